@@ -400,7 +400,7 @@ class TokenGroup(object):
         self._count = count
 
     def __del__(self):
-        conf.lib.clang_disposeTokens(self._tu, self._memory, self._count)
+        conf.lib.clang_disposeFlatTokens(self._memory, self._count)
 
     @staticmethod
     def get_tokens(tu, extent):
@@ -408,11 +408,14 @@ class TokenGroup(object):
 
         This functionality is needed multiple places in this module. We define
         it here because it seems like a logical place.
+
+        The kind, extent and spelling of all of the tokens are obtained
+        together with the tokens, in a single call into libclang.
         """
-        tokens_memory = POINTER(Token)()
+        tokens_memory = POINTER(_CXFlatToken)()
         tokens_count = c_uint()
 
-        conf.lib.clang_tokenize(tu, extent, byref(tokens_memory),
+        conf.lib.clang_tokenizeFlat(tu, extent, byref(tokens_memory),
                 byref(tokens_count))
 
         count = int(tokens_count.value)
@@ -422,16 +425,22 @@ class TokenGroup(object):
         if count < 1:
             return
 
-        tokens_array = cast(tokens_memory, POINTER(Token * count)).contents
+        tokens_array = cast(tokens_memory,
+                            POINTER(_CXFlatToken * count)).contents
 
         token_group = TokenGroup(tu, tokens_memory, tokens_count)
 
         for i in xrange(0, count):
+            flat = tokens_array[i]
             token = Token()
-            token.int_data = tokens_array[i].int_data
-            token.ptr_data = tokens_array[i].ptr_data
+            token.int_data = flat.token.int_data
+            token.ptr_data = flat.token.ptr_data
             token._tu = tu
             token._group = token_group
+            token._kind_id = flat.kind
+            token._spelling = flat.spelling
+            # The extent refers to the memory of the group.
+            token._extent = flat.extent
 
             yield token
 
@@ -1289,6 +1298,48 @@ class Cursor(Structure):
             children)
         return iter(children)
 
+    def get_descendants(self):
+        """Return a list of all the descendants of this cursor.
+
+        The list holds a (cursor, parent) pair for each descendant, with the
+        parent of the children of this cursor being this cursor, in the order
+        in which a traversal recursing into every cursor visits them. All of
+        the cursors are obtained from libclang at once, together with their
+        extents and spellings, which makes this much faster than calling
+        get_children() recursively.
+        """
+        cursors_memory = POINTER(_CXFlatCursor)()
+        cursors_count = c_uint()
+
+        conf.lib.clang_getCursorSubtree(self, byref(cursors_memory),
+                byref(cursors_count))
+
+        count = int(cursors_count.value)
+        if count < 1:
+            return []
+
+        try:
+            cursors_array = cast(cursors_memory,
+                                 POINTER(_CXFlatCursor * count)).contents
+
+            descendants = []
+            for i in xrange(0, count):
+                flat = cursors_array[i]
+                cursor = Cursor.from_buffer_copy(flat.cursor)
+                cursor._tu = self._tu
+                cursor._extent = SourceRange.from_buffer_copy(flat.extent)
+                cursor._spelling = flat.spelling
+
+                if flat.parent < 0:
+                    parent = self
+                else:
+                    parent = descendants[flat.parent][0]
+                descendants.append((cursor, parent))
+        finally:
+            conf.lib.clang_disposeCursorSubtree(cursors_memory, cursors_count)
+
+        return descendants
+
     def get_tokens(self):
         """Obtain Token instances formulating that compose this Cursor.
 
@@ -2383,12 +2434,18 @@ class Token(Structure):
 
         This is the textual representation of the token in source.
         """
-        return conf.lib.clang_getTokenSpelling(self._tu, self)
+        if not hasattr(self, '_spelling'):
+            self._spelling = conf.lib.clang_getTokenSpelling(self._tu, self)
+
+        return self._spelling
 
     @property
     def kind(self):
         """Obtain the TokenKind of the current token."""
-        return TokenKind.from_value(conf.lib.clang_getTokenKind(self))
+        if not hasattr(self, '_kind_id'):
+            self._kind_id = conf.lib.clang_getTokenKind(self)
+
+        return TokenKind.from_value(self._kind_id)
 
     @property
     def location(self):
@@ -2398,7 +2455,10 @@ class Token(Structure):
     @property
     def extent(self):
         """The SourceRange this Token occupies."""
-        return conf.lib.clang_getTokenExtent(self._tu, self)
+        if not hasattr(self, '_extent'):
+            self._extent = conf.lib.clang_getTokenExtent(self._tu, self)
+
+        return self._extent
 
     @property
     def cursor(self):
@@ -2409,6 +2469,26 @@ class Token(Structure):
 
         return cursor
 
+class _CXFlatCursor(Structure):
+    """Helper for reading the cursors of clang_getCursorSubtree()."""
+
+    _fields_ = [
+        ('cursor', Cursor),
+        ('extent', SourceRange),
+        ('spelling', c_char_p),
+        ('parent', c_int)
+    ]
+
+class _CXFlatToken(Structure):
+    """Helper for reading the tokens of clang_tokenizeFlat()."""
+
+    _fields_ = [
+        ('token', Token),
+        ('kind', c_int),
+        ('extent', SourceRange),
+        ('spelling', c_char_p)
+    ]
+
 # Now comes the plumbing to hook up the C library.
 
 # Register callback types in common container.
@@ -2497,9 +2577,15 @@ functionList = [
 # ("clang_disposeCXTUResourceUsage",
 #  [CXTUResourceUsage]),
 
+  ("clang_disposeCursorSubtree",
+   [POINTER(_CXFlatCursor), c_uint]),
+
   ("clang_disposeDiagnostic",
    [Diagnostic]),
 
+  ("clang_disposeFlatTokens",
+   [POINTER(_CXFlatToken), c_uint]),
+
   ("clang_disposeIndex",
    [Index]),
 
@@ -2622,6 +2708,9 @@ functionList = [
    _CXString,
    _CXString.from_result),
 
+  ("clang_getCursorSubtree",
+   [Cursor, POINTER(POINTER(_CXFlatCursor)), POINTER(c_uint)]),
+
   ("clang_getCursorType",
    [Cursor],
    Type,
@@ -2941,6 +3030,10 @@ functionList = [
   ("clang_tokenize",
    [TranslationUnit, SourceRange, POINTER(POINTER(Token)), POINTER(c_uint)]),
 
+  ("clang_tokenizeFlat",
+   [TranslationUnit, SourceRange, POINTER(POINTER(_CXFlatToken)),
+    POINTER(c_uint)]),
+
   ("clang_visitChildren",
    [Cursor, callbacks['cursor_visit'], py_object],
    c_uint),
@@ -73,6 +73,34 @@ def test_get_children():
     assert tu_nodes[2].displayname == 'f0(int, int)'
     assert tu_nodes[2].is_definition() == True
 
+def test_get_descendants():
+    tu = get_tu(kInput)
+    f0 = get_cursor(tu, 'f0')
+
+    expected = []
+    def walk(cursor):
+        for child in cursor.get_children():
+            expected.append((child, cursor))
+            walk(child)
+    walk(f0)
+
+    descendants = f0.get_descendants()
+    assert len(descendants) == len(expected)
+    for (cursor, parent), (e_cursor, e_parent) in zip(descendants, expected):
+        assert cursor == e_cursor
+        assert parent == e_parent
+        assert cursor.kind == e_cursor.kind
+        assert cursor.spelling == e_cursor.spelling
+        assert cursor.extent == e_cursor.extent
+        assert cursor.translation_unit is not None
+
+    assert descendants[0][0].kind == CursorKind.PARM_DECL
+    assert descendants[0][0].spelling == 'a0'
+    assert descendants[0][1] is f0
+
+    s1 = get_cursor(tu, 's1')
+    assert s1.get_descendants() == []
+
 def test_references():
     """Ensure that references to TranslationUnit are kept."""
     tu = get_tu('int x;')
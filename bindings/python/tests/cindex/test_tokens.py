@@ -2,6 +2,7 @@ from clang.cindex import CursorKind
 from clang.cindex import Index
 from clang.cindex import SourceLocation
 from clang.cindex import SourceRange
+from clang.cindex import Token
 from clang.cindex import TokenKind
 from nose.tools import eq_
 from nose.tools import ok_
@@ -50,3 +51,23 @@ def test_token_extent():
 
     eq_(extent.start.offset, 4)
     eq_(extent.end.offset, 7)
+
+def test_token_properties_match_libclang():
+    """Ensure the properties obtained with the tokens are the right ones."""
+    tu = get_tu('int foo(int a) { return a + 10; }')
+    r = tu.get_extent('t.c', (0, 32))
+
+    tokens = list(tu.get_tokens(extent=r))
+    eq_([t.spelling for t in tokens],
+        ['int', 'foo', '(', 'int', 'a', ')', '{', 'return', 'a', '+', '10',
+         ';', '}'])
+
+    for token in tokens:
+        plain = Token()
+        plain.int_data = token.int_data
+        plain.ptr_data = token.ptr_data
+        plain._tu = tu
+
+        eq_(token.spelling, plain.spelling)
+        eq_(token.kind, plain.kind)
+        eq_(token.extent, plain.extent)
@@ -22,6 +22,7 @@
 
 #include "clang-c/Platform.h"
 #include "clang-c/CXString.h"
+#include "clang-c/CXCompilationDatabase.h"
 
 #ifdef __cplusplus
 extern "C" {
@@ -246,6 +247,24 @@ CINDEX_LINKAGE void clang_CXIndex_setGlobalOptions(CXIndex, unsigned options);
  */
 CINDEX_LINKAGE unsigned clang_CXIndex_getGlobalOptions(CXIndex);
 
+/**
+ * \brief Limits the memory used by the translation units of a CXIndex.
+ *
+ * Whenever the translation units of the index use more than \p Bytes, as
+ * reported by \c clang_getCXTUResourceUsage(), the ASTs of the least recently
+ * used ones are unloaded; their precompiled preambles are kept. An unloaded
+ * translation unit is parsed again the next time it is used. Like
+ * \c clang_reparseTranslationUnit(), unloading invalidates the cursors,
+ * tokens and source locations of the translation unit.
+ *
+ * The translation units of such an index must only be used from one thread
+ * at a time.
+ *
+ * \param Bytes The memory budget, or 0 (the default) for no limit.
+ */
+CINDEX_LINKAGE void clang_CXIndex_setMemoryBudget(CXIndex CIdx,
+                                                  unsigned long long Bytes);
+
 /**
  * \defgroup CINDEX_FILES File manipulation routines
  *
@@ -1065,7 +1084,56 @@ enum CXTranslationUnit_Flags {
    * included into the set of code completions returned from this translation
    * unit.
    */
-  CXTranslationUnit_IncludeBriefCommentsInCodeCompletion = 0x80
+  CXTranslationUnit_IncludeBriefCommentsInCodeCompletion = 0x80,
+
+  /**
+   * \brief Used to indicate that an out-of-date precompiled preamble should
+   * be rebuilt on a background thread.
+   *
+   * With this option, \c clang_reparseTranslationUnit() never waits for the
+   * precompiled preamble to be rebuilt. Until the new preamble is complete,
+   * the translation unit is reparsed without a precompiled preamble, and
+   * code completion proceeds as if no preamble was available. Only meaningful
+   * together with \c CXTranslationUnit_PrecompiledPreamble.
+   */
+  CXTranslationUnit_BackgroundPreamble = 0x100,
+
+  /**
+   * \brief Used to indicate that the bodies of the functions defined outside
+   * the main file, e.g., the inline functions of headers, should be skipped
+   * while parsing.
+   *
+   * This option can be used to index headers or build an outline of the main
+   * file without paying for the semantic analysis of every inline body. The
+   * bodies of function templates are kept and parsed only if a template is
+   * instantiated, and the bodies of constexpr functions are always parsed,
+   * since the main file may need them to evaluate constant expressions.
+   */
+  CXTranslationUnit_SkipFunctionBodiesOutsideMainFile = 0x200,
+
+  /**
+   * \brief Used to indicate that the translation unit may be queried from
+   * several threads at once.
+   *
+   * Even the queries that only look at the AST update state that is built
+   * lazily: declarations and types are deserialized from the precompiled
+   * preamble as they are reached, types are uniqued when they are first
+   * formed, and libclang caches cursors and strings. With this option,
+   * libclang serializes the following functions on the translation unit with
+   * a lock of its own, so that clients can call them concurrently without
+   * locking: \c clang_getCursor(), \c clang_getCursorReferenced(),
+   * \c clang_getCursorDefinition(), \c clang_getCursorType(),
+   * \c clang_getTypeDeclaration(), \c clang_getCursorUSR(),
+   * \c clang_Cursor_getRawCommentText(), \c clang_Cursor_getParsedComment(),
+   * \c clang_visitChildren(), \c clang_tokenize(), \c clang_annotateTokens(),
+   * \c clang_codeCompleteAt(), \c clang_saveTranslationUnit() and
+   * \c clang_reparseTranslationUnit(). The lock is recursive, so the
+   * callbacks of these functions may call them again.
+   *
+   * The other functions must still not run concurrently with these, nor
+   * with each other.
+   */
+  CXTranslationUnit_ThreadSafeQueries = 0x400
 };
 
 /**
@@ -2967,6 +3035,60 @@ unsigned clang_visitChildrenWithBlock(CXCursor parent,
 #  endif
 #endif
 
+/**
+ * \brief A cursor found by clang_getCursorSubtree(), with the properties
+ * clients most often ask for.
+ */
+typedef struct {
+  CXCursor Cursor;
+
+  /**
+   * \brief The source range covered by the cursor, as returned by
+   * clang_getCursorExtent().
+   */
+  CXSourceRange Extent;
+
+  /**
+   * \brief The spelling of the cursor, as returned by
+   * clang_getCursorSpelling().
+   */
+  const char *Spelling;
+
+  /**
+   * \brief The position of the parent of the cursor in the array, or -1 if
+   * the cursor is a child of the root.
+   */
+  int Parent;
+} CXFlatCursor;
+
+/**
+ * \brief Retrieve all of the descendants of a cursor at once.
+ *
+ * This visits the same cursors as a call to clang_visitChildren() whose
+ * visitor always returns \c CXChildVisit_Recurse, in the same order, but
+ * saves clients that call libclang through a foreign function interface from
+ * being called back for every cursor.
+ *
+ * \param Root the cursor whose descendants are retrieved.
+ *
+ * \param Cursors this pointer will be set to point to the array of the
+ * descendants of \p Root, each preceded by its parent. The returned pointer
+ * must be freed with clang_disposeCursorSubtree() before the translation
+ * unit is destroyed.
+ *
+ * \param NumCursors will be set to the number of cursors in the
+ * \c *Cursors array.
+ */
+CINDEX_LINKAGE void clang_getCursorSubtree(CXCursor Root,
+                                           CXFlatCursor **Cursors,
+                                           unsigned *NumCursors);
+
+/**
+ * \brief Free the cursors returned by clang_getCursorSubtree().
+ */
+CINDEX_LINKAGE void clang_disposeCursorSubtree(CXFlatCursor *Cursors,
+                                               unsigned NumCursors);
+
 /**
  * @}
  */
@@ -3952,12 +4074,88 @@ CINDEX_LINKAGE void clang_annotateTokens(CXTranslationUnit TU,
                                          CXToken *Tokens, unsigned NumTokens,
                                          CXCursor *Cursors);
 
+/**
+ * \brief Tokenize the source code described by the given range and annotate
+ * the resulting tokens, into buffers provided by the caller.
+ *
+ * This is equivalent to calling clang_tokenize() followed by
+ * clang_annotateTokens(), but it avoids allocating the token array, so that a
+ * client annotating a file over and over again, e.g., for syntax highlighting
+ * during editing, can reuse its buffers.
+ *
+ * \param TU the translation unit whose text is being tokenized.
+ *
+ * \param Range the source range in which text should be tokenized.
+ *
+ * \param Tokens an array of \p MaxTokens tokens, which will be set to the
+ * tokens that occur within the given source range. The tokens need not be
+ * freed with clang_disposeTokens().
+ *
+ * \param Cursors an array of \p MaxTokens cursors, which will be set to the
+ * cursors corresponding to each token.
+ *
+ * \param MaxTokens the number of elements of the \p Tokens and \p Cursors
+ * arrays.
+ *
+ * \returns the number of tokens within the given source range. If this is
+ * larger than \p MaxTokens, neither array has been written to, and the call
+ * should be repeated with larger arrays.
+ */
+CINDEX_LINKAGE unsigned clang_tokenizeAndAnnotate(CXTranslationUnit TU,
+                                                  CXSourceRange Range,
+                                                  CXToken *Tokens,
+                                                  CXCursor *Cursors,
+                                                  unsigned MaxTokens);
+
 /**
  * \brief Free the given set of tokens.
  */
 CINDEX_LINKAGE void clang_disposeTokens(CXTranslationUnit TU,
                                         CXToken *Tokens, unsigned NumTokens);
 
+/**
+ * \brief A token found by clang_tokenizeFlat(), with its kind, extent and
+ * spelling.
+ */
+typedef struct {
+  CXToken Token;
+  CXTokenKind Kind;
+  CXSourceRange Extent;
+  const char *Spelling;
+} CXFlatToken;
+
+/**
+ * \brief Tokenize the source code described by the given range, retrieving
+ * the kind, extent and spelling of every token at once.
+ *
+ * This is equivalent to calling clang_tokenize() followed by
+ * clang_getTokenKind(), clang_getTokenExtent() and clang_getTokenSpelling()
+ * for each token, but saves clients that call libclang through a foreign
+ * function interface a call per token and property.
+ *
+ * \param TU the translation unit whose text is being tokenized.
+ *
+ * \param Range the source range in which text should be tokenized.
+ *
+ * \param Tokens this pointer will be set to point to the array of tokens
+ * that occur within the given source range. The returned pointer must be
+ * freed with clang_disposeFlatTokens() before the translation unit is
+ * destroyed. The tokens it holds need not be freed.
+ *
+ * \param NumTokens will be set to the number of tokens in the \c *Tokens
+ * array.
+ */
+CINDEX_LINKAGE void clang_tokenizeFlat(CXTranslationUnit TU,
+                                       CXSourceRange Range,
+                                       CXFlatToken **Tokens,
+                                       unsigned *NumTokens);
+
+/**
+ * \brief Free the tokens returned by clang_tokenizeFlat().
+ */
+CINDEX_LINKAGE void clang_disposeFlatTokens(CXFlatToken *Tokens,
+                                            unsigned NumTokens);
+
 /**
  * @}
  */
@@ -4394,7 +4592,14 @@ enum CXCodeComplete_Flags {
    * \brief Whether to include brief documentation within the set of code
    * completions returned.
    */
-  CXCodeComplete_IncludeBriefComments = 0x04
+  CXCodeComplete_IncludeBriefComments = 0x04,
+
+  /**
+   * \brief Whether the prefix passed to \c clang_codeCompleteAtWithCallback()
+   * only needs to match a subsequence of the typed text of each result,
+   * ignoring case, rather than its start.
+   */
+  CXCodeComplete_FuzzyPrefix = 0x08
 };
 
 /**
@@ -4611,6 +4816,73 @@ CXCodeCompleteResults *clang_codeCompleteAt(CXTranslationUnit TU,
                                             unsigned num_unsaved_files,
                                             unsigned options);
 
+/**
+ * \brief Receives a batch of code-completion results from
+ * \c clang_codeCompleteAtWithCallback().
+ *
+ * \param Results The results in this batch. The array itself is only valid
+ * during the call, but the completion strings remain valid until the
+ * \c CXCodeCompleteResults returned by \c clang_codeCompleteAtWithCallback()
+ * is disposed.
+ *
+ * \param NumResults The number of results in \p Results.
+ *
+ * \param client_data The client data passed to
+ * \c clang_codeCompleteAtWithCallback().
+ *
+ * \returns zero to continue code completion, or non-zero to cancel it, in
+ * which case no more results are built or delivered.
+ */
+typedef unsigned (*CXCodeCompleteResultsCallback)(CXCompletionResult *Results,
+                                                  unsigned NumResults,
+                                                  CXClientData client_data);
+
+/**
+ * \brief Perform code completion at a given location in a translation unit,
+ * delivering the results in batches as their completion strings are built.
+ *
+ * This function behaves like \c clang_codeCompleteAt(), except that
+ *
+ *   \li only the results whose typed text starts with \p prefix, ignoring
+ *   case, are produced; with \c CXCodeComplete_FuzzyPrefix, the characters
+ *   of \p prefix only need to appear in the typed text in order. Results
+ *   are dropped while they are gathered, before their completion strings
+ *   are built, whenever their names are known.
+ *
+ *   \li \p callback receives the results, \p batch_size at a time, while the
+ *   remaining completion strings are still being built, and may cancel the
+ *   request.
+ *
+ * \param prefix The prefix the typed text of every result must start with, or
+ * NULL to produce all results.
+ *
+ * \param batch_size The number of results passed to each call to
+ * \p callback, except perhaps the last one. Zero delivers all results at once.
+ *
+ * \param callback The function that receives the results, or NULL to only
+ * return them.
+ *
+ * \param client_data Data passed to \p callback.
+ *
+ * \returns If successful, a new \c CXCodeCompleteResults structure containing
+ * the results that were delivered to \p callback, which should eventually be
+ * freed with \c clang_disposeCodeCompleteResults(). If code completion fails,
+ * returns NULL.
+ */
+CINDEX_LINKAGE
+CXCodeCompleteResults *
+clang_codeCompleteAtWithCallback(CXTranslationUnit TU,
+                                 const char *complete_filename,
+                                 unsigned complete_line,
+                                 unsigned complete_column,
+                                 struct CXUnsavedFile *unsaved_files,
+                                 unsigned num_unsaved_files,
+                                 unsigned options,
+                                 const char *prefix,
+                                 unsigned batch_size,
+                                 CXCodeCompleteResultsCallback callback,
+                                 CXClientData client_data);
+
 /**
  * \brief Sort the code-completion results in case-insensitive alphabetical 
  * order.
@@ -5369,6 +5641,37 @@ CINDEX_LINKAGE int clang_indexTranslationUnit(CXIndexAction,
                                               unsigned index_options,
                                               CXTranslationUnit);
 
+/**
+ * \brief Index every source file of a compilation database via callbacks
+ * implemented through #IndexerCallbacks, using several threads.
+ *
+ * Each compile command is indexed as if by #clang_indexSourceFile, relative to
+ * the directory of the command. A file that is included by several
+ * translation units is indexed only once: declarations and references within
+ * it are reported only for the first translation unit that enters it, and
+ * skipped for the others.
+ *
+ * The callbacks are invoked concurrently from different threads, with the
+ * same \p client_data; \c CXIdxClientFile and similar client values are only
+ * meaningful within the translation unit for which they were returned.
+ *
+ * \param num_threads The number of threads to use, or 0 to use one per
+ * processor.
+ *
+ * \returns 0 if every translation unit was indexed, otherwise the number of
+ * translation units for which there was a failure from which there is no
+ * recovery.
+ *
+ * The other parameters are the same as #clang_indexSourceFile.
+ */
+CINDEX_LINKAGE int clang_indexCompilationDatabase(CXIndexAction,
+                                                 CXClientData client_data,
+                                             IndexerCallbacks *index_callbacks,
+                                                 unsigned index_callbacks_size,
+                                                 unsigned index_options,
+                                                 CXCompilationDatabase,
+                                                 unsigned num_threads);
+
 /**
  * \brief Retrieve the CXIdxFile, file, line, column, and offset represented by
  * the given CXIdxLoc.
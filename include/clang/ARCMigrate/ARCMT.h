@@ -68,6 +68,28 @@ bool migrateWithTemporaryFiles(CompilerInvocation &origCI,
                                bool emitPremigrationARCErrors,
                                StringRef plistOut);
 
+/// \brief Works like a migrateWithTemporaryFiles call for every input of every
+/// invocation in \p Invocations, but migrates the translation units
+/// concurrently on up to \p NumThreads threads (0 means one per hardware
+/// thread).
+///
+/// Every translation unit is migrated from the files as they were before the
+/// batch. A file that several translation units rewrote differently, such as
+/// a shared header, gets all of their changes if they touch disjoint ranges
+/// of it; otherwise those translation units are migrated again, one after the
+/// other, on top of the rest of the batch, as a serial migration would.
+///
+/// The diagnostics of each translation unit are printed to \p DiagOS, in the
+/// order of the inputs, once all of them are done. No plist is written.
+///
+/// \returns false if no error is produced, true otherwise.
+bool migrateWithTemporaryFilesInParallel(
+                                    ArrayRef<CompilerInvocation *> Invocations,
+                                    raw_ostream &DiagOS,
+                                    StringRef outputDir,
+                                    bool emitPremigrationARCErrors,
+                                    unsigned NumThreads);
+
 /// \brief Get the set of file remappings from the \arg outputDir path that
 /// migrateWithTemporaryFiles produced.
 ///
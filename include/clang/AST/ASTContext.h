@@ -37,6 +37,7 @@
 #include "llvm/ADT/SmallPtrSet.h"
 #include "llvm/ADT/TinyPtrVector.h"
 #include "llvm/Support/Allocator.h"
+#include "llvm/Support/Mutex.h"
 #include <vector>
 
 namespace llvm {
@@ -58,6 +59,7 @@ namespace clang {
   class CXXABI;
   // Decls
   class DeclContext;
+  class ConstexprCallCache;
   class CXXConversionDecl;
   class CXXMethodDecl;
   class CXXRecordDecl;
@@ -109,6 +111,15 @@ class ASTContext : public RefCountedBase<ASTContext> {
   mutable llvm::FoldingSet<FunctionNoProtoType> FunctionNoProtoTypes;
   mutable llvm::ContextualFoldingSet<FunctionProtoType, ASTContext&>
     FunctionProtoTypes;
+
+  /// \brief A direct-mapped cache of the function types most recently
+  /// looked up, indexed by a hash of their components.
+  ///
+  /// getFunctionType checks this before FunctionProtoTypes, which has to
+  /// build a FoldingSetNodeID for every lookup. A cached type is only used
+  /// if all of its components are equal to the requested ones.
+  enum { FunctionProtoTypeCacheSize = 512 };
+  mutable FunctionProtoType *FunctionProtoTypeCache[FunctionProtoTypeCacheSize];
   mutable llvm::FoldingSet<DependentTypeOfExprType> DependentTypeOfExprTypes;
   mutable llvm::FoldingSet<DependentDecltypeType> DependentDecltypeTypes;
   mutable llvm::FoldingSet<TemplateTypeParmType> TemplateTypeParmTypes;
@@ -148,7 +159,9 @@ class ASTContext : public RefCountedBase<ASTContext> {
 
   /// \brief A cache mapping from RecordDecls to ASTRecordLayouts.
   ///
-  /// This is lazily created.  This is intentionally not serialized.
+  /// This is lazily created. The layouts of the records in an AST file are
+  /// serialized with it, and read back through
+  /// ExternalASTSource::getRecordLayout().
   mutable llvm::DenseMap<const RecordDecl*, const ASTRecordLayout*>
     ASTRecordLayouts;
   mutable llvm::DenseMap<const ObjCContainerDecl*, const ASTRecordLayout*>
@@ -159,6 +172,26 @@ class ASTContext : public RefCountedBase<ASTContext> {
                          std::pair<uint64_t, unsigned> > TypeInfoMap;
   mutable TypeInfoMap MemoizedTypeInfo;
 
+  /// \brief Serializes the computation of type sizes, record layouts and key
+  /// functions while concurrent readers are allowed; null otherwise.
+  OwningPtr<llvm::sys::Mutex> LayoutLock;
+
+  /// \brief Holds the layout lock, if there is one, for its lifetime.
+  class LayoutLockGuard {
+    llvm::sys::Mutex *Lock;
+  public:
+    explicit LayoutLockGuard(const ASTContext &Context)
+      : Lock(Context.LayoutLock.get()) {
+      if (Lock)
+        Lock->acquire();
+    }
+    ~LayoutLockGuard() {
+      if (Lock)
+        Lock->release();
+    }
+  };
+  friend class LayoutLockGuard;
+
   /// \brief A cache mapping from CXXRecordDecls to key functions.
   llvm::DenseMap<const CXXRecordDecl*, const CXXMethodDecl*> KeyFunctions;
   
@@ -348,6 +381,10 @@ class ASTContext : public RefCountedBase<ASTContext> {
   /// that value exceeds the bitfield size of ParmVarDeclBits.ParameterIndex.
   typedef llvm::DenseMap<const VarDecl *, unsigned> ParameterIndexTable;
   ParameterIndexTable ParamIndices;  
+
+  /// \brief The results of earlier calls to constexpr functions, created by
+  /// the constant evaluator the first time it memoizes a call.
+  mutable ConstexprCallCache *ConstexprCalls;
   
   ImportDecl *FirstLocalImport;
   ImportDecl *LastLocalImport;
@@ -367,6 +404,38 @@ class ASTContext : public RefCountedBase<ASTContext> {
   /// AST objects will be released when the ASTContext itself is destroyed.
   mutable llvm::BumpPtrAllocator BumpAlloc;
 
+  /// \brief The allocator for the statements of the body of a function
+  /// which can be released once the function has been emitted.
+  struct FunctionBodyArena {
+    llvm::BumpPtrAllocator Alloc;
+
+    /// \brief Whether anything which can outlive the body, such as a
+    /// template instantiation, was created while the body was parsed.
+    bool Escaped;
+
+    FunctionBodyArena() : Escaped(false) {}
+  };
+
+  /// \brief Whether the statements of function bodies are allocated from
+  /// per-function arenas; see setReleasableFunctionBodies().
+  bool ReleasableFunctionBodies;
+
+  /// \brief The arena of the function body being parsed, if any.
+  FunctionBodyArena *CurFunctionBodyArena;
+
+  /// \brief The arenas of the function bodies which have been parsed and
+  /// not released yet.
+  llvm::DenseMap<const FunctionDecl *, FunctionBodyArena *> FunctionBodyArenas;
+
+  /// \brief The memory of the arenas in FunctionBodyArenas.
+  size_t FunctionBodyArenaMemory;
+
+  /// \brief The number of bytes released with function bodies.
+  size_t ReleasedFunctionBodyMemory;
+
+  /// \brief The number of function bodies which were released.
+  unsigned NumReleasedFunctionBodies;
+
   /// \brief Allocator for partial diagnostics.
   PartialDiagnostic::StorageAllocator DiagAllocator;
 
@@ -410,11 +479,58 @@ public:
     return BumpAlloc.Allocate(Size, Align);
   }
   void Deallocate(void *Ptr) const { }
-  
+
+  /// \brief Allocate memory for a statement, from the arena of the function
+  /// body being parsed if function bodies are releasable.
+  void *AllocateStmt(unsigned Size, unsigned Align = 8) const {
+    if (CurFunctionBodyArena)
+      return CurFunctionBodyArena->Alloc.Allocate(Size, Align);
+    return BumpAlloc.Allocate(Size, Align);
+  }
+
+  /// \brief Allocate the statements of each function body which might not
+  /// be needed after the function has been emitted from an arena of its
+  /// own, which releaseFunctionBody() can free.
+  ///
+  /// This is set by AST consumers which can tell when a function has been
+  /// emitted, and must be set before any function body is parsed.
+  void setReleasableFunctionBodies(bool Releasable) {
+    ReleasableFunctionBodies = Releasable;
+  }
+  bool hasReleasableFunctionBodies() const {
+    return ReleasableFunctionBodies;
+  }
+
+  /// \brief Note that Sema is about to parse the body of \p FD, whose
+  /// statements should be allocated from an arena of their own.
+  void startFunctionBody(const FunctionDecl *FD);
+
+  /// \brief Note that Sema finished parsing the body of \p FD.
+  void finishFunctionBody(const FunctionDecl *FD);
+
+  /// \brief Note that something which can outlive the function body being
+  /// parsed, such as a template instantiation, is being created, so the
+  /// arena of the body cannot be released.
+  void noteFunctionBodyEscape() const {
+    if (CurFunctionBodyArena)
+      CurFunctionBodyArena->Escaped = true;
+  }
+
+  /// \brief Free the statements of the body of \p FD, which has been
+  /// emitted and will not be needed again, replacing the body by an empty
+  /// compound statement.
+  ///
+  /// \returns true if the body was released; bodies which were not allocated
+  /// from an arena, or whose arena might still be referenced, are kept.
+  bool releaseFunctionBody(FunctionDecl *FD);
+
   /// Return the total amount of physical memory allocated for representing
   /// AST nodes and type information.
   size_t getASTAllocatedMemory() const {
-    return BumpAlloc.getTotalMemory();
+    size_t Memory = BumpAlloc.getTotalMemory() + FunctionBodyArenaMemory;
+    if (CurFunctionBodyArena)
+      Memory += CurFunctionBodyArena->Alloc.getTotalMemory();
+    return Memory;
   }
   /// Return the total memory used for various side tables.
   size_t getSideTableAllocatedMemory() const;
@@ -719,6 +835,15 @@ public:
   /// with this AST context, if any.
   ExternalASTSource *getExternalSource() const { return ExternalSource.get(); }
 
+  /// \brief Sets whether several threads may read the AST at the same time.
+  ///
+  /// While this is enabled, the caches of getTypeInfo(), getASTRecordLayout(),
+  /// getObjCLayout() and getKeyFunction(), which are filled as types are
+  /// queried, are guarded by a lock. Nothing else is: the readers must not change the AST, and
+  /// nothing may be loaded lazily from an external AST source.
+  void setConcurrentReaders(bool Allow);
+  bool allowsConcurrentReaders() const { return LayoutLock.get() != 0; }
+
   /// \brief Attach an AST mutation listener to the AST context.
   ///
   /// The AST mutation listener provides the ability to track modifications to
@@ -733,8 +858,18 @@ public:
   ASTMutationListener *getASTMutationListener() const { return Listener; }
 
   void PrintStats() const;
+
+  /// \brief Print the memory used by the AST by node class and by source
+  /// file, and the sizes of the uniquing tables, as enabled by
+  /// -print-memory-stats.
+  void PrintMemoryStats(raw_ostream &OS) const;
+
   const std::vector<Type*>& getTypes() const { return Types; }
 
+  /// \brief Retrieve the table in which the constant evaluator memoizes the
+  /// results of calls to constexpr functions.
+  ConstexprCallCache &getConstexprCallCache() const;
+
   /// \brief Retrieve the declaration for the 128-bit signed integer type.
   TypedefDecl *getInt128Decl() const;
 
@@ -1528,6 +1663,16 @@ public:
   /// of class definition.
   const CXXMethodDecl *getKeyFunction(const CXXRecordDecl *RD);
 
+  /// \brief Whether the vtable and RTTI of the given dynamic class belong to
+  /// the translation unit which owns the PCH or module the class comes from,
+  /// under -fpch-vtables=owner or -fpch-vtables=external.
+  ///
+  /// This covers the classes defined or implicitly instantiated while
+  /// building the AST file whose vtables would otherwise be emitted, with
+  /// linkonce_odr linkage, in every translation unit that uses them: those
+  /// without a key function or with an inline one.
+  bool isVTableOwnedByASTFile(const CXXRecordDecl *RD);
+
   /// Get the offset of a FieldDecl or IndirectFieldDecl, in bits.
   uint64_t getFieldOffset(const ValueDecl *FD) const;
 
@@ -2023,6 +2168,22 @@ public:
   /// \brief The number of implicitly-declared destructors for which 
   /// declarations were built.
   static unsigned NumImplicitDestructorsDeclared;
+
+  /// \brief The number of constexpr function calls whose results were
+  /// memoized.
+  static unsigned NumConstexprCallsMemoized;
+
+  /// \brief The number of constexpr function calls which were not evaluated
+  /// again because their results had been memoized.
+  static unsigned NumConstexprCallCacheHits;
+
+  /// \brief The number of function types looked up in the direct-mapped
+  /// function type cache.
+  static unsigned NumFunctionProtoTypeCacheLookups;
+
+  /// \brief The number of function types found in the direct-mapped
+  /// function type cache.
+  static unsigned NumFunctionProtoTypeCacheHits;
   
 private:
   ASTContext(const ASTContext&); // DO NOT IMPLEMENT
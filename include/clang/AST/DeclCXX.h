@@ -273,6 +273,27 @@ class CXXRecordDecl : public RecordDecl {
 
   friend void TagDecl::startDefinition();
 
+  /// \brief A class from which a class is derived, directly or indirectly,
+  /// and how many subobjects of that class it has.
+  struct TransitiveBase {
+    /// \brief The canonical declaration of the base class.
+    const CXXRecordDecl *Base;
+
+    /// \brief The number of base class subobjects of this type which are
+    /// not within a virtual base class subobject, up to two.
+    unsigned NonVirtualSubobjects : 2;
+
+    /// \brief Whether the class is a virtual base class.
+    unsigned IsVirtual : 1;
+
+    /// \brief Whether there is more than one subobject of this type.
+    unsigned IsAmbiguous : 1;
+
+    bool operator<(const TransitiveBase &Other) const {
+      return Base < Other.Base;
+    }
+  };
+
   struct DefinitionData {
     DefinitionData(CXXRecordDecl *D);
 
@@ -506,6 +527,10 @@ class CXXRecordDecl : public RecordDecl {
     /// \brief Whether this class describes a C++ lambda.
     bool IsLambda : 1;
 
+    /// \brief Whether TransitiveBases has been computed from the current
+    /// base classes.
+    mutable bool ComputedTransitiveBases : 1;
+
     /// NumBases - The number of base class specifiers in Bases.
     unsigned NumBases;
 
@@ -540,6 +565,13 @@ class CXXRecordDecl : public RecordDecl {
     /// in reverse order.
     FriendDecl *FirstFriend;
 
+    /// \brief The non-dependent classes from which this class is derived,
+    /// sorted by address; computed when first needed.
+    mutable TransitiveBase *TransitiveBases;
+
+    /// \brief The number of classes in TransitiveBases.
+    mutable unsigned NumTransitiveBases;
+
     /// \brief Retrieve the set of direct base classes.
     CXXBaseSpecifier *getBases() const {
       if (!Bases.isOffset())
@@ -648,6 +680,13 @@ class CXXRecordDecl : public RecordDecl {
 
   friend class ASTNodeImporter;
 
+  /// \brief Compute the set of classes from which this class is derived.
+  void computeTransitiveBases() const;
+
+  /// \brief Find \p Base among the classes from which this class is
+  /// derived, or return null if it is not derived from \p Base.
+  const TransitiveBase *findTransitiveBase(const CXXRecordDecl *Base) const;
+
 protected:
   CXXRecordDecl(Kind K, TagKind TK, DeclContext *DC,
                 SourceLocation StartLoc, SourceLocation IdLoc,
@@ -1297,6 +1336,15 @@ public:
   /// false otherwise.
   bool isVirtuallyDerivedFrom(const CXXRecordDecl *Base) const;
 
+  /// \brief Determine whether this class has more than one base class
+  /// subobject of type \p Base, so that a conversion to \p Base would be
+  /// ambiguous.
+  ///
+  /// Unlike a search for the paths to \p Base, this does not walk the
+  /// hierarchy: the classes from which a class is derived are computed once
+  /// and cached.
+  bool isAmbiguousBase(const CXXRecordDecl *Base) const;
+
   /// \brief Determine whether this class is provably not derived from
   /// the type \p Base.
   bool isProvablyNotDerivedFrom(const CXXRecordDecl *Base) const;
@@ -195,6 +195,15 @@ public:
   }
 };
 
+/// StoredDeclsMap - The lookup table of a DeclContext.
+///
+/// FIXME: A sorted array would be more compact than a hash table for a
+/// context which can no longer change, but few contexts are immutable once
+/// their table has been built: namespaces can be reopened, and classes gain
+/// implicitly-declared special members when they are first looked up. The
+/// tables of contexts read from an AST file are already the compact on-disk
+/// hash tables, and this map only holds the names which have been looked up
+/// in them.
 class StoredDeclsMap
   : public llvm::SmallDenseMap<DeclarationName, StoredDeclsList, 4> {
 
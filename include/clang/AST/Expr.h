@@ -535,6 +535,15 @@ public:
                              const VarDecl *VD,
                        llvm::SmallVectorImpl<PartialDiagnosticAt> &Notes) const;
 
+  /// EvaluateAsStaticInitializer - Evaluate an expression as the initializer
+  /// of the given C++ variable with static storage duration, which is not a
+  /// constant expression. Calls to functions and constructors which are not
+  /// constexpr are folded if their bodies could be those of constexpr ones,
+  /// up to a limit on the number of calls. Returns true if the variable can
+  /// be initialized statically with the resulting value.
+  bool EvaluateAsStaticInitializer(APValue &Result, const ASTContext &Ctx,
+                                   const VarDecl *VD) const;
+
   /// \brief Enumeration used to describe the kind of Null pointer constant
   /// returned from \c isNullPointerConstant().
   enum NullPointerConstantKind {
@@ -775,6 +784,10 @@ public:
 /// they apply in order to conserve memory. These are laid out past the end of
 /// the object, and flags in the DeclRefExprBitfield track whether they exist:
 ///
+///   DeclRefExprBits.HasNameLoc:
+///       Specifies when this declaration reference expression stores the
+///       DeclarationNameLoc of its name, which only operator, conversion
+///       function and constructor/destructor names carry.
 ///   DeclRefExprBits.HasQualifier:
 ///       Specifies when this declaration reference expression has a C++
 ///       nested-name-specifier.
@@ -795,14 +808,35 @@ class DeclRefExpr : public Expr {
   /// \brief The location of the declaration name itself.
   SourceLocation Loc;
 
-  /// \brief Provides source/type location info for the declaration name
-  /// embedded in D.
-  DeclarationNameLoc DNLoc;
+  /// \brief Test whether the DeclarationNameLoc of the name is attached to
+  /// the end of this DRE.
+  bool hasNameLoc() const { return DeclRefExprBits.HasNameLoc; }
+
+  /// \brief Helper to retrieve the optional source/type location info for
+  /// the declaration name embedded in D.
+  DeclarationNameLoc &getInternalNameLoc() {
+    assert(hasNameLoc());
+    return *reinterpret_cast<DeclarationNameLoc *>(this + 1);
+  }
+
+  /// \brief Helper to retrieve the optional source/type location info for
+  /// the declaration name embedded in D.
+  const DeclarationNameLoc &getInternalNameLoc() const {
+    return const_cast<DeclRefExpr *>(this)->getInternalNameLoc();
+  }
+
+  /// \brief Helper to retrieve the storage of the optional constructs that
+  /// follow the optional DeclarationNameLoc.
+  void *getInternalStorage() {
+    if (hasNameLoc())
+      return &getInternalNameLoc() + 1;
+    return this + 1;
+  }
 
   /// \brief Helper to retrieve the optional NestedNameSpecifierLoc.
   NestedNameSpecifierLoc &getInternalQualifierLoc() {
     assert(hasQualifier());
-    return *reinterpret_cast<NestedNameSpecifierLoc *>(this + 1);
+    return *reinterpret_cast<NestedNameSpecifierLoc *>(getInternalStorage());
   }
 
   /// \brief Helper to retrieve the optional NestedNameSpecifierLoc.
@@ -820,7 +854,7 @@ class DeclRefExpr : public Expr {
     assert(hasFoundDecl());
     if (hasQualifier())
       return *reinterpret_cast<NamedDecl **>(&getInternalQualifierLoc() + 1);
-    return *reinterpret_cast<NamedDecl **>(this + 1);
+    return *reinterpret_cast<NamedDecl **>(getInternalStorage());
   }
 
   /// \brief Helper to retrieve the optional NamedDecl through which this
@@ -847,11 +881,14 @@ class DeclRefExpr : public Expr {
   void computeDependence(ASTContext &C);
 
 public:
+  /// \brief Construct a reference to \p D that carries no qualifier, found
+  /// declaration, template arguments or DeclarationNameLoc; use Create() for
+  /// names that need any of them.
   DeclRefExpr(ValueDecl *D, bool refersToEnclosingLocal, QualType T,
-              ExprValueKind VK, SourceLocation L,
-              const DeclarationNameLoc &LocInfo = DeclarationNameLoc())
+              ExprValueKind VK, SourceLocation L)
     : Expr(DeclRefExprClass, T, VK, OK_Ordinary, false, false, false, false),
-      D(D), Loc(L), DNLoc(LocInfo) {
+      D(D), Loc(L) {
+    DeclRefExprBits.HasNameLoc = 0;
     DeclRefExprBits.HasQualifier = 0;
     DeclRefExprBits.HasTemplateKWAndArgsInfo = 0;
     DeclRefExprBits.HasFoundDecl = 0;
@@ -882,6 +919,7 @@ public:
 
   /// \brief Construct an empty declaration reference expression.
   static DeclRefExpr *CreateEmpty(ASTContext &Context,
+                                  bool HasNameLoc,
                                   bool HasQualifier,
                                   bool HasFoundDecl,
                                   bool HasTemplateKWAndArgsInfo,
@@ -892,7 +930,10 @@ public:
   void setDecl(ValueDecl *NewD) { D = NewD; }
 
   DeclarationNameInfo getNameInfo() const {
-    return DeclarationNameInfo(getDecl()->getDeclName(), Loc, DNLoc);
+    if (!hasNameLoc())
+      return DeclarationNameInfo(getDecl()->getDeclName(), Loc);
+    return DeclarationNameInfo(getDecl()->getDeclName(), Loc,
+                               getInternalNameLoc());
   }
 
   SourceLocation getLocation() const { return Loc; }
@@ -955,7 +996,7 @@ public:
       return reinterpret_cast<ASTTemplateKWAndArgsInfo *>(
         &getInternalQualifierLoc() + 1);
 
-    return reinterpret_cast<ASTTemplateKWAndArgsInfo *>(this + 1);
+    return reinterpret_cast<ASTTemplateKWAndArgsInfo *>(getInternalStorage());
   }
 
   /// \brief Return the optional template keyword and arguments info.
@@ -2182,39 +2223,61 @@ class MemberExpr : public Expr {
   /// In X.F, this is the decl referenced by F.
   ValueDecl *MemberDecl;
 
-  /// MemberDNLoc - Provides source/type location info for the
-  /// declaration name embedded in MemberDecl.
-  DeclarationNameLoc MemberDNLoc;
-
   /// MemberLoc - This is the location of the member name.
   SourceLocation MemberLoc;
 
   /// IsArrow - True if this is "X->F", false if this is "X.F".
   bool IsArrow : 1;
 
+  /// \brief True if this member expression names its member with an operator,
+  /// conversion function or constructor/destructor name, whose source/type
+  /// location info is stored in a DeclarationNameLoc allocated immediately
+  /// after the MemberExpr.
+  bool HasNameLoc : 1;
+
   /// \brief True if this member expression used a nested-name-specifier to
   /// refer to the member, e.g., "x->Base::f", or found its member via a using
   /// declaration.  When true, a MemberNameQualifier
-  /// structure is allocated immediately after the MemberExpr.
+  /// structure is allocated after the MemberExpr and its DeclarationNameLoc,
+  /// if any.
   bool HasQualifierOrFoundDecl : 1;
 
   /// \brief True if this member expression specified a template keyword
   /// and/or a template argument list explicitly, e.g., x->f<int>,
   /// x->template f, x->template f<int>.
   /// When true, an ASTTemplateKWAndArgsInfo structure and its
-  /// TemplateArguments (if any) are allocated immediately after
-  /// the MemberExpr or, if the member expression also has a qualifier,
-  /// after the MemberNameQualifier structure.
+  /// TemplateArguments (if any) are allocated after the MemberExpr and its
+  /// DeclarationNameLoc, if any, or, if the member expression also has a
+  /// qualifier, after the MemberNameQualifier structure.
   bool HasTemplateKWAndArgsInfo : 1;
 
   /// \brief True if this member expression refers to a method that
   /// was resolved from an overloaded set having size greater than 1.
   bool HadMultipleCandidates : 1;
 
+  /// \brief Retrieve the source/type location info for the member name.
+  DeclarationNameLoc &getInternalNameLoc() {
+    assert(HasNameLoc);
+    return *reinterpret_cast<DeclarationNameLoc *>(this + 1);
+  }
+
+  /// \brief Retrieve the source/type location info for the member name.
+  const DeclarationNameLoc &getInternalNameLoc() const {
+    return const_cast<MemberExpr *>(this)->getInternalNameLoc();
+  }
+
+  /// \brief Retrieve the storage of the optional constructs that follow the
+  /// optional DeclarationNameLoc.
+  void *getInternalStorage() {
+    if (HasNameLoc)
+      return &getInternalNameLoc() + 1;
+    return this + 1;
+  }
+
   /// \brief Retrieve the qualifier that preceded the member name, if any.
   MemberNameQualifier *getMemberQualifier() {
     assert(HasQualifierOrFoundDecl);
-    return reinterpret_cast<MemberNameQualifier *> (this + 1);
+    return reinterpret_cast<MemberNameQualifier *>(getInternalStorage());
   }
 
   /// \brief Retrieve the qualifier that preceded the member name, if any.
@@ -2223,25 +2286,11 @@ class MemberExpr : public Expr {
   }
 
 public:
-  MemberExpr(Expr *base, bool isarrow, ValueDecl *memberdecl,
-             const DeclarationNameInfo &NameInfo, QualType ty,
-             ExprValueKind VK, ExprObjectKind OK)
-    : Expr(MemberExprClass, ty, VK, OK,
-           base->isTypeDependent(),
-           base->isValueDependent(),
-           base->isInstantiationDependent(),
-           base->containsUnexpandedParameterPack()),
-      Base(base), MemberDecl(memberdecl), MemberDNLoc(NameInfo.getInfo()),
-      MemberLoc(NameInfo.getLoc()), IsArrow(isarrow),
-      HasQualifierOrFoundDecl(false), HasTemplateKWAndArgsInfo(false),
-      HadMultipleCandidates(false) {
-    assert(memberdecl->getDeclName() == NameInfo.getName());
-  }
-
   // NOTE: this constructor should be used only when it is known that
   // the member name can not provide additional syntactic info
   // (i.e., source locations for C++ operator names or type source info
-  // for constructors, destructors and conversion operators).
+  // for constructors, destructors and conversion operators); use Create()
+  // otherwise.
   MemberExpr(Expr *base, bool isarrow, ValueDecl *memberdecl,
              SourceLocation l, QualType ty,
              ExprValueKind VK, ExprObjectKind OK)
@@ -2249,8 +2298,8 @@ public:
            base->isTypeDependent(), base->isValueDependent(),
            base->isInstantiationDependent(),
            base->containsUnexpandedParameterPack()),
-      Base(base), MemberDecl(memberdecl), MemberDNLoc(), MemberLoc(l),
-      IsArrow(isarrow),
+      Base(base), MemberDecl(memberdecl), MemberLoc(l),
+      IsArrow(isarrow), HasNameLoc(false),
       HasQualifierOrFoundDecl(false), HasTemplateKWAndArgsInfo(false),
       HadMultipleCandidates(false) {}
 
@@ -2311,7 +2360,8 @@ public:
       return 0;
 
     if (!HasQualifierOrFoundDecl)
-      return reinterpret_cast<ASTTemplateKWAndArgsInfo *>(this + 1);
+      return reinterpret_cast<ASTTemplateKWAndArgsInfo *>(
+                                                        getInternalStorage());
 
     return reinterpret_cast<ASTTemplateKWAndArgsInfo *>(
                                                       getMemberQualifier() + 1);
@@ -2400,8 +2450,10 @@ public:
 
   /// \brief Retrieve the member declaration name info.
   DeclarationNameInfo getMemberNameInfo() const {
-    return DeclarationNameInfo(MemberDecl->getDeclName(),
-                               MemberLoc, MemberDNLoc);
+    if (!HasNameLoc)
+      return DeclarationNameInfo(MemberDecl->getDeclName(), MemberLoc);
+    return DeclarationNameInfo(MemberDecl->getDeclName(), MemberLoc,
+                               getInternalNameLoc());
   }
 
   bool isArrow() const { return IsArrow; }
@@ -21,6 +21,7 @@
 namespace clang {
 
 class ASTConsumer;
+class ASTRecordLayout;
 class CXXBaseSpecifier;
 class DeclarationName;
 class ExternalSemaSource; // layering violation required for downcasting
@@ -244,6 +245,17 @@ public:
   { 
     return false;
   }
+
+  /// \brief Retrieve the layout of the given record definition, as computed
+  /// when the external source was built.
+  ///
+  /// Unlike layoutRecordType(), the record is not laid out at all when this
+  /// routine provides its layout.
+  ///
+  /// The default implementation of this method returns NULL.
+  virtual const ASTRecordLayout *getRecordLayout(const RecordDecl *Record) {
+    return 0;
+  }
   
   //===--------------------------------------------------------------------===//
   // Queries for performance analysis.
@@ -12,6 +12,8 @@
 
 #include "clang/Basic/SourceManager.h"
 #include "llvm/ADT/ArrayRef.h"
+#include "llvm/ADT/DenseMap.h"
+#include <vector>
 
 namespace clang {
 
@@ -177,7 +179,7 @@ public:
 class RawCommentList {
 public:
   RawCommentList(SourceManager &SourceMgr) :
-    SourceMgr(SourceMgr), OnlyWhitespaceSeen(true) { }
+    SourceMgr(SourceMgr), OnlyWhitespaceSeen(true), NumIndexedComments(0) { }
 
   void addComment(const RawComment &RC, llvm::BumpPtrAllocator &Allocator);
 
@@ -185,18 +187,42 @@ public:
     return Comments;
   }
 
+  /// \brief A comment, along with the offset of its beginning in its file.
+  struct CommentInFile {
+    unsigned Offset;
+    RawComment *Comment;
+  };
+
+  /// \brief Retrieve the comments of the given file, sorted by offset.
+  ///
+  /// The comments are indexed by file the first time they are looked up, so
+  /// that finding the comment next to a declaration only compares offsets
+  /// within its file.
+  ArrayRef<CommentInFile> getCommentsInFile(FileID FID) const;
+
 private:
   SourceManager &SourceMgr;
   std::vector<RawComment *> Comments;
   SourceLocation PrevCommentEndLoc;
   bool OnlyWhitespaceSeen;
 
+  /// \brief The comments of each file, for the first \c NumIndexedComments
+  /// comments in \c Comments.
+  mutable llvm::DenseMap<FileID, std::vector<CommentInFile> > CommentsInFile;
+  mutable unsigned NumIndexedComments;
+
+  void clearCommentsInFile() {
+    CommentsInFile.clear();
+    NumIndexedComments = 0;
+  }
+
   void addCommentsToFront(const std::vector<RawComment *> &C) {
     size_t OldSize = Comments.size();
     Comments.resize(C.size() + OldSize);
     std::copy_backward(Comments.begin(), Comments.begin() + OldSize,
                        Comments.end());
     std::copy(C.begin(), C.end(), Comments.begin());
+    clearCommentsInFile();
   }
 
   friend class ASTReader;
@@ -113,6 +113,8 @@ private:
   CXXRecordLayoutInfo *CXXInfo;
 
   friend class ASTContext;
+  friend class ASTReader;
+  friend class ASTWriter;
 
   ASTRecordLayout(const ASTContext &Ctx, CharUnits size, CharUnits alignment,
                   CharUnits datasize, const uint64_t *fieldoffsets,
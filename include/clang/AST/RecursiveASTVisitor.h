@@ -154,9 +154,18 @@ public:
 
   /// \brief Return whether \param S should be traversed using data recursion
   /// to avoid a stack overflow with extreme cases.
+  ///
+  /// These are the statements which generated code tends to nest deeply,
+  /// such as chains of operators, conditional operators and else-ifs, and
+  /// whose traversal visits nothing but their children. Data recursion is
+  /// not used if the derived class overrides TraverseStmt(), since the
+  /// children are then not traversed through it.
   bool shouldUseDataRecursionFor(Stmt *S) const {
     return isa<BinaryOperator>(S) || isa<UnaryOperator>(S) ||
-           isa<CaseStmt>(S) || isa<CXXOperatorCallExpr>(S);
+           isa<CaseStmt>(S) || isa<CXXOperatorCallExpr>(S) ||
+           isa<ParenExpr>(S) || isa<ImplicitCastExpr>(S) ||
+           isa<ConditionalOperator>(S) || isa<ArraySubscriptExpr>(S) ||
+           isa<IfStmt>(S) || isa<CompoundStmt>(S);
   }
 
   /// \brief Recursively visit a statement or expression, by
@@ -529,7 +538,15 @@ bool RecursiveASTVisitor<Derived>::TraverseStmt(Stmt *S) {
   if (!S)
     return true;
 
-  if (getDerived().shouldUseDataRecursionFor(S))
+  // Data recursion traverses the children of S without calling TraverseStmt,
+  // so only use it if the derived class does not override that.
+#if defined(_MSC_VER)
+  if (&RecursiveASTVisitor::TraverseStmt == &Derived::TraverseStmt &&
+#else
+  if (&RecursiveASTVisitor::TraverseStmt ==
+        (bool (RecursiveASTVisitor::*)(Stmt*))&Derived::TraverseStmt &&
+#endif
+      getDerived().shouldUseDataRecursionFor(S))
     return dataTraverse(S);
 
   // If we have a binary expr, dispatch to the subcode of the binop.  A smart
@@ -193,6 +193,7 @@ protected:
     friend class ASTStmtReader; // deserialization
     unsigned : NumExprBits;
 
+    unsigned HasNameLoc : 1;
     unsigned HasQualifier : 1;
     unsigned HasTemplateKWAndArgsInfo : 1;
     unsigned HasFoundDecl : 1;
@@ -302,13 +303,11 @@ public:
   // Only allow allocation of Stmts using the allocator in ASTContext
   // or by doing a placement new.
   void* operator new(size_t bytes, ASTContext& C,
-                     unsigned alignment = 8) throw() {
-    return ::operator new(bytes, C, alignment);
-  }
+                     unsigned alignment = 8) throw();
 
   void* operator new(size_t bytes, ASTContext* C,
                      unsigned alignment = 8) throw() {
-    return ::operator new(bytes, *C, alignment);
+    return operator new(bytes, *C, alignment);
   }
 
   void* operator new(size_t bytes, void* mem) throw() {
@@ -299,6 +299,13 @@ private:
   /// Thunks - Contains all thunks that a given method decl will need.
   ThunksMapTy Thunks;
 
+  typedef llvm::DenseMap<const CXXRecordDecl *, CXXFinalOverriderMap *>
+    FinalOverriderMapsTy;
+
+  /// FinalOverriderMaps - Contains the final overriders of the classes whose
+  /// vtables, or construction vtables, have been laid out.
+  FinalOverriderMapsTy FinalOverriderMaps;
+
   void ComputeMethodVTableIndices(const CXXRecordDecl *RD);
 
   /// ComputeVTableRelatedInformation - Compute and store all vtable related
@@ -335,6 +342,10 @@ public:
     return &I->second;
   }
 
+  /// getFinalOverriders - Return the final overriders of the virtual member
+  /// functions of the given class, which are computed only once per class.
+  const CXXFinalOverriderMap &getFinalOverriders(const CXXRecordDecl *RD);
+
   /// getNumVirtualFunctionPointers - Return the number of virtual function
   /// pointers in the vtable for a given record decl.
   uint64_t getNumVirtualFunctionPointers(const CXXRecordDecl *RD);
@@ -95,6 +95,17 @@ public:
     virtual void run() = 0;
   };
 
+  /// \brief The registered matchers, each with the \c MatchCallback that
+  /// will be called when it matches.
+  ///
+  /// The matchers are kept apart by the kind of node they match, so that
+  /// each node is only tried against the matchers which can match it.
+  struct MatcherCallbacks {
+    std::vector<std::pair<const DeclarationMatcher*, MatchCallback*> > Decls;
+    std::vector<std::pair<const TypeMatcher*, MatchCallback*> > Types;
+    std::vector<std::pair<const StatementMatcher*, MatchCallback*> > Stmts;
+  };
+
   MatchFinder();
   ~MatchFinder();
 
@@ -125,10 +136,7 @@ public:
   void registerTestCallbackAfterParsing(ParsingDoneTestCallback *ParsingDone);
 
 private:
-  /// \brief For each \c DynTypedMatcher a \c MatchCallback that will be called
-  /// when it matches.
-  std::vector<std::pair<const internal::DynTypedMatcher*, MatchCallback*> >
-    MatcherCallbackPairs;
+  MatcherCallbacks Matchers;
 
   /// \brief Called when parsing is done.
   ParsingDoneTestCallback *ParsingDone;
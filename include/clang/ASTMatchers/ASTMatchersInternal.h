@@ -93,6 +93,9 @@ public:
   /// \brief Copies all ID/Node pairs to BoundNodesMap \c Other.
   void copyTo(BoundNodesMap *Other) const;
 
+  /// \brief Returns true if no nodes are bound.
+  bool empty() const { return NodeMap.empty(); }
+
 private:
   /// \brief A map from IDs to the bound nodes.
   typedef std::map<std::string, ast_type_traits::DynTypedNode> IDToNodeMap;
@@ -132,6 +135,11 @@ public:
   /// \brief Adds all bound nodes to \c Builder.
   void copyTo(BoundNodesTreeBuilder* Builder) const;
 
+  /// \brief Returns true if the tree holds no bound nodes.
+  bool empty() const {
+    return Bindings.empty() && RecursiveBindings.empty();
+  }
+
   /// \brief Visits all matches that this BoundNodesTree represents.
   ///
   /// The ownership of 'ResultVisitor' remains at the caller.
@@ -18,6 +18,7 @@
 
 #include "llvm/ADT/BitVector.h"
 #include "llvm/ADT/DenseMap.h"
+#include <vector>
 
 namespace clang {
 
@@ -29,19 +30,46 @@ class CFGBlock;
 // tend to have a common destination, so we lazily do a predecessor search
 // from the destination node and cache the results to prevent work
 // duplication.
+//
+// Queries from the entry block, which are the most common ones, are answered
+// from a single forward search instead, so that they do not cost a search and
+// a set of the size of the CFG for every destination.
+//
+// Once many different destinations were queried, the reachability between
+// all the strongly connected components of the CFG is computed at once, and
+// all further queries are answered without a search.
 class CFGReverseBlockReachabilityAnalysis {
   typedef llvm::BitVector ReachableSet;
   typedef llvm::DenseMap<unsigned, ReachableSet> ReachableMap;
+  const CFG &cfg;
   ReachableSet analyzed;
   ReachableMap reachable;
+  unsigned numAnalyzed;
+
+  const CFGBlock *entry;
+  bool analyzedEntry;
+  ReachableSet reachableFromEntry;
+
+  /// The strongly connected component of each block, by block ID, and the
+  /// components reachable from each component, once computeAllReachability()
+  /// ran.
+  bool analyzedAll;
+  std::vector<unsigned> componentOf;
+  std::vector<ReachableSet> reachableComponents;
 public:
   CFGReverseBlockReachabilityAnalysis(const CFG &cfg);
 
   /// Returns true if the block 'Dst' can be reached from block 'Src'.
   bool isReachable(const CFGBlock *Src, const CFGBlock *Dst);
 
+  /// Compute the reachability between all the blocks, so that every later
+  /// query is answered without a search.  Needs a bit per pair of strongly
+  /// connected components.
+  void computeAllReachability();
+
 private:
   void mapReachability(const CFGBlock *Dst);
+  void mapReachabilityFromEntry();
 };
   
 }
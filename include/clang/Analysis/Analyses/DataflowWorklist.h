@@ -0,0 +1,56 @@
+//===- DataflowWorklist.h - Worklist for dataflow analyses --------*- C++ --*-//
+//
+//                     The LLVM Compiler Infrastructure
+//
+// This file is distributed under the University of Illinois Open Source
+// License. See LICENSE.TXT for details.
+//
+//===----------------------------------------------------------------------===//
+//
+// This file defines the worklist shared by the dataflow analyses over CFGs.
+//
+//===----------------------------------------------------------------------===//
+
+#ifndef LLVM_CLANG_DATAFLOW_WORKLIST
+#define LLVM_CLANG_DATAFLOW_WORKLIST
+
+#include "clang/Analysis/Analyses/PostOrderCFGView.h"
+#include "llvm/ADT/BitVector.h"
+#include "llvm/ADT/SmallVector.h"
+
+namespace clang {
+
+/// \brief A worklist of CFG blocks that hands out the blocks in the order
+/// dataflow values converge fastest in: reverse post order for forward
+/// analyses, so that a block is visited after its predecessors, and post order
+/// for backward analyses.  A block is only in the worklist once.
+class DataflowWorklist {
+public:
+  enum Direction { Forward, Backward };
+
+private:
+  SmallVector<const CFGBlock *, 20> worklist;
+  llvm::BitVector enqueuedBlocks;
+  PostOrderCFGView *POV;
+  Direction Dir;
+
+public:
+  DataflowWorklist(const CFG &cfg, AnalysisDeclContext &Ctx, Direction Dir)
+    : enqueuedBlocks(cfg.getNumBlockIDs()),
+      POV(Ctx.getAnalysis<PostOrderCFGView>()), Dir(Dir) {}
+
+  void enqueueBlock(const CFGBlock *block);
+  void enqueueSuccessors(const CFGBlock *block);
+  void enqueuePredecessors(const CFGBlock *block);
+
+  /// \brief Returns the next block to visit, or null if the worklist is empty.
+  const CFGBlock *dequeue();
+
+  /// \brief Restore the order of the blocks after some were enqueued.
+  /// enqueueSuccessors() and enqueuePredecessors() do this themselves.
+  void sortWorklist();
+};
+
+} // end clang namespace
+
+#endif
@@ -20,6 +20,8 @@
 #define LLVM_CLANG_FORMAT_H
 
 #include "clang/AST/CanonicalType.h"
+#include <string>
+#include <vector>
 
 namespace clang {
 
@@ -633,6 +635,61 @@ bool ParsePrintfString(FormatStringHandler &H,
 bool ParseScanfString(FormatStringHandler &H,
                       const char *beg, const char *end, const LangOptions &LO);
 
+/// ParsedFormatString - The result of parsing a printf or scanf format
+/// string, which can be reported to any number of handlers without parsing
+/// the string again.
+///
+/// The positions reported to the handlers point into a copy of the string
+/// owned by this object; handlers for another format string with the same
+/// contents should measure them from getString().begin().
+class ParsedFormatString {
+  enum EventKind {
+    EK_NullChar, EK_Position, EK_InvalidPosition, EK_ZeroPosition,
+    EK_IncompleteSpecifier, EK_InvalidPrintfConversionSpecifier,
+    EK_PrintfSpecifier, EK_InvalidScanfConversionSpecifier,
+    EK_ScanfSpecifier, EK_IncompleteScanList
+  };
+
+  /// \brief One call to a FormatStringHandler.
+  struct Event {
+    EventKind Kind;
+    const char *Start;
+    unsigned Length;
+    /// \brief The position context of an EK_InvalidPosition event, or the
+    /// index of the specifier of a specifier event.
+    unsigned Extra;
+  };
+
+  class Recorder;
+
+  std::string Str;
+  std::vector<Event> Events;
+  std::vector<analyze_printf::PrintfSpecifier> PrintfSpecifiers;
+  std::vector<analyze_scanf::ScanfSpecifier> ScanfSpecifiers;
+
+  /// \brief Whether the parser stopped before the end of the string.
+  bool Stopped;
+
+  // DO NOT IMPLEMENT
+  ParsedFormatString(const ParsedFormatString &);
+  void operator=(const ParsedFormatString &);
+
+public:
+  /// \brief Parse \p FormatStr as a scanf format string if \p IsScanf is
+  /// true, or as a printf one otherwise.
+  ParsedFormatString(StringRef FormatStr, bool IsScanf, const LangOptions &LO);
+
+  /// \brief The copy of the format string the reported positions point into.
+  StringRef getString() const { return Str; }
+
+  /// \brief Report the parse to \p H, up to the first callback which asks
+  /// to stop.
+  ///
+  /// \returns the result ParsePrintfString or ParseScanfString would return
+  /// for this handler.
+  bool report(FormatStringHandler &H) const;
+};
+
 } // end analyze_format_string namespace
 } // end clang namespace
 #endif
@@ -374,9 +374,12 @@ private:
 };
 
 class AnalysisDeclContextManager {
-  typedef llvm::DenseMap<const Decl*, AnalysisDeclContext*> ContextMap;
+  /// Maps each Decl to its context and the last time it was requested.
+  typedef llvm::DenseMap<const Decl*,
+                         std::pair<AnalysisDeclContext*, unsigned> > ContextMap;
 
   ContextMap Contexts;
+  unsigned NumRequests;
   LocationContextManager LocContexts;
   CFG::BuildOptions cfgBuildOptions;
 
@@ -423,6 +426,13 @@ public:
   /// Discard all previously created AnalysisDeclContexts.
   void clear();
 
+  /// Discard all but the \p MaxRetained most recently requested
+  /// AnalysisDeclContexts, together with their CFGs and other analyses. Those
+  /// discarded are created again if requested later.
+  ///
+  /// Like clear(), this must only be called when no analysis is running.
+  void releaseContexts(unsigned MaxRetained);
+
 private:
   friend class AnalysisDeclContext;
 
@@ -18,6 +18,7 @@
 
 #include "clang/Basic/LLVM.h"
 #include <cstring>
+#include <vector>
 
 // VC++ defines 'alloca' as an object-like macro, which interferes with our
 // builtins.
@@ -62,6 +63,12 @@ struct Info {
 class Context {
   const Info *TSRecords;
   unsigned NumTSRecords;
+
+  /// \brief The IDs of the builtins enabled by InitializeBuiltins, in an
+  /// open-addressed hash table indexed by the hash of their names. Empty
+  /// slots hold NotBuiltin.
+  std::vector<unsigned> EnabledIDs;
+
 public:
   Context();
 
@@ -71,7 +78,22 @@ public:
   /// \brief Mark the identifiers for all the builtins with their
   /// appropriate builtin ID # and mark any non-portable builtin identifiers as
   /// such.
-  void InitializeBuiltins(IdentifierTable &Table, const LangOptions& LangOpts);
+  ///
+  /// The identifiers already in \p Table are marked now, unless
+  /// \p OnlyNewIdentifiers, e.g. because they come from an AST file that
+  /// recorded their builtin IDs. The others are marked by the table when it
+  /// creates them, so that the thousands of builtins that a translation unit
+  /// does not mention cost neither identifiers nor time.
+  void InitializeBuiltins(IdentifierTable &Table, const LangOptions& LangOpts,
+                          bool OnlyNewIdentifiers = false);
+
+  /// \brief Return the ID of the builtin named \p Name if InitializeBuiltins
+  /// enabled it, or NotBuiltin.
+  unsigned lookupBuiltin(StringRef Name) const;
+
+  /// \brief Populate the vector with the names of the builtins that
+  /// InitializeBuiltins enabled, in no particular order.
+  void getEnabledBuiltinNames(SmallVectorImpl<const char *> &Names) const;
 
   /// \brief Popular the vector with the names of all of the builtins.
   void GetBuiltinNames(SmallVectorImpl<const char *> &Names,
@@ -0,0 +1,126 @@
+//===--- CompilationProfile.h - Per-TU compilation phase times --*- C++ -*-===//
+//
+//                     The LLVM Compiler Infrastructure
+//
+// This file is distributed under the University of Illinois Open Source
+// License. See LICENSE.TXT for details.
+//
+//===----------------------------------------------------------------------===//
+//
+// This file defines CompilationProfile, which records the time spent in each
+// phase of compiling a translation unit, as enabled by -compile-profile-file.
+//
+//===----------------------------------------------------------------------===//
+
+#ifndef LLVM_CLANG_BASIC_COMPILATION_PROFILE_H
+#define LLVM_CLANG_BASIC_COMPILATION_PROFILE_H
+
+#include "clang/Basic/LLVM.h"
+#include "llvm/ADT/SmallVector.h"
+#include "llvm/Support/DataTypes.h"
+
+namespace clang {
+
+/// CompilationProfile - The time spent in each phase of compiling one
+/// translation unit, and the size of the IR before and after optimization.
+///
+/// Phases nest: the self time of a phase excludes the time of the phases
+/// started while it was running, so the self times add up to the total time.
+/// A phase which is started within itself, such as a template instantiation
+/// triggered by another, counts its outermost run only in its total time.
+class CompilationProfile {
+public:
+  enum Phase {
+    Preprocessing,
+    Frontend,
+    TemplateInstantiation,
+    IRGeneration,
+    FunctionPasses,
+    ModulePasses,
+    CodeGeneration,
+    NumPhases
+  };
+
+  /// \brief The size of an LLVM module.
+  struct IRSize {
+    unsigned Functions, BasicBlocks, Instructions;
+  };
+
+private:
+  struct Cost {
+    uint64_t TotalTime, SelfTime;
+    unsigned Count;
+  };
+  Cost Costs[NumPhases];
+
+  /// \brief A phase which has not stopped yet.
+  struct ActivePhase {
+    Phase P;
+    uint64_t Start, NestedTime;
+  };
+  SmallVector<ActivePhase, 8> Active;
+
+  /// \brief The number of times each phase is in \c Active.
+  unsigned ActiveCount[NumPhases];
+
+  IRSize SizeBeforeOptimization, SizeAfterOptimization;
+  bool HasIRSize;
+
+public:
+  CompilationProfile();
+
+  /// \brief Note that the compiler started the given phase.
+  void startPhase(Phase P);
+
+  /// \brief Note that the compiler finished the most recently started
+  /// phase, which must be \p P.
+  void stopPhase(Phase P);
+
+  /// \brief Record the size of the module before and after the optimization
+  /// passes ran over it.
+  void setIRSize(const IRSize &Before, const IRSize &After);
+
+  /// \brief Write the phases and IR sizes of the translation unit \p File
+  /// as JSON.
+  void printJSON(raw_ostream &OS, StringRef File) const;
+
+  /// \brief The time spent in \p P, including the phases nested in it, in
+  /// nanoseconds.
+  uint64_t getTotalTime(Phase P) const { return Costs[P].TotalTime; }
+
+  /// \brief The time spent in \p P outside of the phases nested in it, in
+  /// nanoseconds.
+  uint64_t getSelfTime(Phase P) const { return Costs[P].SelfTime; }
+
+  /// \brief The number of times \p P ran.
+  unsigned getCount(Phase P) const { return Costs[P].Count; }
+
+  static const char *getPhaseName(Phase P);
+};
+
+/// CompilationProfileRegion - Records a phase for the lifetime of the
+/// object, if given a profile.
+class CompilationProfileRegion {
+  CompilationProfile *Profile;
+  CompilationProfile::Phase P;
+
+  // DO NOT IMPLEMENT
+  CompilationProfileRegion(const CompilationProfileRegion &);
+  void operator=(const CompilationProfileRegion &);
+
+public:
+  CompilationProfileRegion(CompilationProfile *Profile,
+                           CompilationProfile::Phase P)
+    : Profile(Profile), P(P) {
+    if (Profile)
+      Profile->startPhase(P);
+  }
+  ~CompilationProfileRegion() {
+    if (Profile)
+      Profile->stopPhase(P);
+  }
+};
+
+} // end namespace clang
+
+#endif
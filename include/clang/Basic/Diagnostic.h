@@ -134,6 +134,7 @@ public:
   enum Level {
     Ignored = DiagnosticIDs::Ignored,
     Note = DiagnosticIDs::Note,
+    Remark = DiagnosticIDs::Remark,
     Warning = DiagnosticIDs::Warning,
     Error = DiagnosticIDs::Error,
     Fatal = DiagnosticIDs::Fatal
@@ -257,6 +258,55 @@ private:
   typedef std::vector<DiagStatePoint> DiagStatePointsTy;
   mutable DiagStatePointsTy DiagStatePoints;
 
+  /// \brief The changes of diagnostic state within one file, or macro
+  /// expansion, of the translation unit.
+  ///
+  /// A DiagStatePoint in an included file or expansion also changes the
+  /// state of the file that includes it, at the offset of the inclusion.
+  struct DiagStateFile {
+    /// \brief Pairs of file offsets and DiagStatePoints indices, sorted by
+    /// offset. The first one, at offset 0, holds the state in effect where
+    /// the file is entered.
+    SmallVector<std::pair<unsigned, unsigned>, 2> Transitions;
+  };
+
+  /// \brief Indexes DiagStatePoints by FileID, so that the state of a
+  /// location is found by comparing offsets within its file rather than
+  /// locations across the include stack.
+  ///
+  /// Only the files which contain DiagStatePoints, the files including them,
+  /// and the top-level files have entries; the other files have the state in
+  /// effect where they are entered. The points are indexed lazily.
+  mutable llvm::DenseMap<FileID, DiagStateFile> DiagStateFiles;
+
+  /// \brief The number of DiagStatePoints in DiagStateFiles.
+  mutable unsigned NumIndexedDiagStatePoints;
+
+  /// \brief True if DiagStatePoints turned out not to be sorted by file
+  /// offsets, in which case DiagStateFiles is not used.
+  mutable bool DiagStateFilesInvalid;
+
+  /// \brief The location of the last lookup in DiagStateFiles and the index
+  /// of the DiagStatePoint found, valid while there are
+  /// \c LastDiagStateNumPoints points. Clients often query several
+  /// diagnostics at the same location.
+  mutable SourceLocation LastDiagStateLoc;
+  mutable unsigned LastDiagStatePoint;
+  mutable unsigned LastDiagStateNumPoints;
+
+  /// \brief Forget the index of DiagStatePoints, after they were changed
+  /// other than by appending to them.
+  void clearDiagStateFiles() const {
+    DiagStateFiles.clear();
+    NumIndexedDiagStatePoints = 0;
+    DiagStateFilesInvalid = false;
+    LastDiagStateNumPoints = 0;
+  }
+
+  void indexDiagStatePoints() const;
+  DiagStateFile &getDiagStateFile(FileID FID) const;
+  unsigned lookupDiagStatePoint(FileID FID, unsigned Offset) const;
+
   /// \brief Keeps the DiagState that was active during each diagnostic 'push'
   /// so we can get back at it when we 'pop'.
   std::vector<DiagState *> DiagStateOnPushStack;
@@ -367,7 +417,10 @@ public:
     assert(SourceMgr && "SourceManager not set!");
     return *SourceMgr;
   }
-  void setSourceManager(SourceManager *SrcMgr) { SourceMgr = SrcMgr; }
+  void setSourceManager(SourceManager *SrcMgr) {
+    SourceMgr = SrcMgr;
+    clearDiagStateFiles();
+  }
 
   //===--------------------------------------------------------------------===//
   //  DiagnosticsEngine characterization methods, used by a client to customize
@@ -613,6 +666,15 @@ public:
     return (Level)Diags->getDiagnosticLevel(DiagID, Loc, *this);
   }
 
+  /// \brief Determine whether the diagnostic is ignored at the given
+  /// location, honoring the diagnostic pragmas in effect there.
+  ///
+  /// Clients should use this to skip analyses whose only purpose is to
+  /// produce a warning that would be ignored anyway.
+  bool isIgnored(unsigned DiagID, SourceLocation Loc) const {
+    return getDiagnosticLevel(DiagID, Loc) == Ignored;
+  }
+
   /// \brief Issue the message to the client.
   ///
   /// This actually returns an instance of DiagnosticBuilder which emits the
@@ -17,6 +17,7 @@
 
 #include "clang/Basic/FileSystemOptions.h"
 #include "clang/Basic/LLVM.h"
+#include "clang/Basic/VirtualFileSystem.h"
 #include "llvm/ADT/IntrusiveRefCntPtr.h"
 #include "llvm/ADT/SmallVector.h"
 #include "llvm/ADT/StringMap.h"
@@ -39,6 +40,7 @@ namespace sys { class Path; }
 
 namespace clang {
 class FileManager;
+class FilePrefetcher;
 class FileSystemStatCache;
 
 /// \brief Cached information about one directory (either on disk or in
@@ -115,6 +117,9 @@ public:
 class FileManager : public RefCountedBase<FileManager> {
   FileSystemOptions FileSystemOpts;
 
+  /// \brief The file system the files and directories are looked up in.
+  IntrusiveRefCntPtr<VirtualFileSystem> FS;
+
   class UniqueDirContainer;
   class UniqueFileContainer;
 
@@ -159,6 +164,9 @@ class FileManager : public RefCountedBase<FileManager> {
   // Caching.
   OwningPtr<FileSystemStatCache> StatCache;
 
+  /// \brief Contents of files read ahead of time, if any.
+  OwningPtr<FilePrefetcher> Prefetcher;
+
   bool getStatValue(const char *Path, struct stat &StatBuf,
                     int *FileDescriptor);
 
@@ -167,7 +175,10 @@ class FileManager : public RefCountedBase<FileManager> {
   void addAncestorsAsVirtualDirs(StringRef Path);
 
 public:
-  FileManager(const FileSystemOptions &FileSystemOpts);
+  /// \brief Construct a FileManager for the files of the file system \p FS,
+  /// or of the operating system if \p FS is null.
+  FileManager(const FileSystemOptions &FileSystemOpts,
+              VirtualFileSystem *FS = 0);
   ~FileManager();
 
   /// \brief Installs the provided FileSystemStatCache object within
@@ -189,6 +200,12 @@ public:
   /// \brief Removes all FileSystemStatCache objects from the manager.
   void clearStatCaches();
 
+  /// \brief Installs a FilePrefetcher whose contents getBufferForFile()
+  /// uses when it can.
+  ///
+  /// Ownership of the prefetcher is transferred to the FileManager.
+  void setPrefetcher(FilePrefetcher *P);
+
   /// \brief Lookup, cache, and verify the specified directory (real or
   /// virtual).
   ///
@@ -214,6 +231,9 @@ public:
   /// \brief Returns the current file system options
   const FileSystemOptions &getFileSystemOptions() { return FileSystemOpts; }
 
+  /// \brief Returns the file system the files are looked up in.
+  VirtualFileSystem &getVirtualFileSystem() const { return *FS; }
+
   /// \brief Retrieve a file entry for a "virtual" file that acts as
   /// if there were a file with the given name on disk.
   ///
@@ -221,13 +241,21 @@ public:
   const FileEntry *getVirtualFile(StringRef Filename, off_t Size,
                                   time_t ModificationTime);
 
+  /// \brief Whether any "virtual" file was created by getVirtualFile().
+  bool hasVirtualFiles() const { return !VirtualFileEntries.empty(); }
+
   /// \brief Open the specified file as a MemoryBuffer, returning a new
   /// MemoryBuffer if successful, otherwise returning null.
+  ///
+  /// If \p RequiresNullTerminator is false, the buffer is not guaranteed to
+  /// be followed by a null character, which lets big files always be mapped
+  /// rather than copied into memory.
   llvm::MemoryBuffer *getBufferForFile(const FileEntry *Entry,
                                        std::string *ErrorStr = 0,
                                        bool isVolatile = false);
   llvm::MemoryBuffer *getBufferForFile(StringRef Filename,
-                                       std::string *ErrorStr = 0);
+                                       std::string *ErrorStr = 0,
+                                       bool RequiresNullTerminator = true);
 
   /// \brief Get the 'stat' information for the given \p Path.
   ///
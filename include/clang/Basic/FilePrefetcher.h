@@ -0,0 +1,97 @@
+//===--- FilePrefetcher.h - Reading files before they are needed -*- C++ -*-==//
+//
+//                     The LLVM Compiler Infrastructure
+//
+// This file is distributed under the University of Illinois Open Source
+// License. See LICENSE.TXT for details.
+//
+//===----------------------------------------------------------------------===//
+///
+/// \file
+/// \brief Defines FilePrefetcher, which reads the files a compilation is
+/// expected to need on background threads.
+///
+//===----------------------------------------------------------------------===//
+
+#ifndef LLVM_CLANG_BASIC_FILEPREFETCHER_H
+#define LLVM_CLANG_BASIC_FILEPREFETCHER_H
+
+#include "clang/Basic/LLVM.h"
+#include "clang/Basic/Parallel.h"
+#include "llvm/Support/Mutex.h"
+#include <map>
+#include <string>
+#include <vector>
+#include <sys/types.h>
+
+namespace llvm {
+class MemoryBuffer;
+}
+
+namespace clang {
+
+class FileEntry;
+
+/// \brief Reads a list of files on background threads, so that a
+/// FileManager can hand out their contents without waiting for the file
+/// system when they are included later on.
+///
+/// The files are identified by device and inode, so the spelling of their
+/// names does not have to match the one used to include them. A file is only
+/// handed out if its size and modification time still match those the
+/// FileManager saw; files that have not been read yet are read by the
+/// FileManager as usual.
+class FilePrefetcher {
+public:
+  /// \brief A file, read or about to be read.
+  struct File {
+    std::string Path;
+    dev_t Device;
+    ino_t Inode;
+    off_t Size;
+    time_t ModTime;
+    llvm::MemoryBuffer *Buffer;
+  };
+
+private:
+  std::vector<File> Files;
+  unsigned NumThreads;
+
+  /// \brief Guards ReadFiles and Cancelled.
+  llvm::sys::Mutex Lock;
+  std::map<std::pair<dev_t, ino_t>, unsigned> ReadFiles;
+  bool Cancelled;
+
+  BackgroundThread Thread;
+
+  FilePrefetcher(const FilePrefetcher &); // DO NOT IMPLEMENT
+  void operator=(const FilePrefetcher &); // DO NOT IMPLEMENT
+
+  static void run(void *UserData);
+  static void readFile(void *UserData, unsigned Index);
+
+public:
+  /// \brief Start reading \p Paths, with up to \p NumThreads reads in
+  /// flight at once.
+  ///
+  /// Nothing is read when threads are not available.
+  explicit FilePrefetcher(ArrayRef<std::string> Paths, unsigned NumThreads = 4);
+
+  /// \brief Stop reading, and free the contents nobody took.
+  ~FilePrefetcher();
+
+  /// \brief Take the contents read for \p Entry, if they have been read
+  /// already and the file is unchanged.
+  ///
+  /// \returns the contents, which the caller owns, or null.
+  llvm::MemoryBuffer *take(const FileEntry *Entry);
+
+  /// \brief Read the list of files to prefetch from \p ListFile, which names
+  /// one file per line.
+  static bool readFileList(StringRef ListFile,
+                           std::vector<std::string> &Paths);
+};
+
+} // end namespace clang
+
+#endif
@@ -25,6 +25,16 @@ public:
   /// \brief If set, paths are resolved as if the working directory was
   /// set to the value of WorkingDir.
   std::string WorkingDir;
+
+  /// \brief If set, the files listed in this file, one per line, are read
+  /// on background threads before they are needed.
+  std::string PrefetchFileList;
+
+  /// \brief Whether file system lookups go through the process-wide
+  /// SharedStatCache, so that later compiles in the same process reuse them.
+  bool UseSharedStatCache;
+
+  FileSystemOptions() : UseSharedStatCache(false) {}
 };
 
 } // end namespace clang
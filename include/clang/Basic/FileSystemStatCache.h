@@ -23,6 +23,8 @@
 
 namespace clang {
 
+class VirtualFileSystem;
+
 /// \brief Abstract interface for introducing a FileManager cache for 'stat'
 /// system calls, which is used by precompiled and pretokenized headers to
 /// improve performance.
@@ -49,8 +51,10 @@ public:
   /// success for directories (not files).  On a successful file lookup, the
   /// implementation can optionally fill in FileDescriptor with a valid
   /// descriptor and the client guarantees that it will close it.
+  ///
+  /// Lookups the caches cannot answer are answered by the file system \p FS.
   static bool get(const char *Path, struct stat &StatBuf, int *FileDescriptor,
-                  FileSystemStatCache *Cache);
+                  FileSystemStatCache *Cache, VirtualFileSystem &FS);
   
   
   /// \brief Sets the next stat call cache in the chain of stat caches.
@@ -69,16 +73,17 @@ public:
   
 protected:
   virtual LookupResult getStat(const char *Path, struct stat &StatBuf,
-                               int *FileDescriptor) = 0;
+                               int *FileDescriptor, VirtualFileSystem &FS) = 0;
 
   LookupResult statChained(const char *Path, struct stat &StatBuf,
-                           int *FileDescriptor) {
+                           int *FileDescriptor, VirtualFileSystem &FS) {
     if (FileSystemStatCache *Next = getNextStatCache())
-      return Next->getStat(Path, StatBuf, FileDescriptor);
+      return Next->getStat(Path, StatBuf, FileDescriptor, FS);
     
     // If we hit the end of the list of stat caches to try, just compute and
     // return it without a cache.
-    return get(Path, StatBuf, FileDescriptor, 0) ? CacheMissing : CacheExists;
+    return get(Path, StatBuf, FileDescriptor, 0, FS) ? CacheMissing
+                                                      : CacheExists;
   }
 };
 
@@ -97,7 +102,49 @@ public:
   iterator end() const { return StatCalls.end(); }
   
   virtual LookupResult getStat(const char *Path, struct stat &StatBuf,
-                               int *FileDescriptor);
+                               int *FileDescriptor, VirtualFileSystem &FS);
+};
+
+/// \brief A stat cache backed by a single, process-wide table that is shared
+/// by every SharedStatCache instance, in every thread.
+///
+/// Each FileManager that should take part owns its own SharedStatCache object
+/// (usually installed at the end of its chain, after any PCH or PTH caches);
+/// the results themselves are stored once for the whole process. This avoids
+/// re-stating the same system headers and search directories for every
+/// translation unit of a batch run.
+///
+/// Only absolute paths of the real file system are cached, since relative
+/// paths depend on the working directory of the FileManager or the process,
+/// and other VirtualFileSystems on the FileManager using them. The table is
+/// sharded and guarded by reader/writer locks, so concurrent lookups of
+/// cached paths do not contend with each other.
+class SharedStatCache : public FileSystemStatCache {
+  bool CacheMissingPaths;
+  bool ValidateOnOpen;
+
+public:
+  /// \param CacheMissingPaths Whether paths that do not exist are cached as
+  /// well. Most of the stat traffic of header search consists of probing
+  /// directories that do not contain the header, but clients that create
+  /// files during the run must either disable this or call invalidate().
+  ///
+  /// \param ValidateOnOpen Whether cached files that the FileManager is about
+  /// to open are re-checked with open+fstat, which the uncached lookup would
+  /// have done anyway. If their size or modification time changed, the shared
+  /// entry is updated. Directories and missing paths are never re-checked.
+  explicit SharedStatCache(bool CacheMissingPaths = true,
+                           bool ValidateOnOpen = false)
+    : CacheMissingPaths(CacheMissingPaths), ValidateOnOpen(ValidateOnOpen) {}
+
+  /// \brief Forget the cached result for the given absolute path.
+  static void invalidate(StringRef Path);
+
+  /// \brief Forget all cached results.
+  static void invalidateAll();
+
+  virtual LookupResult getStat(const char *Path, struct stat &StatBuf,
+                               int *FileDescriptor, VirtualFileSystem &FS);
 };
 
 } // end namespace clang
@@ -24,7 +24,9 @@
 #include "llvm/ADT/OwningPtr.h"
 #include "llvm/Support/PointerLikeTypeTraits.h"
 #include <cassert>
+#include <cstring>
 #include <string>
+#include <vector>
 
 namespace llvm {
   template <typename T> struct DenseMapInfo;
@@ -37,6 +39,7 @@ namespace clang {
   class SourceLocation;
   class MultiKeywordSelector; // private class used by Selector
   class DeclarationName;      // AST class that stores declaration names
+  namespace Builtin { class Context; }
 
   /// \brief A simple pair of identifier info and location.
   typedef std::pair<IdentifierInfo*, SourceLocation> IdentifierLocPair;
@@ -387,6 +390,10 @@ public:
   /// \returns A new iterator into the set of known identifiers. The
   /// caller is responsible for deleting this iterator.
   virtual IdentifierIterator *getIdentifiers() const;
+
+  /// \brief Retrieve a number which changes whenever the set of identifiers
+  /// returned by getIdentifiers() may have grown.
+  virtual unsigned getIdentifiersGeneration() const { return 0; }
 };
 
 /// \brief An abstract class used to resolve numerical identifier
@@ -415,12 +422,35 @@ class IdentifierTable {
 
   IdentifierInfoLookup* ExternalLookup;
 
+  /// \brief The builtins that mark the identifiers this table creates, see
+  /// Builtin::Context::InitializeBuiltins.
+  const Builtin::Context *LazyBuiltins;
+
+  /// \brief A direct-mapped cache of the identifiers looked up by
+  /// getForLexer(), indexed by getQuickHash(). Its size is a power of two.
+  std::vector<IdentifierInfo*> LexerCache;
+
+  void setLazyBuiltinID(IdentifierInfo &II);
+
+  /// \brief Read \p N bytes of \p P, which need not be aligned.
+  static uint64_t readBytes(const unsigned char *P, unsigned N) {
+    uint64_t V = 0;
+    memcpy(&V, P, N);
+    return V;
+  }
+
 public:
   /// \brief Create the identifier table, populating it with info about the
   /// language keywords for the language specified by \p LangOpts.
   IdentifierTable(const LangOptions &LangOpts,
                   IdentifierInfoLookup* externalLookup = 0);
 
+  /// \brief Mark each identifier that is created from now on with its
+  /// builtin ID in \p Builtins, if any.
+  void setLazyBuiltins(const Builtin::Context *Builtins) {
+    LazyBuiltins = Builtins;
+  }
+
   /// \brief Set the external identifier lookup mechanism.
   void setExternalIdentifierLookup(IdentifierInfoLookup *IILookup) {
     ExternalLookup = IILookup;
@@ -463,9 +493,51 @@ public:
     // contents.
     II->Entry = &Entry;
 
+    if (LazyBuiltins)
+      setLazyBuiltinID(*II);
+
     return *II;
   }
 
+  /// \brief Hash an identifier from its length and at most 16 of its bytes,
+  /// at either end, so that the hash costs the same for all names.
+  static unsigned getQuickHash(StringRef Name) {
+    const unsigned char *P = Name.bytes_begin();
+    unsigned Len = Name.size();
+    uint64_t H;
+    if (Len >= 8)
+      H = readBytes(P, 8) ^ (readBytes(P + Len - 8, 8) >> 1);
+    else if (Len >= 4)
+      H = readBytes(P, 4) | (readBytes(P + Len - 4, 4) << 32);
+    else if (Len)
+      H = P[0] | (P[Len / 2] << 8) | (P[Len - 1] << 16);
+    else
+      H = 0;
+    H = (H ^ Len) * 0x9E3779B97F4A7C15ULL;
+    return unsigned(H >> 32);
+  }
+
+  /// \brief Return the identifier token info for an identifier the lexer
+  /// found.
+  ///
+  /// This is get() behind a cache of the identifiers recently found, which
+  /// answers most lookups with one comparison, without hashing the whole
+  /// name.
+  IdentifierInfo &getForLexer(StringRef Name) {
+    IdentifierInfo *&Slot =
+      LexerCache[getQuickHash(Name) & (LexerCache.size() - 1)];
+    if (Slot && Slot->getLength() == Name.size() &&
+        memcmp(Slot->getNameStart(), Name.data(), Name.size()) == 0)
+      return *Slot;
+    Slot = &get(Name);
+    return *Slot;
+  }
+
+  /// \brief Grow the cache of getForLexer() for a program with about
+  /// \p NumIdentifiers identifiers, such as those of the AST files it
+  /// loads.
+  void reserveLexerCache(unsigned NumIdentifiers);
+
   IdentifierInfo &get(StringRef Name, tok::TokenKind TokenCode) {
     IdentifierInfo &II = get(Name);
     II.TokenID = TokenCode;
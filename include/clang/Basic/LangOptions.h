@@ -62,6 +62,12 @@ public:
     FPC_Fast        // Aggressively fuse FP ops (E.g. FMA).
   };
 
+  enum PCHVTablesMode {
+    PCHVTablesEverywhere, // Emit them wherever used, the default.
+    PCHVTablesOwner,      // Emit those of the AST file, -fpch-vtables=owner.
+    PCHVTablesExternal    // Leave those of the AST file to its owner.
+  };
+
 public:
   clang::ObjCRuntime ObjCRuntime;
 
@@ -89,6 +95,11 @@ public:
     return getSignedOverflowBehavior() == SOB_Defined;
   }
 
+  /// \brief Whether the translation unit can import modules, either because
+  /// modules are enabled or because the builtin intrinsic headers are
+  /// imported as a module.
+  bool allowsModuleImports() const { return Modules || IntrinsicsModule; }
+
   /// \brief Reset all of the options that are not considered when building a
   /// module.
   void resetNonModularOptions();
@@ -0,0 +1,60 @@
+//===--- MD5.h - Computing MD5 digests of byte strings ----------*- C++ -*-===//
+//
+//                     The LLVM Compiler Infrastructure
+//
+// This file is distributed under the University of Illinois Open Source
+// License. See LICENSE.TXT for details.
+//
+//===----------------------------------------------------------------------===//
+///
+/// \file
+/// \brief Defines the MD5 class, which computes the MD5 digest (RFC 1321) of
+/// a sequence of bytes.
+///
+/// This is used where a 32-bit hash would make collisions too likely, such as
+/// to tell whether a file changed from its contents alone. It is not meant to
+/// resist deliberate collisions.
+///
+//===----------------------------------------------------------------------===//
+
+#ifndef LLVM_CLANG_BASIC_MD5_H
+#define LLVM_CLANG_BASIC_MD5_H
+
+#include "clang/Basic/LLVM.h"
+#include "llvm/ADT/StringRef.h"
+#include "llvm/Support/DataTypes.h"
+
+namespace clang {
+
+/// \brief Computes the MD5 digest of the bytes passed to update().
+class MD5 {
+  uint32_t A, B, C, D;
+
+  /// \brief The number of bytes passed to update() so far.
+  uint64_t Length;
+
+  /// \brief The bytes of the current, incomplete 64-byte block.
+  uint8_t Buffer[64];
+
+  void processBlock(const uint8_t *Block);
+
+public:
+  /// \brief The 16 bytes of a digest.
+  typedef uint8_t Digest[16];
+
+  MD5();
+
+  /// \brief Adds \p Data to the bytes being digested.
+  void update(StringRef Data);
+
+  /// \brief Finishes the digest and stores it in \p Result. The object must
+  /// not be updated afterwards.
+  void final(Digest &Result);
+
+  /// \brief Returns the digest of \p Data as four little-endian 32-bit words.
+  static void hash(StringRef Data, uint32_t (&Words)[4]);
+};
+
+} // end namespace clang
+
+#endif
@@ -187,16 +187,33 @@ public:
   }
 
   io::Offset Emit(raw_ostream &out, Info &InfoObj) {
+    // Emit the payload of the table.
+    EmitBuckets(out, 0, NumBuckets, InfoObj);
+
+    // Emit the hashtable itself.
+    return EmitTable(out);
+  }
+
+  unsigned getNumBuckets() const { return NumBuckets; }
+  unsigned getNumEntries() const { return NumEntries; }
+
+  /// EmitBuckets - Emit the payload of the buckets [Begin, End) to \p out and
+  /// record the offset of each bucket within \p out.
+  ///
+  /// Disjoint ranges of buckets may be emitted concurrently into separate
+  /// streams if \p InfoObj can be used from several threads.  The streams
+  /// must then be concatenated, each range moved to its final offset with
+  /// RelocateBuckets(), and the table finished with EmitTable().
+  void EmitBuckets(raw_ostream &out, unsigned Begin, unsigned End,
+                   Info &InfoObj) {
     using namespace clang::io;
 
-    // Emit the payload of the table.
-    for (unsigned i = 0; i < NumBuckets; ++i) {
+    for (unsigned i = Begin; i < End; ++i) {
       Bucket& B = Buckets[i];
       if (!B.head) continue;
 
       // Store the offset for the data of this bucket.
       B.off = out.tell();
-      assert(B.off && "Cannot write a bucket at offset 0. Please add padding.");
 
       // Write out the number of items in the bucket.
       Emit16(out, B.length);
@@ -211,13 +228,30 @@ public:
         InfoObj.EmitData(out, I->key, I->data, Len.second);
       }
     }
+  }
+
+  /// RelocateBuckets - Add \p Delta to the offsets of the non-empty buckets
+  /// in [Begin, End).
+  void RelocateBuckets(unsigned Begin, unsigned End, io::Offset Delta) {
+    for (unsigned i = Begin; i < End; ++i)
+      if (Buckets[i].head)
+        Buckets[i].off += Delta;
+  }
+
+  /// EmitTable - Emit the bucket offsets after the payload written by
+  /// EmitBuckets() and return the offset of the table.
+  io::Offset EmitTable(raw_ostream &out) {
+    using namespace clang::io;
 
-    // Emit the hashtable itself.
     Pad(out, 4);
     io::Offset TableOff = out.tell();
     Emit32(out, NumBuckets);
     Emit32(out, NumEntries);
-    for (unsigned i = 0; i < NumBuckets; ++i) Emit32(out, Buckets[i].off);
+    for (unsigned i = 0; i < NumBuckets; ++i) {
+      assert((!Buckets[i].head || Buckets[i].off) &&
+             "Cannot write a bucket at offset 0. Please add padding.");
+      Emit32(out, Buckets[i].off);
+    }
 
     return TableOff;
   }
@@ -398,6 +432,60 @@ public:
   }
   key_iterator key_end() { return key_iterator(); }
 
+  /// \brief Iterates over the hash values of all of the entries in the table,
+  /// without reading their keys.
+  class hash_iterator {
+    const unsigned char* Ptr;
+    unsigned NumItemsInBucketLeft;
+    unsigned NumEntriesLeft;
+  public:
+    typedef unsigned value_type;
+
+    hash_iterator(const unsigned char* const Ptr, unsigned NumEntries)
+      : Ptr(Ptr), NumItemsInBucketLeft(0), NumEntriesLeft(NumEntries) { }
+    hash_iterator()
+      : Ptr(0), NumItemsInBucketLeft(0), NumEntriesLeft(0) { }
+
+    bool operator==(const hash_iterator& X) const {
+      return X.NumEntriesLeft == NumEntriesLeft;
+    }
+    bool operator!=(const hash_iterator& X) const {
+      return X.NumEntriesLeft != NumEntriesLeft;
+    }
+
+    hash_iterator& operator++() {  // Preincrement
+      if (!NumItemsInBucketLeft) {
+        // 'Items' starts with a 16-bit unsigned integer representing the
+        // number of items in this bucket.
+        NumItemsInBucketLeft = io::ReadUnalignedLE16(Ptr);
+      }
+      Ptr += 4; // Skip the hash.
+      // Determine the length of the key and the data.
+      const std::pair<unsigned, unsigned>& L = Info::ReadKeyDataLength(Ptr);
+      Ptr += L.first + L.second;
+      assert(NumItemsInBucketLeft);
+      --NumItemsInBucketLeft;
+      assert(NumEntriesLeft);
+      --NumEntriesLeft;
+      return *this;
+    }
+    hash_iterator operator++(int) {  // Postincrement
+      hash_iterator tmp = *this; ++*this; return tmp;
+    }
+
+    value_type operator*() const {
+      const unsigned char* LocalPtr = Ptr;
+      if (!NumItemsInBucketLeft)
+        LocalPtr += 2; // number of items in bucket
+      return io::ReadUnalignedLE32(LocalPtr);
+    }
+  };
+
+  hash_iterator hash_begin() {
+    return hash_iterator(Base + 4, getNumEntries());
+  }
+  hash_iterator hash_end() { return hash_iterator(); }
+
   /// \brief Iterates over all the entries in the table, returning the data.
   class data_iterator {
     const unsigned char* Ptr;
@@ -0,0 +1,76 @@
+//===--- Parallel.h - Running independent tasks on worker threads -*- C++ -*-===//
+//
+//                     The LLVM Compiler Infrastructure
+//
+// This file is distributed under the University of Illinois Open Source
+// License. See LICENSE.TXT for details.
+//
+//===----------------------------------------------------------------------===//
+///
+/// \file
+/// \brief Defines minimal facilities for running a batch of independent tasks
+/// on a fixed number of worker threads, or a single task in the background.
+///
+//===----------------------------------------------------------------------===//
+
+#ifndef LLVM_CLANG_BASIC_PARALLEL_H
+#define LLVM_CLANG_BASIC_PARALLEL_H
+
+namespace clang {
+
+/// \brief Returns the number of hardware threads available to the process,
+/// or 1 if it cannot be determined.
+unsigned getNumberOfHardwareThreads();
+
+/// \brief Returns true if runTasksInParallel() can actually use more than one
+/// thread in this build.
+bool isParallelExecutionSupported();
+
+/// \brief Calls \p Fn(UserData, I) once for every \c I in [0, NumTasks).
+///
+/// The tasks are handed out in increasing order to up to \p NumThreads worker
+/// threads, and the function returns once every task has completed. Tasks must
+/// not depend on each other; callers that need deterministic output should
+/// store per-task results by index and combine them after this returns.
+///
+/// If \p NumThreads is 0, the number of hardware threads is used. When threads
+/// are not available, or only one thread is requested, the tasks are run
+/// serially on the calling thread.
+///
+/// \param StackSize The stack size requested for each worker thread, or 0 for
+/// the default.
+void runTasksInParallel(unsigned NumThreads, unsigned NumTasks,
+                        void (*Fn)(void *UserData, unsigned TaskIndex),
+                        void *UserData, unsigned StackSize = 0);
+
+/// \brief A thread that runs a single function in the background.
+///
+/// The thread is joined when the object is destroyed.
+class BackgroundThread {
+  void *Thread;
+
+  BackgroundThread(const BackgroundThread &); // DO NOT IMPLEMENT
+  void operator=(const BackgroundThread &); // DO NOT IMPLEMENT
+
+public:
+  BackgroundThread() : Thread(0) { }
+  ~BackgroundThread() { join(); }
+
+  /// \brief Start running \p Fn(UserData) on a new thread.
+  ///
+  /// \returns false if the thread could not be created, in which case the
+  /// caller remains responsible for running the task. Threads cannot be
+  /// created when isParallelExecutionSupported() is false.
+  bool start(void (*Fn)(void *UserData), void *UserData,
+             unsigned StackSize = 0);
+
+  /// \brief Whether a thread was started and has not been joined yet.
+  bool isJoinable() const { return Thread != 0; }
+
+  /// \brief Wait for the thread, if any, to finish.
+  void join();
+};
+
+} // end namespace clang
+
+#endif
@@ -0,0 +1,40 @@
+//===--- ProfilingSupport.h - Helpers for profiling reports -----*- C++ -*-===//
+//
+//                     The LLVM Compiler Infrastructure
+//
+// This file is distributed under the University of Illinois Open Source
+// License. See LICENSE.TXT for details.
+//
+//===----------------------------------------------------------------------===//
+///
+/// \file
+/// \brief Declares the clock and JSON helpers shared by the profilers and
+/// benchmarks that report where compile time goes.
+///
+//===----------------------------------------------------------------------===//
+
+#ifndef LLVM_CLANG_BASIC_PROFILINGSUPPORT_H
+#define LLVM_CLANG_BASIC_PROFILINGSUPPORT_H
+
+#include "clang/Basic/LLVM.h"
+#include "llvm/ADT/StringRef.h"
+#include "llvm/Support/DataTypes.h"
+
+namespace clang {
+
+/// \brief The current wall-clock time, in nanoseconds.
+uint64_t getCurrentTimeInNanoseconds();
+
+/// \brief The current wall-clock time, in milliseconds.
+uint64_t getCurrentTimeInMilliseconds();
+
+/// \brief The current wall-clock time, in seconds.
+double getCurrentTimeInSeconds();
+
+/// \brief Print \p Str to \p OS as a quoted JSON string, escaping quotes,
+/// backslashes and control characters.
+void printJSONString(raw_ostream &OS, StringRef Str);
+
+} // end namespace clang
+
+#endif
@@ -459,6 +459,8 @@ class IsBeforeInTranslationUnitCache {
   /// random token in the parent.
   unsigned LCommonOffset, RCommonOffset;
 public:
+  IsBeforeInTranslationUnitCache()
+    : IsLQFIDBeforeRQFID(false), LCommonOffset(0), RCommonOffset(0) { }
 
   /// \brief Return true if the currently cached values match up with
   /// the specified LHS/RHS query.
@@ -545,6 +547,10 @@ class SourceManager : public RefCountedBase<SourceManager> {
   /// (likely to change while trying to use them). Defaults to false.
   bool UserFilesAreVolatile;
 
+  /// \brief True if the preprocessor should release the buffers of the
+  /// files it has finished lexing. Defaults to false.
+  bool ReleaseFinishedBuffers;
+
   struct OverriddenFilesInfoTy {
     /// \brief Files that have been overriden with the contents from another
     /// file.
@@ -631,9 +637,34 @@ class SourceManager : public RefCountedBase<SourceManager> {
 
   // Statistics for -print-stats.
   mutable unsigned NumLinearScans, NumBinaryProbes;
+  unsigned NumReleasedBuffers;
+  uint64_t NumReleasedBufferBytes;
+
+  // Cache results for the isBeforeInTranslationUnit method, for each pair of
+  // FileIDs compared.  Once the map is full, the remaining pairs share
+  // IsBeforeInTUCacheOverflow.
+  typedef llvm::DenseMap<std::pair<FileID, FileID>,
+                         IsBeforeInTranslationUnitCache> IsBeforeInTUCacheMap;
+  mutable IsBeforeInTUCacheMap IsBeforeInTUCache;
+  mutable IsBeforeInTranslationUnitCache IsBeforeInTUCacheOverflow;
+
+  /// \brief The parent of a FileID in the tree of \#includes and macro
+  /// expansions, as used by isBeforeInTranslationUnit.
+  struct IncludeParent {
+    /// \brief The FileID of the \#include or expansion location, or an
+    /// invalid FileID at the root of the tree.
+    FileID ParentFID;
+
+    /// \brief The offset of the \#include or expansion location in ParentFID.
+    unsigned Offset;
+
+    /// \brief The number of ancestors of the FileID.
+    unsigned Depth;
+  };
 
-  // Cache results for the isBeforeInTranslationUnit method.
-  mutable IsBeforeInTranslationUnitCache IsBeforeInTUCache;
+  /// \brief The parents of the FileIDs that isBeforeInTranslationUnit has
+  /// looked at, which spare it decomposing the same locations again.
+  mutable llvm::DenseMap<FileID, IncludeParent> IncludeParents;
 
   // Cache for the "fake" buffer used for error-recovery purposes.
   mutable llvm::MemoryBuffer *FakeBufferForRecovery;
@@ -646,6 +677,10 @@ class SourceManager : public RefCountedBase<SourceManager> {
 
   mutable llvm::DenseMap<FileID, MacroArgsMap *> MacroArgsCacheMap;
 
+  /// \brief Line tables being computed in the background, if any.
+  struct LineTablePrecomputation;
+  mutable LineTablePrecomputation *PendingLineTables;
+
   // SourceManager doesn't support copy construction.
   explicit SourceManager(const SourceManager&);
   void operator=(const SourceManager&);
@@ -670,6 +705,22 @@ public:
   /// (likely to change while trying to use them).
   bool userFilesAreVolatile() const { return UserFilesAreVolatile; }
 
+  /// \brief Set whether the preprocessor should release the buffers of the
+  /// files it has finished lexing, see releaseFileBuffer.
+  void setReleaseFinishedBuffers(bool Release) {
+    ReleaseFinishedBuffers = Release;
+  }
+  bool shouldReleaseFinishedBuffers() const { return ReleaseFinishedBuffers; }
+
+  /// \brief Release the memory of the buffer of \p FID, which is not being
+  /// lexed anymore, if that can be done without invalidating pointers into
+  /// the buffer.
+  ///
+  /// Only buffers that map a file can be released.  Their pages are dropped
+  /// and read back from the file on demand, when the buffer is next used by
+  /// getCharacterData or a diagnostic.  Buffers on the heap are kept.
+  void releaseFileBuffer(FileID FID);
+
   /// \brief Create the FileID for a memory buffer that will represent the
   /// FileID for the main source.
   ///
@@ -1154,6 +1205,30 @@ public:
   unsigned getExpansionLineNumber(SourceLocation Loc, bool *Invalid = 0) const;
   unsigned getPresumedLineNumber(SourceLocation Loc, bool *Invalid = 0) const;
 
+  /// \brief Return the offsets of the starts of the lines of the file
+  /// \p FID, computing them if needed.
+  ///
+  /// Returns an empty array if \p FID is not a file or its buffer is invalid.
+  ArrayRef<unsigned> getLineTable(FileID FID, bool *Invalid = 0) const;
+
+  /// \brief Provide the offsets of the starts of the lines of the file \p FID,
+  /// e.g. as read from an AST file, so that they don't need to be computed
+  /// from its buffer.
+  ///
+  /// Has no effect if the line table of the file is already known.
+  void setLineTable(FileID FID, ArrayRef<unsigned> LineOffsets);
+
+  /// \brief Start computing the line tables of all files whose buffers are
+  /// loaded and at least \p MinFileSize bytes long, on a background thread.
+  ///
+  /// Line number queries wait for the computation to finish.  If threads are
+  /// not available, the tables are computed before this returns.
+  void startLineTablePrecomputation(unsigned MinFileSize = 0);
+
+  /// \brief Wait for the line tables started by startLineTablePrecomputation()
+  /// and make them available.
+  void finishLineTablePrecomputation() const;
+
   /// \brief Return the filename or buffer identifier of the buffer the
   /// location is in.
   ///
@@ -1558,6 +1633,10 @@ private:
                                    unsigned Offset) const;
   void computeMacroArgsCache(MacroArgsMap *&MacroArgsCache, FileID FID) const;
 
+  IsBeforeInTranslationUnitCache &getIsBeforeInTUCache(FileID LFID,
+                                                       FileID RFID) const;
+  IncludeParent getIncludeParent(FileID FID) const;
+
   friend class ASTReader;
   friend class ASTWriter;
 };
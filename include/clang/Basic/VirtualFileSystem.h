@@ -0,0 +1,141 @@
+//===--- VirtualFileSystem.h - File system beneath FileManager --*- C++ -*-===//
+//
+//                     The LLVM Compiler Infrastructure
+//
+// This file is distributed under the University of Illinois Open Source
+// License. See LICENSE.TXT for details.
+//
+//===----------------------------------------------------------------------===//
+///
+/// \file
+/// \brief Defines the VirtualFileSystem interface, through which a
+/// FileManager reaches the files it manages, and its implementations.
+///
+//===----------------------------------------------------------------------===//
+
+#ifndef LLVM_CLANG_BASIC_VIRTUAL_FILE_SYSTEM_H
+#define LLVM_CLANG_BASIC_VIRTUAL_FILE_SYSTEM_H
+
+#include "clang/Basic/LLVM.h"
+#include "llvm/ADT/IntrusiveRefCntPtr.h"
+#include "llvm/ADT/OwningPtr.h"
+#include "llvm/ADT/SmallVector.h"
+#include "llvm/ADT/StringMap.h"
+#include "llvm/Support/DataTypes.h"
+#include "llvm/Support/system_error.h"
+#include <sys/types.h>
+#include <sys/stat.h>
+
+namespace llvm {
+class MemoryBuffer;
+}
+
+namespace clang {
+
+/// \brief The file system beneath a FileManager.
+///
+/// The FileManager, and the chain of FileSystemStatCaches it owns, only ever
+/// reach the files and directories they manage through this interface. By
+/// default that is the file system of the operating system, but clients can
+/// serve whole source trees from memory or from their own store instead.
+class VirtualFileSystem : public RefCountedBase<VirtualFileSystem> {
+  virtual void anchor();
+
+public:
+  virtual ~VirtualFileSystem() {}
+
+  /// \brief Get the 'stat' information for the specified path.
+  ///
+  /// \returns \c true if the path does not exist or \c false if it exists.
+  ///
+  /// If FileDescriptor is non-null, the client is about to open the file and
+  /// the implementation can optionally fill in FileDescriptor with a valid
+  /// descriptor; the client guarantees that it will close it. Whether the
+  /// path is a file or a directory is checked by the client.
+  virtual bool getStat(const char *Path, struct stat &StatBuf,
+                       int *FileDescriptor) = 0;
+
+  /// \brief Read the contents of the file at the specified path.
+  ///
+  /// \param FileSize The size of the file if the client knows it, or -1.
+  virtual llvm::error_code
+  getBufferForFile(const char *Path, OwningPtr<llvm::MemoryBuffer> &Result,
+                   int64_t FileSize = -1,
+                   bool RequiresNullTerminator = true) = 0;
+
+  /// \brief The file system of the operating system.
+  ///
+  /// The object is shared by all of its clients and never destroyed.
+  static VirtualFileSystem *getRealFileSystem();
+};
+
+/// \brief A file system whose files are all kept in memory.
+///
+/// Every file has the contents and modification time it was added with; the
+/// directories are the ancestors of the files. Paths are compared after
+/// removing "." components and resolving ".." ones, so "a/./b" and "a/c/../b"
+/// name the same file, but relative paths are never made absolute.
+///
+/// Files must be added before the file system is used; lookups may then
+/// happen concurrently.
+class InMemoryFileSystem : public VirtualFileSystem {
+  struct Entry {
+    struct stat StatBuf;
+    llvm::MemoryBuffer *Buffer; ///< Null for directories.
+  };
+  llvm::StringMap<Entry> Entries;
+
+  /// \brief The device of all the files, distinct from the devices of other
+  /// InMemoryFileSystems so that overlaid files have distinct identities.
+  dev_t Device;
+  ino_t NextInode;
+
+  Entry &addEntry(StringRef Path, mode_t Mode, time_t ModificationTime);
+  const Entry *lookup(const char *Path) const;
+
+  // DO NOT IMPLEMENT
+  InMemoryFileSystem(const InMemoryFileSystem &);
+  void operator=(const InMemoryFileSystem &);
+
+public:
+  InMemoryFileSystem();
+  ~InMemoryFileSystem();
+
+  /// \brief Add, or replace, the file at \p Path, with the given contents.
+  ///
+  /// Ownership of the buffer, which must be null-terminated if clients might
+  /// read it with the null terminator required, is transferred to the file
+  /// system.
+  void addFile(StringRef Path, llvm::MemoryBuffer *Buffer,
+               time_t ModificationTime = 0);
+
+  virtual bool getStat(const char *Path, struct stat &StatBuf,
+                       int *FileDescriptor);
+  virtual llvm::error_code
+  getBufferForFile(const char *Path, OwningPtr<llvm::MemoryBuffer> &Result,
+                   int64_t FileSize = -1, bool RequiresNullTerminator = true);
+};
+
+/// \brief A file system that lays other file systems over a base one.
+///
+/// A path is looked up in the most recently pushed file system first; the
+/// first one in which it exists provides it.
+class OverlayFileSystem : public VirtualFileSystem {
+  SmallVector<IntrusiveRefCntPtr<VirtualFileSystem>, 2> FileSystems;
+
+public:
+  explicit OverlayFileSystem(VirtualFileSystem *Base);
+
+  /// \brief Lay \p FS over the file systems already in the overlay.
+  void pushOverlay(VirtualFileSystem *FS);
+
+  virtual bool getStat(const char *Path, struct stat &StatBuf,
+                       int *FileDescriptor);
+  virtual llvm::error_code
+  getBufferForFile(const char *Path, OwningPtr<llvm::MemoryBuffer> &Result,
+                   int64_t FileSize = -1, bool RequiresNullTerminator = true);
+};
+
+} // end namespace clang
+
+#endif
@@ -17,10 +17,12 @@ namespace llvm {
 }
 
 namespace clang {
+  class CompilationProfile;
   class DiagnosticsEngine;
   class CodeGenOptions;
   class TargetOptions;
   class LangOptions;
+  class SourceManager;
   
   enum BackendAction {
     Backend_EmitAssembly,  ///< Emit native assembly files
@@ -34,7 +36,9 @@ namespace clang {
   void EmitBackendOutput(DiagnosticsEngine &Diags, const CodeGenOptions &CGOpts,
                          const TargetOptions &TOpts, const LangOptions &LOpts,
                          llvm::Module *M,
-                         BackendAction Action, raw_ostream *OS);
+                         BackendAction Action, raw_ostream *OS,
+                         CompilationProfile *Profile = 0,
+                         SourceManager *SM = 0);
 }
 
 #endif
@@ -17,6 +17,7 @@
 
 namespace clang {
 namespace driver {
+  class CompilationCache;
   class DerivedArgList;
   class Driver;
   class InputArgList;
@@ -156,10 +157,37 @@ public:
   /// \return The accumulated result code of the job.
   int ExecuteJob(const Job &J, const Command *&FailingCommand) const;
 
+  /// ExecuteJobsInParallel - Execute the commands of a job list, running up to
+  /// \arg NumJobs commands that do not depend on each other at the same time.
+  ///
+  /// Dependencies are derived from the action graph. The stderr output of
+  /// commands that run concurrently is captured and printed in job order once
+  /// they have finished, and no further commands are started after a failure.
+  ///
+  /// \param NumJobs - The number of concurrent commands, or 0 to use the
+  /// number of hardware threads.
+  /// \param FailingCommand - For non-zero results, this will be set to the
+  /// first Command (in job order) which failed.
+  /// \return The result code of the first failing command, or 0.
+  int ExecuteJobsInParallel(const JobList &Jobs, unsigned NumJobs,
+                            const Command *&FailingCommand) const;
+
   /// initCompilationForDiagnostics - Remove stale state and suppress output
   /// so compilation can be reexecuted to generate additional diagnostic
   /// information (e.g., preprocessed source(s)).
   void initCompilationForDiagnostics();
+
+private:
+  /// PrintCommandIfRequested - Print the command in -v style, if enabled.
+  ///
+  /// \return False if the log of the commands could not be opened.
+  bool PrintCommandIfRequested(const Command &C) const;
+
+  /// ExecuteCachedCommand - Restore the output of the cacheable command
+  /// \arg C from \arg Cache, or run it and cache its output.
+  int ExecuteCachedCommand(const Command &C, CompilationCache &Cache,
+                           StringRef ManifestKey, const char *OutputFile,
+                           const Command *&FailingCommand) const;
 };
 
 } // end namespace driver
@@ -0,0 +1,110 @@
+//===--- CompilationCache.h - Cache of compiler outputs ---------*- C++ -*-===//
+//
+//                     The LLVM Compiler Infrastructure
+//
+// This file is distributed under the University of Illinois Open Source
+// License. See LICENSE.TXT for details.
+//
+//===----------------------------------------------------------------------===//
+
+#ifndef CLANG_DRIVER_COMPILATIONCACHE_H_
+#define CLANG_DRIVER_COMPILATIONCACHE_H_
+
+#include "clang/Basic/LLVM.h"
+#include "clang/Driver/Util.h"
+#include "llvm/ADT/StringRef.h"
+#include <string>
+
+namespace clang {
+namespace driver {
+  class Command;
+
+/// CompilationCacheStorage - Where the compilation cache keeps its entries.
+///
+/// The entries are opaque byte strings named by hexadecimal keys. Storages
+/// may lose entries at any time; they only have to never return an entry
+/// stored under a different key. Clients can share a cache between machines
+/// by giving the driver a storage of their own.
+class CompilationCacheStorage {
+public:
+  virtual ~CompilationCacheStorage();
+
+  /// get - Read the entry stored under \arg Key into \arg Data.
+  ///
+  /// \return Whether the entry was found.
+  virtual bool get(StringRef Key, std::string &Data) = 0;
+
+  /// put - Store \arg Data under \arg Key, replacing any previous entry.
+  virtual void put(StringRef Key, StringRef Data) = 0;
+};
+
+/// LocalCompilationCacheStorage - A storage keeping each entry in a file of
+/// its own in a directory, which several drivers may use at once.
+class LocalCompilationCacheStorage : public CompilationCacheStorage {
+  std::string Directory;
+
+public:
+  explicit LocalCompilationCacheStorage(StringRef Directory);
+
+  virtual bool get(StringRef Key, std::string &Data);
+  virtual void put(StringRef Key, StringRef Data);
+};
+
+/// CompilationCache - Reuses the object files of earlier "clang -cc1"
+/// commands, in the way of ccache's direct mode.
+///
+/// A command is looked up by a hash of its arguments, less the output file,
+/// of the working directory, of the compiler version and of the contents of
+/// its main input. This finds a manifest listing the files the command read
+/// the last time it ran, with their sizes and hashes, and the name of its
+/// result. The result, the object file and the diagnostics the command
+/// printed, is reused when all of the listed files are unchanged.
+///
+/// On a miss, the command is run with a dependency file added, which gives
+/// the files to list in the manifest. As with ccache, a header which would
+/// now be found before one listed there goes unnoticed, and so do __DATE__
+/// and __TIME__.
+class CompilationCache {
+  CompilationCacheStorage &Storage;
+
+public:
+  explicit CompilationCache(CompilationCacheStorage &Storage)
+    : Storage(Storage) {}
+
+  /// isCacheable - Whether \arg C is a compilation to an object file whose
+  /// result can be cached.
+  ///
+  /// \param OutputFile - Set to the object file written by the command.
+  static bool isCacheable(const Command &C, const char *&OutputFile);
+
+  /// getManifestKey - Compute the key of the manifest of \arg C.
+  ///
+  /// \return false if the key could not be computed, e.g. because the main
+  /// input could not be read.
+  bool getManifestKey(const Command &C, std::string &Key) const;
+
+  /// restore - Write the cached object file of the command with the manifest
+  /// \arg ManifestKey to \arg OutputFile, if none of its dependencies
+  /// changed.
+  ///
+  /// \param Diagnostics - Set to the diagnostics the command printed.
+  /// \return Whether the object file was restored.
+  bool restore(StringRef ManifestKey, StringRef OutputFile,
+               std::string &Diagnostics);
+
+  /// addDependencyOutput - Add the arguments making a cacheable command write
+  /// the files it reads to \arg DependencyFile.
+  static void addDependencyOutput(ArgStringList &Args,
+                                  const char *DependencyFile);
+
+  /// store - Cache the result of a command which succeeded.
+  ///
+  /// \param DependencyFile - The dependency file written by the command.
+  void store(StringRef ManifestKey, StringRef OutputFile,
+             StringRef DependencyFile, StringRef Diagnostics);
+};
+
+} // end namespace driver
+} // end namespace clang
+
+#endif
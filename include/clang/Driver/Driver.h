@@ -35,6 +35,7 @@ namespace driver {
   class ArgList;
   class Command;
   class Compilation;
+  class CompilationCacheStorage;
   class DerivedArgList;
   class InputArgList;
   class InputInfo;
@@ -138,6 +139,25 @@ public:
   /// Whether the driver is generating diagnostics for debugging purposes.
   unsigned CCGenDiagnostics : 1;
 
+  /// The number of independent commands to run at the same time (0 means the
+  /// number of hardware threads).
+  unsigned CCCNumJobs;
+
+  /// Whether "clang -cc1" commands should be run inside the driver process
+  /// (-integrated-cc1), which requires CC1Main to be set.
+  unsigned CCCUseIntegratedCC1 : 1;
+
+  /// The signature of the entry point of "clang -cc1".
+  ///
+  /// \param ArgBegin, ArgEnd - The arguments following "-cc1".
+  /// \param Argv0 - The path of the executable the command would have run.
+  typedef int (*CC1MainFn)(const char **ArgBegin, const char **ArgEnd,
+                           const char *Argv0);
+
+  /// The entry point used to run "clang -cc1" commands in process, or null if
+  /// the client does not provide one.
+  CC1MainFn CC1Main;
+
 private:
   /// Name to use when invoking gcc/g++.
   std::string CCCGenericGCCName;
@@ -174,6 +194,10 @@ private:
   std::list<std::string> TempFiles;
   std::list<std::string> ResultFiles;
 
+  /// The storage in which the object files of "clang -cc1" commands are
+  /// cached (-ccc-cache-dir), or null if they are not.
+  CompilationCacheStorage *CacheStorage;
+
   /// \brief Cache of all the ToolChains in use by the driver.
   ///
   /// This maps from the string representation of a triple to a ToolChain
@@ -235,6 +259,14 @@ public:
   bool shouldForceClangUse() const { return ForcedClangUse; }
   void setForcedClangUse(bool V = true) { ForcedClangUse = V; }
 
+  CompilationCacheStorage *getCompilationCacheStorage() const {
+    return CacheStorage;
+  }
+
+  /// \brief Cache the results of compilations in \p Storage, which the driver
+  /// takes ownership of, or stop caching them if it is null.
+  void setCompilationCacheStorage(CompilationCacheStorage *Storage);
+
   /// @}
   /// @name Primary Functionality
   /// @{
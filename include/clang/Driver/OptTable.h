@@ -12,6 +12,8 @@
 
 #include "clang/Basic/LLVM.h"
 #include "clang/Driver/OptSpecifier.h"
+#include "llvm/ADT/SmallVector.h"
+#include "llvm/ADT/StringMap.h"
 
 namespace clang {
 namespace driver {
@@ -59,6 +61,15 @@ namespace driver {
     /// special option like 'input' or 'unknown', and is not an option group).
     unsigned FirstSearchableIndex;
 
+    /// \brief The index of the first searchable option of each name.
+    ///
+    /// Options of the same name are next to each other in the table.
+    llvm::StringMap<unsigned> FirstOptionOfName;
+
+    /// \brief The lengths of the names of the searchable options, longest
+    /// first.
+    SmallVector<unsigned, 32> NameLengths;
+
   private:
     const Info &getInfo(OptSpecifier Opt) const {
       unsigned id = Opt.getID();
@@ -29,6 +29,7 @@
 #include "llvm/ADT/OwningPtr.h"
 #include "llvm/ADT/SmallVector.h"
 #include "llvm/ADT/StringMap.h"
+#include "llvm/Support/Atomic.h"
 #include "llvm/Support/Path.h"
 #include <map>
 #include <string>
@@ -226,6 +227,14 @@ private:
   /// the preamble must be thrown away.
   llvm::StringMap<std::pair<off_t, time_t> > FilesInPreamble;
 
+  /// \brief Keeps track of the files that were read when the main file was
+  /// last parsed successfully, with both their size and their modification
+  /// time.
+  ///
+  /// If none of them has changed and the remapped files are the same, a
+  /// reparse would produce the same AST, so the current one is kept.
+  llvm::StringMap<std::pair<off_t, time_t> > FilesInMainFileParse;
+
   /// \brief When non-NULL, this is the buffer used to store the contents of
   /// the main file when it has been padded for use with the precompiled
   /// preamble.
@@ -258,6 +267,16 @@ private:
   /// \brief True if non-system source files should be treated as volatile
   /// (likely to change while trying to use them).
   bool UserFilesAreVolatile : 1;
+
+  /// \brief Whether an out-of-date precompiled preamble should be rebuilt on
+  /// a background thread instead of during \c Reparse().
+  bool BackgroundPreambleRebuild : 1;
+
+  class BackgroundPreambleBuild;
+
+  /// \brief The precompiled preamble currently being built on a background
+  /// thread, if any.
+  OwningPtr<BackgroundPreambleBuild> PendingPreambleBuild;
  
   /// \brief The language options used when we load an AST file.
   LangOptions ASTFileLangOpts;
@@ -311,7 +330,39 @@ public:
     /// for more information.
     unsigned Type;
   };
-  
+
+  /// \brief The cached code-completion results for the declarations and
+  /// macros of a precompiled preamble.
+  ///
+  /// ASTUnits whose preambles have the same text, input files, and compiler
+  /// invocation share one set, whatever their main files are, and the set is
+  /// stored in the PreambleCache when there is one. The reference count is
+  /// updated atomically, since ASTUnits on different threads may share a set.
+  class PreambleCompletions {
+    mutable volatile llvm::sys::cas_flag RefCount;
+
+    PreambleCompletions(const PreambleCompletions &); // DO NOT IMPLEMENT
+    void operator=(const PreambleCompletions &); // DO NOT IMPLEMENT
+
+  public:
+    explicit PreambleCompletions(StringRef Key);
+
+    void Retain() const;
+    void Release() const;
+
+    /// \brief The key identifying the preamble.
+    std::string Key;
+
+    /// \brief Allocator for the code-completion strings of \c Results.
+    IntrusiveRefCntPtr<GlobalCodeCompletionAllocator> Allocator;
+
+    std::vector<CachedCodeCompletionResult> Results;
+
+    /// \brief The formatted type names of \c Results, as in
+    /// \c CachedCompletionTypes.
+    llvm::StringMap<unsigned> Types;
+  };
+
   /// \brief Retrieve the mapping from formatted type names to unique type
   /// identifiers.
   llvm::StringMap<unsigned> &getCachedCompletionTypes() { 
@@ -324,6 +375,12 @@ public:
     return CachedCompletionAllocator;
   }
 
+  /// \brief Retrieve the shared completions of the precompiled preamble, whose
+  /// strings are among the cached global code completions.
+  IntrusiveRefCntPtr<PreambleCompletions> getPreambleCompletions() {
+    return CachedPreambleCompletions;
+  }
+
   CodeCompletionTUInfo &getCodeCompletionTUInfo() {
     if (!CCTUInfo)
       CCTUInfo.reset(new CodeCompletionTUInfo(
@@ -336,6 +393,10 @@ private:
   IntrusiveRefCntPtr<GlobalCodeCompletionAllocator>
     CachedCompletionAllocator;
   
+  /// \brief The cached completions shared with other ASTUnits that use the
+  /// same precompiled preamble, if any.
+  IntrusiveRefCntPtr<PreambleCompletions> CachedPreambleCompletions;
+
   OwningPtr<CodeCompletionTUInfo> CCTUInfo;
 
   /// \brief The set of cached code-completion results.
@@ -367,6 +428,10 @@ private:
   /// inconsistent state, and is not safe to free.
   unsigned UnsafeToFree : 1;
 
+  /// \brief Whether unloadAST() freed the AST, which has not been parsed
+  /// again since.
+  unsigned ASTUnloaded : 1;
+
   /// \brief Cache any "global" code-completion results, so that we can avoid
   /// recomputing them with each completion.
   void CacheCodeCompletionResults();
@@ -381,6 +446,8 @@ private:
 
   void CleanTemporaryFiles();
   bool Parse(llvm::MemoryBuffer *OverrideMainBuffer);
+  void recordFilesInMainFileParse();
+  bool canReuseAST(RemappedFile *RemappedFiles, unsigned NumRemappedFiles);
   
   std::pair<llvm::MemoryBuffer *, std::pair<unsigned, bool> >
   ComputePreamble(CompilerInvocation &Invocation, 
@@ -392,6 +459,9 @@ private:
                                                         unsigned MaxLines = 0);
   void RealizeTopLevelDeclsFromPreamble();
 
+  bool startBackgroundPreambleBuild();
+  void adoptBackgroundPreamble();
+
   /// \brief Transfers ownership of the objects (like SourceManager) from
   /// \param CI to this ASTUnit.
   void transferASTDataFromCompilerInstance(CompilerInstance &CI);
@@ -440,6 +510,45 @@ public:
   bool isUnsafeToFree() const { return UnsafeToFree; }
   void setUnsafeToFree(bool Value) { UnsafeToFree = Value; }
 
+  /// \brief Free the AST, the preprocessor and the cached code-completion
+  /// results, keeping what is needed to parse the translation unit again:
+  /// the invocation, the remapped files, the precompiled preamble and the
+  /// diagnostics.
+  ///
+  /// Until reloadAST() is called, only the diagnostics, the source manager
+  /// and the file manager may be used.
+  ///
+  /// \returns true if the translation unit cannot be parsed again, in which
+  /// case nothing is freed.
+  bool unloadAST();
+
+  /// \brief Parse the translation unit again after unloadAST(), with the
+  /// files remapped as they were.
+  ///
+  /// \returns true if parsing failed, false otherwise, including when the
+  /// AST was not unloaded.
+  bool reloadAST();
+
+  bool isASTUnloaded() const { return ASTUnloaded; }
+
+  /// \brief Whether an out-of-date precompiled preamble is rebuilt on a
+  /// background thread.
+  ///
+  /// In this mode, \c Reparse() never waits for a precompiled preamble to be
+  /// built. While the new preamble is being built, the translation unit is
+  /// reparsed without one; the new preamble is used by the first \c Reparse()
+  /// after it is complete.
+  bool getBackgroundPreambleRebuild() const {
+    return BackgroundPreambleRebuild;
+  }
+  void setBackgroundPreambleRebuild(bool Value) {
+    BackgroundPreambleRebuild = Value;
+  }
+
+  /// \brief Wait until the precompiled preamble being built on a background
+  /// thread, if any, is complete.
+  void waitForBackgroundPreamble();
+
   const DiagnosticsEngine &getDiagnostics() const { return *Diagnostics; }
   DiagnosticsEngine &getDiagnostics()             { return *Diagnostics; }
   
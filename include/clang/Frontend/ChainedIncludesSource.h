@@ -55,6 +55,7 @@ protected:
   virtual void FinishedDeserializing();
   virtual void StartTranslationUnit(ASTConsumer *Consumer);
   virtual void PrintStats();
+  virtual const ASTRecordLayout *getRecordLayout(const RecordDecl *Record);
 
   /// Return the amount of memory used by memory buffers, breaking down
   /// by heap-backed versus mmap'ed memory.
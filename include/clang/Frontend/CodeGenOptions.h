@@ -59,12 +59,16 @@ public:
                                   ///< aliases to base ctors when possible.
   unsigned DataSections      : 1; ///< Set when -fdata-sections is enabled.
   unsigned DisableFPElim     : 1; ///< Set when -fomit-frame-pointer is enabled.
+  unsigned DisableLifetimeMarkers : 1; ///< Do not emit lifetime markers for
+                                       ///< local variables.
   unsigned DisableLLVMOpts   : 1; ///< Don't run any optimizations, for use in
                                   ///< getting .bc files that correspond to the
                                   ///< internal state before optimizations are
                                   ///< done.
   unsigned DisableRedZone    : 1; ///< Set when -mno-red-zone is enabled.
   unsigned DisableTailCalls  : 1; ///< Do not emit tail calls.
+  unsigned DebugVTableHoming : 1; ///< Emit debug info for a dynamic class
+                                  ///< only where its vtable is emitted.
   unsigned EmitDeclMetadata  : 1; ///< Emit special metadata indicating what
                                   ///< Decl* various IR entities came from. Only
                                   ///< useful when running CodeGen as a
@@ -98,12 +102,18 @@ public:
   unsigned NoNaNsFPMath      : 1; ///< Assume FP arguments, results not NaN.
   unsigned NoZeroInitializedInBSS : 1; ///< -fno-zero-initialized-in-bss.
   unsigned ObjCDispatchMethod : 2; ///< Method of Objective-C dispatch to use.
+  unsigned ObjCSendCache     : 1; ///< Cache the method lookups of message
+                                  ///< sends at each call site.
   unsigned OmitLeafFramePointer : 1; ///< Set when -momit-leaf-frame-pointer is
                                      ///< enabled.
   unsigned OptimizationLevel : 3; ///< The -O[0-4] option specified.
   unsigned OptimizeSize      : 2; ///< If -Os (==1) or -Oz (==2) is specified.
+  unsigned ProfileInstrGenerate : 1; ///< Instrument code to generate
+                                     ///< execution counts to use with PGO.
   unsigned RelaxAll          : 1; ///< Relax all machine code instructions.
   unsigned RelaxedAliasing   : 1; ///< Set when -fno-strict-aliasing is enabled.
+  unsigned ReleaseFunctionBodies : 1; ///< Free the statements of function
+                                      ///< bodies once they are emitted.
   unsigned SaveTempLabels    : 1; ///< Save temporary labels.
   unsigned SimplifyLibCalls  : 1; ///< Set when -fbuiltin is enabled.
   unsigned SoftFloat         : 1; ///< -soft-float.
@@ -169,6 +179,13 @@ public:
   /// The name of the relocation model to use.
   std::string RelocationModel;
 
+  /// Name of the profile file to use with instrumentation-based PGO.
+  std::string InstrProfileInput;
+
+  /// The regular expression of -Rpass, matching the names of the passes
+  /// whose optimization remarks are reported.
+  std::string OptimizationRemarkPattern;
+
   /// If not an empty string, trap intrinsics are lowered to calls to this
   /// function instead of to trap instructions.
   std::string TrapFuncName;
@@ -186,6 +203,9 @@ public:
   /// The lower bound for a buffer to be considered for stack protection.
   unsigned SSPBufferSize;
 
+  /// The size in bytes below which local variables get no lifetime markers.
+  unsigned LifetimeMarkersMinSize;
+
   /// The default TLS model to use.
   TLSModel DefaultTLSModel;
 
@@ -196,7 +216,9 @@ public:
     CXAAtExit = 1;
     CXXCtorDtorAliases = 0;
     DataSections = 0;
+    DebugVTableHoming = 0;
     DisableFPElim = 0;
+    DisableLifetimeMarkers = 0;
     DisableLLVMOpts = 0;
     DisableRedZone = 0;
     DisableTailCalls = 0;
@@ -222,11 +244,14 @@ public:
     NumRegisterParameters = 0;
     ObjCAutoRefCountExceptions = 0;
     ObjCDispatchMethod = Legacy;
+    ObjCSendCache = 0;
     OmitLeafFramePointer = 0;
     OptimizationLevel = 0;
     OptimizeSize = 0;
+    ProfileInstrGenerate = 0;
     RelaxAll = 0;
     RelaxedAliasing = 0;
+    ReleaseFunctionBodies = 0;
     SaveTempLabels = 0;
     SimplifyLibCalls = 1;
     SoftFloat = 0;
@@ -242,6 +267,7 @@ public:
     StackAlignment = 0;
     BoundsChecking = 0;
     SSPBufferSize = 8;
+    LifetimeMarkersMinSize = 32;
     UseInitArray = 0;
 
     DebugInfo = NoDebugInfo;
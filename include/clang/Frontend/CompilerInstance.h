@@ -33,13 +33,16 @@ class ASTContext;
 class ASTConsumer;
 class ASTReader;
 class CodeCompleteConsumer;
+class CompilationProfile;
 class DiagnosticsEngine;
 class DiagnosticConsumer;
 class ExternalASTSource;
 class FileEntry;
 class FileManager;
 class FrontendAction;
+class HeaderCostTracker;
 class Module;
+class ModuleBuildQueue;
 class Preprocessor;
 class Sema;
 class SourceManager;
@@ -97,6 +100,13 @@ class CompilerInstance : public ModuleLoader {
   /// \brief The frontend timer
   OwningPtr<llvm::Timer> FrontendTimer;
 
+  /// \brief The compilation profile of the current input, if any.
+  OwningPtr<CompilationProfile> Profile;
+
+  /// \brief The tracker of what each header costs the current input, if
+  /// any.
+  OwningPtr<HeaderCostTracker> HeaderCosts;
+
   /// \brief Non-owning reference to the ASTReader, if one exists.
   ASTReader *ModuleManager;
 
@@ -111,6 +121,10 @@ class CompilerInstance : public ModuleLoader {
   /// \brief The result of the last module import.
   ///
   Module *LastModuleImportResult;
+
+  /// \brief The modules imported by the main file that are being built in
+  /// the background, if any.
+  OwningPtr<ModuleBuildQueue> ModuleBuilds;
   
   /// \brief Holds information about the output file.
   ///
@@ -444,6 +458,24 @@ public:
     return *FrontendTimer;
   }
 
+  /// }
+  /// @name Compilation profile
+  /// {
+
+  bool hasCompilationProfile() const { return Profile != 0; }
+
+  CompilationProfile &getCompilationProfile() const {
+    assert(Profile && "Compiler instance has no compilation profile!");
+    return *Profile;
+  }
+
+  bool hasHeaderCostTracker() const { return HeaderCosts != 0; }
+
+  HeaderCostTracker &getHeaderCostTracker() const {
+    assert(HeaderCosts && "Compiler instance has no header cost tracker!");
+    return *HeaderCosts;
+  }
+
   /// }
   /// @name Output Files
   /// {
@@ -544,7 +576,8 @@ public:
                              bool DisableStatCache,
                              bool AllowPCHWithCompilerErrors,
                              Preprocessor &PP, ASTContext &Context,
-                             void *DeserializationListener, bool Preamble);
+                             void *DeserializationListener, bool Preamble,
+                             bool ProfileDeserialization = false);
 
   /// Create a code completion consumer using the invocation; note that this
   /// will cause the source manager to truncate the input source file at the
@@ -567,6 +600,9 @@ public:
   /// Create the frontend timer and replace any existing one with it.
   void createFrontendTimer();
 
+  /// Create a compilation profile and replace any existing one with it.
+  void createCompilationProfile();
+
   /// Create the default output file (from the invocation's options) and add it
   /// to the list of tracked output files.
   ///
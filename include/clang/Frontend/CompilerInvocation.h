@@ -131,6 +131,20 @@ public:
   /// passing to CreateFromArgs.
   void toArgs(std::vector<std::string> &Res) const;
 
+  /// \brief Append the invocation to \p Out in a compact binary form, which
+  /// deserialize() loads back without parsing any arguments, so that clients
+  /// can cache the invocations they create.
+  ///
+  /// \returns false if the invocation cannot be serialized, as when it remaps
+  /// files to memory buffers.
+  bool serialize(SmallVectorImpl<char> &Out) const;
+
+  /// \brief Load an invocation written by serialize().
+  ///
+  /// \returns false if \p Data is not an invocation serialized by this
+  /// version of clang.
+  static bool deserialize(CompilerInvocation &Res, StringRef Data);
+
   /// \brief Set language defaults for the given input language and
   /// language standard in the given LangOptions object.
   ///
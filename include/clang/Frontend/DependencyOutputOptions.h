@@ -35,6 +35,10 @@ public:
   /// stderr.
   std::string HeaderIncludeOutputFile;
 
+  /// The file to append the costs of each included file to, as one line of
+  /// JSON per translation unit.
+  std::string HeaderCostFile;
+
   /// A list of names to use as the targets in the dependency file; this list
   /// must contain at least one entry.
   std::vector<std::string> Targets;
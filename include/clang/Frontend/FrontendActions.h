@@ -203,6 +203,14 @@ protected:
   void ExecuteAction();
 };
 
+/// \brief Runs only the preprocessor directives of the input and the files
+/// it includes, skipping all other lines, so that the dependency file options
+/// can list the included files quickly.
+class ScanDependenciesAction : public PreprocessorFrontendAction {
+protected:
+  void ExecuteAction();
+};
+
 class PrintPreprocessedAction : public PreprocessorFrontendAction {
 protected:
   void ExecuteAction();
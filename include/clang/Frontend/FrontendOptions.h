@@ -49,7 +49,8 @@ namespace frontend {
     RewriteTest,            ///< Rewriter playground
     RunAnalysis,            ///< Run one or more source code analyses.
     MigrateSource,          ///< Run migrator.
-    RunPreprocessorOnly     ///< Just lex, no output.
+    RunPreprocessorOnly,    ///< Just lex, no output.
+    ScanDependencies        ///< Only run directives, for dependency output.
   };
 }
 
@@ -94,9 +95,17 @@ public:
   unsigned RelocatablePCH : 1;             ///< When generating PCH files,
                                            /// instruct the AST writer to create
                                            /// relocatable PCH files.
+  unsigned CompressPCH : 1;                ///< When generating PCH files,
+                                           /// compress the file buffers and
+                                           /// line tables they store.
+  unsigned DeterministicPCH : 1;           ///< When generating PCH files,
+                                           /// make them depend only on their
+                                           /// inputs.
   unsigned ShowHelp : 1;                   ///< Show the -help text.
   unsigned ShowStats : 1;                  ///< Show frontend performance
                                            /// metrics and statistics.
+  unsigned ShowMemoryStats : 1;            ///< Show the memory used by the
+                                           /// AST.
   unsigned ShowTimers : 1;                 ///< Show timers for individual
                                            /// actions.
   unsigned ShowVersion : 1;                ///< Show the -version text.
@@ -111,6 +120,15 @@ public:
                                            /// speed up parsing in cases you do
                                            /// not need them (e.g. with code
                                            /// completion).
+  unsigned SkipFunctionBodiesOutsideMainFile : 1; ///< Skip over the bodies
+                                           /// of functions defined outside
+                                           /// the main file, parsing those
+                                           /// of templates only when they
+                                           /// are instantiated.
+  unsigned ShowTemplateProfile : 1;        ///< Show the time and memory spent
+                                           /// instantiating each template.
+  unsigned ReleaseSourceBuffers : 1;       ///< Release the memory of the
+                                           /// buffers of lexed headers.
 
   CodeCompleteOptions CodeCompleteOpts;
 
@@ -176,6 +194,25 @@ public:
   /// \brief File name of the file that will provide record layouts
   /// (in the format produced by -fdump-record-layouts).
   std::string OverrideRecordLayoutsFile;
+
+  /// \brief If given, the file to write statistics about reading AST files
+  /// to, as JSON.
+  std::string DeserializationStatsFile;
+
+  /// \brief If given, the file to write the template instantiations to, in
+  /// the Trace Event JSON format.
+  std::string TemplateProfileTraceFile;
+
+  /// \brief If given, the file to write the time spent in each compilation
+  /// phase to, as JSON.
+  std::string CompileProfileFile;
+
+  /// \brief The number of modules that may be built at once, including on
+  /// the importing thread, or 0 for one per processor.
+  ///
+  /// If more than one, the modules imported by the main file that need to be
+  /// built start building in the background at the first module build.
+  unsigned ModuleBuildThreads;
   
 public:
   FrontendOptions() {
@@ -183,14 +220,21 @@ public:
     ProgramAction = frontend::ParseSyntaxOnly;
     ActionName = "";
     RelocatablePCH = 0;
+    CompressPCH = 0;
+    DeterministicPCH = 0;
     ShowHelp = 0;
     ShowStats = 0;
+    ShowMemoryStats = 0;
     ShowTimers = 0;
     ShowVersion = 0;
     ARCMTAction = ARCMT_None;
     ARCMTMigrateEmitARCErrors = 0;
     SkipFunctionBodies = 0;
+    SkipFunctionBodiesOutsideMainFile = 0;
+    ShowTemplateProfile = 0;
+    ReleaseSourceBuffers = 0;
     ObjCMTAction = ObjCMT_None;
+    ModuleBuildThreads = 1;
   }
 
   /// getInputKindForExtension - Return the appropriate input kind for a file
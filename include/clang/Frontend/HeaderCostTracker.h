@@ -0,0 +1,118 @@
+//===--- HeaderCostTracker.h - What each header costs -----------*- C++ -*-===//
+//
+//                     The LLVM Compiler Infrastructure
+//
+// This file is distributed under the University of Illinois Open Source
+// License. See LICENSE.TXT for details.
+//
+//===----------------------------------------------------------------------===//
+
+#ifndef LLVM_CLANG_FRONTEND_HEADERCOSTTRACKER_H
+#define LLVM_CLANG_FRONTEND_HEADERCOSTTRACKER_H
+
+#include "clang/Basic/LLVM.h"
+#include "clang/Basic/SourceLocation.h"
+#include "llvm/ADT/DenseMap.h"
+#include "llvm/ADT/SmallVector.h"
+#include "llvm/ADT/StringRef.h"
+#include <vector>
+
+namespace clang {
+
+class ASTConsumer;
+class DeclContext;
+class FileEntry;
+class PPCallbacks;
+class Preprocessor;
+
+/// HeaderCostTracker - Attributes the work of the frontend on a translation
+/// unit to the files it includes.
+///
+/// Macro expansions, deserialized declarations and time are charged to the
+/// file the preprocessor is in when they happen; the time thus covers
+/// parsing, semantic analysis and deserialization alike. Declarations are
+/// charged to the file of their location, once the AST is complete. Work
+/// after the end of the main file, such as the instantiation of templates
+/// at the end of the translation unit, is not charged to any file.
+///
+/// The tokens of a file are counted by lexing it again in raw mode when the
+/// preprocessor leaves it, so that the lexer does not count tokens in every
+/// compilation; the time this takes is not charged.
+///
+/// The report has the exclusive and inclusive costs of each file, the latter
+/// adding in the files it included, so that the reports of a whole build can
+/// be summed to choose the headers to split or to precompile.
+class HeaderCostTracker {
+public:
+  enum Counter {
+    Tokens,
+    MacroExpansions,
+    Decls,
+    DeserializedDecls,
+    /// \brief In nanoseconds.
+    Time,
+    NumCounters
+  };
+
+private:
+  /// \brief One entry of a file.
+  struct Inclusion {
+    FileID FID;
+    const FileEntry *File;
+    /// \brief The inclusion this one is nested in, or -1.
+    int Parent;
+    uint64_t Costs[NumCounters];
+  };
+
+  Preprocessor &PP;
+  std::vector<Inclusion> Inclusions;
+
+  /// \brief The inclusions the preprocessor is in, innermost last.
+  SmallVector<unsigned, 16> Stack;
+
+  llvm::DenseMap<FileID, unsigned> InclusionOfFile;
+
+  /// \brief The time when work was last charged.
+  uint64_t LastTime;
+
+  /// \brief Whether the main file ended, after which nothing is charged.
+  bool Finished;
+
+  /// \brief Charge the time since the last charge to the file the
+  /// preprocessor is in.
+  void chargeElapsed();
+
+  /// \brief Charge the tokens of the file of \p I to it.
+  void countTokens(Inclusion &I);
+
+public:
+  explicit HeaderCostTracker(Preprocessor &PP);
+
+  /// \brief Create the callbacks, owned by the caller, which tell the
+  /// tracker what the preprocessor does.
+  PPCallbacks *createPPCallbacks();
+
+  /// \brief Create the consumer, owned by the caller, which counts the
+  /// declarations of the AST and those read from AST files.
+  ASTConsumer *createASTConsumer();
+
+  /// \name Events
+  /// {
+  void enteredFile(FileID FID);
+  void exitedFile();
+  void expandedMacro();
+  void deserializedDecl();
+  void finishedMainFile();
+  void countDecls(const DeclContext *DC);
+  /// }
+
+  /// \brief Write the costs of the translation unit \p File as one line of
+  /// JSON.
+  void printJSON(raw_ostream &OS, StringRef File) const;
+
+  static const char *getCounterName(Counter C);
+};
+
+} // end namespace clang
+
+#endif
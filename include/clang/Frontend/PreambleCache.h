@@ -0,0 +1,110 @@
+//===--- PreambleCache.h - On-disk cache of precompiled preambles -*- C++ -*-===//
+//
+//                     The LLVM Compiler Infrastructure
+//
+// This file is distributed under the University of Illinois Open Source
+// License. See LICENSE.TXT for details.
+//
+//===----------------------------------------------------------------------===//
+//
+//  This file defines PreambleCache, a persistent cache for the precompiled
+//  preambles built by ASTUnit.
+//
+//===----------------------------------------------------------------------===//
+
+#ifndef LLVM_CLANG_FRONTEND_PREAMBLECACHE_H
+#define LLVM_CLANG_FRONTEND_PREAMBLECACHE_H
+
+#include "clang/Basic/LLVM.h"
+#include "llvm/ADT/IntrusiveRefCntPtr.h"
+#include "llvm/ADT/StringRef.h"
+#include "llvm/Support/DataTypes.h"
+#include "llvm/Support/Mutex.h"
+#include <string>
+#include <vector>
+#include <sys/types.h>
+
+namespace clang {
+
+/// \brief A directory of precompiled preambles that outlives the ASTUnits
+/// which built them and can be shared between processes.
+///
+/// Entries are keyed by a string that captures everything the precompiled
+/// preamble depends on besides the files it includes: the main file name and
+/// preamble text, and the compiler version and invocation.
+/// Each entry records the size and modification time of the included files,
+/// which ASTUnit checks before using it. Every entry is one file, written to a
+/// temporary name and renamed into place, so concurrent readers and writers
+/// never observe partial entries. The cache also holds the global code
+/// completions of precompiled preambles, in entries of their own.
+///
+/// When the total size of the entries exceeds the limit, the least recently
+/// used ones are removed.
+class PreambleCache : public RefCountedBase<PreambleCache> {
+public:
+  /// \brief A file the precompiled preamble depends on.
+  struct InputFile {
+    std::string Name;
+    off_t Size;
+    time_t ModTime;
+  };
+
+  /// \brief The data ASTUnit needs to use a precompiled preamble besides the
+  /// AST file itself.
+  struct Entry {
+    std::vector<InputFile> Files;
+    std::vector<uint32_t> TopLevelDecls;
+    /// \brief The size of the main file buffer the preamble was built with.
+    unsigned ReservedSize;
+    unsigned NumWarnings;
+    unsigned TopLevelHashValue;
+
+    Entry() : ReservedSize(0), NumWarnings(0), TopLevelHashValue(0) { }
+  };
+
+private:
+  std::string Directory;
+  uint64_t MaxSize;
+
+  /// \brief Serializes evictions within this process.
+  llvm::sys::Mutex EvictionLock;
+
+  std::string getEntryPath(StringRef Key, const char *Suffix) const;
+  void evict();
+
+public:
+  /// \param Directory The directory that holds the entries. It is created if
+  /// it does not exist.
+  /// \param MaxSize The size in bytes entries may occupy before evictions.
+  PreambleCache(StringRef Directory, uint64_t MaxSize);
+
+  StringRef getDirectory() const { return Directory; }
+
+  /// \brief Look up the entry for \p Key.
+  ///
+  /// On success, the precompiled preamble is copied to \p PCHPath, which the
+  /// caller owns afterwards, and \p Result describes it.
+  bool lookup(StringRef Key, StringRef PCHPath, Entry &Result);
+
+  /// \brief Add the precompiled preamble at \p PCHPath under \p Key,
+  /// replacing any previous entry.
+  void insert(StringRef Key, StringRef PCHPath, const Entry &Data);
+
+  /// \brief Look up the serialized code completions stored under \p Key.
+  bool lookupCompletions(StringRef Key, std::string &Data);
+
+  /// \brief Store serialized code completions under \p Key, replacing any
+  /// previous ones. They are evicted like the precompiled preambles.
+  void insertCompletions(StringRef Key, StringRef Data);
+
+  /// \brief Returns the cache used by all ASTUnits of the process, or null if
+  /// none was installed.
+  static PreambleCache *getShared();
+
+  /// \brief Installs the cache used by all ASTUnits of the process.
+  static void setShared(PreambleCache *Cache);
+};
+
+} // end namespace clang
+
+#endif
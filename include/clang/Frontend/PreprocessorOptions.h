@@ -54,6 +54,14 @@ public:
                                /// preprocessing record we should also keep
                                /// track of locations of conditional directives
                                /// in non-system files.
+
+  unsigned CacheRepeatedIncludes : 1; /// Whether the tokens of files that are
+                                      /// included more than once are lexed
+                                      /// only once.
+
+  unsigned CacheMacroArgExpansions : 1; /// Whether macro arguments made of
+                                        /// the same tokens are pre-expanded
+                                        /// only once.
   
   /// The implicit PCH included at the start of the translation unit, or empty.
   std::string ImplicitPCHInclude;
@@ -61,6 +69,10 @@ public:
   /// \brief Headers that will be converted to chained PCHs in memory.
   std::vector<std::string> ChainedIncludes;
 
+  /// \brief If non-empty, the directory where the chained PCHs are kept and
+  /// reused from, as long as the headers they were built from are unchanged.
+  std::string ChainedIncludesCache;
+
   /// \brief When true, disables most of the normal validation performed on
   /// precompiled headers.
   bool DisablePCHValidation;
@@ -93,6 +105,10 @@ public:
   /// If given, a PTH cache file to use for speeding up header parsing.
   std::string TokenCache;
 
+  /// \brief When true, a PTH cache whose input files changed since it was
+  /// generated is regenerated from its original source header before use.
+  bool RebuildStaleTokenCache;
+
   /// \brief True if the SourceManager should report the original file name for
   /// contents of files that were remapped to other files. Defaults to true.
   bool RemappedFilesKeepOriginalName;
@@ -167,9 +183,12 @@ public:
 public:
   PreprocessorOptions() : UsePredefines(true), DetailedRecord(false),
                           DetailedRecordConditionalDirectives(false),
+                          CacheRepeatedIncludes(false),
+                          CacheMacroArgExpansions(false),
                           DisablePCHValidation(false), DisableStatCache(false),
                           AllowPCHWithCompilerErrors(false),
                           DumpDeserializedPCHDecls(false),
+                          RebuildStaleTokenCache(false),
                           PrecompiledPreambleBytes(0, true),
                           RemappedFilesKeepOriginalName(true),
                           RetainRemappedFileBuffers(false),
@@ -209,6 +228,7 @@ public:
     Includes.clear();
     MacroIncludes.clear();
     ChainedIncludes.clear();
+    ChainedIncludesCache.clear();
     DumpDeserializedPCHDecls = false;
     ImplicitPCHInclude.clear();
     ImplicitPTHInclude.clear();
@@ -45,6 +45,17 @@ enum RecordIDs {
   RECORD_LAST = RECORD_FIXIT
 };
 
+/// \brief The levels of the diagnostics, as serialized.  These keep their
+/// values whatever changes are made to DiagnosticsEngine::Level.
+enum Level {
+  Ignored = 0,
+  Note,
+  Warning,
+  Error,
+  Fatal,
+  Remark
+};
+
 /// \brief Returns a DiagnosticConsumer that serializes diagnostics to
 ///  a bitcode file.
 ///
@@ -0,0 +1,75 @@
+//===--- FileTokenCache.h - Cached tokens of repeatedly lexed files -*- C++ -*-===//
+//
+//                     The LLVM Compiler Infrastructure
+//
+// This file is distributed under the University of Illinois Open Source
+// License. See LICENSE.TXT for details.
+//
+//===----------------------------------------------------------------------===//
+//
+//  This file defines the FileTokenCache interface.
+//
+//===----------------------------------------------------------------------===//
+
+#ifndef LLVM_CLANG_FILETOKENCACHE_H
+#define LLVM_CLANG_FILETOKENCACHE_H
+
+#include "clang/Basic/LLVM.h"
+#include "clang/Basic/SourceLocation.h"
+#include "clang/Basic/TokenKinds.h"
+#include <vector>
+
+namespace clang {
+  class LangOptions;
+
+/// FileTokenCache - The raw tokens of a file, recorded so that a Lexer that
+/// enters the same file again can return them without re-lexing characters.
+///
+/// Each entry records where lexing has to start to produce the token, i.e. the
+/// end of the previous token, so the Lexer can find the entry for its current
+/// position.  Only tokens that lex identically in raw and normal mode, without
+/// diagnostics and without leaving anything but whitespace and comments in
+/// front of them, are recorded.  In particular, '#' is never recorded, so
+/// directives are always handled by the Lexer itself.
+class FileTokenCache {
+public:
+  struct Entry {
+    /// LexStart - The offset of the end of the previous token.
+    unsigned LexStart;
+    /// Offset - The offset of the first character of the token.
+    unsigned Offset;
+    unsigned Length;
+    unsigned short Kind;
+    /// Flags - The Token::StartOfLine and Token::LeadingSpace flags.
+    unsigned char Flags;
+    /// HasComment - Whether a comment precedes the token after LexStart.
+    bool HasComment;
+
+    tok::TokenKind getKind() const { return (tok::TokenKind)Kind; }
+  };
+
+private:
+  std::vector<Entry> Entries;
+
+  FileTokenCache() { }
+
+public:
+  /// Create - Raw-lex the file starting at \p FileLoc, whose text is
+  /// [BufStart, BufEnd) followed by a null character, and record its tokens.
+  /// Returns null if the file contains constructs that make raw and normal
+  /// lexing differ beyond single tokens.
+  static FileTokenCache *Create(SourceLocation FileLoc,
+                                const LangOptions &LangOpts,
+                                const char *BufStart, const char *BufEnd);
+
+  /// find - Return the entry for lexing from \p LexStart, or null if the token
+  /// there was not recorded.  \p Hint is the index of the expected entry; it is
+  /// updated to the index following the result.
+  const Entry *find(unsigned LexStart, unsigned &Hint) const;
+
+  unsigned size() const { return Entries.size(); }
+};
+
+} // end namespace clang
+
+#endif
@@ -169,6 +169,18 @@ class HeaderSearch {
   llvm::StringMap<std::pair<unsigned, unsigned>, llvm::BumpPtrAllocator>
     LookupFileCache;
 
+  /// \brief Whether normal search directories are read once so that lookups
+  /// of names they don't contain can fail without touching the file system.
+  bool CacheSearchDirContents;
+
+  /// \brief The search directories whose contents were read, and whether
+  /// reading them succeeded.
+  llvm::DenseMap<const DirectoryEntry *, bool> IndexedDirs;
+
+  /// \brief The lowercased names of the entries of all IndexedDirs, each
+  /// prefixed with the DirectoryEntry pointer of its directory.
+  llvm::StringSet<llvm::BumpPtrAllocator> IndexedDirContents;
+
   /// \brief Collection mapping a framework or subframework
   /// name like "Carbon" to the Carbon.framework directory.
   llvm::StringMap<FrameworkCacheEntry, llvm::BumpPtrAllocator> FrameworkMap;
@@ -189,6 +201,11 @@ class HeaderSearch {
   
   /// \brief Describes whether a given directory has a module map in it.
   llvm::DenseMap<const DirectoryEntry *, bool> DirectoryHasModuleMap;
+
+  /// \brief Maps a directory to the search directory up to which none of its
+  /// parents has a module map, as determined by hasModuleMap.
+  llvm::DenseMap<const DirectoryEntry *, const DirectoryEntry *>
+    DirectoryLacksModuleMap;
   
   /// \brief Uniqued set of framework names, which is used to track which 
   /// headers were included as framework headers.
@@ -205,6 +222,7 @@ class HeaderSearch {
   unsigned NumIncluded;
   unsigned NumMultiIncludeFileOptzn;
   unsigned NumFrameworkLookups, NumSubFrameworkLookups;
+  unsigned NumIndexedDirLookups, NumIndexedDirMisses;
 
   // HeaderSearch doesn't support default or copy construction.
   explicit HeaderSearch();
@@ -276,6 +294,12 @@ public:
     return StringRef();
   }
 
+  /// \brief Set whether the contents of normal search directories are cached
+  /// to answer lookups of files that don't exist there.
+  void setCacheSearchDirContents(bool Cache) {
+    CacheSearchDirContents = Cache;
+  }
+
   /// \brief Set the path to the module cache.
   void setModuleCachePath(StringRef CachePath) {
     ModuleCachePath = CachePath;
@@ -557,6 +581,17 @@ private:
   /// named directory.
   LoadModuleMapResult loadModuleMapFile(StringRef DirName);
 
+  /// \brief Determine whether the search directory \p Dir may contain
+  /// \p Filename, using the cached directory contents if enabled.
+  ///
+  /// Returns false only if the first component of \p Filename was not found
+  /// when the directory was read.
+  bool directoryMayContain(const DirectoryEntry *Dir, StringRef Filename);
+
+  /// \brief Read the entries of \p Dir into IndexedDirContents.  Returns
+  /// false if the directory could not be read completely.
+  bool indexDirectory(const DirectoryEntry *Dir);
+
   /// \brief Try to load the module map file in the given directory.
   ///
   /// \param Dir The directory where we will look for a module map file.
@@ -22,6 +22,7 @@
 
 namespace clang {
 class DiagnosticsEngine;
+class FileTokenCache;
 class SourceManager;
 class Preprocessor;
 class DiagnosticBuilder;
@@ -83,6 +84,12 @@ class Lexer : public PreprocessorLexer {
   // CurrentConflictMarkerState - The kind of conflict marker we are handling.
   ConflictMarkerKind CurrentConflictMarkerState;
 
+  // TokenCache - The tokens recorded when this file was lexed before, if any.
+  const FileTokenCache *TokenCache;
+
+  // TokenCacheHint - The index of the TokenCache entry expected next.
+  unsigned TokenCacheHint;
+
   Lexer(const Lexer&);          // DO NOT IMPLEMENT
   void operator=(const Lexer&); // DO NOT IMPLEMENT
   friend class Preprocessor;
@@ -142,11 +149,22 @@ public:
       IsAtStartOfLine = false;
     }
 
+    // Replay the token from the cache if possible.
+    if (TokenCache && LexFromTokenCache(Result))
+      return;
+
     // Get a token.  Note that this may delete the current lexer if the end of
     // file is reached.
     LexTokenInternal(Result);
   }
 
+  /// setTokenCache - Return tokens from \p Cache, which holds the tokens of
+  /// this lexer's file, wherever possible instead of lexing them again.
+  void setTokenCache(const FileTokenCache *Cache) {
+    TokenCache = Cache;
+    TokenCacheHint = 0;
+  }
+
   /// isPragmaLexer - Returns true if this Lexer is being used to lex a pragma.
   bool isPragmaLexer() const { return Is_PragmaLexer; }
 
@@ -202,6 +220,12 @@ public:
   /// uninterpreted string.  This switches the lexer out of directive mode.
   void ReadToEndOfLine(SmallVectorImpl<char> *Result = 0);
 
+  /// SkipExcludedLines - Skip the text of an excluded conditional block, in
+  /// raw mode, up to the next '#' that may start a directive, without forming
+  /// tokens.  This may stop earlier, between tokens, where the text needs to
+  /// be lexed.
+  void SkipExcludedLines();
+
 
   /// Diag - Forwarding function for diagnostics.  This translate a source
   /// position in the current buffer into a SourceLocation object for rendering.
@@ -428,6 +452,10 @@ public:
   // Internal implementation interfaces.
 private:
 
+  /// LexFromTokenCache - Form the token at BufferPtr from TokenCache.  Returns
+  /// false if it has to be lexed instead.
+  bool LexFromTokenCache(Token &Result);
+
   /// LexTokenInternal - Internal interface to lex a preprocessing token. Called
   /// by Lex.
   ///
@@ -567,6 +595,7 @@ private:
   bool SkipBCPLComment       (Token &Result, const char *CurPtr);
   bool SkipBlockComment      (Token &Result, const char *CurPtr);
   bool SaveBCPLComment       (Token &Result, const char *CurPtr);
+  const char *SkipToDirectiveLine(const char *CurPtr);
   
   bool IsStartOfConflictMarker(const char *CurPtr);
   bool HandleEndOfConflictMarker(const char *CurPtr);
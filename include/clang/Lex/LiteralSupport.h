@@ -92,6 +92,12 @@ public:
   /// literal exactly, and false otherwise.
   llvm::APFloat::opStatus GetFloatValue(llvm::APFloat &Result);
 
+  /// GetPlainDecimalValue - If the given spelling of a ppnumber is a decimal
+  /// integer constant without a suffix whose value fits in 64 bits, which is
+  /// the most common kind of numeric literal, compute its value without
+  /// running the parser.  Otherwise, return false.
+  static bool GetPlainDecimalValue(StringRef Spelling, uint64_t &Val);
+
 private:
 
   void ParseNumberStartingWithZero(SourceLocation TokLoc);
@@ -217,6 +223,14 @@ public:
 
   StringRef getUDSuffix() const { return UDSuffixBuf; }
 
+  /// GetPlainString - If the given spelling of an ordinary string literal
+  /// token has no prefix, escape, non-ASCII character or ud-suffix, and is
+  /// short enough to need no diagnostic, set \p String to its contents, which
+  /// are the spelling without the quotes, and return true.  Such a string
+  /// does not need the parser, unless it is concatenated with others.
+  static bool GetPlainString(StringRef Spelling, const LangOptions &Features,
+                             StringRef &String);
+
   /// Get the index of a token containing a ud-suffix.
   unsigned getUDSuffixToken() const {
     assert(!UDSuffixBuf.empty() && "no ud-suffix");
@@ -112,6 +112,12 @@ public:
     BuiltinIncludeDir = Dir;
   }
 
+  /// \brief Retrieve the directory that contains Clang-supplied include
+  /// files, if it is known.
+  const DirectoryEntry *getBuiltinIncludeDir() const {
+    return BuiltinIncludeDir;
+  }
+
   /// \brief Retrieve the module that owns the given header file, if any.
   ///
   /// \param File The header file that is likely to be included.
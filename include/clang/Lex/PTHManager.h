@@ -133,6 +133,12 @@ public:
   ///  calls to stat by memoizing their results from when the PTH file
   ///  was generated.
   FileSystemStatCache *createStatCache();
+
+  /// isUpToDate - Returns true if the files the PTH cache was generated from
+  ///  still have the size and modification time recorded in it, and the paths
+  ///  that did not exist back then still don't.  This checks the real file
+  ///  system, not the stat cache.
+  bool isUpToDate() const;
 };
 
 }  // end namespace clang
@@ -20,6 +20,7 @@
 #include "llvm/ADT/SmallVector.h"
 #include "llvm/ADT/DenseMap.h"
 #include "llvm/ADT/Optional.h"
+#include "llvm/ADT/PointerUnion.h"
 #include "llvm/Support/Allocator.h"
 #include "llvm/Support/Compiler.h"
 #include <vector>
@@ -290,9 +291,23 @@ namespace clang {
     /// \brief Allocator used to store preprocessing objects.
     llvm::BumpPtrAllocator BumpAlloc;
 
-    /// \brief The set of preprocessed entities in this record, in order they
-    /// were seen.
-    std::vector<PreprocessedEntity *> PreprocessedEntities;
+    /// \brief A local preprocessed entity, or what is needed to create it.
+    ///
+    /// Macro expansions, which make up most of the entities of a translation
+    /// unit, are recorded as the definition of the expanded macro, or the name
+    /// of a builtin macro, and only become a \c MacroExpansion when a client
+    /// retrieves them. All other entities are created when they are recorded.
+    typedef llvm::PointerUnion3<PreprocessedEntity *, MacroDefinition *,
+                                IdentifierInfo *> LocalEntity;
+
+    /// \brief The preprocessed entities in this record, in the order they
+    /// were seen, along with the begin and end locations of each of them.
+    ///
+    /// The locations are kept apart from the entities so that the lookups by
+    /// location only touch the locations.
+    std::vector<LocalEntity> PreprocessedEntities;
+    std::vector<SourceLocation> PreprocessedEntityBegins;
+    std::vector<SourceLocation> PreprocessedEntityEnds;
     
     /// \brief The set of preprocessed entities in this record that have been
     /// loaded from external sources.
@@ -362,6 +377,10 @@ namespace clang {
     /// \brief Retrieve the preprocessed entity at the given ID.
     PreprocessedEntity *getPreprocessedEntity(PPEntityID PPID);
 
+    /// \brief Retrieve the local preprocessed entity at the given index,
+    /// creating it if it is a macro expansion that was not retrieved before.
+    PreprocessedEntity *getLocalPreprocessedEntity(unsigned Index);
+
     /// \brief Retrieve the loaded preprocessed entity at the given index.
     PreprocessedEntity *getLoadedPreprocessedEntity(unsigned Index);
     
@@ -378,6 +397,14 @@ namespace clang {
     unsigned findBeginLocalPreprocessedEntity(SourceLocation Loc) const;
     unsigned findEndLocalPreprocessedEntity(SourceLocation Loc) const;
 
+    /// \brief Add a local entity covering \p Range to this record.
+    ///
+    /// \param MayBeOutOfOrder whether the entity may begin before the last
+    /// local entity, as inclusion directives that name the file through a
+    /// macro do.
+    PPEntityID addLocalEntity(LocalEntity Entity, SourceRange Range,
+                              bool MayBeOutOfOrder);
+
     /// \brief Allocate space for a new set of loaded preprocessed entities.
     ///
     /// \returns The index into the set of loaded preprocessed entities, which
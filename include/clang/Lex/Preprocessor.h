@@ -43,6 +43,8 @@ class SourceManager;
 class ExternalPreprocessorSource;
 class FileManager;
 class FileEntry;
+class FileTokenCache;
+class MacroArgExpansionCache;
 class HeaderSearch;
 class PragmaNamespace;
 class PragmaHandler;
@@ -112,6 +114,14 @@ class Preprocessor : public RefCountedBase<Preprocessor> {
   bool KeepMacroComments : 1;
   bool SuppressIncludeNotFoundError : 1;
 
+  /// \brief True if the tokens of files that are entered more than once are
+  /// recorded and replayed, see FileTokenCache.
+  bool CacheRepeatedIncludes : 1;
+
+  /// \brief True if the lines of files which cannot start a directive are
+  /// skipped rather than lexed.
+  bool SkipNonDirectiveLines : 1;
+
   // State that changes while the preprocessor runs:
   bool InMacroArgs : 1;            // True if parsing fn macro invocation args.
 
@@ -294,6 +304,16 @@ class Preprocessor : public RefCountedBase<Preprocessor> {
   MacroArgs *MacroArgCache;
   friend class MacroArgs;
 
+  /// MacroArgExpansions - The recorded pre-expansions of macro arguments, if
+  /// they are cached, see MacroArgExpansionCache.
+  OwningPtr<MacroArgExpansionCache> MacroArgExpansions;
+  friend class MacroArgExpansionCache;
+
+  /// FileTokenCaches - The recorded tokens of files that were entered more
+  /// than once while CacheRepeatedIncludes was set.  Files whose tokens
+  /// cannot be recorded map to null.
+  llvm::DenseMap<const FileEntry *, FileTokenCache *> FileTokenCaches;
+
   /// PragmaPushMacroInfo - For each IdentifierInfo used in a #pragma
   /// push_macro directive, we keep a MacroInfo stack used to restore
   /// previous macro value.
@@ -432,6 +452,27 @@ public:
     return SuppressIncludeNotFoundError;
   }
 
+  /// \brief Control whether the tokens of files that are included more than
+  /// once are lexed only once and replayed on later inclusions.
+  void setCacheRepeatedIncludes(bool Cache) { CacheRepeatedIncludes = Cache; }
+  bool getCacheRepeatedIncludes() const { return CacheRepeatedIncludes; }
+
+  /// \brief Control whether only the preprocessor directives of files are
+  /// run, skipping all other lines without forming their tokens.
+  ///
+  /// This is enough to find the files a translation unit includes, but Lex()
+  /// never returns the tokens of the skipped lines, so _Pragma operators and
+  /// macro expansions outside of directives have no effect.
+  void setSkipNonDirectiveLines(bool Skip) { SkipNonDirectiveLines = Skip; }
+  bool getSkipNonDirectiveLines() const { return SkipNonDirectiveLines; }
+
+  /// \brief Control whether the pre-expansion of macro arguments is recorded
+  /// and replayed for later arguments made of the same tokens.
+  void setCacheMacroArgExpansions(bool Cache);
+  bool getCacheMacroArgExpansions() const {
+    return MacroArgExpansions.get() != 0;
+  }
+
   /// isCurrentLexer - Return true if we are lexing directly from the specified
   /// lexer.
   bool isCurrentLexer(const PreprocessorLexer *L) const {
@@ -522,6 +563,9 @@ public:
   /// It is an error to remove a handler that has not been registered.
   void removeCommentHandler(CommentHandler *Handler);
 
+  /// \brief Whether any comment handlers are registered.
+  bool hasCommentHandlers() const { return !CommentHandlers.empty(); }
+
   /// \brief Set the code completion handler to the given object.
   void setCodeCompletionHandler(CodeCompletionHandler &Handler) {
     CodeComplete = &Handler;
@@ -1248,6 +1292,22 @@ private:
   /// start getting tokens from it using the PTH cache.
   void EnterSourceFileWithPTH(PTHLexer *PL, const DirectoryLookup *Dir);
 
+  /// getFileTokenCache - Return the recorded tokens of the file \p FID, whose
+  /// text is \p Buffer, recording them if the file is entered for the second
+  /// time.  Returns null if the tokens should not or cannot be recorded.
+  const FileTokenCache *getFileTokenCache(FileID FID,
+                                          const llvm::MemoryBuffer *Buffer);
+
+  /// getMacroArgExpansionCache - Return the cache of macro argument
+  /// pre-expansions, or null if pre-expansions should not be cached.  Clients
+  /// observing macro expansions need to see every one of them.
+  MacroArgExpansionCache *getMacroArgExpansionCache() const {
+    if (Callbacks || isCodeCompletionEnabled() ||
+        getLangOpts().allowsModuleImports())
+      return 0;
+    return MacroArgExpansions.get();
+  }
+
   /// IsFileLexer - Returns true if we are lexing from a file and not a
   ///  pragma or a macro.
   static bool IsFileLexer(const Lexer* L, const PreprocessorLexer* P) {
@@ -1334,6 +1394,12 @@ public:
   /// \brief A macro is used, update information about macros that need unused
   /// warnings.
   void markMacroAsUsed(MacroInfo *MI);
+
+  /// \brief The macro \#defined for \p II is used by \#ifdef or 'defined',
+  /// which do not need its definition.
+  ///
+  /// A macro that the external source has not loaded yet stays unloaded.
+  void markDefinedMacroAsUsed(IdentifierInfo *II);
 };
 
 /// \brief Abstract base class that describes a handler that will receive
@@ -15,6 +15,7 @@
 #define LLVM_CLANG_SCRATCHBUFFER_H
 
 #include "clang/Basic/SourceLocation.h"
+#include "llvm/ADT/StringMap.h"
 
 namespace clang {
   class SourceManager;
@@ -27,8 +28,37 @@ class ScratchBuffer {
   char *CurBuffer;
   SourceLocation BufferStartLoc;
   unsigned BytesUsed;
+
+  /// BufferSize - The size of the chunk that CurBuffer points to.  Chunks start
+  /// out small and double (up to a limit) each time one fills up.
+  unsigned BufferSize;
+
+  /// ScratchSpelling - Where a spelling has already been placed in scratch
+  /// space, and the location of that copy.
+  struct ScratchSpelling {
+    ScratchSpelling() : Ptr(0) {}
+    const char *Ptr;
+    SourceLocation Loc;
+  };
+
+  /// ShareSpellings - Whether identical spellings are handed out once.  This
+  /// gives them all the same location, so it is only appropriate for clients
+  /// that do not key anything off of token locations.
+  bool ShareSpellings;
+
+  /// Spellings - Each distinct spelling handed out so far, so that tokens
+  /// which are formed over and over (e.g. by the same paste or stringize in
+  /// every expansion of a macro) share one copy.  Only used when
+  /// ShareSpellings is set.
+  llvm::StringMap<ScratchSpelling> Spellings;
+
+  // Statistics.
+  unsigned NumTokens, NumSharedTokens, NumBuffers;
+  uint64_t TotalBufferBytes, SpellingMapBytes;
 public:
-  ScratchBuffer(SourceManager &SM);
+  /// ScratchBuffer - If \p ShareSpellings is true, getToken returns the same
+  /// location for every token with the same spelling.
+  explicit ScratchBuffer(SourceManager &SM, bool ShareSpellings = false);
 
   /// getToken - Splat the specified text into a temporary MemoryBuffer and
   /// return a SourceLocation that refers to the token.  This is just like the
@@ -36,6 +66,9 @@ public:
   /// token.
   SourceLocation getToken(const char *Buf, unsigned Len, const char *&DestPtr);
 
+  /// PrintStats - Print statistics about scratch space usage to stderr.
+  void PrintStats() const;
+
 private:
   void AllocScratchBuffer(unsigned RequestLen);
 };
@@ -41,8 +41,13 @@ namespace clang {
 
   /// \brief Parse the main file known to the preprocessor, producing an 
   /// abstract syntax tree.
+  ///
+  /// \param SkipFunctionBodiesOutsideMainFile If true, skip the bodies of
+  /// the functions defined outside the main file, as though
+  /// \p SkipFunctionBodies applied to them alone.
   void ParseAST(Sema &S, bool PrintStats = false,
-                bool SkipFunctionBodies = false);
+                bool SkipFunctionBodies = false,
+                bool SkipFunctionBodiesOutsideMainFile = false);
   
 }  // end namespace clang
 
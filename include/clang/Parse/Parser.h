@@ -19,6 +19,7 @@
 #include "clang/Lex/CodeCompletionHandler.h"
 #include "clang/Sema/Sema.h"
 #include "clang/Sema/DeclSpec.h"
+#include "llvm/ADT/DenseMap.h"
 #include "llvm/ADT/OwningPtr.h"
 #include "llvm/ADT/SmallVector.h"
 #include "llvm/Support/Compiler.h"
@@ -177,6 +178,7 @@ class Parser : public CodeCompletionHandler {
   OwningPtr<PragmaHandler> WeakHandler;
   OwningPtr<PragmaHandler> RedefineExtnameHandler;
   OwningPtr<PragmaHandler> FPContractHandler;
+  OwningPtr<PragmaHandler> LoopHintHandler;
   OwningPtr<PragmaHandler> OpenCLExtensionHandler;
   OwningPtr<CommentHandler> CommentSemaHandler;
 
@@ -212,6 +214,43 @@ class Parser : public CodeCompletionHandler {
   /// \brief Identifiers which have been declared within a tentative parse.
   SmallVector<IdentifierInfo *, 8> TentativelyDeclaredIdentifiers;
 
+  /// \brief The questions answered by tentative parsing whose answers are
+  /// memoized.
+  enum DisambiguationKind {
+    DK_SimpleDeclaration,
+    DK_ForRangeDeclaration,
+    DK_ConditionDeclaration,
+    DK_FunctionDeclarator,
+    DK_TypeIdInParens,
+    DK_TypeIdAsTemplateArgument
+  };
+
+  /// \brief The answer of a tentative parse, and the state it depended on.
+  struct MemoizedDisambiguation {
+    /// \brief The generation of the identifier resolver; a declaration made
+    /// since can change which names are types.
+    unsigned Generation;
+
+    /// \brief The number of identifiers that were tentatively declared.
+    unsigned NumTentativelyDeclared;
+
+    bool Result;
+    bool IsAmbiguous;
+  };
+
+  /// \brief The answers of the tentative parses within the current top-level
+  /// declaration, by the raw encoding of the location of the token they
+  /// started at and by DisambiguationKind.
+  llvm::DenseMap<std::pair<unsigned, unsigned>, MemoizedDisambiguation>
+    DisambiguationCache;
+
+  /// \brief Statistics about disambiguation: the number of questions that
+  /// needed a tentative parse, that were answered by looking ahead a few
+  /// tokens, and that were answered from DisambiguationCache.
+  unsigned NumTentativeDisambiguations;
+  unsigned NumSimpleDisambiguations;
+  unsigned NumMemoizedDisambiguations;
+
   IdentifierInfo *getSEHExceptKeyword();
 
   /// True if we are within an Objective-C container while parsing C-like decls.
@@ -223,8 +262,13 @@ class Parser : public CodeCompletionHandler {
 
   bool SkipFunctionBodies;
 
+  /// \brief Whether to skip the bodies of the functions defined outside the
+  /// main file, for clients that only need the declarations of headers.
+  bool SkipFunctionBodiesOutsideMainFile;
+
 public:
-  Parser(Preprocessor &PP, Sema &Actions, bool SkipFunctionBodies);
+  Parser(Preprocessor &PP, Sema &Actions, bool SkipFunctionBodies,
+         bool SkipFunctionBodiesOutsideMainFile = false);
   ~Parser();
 
   const LangOptions &getLangOpts() const { return PP.getLangOpts(); }
@@ -233,6 +277,9 @@ public:
   Sema &getActions() const { return Actions; }
   AttributeFactory &getAttrFactory() { return AttrFactory; }
 
+  /// \brief Print statistics about the parser to stderr.
+  void PrintStats() const;
+
   const Token &getCurToken() const { return Tok; }
   Scope *getCurScope() const { return Actions.getCurScope(); }
 
@@ -1065,6 +1112,7 @@ private:
   void ParseLexedMethodDeclaration(LateParsedMethodDeclaration &LM);
   void ParseLexedMethodDefs(ParsingClass &Class);
   void ParseLexedMethodDef(LexedMethod &LM);
+  bool tryDelayingLexedMethodDef(LexedMethod &LM);
   void ParseLexedMemberInitializers(ParsingClass &Class);
   void ParseLexedMemberInitializer(LateParsedMemberInitializer &MI);
   void ParseLexedObjCMethodDefs(LexedMethod &LM, bool parseMethod);
@@ -1435,6 +1483,12 @@ private:
                                          bool OnlyStatement,
                                          SourceLocation *TrailingElseLoc,
                                          ParsedAttributesWithRange &Attrs);
+  StmtResult ParsePragmaLoopHint(StmtVector &Stmts, bool OnlyStatement,
+                                 SourceLocation *TrailingElseLoc,
+                                 ParsedAttributesWithRange &Attrs);
+  /// \brief Handle the annotation token produced for an option of
+  /// #pragma clang loop..., adding the option to \p Hints.
+  void HandlePragmaLoopHint(ParsedAttributesWithRange &Hints);
   StmtResult ParseExprStatement();
   StmtResult ParseLabeledStatement(ParsedAttributesWithRange &attrs);
   StmtResult ParseCaseStatement(bool MissingCase = false,
@@ -1579,6 +1633,15 @@ private:
   /// \returns true if the function body was skipped.
   bool trySkippingFunctionBody();
 
+  /// \brief Determine whether the body of the function \p D, which starts at
+  /// the current token, should be skipped.
+  bool shouldSkipFunctionBody(Decl *D);
+
+  /// \brief Determine whether the body of a templated function, which starts
+  /// at the current token, should be lexed and stored to be parsed only
+  /// when the function is instantiated.
+  bool shouldDelayTemplateFunctionBody(const DeclSpec &DS);
+
   bool ParseImplicitInt(DeclSpec &DS, CXXScopeSpec *SS,
                         const ParsedTemplateInfo &TemplateInfo,
                         AccessSpecifier AS, DeclSpecContext DSC);
@@ -1705,6 +1768,17 @@ private:
     return isCXXTypeId(Context, isAmbiguous);
   }
 
+  /// \brief Look up the memoized answer to the question \p Kind about the
+  /// tokens starting at the current one.  Returns false if there is none, or
+  /// if it may no longer be right.
+  bool lookupDisambiguation(DisambiguationKind Kind, bool &Result,
+                            bool *IsAmbiguous = 0);
+
+  /// \brief Memoize the answer of a tentative parse which started at the
+  /// current token.
+  void memoizeDisambiguation(DisambiguationKind Kind, bool Result,
+                             bool IsAmbiguous = false);
+
   /// TPResult - Used as the result value for functions whose purpose is to
   /// disambiguate C++ constructs by "tentatively parsing" them.
   /// This is a class instead of a simple enum because the implicit enum-to-bool
@@ -1740,6 +1814,29 @@ private:
   /// tell.
   TPResult isExpressionOrTypeSpecifierSimple(tok::TokenKind Kind);
 
+  /// \brief Determine whether the given token, which follows a '(', can only
+  /// start an expression, and neither a declarator nor a
+  /// parameter-declaration-clause.
+  bool isExpressionOnlyAfterParen(const Token &Next);
+
+  /// \brief Determine, by looking ahead a few tokens only, whether the
+  /// simple-type-specifier at the current token starts a function-style
+  /// cast rather than a declaration or a type-id.  Returns false if a
+  /// tentative parse is needed to tell.
+  ///
+  /// \param AllowEmptyParens Whether 'T()' is a function-style cast; it is
+  /// a function type in a type-id.
+  bool isCXXFunctionStyleCastSimple(bool AllowEmptyParens);
+
+  /// \brief Disambiguate a function declarator from a constructor-style
+  /// initializer by looking ahead a few tokens only.  Returns
+  /// TPResult::Ambiguous() if a tentative parse is needed to tell.
+  TPResult isCXXFunctionDeclaratorSimple(bool &IsAmbiguous);
+
+  /// \brief Determine whether the token after the ')' of a function
+  /// declarator can only follow a function declarator.
+  bool isCXXFunctionDeclaratorSuffix(const Token &Next);
+
   /// isCXXDeclarationSpecifier - Returns TPResult::True() if it is a
   /// declaration specifier, TPResult::False() if it is not,
   /// TPResult::Ambiguous() if it could be either a decl-specifier or a
@@ -17,6 +17,7 @@
 
 #include "clang/Basic/SourceLocation.h"
 #include <string>
+#include <vector>
 
 namespace clang {
 
@@ -75,6 +76,36 @@ namespace html {
   /// reasonably close.
   void HighlightMacros(Rewriter &R, FileID FID, const Preprocessor &PP);
 
+  /// HighlightedRange - A range of a file, in offsets from its start, and the
+  /// tags to put around it.
+  struct HighlightedRange {
+    unsigned Begin, End;
+    const char *StartTag;
+    std::string EndTag;
+
+    HighlightedRange(unsigned B, unsigned E, const char *S,
+                     const std::string &ET)
+      : Begin(B), End(E), StartTag(S), EndTag(ET) {}
+  };
+  typedef std::vector<HighlightedRange> HighlightedRanges;
+
+  /// CollectSyntaxHighlights - Compute the ranges SyntaxHighlight would
+  /// highlight, so that clients rendering the same file several times only
+  /// relex it once.
+  void CollectSyntaxHighlights(FileID FID, const Preprocessor &PP,
+                               HighlightedRanges &Ranges);
+
+  /// CollectMacroHighlights - Compute the ranges HighlightMacros would
+  /// highlight, so that clients rendering the same file several times only
+  /// reexpand its macros once.
+  void CollectMacroHighlights(FileID FID, const Preprocessor &PP,
+                              HighlightedRanges &Ranges);
+
+  /// ApplyHighlights - Highlight the given ranges of the specified FileID, in
+  /// order.
+  void ApplyHighlights(Rewriter &R, FileID FID,
+                       const HighlightedRanges &Ranges);
+
 } // end html namespace
 } // end clang namespace
 
@@ -15,6 +15,7 @@
 #define LLVM_CLANG_SEMA_ANALYSIS_WARNINGS_H
 
 #include "llvm/ADT/DenseMap.h"
+#include "llvm/ADT/OwningPtr.h"
 
 namespace clang {
 
@@ -50,6 +51,11 @@ private:
   enum VisitFlag { NotVisited = 0, Visited = 1, Pending = 2 };
   llvm::DenseMap<const FunctionDecl*, VisitFlag> VisitedFD;
 
+  /// \brief The timers of the CFG construction and of each analysis, if
+  /// enabled with -ftime-report.
+  struct AnalysisTimers;
+  OwningPtr<AnalysisTimers> Timers;
+
   /// \name Statistics
   /// @{
 
@@ -88,6 +94,11 @@ private:
 
 public:
   AnalysisBasedWarnings(Sema &s);
+  ~AnalysisBasedWarnings();
+
+  /// \brief Time the CFG construction and each analysis separately.  The
+  /// times are reported when the AnalysisBasedWarnings is destroyed.
+  void enableTimers();
 
   void IssueWarnings(Policy P, FunctionScopeInfo *fscope,
                      const Decl *D, const BlockExpr *blkExpr);
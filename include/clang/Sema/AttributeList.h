@@ -61,7 +61,10 @@ public:
     AS_Declspec,
     // eg) __w64, __ptr32, etc.  It is implied that an MSTypespec is also
     // a declspec.
-    AS_MSTypespec   
+    AS_MSTypespec,
+    // eg) #pragma clang loop vectorize_width(4). The attribute is named after
+    // the pragma; its parameter is the option of the directive.
+    AS_Pragma
   };
 private:
   IdentifierInfo *AttrName;
@@ -345,6 +348,12 @@ public:
 /// A factory, from which one makes pools, from which one creates
 /// individual attributes which are deallocated with the pool.
 ///
+/// The factory also owns the storage of the other short-lived arrays
+/// of a parsed declaration, such as the parameters of a function
+/// declarator and the arguments of a template-id annotation.  That
+/// storage is never freed individually; the parser releases all of it
+/// at once between top-level declarations.
+///
 /// Note that it's tolerably cheap to create and destroy one of
 /// these as long as you don't actually allocate anything in it.
 class AttributeFactory {
@@ -379,6 +388,13 @@ private:
   ///   (size - sizeof(AttributeList)) / sizeof(void*)
   SmallVector<AttributeList*, InlineFreeListsCapacity> FreeLists;
 
+  /// The storage of the parsed declaration, other than the attributes.
+  llvm::BumpPtrAllocator DeclAlloc;
+
+  /// Statistics.
+  unsigned NumAttrsAllocated, NumAttrsReused;
+  unsigned NumDeclAllocations, NumDeclResets;
+
   // The following are the private interface used by AttributePool.
   friend class AttributePool;
 
@@ -395,6 +411,26 @@ private:
 public:
   AttributeFactory();
   ~AttributeFactory();
+
+  /// Allocate storage which lives until the next call to
+  /// resetDeclStorage() or until the factory is destroyed.
+  void *allocateDeclStorage(size_t Size, unsigned Alignment) {
+    ++NumDeclAllocations;
+    return DeclAlloc.Allocate(Size, Alignment);
+  }
+
+  template <typename T>
+  T *allocateDeclStorage(unsigned Num) {
+    return static_cast<T *>(allocateDeclStorage(sizeof(T) * Num,
+                                                llvm::AlignOf<T>::Alignment));
+  }
+
+  /// Release all of the storage allocated by allocateDeclStorage().  No
+  /// declarator or template-id annotation from this factory may still be
+  /// alive.
+  void resetDeclStorage();
+
+  void PrintStats() const;
 };
 
 class AttributePool {
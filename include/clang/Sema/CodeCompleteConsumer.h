@@ -140,6 +140,14 @@ unsigned getMacroUsagePriority(StringRef MacroName,
 /// declaration.
 CXCursorKind getCursorKindForDecl(Decl *D);
 
+/// \brief Determine whether a code-completion result named \p Name matches
+/// the text \p Filter that the user typed, ignoring case.
+///
+/// \param Fuzzy If true, the characters of \p Filter only need to appear in
+/// \p Name in order; otherwise, \p Name must start with \p Filter.
+bool matchesCodeCompletionFilter(StringRef Name, StringRef Filter,
+                                 bool Fuzzy);
+
 class FunctionDecl;
 class FunctionType;
 class FunctionTemplateDecl;
@@ -640,6 +648,13 @@ public:
   /// \brief Add the parent context information to this code completion.
   void addParentContext(DeclContext *DC);
 
+  /// \brief Set the parent context information, whose name must be stored in
+  /// the allocator, to recreate a code completion string.
+  void setParentContext(CXCursorKind Kind, StringRef Name) {
+    ParentKind = Kind;
+    ParentName = Name;
+  }
+
   void addBriefComment(StringRef Comment);
   
   CXCursorKind getParentKind() const { return ParentKind; }
@@ -932,6 +947,25 @@ public:
     return CodeCompleteOpts.IncludeBriefComments;
   }
 
+  /// \brief The text that the names of the results must match, or an empty
+  /// string if all results are wanted.
+  StringRef getFilterPrefix() const {
+    return CodeCompleteOpts.FilterPrefix;
+  }
+
+  /// \brief Whether the filter prefix only needs to match a subsequence of
+  /// each name.
+  bool isFuzzyFilter() const {
+    return CodeCompleteOpts.FuzzyFilter;
+  }
+
+  /// \brief Determine whether a result named \p Name passes the filter
+  /// prefix, and so should be reported to this consumer.
+  bool matchesFilter(StringRef Name) const {
+    return matchesCodeCompletionFilter(Name, getFilterPrefix(),
+                                       isFuzzyFilter());
+  }
+
   /// \brief Determine whether the output of this consumer is binary.
   bool isOutputBinary() const { return OutputIsBinary; }
 
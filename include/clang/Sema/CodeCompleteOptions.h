@@ -10,6 +10,8 @@
 #ifndef LLVM_CLANG_SEMA_CODECOMPLETEOPTIONS_H
 #define LLVM_CLANG_SEMA_CODECOMPLETEOPTIONS_H
 
+#include <string>
+
 /// Options controlling the behavior of code completion.
 class CodeCompleteOptions {
 public:
@@ -25,11 +27,20 @@ public:
   ///< Show brief documentation comments in code completion results.
   unsigned IncludeBriefComments : 1;
 
+  ///< Match FilterPrefix as a subsequence of each name rather than as a
+  ///< prefix.
+  unsigned FuzzyFilter : 1;
+
+  ///< If non-empty, only show the results whose names start with this text,
+  ///< ignoring case.
+  std::string FilterPrefix;
+
   CodeCompleteOptions() :
       IncludeMacros(0),
       IncludeCodePatterns(0),
       IncludeGlobals(1),
-      IncludeBriefComments(0)
+      IncludeBriefComments(0),
+      FuzzyFilter(0)
   { }
 };
 
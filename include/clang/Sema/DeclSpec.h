@@ -413,10 +413,6 @@ public:
       writtenBS(),
       ObjCQualifiers(0) {
   }
-  ~DeclSpec() {
-    delete [] ProtocolQualifiers;
-    delete [] ProtocolLocs;
-  }
   // storage-class-specifier
   SCS getStorageClassSpec() const { return (SCS)StorageClassSpec; }
   bool isThreadSpecified() const { return SCS_thread_specified; }
@@ -1120,9 +1116,6 @@ struct DeclaratorChunk {
     /// ExceptionSpecType - An ExceptionSpecificationType value.
     unsigned ExceptionSpecType : 3;
 
-    /// DeleteArgInfo - If this is true, we need to delete[] ArgInfo.
-    unsigned DeleteArgInfo : 1;
-
     /// HasTrailingReturnType - If this is true, a trailing return type was
     /// specified.
     unsigned HasTrailingReturnType : 1;
@@ -1160,13 +1153,13 @@ struct DeclaratorChunk {
     /// \brief The location of the keyword introducing the spec, if any.
     unsigned ExceptionSpecLoc;
 
-    /// ArgInfo - This is a pointer to a new[]'d array of ParamInfo objects that
+    /// ArgInfo - This is a pointer to an array of ParamInfo objects that
     /// describe the arguments for this function declarator.  This is null if
     /// there are no arguments specified.
     ParamInfo *ArgInfo;
 
     union {
-      /// \brief Pointer to a new[]'d array of TypeAndRange objects that
+      /// \brief Pointer to an array of TypeAndRange objects that
       /// contain the types in the function's dynamic exception specification
       /// and their locations, if there is one.
       TypeAndRange *Exceptions;
@@ -1184,19 +1177,12 @@ struct DeclaratorChunk {
     ///
     /// This is used in various places for error recovery.
     void freeArgs() {
-      if (DeleteArgInfo) {
-        delete[] ArgInfo;
-        DeleteArgInfo = false;
-      }
       NumArgs = 0;
     }
 
-    void destroy() {
-      if (DeleteArgInfo)
-        delete[] ArgInfo;
-      if (getExceptionSpecType() == EST_Dynamic)
-        delete[] Exceptions;
-    }
+    /// The argument and exception arrays are owned by the AttributeFactory
+    /// of the declarator.
+    void destroy() {}
 
     /// isKNRPrototype - Return true if this is a K&R style identifier list,
     /// like "void foo(a,b,c)".  In a function definition, this will be followed
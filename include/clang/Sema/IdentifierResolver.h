@@ -187,6 +187,11 @@ public:
   ///
   /// \returns true if the declaration was added, false otherwise.
   bool tryAddTopLevelDecl(NamedDecl *D, DeclarationName Name);
+
+  /// \brief The number of times the declarations of an identifier have been
+  /// added, removed or replaced, which lets clients tell whether the meaning
+  /// of a name can have changed since they last looked it up.
+  unsigned getGeneration() const { return Generation; }
   
   explicit IdentifierResolver(Preprocessor &PP);
   ~IdentifierResolver();
@@ -198,6 +203,8 @@ private:
   class IdDeclInfoMap;
   IdDeclInfoMap *IdDeclInfos;
 
+  unsigned Generation;
+
   void updatingIdentifier(IdentifierInfo &II);
   void readingIdentifier(IdentifierInfo &II);
   
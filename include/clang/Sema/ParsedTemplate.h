@@ -179,13 +179,16 @@ namespace clang {
       return reinterpret_cast<ParsedTemplateArgument *>(this + 1); 
     }
 
-    /// \brief Creates a new TemplateIdAnnotation with NumArgs arguments and
-    /// appends it to List.
+    /// \brief Creates a new TemplateIdAnnotation with NumArgs arguments in
+    /// the declaration storage of \p Factory and appends it to List.
     static TemplateIdAnnotation *
-    Allocate(unsigned NumArgs, SmallVectorImpl<TemplateIdAnnotation*> &List) {
+    Allocate(unsigned NumArgs, SmallVectorImpl<TemplateIdAnnotation*> &List,
+             AttributeFactory &Factory) {
       TemplateIdAnnotation *TemplateId
-        = (TemplateIdAnnotation *)std::malloc(sizeof(TemplateIdAnnotation) +
-                                      sizeof(ParsedTemplateArgument) * NumArgs);
+        = (TemplateIdAnnotation *)Factory.allocateDeclStorage(
+            sizeof(TemplateIdAnnotation) +
+              sizeof(ParsedTemplateArgument) * NumArgs,
+            llvm::AlignOf<TemplateIdAnnotation>::Alignment);
       TemplateId->NumArgs = NumArgs;
       
       // Default-construct nested-name-specifier.
@@ -200,9 +203,10 @@ namespace clang {
       return TemplateId;
     }
     
+    /// \brief Destroys the nested-name-specifier.  The storage itself is
+    /// released with the rest of the factory's declaration storage.
     void Destroy() { 
       SS.~CXXScopeSpec();
-      free(this); 
     }
   };
 
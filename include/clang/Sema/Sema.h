@@ -42,6 +42,7 @@
 #include "llvm/ADT/SetVector.h"
 #include "llvm/ADT/SmallPtrSet.h"
 #include "llvm/ADT/SmallVector.h"
+#include "llvm/ADT/StringMap.h"
 #include <deque>
 #include <string>
 
@@ -83,6 +84,7 @@ namespace clang {
   class CodeCompletionAllocator;
   class CodeCompletionTUInfo;
   class CodeCompletionResult;
+  class CompilationProfile;
   class Decl;
   class DeclAccessPair;
   class DeclContext;
@@ -178,6 +180,11 @@ namespace sema {
   class LambdaScopeInfo;
   class PossiblyUnreachableDiag;
   class TemplateDeductionInfo;
+  class TemplateInstantiationProfiler;
+}
+
+namespace analyze_format_string {
+  class ParsedFormatString;
 }
 
 // FIXME: No way to easily map from TemplateTypeParmTypes to
@@ -363,6 +370,17 @@ public:
     OpaqueParser = P;
   }
 
+  /// \brief The inline member functions which are used, but whose bodies
+  /// are still to be parsed by \c LateTemplateParser, as with
+  /// -flazy-inline-method-parsing.
+  SmallVector<FunctionDecl *, 8> PendingLateParsedFunctions;
+
+  /// \brief Parse the bodies of the functions in
+  /// \c PendingLateParsedFunctions.
+  ///
+  /// \returns true if any function body was parsed.
+  bool PerformPendingLateParsing();
+
   class DelayedDiagnostics;
 
   class DelayedDiagnosticsState {
@@ -672,6 +690,121 @@ public:
   /// for C++ records.
   llvm::FoldingSet<SpecialMemberOverloadResult> SpecialMemberCache;
 
+  /// \brief The result of substituting template arguments into a type.
+  class SubstTypeCacheEntry : public llvm::FastFoldingSetNode {
+    QualType Result;
+
+  public:
+    SubstTypeCacheEntry(const llvm::FoldingSetNodeID &ID, QualType Result)
+      : FastFoldingSetNode(ID), Result(Result)
+    {}
+
+    QualType getResult() const { return Result; }
+  };
+
+  /// \brief A cache of the types produced by SubstType, keyed by the type, the
+  /// canonical template arguments and the context of the substitution.
+  llvm::FoldingSet<SubstTypeCacheEntry> SubstTypeCache;
+
+  /// \brief An implicit conversion sequence computed for an argument during
+  /// overload resolution.
+  class ConversionSequenceCacheEntry : public llvm::FastFoldingSetNode {
+    ImplicitConversionSequence *Conversion;
+
+  public:
+    ConversionSequenceCacheEntry(const llvm::FoldingSetNodeID &ID,
+                                 ImplicitConversionSequence *Conversion)
+      : FastFoldingSetNode(ID), Conversion(Conversion)
+    {}
+
+    const ImplicitConversionSequence &getConversion() const {
+      return *Conversion;
+    }
+  };
+
+  /// \brief A cache of the implicit conversion sequences computed during
+  /// overload resolution, keyed by the types and value category of the
+  /// argument and the parameter type.
+  llvm::FoldingSet<ConversionSequenceCacheEntry> ConversionSequenceCache;
+
+  /// \brief The namespaces and classes associated with the arguments of a
+  /// call, as found by FindAssociatedClassesAndNamespaces.
+  class AssociatedSetsCacheEntry : public llvm::FastFoldingSetNode {
+    DeclContext **Namespaces;
+    CXXRecordDecl **Classes;
+    unsigned NumNamespaces, NumClasses;
+
+  public:
+    AssociatedSetsCacheEntry(const llvm::FoldingSetNodeID &ID,
+                             DeclContext **Namespaces, unsigned NumNamespaces,
+                             CXXRecordDecl **Classes, unsigned NumClasses)
+      : FastFoldingSetNode(ID), Namespaces(Namespaces), Classes(Classes),
+        NumNamespaces(NumNamespaces), NumClasses(NumClasses)
+    {}
+
+    ArrayRef<DeclContext *> getNamespaces() const {
+      return ArrayRef<DeclContext *>(Namespaces, NumNamespaces);
+    }
+    ArrayRef<CXXRecordDecl *> getClasses() const {
+      return ArrayRef<CXXRecordDecl *>(Classes, NumClasses);
+    }
+  };
+
+  /// \brief A cache of the associated namespaces and classes of calls, keyed
+  /// by the canonical types of the arguments.
+  llvm::FoldingSet<AssociatedSetsCacheEntry> AssociatedSetsCache;
+
+  /// \brief A delayed access check that found the accessed entity
+  /// accessible, keyed by the context of the check and the entity.
+  class SucceededDelayedAccess : public llvm::FoldingSetNode {
+    const DeclContext *Ctx;
+    const NamedDecl *Target;
+    const CXXRecordDecl *NamingClass;
+    void *BaseObjectType;
+    unsigned Access : 2;
+    unsigned IsMember : 1;
+
+  public:
+    SucceededDelayedAccess(const DeclContext *Ctx, const NamedDecl *Target,
+                           const CXXRecordDecl *NamingClass,
+                           QualType BaseObjectType, AccessSpecifier Access,
+                           bool IsMember)
+      : Ctx(Ctx), Target(Target), NamingClass(NamingClass),
+        BaseObjectType(BaseObjectType.getAsOpaquePtr()), Access(Access),
+        IsMember(IsMember)
+    {}
+
+    void Profile(llvm::FoldingSetNodeID &ID) const {
+      Profile(ID, Ctx, Target, NamingClass,
+              QualType::getFromOpaquePtr(BaseObjectType),
+              AccessSpecifier(Access), IsMember);
+    }
+
+    static void Profile(llvm::FoldingSetNodeID &ID, const DeclContext *Ctx,
+                        const NamedDecl *Target,
+                        const CXXRecordDecl *NamingClass,
+                        QualType BaseObjectType, AccessSpecifier Access,
+                        bool IsMember) {
+      ID.AddPointer(Ctx);
+      ID.AddPointer(Target);
+      ID.AddPointer(NamingClass);
+      ID.AddPointer(BaseObjectType.getAsOpaquePtr());
+      ID.AddInteger(Access);
+      ID.AddBoolean(IsMember);
+    }
+  };
+
+  /// \brief The delayed access checks that succeeded while declarations are
+  /// being parsed, so that an entity named several times in a declaration,
+  /// or in the decl-spec shared by the declarators of a group, has its
+  /// access computed once.  Access that has been granted is never revoked,
+  /// so the entries stay valid until no declaration is being parsed any
+  /// more; PopParsingDeclaration then recycles them.
+  llvm::FoldingSet<SucceededDelayedAccess> SucceededDelayedAccesses;
+
+  /// \brief The storage of the entries of SucceededDelayedAccesses.
+  llvm::BumpPtrAllocator SucceededDelayedAccessAlloc;
+
   /// \brief The kind of translation unit we are processing.
   ///
   /// When we're processing a complete translation unit, Sema will perform
@@ -686,6 +819,44 @@ public:
   /// \brief The number of SFINAE diagnostics that have been trapped.
   unsigned NumSFINAEErrors;
 
+  /// \brief The number of diagnostics that have been emitted, including the
+  /// ones suppressed by SFINAE.
+  unsigned NumDiagnosticsEmitted;
+
+  /// \brief The number of substitutions into types answered from
+  /// SubstTypeCache.
+  unsigned NumSubstTypeCacheHits;
+
+  /// \brief The number of implicit conversion sequences answered from
+  /// ConversionSequenceCache.
+  unsigned NumConversionSequenceCacheHits;
+
+  /// \brief The number of associated namespace and class sets answered from
+  /// AssociatedSetsCache.
+  unsigned NumAssociatedSetsCacheHits;
+
+  /// \brief The printf and scanf format strings parsed so far, keyed by
+  /// their contents, so that each is only parsed once.
+  llvm::StringMap<analyze_format_string::ParsedFormatString *>
+    ParsedPrintfStrings, ParsedScanfStrings;
+
+  /// \brief The number of format strings checked without being parsed again.
+  unsigned NumParsedFormatStringsReused;
+
+  /// \brief The number of copy-initializations, and how many of them
+  /// PerformTrivialCopyInitialization did without an initialization
+  /// sequence.
+  unsigned NumCopyInitializations, NumTrivialCopyInitializations;
+
+  /// \brief The number of unqualified lookups that walked the identifier
+  /// resolver's chain for a name, and the number of declarations on those
+  /// chains that they looked at.
+  unsigned NumIdResolverLookups, NumIdResolverDeclsVisited;
+
+  /// \brief The number of delayed access checks answered from
+  /// SucceededDelayedAccesses.
+  unsigned NumDelayedAccessChecksReused;
+
   typedef llvm::DenseMap<ParmVarDecl *, SmallVector<ParmVarDecl *, 1> >
     UnparsedDefaultArgInstantiationsMap;
 
@@ -883,6 +1054,12 @@ public:
   TypeSourceInfo *GetTypeSourceInfoForDeclarator(Declarator &D, QualType T,
                                                TypeSourceInfo *ReturnTypeInfo);
 
+  /// \brief With -fcompact-system-type-locs, the type source information
+  /// shared by the declarations of a system header that have the same
+  /// type, keyed by the type and the file.
+  llvm::DenseMap<std::pair<void *, FileID>, TypeSourceInfo *>
+    SharedSystemTypeSourceInfos;
+
   /// \brief Package the given type and TSI into a ParsedType.
   ParsedType CreateParsedType(QualType T, TypeSourceInfo *TInfo);
   DeclarationNameInfo GetNameForDeclarator(Declarator &D);
@@ -1324,6 +1501,7 @@ public:
   void ActOnFinishKNRParamDeclarations(Scope *S, Declarator &D,
                                        SourceLocation LocAfterDecls);
   void CheckForFunctionRedefinition(FunctionDecl *FD);
+  bool canReleaseFunctionBody(const FunctionDecl *FD) const;
   Decl *ActOnStartOfFunctionDef(Scope *S, Declarator &D);
   Decl *ActOnStartOfFunctionDef(Scope *S, Decl *D);
   void ActOnStartOfObjCMethodDef(Scope *S, Decl *D);
@@ -1707,6 +1885,14 @@ public:
 
   bool CanPerformCopyInitialization(const InitializedEntity &Entity,
                                     ExprResult Init);
+
+  /// \brief Perform a copy-initialization of a scalar from an expression of
+  /// the same type without building an InitializationSequence.
+  ///
+  /// \returns the converted initializer, or an empty result when the
+  /// initialization needs an InitializationSequence.
+  ExprResult PerformTrivialCopyInitialization(const InitializedEntity &Entity,
+                                              Expr *Init);
   ExprResult PerformCopyInitialization(const InitializedEntity &Entity,
                                        SourceLocation EqualLoc,
                                        ExprResult Init,
@@ -5569,6 +5755,25 @@ public:
   /// therefore, should not be counted as part of the instantiation depth.
   unsigned NonInstantiationEntries;
 
+  /// \brief Records the cost of each template instantiation, if enabled by
+  /// -ftemplate-profile or -ftemplate-profile-trace.
+  OwningPtr<sema::TemplateInstantiationProfiler> InstantiationProfiler;
+
+  /// \brief Start recording the cost of each template instantiation.
+  void enableInstantiationProfiler();
+
+  sema::TemplateInstantiationProfiler *getInstantiationProfiler() const {
+    return InstantiationProfiler.get();
+  }
+
+  /// \brief The profile which records the time spent instantiating
+  /// templates, if enabled by -compile-profile-file.
+  CompilationProfile *CompileProfile;
+
+  void setCompilationProfile(CompilationProfile *Profile) {
+    CompileProfile = Profile;
+  }
+
   /// \brief The last template from which a template instantiation
   /// error or warning was produced.
   ///
@@ -5793,6 +5998,25 @@ public:
   /// string represents a keyword.
   UnqualifiedTyposCorrectedMap UnqualifiedTyposCorrected;
 
+  /// \brief The names of the identifiers known to the external identifier
+  /// source, indexed by their length, which typo correction considers.
+  ///
+  /// Walking the identifier tables of the AST files is expensive, so this is
+  /// built by the first typo correction that needs it and only rebuilt when
+  /// the generation of the external identifiers changes.
+  std::vector<std::vector<StringRef> > ExternalTypoCandidates;
+
+  /// \brief Whether \c ExternalTypoCandidates has been built.
+  bool LoadedExternalTypoCandidates;
+
+  /// \brief The generation of the external identifiers that
+  /// \c ExternalTypoCandidates was built from.
+  unsigned ExternalTypoCandidatesGeneration;
+
+  /// \brief Retrieve the names of the external identifiers whose length is
+  /// \p Length, for typo correction.
+  ArrayRef<StringRef> getExternalTypoCandidates(unsigned Length);
+
   /// \brief Worker object for performing CFG-based warnings.
   sema::AnalysisBasedWarnings AnalysisWarnings;
 
@@ -7108,6 +7332,7 @@ public:
 
 private:
   bool SemaBuiltinPrefetch(CallExpr *TheCall);
+  bool SemaBuiltinAssumeAligned(CallExpr *TheCall);
   bool SemaBuiltinObjectSize(CallExpr *TheCall);
   bool SemaBuiltinLongjmp(CallExpr *TheCall);
   ExprResult SemaBuiltinAtomicOverloaded(ExprResult TheCallResult);
@@ -7148,6 +7373,11 @@ private:
                          FormatStringType Type, bool inFunctionCall,
                          VariadicCallType CallType);
 
+  const analyze_format_string::ParsedFormatString &
+  getParsedFormatString(
+      llvm::StringMap<analyze_format_string::ParsedFormatString *> &Parsed,
+      StringRef Str, bool IsScanf);
+
   bool CheckFormatArguments(const FormatAttr *Format, Expr **Args,
                             unsigned NumArgs, bool IsCXXMember,
                             VariadicCallType CallType,
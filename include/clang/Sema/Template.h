@@ -109,6 +109,14 @@ namespace clang {
     const ArgList &getInnermost() const { 
       return TemplateArgumentLists.front(); 
     }
+
+    /// \brief Add the canonical form of these template argument lists to
+    /// \p ID.
+    void Profile(llvm::FoldingSetNodeID &ID, ASTContext &Context) const;
+
+    /// \brief Count the template arguments, counting each element of an
+    /// argument pack.
+    unsigned getNumExpandedArguments() const;
   };
   
   /// \brief The context in which partial ordering of function templates occurs.
@@ -0,0 +1,101 @@
+//===- TemplateInstantiationProfiler.h - Instantiation costs ----*- C++ -*-===//
+//
+//                     The LLVM Compiler Infrastructure
+//
+// This file is distributed under the University of Illinois Open Source
+// License. See LICENSE.TXT for details.
+//
+//===----------------------------------------------------------------------===//
+//
+// This file defines TemplateInstantiationProfiler, which measures the time
+// and AST memory Sema spends instantiating each template specialization.
+//
+//===----------------------------------------------------------------------===//
+
+#ifndef LLVM_CLANG_SEMA_TEMPLATE_INSTANTIATION_PROFILER_H
+#define LLVM_CLANG_SEMA_TEMPLATE_INSTANTIATION_PROFILER_H
+
+#include "clang/Basic/LLVM.h"
+#include "clang/Basic/SourceLocation.h"
+#include "llvm/ADT/DenseMap.h"
+#include "llvm/Support/DataTypes.h"
+#include <vector>
+
+namespace clang {
+
+class ASTContext;
+class Decl;
+
+namespace sema {
+
+/// TemplateInstantiationProfiler - Records every instantiation of a template
+/// specialization or of a member of one, as enabled by -ftemplate-profile
+/// and -ftemplate-profile-trace.
+///
+/// The self time and memory of an instantiation exclude those of the
+/// instantiations nested within it. Memory is the memory allocated for the
+/// AST, which is where instantiation allocates nearly everything.
+class TemplateInstantiationProfiler {
+  ASTContext &Context;
+
+  /// \brief Time and memory, with and without the nested instantiations.
+  struct Cost {
+    uint64_t TotalTime, SelfTime;
+    uint64_t TotalBytes, SelfBytes;
+    unsigned Count;
+
+    Cost() : TotalTime(0), SelfTime(0), TotalBytes(0), SelfBytes(0),
+             Count(0) {}
+  };
+
+  /// \brief An instantiation, in the order it finished.
+  struct Event {
+    const Decl *Specialization;
+    SourceLocation PointOfInstantiation;
+    uint64_t Start, Duration;
+    uint64_t Bytes;
+  };
+
+  /// \brief An instantiation which has not finished yet.
+  struct ActiveInstantiation {
+    const Decl *Specialization;
+    SourceLocation PointOfInstantiation;
+    uint64_t Start, StartBytes;
+    uint64_t NestedTime, NestedBytes;
+  };
+
+  SmallVector<ActiveInstantiation, 16> Active;
+  std::vector<Event> Events;
+
+  llvm::DenseMap<const Decl *, Cost> BySpecialization;
+
+  /// \brief The costs by the raw encoding of the expansion location of the
+  /// point of instantiation.
+  llvm::DenseMap<unsigned, Cost> ByLocation;
+
+  /// \brief When the profiler was created, in nanoseconds.
+  uint64_t StartTime;
+
+public:
+  explicit TemplateInstantiationProfiler(ASTContext &Context);
+
+  /// \brief Note that Sema started instantiating \p Specialization.
+  void startInstantiation(const Decl *Specialization,
+                          SourceLocation PointOfInstantiation);
+
+  /// \brief Note that Sema finished the most recently started instantiation.
+  void finishInstantiation();
+
+  /// \brief Print the costs by specialization and by point of instantiation,
+  /// most expensive first.
+  void printReport(raw_ostream &OS) const;
+
+  /// \brief Write the instantiations as complete events in the Trace Event
+  /// JSON format, which chrome://tracing can display.
+  void printTraceJSON(raw_ostream &OS) const;
+};
+
+} // end namespace sema
+} // end namespace clang
+
+#endif
@@ -32,10 +32,10 @@ namespace clang {
     /// designed for the previous version could not support reading
     /// the new version), this number should be increased.
     ///
-    /// Version 4 of AST files also requires that the version control branch and
+    /// Version 5 of AST files also requires that the version control branch and
     /// revision match exactly, since there is no backward compatibility of
     /// AST files at this time.
-    const unsigned VERSION_MAJOR = 4;
+    const unsigned VERSION_MAJOR = 5;
 
     /// \brief AST file minor version number supported by this version of
     /// Clang.
@@ -472,7 +472,21 @@ namespace clang {
       ///
       /// This array can only be interpreted properly using the Objective-C
       /// categories map.
-      OBJC_CATEGORIES = 54
+      OBJC_CATEGORIES = 54,
+
+      /// \brief Record code for the filter of the identifiers stored in the
+      /// IDENTIFIER_TABLE record.
+      ///
+      /// The blob is a bit array with two bits set for each identifier, as
+      /// computed by getIdentifierFilterBits().  An identifier whose bits are
+      /// not both set is not in the identifier table, so lookups of it can
+      /// skip the AST file without probing its hash table.
+      IDENTIFIER_FILTER = 55,
+
+      /// \brief Record code for the layouts of the records defined in the
+      /// AST file, so that the translation units which load it need not
+      /// lay them out again.
+      RECORD_LAYOUTS = 56
     };
 
     /// \brief Record types used within a source manager block.
@@ -490,7 +504,16 @@ namespace clang {
       SM_SLOC_BUFFER_BLOB = 3,
       /// \brief Describes a source location entry (SLocEntry) for a
       /// macro expansion.
-      SM_SLOC_EXPANSION_ENTRY = 4
+      SM_SLOC_EXPANSION_ENTRY = 4,
+      /// \brief Describes a blob that contains the offsets of the starts of
+      /// the lines of a file, as little-endian 32-bit values. This kind of
+      /// record always directly follows a SM_SLOC_FILE_ENTRY record.
+      SM_SLOC_LINE_TABLE = 5,
+      /// \brief Stands in for a SM_SLOC_BUFFER_BLOB or SM_SLOC_LINE_TABLE
+      /// record whose blob was compressed with zlib. The record holds the
+      /// code of the record it replaces and the uncompressed size of the
+      /// blob.
+      SM_SLOC_COMPRESSED_BLOB = 6
     };
 
     /// \brief Record types used within a preprocessor block.
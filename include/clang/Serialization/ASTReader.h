@@ -431,6 +431,14 @@ private:
   /// global method pool for this selector.
   llvm::DenseMap<Selector, unsigned> SelectorGeneration;
 
+  /// \brief The loaded modules whose method pool has an entry with a given
+  /// selector hash, indexed by that hash (with its top bit cleared, so that
+  /// it is never one of the DenseMap's special keys).
+  ///
+  /// This lets ReadMethodPool() probe only the method pools that may hold a
+  /// selector, rather than the hash tables of every loaded module.
+  llvm::DenseMap<unsigned, SmallVector<ModuleFile *, 2> > SelectorIndex;
+
   /// \brief Mapping from identifiers that represent macros whose definitions
   /// have not yet been deserialized to the global offset where the macro
   /// record resides.
@@ -523,6 +531,11 @@ private:
   /// at the end of the TU, in which case it directs CodeGen to emit the VTable.
   SmallVector<uint64_t, 16> DynamicClasses;
 
+  /// \brief The position of the layouts of record definitions, by the ID of
+  /// the record, within the RecordLayouts of their module file.
+  llvm::DenseMap<serialization::DeclID, std::pair<ModuleFile *, unsigned> >
+    RecordLayoutOffsets;
+
   /// \brief The IDs of the declarations Sema stores directly.
   ///
   /// Sema tracks a few important decls, such as namespace std, directly.
@@ -593,6 +606,10 @@ private:
   /// indicates how many separate module file load operations have occurred.
   unsigned CurrentGeneration;
 
+  /// \brief The number of modules, in load order, whose method pools have
+  /// been added to SelectorIndex.
+  unsigned NumModulesInSelectorIndex;
+
   typedef llvm::DenseMap<unsigned, SwitchCase *> SwitchCaseMapTy;
   /// \brief Mapping from switch-case IDs in the chain to switch-case statements
   ///
@@ -621,12 +638,31 @@ private:
   /// in the chain.
   unsigned TotalNumStatements;
 
+  /// \brief The number of function bodies de-serialized from the chain.
+  unsigned NumFunctionBodiesRead;
+
+  /// \brief The total number of function bodies stored in the chain.
+  unsigned TotalNumFunctionBodies;
+
   /// \brief The number of macros de-serialized from the chain.
   unsigned NumMacrosRead;
 
   /// \brief The total number of macros stored in the chain.
   unsigned TotalNumMacros;
 
+  /// \brief The number of macros de-serialized because all of the macros of
+  /// the chain were walked, rather than because they were used.
+  unsigned NumMacrosReadInBulk;
+
+  /// \brief The number of record layouts de-serialized from the chain.
+  unsigned NumRecordLayoutsRead;
+
+  /// \brief The number of compressed source manager blobs that have been
+  /// decompressed, and their sizes before and after decompression.
+  unsigned NumSLocBlobsDecompressed;
+  uint64_t NumCompressedSLocBlobBytes;
+  uint64_t NumDecompressedSLocBlobBytes;
+
   /// \brief The number of selectors that have been read.
   unsigned NumSelectorsRead;
 
@@ -640,6 +676,19 @@ private:
   /// \brief The total number of method pool entries in the selector table.
   unsigned TotalNumMethodPoolEntries;
 
+  /// \brief The number of times we have looked up a selector in the method
+  /// pool.
+  unsigned NumMethodPoolLookups;
+
+  /// \brief The number of times we have looked up an identifier by name in
+  /// the AST files.
+  unsigned NumIdentifierLookups;
+
+  /// \brief The number of declarations we have looked for an existing
+  /// declaration of the same entity to merge with, how many of those found
+  /// one, and how many were found through MergeCandidates.
+  unsigned NumMergeLookups, NumDeclsMerged, NumMergeCandidateHits;
+
   /// Number of lexical decl contexts read/total.
   unsigned NumLexicalDeclContextsRead, TotalLexicalDeclContexts;
 
@@ -738,6 +787,23 @@ private:
   /// the given canonical declaration.
   MergedDeclsMap::iterator
   combineStoredMergedDecls(Decl *Canon, serialization::GlobalDeclID CanonID);
+
+  /// \brief What identifies the entity declared by a named declaration in a
+  /// file context, for the purpose of merging it with declarations of the
+  /// same entity from other modules: the (primary) redeclaration context, the
+  /// name, the kind of declaration and a kind-specific signature, such as the
+  /// canonical type of a function.
+  typedef std::pair<std::pair<DeclContext *, DeclarationName>,
+                    std::pair<unsigned, void *> > MergeKey;
+
+  /// \brief A declaration of each entity that may have redeclarations to
+  /// merge with, indexed by the entity's MergeKey.
+  ///
+  /// This is filled with declarations that were either found by searching a
+  /// context for an existing entity or added to it because there was none,
+  /// so that declarations of the same entity loaded from other modules find
+  /// them without searching every declaration with their name again.
+  llvm::DenseMap<MergeKey, NamedDecl *> MergeCandidates;
   
   /// \brief Ready to load the previous declaration of the given Decl.
   void loadAndAttachPreviousDecl(Decl *D, serialization::DeclID ID);
@@ -770,6 +836,64 @@ private:
     ~ReadingKindTracker() { Reader.ReadingKind = PrevKind; }
   };
 
+  /// \brief The kinds of work whose time is measured when profiling
+  /// deserialization.
+  enum ProfileKind {
+    Profile_SLocEntry,
+    Profile_Type,
+    Profile_Decl,
+    Profile_Stmt,
+    Profile_Identifier,
+    Profile_IdentifierLookup,
+    Profile_Macro,
+    Profile_SelectorLookup,
+    Profile_DeclMerging,
+    Profile_Decompression,
+    NumProfileKinds
+  };
+
+  /// \brief Whether the time spent deserializing is measured.
+  bool ProfileDeserialization;
+
+  /// \brief The kind of work being measured, or -1 if there is none.
+  int CurrentProfileKind;
+
+  /// \brief When the time of the current kind of work started to be
+  /// measured, in nanoseconds.
+  uint64_t CurrentProfileStart;
+
+  /// \brief The time spent in each kind of work, in nanoseconds.  Work that
+  /// nests within another kind, such as a type read while reading a
+  /// declaration, is only counted for the innermost kind.
+  uint64_t ProfileTimes[NumProfileKinds];
+
+  /// \brief The number of times each kind of work was measured.
+  unsigned ProfileCounts[NumProfileKinds];
+
+  int enterProfileKind(ProfileKind Kind);
+  void leaveProfileKind(int PrevKind);
+
+  /// \brief RAII object that measures the time spent in one kind of work.
+  class ProfileScope {
+    ASTReader &Reader;
+    int PrevKind;
+
+    ProfileScope(const ProfileScope&); // do not implement
+    ProfileScope &operator=(const ProfileScope&); // do not implement
+
+  public:
+    ProfileScope(ASTReader &Reader, ProfileKind Kind)
+      : Reader(Reader), PrevKind(-2) {
+      if (Reader.ProfileDeserialization)
+        PrevKind = Reader.enterProfileKind(Kind);
+    }
+
+    ~ProfileScope() {
+      if (PrevKind != -2)
+        Reader.leaveProfileKind(PrevKind);
+    }
+  };
+
   /// \brief All predefines buffers in the chain, to be treated as if
   /// concatenated.
   PCHPredefinesBlocks PCHPredefinesBuffers;
@@ -800,6 +924,19 @@ private:
   bool ParseLineTable(ModuleFile &F, SmallVectorImpl<uint64_t> &Record);
   ASTReadResult ReadSourceManagerBlock(ModuleFile &F);
   ASTReadResult ReadSLocEntryRecord(int ID);
+
+  /// \brief Read the blob record at the cursor of a source manager block,
+  /// decompressing its blob into \p Decompressed if it was compressed.
+  ///
+  /// \returns the code of the record, or of the record the compressed blob
+  /// stands in for; 0 if the blob could not be decompressed.
+  unsigned readSLocBlob(llvm::BitstreamCursor &Cursor, StringRef &Blob,
+                        SmallVectorImpl<char> &Decompressed);
+
+  /// \brief Read the SM_SLOC_BUFFER_BLOB record at the cursor into a new
+  /// buffer, or return null after reporting an error.
+  llvm::MemoryBuffer *readSLocBuffer(llvm::BitstreamCursor &Cursor,
+                                     StringRef Name);
   llvm::BitstreamCursor &SLocCursorForID(int ID);
   SourceLocation getImportLocation(ModuleFile *F);
   ASTReadResult ReadSubmoduleBlock(ModuleFile &F);
@@ -853,6 +990,10 @@ private:
 
   void finishPendingActions();
 
+  /// \brief Add the method pools of the modules loaded since the last call
+  /// to SelectorIndex.
+  void updateSelectorIndex();
+
   /// \brief Produce an error diagnostic and return true.
   ///
   /// This routine should only be used for fatal errors that have to
@@ -956,6 +1097,15 @@ public:
                                            FileManager &FileMgr,
                                            DiagnosticsEngine &Diags);
 
+  /// \brief Determine from the metadata and the input file records of an AST
+  /// file, without loading it, whether it was written by this version without
+  /// errors and none of the files it was built from changed since.
+  ///
+  /// AST files which import others, or whose paths are relative to a system
+  /// root, are conservatively considered out of date.
+  static bool isASTFileUpToDate(const std::string &ASTFileName,
+                                FileManager &FileMgr);
+
   /// \brief Returns the suggested contents of the predefines buffer,
   /// which contains a (typically-empty) subset of the predefines
   /// build prior to including the precompiled header.
@@ -1193,9 +1343,22 @@ public:
   /// the ASTConsumer.
   virtual void StartTranslationUnit(ASTConsumer *Consumer);
 
+  /// \brief Read the layout of a record definition which was laid out when
+  /// its AST file was built.
+  virtual const ASTRecordLayout *getRecordLayout(const RecordDecl *Record);
+
   /// \brief Print some statistics about AST usage.
   virtual void PrintStats();
 
+  /// \brief Print the statistics printed by PrintStats as a JSON object.
+  void PrintStatsJSON(raw_ostream &OS);
+
+  /// \brief Set whether the time spent deserializing each kind of record is
+  /// measured and reported by PrintStats.
+  void setProfileDeserialization(bool Profile) {
+    ProfileDeserialization = Profile;
+  }
+
   /// \brief Dump information about the AST reader to standard error.
   void dump();
 
@@ -1226,6 +1389,12 @@ public:
   /// in all loaded AST files.
   virtual IdentifierIterator *getIdentifiers() const;
 
+  /// \brief The identifiers in the loaded AST files only change when another
+  /// AST file is loaded.
+  virtual unsigned getIdentifiersGeneration() const {
+    return CurrentGeneration;
+  }
+
   /// \brief Load the contents of the global method pool for a given
   /// selector.
   virtual void ReadMethodPool(Selector Sel);
@@ -117,6 +117,17 @@ private:
   /// \brief Indicates that the AST contained compiler errors.
   bool ASTHasCompilerErrors;
 
+  /// \brief Whether the file buffers and line tables of the source manager
+  /// block are compressed.
+  bool CompressSLocBlobs;
+
+  /// \brief The abbreviation of compressed source manager blobs.
+  unsigned SLocCompressedBlobAbbrv;
+
+  /// \brief Whether the AST file must only depend on the inputs, and not on
+  /// the times, directories and stat results of the build.
+  bool Deterministic;
+
   /// \brief Stores a declaration or a type to be written to the AST file.
   class DeclOrType {
   public:
@@ -350,6 +361,9 @@ private:
   /// \brief The number of statements written to the AST file.
   unsigned NumStatements;
 
+  /// \brief The number of function bodies written to the AST file.
+  unsigned NumFunctionBodies;
+
   /// \brief The number of macros written to the AST file.
   unsigned NumMacros;
 
@@ -410,6 +424,7 @@ private:
   void WriteSourceManagerBlock(SourceManager &SourceMgr,
                                const Preprocessor &PP,
                                StringRef isysroot);
+  void EmitSLocBlob(unsigned Code, unsigned Abbrev, StringRef Blob);
   void WritePreprocessor(const Preprocessor &PP, bool IsModule);
   void WriteHeaderSearch(const HeaderSearch &HS, StringRef isysroot);
   void WritePreprocessorDetail(PreprocessingRecord &PPRec);
@@ -417,6 +432,7 @@ private:
                                         
   void WritePragmaDiagnosticMappings(const DiagnosticsEngine &Diag);
   void WriteCXXBaseSpecifiersOffsets();
+  void WriteRecordLayouts(ASTContext &Context);
   void WriteType(QualType T);
   uint64_t WriteDeclContextLexicalBlock(ASTContext &Context, DeclContext *DC);
   uint64_t WriteDeclContextVisibleBlock(ASTContext &Context, DeclContext *DC);
@@ -465,6 +481,22 @@ public:
   ASTWriter(llvm::BitstreamWriter &Stream);
   ~ASTWriter();
 
+  /// \brief Compress the file buffers and line tables stored in the source
+  /// manager block, when that makes them smaller.
+  ///
+  /// The blobs are decompressed when the reader loads their source location
+  /// entry. They are always written uncompressed if clang was built without
+  /// zlib.
+  void setCompressSLocBlobs(bool Compress) { CompressSLocBlobs = Compress; }
+
+  /// \brief Write the same AST file for the same inputs in every build.
+  ///
+  /// The modification times of the input files are replaced by hashes of
+  /// their contents, which the reader then validates instead, the stat
+  /// cache and the directory of the AST file are omitted, and the names of
+  /// the files inside the working directory are written relative to it.
+  void setDeterministic(bool Value) { Deterministic = Value; }
+
   /// \brief Write a precompiled header for the given semantic analysis.
   ///
   /// \param SemaRef a reference to the semantic analysis object that processed
@@ -727,6 +759,11 @@ class PCHGenerator : public SemaConsumer {
   llvm::BitstreamWriter Stream;
   ASTWriter Writer;
 
+  /// \brief The record definitions to lay out before writing the AST file.
+  SmallVector<const RecordDecl *, 16> RecordDefinitions;
+
+  void layOutRecordDefinitions(ASTContext &Ctx);
+
 protected:
   ASTWriter &getWriter() { return Writer; }
   const ASTWriter &getWriter() const { return Writer; }
@@ -734,9 +771,11 @@ protected:
 public:
   PCHGenerator(const Preprocessor &PP, StringRef OutputFile,
                clang::Module *Module,
-               StringRef isysroot, raw_ostream *Out);
+               StringRef isysroot, raw_ostream *Out,
+               bool CompressSLocBlobs = false, bool Deterministic = false);
   ~PCHGenerator();
   virtual void InitializeSema(Sema &S) { SemaPtr = &S; }
+  virtual void HandleTagDeclDefinition(TagDecl *D);
   virtual void HandleTranslationUnit(ASTContext &Ctx);
   virtual ASTMutationListener *GetASTMutationListener();
   virtual ASTDeserializationListener *GetASTDeserializationListener();
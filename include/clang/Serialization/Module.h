@@ -80,6 +80,9 @@ public:
 
   /// \brief The generation of which this module file is a part.
   unsigned Generation;
+
+  /// \brief The position of this module in the chain of its ModuleManager.
+  unsigned Index;
   
   /// \brief The memory buffer that stores the data associated with
   /// this AST file.
@@ -162,6 +165,13 @@ public:
   /// IdentifierHashTable.
   void *IdentifierLookupTable;
 
+  /// \brief Bit array of the identifiers in IdentifierLookupTable, or null if
+  /// the AST file has none.
+  const unsigned char *IdentifierFilter;
+
+  /// \brief The base-2 logarithm of the number of bits in IdentifierFilter.
+  unsigned IdentifierFilterLog2Bits;
+
   // === Macros ===
 
   /// \brief The cursor to the start of the preprocessor block, which stores
@@ -317,6 +327,10 @@ public:
   /// module.
   SmallVector<uint64_t, 1> ObjCCategories;
 
+  /// \brief The layouts of the records laid out when this module file was
+  /// built, as written by the RECORD_LAYOUTS record.
+  SmallVector<uint64_t, 1> RecordLayouts;
+
   // === Types ===
 
   /// \brief The number of types in this AST file.
@@ -17,6 +17,7 @@
 
 #include "clang/Serialization/Module.h"
 #include "clang/Basic/FileManager.h"
+#include "llvm/ADT/BitVector.h"
 #include "llvm/ADT/DenseMap.h"
 
 namespace clang { 
@@ -38,7 +39,39 @@ class ModuleManager {
   
   /// \brief A lookup of in-memory (virtual file) buffers
   llvm::DenseMap<const FileEntry *, llvm::MemoryBuffer *> InMemoryBuffers;
-  
+
+  /// \brief The modules in the order in which visit() visits them, or empty
+  /// when loading modules invalidated the order.
+  SmallVector<ModuleFile *, 4> VisitOrder;
+
+  /// \brief The state of a visitation, which is kept for the next ones
+  /// since lookups visit the modules over and over.
+  struct VisitState {
+    VisitState() : NextState(0) { }
+    ~VisitState() { delete NextState; }
+
+    /// \brief The modules the visitation skips, indexed by ModuleFile::Index.
+    llvm::BitVector Skipped;
+
+    /// \brief The stack of the walk that marks the modules to skip.
+    SmallVector<ModuleFile *, 4> Stack;
+
+    /// \brief The next unused state, for visitations nested in visitors.
+    VisitState *NextState;
+  };
+
+  /// \brief The unused visitation states.
+  VisitState *FirstVisitState;
+
+  /// \brief Compute the order in which visit() visits the modules.
+  void computeVisitOrder();
+
+  /// \brief Get a visitation state, with no modules to skip.
+  VisitState *allocateVisitState();
+
+  /// \brief Return a visitation state for reuse.
+  void returnVisitState(VisitState *State);
+
 public:
   typedef SmallVector<ModuleFile*, 2>::iterator ModuleIterator;
   typedef SmallVector<ModuleFile*, 2>::const_iterator ModuleConstIterator;
@@ -127,6 +160,9 @@ public:
   ///
   /// \param UserData User data associated with the visitor object, which
   /// will be passed along to the visitor.
+  ///
+  /// The order of the modules is computed once for all visitations until
+  /// more modules are loaded.
   void visit(bool (*Visitor)(ModuleFile &M, void *UserData), void *UserData);
   
   /// \brief Visit each of the modules with a depth-first traversal.
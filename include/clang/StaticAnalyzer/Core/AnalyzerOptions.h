@@ -102,6 +102,25 @@ enum CXXInlineableMemberKind {
   CIMK_Destructors
 };
 
+/// \brief Describes the order in which the analyzer explores the paths
+/// through a function.
+enum ExplorationStrategyKind {
+  /// Depth-first search.
+  ESK_DFS,
+
+  /// Breadth-first search.
+  ESK_BFS,
+
+  /// Breadth-first search over blocks, and depth-first search within them.
+  ESK_BFSBlockDFSContents,
+
+  /// Depth-first search that first continues the paths that enter a block
+  /// that no path has reached so far, and prefers the paths that visited the
+  /// block the fewest times.  This spends the node budget on covering more of
+  /// the function rather than on unrolling loops.
+  ESK_UnexploredFirst
+};
+
 
 class AnalyzerOptions : public llvm::RefCountedBase<AnalyzerOptions> {
 public:
@@ -121,6 +140,19 @@ public:
   AnalysisIPAMode IPAMode;
   
   std::string AnalyzeSpecificFunction;
+
+  /// \brief The file that function summaries are shared through with the
+  /// analysis of other translation units, if any.
+  std::string FunctionSummariesFile;
+
+  /// \brief The file the time and the nodes spent in each checker callback are
+  /// written to as JSON, if any.
+  std::string CheckerProfileFile;
+
+  /// \brief The file the function hashes and diagnostics of the translation
+  /// unit are kept in between runs, if any.  Functions that did not change
+  /// since the last run are not analyzed again.
+  std::string ResultCacheFile;
   
   /// \brief The maximum number of exploded nodes the analyzer will generate.
   unsigned MaxNodes;
@@ -184,6 +216,12 @@ private:
   /// If an option value is not provided, returns the given \p DefaultVal.
   bool getBooleanOption(StringRef Name, bool DefaultVal) const;
 
+  /// Interprets an option's string value as an integer.
+  ///
+  /// If an option value is not provided or is not a number, returns the given
+  /// \p DefaultVal.
+  unsigned getOptionAsInteger(StringRef Name, unsigned DefaultVal) const;
+
 public:
   /// Returns the option controlling which C++ member functions will be
   /// considered for inlining.
@@ -213,6 +251,52 @@ public:
   /// accepts the values "true" and "false".
   bool mayInlineTemplateFunctions() const;
 
+  /// Returns the order in which the analyzer explores the paths through a
+  /// function.
+  ///
+  /// This is controlled by the 'exploration-strategy' config option, which
+  /// accepts the values "dfs", "bfs", "bfs-block-dfs-contents" and
+  /// "unexplored-first".
+  ExplorationStrategyKind getExplorationStrategy() const;
+
+  /// Returns the number of statements the analyzer processes between two
+  /// passes reclaiming uninteresting ExplodedNodes when
+  /// -analyzer-eagerly-trim-egraph is used.
+  ///
+  /// This is controlled by the 'graph-trim-interval' config option.  The
+  /// default is 1000; a value of 0 is treated as 1.
+  unsigned getGraphTrimInterval() const;
+
+  /// Returns the number of blocks the analysis of a top-level function may
+  /// visit in the calls it inlines, or 0 for no limit.
+  ///
+  /// Each call is only inlined if the blocks visited in inlined calls so far
+  /// and the estimated cost of the callee fit in the budget, so once it runs
+  /// low only the cheapest callees are still inlined.
+  ///
+  /// This is controlled by the 'ipa-inlining-budget' config option.  The
+  /// default is 0.
+  unsigned getInliningBudget() const;
+
+  /// Returns the number of milliseconds the path-sensitive analysis of a
+  /// top-level function may take before it stops inlining calls, or 0 for no
+  /// limit.
+  ///
+  /// The analysis then goes on, evaluating the remaining calls conservatively,
+  /// and a remark names the function.
+  ///
+  /// This is controlled by the 'max-function-time' config option.  The
+  /// default is 0.
+  unsigned getTimeBudget() const;
+
+  /// Returns how many of the most recently used functions keep their CFGs
+  /// and other analyses from one top-level function to the next, to be
+  /// inlined again without rebuilding them.
+  ///
+  /// This is controlled by the 'max-retained-decl-contexts' config option.
+  /// The default is 0, which discards all of them.
+  unsigned getMaxRetainedDeclContexts() const;
+
 public:
   AnalyzerOptions() : CXXMemberInliningMode() {
     AnalysisStoreOpt = RegionStoreModel;
@@ -23,6 +23,7 @@
 #include "llvm/ADT/ilist.h"
 #include "llvm/ADT/ilist_node.h"
 #include "llvm/ADT/ImmutableSet.h"
+#include "llvm/ADT/OwningPtr.h"
 #include "llvm/ADT/DenseSet.h"
 #include "llvm/ADT/SmallSet.h"
 
@@ -442,6 +443,14 @@ private:
 // FIXME: Get rid of GRBugReporter.  It's the wrong abstraction.
 class GRBugReporter : public BugReporter {
   ExprEngine& Eng;
+
+  struct ReportGraph;
+
+  /// LastReportGraph - The single path to the error that was built for the
+  /// last equivalence class.  It is reused for the other
+  /// PathDiagnosticConsumers, which flush the same class right after.
+  OwningPtr<ReportGraph> LastReportGraph;
+
 public:
   GRBugReporter(BugReporterData& d, ExprEngine& eng)
     : BugReporter(d, GRBugReporterKind), Eng(eng) {}
@@ -116,7 +116,8 @@ class CheckerManager {
   const LangOptions LangOpts;
 
 public:
-  CheckerManager(const LangOptions &langOpts) : LangOpts(langOpts) { }
+  CheckerManager(const LangOptions &langOpts)
+    : LangOpts(langOpts), ProfileCheckers(false) { }
   ~CheckerManager();
 
   bool hasPathSensitiveCheckers() const;
@@ -129,6 +130,74 @@ public:
   typedef const void *CheckerTag;
   typedef CheckerFn<void ()> CheckerDtor;
 
+//===----------------------------------------------------------------------===//
+// Checker profiling
+//===----------------------------------------------------------------------===//
+
+  /// \brief The kinds of callbacks that are accounted separately when
+  /// profiling checkers.
+  enum CallbackKind {
+    CK_ASTDecl,
+    CK_ASTCodeBody,
+    CK_PreStmt,
+    CK_PostStmt,
+    CK_PreObjCMessage,
+    CK_PostObjCMessage,
+    CK_PreCall,
+    CK_PostCall,
+    CK_Location,
+    CK_Bind,
+    CK_EndAnalysis,
+    CK_EndPath,
+    CK_BranchCondition,
+    CK_LiveSymbols,
+    CK_DeadSymbols,
+    CK_RegionChanges,
+    CK_EvalAssume,
+    CK_EvalCall,
+    CK_InlineCall,
+    CK_EndOfTranslationUnit,
+    NumCallbackKinds
+  };
+
+  /// \brief What one kind of callback of one checker cost.
+  struct CallbackProfile {
+    unsigned Calls;
+    /// \brief The wall-clock time spent in the callback in nanoseconds,
+    /// including the callbacks of other checkers it triggered.
+    uint64_t Time;
+    /// \brief The number of exploded nodes the callback added.
+    unsigned Nodes;
+
+    CallbackProfile() : Calls(0), Time(0), Nodes(0) { }
+  };
+
+  /// \brief Start accounting the callbacks of every checker.
+  void enableCheckerProfiling() { ProfileCheckers = true; }
+
+  /// \brief Returns the profile of the callbacks of kind \p K of \p Checker,
+  /// or null if checkers are not profiled.
+  CallbackProfile *getCallbackProfile(const CheckerBase *Checker,
+                                      CallbackKind K) {
+    if (!ProfileCheckers)
+      return 0;
+    return getCallbackProfileImpl(Checker, K);
+  }
+
+  /// \brief Sets the name under which the checkers registered from now on are
+  /// reported.
+  void setCurrentCheckerName(StringRef Name) { CurrentCheckerName = Name; }
+
+  /// \brief Print the cost of every callback of every checker as a table.
+  void printCheckerProfile(raw_ostream &OS) const;
+
+  /// \brief Print the cost of every callback of every checker as JSON.
+  void printCheckerProfileJSON(raw_ostream &OS) const;
+
+  /// \brief A checker name and the profiles of its callbacks, indexed by
+  /// CallbackKind.
+  typedef std::pair<std::string, const CallbackProfile *> NamedCheckerProfile;
+
 //===----------------------------------------------------------------------===//
 // registerChecker
 //===----------------------------------------------------------------------===//
@@ -146,6 +215,7 @@ public:
     CHECKER *checker = new CHECKER();
     CheckerDtors.push_back(CheckerDtor(checker, destruct<CHECKER>));
     CHECKER::_register(checker, *this);
+    CheckerNames[checker] = CurrentCheckerName;
     ref = checker;
     return checker;
   }
@@ -497,6 +567,24 @@ private:
 
   std::vector<CheckerDtor> CheckerDtors;
 
+  /// The names the checkers were registered under.
+  llvm::DenseMap<const CheckerBase *, std::string> CheckerNames;
+  std::string CurrentCheckerName;
+
+  struct CheckerProfile {
+    CallbackProfile Callbacks[NumCallbackKinds];
+  };
+
+  bool ProfileCheckers;
+
+  /// The profiles of the checkers, allocated on first use so that they stay
+  /// put while callbacks are nested.
+  llvm::DenseMap<const CheckerBase *, CheckerProfile *> CheckerProfiles;
+
+  CallbackProfile *getCallbackProfileImpl(const CheckerBase *Checker,
+                                          CallbackKind K);
+  void collectCheckerProfiles(std::vector<NamedCheckerProfile> &Result) const;
+
   struct DeclCheckerInfo {
     CheckDeclFunc CheckFn;
     HandlesDeclFunc IsForDeclFn;
@@ -57,6 +57,13 @@ public:
   void ClearContexts() {
     AnaCtxMgr.clear();
   }
+
+  /// Discard the AnalysisDeclContexts, with their CFGs and other analyses,
+  /// beyond the most recently used ones that the options retain for the
+  /// calls of the next functions to inline.
+  void ReleaseContexts() {
+    AnaCtxMgr.releaseContexts(options.getMaxRetainedDeclContexts());
+  }
   
   AnalysisDeclContextManager& getAnalysisDeclContextManager() {
     return AnaCtxMgr;
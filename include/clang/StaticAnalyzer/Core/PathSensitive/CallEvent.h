@@ -857,23 +857,23 @@ public:
 /// memory blocks. The CallEvents created by CallEventManager are only valid
 /// for the lifetime of the OwnedCallEvent that holds them; right now these
 /// objects cannot be copied and ownership cannot be transferred.
+///
+/// Since every kind of CallEvent has the same size, a single list of the
+/// released blocks serves them all, and the blocks are never returned to the
+/// allocator; the analysis thus needs only as many blocks as there are
+/// CallEvents alive at once.
 class CallEventManager {
   friend class CallEvent;
 
   llvm::BumpPtrAllocator &Alloc;
-  SmallVector<void *, 8> Cache;
+  SmallVector<void *, 16> Cache;
 
   void reclaim(const void *Memory) {
     Cache.push_back(const_cast<void *>(Memory));
   }
 
   /// Returns memory that can be initialized as a CallEvent.
-  void *allocate() {
-    if (Cache.empty())
-      return Alloc.Allocate<FunctionCall>();
-    else
-      return Cache.pop_back_val();
-  }
+  void *allocate();
 
   template <typename T, typename Arg>
   T *create(Arg A, ProgramStateRef St, const LocationContext *LCtx) {
@@ -84,6 +84,19 @@ private:
   /// (This data is owned by AnalysisConsumer.)
   FunctionSummariesTy *FunctionSummaries;
 
+  /// The number of work items processed so far.
+  unsigned NumStepsExecuted;
+
+  /// The number of blocks visited in the frames of inlined calls so far.
+  unsigned NumInlinedBlockVisits;
+
+  /// The time, in milliseconds, at which the analysis exceeds its time
+  /// budget, or 0 if it has none.
+  uint64_t Deadline;
+
+  /// Whether the analysis ran past its deadline.
+  bool ExceededTimeBudget;
+
   void generateNode(const ProgramPoint &Loc,
                     ProgramStateRef State,
                     ExplodedNode *Pred);
@@ -103,13 +116,19 @@ private:
   ExplodedNode *generateCallExitBeginNode(ExplodedNode *N);
 
 public:
-  /// Construct a CoreEngine object to analyze the provided CFG.
+  /// Construct a CoreEngine object to analyze the provided CFG, exploring it
+  /// in the order of the given worklist, which the engine takes ownership of.
   CoreEngine(SubEngine& subengine,
-             FunctionSummariesTy *FS)
+             FunctionSummariesTy *FS,
+             WorkList *WL)
     : SubEng(subengine), G(new ExplodedGraph()),
-      WList(WorkList::makeDFS()),
+      WList(WL),
       BCounterFactory(G->getAllocator()),
-      FunctionSummaries(FS){}
+      FunctionSummaries(FS),
+      NumStepsExecuted(0),
+      NumInlinedBlockVisits(0),
+      Deadline(0),
+      ExceededTimeBudget(false) {}
 
   /// getGraph - Returns the exploded graph.
   ExplodedGraph& getGraph() { return *G.get(); }
@@ -148,6 +167,22 @@ public:
   
   WorkList *getWorkList() const { return WList.get(); }
 
+  /// Returns the number of work items processed so far, which is what the
+  /// node budget of the analysis bounds.
+  unsigned getNumStepsExecuted() const { return NumStepsExecuted; }
+
+  /// Returns the number of blocks visited in inlined calls so far, which is
+  /// what the inlining budget of the analysis bounds.
+  unsigned getNumInlinedBlockVisits() const { return NumInlinedBlockVisits; }
+
+  /// Give the analysis a time budget, starting now, of \p Milliseconds, or
+  /// none if 0.
+  void setTimeBudget(unsigned Milliseconds);
+
+  /// Returns true once the analysis has run past its time budget.  It then
+  /// continues in a cheaper mode rather than stopping.
+  bool hasExceededTimeBudget() const { return ExceededTimeBudget; }
+
   BlocksExhausted::const_iterator blocks_exhausted_begin() const {
     return blocksExhausted.begin();
   }
@@ -278,6 +278,10 @@ protected:
   
   /// A list of recently allocated nodes that can potentially be recycled.
   NodeVector ChangedNodes;
+
+  /// The number of nodes at the front of ChangedNodes that had no successor
+  /// yet in the last reclamation pass.  They are not kept for another pass.
+  unsigned NumPendingNodes;
   
   /// A list of nodes that can be reused.
   NodeVector FreeNodes;
@@ -288,6 +292,13 @@ protected:
   /// Counter to determine when to reclaim nodes.
   unsigned reclaimCounter;
 
+  /// The number of calls to reclaimRecentlyAllocatedNodes() between two
+  /// reclamation passes.
+  unsigned ReclaimInterval;
+
+  /// NumReclaimedNodes - The number of nodes that were collected.
+  unsigned NumReclaimedNodes;
+
 public:
 
   /// \brief Retrieve the node associated with a (Location,State) pair,
@@ -374,7 +385,15 @@ public:
 
   /// Enable tracking of recently allocated nodes for potential reclamation
   /// when calling reclaimRecentlyAllocatedNodes().
-  void enableNodeReclamation() { reclaimNodes = true; }
+  /// \p Interval is the number of such calls between two reclamation passes.
+  void enableNodeReclamation(unsigned Interval) {
+    assert(Interval > 0);
+    reclaimNodes = true;
+    ReclaimInterval = reclaimCounter = Interval;
+  }
+
+  /// Returns the number of nodes that were reclaimed so far.
+  unsigned getNumReclaimedNodes() const { return NumReclaimedNodes; }
 
   /// Reclaim "uninteresting" nodes created since the last time this method
   /// was called.
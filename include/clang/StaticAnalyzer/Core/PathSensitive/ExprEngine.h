@@ -70,6 +70,18 @@ class ExprEngine : public SubEngine {
   ///  variables and symbols (as determined by a liveness analysis).
   ProgramStateRef CleanedState;
 
+  /// CleanedStateCacheKey - A state and the reference statement and location
+  ///  context it was cleaned for.
+  typedef std::pair<const ProgramState *,
+                    std::pair<const Stmt *, const LocationContext *> >
+    CleanedStateCacheKey;
+
+  /// CleanedStateCache - The states removeDead() cleaned without finding dead
+  ///  symbols, by the state they were computed from.  The first state of each
+  ///  entry keeps the key alive.
+  llvm::DenseMap<CleanedStateCacheKey,
+                 std::pair<ProgramStateRef, ProgramStateRef> > CleanedStateCache;
+
   /// currStmt - The current block-level statement.
   const Stmt *currStmt;
   unsigned int currStmtIdx;
@@ -497,6 +509,9 @@ private:
                     const ProgramPointTag *tag, bool isLoad);
 
   bool shouldInlineDecl(const Decl *D, ExplodedNode *Pred);
+
+  /// Estimate the number of blocks visited when inlining a call to \p D.
+  unsigned estimateInliningCost(const Decl *D, const CFG *CalleeCFG);
   bool inlineCall(const CallEvent &Call, const Decl *D, NodeBuilder &Bldr,
                   ExplodedNode *Pred, ProgramStateRef State);
 
@@ -19,8 +19,12 @@
 #include "llvm/ADT/DenseMap.h"
 #include "llvm/ADT/DenseSet.h"
 #include "llvm/ADT/BitVector.h"
+#include "llvm/ADT/OwningPtr.h"
+#include "llvm/ADT/StringSet.h"
 
 namespace clang {
+class MangleContext;
+
 namespace ento {
 typedef std::deque<Decl*> SetOfDecls;
 typedef llvm::DenseSet<const Decl*> SetOfConstDecls;
@@ -37,18 +41,42 @@ class FunctionSummariesTy {
     /// Marks the IDs of the basic blocks visited during the analyzes.
     llvm::BitVector VisitedBasicBlocks;
 
+    /// The number of times the function was inlined.
+    unsigned TimesInlined;
+
+    /// The number of times its blocks were visited while it was inlined.
+    unsigned InlinedBlockVisits;
+
     FunctionSummary() :
       MayReachMaxBlockCount(false),
       TotalBasicBlocks(0),
-      VisitedBasicBlocks(0) {}
+      VisitedBasicBlocks(0),
+      TimesInlined(0),
+      InlinedBlockVisits(0) {}
   };
 
   typedef llvm::DenseMap<const Decl*, FunctionSummary*> MapTy;
   MapTy Map;
 
+  /// \brief The names of the functions that reached a max block count while
+  /// inlined in the translation units whose summaries were read.
+  llvm::StringSet<> ImportedMaxBlockCountNames;
+
+  /// \brief Caches whether a function is in ImportedMaxBlockCountNames.
+  llvm::DenseMap<const Decl*, bool> ImportedMaxBlockCountCache;
+
+  /// \brief Used to name functions in summary files.
+  OwningPtr<MangleContext> MangleCtx;
+
+  bool hasImportedReachedMaxBlockCount(const Decl *D);
+
 public:
   ~FunctionSummariesTy();
 
+  /// \brief Compute the name that identifies \p D in summary files.  Returns
+  /// false if \p D cannot be identified across translation units.
+  bool getSummaryName(const Decl *D, SmallVectorImpl<char> &Name);
+
   MapTy::iterator findOrInsertSummary(const Decl *D) {
     MapTy::iterator I = Map.find(D);
     if (I != Map.end())
@@ -66,12 +94,14 @@ public:
 
   bool hasReachedMaxBlockCount(const Decl* D) {
   MapTy::const_iterator I = Map.find(D);
-    if (I != Map.end())
-      return I->second->MayReachMaxBlockCount;
-    return false;
+    if (I != Map.end() && I->second->MayReachMaxBlockCount)
+      return true;
+    return !ImportedMaxBlockCountNames.empty() &&
+           hasImportedReachedMaxBlockCount(D);
   }
 
-  void markVisitedBasicBlock(unsigned ID, const Decl* D, unsigned TotalIDs) {
+  void markVisitedBasicBlock(unsigned ID, const Decl* D, unsigned TotalIDs,
+                             bool Inlined = false) {
     MapTy::iterator I = findOrInsertSummary(D);
     llvm::BitVector &Blocks = I->second->VisitedBasicBlocks;
     assert(ID < TotalIDs);
@@ -80,6 +110,22 @@ public:
       I->second->TotalBasicBlocks = TotalIDs;
     }
     Blocks[ID] = true;
+    if (Inlined)
+      ++I->second->InlinedBlockVisits;
+  }
+
+  void markInlined(const Decl *D) {
+    MapTy::iterator I = findOrInsertSummary(D);
+    ++I->second->TimesInlined;
+  }
+
+  /// Get the number of blocks visited, on average, each time the function was
+  /// inlined, or 0 if it never was.
+  unsigned getAverageInlinedBlockVisits(const Decl *D) {
+    MapTy::const_iterator I = Map.find(D);
+    if (I == Map.end() || I->second->TimesInlined == 0)
+      return 0;
+    return I->second->InlinedBlockVisits / I->second->TimesInlined;
   }
 
   unsigned getNumVisitedBasicBlocks(const Decl* D) {
@@ -101,6 +147,18 @@ public:
   unsigned getTotalNumBasicBlocks();
   unsigned getTotalNumVisitedBasicBlocks();
 
+  /// \brief Read the summaries written by other translation units to
+  /// \p Path.  A missing file has no summaries.
+  bool readSummaries(StringRef Path, std::string &ErrorStr);
+
+  /// \brief Append the summaries of this translation unit that are not yet
+  /// in \p Path to it, so that later translation units can read them.
+  ///
+  /// Only the functions with external linkage that reached a max block count
+  /// while inlined are recorded.  Other translation units do not try to
+  /// inline them, which is what this one would do after the first time.
+  bool writeSummaries(StringRef Path, std::string &ErrorStr);
+
 };
 
 }} // end clang ento namespaces
@@ -50,11 +50,18 @@ namespace ento {
     static lookup_type Lookup(data_type B, key_type K) {
       return B.lookup(K);
     }
+    // Leave the map alone if the operation would not change it: the factory
+    // would rebuild and recanonicalize the tree just to find the same one.
     static data_type Set(data_type B, key_type K, value_type E,context_type F){
+      if (const value_type *Old = B.lookup(K))
+        if (Info::isDataEqual(*Old, E))
+          return B;
       return F.add(B, K, E);
     }
 
     static data_type Remove(data_type B, key_type K, context_type F) {
+      if (!B.lookup(K))
+        return B;
       return F.remove(B, K);
     }
 
@@ -89,10 +96,14 @@ namespace ento {
     }
 
     static data_type Add(data_type B, key_type K, context_type F) {
+      if (B.contains(K))
+        return B;
       return F.add(B, K);
     }
 
     static data_type Remove(data_type B, key_type K, context_type F) {
+      if (!B.contains(K))
+        return B;
       return F.remove(B, K);
     }
 
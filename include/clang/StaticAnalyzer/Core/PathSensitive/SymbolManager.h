@@ -474,6 +474,21 @@ class SymbolManager {
   typedef llvm::DenseMap<SymbolRef, SymbolRefSmallVectorTy*> SymbolDependTy;
 
   DataSetTy DataSet;
+
+  /// Looks the binary symbolic expressions up by the identities of their
+  /// operands, their kind and opcode, and their type, which is cheaper than
+  /// profiling them for DataSet.  The integer operands are the uniqued ones
+  /// of BasicValueFactory, so equal expressions almost always share a key.
+  typedef std::pair<std::pair<const void *, const void *>,
+                    std::pair<unsigned, void *> > BinarySymExprKey;
+  typedef llvm::DenseMap<BinarySymExprKey, SymExpr *> BinarySymExprCacheTy;
+  BinarySymExprCacheTy BinarySymExprCache;
+
+  static BinarySymExprKey getBinarySymExprKey(SymExpr::Kind K,
+                                              const void *lhs,
+                                              BinaryOperator::Opcode op,
+                                              const void *rhs, QualType t);
+
   /// Stores the extra dependencies between symbols: the data should be kept
   /// alive as long as the key is live.
   SymbolDependTy SymbolDependencies;
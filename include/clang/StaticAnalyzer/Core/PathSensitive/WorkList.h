@@ -93,6 +93,7 @@ public:
   static WorkList *makeDFS();
   static WorkList *makeBFS();
   static WorkList *makeBFSBlockDFSContents();
+  static WorkList *makeUnexploredFirst();
 };
 
 } // end GR namespace
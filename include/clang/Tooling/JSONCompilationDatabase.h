@@ -20,9 +20,8 @@
 #include "llvm/ADT/OwningPtr.h"
 #include "llvm/ADT/StringMap.h"
 #include "llvm/ADT/StringRef.h"
+#include "llvm/Support/Allocator.h"
 #include "llvm/Support/MemoryBuffer.h"
-#include "llvm/Support/SourceMgr.h"
-#include "llvm/Support/YAMLParser.h"
 #include <string>
 #include <vector>
 
@@ -77,25 +76,42 @@ public:
 private:
   /// \brief Constructs a JSON compilation database on a memory buffer.
   JSONCompilationDatabase(llvm::MemoryBuffer *Database)
-    : Database(Database), YAMLStream(Database->getBuffer(), SM) {}
+    : Database(Database) {}
 
   /// \brief Parses the database file and creates the index.
   ///
+  /// Only the "file" values are decoded while indexing; the directory and
+  /// command of an entry are decoded when its commands are requested.
+  ///
   /// Returns whether parsing succeeded. Sets ErrorMessage if parsing
   /// failed.
   bool parse(std::string &ErrorMessage);
 
-  // Tuple (directory, commandline) where 'commandline' pointing to the
-  // corresponding nodes in the YAML stream.
-  typedef std::pair<llvm::yaml::ScalarNode*,
-                    llvm::yaml::ScalarNode*> CompileCommandRef;
+  /// \brief Indexes the database with a scanner over its buffer.
+  ///
+  /// The scanner only accepts plain JSON with the expected layout and skips
+  /// over directory and command values without decoding them. Returns false
+  /// for anything else, in which case the index is left empty.
+  bool scanJSON();
+
+  /// \brief Indexes the database with the YAML parser.
+  ///
+  /// Handles the inputs scanJSON() rejects and reports their errors.
+  bool parseYAML(std::string &ErrorMessage);
+
+  // Tuple (directory, commandline) where both are JSON string literals,
+  // quotes included, which are decoded when the commands are requested.
+  // They point into the database buffer, or into Strings for entries which
+  // went through the YAML parser.
+  typedef std::pair<StringRef, StringRef> CompileCommandRef;
 
   // Maps file paths to the compile command lines for that file.
   llvm::StringMap< std::vector<CompileCommandRef> > IndexByFile;
 
   llvm::OwningPtr<llvm::MemoryBuffer> Database;
-  llvm::SourceMgr SM;
-  llvm::yaml::Stream YAMLStream;
+
+  // Storage for the JSON literals of entries parsed by parseYAML().
+  llvm::BumpPtrAllocator Strings;
 };
 
 } // end namespace tooling
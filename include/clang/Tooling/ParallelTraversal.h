@@ -0,0 +1,76 @@
+//===--- ParallelTraversal.h - Traversing a TU on several threads -*- C++ -*-=//
+//
+//                     The LLVM Compiler Infrastructure
+//
+// This file is distributed under the University of Illinois Open Source
+// License. See LICENSE.TXT for details.
+//
+//===----------------------------------------------------------------------===//
+//
+//  This file defines helpers which split the traversal of a translation unit
+//  among several threads, for analyses that only read the AST.
+//
+//===----------------------------------------------------------------------===//
+
+#ifndef LLVM_CLANG_TOOLING_PARALLEL_TRAVERSAL_H
+#define LLVM_CLANG_TOOLING_PARALLEL_TRAVERSAL_H
+
+namespace clang {
+
+class ASTContext;
+class Decl;
+
+namespace tooling {
+
+/// \brief Calls \p Fn(UserData, Partition, D) for every top-level declaration
+/// \c D of the translation unit in \p Context, on up to \p NumPartitions
+/// threads.
+///
+/// The declarations are split into \p NumPartitions contiguous partitions of
+/// about the same source size, each of which is processed in order on one
+/// thread. No more threads are used than the hardware provides. While this runs, the AST context allows concurrent readers, see
+/// \c ASTContext::setConcurrentReaders, so \p Fn must not change the AST. If
+/// the AST is loaded lazily from an external source, the partitions are
+/// processed one after the other on the calling thread instead.
+///
+/// \returns False if \p Fn returned false, which stops the processing of the
+/// partition it was called for, but not of the others.
+bool forEachTopLevelDeclInParallel(ASTContext &Context, unsigned NumPartitions,
+                                   bool (*Fn)(void *UserData,
+                                              unsigned Partition, Decl *D),
+                                   void *UserData);
+
+namespace detail {
+template <typename VisitorT>
+bool traverseDeclWithVisitor(void *Visitors, unsigned Partition, Decl *D) {
+  return static_cast<VisitorT *>(Visitors)[Partition].TraverseDecl(D);
+}
+} // end namespace detail
+
+/// \brief Traverses the translation unit in \p Context with the
+/// RecursiveASTVisitors in \p Visitors, each of which traverses one partition
+/// of its top-level declarations on its own thread.
+///
+/// Since every visitor only sees a part of the translation unit, the results
+/// of the visitors have to be combined afterwards. The translation unit
+/// declaration itself is not visited. See forEachTopLevelDeclInParallel() for
+/// the requirements on the visitors.
+///
+/// Example:
+/// \code
+/// std::vector<CountingVisitor> Visitors(4);
+/// traverseTranslationUnitInParallel(Context, &Visitors[0], Visitors.size());
+/// \endcode
+template <typename VisitorT>
+bool traverseTranslationUnitInParallel(ASTContext &Context,
+                                       VisitorT *Visitors,
+                                       unsigned NumVisitors) {
+  return forEachTopLevelDeclInParallel(
+    Context, NumVisitors, &detail::traverseDeclWithVisitor<VisitorT>,
+    Visitors);
+}
+
+} // end namespace tooling
+} // end namespace clang
+
+#endif // LLVM_CLANG_TOOLING_PARALLEL_TRAVERSAL_H
@@ -22,6 +22,7 @@
 #include "llvm/ADT/StringRef.h"
 #include "clang/Basic/SourceLocation.h"
 #include "clang/Tooling/Tooling.h"
+#include "llvm/Support/Mutex.h"
 #include <set>
 #include <string>
 
@@ -74,6 +75,7 @@ public:
   StringRef getFilePath() const { return FilePath; }
   unsigned getOffset() const { return Offset; }
   unsigned getLength() const { return Length; }
+  StringRef getReplacementText() const { return ReplacementText; }
   /// @}
 
   /// \brief Applies the replacement on the Rewriter.
@@ -111,6 +113,61 @@ typedef std::set<Replacement, Replacement::Less> Replacements;
 /// Apply operations.
 bool applyAllReplacements(Replacements &Replaces, Rewriter &Rewrite);
 
+/// \brief Applies replacements to the contents of a file in a single pass.
+///
+/// The replacements in [Begin, End) must all be for the file whose contents
+/// are \p Code, ordered by offset as they are in \c Replacements. A
+/// replacement which overlaps the replacement applied before it, or which
+/// reaches past the end of \p Code, conflicts with it and is skipped.
+///
+/// \returns The number of replacements skipped.
+unsigned applyReplacementsToCode(StringRef Code,
+                                 Replacements::const_iterator Begin,
+                                 Replacements::const_iterator End,
+                                 std::string &Result);
+
+/// \brief Applies all replacements to the files on disk.
+///
+/// Unlike applyAllReplacements() followed by saveRewrittenFiles(), this does
+/// not go through a \c Rewriter: each file is read once, rewritten by
+/// applyReplacementsToCode() and written back. Up to \p NumThreads files are
+/// processed concurrently; 0 selects the number of hardware threads.
+///
+/// Returns false if a replacement was not applicable or was skipped; as with
+/// applyAllReplacements(), the other replacements are still applied. If
+/// \p Saved is not null, it is set to whether every file could be read and
+/// written. Every file is processed independently of the result for the
+/// others.
+bool applyAllReplacementsToFiles(const Replacements &Replaces,
+                                 unsigned NumThreads = 1, bool *Saved = 0);
+
+/// \brief Writes the replacements in a form readReplacements() reads back.
+///
+/// Each replacement is written as a line "R <offset> <length> <path size>
+/// <text size>", followed by the path, the replacement text and a newline.
+/// Since the replacements are independent of each other, the output of
+/// several runs can simply be concatenated.
+void writeReplacements(const Replacements &Replaces, raw_ostream &OS);
+
+/// \brief Adds the replacements written by writeReplacements() to
+/// \p Replaces.
+///
+/// Replacements already in \p Replaces, such as the replacements in a header
+/// which several translation units produced, are only kept once.
+///
+/// \returns False if \p Data is malformed; the replacements before the
+/// malformed one are still added.
+bool readReplacements(StringRef Data, Replacements &Replaces);
+
+/// \brief Adds the replacements written by a RefactoringTool to the file
+/// \p Path, see \c RefactoringTool::setReplacementsFile, to \p Replaces.
+///
+/// Reading the files of all shards of a run into the same \c Replacements
+/// merges them, and applyAllReplacementsToFiles() then applies them.
+///
+/// \returns False if the file cannot be read or is malformed.
+bool readReplacementsFile(StringRef Path, Replacements &Replaces);
+
 /// \brief A tool to run refactorings.
 ///
 /// This is a refactoring specific version of \see ClangTool.
@@ -128,12 +185,38 @@ public:
   /// processed.
   Replacements &getReplacements();
 
-  /// \see ClangTool::run.
+  /// \brief Adds a replacement to getReplacements().
+  ///
+  /// Unlike inserting into getReplacements() directly, this may be called
+  /// concurrently from the actions of a parallel run. Since Replacements is
+  /// ordered, the result does not depend on the order of the calls.
+  void addReplacement(const Replacement &NewReplacement);
+
+  /// \see ClangTool::setNumThreads.
+  ///
+  /// The same number of threads applies the replacements to the files.
+  void setNumThreads(unsigned NumThreads) { Tool.setNumThreads(NumThreads); }
+
+  /// \see ClangTool::setShard.
+  void setShard(unsigned Index, unsigned Count) { Tool.setShard(Index, Count); }
+
+  /// \brief Makes run() write the replacements to the file \p Path with
+  /// writeReplacements() instead of applying them.
+  ///
+  /// This lets the shards of a refactoring run on different machines; the
+  /// files they write are merged with readReplacementsFile() and applied at
+  /// once. An empty path, the default, applies the replacements.
+  void setReplacementsFile(StringRef Path) { ReplacementsFile = Path; }
+
+  /// \brief Runs the tool, then applies the replacements with
+  /// applyAllReplacementsToFiles(), or writes them to the replacements file.
   int run(FrontendActionFactory *ActionFactory);
 
 private:
   ClangTool Tool;
   Replacements Replace;
+  llvm::sys::Mutex ReplaceLock;
+  std::string ReplacementsFile;
 };
 
 template <typename Node>
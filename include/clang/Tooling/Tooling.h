@@ -133,6 +133,25 @@ class ToolInvocation {
   /// \param Content A null terminated buffer of the file's content.
   void mapVirtualFile(StringRef FilePath, StringRef Content);
 
+  /// \brief Sets the stream diagnostics are printed to.
+  ///
+  /// By default diagnostics are printed to llvm::errs().
+  void setDiagnosticOutput(raw_ostream &OS) { DiagnosticOutput = &OS; }
+
+  /// \brief Run the action over the AST file \p Path instead of parsing the
+  /// input of the command line.
+  ///
+  /// The AST file must have been saved from the same input, for example by
+  /// setOutputASTFile(). The action must support AST files.
+  void setInputASTFile(StringRef Path) { InputASTFile = Path; }
+
+  /// \brief Save the AST the action ran over to the AST file \p Path.
+  ///
+  /// Nothing is saved if there were errors, or if the file cannot be
+  /// written; neither makes the invocation fail. The action must not only
+  /// use the preprocessor.
+  void setOutputASTFile(StringRef Path) { OutputASTFile = Path; }
+
   /// \brief Run the clang invocation.
   ///
   /// \returns True if there were no errors during execution.
@@ -151,6 +170,9 @@ class ToolInvocation {
   FileManager *Files;
   // Maps <file name> -> <file content>.
   llvm::StringMap<StringRef> MappedFileContents;
+  raw_ostream *DiagnosticOutput;
+  std::string InputASTFile;
+  std::string OutputASTFile;
 };
 
 /// \brief Utility to run a FrontendAction over a set of files.
@@ -182,6 +204,57 @@ class ClangTool {
   /// \param Adjuster Command line arguments adjuster.
   void setArgumentsAdjuster(ArgumentsAdjuster *Adjuster);
 
+  /// \brief Sets the number of translation units processed concurrently.
+  ///
+  /// With more than one thread, every translation unit gets its own
+  /// FileManager, the working directory of its compile command is applied
+  /// through FileSystemOptions instead of chdir, and the output and
+  /// diagnostics of each translation unit are buffered and printed in the
+  /// order of the source paths once all of them are done. The actions created
+  /// by the factory then run concurrently and must not share unsynchronized
+  /// state; create() itself is never called concurrently.
+  ///
+  /// \param NumThreads The number of worker threads; 0 selects the number of
+  /// hardware threads. The default is 1, which processes the files serially.
+  void setNumThreads(unsigned NumThreads) { this->NumThreads = NumThreads; }
+  unsigned getNumThreads() const { return NumThreads; }
+
+  /// \brief Sets whether the FileManager of every translation unit consults
+  /// the process-wide SharedStatCache.
+  ///
+  /// This avoids re-stating the same headers and search directories for every
+  /// translation unit. Since misses are cached too, it should not be enabled
+  /// for tools that create headers while they run.
+  void setUseSharedStatCache(bool Use) { UseSharedStatCache = Use; }
+
+  /// \brief Sets a directory in which the AST of every translation unit is
+  /// saved, so that later runs over unchanged inputs load it instead of
+  /// parsing the files again.
+  ///
+  /// A saved AST is reused when the compile command and the contents of the
+  /// main file are the same and none of the included files changed. ASTs are
+  /// neither saved nor reused while virtual files are mapped, or for actions
+  /// which do not support AST files. An action run over a loaded AST sees the
+  /// whole translation unit in HandleTranslationUnit, but is not passed every
+  /// top-level declaration through HandleTopLevelDecl.
+  void setASTCacheDirectory(StringRef Directory);
+
+  /// \brief Restricts the tool to one of \p Count disjoint shards of the
+  /// source files, so that the shards can be processed on different machines.
+  ///
+  /// A file is assigned to a shard by a hash of its absolute path, so the
+  /// partition does not depend on the order of the source paths or on which
+  /// other files are processed. All compile commands of a file belong to its
+  /// shard.
+  ///
+  /// \param Index The shard to process, less than \p Count.
+  /// \param Count The number of shards; the default of 1 processes all files.
+  void setShard(unsigned Index, unsigned Count);
+
+  /// \brief Returns whether \p File, an absolute path, belongs to the shard
+  /// processed by the tool.
+  bool isInShard(StringRef File) const;
+
   /// Runs a frontend action over all files specified in the command line.
   ///
   /// \param ActionFactory Factory generating the frontend actions. The function
@@ -195,6 +268,9 @@ class ClangTool {
   FileManager &getFiles() { return Files; }
 
  private:
+  int runInParallel(FrontendActionFactory *ActionFactory,
+                    const std::string &MainExecutable);
+
   // We store compile commands as pair (file name, compile command).
   std::vector< std::pair<std::string, CompileCommand> > CompileCommands;
 
@@ -203,6 +279,12 @@ class ClangTool {
   std::vector< std::pair<StringRef, StringRef> > MappedFileContents;
 
   llvm::OwningPtr<ArgumentsAdjuster> ArgsAdjuster;
+
+  unsigned NumThreads;
+  bool UseSharedStatCache;
+  std::string ASTCacheDirectory;
+  unsigned ShardIndex;
+  unsigned ShardCount;
 };
 
 template <typename T>
@@ -17,9 +17,14 @@
 #include "clang/Rewrite/Core/Rewriter.h"
 #include "clang/Sema/SemaDiagnostic.h"
 #include "clang/Basic/DiagnosticCategories.h"
+#include "clang/Basic/Parallel.h"
 #include "clang/Lex/Preprocessor.h"
+#include "llvm/Support/FileSystem.h"
 #include "llvm/Support/MemoryBuffer.h"
+#include "llvm/ADT/StringMap.h"
 #include "llvm/ADT/Triple.h"
+#include <map>
+#include <set>
 using namespace clang;
 using namespace arcmt;
 
@@ -360,15 +365,14 @@ bool arcmt::checkForManualIssues(CompilerInvocation &origCI,
 // applyTransformations.
 //===----------------------------------------------------------------------===//
 
-static bool applyTransforms(CompilerInvocation &origCI,
-                            const FrontendInputFile &Input,
-                            DiagnosticConsumer *DiagClient,
-                            StringRef outputDir,
-                            bool emitPremigrationARCErrors,
-                            StringRef plistOut) {
-  if (!origCI.getLangOpts()->ObjC1)
-    return false;
-
+/// \brief Check \p Input for manual issues and, if there are none, run all the
+/// transformations over it in \p migration.
+static bool checkAndTransform(CompilerInvocation &origCI,
+                              const FrontendInputFile &Input,
+                              DiagnosticConsumer *DiagClient,
+                              bool emitPremigrationARCErrors,
+                              StringRef plistOut,
+                              MigrationProcess &migration) {
   LangOptions::GCMode OrigGCMode = origCI.getLangOpts()->getGC();
 
   // Make sure checking is successful first.
@@ -377,11 +381,6 @@ static bool applyTransforms(CompilerInvocation &origCI,
                                   emitPremigrationARCErrors, plistOut))
     return true;
 
-  CompilerInvocation CInvok(origCI);
-  CInvok.getFrontendOpts().Inputs.clear();
-  CInvok.getFrontendOpts().Inputs.push_back(Input);
-  
-  MigrationProcess migration(CInvok, DiagClient, outputDir);
   bool NoFinalizeRemoval = origCI.getMigratorOpts().NoFinalizeRemoval;
 
   std::vector<TransformFn> transforms = arcmt::getAllTransformations(OrigGCMode,
@@ -392,6 +391,32 @@ static bool applyTransforms(CompilerInvocation &origCI,
     bool err = migration.applyTransform(transforms[i]);
     if (err) return true;
   }
+  return false;
+}
+
+static CompilerInvocation
+createInvocationForInput(const CompilerInvocation &origCI,
+                         const FrontendInputFile &Input) {
+  CompilerInvocation CInvok(origCI);
+  CInvok.getFrontendOpts().Inputs.clear();
+  CInvok.getFrontendOpts().Inputs.push_back(Input);
+  return CInvok;
+}
+
+static bool applyTransforms(CompilerInvocation &origCI,
+                            const FrontendInputFile &Input,
+                            DiagnosticConsumer *DiagClient,
+                            StringRef outputDir,
+                            bool emitPremigrationARCErrors,
+                            StringRef plistOut) {
+  if (!origCI.getLangOpts()->ObjC1)
+    return false;
+
+  MigrationProcess migration(createInvocationForInput(origCI, Input),
+                             DiagClient, outputDir);
+  if (checkAndTransform(origCI, Input, DiagClient, emitPremigrationARCErrors,
+                        plistOut, migration))
+    return true;
 
   IntrusiveRefCntPtr<DiagnosticIDs> DiagID(new DiagnosticIDs());
   IntrusiveRefCntPtr<DiagnosticsEngine> Diags(
@@ -426,6 +451,283 @@ bool arcmt::migrateWithTemporaryFiles(CompilerInvocation &origCI,
                          outputDir, emitPremigrationARCErrors, plistOut);
 }
 
+//===----------------------------------------------------------------------===//
+// migrateWithTemporaryFilesInParallel.
+//===----------------------------------------------------------------------===//
+
+namespace {
+/// \brief One translation unit of migrateWithTemporaryFilesInParallel.
+struct ParallelMigrationTask {
+  CompilerInvocation *OrigCI;
+  FrontendInputFile Input;
+  /// \brief The buffered diagnostics of the migration.
+  std::string Diagnostics;
+  /// \brief The absolute path and the new contents of every file the
+  /// migration rewrote.
+  std::vector<std::pair<std::string, std::string> > Rewritten;
+  bool Failed;
+  /// \brief Whether the translation unit has to be migrated again on top of
+  /// the merged results.
+  bool Rerun;
+};
+
+/// \brief The state shared by the workers of
+/// migrateWithTemporaryFilesInParallel.
+struct ParallelMigrationRun {
+  StringRef OutputDir;
+  bool EmitPremigrationARCErrors;
+  std::vector<ParallelMigrationTask> Tasks;
+};
+
+/// \brief The replacement of a range of a file by new text.
+struct FileEdit {
+  unsigned Offset;
+  unsigned Length;
+  StringRef Text;
+
+  bool operator<(const FileEdit &RHS) const {
+    return Offset < RHS.Offset ||
+           (Offset == RHS.Offset && Length < RHS.Length);
+  }
+};
+}
+
+static void runParallelMigrationTask(void *UserData, unsigned Index) {
+  ParallelMigrationRun &Run = *static_cast<ParallelMigrationRun *>(UserData);
+  ParallelMigrationTask &Task = Run.Tasks[Index];
+
+  llvm::raw_string_ostream DiagOS(Task.Diagnostics);
+  TextDiagnosticPrinter DiagClient(DiagOS,
+                                   Task.OrigCI->getDiagnosticOpts());
+
+  // Only read the mappings of earlier runs; the merged results are written
+  // once every translation unit is done.
+  MigrationProcess migration(createInvocationForInput(*Task.OrigCI,
+                                                      Task.Input),
+                             &DiagClient, Run.OutputDir);
+  Task.Failed = checkAndTransform(*Task.OrigCI, Task.Input, &DiagClient,
+                                  Run.EmitPremigrationARCErrors, StringRef(),
+                                  migration);
+  if (!Task.Failed) {
+    // The files this migration rewrote are the ones kept in memory.
+    PreprocessorOptions PPOpts;
+    migration.getRemapper().applyMappings(PPOpts);
+    for (unsigned i = 0, e = PPOpts.RemappedFileBuffers.size(); i != e; ++i) {
+      SmallString<256> Path(PPOpts.RemappedFileBuffers[i].first);
+      llvm::sys::fs::make_absolute(Path);
+      StringRef Contents = PPOpts.RemappedFileBuffers[i].second->getBuffer();
+      Task.Rewritten.push_back(std::make_pair(Path.str().str(),
+                                              Contents.str()));
+    }
+  }
+  DiagOS.flush();
+}
+
+/// \brief Combine the different contents that several translation units gave
+/// to a file whose contents were \p Original.
+///
+/// Every version is reduced to the one range of \p Original that it replaces.
+/// Like EditedSource does for the commits of a single translation unit, the
+/// edits are only combined if they do not overlap.
+///
+/// \returns true if the edits conflict.
+static bool mergeRewrites(StringRef Original, ArrayRef<StringRef> Versions,
+                          std::string &Result) {
+  SmallVector<FileEdit, 4> Edits;
+  for (unsigned i = 0, e = Versions.size(); i != e; ++i) {
+    StringRef Version = Versions[i];
+    unsigned Prefix = 0;
+    unsigned Max = std::min(Original.size(), Version.size());
+    while (Prefix != Max && Original[Prefix] == Version[Prefix])
+      ++Prefix;
+    unsigned Suffix = 0;
+    Max -= Prefix;
+    while (Suffix != Max && Original[Original.size() - Suffix - 1] ==
+                                Version[Version.size() - Suffix - 1])
+      ++Suffix;
+
+    FileEdit Edit;
+    Edit.Offset = Prefix;
+    Edit.Length = Original.size() - Prefix - Suffix;
+    Edit.Text = Version.substr(Prefix, Version.size() - Prefix - Suffix);
+    Edits.push_back(Edit);
+  }
+
+  // Edits at the same offset have no defined order, so they conflict too.
+  std::sort(Edits.begin(), Edits.end());
+  for (unsigned i = 1, e = Edits.size(); i != e; ++i)
+    if (Edits[i-1].Offset + Edits[i-1].Length > Edits[i].Offset ||
+        Edits[i-1].Offset == Edits[i].Offset)
+      return true;
+
+  Result.clear();
+  unsigned Pos = 0;
+  for (unsigned i = 0, e = Edits.size(); i != e; ++i) {
+    Result.append(Original.data() + Pos, Edits[i].Offset - Pos);
+    Result.append(Edits[i].Text.data(), Edits[i].Text.size());
+    Pos = Edits[i].Offset + Edits[i].Length;
+  }
+  Result.append(Original.data() + Pos, Original.size() - Pos);
+  return false;
+}
+
+// Give the workers as much stack as libclang's safety threads, since parsing
+// is deeply recursive.
+static const unsigned ParallelMigrationStackSize = 8 << 20;
+
+bool arcmt::migrateWithTemporaryFilesInParallel(
+                                    ArrayRef<CompilerInvocation *> Invocations,
+                                    raw_ostream &DiagOS,
+                                    StringRef outputDir,
+                                    bool emitPremigrationARCErrors,
+                                    unsigned NumThreads) {
+  assert(!outputDir.empty() && "Expected output directory path");
+
+  ParallelMigrationRun Run;
+  Run.OutputDir = outputDir;
+  Run.EmitPremigrationARCErrors = emitPremigrationARCErrors;
+  for (unsigned i = 0, e = Invocations.size(); i != e; ++i) {
+    CompilerInvocation *CI = Invocations[i];
+    if (!CI->getLangOpts()->ObjC1)
+      continue;
+    const std::vector<FrontendInputFile> &Inputs = CI->getFrontendOpts().Inputs;
+    for (unsigned j = 0, je = Inputs.size(); j != je; ++j) {
+      ParallelMigrationTask Task;
+      Task.OrigCI = CI;
+      Task.Input = Inputs[j];
+      Task.Failed = false;
+      Task.Rerun = false;
+      Run.Tasks.push_back(Task);
+    }
+  }
+
+  runTasksInParallel(NumThreads, Run.Tasks.size(), runParallelMigrationTask,
+                     &Run, ParallelMigrationStackSize);
+
+  DiagnosticOptions DiagOpts;
+  TextDiagnosticPrinter DiagClient(DiagOS, DiagOpts);
+  IntrusiveRefCntPtr<DiagnosticIDs> DiagID(new DiagnosticIDs());
+  IntrusiveRefCntPtr<DiagnosticsEngine> Diags(
+      new DiagnosticsEngine(DiagID, &DiagClient, /*ShouldOwnClient=*/false));
+
+  FileRemapper Merged;
+  if (Merged.initFromDisk(outputDir, *Diags, /*ignoreIfFilesChanged=*/true))
+    return true;
+  // The files that earlier runs already migrated are the starting point of
+  // the translation units.
+  llvm::StringMap<std::string> EarlierResults;
+  {
+    PreprocessorOptions PPOpts;
+    Merged.applyMappings(PPOpts);
+    for (unsigned i = 0, e = PPOpts.RemappedFiles.size(); i != e; ++i) {
+      SmallString<256> Path(PPOpts.RemappedFiles[i].first);
+      llvm::sys::fs::make_absolute(Path);
+      EarlierResults[Path.str()] = PPOpts.RemappedFiles[i].second;
+    }
+  }
+
+  // The translation units that rewrote each file, in the order of the inputs.
+  typedef std::map<std::string, SmallVector<unsigned, 2> > WritersMap;
+  WritersMap Writers;
+  for (unsigned i = 0, e = Run.Tasks.size(); i != e; ++i) {
+    const ParallelMigrationTask &Task = Run.Tasks[i];
+    if (Task.Failed)
+      continue;
+    for (unsigned j = 0, je = Task.Rewritten.size(); j != je; ++j)
+      Writers[Task.Rewritten[j].first].push_back(i);
+  }
+
+  std::map<std::string, std::string> MergedContents;
+  std::set<std::string> Conflicts;
+  for (WritersMap::iterator I = Writers.begin(), E = Writers.end();
+       I != E; ++I) {
+    SmallVector<StringRef, 2> Versions;
+    for (unsigned i = 0, e = I->second.size(); i != e; ++i) {
+      const ParallelMigrationTask &Task = Run.Tasks[I->second[i]];
+      for (unsigned j = 0, je = Task.Rewritten.size(); j != je; ++j)
+        if (Task.Rewritten[j].first == I->first &&
+            std::find(Versions.begin(), Versions.end(),
+                      Task.Rewritten[j].second) == Versions.end())
+          Versions.push_back(Task.Rewritten[j].second);
+    }
+    if (Versions.size() == 1) {
+      MergedContents[I->first] = Versions[0].str();
+      continue;
+    }
+
+    llvm::StringMap<std::string>::iterator
+      Earlier = EarlierResults.find(I->first);
+    StringRef OriginalPath =
+      Earlier == EarlierResults.end() ? StringRef(I->first) : Earlier->second;
+    OwningPtr<llvm::MemoryBuffer> Original;
+    std::string Result;
+    if (llvm::MemoryBuffer::getFile(OriginalPath, Original) ||
+        mergeRewrites(Original->getBuffer(), Versions, Result))
+      Conflicts.insert(I->first);
+    else
+      MergedContents[I->first].swap(Result);
+  }
+
+  // A translation unit that rewrote a conflicting file is migrated again, and
+  // so is every other one that rewrote a file it did, since the later of the
+  // two would start from the results of the earlier one.
+  bool Changed = !Conflicts.empty();
+  while (Changed) {
+    Changed = false;
+    for (std::set<std::string>::iterator I = Conflicts.begin(),
+                                         E = Conflicts.end(); I != E; ++I) {
+      const SmallVector<unsigned, 2> &FileWriters = Writers[*I];
+      for (unsigned i = 0, e = FileWriters.size(); i != e; ++i) {
+        ParallelMigrationTask &Task = Run.Tasks[FileWriters[i]];
+        if (Task.Rerun)
+          continue;
+        Task.Rerun = true;
+        for (unsigned j = 0, je = Task.Rewritten.size(); j != je; ++j)
+          if (Conflicts.insert(Task.Rewritten[j].first).second)
+            Changed = true;
+      }
+    }
+  }
+
+  for (std::map<std::string, std::string>::iterator
+         I = MergedContents.begin(), E = MergedContents.end(); I != E; ++I)
+    if (!Conflicts.count(I->first))
+      Merged.remap(I->first,
+                   llvm::MemoryBuffer::getMemBufferCopy(I->second, I->first));
+  bool Failed = Merged.flushToDisk(outputDir, *Diags);
+
+  if (!Failed) {
+    for (unsigned i = 0, e = Run.Tasks.size(); i != e; ++i) {
+      ParallelMigrationTask &Task = Run.Tasks[i];
+      if (!Task.Rerun)
+        continue;
+      Task.Diagnostics.clear();
+      llvm::raw_string_ostream TaskDiagOS(Task.Diagnostics);
+      TextDiagnosticPrinter TaskDiagClient(TaskDiagOS,
+                                           Task.OrigCI->getDiagnosticOpts());
+      CompilerInvocation CI(*Task.OrigCI);
+      Task.Failed = applyTransforms(CI, Task.Input, &TaskDiagClient,
+                                    outputDir, emitPremigrationARCErrors,
+                                    StringRef());
+      TaskDiagOS.flush();
+    }
+  }
+
+  // Report in the order of the inputs, independent of the order in which the
+  // workers finished.
+  for (unsigned i = 0, e = Run.Tasks.size(); i != e; ++i) {
+    DiagOS << Run.Tasks[i].Diagnostics;
+    Failed |= Run.Tasks[i].Failed;
+  }
+  DiagOS.flush();
+
+  // As in migrateWithTemporaryFiles, make sure that the normal compilation
+  // does not get the '-fobjc-arc' flag.
+  for (unsigned i = 0, e = Run.Tasks.size(); i != e; ++i)
+    Run.Tasks[i].OrigCI->getLangOpts()->ObjCAutoRefCount = false;
+  return Failed;
+}
+
 bool arcmt::getFileRemappings(std::vector<std::pair<std::string,std::string> > &
                                   remap,
                               StringRef outputDir,
@@ -33,6 +33,7 @@
 #include "llvm/Support/raw_ostream.h"
 #include "llvm/Support/Capacity.h"
 #include "CXXABI.h"
+#include <algorithm>
 #include <map>
 
 using namespace clang;
@@ -49,11 +50,29 @@ unsigned ASTContext::NumImplicitMoveAssignmentOperators;
 unsigned ASTContext::NumImplicitMoveAssignmentOperatorsDeclared;
 unsigned ASTContext::NumImplicitDestructors;
 unsigned ASTContext::NumImplicitDestructorsDeclared;
+unsigned ASTContext::NumConstexprCallsMemoized;
+unsigned ASTContext::NumConstexprCallCacheHits;
+unsigned ASTContext::NumFunctionProtoTypeCacheLookups;
+unsigned ASTContext::NumFunctionProtoTypeCacheHits;
 
 enum FloatingRank {
   HalfRank, FloatRank, DoubleRank, LongDoubleRank
 };
 
+namespace {
+/// \brief Compare the comments of a file with offsets in it.
+struct CommentOffsetCompare {
+  bool operator()(const RawCommentList::CommentInFile &LHS,
+                  unsigned RHS) const {
+    return LHS.Offset < RHS;
+  }
+  bool operator()(unsigned LHS,
+                  const RawCommentList::CommentInFile &RHS) const {
+    return LHS < RHS.Offset;
+  }
+};
+} // unnamed namespace
+
 RawComment *ASTContext::getRawCommentForDeclNoCache(const Decl *D) const {
   if (!CommentsLoaded && ExternalSource) {
     ExternalSource->ReadComments();
@@ -99,10 +118,8 @@ RawComment *ASTContext::getRawCommentForDeclNoCache(const Decl *D) const {
       isa<TemplateTemplateParmDecl>(D))
     return NULL;
 
-  ArrayRef<RawComment *> RawComments = Comments.getComments();
-
   // If there are no comments anywhere, we won't find anything.
-  if (RawComments.empty())
+  if (Comments.getComments().empty())
     return NULL;
 
   // Find declaration location.
@@ -125,65 +142,47 @@ RawComment *ASTContext::getRawCommentForDeclNoCache(const Decl *D) const {
   if (DeclLoc.isInvalid() || !DeclLoc.isFileID())
     return NULL;
 
-  // Find the comment that occurs just after this declaration.
-  ArrayRef<RawComment *>::iterator Comment;
-  {
-    // When searching for comments during parsing, the comment we are looking
-    // for is usually among the last two comments we parsed -- check them
-    // first.
-    RawComment CommentAtDeclLoc(SourceMgr, SourceRange(DeclLoc));
-    BeforeThanCompare<RawComment> Compare(SourceMgr);
-    ArrayRef<RawComment *>::iterator MaybeBeforeDecl = RawComments.end() - 1;
-    bool Found = Compare(*MaybeBeforeDecl, &CommentAtDeclLoc);
-    if (!Found && RawComments.size() >= 2) {
-      MaybeBeforeDecl--;
-      Found = Compare(*MaybeBeforeDecl, &CommentAtDeclLoc);
-    }
-
-    if (Found) {
-      Comment = MaybeBeforeDecl + 1;
-      assert(Comment == std::lower_bound(RawComments.begin(), RawComments.end(),
-                                         &CommentAtDeclLoc, Compare));
-    } else {
-      // Slow path.
-      Comment = std::lower_bound(RawComments.begin(), RawComments.end(),
-                                 &CommentAtDeclLoc, Compare);
-    }
-  }
+  // Decompose the location for the declaration.  A comment in another file
+  // can't be related to it, so only look at the comments of its file.
+  std::pair<FileID, unsigned> DeclLocDecomp
+    = SourceMgr.getDecomposedLoc(DeclLoc);
+  typedef RawCommentList::CommentInFile CommentInFile;
+  ArrayRef<CommentInFile> FileComments
+    = Comments.getCommentsInFile(DeclLocDecomp.first);
+  if (FileComments.empty())
+    return NULL;
 
-  // Decompose the location for the declaration and find the beginning of the
-  // file buffer.
-  std::pair<FileID, unsigned> DeclLocDecomp = SourceMgr.getDecomposedLoc(DeclLoc);
+  // Find the comment that occurs just after this declaration.
+  ArrayRef<CommentInFile>::iterator Comment
+    = std::lower_bound(FileComments.begin(), FileComments.end(),
+                       DeclLocDecomp.second, CommentOffsetCompare());
 
   // First check whether we have a trailing comment.
-  if (Comment != RawComments.end() &&
-      (*Comment)->isDocumentation() && (*Comment)->isTrailingComment() &&
+  if (Comment != FileComments.end() &&
+      Comment->Comment->isDocumentation() &&
+      Comment->Comment->isTrailingComment() &&
       (isa<FieldDecl>(D) || isa<EnumConstantDecl>(D) || isa<VarDecl>(D))) {
-    std::pair<FileID, unsigned> CommentBeginDecomp
-      = SourceMgr.getDecomposedLoc((*Comment)->getSourceRange().getBegin());
-    // Check that Doxygen trailing comment comes after the declaration, starts
-    // on the same line and in the same file as the declaration.
-    if (DeclLocDecomp.first == CommentBeginDecomp.first &&
-        SourceMgr.getLineNumber(DeclLocDecomp.first, DeclLocDecomp.second)
-          == SourceMgr.getLineNumber(CommentBeginDecomp.first,
-                                     CommentBeginDecomp.second)) {
-      return *Comment;
-    }
+    // Check that Doxygen trailing comment comes after the declaration and
+    // starts on the same line as the declaration.
+    if (SourceMgr.getLineNumber(DeclLocDecomp.first, DeclLocDecomp.second)
+          == SourceMgr.getLineNumber(DeclLocDecomp.first, Comment->Offset))
+      return Comment->Comment;
   }
 
   // The comment just after the declaration was not a trailing comment.
   // Let's look at the previous comment.
-  if (Comment == RawComments.begin())
+  if (Comment == FileComments.begin())
     return NULL;
   --Comment;
 
   // Check that we actually have a non-member Doxygen comment.
-  if (!(*Comment)->isDocumentation() || (*Comment)->isTrailingComment())
+  if (!Comment->Comment->isDocumentation() ||
+      Comment->Comment->isTrailingComment())
     return NULL;
 
   // Decompose the end of the comment.
   std::pair<FileID, unsigned> CommentEndDecomp
-    = SourceMgr.getDecomposedLoc((*Comment)->getSourceRange().getEnd());
+    = SourceMgr.getDecomposedLoc(Comment->Comment->getSourceRange().getEnd());
 
   // If the comment and the declaration aren't in the same file, then they
   // aren't related.
@@ -206,7 +205,7 @@ RawComment *ASTContext::getRawCommentForDeclNoCache(const Decl *D) const {
   if (Text.find_first_of(",;{}#@") != StringRef::npos)
     return NULL;
 
-  return *Comment;
+  return Comment->Comment;
 }
 
 namespace {
@@ -565,8 +564,12 @@ ASTContext::ASTContext(LangOptions& LOpts, SourceManager &SM,
     BlockDescriptorType(0), BlockDescriptorExtendedType(0),
     cudaConfigureCallDecl(0),
     NullTypeSourceInfo(QualType()), 
+    ConstexprCalls(0),
     FirstLocalImport(), LastLocalImport(),
     SourceMgr(SM), LangOpts(LOpts), 
+    ReleasableFunctionBodies(false), CurFunctionBodyArena(0),
+    FunctionBodyArenaMemory(0), ReleasedFunctionBodyMemory(0),
+    NumReleasedFunctionBodies(0),
     AddrSpaceMap(0), Target(t), PrintingPolicy(LOpts),
     Idents(idents), Selectors(sels),
     BuiltinInfo(builtins),
@@ -578,6 +581,9 @@ ASTContext::ASTContext(LangOptions& LOpts, SourceManager &SM,
     UniqueBlockByRefTypeID(0) 
 {
   if (size_reserve > 0) Types.reserve(size_reserve);
+  std::fill(FunctionProtoTypeCache,
+            FunctionProtoTypeCache + FunctionProtoTypeCacheSize,
+            (FunctionProtoType *)0);
   TUDecl = TranslationUnitDecl::Create(*this);
   
   if (!DelayInitialization) {
@@ -591,6 +597,12 @@ ASTContext::~ASTContext() {
   // FIXME: Is this the ideal solution?
   ReleaseDeclContextMaps();
 
+  delete CurFunctionBodyArena;
+  for (llvm::DenseMap<const FunctionDecl *, FunctionBodyArena *>::iterator
+         I = FunctionBodyArenas.begin(), E = FunctionBodyArenas.end();
+       I != E; ++I)
+    delete I->second;
+
   // Call all of the deallocation functions.
   for (unsigned I = 0, N = Deallocations.size(); I != N; ++I)
     Deallocations[I].first(Deallocations[I].second);
@@ -626,6 +638,14 @@ ASTContext::setExternalSource(OwningPtr<ExternalASTSource> &Source) {
   ExternalSource.reset(Source.take());
 }
 
+void ASTContext::setConcurrentReaders(bool Allow) {
+  if (Allow == allowsConcurrentReaders())
+    return;
+  // The lock is recursive, since computing a layout queries the sizes of
+  // the fields, which may lay out other records.
+  LayoutLock.reset(Allow ? new llvm::sys::Mutex(/*recursive=*/true) : 0);
+}
+
 void ASTContext::PrintStats() const {
   llvm::errs() << "\n*** AST Context Stats:\n";
   llvm::errs() << "  " << Types.size() << " types total.\n";
@@ -676,6 +696,19 @@ void ASTContext::PrintStats() const {
   llvm::errs() << NumImplicitDestructorsDeclared << "/"
                << NumImplicitDestructors
                << " implicit destructors created\n";
+  if (getLangOpts().CPlusPlus0x)
+    llvm::errs() << NumConstexprCallCacheHits << "/"
+                 << NumConstexprCallsMemoized
+                 << " memoized constexpr function calls reused\n";
+  llvm::errs() << NumFunctionProtoTypeCacheHits << "/"
+               << NumFunctionProtoTypeCacheLookups
+               << " function type lookups found in the type cache\n";
+
+  if (ReleasableFunctionBodies)
+    llvm::errs() << NumReleasedFunctionBodies << " function bodies released ("
+                 << ReleasedFunctionBodyMemory << " bytes), "
+                 << FunctionBodyArenas.size() << " kept ("
+                 << FunctionBodyArenaMemory << " bytes)\n";
 
   if (ExternalSource.get()) {
     llvm::errs() << "\n";
@@ -685,6 +718,83 @@ void ASTContext::PrintStats() const {
   BumpAlloc.PrintStats();
 }
 
+void ASTContext::startFunctionBody(const FunctionDecl *FD) {
+  assert(ReleasableFunctionBodies && "function bodies are not releasable");
+
+  // A function body can only be parsed within another one as part of
+  // something else, such as a local class, which can outlive the body.
+  if (CurFunctionBodyArena) {
+    CurFunctionBodyArena->Escaped = true;
+    return;
+  }
+  CurFunctionBodyArena = new FunctionBodyArena;
+  FunctionBodyArenas[FD] = CurFunctionBodyArena;
+}
+
+void ASTContext::finishFunctionBody(const FunctionDecl *FD) {
+  llvm::DenseMap<const FunctionDecl *, FunctionBodyArena *>::iterator Known
+    = FunctionBodyArenas.find(FD);
+  if (Known == FunctionBodyArenas.end() ||
+      Known->second != CurFunctionBodyArena)
+    return;
+
+  FunctionBodyArenaMemory += CurFunctionBodyArena->Alloc.getTotalMemory();
+  CurFunctionBodyArena = 0;
+}
+
+/// \brief Determine whether a declaration local to a function can only be
+/// referenced from the body of that function, and so can be kept once the
+/// body has been released.
+static bool isReleasableLocalDecl(const Decl *D) {
+  if (const VarDecl *VD = dyn_cast<VarDecl>(D))
+    return VD->hasLocalStorage();
+  return isa<TypedefNameDecl>(D) || isa<LabelDecl>(D) ||
+         isa<UsingDirectiveDecl>(D) || isa<UsingDecl>(D) ||
+         isa<UsingShadowDecl>(D) || isa<NamespaceAliasDecl>(D);
+}
+
+bool ASTContext::releaseFunctionBody(FunctionDecl *FD) {
+  llvm::DenseMap<const FunctionDecl *, FunctionBodyArena *>::iterator Known
+    = FunctionBodyArenas.find(FD);
+  if (Known == FunctionBodyArenas.end() || Known->second->Escaped)
+    return false;
+
+  // Local classes, blocks, static locals and local declarations of
+  // functions with default arguments can all be used after the body.
+  for (DeclContext::decl_iterator D = FD->noload_decls_begin(),
+                                  DEnd = FD->noload_decls_end();
+       D != DEnd; ++D)
+    if (!isReleasableLocalDecl(*D))
+      return false;
+
+  // Drop the references to the statements of the body from the local
+  // declarations too.
+  for (DeclContext::decl_iterator D = FD->noload_decls_begin(),
+                                  DEnd = FD->noload_decls_end();
+       D != DEnd; ++D) {
+    if (isa<ParmVarDecl>(*D))
+      continue;
+    if (VarDecl *VD = dyn_cast<VarDecl>(*D))
+      VD->setInit(0);
+    else if (LabelDecl *LD = dyn_cast<LabelDecl>(*D))
+      LD->setStmt(0);
+  }
+
+  Stmt *Body = FD->getBody();
+  SourceLocation LBraceLoc = Body ? Body->getLocStart() : SourceLocation();
+  SourceLocation RBraceLoc = Body ? Body->getLocEnd() : SourceLocation();
+  FD->setBody(new (*this) CompoundStmt(*this, 0, 0, LBraceLoc, RBraceLoc));
+
+  FunctionBodyArena *Arena = Known->second;
+  size_t Memory = Arena->Alloc.getTotalMemory();
+  FunctionBodyArenaMemory -= Memory;
+  ReleasedFunctionBodyMemory += Memory;
+  ++NumReleasedFunctionBodies;
+  FunctionBodyArenas.erase(Known);
+  delete Arena;
+  return true;
+}
+
 TypedefDecl *ASTContext::getInt128Decl() const {
   if (!Int128Decl) {
     TypeSourceInfo *TInfo = getTrivialTypeSourceInfo(Int128Ty);
@@ -1178,6 +1288,7 @@ ASTContext::getTypeInfoInChars(QualType T) const {
 }
 
 std::pair<uint64_t, unsigned> ASTContext::getTypeInfo(const Type *T) const {
+  LayoutLockGuard Guard(*this);
   TypeInfoMap::iterator it = MemoizedTypeInfo.find(T);
   if (it != MemoizedTypeInfo.end())
     return it->second;
@@ -2484,12 +2595,83 @@ ASTContext::getFunctionNoProtoType(QualType ResultTy,
   return QualType(New, 0);
 }
 
+/// \brief Hash the components of a function type which
+/// FunctionProtoType::Profile adds to its ID, except for the noexcept
+/// expression and the consumed arguments.
+static unsigned
+hashFunctionProtoType(QualType ResultTy, const QualType *ArgArray,
+                      unsigned NumArgs,
+                      const FunctionProtoType::ExtProtoInfo &EPI) {
+  uintptr_t Hash = uintptr_t(ResultTy.getAsOpaquePtr());
+  for (unsigned i = 0; i != NumArgs; ++i)
+    Hash = (Hash ^ (Hash >> 9)) * 31 + uintptr_t(ArgArray[i].getAsOpaquePtr());
+  Hash = Hash * 31 + (unsigned(EPI.Variadic) + (EPI.TypeQuals << 1) +
+                      (EPI.RefQualifier << 9) +
+                      (EPI.ExceptionSpecType << 11) +
+                      (EPI.HasTrailingReturn << 14) + NumArgs * 17);
+  if (EPI.ExceptionSpecType == EST_Dynamic) {
+    for (unsigned i = 0; i != EPI.NumExceptions; ++i)
+      Hash = Hash * 31 + uintptr_t(EPI.Exceptions[i].getAsOpaquePtr());
+  } else if (EPI.ExceptionSpecType == EST_Uninstantiated ||
+             EPI.ExceptionSpecType == EST_Unevaluated) {
+    Hash = Hash * 31 + uintptr_t(EPI.ExceptionSpecDecl->getCanonicalDecl());
+  }
+  Hash ^= Hash >> 16;
+  return unsigned(Hash ^ (Hash >> 7));
+}
+
+/// \brief Determine whether \p FPT has exactly the components that
+/// FunctionProtoType::Profile would encode for the given function type, and
+/// so is the type FunctionProtoTypes would find for it.
+static bool
+isSameFunctionProtoType(const FunctionProtoType *FPT, QualType ResultTy,
+                        const QualType *ArgArray, unsigned NumArgs,
+                        const FunctionProtoType::ExtProtoInfo &EPI) {
+  if (FPT->getResultType() != ResultTy || FPT->getNumArgs() != NumArgs ||
+      FPT->isVariadic() != EPI.Variadic ||
+      FPT->getTypeQuals() != EPI.TypeQuals ||
+      FPT->getRefQualifier() != EPI.RefQualifier ||
+      FPT->getExceptionSpecType() != EPI.ExceptionSpecType ||
+      FPT->hasTrailingReturn() != EPI.HasTrailingReturn ||
+      FPT->hasAnyConsumedArgs() || !(FPT->getExtInfo() == EPI.ExtInfo))
+    return false;
+
+  if (!std::equal(ArgArray, ArgArray + NumArgs, FPT->arg_type_begin()))
+    return false;
+
+  if (EPI.ExceptionSpecType == EST_Dynamic)
+    return FPT->getNumExceptions() == EPI.NumExceptions &&
+           std::equal(EPI.Exceptions, EPI.Exceptions + EPI.NumExceptions,
+                      FPT->exception_begin());
+  if (EPI.ExceptionSpecType == EST_Uninstantiated ||
+      EPI.ExceptionSpecType == EST_Unevaluated)
+    return FPT->getExceptionSpecDecl()->getCanonicalDecl() ==
+           EPI.ExceptionSpecDecl->getCanonicalDecl();
+  return true;
+}
+
 /// getFunctionType - Return a normal function type with a typed argument
 /// list.  isVariadic indicates whether the argument list includes '...'.
 QualType
 ASTContext::getFunctionType(QualType ResultTy,
                             const QualType *ArgArray, unsigned NumArgs,
                             const FunctionProtoType::ExtProtoInfo &EPI) const {
+  // Try the function type cache first. Noexcept expressions are profiled
+  // structurally and consumed arguments are rare, so those function types
+  // only go through the folding set.
+  FunctionProtoType **CacheSlot = 0;
+  if (EPI.ExceptionSpecType != EST_ComputedNoexcept && !EPI.ConsumedArguments) {
+    ++NumFunctionProtoTypeCacheLookups;
+    CacheSlot = &FunctionProtoTypeCache[
+        hashFunctionProtoType(ResultTy, ArgArray, NumArgs, EPI) %
+        FunctionProtoTypeCacheSize];
+    if (*CacheSlot &&
+        isSameFunctionProtoType(*CacheSlot, ResultTy, ArgArray, NumArgs, EPI)) {
+      ++NumFunctionProtoTypeCacheHits;
+      return QualType(*CacheSlot, 0);
+    }
+  }
+
   // Unique functions, to guarantee there is only one function of a particular
   // structure.
   llvm::FoldingSetNodeID ID;
@@ -2497,8 +2679,11 @@ ASTContext::getFunctionType(QualType ResultTy,
 
   void *InsertPos = 0;
   if (FunctionProtoType *FTP =
-        FunctionProtoTypes.FindNodeOrInsertPos(ID, InsertPos))
+        FunctionProtoTypes.FindNodeOrInsertPos(ID, InsertPos)) {
+    if (CacheSlot)
+      *CacheSlot = FTP;
     return QualType(FTP, 0);
+  }
 
   // Determine whether the type being created is already canonical or not.
   bool isCanonical =
@@ -2560,12 +2745,21 @@ ASTContext::getFunctionType(QualType ResultTy,
   if (EPI.ConsumedArguments)
     Size += NumArgs * sizeof(bool);
 
+  // The noexcept expression is profiled whenever the folding set looks at
+  // this type, so it must outlive any function body it appears in.
+  if (EPI.ExceptionSpecType == EST_ComputedNoexcept)
+    noteFunctionBodyEscape();
+
   FunctionProtoType *FTP = (FunctionProtoType*) Allocate(Size, TypeAlignment);
   FunctionProtoType::ExtProtoInfo newEPI = EPI;
   newEPI.ExtInfo = EPI.ExtInfo.withCallingConv(CallConv);
   new (FTP) FunctionProtoType(ResultTy, ArgArray, NumArgs, Canonical, newEPI);
   Types.push_back(FTP);
   FunctionProtoTypes.InsertNode(FTP, InsertPos);
+  // The canonical type was created in the same way, so the slot may have
+  // been overwritten; it is only ever a hint.
+  if (CacheSlot)
+    *CacheSlot = FTP;
   return QualType(FTP, 0);
 }
 
@@ -7253,6 +7447,50 @@ GVALinkage ASTContext::GetGVALinkageForVariable(const VarDecl *VD) {
   llvm_unreachable("Invalid Linkage!");
 }
 
+bool ASTContext::isVTableOwnedByASTFile(const CXXRecordDecl *RD) {
+  if (LangOpts.getPCHVTables() == LangOptions::PCHVTablesEverywhere ||
+      LangOpts.AppleKext)
+    return false;
+
+  RD = RD->getDefinition();
+  if (!RD || RD->getLinkage() != ExternalLinkage)
+    return false;
+
+  // A vtable whose key function is defined out of line is only emitted with
+  // the key function anyway.
+  if (const CXXMethodDecl *KeyFunction = getKeyFunction(RD)) {
+    const FunctionDecl *Def = 0;
+    if (!KeyFunction->hasBody(Def) || !Def->isInlined())
+      return false;
+  }
+
+  // The class must have been defined, or instantiated, while building the
+  // AST file, so that its owner emits the vtable too.
+  SourceLocation Loc;
+  switch (RD->getTemplateSpecializationKind()) {
+  case TSK_Undeclared:
+  case TSK_ExplicitSpecialization:
+    Loc = RD->getLocation();
+    break;
+
+  case TSK_ImplicitInstantiation:
+    if (const ClassTemplateSpecializationDecl *Spec
+          = dyn_cast<ClassTemplateSpecializationDecl>(RD))
+      Loc = Spec->getPointOfInstantiation();
+    else if (MemberSpecializationInfo *MSInfo
+               = RD->getMemberSpecializationInfo())
+      Loc = MSInfo->getPointOfInstantiation();
+    break;
+
+  case TSK_ExplicitInstantiationDeclaration:
+  case TSK_ExplicitInstantiationDefinition:
+    // The vtable lives with the explicit instantiation definition.
+    return false;
+  }
+
+  return Loc.isValid() && SourceMgr.isLoadedSourceLocation(Loc);
+}
+
 bool ASTContext::DeclMustBeEmitted(const Decl *D) {
   if (const VarDecl *VD = dyn_cast<VarDecl>(D)) {
     if (!VD->isFileVarDecl())
@@ -23,6 +23,7 @@
 #include "clang/Basic/FileManager.h"
 #include "clang/Basic/SourceManager.h"
 #include "llvm/Support/MemoryBuffer.h"
+#include "llvm/Support/SaveAndRestore.h"
 #include <deque>
 
 namespace clang {
@@ -198,6 +199,10 @@ namespace {
     /// \brief Declaration (from, to) pairs that are known not to be equivalent
     /// (which we have already complained about).
     llvm::DenseSet<std::pair<Decl *, Decl *> > &NonEquivalentDecls;
+
+    /// \brief Declaration (from, to) pairs that earlier checks found to be
+    /// equivalent.
+    llvm::DenseSet<std::pair<Decl *, Decl *> > &EquivalentDecls;
     
     /// \brief Whether we're being strict about the spelling of types when 
     /// unifying two types.
@@ -206,12 +211,19 @@ namespace {
     /// \brief Whether to complain about failures.
     bool Complain;
 
+    /// \brief Whether Finish() is running, in which case the tentative
+    /// equivalences are not all verified yet.
+    bool Finishing;
+
     StructuralEquivalenceContext(ASTContext &C1, ASTContext &C2,
                llvm::DenseSet<std::pair<Decl *, Decl *> > &NonEquivalentDecls,
+                  llvm::DenseSet<std::pair<Decl *, Decl *> > &EquivalentDecls,
                                  bool StrictTypeSpelling = false,
                                  bool Complain = true)
       : C1(C1), C2(C2), NonEquivalentDecls(NonEquivalentDecls),
-        StrictTypeSpelling(StrictTypeSpelling), Complain(Complain) { }
+        EquivalentDecls(EquivalentDecls),
+        StrictTypeSpelling(StrictTypeSpelling), Complain(Complain),
+        Finishing(false) { }
 
     /// \brief Determine whether the two declarations are structurally
     /// equivalent.
@@ -225,6 +237,10 @@ namespace {
     ///
     /// \returns true if an error occurred, false otherwise.
     bool Finish();
+
+    /// \brief Remember the equivalences that Finish() verified for later
+    /// checks.
+    void RememberEquivalences();
     
   public:
     DiagnosticBuilder Diag1(SourceLocation Loc, unsigned DiagID) {
@@ -1164,18 +1180,25 @@ static bool IsStructurallyEquivalent(StructuralEquivalenceContext &Context,
   
   // Check whether we already know that these two declarations are not
   // structurally equivalent.
-  if (Context.NonEquivalentDecls.count(std::make_pair(D1->getCanonicalDecl(),
-                                                      D2->getCanonicalDecl())))
+  std::pair<Decl *, Decl *> Canonical(D1->getCanonicalDecl(),
+                                      D2->getCanonicalDecl());
+  if (Context.NonEquivalentDecls.count(Canonical))
     return false;
   
   // Determine whether we've already produced a tentative equivalence for D1.
-  Decl *&EquivToD1 = Context.TentativeEquivalences[D1->getCanonicalDecl()];
+  Decl *&EquivToD1 = Context.TentativeEquivalences[Canonical.first];
   if (EquivToD1)
-    return EquivToD1 == D2->getCanonicalDecl();
+    return EquivToD1 == Canonical.second;
+
+  // Check whether an earlier check already found them equivalent.
+  if (!Context.StrictTypeSpelling && Context.EquivalentDecls.count(Canonical)) {
+    EquivToD1 = Canonical.second;
+    return true;
+  }
   
   // Produce a tentative equivalence D1 <-> D2, which will be checked later.
-  EquivToD1 = D2->getCanonicalDecl();
-  Context.DeclsToCheck.push_back(D1->getCanonicalDecl());
+  EquivToD1 = Canonical.second;
+  Context.DeclsToCheck.push_back(Canonical.first);
   return true;
 }
 
@@ -1184,7 +1207,10 @@ bool StructuralEquivalenceContext::IsStructurallyEquivalent(Decl *D1,
   if (!::IsStructurallyEquivalent(*this, D1, D2))
     return false;
   
-  return !Finish();
+  if (Finish())
+    return false;
+  RememberEquivalences();
+  return true;
 }
 
 bool StructuralEquivalenceContext::IsStructurallyEquivalent(QualType T1, 
@@ -1192,10 +1218,37 @@ bool StructuralEquivalenceContext::IsStructurallyEquivalent(QualType T1,
   if (!::IsStructurallyEquivalent(*this, T1, T2))
     return false;
   
-  return !Finish();
+  if (Finish())
+    return false;
+  RememberEquivalences();
+  return true;
+}
+
+void StructuralEquivalenceContext::RememberEquivalences() {
+  // Checks nested in Finish() are remembered with the outermost one.
+  if (StrictTypeSpelling || Finishing)
+    return;
+
+  // A tag without a definition is equivalent to any tag of the same name,
+  // but it may still get a definition that is not. Only remember checks
+  // which did not depend on one.
+  for (llvm::DenseMap<Decl *, Decl *>::iterator
+         I = TentativeEquivalences.begin(), E = TentativeEquivalences.end();
+       I != E; ++I) {
+    TagDecl *Tag1 = dyn_cast<TagDecl>(I->first);
+    TagDecl *Tag2 = dyn_cast<TagDecl>(I->second);
+    if ((Tag1 && !Tag1->getDefinition()) || (Tag2 && !Tag2->getDefinition()))
+      return;
+  }
+
+  for (llvm::DenseMap<Decl *, Decl *>::iterator
+         I = TentativeEquivalences.begin(), E = TentativeEquivalences.end();
+       I != E; ++I)
+    EquivalentDecls.insert(*I);
 }
 
 bool StructuralEquivalenceContext::Finish() {
+  llvm::SaveAndRestore<bool> SetFinishing(Finishing, true);
   while (!DeclsToCheck.empty()) {
     // Check the next declaration.
     Decl *D1 = DeclsToCheck.front();
@@ -2023,6 +2076,7 @@ bool ASTNodeImporter::IsStructuralMatch(RecordDecl *FromRecord,
   StructuralEquivalenceContext Ctx(Importer.getFromContext(),
                                    Importer.getToContext(),
                                    Importer.getNonEquivalentDecls(),
+                                   Importer.getEquivalentDecls(),
                                    false, Complain);
   return Ctx.IsStructurallyEquivalent(FromRecord, ToRecord);
 }
@@ -2030,7 +2084,8 @@ bool ASTNodeImporter::IsStructuralMatch(RecordDecl *FromRecord,
 bool ASTNodeImporter::IsStructuralMatch(EnumDecl *FromEnum, EnumDecl *ToEnum) {
   StructuralEquivalenceContext Ctx(Importer.getFromContext(),
                                    Importer.getToContext(),
-                                   Importer.getNonEquivalentDecls());
+                                   Importer.getNonEquivalentDecls(),
+                                   Importer.getEquivalentDecls());
   return Ctx.IsStructurallyEquivalent(FromEnum, ToEnum);
 }
 
@@ -2038,7 +2093,8 @@ bool ASTNodeImporter::IsStructuralMatch(ClassTemplateDecl *From,
                                         ClassTemplateDecl *To) {
   StructuralEquivalenceContext Ctx(Importer.getFromContext(),
                                    Importer.getToContext(),
-                                   Importer.getNonEquivalentDecls());
+                                   Importer.getNonEquivalentDecls(),
+                                   Importer.getEquivalentDecls());
   return Ctx.IsStructurallyEquivalent(From, To);  
 }
 
@@ -4654,6 +4710,6 @@ bool ASTImporter::IsStructurallyEquivalent(QualType From, QualType To,
     return true;
       
   StructuralEquivalenceContext Ctx(FromContext, ToContext, NonEquivalentDecls,
-                                   false, Complain);
+                                   EquivalentDecls, false, Complain);
   return Ctx.IsStructurallyEquivalent(From, To);
 }
@@ -0,0 +1,415 @@
+//===--- ASTMemoryStats.cpp - Memory used by the AST ----------------------===//
+//
+//                     The LLVM Compiler Infrastructure
+//
+// This file is distributed under the University of Illinois Open Source
+// License. See LICENSE.TXT for details.
+//
+//===----------------------------------------------------------------------===//
+//
+//  This file implements ASTContext::PrintMemoryStats, which attributes the
+//  memory of the AST to node classes, source files and uniquing tables.
+//
+//===----------------------------------------------------------------------===//
+
+#include "clang/AST/ASTContext.h"
+#include "clang/AST/DeclContextInternals.h"
+#include "clang/AST/DeclCXX.h"
+#include "clang/AST/DeclFriend.h"
+#include "clang/AST/DeclObjC.h"
+#include "clang/AST/DeclTemplate.h"
+#include "clang/AST/ExprCXX.h"
+#include "clang/AST/ExprObjC.h"
+#include "clang/AST/StmtCXX.h"
+#include "clang/AST/StmtObjC.h"
+#include "clang/AST/TypeLoc.h"
+#include "clang/Basic/SourceManager.h"
+#include "llvm/ADT/DenseMap.h"
+#include "llvm/ADT/DenseSet.h"
+#include "llvm/ADT/StringMap.h"
+#include "llvm/Support/Format.h"
+#include "llvm/Support/raw_ostream.h"
+#include <algorithm>
+#include <vector>
+
+using namespace clang;
+
+static uint64_t getDeclClassSize(const Decl *D) {
+  switch (D->getKind()) {
+#define DECL(DERIVED, BASE) case Decl::DERIVED: return sizeof(DERIVED##Decl);
+#define ABSTRACT_DECL(DECL)
+#include "clang/AST/DeclNodes.inc"
+  }
+  llvm_unreachable("unknown decl kind");
+}
+
+static uint64_t getStmtClassSize(const Stmt *S) {
+  switch (S->getStmtClass()) {
+  case Stmt::NoStmtClass:
+    break;
+#define ABSTRACT_STMT(STMT)
+#define STMT(CLASS, PARENT) case Stmt::CLASS##Class: return sizeof(CLASS);
+#include "clang/AST/StmtNodes.inc"
+  }
+  llvm_unreachable("unknown stmt class");
+}
+
+static uint64_t getTypeClassSize(const Type *T) {
+  switch (T->getTypeClass()) {
+#define TYPE(Class, Base) case Type::Class: return sizeof(Class##Type);
+#define ABSTRACT_TYPE(Class, Base)
+#include "clang/AST/TypeNodes.def"
+  }
+  llvm_unreachable("unknown type class");
+}
+
+namespace {
+/// \brief The memory attributed to a node class or to a table.
+struct MemoryCost {
+  uint64_t Bytes;
+  unsigned Count;
+
+  MemoryCost() : Bytes(0), Count(0) {}
+
+  void add(uint64_t NodeBytes) {
+    Bytes += NodeBytes;
+    ++Count;
+  }
+};
+
+/// \brief The memory attributed to a source file.
+struct FileMemoryCost {
+  MemoryCost Decls, Stmts, TypeLocs;
+
+  uint64_t getBytes() const {
+    return Decls.Bytes + Stmts.Bytes + TypeLocs.Bytes;
+  }
+};
+
+/// \brief Walks the declarations and statements of the translation unit
+/// and adds up the memory of each node.
+///
+/// A node is measured as the size of its class plus the trailing arrays
+/// that are allocated with it and that are cheap to find. Declarations
+/// and statement bodies loaded from AST files are not walked, to avoid
+/// deserializing them.
+class MemoryCounter {
+  const SourceManager &SM;
+  llvm::DenseSet<const Decl *> VisitedDecls;
+
+public:
+  llvm::StringMap<MemoryCost> DeclClasses, StmtClasses;
+  llvm::DenseMap<const FileEntry *, FileMemoryCost> Files;
+  MemoryCost TypeLocs, LookupTables;
+
+  explicit MemoryCounter(const SourceManager &SM) : SM(SM) {}
+
+  FileMemoryCost &getFileCost(SourceLocation Loc) {
+    const FileEntry *File = 0;
+    if (Loc.isValid())
+      File = SM.getFileEntryForID(SM.getFileID(SM.getExpansionLoc(Loc)));
+    return Files[File];
+  }
+
+  void visitDecl(const Decl *D);
+  void visitDeclContext(const DeclContext *DC);
+  void visitStmt(const Stmt *S);
+  void visitTypeSourceInfo(const TypeSourceInfo *TSI, FileMemoryCost &File);
+};
+}
+
+void MemoryCounter::visitDecl(const Decl *D) {
+  if (!D || !VisitedDecls.insert(D).second)
+    return;
+
+  uint64_t Bytes = getDeclClassSize(D);
+  FileMemoryCost &File = getFileCost(D->getLocation());
+
+  if (const DeclaratorDecl *DD = dyn_cast<DeclaratorDecl>(D))
+    visitTypeSourceInfo(DD->getTypeSourceInfo(), File);
+  else if (const TypedefNameDecl *TND = dyn_cast<TypedefNameDecl>(D))
+    visitTypeSourceInfo(TND->getTypeSourceInfo(), File);
+
+  bool WalkStmts = !D->isFromASTFile();
+  if (const FunctionDecl *FD = dyn_cast<FunctionDecl>(D)) {
+    Bytes += FD->getNumParams() * sizeof(ParmVarDecl *);
+    for (unsigned I = 0, N = FD->getNumParams(); I != N; ++I)
+      visitDecl(FD->getParamDecl(I));
+    if (WalkStmts && FD->doesThisDeclarationHaveABody() &&
+        !FD->isLateTemplateParsed())
+      visitStmt(FD->getBody());
+
+    if (const CXXConstructorDecl *Ctor = dyn_cast<CXXConstructorDecl>(FD)) {
+      Bytes += Ctor->getNumCtorInitializers() * sizeof(CXXCtorInitializer *);
+      for (CXXConstructorDecl::init_const_iterator I = Ctor->init_begin(),
+                                                   E = Ctor->init_end();
+           I != E; ++I) {
+        Bytes += sizeof(CXXCtorInitializer) +
+                 (*I)->getNumArrayIndices() * sizeof(VarDecl *);
+        if (WalkStmts)
+          visitStmt((*I)->getInit());
+      }
+    }
+  } else if (const ParmVarDecl *PVD = dyn_cast<ParmVarDecl>(D)) {
+    if (WalkStmts && !PVD->hasUnparsedDefaultArg() &&
+        !PVD->hasUninstantiatedDefaultArg())
+      visitStmt(PVD->getInit());
+  } else if (const VarDecl *VD = dyn_cast<VarDecl>(D)) {
+    if (WalkStmts)
+      visitStmt(VD->getInit());
+  } else if (const FieldDecl *FD = dyn_cast<FieldDecl>(D)) {
+    if (WalkStmts)
+      visitStmt(FD->getInClassInitializer());
+  } else if (const EnumConstantDecl *ECD = dyn_cast<EnumConstantDecl>(D)) {
+    if (WalkStmts)
+      visitStmt(ECD->getInitExpr());
+  } else if (const StaticAssertDecl *SAD = dyn_cast<StaticAssertDecl>(D)) {
+    if (WalkStmts)
+      visitStmt(SAD->getAssertExpr());
+  }
+
+  // The templated declaration and the implicit specializations of a
+  // template are not in any declaration context.
+  if (const TemplateDecl *TD = dyn_cast<TemplateDecl>(D)) {
+    if (TemplateParameterList *Params = TD->getTemplateParameters()) {
+      Bytes += Params->size() * sizeof(NamedDecl *);
+      for (TemplateParameterList::iterator I = Params->begin(),
+                                           E = Params->end();
+           I != E; ++I)
+        visitDecl(*I);
+    }
+    visitDecl(TD->getTemplatedDecl());
+
+    if (!D->isFromASTFile()) {
+      if (FunctionTemplateDecl *FTD =
+            dyn_cast<FunctionTemplateDecl>(const_cast<Decl *>(D))) {
+        for (FunctionTemplateDecl::spec_iterator I = FTD->spec_begin(),
+                                                 E = FTD->spec_end();
+             I != E; ++I)
+          visitDecl(*I);
+      } else if (ClassTemplateDecl *CTD =
+                   dyn_cast<ClassTemplateDecl>(const_cast<Decl *>(D))) {
+        for (ClassTemplateDecl::spec_iterator I = CTD->spec_begin(),
+                                              E = CTD->spec_end();
+             I != E; ++I)
+          visitDecl(*I);
+        for (ClassTemplateDecl::partial_spec_iterator
+               I = CTD->partial_spec_begin(), E = CTD->partial_spec_end();
+             I != E; ++I)
+          visitDecl(*I);
+      }
+    }
+  }
+
+  DeclClasses[D->getDeclKindName()].add(Bytes);
+  File.Decls.add(Bytes);
+
+  if (const DeclContext *DC = dyn_cast<DeclContext>(D))
+    visitDeclContext(DC);
+}
+
+void MemoryCounter::visitDeclContext(const DeclContext *DC) {
+  if (DC->getPrimaryContext() == DC)
+    if (StoredDeclsMap *Map = DC->getLookupPtr())
+      LookupTables.add(sizeof(StoredDeclsMap) + Map->getMemorySize());
+
+  for (DeclContext::decl_iterator I = DC->noload_decls_begin(),
+                                  E = DC->noload_decls_end();
+       I != E; ++I)
+    visitDecl(*I);
+}
+
+void MemoryCounter::visitStmt(const Stmt *S) {
+  if (!S)
+    return;
+
+  uint64_t Bytes = getStmtClassSize(S);
+  if (const CompoundStmt *CS = dyn_cast<CompoundStmt>(S))
+    Bytes += CS->size() * sizeof(Stmt *);
+  else if (const CallExpr *CE = dyn_cast<CallExpr>(S))
+    Bytes += (CE->getNumArgs() + 1) * sizeof(Stmt *);
+  else if (const InitListExpr *ILE = dyn_cast<InitListExpr>(S))
+    Bytes += ILE->getNumInits() * sizeof(Stmt *);
+  else if (const DeclStmt *DS = dyn_cast<DeclStmt>(S)) {
+    if (DS->getDeclGroup().isDeclGroup())
+      Bytes += sizeof(DeclGroup) +
+               DS->getDeclGroup().getDeclGroup().size() * sizeof(Decl *);
+  }
+
+  StmtClasses[S->getStmtClassName()].add(Bytes);
+  getFileCost(S->getLocStart()).Stmts.add(Bytes);
+
+  if (const DeclStmt *DS = dyn_cast<DeclStmt>(S)) {
+    for (DeclStmt::const_decl_iterator I = DS->decl_begin(),
+                                       E = DS->decl_end();
+         I != E; ++I)
+      visitDecl(*I);
+  }
+
+  for (Stmt::const_child_range C = S->children(); C; ++C)
+    visitStmt(*C);
+}
+
+void MemoryCounter::visitTypeSourceInfo(const TypeSourceInfo *TSI,
+                                        FileMemoryCost &File) {
+  if (!TSI)
+    return;
+
+  uint64_t Bytes = sizeof(TypeSourceInfo) +
+                   TSI->getTypeLoc().getFullDataSize();
+  TypeLocs.add(Bytes);
+  File.TypeLocs.add(Bytes);
+}
+
+namespace {
+/// \brief A line of the report.
+struct MemoryReportLine {
+  std::string Name;
+  MemoryCost Cost;
+
+  /// \brief Order the largest lines first.
+  bool operator<(const MemoryReportLine &RHS) const {
+    if (Cost.Bytes != RHS.Cost.Bytes)
+      return Cost.Bytes > RHS.Cost.Bytes;
+    return Name < RHS.Name;
+  }
+};
+}
+
+static uint64_t printClasses(raw_ostream &OS, StringRef Title,
+                             const llvm::StringMap<MemoryCost> &Classes) {
+  std::vector<MemoryReportLine> Lines;
+  uint64_t Total = 0;
+  for (llvm::StringMap<MemoryCost>::const_iterator I = Classes.begin(),
+                                                   E = Classes.end();
+       I != E; ++I) {
+    MemoryReportLine L;
+    L.Name = I->getKey();
+    L.Cost = I->getValue();
+    Lines.push_back(L);
+    Total += L.Cost.Bytes;
+  }
+  std::sort(Lines.begin(), Lines.end());
+
+  OS << "\n  " << Title << ": " << Total << " bytes\n";
+  OS << "         Bytes      Count  Class\n";
+  for (unsigned I = 0, N = Lines.size(); I != N; ++I)
+    OS << llvm::format("  %12llu  %9u  ",
+                       (unsigned long long)Lines[I].Cost.Bytes,
+                       Lines[I].Cost.Count)
+       << Lines[I].Name << '\n';
+  return Total;
+}
+
+static void printFoldingSet(raw_ostream &OS, const char *Name,
+                            llvm::FoldingSetImpl &Set) {
+  // A folding set has a bucket per two nodes of capacity, plus a sentinel.
+  uint64_t BucketBytes = (Set.capacity() / 2 + 1) * sizeof(void *);
+  OS << llvm::format("  %9u  %12llu  ", Set.size(),
+                     (unsigned long long)BucketBytes)
+     << Name << '\n';
+}
+
+void ASTContext::PrintMemoryStats(raw_ostream &OS) const {
+  MemoryCounter Counter(SourceMgr);
+  Counter.visitDecl(getTranslationUnitDecl());
+
+  OS << "\n*** AST Memory Stats:\n";
+  OS << "  " << getASTAllocatedMemory()
+     << " bytes allocated for the AST, " << getSideTableAllocatedMemory()
+     << " bytes in side tables.\n";
+
+  uint64_t Attributed = 0;
+  Attributed += printClasses(OS, "Declarations by class", Counter.DeclClasses);
+  Attributed += printClasses(OS, "Statements by class", Counter.StmtClasses);
+
+  llvm::StringMap<MemoryCost> TypeClasses;
+  for (unsigned I = 0, N = Types.size(); I != N; ++I) {
+    const Type *T = Types[I];
+    uint64_t Bytes = getTypeClassSize(T);
+    if (const FunctionProtoType *FPT = dyn_cast<FunctionProtoType>(T))
+      Bytes += (FPT->getNumArgs() + FPT->getNumExceptions()) *
+               sizeof(QualType);
+    else if (const TemplateSpecializationType *TST =
+               dyn_cast<TemplateSpecializationType>(T))
+      Bytes += TST->getNumArgs() * sizeof(TemplateArgument);
+    else if (const DependentTemplateSpecializationType *DTST =
+               dyn_cast<DependentTemplateSpecializationType>(T))
+      Bytes += DTST->getNumArgs() * sizeof(TemplateArgument);
+    TypeClasses[T->getTypeClassName()].add(Bytes);
+  }
+  Attributed += printClasses(OS, "Types by class", TypeClasses);
+
+  OS << "\n  TypeLoc data: " << Counter.TypeLocs.Bytes << " bytes in "
+     << Counter.TypeLocs.Count << " type source infos\n";
+  Attributed += Counter.TypeLocs.Bytes;
+  OS << "  " << Attributed << " of the allocated bytes attributed to AST "
+     << "nodes.\n";
+
+  OS << "\n  DeclContext lookup tables: " << Counter.LookupTables.Bytes
+     << " bytes in " << Counter.LookupTables.Count << " tables\n";
+
+  OS << "\n  Uniquing tables:\n";
+  OS << "      Nodes  Bucket bytes  Table\n";
+#define PRINT_FOLDING_SET(Set) printFoldingSet(OS, #Set, Set)
+  PRINT_FOLDING_SET(ExtQualNodes);
+  PRINT_FOLDING_SET(ComplexTypes);
+  PRINT_FOLDING_SET(PointerTypes);
+  PRINT_FOLDING_SET(BlockPointerTypes);
+  PRINT_FOLDING_SET(LValueReferenceTypes);
+  PRINT_FOLDING_SET(RValueReferenceTypes);
+  PRINT_FOLDING_SET(MemberPointerTypes);
+  PRINT_FOLDING_SET(ConstantArrayTypes);
+  PRINT_FOLDING_SET(IncompleteArrayTypes);
+  PRINT_FOLDING_SET(DependentSizedArrayTypes);
+  PRINT_FOLDING_SET(DependentSizedExtVectorTypes);
+  PRINT_FOLDING_SET(VectorTypes);
+  PRINT_FOLDING_SET(FunctionNoProtoTypes);
+  PRINT_FOLDING_SET(FunctionProtoTypes);
+  PRINT_FOLDING_SET(DependentTypeOfExprTypes);
+  PRINT_FOLDING_SET(DependentDecltypeTypes);
+  PRINT_FOLDING_SET(TemplateTypeParmTypes);
+  PRINT_FOLDING_SET(SubstTemplateTypeParmTypes);
+  PRINT_FOLDING_SET(SubstTemplateTypeParmPackTypes);
+  PRINT_FOLDING_SET(TemplateSpecializationTypes);
+  PRINT_FOLDING_SET(ParenTypes);
+  PRINT_FOLDING_SET(ElaboratedTypes);
+  PRINT_FOLDING_SET(DependentNameTypes);
+  PRINT_FOLDING_SET(DependentTemplateSpecializationTypes);
+  printFoldingSet(OS, "PackExpansionTypes",
+                  const_cast<llvm::FoldingSet<PackExpansionType> &>(
+                    PackExpansionTypes));
+  PRINT_FOLDING_SET(ObjCObjectTypes);
+  PRINT_FOLDING_SET(ObjCObjectPointerTypes);
+  PRINT_FOLDING_SET(AutoTypes);
+  PRINT_FOLDING_SET(AtomicTypes);
+  printFoldingSet(OS, "AttributedTypes",
+                  const_cast<llvm::FoldingSet<AttributedType> &>(
+                    AttributedTypes));
+  PRINT_FOLDING_SET(QualifiedTemplateNames);
+  PRINT_FOLDING_SET(DependentTemplateNames);
+  PRINT_FOLDING_SET(SubstTemplateTemplateParms);
+  PRINT_FOLDING_SET(SubstTemplateTemplateParmPacks);
+  PRINT_FOLDING_SET(NestedNameSpecifiers);
+  PRINT_FOLDING_SET(CanonTemplateTemplateParms);
+#undef PRINT_FOLDING_SET
+
+  std::vector<std::pair<uint64_t, const FileEntry *> > Files;
+  for (llvm::DenseMap<const FileEntry *, FileMemoryCost>::const_iterator
+         I = Counter.Files.begin(), E = Counter.Files.end(); I != E; ++I)
+    Files.push_back(std::make_pair(I->second.getBytes(), I->first));
+  std::sort(Files.begin(), Files.end());
+
+  OS << "\n  By source file:\n";
+  OS << "         Bytes    Decl bytes    Stmt bytes  TypeLoc bytes  File\n";
+  for (unsigned I = Files.size(); I != 0; --I) {
+    const FileMemoryCost &Cost = Counter.Files[Files[I - 1].second];
+    const FileEntry *File = Files[I - 1].second;
+    OS << llvm::format("  %12llu  %12llu  %12llu  %13llu  ",
+                       (unsigned long long)Cost.getBytes(),
+                       (unsigned long long)Cost.Decls.Bytes,
+                       (unsigned long long)Cost.Stmts.Bytes,
+                       (unsigned long long)Cost.TypeLocs.Bytes)
+       << (File ? File->getName() : "<built-in>") << '\n';
+  }
+}
@@ -25,6 +25,7 @@ clang_ast_SRC_FILES :=	\
 	ASTConsumer.cpp	\
 	ASTContext.cpp	\
 	ASTDiagnostic.cpp	\
+	ASTMemoryStats.cpp	\
 	ASTImporter.cpp	\
 	AttrImpl.cpp	\
 	Comment.cpp \
@@ -14,6 +14,7 @@
 #include "clang/AST/ASTContext.h"
 #include "clang/AST/RecordLayout.h"
 #include "clang/AST/DeclCXX.h"
+#include "llvm/ADT/DenseMap.h"
 #include <algorithm>
 #include <set>
 
@@ -78,10 +79,97 @@ void CXXBasePaths::swap(CXXBasePaths &Other) {
   std::swap(DetectedVirtual, Other.DetectedVirtual);
 }
 
+/// \brief Retrieve the canonical declaration of the class named by a
+/// non-dependent base class specifier.
+static const CXXRecordDecl *getBaseClass(const CXXBaseSpecifier &Spec) {
+  const RecordType *RT = Spec.getType()->getAs<RecordType>();
+  return cast<CXXRecordDecl>(RT->getDecl())->getCanonicalDecl();
+}
+
+/// \brief Add up numbers of subobjects, which only matter up to two.
+static unsigned addSubobjectCounts(unsigned X, unsigned Y) {
+  return std::min(X + Y, 2U);
+}
+
+void CXXRecordDecl::computeTransitiveBases() const {
+  // C++ [class.mi]p4: each non-virtual base class specifier denotes a
+  // distinct subobject, while all of the virtual base class specifiers for
+  // a class denote a single shared subobject. So the subobjects of a class
+  // are those of its non-virtual bases, except for the ones within their
+  // virtual bases, plus those of each of its virtual bases, all of which are
+  // listed among its own. Combining the counts already computed for those
+  // bases avoids walking every path through the hierarchy.
+  SmallVector<std::pair<const CXXRecordDecl *, bool>, 8> Subobjects;
+  for (base_class_const_iterator I = bases_begin(), E = bases_end();
+       I != E; ++I)
+    if (!I->isVirtual() && !I->getType()->isDependentType())
+      Subobjects.push_back(std::make_pair(getBaseClass(*I), false));
+  for (base_class_const_iterator I = vbases_begin(), E = vbases_end();
+       I != E; ++I)
+    if (!I->getType()->isDependentType())
+      Subobjects.push_back(std::make_pair(getBaseClass(*I), true));
+
+  llvm::DenseMap<const CXXRecordDecl *, TransitiveBase> Found;
+  for (unsigned I = 0, N = Subobjects.size(); I != N; ++I) {
+    const CXXRecordDecl *Base = Subobjects[I].first;
+    TransitiveBase &Entry = Found[Base];
+    Entry.Base = Base;
+    if (Subobjects[I].second)
+      Entry.IsVirtual = true;
+    else
+      Entry.NonVirtualSubobjects =
+        addSubobjectCounts(Entry.NonVirtualSubobjects, 1);
+
+    const CXXRecordDecl *Def = Base->getDefinition();
+    if (!Def)
+      continue;
+    if (!Def->data().ComputedTransitiveBases)
+      Def->computeTransitiveBases();
+    for (unsigned J = 0, M = Def->data().NumTransitiveBases; J != M; ++J) {
+      const TransitiveBase &Inner = Def->data().TransitiveBases[J];
+      if (!Inner.NonVirtualSubobjects)
+        continue;
+      TransitiveBase &InnerEntry = Found[Inner.Base];
+      InnerEntry.Base = Inner.Base;
+      InnerEntry.NonVirtualSubobjects =
+        addSubobjectCounts(InnerEntry.NonVirtualSubobjects,
+                           Inner.NonVirtualSubobjects);
+    }
+  }
+
+  TransitiveBase *Bases = 0;
+  if (!Found.empty()) {
+    Bases = new (getASTContext()) TransitiveBase[Found.size()];
+    TransitiveBase *Next = Bases;
+    for (llvm::DenseMap<const CXXRecordDecl *, TransitiveBase>::iterator
+           I = Found.begin(), E = Found.end(); I != E; ++I, ++Next) {
+      *Next = I->second;
+      Next->IsAmbiguous = Next->NonVirtualSubobjects + Next->IsVirtual > 1;
+    }
+    std::sort(Bases, Next);
+  }
+  data().TransitiveBases = Bases;
+  data().NumTransitiveBases = Found.size();
+  data().ComputedTransitiveBases = true;
+}
+
+const CXXRecordDecl::TransitiveBase *
+CXXRecordDecl::findTransitiveBase(const CXXRecordDecl *Base) const {
+  if (!data().ComputedTransitiveBases)
+    computeTransitiveBases();
+
+  TransitiveBase Key;
+  Key.Base = Base->getCanonicalDecl();
+  const TransitiveBase *Begin = data().TransitiveBases;
+  const TransitiveBase *End = Begin + data().NumTransitiveBases;
+  const TransitiveBase *I = std::lower_bound(Begin, End, Key);
+  if (I == End || I->Base != Key.Base)
+    return 0;
+  return I;
+}
+
 bool CXXRecordDecl::isDerivedFrom(const CXXRecordDecl *Base) const {
-  CXXBasePaths Paths(/*FindAmbiguities=*/false, /*RecordPaths=*/false,
-                     /*DetectVirtual=*/false);
-  return isDerivedFrom(Base, Paths);
+  return findTransitiveBase(Base) != 0;
 }
 
 bool CXXRecordDecl::isDerivedFrom(const CXXRecordDecl *Base,
@@ -90,6 +178,10 @@ bool CXXRecordDecl::isDerivedFrom(const CXXRecordDecl *Base,
     return false;
   
   Paths.setOrigin(const_cast<CXXRecordDecl*>(this));
+
+  // Only walk the hierarchy to record the paths to a base that is there.
+  if (!findTransitiveBase(Base))
+    return false;
   return lookupInBases(&FindBaseClass,
                        const_cast<CXXRecordDecl*>(Base->getCanonicalDecl()),
                        Paths);
@@ -99,18 +191,13 @@ bool CXXRecordDecl::isVirtuallyDerivedFrom(const CXXRecordDecl *Base) const {
   if (!getNumVBases())
     return false;
 
-  CXXBasePaths Paths(/*FindAmbiguities=*/false, /*RecordPaths=*/false,
-                     /*DetectVirtual=*/false);
-
-  if (getCanonicalDecl() == Base->getCanonicalDecl())
-    return false;
-  
-  Paths.setOrigin(const_cast<CXXRecordDecl*>(this));
+  const TransitiveBase *Found = findTransitiveBase(Base);
+  return Found && Found->IsVirtual;
+}
 
-  const void *BasePtr = static_cast<const void*>(Base->getCanonicalDecl());
-  return lookupInBases(&FindVirtualBaseClass,
-                       const_cast<void *>(BasePtr),
-                       Paths);
+bool CXXRecordDecl::isAmbiguousBase(const CXXRecordDecl *Base) const {
+  const TransitiveBase *Found = findTransitiveBase(Base);
+  return Found && Found->IsAmbiguous;
 }
 
 static bool BaseIsNot(const CXXRecordDecl *Base, void *OpaqueTarget) {
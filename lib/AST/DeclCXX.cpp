@@ -56,8 +56,10 @@ CXXRecordDecl::DefinitionData::DefinitionData(CXXRecordDecl *D)
     DeclaredCopyConstructor(false), DeclaredMoveConstructor(false),
     DeclaredCopyAssignment(false), DeclaredMoveAssignment(false),
     DeclaredDestructor(false), FailedImplicitMoveConstructor(false),
-    FailedImplicitMoveAssignment(false), IsLambda(false), NumBases(0),
-    NumVBases(0), Bases(), VBases(), Definition(D), FirstFriend(0) {
+    FailedImplicitMoveAssignment(false), IsLambda(false),
+    ComputedTransitiveBases(false), NumBases(0), NumVBases(0), Bases(),
+    VBases(), Definition(D), FirstFriend(0), TransitiveBases(0),
+    NumTransitiveBases(0) {
 }
 
 CXXBaseSpecifier *CXXRecordDecl::DefinitionData::getBasesSlowCase() const {
@@ -114,6 +116,10 @@ CXXRecordDecl::setBases(CXXBaseSpecifier const * const *Bases,
   if (!data().Bases.isOffset() && data().NumBases > 0)
     C.Deallocate(data().getBases());
 
+  // The classes from which this class is derived are computed again from
+  // the new base classes.
+  data().ComputedTransitiveBases = false;
+
   if (NumBases) {
     // C++ [dcl.init.aggr]p1:
     //   An aggregate is [...] a class with [...] no base classes [...].
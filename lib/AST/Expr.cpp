@@ -275,6 +275,27 @@ void DeclRefExpr::computeDependence(ASTContext &Ctx) {
     ExprBits.ContainsUnexpandedParameterPack = true;
 }
 
+/// \brief Whether a reference to a declaration named \p Name has to keep
+/// the DeclarationNameLoc of the name. Plain identifiers, which name almost
+/// every referenced declaration, and selectors carry none.
+static bool hasDeclarationNameLoc(DeclarationName Name) {
+  switch (Name.getNameKind()) {
+  case DeclarationName::Identifier:
+  case DeclarationName::ObjCZeroArgSelector:
+  case DeclarationName::ObjCOneArgSelector:
+  case DeclarationName::ObjCMultiArgSelector:
+  case DeclarationName::CXXUsingDirective:
+    return false;
+  case DeclarationName::CXXConstructorName:
+  case DeclarationName::CXXDestructorName:
+  case DeclarationName::CXXConversionFunctionName:
+  case DeclarationName::CXXOperatorName:
+  case DeclarationName::CXXLiteralOperatorName:
+    return true;
+  }
+  llvm_unreachable("Invalid DeclarationName kind!");
+}
+
 DeclRefExpr::DeclRefExpr(ASTContext &Ctx,
                          NestedNameSpecifierLoc QualifierLoc,
                          SourceLocation TemplateKWLoc,
@@ -284,7 +305,10 @@ DeclRefExpr::DeclRefExpr(ASTContext &Ctx,
                          const TemplateArgumentListInfo *TemplateArgs,
                          QualType T, ExprValueKind VK)
   : Expr(DeclRefExprClass, T, VK, OK_Ordinary, false, false, false, false),
-    D(D), Loc(NameInfo.getLoc()), DNLoc(NameInfo.getInfo()) {
+    D(D), Loc(NameInfo.getLoc()) {
+  DeclRefExprBits.HasNameLoc = hasDeclarationNameLoc(NameInfo.getName());
+  if (hasNameLoc())
+    getInternalNameLoc() = NameInfo.getInfo();
   DeclRefExprBits.HasQualifier = QualifierLoc ? 1 : 0;
   if (QualifierLoc)
     getInternalQualifierLoc() = QualifierLoc;
@@ -343,6 +367,8 @@ DeclRefExpr *DeclRefExpr::Create(ASTContext &Context,
     FoundD = 0;
 
   std::size_t Size = sizeof(DeclRefExpr);
+  if (hasDeclarationNameLoc(NameInfo.getName()))
+    Size += sizeof(DeclarationNameLoc);
   if (QualifierLoc != 0)
     Size += sizeof(NestedNameSpecifierLoc);
   if (FoundD)
@@ -359,11 +385,14 @@ DeclRefExpr *DeclRefExpr::Create(ASTContext &Context,
 }
 
 DeclRefExpr *DeclRefExpr::CreateEmpty(ASTContext &Context,
+                                      bool HasNameLoc,
                                       bool HasQualifier,
                                       bool HasFoundDecl,
                                       bool HasTemplateKWAndArgsInfo,
                                       unsigned NumTemplateArgs) {
   std::size_t Size = sizeof(DeclRefExpr);
+  if (HasNameLoc)
+    Size += sizeof(DeclarationNameLoc);
   if (HasQualifier)
     Size += sizeof(NestedNameSpecifierLoc);
   if (HasFoundDecl)
@@ -1186,8 +1215,13 @@ MemberExpr *MemberExpr::Create(ASTContext &C, Expr *base, bool isarrow,
                                QualType ty,
                                ExprValueKind vk,
                                ExprObjectKind ok) {
+  assert(memberdecl->getDeclName() == nameinfo.getName());
   std::size_t Size = sizeof(MemberExpr);
 
+  bool hasNameLoc = hasDeclarationNameLoc(nameinfo.getName());
+  if (hasNameLoc)
+    Size += sizeof(DeclarationNameLoc);
+
   bool hasQualOrFound = (QualifierLoc ||
                          founddecl.getDecl() != memberdecl ||
                          founddecl.getAccess() != memberdecl->getAccess());
@@ -1200,8 +1234,13 @@ MemberExpr *MemberExpr::Create(ASTContext &C, Expr *base, bool isarrow,
     Size += ASTTemplateKWAndArgsInfo::sizeFor(0);
 
   void *Mem = C.Allocate(Size, llvm::alignOf<MemberExpr>());
-  MemberExpr *E = new (Mem) MemberExpr(base, isarrow, memberdecl, nameinfo,
-                                       ty, vk, ok);
+  MemberExpr *E = new (Mem) MemberExpr(base, isarrow, memberdecl,
+                                       nameinfo.getLoc(), ty, vk, ok);
+
+  if (hasNameLoc) {
+    E->HasNameLoc = true;
+    E->getInternalNameLoc() = nameinfo.getInfo();
+  }
 
   if (hasQualOrFound) {
     // FIXME: Wrong. We should be looking at the member declaration we found.
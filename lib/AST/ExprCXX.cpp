@@ -681,7 +681,8 @@ CXXDefaultArgExpr::Create(ASTContext &C, SourceLocation Loc,
 
 CXXTemporary *CXXTemporary::Create(ASTContext &C,
                                    const CXXDestructorDecl *Destructor) {
-  return new (C) CXXTemporary(Destructor);
+  // A temporary is only referenced from the statements which bind it.
+  return new (C.AllocateStmt(sizeof(CXXTemporary))) CXXTemporary(Destructor);
 }
 
 CXXBindTemporaryExpr *CXXBindTemporaryExpr::Create(ASTContext &C,
@@ -349,6 +349,10 @@ namespace {
   /// evaluate the expression regardless of what the RHS is, but C only allows
   /// certain things in certain situations.
   struct EvalInfo {
+    /// MaxStaticInitializerCalls - The number of calls we are willing to
+    /// evaluate when folding a static initializer.
+    static const unsigned MaxStaticInitializerCalls = 128;
+
     ASTContext &Ctx;
 
     /// EvalStatus - Contains information about the evaluation.
@@ -384,12 +388,28 @@ namespace {
     /// are suppressed.
     bool CheckingPotentialConstantExpression;
 
+    /// FoldingStaticInitializer - Are we folding the initializer of a variable
+    /// with static storage duration, which would otherwise be initialized
+    /// dynamically? If so, calls to functions and constructors which are not
+    /// constexpr are evaluated too, as long as their bodies can be.
+    bool FoldingStaticInitializer;
+
+    /// MaxCallStackDepth - The deepest call which has been checked against the
+    /// call depth limit, used to find how deep a memoized call went.
+    unsigned MaxCallStackDepth;
+
+    /// ReadEvaluatingDecl - Has the in-flight value of EvaluatingDecl been
+    /// read? A call which reads it cannot be memoized.
+    bool ReadEvaluatingDecl;
+
     EvalInfo(const ASTContext &C, Expr::EvalStatus &S)
       : Ctx(const_cast<ASTContext&>(C)), EvalStatus(S), CurrentCall(0),
         CallStackDepth(0), NextCallIndex(1),
         BottomFrame(*this, SourceLocation(), 0, 0, 0),
         EvaluatingDecl(0), EvaluatingDeclValue(0), HasActiveDiagnostic(false),
-        CheckingPotentialConstantExpression(false) {}
+        CheckingPotentialConstantExpression(false),
+        FoldingStaticInitializer(false), MaxCallStackDepth(0),
+        ReadEvaluatingDecl(false) {}
 
     void setEvaluatingDecl(const VarDecl *VD, APValue &Value) {
       EvaluatingDecl = VD;
@@ -403,13 +423,19 @@ namespace {
       // when checking a potential constant expression.
       if (CheckingPotentialConstantExpression && CallStackDepth > 1)
         return false;
+      // Give up on static initializers which need many calls; emitting their
+      // dynamic initialization is cheaper than evaluating them.
+      if (FoldingStaticInitializer && NextCallIndex > MaxStaticInitializerCalls)
+        return false;
       if (NextCallIndex == 0) {
         // NextCallIndex has wrapped around.
         Diag(Loc, diag::note_constexpr_call_limit_exceeded);
         return false;
       }
-      if (CallStackDepth <= getLangOpts().ConstexprCallDepth)
+      if (CallStackDepth <= getLangOpts().ConstexprCallDepth) {
+        MaxCallStackDepth = std::max(MaxCallStackDepth, CallStackDepth);
         return true;
+      }
       Diag(Loc, diag::note_constexpr_depth_limit_exceeded)
         << getLangOpts().ConstexprCallDepth;
       return false;
@@ -1419,8 +1445,8 @@ static bool HandleLValueComplexElement(EvalInfo &Info, const Expr *E,
 
 /// Try to evaluate the initializer for a variable declaration.
 static bool EvaluateVarDeclInit(EvalInfo &Info, const Expr *E,
-                                const VarDecl *VD,
-                                CallStackFrame *Frame, APValue &Result) {
+                                const VarDecl *VD, CallStackFrame *Frame,
+                                const APValue *&Result) {
   // If this is a parameter to an active constexpr function call, perform
   // argument substitution.
   if (const ParmVarDecl *PVD = dyn_cast<ParmVarDecl>(VD)) {
@@ -1432,7 +1458,7 @@ static bool EvaluateVarDeclInit(EvalInfo &Info, const Expr *E,
       Info.Diag(E, diag::note_invalid_subexpr_in_const_expr);
       return false;
     }
-    Result = Frame->Arguments[PVD->getFunctionScopeIndex()];
+    Result = &Frame->Arguments[PVD->getFunctionScopeIndex()];
     return true;
   }
 
@@ -1449,8 +1475,9 @@ static bool EvaluateVarDeclInit(EvalInfo &Info, const Expr *E,
   // If we're currently evaluating the initializer of this declaration, use that
   // in-flight value.
   if (Info.EvaluatingDecl == VD) {
-    Result = *Info.EvaluatingDeclValue;
-    return !Result.isUninit();
+    Info.ReadEvaluatingDecl = true;
+    Result = Info.EvaluatingDeclValue;
+    return !Result->isUninit();
   }
 
   // Never evaluate the initializer of a weak variable. We can't be sure that
@@ -1476,7 +1503,7 @@ static bool EvaluateVarDeclInit(EvalInfo &Info, const Expr *E,
     Info.addNotes(Notes);
   }
 
-  Result = *VD->getEvaluatedValue();
+  Result = VD->getEvaluatedValue();
   return true;
 }
 
@@ -1518,10 +1545,13 @@ static APSInt ExtractStringLiteralCharacter(EvalInfo &Info, const Expr *Lit,
   return Value;
 }
 
-/// Extract the designated sub-object of an rvalue.
+/// Extract the designated sub-object of an rvalue into \p Result, which may be
+/// \p Obj itself. Only the sub-object is copied, so large objects can be read
+/// without copying them as a whole.
 static bool ExtractSubobject(EvalInfo &Info, const Expr *E,
-                             APValue &Obj, QualType ObjType,
-                             const SubobjectDesignator &Sub, QualType SubType) {
+                             const APValue &Obj, QualType ObjType,
+                             const SubobjectDesignator &Sub, QualType SubType,
+                             APValue &Result) {
   if (Sub.Invalid)
     // A diagnostic will have already been produced.
     return false;
@@ -1531,13 +1561,16 @@ static bool ExtractSubobject(EvalInfo &Info, const Expr *E,
                 (unsigned)diag::note_invalid_subexpr_in_const_expr);
     return false;
   }
-  if (Sub.Entries.empty())
+  if (Sub.Entries.empty()) {
+    if (&Result != &Obj)
+      Result = Obj;
     return true;
+  }
   if (Info.CheckingPotentialConstantExpression && Obj.isUninit())
     // This object might be initialized later.
     return false;
 
-  APValue *O = &Obj;
+  const APValue *O = &Obj;
   // Walk the designator's path to find the subobject.
   for (unsigned I = 0, N = Sub.Entries.size(); I != N; ++I) {
     if (ObjType->isArrayType()) {
@@ -1558,7 +1591,7 @@ static bool ExtractSubobject(EvalInfo &Info, const Expr *E,
       if (O->isLValue()) {
         assert(I == N - 1 && "extracting subobject of character?");
         assert(!O->hasLValuePath() || O->getLValuePath().empty());
-        Obj = APValue(ExtractStringLiteralCharacter(
+        Result = APValue(ExtractStringLiteralCharacter(
           Info, O->getLValueBase().get<const Expr*>(), Index, SubType));
         return true;
       } else if (O->getArrayInitializedElts() > Index)
@@ -1577,12 +1610,12 @@ static bool ExtractSubobject(EvalInfo &Info, const Expr *E,
       }
       assert(I == N - 1 && "extracting subobject of scalar?");
       if (O->isComplexInt()) {
-        Obj = APValue(Index ? O->getComplexIntImag()
-                            : O->getComplexIntReal());
+        Result = APValue(Index ? O->getComplexIntImag()
+                               : O->getComplexIntReal());
       } else {
         assert(O->isComplexFloat());
-        Obj = APValue(Index ? O->getComplexFloatImag()
-                            : O->getComplexFloatReal());
+        Result = APValue(Index ? O->getComplexFloatImag()
+                               : O->getComplexFloatReal());
       }
       return true;
     } else if (const FieldDecl *Field = getAsField(Sub.Entries[I])) {
@@ -1634,13 +1667,9 @@ static bool ExtractSubobject(EvalInfo &Info, const Expr *E,
     }
   }
 
-  // This may look super-stupid, but it serves an important purpose: if we just
-  // swapped Obj and *O, we'd create an object which had itself as a subobject.
-  // To avoid the leak, we ensure that Tmp ends up owning the original complete
-  // object, which is destroyed by Tmp's destructor.
-  APValue Tmp;
-  O->swap(Tmp);
-  Obj.swap(Tmp);
+  // The assignment copies *O before releasing the old value of Result, so this
+  // is fine even if O points into Result.
+  Result = *O;
   return true;
 }
 
@@ -1813,26 +1842,28 @@ static bool HandleLValueToRValueConversion(EvalInfo &Info, const Expr *Conv,
       }
     }
 
-    if (!EvaluateVarDeclInit(Info, Conv, VD, Frame, RVal))
+    const APValue *Value;
+    if (!EvaluateVarDeclInit(Info, Conv, VD, Frame, Value))
       return false;
 
     if (isa<ParmVarDecl>(VD) || !VD->getAnyInitializer()->isLValue())
-      return ExtractSubobject(Info, Conv, RVal, VT, LVal.Designator, Type);
+      return ExtractSubobject(Info, Conv, *Value, VT, LVal.Designator, Type,
+                              RVal);
 
     // The declaration was initialized by an lvalue, with no lvalue-to-rvalue
     // conversion. This happens when the declaration and the lvalue should be
     // considered synonymous, for instance when initializing an array of char
     // from a string literal. Continue as if the initializer lvalue was the
     // value we were originally given.
-    assert(RVal.getLValueOffset().isZero() &&
+    assert(Value->getLValueOffset().isZero() &&
            "offset for lvalue init of non-reference");
-    Base = RVal.getLValueBase().get<const Expr*>();
+    Base = Value->getLValueBase().get<const Expr*>();
 
-    if (unsigned CallIndex = RVal.getLValueCallIndex()) {
+    if (unsigned CallIndex = Value->getLValueCallIndex()) {
       Frame = Info.getCallFrame(CallIndex);
       if (!Frame) {
         Info.Diag(Conv, diag::note_constexpr_lifetime_ended, 1) << !Base;
-        NoteLValueLocation(Info, RVal.getLValueBase());
+        NoteLValueLocation(Info, Value->getLValueBase());
         return false;
       }
     } else {
@@ -1854,9 +1885,11 @@ static bool HandleLValueToRValueConversion(EvalInfo &Info, const Expr *Conv,
   if (Frame) {
     // If this is a temporary expression with a nontrivial initializer, grab the
     // value from the relevant stack frame.
-    RVal = Frame->Temporaries[Base];
-  } else if (const CompoundLiteralExpr *CLE
-             = dyn_cast<CompoundLiteralExpr>(Base)) {
+    return ExtractSubobject(Info, Conv, Frame->Temporaries[Base],
+                            Base->getType(), LVal.Designator, Type, RVal);
+  }
+
+  if (const CompoundLiteralExpr *CLE = dyn_cast<CompoundLiteralExpr>(Base)) {
     // In C99, a CompoundLiteralExpr is an lvalue, and we defer evaluating the
     // initializer until now for such expressions. Such an expression can't be
     // an ICE in C, so this only matters for fold.
@@ -1874,7 +1907,7 @@ static bool HandleLValueToRValueConversion(EvalInfo &Info, const Expr *Conv,
   }
 
   return ExtractSubobject(Info, Conv, RVal, Base->getType(), LVal.Designator,
-                          Type);
+                          Type, RVal);
 }
 
 /// Build an lvalue for the object argument of a member function call.
@@ -2043,9 +2076,21 @@ static EvalStmtResult EvaluateStmt(APValue &Result, EvalInfo &Info,
     return ESR_Failed;
 
   case Stmt::NullStmtClass:
-  case Stmt::DeclStmtClass:
     return ESR_Succeeded;
 
+  case Stmt::DeclStmtClass: {
+    // The body of a constexpr function cannot declare variables, but the body
+    // of another function being folded might.
+    if (Info.FoldingStaticInitializer) {
+      const DeclStmt *DS = cast<DeclStmt>(S);
+      for (DeclStmt::const_decl_iterator DI = DS->decl_begin(),
+             DE = DS->decl_end(); DI != DE; ++DI)
+        if (isa<VarDecl>(*DI))
+          return ESR_Failed;
+    }
+    return ESR_Succeeded;
+  }
+
   case Stmt::ReturnStmtClass: {
     const Expr *RetExpr = cast<ReturnStmt>(S)->getRetValue();
     if (!Evaluate(Result, Info, RetExpr))
@@ -2108,6 +2153,12 @@ static bool CheckConstexprFunction(EvalInfo &Info, SourceLocation CallLoc,
   if (Definition && Definition->isConstexpr() && !Definition->isInvalidDecl())
     return true;
 
+  // When folding a static initializer, any defined function will do; its
+  // body is still required to be evaluatable.
+  if (Info.FoldingStaticInitializer && Definition &&
+      !Definition->isInvalidDecl())
+    return true;
+
   if (Info.getLangOpts().CPlusPlus0x) {
     const FunctionDecl *DiagDecl = Definition ? Definition : Declaration;
     // FIXME: If DiagDecl is an implicitly-declared special member function, we
@@ -2143,6 +2194,125 @@ static bool EvaluateArgs(ArrayRef<const Expr*> Args, ArgVector &ArgValues,
   return Success;
 }
 
+//===----------------------------------------------------------------------===//
+// Memoization of constexpr function calls
+//===----------------------------------------------------------------------===//
+
+namespace clang {
+/// ConstexprCallCache - The results of calls to constexpr functions outside
+/// of classes, keyed by the callee and the values of the arguments.
+///
+/// Only calls which depend on nothing but their arguments are memoized: the
+/// arguments and the result must not refer to any object, and the call must
+/// have been evaluated without side effects or notes.
+class ConstexprCallCache {
+public:
+  struct Entry : llvm::FoldingSetNode {
+    llvm::FoldingSetNodeID Key;
+
+    /// Result - The value the call returned.
+    APValue Result;
+
+    /// Depth - How many calls deeper than the memoized call itself the
+    /// evaluation went.
+    unsigned Depth;
+
+    void Profile(llvm::FoldingSetNodeID &ID) const { ID = Key; }
+  };
+
+  /// MaxValues - The number of scalar values the arguments and the results of
+  /// all entries may hold together; once it is reached, no further calls are
+  /// memoized.
+  static const unsigned MaxValues = 1 << 20;
+
+  llvm::FoldingSet<Entry> Entries;
+
+  /// NumValues - The number of scalar values held by all entries.
+  unsigned NumValues;
+
+  ConstexprCallCache() : NumValues(0) {}
+
+  ~ConstexprCallCache() {
+    for (llvm::FoldingSet<Entry>::iterator I = Entries.begin(),
+         E = Entries.end(); I != E; )
+      delete &*I++;
+  }
+
+  static void Destroy(void *Cache) {
+    delete static_cast<ConstexprCallCache*>(Cache);
+  }
+};
+}
+
+ConstexprCallCache &ASTContext::getConstexprCallCache() const {
+  if (!ConstexprCalls) {
+    ConstexprCalls = new ConstexprCallCache;
+    const_cast<ASTContext*>(this)->AddDeallocation(ConstexprCallCache::Destroy,
+                                                   ConstexprCalls);
+  }
+  return *ConstexprCalls;
+}
+
+/// Add the value \p V to \p ID, and the number of scalar values in it to
+/// \p NumValues. Returns false if \p V refers to an object, in which case it
+/// cannot be part of a memoized call.
+static bool ProfileCallValue(llvm::FoldingSetNodeID &ID, const APValue &V,
+                             unsigned &NumValues) {
+  ID.AddInteger(V.getKind());
+  ++NumValues;
+  switch (V.getKind()) {
+  case APValue::Uninitialized:
+    return true;
+  case APValue::Int:
+    V.getInt().Profile(ID);
+    return true;
+  case APValue::Float:
+    V.getFloat().Profile(ID);
+    return true;
+  case APValue::ComplexInt:
+    V.getComplexIntReal().Profile(ID);
+    V.getComplexIntImag().Profile(ID);
+    return true;
+  case APValue::ComplexFloat:
+    V.getComplexFloatReal().Profile(ID);
+    V.getComplexFloatImag().Profile(ID);
+    return true;
+  case APValue::Vector:
+    ID.AddInteger(V.getVectorLength());
+    for (unsigned I = 0, N = V.getVectorLength(); I != N; ++I)
+      if (!ProfileCallValue(ID, V.getVectorElt(I), NumValues))
+        return false;
+    return true;
+  case APValue::Array:
+    ID.AddInteger(V.getArraySize());
+    ID.AddInteger(V.getArrayInitializedElts());
+    for (unsigned I = 0, N = V.getArrayInitializedElts(); I != N; ++I)
+      if (!ProfileCallValue(ID, V.getArrayInitializedElt(I), NumValues))
+        return false;
+    return !V.hasArrayFiller() ||
+           ProfileCallValue(ID, V.getArrayFiller(), NumValues);
+  case APValue::Struct:
+    ID.AddInteger(V.getStructNumBases());
+    ID.AddInteger(V.getStructNumFields());
+    for (unsigned I = 0, N = V.getStructNumBases(); I != N; ++I)
+      if (!ProfileCallValue(ID, V.getStructBase(I), NumValues))
+        return false;
+    for (unsigned I = 0, N = V.getStructNumFields(); I != N; ++I)
+      if (!ProfileCallValue(ID, V.getStructField(I), NumValues))
+        return false;
+    return true;
+  case APValue::Union:
+    ID.AddPointer(V.getUnionField());
+    return !V.getUnionField() ||
+           ProfileCallValue(ID, V.getUnionValue(), NumValues);
+  case APValue::LValue:
+  case APValue::MemberPointer:
+  case APValue::AddrLabelDiff:
+    return false;
+  }
+  llvm_unreachable("unknown APValue kind");
+}
+
 /// Evaluate a function call.
 static bool HandleFunctionCall(SourceLocation CallLoc,
                                const FunctionDecl *Callee, const LValue *This,
@@ -2152,11 +2322,74 @@ static bool HandleFunctionCall(SourceLocation CallLoc,
   if (!EvaluateArgs(Args, ArgValues, Info))
     return false;
 
+  // Look for the result of an identical call. A member function could depend
+  // on the object it is called on.
+  llvm::FoldingSetNodeID Key;
+  unsigned NumValues = 0;
+  bool Memoize = !This && !Info.CheckingPotentialConstantExpression;
+  if (Memoize) {
+    Key.AddPointer(Callee);
+    for (unsigned I = 0, N = ArgValues.size(); Memoize && I != N; ++I)
+      Memoize = ProfileCallValue(Key, ArgValues[I], NumValues);
+  }
+
+  ConstexprCallCache *Cache = 0;
+  if (Memoize) {
+    Cache = &Info.Ctx.getConstexprCallCache();
+    void *InsertPos;
+    if (ConstexprCallCache::Entry *Found =
+          Cache->Entries.FindNodeOrInsertPos(Key, InsertPos)) {
+      // The call must still fit within the call depth limit.
+      unsigned Depth = Info.CallStackDepth + Found->Depth;
+      if (Depth <= Info.getLangOpts().ConstexprCallDepth) {
+        Info.MaxCallStackDepth = std::max(Info.MaxCallStackDepth, Depth);
+        ++ASTContext::NumConstexprCallCacheHits;
+        Result = Found->Result;
+        return true;
+      }
+      Memoize = false;
+    }
+  }
+
   if (!Info.CheckCallLimit(CallLoc))
     return false;
 
-  CallStackFrame Frame(Info, CallLoc, Callee, This, ArgValues.data());
-  return EvaluateStmt(Result, Info, Body) == ESR_Returned;
+  // Only a call which produces no notes and no side effects can be memoized.
+  // Notes are dropped altogether without a diagnostic list, so such calls are
+  // not memoized either.
+  Memoize = Memoize && Info.EvalStatus.Diag && Info.EvalStatus.Diag->empty() &&
+            !Info.EvalStatus.HasSideEffects &&
+            Cache->NumValues + NumValues < ConstexprCallCache::MaxValues;
+  unsigned SavedMaxDepth = Info.MaxCallStackDepth;
+  bool SavedReadEvaluatingDecl = Info.ReadEvaluatingDecl;
+  Info.MaxCallStackDepth = Info.CallStackDepth;
+  Info.ReadEvaluatingDecl = false;
+
+  bool Success;
+  {
+    CallStackFrame Frame(Info, CallLoc, Callee, This, ArgValues.data());
+    Success = EvaluateStmt(Result, Info, Body) == ESR_Returned;
+  }
+
+  if (Success && Memoize && Info.EvalStatus.Diag->empty() &&
+      !Info.EvalStatus.HasSideEffects && !Info.ReadEvaluatingDecl) {
+    llvm::FoldingSetNodeID ResultID;
+    if (ProfileCallValue(ResultID, Result, NumValues)) {
+      // Nested calls may have added entries, so the insertion position found
+      // above is stale.
+      ConstexprCallCache::Entry *New = new ConstexprCallCache::Entry;
+      New->Key = Key;
+      New->Result = Result;
+      New->Depth = Info.MaxCallStackDepth - Info.CallStackDepth;
+      Cache->Entries.InsertNode(New);
+      Cache->NumValues += NumValues;
+      ++ASTContext::NumConstexprCallsMemoized;
+    }
+  }
+
+  Info.MaxCallStackDepth = std::max(Info.MaxCallStackDepth, SavedMaxDepth);
+  Info.ReadEvaluatingDecl |= SavedReadEvaluatingDecl;
+  return Success;
 }
 
 /// Evaluate a constructor call.
@@ -2177,6 +2410,15 @@ static bool HandleConstructorCall(SourceLocation CallLoc, const LValue &This,
     return false;
   }
 
+  // The body of a constexpr constructor is empty, and we don't evaluate it.
+  // Other constructors can only be folded if theirs is empty too.
+  if (Info.FoldingStaticInitializer) {
+    const CompoundStmt *Body =
+      dyn_cast_or_null<CompoundStmt>(Definition->getBody());
+    if (!Body || !Body->body_empty())
+      return false;
+  }
+
   CallStackFrame Frame(Info, CallLoc, Definition, &This, ArgValues.data());
 
   // If it's a delegating constructor, just delegate.
@@ -2600,7 +2842,8 @@ public:
     SubobjectDesignator Designator(BaseTy);
     Designator.addDeclUnchecked(FD);
 
-    return ExtractSubobject(Info, E, Val, BaseTy, Designator, E->getType()) &&
+    return ExtractSubobject(Info, E, Val, BaseTy, Designator, E->getType(),
+                            Val) &&
            DerivedSuccess(Val, E);
   }
 
@@ -2848,10 +3091,10 @@ bool LValueExprEvaluator::VisitVarDecl(const Expr *E, const VarDecl *VD) {
     return Success(VD);
   }
 
-  APValue V;
+  const APValue *V;
   if (!EvaluateVarDeclInit(Info, E, VD, Info.CurrentCall, V))
     return false;
-  return Success(V, E);
+  return Success(*V, E);
 }
 
 bool LValueExprEvaluator::VisitMaterializeTemporaryExpr(
@@ -6344,6 +6587,35 @@ bool Expr::EvaluateAsInitializer(APValue &Value, const ASTContext &Ctx,
                                  Value);
 }
 
+bool Expr::EvaluateAsStaticInitializer(APValue &Value, const ASTContext &Ctx,
+                                       const VarDecl *VD) const {
+  assert(Ctx.getLangOpts().CPlusPlus && !VD->hasLocalStorage() &&
+         "not a C++ variable with static storage duration");
+  Expr::EvalStatus EStatus;
+  EvalInfo InitInfo(Ctx, EStatus);
+  InitInfo.setEvaluatingDecl(VD, Value);
+  InitInfo.FoldingStaticInitializer = true;
+
+  LValue LVal;
+  LVal.set(VD);
+
+  // The variable is zero-initialized before its initializer runs.
+  if (!VD->getType()->isReferenceType()) {
+    ImplicitValueInitExpr VIE(VD->getType());
+    if (!EvaluateInPlace(Value, InitInfo, LVal, &VIE, CCEK_Constant,
+                         /*AllowNonLiteralTypes=*/true))
+      return false;
+  }
+
+  if (!EvaluateInPlace(Value, InitInfo, LVal, this, CCEK_Constant,
+                       /*AllowNonLiteralTypes=*/true) ||
+      EStatus.HasSideEffects)
+    return false;
+
+  return CheckConstantExpression(InitInfo, VD->getLocation(), VD->getType(),
+                                 Value);
+}
+
 /// isEvaluatable - Call EvaluateAsRValue to see if this expression can be
 /// constant folded, but discard the result.
 bool Expr::isEvaluatable(const ASTContext &Ctx) const {
@@ -26,6 +26,8 @@
 #include "clang/Basic/ABI.h"
 #include "clang/Basic/SourceManager.h"
 #include "clang/Basic/TargetInfo.h"
+#include "llvm/ADT/STLExtras.h"
+#include "llvm/ADT/SmallString.h"
 #include "llvm/ADT/StringExtras.h"
 #include "llvm/Support/raw_ostream.h"
 #include "llvm/Support/ErrorHandling.h"
@@ -90,16 +92,50 @@ static const NamedDecl *getStructor(const NamedDecl *decl) {
                                                     
 static const unsigned UnknownArity = ~0U;
 
+/// MangledTypeFragment - The mangling of a class template specialization
+/// type, which later manglings can reuse instead of mangling the type again.
+///
+/// The mangling of a type depends on the substitutions made before it only
+/// through the candidates it looks up, so the fragment can be reused by any
+/// mangler which has none of them as substitutions yet.
+struct MangledTypeFragment {
+  /// Text - The mangling, without its back-references.
+  std::string Text;
+
+  /// References - The back-references to substitutions made within the
+  /// fragment, as their offset into Text and their sequence number relative
+  /// to the first substitution the fragment made.
+  SmallVector<std::pair<unsigned, unsigned>, 4> References;
+
+  /// Lookups - The candidates for substitution which were looked up without
+  /// being found.
+  SmallVector<uintptr_t, 8> Lookups;
+
+  /// Substitutions - The substitutions the fragment made, in order.
+  SmallVector<uintptr_t, 8> Substitutions;
+};
+
 class ItaniumMangleContext : public MangleContext {
   llvm::DenseMap<const TagDecl *, uint64_t> AnonStructIds;
   unsigned Discriminator;
   llvm::DenseMap<const NamedDecl*, unsigned> Uniquifier;
+  llvm::DenseMap<const Type *, MangledTypeFragment *> TypeFragments;
   
 public:
   explicit ItaniumMangleContext(ASTContext &Context,
                                 DiagnosticsEngine &Diags)
     : MangleContext(Context, Diags) { }
 
+  ~ItaniumMangleContext() {
+    llvm::DeleteContainerSeconds(TypeFragments);
+  }
+
+  /// getTypeFragment - Return the cached mangling of the given canonical
+  /// type, or null if it has not been cached.
+  MangledTypeFragment *&getTypeFragment(const Type *T) {
+    return TypeFragments[T];
+  }
+
   uint64_t getAnonymousStructId(const TagDecl *TD) {
     std::pair<llvm::DenseMap<const TagDecl *,
       uint64_t>::iterator, bool> Result =
@@ -219,13 +255,20 @@ class CXXNameMangler {
 
   llvm::DenseMap<uintptr_t, unsigned> Substitutions;
 
+  /// Recording - The fragment this mangler is recording, if any.
+  MangledTypeFragment *Recording;
+
+  /// RecordingIsReusable - Whether the fragment being recorded is
+  /// independent of the state the mangler started in.
+  bool RecordingIsReusable;
+
   ASTContext &getASTContext() const { return Context.getASTContext(); }
 
 public:
   CXXNameMangler(ItaniumMangleContext &C, raw_ostream &Out_,
                  const NamedDecl *D = 0)
     : Context(C), Out(Out_), Structor(getStructor(D)), StructorType(0),
-      SeqID(0) {
+      SeqID(0), Recording(0), RecordingIsReusable(false) {
     // These can't be mangled without a ctor type or dtor type.
     assert(!D || (!isa<CXXDestructorDecl>(D) &&
                   !isa<CXXConstructorDecl>(D)));
@@ -233,15 +276,25 @@ public:
   CXXNameMangler(ItaniumMangleContext &C, raw_ostream &Out_,
                  const CXXConstructorDecl *D, CXXCtorType Type)
     : Context(C), Out(Out_), Structor(getStructor(D)), StructorType(Type),
-      SeqID(0) { }
+      SeqID(0), Recording(0), RecordingIsReusable(false) { }
   CXXNameMangler(ItaniumMangleContext &C, raw_ostream &Out_,
                  const CXXDestructorDecl *D, CXXDtorType Type)
     : Context(C), Out(Out_), Structor(getStructor(D)), StructorType(Type),
-      SeqID(0) { }
+      SeqID(0), Recording(0), RecordingIsReusable(false) { }
+
+  /// Create a mangler which continues from the state of \p Outer, recording
+  /// what it mangles into \p Fragment.
+  CXXNameMangler(CXXNameMangler &Outer, raw_ostream &Out_,
+                 MangledTypeFragment &Fragment)
+    : Context(Outer.Context), Out(Out_), Structor(Outer.Structor),
+      StructorType(Outer.StructorType), SeqID(Outer.SeqID),
+      FunctionTypeDepth(Outer.FunctionTypeDepth),
+      Substitutions(Outer.Substitutions), Recording(&Fragment),
+      RecordingIsReusable(true) { }
 
 #if MANGLE_CHECKER
   ~CXXNameMangler() {
-    if (Out.str()[0] == '\01')
+    if (Recording || Out.str()[0] == '\01')
       return;
 
     int status = 0;
@@ -267,6 +320,11 @@ private:
   bool mangleSubstitution(QualType T);
   bool mangleSubstitution(TemplateName Template);
   bool mangleSubstitution(uintptr_t Ptr);
+  void mangleSeqID(unsigned SeqID);
+
+  bool mangleCachedType(const Type *T);
+  bool canReuseFragment(const MangledTypeFragment &Fragment) const;
+  void mangleFragment(const MangledTypeFragment &Fragment);
 
   void mangleExistingSubstitution(QualType type);
   void mangleExistingSubstitution(TemplateName name);
@@ -1149,6 +1207,8 @@ void CXXNameMangler::mangleUnqualifiedName(const NamedDecl *ND,
     llvm_unreachable("Can't mangle Objective-C selector names here!");
 
   case DeclarationName::CXXConstructorName:
+    if (Recording)
+      RecordingIsReusable = false;
     if (ND == Structor)
       // If the named decl is the C++ constructor we're mangling, use the type
       // we were given.
@@ -1160,6 +1220,8 @@ void CXXNameMangler::mangleUnqualifiedName(const NamedDecl *ND,
     break;
 
   case DeclarationName::CXXDestructorName:
+    if (Recording)
+      RecordingIsReusable = false;
     if (ND == Structor)
       // If the named decl is the C++ destructor we're mangling, use the type we
       // were given.
@@ -1796,7 +1858,7 @@ void CXXNameMangler::mangleType(QualType T) {
     // Recurse:  even if the qualified type isn't yet substitutable,
     // the unqualified type might be.
     mangleType(QualType(ty, 0));
-  } else {
+  } else if (!mangleCachedType(ty)) {
     switch (ty->getTypeClass()) {
 #define ABSTRACT_TYPE(CLASS, PARENT)
 #define NON_CANONICAL_TYPE(CLASS, PARENT) \
@@ -3251,10 +3313,30 @@ bool CXXNameMangler::mangleSubstitution(TemplateName Template) {
 
 bool CXXNameMangler::mangleSubstitution(uintptr_t Ptr) {
   llvm::DenseMap<uintptr_t, unsigned>::iterator I = Substitutions.find(Ptr);
-  if (I == Substitutions.end())
+  if (I == Substitutions.end()) {
+    if (Recording)
+      Recording->Lookups.push_back(Ptr);
     return false;
+  }
+
+  if (Recording) {
+    // A reference to a substitution made before the fragment ties the
+    // fragment to this mangler.
+    unsigned FirstSeqID = SeqID - Recording->Substitutions.size();
+    if (I->second < FirstSeqID)
+      RecordingIsReusable = false;
+    else {
+      Recording->References.push_back(
+        std::make_pair(unsigned(Out.tell()), I->second - FirstSeqID));
+      return true;
+    }
+  }
+
+  mangleSeqID(I->second);
+  return true;
+}
 
-  unsigned SeqID = I->second;
+void CXXNameMangler::mangleSeqID(unsigned SeqID) {
   if (SeqID == 0)
     Out << "S_";
   else {
@@ -3279,10 +3361,79 @@ bool CXXNameMangler::mangleSubstitution(uintptr_t Ptr) {
         << StringRef(BufferPtr, llvm::array_endof(Buffer)-BufferPtr)
         << '_';
   }
+}
+
+/// mangleCachedType - Mangle a class template specialization type through
+/// the context's cache of type manglings, which saves mangling its template
+/// arguments again. Returns false if the type cannot be cached.
+bool CXXNameMangler::mangleCachedType(const Type *T) {
+  // Template parameters and function parameters are mangled relative to the
+  // entity being mangled.
+  if (Recording || FunctionTypeDepth.getDepth() ||
+      T->isInstantiationDependentType())
+    return false;
+  const RecordType *RT = dyn_cast<RecordType>(T);
+  if (!RT || !isa<ClassTemplateSpecializationDecl>(RT->getDecl()))
+    return false;
+
+  MangledTypeFragment *Cached = Context.getTypeFragment(T);
+  if (Cached && canReuseFragment(*Cached)) {
+    mangleFragment(*Cached);
+    return true;
+  }
+
+  MangledTypeFragment *Fragment = new MangledTypeFragment;
+  bool IsReusable;
+  {
+    SmallString<64> Buffer;
+    llvm::raw_svector_ostream Stream(Buffer);
+    CXXNameMangler Recorder(*this, Stream, *Fragment);
+    Recorder.mangleType(RT);
+    Stream.flush();
+    Fragment->Text = Buffer.str();
+    IsReusable = Recorder.RecordingIsReusable;
+  }
+
+  mangleFragment(*Fragment);
+  if (IsReusable) {
+    // Replace a fragment which no longer matched the names being mangled.
+    MangledTypeFragment *&Entry = Context.getTypeFragment(T);
+    delete Entry;
+    Entry = Fragment;
+  } else
+    delete Fragment;
+  return true;
+}
 
+/// canReuseFragment - Whether mangling the type of the given fragment now
+/// would produce the fragment again.
+bool CXXNameMangler::canReuseFragment(
+                                 const MangledTypeFragment &Fragment) const {
+  for (unsigned I = 0, N = Fragment.Lookups.size(); I != N; ++I)
+    if (Substitutions.count(Fragment.Lookups[I]))
+      return false;
+  for (unsigned I = 0, N = Fragment.Substitutions.size(); I != N; ++I)
+    if (Substitutions.count(Fragment.Substitutions[I]))
+      return false;
   return true;
 }
 
+void CXXNameMangler::mangleFragment(const MangledTypeFragment &Fragment) {
+  unsigned FirstSeqID = SeqID;
+  StringRef Text = Fragment.Text;
+  unsigned Pos = 0;
+  for (unsigned I = 0, N = Fragment.References.size(); I != N; ++I) {
+    unsigned Offset = Fragment.References[I].first;
+    Out << Text.slice(Pos, Offset);
+    mangleSeqID(FirstSeqID + Fragment.References[I].second);
+    Pos = Offset;
+  }
+  Out << Text.substr(Pos);
+
+  for (unsigned I = 0, N = Fragment.Substitutions.size(); I != N; ++I)
+    addSubstitution(Fragment.Substitutions[I]);
+}
+
 static bool isCharType(QualType T) {
   if (T.isNull())
     return false;
@@ -3438,6 +3589,8 @@ void CXXNameMangler::addSubstitution(TemplateName Template) {
 void CXXNameMangler::addSubstitution(uintptr_t Ptr) {
   assert(!Substitutions.count(Ptr) && "Substitution already exists!");
   Substitutions[Ptr] = SeqID++;
+  if (Recording)
+    Recording->Substitutions.push_back(Ptr);
 }
 
 //
@@ -214,6 +214,8 @@ void RawCommentList::addComment(const RawComment &RC,
     // If they are, just pop a few last comments that don't fit.
     // This happens if an \#include directive contains comments.
     Comments.pop_back();
+    if (Comments.size() < NumIndexedComments)
+      clearCommentsInFile();
   }
 
   if (OnlyWhitespaceSeen) {
@@ -261,3 +263,23 @@ void RawCommentList::addComment(const RawComment &RC,
   OnlyWhitespaceSeen = true;
 }
 
+ArrayRef<RawCommentList::CommentInFile>
+RawCommentList::getCommentsInFile(FileID FID) const {
+  // Index the comments added since the last lookup.  Comments are only ever
+  // added at the end, in source order, so each file keeps its comments
+  // sorted.
+  for (unsigned N = Comments.size(); NumIndexedComments != N;
+       ++NumIndexedComments) {
+    RawComment *RC = Comments[NumIndexedComments];
+    std::pair<FileID, unsigned> Loc
+      = SourceMgr.getDecomposedLoc(RC->getSourceRange().getBegin());
+    CommentInFile C = { Loc.second, RC };
+    CommentsInFile[Loc.first].push_back(C);
+  }
+
+  llvm::DenseMap<FileID, std::vector<CommentInFile> >::const_iterator Pos
+    = CommentsInFile.find(FID);
+  if (Pos == CommentsInFile.end())
+    return ArrayRef<CommentInFile>();
+  return Pos->second;
+}
@@ -19,6 +19,7 @@
 #include "clang/Sema/SemaDiagnostic.h"
 #include "llvm/Support/Format.h"
 #include "llvm/ADT/SmallSet.h"
+#include "llvm/ADT/STLExtras.h"
 #include "llvm/Support/MathExtras.h"
 #include "llvm/Support/CrashRecoveryContext.h"
 
@@ -2381,6 +2382,22 @@ RecordLayoutBuilder::Diag(SourceLocation Loc, unsigned DiagID) {
   return Context.getDiagnostics().Report(Loc, DiagID);
 }
 
+/// \brief Whether the warnings which laying out \p D could produce are all
+/// ignored, so that a layout stored in an AST file can be used instead.
+static bool areLayoutWarningsIgnored(const ASTContext &Context,
+                                     const RecordDecl *D) {
+  static const unsigned LayoutWarnings[] = {
+    diag::warn_padded_struct_size, diag::warn_padded_struct_field,
+    diag::warn_padded_struct_anon_field, diag::warn_unnecessary_packed
+  };
+  DiagnosticsEngine &Diags = Context.getDiagnostics();
+  for (unsigned I = 0, N = llvm::array_lengthof(LayoutWarnings); I != N; ++I)
+    if (Diags.getDiagnosticLevel(LayoutWarnings[I], D->getLocation())
+          != DiagnosticsEngine::Ignored)
+      return false;
+  return true;
+}
+
 /// getASTRecordLayout - Get or compute information about the layout of the
 /// specified record (struct/union/class), which indicates its size and field
 /// position information.
@@ -2401,12 +2418,19 @@ ASTContext::getASTRecordLayout(const RecordDecl *D) const {
   // Look up this layout, if already laid out, return what we have.
   // Note that we can't save a reference to the entry because this function
   // is recursive.
+  LayoutLockGuard Guard(*this);
   const ASTRecordLayout *Entry = ASTRecordLayouts[D];
   if (Entry) return *Entry;
 
-  const ASTRecordLayout *NewEntry;
+  // An AST file may have stored the layout it computed for the record.
+  const ASTRecordLayout *NewEntry = 0;
+  if (D->isFromASTFile() && areLayoutWarningsIgnored(*this, D))
+    if (ExternalASTSource *External = getExternalSource())
+      NewEntry = External->getRecordLayout(D);
 
-  if (const CXXRecordDecl *RD = dyn_cast<CXXRecordDecl>(D)) {
+  if (NewEntry) {
+    // Nothing to lay out.
+  } else if (const CXXRecordDecl *RD = dyn_cast<CXXRecordDecl>(D)) {
     EmptySubobjectMap EmptySubobjects(*this, RD);
     RecordLayoutBuilder Builder(*this, &EmptySubobjects);
     Builder.Layout(RD);
@@ -2478,6 +2502,7 @@ const CXXMethodDecl *ASTContext::getKeyFunction(const CXXRecordDecl *RD) {
   RD = cast<CXXRecordDecl>(RD->getDefinition());
   assert(RD && "Cannot get key function for forward declarations!");
 
+  LayoutLockGuard Guard(*this);
   const CXXMethodDecl *&Entry = KeyFunctions[RD];
   if (!Entry)
     Entry = RecordLayoutBuilder::ComputeKeyFunction(RD);
@@ -2522,6 +2547,7 @@ ASTContext::getObjCLayout(const ObjCInterfaceDecl *D,
   assert(D && D->isThisDeclarationADefinition() && "Invalid interface decl!");
 
   // Look up this layout, if already laid out, return what we have.
+  LayoutLockGuard Guard(*this);
   const ObjCContainerDecl *Key =
     Impl ? (const ObjCContainerDecl*) Impl : (const ObjCContainerDecl*) D;
   if (const ASTRecordLayout *Entry = ObjCLayouts[Key])
@@ -169,11 +169,36 @@ void StmtPrinter::VisitLabelStmt(LabelStmt *Node) {
 }
 
 void StmtPrinter::VisitAttributedStmt(AttributedStmt *Node) {
-  OS << "[[";
-  bool first = true;
+  // Loop hints are printed as the pragmas they were written as, each on a
+  // line of its own.
+  SmallVector<const Attr*, 4> Attrs;
+  bool PrintedPragma = false;
   for (ArrayRef<const Attr*>::iterator it = Node->getAttrs().begin(),
                                        end = Node->getAttrs().end();
                                        it != end; ++it) {
+    if (!isa<LoopHintAttr>(*it)) {
+      Attrs.push_back(*it);
+      continue;
+    }
+    if (PrintedPragma)
+      Indent();
+    (*it)->printPretty(OS, Policy);
+    OS << "\n";
+    PrintedPragma = true;
+  }
+
+  if (Attrs.empty()) {
+    PrintStmt(Node->getSubStmt(), 0);
+    return;
+  }
+  if (PrintedPragma)
+    Indent();
+
+  OS << "[[";
+  bool first = true;
+  for (SmallVector<const Attr*, 4>::iterator it = Attrs.begin(),
+                                             end = Attrs.end();
+                                             it != end; ++it) {
     if (!first) {
       OS << ", ";
       first = false;
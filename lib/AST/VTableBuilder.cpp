@@ -124,7 +124,8 @@ private:
 public:
   FinalOverriders(const CXXRecordDecl *MostDerivedClass,
                   CharUnits MostDerivedClassOffset,
-                  const CXXRecordDecl *LayoutClass);
+                  const CXXRecordDecl *LayoutClass,
+                  const CXXFinalOverriderMap &FinalOverriders);
 
   /// getOverrider - Get the final overrider for the given method declaration in
   /// the subobject with the given base offset. 
@@ -149,7 +150,8 @@ public:
 
 FinalOverriders::FinalOverriders(const CXXRecordDecl *MostDerivedClass,
                                  CharUnits MostDerivedClassOffset,
-                                 const CXXRecordDecl *LayoutClass)
+                                 const CXXRecordDecl *LayoutClass,
+                                 const CXXFinalOverriderMap &FinalOverriders)
   : MostDerivedClass(MostDerivedClass), 
   MostDerivedClassOffset(MostDerivedClassOffset), LayoutClass(LayoutClass),
   Context(MostDerivedClass->getASTContext()),
@@ -165,10 +167,6 @@ FinalOverriders::FinalOverriders(const CXXRecordDecl *MostDerivedClass,
                      SubobjectOffsets, SubobjectLayoutClassOffsets, 
                      SubobjectCounts);
 
-  // Get the final overriders.
-  CXXFinalOverriderMap FinalOverriders;
-  MostDerivedClass->getFinalOverriders(FinalOverriders);
-
   for (CXXFinalOverriderMap::const_iterator I = FinalOverriders.begin(),
        E = FinalOverriders.end(); I != E; ++I) {
     const CXXMethodDecl *MD = I->first;
@@ -993,7 +991,8 @@ public:
     MostDerivedClassOffset(MostDerivedClassOffset), 
     MostDerivedClassIsVirtual(MostDerivedClassIsVirtual), 
     LayoutClass(LayoutClass), Context(MostDerivedClass->getASTContext()), 
-    Overriders(MostDerivedClass, MostDerivedClassOffset, LayoutClass) {
+    Overriders(MostDerivedClass, MostDerivedClassOffset, LayoutClass,
+               VTables.getFinalOverriders(MostDerivedClass)) {
 
     LayoutVTable();
 
@@ -2167,6 +2166,20 @@ VTableLayout::~VTableLayout() { }
 
 VTableContext::~VTableContext() {
   llvm::DeleteContainerSeconds(VTableLayouts);
+  llvm::DeleteContainerSeconds(FinalOverriderMaps);
+}
+
+const CXXFinalOverriderMap &
+VTableContext::getFinalOverriders(const CXXRecordDecl *RD) {
+  // The final overriders of a class are needed for its own vtable and for
+  // each construction vtable in which it is the most derived class, and
+  // computing them walks the whole hierarchy.
+  CXXFinalOverriderMap *&Entry = FinalOverriderMaps[RD];
+  if (!Entry) {
+    Entry = new CXXFinalOverriderMap;
+    RD->getFinalOverriders(*Entry);
+  }
+  return *Entry;
 }
 
 static void 
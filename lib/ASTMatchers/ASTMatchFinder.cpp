@@ -16,12 +16,20 @@
 //
 //===----------------------------------------------------------------------===//
 
+#define DEBUG_TYPE "ast-matchers"
 #include "clang/ASTMatchers/ASTMatchFinder.h"
 #include "clang/AST/ASTConsumer.h"
 #include "clang/AST/ASTContext.h"
 #include "clang/AST/RecursiveASTVisitor.h"
+#include "llvm/ADT/Statistic.h"
+#include <algorithm>
 #include <set>
 
+STATISTIC(NumMemoizationHits, "The # of recursive matches memoized");
+STATISTIC(NumMemoizationMisses, "The # of recursive matches performed");
+STATISTIC(NumMemoizationResets,
+          "The # of times the recursive match cache was cleared");
+
 namespace clang {
 namespace ast_matchers {
 namespace internal {
@@ -40,7 +48,71 @@ typedef MatchFinder::MatchCallback MatchCallback;
 class ParentMapASTVisitor : public RecursiveASTVisitor<ParentMapASTVisitor> {
 public:
   /// \brief Maps from a node to its parent.
-  typedef llvm::DenseMap<const void*, ast_type_traits::DynTypedNode> ParentMap;
+  ///
+  /// The map is an array of (node, parent) pairs sorted by node, in which a
+  /// parent, which is always a \c Decl or a \c Stmt, takes a single pointer.
+  /// This takes a fraction of the memory of a hash table of \c DynTypedNode,
+  /// and the translation unit has an entry for almost every node.
+  class ParentMap {
+  public:
+    /// \brief Sets \c Parent to the parent of \c Node, returning false if
+    /// \c Node is not in the map.
+    bool lookup(const void *Node,
+                ast_type_traits::DynTypedNode &Parent) const {
+      std::vector<Entry>::const_iterator I =
+        std::lower_bound(Entries.begin(), Entries.end(), Entry(Node, 0));
+      if (I == Entries.end() || I->Node != Node)
+        return false;
+      if (I->Parent & IsStmt)
+        Parent = ast_type_traits::DynTypedNode::create(
+          *reinterpret_cast<const Stmt*>(I->Parent & ~IsStmt));
+      else
+        Parent = ast_type_traits::DynTypedNode::create(
+          *reinterpret_cast<const Decl*>(I->Parent));
+      return true;
+    }
+
+  private:
+    /// \brief Set in \c Entry::Parent if the parent is a \c Stmt.
+    static const uintptr_t IsStmt = 1;
+
+    struct Entry {
+      Entry(const void *Node, uintptr_t Parent) : Node(Node), Parent(Parent) {}
+
+      const void *Node;
+      uintptr_t Parent;
+
+      bool operator<(const Entry &Other) const { return Node < Other.Node; }
+    };
+
+    /// \brief Adds \c Parent as the parent of \c Node.
+    void add(const void *Node, const ast_type_traits::DynTypedNode &Parent) {
+      if (const Stmt *S = Parent.get<Stmt>())
+        Entries.push_back(Entry(Node, reinterpret_cast<uintptr_t>(S) | IsStmt));
+      else
+        Entries.push_back(Entry(Node, reinterpret_cast<uintptr_t>(
+                                        Parent.get<Decl>())));
+    }
+
+    /// \brief Sorts the entries, keeping the parent added last for a node
+    /// which was traversed more than once.
+    void finalize() {
+      std::stable_sort(Entries.begin(), Entries.end());
+      std::vector<Entry>::iterator Out = Entries.begin();
+      for (std::vector<Entry>::iterator I = Entries.begin(), E = Entries.end();
+           I != E; ++I) {
+        if (I + 1 != E && I[1].Node == I->Node)
+          continue;
+        *Out++ = *I;
+      }
+      Entries.erase(Out, Entries.end());
+      std::vector<Entry>(Entries).swap(Entries);
+    }
+
+    std::vector<Entry> Entries;
+
+    friend class ParentMapASTVisitor;
+  };
 
   /// \brief Builds and returns the translation unit's parent map.
   ///
@@ -48,6 +120,7 @@ public:
   static ParentMap *buildMap(TranslationUnitDecl &TU) {
     ParentMapASTVisitor Visitor(new ParentMap);
     Visitor.TraverseDecl(&TU);
+    Visitor.Parents->finalize();
     return Visitor.Parents;
   }
 
@@ -64,7 +137,7 @@ private:
     if (Node == NULL)
       return true;
     if (ParentStack.size() > 0)
-      (*Parents)[Node] = ParentStack.back();
+      Parents->add(Node, ParentStack.back());
     ParentStack.push_back(ast_type_traits::DynTypedNode::create(*Node));
     bool Result = (this->*traverse)(Node);
     ParentStack.pop_back();
@@ -98,12 +171,20 @@ private:
 // provides enough benefit for the additional amount of code.
 typedef std::pair<uint64_t, const void*> UntypedMatchInput;
 
-// Used to store the result of a match and possibly bound nodes.
+// Used to store the result of a match and, as an index into the visitor's
+// MemoizedNodes, the nodes it bound, if any.
 struct MemoizedMatchResult {
   bool ResultOfMatch;
-  BoundNodesTree Nodes;
+  unsigned NodesIndex;
 };
 
+static const unsigned NoMemoizedNodes = ~0U;
+
+// The number of results the memoization cache holds before it is cleared.
+// Clearing it only costs recomputing some results, while keeping every
+// result of a large translation unit costs a lot of memory.
+static const unsigned MaxMemoizationEntries = 10000;
+
 // A RecursiveASTVisitor that traverses all children or all descendants of
 // a node.
 class MatchChildASTVisitor
@@ -261,9 +342,8 @@ private:
 class MatchASTVisitor : public RecursiveASTVisitor<MatchASTVisitor>,
                         public ASTMatchFinder {
 public:
-  MatchASTVisitor(std::vector<std::pair<const internal::DynTypedMatcher*,
-                                        MatchCallback*> > *MatcherCallbackPairs)
-     : MatcherCallbackPairs(MatcherCallbackPairs),
+  MatchASTVisitor(const MatchFinder::MatcherCallbacks *Matchers)
+     : Matchers(Matchers),
        ActiveASTContext(NULL) {
   }
 
@@ -322,18 +402,37 @@ public:
     const UntypedMatchInput input(Matcher.getID(), Node.getMemoizationData());
     assert(input.second &&
            "Fix getMemoizationData once more types allow recursive matching.");
-    std::pair<MemoizationMap::iterator, bool> InsertResult
-      = ResultCache.insert(std::make_pair(input, MemoizedMatchResult()));
-    if (InsertResult.second) {
-      BoundNodesTreeBuilder DescendantBoundNodesBuilder;
-      InsertResult.first->second.ResultOfMatch =
-        matchesRecursively(Node, Matcher, &DescendantBoundNodesBuilder,
-                           MaxDepth, Traversal, Bind);
-      InsertResult.first->second.Nodes =
-        DescendantBoundNodesBuilder.build();
+    MemoizationMap::iterator I = ResultCache.find(input);
+    if (I != ResultCache.end()) {
+      ++NumMemoizationHits;
+      if (I->second.NodesIndex != NoMemoizedNodes)
+        MemoizedNodes[I->second.NodesIndex].copyTo(Builder);
+      return I->second.ResultOfMatch;
+    }
+
+    ++NumMemoizationMisses;
+    BoundNodesTreeBuilder DescendantBoundNodesBuilder;
+    MemoizedMatchResult Result;
+    Result.ResultOfMatch =
+      matchesRecursively(Node, Matcher, &DescendantBoundNodesBuilder,
+                         MaxDepth, Traversal, Bind);
+    BoundNodesTree Nodes = DescendantBoundNodesBuilder.build();
+    Nodes.copyTo(Builder);
+
+    // The recursive match may have added entries of its own, so only now
+    // make room for this one.
+    if (ResultCache.size() >= MaxMemoizationEntries) {
+      ++NumMemoizationResets;
+      ResultCache.clear();
+      MemoizedNodes.clear();
     }
-    InsertResult.first->second.Nodes.copyTo(Builder);
-    return InsertResult.first->second.ResultOfMatch;
+    Result.NodesIndex = NoMemoizedNodes;
+    if (!Nodes.empty()) {
+      Result.NodesIndex = MemoizedNodes.size();
+      MemoizedNodes.push_back(Nodes);
+    }
+    ResultCache[input] = Result;
+    return Result.ResultOfMatch;
   }
 
   // Matches children or descendants of 'Node' with 'BaseMatcher'.
@@ -383,14 +482,11 @@ public:
       assert(Ancestor.getMemoizationData() &&
              "Invariant broken: only nodes that support memoization may be "
              "used in the parent map.");
-      ParentMapASTVisitor::ParentMap::const_iterator I =
-        Parents->find(Ancestor.getMemoizationData());
-      if (I == Parents->end()) {
+      if (!Parents->lookup(Ancestor.getMemoizationData(), Ancestor)) {
         assert(false &&
                "Found node that is not in the parent map.");
         return false;
       }
-      Ancestor = I->second;
       if (Matcher.matches(Ancestor, this, Builder))
         return true;
     }
@@ -435,17 +531,22 @@ private:
     return false;
   }
 
-  // Matches all registered matchers on the given node and calls the
-  // result callback for every node that matches.
+  // Matches all registered matchers for the kind of the given node on it, and
+  // calls the result callback for every node that matches.
+  void match(const Decl &Node) { match(Node, Matchers->Decls); }
+  void match(const Stmt &Node) { match(Node, Matchers->Stmts); }
+  void match(const QualType &Node) { match(Node, Matchers->Types); }
+
   template <typename T>
-  void match(const T &node) {
-    for (std::vector<std::pair<const internal::DynTypedMatcher*,
-                               MatchCallback*> >::const_iterator
-             I = MatcherCallbackPairs->begin(), E = MatcherCallbackPairs->end();
+  void match(const T &Node,
+             const std::vector<std::pair<const Matcher<T>*,
+                                         MatchCallback*> > &NodeMatchers) {
+    for (typename std::vector<std::pair<const Matcher<T>*,
+                                        MatchCallback*> >::const_iterator
+             I = NodeMatchers.begin(), E = NodeMatchers.end();
          I != E; ++I) {
       BoundNodesTreeBuilder Builder;
-      if (I->first->matches(ast_type_traits::DynTypedNode::create(node),
-                            this, &Builder)) {
+      if (I->first->matches(Node, this, &Builder)) {
         BoundNodesTree BoundNodes = Builder.build();
         MatchVisitor Visitor(ActiveASTContext, I->second);
         BoundNodes.visitMatches(&Visitor);
@@ -453,8 +554,7 @@ private:
     }
   }
 
-  std::vector<std::pair<const internal::DynTypedMatcher*,
-                        MatchCallback*> > *const MatcherCallbackPairs;
+  const MatchFinder::MatcherCallbacks *const Matchers;
   ASTContext *ActiveASTContext;
 
   // Maps a canonical type to its TypedefDecls.
@@ -464,6 +564,9 @@ private:
   typedef llvm::DenseMap<UntypedMatchInput, MemoizedMatchResult> MemoizationMap;
   MemoizationMap ResultCache;
 
+  // The nodes bound by the memoized matches which bound any.
+  std::vector<BoundNodesTree> MemoizedNodes;
+
   llvm::OwningPtr<ParentMapASTVisitor::ParentMap> Parents;
 };
 
@@ -559,10 +662,9 @@ bool MatchASTVisitor::TraverseTypeLoc(TypeLoc TypeLoc) {
 class MatchASTConsumer : public ASTConsumer {
 public:
   MatchASTConsumer(
-    std::vector<std::pair<const internal::DynTypedMatcher*,
-                          MatchCallback*> > *MatcherCallbackPairs,
+    const MatchFinder::MatcherCallbacks *Matchers,
     MatchFinder::ParsingDoneTestCallback *ParsingDone)
-    : Visitor(MatcherCallbackPairs),
+    : Visitor(Matchers),
       ParsingDone(ParsingDone) {}
 
 private:
@@ -592,35 +694,44 @@ MatchFinder::ParsingDoneTestCallback::~ParsingDoneTestCallback() {}
 
 MatchFinder::MatchFinder() : ParsingDone(NULL) {}
 
-MatchFinder::~MatchFinder() {
-  for (std::vector<std::pair<const internal::DynTypedMatcher*,
-                             MatchCallback*> >::const_iterator
-           It = MatcherCallbackPairs.begin(), End = MatcherCallbackPairs.end();
+template <typename T>
+static void deleteMatchers(
+    const std::vector<std::pair<const T*,
+                                MatchFinder::MatchCallback*> > &Matchers) {
+  for (typename std::vector<std::pair<const T*,
+                                      MatchFinder::MatchCallback*> >
+           ::const_iterator It = Matchers.begin(), End = Matchers.end();
        It != End; ++It) {
     delete It->first;
   }
 }
 
+MatchFinder::~MatchFinder() {
+  deleteMatchers(Matchers.Decls);
+  deleteMatchers(Matchers.Types);
+  deleteMatchers(Matchers.Stmts);
+}
+
 void MatchFinder::addMatcher(const DeclarationMatcher &NodeMatch,
                              MatchCallback *Action) {
-  MatcherCallbackPairs.push_back(std::make_pair(
-    new internal::Matcher<Decl>(NodeMatch), Action));
+  Matchers.Decls.push_back(std::make_pair(
+    new DeclarationMatcher(NodeMatch), Action));
 }
 
 void MatchFinder::addMatcher(const TypeMatcher &NodeMatch,
                              MatchCallback *Action) {
-  MatcherCallbackPairs.push_back(std::make_pair(
-    new internal::Matcher<QualType>(NodeMatch), Action));
+  Matchers.Types.push_back(std::make_pair(
+    new TypeMatcher(NodeMatch), Action));
 }
 
 void MatchFinder::addMatcher(const StatementMatcher &NodeMatch,
                              MatchCallback *Action) {
-  MatcherCallbackPairs.push_back(std::make_pair(
-    new internal::Matcher<Stmt>(NodeMatch), Action));
+  Matchers.Stmts.push_back(std::make_pair(
+    new StatementMatcher(NodeMatch), Action));
 }
 
 ASTConsumer *MatchFinder::newASTConsumer() {
-  return new internal::MatchASTConsumer(&MatcherCallbackPairs, ParsingDone);
+  return new internal::MatchASTConsumer(&Matchers, ParsingDone);
 }
 
 void MatchFinder::registerTestCallbackAfterParsing(
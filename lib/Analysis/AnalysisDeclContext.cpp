@@ -28,6 +28,8 @@
 #include "llvm/Support/SaveAndRestore.h"
 #include "llvm/ADT/SmallPtrSet.h"
 #include "llvm/Support/ErrorHandling.h"
+#include <algorithm>
+#include <vector>
 
 using namespace clang;
 
@@ -64,7 +66,8 @@ AnalysisDeclContext::AnalysisDeclContext(AnalysisDeclContextManager *Mgr,
 AnalysisDeclContextManager::AnalysisDeclContextManager(bool useUnoptimizedCFG,
                                                        bool addImplicitDtors,
                                                        bool addInitializers,
-                                                       bool addTemporaryDtors) {
+                                                       bool addTemporaryDtors)
+  : NumRequests(0) {
   cfgBuildOptions.PruneTriviallyFalseEdges = !useUnoptimizedCFG;
   cfgBuildOptions.AddImplicitDtors = addImplicitDtors;
   cfgBuildOptions.AddInitializers = addInitializers;
@@ -73,10 +76,35 @@ AnalysisDeclContextManager::AnalysisDeclContextManager(bool useUnoptimizedCFG,
 
 void AnalysisDeclContextManager::clear() {
   for (ContextMap::iterator I = Contexts.begin(), E = Contexts.end(); I!=E; ++I)
-    delete I->second;
+    delete I->second.first;
   Contexts.clear();
 }
 
+void AnalysisDeclContextManager::releaseContexts(unsigned MaxRetained) {
+  if (Contexts.size() <= MaxRetained)
+    return;
+  if (MaxRetained == 0) {
+    clear();
+    return;
+  }
+
+  // Find the time of the oldest request among the MaxRetained last ones.
+  std::vector<unsigned> RequestTimes;
+  RequestTimes.reserve(Contexts.size());
+  for (ContextMap::iterator I = Contexts.begin(), E = Contexts.end(); I!=E; ++I)
+    RequestTimes.push_back(I->second.second);
+  std::vector<unsigned>::iterator Cutoff = RequestTimes.end() - MaxRetained;
+  std::nth_element(RequestTimes.begin(), Cutoff, RequestTimes.end());
+
+  for (ContextMap::iterator I = Contexts.begin(), E = Contexts.end(); I!=E; ) {
+    ContextMap::iterator Current = I++;
+    if (Current->second.second < *Cutoff) {
+      delete Current->second.first;
+      Contexts.erase(Current);
+    }
+  }
+}
+
 Stmt *AnalysisDeclContext::getBody() const {
   if (const FunctionDecl *FD = dyn_cast<FunctionDecl>(D))
     return FD->getBody();
@@ -203,10 +231,11 @@ PseudoConstantAnalysis *AnalysisDeclContext::getPseudoConstantAnalysis() {
 }
 
 AnalysisDeclContext *AnalysisDeclContextManager::getContext(const Decl *D) {
-  AnalysisDeclContext *&AC = Contexts[D];
-  if (!AC)
-    AC = new AnalysisDeclContext(this, D, cfgBuildOptions);
-  return AC;
+  std::pair<AnalysisDeclContext*, unsigned> &Entry = Contexts[D];
+  if (!Entry.first)
+    Entry.first = new AnalysisDeclContext(this, D, cfgBuildOptions);
+  Entry.second = ++NumRequests;
+  return Entry.first;
 }
 
 const StackFrameContext *
@@ -459,8 +488,7 @@ AnalysisDeclContext::~AnalysisDeclContext() {
 }
 
 AnalysisDeclContextManager::~AnalysisDeclContextManager() {
-  for (ContextMap::iterator I = Contexts.begin(), E = Contexts.end(); I!=E; ++I)
-    delete I->second;
+  clear();
 }
 
 LocationContext::~LocationContext() {}
@@ -21,6 +21,7 @@ clang_analysis_SRC_FILES := \
   CFGReachabilityAnalysis.cpp \
   CFGStmtMap.cpp \
   CocoaConventions.cpp \
+  DataflowWorklist.cpp \
   Dominators.cpp \
   FormatString.cpp \
   LiveVariables.cpp \
@@ -16,19 +16,42 @@
 #include "llvm/ADT/SmallVector.h"
 #include "clang/Analysis/Analyses/CFGReachabilityAnalysis.h"
 #include "clang/Analysis/CFG.h"
+#include <algorithm>
 
 using namespace clang;
 
 CFGReverseBlockReachabilityAnalysis::CFGReverseBlockReachabilityAnalysis(const CFG &cfg)
-  : analyzed(cfg.getNumBlockIDs(), false) {}
+  : cfg(cfg), analyzed(cfg.getNumBlockIDs(), false), numAnalyzed(0),
+    entry(&cfg.getEntry()), analyzedEntry(false), analyzedAll(false) {}
 
 bool CFGReverseBlockReachabilityAnalysis::isReachable(const CFGBlock *Src,
                                           const CFGBlock *Dst) {
 
   const unsigned DstBlockID = Dst->getBlockID();
+
+  if (analyzedAll) {
+    // Like the searches, do not report that a block reaches itself.
+    return Src != Dst &&
+           reachableComponents[componentOf[Src->getBlockID()]]
+                              [componentOf[DstBlockID]];
+  }
+
+  if (Src == entry) {
+    if (!analyzedEntry) {
+      mapReachabilityFromEntry();
+      analyzedEntry = true;
+    }
+    return reachableFromEntry[DstBlockID];
+  }
   
   // If we haven't analyzed the destination node, run the analysis now
   if (!analyzed[DstBlockID]) {
+    // Once a good part of the blocks were asked about, one pass over the
+    // whole CFG is cheaper than the searches still to come.
+    if (++numAnalyzed >= 8 && numAnalyzed * 8 >= analyzed.size()) {
+      computeAllReachability();
+      return isReachable(Src, Dst);
+    }
     mapReachability(Dst);
     analyzed[DstBlockID] = true;
   }
@@ -74,3 +97,124 @@ void CFGReverseBlockReachabilityAnalysis::mapReachability(const CFGBlock *Dst) {
     }
   }
 }
+
+// Maps the nodes reachable from the entry node by walking the successors of
+// the entry node.
+void CFGReverseBlockReachabilityAnalysis::mapReachabilityFromEntry() {
+  SmallVector<const CFGBlock *, 11> worklist;
+  reachableFromEntry.resize(analyzed.size(), false);
+
+  // Like for the other queries, the entry node only reaches itself through
+  // an edge, and it has no predecessors.
+  for (CFGBlock::const_succ_iterator i = entry->succ_begin(),
+       e = entry->succ_end(); i != e; ++i) {
+    if (*i)
+      worklist.push_back(*i);
+  }
+
+  while (!worklist.empty()) {
+    const CFGBlock *block = worklist.back();
+    worklist.pop_back();
+
+    if (reachableFromEntry[block->getBlockID()])
+      continue;
+    reachableFromEntry[block->getBlockID()] = true;
+
+    // Add the successors to the worklist.  Trivially false edges are null.
+    for (CFGBlock::const_succ_iterator i = block->succ_begin(),
+         e = block->succ_end(); i != e; ++i) {
+      if (*i)
+        worklist.push_back(*i);
+    }
+  }
+}
+
+void CFGReverseBlockReachabilityAnalysis::computeAllReachability() {
+  if (analyzedAll)
+    return;
+
+  // Find the strongly connected components with Tarjan's algorithm.  It
+  // completes a component only after all the components it reaches, so the
+  // reachable set of each component can be built from theirs right away.
+  const unsigned numBlocks = analyzed.size();
+  const unsigned unvisited = ~0U;
+  std::vector<unsigned> index(numBlocks, unvisited), lowLink(numBlocks);
+  llvm::BitVector onStack(numBlocks);
+  SmallVector<const CFGBlock *, 32> stack;
+  typedef std::pair<const CFGBlock *, CFGBlock::const_succ_iterator> DFSEntry;
+  SmallVector<DFSEntry, 32> dfs;
+  unsigned nextIndex = 0;
+
+  componentOf.assign(numBlocks, 0);
+  reachableComponents.clear();
+
+  for (CFG::const_iterator BI = cfg.begin(), BE = cfg.end(); BI != BE; ++BI) {
+    const CFGBlock *root = *BI;
+    if (index[root->getBlockID()] != unvisited)
+      continue;
+
+    index[root->getBlockID()] = lowLink[root->getBlockID()] = nextIndex++;
+    stack.push_back(root);
+    onStack[root->getBlockID()] = true;
+    dfs.push_back(DFSEntry(root, root->succ_begin()));
+
+    while (!dfs.empty()) {
+      const CFGBlock *block = dfs.back().first;
+      const unsigned blockID = block->getBlockID();
+
+      if (dfs.back().second != block->succ_end()) {
+        // Trivially false edges are null.
+        const CFGBlock *succ = *dfs.back().second++;
+        if (!succ)
+          continue;
+        const unsigned succID = succ->getBlockID();
+        if (index[succID] == unvisited) {
+          index[succID] = lowLink[succID] = nextIndex++;
+          stack.push_back(succ);
+          onStack[succID] = true;
+          dfs.push_back(DFSEntry(succ, succ->succ_begin()));
+        } else if (onStack[succID]) {
+          lowLink[blockID] = std::min(lowLink[blockID], index[succID]);
+        }
+        continue;
+      }
+
+      dfs.pop_back();
+      if (!dfs.empty()) {
+        const unsigned parentID = dfs.back().first->getBlockID();
+        lowLink[parentID] = std::min(lowLink[parentID], lowLink[blockID]);
+      }
+      if (lowLink[blockID] != index[blockID])
+        continue;
+
+      // 'block' is the root of a component; pop its members.
+      const unsigned component = reachableComponents.size();
+      reachableComponents.push_back(ReachableSet(numBlocks));
+      SmallVector<const CFGBlock *, 8> members;
+      const CFGBlock *member;
+      do {
+        member = stack.pop_back_val();
+        onStack[member->getBlockID()] = false;
+        componentOf[member->getBlockID()] = component;
+        members.push_back(member);
+      } while (member != block);
+
+      ReachableSet &reach = reachableComponents[component];
+      for (unsigned i = 0, e = members.size(); i != e; ++i) {
+        for (CFGBlock::const_succ_iterator si = members[i]->succ_begin(),
+             se = members[i]->succ_end(); si != se; ++si) {
+          if (!*si)
+            continue;
+          const unsigned succComponent = componentOf[(*si)->getBlockID()];
+          // The members of a cycle reach each other.
+          if (succComponent != component)
+            reach |= reachableComponents[succComponent];
+          reach.set(succComponent);
+        }
+      }
+    }
+  }
+
+  reachable.clear();
+  analyzedAll = true;
+}
@@ -0,0 +1,82 @@
+//===- DataflowWorklist.cpp - Worklist for dataflow analyses ------*- C++ --*-//
+//
+//                     The LLVM Compiler Infrastructure
+//
+// This file is distributed under the University of Illinois Open Source
+// License. See LICENSE.TXT for details.
+//
+//===----------------------------------------------------------------------===//
+//
+// This file implements the worklist shared by the dataflow analyses over CFGs.
+//
+//===----------------------------------------------------------------------===//
+
+#include "clang/Analysis/Analyses/DataflowWorklist.h"
+#include <algorithm>
+
+using namespace clang;
+
+namespace {
+/// Orders the blocks so that the block with the highest post order number is
+/// at the back of the worklist, and dequeued first.
+struct ReversePostOrderCompare {
+  PostOrderCFGView::BlockOrderCompare POC;
+  ReversePostOrderCompare(PostOrderCFGView::BlockOrderCompare poc)
+    : POC(poc) {}
+  bool operator()(const CFGBlock *b1, const CFGBlock *b2) const {
+    return POC(b2, b1);
+  }
+};
+}
+
+void DataflowWorklist::enqueueBlock(const CFGBlock *block) {
+  if (block && !enqueuedBlocks[block->getBlockID()]) {
+    enqueuedBlocks[block->getBlockID()] = true;
+    worklist.push_back(block);
+  }
+}
+
+void DataflowWorklist::enqueueSuccessors(const CFGBlock *block) {
+  const unsigned OldWorklistSize = worklist.size();
+  for (CFGBlock::const_succ_iterator I = block->succ_begin(),
+       E = block->succ_end(); I != E; ++I) {
+    enqueueBlock(*I);
+  }
+
+  if (OldWorklistSize == 0 || OldWorklistSize == worklist.size())
+    return;
+
+  sortWorklist();
+}
+
+void DataflowWorklist::enqueuePredecessors(const CFGBlock *block) {
+  const unsigned OldWorklistSize = worklist.size();
+  for (CFGBlock::const_pred_iterator I = block->pred_begin(),
+       E = block->pred_end(); I != E; ++I) {
+    enqueueBlock(*I);
+  }
+
+  if (OldWorklistSize == 0 || OldWorklistSize == worklist.size())
+    return;
+
+  sortWorklist();
+}
+
+void DataflowWorklist::sortWorklist() {
+  // BlockOrderCompare puts the block that comes first in post order at the
+  // back of the worklist.
+  if (Dir == Backward)
+    std::sort(worklist.begin(), worklist.end(), POV->getComparator());
+  else
+    std::sort(worklist.begin(), worklist.end(),
+              ReversePostOrderCompare(POV->getComparator()));
+}
+
+const CFGBlock *DataflowWorklist::dequeue() {
+  if (worklist.empty())
+    return 0;
+  const CFGBlock *b = worklist.back();
+  worklist.pop_back();
+  enqueuedBlocks[b->getBlockID()] = false;
+  return b;
+}
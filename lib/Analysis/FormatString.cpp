@@ -21,6 +21,7 @@ using clang::analyze_format_string::FormatStringHandler;
 using clang::analyze_format_string::FormatSpecifier;
 using clang::analyze_format_string::LengthModifier;
 using clang::analyze_format_string::OptionalAmount;
+using clang::analyze_format_string::ParsedFormatString;
 using clang::analyze_format_string::PositionContext;
 using clang::analyze_format_string::ConversionSpecifier;
 using namespace clang;
@@ -768,3 +769,145 @@ bool FormatSpecifier::namedTypeToLengthModifier(QualType QT,
   }
   return false;
 }
+
+//===----------------------------------------------------------------------===//
+// Methods on ParsedFormatString.
+//===----------------------------------------------------------------------===//
+
+/// Recorder - A handler which records every callback, and never stops the
+/// parser, so that any handler can be told what it would have been.
+class ParsedFormatString::Recorder : public FormatStringHandler {
+  ParsedFormatString &Parsed;
+
+  void record(EventKind Kind, const char *Start, unsigned Length,
+              unsigned Extra = 0) {
+    Event E = { Kind, Start, Length, Extra };
+    Parsed.Events.push_back(E);
+  }
+
+public:
+  explicit Recorder(ParsedFormatString &Parsed) : Parsed(Parsed) {}
+
+  virtual void HandleNullChar(const char *nullCharacter) {
+    record(EK_NullChar, nullCharacter, 0);
+  }
+
+  virtual void HandlePosition(const char *startPos, unsigned posLen) {
+    record(EK_Position, startPos, posLen);
+  }
+
+  virtual void HandleInvalidPosition(const char *startPos, unsigned posLen,
+                                     PositionContext p) {
+    record(EK_InvalidPosition, startPos, posLen, p);
+  }
+
+  virtual void HandleZeroPosition(const char *startPos, unsigned posLen) {
+    record(EK_ZeroPosition, startPos, posLen);
+  }
+
+  virtual void HandleIncompleteSpecifier(const char *startSpecifier,
+                                         unsigned specifierLen) {
+    record(EK_IncompleteSpecifier, startSpecifier, specifierLen);
+  }
+
+  virtual bool HandleInvalidPrintfConversionSpecifier(
+                                      const analyze_printf::PrintfSpecifier &FS,
+                                      const char *startSpecifier,
+                                      unsigned specifierLen) {
+    record(EK_InvalidPrintfConversionSpecifier, startSpecifier, specifierLen,
+           Parsed.PrintfSpecifiers.size());
+    Parsed.PrintfSpecifiers.push_back(FS);
+    return true;
+  }
+
+  virtual bool HandlePrintfSpecifier(const analyze_printf::PrintfSpecifier &FS,
+                                     const char *startSpecifier,
+                                     unsigned specifierLen) {
+    record(EK_PrintfSpecifier, startSpecifier, specifierLen,
+           Parsed.PrintfSpecifiers.size());
+    Parsed.PrintfSpecifiers.push_back(FS);
+    return true;
+  }
+
+  virtual bool HandleInvalidScanfConversionSpecifier(
+                                        const analyze_scanf::ScanfSpecifier &FS,
+                                        const char *startSpecifier,
+                                        unsigned specifierLen) {
+    record(EK_InvalidScanfConversionSpecifier, startSpecifier, specifierLen,
+           Parsed.ScanfSpecifiers.size());
+    Parsed.ScanfSpecifiers.push_back(FS);
+    return true;
+  }
+
+  virtual bool HandleScanfSpecifier(const analyze_scanf::ScanfSpecifier &FS,
+                                    const char *startSpecifier,
+                                    unsigned specifierLen) {
+    record(EK_ScanfSpecifier, startSpecifier, specifierLen,
+           Parsed.ScanfSpecifiers.size());
+    Parsed.ScanfSpecifiers.push_back(FS);
+    return true;
+  }
+
+  virtual void HandleIncompleteScanList(const char *start, const char *end) {
+    record(EK_IncompleteScanList, start, end - start);
+  }
+};
+
+ParsedFormatString::ParsedFormatString(StringRef FormatStr, bool IsScanf,
+                                       const LangOptions &LO)
+  : Str(FormatStr) {
+  // The recorded positions point into Str, which is never modified.
+  Recorder R(*this);
+  const char *Beg = Str.data();
+  if (IsScanf)
+    Stopped = ParseScanfString(R, Beg, Beg + Str.size(), LO);
+  else
+    Stopped = ParsePrintfString(R, Beg, Beg + Str.size(), LO);
+}
+
+bool ParsedFormatString::report(FormatStringHandler &H) const {
+  for (unsigned I = 0, N = Events.size(); I != N; ++I) {
+    const Event &E = Events[I];
+    switch (E.Kind) {
+    case EK_NullChar:
+      H.HandleNullChar(E.Start);
+      break;
+    case EK_Position:
+      H.HandlePosition(E.Start, E.Length);
+      break;
+    case EK_InvalidPosition:
+      H.HandleInvalidPosition(E.Start, E.Length, PositionContext(E.Extra));
+      break;
+    case EK_ZeroPosition:
+      H.HandleZeroPosition(E.Start, E.Length);
+      break;
+    case EK_IncompleteSpecifier:
+      H.HandleIncompleteSpecifier(E.Start, E.Length);
+      break;
+    case EK_InvalidPrintfConversionSpecifier:
+      if (!H.HandleInvalidPrintfConversionSpecifier(PrintfSpecifiers[E.Extra],
+                                                    E.Start, E.Length))
+        return true;
+      break;
+    case EK_PrintfSpecifier:
+      if (!H.HandlePrintfSpecifier(PrintfSpecifiers[E.Extra], E.Start,
+                                   E.Length))
+        return true;
+      break;
+    case EK_InvalidScanfConversionSpecifier:
+      if (!H.HandleInvalidScanfConversionSpecifier(ScanfSpecifiers[E.Extra],
+                                                   E.Start, E.Length))
+        return true;
+      break;
+    case EK_ScanfSpecifier:
+      if (!H.HandleScanfSpecifier(ScanfSpecifiers[E.Extra], E.Start,
+                                  E.Length))
+        return true;
+      break;
+    case EK_IncompleteScanList:
+      H.HandleIncompleteScanList(E.Start, E.Start + E.Length);
+      break;
+    }
+  }
+  return Stopped;
+}
@@ -760,7 +760,7 @@ struct FactEntry {
 };
 
 
-typedef unsigned short FactID;
+typedef unsigned FactID;
 
 /// \brief FactManager manages the memory for all facts that are created during 
 /// the analysis of a single routine.
@@ -771,7 +771,7 @@ private:
 public:
   FactID newLock(const SExpr& M, const LockData& L) {
     Facts.push_back(FactEntry(M,L));
-    return static_cast<unsigned short>(Facts.size() - 1);
+    return static_cast<FactID>(Facts.size() - 1);
   }
 
   const FactEntry& operator[](FactID F) const { return Facts[F]; }
@@ -804,6 +804,19 @@ public:
 
   bool isEmpty() const { return FactIDs.size() == 0; }
 
+  /// \brief Returns true if this set holds exactly the facts of \p Other,
+  /// in any order.
+  bool hasSameFacts(const FactSet &Other) const {
+    if (FactIDs.size() != Other.FactIDs.size())
+      return false;
+    if (FactIDs == Other.FactIDs)
+      return true;
+    FactVec Mine(FactIDs), Theirs(Other.FactIDs);
+    std::sort(Mine.begin(), Mine.end());
+    std::sort(Theirs.begin(), Theirs.end());
+    return Mine == Theirs;
+  }
+
   FactID addLock(FactManager& FM, const SExpr& M, const LockData& L) {
     FactID F = FM.newLock(M, L);
     FactIDs.push_back(F);
@@ -2070,6 +2083,13 @@ void ThreadSafetyAnalyzer::intersectAndWarn(FactSet &FSet1,
                                             LockErrorKind LEK1,
                                             LockErrorKind LEK2,
                                             bool Modify) {
+  // addLock() never lets two facts of a lockset match each other, so if both
+  // locksets hold the same facts, each fact only matches itself in the other
+  // one: there is nothing to warn about or to remove.  This is the common case
+  // at joins, and skips the quadratic matching below.
+  if (FSet1.hasSameFacts(FSet2))
+    return;
+
   FactSet FSet1Orig = FSet1;
 
   for (FactSet::const_iterator I = FSet2.begin(), E = FSet2.end();
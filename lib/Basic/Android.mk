@@ -22,23 +22,29 @@ TBLGEN_TABLES := \
 
 clang_basic_SRC_FILES := \
   Builtins.cpp \
+  CompilationProfile.cpp \
   ConvertUTF.c \
   ConvertUTFWrapper.cpp \
   Diagnostic.cpp \
   DiagnosticIDs.cpp \
   FileManager.cpp \
+  FilePrefetcher.cpp \
   FileSystemStatCache.cpp \
   IdentifierTable.cpp \
   LangOptions.cpp \
+  MD5.cpp \
   Module.cpp \
   ObjCRuntime.cpp \
+  Parallel.cpp \
+  ProfilingSupport.cpp \
   SourceLocation.cpp \
   SourceManager.cpp \
   TargetInfo.cpp \
   Targets.cpp \
   TokenKinds.cpp \
   Version.cpp \
-  VersionTuple.cpp
+  VersionTuple.cpp \
+  VirtualFileSystem.cpp
 
 LOCAL_SRC_FILES := $(clang_basic_SRC_FILES)
 
@@ -16,6 +16,7 @@
 #include "clang/Basic/TargetInfo.h"
 #include "clang/Basic/LangOptions.h"
 #include "llvm/ADT/SmallVector.h"
+#include "llvm/ADT/StringExtras.h"
 using namespace clang;
 
 static const Builtin::Info BuiltinInfo[] = {
@@ -48,19 +49,64 @@ void Builtin::Context::InitializeTarget(const TargetInfo &Target) {
 /// appropriate builtin ID # and mark any non-portable builtin identifiers as
 /// such.
 void Builtin::Context::InitializeBuiltins(IdentifierTable &Table,
-                                          const LangOptions& LangOpts) {
-  // Step #1: mark all target-independent builtins with their ID's.
+                                          const LangOptions& LangOpts,
+                                          bool OnlyNewIdentifiers) {
+  SmallVector<unsigned, 2048> IDs;
+
+  // Step #1: enable all target-independent builtins.
   for (unsigned i = Builtin::NotBuiltin+1; i != Builtin::FirstTSBuiltin; ++i)
     if (!LangOpts.NoBuiltin || !strchr(BuiltinInfo[i].Attributes, 'f')) {
       if (LangOpts.ObjC1 || 
           BuiltinInfo[i].builtin_lang != clang::OBJC_LANG)
-        Table.get(BuiltinInfo[i].Name).setBuiltinID(i);
+        IDs.push_back(i);
     }
 
-  // Step #2: Register target-specific builtins.
+  // Step #2: enable target-specific builtins.
   for (unsigned i = 0, e = NumTSRecords; i != e; ++i)
     if (!LangOpts.NoBuiltin || !strchr(TSRecords[i].Attributes, 'f'))
-      Table.get(TSRecords[i].Name).setBuiltinID(i+Builtin::FirstTSBuiltin);
+      IDs.push_back(i+Builtin::FirstTSBuiltin);
+
+  // Index them by name in a table that is at most half full. A later builtin
+  // replaces an earlier one of the same name.
+  unsigned Size = 1;
+  while (Size < IDs.size() * 2)
+    Size <<= 1;
+  EnabledIDs.assign(Size, Builtin::NotBuiltin);
+  for (unsigned i = 0, e = IDs.size(); i != e; ++i) {
+    const char *Name = GetRecord(IDs[i]).Name;
+    unsigned Slot = llvm::HashString(Name) & (Size - 1);
+    while (EnabledIDs[Slot] != Builtin::NotBuiltin &&
+           strcmp(GetRecord(EnabledIDs[Slot]).Name, Name) != 0)
+      Slot = (Slot + 1) & (Size - 1);
+    EnabledIDs[Slot] = IDs[i];
+  }
+
+  Table.setLazyBuiltins(this);
+  if (OnlyNewIdentifiers)
+    return;
+  for (IdentifierTable::iterator I = Table.begin(), E = Table.end(); I != E;
+       ++I)
+    if (IdentifierInfo *II = I->getValue())
+      if (unsigned ID = lookupBuiltin(I->getKey()))
+        II->setBuiltinID(ID);
+}
+
+unsigned Builtin::Context::lookupBuiltin(StringRef Name) const {
+  if (EnabledIDs.empty())
+    return Builtin::NotBuiltin;
+  unsigned Mask = EnabledIDs.size() - 1;
+  for (unsigned Slot = llvm::HashString(Name) & Mask;
+       EnabledIDs[Slot] != Builtin::NotBuiltin; Slot = (Slot + 1) & Mask)
+    if (Name == GetRecord(EnabledIDs[Slot]).Name)
+      return EnabledIDs[Slot];
+  return Builtin::NotBuiltin;
+}
+
+void Builtin::Context::getEnabledBuiltinNames(
+    SmallVectorImpl<const char *> &Names) const {
+  for (unsigned i = 0, e = EnabledIDs.size(); i != e; ++i)
+    if (EnabledIDs[i] != Builtin::NotBuiltin)
+      Names.push_back(GetRecord(EnabledIDs[i]).Name);
 }
 
 void
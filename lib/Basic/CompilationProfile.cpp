@@ -0,0 +1,109 @@
+//===--- CompilationProfile.cpp - Per-TU compilation phase times ----------===//
+//
+//                     The LLVM Compiler Infrastructure
+//
+// This file is distributed under the University of Illinois Open Source
+// License. See LICENSE.TXT for details.
+//
+//===----------------------------------------------------------------------===//
+//
+// This file implements CompilationProfile.
+//
+//===----------------------------------------------------------------------===//
+
+#include "clang/Basic/CompilationProfile.h"
+#include "clang/Basic/ProfilingSupport.h"
+#include "llvm/Support/ErrorHandling.h"
+#include "llvm/Support/Format.h"
+#include "llvm/Support/raw_ostream.h"
+
+using namespace clang;
+
+CompilationProfile::CompilationProfile() : HasIRSize(false) {
+  for (unsigned I = 0; I != NumPhases; ++I) {
+    Costs[I].TotalTime = Costs[I].SelfTime = 0;
+    Costs[I].Count = 0;
+    ActiveCount[I] = 0;
+  }
+}
+
+void CompilationProfile::startPhase(Phase P) {
+  ActivePhase A;
+  A.P = P;
+  A.Start = getCurrentTimeInNanoseconds();
+  A.NestedTime = 0;
+  Active.push_back(A);
+  ++ActiveCount[P];
+}
+
+void CompilationProfile::stopPhase(Phase P) {
+  assert(!Active.empty() && Active.back().P == P && "unbalanced phases");
+  ActivePhase A = Active.pop_back_val();
+  --ActiveCount[P];
+
+  uint64_t Time = getCurrentTimeInNanoseconds() - A.Start;
+  Cost &C = Costs[P];
+  if (ActiveCount[P] == 0)
+    C.TotalTime += Time;
+  C.SelfTime += Time - A.NestedTime;
+  ++C.Count;
+
+  if (!Active.empty())
+    Active.back().NestedTime += Time;
+}
+
+void CompilationProfile::setIRSize(const IRSize &Before, const IRSize &After) {
+  SizeBeforeOptimization = Before;
+  SizeAfterOptimization = After;
+  HasIRSize = true;
+}
+
+const char *CompilationProfile::getPhaseName(Phase P) {
+  switch (P) {
+  case Preprocessing:         return "preprocessing";
+  case Frontend:              return "frontend";
+  case TemplateInstantiation: return "template_instantiation";
+  case IRGeneration:          return "ir_generation";
+  case FunctionPasses:        return "function_passes";
+  case ModulePasses:          return "module_passes";
+  case CodeGeneration:        return "code_generation";
+  case NumPhases:             break;
+  }
+  llvm_unreachable("invalid phase");
+}
+
+
+static void printIRSize(raw_ostream &OS, StringRef Name,
+                        const CompilationProfile::IRSize &Size) {
+  OS << "    \"" << Name << "\": { \"functions\": " << Size.Functions
+     << ", \"basic_blocks\": " << Size.BasicBlocks
+     << ", \"instructions\": " << Size.Instructions << " }";
+}
+
+void CompilationProfile::printJSON(raw_ostream &OS, StringRef File) const {
+  // Times are in seconds.
+  OS << "{\n  \"file\": ";
+  printJSONString(OS, File);
+  OS << ",\n  \"phases\": [";
+  bool First = true;
+  for (unsigned I = 0; I != NumPhases; ++I) {
+    const Cost &C = Costs[I];
+    if (!C.Count)
+      continue;
+    OS << (First ? "\n    " : ",\n    ");
+    First = false;
+    OS << "{ \"name\": \"" << getPhaseName(Phase(I)) << "\", "
+       << llvm::format("\"total\": %.6f, \"self\": %.6f", C.TotalTime / 1e9,
+                       C.SelfTime / 1e9)
+       << ", \"count\": " << C.Count << " }";
+  }
+  OS << "\n  ]";
+  if (HasIRSize) {
+    OS << ",\n  \"ir\": {\n";
+    printIRSize(OS, "before_optimization", SizeBeforeOptimization);
+    OS << ",\n";
+    printIRSize(OS, "after_optimization", SizeAfterOptimization);
+    OS << "\n  }";
+  }
+  OS << "\n}\n";
+}
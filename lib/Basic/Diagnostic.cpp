@@ -14,6 +14,7 @@
 #include "clang/Basic/Diagnostic.h"
 #include "clang/Basic/IdentifierTable.h"
 #include "clang/Basic/PartialDiagnostic.h"
+#include "clang/Basic/SourceManager.h"
 #include "llvm/ADT/SmallString.h"
 #include "llvm/Support/raw_ostream.h"
 #include "llvm/Support/CrashRecoveryContext.h"
@@ -115,6 +116,7 @@ void DiagnosticsEngine::Reset() {
   DiagStates.clear();
   DiagStatePoints.clear();
   DiagStateOnPushStack.clear();
+  clearDiagStateFiles();
 
   // Create a DiagState and DiagStatePoint representing diagnostic changes
   // through command-line.
@@ -139,6 +141,100 @@ void DiagnosticsEngine::ReportDelayed() {
   DelayedDiagArg2.clear();
 }
 
+/// \brief Return the location at which the file or macro expansion \p FID
+/// is entered, or an invalid location for top-level files.
+static SourceLocation getEnteredLoc(const SourceManager &SM, FileID FID) {
+  const SrcMgr::SLocEntry &Entry = SM.getSLocEntry(FID);
+  if (Entry.isExpansion())
+    return Entry.getExpansion().getExpansionLocStart();
+  return Entry.getFile().getIncludeLoc();
+}
+
+DiagnosticsEngine::DiagStateFile &
+DiagnosticsEngine::getDiagStateFile(FileID FID) const {
+  llvm::DenseMap<FileID, DiagStateFile>::iterator I = DiagStateFiles.find(FID);
+  if (I != DiagStateFiles.end())
+    return I->second;
+
+  // The file starts out with the state in effect where it is entered.
+  unsigned Initial;
+  SourceLocation EnteredLoc = getEnteredLoc(*SourceMgr, FID);
+  if (EnteredLoc.isValid()) {
+    std::pair<FileID, unsigned> Decomp =
+      SourceMgr->getDecomposedLoc(EnteredLoc);
+    Initial = lookupDiagStatePoint(Decomp.first, Decomp.second);
+  } else {
+    // Top-level files, such as the main file and the predefines buffer, are
+    // only ordered by the source manager.
+    FullSourceLoc Start(SourceMgr->getLocForStartOfFile(FID), *SourceMgr);
+    DiagStatePointsTy::iterator Pos =
+      std::upper_bound(DiagStatePoints.begin(),
+                       DiagStatePoints.begin() + NumIndexedDiagStatePoints,
+                       DiagStatePoint(0, Start));
+    Initial = Pos - DiagStatePoints.begin() - 1;
+  }
+
+  DiagStateFile &File = DiagStateFiles[FID];
+  File.Transitions.push_back(std::make_pair(0U, Initial));
+  return File;
+}
+
+unsigned DiagnosticsEngine::lookupDiagStatePoint(FileID FID,
+                                                 unsigned Offset) const {
+  // Files without an entry contain no DiagStatePoints, so they have the state
+  // in effect where they are entered.
+  llvm::DenseMap<FileID, DiagStateFile>::iterator I;
+  while ((I = DiagStateFiles.find(FID)) == DiagStateFiles.end()) {
+    SourceLocation EnteredLoc = getEnteredLoc(*SourceMgr, FID);
+    if (EnteredLoc.isInvalid())
+      break;
+    std::pair<FileID, unsigned> Decomp =
+      SourceMgr->getDecomposedLoc(EnteredLoc);
+    FID = Decomp.first;
+    Offset = Decomp.second;
+  }
+  const DiagStateFile &File =
+    I != DiagStateFiles.end() ? I->second : getDiagStateFile(FID);
+
+  // Find the last transition at or before the offset.
+  const std::pair<unsigned, unsigned> *Pos =
+    std::upper_bound(File.Transitions.begin(), File.Transitions.end(),
+                     std::make_pair(Offset, ~0U));
+  return Pos[-1].second;
+}
+
+void DiagnosticsEngine::indexDiagStatePoints() const {
+  for (unsigned N = DiagStatePoints.size();
+       NumIndexedDiagStatePoints != N && !DiagStateFilesInvalid;
+       ++NumIndexedDiagStatePoints) {
+    unsigned Index = NumIndexedDiagStatePoints;
+    FullSourceLoc Loc = DiagStatePoints[Index].Loc;
+    if (Loc.isInvalid())
+      continue; // The command-line state.
+
+    // Record the transition in the file of the point, and in every file
+    // including it.
+    std::pair<FileID, unsigned> Decomp = SourceMgr->getDecomposedLoc(Loc);
+    while (1) {
+      DiagStateFile &File = getDiagStateFile(Decomp.first);
+      std::pair<unsigned, unsigned> &Last = File.Transitions.back();
+      if (Last.first > Decomp.second) {
+        DiagStateFilesInvalid = true;
+        break;
+      }
+      if (Last.first == Decomp.second)
+        Last.second = Index;
+      else
+        File.Transitions.push_back(std::make_pair(Decomp.second, Index));
+
+      SourceLocation EnteredLoc = getEnteredLoc(*SourceMgr, Decomp.first);
+      if (EnteredLoc.isInvalid())
+        break;
+      Decomp = SourceMgr->getDecomposedLoc(EnteredLoc);
+    }
+  }
+}
+
 DiagnosticsEngine::DiagStatePointsTy::iterator
 DiagnosticsEngine::GetDiagStatePointForLoc(SourceLocation L) const {
   assert(!DiagStatePoints.empty());
@@ -152,6 +248,22 @@ DiagnosticsEngine::GetDiagStatePointForLoc(SourceLocation L) const {
   if (Loc.isInvalid())
     return DiagStatePoints.end() - 1;
 
+  // Without diagnostic pragmas, every location has the command-line state.
+  if (DiagStatePoints.size() == 1)
+    return DiagStatePoints.begin();
+
+  indexDiagStatePoints();
+  if (!DiagStateFilesInvalid) {
+    if (L != LastDiagStateLoc ||
+        LastDiagStateNumPoints != DiagStatePoints.size()) {
+      std::pair<FileID, unsigned> Decomp = SourceMgr->getDecomposedLoc(L);
+      LastDiagStateLoc = L;
+      LastDiagStatePoint = lookupDiagStatePoint(Decomp.first, Decomp.second);
+      LastDiagStateNumPoints = DiagStatePoints.size();
+    }
+    return DiagStatePoints.begin() + LastDiagStatePoint;
+  }
+
   DiagStatePointsTy::iterator Pos = DiagStatePoints.end();
   FullSourceLoc LastStateChangePos = DiagStatePoints.back().Loc;
   if (LastStateChangePos.isValid() &&
@@ -228,6 +340,7 @@ void DiagnosticsEngine::setDiagnosticMapping(diag::kind Diag, diag::Mapping Map,
   GetCurDiagState()->setMappingInfo(Diag, MappingInfo);
   DiagStatePoints.insert(Pos+1, DiagStatePoint(NewState,
                                                FullSourceLoc(Loc, *SourceMgr)));
+  clearDiagStateFiles();
 }
 
 bool DiagnosticsEngine::setDiagnosticGroupMapping(
@@ -30,9 +30,10 @@ namespace {
 // Diagnostic classes.
 enum {
   CLASS_NOTE       = 0x01,
-  CLASS_WARNING    = 0x02,
-  CLASS_EXTENSION  = 0x03,
-  CLASS_ERROR      = 0x04
+  CLASS_REMARK     = 0x02,
+  CLASS_WARNING    = 0x03,
+  CLASS_EXTENSION  = 0x04,
+  CLASS_ERROR      = 0x05
 };
 
 struct StaticDiagInfoRec {
@@ -306,7 +307,8 @@ unsigned DiagnosticIDs::getCustomDiagID(Level L, StringRef Message) {
 /// call on NOTEs.
 bool DiagnosticIDs::isBuiltinWarningOrExtension(unsigned DiagID) {
   return DiagID < diag::DIAG_UPPER_LIMIT &&
-         getBuiltinDiagClass(DiagID) != CLASS_ERROR;
+         getBuiltinDiagClass(DiagID) != CLASS_ERROR &&
+         getBuiltinDiagClass(DiagID) != CLASS_REMARK;
 }
 
 /// \brief Determine whether the given built-in diagnostic ID is a
@@ -397,6 +399,9 @@ DiagnosticIDs::getDiagnosticLevel(unsigned DiagID, unsigned DiagClass,
   case diag::MAP_FATAL:
     Result = DiagnosticIDs::Fatal;
     break;
+  case diag::MAP_REMARK:
+    Result = DiagnosticIDs::Remark;
+    break;
   }
 
   // Upgrade ignored diagnostics if -Weverything is enabled.
@@ -18,6 +18,7 @@
 //===----------------------------------------------------------------------===//
 
 #include "clang/Basic/FileManager.h"
+#include "clang/Basic/FilePrefetcher.h"
 #include "clang/Basic/FileSystemStatCache.h"
 #include "llvm/ADT/SmallString.h"
 #include "llvm/Support/FileSystem.h"
@@ -170,8 +171,9 @@ public:
 // Common logic.
 //===----------------------------------------------------------------------===//
 
-FileManager::FileManager(const FileSystemOptions &FSO)
+FileManager::FileManager(const FileSystemOptions &FSO, VirtualFileSystem *FS)
   : FileSystemOpts(FSO),
+    FS(FS ? FS : VirtualFileSystem::getRealFileSystem()),
     UniqueRealDirs(*new UniqueDirContainer()),
     UniqueRealFiles(*new UniqueFileContainer()),
     SeenDirEntries(64), SeenFileEntries(64), NextFileUID(0) {
@@ -227,6 +229,10 @@ void FileManager::clearStatCaches() {
   StatCache.reset(0);
 }
 
+void FileManager::setPrefetcher(FilePrefetcher *P) {
+  Prefetcher.reset(P);
+}
+
 /// \brief Retrieve the directory that the given file name resides in.
 /// Filename can point to either a real file or a virtual file.
 static const DirectoryEntry *getDirectoryFromFile(FileManager &FileMgr,
@@ -504,6 +510,18 @@ getBufferForFile(const FileEntry *Entry, std::string *ErrorStr,
     FileSize = -1;
 
   const char *Filename = Entry->getName();
+
+  // If the contents were read ahead of time, use them.
+  if (Prefetcher && !isVolatile) {
+    if (llvm::MemoryBuffer *Buffer = Prefetcher->take(Entry)) {
+      if (Entry->FD != -1) {
+        close(Entry->FD);
+        Entry->FD = -1;
+      }
+      return Buffer;
+    }
+  }
+
   // If the file is already open, use the open file descriptor.
   if (Entry->FD != -1) {
     ec = llvm::MemoryBuffer::getOpenFile(Entry->FD, Filename, Result, FileSize);
@@ -518,7 +536,7 @@ getBufferForFile(const FileEntry *Entry, std::string *ErrorStr,
   // Otherwise, open the file.
 
   if (FileSystemOpts.WorkingDir.empty()) {
-    ec = llvm::MemoryBuffer::getFile(Filename, Result, FileSize);
+    ec = FS->getBufferForFile(Filename, Result, FileSize);
     if (ec && ErrorStr)
       *ErrorStr = ec.message();
     return Result.take();
@@ -526,26 +544,21 @@ getBufferForFile(const FileEntry *Entry, std::string *ErrorStr,
 
   SmallString<128> FilePath(Entry->getName());
   FixupRelativePath(FilePath);
-  ec = llvm::MemoryBuffer::getFile(FilePath.str(), Result, FileSize);
+  ec = FS->getBufferForFile(FilePath.c_str(), Result, FileSize);
   if (ec && ErrorStr)
     *ErrorStr = ec.message();
   return Result.take();
 }
 
 llvm::MemoryBuffer *FileManager::
-getBufferForFile(StringRef Filename, std::string *ErrorStr) {
+getBufferForFile(StringRef Filename, std::string *ErrorStr,
+                 bool RequiresNullTerminator) {
   OwningPtr<llvm::MemoryBuffer> Result;
   llvm::error_code ec;
-  if (FileSystemOpts.WorkingDir.empty()) {
-    ec = llvm::MemoryBuffer::getFile(Filename, Result);
-    if (ec && ErrorStr)
-      *ErrorStr = ec.message();
-    return Result.take();
-  }
-
   SmallString<128> FilePath(Filename);
   FixupRelativePath(FilePath);
-  ec = llvm::MemoryBuffer::getFile(FilePath.c_str(), Result);
+  ec = FS->getBufferForFile(FilePath.c_str(), Result, /*FileSize=*/-1,
+                            RequiresNullTerminator);
   if (ec && ErrorStr)
     *ErrorStr = ec.message();
   return Result.take();
@@ -562,13 +575,13 @@ bool FileManager::getStatValue(const char *Path, struct stat &StatBuf,
   // absolute!
   if (FileSystemOpts.WorkingDir.empty())
     return FileSystemStatCache::get(Path, StatBuf, FileDescriptor,
-                                    StatCache.get());
+                                    StatCache.get(), *FS);
 
   SmallString<128> FilePath(Path);
   FixupRelativePath(FilePath);
 
   return FileSystemStatCache::get(FilePath.c_str(), StatBuf, FileDescriptor,
-                                  StatCache.get());
+                                  StatCache.get(), *FS);
 }
 
 bool FileManager::getNoncachedStatValue(StringRef Path, 
@@ -576,7 +589,7 @@ bool FileManager::getNoncachedStatValue(StringRef Path,
   SmallString<128> FilePath(Path);
   FixupRelativePath(FilePath);
 
-  return ::stat(FilePath.c_str(), &StatBuf) != 0;
+  return FS->getStat(FilePath.c_str(), StatBuf, 0);
 }
 
 void FileManager::invalidateCache(const FileEntry *Entry) {
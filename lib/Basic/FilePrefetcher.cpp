@@ -0,0 +1,123 @@
+//===--- FilePrefetcher.cpp - Reading files before they are needed --------===//
+//
+//                     The LLVM Compiler Infrastructure
+//
+// This file is distributed under the University of Illinois Open Source
+// License. See LICENSE.TXT for details.
+//
+//===----------------------------------------------------------------------===//
+//
+//  This file implements FilePrefetcher.
+//
+//===----------------------------------------------------------------------===//
+
+#define DEBUG_TYPE "file-prefetcher"
+#include "clang/Basic/FilePrefetcher.h"
+#include "clang/Basic/FileManager.h"
+#include "llvm/ADT/OwningPtr.h"
+#include "llvm/ADT/SmallVector.h"
+#include "llvm/ADT/Statistic.h"
+#include "llvm/Support/MemoryBuffer.h"
+#include "llvm/Support/MutexGuard.h"
+#include "llvm/Support/system_error.h"
+#include <sys/stat.h>
+
+using namespace clang;
+
+STATISTIC(NumFilesPrefetched, "The # of files read ahead of time");
+STATISTIC(NumPrefetchedFilesUsed, "The # of prefetched files used");
+
+FilePrefetcher::FilePrefetcher(ArrayRef<std::string> Paths,
+                               unsigned NumThreads)
+  : NumThreads(NumThreads), Cancelled(false) {
+  if (Paths.empty() || !isParallelExecutionSupported())
+    return;
+
+  Files.resize(Paths.size());
+  for (unsigned I = 0, N = Paths.size(); I != N; ++I) {
+    Files[I].Path = Paths[I];
+    Files[I].Buffer = 0;
+  }
+  if (!Thread.start(run, this))
+    Files.clear();
+}
+
+FilePrefetcher::~FilePrefetcher() {
+  {
+    llvm::MutexGuard Guard(Lock);
+    Cancelled = true;
+  }
+  Thread.join();
+  for (unsigned I = 0, N = Files.size(); I != N; ++I)
+    delete Files[I].Buffer;
+}
+
+void FilePrefetcher::run(void *UserData) {
+  FilePrefetcher &Self = *static_cast<FilePrefetcher *>(UserData);
+  runTasksInParallel(Self.NumThreads, Self.Files.size(), readFile, &Self);
+}
+
+void FilePrefetcher::readFile(void *UserData, unsigned Index) {
+  FilePrefetcher &Self = *static_cast<FilePrefetcher *>(UserData);
+  {
+    llvm::MutexGuard Guard(Self.Lock);
+    if (Self.Cancelled)
+      return;
+  }
+
+  File &F = Self.Files[Index];
+  struct stat StatBuf;
+  if (::stat(F.Path.c_str(), &StatBuf) != 0 || !S_ISREG(StatBuf.st_mode))
+    return;
+
+  OwningPtr<llvm::MemoryBuffer> Buffer;
+  if (llvm::MemoryBuffer::getFile(F.Path, Buffer, StatBuf.st_size))
+    return;
+
+  F.Device = StatBuf.st_dev;
+  F.Inode = StatBuf.st_ino;
+  F.Size = StatBuf.st_size;
+  F.ModTime = StatBuf.st_mtime;
+  F.Buffer = Buffer.take();
+
+  // Publish the file only once all of its fields are set.
+  llvm::MutexGuard Guard(Self.Lock);
+  Self.ReadFiles[std::make_pair(F.Device, F.Inode)] = Index;
+  ++NumFilesPrefetched;
+}
+
+llvm::MemoryBuffer *FilePrefetcher::take(const FileEntry *Entry) {
+  llvm::MutexGuard Guard(Lock);
+  std::map<std::pair<dev_t, ino_t>, unsigned>::iterator I
+    = ReadFiles.find(std::make_pair(Entry->getDevice(), Entry->getInode()));
+  if (I == ReadFiles.end())
+    return 0;
+
+  File &F = Files[I->second];
+  ReadFiles.erase(I);
+  if (F.Size != Entry->getSize() ||
+      F.ModTime != Entry->getModificationTime())
+    return 0;
+
+  llvm::MemoryBuffer *Result = F.Buffer;
+  F.Buffer = 0;
+  ++NumPrefetchedFilesUsed;
+  return Result;
+}
+
+bool FilePrefetcher::readFileList(StringRef ListFile,
+                                  std::vector<std::string> &Paths) {
+  OwningPtr<llvm::MemoryBuffer> Buffer;
+  if (llvm::MemoryBuffer::getFile(ListFile, Buffer))
+    return false;
+
+  SmallVector<StringRef, 64> Lines;
+  Buffer->getBuffer().split(Lines, "\n", /*MaxSplit=*/-1,
+                            /*KeepEmpty=*/false);
+  for (unsigned I = 0, N = Lines.size(); I != N; ++I) {
+    StringRef Line = Lines[I].trim();
+    if (!Line.empty())
+      Paths.push_back(Line);
+  }
+  return true;
+}
@@ -12,8 +12,10 @@
 //===----------------------------------------------------------------------===//
 
 #include "clang/Basic/FileSystemStatCache.h"
+#include "clang/Basic/VirtualFileSystem.h"
+#include "llvm/ADT/StringExtras.h"
 #include "llvm/Support/Path.h"
-#include <fcntl.h>
+#include "llvm/Support/RWMutex.h"
 
 // FIXME: This is terrible, we need this for ::close.
 #if !defined(_MSC_VER) && !defined(__MINGW32__)
@@ -40,48 +42,17 @@ void FileSystemStatCache::anchor() { }
 /// implementation can optionally fill in FileDescriptor with a valid
 /// descriptor and the client guarantees that it will close it.
 bool FileSystemStatCache::get(const char *Path, struct stat &StatBuf,
-                              int *FileDescriptor, FileSystemStatCache *Cache) {
+                              int *FileDescriptor, FileSystemStatCache *Cache,
+                              VirtualFileSystem &FS) {
   LookupResult R;
   bool isForDir = FileDescriptor == 0;
 
-  // If we have a cache, use it to resolve the stat query.
+  // If we have a cache, use it to resolve the stat query.  Otherwise, go to
+  // the file system, which may open the file for us.
   if (Cache)
-    R = Cache->getStat(Path, StatBuf, FileDescriptor);
-  else if (isForDir) {
-    // If this is a directory and we have no cache, just go to the file system.
-    R = ::stat(Path, &StatBuf) != 0 ? CacheMissing : CacheExists;
-  } else {
-    // Otherwise, we have to go to the filesystem.  We can always just use
-    // 'stat' here, but (for files) the client is asking whether the file exists
-    // because it wants to turn around and *open* it.  It is more efficient to
-    // do "open+fstat" on success than it is to do "stat+open".
-    //
-    // Because of this, check to see if the file exists with 'open'.  If the
-    // open succeeds, use fstat to get the stat info.
-    int OpenFlags = O_RDONLY;
-#ifdef O_BINARY
-    OpenFlags |= O_BINARY;  // Open input file in binary mode on win32.
-#endif
-    *FileDescriptor = ::open(Path, OpenFlags);
-    
-    if (*FileDescriptor == -1) {
-      // If the open fails, our "stat" fails.
-      R = CacheMissing;
-    } else {
-      // Otherwise, the open succeeded.  Do an fstat to get the information
-      // about the file.  We'll end up returning the open file descriptor to the
-      // client to do what they please with it.
-      if (::fstat(*FileDescriptor, &StatBuf) == 0)
-        R = CacheExists;
-      else {
-        // fstat rarely fails.  If it does, claim the initial open didn't
-        // succeed.
-        R = CacheMissing;
-        ::close(*FileDescriptor);
-        *FileDescriptor = -1;
-      }
-    }
-  }
+    R = Cache->getStat(Path, StatBuf, FileDescriptor, FS);
+  else
+    R = FS.getStat(Path, StatBuf, FileDescriptor) ? CacheMissing : CacheExists;
 
   // If the path doesn't exist, return failure.
   if (R == CacheMissing) return true;
@@ -104,8 +75,8 @@ bool FileSystemStatCache::get(const char *Path, struct stat &StatBuf,
 
 MemorizeStatCalls::LookupResult
 MemorizeStatCalls::getStat(const char *Path, struct stat &StatBuf,
-                           int *FileDescriptor) {
-  LookupResult Result = statChained(Path, StatBuf, FileDescriptor);
+                           int *FileDescriptor, VirtualFileSystem &FS) {
+  LookupResult Result = statChained(Path, StatBuf, FileDescriptor, FS);
   
   // Do not cache failed stats, it is easy to construct common inconsistent
   // situations if we do, and they are not important for PCH performance (which
@@ -120,3 +91,124 @@ MemorizeStatCalls::getStat(const char *Path, struct stat &StatBuf,
   
   return Result;
 }
+
+namespace {
+/// \brief One cached stat() result of the process-wide table.
+struct SharedStatEntry {
+  bool Exists;
+  /// \brief For missing paths, whether the failed lookup was a file lookup.
+  ///
+  /// A file lookup fails for unreadable directories that a directory lookup
+  /// would find, so misses only answer lookups of the same kind.
+  bool MissingForFileLookup;
+  struct stat StatBuf;
+};
+
+/// \brief The process-wide table behind SharedStatCache.
+///
+/// The table is split into shards by path hash, each with its own
+/// reader/writer lock.
+class SharedStatTable {
+public:
+  enum { NumShards = 32 };
+
+private:
+  struct Shard {
+    llvm::sys::SmartRWMutex<false> Lock;
+    llvm::StringMap<SharedStatEntry, llvm::BumpPtrAllocator> Entries;
+  };
+  Shard Shards[NumShards];
+
+  Shard &getShard(StringRef Path) {
+    return Shards[llvm::HashString(Path) % NumShards];
+  }
+
+public:
+  bool lookup(StringRef Path, SharedStatEntry &Entry) {
+    Shard &S = getShard(Path);
+    llvm::sys::SmartScopedReader<false> Reader(S.Lock);
+    llvm::StringMap<SharedStatEntry, llvm::BumpPtrAllocator>::iterator
+      Known = S.Entries.find(Path);
+    if (Known == S.Entries.end())
+      return false;
+    Entry = Known->second;
+    return true;
+  }
+
+  void insert(StringRef Path, const SharedStatEntry &Entry) {
+    Shard &S = getShard(Path);
+    llvm::sys::SmartScopedWriter<false> Writer(S.Lock);
+    S.Entries[Path] = Entry;
+  }
+
+  void erase(StringRef Path) {
+    Shard &S = getShard(Path);
+    llvm::sys::SmartScopedWriter<false> Writer(S.Lock);
+    S.Entries.erase(Path);
+  }
+
+  void clear() {
+    for (unsigned I = 0; I != NumShards; ++I) {
+      llvm::sys::SmartScopedWriter<false> Writer(Shards[I].Lock);
+      Shards[I].Entries.clear();
+    }
+  }
+};
+}
+
+static SharedStatTable &getSharedStatTable() {
+  // Intentionally leaked, so that FileManagers destroyed during static
+  // destruction can still use it.
+  static SharedStatTable *Table = new SharedStatTable;
+  return *Table;
+}
+
+void SharedStatCache::invalidate(StringRef Path) {
+  getSharedStatTable().erase(Path);
+}
+
+void SharedStatCache::invalidateAll() {
+  getSharedStatTable().clear();
+}
+
+SharedStatCache::LookupResult
+SharedStatCache::getStat(const char *Path, struct stat &StatBuf,
+                         int *FileDescriptor, VirtualFileSystem &FS) {
+  // Relative paths depend on the working directory, and other file systems
+  // on their clients; don't share them.
+  if (!llvm::sys::path::is_absolute(Path) ||
+      &FS != VirtualFileSystem::getRealFileSystem())
+    return statChained(Path, StatBuf, FileDescriptor, FS);
+
+  SharedStatTable &Table = getSharedStatTable();
+  SharedStatEntry Entry;
+  bool IsFileLookup = FileDescriptor != 0;
+  if (Table.lookup(Path, Entry)) {
+    if (!Entry.Exists && Entry.MissingForFileLookup == IsFileLookup)
+      return CacheMissing;
+
+    bool Revalidate = !Entry.Exists ||
+                      (ValidateOnOpen && IsFileLookup &&
+                       !S_ISDIR(Entry.StatBuf.st_mode));
+    if (!Revalidate) {
+      StatBuf = Entry.StatBuf;
+      return CacheExists;
+    }
+  }
+
+  LookupResult Result = statChained(Path, StatBuf, FileDescriptor, FS);
+  if (Result == CacheMissing) {
+    if (CacheMissingPaths) {
+      Entry.Exists = false;
+      Entry.MissingForFileLookup = IsFileLookup;
+      Table.insert(Path, Entry);
+    }
+    return Result;
+  }
+
+  Entry.Exists = true;
+  Entry.MissingForFileLookup = false;
+  Entry.StatBuf = StatBuf;
+  Table.insert(Path, Entry);
+  return Result;
+}
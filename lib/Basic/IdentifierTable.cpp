@@ -13,6 +13,7 @@
 //===----------------------------------------------------------------------===//
 
 #include "clang/Basic/IdentifierTable.h"
+#include "clang/Basic/Builtins.h"
 #include "clang/Basic/LangOptions.h"
 #include "llvm/ADT/FoldingSet.h"
 #include "llvm/ADT/DenseMap.h"
@@ -74,7 +75,7 @@ ExternalIdentifierLookup::~ExternalIdentifierLookup() {}
 IdentifierTable::IdentifierTable(const LangOptions &LangOpts,
                                  IdentifierInfoLookup* externalLookup)
   : HashTable(8192), // Start with space for 8K identifiers.
-    ExternalLookup(externalLookup) {
+    ExternalLookup(externalLookup), LazyBuiltins(0), LexerCache(1024) {
 
   // Populate the identifier table with info about keywords for the current
   // language.
@@ -85,6 +86,21 @@ IdentifierTable::IdentifierTable(const LangOptions &LangOpts,
   get("__experimental_modules_import").setModulesImport(true);
 }
 
+void IdentifierTable::reserveLexerCache(unsigned NumIdentifiers) {
+  // Past this size the cache no longer fits in the caches of the processor.
+  const unsigned MaxSize = 1 << 14;
+  unsigned Size = LexerCache.size();
+  while (Size < NumIdentifiers && Size < MaxSize)
+    Size *= 2;
+  if (Size != LexerCache.size())
+    LexerCache.assign(Size, 0);
+}
+
+void IdentifierTable::setLazyBuiltinID(IdentifierInfo &II) {
+  if (unsigned ID = LazyBuiltins->lookupBuiltin(II.getName()))
+    II.setBuiltinID(ID);
+}
+
 //===----------------------------------------------------------------------===//
 // Language Keyword Implementation
 //===----------------------------------------------------------------------===//
@@ -0,0 +1,146 @@
+//===--- MD5.cpp - Computing MD5 digests of byte strings ------------------===//
+//
+//                     The LLVM Compiler Infrastructure
+//
+// This file is distributed under the University of Illinois Open Source
+// License. See LICENSE.TXT for details.
+//
+//===----------------------------------------------------------------------===//
+//
+//  This file implements the MD5 class, following RFC 1321.
+//
+//===----------------------------------------------------------------------===//
+
+#include "clang/Basic/MD5.h"
+#include <cstring>
+
+using namespace clang;
+
+/// The number of bits each step of a round rotates by.
+static const unsigned Shifts[64] = {
+  7, 12, 17, 22, 7, 12, 17, 22, 7, 12, 17, 22, 7, 12, 17, 22,
+  5, 9, 14, 20, 5, 9, 14, 20, 5, 9, 14, 20, 5, 9, 14, 20,
+  4, 11, 16, 23, 4, 11, 16, 23, 4, 11, 16, 23, 4, 11, 16, 23,
+  6, 10, 15, 21, 6, 10, 15, 21, 6, 10, 15, 21, 6, 10, 15, 21
+};
+
+/// The integer parts of 2^32 * abs(sin(I + 1)), added in step I.
+static const uint32_t Sines[64] = {
+  0xd76aa478, 0xe8c7b756, 0x242070db, 0xc1bdceee,
+  0xf57c0faf, 0x4787c62a, 0xa8304613, 0xfd469501,
+  0x698098d8, 0x8b44f7af, 0xffff5bb1, 0x895cd7be,
+  0x6b901122, 0xfd987193, 0xa679438e, 0x49b40821,
+  0xf61e2562, 0xc040b340, 0x265e5a51, 0xe9b6c7aa,
+  0xd62f105d, 0x02441453, 0xd8a1e681, 0xe7d3fbc8,
+  0x21e1cde6, 0xc33707d6, 0xf4d50d87, 0x455a14ed,
+  0xa9e3e905, 0xfcefa3f8, 0x676f02d9, 0x8d2a4c8a,
+  0xfffa3942, 0x8771f681, 0x6d9d6122, 0xfde5380c,
+  0xa4beea44, 0x4bdecfa9, 0xf6bb4b60, 0xbebfbc70,
+  0x289b7ec6, 0xeaa127fa, 0xd4ef3085, 0x04881d05,
+  0xd9d4d039, 0xe6db99e5, 0x1fa27cf8, 0xc4ac5665,
+  0xf4292244, 0x432aff97, 0xab9423a7, 0xfc93a039,
+  0x655b59c3, 0x8f0ccc92, 0xffeff47d, 0x85845dd1,
+  0x6fa87e4f, 0xfe2ce6e0, 0xa3014314, 0x4e0811a1,
+  0xf7537e82, 0xbd3af235, 0x2ad7d2bb, 0xeb86d391
+};
+
+static uint32_t readLittleEndian32(const uint8_t *P) {
+  return uint32_t(P[0]) | uint32_t(P[1]) << 8 | uint32_t(P[2]) << 16 |
+         uint32_t(P[3]) << 24;
+}
+
+static void writeLittleEndian32(uint8_t *P, uint32_t V) {
+  for (unsigned I = 0; I != 4; ++I)
+    P[I] = uint8_t(V >> (8 * I));
+}
+
+MD5::MD5()
+  : A(0x67452301), B(0xefcdab89), C(0x98badcfe), D(0x10325476), Length(0) {
+}
+
+void MD5::processBlock(const uint8_t *Block) {
+  uint32_t Words[16];
+  for (unsigned I = 0; I != 16; ++I)
+    Words[I] = readLittleEndian32(Block + 4 * I);
+
+  uint32_t a = A, b = B, c = C, d = D;
+  for (unsigned I = 0; I != 64; ++I) {
+    uint32_t F;
+    unsigned W;
+    if (I < 16) {
+      F = (b & c) | (~b & d);
+      W = I;
+    } else if (I < 32) {
+      F = (d & b) | (~d & c);
+      W = (5 * I + 1) % 16;
+    } else if (I < 48) {
+      F = b ^ c ^ d;
+      W = (3 * I + 5) % 16;
+    } else {
+      F = c ^ (b | ~d);
+      W = (7 * I) % 16;
+    }
+    F += a + Sines[I] + Words[W];
+    a = d;
+    d = c;
+    c = b;
+    b += (F << Shifts[I]) | (F >> (32 - Shifts[I]));
+  }
+
+  A += a;
+  B += b;
+  C += c;
+  D += d;
+}
+
+void MD5::update(StringRef Data) {
+  const uint8_t *P = reinterpret_cast<const uint8_t *>(Data.data());
+  size_t Size = Data.size();
+  unsigned Used = Length % 64;
+  Length += Size;
+
+  // Complete the block left over from the previous update.
+  if (Used) {
+    size_t Fill = 64 - Used;
+    if (Size < Fill) {
+      memcpy(Buffer + Used, P, Size);
+      return;
+    }
+    memcpy(Buffer + Used, P, Fill);
+    processBlock(Buffer);
+    P += Fill;
+    Size -= Fill;
+  }
+
+  for (; Size >= 64; P += 64, Size -= 64)
+    processBlock(P);
+  memcpy(Buffer, P, Size);
+}
+
+void MD5::final(Digest &Result) {
+  // Pad with a 1 bit and then 0 bits up to 8 bytes short of a block, and end
+  // with the length in bits.
+  uint64_t BitLength = Length * 8;
+  static const uint8_t Padding[64] = { 0x80 };
+  unsigned Used = Length % 64;
+  update(StringRef(reinterpret_cast<const char *>(Padding),
+                   (Used < 56 ? 56 : 120) - Used));
+  uint8_t LengthBytes[8];
+  writeLittleEndian32(LengthBytes, uint32_t(BitLength));
+  writeLittleEndian32(LengthBytes + 4, uint32_t(BitLength >> 32));
+  update(StringRef(reinterpret_cast<const char *>(LengthBytes), 8));
+
+  writeLittleEndian32(Result, A);
+  writeLittleEndian32(Result + 4, B);
+  writeLittleEndian32(Result + 8, C);
+  writeLittleEndian32(Result + 12, D);
+}
+
+void MD5::hash(StringRef Data, uint32_t (&Words)[4]) {
+  MD5 Hasher;
+  Hasher.update(Data);
+  Digest Result;
+  Hasher.final(Result);
+  for (unsigned I = 0; I != 4; ++I)
+    Words[I] = readLittleEndian32(Result + 4 * I);
+}
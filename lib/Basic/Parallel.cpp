@@ -0,0 +1,180 @@
+//===--- Parallel.cpp - Running independent tasks on worker threads -------===//
+//
+//                     The LLVM Compiler Infrastructure
+//
+// This file is distributed under the University of Illinois Open Source
+// License. See LICENSE.TXT for details.
+//
+//===----------------------------------------------------------------------===//
+//
+//  This file implements runTasksInParallel, BackgroundThread and related
+//  helpers.
+//
+//===----------------------------------------------------------------------===//
+
+#include "clang/Basic/Parallel.h"
+#include "clang/Basic/LLVM.h"
+#include "llvm/ADT/SmallVector.h"
+#include "llvm/Config/config.h"
+#include "llvm/Support/Atomic.h"
+#include "llvm/Support/Threading.h"
+
+#if LLVM_MULTITHREADED && defined(HAVE_PTHREAD_H)
+#include <pthread.h>
+#include <unistd.h>
+#define CLANG_PARALLEL_USE_PTHREADS 1
+#endif
+
+using namespace clang;
+
+unsigned clang::getNumberOfHardwareThreads() {
+#if defined(CLANG_PARALLEL_USE_PTHREADS) && defined(_SC_NPROCESSORS_ONLN)
+  long NumCPUs = ::sysconf(_SC_NPROCESSORS_ONLN);
+  if (NumCPUs > 0)
+    return static_cast<unsigned>(NumCPUs);
+#endif
+  return 1;
+}
+
+bool clang::isParallelExecutionSupported() {
+#ifdef CLANG_PARALLEL_USE_PTHREADS
+  return true;
+#else
+  return false;
+#endif
+}
+
+namespace {
+/// \brief The state shared by all workers of one runTasksInParallel call.
+struct TaskQueue {
+  void (*Fn)(void *UserData, unsigned TaskIndex);
+  void *UserData;
+  unsigned NumTasks;
+  /// \brief The number of tasks handed out so far.
+  volatile llvm::sys::cas_flag NextTask;
+};
+}
+
+static void runQueuedTasks(TaskQueue &Queue) {
+  while (true) {
+    unsigned Index = llvm::sys::AtomicIncrement(&Queue.NextTask) - 1;
+    if (Index >= Queue.NumTasks)
+      return;
+    Queue.Fn(Queue.UserData, Index);
+  }
+}
+
+#ifdef CLANG_PARALLEL_USE_PTHREADS
+static void *ParallelWorker(void *Arg) {
+  runQueuedTasks(*static_cast<TaskQueue *>(Arg));
+  return 0;
+}
+#endif
+
+void clang::runTasksInParallel(unsigned NumThreads, unsigned NumTasks,
+                               void (*Fn)(void *UserData, unsigned TaskIndex),
+                               void *UserData, unsigned StackSize) {
+  TaskQueue Queue;
+  Queue.Fn = Fn;
+  Queue.UserData = UserData;
+  Queue.NumTasks = NumTasks;
+  Queue.NextTask = 0;
+
+  if (NumThreads == 0)
+    NumThreads = getNumberOfHardwareThreads();
+  if (NumThreads > NumTasks)
+    NumThreads = NumTasks;
+
+#ifdef CLANG_PARALLEL_USE_PTHREADS
+  if (NumThreads > 1) {
+    // The workers below call into code that may consult the global lock.
+    llvm::llvm_start_multithreaded();
+
+    pthread_attr_t Attr;
+    if (::pthread_attr_init(&Attr) == 0) {
+      if (StackSize)
+        ::pthread_attr_setstacksize(&Attr, StackSize);
+
+      // The calling thread acts as one of the workers.
+      SmallVector<pthread_t, 16> Workers;
+      for (unsigned I = 1; I != NumThreads; ++I) {
+        pthread_t Thread;
+        if (::pthread_create(&Thread, &Attr, ParallelWorker, &Queue) != 0)
+          break;
+        Workers.push_back(Thread);
+      }
+      ::pthread_attr_destroy(&Attr);
+
+      runQueuedTasks(Queue);
+      for (unsigned I = 0, E = Workers.size(); I != E; ++I)
+        ::pthread_join(Workers[I], 0);
+      return;
+    }
+  }
+#endif
+
+  (void)StackSize;
+  runQueuedTasks(Queue);
+}
+
+#ifdef CLANG_PARALLEL_USE_PTHREADS
+namespace {
+struct BackgroundThreadInfo {
+  pthread_t Thread;
+  void (*Fn)(void *UserData);
+  void *UserData;
+};
+}
+
+static void *BackgroundWorker(void *Arg) {
+  BackgroundThreadInfo *Info = static_cast<BackgroundThreadInfo *>(Arg);
+  Info->Fn(Info->UserData);
+  return 0;
+}
+#endif
+
+bool BackgroundThread::start(void (*Fn)(void *UserData), void *UserData,
+                             unsigned StackSize) {
+  join();
+
+#ifdef CLANG_PARALLEL_USE_PTHREADS
+  llvm::llvm_start_multithreaded();
+
+  pthread_attr_t Attr;
+  if (::pthread_attr_init(&Attr) != 0)
+    return false;
+  if (StackSize)
+    ::pthread_attr_setstacksize(&Attr, StackSize);
+
+  BackgroundThreadInfo *Info = new BackgroundThreadInfo();
+  Info->Fn = Fn;
+  Info->UserData = UserData;
+  bool Started
+    = ::pthread_create(&Info->Thread, &Attr, BackgroundWorker, Info) == 0;
+  ::pthread_attr_destroy(&Attr);
+  if (!Started) {
+    delete Info;
+    return false;
+  }
+
+  Thread = Info;
+  return true;
+#else
+  (void)Fn;
+  (void)UserData;
+  (void)StackSize;
+  return false;
+#endif
+}
+
+void BackgroundThread::join() {
+  if (!Thread)
+    return;
+
+#ifdef CLANG_PARALLEL_USE_PTHREADS
+  BackgroundThreadInfo *Info = static_cast<BackgroundThreadInfo *>(Thread);
+  ::pthread_join(Info->Thread, 0);
+  delete Info;
+#endif
+  Thread = 0;
+}
@@ -0,0 +1,48 @@
+//===--- ProfilingSupport.cpp - Helpers for profiling reports -------------===//
+//
+//                     The LLVM Compiler Infrastructure
+//
+// This file is distributed under the University of Illinois Open Source
+// License. See LICENSE.TXT for details.
+//
+//===----------------------------------------------------------------------===//
+//
+//  This file implements the clock and JSON helpers of the profilers.
+//
+//===----------------------------------------------------------------------===//
+
+#include "clang/Basic/ProfilingSupport.h"
+#include "llvm/ADT/StringExtras.h"
+#include "llvm/Support/TimeValue.h"
+#include "llvm/Support/raw_ostream.h"
+
+using namespace clang;
+
+uint64_t clang::getCurrentTimeInNanoseconds() {
+  llvm::sys::TimeValue Now = llvm::sys::TimeValue::now();
+  return uint64_t(Now.seconds()) * 1000000000 + Now.nanoseconds();
+}
+
+uint64_t clang::getCurrentTimeInMilliseconds() {
+  llvm::sys::TimeValue Now = llvm::sys::TimeValue::now();
+  return uint64_t(Now.seconds()) * 1000 + Now.milliseconds();
+}
+
+double clang::getCurrentTimeInSeconds() {
+  llvm::sys::TimeValue Now = llvm::sys::TimeValue::now();
+  return Now.seconds() + Now.nanoseconds() / 1e9;
+}
+
+void clang::printJSONString(raw_ostream &OS, StringRef Str) {
+  OS << '"';
+  for (unsigned I = 0, N = Str.size(); I != N; ++I) {
+    unsigned char C = Str[I];
+    if (C == '"' || C == '\\')
+      OS << '\\' << C;
+    else if (C < 0x20)
+      OS << "\\u00" << llvm::hexdigit(C >> 4) << llvm::hexdigit(C & 0xF);
+    else
+      OS << C;
+  }
+  OS << '"';
+}
@@ -15,11 +15,14 @@
 #include "clang/Basic/SourceManagerInternals.h"
 #include "clang/Basic/Diagnostic.h"
 #include "clang/Basic/FileManager.h"
+#include "clang/Basic/Parallel.h"
 #include "llvm/ADT/StringSwitch.h"
 #include "llvm/ADT/Optional.h"
 #include "llvm/ADT/STLExtras.h"
+#include "llvm/Config/config.h"
 #include "llvm/Support/Compiler.h"
 #include "llvm/Support/MemoryBuffer.h"
+#include "llvm/Support/Process.h"
 #include "llvm/Support/raw_ostream.h"
 #include "llvm/Support/Path.h"
 #include "llvm/Support/Capacity.h"
@@ -27,6 +30,9 @@
 #include <string>
 #include <cstring>
 #include <sys/stat.h>
+#ifdef HAVE_SYS_MMAN_H
+#include <sys/mman.h>
+#endif
 
 using namespace clang;
 using namespace SrcMgr;
@@ -373,15 +379,17 @@ LineTableInfo &SourceManager::getLineTable() {
 SourceManager::SourceManager(DiagnosticsEngine &Diag, FileManager &FileMgr,
                              bool UserFilesAreVolatile)
   : Diag(Diag), FileMgr(FileMgr), OverridenFilesKeepOriginalName(true),
-    UserFilesAreVolatile(UserFilesAreVolatile),
+    UserFilesAreVolatile(UserFilesAreVolatile), ReleaseFinishedBuffers(false),
     ExternalSLocEntries(0), LineTable(0), NumLinearScans(0),
-    NumBinaryProbes(0), FakeBufferForRecovery(0),
-    FakeContentCacheForRecovery(0) {
+    NumBinaryProbes(0), NumReleasedBuffers(0), NumReleasedBufferBytes(0),
+    FakeBufferForRecovery(0),
+    FakeContentCacheForRecovery(0), PendingLineTables(0) {
   clearIDTables();
   Diag.setSourceManager(this);
 }
 
 SourceManager::~SourceManager() {
+  finishLineTablePrecomputation();
   delete LineTable;
 
   // Delete FileEntry objects corresponding to content caches.  Since the actual
@@ -418,6 +426,9 @@ void SourceManager::clearIDTables() {
   LastLineNoFileIDQuery = FileID();
   LastLineNoContentCache = 0;
   LastFileIDLookup = FileID();
+  IsBeforeInTUCache.clear();
+  IsBeforeInTUCacheOverflow.clear();
+  IncludeParents.clear();
 
   if (LineTable)
     LineTable->clear();
@@ -629,6 +640,9 @@ SourceManager::getMemoryBufferForFile(const FileEntry *File,
 void SourceManager::overrideFileContents(const FileEntry *SourceFile,
                                          const llvm::MemoryBuffer *Buffer,
                                          bool DoNotFree) {
+  // A background line table computation may be reading the old buffer.
+  finishLineTablePrecomputation();
+
   const SrcMgr::ContentCache *IR = getOrCreateContentCache(SourceFile);
   assert(IR && "getOrCreateContentCache() cannot return NULL");
 
@@ -653,6 +667,7 @@ void SourceManager::disableFileContentsOverride(const FileEntry *File) {
   if (!isFileOverridden(File))
     return;
 
+  finishLineTablePrecomputation();
   const SrcMgr::ContentCache *IR = getOrCreateContentCache(File);
   const_cast<SrcMgr::ContentCache *>(IR)->replaceBuffer(0);
   const_cast<SrcMgr::ContentCache *>(IR)->ContentsEntry = IR->OrigEntry;
@@ -1029,6 +1044,19 @@ unsigned SourceManager::getColumnNumber(FileID FID, unsigned FilePos,
     return 1;
   }
 
+  // If the line number of a position on this line was just computed, the
+  // line table has its start, which spares the scan back through a long
+  // line.
+  if (LastLineNoFileIDQuery == FID &&
+      LastLineNoContentCache->SourceLineCache != 0 &&
+      LastLineNoResult < LastLineNoContentCache->NumLines) {
+    unsigned *SourceLineCache = LastLineNoContentCache->SourceLineCache;
+    unsigned LineStart = SourceLineCache[LastLineNoResult - 1];
+    unsigned LineEnd = SourceLineCache[LastLineNoResult];
+    if (FilePos >= LineStart && FilePos < LineEnd)
+      return FilePos - LineStart + 1;
+  }
+
   const char *Buf = MemBuf->getBufferStart();
   unsigned LineStart = FilePos;
   while (LineStart && Buf[LineStart-1] != '\n' && Buf[LineStart-1] != '\r')
@@ -1069,23 +1097,12 @@ unsigned SourceManager::getPresumedColumnNumber(SourceLocation Loc,
 #include <emmintrin.h>
 #endif
 
-static LLVM_ATTRIBUTE_NOINLINE void
-ComputeLineNumbers(DiagnosticsEngine &Diag, ContentCache *FI,
-                   llvm::BumpPtrAllocator &Alloc,
-                   const SourceManager &SM, bool &Invalid);
-static void ComputeLineNumbers(DiagnosticsEngine &Diag, ContentCache *FI,
-                               llvm::BumpPtrAllocator &Alloc,
-                               const SourceManager &SM, bool &Invalid) {
-  // Note that calling 'getBuffer()' may lazily page in the file.
-  const MemoryBuffer *Buffer = FI->getBuffer(Diag, SM, SourceLocation(),
-                                             &Invalid);
-  if (Invalid)
-    return;
-
-  // Find the file offsets of all of the *physical* source lines.  This does
-  // not look at trigraphs, escaped newlines, or anything else tricky.
-  SmallVector<unsigned, 256> LineOffsets;
-
+/// ComputeLineOffsets - Find the file offsets of all of the *physical* source
+/// lines of \p Buffer.  This does not look at trigraphs, escaped newlines, or
+/// anything else tricky.  It only reads the buffer, so it may run on any
+/// thread.
+static void ComputeLineOffsets(const MemoryBuffer *Buffer,
+                               SmallVectorImpl<unsigned> &LineOffsets) {
   // Line #1 starts at char 0.
   LineOffsets.push_back(0);
 
@@ -1148,13 +1165,144 @@ FoundSpecialChar:
       ++Offs, ++Buf;
     }
   }
+}
 
-  // Copy the offsets into the FileInfo structure.
+/// SetLineOffsets - Copy the offsets into the ContentCache structure.
+static void SetLineOffsets(ContentCache *FI, llvm::BumpPtrAllocator &Alloc,
+                           ArrayRef<unsigned> LineOffsets) {
   FI->NumLines = LineOffsets.size();
   FI->SourceLineCache = Alloc.Allocate<unsigned>(LineOffsets.size());
   std::copy(LineOffsets.begin(), LineOffsets.end(), FI->SourceLineCache);
 }
 
+static LLVM_ATTRIBUTE_NOINLINE void
+ComputeLineNumbers(DiagnosticsEngine &Diag, ContentCache *FI,
+                   llvm::BumpPtrAllocator &Alloc,
+                   const SourceManager &SM, bool &Invalid);
+static void ComputeLineNumbers(DiagnosticsEngine &Diag, ContentCache *FI,
+                               llvm::BumpPtrAllocator &Alloc,
+                               const SourceManager &SM, bool &Invalid) {
+  // Use the table computed in the background, if there is one.
+  SM.finishLineTablePrecomputation();
+  if (FI->SourceLineCache) {
+    Invalid = false;
+    return;
+  }
+
+  // Note that calling 'getBuffer()' may lazily page in the file.
+  const MemoryBuffer *Buffer = FI->getBuffer(Diag, SM, SourceLocation(),
+                                             &Invalid);
+  if (Invalid)
+    return;
+
+  SmallVector<unsigned, 256> LineOffsets;
+  ComputeLineOffsets(Buffer, LineOffsets);
+  SetLineOffsets(FI, Alloc, LineOffsets);
+}
+
+ArrayRef<unsigned> SourceManager::getLineTable(FileID FID,
+                                               bool *Invalid) const {
+  bool MyInvalid = false;
+  const SLocEntry &Entry = getSLocEntry(FID, &MyInvalid);
+  if (MyInvalid || !Entry.isFile() || !Entry.getFile().getContentCache()) {
+    if (Invalid)
+      *Invalid = true;
+    return ArrayRef<unsigned>();
+  }
+
+  ContentCache *Content
+    = const_cast<ContentCache *>(Entry.getFile().getContentCache());
+  if (Content->SourceLineCache == 0)
+    ComputeLineNumbers(Diag, Content, ContentCacheAlloc, *this, MyInvalid);
+  if (Invalid)
+    *Invalid = MyInvalid;
+  if (MyInvalid)
+    return ArrayRef<unsigned>();
+  return ArrayRef<unsigned>(Content->SourceLineCache, Content->NumLines);
+}
+
+void SourceManager::setLineTable(FileID FID, ArrayRef<unsigned> LineOffsets) {
+  bool Invalid = false;
+  const SLocEntry &Entry = getSLocEntry(FID, &Invalid);
+  if (Invalid || !Entry.isFile() || LineOffsets.empty())
+    return;
+
+  ContentCache *Content
+    = const_cast<ContentCache *>(Entry.getFile().getContentCache());
+  if (Content && Content->SourceLineCache == 0)
+    SetLineOffsets(Content, ContentCacheAlloc, LineOffsets);
+}
+
+/// \brief The state of a background line table computation.
+///
+/// The buffers are collected on the thread that owns the SourceManager, and
+/// the results are only copied into the content caches from that thread, in
+/// finishLineTablePrecomputation().
+struct SourceManager::LineTablePrecomputation {
+  std::vector<ContentCache *> Contents;
+  std::vector<const MemoryBuffer *> Buffers;
+  std::vector<std::vector<unsigned> > Results;
+  BackgroundThread Thread;
+
+  static void computeOne(void *UserData, unsigned Index) {
+    LineTablePrecomputation *Job
+      = static_cast<LineTablePrecomputation *>(UserData);
+    SmallVector<unsigned, 256> LineOffsets;
+    ComputeLineOffsets(Job->Buffers[Index], LineOffsets);
+    Job->Results[Index].assign(LineOffsets.begin(), LineOffsets.end());
+  }
+
+  static void computeAll(void *UserData) {
+    LineTablePrecomputation *Job
+      = static_cast<LineTablePrecomputation *>(UserData);
+    runTasksInParallel(0, Job->Buffers.size(), computeOne, Job);
+  }
+
+  void add(ContentCache *Content, unsigned MinFileSize) {
+    if (!Content || Content->SourceLineCache)
+      return;
+    const MemoryBuffer *Buffer = Content->getRawBuffer();
+    if (!Buffer || Buffer->getBufferSize() < MinFileSize)
+      return;
+    Contents.push_back(Content);
+    Buffers.push_back(Buffer);
+  }
+};
+
+void SourceManager::startLineTablePrecomputation(unsigned MinFileSize) {
+  finishLineTablePrecomputation();
+
+  LineTablePrecomputation *Job = new LineTablePrecomputation();
+  for (llvm::DenseMap<const FileEntry*, SrcMgr::ContentCache*>::iterator
+       I = FileInfos.begin(), E = FileInfos.end(); I != E; ++I)
+    Job->add(I->second, MinFileSize);
+  for (unsigned I = 0, N = MemBufferInfos.size(); I != N; ++I)
+    Job->add(MemBufferInfos[I], MinFileSize);
+
+  if (Job->Buffers.empty()) {
+    delete Job;
+    return;
+  }
+
+  Job->Results.resize(Job->Buffers.size());
+  PendingLineTables = Job;
+  if (!Job->Thread.start(LineTablePrecomputation::computeAll, Job))
+    LineTablePrecomputation::computeAll(Job);
+}
+
+void SourceManager::finishLineTablePrecomputation() const {
+  LineTablePrecomputation *Job = PendingLineTables;
+  if (!Job)
+    return;
+
+  Job->Thread.join();
+  PendingLineTables = 0;
+  for (unsigned I = 0, N = Job->Contents.size(); I != N; ++I)
+    if (Job->Contents[I]->SourceLineCache == 0)
+      SetLineOffsets(Job->Contents[I], ContentCacheAlloc, Job->Results[I]);
+  delete Job;
+}
+
 /// getLineNumber - Given a SourceLocation, return the spelling line number
 /// for the position indicated.  This requires building and caching a table of
 /// line offsets for the MemoryBuffer, so this is not cheap: use only when
@@ -1790,7 +1938,64 @@ static bool MoveUpIncludeHierarchy(std::pair<FileID, unsigned> &Loc,
   Loc = SM.getDecomposedLoc(UpperLoc);
   return false;
 }
-  
+
+/// \brief Return the cache for the isBeforeInTranslationUnit queries which
+/// compare a location in \p LFID with one in \p RFID.
+IsBeforeInTranslationUnitCache &
+SourceManager::getIsBeforeInTUCache(FileID LFID, FileID RFID) const {
+  // Sorting diagnostics or declarations compares locations from many pairs of
+  // files, but a few hundred entries cover the pairs that recur.
+  const unsigned MaxCachedPairs = 256;
+  std::pair<FileID, FileID> Key(LFID, RFID);
+  IsBeforeInTUCacheMap::iterator I = IsBeforeInTUCache.find(Key);
+  if (I != IsBeforeInTUCache.end())
+    return I->second;
+  if (IsBeforeInTUCache.size() < MaxCachedPairs)
+    return IsBeforeInTUCache[Key];
+  return IsBeforeInTUCacheOverflow;
+}
+
+/// \brief Return the parent of \p FID in the tree of \#includes and macro
+/// expansions, and its depth in the tree.
+SourceManager::IncludeParent
+SourceManager::getIncludeParent(FileID FID) const {
+  llvm::DenseMap<FileID, IncludeParent>::iterator I = IncludeParents.find(FID);
+  if (I != IncludeParents.end())
+    return I->second;
+
+  // Walk up to the root, or to the first ancestor whose parent is known, then
+  // fill in the depths on the way back down.
+  SmallVector<std::pair<FileID, IncludeParent>, 8> Chain;
+  unsigned Depth;
+  while (true) {
+    std::pair<FileID, unsigned> Loc(FID, 0);
+    IncludeParent Parent;
+    if (MoveUpIncludeHierarchy(Loc, *this)) {
+      Parent.ParentFID = FileID();
+      Parent.Offset = 0;
+      Chain.push_back(std::make_pair(FID, Parent));
+      Depth = 0;
+      break;
+    }
+
+    Parent.ParentFID = Loc.first;
+    Parent.Offset = Loc.second;
+    Chain.push_back(std::make_pair(FID, Parent));
+    I = IncludeParents.find(Loc.first);
+    if (I != IncludeParents.end()) {
+      Depth = I->second.Depth + 1;
+      break;
+    }
+    FID = Loc.first;
+  }
+
+  for (unsigned N = Chain.size(); N != 0; --N, ++Depth) {
+    Chain[N - 1].second.Depth = Depth;
+    IncludeParents[Chain[N - 1].first] = Chain[N - 1].second;
+  }
+  return Chain.front().second;
+}
+
 
 /// \brief Determines the order of 2 source locations in the translation unit.
 ///
@@ -1810,44 +2015,46 @@ bool SourceManager::isBeforeInTranslationUnit(SourceLocation LHS,
 
   // If we are comparing a source location with multiple locations in the same
   // file, we get a big win by caching the result.
-  if (IsBeforeInTUCache.isCacheValid(LOffs.first, ROffs.first))
-    return IsBeforeInTUCache.getCachedResult(LOffs.second, ROffs.second);
+  IsBeforeInTranslationUnitCache &Cache =
+    getIsBeforeInTUCache(LOffs.first, ROffs.first);
+  if (Cache.isCacheValid(LOffs.first, ROffs.first))
+    return Cache.getCachedResult(LOffs.second, ROffs.second);
 
   // Okay, we missed in the cache, start updating the cache for this query.
-  IsBeforeInTUCache.setQueryFIDs(LOffs.first, ROffs.first,
-                          /*isLFIDBeforeRFID=*/LOffs.first.ID < ROffs.first.ID);
-
-  // We need to find the common ancestor. The only way of doing this is to
-  // build the complete include chain for one and then walking up the chain
-  // of the other looking for a match.
-  // We use a map from FileID to Offset to store the chain. Easier than writing
-  // a custom set hash info that only depends on the first part of a pair.
-  typedef llvm::DenseMap<FileID, unsigned> LocSet;
-  LocSet LChain;
-  do {
-    LChain.insert(LOffs);
-    // We catch the case where LOffs is in a file included by ROffs and
-    // quit early. The other way round unfortunately remains suboptimal.
-  } while (LOffs.first != ROffs.first && !MoveUpIncludeHierarchy(LOffs, *this));
-  LocSet::iterator I;
-  while((I = LChain.find(ROffs.first)) == LChain.end()) {
-    if (MoveUpIncludeHierarchy(ROffs, *this))
-      break; // Met at topmost file.
+  Cache.setQueryFIDs(LOffs.first, ROffs.first,
+                     /*isLFIDBeforeRFID=*/LOffs.first.ID < ROffs.first.ID);
+
+  // We need to find the common ancestor.  Walk up from the deeper of the two
+  // locations until both are at the same depth, then walk up from both until
+  // they meet.
+  IncludeParent LParent = getIncludeParent(LOffs.first);
+  IncludeParent RParent = getIncludeParent(ROffs.first);
+  while (LParent.Depth > RParent.Depth) {
+    LOffs = std::make_pair(LParent.ParentFID, LParent.Offset);
+    LParent = getIncludeParent(LOffs.first);
+  }
+  while (RParent.Depth > LParent.Depth) {
+    ROffs = std::make_pair(RParent.ParentFID, RParent.Offset);
+    RParent = getIncludeParent(ROffs.first);
+  }
+  while (LOffs.first != ROffs.first && LParent.Depth != 0) {
+    LOffs = std::make_pair(LParent.ParentFID, LParent.Offset);
+    LParent = getIncludeParent(LOffs.first);
+    ROffs = std::make_pair(RParent.ParentFID, RParent.Offset);
+    RParent = getIncludeParent(ROffs.first);
   }
-  if (I != LChain.end())
-    LOffs = *I;
 
-  // If we exited because we found a nearest common ancestor, compare the
-  // locations within the common file and cache them.
+  // If we found a nearest common ancestor, compare the locations within the
+  // common file and cache them.
   if (LOffs.first == ROffs.first) {
-    IsBeforeInTUCache.setCommonLoc(LOffs.first, LOffs.second, ROffs.second);
-    return IsBeforeInTUCache.getCachedResult(LOffs.second, ROffs.second);
+    Cache.setCommonLoc(LOffs.first, LOffs.second, ROffs.second);
+    return Cache.getCachedResult(LOffs.second, ROffs.second);
   }
 
   // This can happen if a location is in a built-ins buffer.
   // But see PR5662.
   // Clear the lookup cache, it depends on a common location.
-  IsBeforeInTUCache.clear();
+  Cache.clear();
   bool LIsBuiltins = strcmp("<built-in>",
                             getBuffer(LOffs.first)->getBufferIdentifier()) == 0;
   bool RIsBuiltins = strcmp("<built-in>",
@@ -1862,6 +2069,34 @@ bool SourceManager::isBeforeInTranslationUnit(SourceLocation LHS,
   return LOffs.first < ROffs.first;
 }
 
+void SourceManager::releaseFileBuffer(FileID FID) {
+  bool Invalid = false;
+  const SLocEntry &Entry = getSLocEntry(FID, &Invalid);
+  if (Invalid || !Entry.isFile())
+    return;
+
+  const ContentCache *Content = Entry.getFile().getContentCache();
+  const MemoryBuffer *Buffer = Content->getRawBuffer();
+  if (!Buffer || Content->isBufferInvalid() ||
+      Buffer->getBufferKind() != MemoryBuffer::MemoryBuffer_MMap)
+    return;
+
+#if defined(HAVE_SYS_MMAN_H) && defined(MADV_DONTNEED)
+  // Drop the whole pages of the read-only mapping.  The buffer stays mapped,
+  // so whoever touches it again reads the pages back from the file.
+  uintptr_t PageSize = llvm::sys::Process::GetPageSize();
+  uintptr_t Start = (uintptr_t)Buffer->getBufferStart();
+  uintptr_t End = (uintptr_t)Buffer->getBufferEnd();
+  Start = (Start + PageSize - 1) & ~(PageSize - 1);
+  End &= ~(PageSize - 1);
+  if (Start >= End || ::madvise((void*)Start, End - Start, MADV_DONTNEED))
+    return;
+
+  ++NumReleasedBuffers;
+  NumReleasedBufferBytes += End - Start;
+#endif
+}
+
 void SourceManager::PrintStats() const {
   llvm::errs() << "\n*** Source Manager Stats:\n";
   llvm::errs() << FileInfos.size() << " files mapped, " << MemBufferInfos.size()
@@ -1874,7 +2109,33 @@ void SourceManager::PrintStats() const {
                << " loaded SLocEntries allocated, "
                << MaxLoadedOffset - CurrentLoadedOffset
                << "B of Sloc address space used.\n";
-  
+
+  // Break down the local table by kind of entry.  Macro argument expansions
+  // tend to dominate in heavily preprocessed code.
+  unsigned NumMacroExpansions = 0, NumMacroArgExpansions = 0;
+  unsigned MacroExpansionSpace = 0, MacroArgExpansionSpace = 0;
+  for (unsigned I = 0, N = LocalSLocEntryTable.size(); I != N; ++I) {
+    const SrcMgr::SLocEntry &Entry = LocalSLocEntryTable[I];
+    if (!Entry.isExpansion())
+      continue;
+    unsigned EntryEnd = I + 1 == N ? NextLocalOffset
+                                   : LocalSLocEntryTable[I + 1].getOffset();
+    if (Entry.getExpansion().isMacroArgExpansion()) {
+      ++NumMacroArgExpansions;
+      MacroArgExpansionSpace += EntryEnd - Entry.getOffset();
+    } else {
+      ++NumMacroExpansions;
+      MacroExpansionSpace += EntryEnd - Entry.getOffset();
+    }
+  }
+  llvm::errs() << NumMacroExpansions << " macro expansion SLocEntry's ("
+               << NumMacroExpansions * sizeof(SrcMgr::SLocEntry) << " bytes, "
+               << MacroExpansionSpace << "B of Sloc address space), "
+               << NumMacroArgExpansions << " macro arg expansion SLocEntry's ("
+               << NumMacroArgExpansions * sizeof(SrcMgr::SLocEntry)
+               << " bytes, " << MacroArgExpansionSpace
+               << "B of Sloc address space).\n";
+
   unsigned NumLineNumsComputed = 0;
   unsigned NumFileBytesMapped = 0;
   for (fileinfo_iterator I = fileinfo_begin(), E = fileinfo_end(); I != E; ++I){
@@ -1888,6 +2149,9 @@ void SourceManager::PrintStats() const {
                << NumMacroArgsComputed << " files with macro args computed.\n";
   llvm::errs() << "FileID scans: " << NumLinearScans << " linear, "
                << NumBinaryProbes << " binary.\n";
+  if (ReleaseFinishedBuffers)
+    llvm::errs() << NumReleasedBuffers << " file buffers released ("
+                 << NumReleasedBufferBytes << " bytes).\n";
 }
 
 ExternalSLocEntrySource::~ExternalSLocEntrySource() { }
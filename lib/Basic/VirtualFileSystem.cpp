@@ -0,0 +1,258 @@
+//===--- VirtualFileSystem.cpp - File system beneath FileManager ----------===//
+//
+//                     The LLVM Compiler Infrastructure
+//
+// This file is distributed under the University of Illinois Open Source
+// License. See LICENSE.TXT for details.
+//
+//===----------------------------------------------------------------------===//
+//
+//  This file implements the VirtualFileSystem interface.
+//
+//===----------------------------------------------------------------------===//
+
+#include "clang/Basic/VirtualFileSystem.h"
+#include "llvm/ADT/SmallString.h"
+#include "llvm/Support/Atomic.h"
+#include "llvm/Support/MemoryBuffer.h"
+#include "llvm/Support/Path.h"
+#include <cstring>
+#include <fcntl.h>
+
+// FIXME: This is terrible, we need this for ::close.
+#if !defined(_MSC_VER) && !defined(__MINGW32__)
+#include <unistd.h>
+#include <sys/uio.h>
+#else
+#include <io.h>
+#endif
+using namespace clang;
+
+void VirtualFileSystem::anchor() { }
+
+//===----------------------------------------------------------------------===//
+// RealFileSystem
+//===----------------------------------------------------------------------===//
+
+namespace {
+/// \brief The file system of the operating system.
+class RealFileSystem : public VirtualFileSystem {
+public:
+  virtual bool getStat(const char *Path, struct stat &StatBuf,
+                       int *FileDescriptor);
+  virtual llvm::error_code
+  getBufferForFile(const char *Path, OwningPtr<llvm::MemoryBuffer> &Result,
+                   int64_t FileSize, bool RequiresNullTerminator);
+};
+}
+
+bool RealFileSystem::getStat(const char *Path, struct stat &StatBuf,
+                             int *FileDescriptor) {
+  // If this is a directory, just go to the file system.
+  if (!FileDescriptor)
+    return ::stat(Path, &StatBuf) != 0;
+
+  // We can always just use 'stat' here, but (for files) the client is asking
+  // whether the file exists because it wants to turn around and *open* it.
+  // It is more efficient to do "open+fstat" on success than it is to do
+  // "stat+open".
+  //
+  // Because of this, check to see if the file exists with 'open'.  If the
+  // open succeeds, use fstat to get the stat info.
+  int OpenFlags = O_RDONLY;
+#ifdef O_BINARY
+  OpenFlags |= O_BINARY;  // Open input file in binary mode on win32.
+#endif
+  *FileDescriptor = ::open(Path, OpenFlags);
+
+  // If the open fails, our "stat" fails.
+  if (*FileDescriptor == -1)
+    return true;
+
+  // Otherwise, the open succeeded.  Do an fstat to get the information
+  // about the file.  We'll end up returning the open file descriptor to the
+  // client to do what they please with it.
+  if (::fstat(*FileDescriptor, &StatBuf) == 0)
+    return false;
+
+  // fstat rarely fails.  If it does, claim the initial open didn't succeed.
+  ::close(*FileDescriptor);
+  *FileDescriptor = -1;
+  return true;
+}
+
+llvm::error_code
+RealFileSystem::getBufferForFile(const char *Path,
+                                 OwningPtr<llvm::MemoryBuffer> &Result,
+                                 int64_t FileSize,
+                                 bool RequiresNullTerminator) {
+  return llvm::MemoryBuffer::getFile(Path, Result, FileSize,
+                                     RequiresNullTerminator);
+}
+
+static VirtualFileSystem *createRealFileSystem() {
+  VirtualFileSystem *FS = new RealFileSystem;
+  // Never let the references of the clients destroy it.
+  FS->Retain();
+  return FS;
+}
+
+VirtualFileSystem *VirtualFileSystem::getRealFileSystem() {
+  // Intentionally leaked, so that FileManagers destroyed during static
+  // destruction can still use it.
+  static VirtualFileSystem *FS = createRealFileSystem();
+  return FS;
+}
+
+//===----------------------------------------------------------------------===//
+// InMemoryFileSystem
+//===----------------------------------------------------------------------===//
+
+/// \brief Remove the "." components of \p Path and resolve its ".." ones.
+static void normalizePath(StringRef Path, SmallVectorImpl<char> &Result) {
+  SmallVector<StringRef, 16> Components;
+  StringRef Root = llvm::sys::path::root_path(Path);
+  StringRef Relative = llvm::sys::path::relative_path(Path);
+  for (llvm::sys::path::const_iterator I = llvm::sys::path::begin(Relative),
+                                       E = llvm::sys::path::end(Relative);
+       I != E; ++I) {
+    StringRef Component = *I;
+    if (Component == ".")
+      continue;
+    if (Component == ".." && !Components.empty() &&
+        Components.back() != "..") {
+      Components.pop_back();
+      continue;
+    }
+    Components.push_back(Component);
+  }
+
+  Result.assign(Root.begin(), Root.end());
+  for (unsigned I = 0, N = Components.size(); I != N; ++I)
+    llvm::sys::path::append(Result, Components[I]);
+  if (Result.empty())
+    Result.push_back('.');
+}
+
+static dev_t getNextInMemoryDevice() {
+  // Count down from the largest device number, which real file systems are
+  // unlikely to use.
+  static volatile llvm::sys::cas_flag NumDevices = 0;
+  return dev_t(-1) - llvm::sys::AtomicIncrement(&NumDevices);
+}
+
+InMemoryFileSystem::InMemoryFileSystem()
+  : Device(getNextInMemoryDevice()), NextInode(1) {
+  addEntry(".", S_IFDIR | 0555, 0);
+}
+
+InMemoryFileSystem::~InMemoryFileSystem() {
+  for (llvm::StringMap<Entry>::iterator I = Entries.begin(),
+                                        E = Entries.end();
+       I != E; ++I)
+    delete I->getValue().Buffer;
+}
+
+InMemoryFileSystem::Entry &
+InMemoryFileSystem::addEntry(StringRef Path, mode_t Mode,
+                             time_t ModificationTime) {
+  Entry &Result = Entries.GetOrCreateValue(Path).getValue();
+  if (Result.StatBuf.st_mode == 0) {
+    memset(&Result.StatBuf, 0, sizeof(Result.StatBuf));
+    Result.StatBuf.st_dev = Device;
+#ifndef _WIN32  // struct stat has no st_ino field on Windows.
+    Result.StatBuf.st_ino = NextInode++;
+#endif
+    Result.Buffer = 0;
+  }
+  Result.StatBuf.st_mode = Mode;
+  Result.StatBuf.st_mtime = ModificationTime;
+  return Result;
+}
+
+void InMemoryFileSystem::addFile(StringRef Path, llvm::MemoryBuffer *Buffer,
+                                 time_t ModificationTime) {
+  SmallString<128> Normalized;
+  normalizePath(Path, Normalized);
+
+  // Add the ancestors of the file as directories.
+  StringRef Dir = llvm::sys::path::parent_path(Normalized);
+  while (!Dir.empty()) {
+    addEntry(Dir, S_IFDIR | 0555, 0);
+    Dir = llvm::sys::path::parent_path(Dir);
+  }
+
+  Entry &File = addEntry(Normalized, S_IFREG | 0444, ModificationTime);
+  delete File.Buffer;
+  File.Buffer = Buffer;
+  File.StatBuf.st_size = Buffer->getBufferSize();
+}
+
+const InMemoryFileSystem::Entry *
+InMemoryFileSystem::lookup(const char *Path) const {
+  SmallString<128> Normalized;
+  normalizePath(Path, Normalized);
+  llvm::StringMap<Entry>::const_iterator I = Entries.find(Normalized);
+  return I == Entries.end() ? 0 : &I->getValue();
+}
+
+bool InMemoryFileSystem::getStat(const char *Path, struct stat &StatBuf,
+                                 int * /*FileDescriptor*/) {
+  const Entry *E = lookup(Path);
+  if (!E)
+    return true;
+  StatBuf = E->StatBuf;
+  return false;
+}
+
+llvm::error_code
+InMemoryFileSystem::getBufferForFile(const char *Path,
+                                     OwningPtr<llvm::MemoryBuffer> &Result,
+                                     int64_t /*FileSize*/,
+                                     bool RequiresNullTerminator) {
+  const Entry *E = lookup(Path);
+  if (!E)
+    return llvm::make_error_code(llvm::errc::no_such_file_or_directory);
+  if (!E->Buffer)
+    return llvm::make_error_code(llvm::errc::is_a_directory);
+
+  Result.reset(llvm::MemoryBuffer::getMemBuffer(E->Buffer->getBuffer(), Path,
+                                                RequiresNullTerminator));
+  return llvm::error_code::success();
+}
+
+//===----------------------------------------------------------------------===//
+// OverlayFileSystem
+//===----------------------------------------------------------------------===//
+
+OverlayFileSystem::OverlayFileSystem(VirtualFileSystem *Base) {
+  pushOverlay(Base);
+}
+
+void OverlayFileSystem::pushOverlay(VirtualFileSystem *FS) {
+  assert(FS && "No file system provided?");
+  FileSystems.push_back(FS);
+}
+
+bool OverlayFileSystem::getStat(const char *Path, struct stat &StatBuf,
+                                int *FileDescriptor) {
+  for (unsigned I = FileSystems.size(); I != 0; --I)
+    if (!FileSystems[I - 1]->getStat(Path, StatBuf, FileDescriptor))
+      return false;
+  return true;
+}
+
+llvm::error_code
+OverlayFileSystem::getBufferForFile(const char *Path,
+                                    OwningPtr<llvm::MemoryBuffer> &Result,
+                                    int64_t FileSize,
+                                    bool RequiresNullTerminator) {
+  // Read the file from the file system that getStat() finds it in, so that
+  // the contents match the size and time the client saw.
+  struct stat StatBuf;
+  for (unsigned I = FileSystems.size(); I != 0; --I)
+    if (!FileSystems[I - 1]->getStat(Path, StatBuf, 0))
+      return FileSystems[I - 1]->getBufferForFile(Path, Result, FileSize,
+                                                  RequiresNullTerminator);
+  return llvm::make_error_code(llvm::errc::no_such_file_or_directory);
+}
@@ -44,12 +44,14 @@ clang_codegen_SRC_FILES := \
   CodeGenAction.cpp \
   CodeGenFunction.cpp \
   CodeGenModule.cpp \
+  CodeGenPGO.cpp \
   CodeGenTBAA.cpp \
   CodeGenTypes.cpp \
   ItaniumCXXABI.cpp \
   MicrosoftCXXABI.cpp \
   ModuleBuilder.cpp \
-  TargetInfo.cpp
+  TargetInfo.cpp \
+  VarBypassDetector.cpp
 
 # For the host only
 # =====================================================
@@ -7,23 +7,36 @@
 //
 //===----------------------------------------------------------------------===//
 
+#define DEBUG_TYPE "bounds-checking"
 #include "clang/CodeGen/BackendUtil.h"
+#include "clang/Basic/CompilationProfile.h"
 #include "clang/Basic/Diagnostic.h"
+#include "clang/Basic/FileManager.h"
+#include "clang/Basic/SourceManager.h"
 #include "clang/Basic/TargetOptions.h"
 #include "clang/Basic/LangOptions.h"
 #include "clang/Frontend/CodeGenOptions.h"
 #include "clang/Frontend/FrontendDiagnostic.h"
+#include "llvm/DebugInfo.h"
+#include "llvm/IntrinsicInst.h"
 #include "llvm/Module.h"
 #include "llvm/PassManager.h"
+#include "llvm/ADT/DenseMap.h"
+#include "llvm/ADT/SmallPtrSet.h"
+#include "llvm/ADT/Statistic.h"
 #include "llvm/Analysis/Verifier.h"
 #include "llvm/Assembly/PrintModulePass.h"
 #include "llvm/Bitcode/ReaderWriter.h"
 #include "llvm/CodeGen/RegAllocRegistry.h"
 #include "llvm/CodeGen/SchedulerRegistry.h"
 #include "llvm/MC/SubtargetFeature.h"
+#include "llvm/Support/CallSite.h"
 #include "llvm/Support/CommandLine.h"
 #include "llvm/Support/FormattedStream.h"
+#include "llvm/Support/InstIterator.h"
+#include "llvm/Support/Path.h"
 #include "llvm/Support/PrettyStackTrace.h"
+#include "llvm/Support/Regex.h"
 #include "llvm/Support/TargetRegistry.h"
 #include "llvm/Support/Timer.h"
 #include "llvm/Support/raw_ostream.h"
@@ -35,9 +48,14 @@
 #include "llvm/Transforms/IPO.h"
 #include "llvm/Transforms/IPO/PassManagerBuilder.h"
 #include "llvm/Transforms/Scalar.h"
+#include "llvm/Transforms/Utils/Local.h"
 using namespace clang;
 using namespace llvm;
 
+STATISTIC(NumChecksElided,
+          "The # of bounds checks elided because the frontend proved the "
+          "access in bounds");
+
 namespace {
 
 class EmitAssemblyHelper {
@@ -46,6 +64,8 @@ class EmitAssemblyHelper {
   const clang::TargetOptions &TargetOpts;
   const LangOptions &LangOpts;
   Module *TheModule;
+  CompilationProfile *Profile;
+  SourceManager *SM;
 
   Timer CodeGenerationTime;
 
@@ -90,9 +110,11 @@ public:
                      const CodeGenOptions &CGOpts,
                      const clang::TargetOptions &TOpts,
                      const LangOptions &LOpts,
-                     Module *M)
+                     Module *M, CompilationProfile *Profile,
+                     SourceManager *SM)
     : Diags(_Diags), CodeGenOpts(CGOpts), TargetOpts(TOpts), LangOpts(LOpts),
-      TheModule(M), CodeGenerationTime("Code Generation Time"),
+      TheModule(M), Profile(Profile), SM(SM),
+      CodeGenerationTime("Code Generation Time"),
       CodeGenPasses(0), PerModulePasses(0), PerFunctionPasses(0) {}
 
   ~EmitAssemblyHelper() {
@@ -106,6 +128,149 @@ public:
 
 }
 
+namespace {
+
+/// InliningRemarks - Report the calls which were inlined, and those which
+/// were not, as the optimization remarks of the pass "inline".
+///
+/// The inliner keeps no record of its decisions, so they are recovered from
+/// the optimized module: the debug info of inlined code carries the location
+/// of the call it replaced, and the calls left to the functions defined in
+/// the module were not inlined.
+class InliningRemarks : public ModulePass {
+  DiagnosticsEngine &Diags;
+  SourceManager *SM;
+
+  /// Whether the cost-based inliner ran, so that a call it left can be
+  /// reported as too costly.
+  bool InlinerRan;
+
+  /// The source names of the functions, from their debug info.
+  DenseMap<const Function *, StringRef> FunctionNames;
+
+  SourceLocation getLocation(DebugLoc DL, LLVMContext &Ctx) const;
+  StringRef getFunctionName(const Function *F) const;
+  void reportInlinedCalls(Module &M);
+  void reportCallsLeft(Module &M);
+
+public:
+  static char ID;
+
+  InliningRemarks(DiagnosticsEngine &Diags, SourceManager *SM,
+                  bool InlinerRan)
+    : ModulePass(ID), Diags(Diags), SM(SM), InlinerRan(InlinerRan) {}
+
+  virtual const char *getPassName() const { return "Inlining remarks"; }
+
+  virtual void getAnalysisUsage(AnalysisUsage &AU) const {
+    AU.setPreservesAll();
+  }
+
+  virtual bool runOnModule(Module &M);
+};
+
+}
+
+char InliningRemarks::ID = 0;
+
+/// getLocation - Find the source location of a debug location, if the file it
+/// names is one of the translation unit.
+SourceLocation InliningRemarks::getLocation(DebugLoc DL,
+                                            LLVMContext &Ctx) const {
+  if (!SM || DL.isUnknown())
+    return SourceLocation();
+
+  DIScope Scope(DL.getScope(Ctx));
+  SmallString<128> Path(Scope.getFilename());
+  if (!llvm::sys::path::is_absolute(Path.str())) {
+    SmallString<128> Dir(Scope.getDirectory());
+    llvm::sys::path::append(Dir, Path.str());
+    Path = Dir;
+  }
+
+  const FileEntry *File = SM->getFileManager().getFile(Path.str());
+  if (!File)
+    return SourceLocation();
+  return SM->translateFileLineCol(File, DL.getLine(),
+                                  DL.getCol() ? DL.getCol() : 1);
+}
+
+StringRef InliningRemarks::getFunctionName(const Function *F) const {
+  StringRef Name = FunctionNames.lookup(F);
+  return Name.empty() ? F->getName() : Name;
+}
+
+void InliningRemarks::reportInlinedCalls(Module &M) {
+  LLVMContext &Ctx = M.getContext();
+  SmallPtrSet<MDNode *, 32> CallsSeen;
+  for (Module::iterator F = M.begin(), FE = M.end(); F != FE; ++F) {
+    for (inst_iterator I = inst_begin(F), IE = inst_end(F); I != IE; ++I) {
+      // Code inlined into inlined code has a chain of the calls it replaced.
+      DebugLoc DL = I->getDebugLoc();
+      while (MDNode *InlinedAt = DL.getInlinedAt(Ctx)) {
+        DebugLoc CallLoc = DebugLoc::getFromDILocation(InlinedAt);
+        if (CallsSeen.insert(InlinedAt))
+          Diags.Report(getLocation(CallLoc, Ctx),
+                       diag::remark_fe_backend_inlined)
+            << getDISubprogram(DL.getScope(Ctx)).getName()
+            << getDISubprogram(CallLoc.getScope(Ctx)).getName();
+        DL = CallLoc;
+      }
+    }
+  }
+}
+
+void InliningRemarks::reportCallsLeft(Module &M) {
+  LLVMContext &Ctx = M.getContext();
+  for (Module::iterator F = M.begin(), FE = M.end(); F != FE; ++F) {
+    for (inst_iterator I = inst_begin(F), IE = inst_end(F); I != IE; ++I) {
+      CallSite CS(&*I);
+      if (!CS)
+        continue;
+      const Function *Callee = CS.getCalledFunction();
+      if (!Callee || Callee->isDeclaration())
+        continue;
+
+      enum { NoInline, Overridable, Recursive, TooCostly } Reason;
+      if (Callee->hasFnAttr(Attribute::NoInline))
+        Reason = NoInline;
+      else if (Callee->mayBeOverridden())
+        Reason = Overridable;
+      else if (Callee == F)
+        Reason = Recursive;
+      else if (InlinerRan)
+        Reason = TooCostly;
+      else
+        continue;
+
+      // The call may itself come from inlined code.
+      DebugLoc DL = I->getDebugLoc();
+      StringRef Caller = DL.isUnknown() ? getFunctionName(F) :
+        getDISubprogram(DL.getScope(Ctx)).getName();
+      Diags.Report(getLocation(DL, Ctx), diag::remark_fe_backend_not_inlined)
+        << getFunctionName(Callee) << Caller << Reason;
+    }
+  }
+}
+
+bool InliningRemarks::runOnModule(Module &M) {
+  if (!M.getNamedMetadata("llvm.dbg.cu"))
+    Diags.Report(diag::remark_fe_backend_inlining_needs_debug_info);
+
+  DebugInfoFinder Finder;
+  Finder.processModule(M);
+  for (DebugInfoFinder::iterator I = Finder.subprogram_begin(),
+                                 E = Finder.subprogram_end(); I != E; ++I) {
+    DISubprogram SP(*I);
+    if (const Function *F = SP.getFunction())
+      FunctionNames[F] = SP.getName();
+  }
+
+  reportInlinedCalls(M);
+  reportCallsLeft(M);
+  return false;
+}
+
 static void addObjCARCAPElimPass(const PassManagerBuilder &Builder, PassManagerBase &PM) {
   if (Builder.OptLevel > 0)
     PM.add(createObjCARCAPElimPass());
@@ -121,10 +286,78 @@ static void addObjCARCOptPass(const PassManagerBuilder &Builder, PassManagerBase
     PM.add(createObjCARCOptPass());
 }
 
+namespace {
+
+/// ElideProvenBoundsChecks - Remove the run-time bounds checks of the memory
+/// accesses whose address CodeGen marked with !clang.bounds.safe, because it
+/// proved them in bounds from the source: constant indexes, and indexes
+/// bounded by the loops around them, into arrays of known size.
+///
+/// The bounds checking pass splits the block before each access it checks,
+/// and branches from the old block to a trap block when the check fails or
+/// to the access otherwise. The branches for marked accesses are made to go
+/// to the access unconditionally.
+class ElideProvenBoundsChecks : public FunctionPass {
+public:
+  static char ID;
+
+  ElideProvenBoundsChecks() : FunctionPass(ID) {}
+
+  virtual const char *getPassName() const {
+    return "Elide proven bounds checks";
+  }
+
+  virtual bool runOnFunction(Function &F);
+};
+
+}
+
+char ElideProvenBoundsChecks::ID = 0;
+
+static bool isTrapBlock(BasicBlock *BB) {
+  const IntrinsicInst *II = dyn_cast<IntrinsicInst>(BB->begin());
+  return II && II->getIntrinsicID() == Intrinsic::trap;
+}
+
+static bool isProvenAccess(Instruction *I, unsigned SafeKind) {
+  Value *Ptr;
+  if (LoadInst *LI = dyn_cast<LoadInst>(I))
+    Ptr = LI->getPointerOperand();
+  else if (StoreInst *SI = dyn_cast<StoreInst>(I))
+    Ptr = SI->getPointerOperand();
+  else
+    return false;
+  Instruction *Addr = dyn_cast<Instruction>(Ptr->stripPointerCasts());
+  return Addr && Addr->getMetadata(SafeKind);
+}
+
+bool ElideProvenBoundsChecks::runOnFunction(Function &F) {
+  unsigned SafeKind = F.getContext().getMDKindID("clang.bounds.safe");
+  bool Changed = false;
+  for (Function::iterator BB = F.begin(), E = F.end(); BB != E; ++BB) {
+    BranchInst *BI = dyn_cast<BranchInst>(BB->getTerminator());
+    if (!BI || !BI->isConditional() || !isTrapBlock(BI->getSuccessor(0)))
+      continue;
+    BasicBlock *Cont = BI->getSuccessor(1);
+    if (!isProvenAccess(Cont->begin(), SafeKind))
+      continue;
+
+    // The trap blocks left without predecessors are removed by later passes.
+    Value *Cond = BI->getCondition();
+    BranchInst::Create(Cont, BI);
+    BI->eraseFromParent();
+    RecursivelyDeleteTriviallyDeadInstructions(Cond);
+    ++NumChecksElided;
+    Changed = true;
+  }
+  return Changed;
+}
+
 static unsigned BoundsChecking;
 static void addBoundsCheckingPass(const PassManagerBuilder &Builder,
                                     PassManagerBase &PM) {
   PM.add(createBoundsCheckingPass(BoundsChecking));
+  PM.add(new ElideProvenBoundsChecks());
 }
 
 static void addAddressSanitizerPass(const PassManagerBuilder &Builder,
@@ -239,6 +472,14 @@ void EmitAssemblyHelper::CreatePasses() {
   
   
   PMBuilder.populateModulePassManager(*MPM);
+
+  // Report the decisions of the optimizers once they have all run.
+  if (!CodeGenOpts.OptimizationRemarkPattern.empty()) {
+    llvm::Regex Pattern(CodeGenOpts.OptimizationRemarkPattern);
+    if (Pattern.match("inline"))
+      MPM->add(new InliningRemarks(Diags, SM,
+                                   Inlining == CodeGenOptions::NormalInlining));
+  }
 }
 
 bool EmitAssemblyHelper::AddEmitPasses(BackendAction Action,
@@ -427,10 +668,28 @@ bool EmitAssemblyHelper::AddEmitPasses(BackendAction Action,
   return true;
 }
 
+static CompilationProfile::IRSize getIRSize(const Module &M) {
+  CompilationProfile::IRSize Size = { 0, 0, 0 };
+  for (Module::const_iterator F = M.begin(), FE = M.end(); F != FE; ++F) {
+    if (F->isDeclaration())
+      continue;
+    ++Size.Functions;
+    for (Function::const_iterator B = F->begin(), BE = F->end(); B != BE; ++B) {
+      ++Size.BasicBlocks;
+      Size.Instructions += B->size();
+    }
+  }
+  return Size;
+}
+
 void EmitAssemblyHelper::EmitAssembly(BackendAction Action, raw_ostream *OS) {
   TimeRegion Region(llvm::TimePassesIsEnabled ? &CodeGenerationTime : 0);
   llvm::formatted_raw_ostream FormattedOS;
 
+  CompilationProfile::IRSize SizeBefore = { 0, 0, 0 };
+  if (Profile)
+    SizeBefore = getIRSize(*TheModule);
+
   CreatePasses();
   switch (Action) {
   case Backend_EmitNothing:
@@ -459,6 +718,8 @@ void EmitAssemblyHelper::EmitAssembly(BackendAction Action, raw_ostream *OS) {
 
   if (PerFunctionPasses) {
     PrettyStackTraceString CrashInfo("Per-function optimization");
+    CompilationProfileRegion Region(Profile,
+                                    CompilationProfile::FunctionPasses);
 
     PerFunctionPasses->doInitialization();
     for (Module::iterator I = TheModule->begin(),
@@ -470,11 +731,25 @@ void EmitAssemblyHelper::EmitAssembly(BackendAction Action, raw_ostream *OS) {
 
   if (PerModulePasses) {
     PrettyStackTraceString CrashInfo("Per-module optimization passes");
+    CompilationProfileRegion Region(Profile, CompilationProfile::ModulePasses);
     PerModulePasses->run(*TheModule);
   }
 
+  // The IR is final once the optimizers have run; code generation lowers it
+  // without changing it.
+  if (Profile)
+    Profile->setIRSize(SizeBefore, getIRSize(*TheModule));
+
+  // FIXME: Code generation runs over the whole module on one thread. The
+  // module cannot be split by function and generated in parallel here:
+  // every piece would need an LLVMContext of its own, as contexts are not
+  // thread-safe, and this LLVM has no way to split a module or to combine
+  // the object files or assembly from several functions' TargetMachines
+  // into one output, whose local labels and constant pools would clash.
   if (CodeGenPasses) {
     PrettyStackTraceString CrashInfo("Code generation");
+    CompilationProfileRegion Region(Profile,
+                                    CompilationProfile::CodeGeneration);
     CodeGenPasses->run(*TheModule);
   }
 }
@@ -484,8 +759,10 @@ void clang::EmitBackendOutput(DiagnosticsEngine &Diags,
                               const clang::TargetOptions &TOpts,
                               const LangOptions &LOpts,
                               Module *M,
-                              BackendAction Action, raw_ostream *OS) {
-  EmitAssemblyHelper AsmHelper(Diags, CGOpts, TOpts, LOpts, M);
+                              BackendAction Action, raw_ostream *OS,
+                              CompilationProfile *Profile,
+                              SourceManager *SM) {
+  EmitAssemblyHelper AsmHelper(Diags, CGOpts, TOpts, LOpts, M, Profile, SM);
 
   AsmHelper.EmitAssembly(Action, OS);
 }
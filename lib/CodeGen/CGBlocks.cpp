@@ -11,6 +11,7 @@
 //
 //===----------------------------------------------------------------------===//
 
+#define DEBUG_TYPE "blocks"
 #include "CGDebugInfo.h"
 #include "CodeGenFunction.h"
 #include "CGObjCRuntime.h"
@@ -19,6 +20,7 @@
 #include "clang/AST/DeclObjC.h"
 #include "llvm/Module.h"
 #include "llvm/ADT/SmallSet.h"
+#include "llvm/ADT/Statistic.h"
 #include "llvm/Target/TargetData.h"
 #include <algorithm>
 
@@ -39,6 +41,12 @@ CGBlockInfo::CGBlockInfo(const BlockDecl *block, StringRef name)
 // Anchor the vtable to this translation unit.
 CodeGenModule::ByrefHelpers::~ByrefHelpers() {}
 
+STATISTIC(NumBlockHelpersEmitted,
+          "The # of pairs of block copy and dispose helpers emitted");
+STATISTIC(NumBlockHelpersShared,
+          "The # of blocks which share the copy and dispose helpers of "
+          "another block");
+
 /// Build the given block as a global block.
 static llvm::Constant *buildGlobalBlock(CodeGenModule &CGM,
                                         const CGBlockInfo &blockInfo,
@@ -56,6 +64,55 @@ static llvm::Constant *buildDisposeHelper(CodeGenModule &CGM,
   return CodeGenFunction(CGM).GenerateDestroyHelperFunction(blockInfo);
 }
 
+/// getBlockHelpersKey - Describe what the copy and dispose helpers of a
+/// block do: the offset and kind of each capture which they copy and
+/// dispose of.  The helpers only depend on that, so blocks with the same
+/// description can share them.
+///
+/// \returns false if the block has C++ captures, whose helpers run the
+/// constructors and destructors of the captured types.
+static bool getBlockHelpersKey(CodeGenModule &CGM, const CGBlockInfo &blockInfo,
+                               SmallVectorImpl<char> &key) {
+  if (blockInfo.HasCXXObject)
+    return false;
+
+  const llvm::StructLayout *layout =
+    CGM.getTargetData().getStructLayout(blockInfo.StructureType);
+  llvm::raw_svector_ostream out(key);
+
+  const BlockDecl *blockDecl = blockInfo.getBlockDecl();
+  for (BlockDecl::capture_const_iterator ci = blockDecl->capture_begin(),
+         ce = blockDecl->capture_end(); ci != ce; ++ci) {
+    const VarDecl *variable = ci->getVariable();
+    QualType type = variable->getType();
+
+    const CGBlockInfo::Capture &capture = blockInfo.getCapture(variable);
+    if (capture.isConstant()) continue;
+
+    // These are the captures, and the flags, that the helpers handle.
+    char kind;
+    if (ci->isByRef()) {
+      kind = type.isObjCGCWeak() ? 'w' : 'r';
+    } else if (type->isObjCRetainableType()) {
+      kind = type->isBlockPointerType() ? 'b' : 'o';
+      if (CGM.getLangOpts().ObjCAutoRefCount) {
+        Qualifiers qs = type.getQualifiers();
+        if (!qs.hasStrongOrWeakObjCLifetime())
+          continue;
+        if (qs.getObjCLifetime() == Qualifiers::OCL_Weak)
+          kind = 'W';
+      }
+    } else {
+      continue;
+    }
+
+    out << layout->getElementOffset(capture.getIndex()) << kind;
+  }
+
+  out.flush();
+  return true;
+}
+
 /// Build the block descriptor constant for a block.
 static llvm::Constant *buildBlockDescriptor(CodeGenModule &CGM,
                                             const CGBlockInfo &blockInfo) {
@@ -78,11 +135,27 @@ static llvm::Constant *buildBlockDescriptor(CodeGenModule &CGM,
 
   // Optional copy/dispose helpers.
   if (blockInfo.NeedsCopyDispose) {
+    SmallString<32> key;
+    bool shareable = getBlockHelpersKey(CGM, blockInfo, key);
+    std::pair<llvm::Constant *, llvm::Constant *> helpers(0, 0);
+    if (shareable)
+      helpers = CGM.BlockHelpersCache.lookup(key);
+
+    if (helpers.first) {
+      ++NumBlockHelpersShared;
+    } else {
+      ++NumBlockHelpersEmitted;
+      helpers.first = buildCopyHelper(CGM, blockInfo);
+      helpers.second = buildDisposeHelper(CGM, blockInfo);
+      if (shareable)
+        CGM.BlockHelpersCache[key] = helpers;
+    }
+
     // copy_func_helper_decl
-    elements.push_back(buildCopyHelper(CGM, blockInfo));
+    elements.push_back(helpers.first);
 
     // destroy_func_decl
-    elements.push_back(buildDisposeHelper(CGM, blockInfo));
+    elements.push_back(helpers.second);
   }
 
   // Signature.  Mandatory ObjC-style method descriptor @encode sequence.
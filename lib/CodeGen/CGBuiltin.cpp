@@ -356,6 +356,15 @@ RValue CodeGenFunction::EmitBuiltinExpr(const FunctionDecl *FD,
                                         "expval");
     return RValue::get(Result);
   }
+  case Builtin::BI__builtin_assume_aligned: {
+    // FIXME: LLVM has no way to state the assumption, so the builtin just
+    // returns its argument. The offset is still evaluated for its side
+    // effects.
+    Value *PtrValue = EmitScalarExpr(E->getArg(0));
+    if (E->getNumArgs() > 2)
+      EmitScalarExpr(E->getArg(2));
+    return RValue::get(PtrValue);
+  }
   case Builtin::BI__builtin_bswap32:
   case Builtin::BI__builtin_bswap64: {
     Value *ArgValue = EmitScalarExpr(E->getArg(0));
@@ -17,12 +17,25 @@
 //
 //===----------------------------------------------------------------------===//
 
+#define DEBUG_TYPE "cleanups"
 #include "CodeGenFunction.h"
 #include "CGCleanup.h"
+#include "llvm/ADT/Statistic.h"
 
 using namespace clang;
 using namespace CodeGen;
 
+STATISTIC(NumCleanupsElided, "The # of cleanups popped without any code");
+STATISTIC(NumNormalCleanupsInline,
+          "The # of normal cleanups emitted inline on the fallthrough");
+STATISTIC(NumNormalCleanupsThreaded,
+          "The # of normal cleanups emitted as blocks that branches thread "
+          "through");
+STATISTIC(NumEHCleanupsEmitted, "The # of EH cleanups emitted");
+STATISTIC(NumEHCleanupsForwarded,
+          "The # of EH cleanups with nothing to do whose branches were "
+          "forwarded to the enclosing EH scope");
+
 bool DominatingValue<RValue>::saved_type::needsSaving(RValue rv) {
   if (rv.isScalar())
     return DominatingLLVMValue::needsSaving(rv.getScalarVal());
@@ -610,6 +623,7 @@ void CodeGenFunction::PopCleanupBlock(bool FallthroughIsBranchThrough) {
 
   // If we don't need the cleanup at all, we're done.
   if (!RequiresNormalCleanup && !RequiresEHCleanup) {
+    ++NumCleanupsElided;
     destroyOptimisticNormalEntry(*this, Scope);
     EHStack.popCleanup(); // safe because there are no fixups
     assert(EHStack.getNumBranchFixups() == 0 ||
@@ -646,6 +660,7 @@ void CodeGenFunction::PopCleanupBlock(bool FallthroughIsBranchThrough) {
       destroyOptimisticNormalEntry(*this, Scope);
       EHStack.popCleanup();
 
+      ++NumNormalCleanupsInline;
       EmitCleanup(*this, Fn, cleanupFlags, NormalActiveFlag);
 
     // Otherwise, the best approach is to thread everything through
@@ -758,6 +773,7 @@ void CodeGenFunction::PopCleanupBlock(bool FallthroughIsBranchThrough) {
       EHStack.popCleanup();
       assert(EHStack.hasNormalCleanups() == HasEnclosingCleanups);
 
+      ++NumNormalCleanupsThreaded;
       EmitCleanup(*this, Fn, cleanupFlags, NormalActiveFlag);
 
       // Append the prepared cleanup prologue from above.
@@ -825,18 +841,24 @@ void CodeGenFunction::PopCleanupBlock(bool FallthroughIsBranchThrough) {
 
   assert(EHStack.hasNormalCleanups() || EHStack.getNumBranchFixups() == 0);
 
-  // Emit the EH cleanup if required.
-  if (RequiresEHCleanup) {
+  // Emit the EH cleanup if required.  We only actually emit the cleanup
+  // code if the cleanup is either active or was used before it was
+  // deactivated.  Otherwise there is nothing to run on the way out, so the
+  // branches to the cleanup go straight to the enclosing EH scope rather
+  // than through a block of its own; in a chain of such cleanups, they all
+  // collapse into the first one that does something.
+  if (RequiresEHCleanup && !EHActiveFlag && !IsActive) {
+    ++NumEHCleanupsForwarded;
+    EHEntry->replaceAllUsesWith(getEHDispatchBlock(EHParent));
+    delete EHEntry;
+  } else if (RequiresEHCleanup) {
     CGBuilderTy::InsertPoint SavedIP = Builder.saveAndClearIP();
 
     EmitBlock(EHEntry);
 
-    // We only actually emit the cleanup code if the cleanup is either
-    // active or was used before it was deactivated.
-    if (EHActiveFlag || IsActive) {
-      cleanupFlags.setIsForEHCleanup();
-      EmitCleanup(*this, Fn, cleanupFlags, EHActiveFlag);
-    }
+    ++NumEHCleanupsEmitted;
+    cleanupFlags.setIsForEHCleanup();
+    EmitCleanup(*this, Fn, cleanupFlags, EHActiveFlag);
 
     Builder.CreateBr(getEHDispatchBlock(EHParent));
 
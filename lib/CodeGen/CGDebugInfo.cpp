@@ -11,6 +11,7 @@
 //
 //===----------------------------------------------------------------------===//
 
+#define DEBUG_TYPE "debug-info"
 #include "CGDebugInfo.h"
 #include "CodeGenFunction.h"
 #include "CodeGenModule.h"
@@ -32,12 +33,18 @@
 #include "llvm/Module.h"
 #include "llvm/ADT/StringExtras.h"
 #include "llvm/ADT/SmallVector.h"
+#include "llvm/ADT/Statistic.h"
 #include "llvm/Support/Dwarf.h"
 #include "llvm/Support/FileSystem.h"
 #include "llvm/Target/TargetData.h"
 using namespace clang;
 using namespace clang::CodeGen;
 
+STATISTIC(NumRecordTypesEmitted, "The # of record type definitions emitted");
+STATISTIC(NumRecordTypesElided,
+          "The # of record types emitted as declarations because their "
+          "vtable is emitted elsewhere");
+
 CGDebugInfo::CGDebugInfo(CodeGenModule &CGM)
   : CGM(CGM), DBuilder(CGM.getModule()),
     BlockLiteralGenericSet(false) {
@@ -1213,10 +1220,42 @@ llvm::DIType CGDebugInfo::getOrCreateInterfaceType(QualType D,
   return T;
 }
 
+/// isTypeHomedElsewhere - Return true if the definition of the given record
+/// is left to the translation unit which emits its vtable, that is, the one
+/// which defines its key function.
+bool CGDebugInfo::isTypeHomedElsewhere(const RecordDecl *RD) {
+  if (!CGM.getCodeGenOpts().DebugVTableHoming)
+    return false;
+
+  const CXXRecordDecl *CXXDecl = dyn_cast<CXXRecordDecl>(RD);
+  if (!CXXDecl || !CXXDecl->hasDefinition() || !CXXDecl->isDynamicClass())
+    return false;
+
+  // Classes without a key function have their vtable emitted wherever it is
+  // used, and implicit instantiations never have one.
+  const CXXMethodDecl *KeyFunction = CGM.getContext().getKeyFunction(CXXDecl);
+  return KeyFunction && !KeyFunction->hasBody();
+}
+
+/// EmitVTableClassType - Emit the definition of a class whose vtable is being
+/// emitted, for the translation units which only declare it.
+void CGDebugInfo::EmitVTableClassType(const CXXRecordDecl *RD) {
+  if (!CGM.getCodeGenOpts().DebugVTableHoming)
+    return;
+  QualType Ty = CGM.getContext().getRecordType(RD);
+  DBuilder.retainType(getOrCreateType(Ty, getOrCreateFile(RD->getLocation())));
+}
+
 /// CreateType - get structure or union type.
 llvm::DIType CGDebugInfo::CreateType(const RecordType *Ty) {
   RecordDecl *RD = Ty->getDecl();
 
+  if (isTypeHomedElsewhere(RD)) {
+    ++NumRecordTypesElided;
+    return createRecordFwdDecl(RD,
+               getContextDescriptor(cast<Decl>(RD->getDeclContext())));
+  }
+
   // Get overall information about the record type for the debug info.
   llvm::DIFile DefUnit = getOrCreateFile(RD->getLocation());
 
@@ -1232,6 +1271,7 @@ llvm::DIType CGDebugInfo::CreateType(const RecordType *Ty) {
   if (FwdDecl.isForwardDecl())
     return FwdDecl;
 
+  ++NumRecordTypesEmitted;
   llvm::TrackingVH<llvm::MDNode> FwdDeclNode(FwdDecl);
 
   // Push the struct on region stack.
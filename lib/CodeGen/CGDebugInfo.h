@@ -236,6 +236,10 @@ public:
   llvm::DIType getOrCreateInterfaceType(QualType Ty,
 					SourceLocation Loc);
 
+  /// EmitVTableClassType - Emit the definition of a class whose vtable is
+  /// being emitted, when its debug info is homed with its vtable.
+  void EmitVTableClassType(const CXXRecordDecl *RD);
+
 private:
   /// EmitDeclare - Emit call to llvm.dbg.declare for a variable declaration.
   void EmitDeclare(const VarDecl *decl, unsigned Tag, llvm::Value *AI,
@@ -249,6 +253,10 @@ private:
   /// getContextDescriptor - Get context info for the decl.
   llvm::DIDescriptor getContextDescriptor(const Decl *Decl);
 
+  /// isTypeHomedElsewhere - Return true if only a declaration of the record
+  /// is emitted, because its definition goes with its vtable.
+  bool isTypeHomedElsewhere(const RecordDecl *RD);
+
   /// createRecordFwdDecl - Create a forward decl for a RecordType in a given
   /// context.
   llvm::DIType createRecordFwdDecl(const RecordDecl *, llvm::DIDescriptor);
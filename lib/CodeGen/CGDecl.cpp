@@ -402,6 +402,17 @@ namespace {
     }
   };
 
+  struct CallLifetimeEnd : EHScopeStack::Cleanup {
+    llvm::Value *Addr;
+    llvm::Value *Size;
+    CallLifetimeEnd(llvm::Value *addr, llvm::Value *size)
+      : Addr(addr), Size(size) {}
+
+    void Emit(CodeGenFunction &CGF, Flags flags) {
+      CGF.EmitLifetimeEnd(Size, Addr);
+    }
+  };
+
   struct ExtendGCLifetime : EHScopeStack::Cleanup {
     const VarDecl &Var;
     ExtendGCLifetime(const VarDecl *var) : Var(*var) {}
@@ -774,6 +785,33 @@ void CodeGenFunction::EmitAutoVarDecl(const VarDecl &D) {
   EmitAutoVarCleanups(emission);
 }
 
+/// EmitLifetimeStart - Emit an llvm.lifetime.start for a local variable.
+llvm::Value *CodeGenFunction::EmitLifetimeStart(uint64_t Size,
+                                                llvm::Value *Addr) {
+  // The markers only help the optimizer; leave them out at -O0, and for
+  // objects too small for sharing their stack slots to pay for the IR.
+  const CodeGenOptions &CGOpts = CGM.getCodeGenOpts();
+  if (CGOpts.OptimizationLevel == 0 || CGOpts.DisableLifetimeMarkers ||
+      Size < CGOpts.LifetimeMarkersMinSize)
+    return 0;
+
+  llvm::Value *SizeV = llvm::ConstantInt::get(Int64Ty, Size);
+  Addr = Builder.CreateBitCast(Addr, Int8PtrTy);
+  llvm::CallInst *C =
+    Builder.CreateCall2(CGM.getIntrinsic(llvm::Intrinsic::lifetime_start),
+                        SizeV, Addr);
+  C->setDoesNotThrow();
+  return SizeV;
+}
+
+void CodeGenFunction::EmitLifetimeEnd(llvm::Value *Size, llvm::Value *Addr) {
+  Addr = Builder.CreateBitCast(Addr, Int8PtrTy);
+  llvm::CallInst *C =
+    Builder.CreateCall2(CGM.getIntrinsic(llvm::Intrinsic::lifetime_end),
+                        Size, Addr);
+  C->setDoesNotThrow();
+}
+
 /// EmitAutoVarAlloca - Emit the alloca and debug information for a
 /// local variable.  Does not emit initalization or destruction.
 CodeGenFunction::AutoVarEmission
@@ -866,6 +904,15 @@ CodeGenFunction::EmitAutoVarAlloca(const VarDecl &D) {
               getContext().toCharUnitsFromBits(Target.getPointerAlign(0)));
         Alloc->setAlignment(allocaAlignment.getQuantity());
         DeclPtr = Alloc;
+
+        // Tell the optimizer where the lifetime of the variable starts, so
+        // that variables of disjoint scopes can share stack slots. Jumps
+        // into the scope past the declaration would bypass the marker.
+        Bypasses.init(CurCodeDecl);
+        if (HaveInsertPoint() && Bypasses.isSafe(&D)) {
+          uint64_t Size = CGM.getTargetData().getTypeAllocSize(LTy);
+          emission.SizeForLifetimeMarkers = EmitLifetimeStart(Size, Alloc);
+        }
       }
     } else {
       // Targets that don't support recursion emit locals as globals.
@@ -1198,6 +1245,11 @@ void CodeGenFunction::EmitAutoVarCleanups(const AutoVarEmission &emission) {
 
   const VarDecl &D = *emission.Variable;
 
+  // End the lifetime of the variable after all of its other cleanups.
+  if (emission.SizeForLifetimeMarkers)
+    EHStack.pushCleanup<CallLifetimeEnd>(NormalCleanup, emission.Address,
+                                         emission.SizeForLifetimeMarkers);
+
   // Check the type for a cleanup.
   if (QualType::DestructionKind dtorKind = D.getType().isDestructedType())
     emitAutoVarTypeCleanup(emission, dtorKind);
@@ -1970,6 +1970,62 @@ static const Expr *isSimpleArrayDecayOperand(const Expr *E) {
   return SubExpr;
 }
 
+bool CodeGenFunction::isIndexInBounds(const Expr *Idx, uint64_t Size) {
+  llvm::APSInt Value;
+  if (Idx->EvaluateAsInt(Value, getContext()))
+    return !(Value.isSigned() && Value.isNegative()) &&
+           Value.getActiveBits() <= 63 && Value.getZExtValue() < Size;
+
+  // Otherwise look for 'V', 'V + C' or 'V - C', where V is a variable of an
+  // enclosing loop with known bounds.
+  int64_t Offset = 0;
+  Idx = Idx->IgnoreParenImpCasts();
+  if (const BinaryOperator *BO = dyn_cast<BinaryOperator>(Idx)) {
+    if (BO->getOpcode() != BO_Add && BO->getOpcode() != BO_Sub)
+      return false;
+    llvm::APSInt C;
+    if (!BO->getRHS()->EvaluateAsInt(C, getContext()) ||
+        (C.isSigned() ? C.getMinSignedBits() : C.getActiveBits() + 1) > 32)
+      return false;
+    Offset = BO->getOpcode() == BO_Add ? C.getSExtValue() : -C.getSExtValue();
+    Idx = BO->getLHS()->IgnoreParenImpCasts();
+  }
+
+  const DeclRefExpr *DRE = dyn_cast<DeclRefExpr>(Idx);
+  if (!DRE)
+    return false;
+  for (unsigned I = BoundedLoopVariables.size(); I != 0; --I) {
+    const BoundedLoopVariable &BV = BoundedLoopVariables[I - 1];
+    if (BV.Var == DRE->getDecl())
+      return BV.Min + Offset >= 0 && uint64_t(BV.Max + Offset) < Size;
+  }
+  return false;
+}
+
+bool CodeGenFunction::isSubscriptInBounds(const ArraySubscriptExpr *E) {
+  const Expr *Array = isSimpleArrayDecayOperand(E->getBase());
+  if (!Array)
+    return false;
+  const ConstantArrayType *CAT =
+    getContext().getAsConstantArrayType(Array->getType());
+  if (!CAT || !isIndexInBounds(E->getIdx(), CAT->getSize().getZExtValue()))
+    return false;
+
+  // The array must have the storage its type says: it cannot be reached
+  // through a pointer, which might point to a smaller object.
+  const Expr *Base = Array->IgnoreParens();
+  while (const MemberExpr *ME = dyn_cast<MemberExpr>(Base)) {
+    if (ME->isArrow())
+      return false;
+    Base = ME->getBase()->IgnoreParens();
+  }
+  if (const ArraySubscriptExpr *ASE = dyn_cast<ArraySubscriptExpr>(Base))
+    return isSubscriptInBounds(ASE);
+  const DeclRefExpr *DRE = dyn_cast<DeclRefExpr>(Base);
+  return DRE && isa<VarDecl>(DRE->getDecl()) &&
+         !DRE->getDecl()->getType()->isReferenceType();
+}
+
 LValue CodeGenFunction::EmitArraySubscriptExpr(const ArraySubscriptExpr *E) {
   // The index must always be an integer, which is not an aggregate.  Emit it.
   llvm::Value *Idx = EmitScalarExpr(E->getIdx());
@@ -2048,6 +2104,14 @@ LValue CodeGenFunction::EmitArraySubscriptExpr(const ArraySubscriptExpr *E) {
       Address = Builder.CreateGEP(ArrayPtr, Args, "arrayidx");
     else
       Address = Builder.CreateInBoundsGEP(ArrayPtr, Args, "arrayidx");
+
+    // Tell the bounds checking pass which accesses need no check; see
+    // ElideProvenBoundsChecks in BackendUtil.cpp.
+    if (CGM.getCodeGenOpts().BoundsChecking && isSubscriptInBounds(E))
+      if (llvm::Instruction *GEP = dyn_cast<llvm::Instruction>(Address))
+        GEP->setMetadata("clang.bounds.safe",
+                         llvm::MDNode::get(getLLVMContext(),
+                                           ArrayRef<llvm::Value *>()));
   } else {
     // The base must be a pointer, which is not an aggregate.  Emit it.
     llvm::Value *Base = EmitScalarExpr(E->getBase());
@@ -2348,7 +2412,7 @@ EmitConditionalOperatorLValue(const AbstractConditionalOperator *expr) {
   llvm::BasicBlock *contBlock = createBasicBlock("cond.end");
 
   ConditionalEvaluation eval(*this);
-  EmitBranchOnBoolExpr(condExpr, lhsBlock, rhsBlock);
+  EmitBranchOnRegionCond(expr, condExpr, lhsBlock, rhsBlock);
     
   // Any temporaries created here are conditional.
   EmitBlock(lhsBlock);
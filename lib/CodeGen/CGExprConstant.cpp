@@ -1010,6 +1010,25 @@ public:
 
 }  // end anonymous namespace.
 
+/// isDiscardableStaticVar - Whether the definition of the given variable with
+/// static storage duration may be replaced by the linker with one from another
+/// translation unit. Such a variable is initialized under a guard, and another
+/// translation unit which does not fold its initializer would run it again.
+static bool isDiscardableStaticVar(CodeGenModule &CGM, const VarDecl &D,
+                                   CodeGenFunction *CGF) {
+  if (D.hasAttr<WeakAttr>())
+    return true;
+
+  // A static local shares the linkage of the function containing it.
+  if (D.isStaticLocal())
+    return !CGF || !CGF->CurFn ||
+           llvm::GlobalValue::isWeakForLinker(CGF->CurFn->getLinkage());
+
+  GVALinkage Linkage = CGM.getContext().GetGVALinkageForVariable(&D);
+  return Linkage == GVA_TemplateInstantiation ||
+         Linkage == GVA_ExplicitTemplateInstantiation;
+}
+
 llvm::Constant *CodeGenModule::EmitConstantInit(const VarDecl &D,
                                                 CodeGenFunction *CGF) {
   if (const APValue *Value = D.evaluateValue())
@@ -1032,6 +1051,17 @@ llvm::Constant *CodeGenModule::EmitConstantInit(const VarDecl &D,
     llvm::Type *BoolTy = getTypes().ConvertTypeForMem(E->getType());
     C = llvm::ConstantExpr::getZExt(C, BoolTy);
   }
+
+  // A C++ variable with static storage duration whose initializer is not a
+  // constant expression may still be initialized statically, if we can fold
+  // its initializer, unless its definition can be discarded in favor of one
+  // which is not folded.
+  if (!C && Context.getLangOpts().CPlusPlus && !D.hasLocalStorage() &&
+      !isDiscardableStaticVar(*this, D, CGF)) {
+    APValue Value;
+    if (E->EvaluateAsStaticInitializer(Value, Context, &D))
+      C = EmitConstantValueForMemory(Value, D.getType(), CGF);
+  }
   return C;
 }
 
@@ -1060,6 +1090,33 @@ llvm::Constant *CodeGenModule::EmitConstantExpr(const Expr *E,
   return C;
 }
 
+/// Emit the integer elements of a constant array straight into the data of a
+/// ConstantDataArray, or return null if one of them is not an integer.
+template <typename T>
+static llvm::Constant *EmitIntegerArrayData(llvm::LLVMContext &VMContext,
+                                            const APValue &Value) {
+  unsigned NumElements = Value.getArraySize();
+  unsigned NumInitElts = Value.getArrayInitializedElts();
+
+  T Filler = 0;
+  if (Value.hasArrayFiller()) {
+    if (!Value.getArrayFiller().isInt())
+      return 0;
+    Filler = Value.getArrayFiller().getInt().getZExtValue();
+  }
+
+  SmallVector<T, 64> Data;
+  Data.reserve(NumElements);
+  for (unsigned I = 0; I != NumInitElts; ++I) {
+    const APValue &Elt = Value.getArrayInitializedElt(I);
+    if (!Elt.isInt())
+      return 0;
+    Data.push_back(Elt.getInt().getZExtValue());
+  }
+  Data.resize(NumElements, Filler);
+  return llvm::ConstantDataArray::get(VMContext, Data);
+}
+
 llvm::Constant *CodeGenModule::EmitConstantValue(const APValue &Value,
                                                  QualType DestType,
                                                  CodeGenFunction *CGF) {
@@ -1185,6 +1242,21 @@ llvm::Constant *CodeGenModule::EmitConstantValue(const APValue &Value,
     unsigned NumElements = Value.getArraySize();
     unsigned NumInitElts = Value.getArrayInitializedElts();
 
+    // Arrays of integers, such as the tables of bytes that embed binary data,
+    // do not need an llvm::Constant per element.
+    QualType EltTy = CAT->getElementType();
+    if (EltTy->isIntegerType() && !EltTy->isBooleanType()) {
+      llvm::Constant *C = 0;
+      switch (getTypes().ConvertTypeForMem(EltTy)->getPrimitiveSizeInBits()) {
+      case 8:  C = EmitIntegerArrayData<uint8_t>(VMContext, Value); break;
+      case 16: C = EmitIntegerArrayData<uint16_t>(VMContext, Value); break;
+      case 32: C = EmitIntegerArrayData<uint32_t>(VMContext, Value); break;
+      case 64: C = EmitIntegerArrayData<uint64_t>(VMContext, Value); break;
+      }
+      if (C)
+        return C;
+    }
+
     std::vector<llvm::Constant*> Elts;
     Elts.reserve(NumElements);
 
@@ -578,18 +578,20 @@ class CGObjCGNUstep : public CGObjCGNU {
     /// Type of an slot structure pointer.  This is returned by the various
     /// lookup functions.
     llvm::Type *SlotTy;
-  protected:
-    virtual llvm::Value *LookupIMP(CodeGenFunction &CGF,
-                                   llvm::Value *&Receiver,
-                                   llvm::Value *cmd,
-                                   llvm::MDNode *node) {
+    /// Type of the per-call-site caches of -fobjc-send-cache: the class of
+    /// the last receiver, the slot of the method it was sent, and the version
+    /// of the method caches of the runtime when the slot was looked up.
+    llvm::StructType *SendCacheTy;
+
+    /// Look up the slot of the method for the receiver stored at ReceiverPtr,
+    /// which the lookup function may replace.
+    llvm::Value *EmitSlotLookup(CodeGenFunction &CGF,
+                                llvm::Value *ReceiverPtr,
+                                llvm::Value *cmd,
+                                llvm::MDNode *node) {
       CGBuilderTy &Builder = CGF.Builder;
       llvm::Function *LookupFn = SlotLookupFn;
 
-      // Store the receiver on the stack so that we can reload it later
-      llvm::Value *ReceiverPtr = CGF.CreateTempAlloca(Receiver->getType());
-      Builder.CreateStore(Receiver, ReceiverPtr);
-
       llvm::Value *self;
 
       if (isa<ObjCMethodDecl>(CGF.CurCodeDecl)) {
@@ -608,10 +610,117 @@ class CGObjCGNUstep : public CGObjCGNU {
       llvm::CallSite slot = CGF.EmitCallOrInvoke(LookupFn, args);
       slot.setOnlyReadsMemory();
       slot->setMetadata(msgSendMDKind, node);
+      return slot.getInstruction();
+    }
+
+    /// Look up the slot of the method through a cache of the call site, which
+    /// holds the slot found for the last receiver of the message.  The cache
+    /// is used when the receiver has the same class and no method has changed
+    /// since, which the runtime records by incrementing
+    /// objc_method_cache_version.  The caches are thread-local, so that they
+    /// never mix the entries of two threads.
+    llvm::Value *EmitCachedSlotLookup(CodeGenFunction &CGF,
+                                      llvm::Value *Receiver,
+                                      llvm::Value *ReceiverPtr,
+                                      llvm::Value *cmd,
+                                      llvm::MDNode *node) {
+      CGBuilderTy &Builder = CGF.Builder;
+
+      llvm::GlobalVariable *Cache =
+        new llvm::GlobalVariable(TheModule, SendCacheTy, false,
+                                 llvm::GlobalValue::InternalLinkage,
+                                 llvm::Constant::getNullValue(SendCacheTy),
+                                 ".objc_send_cache");
+      CGM.setDefaultTLSMode(Cache);
+      llvm::Value *CacheVersion =
+        CGM.CreateRuntimeVariable(IntTy, "objc_method_cache_version");
+
+      llvm::BasicBlock *CheckBB = CGF.createBasicBlock("send.cache.check");
+      llvm::BasicBlock *HitBB = CGF.createBasicBlock("send.cache.hit");
+      llvm::BasicBlock *MissBB = CGF.createBasicBlock("send.cache.miss");
+      llvm::BasicBlock *FillBB = CGF.createBasicBlock("send.cache.fill");
+      llvm::BasicBlock *ContBB = CGF.createBasicBlock("send.cache.cont");
+
+      // Only look at the class of receivers which are real objects: nil and
+      // the small objects of the runtime, which are not aligned, always take
+      // the lookup function.
+      llvm::Value *ReceiverInt = Builder.CreatePtrToInt(Receiver, IntPtrTy);
+      llvm::Value *IsObject = Builder.CreateAnd(
+        Builder.CreateIsNotNull(ReceiverInt),
+        Builder.CreateIsNull(Builder.CreateAnd(ReceiverInt,
+                                               CGM.PointerAlignInBytes - 1)));
+      llvm::BasicBlock *EntryBB = Builder.GetInsertBlock();
+      Builder.CreateCondBr(IsObject, CheckBB, MissBB);
+
+      CGF.EmitBlock(CheckBB);
+      llvm::Value *IsaPtr = Builder.CreateBitCast(Receiver,
+                                                  PtrTy->getPointerTo());
+      llvm::Value *Isa = Builder.CreateLoad(IsaPtr, "isa");
+      llvm::Value *CachedIsa =
+        Builder.CreateLoad(Builder.CreateStructGEP(Cache, 0));
+      llvm::Value *CachedVersion =
+        Builder.CreateLoad(Builder.CreateStructGEP(Cache, 2));
+      llvm::Value *IsHit = Builder.CreateAnd(
+        Builder.CreateICmpEQ(Isa, CachedIsa),
+        Builder.CreateICmpEQ(CachedVersion, Builder.CreateLoad(CacheVersion)));
+      Builder.CreateCondBr(IsHit, HitBB, MissBB);
+
+      CGF.EmitBlock(HitBB);
+      llvm::Value *CachedSlot =
+        Builder.CreateLoad(Builder.CreateStructGEP(Cache, 1));
+      Builder.CreateBr(ContBB);
+
+      // Read the version before looking the method up, so that a change to
+      // the methods made during the lookup invalidates the entry.
+      CGF.EmitBlock(MissBB);
+      llvm::PHINode *Cacheable = Builder.CreatePHI(Builder.getInt1Ty(), 2);
+      Cacheable->addIncoming(Builder.getFalse(), EntryBB);
+      Cacheable->addIncoming(Builder.getTrue(), CheckBB);
+      llvm::Value *Version = Builder.CreateLoad(CacheVersion);
+      llvm::Value *Slot = EmitSlotLookup(CGF, ReceiverPtr, cmd, node);
+
+      // A lookup which replaced the receiver, for instance to forward the
+      // message, found the slot of another object; don't cache it.
+      llvm::Value *NewReceiver = Builder.CreateLoad(ReceiverPtr, true);
+      Builder.CreateCondBr(
+        Builder.CreateAnd(Cacheable,
+                          Builder.CreateICmpEQ(NewReceiver, Receiver)),
+        FillBB, ContBB);
+      llvm::BasicBlock *LookupBB = Builder.GetInsertBlock();
+
+      CGF.EmitBlock(FillBB);
+      Builder.CreateStore(Builder.CreateLoad(IsaPtr),
+                          Builder.CreateStructGEP(Cache, 0));
+      Builder.CreateStore(Slot, Builder.CreateStructGEP(Cache, 1));
+      Builder.CreateStore(Version, Builder.CreateStructGEP(Cache, 2));
+      Builder.CreateBr(ContBB);
+
+      CGF.EmitBlock(ContBB);
+      llvm::PHINode *Result = Builder.CreatePHI(SlotTy, 3);
+      Result->addIncoming(CachedSlot, HitBB);
+      Result->addIncoming(Slot, LookupBB);
+      Result->addIncoming(Slot, FillBB);
+      return Result;
+    }
+  protected:
+    virtual llvm::Value *LookupIMP(CodeGenFunction &CGF,
+                                   llvm::Value *&Receiver,
+                                   llvm::Value *cmd,
+                                   llvm::MDNode *node) {
+      CGBuilderTy &Builder = CGF.Builder;
+
+      // Store the receiver on the stack so that we can reload it later
+      llvm::Value *ReceiverPtr = CGF.CreateTempAlloca(Receiver->getType());
+      Builder.CreateStore(Receiver, ReceiverPtr);
+
+      llvm::Value *slot;
+      if (CGM.getCodeGenOpts().ObjCSendCache)
+        slot = EmitCachedSlotLookup(CGF, Receiver, ReceiverPtr, cmd, node);
+      else
+        slot = EmitSlotLookup(CGF, ReceiverPtr, cmd, node);
 
       // Load the imp from the slot
-      llvm::Value *imp =
-        Builder.CreateLoad(Builder.CreateStructGEP(slot.getInstruction(), 4));
+      llvm::Value *imp = Builder.CreateLoad(Builder.CreateStructGEP(slot, 4));
 
       // The lookup function may have changed the receiver, so make sure we use
       // the new one.
@@ -634,6 +743,7 @@ class CGObjCGNUstep : public CGObjCGNU {
       llvm::StructType *SlotStructTy = llvm::StructType::get(PtrTy,
           PtrTy, PtrTy, IntTy, IMPTy, NULL);
       SlotTy = llvm::PointerType::getUnqual(SlotStructTy);
+      SendCacheTy = llvm::StructType::get(PtrTy, SlotTy, IntTy, NULL);
       // Slot_t objc_msg_lookup_sender(id *receiver, SEL selector, id sender);
       SlotLookupFn.init(&CGM, "objc_msg_lookup_sender", SlotTy, PtrToIdTy,
           SelectorTy, IdTy, NULL);
@@ -21,6 +21,8 @@
 #include "llvm/ADT/StringExtras.h"
 #include "llvm/InlineAsm.h"
 #include "llvm/Intrinsics.h"
+#include "llvm/MDBuilder.h"
+#include "llvm/Metadata.h"
 #include "llvm/Target/TargetData.h"
 using namespace clang;
 using namespace CodeGen;
@@ -40,7 +42,7 @@ void CodeGenFunction::EmitStopPoint(const Stmt *S) {
   }
 }
 
-void CodeGenFunction::EmitStmt(const Stmt *S) {
+void CodeGenFunction::EmitStmt(const Stmt *S, ArrayRef<const Attr *> Attrs) {
   assert(S && "Null statement?");
 
   // These statements have their own debug info handling.
@@ -125,9 +127,9 @@ void CodeGenFunction::EmitStmt(const Stmt *S) {
     EmitIndirectGotoStmt(cast<IndirectGotoStmt>(*S)); break;
 
   case Stmt::IfStmtClass:       EmitIfStmt(cast<IfStmt>(*S));             break;
-  case Stmt::WhileStmtClass:    EmitWhileStmt(cast<WhileStmt>(*S));       break;
-  case Stmt::DoStmtClass:       EmitDoStmt(cast<DoStmt>(*S));             break;
-  case Stmt::ForStmtClass:      EmitForStmt(cast<ForStmt>(*S));           break;
+  case Stmt::WhileStmtClass: EmitWhileStmt(cast<WhileStmt>(*S), Attrs); break;
+  case Stmt::DoStmtClass:    EmitDoStmt(cast<DoStmt>(*S), Attrs);       break;
+  case Stmt::ForStmtClass:   EmitForStmt(cast<ForStmt>(*S), Attrs);     break;
 
   case Stmt::ReturnStmtClass:   EmitReturnStmt(cast<ReturnStmt>(*S));     break;
 
@@ -161,7 +163,7 @@ void CodeGenFunction::EmitStmt(const Stmt *S) {
     EmitCXXTryStmt(cast<CXXTryStmt>(*S));
     break;
   case Stmt::CXXForRangeStmtClass:
-    EmitCXXForRangeStmt(cast<CXXForRangeStmt>(*S));
+    EmitCXXForRangeStmt(cast<CXXForRangeStmt>(*S), Attrs);
   case Stmt::SEHTryStmtClass:
     // FIXME Not yet implemented
     break;
@@ -336,8 +338,39 @@ void CodeGenFunction::EmitLabelStmt(const LabelStmt &S) {
   EmitStmt(S.getSubStmt());
 }
 
+CodeGenFunction::BranchLikelihood
+CodeGenFunction::getLikelihood(const Stmt *S) {
+  if (const AttributedStmt *AS = dyn_cast_or_null<AttributedStmt>(S)) {
+    ArrayRef<const Attr *> Attrs = AS->getAttrs();
+    for (unsigned I = 0, N = Attrs.size(); I != N; ++I) {
+      if (isa<LikelyAttr>(Attrs[I]))
+        return LH_Likely;
+      if (isa<UnlikelyAttr>(Attrs[I]))
+        return LH_Unlikely;
+    }
+  }
+  return LH_None;
+}
+
+/// getCaseLikelihood - The likelihood of the statement which the case label
+/// \p S leads to, past any further labels.
+static CodeGenFunction::BranchLikelihood
+getCaseLikelihood(const SwitchCase &S) {
+  const Stmt *Sub = S.getSubStmt();
+  while (const SwitchCase *Inner = dyn_cast<SwitchCase>(Sub))
+    Sub = Inner->getSubStmt();
+  return CodeGenFunction::getLikelihood(Sub);
+}
+
+// The weights of likely and unlikely branches, which are those that
+// __builtin_expect gives the expected and unexpected ways of a branch. A case
+// without either attribute is weighted in between.
+static const uint32_t LikelyBranchWeight = 64;
+static const uint32_t UnlikelyBranchWeight = 4;
+static const uint32_t NoLikelihoodBranchWeight = 16;
+
 void CodeGenFunction::EmitAttributedStmt(const AttributedStmt &S) {
-  EmitStmt(S.getSubStmt());
+  EmitStmt(S.getSubStmt(), S.getAttrs());
 }
 
 void CodeGenFunction::EmitGotoStmt(const GotoStmt &S) {
@@ -408,7 +441,18 @@ void CodeGenFunction::EmitIfStmt(const IfStmt &S) {
   llvm::BasicBlock *ElseBlock = ContBlock;
   if (S.getElse())
     ElseBlock = createBasicBlock("if.else");
-  EmitBranchOnBoolExpr(S.getCond(), ThenBlock, ElseBlock);
+
+  // Weight the branches by their [[clang::likely]] and [[clang::unlikely]]
+  // attributes, unless the two contradict each other.
+  int Likelihood = getLikelihood(S.getThen()) - getLikelihood(S.getElse());
+  llvm::MDNode *HintWeights = 0;
+  if (Likelihood != 0) {
+    llvm::MDBuilder MDHelper(getLLVMContext());
+    HintWeights = Likelihood > 0 ?
+      MDHelper.createBranchWeights(LikelyBranchWeight, UnlikelyBranchWeight) :
+      MDHelper.createBranchWeights(UnlikelyBranchWeight, LikelyBranchWeight);
+  }
+  EmitBranchOnRegionCond(&S, S.getCond(), ThenBlock, ElseBlock, HintWeights);
 
   // Emit the 'then' code.
   EmitBlock(ThenBlock); 
@@ -438,7 +482,8 @@ void CodeGenFunction::EmitIfStmt(const IfStmt &S) {
   EmitBlock(ContBlock, true);
 }
 
-void CodeGenFunction::EmitWhileStmt(const WhileStmt &S) {
+void CodeGenFunction::EmitWhileStmt(const WhileStmt &S,
+                                    ArrayRef<const Attr *> Attrs) {
   // Emit the header for the loop, which will also become
   // the continue target.
   JumpDest LoopHeader = getJumpDestInCurrentScope("while.cond");
@@ -482,7 +527,7 @@ void CodeGenFunction::EmitWhileStmt(const WhileStmt &S) {
     if (ConditionScope.requiresCleanups())
       ExitBlock = createBasicBlock("while.exit");
 
-    Builder.CreateCondBr(BoolCondVal, LoopBody, ExitBlock);
+    EmitRegionCondBr(&S, BoolCondVal, LoopBody, ExitBlock);
 
     if (ExitBlock != LoopExit.getBlock()) {
       EmitBlock(ExitBlock);
@@ -504,7 +549,9 @@ void CodeGenFunction::EmitWhileStmt(const WhileStmt &S) {
   ConditionScope.ForceCleanup();
 
   // Branch to the loop header again.
+  llvm::BasicBlock *LatchBlock = Builder.GetInsertBlock();
   EmitBranch(LoopHeader.getBlock());
+  EmitLoopHints(LatchBlock, LoopHeader.getBlock(), Attrs);
 
   // Emit the exit block.
   EmitBlock(LoopExit.getBlock(), true);
@@ -515,7 +562,8 @@ void CodeGenFunction::EmitWhileStmt(const WhileStmt &S) {
     SimplifyForwardingBlocks(LoopHeader.getBlock());
 }
 
-void CodeGenFunction::EmitDoStmt(const DoStmt &S) {
+void CodeGenFunction::EmitDoStmt(const DoStmt &S,
+                                 ArrayRef<const Attr *> Attrs) {
   JumpDest LoopExit = getJumpDestInCurrentScope("do.end");
   JumpDest LoopCond = getJumpDestInCurrentScope("do.cond");
 
@@ -550,8 +598,17 @@ void CodeGenFunction::EmitDoStmt(const DoStmt &S) {
       EmitBoolCondBranch = false;
 
   // As long as the condition is true, iterate the loop.
-  if (EmitBoolCondBranch)
-    Builder.CreateCondBr(BoolCondVal, LoopBody, LoopExit.getBlock());
+  if (EmitBoolCondBranch) {
+    EmitRegionCondBr(&S, BoolCondVal, LoopBody, LoopExit.getBlock());
+
+    // When instrumenting, the back-edge passes through the block counting it.
+    llvm::BasicBlock *LatchBlock = Builder.GetInsertBlock();
+    llvm::BasicBlock *Taken =
+      cast<llvm::BranchInst>(LatchBlock->getTerminator())->getSuccessor(0);
+    if (Taken != LoopBody)
+      LatchBlock = Taken;
+    EmitLoopHints(LatchBlock, LoopBody, Attrs);
+  }
 
   // Emit the exit block.
   EmitBlock(LoopExit.getBlock());
@@ -562,7 +619,102 @@ void CodeGenFunction::EmitDoStmt(const DoStmt &S) {
     SimplifyForwardingBlocks(LoopCond.getBlock());
 }
 
-void CodeGenFunction::EmitForStmt(const ForStmt &S) {
+/// refersTo - Whether \p E names the variable \p Var.
+static bool refersTo(const Expr *E, const VarDecl *Var) {
+  const DeclRefExpr *DRE = dyn_cast<DeclRefExpr>(E->IgnoreParenImpCasts());
+  return DRE && DRE->getDecl() == Var;
+}
+
+/// onlyReadsVariable - Whether every use of \p Var in \p S reads its value,
+/// so that \p S cannot modify the variable or let anything else do so, and
+/// \p S has no labels through which a jump could enter it.
+static bool onlyReadsVariable(const Stmt *S, const VarDecl *Var,
+                              bool InSwitch) {
+  if (!S)
+    return true;
+  if (isa<LabelStmt>(S) || (isa<SwitchCase>(S) && !InSwitch))
+    return false;
+  if (const ImplicitCastExpr *ICE = dyn_cast<ImplicitCastExpr>(S))
+    if (ICE->getCastKind() == CK_LValueToRValue &&
+        refersTo(ICE->getSubExpr(), Var))
+      return true;
+  if (const DeclRefExpr *DRE = dyn_cast<DeclRefExpr>(S))
+    return DRE->getDecl() != Var;
+
+  // The cases of a switch in the loop body cannot be reached from outside.
+  const SwitchStmt *Switch = dyn_cast<SwitchStmt>(S);
+  for (Stmt::const_child_range I = S->children(); I; ++I)
+    if (!onlyReadsVariable(*I, Var,
+                           InSwitch || (Switch && *I == Switch->getBody())))
+      return false;
+  return true;
+}
+
+/// findBoundedLoopVariable - Recognize 'for (T V = A; V < B; ++V)', where A
+/// and B are constants and the body only reads V, and compute the values V
+/// can have in the body. Variants using '<=', 'V++' and 'V += 1' are also
+/// recognized.
+static bool findBoundedLoopVariable(ASTContext &Ctx, const ForStmt &S,
+                                    const VarDecl *&Var, int64_t &Min,
+                                    int64_t &Max) {
+  const DeclStmt *Init = dyn_cast_or_null<DeclStmt>(S.getInit());
+  if (!Init || !Init->isSingleDecl() || !S.getCond() || !S.getInc() ||
+      S.getConditionVariable())
+    return false;
+  Var = dyn_cast<VarDecl>(Init->getSingleDecl());
+  if (!Var || !Var->getType()->isIntegerType() ||
+      Var->getType().isVolatileQualified() || Var->hasAttr<BlocksAttr>() ||
+      !Var->getInit())
+    return false;
+
+  llvm::APSInt Start;
+  if (!Var->getInit()->EvaluateAsInt(Start, Ctx) ||
+      (Start.isSigned() && Start.isNegative()) || Start.getActiveBits() > 62)
+    return false;
+
+  const BinaryOperator *Cond =
+    dyn_cast<BinaryOperator>(S.getCond()->IgnoreParens());
+  llvm::APSInt Limit;
+  if (!Cond || (Cond->getOpcode() != BO_LT && Cond->getOpcode() != BO_LE) ||
+      !refersTo(Cond->getLHS(), Var) ||
+      !Cond->getRHS()->EvaluateAsInt(Limit, Ctx) ||
+      (Limit.isSigned() && Limit.isNegative()) || Limit.getActiveBits() > 62)
+    return false;
+
+  const Expr *Inc = S.getInc()->IgnoreParens();
+  if (const UnaryOperator *UO = dyn_cast<UnaryOperator>(Inc)) {
+    if (!UO->isIncrementOp() || !refersTo(UO->getSubExpr(), Var))
+      return false;
+  } else if (const CompoundAssignOperator *CAO =
+               dyn_cast<CompoundAssignOperator>(Inc)) {
+    llvm::APSInt Step;
+    if (CAO->getOpcode() != BO_AddAssign || !refersTo(CAO->getLHS(), Var) ||
+        !CAO->getRHS()->EvaluateAsInt(Step, Ctx) ||
+        Step.getLimitedValue() != 1)
+      return false;
+  } else {
+    return false;
+  }
+
+  if (!onlyReadsVariable(S.getBody(), Var, false))
+    return false;
+
+  // V must not wrap around before it fails the condition.
+  if (Cond->getOpcode() == BO_LT && !Limit)
+    return false;
+  uint64_t Last = Limit.getZExtValue() - (Cond->getOpcode() == BO_LT);
+  uint64_t VarBits =
+    Ctx.getTypeSize(Var->getType()) - Var->getType()->isSignedIntegerType();
+  if (VarBits < 63 && Last >= (uint64_t(1) << VarBits) - 1)
+    return false;
+
+  Min = Start.getZExtValue();
+  Max = Last;
+  return true;
+}
+
+void CodeGenFunction::EmitForStmt(const ForStmt &S,
+                                  ArrayRef<const Attr *> Attrs) {
   JumpDest LoopExit = getJumpDestInCurrentScope("for.end");
 
   RunCleanupsScope ForScope(*this);
@@ -605,7 +757,7 @@ void CodeGenFunction::EmitForStmt(const ForStmt &S) {
     // C99 6.8.5p2/p4: The first substatement is executed if the expression
     // compares unequal to 0.  The condition must be a scalar type.
     BoolCondVal = EvaluateExprAsBool(S.getCond());
-    Builder.CreateCondBr(BoolCondVal, ForBody, ExitBlock);
+    EmitRegionCondBr(&S, BoolCondVal, ForBody, ExitBlock);
 
     if (ExitBlock != LoopExit.getBlock()) {
       EmitBlock(ExitBlock);
@@ -628,6 +780,13 @@ void CodeGenFunction::EmitForStmt(const ForStmt &S) {
   // Store the blocks to use for break and continue.
   BreakContinueStack.push_back(BreakContinue(LoopExit, Continue));
 
+  // Accesses indexed by a bounded loop variable may need no bounds checks.
+  BoundedLoopVariable BV;
+  bool IsBounded = CGM.getCodeGenOpts().BoundsChecking &&
+    findBoundedLoopVariable(getContext(), S, BV.Var, BV.Min, BV.Max);
+  if (IsBounded)
+    BoundedLoopVariables.push_back(BV);
+
   {
     // Create a separate cleanup scope for the body, in case it is not
     // a compound statement.
@@ -635,6 +794,9 @@ void CodeGenFunction::EmitForStmt(const ForStmt &S) {
     EmitStmt(S.getBody());
   }
 
+  if (IsBounded)
+    BoundedLoopVariables.pop_back();
+
   // If there is an increment, emit it next.
   if (S.getInc()) {
     EmitBlock(Continue.getBlock());
@@ -644,7 +806,9 @@ void CodeGenFunction::EmitForStmt(const ForStmt &S) {
   BreakContinueStack.pop_back();
 
   ConditionScope.ForceCleanup();
+  llvm::BasicBlock *LatchBlock = Builder.GetInsertBlock();
   EmitBranch(CondBlock);
+  EmitLoopHints(LatchBlock, CondBlock, Attrs);
 
   ForScope.ForceCleanup();
 
@@ -655,7 +819,8 @@ void CodeGenFunction::EmitForStmt(const ForStmt &S) {
   EmitBlock(LoopExit.getBlock(), true);
 }
 
-void CodeGenFunction::EmitCXXForRangeStmt(const CXXForRangeStmt &S) {
+void CodeGenFunction::EmitCXXForRangeStmt(const CXXForRangeStmt &S,
+                                          ArrayRef<const Attr *> Attrs) {
   JumpDest LoopExit = getJumpDestInCurrentScope("for.end");
 
   RunCleanupsScope ForScope(*this);
@@ -686,7 +851,7 @@ void CodeGenFunction::EmitCXXForRangeStmt(const CXXForRangeStmt &S) {
   // The body is executed if the expression, contextually converted
   // to bool, is true.
   llvm::Value *BoolCondVal = EvaluateExprAsBool(S.getCond());
-  Builder.CreateCondBr(BoolCondVal, ForBody, ExitBlock);
+  EmitRegionCondBr(&S, BoolCondVal, ForBody, ExitBlock);
 
   if (ExitBlock != LoopExit.getBlock()) {
     EmitBlock(ExitBlock);
@@ -714,7 +879,9 @@ void CodeGenFunction::EmitCXXForRangeStmt(const CXXForRangeStmt &S) {
 
   BreakContinueStack.pop_back();
 
+  llvm::BasicBlock *LatchBlock = Builder.GetInsertBlock();
   EmitBranch(CondBlock);
+  EmitLoopHints(LatchBlock, CondBlock, Attrs);
 
   ForScope.ForceCleanup();
 
@@ -725,6 +892,74 @@ void CodeGenFunction::EmitCXXForRangeStmt(const CXXForRangeStmt &S) {
   EmitBlock(LoopExit.getBlock(), true);
 }
 
+void CodeGenFunction::EmitLoopHints(llvm::BasicBlock *Latch,
+                                    llvm::BasicBlock *Header,
+                                    ArrayRef<const Attr *> Attrs) {
+  // The body of the loop may have left through a return or a break instead.
+  llvm::BranchInst *BackEdge =
+    Latch ? dyn_cast_or_null<llvm::BranchInst>(Latch->getTerminator()) : 0;
+  if (!BackEdge)
+    return;
+  bool ReachesHeader = false;
+  for (unsigned I = 0, N = BackEdge->getNumSuccessors(); I != N; ++I)
+    ReachesHeader |= BackEdge->getSuccessor(I) == Header;
+  if (!ReachesHeader)
+    return;
+
+  llvm::LLVMContext &Context = getLLVMContext();
+  SmallVector<llvm::Value *, 4> Hints;
+
+  // The first operand refers to the node itself, which keeps the loops of a
+  // function distinct even when their hints are the same.
+  llvm::MDNode *TempNode =
+    llvm::MDNode::getTemporary(Context, ArrayRef<llvm::Value *>());
+  Hints.push_back(TempNode);
+
+  for (unsigned I = 0, N = Attrs.size(); I != N; ++I) {
+    const LoopHintAttr *Hint = dyn_cast<LoopHintAttr>(Attrs[I]);
+    if (!Hint)
+      continue;
+
+    SmallVector<llvm::Value *, 2> Ops;
+    unsigned Value = Hint->getValue();
+    switch (Hint->getOption()) {
+    case LoopHintAttr::Vectorize:
+      Ops.push_back(llvm::MDString::get(Context,
+                                        "llvm.loop.vectorize.enable"));
+      Ops.push_back(Builder.getInt1(Value));
+      break;
+    case LoopHintAttr::VectorizeWidth:
+      Ops.push_back(llvm::MDString::get(Context, "llvm.loop.vectorize.width"));
+      Ops.push_back(Builder.getInt32(Value));
+      break;
+    case LoopHintAttr::InterleaveCount:
+      Ops.push_back(llvm::MDString::get(Context,
+                                        "llvm.loop.interleave.count"));
+      Ops.push_back(Builder.getInt32(Value));
+      break;
+    case LoopHintAttr::Unroll:
+      Ops.push_back(llvm::MDString::get(Context, Value ?
+                                        "llvm.loop.unroll.enable" :
+                                        "llvm.loop.unroll.disable"));
+      break;
+    case LoopHintAttr::UnrollCount:
+      Ops.push_back(llvm::MDString::get(Context, "llvm.loop.unroll.count"));
+      Ops.push_back(Builder.getInt32(Value));
+      break;
+    }
+    Hints.push_back(llvm::MDNode::get(Context, Ops));
+  }
+  if (Hints.size() == 1) {
+    llvm::MDNode::deleteTemporary(TempNode);
+    return;
+  }
+
+  llvm::MDNode *LoopID = llvm::MDNode::get(Context, Hints);
+  LoopID->replaceOperandWith(0, LoopID);
+  llvm::MDNode::deleteTemporary(TempNode);
+  BackEdge->setMetadata("llvm.loop", LoopID);
+}
+
 void CodeGenFunction::EmitReturnOfRValue(RValue RV, QualType Ty) {
   if (RV.isScalar()) {
     Builder.CreateStore(RV.getScalarVal(), ReturnValue);
@@ -842,9 +1077,19 @@ void CodeGenFunction::EmitCaseStmtRange(const CaseStmt &S) {
   llvm::APInt Range = RHS - LHS;
   // FIXME: parameters such as this should not be hardcoded.
   if (Range.ult(llvm::APInt(Range.getBitWidth(), 64))) {
-    // Range is small enough to add multiple switch instruction cases.
-    for (unsigned i = 0, e = Range.getZExtValue() + 1; i != e; ++i) {
-      SwitchInsn->addCase(Builder.getInt(LHS), CaseDest);
+    // Range is small enough to add multiple switch instruction cases. The
+    // count of the case is shared out among them.
+    unsigned NumCases = Range.getZExtValue() + 1;
+    llvm::BasicBlock *CountedCaseDest = PGO.countEdge(*this, &S, 0, CaseDest);
+    uint64_t CaseCount = 0;
+    if (SwitchWeights && !PGO.getEdgeCount(&S, 0, CaseCount))
+      SwitchWeights = 0;
+    for (unsigned i = 0; i != NumCases; ++i) {
+      SwitchInsn->addCase(Builder.getInt(LHS), CountedCaseDest);
+      if (SwitchWeights)
+        SwitchWeights->push_back(CaseCount / NumCases);
+      if (SwitchLikelihood)
+        SwitchLikelihood->push_back(getCaseLikelihood(S));
       LHS++;
     }
     return;
@@ -868,7 +1113,7 @@ void CodeGenFunction::EmitCaseStmtRange(const CaseStmt &S) {
     Builder.CreateSub(SwitchInsn->getCondition(), Builder.getInt(LHS));
   llvm::Value *Cond =
     Builder.CreateICmpULE(Diff, Builder.getInt(Range), "inbounds");
-  Builder.CreateCondBr(Cond, CaseDest, FalseDest);
+  Builder.CreateCondBr(Cond, PGO.countEdge(*this, &S, 0, CaseDest), FalseDest);
 
   // Restore the appropriate insertion point.
   if (RestoreBB)
@@ -877,6 +1122,23 @@ void CodeGenFunction::EmitCaseStmtRange(const CaseStmt &S) {
     Builder.ClearInsertionPoint();
 }
 
+/// addSwitchCase - Add a case to the current switch instruction, counting
+/// how often the switch jumps to it.
+void CodeGenFunction::addSwitchCase(const CaseStmt &S,
+                                    llvm::ConstantInt *CaseVal,
+                                    llvm::BasicBlock *CaseDest) {
+  SwitchInsn->addCase(CaseVal, PGO.countEdge(*this, &S, 0, CaseDest));
+  if (SwitchLikelihood)
+    SwitchLikelihood->push_back(getCaseLikelihood(S));
+  if (SwitchWeights) {
+    uint64_t CaseCount;
+    if (PGO.getEdgeCount(&S, 0, CaseCount))
+      SwitchWeights->push_back(CaseCount);
+    else
+      SwitchWeights = 0;
+  }
+}
+
 void CodeGenFunction::EmitCaseStmt(const CaseStmt &S) {
   // If there is no enclosing switch instance that we're aware of, then this
   // case statement and its block can be elided.  This situation only happens
@@ -905,7 +1167,7 @@ void CodeGenFunction::EmitCaseStmt(const CaseStmt &S) {
 
     // Only do this optimization if there are no cleanups that need emitting.
     if (isObviouslyBranchWithoutCleanups(Block)) {
-      SwitchInsn->addCase(CaseVal, Block.getBlock());
+      addSwitchCase(S, CaseVal, Block.getBlock());
 
       // If there was a fallthrough into this case, make sure to redirect it to
       // the end of the switch as well.
@@ -919,7 +1181,7 @@ void CodeGenFunction::EmitCaseStmt(const CaseStmt &S) {
 
   EmitBlock(createBasicBlock("sw.bb"));
   llvm::BasicBlock *CaseDest = Builder.GetInsertBlock();
-  SwitchInsn->addCase(CaseVal, CaseDest);
+  addSwitchCase(S, CaseVal, CaseDest);
 
   // Recursively emitting the statement is acceptable, but is not wonderful for
   // code where we have many case statements nested together, i.e.:
@@ -938,7 +1200,7 @@ void CodeGenFunction::EmitCaseStmt(const CaseStmt &S) {
     CurCase = NextCase;
     llvm::ConstantInt *CaseVal = 
       Builder.getInt(CurCase->getLHS()->EvaluateKnownConstInt(getContext()));
-    SwitchInsn->addCase(CaseVal, CaseDest);
+    addSwitchCase(*CurCase, CaseVal, CaseDest);
     NextCase = dyn_cast<CaseStmt>(CurCase->getSubStmt());
   }
 
@@ -951,6 +1213,8 @@ void CodeGenFunction::EmitDefaultStmt(const DefaultStmt &S) {
   assert(DefaultBlock->empty() &&
          "EmitDefaultStmt: Default block already defined?");
   EmitBlock(DefaultBlock);
+  if (SwitchLikelihood)
+    (*SwitchLikelihood)[0] = getCaseLikelihood(S);
   EmitStmt(S.getSubStmt());
 }
 
@@ -1166,6 +1430,8 @@ void CodeGenFunction::EmitSwitchStmt(const SwitchStmt &S) {
   // Handle nested switch statements.
   llvm::SwitchInst *SavedSwitchInsn = SwitchInsn;
   llvm::BasicBlock *SavedCRBlock = CaseRangeBlock;
+  SmallVector<uint64_t, 16> *SavedSwitchWeights = SwitchWeights;
+  SmallVector<BranchLikelihood, 16> *SavedSwitchLikelihood = SwitchLikelihood;
 
   // See if we can constant fold the condition of the switch and therefore only
   // emit the live case statement (if any) of the switch.
@@ -1204,6 +1470,24 @@ void CodeGenFunction::EmitSwitchStmt(const SwitchStmt &S) {
   SwitchInsn = Builder.CreateSwitch(CondV, DefaultBlock);
   CaseRangeBlock = DefaultBlock;
 
+  // Collect the counts of the cases as they are added, starting with the
+  // default's.
+  SmallVector<uint64_t, 16> Weights;
+  uint64_t DefaultCount;
+  SwitchWeights = 0;
+  if (PGO.getEdgeCount(&S, 0, DefaultCount)) {
+    Weights.push_back(DefaultCount);
+    SwitchWeights = &Weights;
+  }
+
+  // Without a profile, collect the likelihoods of the cases instead.
+  SmallVector<BranchLikelihood, 16> Likelihoods;
+  SwitchLikelihood = 0;
+  if (!SwitchWeights) {
+    Likelihoods.push_back(LH_None);
+    SwitchLikelihood = &Likelihoods;
+  }
+
   // Clear the insertion point to indicate we are in unreachable code.
   Builder.ClearInsertionPoint();
 
@@ -1222,7 +1506,31 @@ void CodeGenFunction::EmitSwitchStmt(const SwitchStmt &S) {
 
   // Update the default block in case explicit case range tests have
   // been chained on top.
-  SwitchInsn->setDefaultDest(CaseRangeBlock);
+  SwitchInsn->setDefaultDest(PGO.countEdge(*this, &S, 0, CaseRangeBlock));
+
+  // Every case added has a count, unless the profile was missing one.
+  if (SwitchWeights && Weights.size() == SwitchInsn->getNumCases() + 1)
+    SwitchInsn->setMetadata(llvm::LLVMContext::MD_prof,
+                            PGO.createBranchWeights(Weights));
+
+  // Otherwise weight the cases by their likelihood attributes, if any of
+  // them has one.
+  if (SwitchLikelihood &&
+      Likelihoods.size() == SwitchInsn->getNumCases() + 1) {
+    SmallVector<uint32_t, 16> HintWeights;
+    bool HasLikelihood = false;
+    for (unsigned I = 0, N = Likelihoods.size(); I != N; ++I) {
+      HasLikelihood |= Likelihoods[I] != LH_None;
+      HintWeights.push_back(Likelihoods[I] == LH_Likely ? LikelyBranchWeight :
+                            Likelihoods[I] == LH_Unlikely ?
+                              UnlikelyBranchWeight : NoLikelihoodBranchWeight);
+    }
+    if (HasLikelihood) {
+      llvm::MDBuilder MDHelper(getLLVMContext());
+      SwitchInsn->setMetadata(llvm::LLVMContext::MD_prof,
+                              MDHelper.createBranchWeights(HintWeights));
+    }
+  }
 
   // If a default was never emitted:
   if (!DefaultBlock->getParent()) {
@@ -1245,6 +1553,8 @@ void CodeGenFunction::EmitSwitchStmt(const SwitchStmt &S) {
 
   SwitchInsn = SavedSwitchInsn;
   CaseRangeBlock = SavedCRBlock;
+  SwitchWeights = SavedSwitchWeights;
+  SwitchLikelihood = SavedSwitchLikelihood;
 }
 
 static std::string
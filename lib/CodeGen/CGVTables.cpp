@@ -14,6 +14,7 @@
 #include "CodeGenModule.h"
 #include "CodeGenFunction.h"
 #include "CGCXXABI.h"
+#include "CGDebugInfo.h"
 #include "clang/AST/CXXInheritance.h"
 #include "clang/AST/RecordLayout.h"
 #include "clang/Frontend/CodeGenOptions.h"
@@ -38,6 +39,12 @@ bool CodeGenVTables::ShouldEmitVTableInThisTU(const CXXRecordDecl *RD) {
   if (TSK == TSK_ExplicitInstantiationDeclaration)
     return false;
 
+  // With -fpch-vtables=external, the owner of the AST file defining the
+  // class emits its vtable; only emit it for devirtualization.
+  if (CGM.getLangOpts().getPCHVTables() == LangOptions::PCHVTablesExternal &&
+      CGM.getContext().isVTableOwnedByASTFile(RD))
+    return CGM.getCodeGenOpts().OptimizationLevel;
+
   const CXXMethodDecl *KeyFunction = CGM.getContext().getKeyFunction(RD);
   if (!KeyFunction)
     return true;
@@ -722,6 +729,12 @@ CodeGenVTables::GenerateClassData(llvm::GlobalVariable::LinkageTypes Linkage,
     EmitVTTDefinition(VTT, Linkage, RD);
   }
 
+  // The class's debug info lives with its vtable.
+  if (CGDebugInfo *DI = CGM.getModuleDebugInfo())
+    if (Linkage != llvm::GlobalVariable::AvailableExternallyLinkage &&
+        CGM.getCodeGenOpts().DebugInfo >= CodeGenOptions::LimitedDebugInfo)
+      DI->EmitVTableClassType(RD);
+
   // If this is the magic class __cxxabiv1::__fundamental_type_info,
   // we will emit the typeinfo for the fundamental types. This is the
   // same behaviour as GCC.
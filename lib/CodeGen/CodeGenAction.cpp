@@ -8,6 +8,7 @@
 //===----------------------------------------------------------------------===//
 
 #include "clang/CodeGen/CodeGenAction.h"
+#include "clang/Basic/CompilationProfile.h"
 #include "clang/Basic/FileManager.h"
 #include "clang/Basic/SourceManager.h"
 #include "clang/Basic/TargetInfo.h"
@@ -42,6 +43,7 @@ namespace clang {
     const LangOptions &LangOpts;
     raw_ostream *AsmOutStream;
     ASTContext *Context;
+    CompilationProfile *Profile;
 
     Timer LLVMIRGeneration;
 
@@ -58,13 +60,15 @@ namespace clang {
                     const std::string &infile,
                     llvm::Module *LinkModule,
                     raw_ostream *OS,
-                    LLVMContext &C) :
+                    LLVMContext &C,
+                    CompilationProfile *Profile) :
       Diags(_Diags),
       Action(action),
       CodeGenOpts(compopts),
       TargetOpts(targetopts),
       LangOpts(langopts),
       AsmOutStream(OS),
+      Profile(Profile),
       LLVMIRGeneration("LLVM IR Generation Time"),
       Gen(CreateLLVMCodeGen(Diags, infile, compopts, C)),
       LinkModule(LinkModule) {
@@ -80,6 +84,8 @@ namespace clang {
 
     virtual void Initialize(ASTContext &Ctx) {
       Context = &Ctx;
+      CompilationProfileRegion Region(Profile,
+                                      CompilationProfile::IRGeneration);
 
       if (llvm::TimePassesIsEnabled)
         LLVMIRGeneration.startTimer();
@@ -96,6 +102,8 @@ namespace clang {
       PrettyStackTraceDecl CrashInfo(*D.begin(), SourceLocation(),
                                      Context->getSourceManager(),
                                      "LLVM IR generation of declaration");
+      CompilationProfileRegion Region(Profile,
+                                      CompilationProfile::IRGeneration);
 
       if (llvm::TimePassesIsEnabled)
         LLVMIRGeneration.startTimer();
@@ -111,6 +119,8 @@ namespace clang {
     virtual void HandleTranslationUnit(ASTContext &C) {
       {
         PrettyStackTraceString CrashInfo("Per-file LLVM IR generation");
+        CompilationProfileRegion Region(Profile,
+                                        CompilationProfile::IRGeneration);
         if (llvm::TimePassesIsEnabled)
           LLVMIRGeneration.startTimer();
 
@@ -157,7 +167,8 @@ namespace clang {
       Ctx.setInlineAsmDiagnosticHandler(InlineAsmDiagHandler, this);
 
       EmitBackendOutput(Diags, CodeGenOpts, TargetOpts, LangOpts,
-                        TheModule.get(), Action, AsmOutStream);
+                        TheModule.get(), Action, AsmOutStream, Profile,
+                        &Context->getSourceManager());
       
       Ctx.setInlineAsmDiagnosticHandler(OldHandler, OldContext);
     }
@@ -356,7 +367,9 @@ ASTConsumer *CodeGenAction::CreateASTConsumer(CompilerInstance &CI,
                           CI.getCodeGenOpts(), CI.getTargetOpts(),
                           CI.getLangOpts(),
                           CI.getFrontendOpts().ShowTimers, InFile,
-                          LinkModuleToUse, OS.take(), *VMContext);
+                          LinkModuleToUse, OS.take(), *VMContext,
+                          CI.hasCompilationProfile() ?
+                            &CI.getCompilationProfile() : 0);
   return BEConsumer;
 }
 
@@ -413,7 +426,10 @@ void CodeGenAction::ExecuteAction() {
     EmitBackendOutput(CI.getDiagnostics(), CI.getCodeGenOpts(),
                       CI.getTargetOpts(), CI.getLangOpts(),
                       TheModule.get(),
-                      BA, OS);
+                      BA, OS,
+                      CI.hasCompilationProfile() ?
+                        &CI.getCompilationProfile() : 0,
+                      &SM);
     return;
   }
 
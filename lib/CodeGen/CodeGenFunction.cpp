@@ -36,7 +36,8 @@ CodeGenFunction::CodeGenFunction(CodeGenModule &cgm, bool suppressNewContext)
     LambdaThisCaptureField(0), NormalCleanupDest(0), NextCleanupDestIndex(1),
     FirstBlockInfo(0), EHResumeBlock(0), ExceptionSlot(0), EHSelectorSlot(0),
     DebugInfo(0), DisableDebugInfo(false), DidCallStackSave(false),
-    IndirectBranch(0), SwitchInsn(0), CaseRangeBlock(0), UnreachableBlock(0),
+    IndirectBranch(0), SwitchInsn(0), CaseRangeBlock(0), SwitchWeights(0),
+    SwitchLikelihood(0), PGO(cgm), UnreachableBlock(0),
     CXXABIThisDecl(0), CXXABIThisValue(0), CXXThisValue(0), CXXVTTDecl(0),
     CXXVTTValue(0), OutermostConditional(0), TerminateLandingPad(0),
     TerminateHandler(0), TrapBB(0) {
@@ -511,6 +512,7 @@ void CodeGenFunction::GenerateCode(GlobalDecl GD, llvm::Function *Fn,
 
   // Emit the standard function prologue.
   StartFunction(GD, ResTy, Fn, FnInfo, Args, BodyRange.getBegin());
+  PGO.assignRegionCounters(FD, CurFn, Builder);
 
   // Generate the body of the function.
   if (isa<CXXDestructorDecl>(FD))
@@ -640,7 +642,8 @@ ConstantFoldsToSimpleInteger(const Expr *Cond, llvm::APSInt &ResultInt) {
 ///
 void CodeGenFunction::EmitBranchOnBoolExpr(const Expr *Cond,
                                            llvm::BasicBlock *TrueBlock,
-                                           llvm::BasicBlock *FalseBlock) {
+                                           llvm::BasicBlock *FalseBlock,
+                                           llvm::MDNode *Weights) {
   Cond = Cond->IgnoreParens();
 
   if (const BinaryOperator *CondBOp = dyn_cast<BinaryOperator>(Cond)) {
@@ -652,7 +655,8 @@ void CodeGenFunction::EmitBranchOnBoolExpr(const Expr *Cond,
       if (ConstantFoldsToSimpleInteger(CondBOp->getLHS(), ConstantBool) &&
           ConstantBool) {
         // br(1 && X) -> br(X).
-        return EmitBranchOnBoolExpr(CondBOp->getRHS(), TrueBlock, FalseBlock);
+        return EmitBranchOnBoolExpr(CondBOp->getRHS(), TrueBlock, FalseBlock,
+                                    Weights);
       }
 
       // If we have "X && 1", simplify the code to use an uncond branch.
@@ -660,7 +664,8 @@ void CodeGenFunction::EmitBranchOnBoolExpr(const Expr *Cond,
       if (ConstantFoldsToSimpleInteger(CondBOp->getRHS(), ConstantBool) &&
           ConstantBool) {
         // br(X && 1) -> br(X).
-        return EmitBranchOnBoolExpr(CondBOp->getLHS(), TrueBlock, FalseBlock);
+        return EmitBranchOnBoolExpr(CondBOp->getLHS(), TrueBlock, FalseBlock,
+                                    Weights);
       }
 
       // Emit the LHS as a conditional.  If the LHS conditional is false, we
@@ -668,7 +673,7 @@ void CodeGenFunction::EmitBranchOnBoolExpr(const Expr *Cond,
       llvm::BasicBlock *LHSTrue = createBasicBlock("land.lhs.true");
 
       ConditionalEvaluation eval(*this);
-      EmitBranchOnBoolExpr(CondBOp->getLHS(), LHSTrue, FalseBlock);
+      EmitBranchOnRegionCond(CondBOp, CondBOp->getLHS(), LHSTrue, FalseBlock);
       EmitBlock(LHSTrue);
 
       // Any temporaries created here are conditional.
@@ -686,7 +691,8 @@ void CodeGenFunction::EmitBranchOnBoolExpr(const Expr *Cond,
       if (ConstantFoldsToSimpleInteger(CondBOp->getLHS(), ConstantBool) &&
           !ConstantBool) {
         // br(0 || X) -> br(X).
-        return EmitBranchOnBoolExpr(CondBOp->getRHS(), TrueBlock, FalseBlock);
+        return EmitBranchOnBoolExpr(CondBOp->getRHS(), TrueBlock, FalseBlock,
+                                    Weights);
       }
 
       // If we have "X || 0", simplify the code to use an uncond branch.
@@ -694,7 +700,8 @@ void CodeGenFunction::EmitBranchOnBoolExpr(const Expr *Cond,
       if (ConstantFoldsToSimpleInteger(CondBOp->getRHS(), ConstantBool) &&
           !ConstantBool) {
         // br(X || 0) -> br(X).
-        return EmitBranchOnBoolExpr(CondBOp->getLHS(), TrueBlock, FalseBlock);
+        return EmitBranchOnBoolExpr(CondBOp->getLHS(), TrueBlock, FalseBlock,
+                                    Weights);
       }
 
       // Emit the LHS as a conditional.  If the LHS conditional is true, we
@@ -702,7 +709,7 @@ void CodeGenFunction::EmitBranchOnBoolExpr(const Expr *Cond,
       llvm::BasicBlock *LHSFalse = createBasicBlock("lor.lhs.false");
 
       ConditionalEvaluation eval(*this);
-      EmitBranchOnBoolExpr(CondBOp->getLHS(), TrueBlock, LHSFalse);
+      EmitBranchOnRegionCond(CondBOp, CondBOp->getLHS(), TrueBlock, LHSFalse);
       EmitBlock(LHSFalse);
 
       // Any temporaries created here are conditional.
@@ -716,8 +723,18 @@ void CodeGenFunction::EmitBranchOnBoolExpr(const Expr *Cond,
 
   if (const UnaryOperator *CondUOp = dyn_cast<UnaryOperator>(Cond)) {
     // br(!x, t, f) -> br(x, f, t)
-    if (CondUOp->getOpcode() == UO_LNot)
-      return EmitBranchOnBoolExpr(CondUOp->getSubExpr(), FalseBlock, TrueBlock);
+    if (CondUOp->getOpcode() == UO_LNot) {
+      // The weights of the blocks are swapped along with the blocks.
+      if (Weights) {
+        llvm::Value *Ops[] = {
+          Weights->getOperand(0), Weights->getOperand(2),
+          Weights->getOperand(1)
+        };
+        Weights = llvm::MDNode::get(getLLVMContext(), Ops);
+      }
+      return EmitBranchOnBoolExpr(CondUOp->getSubExpr(), FalseBlock, TrueBlock,
+                                  Weights);
+    }
   }
 
   if (const ConditionalOperator *CondOp = dyn_cast<ConditionalOperator>(Cond)) {
@@ -726,7 +743,7 @@ void CodeGenFunction::EmitBranchOnBoolExpr(const Expr *Cond,
     llvm::BasicBlock *RHSBlock = createBasicBlock("cond.false");
 
     ConditionalEvaluation cond(*this);
-    EmitBranchOnBoolExpr(CondOp->getCond(), LHSBlock, RHSBlock);
+    EmitBranchOnRegionCond(CondOp, CondOp->getCond(), LHSBlock, RHSBlock);
 
     cond.begin(*this);
     EmitBlock(LHSBlock);
@@ -743,7 +760,27 @@ void CodeGenFunction::EmitBranchOnBoolExpr(const Expr *Cond,
 
   // Emit the code with the fully general case.
   llvm::Value *CondV = EvaluateExprAsBool(Cond);
-  Builder.CreateCondBr(CondV, TrueBlock, FalseBlock);
+  Builder.CreateCondBr(CondV, TrueBlock, FalseBlock, Weights);
+}
+
+void CodeGenFunction::EmitBranchOnRegionCond(const Stmt *S, const Expr *Cond,
+                                             llvm::BasicBlock *TrueBlock,
+                                             llvm::BasicBlock *FalseBlock,
+                                             llvm::MDNode *HintWeights) {
+  llvm::BasicBlock *CountedTrueBlock = PGO.countEdge(*this, S, 0, TrueBlock);
+  llvm::BasicBlock *CountedFalseBlock = PGO.countEdge(*this, S, 1, FalseBlock);
+  llvm::MDNode *Weights = PGO.getBranchWeights(S);
+  EmitBranchOnBoolExpr(Cond, CountedTrueBlock, CountedFalseBlock,
+                       Weights ? Weights : HintWeights);
+}
+
+void CodeGenFunction::EmitRegionCondBr(const Stmt *S, llvm::Value *CondV,
+                                       llvm::BasicBlock *TrueBlock,
+                                       llvm::BasicBlock *FalseBlock) {
+  llvm::BasicBlock *CountedTrueBlock = PGO.countEdge(*this, S, 0, TrueBlock);
+  llvm::BasicBlock *CountedFalseBlock = PGO.countEdge(*this, S, 1, FalseBlock);
+  Builder.CreateCondBr(CondV, CountedTrueBlock, CountedFalseBlock,
+                       PGO.getBranchWeights(S));
 }
 
 /// ErrorUnsupported - Print out an error that codegen doesn't support the
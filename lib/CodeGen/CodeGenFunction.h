@@ -30,6 +30,8 @@
 #include "CGBuilder.h"
 #include "CGDebugInfo.h"
 #include "CGValue.h"
+#include "CodeGenPGO.h"
+#include "VarBypassDetector.h"
 
 namespace llvm {
   class BasicBlock;
@@ -1152,6 +1154,41 @@ private:
   /// statement range in current switch instruction.
   llvm::BasicBlock *CaseRangeBlock;
 
+  /// SwitchWeights - The counts of the default and of each case added to the
+  /// current switch instruction so far, if the profile has counts for it.
+  SmallVector<uint64_t, 16> *SwitchWeights;
+
+public:
+  /// BranchLikelihood - What a [[clang::likely]] or [[clang::unlikely]]
+  /// attribute says about how often a statement is reached.
+  enum BranchLikelihood { LH_Unlikely = -1, LH_None, LH_Likely };
+
+  /// getLikelihood - The likelihood which the attributes of \p S give it.
+  static BranchLikelihood getLikelihood(const Stmt *S);
+
+private:
+  /// SwitchLikelihood - The likelihoods of the default and of each case
+  /// added to the current switch instruction so far.
+  SmallVector<BranchLikelihood, 16> *SwitchLikelihood;
+
+  /// PGO - The region counters of the current function.
+  CodeGenPGO PGO;
+
+  /// Bypasses - The local variables of the current function whose
+  /// declarations a jump may bypass.
+  VarBypassDetector Bypasses;
+
+  /// BoundedLoopVariable - A variable declared by a 'for' loop whose body is
+  /// being emitted, and the values it can have in the body.
+  struct BoundedLoopVariable {
+    const VarDecl *Var;
+    int64_t Min, Max;
+  };
+
+  /// BoundedLoopVariables - The loop variables known to be bounded, when
+  /// emitting run-time bounds checks, innermost loop last.
+  SmallVector<BoundedLoopVariable, 4> BoundedLoopVariables;
+
   /// OpaqueLValues - Keeps track of the current set of opaque value
   /// expressions.
   llvm::DenseMap<const OpaqueValueExpr *, LValue> OpaqueLValues;
@@ -1901,6 +1938,10 @@ public:
 
     llvm::Value *NRVOFlag;
 
+    /// The size of the variable given to llvm.lifetime.start, or null if the
+    /// variable has no lifetime markers.
+    llvm::Value *SizeForLifetimeMarkers;
+
     /// True if the variable is a __block variable.
     bool IsByRef;
 
@@ -1913,7 +1954,8 @@ public:
 
     AutoVarEmission(const VarDecl &variable)
       : Variable(&variable), Address(0), NRVOFlag(0),
-        IsByRef(false), IsConstantAggregate(false) {}
+        SizeForLifetimeMarkers(0), IsByRef(false),
+        IsConstantAggregate(false) {}
 
     bool wasEmittedAsGlobal() const { return Address == 0; }
 
@@ -1932,6 +1974,13 @@ public:
     }
   };
   AutoVarEmission EmitAutoVarAlloca(const VarDecl &var);
+
+  /// EmitLifetimeStart - Emit an llvm.lifetime.start for the \p Size bytes
+  /// at \p Addr, if lifetime markers are enabled and the object is large
+  /// enough to get them. Returns the size to pass to EmitLifetimeEnd, or null
+  /// if no marker was emitted.
+  llvm::Value *EmitLifetimeStart(uint64_t Size, llvm::Value *Addr);
+  void EmitLifetimeEnd(llvm::Value *Size, llvm::Value *Addr);
   void EmitAutoVarInit(const AutoVarEmission &emission);
   void EmitAutoVarCleanups(const AutoVarEmission &emission);  
   void emitAutoVarTypeCleanup(const AutoVarEmission &emission,
@@ -1968,7 +2017,11 @@ public:
   /// This function may clear the current insertion point; callers should use
   /// EnsureInsertPoint if they wish to subsequently generate code without first
   /// calling EmitBlock, EmitBranch, or EmitStmt.
-  void EmitStmt(const Stmt *S);
+  ///
+  /// \p Attrs are the attributes the statement was written with, such as the
+  /// hints of a loop.
+  void EmitStmt(const Stmt *S,
+                ArrayRef<const Attr *> Attrs = ArrayRef<const Attr *>());
 
   /// EmitSimpleStmt - Try to emit a "simple" statement which does not
   /// necessarily require an insertion point or debug information; typically
@@ -1990,9 +2043,12 @@ public:
   void EmitGotoStmt(const GotoStmt &S);
   void EmitIndirectGotoStmt(const IndirectGotoStmt &S);
   void EmitIfStmt(const IfStmt &S);
-  void EmitWhileStmt(const WhileStmt &S);
-  void EmitDoStmt(const DoStmt &S);
-  void EmitForStmt(const ForStmt &S);
+  void EmitWhileStmt(const WhileStmt &S,
+                     ArrayRef<const Attr *> Attrs = ArrayRef<const Attr *>());
+  void EmitDoStmt(const DoStmt &S,
+                  ArrayRef<const Attr *> Attrs = ArrayRef<const Attr *>());
+  void EmitForStmt(const ForStmt &S,
+                   ArrayRef<const Attr *> Attrs = ArrayRef<const Attr *>());
   void EmitReturnStmt(const ReturnStmt &S);
   void EmitDeclStmt(const DeclStmt &S);
   void EmitBreakStmt(const BreakStmt &S);
@@ -2001,6 +2057,8 @@ public:
   void EmitDefaultStmt(const DefaultStmt &S);
   void EmitCaseStmt(const CaseStmt &S);
   void EmitCaseStmtRange(const CaseStmt &S);
+  void addSwitchCase(const CaseStmt &S, llvm::ConstantInt *CaseVal,
+                     llvm::BasicBlock *CaseDest);
   void EmitAsmStmt(const AsmStmt &S);
 
   void EmitObjCForCollectionStmt(const ObjCForCollectionStmt &S);
@@ -2015,7 +2073,13 @@ public:
   void ExitCXXTryStmt(const CXXTryStmt &S, bool IsFnTryBlock = false);
 
   void EmitCXXTryStmt(const CXXTryStmt &S);
-  void EmitCXXForRangeStmt(const CXXForRangeStmt &S);
+  void EmitCXXForRangeStmt(const CXXForRangeStmt &S,
+                   ArrayRef<const Attr *> Attrs = ArrayRef<const Attr *>());
+
+  /// EmitLoopHints - Attach the '#pragma clang loop' hints among \p Attrs to
+  /// the back-edge of a loop, if \p Latch ends with a branch to \p Header.
+  void EmitLoopHints(llvm::BasicBlock *Latch, llvm::BasicBlock *Header,
+                     ArrayRef<const Attr *> Attrs);
 
   //===--------------------------------------------------------------------===//
   //                         LValue Expression Emission
@@ -2115,6 +2179,15 @@ public:
   void EmitStoreThroughBitfieldLValue(RValue Src, LValue Dst,
                                       llvm::Value **Result=0);
 
+  /// isIndexInBounds - Whether \p Idx is known to be at least 0 and less than
+  /// \p Size wherever it is evaluated.
+  bool isIndexInBounds(const Expr *Idx, uint64_t Size);
+
+  /// isSubscriptInBounds - Whether \p E is known to access an element of an
+  /// array which is, or is a subobject of, a variable, so that its run-time
+  /// bounds check can be left out.
+  bool isSubscriptInBounds(const ArraySubscriptExpr *E);
+
   /// Emit an l-value for an assignment (simple or compound) of complex type.
   LValue EmitComplexAssignmentLValue(const BinaryOperator *E);
   LValue EmitComplexCompoundAssignmentLValue(const CompoundAssignOperator *E);
@@ -2532,8 +2605,25 @@ public:
   /// EmitBranchOnBoolExpr - Emit a branch on a boolean condition (e.g. for an
   /// if statement) to the specified blocks.  Based on the condition, this might
   /// try to simplify the codegen of the conditional based on the branch.
+  ///
+  /// Weights, if given, are the branch weights of the condition as a whole.
   void EmitBranchOnBoolExpr(const Expr *Cond, llvm::BasicBlock *TrueBlock,
-                            llvm::BasicBlock *FalseBlock);
+                            llvm::BasicBlock *FalseBlock,
+                            llvm::MDNode *Weights = 0);
+
+  /// EmitBranchOnRegionCond - Emit a branch on the condition of the region
+  /// \p S, such as an 'if' or a '?:', counting how often either way is taken
+  /// and weighting them by the profile, or by \p HintWeights without one.
+  void EmitBranchOnRegionCond(const Stmt *S, const Expr *Cond,
+                              llvm::BasicBlock *TrueBlock,
+                              llvm::BasicBlock *FalseBlock,
+                              llvm::MDNode *HintWeights = 0);
+
+  /// EmitRegionCondBr - Like EmitBranchOnRegionCond, for a condition which
+  /// has already been evaluated.
+  void EmitRegionCondBr(const Stmt *S, llvm::Value *CondV,
+                        llvm::BasicBlock *TrueBlock,
+                        llvm::BasicBlock *FalseBlock);
 
   /// \brief Create a basic block that will call the trap intrinsic, and emit a
   /// conditional branch to it.
@@ -14,6 +14,7 @@
 #include "CodeGenModule.h"
 #include "CGDebugInfo.h"
 #include "CodeGenFunction.h"
+#include "CodeGenPGO.h"
 #include "CodeGenTBAA.h"
 #include "CGCall.h"
 #include "CGCUDARuntime.h"
@@ -22,6 +23,7 @@
 #include "CGOpenCLRuntime.h"
 #include "TargetInfo.h"
 #include "clang/Frontend/CodeGenOptions.h"
+#include "clang/Frontend/FrontendDiagnostic.h"
 #include "clang/AST/ASTContext.h"
 #include "clang/AST/CharUnits.h"
 #include "clang/AST/DeclObjC.h"
@@ -71,7 +73,7 @@ CodeGenModule::CodeGenModule(ASTContext &C, const CodeGenOptions &CGO,
     TBAA(0),
     VTables(*this), ObjCRuntime(0), OpenCLRuntime(0), CUDARuntime(0),
     DebugInfo(0), ARCData(0), NoObjCARCExceptionsMetadata(0),
-    RRData(0), CFConstantStringClassRef(0),
+    RRData(0), PGOData(0), CFConstantStringClassRef(0),
     ConstantStringClassRef(0), NSConstantStringType(0),
     VMContext(M.getContext()),
     NSConcreteGlobalBlock(0), NSConcreteStackBlock(0),
@@ -120,6 +122,17 @@ CodeGenModule::CodeGenModule(ASTContext &C, const CodeGenOptions &CGO,
   if (C.getLangOpts().ObjCAutoRefCount)
     ARCData = new ARCEntrypoints();
   RRData = new RREntrypoints();
+
+  if (!CodeGenOpts.InstrProfileInput.empty()) {
+    PGOData = new PGOProfileData;
+    std::string Error;
+    if (PGOData->read(CodeGenOpts.InstrProfileInput, Error)) {
+      Diags.Report(diag::err_fe_unable_to_read_profile)
+        << CodeGenOpts.InstrProfileInput << Error;
+      delete PGOData;
+      PGOData = 0;
+    }
+  }
 }
 
 CodeGenModule::~CodeGenModule() {
@@ -132,6 +145,7 @@ CodeGenModule::~CodeGenModule() {
   delete DebugInfo;
   delete ARCData;
   delete RRData;
+  delete PGOData;
 }
 
 void CodeGenModule::createObjCRuntime() {
@@ -168,6 +182,8 @@ void CodeGenModule::Release() {
   if (ObjCRuntime)
     if (llvm::Function *ObjCInitFunction = ObjCRuntime->ModuleInitFunction())
       AddGlobalCtor(ObjCInitFunction);
+  if (getCodeGenOpts().ProfileInstrGenerate)
+    EmitPGOWriteout();
   EmitCtorList(GlobalCtors, "llvm.global_ctors");
   EmitCtorList(GlobalDtors, "llvm.global_dtors");
   EmitGlobalAnnotations();
@@ -298,6 +314,10 @@ void CodeGenModule::setTLSMode(llvm::GlobalVariable *GV,
   GV->setThreadLocalMode(TLM);
 }
 
+void CodeGenModule::setDefaultTLSMode(llvm::GlobalVariable *GV) const {
+  GV->setThreadLocalMode(GetLLVMTLSModel(CodeGenOpts.DefaultTLSModel));
+}
+
 /// Set the symbol visibility of type information (vtable and RTTI)
 /// associated with the given type.
 void CodeGenModule::setTypeVisibility(llvm::GlobalValue *GV,
@@ -423,6 +443,11 @@ llvm::GlobalValue *CodeGenModule::GetGlobalValue(StringRef Name) {
   return getModule().getNamedValue(Name);
 }
 
+bool CodeGenModule::hasEmittedDefinition(GlobalDecl GD) {
+  llvm::GlobalValue *GV = GetGlobalValue(getMangledName(GD));
+  return GV && !GV->isDeclaration();
+}
+
 /// AddGlobalCtor - Add a function to the list that will be called before
 /// main() runs.
 void CodeGenModule::AddGlobalCtor(llvm::Function * Ctor, int Priority) {
@@ -701,6 +726,16 @@ void CodeGenModule::EmitLLVMUsed() {
   GV->setSection("llvm.metadata");
 }
 
+/// EmitDeferred - Emit the deferred declarations which have been used.
+///
+/// FIXME: Function bodies are emitted one at a time, into one module. They
+/// cannot be emitted concurrently into separate modules: an llvm::Module
+/// and everything in it belong to one LLVMContext, which is not thread-safe,
+/// and modules from different contexts cannot be linked. Emitting a body
+/// also mutates the ASTContext (uniquing types, computing record layouts
+/// and caching constant evaluation and mangling numbers) and this
+/// CodeGenModule (the deferred-decls queue, the type cache and the global
+/// value map), none of which is synchronized.
 void CodeGenModule::EmitDeferred() {
   // Emit code for any potentially referenced deferred decls.  Since a
   // previously unused static decl may become used during the generation of code
@@ -1354,6 +1389,14 @@ CodeGenModule::getVTableLinkage(const CXXRecordDecl *RD) {
   if (RD->getLinkage() != ExternalLinkage)
     return llvm::GlobalVariable::InternalLinkage;
 
+  // The owner of the AST file defining the class provides the one definition
+  // of its vtable under -fpch-vtables; everyone else has a copy at most.
+  if (Context.isVTableOwnedByASTFile(RD)) {
+    if (Context.getLangOpts().getPCHVTables() == LangOptions::PCHVTablesOwner)
+      return llvm::GlobalVariable::WeakODRLinkage;
+    return llvm::GlobalVariable::AvailableExternallyLinkage;
+  }
+
   if (const CXXMethodDecl *KeyFunction
                                     = RD->getASTContext().getKeyFunction(RD)) {
     // If this class has a key function, use that to determine the linkage of
@@ -1597,6 +1640,8 @@ void CodeGenModule::EmitGlobalVarDefinition(const VarDecl *D) {
       if (getLangOpts().CPlusPlus) {
         Init = EmitNullConstant(T);
         NeedsGlobalCtor = true;
+        getDiags().Report(D->getLocation(), diag::warn_fe_dynamic_initializer)
+          << D;
       } else {
         ErrorUnsupported(D, "static initializer");
         Init = llvm::UndefValue::get(getTypes().ConvertType(T));
@@ -77,6 +77,7 @@ namespace CodeGen {
   class CGObjCRuntime;
   class CGOpenCLRuntime;
   class CGCUDARuntime;
+  class PGOProfileData;
   class BlockFieldFlags;
   class FunctionArgList;
   
@@ -238,6 +239,14 @@ class CodeGenModule : public CodeGenTypeCache {
   llvm::MDNode *NoObjCARCExceptionsMetadata;
   RREntrypoints *RRData;
 
+  /// PGOData - The profile read for -fprofile-instr-use, if any.
+  PGOProfileData *PGOData;
+
+  /// PGOCounterArrays - The name of each function instrumented for
+  /// -fprofile-instr-generate, and the array of its region counters.
+  std::vector<std::pair<std::string, llvm::GlobalVariable *> >
+    PGOCounterArrays;
+
   // WeakRefReferences - A set of references that have only been seen via
   // a weakref so far. This is used to remove the weak of the reference if we ever
   // see a direct reference or a definition.
@@ -391,6 +400,15 @@ public:
   /// getCXXABI() - Return a reference to the configured C++ ABI.
   CGCXXABI &getCXXABI() { return ABI; }
 
+  /// getPGOData() - Return the profile used for -fprofile-instr-use, or null.
+  PGOProfileData *getPGOData() const { return PGOData; }
+
+  /// addPGOCounterArray - Note the region counters of an instrumented
+  /// function, which the profile runtime writes out when the program exits.
+  void addPGOCounterArray(StringRef FuncName, llvm::GlobalVariable *Counters) {
+    PGOCounterArrays.push_back(std::make_pair(FuncName.str(), Counters));
+  }
+
   ARCEntrypoints &getARCEntrypoints() const {
     assert(getLangOpts().ObjCAutoRefCount && ARCData != 0);
     return *ARCData;
@@ -478,6 +496,10 @@ public:
   /// for the thread-local variable declaration D.
   void setTLSMode(llvm::GlobalVariable *GV, const VarDecl &D) const;
 
+  /// setDefaultTLSMode - Make the given LLVM GlobalVariable thread-local,
+  /// with the TLS mode of -ftls-model.
+  void setDefaultTLSMode(llvm::GlobalVariable *GV) const;
+
   /// TypeVisibilityKind - The kind of global variable that is passed to 
   /// setTypeVisibility
   enum TypeVisibilityKind {
@@ -591,6 +613,12 @@ public:
 
   llvm::FoldingSet<ByrefHelpers> ByrefHelpersCache;
 
+  /// BlockHelpersCache - The copy and dispose helpers of the blocks without
+  /// C++ captures, keyed by the captures which they copy and dispose of, so
+  /// that blocks which capture alike share them.
+  llvm::StringMap<std::pair<llvm::Constant *, llvm::Constant *> >
+    BlockHelpersCache;
+
   /// getUniqueBlockCount - Fetches the global unique block count.
   int getUniqueBlockCount() { return ++Block.GlobalUniqueCount; }
   
@@ -681,6 +709,10 @@ public:
   /// EmitTopLevelDecl - Emit code for a single top level declaration.
   void EmitTopLevelDecl(Decl *D);
 
+  /// hasEmittedDefinition - Return true if the definition of the given global
+  /// has been emitted into the module, rather than deferred or not emitted.
+  bool hasEmittedDefinition(GlobalDecl GD);
+
   /// HandleCXXStaticMemberVarInstantiation - Tell the consumer that this
   // variable has been instantiated.
   void HandleCXXStaticMemberVarInstantiation(VarDecl *VD);
@@ -984,6 +1016,8 @@ private:
   /// to emit the .gcno and .gcda files in a way that persists in .bc files.
   void EmitCoverageFile();
 
+  void EmitPGOWriteout();
+
   /// MayDeferGeneration - Determine if the given decl can be emitted
   /// lazily; this is only relevant for definitions. The given decl
   /// must be either a function or var decl.
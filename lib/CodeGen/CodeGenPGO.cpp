@@ -0,0 +1,297 @@
+//===--- CodeGenPGO.cpp - PGO instrumentation for LLVM CodeGen ------------===//
+//
+//                     The LLVM Compiler Infrastructure
+//
+// This file is distributed under the University of Illinois Open Source
+// License. See LICENSE.TXT for details.
+//
+//===----------------------------------------------------------------------===//
+//
+// Instrumentation-based profile-guided optimization
+//
+//===----------------------------------------------------------------------===//
+
+#include "CodeGenPGO.h"
+#include "CodeGenFunction.h"
+#include "CodeGenModule.h"
+#include "clang/AST/RecursiveASTVisitor.h"
+#include "clang/Frontend/CodeGenOptions.h"
+#include "llvm/MDBuilder.h"
+#include "llvm/Support/MemoryBuffer.h"
+#include "llvm/Support/system_error.h"
+#include <algorithm>
+
+using namespace clang;
+using namespace CodeGen;
+
+/// takeLine - Remove the first line from \p Data and return it.
+static StringRef takeLine(StringRef &Data) {
+  std::pair<StringRef, StringRef> Split = Data.split('\n');
+  Data = Split.second;
+  return Split.first;
+}
+
+bool PGOProfileData::read(StringRef Path, std::string &Error) {
+  OwningPtr<llvm::MemoryBuffer> Buffer;
+  if (llvm::error_code EC = llvm::MemoryBuffer::getFile(Path, Buffer)) {
+    Error = EC.message();
+    return true;
+  }
+
+  StringRef Data = Buffer->getBuffer();
+  while (!Data.empty()) {
+    StringRef Name = takeLine(Data);
+    if (Name.empty())
+      continue;
+
+    unsigned NumCounters;
+    if (takeLine(Data).getAsInteger(10, NumCounters) || NumCounters == 0) {
+      Error = ("invalid number of counters for '" + Name + "'").str();
+      return true;
+    }
+
+    std::vector<uint64_t> &Counts = FunctionCounts[Name];
+    if (!Counts.empty() && Counts.size() != NumCounters) {
+      Error = ("conflicting numbers of counters for '" + Name + "'").str();
+      return true;
+    }
+    Counts.resize(NumCounters);
+
+    for (unsigned I = 0; I != NumCounters; ++I) {
+      uint64_t Count;
+      if (takeLine(Data).getAsInteger(10, Count)) {
+        Error = ("invalid count for '" + Name + "'").str();
+        return true;
+      }
+      Counts[I] += Count;
+    }
+    MaxFunctionCount = std::max(MaxFunctionCount, Counts[0]);
+  }
+  return false;
+}
+
+const std::vector<uint64_t> *
+PGOProfileData::getFunctionCounts(StringRef FuncName) const {
+  llvm::StringMap<std::vector<uint64_t> >::const_iterator I =
+    FunctionCounts.find(FuncName);
+  return I == FunctionCounts.end() ? 0 : &I->getValue();
+}
+
+namespace {
+/// MapRegionCounters - Assign counters to the regions of a function body, in
+/// the order in which they appear.
+class MapRegionCounters : public RecursiveASTVisitor<MapRegionCounters> {
+  llvm::DenseMap<const Stmt *, unsigned> &CounterMap;
+
+  void addRegion(const Stmt *S, unsigned NumCounters) {
+    CounterMap[S] = NextCounter;
+    NextCounter += NumCounters;
+  }
+
+public:
+  unsigned NextCounter;
+
+  explicit MapRegionCounters(llvm::DenseMap<const Stmt *, unsigned> &Map)
+    : CounterMap(Map), NextCounter(1) {}
+
+  // Blocks, lambdas and the members of local classes are emitted as functions
+  // of their own, with counters of their own.
+  bool TraverseBlockExpr(BlockExpr *) { return true; }
+  bool TraverseLambdaExpr(LambdaExpr *) { return true; }
+  bool TraverseDecl(Decl *D) {
+    if (D && (isa<FunctionDecl>(D) || isa<TagDecl>(D) || isa<BlockDecl>(D)))
+      return true;
+    return RecursiveASTVisitor<MapRegionCounters>::TraverseDecl(D);
+  }
+
+  bool VisitStmt(Stmt *S) {
+    switch (S->getStmtClass()) {
+    default:
+      break;
+    case Stmt::IfStmtClass:
+    case Stmt::WhileStmtClass:
+    case Stmt::DoStmtClass:
+    case Stmt::ForStmtClass:
+    case Stmt::CXXForRangeStmtClass:
+    case Stmt::ConditionalOperatorClass:
+      addRegion(S, 2);
+      break;
+    case Stmt::BinaryOperatorClass:
+      if (cast<BinaryOperator>(S)->isLogicalOp())
+        addRegion(S, 2);
+      break;
+    case Stmt::SwitchStmtClass:
+    case Stmt::CaseStmtClass:
+      addRegion(S, 1);
+      break;
+    }
+    return true;
+  }
+};
+}
+
+void CodeGenPGO::assignRegionCounters(const Decl *D, llvm::Function *Fn,
+                                      CGBuilderTy &Builder) {
+  bool InstrumentRegions = CGM.getCodeGenOpts().ProfileInstrGenerate;
+  PGOProfileData *PGOData = CGM.getPGOData();
+  if (!InstrumentRegions && !PGOData)
+    return;
+
+  // Functions with internal linkage in different translation units can have
+  // the same name, so also name the file they came from.
+  FuncName = Fn->getName();
+  const FunctionDecl *FD = dyn_cast<FunctionDecl>(D);
+  if (!FD || FD->getLinkage() != ExternalLinkage)
+    FuncName = CGM.getCodeGenOpts().MainFileName + ":" + FuncName;
+
+  MapRegionCounters Walker(RegionCounterMap);
+  if (Stmt *Body = D->getBody())
+    Walker.TraverseStmt(Body);
+  NumRegionCounters = Walker.NextCounter;
+
+  if (InstrumentRegions) {
+    llvm::ArrayType *CounterTy =
+      llvm::ArrayType::get(CGM.Int64Ty, NumRegionCounters);
+    RegionCounters =
+      new llvm::GlobalVariable(CGM.getModule(), CounterTy, false,
+                               llvm::GlobalVariable::InternalLinkage,
+                               llvm::Constant::getNullValue(CounterTy),
+                               "__llvm_pgo_ctr");
+    CGM.addPGOCounterArray(FuncName, RegionCounters);
+    emitCounterIncrement(Builder, 0);
+  }
+
+  if (PGOData) {
+    // The counts of a function whose regions changed since the profile was
+    // taken would be attributed to the wrong regions; ignore them.
+    RegionCounts = PGOData->getFunctionCounts(FuncName);
+    if (RegionCounts && RegionCounts->size() != NumRegionCounters)
+      RegionCounts = 0;
+    if (RegionCounts)
+      applyFunctionAttributes(Fn);
+  }
+}
+
+void CodeGenPGO::applyFunctionAttributes(llvm::Function *Fn) {
+  // Optimize the functions which the profile never entered for size, and
+  // suggest inlining the hottest ones.
+  uint64_t EntryCount = (*RegionCounts)[0];
+  uint64_t MaxCount = CGM.getPGOData()->getMaximumFunctionCount();
+  if (EntryCount == 0)
+    Fn->addFnAttr(llvm::Attribute::OptimizeForSize);
+  else if (EntryCount >= MaxCount / 10 * 3)
+    Fn->addFnAttr(llvm::Attribute::InlineHint);
+}
+
+void CodeGenPGO::emitCounterIncrement(CGBuilderTy &Builder, unsigned Counter) {
+  llvm::Value *Addr =
+    Builder.CreateConstInBoundsGEP2_64(RegionCounters, 0, Counter);
+  llvm::Value *Count = Builder.CreateLoad(Addr, "pgocount");
+  Count = Builder.CreateAdd(Count, Builder.getInt64(1));
+  Builder.CreateStore(Count, Addr);
+}
+
+llvm::BasicBlock *CodeGenPGO::countEdge(CodeGenFunction &CGF, const Stmt *S,
+                                        unsigned Edge,
+                                        llvm::BasicBlock *Dest) {
+  if (!RegionCounters)
+    return Dest;
+  llvm::DenseMap<const Stmt *, unsigned>::const_iterator I =
+    RegionCounterMap.find(S);
+  if (I == RegionCounterMap.end())
+    return Dest;
+
+  CGBuilderTy &Builder = CGF.Builder;
+  CGBuilderTy::InsertPoint SavedIP = Builder.saveIP();
+  llvm::BasicBlock *Block = CGF.createBasicBlock("pgo.count", CGF.CurFn);
+  Builder.SetInsertPoint(Block);
+  emitCounterIncrement(Builder, I->second + Edge);
+  Builder.CreateBr(Dest);
+  Builder.restoreIP(SavedIP);
+  return Block;
+}
+
+bool CodeGenPGO::getEdgeCount(const Stmt *S, unsigned Edge,
+                              uint64_t &Count) const {
+  if (!RegionCounts)
+    return false;
+  llvm::DenseMap<const Stmt *, unsigned>::const_iterator I =
+    RegionCounterMap.find(S);
+  if (I == RegionCounterMap.end())
+    return false;
+  Count = (*RegionCounts)[I->second + Edge];
+  return true;
+}
+
+llvm::MDNode *CodeGenPGO::getBranchWeights(const Stmt *S) const {
+  uint64_t Counts[2];
+  if (!getEdgeCount(S, 0, Counts[0]) || !getEdgeCount(S, 1, Counts[1]))
+    return 0;
+  return createBranchWeights(Counts);
+}
+
+llvm::MDNode *CodeGenPGO::createBranchWeights(ArrayRef<uint64_t> Counts) const {
+  // Branch weights are 32 bits wide. Scale the counts down to fit, and keep
+  // the weights of branches which were never taken nonzero.
+  uint64_t MaxCount = 0;
+  for (unsigned I = 0, N = Counts.size(); I != N; ++I)
+    MaxCount = std::max(MaxCount, Counts[I]);
+  uint64_t Scale = MaxCount / UINT32_MAX + 1;
+
+  SmallVector<uint32_t, 16> Weights;
+  for (unsigned I = 0, N = Counts.size(); I != N; ++I)
+    Weights.push_back(Counts[I] / Scale + 1);
+
+  llvm::MDBuilder MDHelper(CGM.getLLVMContext());
+  return MDHelper.createBranchWeights(Weights);
+}
+
+/// EmitPGOWriteout - Emit a function which passes the region counters of the
+/// instrumented functions to the profile runtime, and register it with the
+/// runtime when the program starts.
+void CodeGenModule::EmitPGOWriteout() {
+  if (PGOCounterArrays.empty())
+    return;
+
+  llvm::Type *EmitArgs[] = { Int8PtrTy, Int32Ty, Int64Ty->getPointerTo() };
+  llvm::FunctionType *EmitTy =
+    llvm::FunctionType::get(VoidTy, EmitArgs, false);
+  llvm::Constant *EmitFn = CreateRuntimeFunction(EmitTy, "llvm_pgo_emit");
+
+  llvm::FunctionType *VoidFnTy = llvm::FunctionType::get(VoidTy, false);
+  llvm::Function *Writeout =
+    llvm::Function::Create(VoidFnTy, llvm::GlobalValue::InternalLinkage,
+                           "__llvm_pgo_writeout", &TheModule);
+  Writeout->setUnnamedAddr(true);
+  CGBuilderTy Builder(llvm::BasicBlock::Create(VMContext, "", Writeout));
+
+  for (unsigned I = 0, N = PGOCounterArrays.size(); I != N; ++I) {
+    llvm::GlobalVariable *Counters = PGOCounterArrays[I].second;
+    uint64_t NumCounters =
+      cast<llvm::ArrayType>(Counters->getType()->getElementType())
+        ->getNumElements();
+    llvm::Value *Args[] = {
+      llvm::ConstantExpr::getBitCast(
+        GetAddrOfConstantCString(PGOCounterArrays[I].first), Int8PtrTy),
+      Builder.getInt32(NumCounters),
+      Builder.CreateConstInBoundsGEP2_64(Counters, 0, 0)
+    };
+    Builder.CreateCall(EmitFn, Args);
+  }
+  Builder.CreateRetVoid();
+
+  llvm::FunctionType *RegisterTy =
+    llvm::FunctionType::get(VoidTy, Writeout->getType(), false);
+  llvm::Constant *RegisterFn =
+    CreateRuntimeFunction(RegisterTy, "llvm_pgo_register_writeout_function");
+
+  llvm::Function *Init =
+    llvm::Function::Create(VoidFnTy, llvm::GlobalValue::InternalLinkage,
+                           "__llvm_pgo_init", &TheModule);
+  Init->setUnnamedAddr(true);
+  Builder.SetInsertPoint(llvm::BasicBlock::Create(VMContext, "", Init));
+  Builder.CreateCall(RegisterFn, Writeout);
+  Builder.CreateRetVoid();
+
+  AddGlobalCtor(Init, 0);
+}
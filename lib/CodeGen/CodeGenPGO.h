@@ -0,0 +1,126 @@
+//===--- CodeGenPGO.h - PGO instrumentation for LLVM CodeGen ----*- C++ -*-===//
+//
+//                     The LLVM Compiler Infrastructure
+//
+// This file is distributed under the University of Illinois Open Source
+// License. See LICENSE.TXT for details.
+//
+//===----------------------------------------------------------------------===//
+//
+// This is the code that instruments the regions of functions with counters
+// for -fprofile-instr-generate, and that turns the counts read back for
+// -fprofile-instr-use into branch weights.
+//
+//===----------------------------------------------------------------------===//
+
+#ifndef CLANG_CODEGEN_CODEGENPGO_H
+#define CLANG_CODEGEN_CODEGENPGO_H
+
+#include "CGBuilder.h"
+#include "clang/Basic/LLVM.h"
+#include "llvm/ADT/DenseMap.h"
+#include "llvm/ADT/StringMap.h"
+#include "llvm/Support/DataTypes.h"
+#include <string>
+#include <vector>
+
+namespace llvm {
+  class BasicBlock;
+  class Function;
+  class GlobalVariable;
+  class MDNode;
+}
+
+namespace clang {
+  class Decl;
+  class Stmt;
+
+namespace CodeGen {
+  class CodeGenFunction;
+  class CodeGenModule;
+
+/// PGOProfileData - The counts of a profile written by a program built with
+/// -fprofile-instr-generate.
+///
+/// The profile is a text file with one record per instrumented function: the
+/// name of the function, the number of its counters and each of the counts,
+/// all on lines of their own, followed by an empty line. The records of a
+/// function which appears several times, because it was emitted in several
+/// translation units, are summed.
+class PGOProfileData {
+  llvm::StringMap<std::vector<uint64_t> > FunctionCounts;
+  uint64_t MaxFunctionCount;
+
+public:
+  PGOProfileData() : MaxFunctionCount(0) {}
+
+  /// \brief Read the profile at \p Path.
+  ///
+  /// \returns true, and sets \p Error, if the profile could not be read.
+  bool read(StringRef Path, std::string &Error);
+
+  /// \brief The counts of the named function, or null if the profile does
+  /// not cover it.
+  const std::vector<uint64_t> *getFunctionCounts(StringRef FuncName) const;
+
+  /// \brief The largest number of times any function was entered.
+  uint64_t getMaximumFunctionCount() const { return MaxFunctionCount; }
+};
+
+/// CodeGenPGO - The region counters of the function being emitted.
+///
+/// Counter 0 counts the entries into the function. Each branch of the AST,
+/// that is each 'if', loop, '?:', '&&' and '||', has a pair of counters, the
+/// first for the times the condition was true and the second for the times
+/// it was false. A 'switch' has a counter for the times no case matched, and
+/// each 'case' a counter for the times the switch jumped to it. The counters
+/// are assigned in the order of the AST, so profiles survive changes that
+/// leave the control flow of a function alone.
+class CodeGenPGO {
+  CodeGenModule &CGM;
+  std::string FuncName;
+
+  /// RegionCounterMap - The first counter of each region.
+  llvm::DenseMap<const Stmt *, unsigned> RegionCounterMap;
+  unsigned NumRegionCounters;
+
+  /// RegionCounters - The counters, when instrumenting the function.
+  llvm::GlobalVariable *RegionCounters;
+
+  /// RegionCounts - The counts from the profile, when using one.
+  const std::vector<uint64_t> *RegionCounts;
+
+  void emitCounterIncrement(CGBuilderTy &Builder, unsigned Counter);
+  void applyFunctionAttributes(llvm::Function *Fn);
+
+public:
+  explicit CodeGenPGO(CodeGenModule &CGM)
+    : CGM(CGM), NumRegionCounters(0), RegionCounters(0), RegionCounts(0) {}
+
+  /// \brief Assign counters to the regions of the body of \p D, which is
+  /// being emitted as \p Fn, and count the entry into the function.
+  void assignRegionCounters(const Decl *D, llvm::Function *Fn,
+                            CGBuilderTy &Builder);
+
+  /// \brief Return a block which counts an edge of region \p S before
+  /// continuing to \p Dest, or \p Dest itself if \p S is not instrumented.
+  llvm::BasicBlock *countEdge(CodeGenFunction &CGF, const Stmt *S,
+                              unsigned Edge, llvm::BasicBlock *Dest);
+
+  /// \brief Get the count of an edge of region \p S from the profile.
+  ///
+  /// \returns false if the profile has no count for it.
+  bool getEdgeCount(const Stmt *S, unsigned Edge, uint64_t &Count) const;
+
+  /// \brief The branch weights of the two-way region \p S, or null without
+  /// a profile.
+  llvm::MDNode *getBranchWeights(const Stmt *S) const;
+
+  /// \brief Create branch weights from counts, scaling them to 32 bits.
+  llvm::MDNode *createBranchWeights(ArrayRef<uint64_t> Counts) const;
+};
+
+}  // end namespace CodeGen
+}  // end namespace clang
+
+#endif
@@ -57,6 +57,9 @@ namespace {
       TD.reset(new llvm::TargetData(Ctx->getTargetInfo().getTargetDescription()));
       Builder.reset(new CodeGen::CodeGenModule(Context, CodeGenOpts,
                                                *M, *TD, Diags));
+
+      if (CodeGenOpts.ReleaseFunctionBodies)
+        Context.setReleasableFunctionBodies(true);
     }
 
     virtual void HandleCXXStaticMemberVarInstantiation(VarDecl *VD) {
@@ -67,6 +70,17 @@ namespace {
       // Make sure to emit all elements of a Decl.
       for (DeclGroupRef::iterator I = DG.begin(), E = DG.end(); I != E; ++I)
         Builder->EmitTopLevelDecl(*I);
+
+      // Nothing needs the statements of a function which has been emitted,
+      // unless it is deferred or might be used by later declarations, as
+      // the ASTContext checks.
+      if (CodeGenOpts.ReleaseFunctionBodies && !Diags.hasErrorOccurred())
+        for (DeclGroupRef::iterator I = DG.begin(), E = DG.end(); I != E; ++I)
+          if (FunctionDecl *FD = dyn_cast<FunctionDecl>(*I))
+            if (FD->doesThisDeclarationHaveABody() &&
+                !isa<CXXConstructorDecl>(FD) && !isa<CXXDestructorDecl>(FD) &&
+                Builder->hasEmittedDefinition(FD))
+              Ctx->releaseFunctionBody(FD);
       return true;
     }
 
@@ -0,0 +1,93 @@
+//===--- VarBypassDetector.cpp - Bypass jumps detector --------------------===//
+//
+//                     The LLVM Compiler Infrastructure
+//
+// This file is distributed under the University of Illinois Open Source
+// License. See LICENSE.TXT for details.
+//
+//===----------------------------------------------------------------------===//
+
+#include "VarBypassDetector.h"
+#include "clang/AST/Decl.h"
+#include "clang/AST/Stmt.h"
+#include "clang/AST/StmtObjC.h"
+
+using namespace clang;
+using namespace CodeGen;
+
+void VarBypassDetector::init(const Decl *D) {
+  if (D == AnalyzedDecl)
+    return;
+  AnalyzedDecl = D;
+  Scope.clear();
+  Bypassed.clear();
+  if (const Stmt *Body = D ? D->getBody() : 0)
+    walk(Body, 0);
+}
+
+/// markBypassed - Mark the variables in scope from \p ScopeBegin on as
+/// bypassed by a jump to the current point of the walk.
+void VarBypassDetector::markBypassed(unsigned ScopeBegin) {
+  for (unsigned I = ScopeBegin, N = Scope.size(); I != N; ++I)
+    Bypassed[Scope[I]] = true;
+}
+
+/// walk - Walk \p S, whose innermost enclosing switch body started when the
+/// scope had \p SwitchScopeBegin variables.
+void VarBypassDetector::walk(const Stmt *S, unsigned SwitchScopeBegin) {
+  if (!S)
+    return;
+
+  switch (S->getStmtClass()) {
+  // Blocks and lambdas are emitted as functions of their own.
+  case Stmt::BlockExprClass:
+  case Stmt::LambdaExprClass:
+    return;
+
+  case Stmt::DeclStmtClass: {
+    // The variables stay in scope until the enclosing statement ends.
+    const DeclStmt *DS = cast<DeclStmt>(S);
+    for (DeclStmt::const_decl_iterator I = DS->decl_begin(),
+                                       E = DS->decl_end();
+         I != E; ++I) {
+      if (const VarDecl *VD = dyn_cast<VarDecl>(*I)) {
+        walk(VD->getInit(), SwitchScopeBegin);
+        if (VD->hasLocalStorage()) {
+          Scope.push_back(VD);
+          Bypassed.insert(std::make_pair(VD, false));
+        }
+      }
+    }
+    return;
+  }
+
+  case Stmt::LabelStmtClass:
+    markBypassed(0);
+    break;
+
+  case Stmt::CaseStmtClass:
+  case Stmt::DefaultStmtClass:
+    markBypassed(SwitchScopeBegin);
+    break;
+
+  default:
+    break;
+  }
+
+  const SwitchStmt *Switch = dyn_cast<SwitchStmt>(S);
+  unsigned ScopeSize = Scope.size();
+  for (Stmt::const_child_range I = S->children(); I; ++I) {
+    if (Switch && *I == Switch->getBody())
+      walk(*I, Scope.size());
+    else
+      walk(*I, SwitchScopeBegin);
+  }
+  Scope.resize(ScopeSize);
+
+  // The element variable of a for-in loop is allocated once, before the
+  // loop, but its cleanups run after every iteration.
+  if (const ObjCForCollectionStmt *ForIn = dyn_cast<ObjCForCollectionStmt>(S))
+    if (const DeclStmt *DS = dyn_cast<DeclStmt>(ForIn->getElement()))
+      if (const VarDecl *VD = dyn_cast<VarDecl>(DS->getSingleDecl()))
+        Bypassed[VD] = true;
+}
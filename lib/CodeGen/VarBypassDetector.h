@@ -0,0 +1,70 @@
+//===--- VarBypassDetector.h - Bypass jumps detector --------------*- C++ -*-=//
+//
+//                     The LLVM Compiler Infrastructure
+//
+// This file is distributed under the University of Illinois Open Source
+// License. See LICENSE.TXT for details.
+//
+//===----------------------------------------------------------------------===//
+//
+// This file finds the local variables whose declarations a jump may bypass,
+// which must not get lifetime markers.
+//
+//===----------------------------------------------------------------------===//
+
+#ifndef CLANG_CODEGEN_VARBYPASSDETECTOR_H
+#define CLANG_CODEGEN_VARBYPASSDETECTOR_H
+
+#include "clang/Basic/LLVM.h"
+#include "llvm/ADT/DenseMap.h"
+#include "llvm/ADT/SmallVector.h"
+
+namespace clang {
+  class Decl;
+  class Stmt;
+  class VarDecl;
+
+namespace CodeGen {
+
+/// VarBypassDetector - Finds the local variables of a function which a
+/// 'goto', or the jump of a 'switch' to one of its labels, may enter the
+/// scope of without passing their declaration.
+///
+/// The lifetime of such a variable does not start at its declaration, so it
+/// cannot be given an llvm.lifetime.start there: the optimizer would assume
+/// the variable dead on the paths which bypassed it. Any label is assumed to
+/// be the target of some jump, which is conservative but cheap.
+class VarBypassDetector {
+  /// Scope - The variables in scope at the current point of the walk.
+  SmallVector<const VarDecl *, 16> Scope;
+
+  /// Bypassed - For each variable seen in the body, whether a jump may
+  /// bypass its declaration.
+  llvm::DenseMap<const VarDecl *, bool> Bypassed;
+
+  /// AnalyzedDecl - The function, method or block whose body was walked.
+  const Decl *AnalyzedDecl;
+
+  void walk(const Stmt *S, unsigned SwitchScopeBegin);
+  void markBypassed(unsigned ScopeBegin);
+
+public:
+  VarBypassDetector() : AnalyzedDecl(0) {}
+
+  /// \brief Find the bypassed variables of the body of \p D, unless it was
+  /// the body walked last.
+  void init(const Decl *D);
+
+  /// \brief Whether \p D was declared in the walked body, and no jump may
+  /// bypass its declaration.
+  bool isSafe(const VarDecl *D) const {
+    llvm::DenseMap<const VarDecl *, bool>::const_iterator I =
+      Bypassed.find(D);
+    return I != Bypassed.end() && !I->second;
+  }
+};
+
+}  // end namespace CodeGen
+}  // end namespace clang
+
+#endif
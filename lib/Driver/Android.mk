@@ -18,6 +18,7 @@ clang_driver_SRC_FILES := \
   ArgList.cpp \
   CC1AsOptions.cpp \
   Compilation.cpp \
+  CompilationCache.cpp \
   Driver.cpp \
   DriverOptions.cpp \
   Job.cpp \
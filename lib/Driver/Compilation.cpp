@@ -9,14 +9,20 @@
 
 #include "clang/Driver/Compilation.h"
 
+#include "clang/Basic/Parallel.h"
 #include "clang/Driver/Action.h"
 #include "clang/Driver/ArgList.h"
+#include "clang/Driver/CompilationCache.h"
 #include "clang/Driver/Driver.h"
 #include "clang/Driver/DriverDiagnostic.h"
 #include "clang/Driver/Options.h"
+#include "clang/Driver/Tool.h"
 #include "clang/Driver/ToolChain.h"
 
 #include "llvm/ADT/STLExtras.h"
+#include "llvm/ADT/SmallPtrSet.h"
+#include "llvm/Support/CrashRecoveryContext.h"
+#include "llvm/Support/MemoryBuffer.h"
 #include "llvm/Support/raw_ostream.h"
 #include "llvm/Support/Program.h"
 #include <sys/stat.h>
@@ -137,14 +143,7 @@ bool Compilation::CleanupFileList(const ArgStringList &Files,
   return Success;
 }
 
-int Compilation::ExecuteCommand(const Command &C,
-                                const Command *&FailingCommand) const {
-  llvm::sys::Path Prog(C.getExecutable());
-  const char **Argv = new const char*[C.getArguments().size() + 2];
-  Argv[0] = C.getExecutable();
-  std::copy(C.getArguments().begin(), C.getArguments().end(), Argv+1);
-  Argv[C.getArguments().size() + 1] = 0;
-
+bool Compilation::PrintCommandIfRequested(const Command &C) const {
   if ((getDriver().CCCEcho || getDriver().CCPrintOptions ||
        getArgs().hasArg(options::OPT_v)) && !getDriver().CCGenDiagnostics) {
     raw_ostream *OS = &llvm::errs();
@@ -159,9 +158,8 @@ int Compilation::ExecuteCommand(const Command &C,
       if (!Error.empty()) {
         getDriver().Diag(clang::diag::err_drv_cc_print_options_failure)
           << Error;
-        FailingCommand = &C;
         delete OS;
-        return 1;
+        return false;
       }
     }
 
@@ -173,13 +171,99 @@ int Compilation::ExecuteCommand(const Command &C,
     if (OS != &llvm::errs())
       delete OS;
   }
+  return true;
+}
+
+/// \brief Run the given command and wait for it to finish.
+///
+/// This does not touch the driver, so it may be called from several threads
+/// at once.
+static int RunCommand(const char *Executable, const ArgStringList &Args,
+                      const llvm::sys::Path **Redirects, std::string &Error) {
+  llvm::sys::Path Prog(Executable);
+  const char **Argv = new const char*[Args.size() + 2];
+  Argv[0] = Executable;
+  std::copy(Args.begin(), Args.end(), Argv+1);
+  Argv[Args.size() + 1] = 0;
 
-  std::string Error;
   int Res =
     llvm::sys::Program::ExecuteAndWait(Prog, Argv,
                                        /*env*/0, Redirects,
                                        /*secondsToWait*/0, /*memoryLimit*/0,
                                        &Error);
+  delete[] Argv;
+  return Res;
+}
+
+namespace {
+struct IntegratedCC1Info {
+  Driver::CC1MainFn CC1Main;
+  const Command *Cmd;
+  int Res;
+};
+}
+
+static void RunIntegratedCC1(void *UserData) {
+  IntegratedCC1Info &Info = *static_cast<IntegratedCC1Info*>(UserData);
+  const ArgStringList &Args = Info.Cmd->getArguments();
+  // Skip the leading "-cc1".
+  const char **ArgBegin = const_cast<const char **>(Args.data()) + 1;
+  Info.Res = Info.CC1Main(ArgBegin, ArgBegin + Args.size() - 1,
+                          Info.Cmd->getExecutable());
+}
+
+/// \brief Whether the command is a "clang -cc1" invocation of the driver's own
+/// executable, which CC1Main can run in process.
+///
+/// Commands with -mllvm options are not: those set LLVM's global command line
+/// options, which would stay set for the following commands.
+static bool IsIntegratedCC1Command(const Driver &D, const Command &C) {
+  const ArgStringList &Args = C.getArguments();
+  if (StringRef(C.getCreator().getName()) != "clang" || Args.empty() ||
+      StringRef(Args[0]) != "-cc1" ||
+      StringRef(C.getExecutable()) != D.getClangProgramPath())
+    return false;
+  for (unsigned I = 1, E = Args.size(); I != E; ++I)
+    if (StringRef(Args[I]) == "-mllvm")
+      return false;
+  return true;
+}
+
+int Compilation::ExecuteCommand(const Command &C,
+                                const Command *&FailingCommand) const {
+  if (!PrintCommandIfRequested(C)) {
+    FailingCommand = &C;
+    return 1;
+  }
+
+  // Reuse the result of an earlier run of a compilation if it is cached.
+  const Driver &D = getDriver();
+  const char *OutputFile;
+  if (D.getCompilationCacheStorage() && !Redirects &&
+      CompilationCache::isCacheable(C, OutputFile)) {
+    CompilationCache Cache(*D.getCompilationCacheStorage());
+    std::string ManifestKey;
+    if (Cache.getManifestKey(C, ManifestKey))
+      return ExecuteCachedCommand(C, Cache, ManifestKey, OutputFile,
+                                  FailingCommand);
+  }
+
+  // Run the compiler in process if requested, unless the output has to be
+  // redirected. A crash is reported like a signalled process.
+  if (D.CCCUseIntegratedCC1 && D.CC1Main && !Redirects &&
+      IsIntegratedCC1Command(D, C)) {
+    IntegratedCC1Info Info = { D.CC1Main, &C, 1 };
+    llvm::CrashRecoveryContext::Enable();
+    llvm::CrashRecoveryContext CRC;
+    if (!CRC.RunSafely(RunIntegratedCC1, &Info))
+      Info.Res = -1;
+    if (Info.Res)
+      FailingCommand = &C;
+    return Info.Res;
+  }
+
+  std::string Error;
+  int Res = RunCommand(C.getExecutable(), C.getArguments(), Redirects, Error);
   if (!Error.empty()) {
     assert(Res && "Error string set with 0 result code!");
     getDriver().Diag(clang::diag::err_drv_command_failure) << Error;
@@ -188,7 +272,46 @@ int Compilation::ExecuteCommand(const Command &C,
   if (Res)
     FailingCommand = &C;
 
-  delete[] Argv;
+  return Res;
+}
+
+int Compilation::ExecuteCachedCommand(const Command &C, CompilationCache &Cache,
+                                      StringRef ManifestKey,
+                                      const char *OutputFile,
+                                      const Command *&FailingCommand) const {
+  std::string Diagnostics;
+  if (Cache.restore(ManifestKey, OutputFile, Diagnostics)) {
+    llvm::errs() << Diagnostics;
+    return 0;
+  }
+
+  // Run the command out of process, collecting the files it reads and the
+  // diagnostics it prints, which are replayed on later hits.
+  const Driver &D = getDriver();
+  std::string DependencyFile = D.GetTemporaryPath("deps", "d");
+  llvm::sys::Path StderrFile(D.GetTemporaryPath("stderr", "txt"));
+  ArgStringList Args(C.getArguments());
+  CompilationCache::addDependencyOutput(Args, DependencyFile.c_str());
+  const llvm::sys::Path *CacheRedirects[3] = { 0, 0, &StderrFile };
+
+  std::string Error;
+  int Res = RunCommand(C.getExecutable(), Args, CacheRedirects, Error);
+  OwningPtr<llvm::MemoryBuffer> Output;
+  if (!llvm::MemoryBuffer::getFile(StderrFile.str(), Output)) {
+    Diagnostics = Output->getBuffer();
+    llvm::errs() << Diagnostics;
+  }
+  StderrFile.eraseFromDisk(false, 0);
+  if (!Error.empty()) {
+    assert(Res && "Error string set with 0 result code!");
+    D.Diag(clang::diag::err_drv_command_failure) << Error;
+  }
+
+  if (Res)
+    FailingCommand = &C;
+  else
+    Cache.store(ManifestKey, OutputFile, DependencyFile, Diagnostics);
+  llvm::sys::Path(DependencyFile).eraseFromDisk(false, 0);
   return Res;
 }
 
@@ -206,6 +329,134 @@ int Compilation::ExecuteJob(const Job &J,
   }
 }
 
+static void CollectCommands(const Job &J,
+                            SmallVectorImpl<const Command *> &Commands) {
+  if (const Command *C = dyn_cast<Command>(&J)) {
+    Commands.push_back(C);
+    return;
+  }
+
+  const JobList *Jobs = cast<JobList>(&J);
+  for (JobList::const_iterator
+         it = Jobs->begin(), ie = Jobs->end(); it != ie; ++it)
+    CollectCommands(**it, Commands);
+}
+
+static void CollectInputActions(const Action *A,
+                                llvm::SmallPtrSet<const Action *, 16> &Inputs) {
+  for (Action::const_iterator it = A->begin(), ie = A->end(); it != ie; ++it)
+    if (Inputs.insert(*it))
+      CollectInputActions(*it, Inputs);
+}
+
+namespace {
+/// \brief A command run by Compilation::ExecuteJobsInParallel.
+struct ParallelCommand {
+  const Command *Cmd;
+  /// \brief The file receiving the stderr output of the command, or empty if
+  /// its output is not captured.
+  llvm::sys::Path StderrFile;
+  std::string Error;
+  int Result;
+};
+}
+
+static void RunParallelCommand(void *UserData, unsigned Index) {
+  ParallelCommand &PC = static_cast<ParallelCommand *>(UserData)[Index];
+  const llvm::sys::Path *Redirects[3] = {
+    0, 0, PC.StderrFile.isEmpty() ? 0 : &PC.StderrFile
+  };
+  PC.Result = RunCommand(PC.Cmd->getExecutable(), PC.Cmd->getArguments(),
+                         Redirects, PC.Error);
+}
+
+int Compilation::ExecuteJobsInParallel(const JobList &Jobs, unsigned NumJobs,
+                                       const Command *&FailingCommand) const {
+  // Redirected compilations (e.g., when generating crash diagnostics) are
+  // always run serially, and so are cached ones, whose diagnostics are
+  // captured for the cache already.
+  if (Redirects || NumJobs == 1 || !isParallelExecutionSupported() ||
+      getDriver().getCompilationCacheStorage())
+    return ExecuteJob(Jobs, FailingCommand);
+
+  SmallVector<const Command *, 16> Commands;
+  CollectCommands(Jobs, Commands);
+
+  // Assign every command to a level, such that it only consumes the outputs of
+  // commands on lower levels. The commands are in dependency order already, so
+  // only earlier commands need to be considered. An earlier command producing
+  // a PCH is treated as a dependency of everything after it, since inputs can
+  // use it without the action graph knowing.
+  SmallVector<unsigned, 16> Levels(Commands.size());
+  unsigned NumLevels = 0;
+  for (unsigned i = 0, e = Commands.size(); i != e; ++i) {
+    llvm::SmallPtrSet<const Action *, 16> Inputs;
+    CollectInputActions(&Commands[i]->getSource(), Inputs);
+
+    unsigned Level = 0;
+    for (unsigned j = 0; j != i; ++j) {
+      const Action &Source = Commands[j]->getSource();
+      if (Inputs.count(&Source) || Source.getType() == types::TY_PCH)
+        Level = std::max(Level, Levels[j] + 1);
+    }
+    Levels[i] = Level;
+    NumLevels = std::max(NumLevels, Level + 1);
+  }
+
+  for (unsigned Level = 0; Level != NumLevels; ++Level) {
+    SmallVector<ParallelCommand, 16> Batch;
+    for (unsigned i = 0, e = Commands.size(); i != e; ++i) {
+      if (Levels[i] != Level)
+        continue;
+      Batch.push_back(ParallelCommand());
+      Batch.back().Cmd = Commands[i];
+      Batch.back().Result = 0;
+    }
+
+    // Print the commands and set up the capture of their diagnostics in
+    // order, before any of them runs. A single command just writes to stderr.
+    for (unsigned i = 0, e = Batch.size(); i != e; ++i) {
+      if (!PrintCommandIfRequested(*Batch[i].Cmd)) {
+        FailingCommand = Batch[i].Cmd;
+        return 1;
+      }
+      if (e > 1)
+        Batch[i].StderrFile = getDriver().GetTemporaryPath("stderr", "txt");
+    }
+
+    runTasksInParallel(NumJobs, Batch.size(), RunParallelCommand,
+                       Batch.data());
+
+    // Replay the diagnostics in command order, so that the output does not
+    // depend on scheduling, and report the first failure.
+    int Res = 0;
+    for (unsigned i = 0, e = Batch.size(); i != e; ++i) {
+      ParallelCommand &PC = Batch[i];
+      if (!PC.StderrFile.isEmpty()) {
+        OwningPtr<llvm::MemoryBuffer> Output;
+        if (!llvm::MemoryBuffer::getFile(PC.StderrFile.str(), Output))
+          llvm::errs() << Output->getBuffer();
+        PC.StderrFile.eraseFromDisk(false, 0);
+      }
+      if (!PC.Error.empty()) {
+        assert(PC.Result && "Error string set with 0 result code!");
+        getDriver().Diag(clang::diag::err_drv_command_failure) << PC.Error;
+      }
+      if (PC.Result && !Res) {
+        Res = PC.Result;
+        FailingCommand = PC.Cmd;
+      }
+    }
+    llvm::errs().flush();
+
+    // Don't start the next level once a command failed; the other commands of
+    // this level were already running and have been allowed to finish.
+    if (Res)
+      return Res;
+  }
+  return 0;
+}
+
 void Compilation::initCompilationForDiagnostics(void) {
   // Free actions and jobs.
   DeleteContainerPointers(Actions);
@@ -0,0 +1,363 @@
+//===--- CompilationCache.cpp - Cache of compiler outputs -----------------===//
+//
+//                     The LLVM Compiler Infrastructure
+//
+// This file is distributed under the University of Illinois Open Source
+// License. See LICENSE.TXT for details.
+//
+//===----------------------------------------------------------------------===//
+
+#include "clang/Driver/CompilationCache.h"
+
+#include "clang/Basic/Version.h"
+#include "clang/Driver/Job.h"
+
+#include "llvm/ADT/OwningPtr.h"
+#include "llvm/ADT/SmallString.h"
+#include "llvm/ADT/StringExtras.h"
+#include "llvm/Support/FileSystem.h"
+#include "llvm/Support/MemoryBuffer.h"
+#include "llvm/Support/Path.h"
+#include "llvm/Support/raw_ostream.h"
+#include "llvm/Support/system_error.h"
+
+using namespace clang::driver;
+using namespace clang;
+
+/// \brief The first line of every manifest, which also versions the format.
+static const char ManifestMagic[] = "clang-compilation-manifest 1\n";
+
+/// \brief The first line of every result.
+static const char ResultMagic[] = "clang-compilation-result 1\n";
+
+CompilationCacheStorage::~CompilationCacheStorage() {}
+
+LocalCompilationCacheStorage::LocalCompilationCacheStorage(StringRef Directory)
+  : Directory(Directory) {
+  bool Existed;
+  llvm::sys::fs::create_directories(Directory, Existed);
+}
+
+bool LocalCompilationCacheStorage::get(StringRef Key, std::string &Data) {
+  SmallString<128> Path(Directory);
+  llvm::sys::path::append(Path, Key);
+  OwningPtr<llvm::MemoryBuffer> Buffer;
+  if (llvm::MemoryBuffer::getFile(Path.str(), Buffer))
+    return false;
+  Data = Buffer->getBuffer();
+  return true;
+}
+
+void LocalCompilationCacheStorage::put(StringRef Key, StringRef Data) {
+  SmallString<128> Path(Directory);
+  llvm::sys::path::append(Path, Key);
+
+  // Write the entry to a temporary file and rename it into place, so that
+  // concurrent drivers only ever read complete entries.
+  llvm::sys::Path TempPath(Path.str());
+  TempPath.appendSuffix("tmp");
+  if (TempPath.makeUnique(/*reuse_current=*/false, 0))
+    return;
+
+  std::string ErrorInfo;
+  {
+    llvm::raw_fd_ostream Out(TempPath.c_str(), ErrorInfo,
+                             llvm::raw_fd_ostream::F_Binary);
+    if (!ErrorInfo.empty())
+      return;
+    Out << Data;
+    Out.close();
+    if (Out.has_error()) {
+      Out.clear_error();
+      ErrorInfo = "write error";
+    }
+  }
+
+  bool Existed;
+  if (!ErrorInfo.empty() || llvm::sys::fs::rename(TempPath.str(), Path.str()))
+    llvm::sys::fs::remove(TempPath.str(), Existed);
+}
+
+namespace {
+/// \brief A 64-bit FNV-1a hash.
+class Hasher {
+  uint64_t Hash;
+
+public:
+  Hasher() : Hash(14695981039346656037ULL) {}
+
+  /// \brief Add \p Data, followed by a separator so that consecutive strings
+  /// cannot run into each other.
+  void add(StringRef Data) {
+    for (unsigned I = 0, N = Data.size(); I != N; ++I) {
+      Hash ^= static_cast<unsigned char>(Data[I]);
+      Hash *= 1099511628211ULL;
+    }
+    Hash ^= 0xFF;
+    Hash *= 1099511628211ULL;
+  }
+
+  std::string getHex() const {
+    std::string Result = llvm::utohexstr(Hash);
+    return std::string(16 - Result.size(), '0') + Result;
+  }
+};
+}
+
+/// \brief Hash the contents of the file at \p Path.
+///
+/// \return false if the file could not be read.
+static bool hashFile(StringRef Path, uint64_t &Size, std::string &Hash) {
+  OwningPtr<llvm::MemoryBuffer> Buffer;
+  if (llvm::MemoryBuffer::getFile(Path, Buffer))
+    return false;
+  Hasher H;
+  H.add(Buffer->getBuffer());
+  Size = Buffer->getBufferSize();
+  Hash = H.getHex();
+  return true;
+}
+
+/// \brief Find the main input of a "clang -cc1" command, which follows the
+/// last "-x <language>".
+static const char *getMainInput(const ArgStringList &Args) {
+  for (unsigned i = Args.size(); i >= 3; --i)
+    if (StringRef(Args[i - 3]) == "-x")
+      return Args[i - 1];
+  return 0;
+}
+
+bool CompilationCache::isCacheable(const Command &C, const char *&OutputFile) {
+  const ArgStringList &Args = C.getArguments();
+  if (Args.empty() || StringRef(Args[0]) != "-cc1")
+    return false;
+
+  // Only compilations to an object file are cached, and not those which
+  // write other files, or read files a dependency file does not list.
+  bool EmitsObject = false;
+  OutputFile = 0;
+  for (unsigned i = 1, e = Args.size(); i != e; ++i) {
+    StringRef Arg = Args[i];
+    if (Arg == "-emit-obj")
+      EmitsObject = true;
+    else if (Arg == "-o" && i + 1 != e)
+      OutputFile = Args[++i];
+    else if (Arg == "-dependency-file" || Arg == "-header-include-file" ||
+             Arg == "-serialize-diagnostic-file" ||
+             Arg == "-diagnostic-log-file" ||
+             Arg == "-dump-build-information" || Arg == "-include-pch" ||
+             Arg == "-fmodules" || Arg == "-mlink-bitcode-file" ||
+             Arg.startswith("-fprofile-instr-use="))
+      return false;
+  }
+
+  const char *Input = getMainInput(Args);
+  return EmitsObject && OutputFile && StringRef(OutputFile) != "-" &&
+         Input && StringRef(Input) != "-";
+}
+
+bool CompilationCache::getManifestKey(const Command &C,
+                                      std::string &Key) const {
+  const ArgStringList &Args = C.getArguments();
+  uint64_t InputSize;
+  std::string InputHash;
+  if (!hashFile(getMainInput(Args), InputSize, InputHash))
+    return false;
+
+  // The output file is left out, since the driver picks a new temporary one
+  // whenever it links the object file itself. The working directory is part
+  // of the debug information.
+  SmallString<128> WorkingDir;
+  llvm::sys::fs::current_path(WorkingDir);
+
+  Hasher H;
+  H.add("manifest");
+  H.add(getClangFullVersion());
+  H.add(C.getExecutable());
+  H.add(WorkingDir.str());
+  for (unsigned i = 0, e = Args.size(); i != e; ++i) {
+    if (StringRef(Args[i]) == "-o" && i + 1 != e) {
+      ++i;
+      continue;
+    }
+    H.add(Args[i]);
+  }
+  H.add(InputHash);
+  Key = H.getHex();
+  return true;
+}
+
+namespace {
+/// \brief Reads the length-prefixed byte strings of a result.
+class ResultReader {
+  StringRef Data;
+  bool Failed;
+
+public:
+  explicit ResultReader(StringRef Data) : Data(Data), Failed(false) {}
+
+  bool failed() const { return Failed; }
+
+  bool consume(StringRef Expected) {
+    if (!Data.startswith(Expected))
+      return !(Failed = true);
+    Data = Data.substr(Expected.size());
+    return true;
+  }
+
+  StringRef readBytes() {
+    size_t End = Data.find('\n');
+    unsigned long long Length;
+    if (End == StringRef::npos || Data.substr(0, End).getAsInteger(10, Length)
+        || Length > Data.size() - End - 1) {
+      Failed = true;
+      return StringRef();
+    }
+    StringRef Result = Data.substr(End + 1, Length);
+    Data = Data.substr(End + 1 + Length);
+    return Result;
+  }
+};
+}
+
+bool CompilationCache::restore(StringRef ManifestKey, StringRef OutputFile,
+                               std::string &Diagnostics) {
+  std::string Manifest;
+  if (!Storage.get(ManifestKey, Manifest) ||
+      !StringRef(Manifest).startswith(ManifestMagic))
+    return false;
+
+  // Every line but the last names a dependency, as "dep <size> <hash> <path>",
+  // and the last the result, as "result <key>".
+  StringRef Lines = StringRef(Manifest).substr(sizeof(ManifestMagic) - 1);
+  std::string ResultKey;
+  while (!Lines.empty()) {
+    std::pair<StringRef, StringRef> Split = Lines.split('\n');
+    StringRef Line = Split.first;
+    Lines = Split.second;
+
+    if (Line.startswith("result ")) {
+      ResultKey = Line.substr(7);
+      break;
+    }
+    if (!Line.startswith("dep "))
+      return false;
+
+    SmallVector<StringRef, 4> Fields;
+    Line.split(Fields, " ", /*MaxSplit=*/3);
+    uint64_t ExpectedSize;
+    if (Fields.size() != 4 || Fields[1].getAsInteger(10, ExpectedSize))
+      return false;
+    uint64_t Size;
+    std::string Hash;
+    if (!hashFile(Fields[3], Size, Hash) || Size != ExpectedSize ||
+        Hash != Fields[2])
+      return false;
+  }
+
+  std::string Result;
+  if (ResultKey.empty() || !Storage.get(ResultKey, Result))
+    return false;
+  ResultReader Reader(Result);
+  Reader.consume(ResultMagic);
+  StringRef CachedDiagnostics = Reader.readBytes();
+  StringRef Object = Reader.readBytes();
+  if (Reader.failed())
+    return false;
+
+  std::string ErrorInfo;
+  llvm::raw_fd_ostream Out(OutputFile.str().c_str(), ErrorInfo,
+                           llvm::raw_fd_ostream::F_Binary);
+  if (!ErrorInfo.empty())
+    return false;
+  Out << Object;
+  Out.close();
+  if (Out.has_error()) {
+    Out.clear_error();
+    return false;
+  }
+
+  Diagnostics = CachedDiagnostics;
+  return true;
+}
+
+void CompilationCache::addDependencyOutput(ArgStringList &Args,
+                                           const char *DependencyFile) {
+  Args.push_back("-dependency-file");
+  Args.push_back(DependencyFile);
+  Args.push_back("-MT");
+  Args.push_back("cached");
+  Args.push_back("-sys-header-deps");
+}
+
+/// \brief Parse the dependencies of the single rule of a dependency file.
+static void parseDependencyFile(StringRef Data,
+                                SmallVectorImpl<std::string> &Files) {
+  size_t Colon = Data.find(": ");
+  if (Colon == StringRef::npos)
+    return;
+  Data = Data.substr(Colon + 2);
+
+  // Escaped newlines separate the files; escaped spaces are part of them.
+  std::string File;
+  for (unsigned i = 0, e = Data.size(); i != e; ++i) {
+    char Ch = Data[i];
+    if (Ch == '\\' && i + 1 != e && (Data[i + 1] == ' ' ||
+                                     Data[i + 1] == '\n')) {
+      if (Data[++i] == ' ') {
+        File += ' ';
+        continue;
+      }
+      Ch = '\n';
+    }
+    if (Ch != ' ' && Ch != '\n') {
+      File += Ch;
+      continue;
+    }
+    if (!File.empty())
+      Files.push_back(File);
+    File.clear();
+  }
+  if (!File.empty())
+    Files.push_back(File);
+}
+
+void CompilationCache::store(StringRef ManifestKey, StringRef OutputFile,
+                             StringRef DependencyFile,
+                             StringRef Diagnostics) {
+  OwningPtr<llvm::MemoryBuffer> Deps, Object;
+  if (llvm::MemoryBuffer::getFile(DependencyFile, Deps) ||
+      llvm::MemoryBuffer::getFile(OutputFile, Object))
+    return;
+  SmallVector<std::string, 64> Files;
+  parseDependencyFile(Deps->getBuffer(), Files);
+  if (Files.empty())
+    return;
+
+  std::string Manifest = ManifestMagic;
+  llvm::raw_string_ostream ManifestOS(Manifest);
+  Hasher ResultHash;
+  ResultHash.add("result");
+  ResultHash.add(ManifestKey);
+  for (unsigned i = 0, e = Files.size(); i != e; ++i) {
+    uint64_t Size;
+    std::string Hash;
+    if (!hashFile(Files[i], Size, Hash))
+      return;
+    ManifestOS << "dep " << Size << ' ' << Hash << ' ' << Files[i] << '\n';
+    ResultHash.add(Hash);
+  }
+  std::string ResultKey = ResultHash.getHex();
+  ManifestOS << "result " << ResultKey << '\n';
+  ManifestOS.flush();
+
+  std::string Result = ResultMagic;
+  llvm::raw_string_ostream ResultOS(Result);
+  ResultOS << Diagnostics.size() << '\n' << Diagnostics;
+  ResultOS << Object->getBufferSize() << '\n' << Object->getBuffer();
+  ResultOS.flush();
+
+  // Store the result first, so that a manifest never names a missing one.
+  Storage.put(ResultKey, Result);
+  Storage.put(ManifestKey, Manifest);
+}
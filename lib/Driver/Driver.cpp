@@ -13,6 +13,7 @@
 #include "clang/Driver/Arg.h"
 #include "clang/Driver/ArgList.h"
 #include "clang/Driver/Compilation.h"
+#include "clang/Driver/CompilationCache.h"
 #include "clang/Driver/DriverDiagnostic.h"
 #include "clang/Driver/Job.h"
 #include "clang/Driver/OptTable.h"
@@ -57,9 +58,12 @@ Driver::Driver(StringRef ClangExecutable,
     CCLogDiagnosticsFilename(0), CCCIsCXX(false),
     CCCIsCPP(false),CCCEcho(false), CCCPrintBindings(false),
     CCPrintOptions(false), CCPrintHeaders(false), CCLogDiagnostics(false),
-    CCGenDiagnostics(false), CCCGenericGCCName(""), CheckInputsExist(true),
+    CCGenDiagnostics(false), CCCNumJobs(1), CCCUseIntegratedCC1(false),
+    CC1Main(0), CCCGenericGCCName(""),
+    CheckInputsExist(true),
     CCCUseClang(true), CCCUseClangCXX(true), CCCUseClangCPP(true),
-    ForcedClangUse(false), CCCUsePCH(true), SuppressMissingInputWarning(false) {
+    ForcedClangUse(false), CCCUsePCH(true), SuppressMissingInputWarning(false),
+    CacheStorage(0) {
   if (IsProduction) {
     // In a "production" build, only use clang on architectures we expect to
     // work.
@@ -87,6 +91,7 @@ Driver::Driver(StringRef ClangExecutable,
 
 Driver::~Driver() {
   delete Opts;
+  delete CacheStorage;
 
   for (llvm::StringMap<ToolChain *>::iterator I = ToolChains.begin(),
                                               E = ToolChains.end();
@@ -94,6 +99,11 @@ Driver::~Driver() {
     delete I->second;
 }
 
+void Driver::setCompilationCacheStorage(CompilationCacheStorage *Storage) {
+  delete CacheStorage;
+  CacheStorage = Storage;
+}
+
 InputArgList *Driver::ParseArgStrings(ArrayRef<const char *> ArgList) {
   llvm::PrettyStackTraceString CrashInfo("Command line argument parsing");
   unsigned MissingArgIndex, MissingArgCount;
@@ -284,6 +294,20 @@ Compilation *Driver::BuildCompilation(ArrayRef<const char *> ArgList) {
   CCCPrintBindings = Args->hasArg(options::OPT_ccc_print_bindings);
   CCCIsCXX = Args->hasArg(options::OPT_ccc_cxx) || CCCIsCXX;
   CCCEcho = Args->hasArg(options::OPT_ccc_echo);
+  if (const Arg *A = Args->getLastArg(options::OPT_ccc_jobs)) {
+    StringRef Value = A->getValue(*Args);
+    if (Value.getAsInteger(10, CCCNumJobs)) {
+      Diag(clang::diag::err_drv_invalid_int_value)
+        << A->getAsString(*Args) << Value;
+      CCCNumJobs = 1;
+    }
+  }
+  if (const Arg *A = Args->getLastArg(options::OPT_ccc_cache_dir))
+    setCompilationCacheStorage(
+      new LocalCompilationCacheStorage(A->getValue(*Args)));
+  CCCUseIntegratedCC1 = Args->hasFlag(options::OPT_integrated_cc1,
+                                      options::OPT_no_integrated_cc1,
+                                      CCCUseIntegratedCC1);
   if (const Arg *A = Args->getLastArg(options::OPT_ccc_gcc_name))
     CCCGenericGCCName = A->getValue(*Args);
   CCCUseClangCXX = Args->hasFlag(options::OPT_ccc_clang_cxx,
@@ -593,7 +617,9 @@ int Driver::ExecuteCompilation(const Compilation &C,
   if (Diags.hasErrorOccurred())
     return 1;
 
-  int Res = C.ExecuteJob(C.getJobs(), FailingCommand);
+  int Res = CCCNumJobs == 1 ?
+    C.ExecuteJob(C.getJobs(), FailingCommand) :
+    C.ExecuteJobsInParallel(C.getJobs(), CCCNumJobs, FailingCommand);
 
   // Remove temp files.
   C.CleanupFileList(C.getTempFiles());
@@ -14,6 +14,7 @@
 #include "llvm/Support/raw_ostream.h"
 #include "llvm/Support/ErrorHandling.h"
 #include <algorithm>
+#include <functional>
 #include <map>
 using namespace clang::driver;
 using namespace clang::driver::options;
@@ -60,14 +61,6 @@ static inline bool operator<(const OptTable::Info &A, const OptTable::Info &B) {
          "Unexpected classes for options with same name.");
   return B.Kind == Option::JoinedClass;
 }
-
-// Support lower_bound between info and an option name.
-static inline bool operator<(const OptTable::Info &I, const char *Name) {
-  return StrCmpOptionName(I.Name, Name) == -1;
-}
-static inline bool operator<(const char *Name, const OptTable::Info &I) {
-  return StrCmpOptionName(Name, I.Name) == -1;
-}
 }
 }
 
@@ -102,6 +95,15 @@ OptTable::OptTable(const Info *_OptionInfos, unsigned _NumOptionInfos)
   }
   assert(FirstSearchableIndex != 0 && "No searchable options?");
 
+  for (unsigned i = FirstSearchableIndex, e = getNumOptions(); i != e; ++i) {
+    StringRef Name = getInfo(i + 1).Name;
+    FirstOptionOfName.GetOrCreateValue(Name, i);
+    if (std::find(NameLengths.begin(), NameLengths.end(), Name.size()) ==
+        NameLengths.end())
+      NameLengths.push_back(Name.size());
+  }
+  std::sort(NameLengths.begin(), NameLengths.end(), std::greater<unsigned>());
+
 #ifndef NDEBUG
   // Check that everything after the first searchable option is a
   // regular option class.
@@ -151,35 +153,30 @@ Arg *OptTable::ParseOneArg(const ArgList &Args, unsigned &Index) const {
   if (Str[0] != '-' || Str[1] == '\0')
     return new Arg(TheInputOption, Index++, Str);
 
-  const Info *Start = OptionInfos + FirstSearchableIndex;
-  const Info *End = OptionInfos + getNumOptions();
-
-  // Search for the first next option which could be a prefix.
-  Start = std::lower_bound(Start, End, Str);
+  // Only the options whose names prefix the string can accept it. Try them
+  // from the longest name to the shortest, and those of the same name in
+  // table order, as a scan of the sorted table would.
+  size_t Length = strlen(Str);
+  for (unsigned l = 0, le = NameLengths.size(); l != le; ++l) {
+    if (NameLengths[l] > Length)
+      continue;
 
-  // Options are stored in sorted order, with '\0' at the end of the
-  // alphabet. Since the only options which can accept a string must
-  // prefix it, we iteratively search for the next option which could
-  // be a prefix.
-  //
-  // FIXME: This is searching much more than necessary, but I am
-  // blanking on the simplest way to make it fast. We can solve this
-  // problem when we move to TableGen.
-  for (; Start != End; ++Start) {
-    // Scan for first option which is a proper prefix.
-    for (; Start != End; ++Start)
-      if (memcmp(Str, Start->Name, strlen(Start->Name)) == 0)
-        break;
-    if (Start == End)
-      break;
+    StringRef Name(Str, NameLengths[l]);
+    llvm::StringMap<unsigned>::const_iterator Found =
+      FirstOptionOfName.find(Name);
+    if (Found == FirstOptionOfName.end())
+      continue;
 
-    // See if this option matches.
-    if (Arg *A = getOption(Start - OptionInfos + 1)->accept(Args, Index))
-      return A;
+    for (unsigned i = Found->getValue(), e = getNumOptions();
+         i != e && Name == getInfo(i + 1).Name; ++i) {
+      // See if this option matches.
+      if (Arg *A = getOption(i + 1)->accept(Args, Index))
+        return A;
 
-    // Otherwise, see if this argument was missing values.
-    if (Prev != Index)
-      return 0;
+      // Otherwise, see if this argument was missing values.
+      if (Prev != Index)
+        return 0;
+    }
   }
 
   return new Arg(TheUnknownOption, Index++, Str);
@@ -20,7 +20,9 @@
 #include "clang/Basic/ObjCRuntime.h"
 #include "clang/Basic/Version.h"
 
+#include "llvm/ADT/OwningPtr.h"
 #include "llvm/ADT/SmallString.h"
+#include "llvm/ADT/StringMap.h"
 #include "llvm/ADT/StringExtras.h"
 #include "llvm/ADT/StringSwitch.h"
 #include "llvm/ADT/STLExtras.h"
@@ -32,6 +34,7 @@
 #include "llvm/Support/system_error.h"
 
 #include <cstdlib> // ::getenv
+#include <sys/stat.h>
 
 #include "clang/Config/config.h" // for GCC_INSTALL_PREFIX
 
@@ -1027,6 +1030,73 @@ bool Generic_GCC::GCCVersion::operator<(const GCCVersion &RHS) const {
   return false;
 }
 
+/// \brief The directories whose modification times determine the outcome of
+/// a GCC installation detection, with those times (-1 for a missing one).
+///
+/// A path that exists is covered by its parent directory, whose time changes
+/// when the path is removed. A path that is missing is covered by its nearest
+/// existing ancestor, whose time changes when the first missing component is
+/// created. A directory that is listed is covered by itself.
+struct Generic_GCC::GCCInstallationDetector::ProbedDirectories {
+  llvm::StringMap<long long> Times;
+
+  static long long getModificationTime(StringRef Dir) {
+    struct stat StatBuf;
+    if (::stat(Dir.str().c_str(), &StatBuf))
+      return -1;
+    return StatBuf.st_mtime;
+  }
+
+  void addDirectory(StringRef Dir) {
+    if (Dir.empty())
+      Dir = ".";
+    if (!Times.count(Dir))
+      Times[Dir] = getModificationTime(Dir);
+  }
+
+  void addMissingPath(StringRef Path) {
+    StringRef Dir = Path;
+    do
+      Dir = llvm::sys::path::parent_path(Dir);
+    while (!Dir.empty() && !llvm::sys::fs::exists(Dir));
+    addDirectory(Dir);
+  }
+
+  /// \brief Whether \p Path exists, noting the directories that tell.
+  bool exists(const std::string &Path) {
+    if (!llvm::sys::fs::exists(Path)) {
+      addMissingPath(Path);
+      return false;
+    }
+    addDirectory(llvm::sys::path::parent_path(Path));
+    return true;
+  }
+
+  /// \brief Whether \p Path exists, noting the directories that tell in
+  /// \p Probed, if any.
+  static bool probe(ProbedDirectories *Probed, const std::string &Path) {
+    return Probed ? Probed->exists(Path) : llvm::sys::fs::exists(Path);
+  }
+
+  /// \brief Note that the entries of \p Dir were listed.
+  void addListedDirectory(const std::string &Dir) {
+    if (getModificationTime(Dir) == -1)
+      addMissingPath(Dir);
+    else
+      addDirectory(Dir);
+  }
+
+  /// \brief Whether the directories still have the recorded times.
+  bool isUpToDate() const {
+    for (llvm::StringMap<long long>::const_iterator I = Times.begin(),
+                                                    E = Times.end();
+         I != E; ++I)
+      if (getModificationTime(I->getKey()) != I->getValue())
+        return false;
+    return true;
+  }
+};
+
 static StringRef getGCCToolchainDir(const ArgList &Args) {
   const Arg *A = Args.getLastArg(options::OPT_gcc_toolchain);
   if (A)
@@ -1078,31 +1148,205 @@ Generic_GCC::GCCInstallationDetector::GCCInstallationDetector(
     Prefixes.push_back(D.InstalledDir + "/..");
   }
 
+  // If a cache file is given, reuse the installation detected by an earlier
+  // run with the same candidates, unless the directories it looked at have
+  // changed since.
+  const char *CacheFile = ::getenv("CLANG_GCC_INSTALLATION_CACHE");
+  std::string CacheKey;
+  OwningPtr<ProbedDirectories> Probed;
+  if (CacheFile && *CacheFile) {
+    CacheKey = "entry " + getClangFullVersion() + " " + TargetTriple.str() +
+               "\n";
+    for (unsigned i = 0, ie = Prefixes.size(); i < ie; ++i)
+      CacheKey += "prefix " + Prefixes[i] + "\n";
+    if (loadFromCache(CacheFile, CacheKey))
+      return;
+    Probed.reset(new ProbedDirectories());
+  }
+
   // Loop over the various components which exist and select the best GCC
   // installation available. GCC installs are ranked by version number.
   Version = GCCVersion::Parse("0.0.0");
   for (unsigned i = 0, ie = Prefixes.size(); i < ie; ++i) {
-    if (!llvm::sys::fs::exists(Prefixes[i]))
+    if (!ProbedDirectories::probe(Probed.get(), Prefixes[i]))
       continue;
     for (unsigned j = 0, je = CandidateLibDirs.size(); j < je; ++j) {
       const std::string LibDir = Prefixes[i] + CandidateLibDirs[j].str();
-      if (!llvm::sys::fs::exists(LibDir))
+      if (!ProbedDirectories::probe(Probed.get(), LibDir))
         continue;
       for (unsigned k = 0, ke = CandidateTripleAliases.size(); k < ke; ++k)
-        ScanLibDirForGCCTriple(TargetArch, LibDir, CandidateTripleAliases[k]);
+        ScanLibDirForGCCTriple(TargetArch, LibDir, CandidateTripleAliases[k],
+                               Probed.get());
     }
     for (unsigned j = 0, je = CandidateMultiarchLibDirs.size(); j < je; ++j) {
       const std::string LibDir
         = Prefixes[i] + CandidateMultiarchLibDirs[j].str();
-      if (!llvm::sys::fs::exists(LibDir))
+      if (!ProbedDirectories::probe(Probed.get(), LibDir))
         continue;
       for (unsigned k = 0, ke = CandidateMultiarchTripleAliases.size(); k < ke;
            ++k)
         ScanLibDirForGCCTriple(TargetArch, LibDir,
                                CandidateMultiarchTripleAliases[k],
+                               Probed.get(),
                                /*NeedsMultiarchSuffix=*/true);
     }
   }
+
+  if (Probed)
+    saveToCache(CacheFile, CacheKey, *Probed);
+}
+
+static const char GCCInstallationCacheMagic[] =
+  "clang-gcc-installation-cache 1";
+
+/// \brief Split the entries of a GCC installation cache file, each of which
+/// runs from its "entry" line to its "end" line, into their lines.
+static bool readGCCInstallationCache(
+    StringRef Buffer, std::vector<SmallVector<StringRef, 16> > &Entries) {
+  SmallVector<StringRef, 64> Lines;
+  Buffer.split(Lines, "\n", /*MaxSplit=*/-1, /*KeepEmpty=*/false);
+  if (Lines.empty() || Lines[0] != GCCInstallationCacheMagic)
+    return false;
+  for (unsigned i = 1, ie = Lines.size(); i < ie; ++i) {
+    if (Lines[i].startswith("entry "))
+      Entries.push_back(SmallVector<StringRef, 16>());
+    else if (Entries.empty())
+      return false;
+    Entries.back().push_back(Lines[i]);
+  }
+  return Entries.empty() || Entries.back().back() == "end";
+}
+
+/// \brief Whether the first lines of a cache entry are the given key.
+static bool hasCacheKey(ArrayRef<StringRef> Entry, StringRef Key) {
+  for (unsigned i = 0, ie = Entry.size(); i < ie && !Key.empty(); ++i) {
+    std::pair<StringRef, StringRef> Line = Key.split('\n');
+    if (Entry[i] != Line.first)
+      return false;
+    Key = Line.second;
+  }
+  return Key.empty();
+}
+
+bool Generic_GCC::GCCInstallationDetector::loadFromCache(StringRef CacheFile,
+                                                         StringRef Key) {
+  OwningPtr<llvm::MemoryBuffer> Buffer;
+  if (llvm::MemoryBuffer::getFile(CacheFile, Buffer))
+    return false;
+  std::vector<SmallVector<StringRef, 16> > Entries;
+  if (!readGCCInstallationCache(Buffer->getBuffer(), Entries))
+    return false;
+
+  for (unsigned i = 0, ie = Entries.size(); i < ie; ++i) {
+    ArrayRef<StringRef> Entry = Entries[i];
+    if (!hasCacheKey(Entry, Key))
+      continue;
+
+    ProbedDirectories Probed;
+    StringRef Valid, Triple, InstallPath, MultiarchSuffix, ParentLibPath;
+    StringRef VersionText;
+    for (unsigned j = 0, je = Entry.size(); j < je; ++j) {
+      std::pair<StringRef, StringRef> Field = Entry[j].split(' ');
+      if (Field.first == "valid")
+        Valid = Field.second;
+      else if (Field.first == "gcc-triple")
+        Triple = Field.second;
+      else if (Field.first == "install-path")
+        InstallPath = Field.second;
+      else if (Field.first == "multiarch-suffix")
+        MultiarchSuffix = Field.second;
+      else if (Field.first == "parent-lib-path")
+        ParentLibPath = Field.second;
+      else if (Field.first == "version")
+        VersionText = Field.second;
+      else if (Field.first == "dir") {
+        std::pair<StringRef, StringRef> Dir = Field.second.split(' ');
+        long long Time;
+        if (Dir.first.getAsInteger(10, Time))
+          return false;
+        Probed.Times[Dir.second] = Time;
+      }
+    }
+    if (!Probed.isUpToDate())
+      return false;
+
+    IsValid = Valid == "1";
+    if (IsValid) {
+      GCCTriple.setTriple(Triple);
+      GCCInstallPath = InstallPath;
+      GCCMultiarchSuffix = MultiarchSuffix;
+      GCCParentLibPath = ParentLibPath;
+      Version = GCCVersion::Parse(VersionText);
+    } else
+      Version = GCCVersion::Parse("0.0.0");
+    return true;
+  }
+  return false;
+}
+
+void Generic_GCC::GCCInstallationDetector::saveToCache(
+    StringRef CacheFile, StringRef Key,
+    const ProbedDirectories &Probed) const {
+  // Keep the most recent entries of other triples and prefixes.
+  const unsigned MaxEntries = 32;
+  OwningPtr<llvm::MemoryBuffer> Buffer;
+  std::vector<SmallVector<StringRef, 16> > Entries;
+  if (!llvm::MemoryBuffer::getFile(CacheFile, Buffer) &&
+      !readGCCInstallationCache(Buffer->getBuffer(), Entries))
+    Entries.clear();
+
+  // Write the cache to a temporary file and rename it into place, so that
+  // concurrent drivers only ever read complete caches.
+  llvm::sys::Path TempPath(CacheFile);
+  TempPath.appendSuffix("tmp");
+  if (TempPath.makeUnique(/*reuse_current=*/false, 0))
+    return;
+
+  std::string ErrorInfo;
+  {
+    llvm::raw_fd_ostream Out(TempPath.c_str(), ErrorInfo,
+                             llvm::raw_fd_ostream::F_Binary);
+    if (!ErrorInfo.empty())
+      return;
+
+    Out << GCCInstallationCacheMagic << '\n';
+    SmallVector<unsigned, 32> Kept;
+    for (unsigned i = 0, ie = Entries.size(); i < ie; ++i)
+      if (!hasCacheKey(Entries[i], Key))
+        Kept.push_back(i);
+    unsigned FirstKept = 0;
+    if (Kept.size() >= MaxEntries)
+      FirstKept = Kept.size() - MaxEntries + 1;
+    for (unsigned i = FirstKept, ie = Kept.size(); i < ie; ++i) {
+      ArrayRef<StringRef> Entry = Entries[Kept[i]];
+      for (unsigned j = 0, je = Entry.size(); j < je; ++j)
+        Out << Entry[j] << '\n';
+    }
+
+    Out << Key;
+    Out << "valid " << (IsValid ? "1" : "0") << '\n';
+    if (IsValid) {
+      Out << "gcc-triple " << GCCTriple.str() << '\n';
+      Out << "install-path " << GCCInstallPath << '\n';
+      Out << "multiarch-suffix " << GCCMultiarchSuffix << '\n';
+      Out << "parent-lib-path " << GCCParentLibPath << '\n';
+      Out << "version " << Version.Text << '\n';
+    }
+    for (llvm::StringMap<long long>::const_iterator I = Probed.Times.begin(),
+                                                    E = Probed.Times.end();
+         I != E; ++I)
+      Out << "dir " << I->getValue() << ' ' << I->getKey() << '\n';
+    Out << "end\n";
+    Out.close();
+    if (Out.has_error()) {
+      Out.clear_error();
+      ErrorInfo = "write error";
+    }
+  }
+
+  bool Existed;
+  if (!ErrorInfo.empty() || llvm::sys::fs::rename(TempPath.str(), CacheFile))
+    llvm::sys::fs::remove(TempPath.str(), Existed);
 }
 
 /*static*/ void Generic_GCC::GCCInstallationDetector::CollectLibDirsAndTriples(
@@ -1283,7 +1527,8 @@ Generic_GCC::GCCInstallationDetector::GCCInstallationDetector(
 
 void Generic_GCC::GCCInstallationDetector::ScanLibDirForGCCTriple(
     llvm::Triple::ArchType TargetArch, const std::string &LibDir,
-    StringRef CandidateTriple, bool NeedsMultiarchSuffix) {
+    StringRef CandidateTriple, ProbedDirectories *Probed,
+    bool NeedsMultiarchSuffix) {
   // There are various different suffixes involving the triple we
   // check for. We also record what is necessary to walk from each back
   // up to the lib directory.
@@ -1307,6 +1552,8 @@ void Generic_GCC::GCCInstallationDetector::ScanLibDirForGCCTriple(
                                    (TargetArch != llvm::Triple::x86));
   for (unsigned i = 0; i < NumLibSuffixes; ++i) {
     StringRef LibSuffix = LibSuffixes[i];
+    if (Probed)
+      Probed->addListedDirectory(LibDir + LibSuffix.str());
     llvm::error_code EC;
     for (llvm::sys::fs::directory_iterator LI(LibDir + LibSuffix, EC), LE;
          !EC && LI != LE; LI = LI.increment(EC)) {
@@ -1329,11 +1576,12 @@ void Generic_GCC::GCCInstallationDetector::ScanLibDirForGCCTriple(
            TargetArch == llvm::Triple::ppc64 ||
            TargetArch == llvm::Triple::mips64 ||
            TargetArch == llvm::Triple::mips64el) ? "/64" : "/32";
-      if (llvm::sys::fs::exists(LI->path() + MultiarchSuffix + "/crtbegin.o")) {
+      if (ProbedDirectories::probe(Probed, LI->path() + MultiarchSuffix.str() +
+                                           "/crtbegin.o")) {
         GCCMultiarchSuffix = MultiarchSuffix.str();
       } else {
         if (NeedsMultiarchSuffix ||
-            !llvm::sys::fs::exists(LI->path() + "/crtbegin.o"))
+            !ProbedDirectories::probe(Probed, LI->path() + "/crtbegin.o"))
           continue;
         GCCMultiarchSuffix.clear();
       }
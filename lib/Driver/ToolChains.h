@@ -102,6 +102,12 @@ protected:
     const GCCVersion &getVersion() const { return Version; }
 
   private:
+    struct ProbedDirectories;
+
+    bool loadFromCache(StringRef CacheFile, StringRef Key);
+    void saveToCache(StringRef CacheFile, StringRef Key,
+                     const ProbedDirectories &Probed) const;
+
     static void CollectLibDirsAndTriples(
       const llvm::Triple &TargetTriple,
       const llvm::Triple &MultiarchTriple,
@@ -113,6 +119,7 @@ protected:
     void ScanLibDirForGCCTriple(llvm::Triple::ArchType TargetArch,
                                 const std::string &LibDir,
                                 StringRef CandidateTriple,
+                                ProbedDirectories *Probed,
                                 bool NeedsMultiarchSuffix = false);
   };
 
@@ -1999,6 +1999,11 @@ void Clang::ConstructJob(Compilation &C, const JobAction &JA,
       Args.hasArg(options::OPT_coverage))
     CmdArgs.push_back("-femit-coverage-data");
 
+  Args.AddLastArg(CmdArgs, options::OPT_fprofile_instr_generate);
+  Args.AddLastArg(CmdArgs, options::OPT_fprofile_instr_use_EQ);
+  Args.AddLastArg(CmdArgs, options::OPT_fpch_vtables_EQ);
+  Args.AddLastArg(CmdArgs, options::OPT_Rpass_EQ);
+
   if (C.getArgs().hasArg(options::OPT_c) ||
       C.getArgs().hasArg(options::OPT_S)) {
     if (Output.isFilename()) {
@@ -2425,6 +2430,17 @@ void Clang::ConstructJob(Compilation &C, const JobAction &JA,
       CmdArgs.push_back("-fmodules");
   }
 
+  // -fintrinsics-module imports the builtin intrinsic headers as a module,
+  // with the same restriction for C++ as -fmodules.
+  if (Args.hasFlag(options::OPT_fintrinsics_module,
+                   options::OPT_fno_intrinsics_module, false)) {
+    bool AllowedInCXX = Args.hasFlag(options::OPT_fcxx_modules,
+                                     options::OPT_fno_cxx_modules,
+                                     false);
+    if (AllowedInCXX || !types::isCXX(InputType))
+      CmdArgs.push_back("-fintrinsics-module");
+  }
+
   // -faccess-control is default.
   if (Args.hasFlag(options::OPT_fno_access_control,
                    options::OPT_faccess_control,
@@ -2510,6 +2526,9 @@ void Clang::ConstructJob(Compilation &C, const JobAction &JA,
                    getToolChain().getTriple().getOS() == llvm::Triple::Win32))
     CmdArgs.push_back("-fdelayed-template-parsing");
 
+  Args.AddLastArg(CmdArgs, options::OPT_flazy_inline_method_parsing);
+  Args.AddLastArg(CmdArgs, options::OPT_fcompact_system_type_locs);
+
   // -fgnu-keywords default varies depending on language; only pass if
   // specified.
   if (Arg *A = Args.getLastArg(options::OPT_fgnu_keywords,
@@ -2543,6 +2562,12 @@ void Clang::ConstructJob(Compilation &C, const JobAction &JA,
     }
   }
 
+  // -fobjc-send-cache is only implemented by the GNUstep runtime.
+  if (Args.hasFlag(options::OPT_fobjc_send_cache,
+                   options::OPT_fno_objc_send_cache, false) &&
+      objcRuntime.getKind() == ObjCRuntime::GNUstep)
+    CmdArgs.push_back("-fobjc-send-cache");
+
   // -fobjc-default-synthesize-properties=1 is default. This only has an effect
   // if the nonfragile objc abi is used.
   if (getToolChain().IsObjCDefaultSynthPropertiesDefault()) {
@@ -22,15 +22,20 @@
 #include "clang/Frontend/FrontendDiagnostic.h"
 #include "clang/Frontend/FrontendOptions.h"
 #include "clang/Frontend/MultiplexConsumer.h"
+#include "clang/Frontend/PreambleCache.h"
 #include "clang/Frontend/Utils.h"
 #include "clang/Serialization/ASTReader.h"
 #include "clang/Serialization/ASTWriter.h"
 #include "clang/Lex/HeaderSearch.h"
 #include "clang/Lex/Preprocessor.h"
+#include "clang/Basic/Parallel.h"
 #include "clang/Basic/TargetOptions.h"
 #include "clang/Basic/TargetInfo.h"
 #include "clang/Basic/Diagnostic.h"
+#include "clang/Basic/OnDiskHashTable.h"
+#include "clang/Basic/Version.h"
 #include "llvm/ADT/ArrayRef.h"
+#include "llvm/ADT/STLExtras.h"
 #include "llvm/ADT/StringExtras.h"
 #include "llvm/ADT/StringSet.h"
 #include "llvm/Support/Atomic.h"
@@ -43,6 +48,7 @@
 #include "llvm/Support/Mutex.h"
 #include "llvm/Support/MutexGuard.h"
 #include "llvm/Support/CrashRecoveryContext.h"
+#include <algorithm>
 #include <cstdlib>
 #include <cstdio>
 #include <sys/stat.h>
@@ -168,8 +174,73 @@ void OnDiskData::CleanTemporaryFiles() {
   TemporaryFiles.clear(); 
 }
 
+namespace {
+  /// \brief A precompiled preamble built by an ASTUnit of this process, which
+  /// other ASTUnits with the same main file, preamble and invocation use as
+  /// well.
+  struct SharedPreamble {
+    std::string PCHPath;
+    PreambleCache::Entry Data;
+  };
+}
+
+/// \brief The shared precompiled preambles, by their PreambleCache key.
+///
+/// Guarded by the on-disk mutex. It is never destroyed, since preamble files
+/// are still removed by cleanupOnDiskMapAtExit().
+static llvm::StringMap<SharedPreamble> &getSharedPreambles() {
+  static llvm::StringMap<SharedPreamble> *M
+    = new llvm::StringMap<SharedPreamble>();
+  return *M;
+}
+
+static void registerSharedPreamble(StringRef Key, StringRef PCHPath,
+                                   const PreambleCache::Entry &Data) {
+  llvm::MutexGuard Guard(getOnDiskMutex());
+  SharedPreamble &Shared = getSharedPreambles()[Key];
+  Shared.PCHPath = PCHPath;
+  Shared.Data = Data;
+}
+
+/// \brief Stop sharing the precompiled preamble at \p PCHPath, which is about
+/// to be removed.
+static void unregisterSharedPreamble(StringRef PCHPath) {
+  llvm::MutexGuard Guard(getOnDiskMutex());
+  llvm::StringMap<SharedPreamble> &M = getSharedPreambles();
+  for (llvm::StringMap<SharedPreamble>::iterator I = M.begin(), E = M.end();
+       I != E; ++I) {
+    if (I->second.PCHPath == PCHPath) {
+      M.erase(I);
+      return;
+    }
+  }
+}
+
+/// \brief Look up the shared precompiled preamble for \p Key.
+///
+/// On success, \p PCHPath is made a hard link to it, so that the ASTUnits
+/// share one file, and the memory the operating system caches for it, while
+/// each can remove its own name independently. \p Result describes the
+/// preamble.
+static bool linkSharedPreamble(StringRef Key, StringRef PCHPath,
+                               PreambleCache::Entry &Result) {
+  llvm::MutexGuard Guard(getOnDiskMutex());
+  llvm::StringMap<SharedPreamble>::iterator I = getSharedPreambles().find(Key);
+  if (I == getSharedPreambles().end() || I->second.PCHPath == PCHPath)
+    return false;
+
+  bool Existed;
+  llvm::sys::fs::remove(PCHPath, Existed);
+  if (llvm::sys::fs::create_hard_link(I->second.PCHPath, PCHPath))
+    return false;
+
+  Result = I->second.Data;
+  return true;
+}
+
 void OnDiskData::CleanPreambleFile() {
   if (!PreambleFile.empty()) {
+    unregisterSharedPreamble(PreambleFile);
     llvm::sys::Path(PreambleFile).eraseFromDisk();
     PreambleFile.clear();
   }
@@ -201,6 +272,49 @@ void ASTUnit::addTemporaryFile(const llvm::sys::Path &TempFile) {
 /// preamble.
 const unsigned DefaultPreambleRebuildInterval = 5;
 
+/// \brief A precompiled preamble being built on a background thread.
+///
+/// The preamble is built by a separate ASTUnit that shares no state with the
+/// ASTUnit that requested it; the latter adopts the result afterwards.
+class ASTUnit::BackgroundPreambleBuild {
+public:
+  OwningPtr<ASTUnit> Builder;
+  llvm::sys::Mutex Lock;
+  bool Finished;
+  bool Crashed;
+  BackgroundThread Thread;
+
+  BackgroundPreambleBuild() : Finished(false), Crashed(false) { }
+
+  ~BackgroundPreambleBuild() {
+    Thread.join();
+    // The builder may be in an inconsistent state after a crash.
+    if (Crashed)
+      Builder.take();
+  }
+
+  bool isFinished() {
+    llvm::MutexGuard Guard(Lock);
+    return Finished;
+  }
+
+  static void build(void *UserData) {
+    ASTUnit &Builder = *static_cast<ASTUnit *>(UserData);
+    delete Builder.getMainBufferWithPrecompiledPreamble(*Builder.Invocation);
+  }
+
+  static void run(void *UserData) {
+    BackgroundPreambleBuild &Build
+      = *static_cast<BackgroundPreambleBuild *>(UserData);
+    llvm::CrashRecoveryContext CRC;
+    bool Succeeded = CRC.RunSafely(build, Build.Builder.get());
+
+    llvm::MutexGuard Guard(Build.Lock);
+    Build.Crashed = !Succeeded;
+    Build.Finished = true;
+  }
+};
+
 /// \brief Tracks the number of ASTUnit objects that are currently active.
 ///
 /// Used for debugging purposes only.
@@ -216,10 +330,11 @@ ASTUnit::ASTUnit(bool _MainFileIsAST)
     NumWarningsInPreamble(0),
     ShouldCacheCodeCompletionResults(false),
     IncludeBriefCommentsInCodeCompletion(false), UserFilesAreVolatile(false),
+    BackgroundPreambleRebuild(false),
     CompletionCacheTopLevelHashValue(0),
     PreambleTopLevelHashValue(0),
     CurrentTopLevelHashValue(0),
-    UnsafeToFree(false) { 
+    UnsafeToFree(false), ASTUnloaded(false) { 
   if (getenv("LIBCLANG_OBJTRACKING")) {
     llvm::sys::AtomicIncrement(&ActiveASTUnitObjects);
     fprintf(stderr, "+++ %d translation units\n", ActiveASTUnitObjects);
@@ -227,6 +342,9 @@ ASTUnit::ASTUnit(bool _MainFileIsAST)
 }
 
 ASTUnit::~ASTUnit() {
+  // Wait for the background preamble build, if any; it removes its own files.
+  PendingPreambleBuild.reset();
+
   clearFileLevelDecls();
 
   // Clean up the temporary files and the preamble file.
@@ -333,6 +451,348 @@ static unsigned getDeclShowContexts(NamedDecl *ND,
   return Contexts;
 }
 
+//===----------------------------------------------------------------------===//
+// Code completions shared between ASTUnits
+//===----------------------------------------------------------------------===//
+
+static llvm::sys::Mutex &getPreambleCompletionsMutex() {
+  static llvm::sys::Mutex M;
+  return M;
+}
+
+/// \brief The preamble completions alive in this process, by key.
+///
+/// A set does not own a reference to itself; it removes itself from this map
+/// when its last reference is released.
+static llvm::StringMap<ASTUnit::PreambleCompletions *> &
+getLivePreambleCompletions() {
+  static llvm::StringMap<ASTUnit::PreambleCompletions *> Live;
+  return Live;
+}
+
+ASTUnit::PreambleCompletions::PreambleCompletions(StringRef Key)
+  : RefCount(0), Key(Key), Allocator(new GlobalCodeCompletionAllocator) { }
+
+void ASTUnit::PreambleCompletions::Retain() const {
+  llvm::sys::AtomicIncrement(&RefCount);
+}
+
+void ASTUnit::PreambleCompletions::Release() const {
+  // Dropping the last reference is serialized with lookups, so that a lookup
+  // never finds a set that is about to be deleted.
+  llvm::MutexGuard Guard(getPreambleCompletionsMutex());
+  if (llvm::sys::AtomicDecrement(&RefCount) != 0)
+    return;
+
+  llvm::StringMap<PreambleCompletions *> &Live = getLivePreambleCompletions();
+  llvm::StringMap<PreambleCompletions *>::iterator Pos = Live.find(Key);
+  if (Pos != Live.end() && Pos->second == this)
+    Live.erase(Pos);
+  delete this;
+}
+
+static IntrusiveRefCntPtr<ASTUnit::PreambleCompletions>
+findPreambleCompletions(StringRef Key) {
+  llvm::MutexGuard Guard(getPreambleCompletionsMutex());
+  llvm::StringMap<ASTUnit::PreambleCompletions *> &Live
+    = getLivePreambleCompletions();
+  llvm::StringMap<ASTUnit::PreambleCompletions *>::iterator Pos
+    = Live.find(Key);
+  if (Pos == Live.end())
+    return 0;
+  return Pos->second;
+}
+
+/// \brief Make \p Completions available to other ASTUnits, unless another
+/// set for the same preamble already is.
+static void
+publishPreambleCompletions(ASTUnit::PreambleCompletions *Completions) {
+  llvm::MutexGuard Guard(getPreambleCompletionsMutex());
+  ASTUnit::PreambleCompletions *&Entry
+    = getLivePreambleCompletions()[Completions->Key];
+  if (!Entry)
+    Entry = Completions;
+}
+
+/// \brief Compute the key under which ASTUnits share the code completions of
+/// a precompiled preamble.
+///
+/// Unlike the key of the precompiled preamble itself, which is only valid for
+/// one main file, this leaves out the main file, so that every file with the
+/// same preamble shares its completions. The input files of the preamble are
+/// part of the key, so a set is never used after a header changes.
+static std::string
+getPreambleCompletionsKey(const CompilerInvocation &Invocation,
+                          StringRef PreambleText, bool EndsAtStartOfLine,
+                          ArrayRef<std::string> TargetFeatures,
+               const llvm::StringMap<std::pair<off_t, time_t> > &Files,
+                          bool IncludeBriefComments) {
+  CompilerInvocation CI(Invocation);
+  FrontendOptions &FrontendOpts = CI.getFrontendOpts();
+  FrontendOpts.Inputs[0] = FrontendInputFile("", FrontendOpts.Inputs[0].Kind);
+  FrontendOpts.OutputFile.clear();
+  CI.getCodeGenOpts().MainFileName.clear();
+  CI.getDependencyOutputOpts() = DependencyOutputOptions();
+  CI.getPreprocessorOpts().clearRemappedFiles();
+
+  std::vector<std::string> Args;
+  CI.toArgs(Args);
+
+  std::vector<std::string> FileStamps;
+  for (llvm::StringMap<std::pair<off_t, time_t> >::const_iterator
+         F = Files.begin(), FEnd = Files.end();
+       F != FEnd; ++F)
+    FileStamps.push_back(F->first().str() + ' ' +
+                         llvm::utostr(uint64_t(F->second.first)) + ' ' +
+                         llvm::itostr(int64_t(F->second.second)));
+  std::sort(FileStamps.begin(), FileStamps.end());
+
+  std::string Key;
+  llvm::raw_string_ostream OS(Key);
+  OS << getClangFullRepositoryVersion() << '\n' << IncludeBriefComments << '\n';
+  for (unsigned I = 0, N = Args.size(); I != N; ++I)
+    OS << Args[I] << '\n';
+  for (unsigned I = 0, N = TargetFeatures.size(); I != N; ++I)
+    OS << TargetFeatures[I] << '\n';
+  for (unsigned I = 0, N = FileStamps.size(); I != N; ++I)
+    OS << FileStamps[I] << '\n';
+  OS << EndsAtStartOfLine << '\n' << PreambleText;
+  return OS.str();
+}
+
+/// \brief Determine whether a global code completion refers to a declaration
+/// or macro of the precompiled preamble.
+static bool isFromPreamble(const CodeCompletionResult &Result,
+                           Preprocessor &PP) {
+  switch (Result.Kind) {
+  case CodeCompletionResult::RK_Declaration:
+    return Result.Declaration->isFromASTFile();
+
+  case CodeCompletionResult::RK_Macro:
+    if (MacroInfo *MI = PP.getMacroInfo(Result.Macro))
+      return MI->isFromAST();
+    return false;
+
+  case CodeCompletionResult::RK_Keyword:
+  case CodeCompletionResult::RK_Pattern:
+    return false;
+  }
+
+  llvm_unreachable("Invalid ResultKind!");
+}
+
+/// \brief Determine whether the main file changed which declarations and
+/// macros of the precompiled preamble are visible at file scope, or how they
+/// complete, in which case the completions other ASTUnits computed for the
+/// preamble don't apply to it.
+static bool changesPreambleCompletions(Sema &S, Preprocessor &PP,
+                                ArrayRef<CodeCompletionResult> Results) {
+  // A using directive makes more declarations visible.
+  TranslationUnitDecl *TU = S.Context.getTranslationUnitDecl();
+  for (DeclContext::udir_iterator U = TU->using_directives_begin(),
+                               UEnd = TU->using_directives_end();
+       U != UEnd; ++U)
+    if (!(*U)->isFromASTFile())
+      return true;
+
+  // A redeclaration is found in place of the declaration of the preamble.
+  for (unsigned I = 0, N = Results.size(); I != N; ++I) {
+    if (Results[I].Kind != CodeCompletionResult::RK_Declaration)
+      continue;
+    Decl *D = Results[I].Declaration;
+    if (!D->isFromASTFile() && D->getCanonicalDecl()->isFromASTFile())
+      return true;
+  }
+
+  // So is a macro redefinition, and an #undef hides the macro.
+  for (Preprocessor::macro_iterator M = PP.macro_begin(), MEnd = PP.macro_end();
+       M != MEnd; ++M) {
+    MacroInfo *Latest = M->second;
+    for (MacroInfo *MI = Latest->getPreviousDefinition(); MI;
+         MI = MI->getPreviousDefinition())
+      if (MI->isFromAST())
+        return true;
+    if (Latest->isFromAST() && !M->first->hasMacroDefinition() &&
+        M->first->hasChangedSinceDeserialization())
+      return true;
+  }
+
+  return false;
+}
+
+/// \brief Whether a code completion chunk of kind \p Kind has text of its
+/// own, rather than an optional string or punctuation.
+static bool chunkHasText(CodeCompletionString::ChunkKind Kind) {
+  switch (Kind) {
+  case CodeCompletionString::CK_TypedText:
+  case CodeCompletionString::CK_Text:
+  case CodeCompletionString::CK_Placeholder:
+  case CodeCompletionString::CK_Informative:
+  case CodeCompletionString::CK_ResultType:
+  case CodeCompletionString::CK_CurrentParameter:
+    return true;
+  default:
+    return false;
+  }
+}
+
+static void writeCompletionBytes(raw_ostream &OS, StringRef Bytes) {
+  io::Emit32(OS, Bytes.size());
+  OS << Bytes;
+}
+
+static void writeCompletionString(raw_ostream &OS,
+                                  const CodeCompletionString &CCS) {
+  io::Emit16(OS, CCS.getPriority());
+  io::Emit8(OS, CCS.getAvailability());
+  io::Emit16(OS, CCS.getParentContextKind());
+  writeCompletionBytes(OS, CCS.getParentContextName());
+  io::Emit8(OS, CCS.getBriefComment() != 0);
+  if (CCS.getBriefComment())
+    writeCompletionBytes(OS, CCS.getBriefComment());
+
+  io::Emit16(OS, CCS.size());
+  for (CodeCompletionString::iterator C = CCS.begin(), CEnd = CCS.end();
+       C != CEnd; ++C) {
+    io::Emit8(OS, C->Kind);
+    if (C->Kind == CodeCompletionString::CK_Optional)
+      writeCompletionString(OS, *C->Optional);
+    else if (chunkHasText(C->Kind))
+      writeCompletionBytes(OS, C->Text);
+  }
+
+  io::Emit16(OS, CCS.getAnnotationCount());
+  for (unsigned I = 0, N = CCS.getAnnotationCount(); I != N; ++I)
+    writeCompletionBytes(OS, CCS.getAnnotation(I));
+}
+
+/// \brief Serialize \p Completions for the PreambleCache.
+static std::string
+writePreambleCompletions(const ASTUnit::PreambleCompletions &Completions) {
+  std::string Data;
+  llvm::raw_string_ostream OS(Data);
+  io::Emit32(OS, Completions.Results.size());
+  for (unsigned I = 0, N = Completions.Results.size(); I != N; ++I) {
+    const ASTUnit::CachedCodeCompletionResult &R = Completions.Results[I];
+    io::Emit64(OS, R.ShowInContexts);
+    io::Emit32(OS, R.Priority);
+    io::Emit32(OS, R.Kind);
+    io::Emit8(OS, R.Availability);
+    io::Emit8(OS, R.TypeClass);
+    io::Emit32(OS, R.Type);
+    writeCompletionString(OS, *R.Completion);
+  }
+
+  io::Emit32(OS, Completions.Types.size());
+  for (llvm::StringMap<unsigned>::const_iterator
+         T = Completions.Types.begin(), TEnd = Completions.Types.end();
+       T != TEnd; ++T) {
+    io::Emit32(OS, T->second);
+    writeCompletionBytes(OS, T->first());
+  }
+  return OS.str();
+}
+
+namespace {
+/// \brief Reads the completions written by writePreambleCompletions.
+class PreambleCompletionsReader {
+  const unsigned char *Pos, *End;
+  GlobalCodeCompletionAllocator &Allocator;
+  CodeCompletionTUInfo TUInfo;
+  bool Failed;
+
+  bool has(size_t Size) {
+    if (size_t(End - Pos) < Size)
+      Failed = true;
+    return !Failed;
+  }
+
+public:
+  PreambleCompletionsReader(StringRef Data,
+               IntrusiveRefCntPtr<GlobalCodeCompletionAllocator> AllocatorRef)
+    : Pos(reinterpret_cast<const unsigned char *>(Data.data())),
+      End(Pos + Data.size()), Allocator(*AllocatorRef), TUInfo(AllocatorRef),
+      Failed(false) { }
+
+  bool failed() const { return Failed; }
+
+  uint8_t read8() { return has(1) ? *Pos++ : 0; }
+  uint16_t read16() { return has(2) ? io::ReadUnalignedLE16(Pos) : 0; }
+  uint32_t read32() { return has(4) ? io::ReadUnalignedLE32(Pos) : 0; }
+  uint64_t read64() { return has(8) ? io::ReadUnalignedLE64(Pos) : 0; }
+
+  StringRef readBytes() {
+    uint32_t Length = read32();
+    if (!has(Length))
+      return StringRef();
+    StringRef Result(reinterpret_cast<const char *>(Pos), Length);
+    Pos += Length;
+    return Result;
+  }
+
+  CodeCompletionString *readString() {
+    unsigned Priority = read16();
+    CXAvailabilityKind Availability = CXAvailabilityKind(read8());
+    CodeCompletionBuilder Builder(Allocator, TUInfo, Priority, Availability);
+    CXCursorKind ParentKind = CXCursorKind(read16());
+    Builder.setParentContext(ParentKind, Allocator.CopyString(readBytes()));
+    if (read8())
+      Builder.addBriefComment(readBytes());
+
+    for (unsigned I = 0, N = read16(); I != N && !Failed; ++I) {
+      CodeCompletionString::ChunkKind Kind
+        = CodeCompletionString::ChunkKind(read8());
+      if (Kind > CodeCompletionString::CK_VerticalSpace)
+        Failed = true;
+      else if (Kind == CodeCompletionString::CK_Optional)
+        Builder.AddOptionalChunk(readString());
+      else if (chunkHasText(Kind))
+        Builder.AddChunk(Kind, Allocator.CopyString(readBytes()));
+      else
+        Builder.AddChunk(Kind);
+    }
+
+    for (unsigned I = 0, N = read16(); I != N && !Failed; ++I)
+      Builder.AddAnnotation(Allocator.CopyString(readBytes()));
+    return Builder.TakeString();
+  }
+};
+}
+
+/// \brief Deserialize the completions stored in the PreambleCache under
+/// \p Key, or return null if there are none.
+static IntrusiveRefCntPtr<ASTUnit::PreambleCompletions>
+loadPreambleCompletions(StringRef Key) {
+  PreambleCache *Cache = PreambleCache::getShared();
+  std::string Data;
+  if (!Cache || !Cache->lookupCompletions(Key, Data))
+    return 0;
+
+  IntrusiveRefCntPtr<ASTUnit::PreambleCompletions> Completions
+    = new ASTUnit::PreambleCompletions(Key);
+  PreambleCompletionsReader Reader(Data, Completions->Allocator);
+  for (unsigned I = 0, N = Reader.read32(); I != N && !Reader.failed(); ++I) {
+    ASTUnit::CachedCodeCompletionResult R;
+    R.ShowInContexts = Reader.read64();
+    R.Priority = Reader.read32();
+    R.Kind = CXCursorKind(Reader.read32());
+    R.Availability = CXAvailabilityKind(Reader.read8());
+    R.TypeClass = SimplifiedTypeClass(Reader.read8());
+    R.Type = Reader.read32();
+    R.Completion = Reader.readString();
+    Completions->Results.push_back(R);
+  }
+  for (unsigned I = 0, N = Reader.read32(); I != N && !Reader.failed(); ++I) {
+    unsigned Type = Reader.read32();
+    Completions->Types[Reader.readBytes()] = Type;
+  }
+  if (Reader.failed())
+    return 0;
+
+  publishPreambleCompletions(Completions.getPtr());
+  return Completions;
+}
+
 void ASTUnit::CacheCodeCompletionResults() {
   if (!TheSema)
     return;
@@ -350,17 +810,77 @@ void ASTUnit::CacheCodeCompletionResults() {
   TheSema->GatherGlobalCodeCompletions(*CachedCompletionAllocator,
                                        getCodeCompletionTUInfo(), Results);
   
+  // The completions for the declarations and macros of the precompiled
+  // preamble are shared with the other ASTUnits using the same preamble,
+  // unless the main file changed them or remaps other files.
+  IntrusiveRefCntPtr<PreambleCompletions> Shared;
+  bool BuildShared = false;
+  if (SavedMainFileBuffer && !Preamble.empty() &&
+      !changesPreambleCompletions(*TheSema, *PP, Results)) {
+    StringRef MainFilename = Invocation->getFrontendOpts().Inputs[0].File;
+    PreprocessorOptions &PPOpts = Invocation->getPreprocessorOpts();
+    bool RemapsOtherFiles = false;
+    for (PreprocessorOptions::remapped_file_iterator
+           R = PPOpts.remapped_file_begin(), REnd = PPOpts.remapped_file_end();
+         R != REnd; ++R)
+      RemapsOtherFiles |= R->first != MainFilename;
+    for (PreprocessorOptions::remapped_file_buffer_iterator
+           R = PPOpts.remapped_file_buffer_begin(),
+           REnd = PPOpts.remapped_file_buffer_end();
+         R != REnd; ++R)
+      RemapsOtherFiles |= R->first != MainFilename;
+
+    if (!RemapsOtherFiles) {
+      std::string Key
+        = getPreambleCompletionsKey(*Invocation,
+                                    StringRef(Preamble.getBufferStart(),
+                                              Preamble.size()),
+                                    PreambleEndsAtStartOfLine, TargetFeatures,
+                                    FilesInPreamble,
+                                    IncludeBriefCommentsInCodeCompletion);
+      Shared = findPreambleCompletions(Key);
+      if (!Shared)
+        Shared = loadPreambleCompletions(Key);
+      if (!Shared) {
+        Shared = new PreambleCompletions(Key);
+        BuildShared = true;
+      }
+    }
+  }
+
+  unsigned NextTypeValue = 1;
+  if (Shared && !BuildShared) {
+    CachedCompletionResults = Shared->Results;
+    for (llvm::StringMap<unsigned>::iterator T = Shared->Types.begin(),
+                                          TEnd = Shared->Types.end();
+         T != TEnd; ++T) {
+      CachedCompletionTypes[T->first()] = T->second;
+      NextTypeValue = std::max(NextTypeValue, T->second + 1);
+    }
+  }
+  CodeCompletionTUInfo SharedTUInfo(Shared ? Shared->Allocator
+                                           : CachedCompletionAllocator);
+
   // Translate global code completions into cached completions.
   llvm::DenseMap<CanQualType, unsigned> CompletionTypes;
   
   for (unsigned I = 0, N = Results.size(); I != N; ++I) {
+    bool FromPreamble = Shared && isFromPreamble(Results[I], *PP);
+    if (FromPreamble && !BuildShared)
+      continue;
+    GlobalCodeCompletionAllocator &Allocator
+      = FromPreamble ? *Shared->Allocator : *CachedCompletionAllocator;
+    CodeCompletionTUInfo &TUInfo
+      = FromPreamble ? SharedTUInfo : getCodeCompletionTUInfo();
+    std::vector<CachedCodeCompletionResult> *SharedResults
+      = FromPreamble ? &Shared->Results : 0;
+
     switch (Results[I].Kind) {
     case Result::RK_Declaration: {
       bool IsNestedNameSpecifier = false;
       CachedCodeCompletionResult CachedResult;
       CachedResult.Completion = Results[I].CreateCodeCompletionString(*TheSema,
-                                                    *CachedCompletionAllocator,
-                                                    getCodeCompletionTUInfo(),
+                                                    Allocator, TUInfo,
                                           IncludeBriefCommentsInCodeCompletion);
       CachedResult.ShowInContexts = getDeclShowContexts(Results[I].Declaration,
                                                         Ctx->getLangOpts(),
@@ -385,15 +905,19 @@ void ASTUnit::CacheCodeCompletionResults() {
         // temporary, CanQualType-based hash table to find the associated value.
         unsigned &TypeValue = CompletionTypes[CanUsageType];
         if (TypeValue == 0) {
-          TypeValue = CompletionTypes.size();
-          CachedCompletionTypes[QualType(CanUsageType).getAsString()]
-            = TypeValue;
+          unsigned &StoredValue
+            = CachedCompletionTypes[QualType(CanUsageType).getAsString()];
+          if (StoredValue == 0)
+            StoredValue = NextTypeValue++;
+          TypeValue = StoredValue;
         }
         
         CachedResult.Type = TypeValue;
       }
       
       CachedCompletionResults.push_back(CachedResult);
+      if (SharedResults)
+        SharedResults->push_back(CachedResult);
       
       /// Handle nested-name-specifiers in C++.
       if (TheSema->Context.getLangOpts().CPlusPlus && 
@@ -424,15 +948,16 @@ void ASTUnit::CacheCodeCompletionResults() {
           // nested-name-specifier completion.
           Results[I].StartsNestedNameSpecifier = true;
           CachedResult.Completion 
-            = Results[I].CreateCodeCompletionString(*TheSema,
-                                                    *CachedCompletionAllocator,
-                                                    getCodeCompletionTUInfo(),
+            = Results[I].CreateCodeCompletionString(*TheSema, Allocator,
+                                                    TUInfo,
                                         IncludeBriefCommentsInCodeCompletion);
           CachedResult.ShowInContexts = RemainingContexts;
           CachedResult.Priority = CCP_NestedNameSpecifier;
           CachedResult.TypeClass = STC_Void;
           CachedResult.Type = 0;
           CachedCompletionResults.push_back(CachedResult);
+          if (SharedResults)
+            SharedResults->push_back(CachedResult);
         }
       }
       break;
@@ -447,9 +972,7 @@ void ASTUnit::CacheCodeCompletionResults() {
     case Result::RK_Macro: {
       CachedCodeCompletionResult CachedResult;
       CachedResult.Completion 
-        = Results[I].CreateCodeCompletionString(*TheSema,
-                                                *CachedCompletionAllocator,
-                                                getCodeCompletionTUInfo(),
+        = Results[I].CreateCodeCompletionString(*TheSema, Allocator, TUInfo,
                                           IncludeBriefCommentsInCodeCompletion);
       CachedResult.ShowInContexts
         = (1LL << CodeCompletionContext::CCC_TopLevel)
@@ -471,10 +994,29 @@ void ASTUnit::CacheCodeCompletionResults() {
       CachedResult.TypeClass = STC_Void;
       CachedResult.Type = 0;
       CachedCompletionResults.push_back(CachedResult);
+      if (SharedResults)
+        SharedResults->push_back(CachedResult);
       break;
     }
     }
   }
+
+  if (BuildShared) {
+    // Keep the names of the types the shared completions have.
+    std::vector<bool> SharedTypes(NextTypeValue);
+    for (unsigned I = 0, N = Shared->Results.size(); I != N; ++I)
+      SharedTypes[Shared->Results[I].Type] = true;
+    for (llvm::StringMap<unsigned>::iterator T = CachedCompletionTypes.begin(),
+                                          TEnd = CachedCompletionTypes.end();
+         T != TEnd; ++T)
+      if (SharedTypes[T->second])
+        Shared->Types[T->first()] = T->second;
+
+    publishPreambleCompletions(Shared.getPtr());
+    if (PreambleCache *Cache = PreambleCache::getShared())
+      Cache->insertCompletions(Shared->Key, writePreambleCompletions(*Shared));
+  }
+  CachedPreambleCompletions = Shared;
   
   // Save the current top-level hash value.
   CompletionCacheTopLevelHashValue = CurrentTopLevelHashValue;
@@ -484,6 +1026,7 @@ void ASTUnit::ClearCachedCompletionResults() {
   CachedCompletionResults.clear();
   CachedCompletionTypes.clear();
   CachedCompletionAllocator = 0;
+  CachedPreambleCompletions = 0;
 }
 
 namespace {
@@ -1030,6 +1573,7 @@ static void checkAndSanitizeDiags(SmallVectorImpl<StoredDiagnostic> &
 bool ASTUnit::Parse(llvm::MemoryBuffer *OverrideMainBuffer) {
   delete SavedMainFileBuffer;
   SavedMainFileBuffer = 0;
+  FilesInMainFileParse.clear();
   
   if (!Invocation) {
     delete OverrideMainBuffer;
@@ -1150,6 +1694,7 @@ bool ASTUnit::Parse(llvm::MemoryBuffer *OverrideMainBuffer) {
   Act->EndSourceFile();
 
   FailedParseDiagnostics.clear();
+  recordFilesInMainFileParse();
 
   return false;
 
@@ -1293,6 +1838,57 @@ static llvm::MemoryBuffer *CreatePaddedMainFileBuffer(llvm::MemoryBuffer *Old,
   return Result;
 }
 
+/// \brief Compute the key under which the precompiled preamble for
+/// \p Invocation is stored in the PreambleCache.
+static std::string getPreambleCacheKey(const CompilerInvocation &Invocation,
+                                       StringRef PreambleText,
+                                       bool EndsAtStartOfLine,
+                                       ArrayRef<std::string> TargetFeatures) {
+  std::vector<std::string> Args;
+  Invocation.toArgs(Args);
+
+  std::string Key;
+  llvm::raw_string_ostream OS(Key);
+  OS << getClangFullRepositoryVersion() << '\n'
+     << Invocation.getFrontendOpts().Inputs[0].File << '\n';
+  for (unsigned I = 0, N = Args.size(); I != N; ++I)
+    OS << Args[I] << '\n';
+  for (unsigned I = 0, N = TargetFeatures.size(); I != N; ++I)
+    OS << TargetFeatures[I] << '\n';
+  OS << EndsAtStartOfLine << '\n' << PreambleText;
+  return OS.str();
+}
+
+/// \brief Determine whether the files a cached precompiled preamble was built
+/// from are unchanged on disk and not remapped by \p PPOpts.
+static bool areCachedPreambleInputsCurrent(FileManager &FileMgr,
+                                           const PreprocessorOptions &PPOpts,
+                                           const PreambleCache::Entry &Cached) {
+  llvm::StringSet<> RemappedFiles;
+  for (PreprocessorOptions::const_remapped_file_iterator
+            R = PPOpts.remapped_file_begin(),
+         REnd = PPOpts.remapped_file_end();
+       R != REnd; ++R)
+    RemappedFiles.insert(R->first);
+  for (PreprocessorOptions::const_remapped_file_buffer_iterator
+            R = PPOpts.remapped_file_buffer_begin(),
+         REnd = PPOpts.remapped_file_buffer_end();
+       R != REnd; ++R)
+    RemappedFiles.insert(R->first);
+
+  for (unsigned I = 0, N = Cached.Files.size(); I != N; ++I) {
+    const PreambleCache::InputFile &File = Cached.Files[I];
+    if (RemappedFiles.count(File.Name))
+      return false;
+
+    struct stat StatBuf;
+    if (FileMgr.getNoncachedStatValue(File.Name, StatBuf) ||
+        StatBuf.st_size != File.Size || StatBuf.st_mtime != File.ModTime)
+      return false;
+  }
+  return true;
+}
+
 /// \brief Attempt to build or re-use a precompiled preamble when (re-)parsing
 /// the source file.
 ///
@@ -1466,6 +2062,65 @@ llvm::MemoryBuffer *ASTUnit::getMainBufferWithPrecompiledPreamble(
     return 0;
   }
   
+  // Another ASTUnit of this process, or possibly of an earlier one, may have
+  // built this preamble already.
+  PreambleCache *Cache = PreambleCache::getShared();
+  std::string CacheKey
+    = getPreambleCacheKey(*PreambleInvocation,
+                          StringRef(NewPreamble.first->getBufferStart(),
+                                    NewPreamble.second.first),
+                          NewPreamble.second.second, TargetFeatures);
+  PreambleCache::Entry Cached;
+  if (linkSharedPreamble(CacheKey, PreamblePCHPath, Cached) ||
+      (Cache && Cache->lookup(CacheKey, PreamblePCHPath, Cached))) {
+    if (NewPreamble.first->getBufferSize() < Cached.ReservedSize - 2 &&
+        areCachedPreambleInputsCurrent(*FileMgr, PreprocessorOpts, Cached)) {
+      StringRef MainFilename = FrontendOpts.Inputs[0].File;
+      Preamble.assign(FileMgr->getFile(MainFilename),
+                      NewPreamble.first->getBufferStart(),
+                      NewPreamble.first->getBufferStart()
+                                                  + NewPreamble.second.first);
+      PreambleEndsAtStartOfLine = NewPreamble.second.second;
+      PreambleReservedSize = Cached.ReservedSize;
+      OriginalSourceFile = MainFilename;
+      setPreambleFile(this, PreamblePCHPath);
+      NumWarningsInPreamble = Cached.NumWarnings;
+      // Keep sharing the preamble if the ASTUnit which built it goes away.
+      registerSharedPreamble(CacheKey, PreamblePCHPath, Cached);
+
+      FilesInPreamble.clear();
+      for (unsigned I = 0, N = Cached.Files.size(); I != N; ++I)
+        FilesInPreamble[Cached.Files[I].Name]
+          = std::make_pair(Cached.Files[I].Size, Cached.Files[I].ModTime);
+
+      TopLevelDecls.clear();
+      TopLevelDeclsInPreamble.assign(Cached.TopLevelDecls.begin(),
+                                     Cached.TopLevelDecls.end());
+      PreambleDiagnostics.clear();
+      checkAndRemoveNonDriverDiags(StoredDiagnostics);
+
+      // Set the state of the diagnostic object to mimic its state
+      // after parsing the preamble.
+      getDiagnostics().Reset();
+      ProcessWarningOptions(getDiagnostics(),
+                            PreambleInvocation->getDiagnosticOpts());
+      getDiagnostics().setNumWarnings(NumWarningsInPreamble);
+
+      PreambleRebuildCounter = 1;
+      CurrentTopLevelHashValue = Cached.TopLevelHashValue;
+      if (CurrentTopLevelHashValue != PreambleTopLevelHashValue) {
+        CompletionCacheTopLevelHashValue = 0;
+        PreambleTopLevelHashValue = CurrentTopLevelHashValue;
+      }
+
+      return CreatePaddedMainFileBuffer(NewPreamble.first,
+                                        PreambleReservedSize,
+                                        FrontendOpts.Inputs[0].File);
+    }
+
+    llvm::sys::Path(PreamblePCHPath).eraseFromDisk();
+  }
+
   // We did not previously compute a preamble, or it can't be reused anyway.
   SimpleTimer PreambleTimer(WantTiming);
   PreambleTimer.setOutput("Precompiling preamble");
@@ -1622,6 +2277,32 @@ llvm::MemoryBuffer *ASTUnit::getMainBufferWithPrecompiledPreamble(
   PreambleRebuildCounter = 1;
   PreprocessorOpts.eraseRemappedFile(
                                PreprocessorOpts.remapped_file_buffer_end() - 1);
+
+  // Preambles that produced diagnostics are not cached or shared, since the
+  // cache would have to replay them; neither are preambles built from
+  // remapped files.
+  if (PreambleDiagnostics.empty()) {
+    PreambleCache::Entry Built;
+    Built.ReservedSize = PreambleReservedSize;
+    Built.NumWarnings = NumWarningsInPreamble;
+    Built.TopLevelHashValue = CurrentTopLevelHashValue;
+    Built.TopLevelDecls.assign(TopLevelDeclsInPreamble.begin(),
+                               TopLevelDeclsInPreamble.end());
+    for (llvm::StringMap<std::pair<off_t, time_t> >::iterator
+           F = FilesInPreamble.begin(), FEnd = FilesInPreamble.end();
+         F != FEnd; ++F) {
+      PreambleCache::InputFile File;
+      File.Name = F->first();
+      File.Size = F->second.first;
+      File.ModTime = F->second.second;
+      Built.Files.push_back(File);
+    }
+    if (areCachedPreambleInputsCurrent(*FileMgr, PreprocessorOpts, Built)) {
+      registerSharedPreamble(CacheKey, PreamblePCHPath, Built);
+      if (Cache)
+        Cache->insert(CacheKey, PreamblePCHPath, Built);
+    }
+  }
   
   // If the hash of top-level entities differs from the hash of the top-level
   // entities the last time we rebuilt the preamble, clear out the completion
@@ -1636,6 +2317,145 @@ llvm::MemoryBuffer *ASTUnit::getMainBufferWithPrecompiledPreamble(
                                     FrontendOpts.Inputs[0].File);
 }
 
+/// \brief Copy \p In for use on another thread.
+///
+/// Unlike the copy constructor, this does not share the analyzer options
+/// (which are reference counted without synchronization) and copies the
+/// remapped file buffers, which the original owner may free at any time.
+static CompilerInvocation *
+createIndependentInvocation(const CompilerInvocation &In) {
+  CompilerInvocation *CI = new CompilerInvocation();
+  *CI->getLangOpts() = *In.getLangOpts();
+  CI->getMigratorOpts() = In.getMigratorOpts();
+  CI->getCodeGenOpts() = In.getCodeGenOpts();
+  CI->getDependencyOutputOpts() = In.getDependencyOutputOpts();
+  CI->getDiagnosticOpts() = In.getDiagnosticOpts();
+  CI->getFileSystemOpts() = In.getFileSystemOpts();
+  CI->getHeaderSearchOpts() = In.getHeaderSearchOpts();
+  CI->getFrontendOpts() = In.getFrontendOpts();
+  CI->getPreprocessorOutputOpts() = In.getPreprocessorOutputOpts();
+  CI->getTargetOpts() = In.getTargetOpts();
+
+  const PreprocessorOptions &InPPOpts = In.getPreprocessorOpts();
+  PreprocessorOptions &PPOpts = CI->getPreprocessorOpts();
+  PPOpts = InPPOpts;
+  PPOpts.clearRemappedFiles();
+  for (PreprocessorOptions::const_remapped_file_iterator
+            R = InPPOpts.remapped_file_begin(),
+         REnd = InPPOpts.remapped_file_end();
+       R != REnd; ++R)
+    PPOpts.addRemappedFile(R->first, R->second);
+  for (PreprocessorOptions::const_remapped_file_buffer_iterator
+            R = InPPOpts.remapped_file_buffer_begin(),
+         REnd = InPPOpts.remapped_file_buffer_end();
+       R != REnd; ++R)
+    PPOpts.addRemappedFile(R->first,
+        llvm::MemoryBuffer::getMemBufferCopy(R->second->getBuffer(),
+                                             R->second->getBufferIdentifier()));
+  return CI;
+}
+
+/// \brief Start building the precompiled preamble on a background thread.
+///
+/// \returns false if no thread could be started, in which case the caller
+/// should build the preamble itself.
+bool ASTUnit::startBackgroundPreambleBuild() {
+  // Only one build at a time; the next Reparse() will adopt it and start
+  // another one if the preamble changed in the meantime.
+  if (PendingPreambleBuild)
+    return true;
+
+  // If we previously failed to build a preamble, honor the same back-off as
+  // getMainBufferWithPrecompiledPreamble().
+  if (PreambleRebuildCounter > 1) {
+    --PreambleRebuildCounter;
+    return true;
+  }
+
+  // Don't start a thread when the main file has no preamble to build; a later
+  // Reparse() starts one once it has.
+  bool CreatedPreambleBuffer = false;
+  std::pair<llvm::MemoryBuffer *, std::pair<unsigned, bool> > NewPreamble
+    = ComputePreamble(*Invocation, 0, CreatedPreambleBuffer);
+  if (CreatedPreambleBuffer)
+    delete NewPreamble.first;
+  if (!NewPreamble.second.first)
+    return true;
+
+  OwningPtr<ASTUnit> Builder(new ASTUnit(false));
+  Builder->Invocation = createIndependentInvocation(*Invocation);
+  Builder->FileSystemOpts = Builder->Invocation->getFileSystemOpts();
+  Builder->FileMgr = new FileManager(Builder->FileSystemOpts);
+  Builder->TargetFeatures = TargetFeatures;
+  Builder->CaptureDiagnostics = CaptureDiagnostics;
+  Builder->UserFilesAreVolatile = UserFilesAreVolatile;
+  Builder->PreambleRebuildCounter = 1;
+  ConfigureDiags(Builder->Diagnostics, 0, 0, *Builder, CaptureDiagnostics);
+
+  OwningPtr<BackgroundPreambleBuild> Build(new BackgroundPreambleBuild());
+  Build->Builder.reset(Builder.take());
+  if (!Build->Thread.start(BackgroundPreambleBuild::run, Build.get(),
+                           /*StackSize=*/8 << 20))
+    return false;
+
+  PendingPreambleBuild.reset(Build.take());
+  return true;
+}
+
+/// \brief If the background preamble build has finished, use its result.
+void ASTUnit::adoptBackgroundPreamble() {
+  if (!PendingPreambleBuild || !PendingPreambleBuild->isFinished())
+    return;
+
+  OwningPtr<BackgroundPreambleBuild> Build(PendingPreambleBuild.take());
+  Build->Thread.join();
+  if (Build->Crashed) {
+    PreambleRebuildCounter = DefaultPreambleRebuildInterval;
+    return;
+  }
+
+  ASTUnit &Builder = *Build->Builder;
+  std::string PreambleFile = getPreambleFile(&Builder);
+  if (Builder.Preamble.empty() || PreambleFile.empty()) {
+    // There was no preamble, or it could not be built.
+    PreambleRebuildCounter = Builder.PreambleRebuildCounter;
+    return;
+  }
+
+  // Take over the precompiled preamble file from the builder.
+  getOnDiskData(&Builder).PreambleFile.clear();
+  erasePreambleFile(this);
+  setPreambleFile(this, PreambleFile);
+
+  Preamble.assign(FileMgr->getFile(Builder.OriginalSourceFile),
+                  Builder.Preamble.getBufferStart(),
+                  Builder.Preamble.getBufferStart() + Builder.Preamble.size());
+  PreambleEndsAtStartOfLine = Builder.PreambleEndsAtStartOfLine;
+  PreambleReservedSize = Builder.PreambleReservedSize;
+  NumWarningsInPreamble = Builder.NumWarningsInPreamble;
+  PreambleDiagnostics = Builder.PreambleDiagnostics;
+  TopLevelDeclsInPreamble = Builder.TopLevelDeclsInPreamble;
+
+  FilesInPreamble.clear();
+  for (llvm::StringMap<std::pair<off_t, time_t> >::iterator
+         F = Builder.FilesInPreamble.begin(),
+         FEnd = Builder.FilesInPreamble.end();
+       F != FEnd; ++F)
+    FilesInPreamble[F->first()] = F->second;
+
+  PreambleRebuildCounter = 1;
+  CurrentTopLevelHashValue = Builder.CurrentTopLevelHashValue;
+  if (CurrentTopLevelHashValue != PreambleTopLevelHashValue) {
+    CompletionCacheTopLevelHashValue = 0;
+    PreambleTopLevelHashValue = CurrentTopLevelHashValue;
+  }
+}
+
+void ASTUnit::waitForBackgroundPreamble() {
+  if (PendingPreambleBuild)
+    PendingPreambleBuild->Thread.join();
+}
+
 void ASTUnit::RealizeTopLevelDeclsFromPreamble() {
   std::vector<Decl *> Resolved;
   Resolved.reserve(TopLevelDeclsInPreamble.size());
@@ -1991,10 +2811,151 @@ ASTUnit *ASTUnit::LoadFromCommandLine(const char **ArgBegin,
   return AST.take();
 }
 
+/// \brief Remember the size and modification time of the files read by the
+/// parse of the main file which just finished.
+void ASTUnit::recordFilesInMainFileParse() {
+  FilesInMainFileParse.clear();
+  for (SourceManager::fileinfo_iterator I = SourceMgr->fileinfo_begin(),
+                                        E = SourceMgr->fileinfo_end();
+       I != E; ++I) {
+    const FileEntry *File = I->second->OrigEntry;
+    if (!File)
+      continue;
+    FilesInMainFileParse[File->getName()]
+      = std::make_pair(File->getSize(), File->getModificationTime());
+  }
+}
+
+/// \brief Whether reparsing with the given remapped files would produce the
+/// same AST as the last parse, because none of its inputs have changed.
+bool ASTUnit::canReuseAST(RemappedFile *RemappedFiles,
+                          unsigned NumRemappedFiles) {
+  if (FilesInMainFileParse.empty() || !Ctx)
+    return false;
+
+  // A preamble build is pending or about to be tried.
+  if (PendingPreambleBuild ||
+      (getPreambleFile(this).empty() && PreambleRebuildCounter > 0))
+    return false;
+
+  // The files must be remapped to the same contents as last time.  Files
+  // remapped to other files are rare enough not to bother.
+  PreprocessorOptions &PPOpts = Invocation->getPreprocessorOpts();
+  if (PPOpts.remapped_file_begin() != PPOpts.remapped_file_end())
+    return false;
+  unsigned NumOldRemappedFiles = PPOpts.remapped_file_buffer_end() -
+                                 PPOpts.remapped_file_buffer_begin();
+  if (NumOldRemappedFiles != NumRemappedFiles)
+    return false;
+  llvm::StringSet<> Remapped;
+  for (unsigned I = 0; I != NumRemappedFiles; ++I) {
+    const llvm::MemoryBuffer *Buffer
+      = RemappedFiles[I].second.dyn_cast<const llvm::MemoryBuffer *>();
+    if (!Buffer)
+      return false;
+
+    PreprocessorOptions::remapped_file_buffer_iterator
+      Old = PPOpts.remapped_file_buffer_begin(),
+      OldEnd = PPOpts.remapped_file_buffer_end();
+    while (Old != OldEnd && Old->first != RemappedFiles[I].first)
+      ++Old;
+    if (Old == OldEnd || Old->second->getBuffer() != Buffer->getBuffer())
+      return false;
+    Remapped.insert(RemappedFiles[I].first);
+  }
+
+  // The other files read by the last parse, including those of the
+  // preamble, must be unchanged on disk.
+  const llvm::StringMap<std::pair<off_t, time_t> > *Files[] = {
+    &FilesInMainFileParse, &FilesInPreamble
+  };
+  for (unsigned I = 0; I != llvm::array_lengthof(Files); ++I) {
+    for (llvm::StringMap<std::pair<off_t, time_t> >::const_iterator
+           F = Files[I]->begin(), FEnd = Files[I]->end();
+         F != FEnd; ++F) {
+      if (Remapped.count(F->first()))
+        continue;
+
+      struct stat StatBuf;
+      if (FileMgr->getNoncachedStatValue(F->first(), StatBuf) ||
+          StatBuf.st_size != F->second.first ||
+          StatBuf.st_mtime != F->second.second)
+        return false;
+    }
+  }
+
+  return true;
+}
+
+bool ASTUnit::unloadAST() {
+  if (!Invocation || MainFileIsAST || UnsafeToFree)
+    return true;
+  if (ASTUnloaded)
+    return false;
+
+  clearFileLevelDecls();
+  TopLevelDecls.clear();
+  ClearCachedCompletionResults();
+  CompletionCacheTopLevelHashValue = 0;
+  CCTUInfo.reset();
+
+  // The semantic analysis and the consumer refer to the context and the
+  // preprocessor.
+  TheSema.reset();
+  Consumer.reset();
+  Ctx = 0;
+  PP = 0;
+  Reader = 0;
+  ASTUnloaded = true;
+  return false;
+}
+
+bool ASTUnit::reloadAST() {
+  if (!ASTUnloaded)
+    return false;
+  ASTUnloaded = false;
+
+  // Reparse() frees the remapped files before it installs the ones it is
+  // given, so give it copies.
+  PreprocessorOptions &PPOpts = Invocation->getPreprocessorOpts();
+  std::vector<std::string> RemappedTargets;
+  for (PreprocessorOptions::remapped_file_iterator
+         R = PPOpts.remapped_file_begin(), REnd = PPOpts.remapped_file_end();
+       R != REnd; ++R)
+    RemappedTargets.push_back(R->second);
+
+  SmallVector<RemappedFile, 4> Remapped;
+  unsigned I = 0;
+  for (PreprocessorOptions::remapped_file_iterator
+         R = PPOpts.remapped_file_begin(), REnd = PPOpts.remapped_file_end();
+       R != REnd; ++R, ++I)
+    Remapped.push_back(RemappedFile(R->first, RemappedTargets[I].c_str()));
+  for (PreprocessorOptions::remapped_file_buffer_iterator
+         R = PPOpts.remapped_file_buffer_begin(),
+         REnd = PPOpts.remapped_file_buffer_end();
+       R != REnd; ++R) {
+    const llvm::MemoryBuffer *Copy
+      = llvm::MemoryBuffer::getMemBufferCopy(R->second->getBuffer(),
+                                             R->second->getBufferIdentifier());
+    Remapped.push_back(RemappedFile(R->first, Copy));
+  }
+
+  return Reparse(Remapped.data(), Remapped.size());
+}
+
 bool ASTUnit::Reparse(RemappedFile *RemappedFiles, unsigned NumRemappedFiles) {
   if (!Invocation)
     return true;
 
+  // If nothing changed since the last parse, keep its AST and diagnostics.
+  // The remapped buffers are ours to free, but the AST still refers to the
+  // ones it was parsed from.
+  if (canReuseAST(RemappedFiles, NumRemappedFiles)) {
+    for (unsigned I = 0; I != NumRemappedFiles; ++I)
+      delete RemappedFiles[I].second.get<const llvm::MemoryBuffer *>();
+    return false;
+  }
+
   clearFileLevelDecls();
   
   SimpleTimer ParsingTimer(WantTiming);
@@ -2027,8 +2988,19 @@ bool ASTUnit::Reparse(RemappedFile *RemappedFiles, unsigned NumRemappedFiles) {
   // If we have a preamble file lying around, or if we might try to
   // build a precompiled preamble, do so now.
   llvm::MemoryBuffer *OverrideMainBuffer = 0;
-  if (!getPreambleFile(this).empty() || PreambleRebuildCounter > 0)
-    OverrideMainBuffer = getMainBufferWithPrecompiledPreamble(*Invocation);
+  if (!getPreambleFile(this).empty() || PreambleRebuildCounter > 0) {
+    if (BackgroundPreambleRebuild) {
+      // Never wait for the preamble: use the current one if it is still valid,
+      // and otherwise parse without one while a new one is built.
+      adoptBackgroundPreamble();
+      OverrideMainBuffer
+        = getMainBufferWithPrecompiledPreamble(*Invocation,
+                                               /*AllowRebuild=*/false);
+      if (!OverrideMainBuffer && !startBackgroundPreambleBuild())
+        OverrideMainBuffer = getMainBufferWithPrecompiledPreamble(*Invocation);
+    } else
+      OverrideMainBuffer = getMainBufferWithPrecompiledPreamble(*Invocation);
+  }
     
   // Clear out the diagnostics state.
   getDiagnostics().Reset();
@@ -2221,6 +3193,13 @@ void AugmentedCodeCompleteConsumer::ProcessCodeCompleteResults(Sema &S,
     // interested in, we'll add this result.
     if ((C->ShowInContexts & InContexts) == 0)
       continue;
+
+    // Skip the results that can't match the text the user typed.
+    if (!getFilterPrefix().empty()) {
+      const char *TypedText = C->Completion->getTypedText();
+      if (!TypedText || !matchesFilter(TypedText))
+        continue;
+    }
     
     // If we haven't added any results previously, do so now.
     if (!AddedResult) {
@@ -2324,6 +3303,8 @@ void ASTUnit::CodeComplete(StringRef File, unsigned Line, unsigned Column,
   CodeCompleteOpts.IncludeCodePatterns = IncludeCodePatterns;
   CodeCompleteOpts.IncludeGlobals = CachedCompletionResults.empty();
   CodeCompleteOpts.IncludeBriefComments = IncludeBriefComments;
+  CodeCompleteOpts.FilterPrefix = Consumer.getFilterPrefix();
+  CodeCompleteOpts.FuzzyFilter = Consumer.isFuzzyFilter();
 
   assert(IncludeBriefComments == this->IncludeBriefCommentsInCodeCompletion);
 
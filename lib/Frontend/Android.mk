@@ -29,6 +29,7 @@ clang_frontend_SRC_FILES := \
   ChainedIncludesSource.cpp \
   CompilerInstance.cpp \
   CompilerInvocation.cpp \
+  CompilerInvocationSerialization.cpp \
   CreateInvocationFromCommandLine.cpp \
   DependencyFile.cpp \
   DependencyGraph.cpp \
@@ -36,6 +37,7 @@ clang_frontend_SRC_FILES := \
   FrontendAction.cpp \
   FrontendActions.cpp \
   FrontendOptions.cpp \
+  HeaderCostTracker.cpp \
   HeaderIncludeGen.cpp \
   InitHeaderSearch.cpp \
   InitPreprocessor.cpp \
@@ -43,6 +45,7 @@ clang_frontend_SRC_FILES := \
   LayoutOverrideSource.cpp \
   LogDiagnosticPrinter.cpp \
   MultiplexConsumer.cpp \
+  PreambleCache.cpp \
   PrintPreprocessedOutput.cpp \
   SerializedDiagnosticPrinter.cpp \
   TextDiagnostic.cpp \
@@ -8,7 +8,8 @@
 //===----------------------------------------------------------------------===//
 //
 //  This file defines the ChainedIncludesSource class, which converts headers
-//  to chained PCHs in memory, mainly used for testing.
+//  to chained PCHs in memory, mainly used for testing, and optionally keeps
+//  them in a cache directory to rebuild only the layers that changed.
 //
 //===----------------------------------------------------------------------===//
 
@@ -20,8 +21,17 @@
 #include "clang/Serialization/ASTWriter.h"
 #include "clang/Parse/ParseAST.h"
 #include "clang/Lex/Preprocessor.h"
+#include "clang/Basic/FileManager.h"
+#include "clang/Basic/MD5.h"
+#include "clang/Basic/SourceManager.h"
 #include "clang/Basic/TargetInfo.h"
+#include "llvm/ADT/SmallString.h"
+#include "llvm/ADT/StringExtras.h"
+#include "llvm/Support/FileSystem.h"
 #include "llvm/Support/MemoryBuffer.h"
+#include "llvm/Support/Path.h"
+#include "llvm/Support/raw_ostream.h"
+#include "llvm/Support/system_error.h"
 
 using namespace clang;
 
@@ -52,6 +62,150 @@ static ASTReader *createASTReader(CompilerInstance &CI,
   return 0;
 }
 
+//===----------------------------------------------------------------------===//
+// The cache of layers.
+//===----------------------------------------------------------------------===//
+
+// With -chain-include-cache, each layer is kept in the cache directory as the
+// PCH itself, "<header>-<hash>.pch", and a manifest "<header>-<hash>.pch.deps"
+// holding the key of the layer, its size on the first line, followed by one
+// line per file the layer was built from, "size<tab>mtime<tab>path".
+//
+// The key is the invocation that builds the layer, together with the hash of
+// the layer below it, so that a layer is reused only on top of the very layer
+// it was built on: once a layer is rebuilt, the ones above it are rebuilt as
+// well, unless the rebuilt layer came out the same.
+
+/// Returns the key of the layer built by \p Invocation on top of a layer
+/// whose contents hash to \p BelowHash, or the empty string if the layer
+/// cannot be cached.
+static std::string getLayerKey(const CompilerInvocation &Invocation,
+                               StringRef BelowHash) {
+  // Leave out what only matters to the translation unit, so that the layers
+  // are shared by all those that chain the same headers.
+  CompilerInvocation KeyInvocation(Invocation);
+  KeyInvocation.getFrontendOpts().OutputFile.clear();
+  KeyInvocation.getDependencyOutputOpts() = DependencyOutputOptions();
+  KeyInvocation.getDiagnosticOpts().DiagnosticLogFile.clear();
+  KeyInvocation.getDiagnosticOpts().DiagnosticSerializationFile.clear();
+  KeyInvocation.getCodeGenOpts().MainFileName.clear();
+
+  SmallString<1024> Key;
+  if (!KeyInvocation.serialize(Key))
+    return std::string();
+  Key += BelowHash;
+  return Key.str();
+}
+
+/// Returns the size and the MD5 digest of \p Buffer. The layers below a
+/// cached one are identified by this alone, so a weaker hash would let a
+/// rebuilt lower layer be mistaken for the one it replaced.
+static std::string getBufferHash(const llvm::MemoryBuffer *Buffer) {
+  uint32_t Digest[4];
+  MD5::hash(Buffer->getBuffer(), Digest);
+  std::string Hash = llvm::utohexstr(Buffer->getBufferSize());
+  for (unsigned I = 0; I != 4; ++I)
+    Hash += "-" + llvm::utohexstr(Digest[I]);
+  return Hash;
+}
+
+static std::string getLayerPath(StringRef CacheDir, StringRef Include,
+                                StringRef Key) {
+  SmallString<256> Path(CacheDir);
+  llvm::sys::path::append(Path, llvm::sys::path::filename(Include).str() +
+                                "-" + llvm::utohexstr(llvm::HashString(Key)) +
+                                ".pch");
+  return Path.str();
+}
+
+/// Returns the layer cached at \p Path, or null if it has another key or any
+/// of the files it was built from changed.
+///
+/// FIXME: Like PTH, this should also notice new headers that would now be
+/// found before those the layer was built from.
+static llvm::MemoryBuffer *readCachedLayer(StringRef Path, StringRef Key) {
+  OwningPtr<llvm::MemoryBuffer> Manifest;
+  if (llvm::MemoryBuffer::getFile((Path + ".deps").str(), Manifest))
+    return 0;
+
+  StringRef Line, Rest = Manifest->getBuffer();
+  llvm::tie(Line, Rest) = Rest.split('\n');
+  unsigned KeySize;
+  if (Line.getAsInteger(10, KeySize) || !Rest.startswith(Key) ||
+      KeySize != Key.size())
+    return 0;
+  Rest = Rest.substr(KeySize);
+
+  while (!Rest.empty()) {
+    llvm::tie(Line, Rest) = Rest.split('\n');
+    SmallVector<StringRef, 3> Fields;
+    Line.split(Fields, "\t", /*MaxSplit=*/2);
+    long long Size, ModTime;
+    if (Fields.size() != 3 || Fields[0].getAsInteger(10, Size) ||
+        Fields[1].getAsInteger(10, ModTime))
+      return 0;
+
+    llvm::sys::PathWithStatus FilePath(Fields[2]);
+    const llvm::sys::FileStatus *Status = FilePath.getFileStatus();
+    if (!Status || (long long)Status->getSize() != Size ||
+        (long long)Status->getTimestamp().toEpochTime() != ModTime)
+      return 0;
+  }
+
+  OwningPtr<llvm::MemoryBuffer> Layer;
+  if (llvm::MemoryBuffer::getFile(Path, Layer))
+    return 0;
+  return Layer.take();
+}
+
+/// Write \p Contents to \p Path through a temporary file, so that others
+/// never read it partially written.
+static bool writeFileAtomically(StringRef Path, StringRef Contents) {
+  SmallString<128> TempPath(Path);
+  TempPath += "-%%%%%%%%";
+  int FD;
+  if (llvm::sys::fs::unique_file(TempPath.str(), FD, TempPath,
+                                 /*makeAbsolute=*/false))
+    return false;
+
+  llvm::raw_fd_ostream Out(FD, /*shouldClose=*/true);
+  Out << Contents;
+  Out.close();
+  bool Existed;
+  if (Out.has_error()) {
+    Out.clear_error();
+    llvm::sys::fs::remove(TempPath.str(), Existed);
+    return false;
+  }
+
+  if (llvm::sys::fs::rename(TempPath.str(), Path)) {
+    llvm::sys::fs::remove(TempPath.str(), Existed);
+    return false;
+  }
+  return true;
+}
+
+/// Store the layer \p Layer built from the files of \p SM at \p Path.
+/// Failures only cost a rebuild next time, so they are ignored.
+static void writeCachedLayer(StringRef Path, StringRef Key, StringRef Layer,
+                             const SourceManager &SM) {
+  std::string Manifest;
+  llvm::raw_string_ostream OS(Manifest);
+  OS << Key.size() << '\n' << Key;
+  for (SourceManager::fileinfo_iterator I = SM.fileinfo_begin(),
+                                        E = SM.fileinfo_end();
+       I != E; ++I) {
+    OS << I->first->getSize() << '\t'
+       << (long long)I->first->getModificationTime() << '\t'
+       << I->first->getName() << '\n';
+  }
+  OS.flush();
+
+  // Write the layer first, so that a manifest never describes a missing one.
+  if (writeFileAtomically(Path, Layer))
+    writeFileAtomically((Path + ".deps").str(), Manifest);
+}
+
 ChainedIncludesSource::~ChainedIncludesSource() {
   for (unsigned i = 0, e = CIs.size(); i != e; ++i)
     delete CIs[i];
@@ -68,12 +222,29 @@ ChainedIncludesSource *ChainedIncludesSource::create(CompilerInstance &CI) {
   SmallVector<llvm::MemoryBuffer *, 4> serialBufs;
   SmallVector<std::string, 4> serialBufNames;
 
+  StringRef cacheDir = CI.getPreprocessorOpts().ChainedIncludesCache;
+  if (!cacheDir.empty()) {
+    bool existed;
+    if (llvm::sys::fs::create_directories(cacheDir, existed))
+      cacheDir = StringRef();
+  }
+
   for (unsigned i = 0, e = includes.size(); i != e; ++i) {
     bool firstInclude = (i == 0);
+    if (!firstInclude) {
+      std::string pchName = includes[i-1];
+      llvm::raw_string_ostream os(pchName);
+      os << ".pch" << i-1;
+      os.flush();
+
+      serialBufNames.push_back(pchName);
+    }
+
     OwningPtr<CompilerInvocation> CInvok;
     CInvok.reset(new CompilerInvocation(CI.getInvocation()));
     
     CInvok->getPreprocessorOpts().ChainedIncludes.clear();
+    CInvok->getPreprocessorOpts().ChainedIncludesCache.clear();
     CInvok->getPreprocessorOpts().ImplicitPCHInclude.clear();
     CInvok->getPreprocessorOpts().ImplicitPTHInclude.clear();
     CInvok->getPreprocessorOpts().DisablePCHValidation = true;
@@ -85,6 +256,18 @@ ChainedIncludesSource *ChainedIncludesSource::create(CompilerInstance &CI) {
     CInvok->getFrontendOpts().Inputs.push_back(FrontendInputFile(includes[i],
                                                                  IK));
 
+    std::string layerKey, layerPath;
+    if (!cacheDir.empty())
+      layerKey = getLayerKey(*CInvok, firstInclude ? std::string() :
+                                          getBufferHash(serialBufs.back()));
+    if (!layerKey.empty()) {
+      layerPath = getLayerPath(cacheDir, includes[i], layerKey);
+      if (llvm::MemoryBuffer *layer = readCachedLayer(layerPath, layerKey)) {
+        serialBufs.push_back(layer);
+        continue;
+      }
+    }
+
     TextDiagnosticPrinter *DiagClient =
       new TextDiagnosticPrinter(llvm::errs(), DiagnosticOptions());
     IntrusiveRefCntPtr<DiagnosticIDs> DiagID(new DiagnosticIDs());
@@ -125,20 +308,18 @@ ChainedIncludesSource *ChainedIncludesSource::create(CompilerInstance &CI) {
                              StringRef(serialBufs[si]->getBufferStart(),
                                              serialBufs[si]->getBufferSize())));
       }
-      std::string pchName = includes[i-1];
-      llvm::raw_string_ostream os(pchName);
-      os << ".pch" << i-1;
-      os.flush();
-      
-      serialBufNames.push_back(pchName);
-
       OwningPtr<ExternalASTSource> Reader;
 
-      Reader.reset(createASTReader(*Clang, pchName, bufs, serialBufNames, 
+      Reader.reset(createASTReader(*Clang, serialBufNames.back(), bufs,
+                                   serialBufNames,
         Clang->getASTConsumer().GetASTDeserializationListener()));
       if (!Reader)
         return 0;
       Clang->getASTContext().setExternalSource(Reader);
+      Preprocessor &PP = Clang->getPreprocessor();
+      PP.getBuiltinInfo().InitializeBuiltins(PP.getIdentifierTable(),
+                                             PP.getLangOpts(),
+                                             /*OnlyNewIdentifiers=*/true);
     }
     
     if (!Clang->InitializeSourceManager(includes[i]))
@@ -147,6 +328,10 @@ ChainedIncludesSource *ChainedIncludesSource::create(CompilerInstance &CI) {
     ParseAST(Clang->getSema());
     OS.flush();
     Clang->getDiagnosticClient().EndSourceFile();
+    if (!layerPath.empty() && !Clang->getDiagnostics().hasErrorOccurred())
+      writeCachedLayer(layerPath, layerKey,
+                       StringRef(serialAST.data(), serialAST.size()),
+                       Clang->getSourceManager());
     serialBufs.push_back(
       llvm::MemoryBuffer::getMemBufferCopy(StringRef(serialAST.data(),
                                                            serialAST.size())));
@@ -214,6 +399,10 @@ void ChainedIncludesSource::StartTranslationUnit(ASTConsumer *Consumer) {
 void ChainedIncludesSource::PrintStats() {
   return getFinalReader().PrintStats();
 }
+const ASTRecordLayout *
+ChainedIncludesSource::getRecordLayout(const RecordDecl *Record) {
+  return getFinalReader().getRecordLayout(Record);
+}
 void ChainedIncludesSource::getMemoryBufferSizes(MemoryBufferSizes &sizes)const{
   for (unsigned i = 0, e = CIs.size(); i != e; ++i) {
     if (const ExternalASTSource *eSrc =
@@ -12,8 +12,12 @@
 #include "clang/AST/ASTConsumer.h"
 #include "clang/AST/ASTContext.h"
 #include "clang/AST/Decl.h"
+#include "clang/Basic/CompilationProfile.h"
 #include "clang/Basic/Diagnostic.h"
 #include "clang/Basic/FileManager.h"
+#include "clang/Basic/FilePrefetcher.h"
+#include "clang/Basic/FileSystemStatCache.h"
+#include "clang/Basic/Parallel.h"
 #include "clang/Basic/SourceManager.h"
 #include "clang/Basic/TargetInfo.h"
 #include "clang/Basic/Version.h"
@@ -24,6 +28,7 @@
 #include "clang/Frontend/FrontendAction.h"
 #include "clang/Frontend/FrontendActions.h"
 #include "clang/Frontend/FrontendDiagnostic.h"
+#include "clang/Frontend/HeaderCostTracker.h"
 #include "clang/Frontend/LogDiagnosticPrinter.h"
 #include "clang/Frontend/SerializedDiagnosticPrinter.h"
 #include "clang/Frontend/TextDiagnosticPrinter.h"
@@ -35,6 +40,8 @@
 #include "llvm/Support/MemoryBuffer.h"
 #include "llvm/Support/raw_ostream.h"
 #include "llvm/ADT/Statistic.h"
+#include "llvm/ADT/StringSet.h"
+#include "llvm/Support/Atomic.h"
 #include "llvm/Support/Timer.h"
 #include "llvm/Support/Host.h"
 #include "llvm/Support/LockFileManager.h"
@@ -44,6 +51,8 @@
 #include "llvm/Support/system_error.h"
 #include "llvm/Support/CrashRecoveryContext.h"
 #include "llvm/Config/config.h"
+#include <algorithm>
+#include <cctype>
 
 using namespace clang;
 
@@ -222,24 +231,152 @@ CompilerInstance::createDiagnostics(const DiagnosticOptions &Opts,
 
 void CompilerInstance::createFileManager() {
   FileMgr = new FileManager(getFileSystemOpts());
+
+  // Files that changed since an earlier compile cached them are noticed when
+  // they are opened. Files that were created since are only found after
+  // SharedStatCache::invalidate().
+  if (getFileSystemOpts().UseSharedStatCache)
+    FileMgr->addStatCache(new SharedStatCache(/*CacheMissingPaths=*/true,
+                                              /*ValidateOnOpen=*/true));
+
+  StringRef ListFile = getFileSystemOpts().PrefetchFileList;
+  if (!ListFile.empty()) {
+    std::vector<std::string> Paths;
+    if (!FilePrefetcher::readFileList(ListFile, Paths)) {
+      if (hasDiagnostics())
+        getDiagnostics().Report(diag::err_fe_error_reading) << ListFile;
+    } else
+      FileMgr->setPrefetcher(new FilePrefetcher(Paths));
+  }
 }
 
 // Source Manager
 
 void CompilerInstance::createSourceManager(FileManager &FileMgr) {
   SourceMgr = new SourceManager(getDiagnostics(), FileMgr);
+  SourceMgr->setReleaseFinishedBuffers(getFrontendOpts().ReleaseSourceBuffers);
 }
 
 // Preprocessor
 
+/// \brief Determine the appropriate source input kind based on language
+/// options.
+static InputKind getSourceInputKindFromOptions(const LangOptions &LangOpts) {
+  if (LangOpts.OpenCL)
+    return IK_OpenCL;
+  if (LangOpts.CUDA)
+    return IK_CUDA;
+  if (LangOpts.ObjC1)
+    return LangOpts.CPlusPlus? IK_ObjCXX : IK_ObjC;
+  return LangOpts.CPlusPlus? IK_CXX : IK_C;
+}
+
+namespace {
+  struct RebuildTokenCacheData {
+    CompilerInstance &Instance;
+    GeneratePTHAction &Action;
+  };
+}
+
+/// \brief Helper function that executes the PTH-generating action under a
+/// crash recovery context.
+static void doRebuildTokenCache(void *UserData) {
+  RebuildTokenCacheData &Data
+    = *reinterpret_cast<RebuildTokenCacheData *>(UserData);
+  Data.Instance.ExecuteAction(Data.Action);
+}
+
+/// \brief Regenerate the PTH file \p TokenCacheFile from \p SourceFile, using
+/// the options of the compiler instance that wants to use it.
+///
+/// Concurrent compilations that find the same PTH file out of date wait for
+/// the first one to regenerate it.  The new file replaces the old one
+/// atomically, so other processes never map a partially written cache.
+static bool rebuildTokenCache(CompilerInstance &UsingInstance,
+                              StringRef SourceFile,
+                              StringRef TokenCacheFile) {
+  llvm::LockFileManager Locked(TokenCacheFile);
+  switch (Locked) {
+  case llvm::LockFileManager::LFS_Error:
+    return false;
+
+  case llvm::LockFileManager::LFS_Owned:
+    // We're responsible for regenerating the cache. Do so below.
+    break;
+
+  case llvm::LockFileManager::LFS_Shared:
+    // Someone else is regenerating the cache. Wait for them to finish.
+    Locked.waitForUnlock();
+    return true;
+  }
+
+  IntrusiveRefCntPtr<CompilerInvocation> Invocation
+    (new CompilerInvocation(UsingInstance.getInvocation()));
+
+  // Tokenize the header on its own, without any token cache.
+  PreprocessorOptions &PPOpts = Invocation->getPreprocessorOpts();
+  PPOpts.ImplicitPTHInclude.clear();
+  PPOpts.TokenCache.clear();
+  PPOpts.RebuildStaleTokenCache = false;
+
+  // Don't free the remapped file buffers; they are owned by our caller.
+  PPOpts.RetainRemappedFileBuffers = true;
+
+  FrontendOptions &FrontendOpts = Invocation->getFrontendOpts();
+  FrontendOpts.ProgramAction = frontend::GeneratePTH;
+  FrontendOpts.OutputFile = TokenCacheFile.str();
+  FrontendOpts.DisableFree = false;
+  FrontendOpts.Inputs.clear();
+  FrontendOpts.Inputs.push_back(
+    FrontendInputFile(SourceFile,
+                      getSourceInputKindFromOptions(*Invocation->getLangOpts())));
+
+  Invocation->getDependencyOutputOpts() = DependencyOutputOptions();
+  Invocation->getDiagnosticOpts().VerifyDiagnostics = 0;
+
+  CompilerInstance Instance;
+  Instance.setInvocation(&*Invocation);
+  Instance.createDiagnostics(/*argc=*/0, /*argv=*/0,
+                             &UsingInstance.getDiagnosticClient(),
+                             /*ShouldOwnClient=*/true,
+                             /*ShouldCloneClient=*/true);
+
+  // Execute the action on a separate thread so that we get a stack large
+  // enough.
+  GeneratePTHAction Action;
+  const unsigned ThreadStackSize = 8 << 20;
+  llvm::CrashRecoveryContext CRC;
+  RebuildTokenCacheData Data = { Instance, Action };
+  if (!CRC.RunSafelyOnThread(&doRebuildTokenCache, &Data, ThreadStackSize))
+    return false;
+  return !Instance.getDiagnostics().hasErrorOccurred();
+}
+
 void CompilerInstance::createPreprocessor() {
   const PreprocessorOptions &PPOpts = getPreprocessorOpts();
 
   // Create a PTH manager if we are using some form of a token cache.
   PTHManager *PTHMgr = 0;
-  if (!PPOpts.TokenCache.empty())
+  if (!PPOpts.TokenCache.empty()) {
     PTHMgr = PTHManager::Create(PPOpts.TokenCache, getDiagnostics());
 
+    // Regenerate the cache if the files it was generated from have changed.
+    if (PTHMgr && PPOpts.RebuildStaleTokenCache && !PTHMgr->isUpToDate()) {
+      std::string SourceFile;
+      if (const char *OriginalFile = PTHMgr->getOriginalSourceFile())
+        SourceFile = OriginalFile;
+      delete PTHMgr;
+      PTHMgr = 0;
+
+      if (!SourceFile.empty() &&
+          rebuildTokenCache(*this, SourceFile, PPOpts.TokenCache))
+        PTHMgr = PTHManager::Create(PPOpts.TokenCache, getDiagnostics());
+      else
+        getDiagnostics().Report(diag::err_fe_pth_rebuild_failed)
+          << PPOpts.TokenCache;
+    }
+  }
+
   // Create the Preprocessor.
   HeaderSearch *HeaderInfo = new HeaderSearch(getFileManager(), 
                                               getDiagnostics(),
@@ -260,6 +397,9 @@ void CompilerInstance::createPreprocessor() {
   if (PPOpts.DetailedRecord)
     PP->createPreprocessingRecord(PPOpts.DetailedRecordConditionalDirectives);
 
+  PP->setCacheRepeatedIncludes(PPOpts.CacheRepeatedIncludes);
+  PP->setCacheMacroArgExpansions(PPOpts.CacheMacroArgExpansions);
+
   InitializePreprocessor(*PP, PPOpts, getHeaderSearchOpts(), getFrontendOpts());
 
   // Set up the module path, including the hash for the
@@ -290,6 +430,13 @@ void CompilerInstance::createPreprocessor() {
     AttachHeaderIncludeGen(*PP, /*ShowAllHeaders=*/true, OutputPath,
                            /*ShowDepth=*/false);
   }
+
+  // Handle tracking what each header costs, if requested.
+  HeaderCosts.reset();
+  if (!DepOpts.HeaderCostFile.empty()) {
+    HeaderCosts.reset(new HeaderCostTracker(*PP));
+    PP->addPPCallbacks(HeaderCosts->createPPCallbacks());
+  }
 }
 
 // ASTContext
@@ -304,6 +451,12 @@ void CompilerInstance::createASTContext() {
 
 // ExternalASTSource
 
+/// \brief Whether the AST reader should measure the time it spends
+/// deserializing, because its statistics will be reported.
+static bool shouldProfileDeserialization(const FrontendOptions &Opts) {
+  return Opts.ShowStats || !Opts.DeserializationStatsFile.empty();
+}
+
 void CompilerInstance::createPCHExternalASTSource(StringRef Path,
                                                   bool DisablePCHValidation,
                                                   bool DisableStatCache,
@@ -317,7 +470,9 @@ void CompilerInstance::createPCHExternalASTSource(StringRef Path,
                                           AllowPCHWithCompilerErrors,
                                           getPreprocessor(), getASTContext(),
                                           DeserializationListener,
-                                          Preamble));
+                                          Preamble,
+                                          shouldProfileDeserialization(
+                                            getFrontendOpts())));
   ModuleManager = static_cast<ASTReader*>(Source.get());
   getASTContext().setExternalSource(Source);
 }
@@ -331,13 +486,15 @@ CompilerInstance::createPCHExternalASTSource(StringRef Path,
                                              Preprocessor &PP,
                                              ASTContext &Context,
                                              void *DeserializationListener,
-                                             bool Preamble) {
+                                             bool Preamble,
+                                             bool ProfileDeserialization) {
   OwningPtr<ASTReader> Reader;
   Reader.reset(new ASTReader(PP, Context,
                              Sysroot.empty() ? "" : Sysroot.c_str(),
                              DisablePCHValidation, DisableStatCache,
                              AllowPCHWithCompilerErrors));
 
+  Reader->setProfileDeserialization(ProfileDeserialization);
   Reader->setDeserializationListener(
             static_cast<ASTDeserializationListener *>(DeserializationListener));
   switch (Reader->ReadAST(Path,
@@ -408,6 +565,10 @@ void CompilerInstance::createFrontendTimer() {
   FrontendTimer.reset(new llvm::Timer("Clang front-end timer"));
 }
 
+void CompilerInstance::createCompilationProfile() {
+  Profile.reset(new CompilationProfile());
+}
+
 CodeCompleteConsumer *
 CompilerInstance::createCodeCompletionConsumer(Preprocessor &PP,
                                                const std::string &Filename,
@@ -426,6 +587,13 @@ void CompilerInstance::createSema(TranslationUnitKind TUKind,
                                   CodeCompleteConsumer *CompletionConsumer) {
   TheSema.reset(new Sema(getPreprocessor(), getASTContext(), getASTConsumer(),
                          TUKind, CompletionConsumer));
+  if (getFrontendOpts().ShowTimers)
+    TheSema->AnalysisWarnings.enableTimers();
+  if (getFrontendOpts().ShowTemplateProfile ||
+      !getFrontendOpts().TemplateProfileTraceFile.empty())
+    TheSema->enableInstantiationProfiler();
+  if (hasCompilationProfile())
+    TheSema->setCompilationProfile(&getCompilationProfile());
 }
 
 // Output Files
@@ -668,6 +836,10 @@ bool CompilerInstance::ExecuteAction(FrontendAction &Act) {
     if (hasSourceManager())
       getSourceManager().clearIDTables();
 
+    // Each input gets a profile of its own.
+    if (!getFrontendOpts().CompileProfileFile.empty())
+      createCompilationProfile();
+
     if (Act.BeginSourceFile(*this, getFrontendOpts().Inputs[i])) {
       Act.Execute();
       Act.EndSourceFile();
@@ -701,18 +873,6 @@ bool CompilerInstance::ExecuteAction(FrontendAction &Act) {
   return !getDiagnostics().getClient()->getNumErrors();
 }
 
-/// \brief Determine the appropriate source input kind based on language
-/// options.
-static InputKind getSourceInputKindFromOptions(const LangOptions &LangOpts) {
-  if (LangOpts.OpenCL)
-    return IK_OpenCL;
-  if (LangOpts.CUDA)
-    return IK_CUDA;
-  if (LangOpts.ObjC1)
-    return LangOpts.CPlusPlus? IK_ObjCXX : IK_ObjC;
-  return LangOpts.CPlusPlus? IK_CXX : IK_C;
-}
-
 namespace {
   struct CompileModuleMapData {
     CompilerInstance &Instance;
@@ -728,27 +888,27 @@ static void doCompileMapModule(void *UserData) {
   Data.Instance.ExecuteAction(Data.CreateModuleAction);
 }
 
-/// \brief Compile a module file for the given module, using the options 
-/// provided by the importing compiler instance.
-static void compileModule(CompilerInstance &ImportingInstance,
-                          Module *Module,
-                          StringRef ModuleFileName) {
-  llvm::LockFileManager Locked(ModuleFileName);
-  switch (Locked) {
-  case llvm::LockFileManager::LFS_Error:
-    return;
-
-  case llvm::LockFileManager::LFS_Owned:
-    // We're responsible for building the module ourselves. Do so below.
-    break;
-
-  case llvm::LockFileManager::LFS_Shared:
-    // Someone else is responsible for building the module. Wait for them to
-    // finish.
-    Locked.waitForUnlock();
-    break;
-  }
+namespace {
+  /// \brief The invocation that builds a module, and the temporary module map
+  /// it builds the module from, if any.
+  struct ModuleBuild {
+    IntrusiveRefCntPtr<CompilerInvocation> Invocation;
+    std::string ModuleFileName;
+    std::string TempModuleMapFileName;
+  };
+}
 
+/// \brief Set up the building of a module file for the given module, using
+/// the options provided by the importing compiler instance.
+///
+/// \param Diags Where to report a failure, if anywhere.
+///
+/// \returns false if the module cannot be built.
+static bool prepareModuleBuild(CompilerInstance &ImportingInstance,
+                               Module *Module,
+                               StringRef ModuleFileName,
+                               ModuleBuild &Build,
+                               DiagnosticsEngine *Diags) {
   ModuleMap &ModMap 
     = ImportingInstance.getPreprocessor().getHeaderSearchInfo().getModuleMap();
     
@@ -777,6 +937,8 @@ static void compileModule(CompilerInstance &ImportingInstance,
   FrontendOpts.OutputFile = ModuleFileName.str();
   FrontendOpts.DisableFree = false;
   FrontendOpts.Inputs.clear();
+  // The modules this module imports are built one after another.
+  FrontendOpts.ModuleBuildThreads = 1;
   InputKind IK = getSourceInputKindFromOptions(*Invocation->getLangOpts());
 
   // Get or create the module map that we'll use to build this module.
@@ -795,9 +957,9 @@ static void compileModule(CompilerInstance &ImportingInstance,
                                    TempModuleMapFileName,
                                    /*makeAbsolute=*/true)
           != llvm::errc::success) {
-      ImportingInstance.getDiagnostics().Report(diag::err_module_map_temp_file)
-        << TempModuleMapFileName;
-      return;
+      if (Diags)
+        Diags->Report(diag::err_module_map_temp_file) << TempModuleMapFileName;
+      return false;
     }
     // Print the module map to this file.
     llvm::raw_fd_ostream OS(FD, /*shouldClose=*/true);
@@ -812,15 +974,59 @@ static void compileModule(CompilerInstance &ImportingInstance,
   Invocation->getDiagnosticOpts().VerifyDiagnostics = 0;
   assert(ImportingInstance.getInvocation().getModuleHash() ==
          Invocation->getModuleHash() && "Module hash mismatch!");
-  
+
+  Build.Invocation = Invocation;
+  Build.ModuleFileName = ModuleFileName;
+  Build.TempModuleMapFileName = TempModuleMapFileName.str();
+  return true;
+}
+
+/// \brief Delete the temporary module map file of a module build, if any.
+static void removeTempModuleMap(ModuleBuild &Build) {
+  // FIXME: Even though we're executing under crash protection, it would still
+  // be nice to do this with RemoveFileOnSignal when we can. However, that
+  // doesn't make sense for all clients, so clean this up manually.
+  if (!Build.TempModuleMapFileName.empty())
+    llvm::sys::Path(Build.TempModuleMapFileName).eraseFromDisk();
+}
+
+/// \brief Build a module file, unless another compile builds it first.
+///
+/// \param Client The consumer of the diagnostics of the build; it is cloned
+/// if \p ShouldCloneClient, and otherwise owned by the build from now on.
+static void runModuleBuild(ModuleBuild &Build, DiagnosticConsumer *Client,
+                           bool ShouldCloneClient) {
+  llvm::LockFileManager Locked(Build.ModuleFileName);
+  switch (Locked) {
+  case llvm::LockFileManager::LFS_Error:
+    removeTempModuleMap(Build);
+    if (!ShouldCloneClient)
+      delete Client;
+    return;
+
+  case llvm::LockFileManager::LFS_Owned:
+    // We're responsible for building the module ourselves. Do so below.
+    break;
+
+  case llvm::LockFileManager::LFS_Shared:
+    // Someone else is responsible for building the module. Wait for them to
+    // finish, and only build it ourselves if they failed to.
+    Locked.waitForUnlock();
+    if (llvm::sys::fs::exists(Build.ModuleFileName)) {
+      removeTempModuleMap(Build);
+      if (!ShouldCloneClient)
+        delete Client;
+      return;
+    }
+    break;
+  }
+
   // Construct a compiler instance that will be used to actually create the
   // module.
   CompilerInstance Instance;
-  Instance.setInvocation(&*Invocation);
-  Instance.createDiagnostics(/*argc=*/0, /*argv=*/0,
-                             &ImportingInstance.getDiagnosticClient(),
-                             /*ShouldOwnClient=*/true,
-                             /*ShouldCloneClient=*/true);
+  Instance.setInvocation(&*Build.Invocation);
+  Instance.createDiagnostics(/*argc=*/0, /*argv=*/0, Client,
+                             /*ShouldOwnClient=*/true, ShouldCloneClient);
   
   // Construct a module-generating action.
   GenerateModuleAction CreateModuleAction;
@@ -831,13 +1037,239 @@ static void compileModule(CompilerInstance &ImportingInstance,
   llvm::CrashRecoveryContext CRC;
   CompileModuleMapData Data = { Instance, CreateModuleAction };
   CRC.RunSafelyOnThread(&doCompileMapModule, &Data, ThreadStackSize);
-  
-  // Delete the temporary module map file.
-  // FIXME: Even though we're executing under crash protection, it would still
-  // be nice to do this with RemoveFileOnSignal when we can. However, that
-  // doesn't make sense for all clients, so clean this up manually.
-  if (!TempModuleMapFileName.empty())
-    llvm::sys::Path(TempModuleMapFileName).eraseFromDisk();
+
+  removeTempModuleMap(Build);
+}
+
+/// \brief Compile a module file for the given module, using the options 
+/// provided by the importing compiler instance.
+static void compileModule(CompilerInstance &ImportingInstance,
+                          Module *Module,
+                          StringRef ModuleFileName) {
+  ModuleBuild Build;
+  if (!prepareModuleBuild(ImportingInstance, Module, ModuleFileName, Build,
+                          &ImportingInstance.getDiagnostics()))
+    return;
+  runModuleBuild(Build, &ImportingInstance.getDiagnosticClient(),
+                 /*ShouldCloneClient=*/true);
+}
+
+namespace clang {
+/// \brief Builds the modules imported by the main file of a translation unit
+/// in the background, before the parser reaches their imports.
+///
+/// Each background thread builds one module, with its diagnostics
+/// suppressed; a module whose build failed is built again when it is
+/// imported, so that the errors are reported. The jobs are only started,
+/// joined and handed out on the thread of the importing compiler instance.
+class ModuleBuildQueue {
+  struct Job {
+    std::string Name;
+    ModuleBuild Build;
+    BackgroundThread Thread;
+    enum { Pending, Running, Done } State;
+    /// \brief Set by the thread of a running job when it is done.
+    volatile llvm::sys::cas_flag Finished;
+  };
+  std::vector<Job *> Jobs;
+
+  /// \brief The number of jobs that may run in the background at once.
+  unsigned MaxRunning;
+  unsigned NumRunning;
+
+  ModuleBuildQueue(const ModuleBuildQueue &); // DO NOT IMPLEMENT
+  void operator=(const ModuleBuildQueue &); // DO NOT IMPLEMENT
+
+  static void runJob(void *UserData) {
+    Job *J = static_cast<Job *>(UserData);
+    runModuleBuild(J->Build, new IgnoringDiagConsumer(),
+                   /*ShouldCloneClient=*/false);
+    llvm::sys::AtomicIncrement(&J->Finished);
+  }
+
+  void join(Job *J) {
+    J->Thread.join();
+    J->State = Job::Done;
+    --NumRunning;
+  }
+
+  /// \brief Join the jobs that are done, and start pending ones in their
+  /// place.
+  void update() {
+    for (unsigned I = 0, N = Jobs.size(); I != N; ++I)
+      if (Jobs[I]->State == Job::Running && Jobs[I]->Finished)
+        join(Jobs[I]);
+
+    for (unsigned I = 0, N = Jobs.size(); I != N && NumRunning < MaxRunning;
+         ++I) {
+      Job *J = Jobs[I];
+      if (J->State != Job::Pending)
+        continue;
+      if (!J->Thread.start(&runJob, J))
+        return;
+      J->State = Job::Running;
+      ++NumRunning;
+    }
+  }
+
+  Job *findPendingJob() const {
+    for (unsigned I = 0, N = Jobs.size(); I != N; ++I)
+      if (Jobs[I]->State == Job::Pending)
+        return Jobs[I];
+    return 0;
+  }
+
+public:
+  explicit ModuleBuildQueue(unsigned MaxRunning)
+    : MaxRunning(MaxRunning), NumRunning(0) { }
+
+  ~ModuleBuildQueue() {
+    for (unsigned I = 0, N = Jobs.size(); I != N; ++I) {
+      if (Jobs[I]->State == Job::Pending)
+        removeTempModuleMap(Jobs[I]->Build);
+      delete Jobs[I];
+    }
+  }
+
+  /// \brief Queue the build of the top-level module \p Name, and start it if
+  /// a thread is available.
+  void addJob(StringRef Name, const ModuleBuild &Build) {
+    Job *J = new Job();
+    J->Name = Name;
+    J->Build = Build;
+    J->State = Job::Pending;
+    J->Finished = 0;
+    Jobs.push_back(J);
+    update();
+  }
+
+  /// \brief Wait for the background build of the top-level module \p Name,
+  /// if there is one.
+  ///
+  /// While waiting, the modules whose builds have not started yet are built
+  /// on the calling thread.
+  ///
+  /// \returns true if the module was built in the background, successfully
+  /// or not, and false if the caller should build it.
+  bool waitForModule(StringRef Name) {
+    update();
+
+    Job *J = 0;
+    for (unsigned I = 0, N = Jobs.size(); I != N && !J; ++I)
+      if (Jobs[I]->Name == Name)
+        J = Jobs[I];
+    if (!J)
+      return false;
+
+    if (J->State == Job::Pending) {
+      // The caller builds it, reporting its diagnostics.
+      removeTempModuleMap(J->Build);
+      J->State = Job::Done;
+      return false;
+    }
+
+    if (J->State == Job::Running) {
+      while (!J->Finished) {
+        Job *Next = findPendingJob();
+        if (!Next)
+          break;
+        Next->State = Job::Done;
+        runModuleBuild(Next->Build, new IgnoringDiagConsumer(),
+                       /*ShouldCloneClient=*/false);
+        update();
+      }
+      if (J->State == Job::Running)
+        join(J);
+    }
+
+    update();
+    return true;
+  }
+};
+}
+
+/// \brief Find the modules that the main file imports with
+/// \c \@__experimental_modules_import.
+///
+/// The imports are found textually, so some of them may be in comments or
+/// in code that is not compiled.
+static void findImportedModuleNames(StringRef Buffer,
+                                    SmallVectorImpl<StringRef> &Names) {
+  const StringRef Keyword = "@__experimental_modules_import";
+  for (size_t Pos = Buffer.find(Keyword); Pos != StringRef::npos;
+       Pos = Buffer.find(Keyword, Pos + Keyword.size())) {
+    StringRef Rest = Buffer.substr(Pos + Keyword.size());
+    size_t Start = Rest.find_first_not_of(" \t\n\r");
+    if (Start == 0 || Start == StringRef::npos)
+      continue;
+    size_t End = Start;
+    while (End != Rest.size() && (isalnum(Rest[End]) || Rest[End] == '_'))
+      ++End;
+    if (End != Start)
+      Names.push_back(Rest.slice(Start, End));
+  }
+}
+
+/// \brief Start building, in the background, the modules that the main file
+/// imports and that need to be built, other than \p ImportedName.
+static ModuleBuildQueue *queueModuleBuilds(CompilerInstance &CI,
+                                           StringRef ImportedName) {
+  unsigned NumThreads = CI.getFrontendOpts().ModuleBuildThreads;
+  if (NumThreads == 0)
+    NumThreads = getNumberOfHardwareThreads();
+  if (NumThreads <= 1 || !isParallelExecutionSupported())
+    return 0;
+
+  SourceManager &SourceMgr = CI.getSourceManager();
+  bool Invalid = false;
+  StringRef Buffer = SourceMgr.getBufferData(SourceMgr.getMainFileID(),
+                                             &Invalid);
+  if (Invalid)
+    return 0;
+  SmallVector<StringRef, 16> Names;
+  findImportedModuleNames(Buffer, Names);
+
+  ModuleBuildQueue *Queue = new ModuleBuildQueue(NumThreads - 1);
+  HeaderSearch &HS = CI.getPreprocessor().getHeaderSearchInfo();
+  const SmallVectorImpl<std::string> &ModuleBuildPath
+    = CI.getPreprocessorOpts().ModuleBuildPath;
+  llvm::StringSet<> Seen;
+  Seen.insert(ImportedName);
+  Seen.insert(CI.getLangOpts().CurrentModule);
+  for (unsigned I = 0, N = Names.size(); I != N; ++I) {
+    if (!Seen.insert(Names[I]))
+      continue;
+    if (std::find(ModuleBuildPath.begin(), ModuleBuildPath.end(), Names[I])
+          != ModuleBuildPath.end())
+      continue;
+
+    Module *Module = HS.lookupModule(Names[I]);
+    if (!Module)
+      continue;
+    std::string ModuleFileName = HS.getModuleFileName(Module);
+    if (ModuleFileName.empty() || llvm::sys::fs::exists(ModuleFileName))
+      continue;
+
+    ModuleBuild Build;
+    if (!prepareModuleBuild(CI, Module, ModuleFileName, Build, /*Diags=*/0))
+      continue;
+
+    // Nothing but the module file comes out of a build in the background.
+    DiagnosticOptions &DiagOpts = Build.Invocation->getDiagnosticOpts();
+    DiagOpts.DumpBuildInformation.clear();
+    DiagOpts.DiagnosticLogFile.clear();
+    DiagOpts.DiagnosticSerializationFile.clear();
+    FrontendOptions &FrontendOpts = Build.Invocation->getFrontendOpts();
+    FrontendOpts.ShowStats = false;
+    FrontendOpts.ShowTimers = false;
+    FrontendOpts.ShowTemplateProfile = false;
+    FrontendOpts.DeserializationStatsFile.clear();
+    FrontendOpts.TemplateProfileTraceFile.clear();
+    FrontendOpts.CompileProfileFile.clear();
+
+    Queue->addJob(Names[I], Build);
+  }
+  return Queue;
 }
 
 Module *CompilerInstance::loadModule(SourceLocation ImportLoc, 
@@ -914,11 +1346,20 @@ Module *CompilerInstance::loadModule(SourceLocation ImportLoc,
         return 0;
       }
 
-      getDiagnostics().Report(ModuleNameLoc, diag::warn_module_build)
-        << ModuleName;
-      BuildingModule = true;
-      compileModule(*this, Module, ModuleFileName);
-      ModuleFile = FileMgr->getFile(ModuleFileName);
+      // Start building the other modules that the main file imports, so
+      // that they are ready, or closer to it, when it imports them.
+      if (!ModuleBuilds)
+        ModuleBuilds.reset(queueModuleBuilds(*this, ModuleName));
+      if (ModuleBuilds && ModuleBuilds->waitForModule(ModuleName))
+        ModuleFile = FileMgr->getFile(ModuleFileName);
+
+      if (!ModuleFile) {
+        getDiagnostics().Report(ModuleNameLoc, diag::warn_module_build)
+          << ModuleName;
+        BuildingModule = true;
+        compileModule(*this, Module, ModuleFileName);
+        ModuleFile = FileMgr->getFile(ModuleFileName);
+      }
     }
 
     if (!ModuleFile) {
@@ -941,6 +1382,8 @@ Module *CompilerInstance::loadModule(SourceLocation ImportLoc,
                                     Sysroot.empty() ? "" : Sysroot.c_str(),
                                     PPOpts.DisablePCHValidation,
                                     PPOpts.DisableStatCache);
+      ModuleManager->setProfileDeserialization(
+        shouldProfileDeserialization(getFrontendOpts()));
       if (hasASTConsumer()) {
         ModuleManager->setDeserializationListener(
           getASTConsumer().GetASTDeserializationListener());
@@ -28,6 +28,7 @@
 #include "llvm/Support/ErrorHandling.h"
 #include "llvm/Support/Host.h"
 #include "llvm/Support/Path.h"
+#include "llvm/Support/Regex.h"
 using namespace clang;
 
 //===----------------------------------------------------------------------===//
@@ -147,6 +148,12 @@ static void AnalyzerOptsToArgs(const AnalyzerOptions &Opts, ToArgsList &Res) {
                   getAnalysisPurgeModeName(Opts.AnalysisPurgeOpt));
   if (!Opts.AnalyzeSpecificFunction.empty())
     Res.push_back("-analyze-function", Opts.AnalyzeSpecificFunction);
+  if (!Opts.FunctionSummariesFile.empty())
+    Res.push_back("-analyzer-function-summaries", Opts.FunctionSummariesFile);
+  if (!Opts.CheckerProfileFile.empty())
+    Res.push_back("-analyzer-checker-profile", Opts.CheckerProfileFile);
+  if (!Opts.ResultCacheFile.empty())
+    Res.push_back("-analyzer-result-cache", Opts.ResultCacheFile);
   if (Opts.IPAMode != DynamicDispatchBifurcate)
     Res.push_back("-analyzer-ipa", getAnalysisIPAModeName(Opts.IPAMode));
   if (Opts.InliningMode != NoRedundancy)
@@ -196,6 +203,13 @@ static void CodeGenOptsToArgs(const CodeGenOptions &Opts, ToArgsList &Res) {
       Res.push_back("-fno-limit-debug-info");
       break;
   }
+  if (Opts.DebugVTableHoming)
+    Res.push_back("-fdebug-vtable-homing");
+  if (Opts.DisableLifetimeMarkers)
+    Res.push_back("-disable-lifetime-markers");
+  if (Opts.LifetimeMarkersMinSize != 32)
+    Res.push_back("-lifetime-markers-min-size",
+                  llvm::utostr(Opts.LifetimeMarkersMinSize));
   if (Opts.DisableLLVMOpts)
     Res.push_back("-disable-llvm-optzns");
   if (Opts.DisableRedZone)
@@ -210,6 +224,12 @@ static void CodeGenOptsToArgs(const CodeGenOptions &Opts, ToArgsList &Res) {
     Res.push_back("-femit-coverage-data");
   if (Opts.EmitGcovNotes)
     Res.push_back("-femit-coverage-notes");
+  if (Opts.ProfileInstrGenerate)
+    Res.push_back("-fprofile-instr-generate");
+  if (!Opts.InstrProfileInput.empty())
+    Res.push_back("-fprofile-instr-use=" + Opts.InstrProfileInput);
+  if (!Opts.OptimizationRemarkPattern.empty())
+    Res.push_back("-Rpass=" + Opts.OptimizationRemarkPattern);
   if (Opts.EmitOpenCLArgMetadata)
     Res.push_back("-cl-kernel-arg-info");
   if (!Opts.MergeAllConstants)
@@ -220,6 +240,8 @@ static void CodeGenOptsToArgs(const CodeGenOptions &Opts, ToArgsList &Res) {
     Res.push_back("-fforbid-guard-variables");
   if (Opts.UseRegisterSizedBitfieldAccess)
     Res.push_back("-fuse-register-sized-bitfield-access");
+  if (Opts.ReleaseFunctionBodies)
+    Res.push_back("-frelease-function-bodies");
   if (Opts.NoImplicitFloat)
     Res.push_back("-no-implicit-float");
   if (Opts.OmitLeafFramePointer)
@@ -281,6 +303,8 @@ static void CodeGenOptsToArgs(const CodeGenOptions &Opts, ToArgsList &Res) {
     Res.push_back("-fobjc-dispatch-method=non-legacy");
     break;
   }
+  if (Opts.ObjCSendCache)
+    Res.push_back("-fobjc-send-cache");
   if (Opts.BoundsChecking > 0)
     Res.push_back("-fbounds-checking=" + llvm::utostr(Opts.BoundsChecking));
   if (Opts.NumRegisterParameters)
@@ -333,6 +357,8 @@ static void DependencyOutputOptsToArgs(const DependencyOutputOptions &Opts,
     Res.push_back("-H");
   if (!Opts.HeaderIncludeOutputFile.empty())
     Res.push_back("-header-include-file", Opts.HeaderIncludeOutputFile);
+  if (!Opts.HeaderCostFile.empty())
+    Res.push_back("-header-cost-file", Opts.HeaderCostFile);
   if (Opts.UsePhonyTargets)
     Res.push_back("-MP");
   if (!Opts.OutputFile.empty())
@@ -463,6 +489,7 @@ static const char *getActionName(frontend::ActionKind Kind) {
   case frontend::RunAnalysis:            return "-analyze";
   case frontend::MigrateSource:          return "-migrate";
   case frontend::RunPreprocessorOnly:    return "-Eonly";
+  case frontend::ScanDependencies:       return "-scan-dependencies";
   }
 
   llvm_unreachable("Unexpected language kind!");
@@ -471,6 +498,8 @@ static const char *getActionName(frontend::ActionKind Kind) {
 static void FileSystemOptsToArgs(const FileSystemOptions &Opts, ToArgsList &Res){
   if (!Opts.WorkingDir.empty())
     Res.push_back("-working-directory", Opts.WorkingDir);
+  if (!Opts.PrefetchFileList.empty())
+    Res.push_back("-prefetch-file-list", Opts.PrefetchFileList);
 }
 
 static void CodeCompleteOptionsToArgs(const CodeCompleteOptions &Opts,
@@ -483,6 +512,10 @@ static void CodeCompleteOptionsToArgs(const CodeCompleteOptions &Opts,
     Res.push_back("-no-code-completion-globals");
   if (Opts.IncludeBriefComments)
     Res.push_back("-code-completion-brief-comments");
+  if (!Opts.FilterPrefix.empty())
+    Res.push_back("-code-completion-prefix", Opts.FilterPrefix);
+  if (Opts.FuzzyFilter)
+    Res.push_back("-code-completion-fuzzy");
 }
 
 static void FrontendOptsToArgs(const FrontendOptions &Opts, ToArgsList &Res) {
@@ -490,10 +523,18 @@ static void FrontendOptsToArgs(const FrontendOptions &Opts, ToArgsList &Res) {
     Res.push_back("-disable-free");
   if (Opts.RelocatablePCH)
     Res.push_back("-relocatable-pch");
+  if (Opts.CompressPCH)
+    Res.push_back("-compress-pch");
+  if (Opts.DeterministicPCH)
+    Res.push_back("-deterministic-pch");
   if (Opts.ShowHelp)
     Res.push_back("-help");
   if (Opts.ShowStats)
     Res.push_back("-print-stats");
+  if (Opts.ShowMemoryStats)
+    Res.push_back("-print-memory-stats");
+  if (Opts.ReleaseSourceBuffers)
+    Res.push_back("-release-source-buffers");
   if (Opts.ShowTimers)
     Res.push_back("-ftime-report");
   if (Opts.ShowVersion)
@@ -575,6 +616,20 @@ static void FrontendOptsToArgs(const FrontendOptions &Opts, ToArgsList &Res) {
     Res.push_back("-mllvm", Opts.LLVMArgs[i]);
   if (!Opts.OverrideRecordLayoutsFile.empty())
     Res.push_back("-foverride-record-layout=" + Opts.OverrideRecordLayoutsFile);
+  if (!Opts.DeserializationStatsFile.empty())
+    Res.push_back("-deserialization-stats-file",
+                  Opts.DeserializationStatsFile);
+  if (Opts.ShowTemplateProfile)
+    Res.push_back("-ftemplate-profile");
+  if (!Opts.TemplateProfileTraceFile.empty())
+    Res.push_back("-ftemplate-profile-trace", Opts.TemplateProfileTraceFile);
+  if (!Opts.CompileProfileFile.empty())
+    Res.push_back("-compile-profile-file", Opts.CompileProfileFile);
+  if (Opts.ModuleBuildThreads != 1)
+    Res.push_back("-fmodules-build-threads=" +
+                  llvm::utostr(Opts.ModuleBuildThreads));
+  if (Opts.SkipFunctionBodiesOutsideMainFile)
+    Res.push_back("-skip-function-bodies-outside-main-file");
 }
 
 static void HeaderSearchOptsToArgs(const HeaderSearchOptions &Opts,
@@ -667,6 +722,8 @@ static void HeaderSearchOptsToArgs(const HeaderSearchOptions &Opts,
     Res.push_back("-stdlib=libc++");
   if (Opts.Verbose)
     Res.push_back("-v");
+  if (Opts.CacheSearchDirContents)
+    Res.push_back("-cache-search-dir-contents");
 }
 
 static void LangOptsToArgs(const LangOptions &Opts, ToArgsList &Res) {
@@ -751,6 +808,8 @@ static void LangOptsToArgs(const LangOptions &Opts, ToArgsList &Res) {
     Res.push_back("-fblocks-runtime-optional");
   if (Opts.Modules)
     Res.push_back("-fmodules");
+  if (Opts.IntrinsicsModule)
+    Res.push_back("-fintrinsics-module");
   if (Opts.EmitAllDecls)
     Res.push_back("-femit-all-decls");
   if (Opts.MathErrno)
@@ -769,6 +828,15 @@ static void LangOptsToArgs(const LangOptions &Opts, ToArgsList &Res) {
   case LangOptions::FPC_On:   Res.push_back("-ffp-contract=on"); break;
   case LangOptions::FPC_Fast: Res.push_back("-ffp-contract=fast"); break;
   }
+  switch (Opts.getPCHVTables()) {
+  case LangOptions::PCHVTablesEverywhere: break;
+  case LangOptions::PCHVTablesOwner:
+    Res.push_back("-fpch-vtables=owner");
+    break;
+  case LangOptions::PCHVTablesExternal:
+    Res.push_back("-fpch-vtables=external");
+    break;
+  }
   if (Opts.HeinousExtensions)
     Res.push_back("-fheinous-gnu-extensions");
   // Optimize is implicit.
@@ -855,6 +923,10 @@ static void LangOptsToArgs(const LangOptions &Opts, ToArgsList &Res) {
     Res.push_back("-fdebugger-objc-literal");
   if (Opts.DelayedTemplateParsing)
     Res.push_back("-fdelayed-template-parsing");
+  if (Opts.LazyInlineMethodParsing)
+    Res.push_back("-flazy-inline-method-parsing");
+  if (Opts.CompactSystemTypeLocs)
+    Res.push_back("-fcompact-system-type-locs");
   if (Opts.Deprecated)
     Res.push_back("-fdeprecated-macro");
   if (Opts.ApplePragmaPack)
@@ -878,6 +950,10 @@ static void PreprocessorOptsToArgs(const PreprocessorOptions &Opts,
     Res.push_back("-undef");
   if (Opts.DetailedRecord)
     Res.push_back("-detailed-preprocessing-record");
+  if (Opts.CacheRepeatedIncludes)
+    Res.push_back("-cache-repeated-includes");
+  if (Opts.CacheMacroArgExpansions)
+    Res.push_back("-cache-macro-arg-expansions");
   if (!Opts.ImplicitPCHInclude.empty())
     Res.push_back("-include-pch", Opts.ImplicitPCHInclude);
   if (!Opts.ImplicitPTHInclude.empty())
@@ -889,8 +965,12 @@ static void PreprocessorOptsToArgs(const PreprocessorOptions &Opts,
       assert(Opts.ImplicitPTHInclude == Opts.TokenCache &&
              "Unsupported option combination!");
   }
+  if (Opts.RebuildStaleTokenCache)
+    Res.push_back("-rebuild-stale-token-cache");
   for (unsigned i = 0, e = Opts.ChainedIncludes.size(); i != e; ++i)
     Res.push_back("-chain-include", Opts.ChainedIncludes[i]);
+  if (!Opts.ChainedIncludesCache.empty())
+    Res.push_back("-chain-include-cache", Opts.ChainedIncludesCache);
   for (unsigned i = 0, e = Opts.RemappedFiles.size(); i != e; ++i) {
     Res.push_back("-remap-file", Opts.RemappedFiles[i].first + ";" +
                                  Opts.RemappedFiles[i].second);
@@ -1129,6 +1209,10 @@ static bool ParseAnalyzerArgs(AnalyzerOptions &Opts, ArgList &Args,
     Args.hasArg(OPT_analyzer_opt_analyze_nested_blocks);
   Opts.eagerlyAssumeBinOpBifurcation = Args.hasArg(OPT_analyzer_eagerly_assume);
   Opts.AnalyzeSpecificFunction = Args.getLastArgValue(OPT_analyze_function);
+  Opts.FunctionSummariesFile =
+    Args.getLastArgValue(OPT_analyzer_function_summaries);
+  Opts.CheckerProfileFile = Args.getLastArgValue(OPT_analyzer_checker_profile);
+  Opts.ResultCacheFile = Args.getLastArgValue(OPT_analyzer_result_cache);
   Opts.UnoptimizedCFG = Args.hasArg(OPT_analysis_UnoptimizedCFG);
   Opts.TrimGraph = Args.hasArg(OPT_trim_egraph);
   Opts.MaxNodes = Args.getLastArgIntValue(OPT_analyzer_max_nodes, 150000,Diags);
@@ -1228,12 +1312,17 @@ static bool ParseCodeGenArgs(CodeGenOptions &Opts, ArgList &Args, InputKind IK,
       Opts.DebugInfo = CodeGenOptions::FullDebugInfo;
   }
 
+  Opts.DebugVTableHoming = Args.hasArg(OPT_fdebug_vtable_homing);
+  Opts.DisableLifetimeMarkers = Args.hasArg(OPT_disable_lifetime_markers);
+  Opts.LifetimeMarkersMinSize =
+    Args.getLastArgIntValue(OPT_lifetime_markers_min_size, 32, Diags);
   Opts.DisableLLVMOpts = Args.hasArg(OPT_disable_llvm_optzns);
   Opts.DisableRedZone = Args.hasArg(OPT_disable_red_zone);
   Opts.ForbidGuardVariables = Args.hasArg(OPT_fforbid_guard_variables);
   Opts.UseRegisterSizedBitfieldAccess = Args.hasArg(
     OPT_fuse_register_sized_bitfield_access);
   Opts.RelaxedAliasing = Args.hasArg(OPT_relaxed_aliasing);
+  Opts.ReleaseFunctionBodies = Args.hasArg(OPT_frelease_function_bodies);
   Opts.DwarfDebugFlags = Args.getLastArgValue(OPT_dwarf_debug_flags);
   Opts.MergeAllConstants = !Args.hasArg(OPT_fno_merge_all_constants);
   Opts.NoCommon = Args.hasArg(OPT_fno_common);
@@ -1297,6 +1386,19 @@ static bool ParseCodeGenArgs(CodeGenOptions &Opts, ArgList &Args, InputKind IK,
   Opts.EmitGcovNotes = Args.hasArg(OPT_femit_coverage_notes);
   Opts.EmitOpenCLArgMetadata = Args.hasArg(OPT_cl_kernel_arg_info);
   Opts.CoverageFile = Args.getLastArgValue(OPT_coverage_file);
+  Opts.ProfileInstrGenerate = Args.hasArg(OPT_fprofile_instr_generate);
+  Opts.InstrProfileInput = Args.getLastArgValue(OPT_fprofile_instr_use_EQ);
+  if (Arg *A = Args.getLastArg(OPT_Rpass_EQ)) {
+    StringRef Val = A->getValue(Args);
+    std::string RegexError;
+    if (!llvm::Regex(Val).isValid(RegexError)) {
+      Diags.Report(diag::err_drv_optimization_remark_pattern)
+        << RegexError << A->getAsString(Args);
+      Success = false;
+    } else {
+      Opts.OptimizationRemarkPattern = Val;
+    }
+  }
   Opts.DebugCompilationDir = Args.getLastArgValue(OPT_fdebug_compilation_dir);
   Opts.LinkBitcodeFile = Args.getLastArgValue(OPT_mlink_bitcode_file);
   Opts.SSPBufferSize =
@@ -1321,6 +1423,7 @@ static bool ParseCodeGenArgs(CodeGenOptions &Opts, ArgList &Args, InputKind IK,
       Opts.ObjCDispatchMethod = Method;
     }
   }
+  Opts.ObjCSendCache = Args.hasArg(OPT_fobjc_send_cache);
 
   if (Arg *A = Args.getLastArg(OPT_ftlsmodel_EQ)) {
     StringRef Name = A->getValue(Args);
@@ -1350,6 +1453,7 @@ static void ParseDependencyOutputArgs(DependencyOutputOptions &Opts,
   Opts.UsePhonyTargets = Args.hasArg(OPT_MP);
   Opts.ShowHeaderIncludes = Args.hasArg(OPT_H);
   Opts.HeaderIncludeOutputFile = Args.getLastArgValue(OPT_header_include_file);
+  Opts.HeaderCostFile = Args.getLastArgValue(OPT_header_cost_file);
   Opts.AddMissingHeaderDeps = Args.hasArg(OPT_MG);
   Opts.DOTOutputFile = Args.getLastArgValue(OPT_dependency_dot);
 }
@@ -1462,6 +1566,7 @@ bool clang::ParseDiagnosticArgs(DiagnosticOptions &Opts, ArgList &Args,
 
 static void ParseFileSystemArgs(FileSystemOptions &Opts, ArgList &Args) {
   Opts.WorkingDir = Args.getLastArgValue(OPT_working_directory);
+  Opts.PrefetchFileList = Args.getLastArgValue(OPT_prefetch_file_list);
 }
 
 static InputKind ParseFrontendArgs(FrontendOptions &Opts, ArgList &Args,
@@ -1533,6 +1638,8 @@ static InputKind ParseFrontendArgs(FrontendOptions &Opts, ArgList &Args,
       Opts.ProgramAction = frontend::MigrateSource; break;
     case OPT_Eonly:
       Opts.ProgramAction = frontend::RunPreprocessorOnly; break;
+    case OPT_scan_dependencies:
+      Opts.ProgramAction = frontend::ScanDependencies; break;
     }
   }
 
@@ -1570,8 +1677,12 @@ static InputKind ParseFrontendArgs(FrontendOptions &Opts, ArgList &Args,
   Opts.OutputFile = Args.getLastArgValue(OPT_o);
   Opts.Plugins = Args.getAllArgValues(OPT_load);
   Opts.RelocatablePCH = Args.hasArg(OPT_relocatable_pch);
+  Opts.CompressPCH = Args.hasArg(OPT_compress_pch);
+  Opts.DeterministicPCH = Args.hasArg(OPT_deterministic_pch);
   Opts.ShowHelp = Args.hasArg(OPT_help);
   Opts.ShowStats = Args.hasArg(OPT_print_stats);
+  Opts.ShowMemoryStats = Args.hasArg(OPT_print_memory_stats);
+  Opts.ReleaseSourceBuffers = Args.hasArg(OPT_release_source_buffers);
   Opts.ShowTimers = Args.hasArg(OPT_ftime_report);
   Opts.ShowVersion = Args.hasArg(OPT_version);
   Opts.ASTMergeFiles = Args.getAllArgValues(OPT_ast_merge);
@@ -1581,6 +1692,8 @@ static InputKind ParseFrontendArgs(FrontendOptions &Opts, ArgList &Args,
   Opts.FixAndRecompile = Args.hasArg(OPT_fixit_recompile);
   Opts.FixToTemporaries = Args.hasArg(OPT_fixit_to_temp);
   Opts.ASTDumpFilter = Args.getLastArgValue(OPT_ast_dump_filter);
+  Opts.SkipFunctionBodiesOutsideMainFile
+    = Args.hasArg(OPT_skip_function_bodies_outside_main_file);
 
   Opts.CodeCompleteOpts.IncludeMacros
     = Args.hasArg(OPT_code_completion_macros);
@@ -1590,9 +1703,21 @@ static InputKind ParseFrontendArgs(FrontendOptions &Opts, ArgList &Args,
     = !Args.hasArg(OPT_no_code_completion_globals);
   Opts.CodeCompleteOpts.IncludeBriefComments
     = Args.hasArg(OPT_code_completion_brief_comments);
+  Opts.CodeCompleteOpts.FilterPrefix
+    = Args.getLastArgValue(OPT_code_completion_prefix);
+  Opts.CodeCompleteOpts.FuzzyFilter
+    = Args.hasArg(OPT_code_completion_fuzzy);
 
   Opts.OverrideRecordLayoutsFile
     = Args.getLastArgValue(OPT_foverride_record_layout_EQ);
+  Opts.DeserializationStatsFile
+    = Args.getLastArgValue(OPT_deserialization_stats_file);
+  Opts.ShowTemplateProfile = Args.hasArg(OPT_ftemplate_profile);
+  Opts.TemplateProfileTraceFile
+    = Args.getLastArgValue(OPT_ftemplate_profile_trace);
+  Opts.CompileProfileFile = Args.getLastArgValue(OPT_compile_profile_file);
+  Opts.ModuleBuildThreads
+    = Args.getLastArgIntValue(OPT_fmodules_build_threads_EQ, 1, Diags);
   if (const Arg *A = Args.getLastArg(OPT_arcmt_check,
                                      OPT_arcmt_modify,
                                      OPT_arcmt_migrate)) {
@@ -1705,6 +1830,7 @@ static void ParseHeaderSearchArgs(HeaderSearchOptions &Opts, ArgList &Args) {
   Opts.ResourceDir = Args.getLastArgValue(OPT_resource_dir);
   Opts.ModuleCachePath = Args.getLastArgValue(OPT_fmodule_cache_path);
   Opts.DisableModuleHash = Args.hasArg(OPT_fdisable_module_hash);
+  Opts.CacheSearchDirContents = Args.hasArg(OPT_cache_search_dir_contents);
   
   // Add -I..., -F..., and -index-header-map options in order.
   bool IsIndexHeaderMap = false;
@@ -2040,6 +2166,18 @@ static void ParseLangArgs(LangOptions &Opts, ArgList &Args, InputKind IK,
       Diags.Report(diag::err_drv_invalid_value) << A->getAsString(Args) << Val;
   }
 
+  if (Arg *A = Args.getLastArg(OPT_fpch_vtables_EQ)) {
+    StringRef Val = A->getValue(Args);
+    if (Val == "everywhere")
+      Opts.setPCHVTables(LangOptions::PCHVTablesEverywhere);
+    else if (Val == "owner")
+      Opts.setPCHVTables(LangOptions::PCHVTablesOwner);
+    else if (Val == "external")
+      Opts.setPCHVTables(LangOptions::PCHVTablesExternal);
+    else
+      Diags.Report(diag::err_drv_invalid_value) << A->getAsString(Args) << Val;
+  }
+
   if (Args.hasArg(OPT_fvisibility_inlines_hidden))
     Opts.InlineVisibilityHidden = 1;
 
@@ -2081,6 +2219,7 @@ static void ParseLangArgs(LangOptions &Opts, ArgList &Args, InputKind IK,
   Opts.Blocks = Args.hasArg(OPT_fblocks);
   Opts.BlocksRuntimeOptional = Args.hasArg(OPT_fblocks_runtime_optional);
   Opts.Modules = Args.hasArg(OPT_fmodules);
+  Opts.IntrinsicsModule = Args.hasArg(OPT_fintrinsics_module);
   Opts.CharIsSigned = !Args.hasArg(OPT_fno_signed_char);
   Opts.WChar = Opts.CPlusPlus && !Args.hasArg(OPT_fno_wchar);
   Opts.ShortWChar = Args.hasArg(OPT_fshort_wchar);
@@ -2097,6 +2236,8 @@ static void ParseLangArgs(LangOptions &Opts, ArgList &Args, InputKind IK,
   Opts.ConstexprCallDepth = Args.getLastArgIntValue(OPT_fconstexpr_depth, 512,
                                                     Diags);
   Opts.DelayedTemplateParsing = Args.hasArg(OPT_fdelayed_template_parsing);
+  Opts.LazyInlineMethodParsing = Args.hasArg(OPT_flazy_inline_method_parsing);
+  Opts.CompactSystemTypeLocs = Args.hasArg(OPT_fcompact_system_type_locs);
   Opts.NumLargeByValueCopy = Args.getLastArgIntValue(OPT_Wlarge_by_value_copy_EQ,
                                                     0, Diags);
   Opts.MSBitfields = Args.hasArg(OPT_mms_bitfields);
@@ -2173,8 +2314,11 @@ static void ParsePreprocessorArgs(PreprocessorOptions &Opts, ArgList &Args,
       Opts.TokenCache = A->getValue(Args);
   else
     Opts.TokenCache = Opts.ImplicitPTHInclude;
+  Opts.RebuildStaleTokenCache = Args.hasArg(OPT_rebuild_stale_token_cache);
   Opts.UsePredefines = !Args.hasArg(OPT_undef);
   Opts.DetailedRecord = Args.hasArg(OPT_detailed_preprocessing_record);
+  Opts.CacheRepeatedIncludes = Args.hasArg(OPT_cache_repeated_includes);
+  Opts.CacheMacroArgExpansions = Args.hasArg(OPT_cache_macro_arg_expansions);
   Opts.DisablePCHValidation = Args.hasArg(OPT_fno_validate_pch);
 
   Opts.DumpDeserializedPCHDecls = Args.hasArg(OPT_dump_deserialized_pch_decls);
@@ -2233,6 +2377,7 @@ static void ParsePreprocessorArgs(PreprocessorOptions &Opts, ArgList &Args,
     const Arg *A = *it;
     Opts.ChainedIncludes.push_back(A->getValue(Args));
   }
+  Opts.ChainedIncludesCache = Args.getLastArgValue(OPT_chain_include_cache);
 
   // Include 'altivec.h' if -faltivec option present
   if (Args.hasArg(OPT_faltivec))
@@ -2343,6 +2488,20 @@ bool CompilerInvocation::CreateFromArgs(CompilerInvocation &Res,
     ParseLangArgs(*Res.getLangOpts(), *Args, DashX, Diags);
     if (Res.getFrontendOpts().ProgramAction == frontend::RewriteObjC)
       Res.getLangOpts()->ObjCExceptions = 1;
+    // Only code generation can do without the type source locations of
+    // system headers; tools and AST files need them.
+    switch (Res.getFrontendOpts().ProgramAction) {
+    case frontend::EmitAssembly:
+    case frontend::EmitBC:
+    case frontend::EmitLLVM:
+    case frontend::EmitLLVMOnly:
+    case frontend::EmitCodeGenOnly:
+    case frontend::EmitObj:
+      break;
+    default:
+      Res.getLangOpts()->CompactSystemTypeLocs = 0;
+      break;
+    }
   }
   // FIXME: ParsePreprocessorArgs uses the FileManager to read the contents of
   // PCH file and find the original header name. Remove the need to do that in
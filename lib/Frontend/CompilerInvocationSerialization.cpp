@@ -0,0 +1,686 @@
+//===--- CompilerInvocationSerialization.cpp - Binary CompilerInvocation --===//
+//
+//                     The LLVM Compiler Infrastructure
+//
+// This file is distributed under the University of Illinois Open Source
+// License. See LICENSE.TXT for details.
+//
+//===----------------------------------------------------------------------===//
+//
+// This file implements CompilerInvocation::serialize and deserialize, which
+// save an invocation in a compact binary form and load it back without
+// parsing any arguments.
+//
+// Each group of options is described by a single mapping function, which
+// both writes and reads it, so that the two directions cannot disagree. As
+// with toArgs, the mapping functions must be kept up to date by hand when
+// options are added.
+//
+//===----------------------------------------------------------------------===//
+
+#include "clang/Frontend/CompilerInvocation.h"
+#include "clang/Basic/Version.h"
+#include "llvm/ADT/SmallVector.h"
+#include <set>
+
+using namespace clang;
+
+/// \brief The first bytes of a serialized invocation.
+static const char InvocationMagic[] = { 'C', 'L', 'C', 'I' };
+
+/// \brief The version of the format, bumped whenever the options change in a
+/// way the version of clang does not already tell apart.
+static const unsigned InvocationFormatVersion = 4;
+
+namespace {
+/// \brief Appends the options to a buffer.
+class InvocationWriter {
+  SmallVectorImpl<char> &Out;
+
+public:
+  explicit InvocationWriter(SmallVectorImpl<char> &Out) : Out(Out) {}
+
+  bool isReading() const { return false; }
+
+  /// \brief Write an integer, seven bits at a time.
+  void mapInteger(uint64_t &Value) {
+    uint64_t Rest = Value;
+    do {
+      unsigned char Byte = Rest & 0x7F;
+      Rest >>= 7;
+      if (Rest)
+        Byte |= 0x80;
+      Out.push_back(Byte);
+    } while (Rest);
+  }
+
+  void mapBytes(std::string &Str) {
+    uint64_t Size = Str.size();
+    mapInteger(Size);
+    Out.append(Str.begin(), Str.end());
+  }
+
+  bool canHold(uint64_t NumElements) const { return true; }
+};
+
+/// \brief Reads the options back from a buffer, failing rather than reading
+/// past its end.
+class InvocationReader {
+  const char *Cur;
+  const char *End;
+  bool Failed;
+
+public:
+  explicit InvocationReader(StringRef Data)
+    : Cur(Data.begin()), End(Data.end()), Failed(false) {}
+
+  bool isReading() const { return true; }
+  bool hasFailed() const { return Failed; }
+  bool atEnd() const { return Cur == End; }
+  void fail() { Failed = true; }
+
+  void mapInteger(uint64_t &Value) {
+    Value = 0;
+    for (unsigned Shift = 0; Cur != End && Shift < 64; Shift += 7) {
+      unsigned char Byte = *Cur++;
+      Value |= uint64_t(Byte & 0x7F) << Shift;
+      if (!(Byte & 0x80))
+        return;
+    }
+    Failed = true;
+    Value = 0;
+  }
+
+  void mapBytes(std::string &Str) {
+    uint64_t Size;
+    mapInteger(Size);
+    if (!canHold(Size)) {
+      Str.clear();
+      return;
+    }
+    Str.assign(Cur, Size);
+    Cur += Size;
+  }
+
+  /// \brief Whether what is left of the buffer can hold \p NumElements, each
+  /// of which takes at least a byte. This keeps a corrupt count from
+  /// allocating more than the buffer could describe.
+  bool canHold(uint64_t NumElements) {
+    if (NumElements > uint64_t(End - Cur))
+      Failed = true;
+    return !Failed;
+  }
+};
+}
+
+//===----------------------------------------------------------------------===//
+// Values
+//===----------------------------------------------------------------------===//
+
+template<typename IO> static void mapValue(IO &io, std::string &Str);
+template<typename IO, typename First, typename Second>
+static void mapValue(IO &io, std::pair<First, Second> &Pair);
+template<typename IO, typename T>
+static void mapValue(IO &io, std::vector<T> &Vector);
+template<typename IO>
+static void mapValue(IO &io, HeaderSearchOptions::Entry &E);
+template<typename IO>
+static void mapValue(IO &io, HeaderSearchOptions::SystemHeaderPrefix &P);
+template<typename IO> static void mapValue(IO &io, FrontendInputFile &Input);
+
+template<typename IO> static void mapValue(IO &io, unsigned &Value) {
+  uint64_t Wide = Value;
+  io.mapInteger(Wide);
+  if (io.isReading())
+    Value = Wide;
+}
+
+template<typename IO> static void mapValue(IO &io, bool &Value) {
+  uint64_t Wide = Value;
+  io.mapInteger(Wide);
+  if (io.isReading())
+    Value = Wide;
+}
+
+template<typename IO> static void mapValue(IO &io, std::string &Str) {
+  io.mapBytes(Str);
+}
+
+template<typename IO, typename First, typename Second>
+static void mapValue(IO &io, std::pair<First, Second> &Pair) {
+  mapValue(io, Pair.first);
+  mapValue(io, Pair.second);
+}
+
+/// \brief Map a vector whose elements, when read, start out as copies of
+/// \p Proto.
+template<typename IO, typename VectorT>
+static void mapVector(IO &io, VectorT &Vector,
+                      const typename VectorT::value_type &Proto) {
+  uint64_t Size = Vector.size();
+  io.mapInteger(Size);
+  if (io.isReading()) {
+    Vector.clear();
+    if (!io.canHold(Size))
+      return;
+    Vector.assign(Size, Proto);
+  }
+  for (unsigned I = 0, N = Vector.size(); I != N; ++I)
+    mapValue(io, Vector[I]);
+}
+
+template<typename IO, typename T>
+static void mapValue(IO &io, std::vector<T> &Vector) {
+  mapVector(io, Vector, T());
+}
+
+template<typename IO>
+static void mapValue(IO &io, std::set<std::string> &Set) {
+  uint64_t Size = Set.size();
+  io.mapInteger(Size);
+  if (!io.isReading()) {
+    for (std::set<std::string>::iterator I = Set.begin(), E = Set.end();
+         I != E; ++I) {
+      std::string Str = *I;
+      mapValue(io, Str);
+    }
+    return;
+  }
+
+  Set.clear();
+  if (!io.canHold(Size))
+    return;
+  for (uint64_t I = 0; I != Size; ++I) {
+    std::string Str;
+    mapValue(io, Str);
+    Set.insert(Str);
+  }
+}
+
+template<typename IO>
+static void mapValue(IO &io, llvm::StringMap<std::string> &Map) {
+  uint64_t Size = Map.size();
+  io.mapInteger(Size);
+  if (!io.isReading()) {
+    for (llvm::StringMap<std::string>::iterator I = Map.begin(),
+                                                E = Map.end();
+         I != E; ++I) {
+      std::string Key = I->getKey().str();
+      mapValue(io, Key);
+      mapValue(io, I->getValue());
+    }
+    return;
+  }
+
+  Map.clear();
+  if (!io.canHold(Size))
+    return;
+  for (uint64_t I = 0; I != Size; ++I) {
+    std::string Key;
+    mapValue(io, Key);
+    mapValue(io, Map[Key]);
+  }
+}
+
+// Bitfields and enumerations cannot be bound to references, so they go
+// through a temporary. The writer works on a const invocation and must not
+// store anything back.
+#define MAP_UNSIGNED(Field) \
+  do { \
+    uint64_t Value = Opts.Field; \
+    io.mapInteger(Value); \
+    if (io.isReading()) \
+      Opts.Field = Value; \
+  } while (0)
+
+#define MAP_ENUM(Field, Type) \
+  do { \
+    uint64_t Value = Opts.Field; \
+    io.mapInteger(Value); \
+    if (io.isReading()) \
+      Opts.Field = static_cast<Type>(Value); \
+  } while (0)
+
+#define MAP_VALUE(Field) mapValue(io, Opts.Field)
+
+template<typename IO>
+static void mapValue(IO &io, HeaderSearchOptions::Entry &Opts) {
+  MAP_VALUE(Path);
+  MAP_ENUM(Group, frontend::IncludeDirGroup);
+  MAP_UNSIGNED(IsUserSupplied);
+  MAP_UNSIGNED(IsFramework);
+  MAP_UNSIGNED(IgnoreSysRoot);
+  MAP_UNSIGNED(IsInternal);
+  MAP_UNSIGNED(ImplicitExternC);
+}
+
+template<typename IO>
+static void mapValue(IO &io, HeaderSearchOptions::SystemHeaderPrefix &Opts) {
+  MAP_VALUE(Prefix);
+  MAP_VALUE(IsSystemHeader);
+}
+
+template<typename IO>
+static void mapValue(IO &io, FrontendInputFile &Opts) {
+  MAP_VALUE(File);
+  MAP_ENUM(Kind, InputKind);
+  MAP_VALUE(IsSystem);
+}
+
+//===----------------------------------------------------------------------===//
+// Option Groups
+//===----------------------------------------------------------------------===//
+
+template<typename IO>
+static void mapAnalyzerOptions(IO &io, AnalyzerOptions &Opts) {
+  // The private members only cache what is computed from Config.
+  MAP_VALUE(CheckersControlList);
+  MAP_VALUE(Config);
+  MAP_ENUM(AnalysisStoreOpt, AnalysisStores);
+  MAP_ENUM(AnalysisConstraintsOpt, AnalysisConstraints);
+  MAP_ENUM(AnalysisDiagOpt, AnalysisDiagClients);
+  MAP_ENUM(AnalysisPurgeOpt, AnalysisPurgeMode);
+  MAP_ENUM(IPAMode, AnalysisIPAMode);
+  MAP_VALUE(AnalyzeSpecificFunction);
+  MAP_VALUE(FunctionSummariesFile);
+  MAP_VALUE(CheckerProfileFile);
+  MAP_VALUE(ResultCacheFile);
+  MAP_VALUE(MaxNodes);
+  MAP_VALUE(maxBlockVisitOnPath);
+  MAP_UNSIGNED(ShowCheckerHelp);
+  MAP_UNSIGNED(AnalyzeAll);
+  MAP_UNSIGNED(AnalyzerDisplayProgress);
+  MAP_UNSIGNED(AnalyzeNestedBlocks);
+  MAP_UNSIGNED(eagerlyAssumeBinOpBifurcation);
+  MAP_UNSIGNED(TrimGraph);
+  MAP_UNSIGNED(visualizeExplodedGraphWithGraphViz);
+  MAP_UNSIGNED(visualizeExplodedGraphWithUbiGraph);
+  MAP_UNSIGNED(UnoptimizedCFG);
+  MAP_UNSIGNED(eagerlyTrimExplodedGraph);
+  MAP_UNSIGNED(PrintStats);
+  MAP_UNSIGNED(NoRetryExhausted);
+  MAP_VALUE(InlineMaxStackDepth);
+  MAP_VALUE(InlineMaxFunctionSize);
+  MAP_ENUM(InliningMode, AnalysisInliningMode);
+}
+
+template<typename IO>
+static void mapMigratorOptions(IO &io, MigratorOptions &Opts) {
+  MAP_UNSIGNED(NoNSAllocReallocError);
+  MAP_UNSIGNED(NoFinalizeRemoval);
+}
+
+template<typename IO>
+static void mapCodeGenOptions(IO &io, CodeGenOptions &Opts) {
+  MAP_UNSIGNED(AsmVerbose);
+  MAP_UNSIGNED(ObjCAutoRefCountExceptions);
+  MAP_UNSIGNED(CUDAIsDevice);
+  MAP_UNSIGNED(CXAAtExit);
+  MAP_UNSIGNED(CXXCtorDtorAliases);
+  MAP_UNSIGNED(DataSections);
+  MAP_UNSIGNED(DisableFPElim);
+  MAP_UNSIGNED(DisableLifetimeMarkers);
+  MAP_UNSIGNED(DisableLLVMOpts);
+  MAP_UNSIGNED(DisableRedZone);
+  MAP_UNSIGNED(DisableTailCalls);
+  MAP_UNSIGNED(DebugVTableHoming);
+  MAP_UNSIGNED(EmitDeclMetadata);
+  MAP_UNSIGNED(EmitGcovArcs);
+  MAP_UNSIGNED(EmitGcovNotes);
+  MAP_UNSIGNED(EmitOpenCLArgMetadata);
+  MAP_UNSIGNED(ForbidGuardVariables);
+  MAP_UNSIGNED(FunctionSections);
+  MAP_UNSIGNED(HiddenWeakTemplateVTables);
+  MAP_UNSIGNED(HiddenWeakVTables);
+  MAP_UNSIGNED(InstrumentFunctions);
+  MAP_UNSIGNED(InstrumentForProfiling);
+  MAP_UNSIGNED(LessPreciseFPMAD);
+  MAP_UNSIGNED(MergeAllConstants);
+  MAP_UNSIGNED(NoCommon);
+  MAP_UNSIGNED(NoDwarf2CFIAsm);
+  MAP_UNSIGNED(NoDwarfDirectoryAsm);
+  MAP_UNSIGNED(NoExecStack);
+  MAP_UNSIGNED(NoGlobalMerge);
+  MAP_UNSIGNED(NoImplicitFloat);
+  MAP_UNSIGNED(NoInfsFPMath);
+  MAP_UNSIGNED(NoInline);
+  MAP_UNSIGNED(NoNaNsFPMath);
+  MAP_UNSIGNED(NoZeroInitializedInBSS);
+  MAP_UNSIGNED(ObjCDispatchMethod);
+  MAP_UNSIGNED(ObjCSendCache);
+  MAP_UNSIGNED(OmitLeafFramePointer);
+  MAP_UNSIGNED(OptimizationLevel);
+  MAP_UNSIGNED(OptimizeSize);
+  MAP_UNSIGNED(ProfileInstrGenerate);
+  MAP_UNSIGNED(RelaxAll);
+  MAP_UNSIGNED(RelaxedAliasing);
+  MAP_UNSIGNED(ReleaseFunctionBodies);
+  MAP_UNSIGNED(SaveTempLabels);
+  MAP_UNSIGNED(SimplifyLibCalls);
+  MAP_UNSIGNED(SoftFloat);
+  MAP_UNSIGNED(StrictEnums);
+  MAP_UNSIGNED(TimePasses);
+  MAP_UNSIGNED(UnitAtATime);
+  MAP_UNSIGNED(UnrollLoops);
+  MAP_UNSIGNED(UnsafeFPMath);
+  MAP_UNSIGNED(UnwindTables);
+  MAP_UNSIGNED(UseRegisterSizedBitfieldAccess);
+  MAP_UNSIGNED(VerifyModule);
+  MAP_UNSIGNED(StackRealignment);
+  MAP_UNSIGNED(UseInitArray);
+  MAP_VALUE(StackAlignment);
+  MAP_VALUE(CodeModel);
+  MAP_VALUE(CoverageFile);
+  MAP_VALUE(DebugPass);
+  MAP_VALUE(DebugCompilationDir);
+  MAP_ENUM(DebugInfo, CodeGenOptions::DebugInfoKind);
+  MAP_VALUE(DwarfDebugFlags);
+  MAP_VALUE(FloatABI);
+  MAP_VALUE(LimitFloatPrecision);
+  MAP_VALUE(LinkBitcodeFile);
+  MAP_ENUM(Inlining, CodeGenOptions::InliningMethod);
+  MAP_VALUE(MainFileName);
+  MAP_VALUE(RelocationModel);
+  MAP_VALUE(InstrProfileInput);
+  MAP_VALUE(OptimizationRemarkPattern);
+  MAP_VALUE(TrapFuncName);
+  MAP_VALUE(BackendOptions);
+  MAP_VALUE(NumRegisterParameters);
+  MAP_UNSIGNED(BoundsChecking);
+  MAP_VALUE(SSPBufferSize);
+  MAP_VALUE(LifetimeMarkersMinSize);
+  MAP_ENUM(DefaultTLSModel, CodeGenOptions::TLSModel);
+}
+
+template<typename IO>
+static void mapDependencyOutputOptions(IO &io, DependencyOutputOptions &Opts) {
+  MAP_UNSIGNED(IncludeSystemHeaders);
+  MAP_UNSIGNED(ShowHeaderIncludes);
+  MAP_UNSIGNED(UsePhonyTargets);
+  MAP_UNSIGNED(AddMissingHeaderDeps);
+  MAP_VALUE(OutputFile);
+  MAP_VALUE(HeaderIncludeOutputFile);
+  MAP_VALUE(HeaderCostFile);
+  MAP_VALUE(Targets);
+  MAP_VALUE(DOTOutputFile);
+}
+
+template<typename IO>
+static void mapDiagnosticOptions(IO &io, DiagnosticOptions &Opts) {
+  MAP_UNSIGNED(IgnoreWarnings);
+  MAP_UNSIGNED(NoRewriteMacros);
+  MAP_UNSIGNED(Pedantic);
+  MAP_UNSIGNED(PedanticErrors);
+  MAP_UNSIGNED(ShowColumn);
+  MAP_UNSIGNED(ShowLocation);
+  MAP_UNSIGNED(ShowCarets);
+  MAP_UNSIGNED(ShowFixits);
+  MAP_UNSIGNED(ShowSourceRanges);
+  MAP_UNSIGNED(ShowParseableFixits);
+  MAP_UNSIGNED(ShowOptionNames);
+  MAP_UNSIGNED(ShowNoteIncludeStack);
+  MAP_UNSIGNED(ShowCategories);
+  MAP_UNSIGNED(Format);
+  MAP_UNSIGNED(ShowColors);
+  MAP_UNSIGNED(ShowOverloads);
+  MAP_UNSIGNED(VerifyDiagnostics);
+  MAP_UNSIGNED(ElideType);
+  MAP_UNSIGNED(ShowTemplateTree);
+  MAP_VALUE(ErrorLimit);
+  MAP_VALUE(MacroBacktraceLimit);
+  MAP_VALUE(TemplateBacktraceLimit);
+  MAP_VALUE(ConstexprBacktraceLimit);
+  MAP_VALUE(TabStop);
+  MAP_VALUE(MessageLength);
+  MAP_VALUE(DumpBuildInformation);
+  MAP_VALUE(DiagnosticLogFile);
+  MAP_VALUE(DiagnosticSerializationFile);
+  MAP_VALUE(Warnings);
+}
+
+template<typename IO>
+static void mapFileSystemOptions(IO &io, FileSystemOptions &Opts) {
+  MAP_VALUE(WorkingDir);
+  MAP_VALUE(PrefetchFileList);
+  MAP_VALUE(UseSharedStatCache);
+}
+
+template<typename IO>
+static void mapCodeCompleteOptions(IO &io, CodeCompleteOptions &Opts) {
+  MAP_UNSIGNED(IncludeMacros);
+  MAP_UNSIGNED(IncludeCodePatterns);
+  MAP_UNSIGNED(IncludeGlobals);
+  MAP_UNSIGNED(IncludeBriefComments);
+  MAP_UNSIGNED(FuzzyFilter);
+  MAP_VALUE(FilterPrefix);
+}
+
+template<typename IO>
+static void mapFrontendOptions(IO &io, FrontendOptions &Opts) {
+  MAP_UNSIGNED(DisableFree);
+  MAP_UNSIGNED(RelocatablePCH);
+  MAP_UNSIGNED(CompressPCH);
+  MAP_UNSIGNED(DeterministicPCH);
+  MAP_UNSIGNED(ShowHelp);
+  MAP_UNSIGNED(ShowStats);
+  MAP_UNSIGNED(ShowMemoryStats);
+  MAP_UNSIGNED(ShowTimers);
+  MAP_UNSIGNED(ShowVersion);
+  MAP_UNSIGNED(FixWhatYouCan);
+  MAP_UNSIGNED(FixOnlyWarnings);
+  MAP_UNSIGNED(FixAndRecompile);
+  MAP_UNSIGNED(FixToTemporaries);
+  MAP_UNSIGNED(ARCMTMigrateEmitARCErrors);
+  MAP_UNSIGNED(SkipFunctionBodies);
+  MAP_UNSIGNED(SkipFunctionBodiesOutsideMainFile);
+  MAP_UNSIGNED(ShowTemplateProfile);
+  MAP_UNSIGNED(ReleaseSourceBuffers);
+  mapCodeCompleteOptions(io, Opts.CodeCompleteOpts);
+
+  // The type of ARCMTAction has no name to cast to.
+  uint64_t ARCMTAction = Opts.ARCMTAction;
+  io.mapInteger(ARCMTAction);
+  if (io.isReading()) {
+    switch (ARCMTAction) {
+    case FrontendOptions::ARCMT_None:
+      Opts.ARCMTAction = FrontendOptions::ARCMT_None;
+      break;
+    case FrontendOptions::ARCMT_Check:
+      Opts.ARCMTAction = FrontendOptions::ARCMT_Check;
+      break;
+    case FrontendOptions::ARCMT_Modify:
+      Opts.ARCMTAction = FrontendOptions::ARCMT_Modify;
+      break;
+    case FrontendOptions::ARCMT_Migrate:
+      Opts.ARCMTAction = FrontendOptions::ARCMT_Migrate;
+      break;
+    default:
+      io.fail();
+      break;
+    }
+  }
+
+  MAP_VALUE(ObjCMTAction);
+  MAP_VALUE(MTMigrateDir);
+  MAP_VALUE(ARCMTMigrateReportOut);
+  MAP_VALUE(Inputs);
+  MAP_VALUE(OutputFile);
+  MAP_VALUE(FixItSuffix);
+  MAP_VALUE(ASTDumpFilter);
+  MAP_VALUE(CodeCompletionAt.FileName);
+  MAP_VALUE(CodeCompletionAt.Line);
+  MAP_VALUE(CodeCompletionAt.Column);
+  MAP_ENUM(ProgramAction, frontend::ActionKind);
+  MAP_VALUE(ActionName);
+  MAP_VALUE(PluginArgs);
+  MAP_VALUE(AddPluginActions);
+  MAP_VALUE(AddPluginArgs);
+  MAP_VALUE(Plugins);
+  MAP_VALUE(ASTMergeFiles);
+  MAP_VALUE(LLVMArgs);
+  MAP_VALUE(OverrideRecordLayoutsFile);
+  MAP_VALUE(DeserializationStatsFile);
+  MAP_VALUE(TemplateProfileTraceFile);
+  MAP_VALUE(CompileProfileFile);
+  MAP_VALUE(ModuleBuildThreads);
+}
+
+template<typename IO>
+static void mapHeaderSearchOptions(IO &io, HeaderSearchOptions &Opts) {
+  MAP_VALUE(Sysroot);
+  mapVector(io, Opts.UserEntries,
+            HeaderSearchOptions::Entry("", frontend::Angled, false, false,
+                                       false, false, false));
+  mapVector(io, Opts.SystemHeaderPrefixes,
+            HeaderSearchOptions::SystemHeaderPrefix("", false));
+  MAP_VALUE(ResourceDir);
+  MAP_VALUE(ModuleCachePath);
+  MAP_UNSIGNED(DisableModuleHash);
+  MAP_UNSIGNED(UseBuiltinIncludes);
+  MAP_UNSIGNED(UseStandardSystemIncludes);
+  MAP_UNSIGNED(UseStandardCXXIncludes);
+  MAP_UNSIGNED(UseLibcxx);
+  MAP_UNSIGNED(Verbose);
+  MAP_UNSIGNED(CacheSearchDirContents);
+}
+
+template<typename IO>
+static void mapLangOptions(IO &io, LangOptions &Opts) {
+#define LANGOPT(Name, Bits, Default, Description) \
+  MAP_UNSIGNED(Name);
+#define ENUM_LANGOPT(Name, Type, Bits, Default, Description) \
+  do { \
+    uint64_t Value = Opts.get##Name(); \
+    io.mapInteger(Value); \
+    if (io.isReading()) \
+      Opts.set##Name(static_cast<Type>(Value)); \
+  } while (0);
+#include "clang/Basic/LangOptions.def"
+
+  std::string ObjCRuntime = Opts.ObjCRuntime.getAsString();
+  mapValue(io, ObjCRuntime);
+  if (io.isReading() && Opts.ObjCRuntime.tryParse(ObjCRuntime))
+    io.fail();
+  MAP_VALUE(ObjCConstantStringClass);
+  MAP_VALUE(OverflowHandler);
+  MAP_VALUE(CurrentModule);
+}
+
+template<typename IO>
+static void mapPreprocessorOptions(IO &io, PreprocessorOptions &Opts) {
+  // RemappedFileBuffers are refused by serialize().
+  MAP_VALUE(Macros);
+  MAP_VALUE(Includes);
+  MAP_VALUE(MacroIncludes);
+  MAP_UNSIGNED(UsePredefines);
+  MAP_UNSIGNED(DetailedRecord);
+  MAP_UNSIGNED(DetailedRecordConditionalDirectives);
+  MAP_UNSIGNED(CacheRepeatedIncludes);
+  MAP_UNSIGNED(CacheMacroArgExpansions);
+  MAP_VALUE(ImplicitPCHInclude);
+  MAP_VALUE(ChainedIncludes);
+  MAP_VALUE(ChainedIncludesCache);
+  MAP_VALUE(DisablePCHValidation);
+  MAP_VALUE(DisableStatCache);
+  MAP_VALUE(AllowPCHWithCompilerErrors);
+  MAP_VALUE(DumpDeserializedPCHDecls);
+  MAP_VALUE(DeserializedPCHDeclsToErrorOn);
+  MAP_VALUE(PrecompiledPreambleBytes);
+  MAP_VALUE(ImplicitPTHInclude);
+  MAP_VALUE(TokenCache);
+  MAP_VALUE(RebuildStaleTokenCache);
+  MAP_VALUE(RemappedFilesKeepOriginalName);
+  MAP_VALUE(RemappedFiles);
+  MAP_VALUE(RetainRemappedFileBuffers);
+  MAP_ENUM(ObjCXXARCStandardLibrary, ObjCXXARCStandardLibraryKind);
+  mapVector(io, Opts.ModuleBuildPath, std::string());
+}
+
+template<typename IO>
+static void mapPreprocessorOutputOptions(IO &io,
+                                         PreprocessorOutputOptions &Opts) {
+  MAP_UNSIGNED(ShowCPP);
+  MAP_UNSIGNED(ShowComments);
+  MAP_UNSIGNED(ShowLineMarkers);
+  MAP_UNSIGNED(ShowMacroComments);
+  MAP_UNSIGNED(ShowMacros);
+  MAP_UNSIGNED(RewriteIncludes);
+}
+
+template<typename IO>
+static void mapTargetOptions(IO &io, TargetOptions &Opts) {
+  MAP_VALUE(Triple);
+  MAP_VALUE(CPU);
+  MAP_VALUE(ABI);
+  MAP_VALUE(CXXABI);
+  MAP_VALUE(LinkerVersion);
+  MAP_VALUE(Features);
+}
+
+#undef MAP_UNSIGNED
+#undef MAP_ENUM
+#undef MAP_VALUE
+
+/// \brief Map every group of options of \p Invocation.
+template<typename IO>
+static void mapInvocation(IO &io, CompilerInvocation &Invocation) {
+  mapAnalyzerOptions(io, *Invocation.getAnalyzerOpts());
+  mapMigratorOptions(io, Invocation.getMigratorOpts());
+  mapCodeGenOptions(io, Invocation.getCodeGenOpts());
+  mapDependencyOutputOptions(io, Invocation.getDependencyOutputOpts());
+  mapDiagnosticOptions(io, Invocation.getDiagnosticOpts());
+  mapFileSystemOptions(io, Invocation.getFileSystemOpts());
+  mapFrontendOptions(io, Invocation.getFrontendOpts());
+  mapHeaderSearchOptions(io, Invocation.getHeaderSearchOpts());
+  mapLangOptions(io, *Invocation.getLangOpts());
+  mapPreprocessorOptions(io, Invocation.getPreprocessorOpts());
+  mapPreprocessorOutputOptions(io, Invocation.getPreprocessorOutputOpts());
+  mapTargetOptions(io, Invocation.getTargetOpts());
+}
+
+/// \brief The version of clang, which the reader insists on, since the
+/// options of two versions may have the same format but mean different
+/// things.
+static std::string getInvocationVersion() {
+  return getClangFullRepositoryVersion();
+}
+
+bool CompilerInvocation::serialize(SmallVectorImpl<char> &Out) const {
+  // A memory buffer cannot outlive the process that owns it.
+  if (!PreprocessorOpts.RemappedFileBuffers.empty())
+    return false;
+
+  Out.append(InvocationMagic, InvocationMagic + sizeof(InvocationMagic));
+  InvocationWriter Writer(Out);
+  uint64_t FormatVersion = InvocationFormatVersion;
+  Writer.mapInteger(FormatVersion);
+  std::string Version = getInvocationVersion();
+  Writer.mapBytes(Version);
+
+  // The writer stores nothing back into the options.
+  mapInvocation(Writer, const_cast<CompilerInvocation &>(*this));
+  return true;
+}
+
+bool CompilerInvocation::deserialize(CompilerInvocation &Res,
+                                     StringRef Data) {
+  if (!Data.startswith(StringRef(InvocationMagic, sizeof(InvocationMagic))))
+    return false;
+
+  InvocationReader Reader(Data.substr(sizeof(InvocationMagic)));
+  uint64_t FormatVersion;
+  Reader.mapInteger(FormatVersion);
+  if (Reader.hasFailed() || FormatVersion != InvocationFormatVersion)
+    return false;
+  std::string Version;
+  Reader.mapBytes(Version);
+  if (Reader.hasFailed() || Version != getInvocationVersion())
+    return false;
+
+  // Do not write through to options shared with copies of Res.
+  Res.LangOpts = new LangOptions();
+  Res.AnalyzerOpts = new AnalyzerOptions();
+  Res.PreprocessorOpts.clearRemappedFiles();
+  mapInvocation(Reader, Res);
+  return !Reader.hasFailed() && Reader.atEnd();
+}
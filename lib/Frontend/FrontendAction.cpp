@@ -11,6 +11,7 @@
 #include "clang/AST/ASTConsumer.h"
 #include "clang/AST/ASTContext.h"
 #include "clang/AST/DeclGroup.h"
+#include "clang/Basic/CompilationProfile.h"
 #include "clang/Lex/HeaderSearch.h"
 #include "clang/Lex/Preprocessor.h"
 #include "clang/Frontend/ASTUnit.h"
@@ -18,9 +19,12 @@
 #include "clang/Frontend/CompilerInstance.h"
 #include "clang/Frontend/FrontendDiagnostic.h"
 #include "clang/Frontend/FrontendPluginRegistry.h"
+#include "clang/Frontend/HeaderCostTracker.h"
 #include "clang/Frontend/LayoutOverrideSource.h"
 #include "clang/Frontend/MultiplexConsumer.h"
 #include "clang/Parse/ParseAST.h"
+#include "clang/Sema/Sema.h"
+#include "clang/Sema/TemplateInstantiationProfiler.h"
 #include "clang/Serialization/ASTDeserializationListener.h"
 #include "clang/Serialization/ASTReader.h"
 #include "llvm/Support/MemoryBuffer.h"
@@ -128,13 +132,17 @@ ASTConsumer* FrontendAction::CreateWrappedASTConsumer(CompilerInstance &CI,
   if (!Consumer)
     return 0;
 
-  if (CI.getFrontendOpts().AddPluginActions.size() == 0)
+  if (CI.getFrontendOpts().AddPluginActions.size() == 0 &&
+      !CI.hasHeaderCostTracker())
     return Consumer;
 
   // Make sure the non-plugin consumer is first, so that plugins can't
   // modifiy the AST.
   std::vector<ASTConsumer*> Consumers(1, Consumer);
 
+  if (CI.hasHeaderCostTracker())
+    Consumers.push_back(CI.getHeaderCostTracker().createASTConsumer());
+
   for (size_t i = 0, e = CI.getFrontendOpts().AddPluginActions.size();
        i != e; ++i) { 
     // This is O(|plugins| * |add_plugins|), but since both numbers are
@@ -282,12 +290,17 @@ bool FrontendAction::BeginSourceFile(CompilerInstance &CI,
       goto failure;
   }
 
-  // Initialize built-in info as long as we aren't using an external AST
-  // source.
-  if (!CI.hasASTContext() || !CI.getASTContext().getExternalSource()) {
+  // Initialize built-in info. The identifiers of an external AST source
+  // already carry their builtin IDs, but the builtins it does not mention
+  // still need to be found.
+  if (CI.hasPreprocessor()) {
     Preprocessor &PP = CI.getPreprocessor();
+    bool HasExternalSource = CI.hasASTContext() &&
+                             CI.getASTContext().getExternalSource();
     PP.getBuiltinInfo().InitializeBuiltins(PP.getIdentifierTable(),
-                                           PP.getLangOpts());
+                                           PP.getLangOpts(),
+                                           /*OnlyNewIdentifiers=*/
+                                             HasExternalSource);
   }
 
   // If there is a layout overrides file, attach an external AST source that
@@ -332,6 +345,13 @@ bool FrontendAction::Execute() {
       return false;
   }
 
+  // Lexing is interleaved with parsing, so only actions which do nothing
+  // but preprocess have a preprocessing phase of their own.
+  CompilationProfileRegion Region(
+      CI.hasCompilationProfile() ? &CI.getCompilationProfile() : 0,
+      usesPreprocessorOnly() ? CompilationProfile::Preprocessing
+                             : CompilationProfile::Frontend);
+
   if (CI.hasFrontendTimer()) {
     llvm::TimeRegion Timer(CI.getFrontendTimer());
     ExecuteAction();
@@ -344,6 +364,72 @@ bool FrontendAction::Execute() {
 void FrontendAction::EndSourceFile() {
   CompilerInstance &CI = getCompilerInstance();
 
+  // Write the AST reader statistics while the AST it has read is still alive.
+  const std::string &StatsFile = CI.getFrontendOpts().DeserializationStatsFile;
+  if (!StatsFile.empty() && CI.hasASTContext() && CI.getModuleManager() &&
+      CI.getASTContext().getExternalSource() == CI.getModuleManager()) {
+    std::string Error;
+    llvm::raw_fd_ostream OS(StatsFile.c_str(), Error);
+    if (Error.empty())
+      CI.getModuleManager()->PrintStatsJSON(OS);
+    else
+      CI.getDiagnostics().Report(diag::err_fe_unable_to_open_output)
+        << StatsFile << Error;
+  }
+
+  // Report the template instantiations while their declarations are alive.
+  if (CI.hasSema())
+    if (sema::TemplateInstantiationProfiler *Profiler
+          = CI.getSema().getInstantiationProfiler()) {
+      if (CI.getFrontendOpts().ShowTemplateProfile)
+        Profiler->printReport(llvm::errs());
+      const std::string &TraceFile
+        = CI.getFrontendOpts().TemplateProfileTraceFile;
+      if (!TraceFile.empty()) {
+        std::string Error;
+        llvm::raw_fd_ostream OS(TraceFile.c_str(), Error);
+        if (Error.empty())
+          Profiler->printTraceJSON(OS);
+        else
+          CI.getDiagnostics().Report(diag::err_fe_unable_to_open_output)
+            << TraceFile << Error;
+      }
+    }
+
+  // Clients of the library may profile without asking for a file.
+  if (CI.hasCompilationProfile() &&
+      !CI.getFrontendOpts().CompileProfileFile.empty()) {
+    const std::string &ProfileFile = CI.getFrontendOpts().CompileProfileFile;
+    std::string Error;
+    llvm::raw_fd_ostream OS(ProfileFile.c_str(), Error);
+    if (Error.empty())
+      CI.getCompilationProfile().printJSON(OS, getCurrentFile());
+    else
+      CI.getDiagnostics().Report(diag::err_fe_unable_to_open_output)
+        << ProfileFile << Error;
+  }
+
+  // Each translation unit appends a line, so that one file collects the
+  // costs of a whole build.
+  if (CI.hasHeaderCostTracker()) {
+    const std::string &CostFile = CI.getDependencyOutputOpts().HeaderCostFile;
+    std::string Error;
+    llvm::raw_fd_ostream OS(CostFile.c_str(), Error,
+                            llvm::raw_fd_ostream::F_Append);
+    if (Error.empty()) {
+      // Write the line at once, so that concurrent compilations don't
+      // interleave their lines.
+      std::string Line;
+      llvm::raw_string_ostream LineOS(Line);
+      CI.getHeaderCostTracker().printJSON(LineOS, getCurrentFile());
+      OS.SetUnbuffered();
+      OS.SetUseAtomicWrites(true);
+      OS << LineOS.str();
+    } else
+      CI.getDiagnostics().Report(diag::err_fe_unable_to_open_output)
+        << CostFile << Error;
+  }
+
   // Inform the diagnostic client we are done with this source file.
   CI.getDiagnosticClient().EndSourceFile();
 
@@ -419,7 +505,11 @@ void ASTFrontendAction::ExecuteAction() {
     CI.createSema(getTranslationUnitKind(), CompletionConsumer);
 
   ParseAST(CI.getSema(), CI.getFrontendOpts().ShowStats,
-           CI.getFrontendOpts().SkipFunctionBodies);
+           CI.getFrontendOpts().SkipFunctionBodies,
+           CI.getFrontendOpts().SkipFunctionBodiesOutsideMainFile);
+
+  if (CI.getFrontendOpts().ShowMemoryStats)
+    CI.getASTContext().PrintMemoryStats(llvm::errs());
 }
 
 void PluginASTAction::anchor() { }
@@ -92,7 +92,9 @@ ASTConsumer *GeneratePCHAction::CreateASTConsumer(CompilerInstance &CI,
 
   if (!CI.getFrontendOpts().RelocatablePCH)
     Sysroot.clear();
-  return new PCHGenerator(CI.getPreprocessor(), OutputFile, 0, Sysroot, OS);
+  return new PCHGenerator(CI.getPreprocessor(), OutputFile, 0, Sysroot, OS,
+                          CI.getFrontendOpts().CompressPCH,
+                          CI.getFrontendOpts().DeterministicPCH);
 }
 
 bool GeneratePCHAction::ComputeASTConsumerArguments(CompilerInstance &CI,
@@ -128,7 +130,8 @@ ASTConsumer *GenerateModuleAction::CreateASTConsumer(CompilerInstance &CI,
     return 0;
   
   return new PCHGenerator(CI.getPreprocessor(), OutputFile, Module, 
-                          Sysroot, OS);
+                          Sysroot, OS, CI.getFrontendOpts().CompressPCH,
+                          CI.getFrontendOpts().DeterministicPCH);
 }
 
 /// \brief Collect the set of header includes needed to construct the given 
@@ -422,6 +425,20 @@ void PreprocessOnlyAction::ExecuteAction() {
   } while (Tok.isNot(tok::eof));
 }
 
+void ScanDependenciesAction::ExecuteAction() {
+  Preprocessor &PP = getCompilerInstance().getPreprocessor();
+
+  // Ignore unknown pragmas.
+  PP.AddPragmaHandler(new EmptyPragmaHandler());
+  PP.setSkipNonDirectiveLines(true);
+
+  Token Tok;
+  PP.EnterMainSourceFile();
+  do {
+    PP.Lex(Tok);
+  } while (Tok.isNot(tok::eof));
+}
+
 void PrintPreprocessedAction::ExecuteAction() {
   CompilerInstance &CI = getCompilerInstance();
   // Output file may need to be set to 'Binary', to avoid converting Unix style
@@ -468,6 +485,11 @@ void PrintPreprocessedAction::ExecuteAction() {
   raw_ostream *OS = CI.createDefaultOutputFile(BinaryMode, getCurrentFile());
   if (!OS) return;
 
+  // The output is written a few characters at a time; make sure it reaches
+  // the file in large blocks.
+  if (OS->GetBufferSize() && OS->GetBufferSize() < 64 * 1024)
+    OS->SetBufferSize(64 * 1024);
+
   DoPrintPreprocessedInput(CI.getPreprocessor(), OS,
                            CI.getPreprocessorOutputOpts());
 }
@@ -0,0 +1,267 @@
+//===--- HeaderCostTracker.cpp - What each header costs -------------------===//
+//
+//                     The LLVM Compiler Infrastructure
+//
+// This file is distributed under the University of Illinois Open Source
+// License. See LICENSE.TXT for details.
+//
+//===----------------------------------------------------------------------===//
+//
+// This file implements HeaderCostTracker.
+//
+//===----------------------------------------------------------------------===//
+
+#include "clang/Frontend/HeaderCostTracker.h"
+#include "clang/AST/ASTConsumer.h"
+#include "clang/AST/ASTContext.h"
+#include "clang/AST/DeclBase.h"
+#include "clang/Basic/FileManager.h"
+#include "clang/Basic/ProfilingSupport.h"
+#include "clang/Basic/SourceManager.h"
+#include "clang/Lex/Lexer.h"
+#include "clang/Lex/PPCallbacks.h"
+#include "clang/Lex/Preprocessor.h"
+#include "clang/Serialization/ASTDeserializationListener.h"
+#include "llvm/ADT/StringMap.h"
+#include "llvm/Support/ErrorHandling.h"
+#include "llvm/Support/MemoryBuffer.h"
+#include "llvm/Support/raw_ostream.h"
+
+using namespace clang;
+
+namespace {
+class HeaderCostCallbacks : public PPCallbacks {
+  HeaderCostTracker &Tracker;
+  SourceManager &SM;
+
+public:
+  HeaderCostCallbacks(HeaderCostTracker &Tracker, SourceManager &SM)
+    : Tracker(Tracker), SM(SM) {}
+
+  virtual void FileChanged(SourceLocation Loc, FileChangeReason Reason,
+                           SrcMgr::CharacteristicKind FileType,
+                           FileID PrevFID) {
+    if (Reason == EnterFile)
+      Tracker.enteredFile(SM.getFileID(SM.getExpansionLoc(Loc)));
+    else if (Reason == ExitFile)
+      Tracker.exitedFile();
+  }
+
+  virtual void MacroExpands(const Token &MacroNameTok, const MacroInfo *MI,
+                            SourceRange Range) {
+    Tracker.expandedMacro();
+  }
+
+  virtual void EndOfMainFile() {
+    Tracker.finishedMainFile();
+  }
+};
+
+class HeaderCostConsumer : public ASTConsumer,
+                           public ASTDeserializationListener {
+  HeaderCostTracker &Tracker;
+
+public:
+  explicit HeaderCostConsumer(HeaderCostTracker &Tracker)
+    : Tracker(Tracker) {}
+
+  virtual void HandleTranslationUnit(ASTContext &Ctx) {
+    Tracker.countDecls(Ctx.getTranslationUnitDecl());
+  }
+
+  virtual ASTDeserializationListener *GetASTDeserializationListener() {
+    return this;
+  }
+
+  virtual void DeclRead(serialization::DeclID ID, const Decl *D) {
+    Tracker.deserializedDecl();
+  }
+};
+}
+
+HeaderCostTracker::HeaderCostTracker(Preprocessor &PP)
+  : PP(PP), LastTime(getCurrentTimeInNanoseconds()), Finished(false) {}
+
+PPCallbacks *HeaderCostTracker::createPPCallbacks() {
+  return new HeaderCostCallbacks(*this, PP.getSourceManager());
+}
+
+ASTConsumer *HeaderCostTracker::createASTConsumer() {
+  return new HeaderCostConsumer(*this);
+}
+
+void HeaderCostTracker::chargeElapsed() {
+  uint64_t NowTime = getCurrentTimeInNanoseconds();
+  if (!Finished && !Stack.empty())
+    Inclusions[Stack.back()].Costs[Time] += NowTime - LastTime;
+  LastTime = NowTime;
+}
+
+void HeaderCostTracker::countTokens(Inclusion &I) {
+  SourceManager &SM = PP.getSourceManager();
+  bool Invalid = false;
+  const llvm::MemoryBuffer *Buffer = SM.getBuffer(I.FID, &Invalid);
+  if (Invalid)
+    return;
+
+  Lexer RawLex(I.FID, Buffer, SM, PP.getLangOpts());
+  Token Tok;
+  for (RawLex.LexFromRawLexer(Tok); Tok.isNot(tok::eof);
+       RawLex.LexFromRawLexer(Tok))
+    ++I.Costs[Tokens];
+
+  // Lexing the file again is not part of its cost.
+  LastTime = getCurrentTimeInNanoseconds();
+}
+
+void HeaderCostTracker::enteredFile(FileID FID) {
+  chargeElapsed();
+  Inclusion I;
+  I.FID = FID;
+  I.File = PP.getSourceManager().getFileEntryForID(FID);
+  I.Parent = Stack.empty() ? -1 : int(Stack.back());
+  for (unsigned C = 0; C != NumCounters; ++C)
+    I.Costs[C] = 0;
+  InclusionOfFile[FID] = Inclusions.size();
+  Stack.push_back(Inclusions.size());
+  Inclusions.push_back(I);
+}
+
+void HeaderCostTracker::exitedFile() {
+  chargeElapsed();
+  if (!Stack.empty()) {
+    if (!Finished)
+      countTokens(Inclusions[Stack.back()]);
+    Stack.pop_back();
+  }
+}
+
+void HeaderCostTracker::expandedMacro() {
+  if (!Finished && !Stack.empty())
+    ++Inclusions[Stack.back()].Costs[MacroExpansions];
+}
+
+void HeaderCostTracker::deserializedDecl() {
+  if (!Finished && !Stack.empty())
+    ++Inclusions[Stack.back()].Costs[DeserializedDecls];
+}
+
+void HeaderCostTracker::finishedMainFile() {
+  chargeElapsed();
+  for (unsigned I = 0, N = Stack.size(); I != N; ++I)
+    countTokens(Inclusions[Stack[I]]);
+  Finished = true;
+}
+
+void HeaderCostTracker::countDecls(const DeclContext *DC) {
+  // Only look at the declarations of this translation unit, without loading
+  // those of AST files.
+  SourceManager &SM = PP.getSourceManager();
+  for (DeclContext::decl_iterator D = DC->noload_decls_begin(),
+                               DEnd = DC->noload_decls_end();
+       D != DEnd; ++D) {
+    if ((*D)->isFromASTFile())
+      continue;
+    SourceLocation Loc = (*D)->getLocation();
+    if (Loc.isValid()) {
+      llvm::DenseMap<FileID, unsigned>::iterator Known
+        = InclusionOfFile.find(SM.getFileID(SM.getExpansionLoc(Loc)));
+      if (Known != InclusionOfFile.end())
+        ++Inclusions[Known->second].Costs[Decls];
+    }
+    if (const DeclContext *Inner = dyn_cast<DeclContext>(*D))
+      countDecls(Inner);
+  }
+}
+
+const char *HeaderCostTracker::getCounterName(Counter C) {
+  switch (C) {
+  case Tokens:            return "tokens";
+  case MacroExpansions:   return "macro_expansions";
+  case Decls:             return "decls";
+  case DeserializedDecls: return "deserialized_decls";
+  case Time:              return "time";
+  case NumCounters:       break;
+  }
+  llvm_unreachable("invalid counter");
+}
+
+
+namespace {
+/// \brief The costs of all inclusions of one file.
+struct FileCosts {
+  std::string Name;
+  unsigned Includes;
+  uint64_t Exclusive[HeaderCostTracker::NumCounters];
+  uint64_t Inclusive[HeaderCostTracker::NumCounters];
+};
+}
+
+static void printCosts(raw_ostream &OS, const uint64_t *Costs) {
+  OS << '{';
+  for (unsigned C = 0; C != HeaderCostTracker::NumCounters; ++C)
+    OS << (C ? ", \"" : " \"")
+       << HeaderCostTracker::getCounterName(HeaderCostTracker::Counter(C))
+       << "\": " << Costs[C];
+  OS << " }";
+}
+
+void HeaderCostTracker::printJSON(raw_ostream &OS, StringRef File) const {
+  // Inclusions come after the one they are nested in, so one pass from the
+  // end gathers the inclusive costs.
+  std::vector<uint64_t> Inclusive(Inclusions.size() * NumCounters);
+  for (unsigned I = Inclusions.size(); I-- != 0; ) {
+    for (unsigned C = 0; C != NumCounters; ++C) {
+      Inclusive[I * NumCounters + C] += Inclusions[I].Costs[C];
+      if (Inclusions[I].Parent >= 0)
+        Inclusive[Inclusions[I].Parent * NumCounters + C] +=
+          Inclusive[I * NumCounters + C];
+    }
+  }
+
+  // Sum the inclusions of each file, in the order they were first entered.
+  // The inclusive costs of an inclusion nested in another of the same file
+  // are already part of the outer one's.
+  SourceManager &SM = PP.getSourceManager();
+  std::vector<FileCosts> Files;
+  llvm::StringMap<unsigned> FileIndex;
+  for (unsigned I = 0, N = Inclusions.size(); I != N; ++I) {
+    const Inclusion &Inc = Inclusions[I];
+    StringRef Name = Inc.File ? StringRef(Inc.File->getName())
+                              : SM.getBuffer(Inc.FID)->getBufferIdentifier();
+    unsigned Index = FileIndex.GetOrCreateValue(Name, Files.size()).getValue();
+    if (Index == Files.size()) {
+      FileCosts Costs;
+      Costs.Name = Name;
+      Costs.Includes = 0;
+      for (unsigned C = 0; C != NumCounters; ++C)
+        Costs.Exclusive[C] = Costs.Inclusive[C] = 0;
+      Files.push_back(Costs);
+    }
+    FileCosts &Costs = Files[Index];
+    ++Costs.Includes;
+
+    bool Nested = false;
+    for (int P = Inc.Parent; P >= 0 && !Nested; P = Inclusions[P].Parent)
+      Nested = Inclusions[P].File == Inc.File && Inc.File;
+    for (unsigned C = 0; C != NumCounters; ++C) {
+      Costs.Exclusive[C] += Inc.Costs[C];
+      if (!Nested)
+        Costs.Inclusive[C] += Inclusive[I * NumCounters + C];
+    }
+  }
+
+  OS << "{\"file\": ";
+  printJSONString(OS, File);
+  OS << ", \"headers\": [";
+  for (unsigned I = 0, N = Files.size(); I != N; ++I) {
+    OS << (I ? ", " : "") << "{\"name\": ";
+    printJSONString(OS, Files[I].Name);
+    OS << ", \"includes\": " << Files[I].Includes << ", \"exclusive\": ";
+    printCosts(OS, Files[I].Exclusive);
+    OS << ", \"inclusive\": ";
+    printCosts(OS, Files[I].Inclusive);
+    OS << '}';
+  }
+  OS << "]}\n";
+}
@@ -683,5 +683,7 @@ void clang::ApplyHeaderSearchOptions(HeaderSearch &HS,
       HS.getModuleMap().setBuiltinIncludeDir(Dir);
   }
 
+  HS.setCacheSearchDirContents(HSOpts.CacheSearchDirContents);
+
   Init.Realize(Lang);
 }
@@ -0,0 +1,341 @@
+//===--- PreambleCache.cpp - On-disk cache of precompiled preambles -------===//
+//
+//                     The LLVM Compiler Infrastructure
+//
+// This file is distributed under the University of Illinois Open Source
+// License. See LICENSE.TXT for details.
+//
+//===----------------------------------------------------------------------===//
+//
+//  This file implements PreambleCache.
+//
+//===----------------------------------------------------------------------===//
+
+#include "clang/Frontend/PreambleCache.h"
+#include "llvm/ADT/OwningPtr.h"
+#include "llvm/ADT/SmallString.h"
+#include "llvm/ADT/StringExtras.h"
+#include "llvm/Config/llvm-config.h"
+#include "llvm/Support/FileSystem.h"
+#include "llvm/Support/MemoryBuffer.h"
+#include "llvm/Support/MutexGuard.h"
+#include "llvm/Support/Path.h"
+#include "llvm/Support/raw_ostream.h"
+#include "llvm/Support/system_error.h"
+#include <algorithm>
+#include <sys/stat.h>
+#ifdef LLVM_ON_WIN32
+#include <sys/utime.h>
+#else
+#include <utime.h>
+#endif
+
+using namespace clang;
+
+/// \brief The first line of every entry, which also versions the format.
+static const char EntryMagic[] = "CLANG PREAMBLE CACHE 1\n";
+
+/// \brief The first line of every code completion entry.
+static const char CompletionsMagic[] = "CLANG COMPLETION CACHE 1\n";
+
+/// \brief The suffix of entry files in the cache directory.
+static const char EntrySuffix[] = ".preamble";
+
+/// \brief The suffix of code completion entry files in the cache directory.
+static const char CompletionsSuffix[] = ".completions";
+
+PreambleCache::PreambleCache(StringRef Directory, uint64_t MaxSize)
+  : Directory(Directory), MaxSize(MaxSize) {
+  bool Existed;
+  llvm::sys::fs::create_directories(Directory, Existed);
+}
+
+std::string PreambleCache::getEntryPath(StringRef Key,
+                                        const char *Suffix) const {
+  // 64-bit FNV-1a. Collisions only cost a miss, since the entry stores the
+  // complete key.
+  uint64_t Hash = 14695981039346656037ULL;
+  for (unsigned I = 0, N = Key.size(); I != N; ++I) {
+    Hash ^= static_cast<unsigned char>(Key[I]);
+    Hash *= 1099511628211ULL;
+  }
+
+  SmallString<128> Path(Directory);
+  llvm::sys::path::append(Path, llvm::utohexstr(Hash) + Suffix);
+  return Path.str();
+}
+
+namespace {
+/// \brief Reads the fields of an entry in the order they were written.
+class EntryReader {
+  StringRef Data;
+  bool Failed;
+
+public:
+  explicit EntryReader(StringRef Data) : Data(Data), Failed(false) { }
+
+  bool failed() const { return Failed; }
+
+  bool consume(StringRef Expected) {
+    if (!Data.startswith(Expected))
+      return !(Failed = true);
+    Data = Data.substr(Expected.size());
+    return true;
+  }
+
+  /// \brief Read a number terminated by a space or newline.
+  template<typename T>
+  T readNumber() {
+    size_t End = Data.find_first_of(" \n");
+    unsigned long long Value = 0;
+    if (End == StringRef::npos || Data.substr(0, End).getAsInteger(10, Value)) {
+      Failed = true;
+      return T();
+    }
+    Data = Data.substr(End + 1);
+    return static_cast<T>(Value);
+  }
+
+  /// \brief Read a byte string preceded by its length.
+  StringRef readBytes() {
+    size_t Length = readNumber<size_t>();
+    if (Failed || Length > Data.size())
+      return (Failed = true), StringRef();
+    StringRef Result = Data.substr(0, Length);
+    Data = Data.substr(Length);
+    consume("\n");
+    return Result;
+  }
+};
+}
+
+static void writeBytes(raw_ostream &OS, StringRef Bytes) {
+  OS << Bytes.size() << '\n' << Bytes << '\n';
+}
+
+bool PreambleCache::lookup(StringRef Key, StringRef PCHPath, Entry &Result) {
+  std::string EntryPath = getEntryPath(Key, EntrySuffix);
+  OwningPtr<llvm::MemoryBuffer> Buffer;
+  if (llvm::MemoryBuffer::getFile(EntryPath, Buffer))
+    return false;
+
+  EntryReader Reader(Buffer->getBuffer());
+  if (!Reader.consume(EntryMagic) || Reader.readBytes() != Key)
+    return false;
+
+  Entry Data;
+  Data.ReservedSize = Reader.readNumber<unsigned>();
+  Data.NumWarnings = Reader.readNumber<unsigned>();
+  Data.TopLevelHashValue = Reader.readNumber<unsigned>();
+  for (unsigned I = 0, N = Reader.readNumber<unsigned>();
+       I != N && !Reader.failed(); ++I)
+    Data.TopLevelDecls.push_back(Reader.readNumber<uint32_t>());
+  for (unsigned I = 0, N = Reader.readNumber<unsigned>();
+       I != N && !Reader.failed(); ++I) {
+    InputFile File;
+    File.Size = Reader.readNumber<off_t>();
+    File.ModTime = Reader.readNumber<time_t>();
+    File.Name = Reader.readBytes();
+    Data.Files.push_back(File);
+  }
+  StringRef PCH = Reader.readBytes();
+  if (Reader.failed())
+    return false;
+
+  std::string ErrorInfo;
+  {
+    llvm::raw_fd_ostream Out(PCHPath.str().c_str(), ErrorInfo,
+                             llvm::raw_fd_ostream::F_Binary);
+    if (!ErrorInfo.empty())
+      return false;
+    Out << PCH;
+    Out.close();
+    if (Out.has_error()) {
+      Out.clear_error();
+      ErrorInfo = "write error";
+    }
+  }
+  if (!ErrorInfo.empty()) {
+    bool Existed;
+    llvm::sys::fs::remove(PCHPath, Existed);
+    return false;
+  }
+
+  // Mark the entry as recently used.
+  ::utime(EntryPath.c_str(), 0);
+
+  Result = Data;
+  return true;
+}
+
+void PreambleCache::insert(StringRef Key, StringRef PCHPath,
+                           const Entry &Data) {
+  OwningPtr<llvm::MemoryBuffer> PCH;
+  if (llvm::MemoryBuffer::getFile(PCHPath, PCH))
+    return;
+
+  std::string EntryPath = getEntryPath(Key, EntrySuffix);
+  llvm::sys::Path TempPath(EntryPath);
+  TempPath.appendSuffix("tmp");
+  if (TempPath.makeUnique(/*reuse_current=*/false, 0))
+    return;
+
+  std::string ErrorInfo;
+  {
+    llvm::raw_fd_ostream Out(TempPath.c_str(), ErrorInfo,
+                             llvm::raw_fd_ostream::F_Binary);
+    if (!ErrorInfo.empty())
+      return;
+
+    Out << EntryMagic;
+    writeBytes(Out, Key);
+    Out << Data.ReservedSize << ' ' << Data.NumWarnings << ' '
+        << Data.TopLevelHashValue << '\n';
+    Out << Data.TopLevelDecls.size() << '\n';
+    for (unsigned I = 0, N = Data.TopLevelDecls.size(); I != N; ++I)
+      Out << Data.TopLevelDecls[I] << '\n';
+    Out << Data.Files.size() << '\n';
+    for (unsigned I = 0, N = Data.Files.size(); I != N; ++I) {
+      Out << static_cast<unsigned long long>(Data.Files[I].Size) << ' '
+          << static_cast<long long>(Data.Files[I].ModTime) << ' ';
+      writeBytes(Out, Data.Files[I].Name);
+    }
+    writeBytes(Out, PCH->getBuffer());
+    Out.close();
+    if (Out.has_error()) {
+      Out.clear_error();
+      ErrorInfo = "write error";
+    }
+  }
+
+  bool Existed;
+  if (!ErrorInfo.empty() || llvm::sys::fs::rename(TempPath.str(), EntryPath)) {
+    llvm::sys::fs::remove(TempPath.str(), Existed);
+    return;
+  }
+
+  evict();
+}
+
+bool PreambleCache::lookupCompletions(StringRef Key, std::string &Data) {
+  std::string EntryPath = getEntryPath(Key, CompletionsSuffix);
+  OwningPtr<llvm::MemoryBuffer> Buffer;
+  if (llvm::MemoryBuffer::getFile(EntryPath, Buffer))
+    return false;
+
+  EntryReader Reader(Buffer->getBuffer());
+  if (!Reader.consume(CompletionsMagic) || Reader.readBytes() != Key)
+    return false;
+  StringRef Completions = Reader.readBytes();
+  if (Reader.failed())
+    return false;
+
+  // Mark the entry as recently used.
+  ::utime(EntryPath.c_str(), 0);
+
+  Data = Completions;
+  return true;
+}
+
+void PreambleCache::insertCompletions(StringRef Key, StringRef Data) {
+  std::string EntryPath = getEntryPath(Key, CompletionsSuffix);
+  llvm::sys::Path TempPath(EntryPath);
+  TempPath.appendSuffix("tmp");
+  if (TempPath.makeUnique(/*reuse_current=*/false, 0))
+    return;
+
+  std::string ErrorInfo;
+  {
+    llvm::raw_fd_ostream Out(TempPath.c_str(), ErrorInfo,
+                             llvm::raw_fd_ostream::F_Binary);
+    if (!ErrorInfo.empty())
+      return;
+
+    Out << CompletionsMagic;
+    writeBytes(Out, Key);
+    writeBytes(Out, Data);
+    Out.close();
+    if (Out.has_error()) {
+      Out.clear_error();
+      ErrorInfo = "write error";
+    }
+  }
+
+  bool Existed;
+  if (!ErrorInfo.empty() || llvm::sys::fs::rename(TempPath.str(), EntryPath)) {
+    llvm::sys::fs::remove(TempPath.str(), Existed);
+    return;
+  }
+
+  evict();
+}
+
+namespace {
+struct CachedEntryFile {
+  std::string Path;
+  uint64_t Size;
+  time_t LastUse;
+
+  bool operator<(const CachedEntryFile &Other) const {
+    return LastUse < Other.LastUse;
+  }
+};
+}
+
+void PreambleCache::evict() {
+  llvm::MutexGuard Guard(EvictionLock);
+
+  std::vector<CachedEntryFile> Entries;
+  uint64_t TotalSize = 0;
+  llvm::error_code EC;
+  for (llvm::sys::fs::directory_iterator File(Directory, EC), End;
+       File != End && !EC; File.increment(EC)) {
+    StringRef Path = File->path();
+    if (!Path.endswith(EntrySuffix) && !Path.endswith(CompletionsSuffix))
+      continue;
+
+    struct stat StatBuf;
+    if (::stat(File->path().c_str(), &StatBuf))
+      continue;
+
+    CachedEntryFile Entry;
+    Entry.Path = Path;
+    Entry.Size = StatBuf.st_size;
+    Entry.LastUse = StatBuf.st_mtime;
+    Entries.push_back(Entry);
+    TotalSize += Entry.Size;
+  }
+
+  if (TotalSize <= MaxSize)
+    return;
+
+  // Remove the least recently used entries first. Another process may be
+  // doing the same; failing to remove an entry is harmless.
+  std::sort(Entries.begin(), Entries.end());
+  for (unsigned I = 0, N = Entries.size(); I != N && TotalSize > MaxSize;
+       ++I) {
+    bool Existed;
+    llvm::sys::fs::remove(Entries[I].Path, Existed);
+    TotalSize -= Entries[I].Size;
+  }
+}
+
+static llvm::sys::Mutex &getSharedCacheMutex() {
+  static llvm::sys::Mutex M;
+  return M;
+}
+
+static IntrusiveRefCntPtr<PreambleCache> &getSharedCacheStorage() {
+  static IntrusiveRefCntPtr<PreambleCache> SharedCache;
+  return SharedCache;
+}
+
+PreambleCache *PreambleCache::getShared() {
+  llvm::MutexGuard Guard(getSharedCacheMutex());
+  return getSharedCacheStorage().getPtr();
+}
+
+void PreambleCache::setShared(PreambleCache *Cache) {
+  llvm::MutexGuard Guard(getSharedCacheMutex());
+  getSharedCacheStorage() = Cache;
+}
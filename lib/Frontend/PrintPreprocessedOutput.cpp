@@ -28,6 +28,7 @@
 #include "llvm/Support/ErrorHandling.h"
 #include <cctype>
 #include <cstdio>
+#include <cstring>
 using namespace clang;
 
 /// PrintMacroDefinition - Print a macro definition in a form that will be
@@ -406,6 +407,8 @@ PragmaDiagnostic(SourceLocation Loc, StringRef Namespace,
   case diag::MAP_FATAL:
     OS << "fatal";
     break;
+  case diag::MAP_REMARK:
+    llvm_unreachable("remarks cannot be mapped by pragmas");
   }
   OS << " \"" << Str << '"';
   setEmittedDirectiveOnThisLine();
@@ -436,8 +439,8 @@ bool PrintPPOutputPPCallbacks::HandleFirstTokOnLine(Token &Tok) {
     OS << ' ';
 
   // Otherwise, indent the appropriate number of spaces.
-  for (; ColNo > 1; --ColNo)
-    OS << ' ';
+  if (ColNo > 1)
+    OS.indent(ColNo - 1);
 
   return true;
 }
@@ -493,6 +496,19 @@ struct UnknownPragmaHandler : public PragmaHandler {
 } // end anonymous namespace
 
 
+/// getSimpleSpelling - If \p Tok is a punctuator spelled the way its kind is,
+/// return that spelling, so that it need not be read from the source.
+/// Digraphs, and tokens containing trigraphs or escaped newlines, are spelled
+/// with more characters.
+static const char *getSimpleSpelling(const Token &Tok) {
+  if (Tok.needsCleaning())
+    return 0;
+  const char *Spelling = tok::getTokenSimpleSpelling(Tok.getKind());
+  if (!Spelling || strlen(Spelling) != Tok.getLength())
+    return 0;
+  return Spelling;
+}
+
 static void PrintPreprocessedTokens(Preprocessor &PP, Token &Tok,
                                     PrintPPOutputPPCallbacks *Callbacks,
                                     raw_ostream &OS) {
@@ -523,6 +539,8 @@ static void PrintPreprocessedTokens(Preprocessor &PP, Token &Tok,
     } else if (Tok.isLiteral() && !Tok.needsCleaning() &&
                Tok.getLiteralData()) {
       OS.write(Tok.getLiteralData(), Tok.getLength());
+    } else if (const char *Spelling = getSimpleSpelling(Tok)) {
+      OS.write(Spelling, Tok.getLength());
     } else if (Tok.getLength() < 256) {
       const char *TokPtr = Buffer;
       unsigned Len = PP.getSpelling(Tok, TokPtr);
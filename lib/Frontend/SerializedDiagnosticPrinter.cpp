@@ -12,6 +12,7 @@
 #include "llvm/ADT/StringRef.h"
 #include "llvm/ADT/SmallString.h"
 #include "llvm/ADT/DenseSet.h"
+#include "llvm/Support/ErrorHandling.h"
 #include "clang/Basic/SourceManager.h"
 #include "clang/Basic/FileManager.h"
 #include "clang/Basic/Diagnostic.h"
@@ -128,6 +129,12 @@ private:
   /// \brief End a DIAG block.
   void ExitDiagBlock();
 
+  /// \brief Write the serialized content so far to the output stream.
+  ///
+  /// Must only be called outside of all blocks, where no block size is left
+  /// to be filled in.
+  void FlushBuffer();
+
   /// \brief Emit a DIAG record.
   void EmitDiagnosticMessage(SourceLocation Loc,
                              PresumedLoc PLoc,
@@ -174,6 +181,11 @@ private:
   /// \brief The version of the diagnostics file.
   enum { Version = 1 };
 
+  /// \brief The size the buffer may reach before it is written out between
+  /// two diagnostics, so that memory use does not grow with the number of
+  /// diagnostics.
+  enum { FlushThreshold = 64 * 1024 };
+
   const LangOptions *LangOpts;
   const DiagnosticOptions &DiagOpts;
   
@@ -495,8 +507,11 @@ void SDiagsWriter::HandleDiagnostic(DiagnosticsEngine::Level DiagLevel,
   // for beginDiagnostic, in case associated notes are emitted before we get
   // there.
   if (DiagLevel != DiagnosticsEngine::Note) {
-    if (EmittedAnyDiagBlocks)
+    if (EmittedAnyDiagBlocks) {
       ExitDiagBlock();
+      if (Buffer.size() >= FlushThreshold)
+        FlushBuffer();
+    }
 
     EnterDiagBlock();
     EmittedAnyDiagBlocks = true;
@@ -527,6 +542,21 @@ void SDiagsWriter::HandleDiagnostic(DiagnosticsEngine::Level DiagLevel,
                           &Info);
 }
 
+static serialized_diags::Level getStableLevel(DiagnosticsEngine::Level Level) {
+  switch (Level) {
+#define CASE(X) case DiagnosticsEngine::X: return serialized_diags::X;
+  CASE(Ignored)
+  CASE(Note)
+  CASE(Remark)
+  CASE(Warning)
+  CASE(Error)
+  CASE(Fatal)
+#undef CASE
+  }
+
+  llvm_unreachable("invalid diagnostic level");
+}
+
 void SDiagsWriter::EmitDiagnosticMessage(SourceLocation Loc,
                                          PresumedLoc PLoc,
                                          DiagnosticsEngine::Level Level,
@@ -536,7 +566,7 @@ void SDiagsWriter::EmitDiagnosticMessage(SourceLocation Loc,
   // Emit the RECORD_DIAG record.
   Record.clear();
   Record.push_back(RECORD_DIAG);
-  Record.push_back(Level);
+  Record.push_back(getStableLevel(Level));
   AddLocToRecord(Loc, SM, PLoc, Record);
 
   if (const Diagnostic *Info = D.dyn_cast<const Diagnostic*>()) {
@@ -573,6 +603,11 @@ void SDiagsWriter::ExitDiagBlock() {
   Stream.ExitBlock();
 }
 
+void SDiagsWriter::FlushBuffer() {
+  OS->write(Buffer.data(), Buffer.size());
+  Buffer.clear();
+}
+
 void SDiagsRenderer::beginDiagnostic(DiagOrStoredDiag D,
                                      DiagnosticsEngine::Level Level) {
   if (Level == DiagnosticsEngine::Note)
@@ -633,8 +668,8 @@ void SDiagsWriter::finish() {
   if (EmittedAnyDiagBlocks)
     ExitDiagBlock();
 
-  // Write the generated bitstream to "Out".
-  OS->write((char *)&Buffer.front(), Buffer.size());
+  // Write the rest of the generated bitstream to "Out".
+  FlushBuffer();
   OS->flush();
 
   OS.reset(0);
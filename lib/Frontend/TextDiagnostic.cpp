@@ -26,6 +26,8 @@ using namespace clang;
 
 static const enum raw_ostream::Colors noteColor =
   raw_ostream::BLACK;
+static const enum raw_ostream::Colors remarkColor =
+  raw_ostream::BLUE;
 static const enum raw_ostream::Colors fixitColor =
   raw_ostream::GREEN;
 static const enum raw_ostream::Colors caretColor =
@@ -61,6 +63,9 @@ static void applyTemplateHighlighting(raw_ostream &OS, StringRef Str,
 /// \brief Number of spaces to indent when word-wrapping.
 const unsigned WordWrapIndentation = 6;
 
+/// \brief Number of bytes of a source line to show at most around the caret.
+const unsigned MaxSnippetLength = 4096;
+
 static int bytesSincePreviousTabOrLineBegin(StringRef SourceLine, size_t i) {
   int bytes = 0;
   while (0<i) {
@@ -259,8 +264,9 @@ static void columnToByte(StringRef SourceLine, unsigned TabStop,
 }
 
 struct SourceColumnMap {
-  SourceColumnMap(StringRef SourceLine, unsigned TabStop)
-  : m_SourceLine(SourceLine) {
+  SourceColumnMap(StringRef SourceLine, unsigned TabStop,
+                  unsigned LineOffset = 0)
+  : m_SourceLine(SourceLine), m_LineOffset(LineOffset) {
     
     ::byteToColumn(SourceLine, TabStop, m_byteToColumn);
     ::columnToByte(SourceLine, TabStop, m_columnToByte);
@@ -285,9 +291,24 @@ struct SourceColumnMap {
   StringRef getSourceLine() const {
     return m_SourceLine;
   }
+  /// \brief The byte of the source line shown for byte \p n of the line in
+  /// the file, clamped to the part that is shown.
+  unsigned lineByteToByte(unsigned n) const {
+    if (n < m_LineOffset)
+      return 0;
+    return std::min<unsigned>(n - m_LineOffset, m_SourceLine.size());
+  }
+  /// \brief Whether byte \p n of the line in the file is in the part shown,
+  /// or right at its end.
+  bool isLineByteShown(unsigned n) const {
+    return n >= m_LineOffset && n - m_LineOffset <= m_SourceLine.size();
+  }
   
 private:
   const std::string m_SourceLine;
+  /// \brief Byte n of the source line shown is byte n + m_LineOffset of the
+  /// line in the file; only part of an overly long line is shown.
+  unsigned m_LineOffset;
   SmallVector<int,200> m_byteToColumn;
   SmallVector<int,200> m_columnToByte;
 };
@@ -689,6 +710,7 @@ TextDiagnostic::printDiagnosticLevel(raw_ostream &OS,
     case DiagnosticsEngine::Ignored:
       llvm_unreachable("Invalid diagnostic type");
     case DiagnosticsEngine::Note:    OS.changeColor(noteColor, true); break;
+    case DiagnosticsEngine::Remark:  OS.changeColor(remarkColor, true); break;
     case DiagnosticsEngine::Warning: OS.changeColor(warningColor, true); break;
     case DiagnosticsEngine::Error:   OS.changeColor(errorColor, true); break;
     case DiagnosticsEngine::Fatal:   OS.changeColor(fatalColor, true); break;
@@ -699,6 +721,7 @@ TextDiagnostic::printDiagnosticLevel(raw_ostream &OS,
   case DiagnosticsEngine::Ignored:
     llvm_unreachable("Invalid diagnostic type");
   case DiagnosticsEngine::Note:    OS << "note: "; break;
+  case DiagnosticsEngine::Remark:  OS << "remark: "; break;
   case DiagnosticsEngine::Warning: OS << "warning: "; break;
   case DiagnosticsEngine::Error:   OS << "error: "; break;
   case DiagnosticsEngine::Fatal:   OS << "fatal error: "; break;
@@ -899,9 +922,10 @@ void TextDiagnostic::emitSnippetAndCaret(
 
   // Get information about the buffer it points into.
   bool Invalid = false;
-  const char *BufStart = SM.getBufferData(FID, &Invalid).data();
+  StringRef BufData = SM.getBufferData(FID, &Invalid);
   if (Invalid)
     return;
+  const char *BufStart = BufData.data();
 
   unsigned LineNo = SM.getLineNumber(FID, FileOffset);
   unsigned ColNo = SM.getColumnNumber(FID, FileOffset);
@@ -910,21 +934,52 @@ void TextDiagnostic::emitSnippetAndCaret(
   const char *TokPtr = BufStart+FileOffset;
   const char *LineStart = TokPtr-ColNo+1; // Column # is 1-based.
 
-
   // Compute the line end.  Scan forward from the error position to the end of
-  // the line.
+  // the line, or as far as the part of an overly long line that we show.
+  unsigned ScanLength = std::max(ColNo - 1 + MaxSnippetLength / 2,
+                                 MaxSnippetLength) + 1;
+  const char *ScanEnd = BufData.end();
+  if (unsigned(ScanEnd - LineStart) > ScanLength)
+    ScanEnd = LineStart + ScanLength;
   const char *LineEnd = TokPtr;
-  while (*LineEnd != '\n' && *LineEnd != '\r' && *LineEnd != '\0')
+  while (LineEnd != ScanEnd &&
+         *LineEnd != '\n' && *LineEnd != '\r' && *LineEnd != '\0')
     ++LineEnd;
 
+  // Of a line longer than MaxSnippetLength, as in minified or generated code,
+  // only show the part around the caret, so that the work below does not
+  // grow with the length of the line. Cut it at character boundaries, and
+  // mark the cuts with ellipses.
+  const char *ShownStart = LineStart, *ShownEnd = LineEnd;
+  if (unsigned(LineEnd - LineStart) > MaxSnippetLength) {
+    if (unsigned(TokPtr - LineStart) > MaxSnippetLength / 2)
+      ShownStart = TokPtr - MaxSnippetLength / 2;
+    while (ShownStart != TokPtr && (*ShownStart & 0xC0) == 0x80)
+      ++ShownStart;
+    if (unsigned(LineEnd - ShownStart) > MaxSnippetLength)
+      ShownEnd = ShownStart + MaxSnippetLength;
+    while (ShownEnd > TokPtr && ShownEnd != LineEnd &&
+           (*ShownEnd & 0xC0) == 0x80)
+      --ShownEnd;
+  }
+
   // Copy the line of code into an std::string for ease of manipulation.
-  std::string SourceLine(LineStart, LineEnd);
+  static const char Ellipsis[] = "...";
+  unsigned LineOffset = ShownStart - LineStart;
+  std::string SourceLine;
+  if (ShownStart != LineStart) {
+    SourceLine = Ellipsis;
+    LineOffset -= SourceLine.size();
+  }
+  SourceLine.append(ShownStart, ShownEnd);
+  if (ShownEnd != LineEnd)
+    SourceLine += Ellipsis;
 
   // Create a line for the caret that is filled with spaces that is the same
   // length as the line of source code.
-  std::string CaretLine(LineEnd-LineStart, ' ');
+  std::string CaretLine(SourceLine.size(), ' ');
 
-  const SourceColumnMap sourceColMap(SourceLine, DiagOpts.TabStop);
+  const SourceColumnMap sourceColMap(SourceLine, DiagOpts.TabStop, LineOffset);
 
   // Highlight all of the characters covered by Ranges with ~ characters.
   for (SmallVectorImpl<CharSourceRange>::iterator I = Ranges.begin(),
@@ -933,7 +988,7 @@ void TextDiagnostic::emitSnippetAndCaret(
     highlightRange(*I, LineNo, FID, sourceColMap, CaretLine, SM);
 
   // Next, insert the caret itself.
-  ColNo = sourceColMap.byteToColumn(ColNo-1);
+  ColNo = sourceColMap.byteToColumn(sourceColMap.lineByteToByte(ColNo-1));
   if (CaretLine.size()<ColNo+1)
     CaretLine.resize(ColNo+1, ' ');
   CaretLine[ColNo] = '^';
@@ -1054,6 +1109,7 @@ void TextDiagnostic::highlightRange(const CharSourceRange &R,
   if (StartLineNo == LineNo) {
     StartColNo = SM.getExpansionColumnNumber(Begin);
     if (StartColNo) --StartColNo;  // Zero base the col #.
+    StartColNo = map.lineByteToByte(StartColNo);
   }
 
   // Compute the column number of the end.
@@ -1067,6 +1123,7 @@ void TextDiagnostic::highlightRange(const CharSourceRange &R,
       // this is a token range.
       if (R.isTokenRange())
         EndColNo += Lexer::MeasureTokenLength(End, SM, LangOpts);
+      EndColNo = map.lineByteToByte(EndColNo);
     } else {
       EndColNo = CaretLine.size();
     }
@@ -1085,7 +1142,7 @@ void TextDiagnostic::highlightRange(const CharSourceRange &R,
     // Pick the last non-whitespace column.
     if (EndColNo > map.getSourceLine().size())
       EndColNo = map.getSourceLine().size();
-    while (EndColNo-1 &&
+    while (EndColNo > 1 &&
            (map.getSourceLine()[EndColNo-1] == ' ' ||
             map.getSourceLine()[EndColNo-1] == '\t'))
       --EndColNo;
@@ -1137,6 +1194,13 @@ std::string TextDiagnostic::buildFixItInsertionLine(
         unsigned HintByteOffset
           = SM.getColumnNumber(HintLocInfo.first, HintLocInfo.second) - 1;
 
+        // The hint may be outside the part of an overly long line we show.
+        if (!map.isLineByteShown(HintByteOffset)) {
+          FixItInsertionLine.clear();
+          break;
+        }
+        HintByteOffset = map.lineByteToByte(HintByteOffset);
+
         // The hint must start inside the source or right at the end
         assert(HintByteOffset < static_cast<unsigned>(map.bytes())+1);
         unsigned HintCol = map.byteToColumn(HintByteOffset);
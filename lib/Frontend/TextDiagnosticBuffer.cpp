@@ -29,7 +29,10 @@ void TextDiagnosticBuffer::HandleDiagnostic(DiagnosticsEngine::Level Level,
   switch (Level) {
   default: llvm_unreachable(
                          "Diagnostic not handled during diagnostic buffering!");
+  // Remarks only come from the optimizers, which never run while diagnostics
+  // are buffered; keep them with the notes.
   case DiagnosticsEngine::Note:
+  case DiagnosticsEngine::Remark:
     Notes.push_back(std::make_pair(Info.getLocation(), Buf.str()));
     break;
   case DiagnosticsEngine::Warning:
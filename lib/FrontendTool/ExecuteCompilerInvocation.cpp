@@ -84,6 +84,7 @@ static FrontendAction *CreateFrontendBaseAction(CompilerInstance &CI) {
   case RunAnalysis:            return new ento::AnalysisAction();
   case MigrateSource:          return new arcmt::MigrateSourceAction();
   case RunPreprocessorOnly:    return new PreprocessOnlyAction();
+  case ScanDependencies:       return new ScanDependenciesAction();
   }
   llvm_unreachable("Invalid program action!");
 }
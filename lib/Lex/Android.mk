@@ -11,10 +11,12 @@ TBLGEN_TABLES := \
   AttrSpellings.inc
 
 clang_lex_SRC_FILES := \
+  FileTokenCache.cpp \
   HeaderMap.cpp \
   HeaderSearch.cpp \
   Lexer.cpp \
   LiteralSupport.cpp \
+  MacroArgExpansionCache.cpp \
   MacroArgs.cpp \
   MacroInfo.cpp \
   ModuleMap.cpp \
@@ -0,0 +1,195 @@
+//===--- FileTokenCache.cpp - Cached tokens of repeatedly lexed files -----===//
+//
+//                     The LLVM Compiler Infrastructure
+//
+// This file is distributed under the University of Illinois Open Source
+// License. See LICENSE.TXT for details.
+//
+//===----------------------------------------------------------------------===//
+//
+//  This file implements the FileTokenCache interface.
+//
+//===----------------------------------------------------------------------===//
+
+#include "clang/Lex/FileTokenCache.h"
+#include "clang/Lex/Lexer.h"
+#include "llvm/ADT/StringRef.h"
+#include <algorithm>
+#include <cstring>
+using namespace clang;
+
+/// containsTrigraphStart - Return true if [Ptr, End] contains "??".  Trigraphs
+/// are diagnosed in normal mode even when they are not enabled.
+static bool containsTrigraphStart(const char *Ptr, const char *End) {
+  for (; Ptr != End; ++Ptr)
+    if (Ptr[0] == '?' && Ptr[1] == '?')
+      return true;
+  return false;
+}
+
+/// isCacheableGap - Return true if [Ptr, End) only contains whitespace and
+/// comments that the lexer skips without diagnostics or escaped newlines.
+/// Sets \p HasComment if it contains a comment.
+static bool isCacheableGap(const char *Ptr, const char *End,
+                           const LangOptions &LangOpts, bool &HasComment) {
+  HasComment = false;
+  while (Ptr != End) {
+    switch (*Ptr) {
+    case ' ': case '\t': case '\f': case '\v': case '\n': case '\r':
+      ++Ptr;
+      continue;
+    case '/':
+      break;
+    default:
+      return false;
+    }
+
+    if (End - Ptr < 2)
+      return false;
+    const char *BodyStart = Ptr + 2;
+    if (Ptr[1] == '/' && LangOpts.BCPLComment) {
+      Ptr = BodyStart;
+      while (Ptr != End && *Ptr != '\n' && *Ptr != '\r')
+        ++Ptr;
+    } else if (Ptr[1] == '*') {
+      StringRef Rest(BodyStart, End - BodyStart);
+      size_t CommentEnd = Rest.find("*/");
+      // A nested "/*" is diagnosed.
+      if (CommentEnd == StringRef::npos ||
+          Rest.substr(0, CommentEnd).find("/*") != StringRef::npos)
+        return false;
+      Ptr = BodyStart + CommentEnd + 2;
+    } else {
+      return false;
+    }
+
+    StringRef Body(BodyStart, Ptr - BodyStart);
+    if (Body.find('\\') != StringRef::npos ||
+        Body.find('\0') != StringRef::npos ||
+        containsTrigraphStart(BodyStart, Ptr))
+      return false;
+    HasComment = true;
+  }
+  return true;
+}
+
+/// isCacheableToken - Return true if normal lexing produces \p Tok, spelled
+/// [TokStart, TokEnd), exactly like raw lexing does, without diagnostics.
+static bool isCacheableToken(const Token &Tok, const char *TokStart,
+                             const char *TokEnd, const LangOptions &LangOpts) {
+  if (Tok.needsCleaning() || containsTrigraphStart(TokStart, TokEnd))
+    return false;
+
+  switch (Tok.getKind()) {
+  case tok::unknown:
+  case tok::eof:
+  case tok::eod:
+  case tok::comment:
+  case tok::code_completion:
+  // Directives must be seen by the lexer itself.
+  case tok::hash:
+  case tok::hashhash:
+  case tok::hashat:
+    return false;
+
+  case tok::raw_identifier:
+    // '$' in identifiers is diagnosed.
+    return !memchr(TokStart, '$', TokEnd - TokStart);
+
+  case tok::string_literal:
+  case tok::wide_string_literal:
+  case tok::char_constant:
+  case tok::wide_char_constant: {
+    // Raw strings and user-defined literals have compatibility warnings, so
+    // only record plain literals.
+    const char *Quote = TokStart;
+    if (*Quote == 'L')
+      ++Quote;
+    return (*Quote == '"' || *Quote == '\'') && TokEnd[-1] == *Quote &&
+           TokEnd - Quote >= 2 &&
+           !Lexer::isIdentifierBodyChar(*TokEnd, LangOpts) &&
+           !memchr(TokStart, '\0', TokEnd - TokStart);
+  }
+
+  case tok::utf8_string_literal:
+  case tok::utf16_string_literal:
+  case tok::utf32_string_literal:
+  case tok::utf16_char_constant:
+  case tok::utf32_char_constant:
+    return false;
+
+  case tok::less:
+    // '<::' is diagnosed in C++11.
+    return *TokEnd != ':';
+
+  default:
+    return true;
+  }
+}
+
+FileTokenCache *FileTokenCache::Create(SourceLocation FileLoc,
+                                       const LangOptions &LangOpts,
+                                       const char *BufStart,
+                                       const char *BufEnd) {
+  FileTokenCache *Cache = new FileTokenCache();
+  Lexer RawLex(FileLoc, LangOpts, BufStart, BufStart, BufEnd);
+
+  const char *LexStart = RawLex.getBufferLocation();
+  Token Tok;
+  while (true) {
+    RawLex.LexFromRawLexer(Tok);
+    if (Tok.is(tok::eof))
+      break;
+
+    const char *TokEnd = RawLex.getBufferLocation();
+    const char *TokStart = TokEnd - Tok.getLength();
+
+    // Conflict markers are only recognized when not lexing raw.
+    if (Tok.isAtStartOfLine()) {
+      StringRef Line(TokStart, BufEnd - TokStart);
+      if (Line.startswith("<<<<<<<") || Line.startswith(">>>> ")) {
+        delete Cache;
+        return 0;
+      }
+    }
+
+    bool HasComment;
+    if (isCacheableToken(Tok, TokStart, TokEnd, LangOpts) &&
+        isCacheableGap(LexStart, TokStart, LangOpts, HasComment)) {
+      Entry E;
+      E.LexStart = LexStart - BufStart;
+      E.Offset = TokStart - BufStart;
+      E.Length = Tok.getLength();
+      E.Kind = Tok.getKind();
+      E.Flags = Tok.getFlags() & (Token::StartOfLine | Token::LeadingSpace);
+      E.HasComment = HasComment;
+      Cache->Entries.push_back(E);
+    }
+
+    LexStart = TokEnd;
+  }
+
+  return Cache;
+}
+
+namespace {
+struct EntryLexStartLess {
+  bool operator()(const FileTokenCache::Entry &E, unsigned LexStart) const {
+    return E.LexStart < LexStart;
+  }
+};
+}
+
+const FileTokenCache::Entry *FileTokenCache::find(unsigned LexStart,
+                                                  unsigned &Hint) const {
+  if (Hint < Entries.size() && Entries[Hint].LexStart == LexStart)
+    return &Entries[Hint++];
+
+  std::vector<Entry>::const_iterator I
+    = std::lower_bound(Entries.begin(), Entries.end(), LexStart,
+                       EntryLexStartLess());
+  if (I == Entries.end() || I->LexStart != LexStart)
+    return 0;
+  Hint = I - Entries.begin() + 1;
+  return &*I;
+}
@@ -209,8 +209,11 @@ const FileEntry *HeaderMap::LookupFile(
   if (NumBuckets & (NumBuckets-1))
     return 0;
 
-  // Linearly probe the hash table.
-  for (unsigned Bucket = HashHMapKey(Filename);; ++Bucket) {
+  // Linearly probe the hash table.  Give up after visiting every bucket, in
+  // case the headermap is corrupt and has no empty bucket.
+  unsigned FirstBucket = HashHMapKey(Filename);
+  for (unsigned Bucket = FirstBucket; Bucket - FirstBucket != NumBuckets;
+       ++Bucket) {
     HMapBucket B = getBucket(Bucket & (NumBuckets-1));
     if (B.Key == HMAP_EmptyBucketKey) return 0; // Hash miss.
 
@@ -225,4 +228,5 @@ const FileEntry *HeaderMap::LookupFile(
     DestPath += getString(B.Suffix);
     return FM.getFile(DestPath.str());
   }
+  return 0;
 }
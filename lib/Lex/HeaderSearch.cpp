@@ -47,12 +47,14 @@ HeaderSearch::HeaderSearch(FileManager &FM, DiagnosticsEngine &Diags,
   AngledDirIdx = 0;
   SystemDirIdx = 0;
   NoCurDirSearch = false;
+  CacheSearchDirContents = false;
 
   ExternalLookup = 0;
   ExternalSource = 0;
   NumIncluded = 0;
   NumMultiIncludeFileOptzn = 0;
   NumFrameworkLookups = NumSubFrameworkLookups = 0;
+  NumIndexedDirLookups = NumIndexedDirMisses = 0;
 }
 
 HeaderSearch::~HeaderSearch() {
@@ -81,6 +83,10 @@ void HeaderSearch::PrintStats() {
 
   fprintf(stderr, "%d framework lookups.\n", NumFrameworkLookups);
   fprintf(stderr, "%d subframework lookups.\n", NumSubFrameworkLookups);
+  if (CacheSearchDirContents)
+    fprintf(stderr, "%d search directory lookups, %d answered from the "
+            "directory contents cache.\n", NumIndexedDirLookups,
+            NumIndexedDirMisses);
 }
 
 /// CreateHeaderMap - This method returns a HeaderMap for the specified
@@ -210,6 +216,10 @@ const FileEntry *DirectoryLookup::LookupFile(
 
   SmallString<1024> TmpDir;
   if (isNormalDir()) {
+    // Don't bother stat'ing a file whose name isn't in the directory.
+    if (!HS.directoryMayContain(getDir(), Filename))
+      return 0;
+
     // Concatenate the requested file onto the directory.
     TmpDir = getDir()->getName();
     llvm::sys::path::append(TmpDir, Filename);
@@ -798,7 +808,61 @@ size_t HeaderSearch::getTotalMemory() const {
     + llvm::capacity_in_bytes(FileInfo)
     + llvm::capacity_in_bytes(HeaderMaps)
     + LookupFileCache.getAllocator().getTotalMemory()
-    + FrameworkMap.getAllocator().getTotalMemory();
+    + FrameworkMap.getAllocator().getTotalMemory()
+    + IndexedDirContents.getAllocator().getTotalMemory();
+}
+
+/// getIndexedDirKey - Return the key of the entry \p Name of \p Dir in
+/// IndexedDirContents.  Names are lowercased so that the cache never misses
+/// a file on a case-insensitive file system.
+static std::string getIndexedDirKey(const DirectoryEntry *Dir,
+                                    StringRef Name) {
+  std::string Key(reinterpret_cast<const char *>(&Dir), sizeof(Dir));
+  Key += Name.lower();
+  return Key;
+}
+
+bool HeaderSearch::indexDirectory(const DirectoryEntry *Dir) {
+  SmallString<128> DirName(Dir->getName());
+  FileMgr.FixupRelativePath(DirName);
+  SmallString<128> DirNative;
+  llvm::sys::path::native(DirName.str(), DirNative);
+
+  llvm::error_code EC;
+  llvm::sys::fs::directory_iterator Entry(DirNative.str(), EC), End;
+  for (; Entry != End && !EC; Entry.increment(EC))
+    IndexedDirContents.insert(
+      getIndexedDirKey(Dir, llvm::sys::path::filename(Entry->path())));
+  return !EC;
+}
+
+bool HeaderSearch::directoryMayContain(const DirectoryEntry *Dir,
+                                       StringRef Filename) {
+  if (!CacheSearchDirContents)
+    return true;
+
+  // Only the first component is looked up; a subdirectory is read by the file
+  // manager anyway once it is known to exist.
+  if (llvm::sys::path::is_absolute(Filename))
+    return true;
+  StringRef Name = *llvm::sys::path::begin(Filename);
+  if (Name.empty() || Name == "." || Name == "..")
+    return true;
+
+  std::pair<llvm::DenseMap<const DirectoryEntry *, bool>::iterator, bool>
+    Known = IndexedDirs.insert(std::make_pair(Dir, false));
+  if (Known.second)
+    Known.first->second = indexDirectory(Dir);
+  if (!Known.first->second)
+    return true;
+
+  ++NumIndexedDirLookups;
+  // Virtual files don't show up when reading the directory.
+  if (IndexedDirContents.count(getIndexedDirKey(Dir, Name)) ||
+      FileMgr.hasVirtualFiles())
+    return true;
+  ++NumIndexedDirMisses;
+  return false;
 }
 
 StringRef HeaderSearch::getUniqueFrameworkName(StringRef Framework) {
@@ -820,6 +884,11 @@ bool HeaderSearch::hasModuleMap(StringRef FileName,
     const DirectoryEntry *Dir = FileMgr.getDirectory(DirName);
     if (!Dir)
       return false;
+
+    // If we already walked from here up to the root without finding a module
+    // map, don't do it again.
+    if (DirectoryLacksModuleMap.lookup(Dir) == Root)
+      return false;
     
     // Try to load the module map file in this directory.
     switch (loadModuleMapFile(Dir)) {
@@ -837,9 +906,14 @@ bool HeaderSearch::hasModuleMap(StringRef FileName,
       break;
     }
 
-    // If we hit the top of our search, we're done.
-    if (Dir == Root)
+    // If we hit the top of our search, we're done.  Remember that none of
+    // the directories we stepped through has a module map up to the root.
+    if (Dir == Root) {
+      DirectoryLacksModuleMap[Dir] = Root;
+      for (unsigned I = 0, N = FixUpDirectories.size(); I != N; ++I)
+        DirectoryLacksModuleMap[FixUpDirectories[I]] = Root;
       return false;
+    }
         
     // Keep track of all of the directories we checked, so we can mark them as
     // having module maps if we eventually do find a module map.
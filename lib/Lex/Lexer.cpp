@@ -28,12 +28,24 @@
 #include "clang/Lex/Preprocessor.h"
 #include "clang/Lex/LexDiagnostic.h"
 #include "clang/Lex/CodeCompletionHandler.h"
+#include "clang/Lex/FileTokenCache.h"
 #include "clang/Basic/SourceManager.h"
 #include "llvm/ADT/StringSwitch.h"
 #include "llvm/ADT/STLExtras.h"
 #include "llvm/Support/Compiler.h"
 #include "llvm/Support/MemoryBuffer.h"
 #include <cstring>
+#ifdef __SSE2__
+#include <emmintrin.h>
+#elif __ALTIVEC__
+#include <altivec.h>
+#undef bool
+#endif
+#if (defined(__ARM_NEON__) || defined(__ARM_NEON)) && \
+    !defined(__ARMEB__) && !defined(__AARCH64EB__)
+#include <arm_neon.h>
+#define LEXER_USE_NEON 1
+#endif
 using namespace clang;
 
 static void InitCharacterInfo();
@@ -90,6 +102,8 @@ void Lexer::InitLexer(const char *BufStart, const char *BufPtr,
 
   Is_PragmaLexer = false;
   CurrentConflictMarkerState = CMK_None;
+  TokenCache = 0;
+  TokenCacheHint = 0;
 
   // Start of the file is a start of line.
   IsAtStartOfLine = true;
@@ -1120,6 +1134,226 @@ static inline bool isRawStringDelimBody(unsigned char c) {
     true : false;
 }
 
+//===----------------------------------------------------------------------===//
+// Block scanning
+//===----------------------------------------------------------------------===//
+//
+// The functions below skip the leading part of a run of characters of one
+// class 16 bytes at a time.  They only ever look at whole blocks that end at or
+// before the end of the buffer, and leave the remainder of the run to the
+// scalar loops of their callers, which therefore stay correct (if slower) when
+// no vector unit is available.
+
+#if defined(__SSE2__) || defined(LEXER_USE_NEON)
+#define LEXER_USE_CHAR_BLOCKS 1
+
+#ifdef __SSE2__
+/// CharBlock - 16 characters, or a byte mask with one lane per character.
+typedef __m128i CharBlock;
+
+static inline CharBlock loadCharBlock(const char *Ptr) {
+  return _mm_loadu_si128((const __m128i*)Ptr);
+}
+
+static inline CharBlock matchChar(CharBlock Chars, char C) {
+  return _mm_cmpeq_epi8(Chars, _mm_set1_epi8(C));
+}
+
+/// matchRange - Match characters in [Lo, Hi].  Both bounds must be ASCII, so
+/// the signed comparisons never match bytes with the high bit set.
+static inline CharBlock matchRange(CharBlock Chars, char Lo, char Hi) {
+  return _mm_and_si128(_mm_cmpgt_epi8(Chars, _mm_set1_epi8(Lo - 1)),
+                       _mm_cmplt_epi8(Chars, _mm_set1_epi8(Hi + 1)));
+}
+
+static inline CharBlock orMatches(CharBlock LHS, CharBlock RHS) {
+  return _mm_or_si128(LHS, RHS);
+}
+
+static inline CharBlock notMatches(CharBlock Mask) {
+  return _mm_xor_si128(Mask, _mm_set1_epi8(-1));
+}
+
+/// countLeadingMatches - Return the number of leading lanes set in \p Mask.
+static inline unsigned countLeadingMatches(CharBlock Mask) {
+  unsigned Bits = _mm_movemask_epi8(Mask);
+  return llvm::CountTrailingZeros_32(~Bits);
+}
+#else
+typedef uint8x16_t CharBlock;
+
+static inline CharBlock loadCharBlock(const char *Ptr) {
+  return vld1q_u8((const uint8_t*)Ptr);
+}
+
+static inline CharBlock matchChar(CharBlock Chars, char C) {
+  return vceqq_u8(Chars, vdupq_n_u8((uint8_t)C));
+}
+
+static inline CharBlock matchRange(CharBlock Chars, char Lo, char Hi) {
+  return vandq_u8(vcgeq_u8(Chars, vdupq_n_u8((uint8_t)Lo)),
+                  vcleq_u8(Chars, vdupq_n_u8((uint8_t)Hi)));
+}
+
+static inline CharBlock orMatches(CharBlock LHS, CharBlock RHS) {
+  return vorrq_u8(LHS, RHS);
+}
+
+static inline CharBlock notMatches(CharBlock Mask) {
+  return vmvnq_u8(Mask);
+}
+
+static inline unsigned countLeadingMatches(CharBlock Mask) {
+  // NEON has no movemask; narrow every lane to a nibble instead.
+  uint8x8_t Nibbles = vshrn_n_u16(vreinterpretq_u16_u8(Mask), 4);
+  uint64_t Bits = vget_lane_u64(vreinterpret_u64_u8(Nibbles), 0);
+  if (Bits == ~0ULL)
+    return 16;
+  return llvm::CountTrailingZeros_64(~Bits) / 4;
+}
+#endif
+
+/// matchIdentifierBody - Match [a-zA-Z0-9_], see isIdentifierBody.
+static inline CharBlock matchIdentifierBody(CharBlock Chars) {
+  return orMatches(orMatches(matchRange(Chars, 'a', 'z'),
+                             matchRange(Chars, 'A', 'Z')),
+                   orMatches(matchRange(Chars, '0', '9'),
+                             matchChar(Chars, '_')));
+}
+
+/// matchNumberBody - Match [a-zA-Z0-9_.], see isNumberBody.
+static inline CharBlock matchNumberBody(CharBlock Chars) {
+  return orMatches(matchIdentifierBody(Chars), matchChar(Chars, '.'));
+}
+
+/// matchHorizontalWhitespace - Match ' ', '\\t', '\\f' and '\\v', see
+/// isHorizontalWhitespace.
+static inline CharBlock matchHorizontalWhitespace(CharBlock Chars) {
+  return orMatches(orMatches(matchChar(Chars, ' '), matchChar(Chars, '\t')),
+                   orMatches(matchChar(Chars, '\f'), matchChar(Chars, '\v')));
+}
+
+/// matchBCPLCommentBody - Match everything but '\\0', '\\n' and '\\r'.
+static inline CharBlock matchBCPLCommentBody(CharBlock Chars) {
+  return notMatches(orMatches(matchChar(Chars, '\0'),
+                              orMatches(matchChar(Chars, '\n'),
+                                        matchChar(Chars, '\r'))));
+}
+
+/// matchBlockCommentBody - Match everything but '\\0' and '/'.
+static inline CharBlock matchBlockCommentBody(CharBlock Chars) {
+  return notMatches(orMatches(matchChar(Chars, '\0'), matchChar(Chars, '/')));
+}
+
+/// matchExcludedLineBody - Match the characters which isExcludedLineBody
+/// accepts.
+static inline CharBlock matchExcludedLineBody(CharBlock Chars) {
+  CharBlock Special =
+    orMatches(orMatches(orMatches(matchChar(Chars, '\0'),
+                                  matchChar(Chars, '\n')),
+                        orMatches(matchChar(Chars, '\r'),
+                                  matchChar(Chars, '/'))),
+              orMatches(orMatches(matchChar(Chars, '"'),
+                                  matchChar(Chars, '\'')),
+                        orMatches(matchChar(Chars, '\\'),
+                                  matchChar(Chars, '?'))));
+  return notMatches(Special);
+}
+
+/// skipCharBlocks - Advance \p Ptr over the characters matched by \p Match,
+/// looking at [Ptr, End) in blocks of 16.
+template <CharBlock (*Match)(CharBlock)>
+static inline const char *skipCharBlocks(const char *Ptr, const char *End) {
+  while (Ptr + 16 <= End) {
+    unsigned NumMatched = countLeadingMatches(Match(loadCharBlock(Ptr)));
+    Ptr += NumMatched;
+    if (NumMatched != 16)
+      break;
+  }
+  return Ptr;
+}
+#endif
+
+/// skipIdentifierBodyFast - Skip a prefix of a run of [a-zA-Z0-9_] starting at
+/// \p Ptr, without looking at or past \p End.
+static inline const char *skipIdentifierBodyFast(const char *Ptr,
+                                                 const char *End) {
+#ifdef LEXER_USE_CHAR_BLOCKS
+  return skipCharBlocks<matchIdentifierBody>(Ptr, End);
+#else
+  return Ptr;
+#endif
+}
+
+/// skipNumberBodyFast - Skip a prefix of a run of [a-zA-Z0-9_.] starting at
+/// \p Ptr, without looking at or past \p End.
+static inline const char *skipNumberBodyFast(const char *Ptr,
+                                             const char *End) {
+#ifdef LEXER_USE_CHAR_BLOCKS
+  return skipCharBlocks<matchNumberBody>(Ptr, End);
+#else
+  return Ptr;
+#endif
+}
+
+/// skipHorizontalWhitespaceFast - Skip a prefix of a run of horizontal
+/// whitespace starting at \p Ptr, without looking at or past \p End.
+static inline const char *skipHorizontalWhitespaceFast(const char *Ptr,
+                                                       const char *End) {
+#ifdef LEXER_USE_CHAR_BLOCKS
+  return skipCharBlocks<matchHorizontalWhitespace>(Ptr, End);
+#else
+  return Ptr;
+#endif
+}
+
+/// skipBCPLCommentBodyFast - Skip a prefix of the characters before the next
+/// '\\0', '\\n' or '\\r' starting at \p Ptr, without looking at or past \p End.
+static inline const char *skipBCPLCommentBodyFast(const char *Ptr,
+                                                  const char *End) {
+#ifdef LEXER_USE_CHAR_BLOCKS
+  return skipCharBlocks<matchBCPLCommentBody>(Ptr, End);
+#else
+  return Ptr;
+#endif
+}
+
+/// skipBlockCommentBodyFast - Skip a prefix of the characters before the next
+/// '\\0' or '/' starting at \p Ptr, without looking at or past \p End.
+static inline const char *skipBlockCommentBodyFast(const char *Ptr,
+                                                   const char *End) {
+#ifdef LEXER_USE_CHAR_BLOCKS
+  return skipCharBlocks<matchBlockCommentBody>(Ptr, End);
+#else
+  return Ptr;
+#endif
+}
+
+/// isExcludedLineBody - Return true if \p c can be skipped without a closer
+/// look when it is in the middle of a line of an excluded conditional block:
+/// it cannot end the line, start a comment or a literal, or escape a newline.
+static inline bool isExcludedLineBody(unsigned char c) {
+  switch (c) {
+  case '\0': case '\n': case '\r': case '/':
+  case '"': case '\'': case '\\': case '?':
+    return false;
+  default:
+    return true;
+  }
+}
+
+/// skipExcludedLineBodyFast - Skip a prefix of a run of characters accepted
+/// by isExcludedLineBody starting at \p Ptr, without looking at or past
+/// \p End.
+static inline const char *skipExcludedLineBodyFast(const char *Ptr,
+                                                   const char *End) {
+#ifdef LEXER_USE_CHAR_BLOCKS
+  return skipCharBlocks<matchExcludedLineBody>(Ptr, End);
+#else
+  return Ptr;
+#endif
+}
+
 // Allow external clients to make use of CharInfo.
 bool Lexer::isIdentifierBodyChar(char c, const LangOptions &LangOpts) {
   return isIdentifierBody(c) || (c == '$' && LangOpts.DollarIdents);
@@ -1467,6 +1701,7 @@ void Lexer::SkipBytes(unsigned Bytes, bool StartOfLine) {
 void Lexer::LexIdentifier(Token &Result, const char *CurPtr) {
   // Match [_A-Za-z0-9]*, we have already matched [_A-Za-z$]
   unsigned Size;
+  CurPtr = skipIdentifierBodyFast(CurPtr, BufferEnd);
   unsigned char C = *CurPtr++;
   while (isIdentifierBody(C))
     C = *CurPtr++;
@@ -1548,8 +1783,17 @@ bool Lexer::isHexaLiteral(const char *Start, const LangOptions &LangOpts) {
 /// constant.
 void Lexer::LexNumericConstant(Token &Result, const char *CurPtr) {
   unsigned Size;
-  char C = getCharAndSize(CurPtr, Size);
   char PrevCh = 0;
+
+  // Number bodies never contain the characters that start trigraphs or escaped
+  // newlines, so their leading raw run can be skipped without decoding.
+  const char *RunEnd = skipNumberBodyFast(CurPtr, BufferEnd);
+  if (RunEnd != CurPtr) {
+    PrevCh = RunEnd[-1];
+    CurPtr = RunEnd;
+  }
+
+  char C = getCharAndSize(CurPtr, Size);
   while (isNumberBody(C)) { // FIXME: UCNs.
     CurPtr = ConsumeChar(CurPtr, Size, Result);
     PrevCh = C;
@@ -1859,6 +2103,10 @@ bool Lexer::SkipWhitespace(Token &Result, const char *CurPtr) {
   unsigned char Char = *CurPtr;  // Skip consequtive spaces efficiently.
   while (1) {
     // Skip horizontal whitespace very aggressively.
+    if (isHorizontalWhitespace(Char)) {
+      CurPtr = skipHorizontalWhitespaceFast(CurPtr, BufferEnd);
+      Char = *CurPtr;
+    }
     while (isHorizontalWhitespace(Char))
       Char = *++CurPtr;
 
@@ -1917,8 +2165,10 @@ bool Lexer::SkipBCPLComment(Token &Result, const char *CurPtr) {
   // them.  As such, optimize for this case with the inner loop.
   char C;
   do {
+    // Skip over characters in the fast loop.  The code-completion point is a
+    // '\0', so the block scan stops there as well.
+    CurPtr = skipBCPLCommentBodyFast(CurPtr, BufferEnd);
     C = *CurPtr;
-    // Skip over characters in the fast loop.
     while (C != 0 &&                // Potentially EOF.
            C != '\n' && C != '\r')  // Newline or DOS-style newline.
       C = *++CurPtr;
@@ -2114,13 +2364,6 @@ static bool isEndOfBlockCommentWithEscapedNewLine(const char *CurPtr,
   return true;
 }
 
-#ifdef __SSE2__
-#include <emmintrin.h>
-#elif __ALTIVEC__
-#include <altivec.h>
-#undef bool
-#endif
-
 /// We have just read from input the / and * characters that started a comment.
 /// Read until we find the * and / characters that terminate the comment.
 /// Note that we don't bother decoding trigraphs or escaped newlines in block
@@ -2348,6 +2591,188 @@ void Lexer::ReadToEndOfLine(SmallVectorImpl<char> *Result) {
   }
 }
 
+/// skipBackslashNewlines - Skip the backslash-newline sequences at \p Ptr.
+/// Unlike SkipEscapedNewLines, this does not recognize the ??/ trigraph.
+static const char *skipBackslashNewlines(const char *Ptr) {
+  while (*Ptr == '\\') {
+    unsigned Size = Lexer::getEscapedNewLineSize(Ptr + 1);
+    if (Size == 0)
+      break;
+    Ptr += Size + 1;
+  }
+  return Ptr;
+}
+
+/// SkipExcludedLines - Skip the text of an excluded conditional block, up to
+/// the next '#' which may start a directive, without forming any tokens.
+///
+/// The scan understands comments, literals and escaped newlines, which decide
+/// where lines start.  It stops early, at the last point between tokens, when
+/// it finds anything else that needs the full lexer: trigraphs, raw string
+/// literals, escaped newlines inside a comment delimiter, or a null character
+/// (which may be the end of the buffer or the code-completion point).
+void Lexer::SkipExcludedLines() {
+  assert(LexingRawMode && !ParsingPreprocessorDirective &&
+         "Can only skip the text of excluded blocks!");
+  const char *CurPtr = BufferPtr;
+  bool AtStartOfLine = IsAtStartOfLine;
+
+  // The last point between tokens that the scan went past, where lexing
+  // resumes.
+  const char *ResumePtr = CurPtr;
+  bool ResumeAtStartOfLine = AtStartOfLine;
+  bool SkippedTokens = false;
+
+  while (1) {
+    char C = *CurPtr++;
+    switch (C) {
+    case 0:
+      goto Resume;
+
+    case ' ':
+    case '\t':
+    case '\f':
+    case '\v':
+      continue;
+
+    case '\n':
+    case '\r':
+      AtStartOfLine = true;
+      ResumePtr = CurPtr;
+      ResumeAtStartOfLine = true;
+      continue;
+
+    case '\\': {
+      // Escaped newlines join lines, so they do not start a new one.
+      const char *AfterNewlines = skipBackslashNewlines(CurPtr - 1);
+      if (AfterNewlines != CurPtr - 1) {
+        CurPtr = AfterNewlines;
+        continue;
+      }
+      break;
+    }
+
+    case '?':
+      if (LangOpts.Trigraphs && *CurPtr == '?')
+        goto Resume;
+      break;
+
+    case '#':
+      if (AtStartOfLine)
+        goto Resume;
+      break;
+
+    case '%':
+      if (!AtStartOfLine || !LangOpts.Digraphs)
+        break;
+      if (*CurPtr == ':' || *CurPtr == '\\' ||
+          (*CurPtr == '?' && LangOpts.Trigraphs))
+        goto Resume;
+      break;
+
+    case '/':
+      if (*CurPtr == '*') {
+        // Skip the block comment.  Its newlines do not start lines.
+        const char *Slash = CurPtr + 1;
+        while (1) {
+          Slash = skipBlockCommentBodyFast(Slash, BufferEnd);
+          while (*Slash != '/' && *Slash != 0)
+            ++Slash;
+          if (*Slash == 0)
+            goto Resume;
+          if (Slash[-1] == '*' && Slash - 1 != CurPtr)
+            break;
+          // The '*' may be before an escaped newline.
+          if (Slash[-1] == '\n' || Slash[-1] == '\r')
+            goto Resume;
+          ++Slash;
+        }
+        CurPtr = Slash + 1;
+        ResumePtr = CurPtr;
+        ResumeAtStartOfLine = AtStartOfLine;
+        continue;
+      }
+
+      if (*CurPtr == '/' && LangOpts.BCPLComment) {
+        // Skip the line comment, and the lines it continues onto.
+        const char *Newline = CurPtr + 1;
+        while (1) {
+          Newline = skipBCPLCommentBodyFast(Newline, BufferEnd);
+          while (*Newline != '\n' && *Newline != '\r' && *Newline != 0)
+            ++Newline;
+          if (*Newline == 0)
+            goto Resume;
+
+          const char *LastChar = Newline - 1;
+          while (isHorizontalWhitespace(*LastChar))
+            --LastChar;
+          if (LangOpts.Trigraphs && *LastChar == '/' && LastChar[-1] == '?')
+            goto Resume;
+          if (*LastChar != '\\')
+            break;
+          Newline = skipBackslashNewlines(LastChar);
+        }
+        // Leave the newline to start the next line.
+        CurPtr = Newline;
+        continue;
+      }
+
+      if (*CurPtr == '\\' || (*CurPtr == '?' && LangOpts.Trigraphs))
+        goto Resume;
+      break;
+
+    case '"':
+      // Raw string literals may span lines; leave them to the lexer.
+      if (LangOpts.CPlusPlus0x && CurPtr - 1 != BufferStart &&
+          (CurPtr[-2] == 'R' || isVerticalWhitespace(CurPtr[-2])))
+        goto Resume;
+      // FALL THROUGH.
+    case '\'': {
+      // Skip the literal, which ends at its closing quote or, if it is
+      // unterminated, before the end of the line.
+      while (1) {
+        CurPtr = skipBackslashNewlines(CurPtr);
+        char LitChar = *CurPtr;
+        if (LitChar == '\n' || LitChar == '\r')
+          break;
+        if (LitChar == 0 ||
+            (LitChar == '?' && LangOpts.Trigraphs && CurPtr[1] == '?'))
+          goto Resume;
+        ++CurPtr;
+        if (LitChar == C)
+          break;
+        if (LitChar == '\\') {
+          CurPtr = skipBackslashNewlines(CurPtr);
+          if (*CurPtr == 0)
+            goto Resume;
+          ++CurPtr;
+        }
+      }
+      break;
+    }
+
+    default:
+      break;
+    }
+
+    // Anything else is part of a token; skip to the next character which
+    // needs a closer look.
+    SkippedTokens = true;
+    AtStartOfLine = false;
+    CurPtr = skipExcludedLineBodyFast(CurPtr, BufferEnd);
+    while (isExcludedLineBody(*CurPtr))
+      ++CurPtr;
+  }
+
+Resume:
+  // Tokens in excluded blocks count as tokens for the multiple-include
+  // optimization, as they do when they are lexed.
+  if (SkippedTokens)
+    MIOpt.ReadToken();
+  BufferPtr = ResumePtr;
+  IsAtStartOfLine = ResumeAtStartOfLine;
+}
+
 /// LexEndOfFile - CurPtr points to the end of this file.  Handle this
 /// condition, reporting diagnostics and handling other edge cases as required.
 /// This returns true if Result contains a token, false if PP.Lex should be
@@ -2547,6 +2972,170 @@ bool Lexer::isCodeCompletionPoint(const char *CurPtr) const {
 }
 
 
+bool Lexer::LexFromTokenCache(Token &Result) {
+  // Newlines end directives, and comments and whitespace may have to be
+  // returned or handed to the comment handlers: lex those cases normally.
+  if (ParsingPreprocessorDirective || ExtendedTokenMode)
+    return false;
+
+  const FileTokenCache::Entry *Entry =
+    TokenCache->find(BufferPtr - BufferStart, TokenCacheHint);
+  if (!Entry ||
+      (Entry->HasComment && !LexingRawMode && PP->hasCommentHandlers()))
+    return false;
+
+  Result.setFlagValue(Token::StartOfLine, Entry->Flags & Token::StartOfLine);
+  Result.setFlagValue(Token::LeadingSpace, Entry->Flags & Token::LeadingSpace);
+
+  // Notify MIOpt that we read a non-whitespace/non-comment token.
+  MIOpt.ReadToken();
+
+  const char *TokStart = BufferStart + Entry->Offset;
+  BufferPtr = TokStart;
+  tok::TokenKind Kind = Entry->getKind();
+  FormTokenWithChars(Result, TokStart + Entry->Length, Kind);
+
+  if (Kind != tok::raw_identifier) {
+    if (Result.isLiteral())
+      Result.setLiteralData(TokStart);
+    return true;
+  }
+
+  // This mirrors the end of LexIdentifier.
+  Result.setRawIdentifierData(TokStart);
+  if (LexingRawMode)
+    return true;
+
+  IdentifierInfo *II = PP->LookUpIdentifierInfo(Result);
+  if (II->isHandleIdentifierCase())
+    PP->HandleIdentifier(Result);
+  return true;
+}
+
+/// isRawStringLiteralQuote - Return true if the double quote at \p Quote
+/// opens a C++11 raw string literal, because it follows an 'R' prefix.
+static bool isRawStringLiteralQuote(const char *Quote,
+                                    const char *BufferStart) {
+  if (Quote == BufferStart || Quote[-1] != 'R')
+    return false;
+  const char *Prefix = Quote - 1;
+  if (Prefix - BufferStart >= 2 && Prefix[-1] == '8' && Prefix[-2] == 'u')
+    Prefix -= 2;
+  else if (Prefix != BufferStart &&
+           (Prefix[-1] == 'u' || Prefix[-1] == 'U' || Prefix[-1] == 'L'))
+    --Prefix;
+  return Prefix == BufferStart || !isIdentifierBody(Prefix[-1]);
+}
+
+/// SkipToDirectiveLine - CurPtr points to the first character of a line after
+/// its leading whitespace.  If the line cannot start a preprocessor directive,
+/// skip it, and the lines after it which cannot either, without forming any
+/// tokens.  Return a pointer to the first character of the line that might
+/// start a directive, or to the end of the buffer.
+///
+/// Comments and literals spanning lines are skipped as a whole, so that the
+/// lines within them are not mistaken for directives.
+const char *Lexer::SkipToDirectiveLine(const char *CurPtr) {
+  while (1) {
+    // Leave empty lines, and lines which start with something that might turn
+    // into a '#' (a digraph, a trigraph, a comment or an escaped newline), to
+    // the lexer, as well as nulls, which might be the end of the buffer or
+    // the code completion point.
+    switch (*CurPtr) {
+    case '#': case '%': case '?': case '/': case '\\':
+    case '\n': case '\r': case 0:
+      return CurPtr;
+    }
+
+    // Skip to the end of the line.
+    while (*CurPtr != '\n' && *CurPtr != '\r') {
+      char C = *CurPtr++;
+      switch (C) {
+      case 0:
+        return CurPtr - 1;
+
+      case '\\':
+        // Skip an escaped newline, which continues the line.
+        if (CurPtr[0] == '\r' && CurPtr[1] == '\n')
+          CurPtr += 2;
+        else if (CurPtr[0] == '\n' || CurPtr[0] == '\r')
+          ++CurPtr;
+        break;
+
+      case '/':
+        if (*CurPtr == '*') {
+          // Skip a block comment.
+          for (++CurPtr; CurPtr[0] != '*' || CurPtr[1] != '/'; ++CurPtr)
+            if (CurPtr == BufferEnd)
+              return BufferEnd;
+          CurPtr += 2;
+        } else if (*CurPtr == '/' && LangOpts.BCPLComment) {
+          // Skip a line comment, which escaped newlines continue.
+          for (; *CurPtr != '\n' && *CurPtr != '\r'; ++CurPtr) {
+            if (CurPtr == BufferEnd)
+              return BufferEnd;
+            if (CurPtr[0] == '\\' && CurPtr[1] == '\r' && CurPtr[2] == '\n')
+              CurPtr += 2;
+            else if (CurPtr[0] == '\\' &&
+                     (CurPtr[1] == '\n' || CurPtr[1] == '\r'))
+              ++CurPtr;
+          }
+        }
+        break;
+
+      case '"':
+        if (LangOpts.CPlusPlus0x &&
+            isRawStringLiteralQuote(CurPtr - 1, BufferStart)) {
+          // Skip a raw string literal, which ends at the first ')', followed
+          // by its delimiter and a double quote.
+          const char *DelimEnd = CurPtr;
+          while (DelimEnd - CurPtr <= 16 && *DelimEnd != '(' &&
+                 *DelimEnd != ')' && *DelimEnd != '\\' &&
+                 !isWhitespace(*DelimEnd) && DelimEnd != BufferEnd)
+            ++DelimEnd;
+          if (*DelimEnd == '(') {
+            std::string Terminator = ")";
+            Terminator.append(CurPtr, DelimEnd);
+            Terminator += '"';
+            size_t End = StringRef(DelimEnd, BufferEnd - DelimEnd)
+                           .find(Terminator);
+            if (End == StringRef::npos)
+              return BufferEnd;
+            CurPtr = DelimEnd + End + Terminator.size();
+            break;
+          }
+        }
+        // Fall through.
+      case '\'':
+        // Skip a string or character literal.  Unterminated ones end at the
+        // end of the line.
+        while (*CurPtr != C && *CurPtr != '\n' && *CurPtr != '\r') {
+          if (CurPtr == BufferEnd)
+            return BufferEnd;
+          if (*CurPtr == '\\') {
+            ++CurPtr;
+            if (CurPtr[0] == '\r' && CurPtr[1] == '\n')
+              ++CurPtr;
+            if (CurPtr == BufferEnd)
+              return BufferEnd;
+          }
+          ++CurPtr;
+        }
+        if (*CurPtr == C)
+          ++CurPtr;
+        break;
+      }
+    }
+
+    // Skip the newline and the leading whitespace of the next line.
+    if (CurPtr[0] == '\r' && CurPtr[1] == '\n')
+      ++CurPtr;
+    ++CurPtr;
+    while (isHorizontalWhitespace(*CurPtr))
+      ++CurPtr;
+  }
+}
+
 /// LexTokenInternal - This implements a simple C family lexer.  It is an
 /// extremely performance critical piece of code.  This assumes that the buffer
 /// has a null character at the end of the file.  This returns a preprocessing
@@ -2579,6 +3168,20 @@ LexNextToken:
     Result.setFlag(Token::LeadingSpace);
   }
 
+  // If the preprocessor only runs directives, skip the lines which cannot
+  // start one.  The lines are not empty, so the file has tokens outside of
+  // any include guard.
+  if (Result.isAtStartOfLine() && PP && PP->getSkipNonDirectiveLines() &&
+      !LexingRawMode && !Is_PragmaLexer && !ParsingPreprocessorDirective) {
+    const char *DirectiveLine = SkipToDirectiveLine(CurPtr);
+    if (DirectiveLine != CurPtr) {
+      MIOpt.ReadToken();
+      BufferPtr = DirectiveLine;
+      Result.clearFlag(Token::LeadingSpace);
+      goto LexNextToken;
+    }
+  }
+
   unsigned SizeTmp, SizeTmp2;   // Temporaries for use in cases below.
 
   // Read a character, advancing over it.
@@ -818,6 +818,25 @@ NumericLiteralParser::GetFloatValue(llvm::APFloat &Result) {
                                   APFloat::rmNearestTiesToEven);
 }
 
+bool NumericLiteralParser::GetPlainDecimalValue(StringRef Spelling,
+                                                uint64_t &Val) {
+  // Twenty digits can overflow 64 bits, nineteen cannot.  A leading zero
+  // makes an octal number, or a floating one.
+  if (Spelling.empty() || Spelling.size() > 19 ||
+      (Spelling[0] == '0' && Spelling.size() != 1))
+    return false;
+
+  uint64_t Result = 0;
+  for (unsigned I = 0, N = Spelling.size(); I != N; ++I) {
+    unsigned Digit = (unsigned char)Spelling[I] - '0';
+    if (Digit > 9)
+      return false;
+    Result = Result * 10 + Digit;
+  }
+  Val = Result;
+  return true;
+}
+
 
 /// \verbatim
 ///       user-defined-character-literal: [C++11 lex.ext]
@@ -1036,6 +1055,12 @@ CharLiteralParser::CharLiteralParser(const char *begin, const char *end,
     Value = (signed char)Value;
 }
 
+/// \brief The number of characters beyond which a string literal is
+/// diagnosed as an extension.
+static unsigned getMaxStringChars(const LangOptions &Features) {
+  return Features.CPlusPlus ? 65536 : Features.C99 ? 4095 : 509;
+}
+
 /// \verbatim
 ///       string-literal: [C++0x lex.string]
 ///         encoding-prefix " [s-char-sequence] "
@@ -1348,7 +1373,7 @@ void StringLiteralParser::init(const Token *StringToks, unsigned NumStringToks){
     }
   } else if (Diags) {
     // Complain if this string literal has too many characters.
-    unsigned MaxChars = Features.CPlusPlus? 65536 : Features.C99 ? 4095 : 509;
+    unsigned MaxChars = getMaxStringChars(Features);
     
     if (GetNumStringChars() > MaxChars)
       Diags->Report(StringToks[0].getLocation(),
@@ -1360,6 +1385,27 @@ void StringLiteralParser::init(const Token *StringToks, unsigned NumStringToks){
   }
 }
 
+bool StringLiteralParser::GetPlainString(StringRef Spelling,
+                                         const LangOptions &Features,
+                                         StringRef &String) {
+  // A raw string, or one with a ud-suffix, does not start and end with the
+  // quotes.
+  if (Spelling.size() < 2 || Spelling[0] != '"' ||
+      Spelling[Spelling.size() - 1] != '"' ||
+      Spelling.size() - 2 > getMaxStringChars(Features))
+    return false;
+
+  // Escapes (including the \p of Pascal strings) and non-ASCII characters,
+  // which must be valid UTF-8, need the parser.
+  StringRef Contents = Spelling.substr(1, Spelling.size() - 2);
+  for (const char *I = Contents.begin(), *E = Contents.end(); I != E; ++I)
+    if (*I == '\\' || (unsigned char)*I >= 0x80)
+      return false;
+
+  String = Contents;
+  return true;
+}
+
 /// \brief This function copies from Fragment, which is a sequence of bytes
 /// within Tok's contents (which begin at TokBegin) into ResultPtr.
 /// Performs widening for multi-byte characters.
@@ -0,0 +1,432 @@
+//===--- MacroArgExpansionCache.cpp - Replay of argument pre-expansion ----===//
+//
+//                     The LLVM Compiler Infrastructure
+//
+// This file is distributed under the University of Illinois Open Source
+// License. See LICENSE.TXT for details.
+//
+//===----------------------------------------------------------------------===//
+//
+// This file implements the MacroArgExpansionCache interface.
+//
+//===----------------------------------------------------------------------===//
+
+#include "MacroArgExpansionCache.h"
+#include "clang/Basic/Diagnostic.h"
+#include "clang/Basic/SourceManager.h"
+#include "clang/Lex/MacroInfo.h"
+#include "clang/Lex/Preprocessor.h"
+#include "llvm/ADT/OwningPtr.h"
+#include "llvm/ADT/STLExtras.h"
+#include "llvm/Support/raw_ostream.h"
+#include <algorithm>
+#include <cstring>
+using namespace clang;
+
+/// MaxEntries - The number of recorded pre-expansions after which the cache
+/// starts over, to bound its memory use.
+static const unsigned MaxEntries = 4096;
+
+namespace {
+/// MappedLoc - A source location of a recorded pre-expansion, with how to
+/// translate it for a replay.
+struct MappedLoc {
+  enum MapKind {
+    /// Keep - The location does not depend on the argument, e.g. it is in a
+    /// macro definition or the scratch buffer.
+    Keep,
+    /// InArgument - The location is within one of the argument tokens.
+    InArgument,
+    /// InExpansion - The location is in an SLocEntry created by the
+    /// pre-expansion.
+    InExpansion
+  };
+
+  SourceLocation Loc;
+  MapKind Kind;
+};
+
+/// RecordedSLocEntry - An expansion SLocEntry created by a pre-expansion.
+struct RecordedSLocEntry {
+  MappedLoc Spelling;
+  MappedLoc ExpansionStart;
+  /// ExpansionEnd - Invalid for a macro argument expansion.
+  MappedLoc ExpansionEnd;
+  unsigned Length;
+};
+}
+
+struct MacroArgExpansionCache::Entry {
+  Entry *Next;
+  unsigned Hash;
+
+  /// Input - The argument tokens, including the EOF.
+  std::vector<Token> Input;
+
+  /// Output - The pre-expanded tokens, including the EOF.
+  std::vector<Token> Output;
+  std::vector<MappedLoc::MapKind> OutputLocKinds;
+
+  /// SLocEntries - The SLocEntries created by the pre-expansion, in order,
+  /// starting at StartOffset.
+  std::vector<RecordedSLocEntry> SLocEntries;
+  unsigned StartOffset;
+
+  /// ExpandedMacros - The macros expanded by the pre-expansion.  They must be
+  /// enabled for a replay.
+  SmallVector<MacroInfo *, 4> ExpandedMacros;
+
+  /// OutputMacros - The macros named by the output tokens, with whether they
+  /// were enabled.  This determines whether they were marked unexpandable.
+  SmallVector<std::pair<MacroInfo *, bool>, 4> OutputMacros;
+};
+
+struct MacroArgExpansionCache::Recording {
+  const Token *Input;
+  unsigned Hash;
+  unsigned StartEntry;
+  unsigned StartOffset;
+  unsigned NumWarnings;
+  DiagnosticErrorTrap ErrorTrap;
+  SmallVector<MacroInfo *, 8> ExpandedMacros;
+  bool Replayable;
+
+  explicit Recording(DiagnosticsEngine &Diags) : ErrorTrap(Diags) { }
+};
+
+/// hashArgument - Hash the tokens of the argument \p ArgToks and the distances
+/// between their locations.  Returns false if the argument cannot be recorded.
+static bool hashArgument(const SourceManager &SM, const Token *ArgToks,
+                         unsigned &Hash) {
+  // FNV-1a over the properties that isSameArgument compares.
+  Hash = 2166136261U;
+  SourceLocation FirstLoc = ArgToks->getLocation();
+  if (FirstLoc.isInvalid())
+    return false;
+  for (const Token *Tok = ArgToks; ; ++Tok) {
+    if (Tok->isAnnotation() || Tok->is(tok::code_completion))
+      return false;
+
+    int RelOffs;
+    if (Tok->getLocation().isInvalid() ||
+        !SM.isInSameSLocAddrSpace(FirstLoc, Tok->getLocation(), &RelOffs))
+      return false;
+
+    unsigned Values[] = {
+      Tok->getKind(), Tok->getFlags(), Tok->getLength(), unsigned(RelOffs)
+    };
+    for (unsigned I = 0; I != llvm::array_lengthof(Values); ++I)
+      Hash = (Hash ^ Values[I]) * 16777619U;
+    if (Tok->isLiteral()) {
+      if (const char *Data = Tok->getLiteralData())
+        for (unsigned I = 0, N = Tok->getLength(); I != N; ++I)
+          Hash = (Hash ^ (unsigned char)Data[I]) * 16777619U;
+    } else {
+      uintptr_t II = (uintptr_t)Tok->getIdentifierInfo();
+      Hash = (Hash ^ unsigned(II) ^ unsigned(uint64_t(II) >> 32)) * 16777619U;
+    }
+
+    if (Tok->is(tok::eof))
+      return true;
+  }
+}
+
+/// isSameArgument - Return true if \p ArgToks consists of the same tokens as
+/// \p Input, with the same distances between their locations.
+static bool isSameArgument(const Token *ArgToks,
+                           const std::vector<Token> &Input) {
+  unsigned FirstLoc = ArgToks->getLocation().getRawEncoding();
+  unsigned InputFirstLoc = Input[0].getLocation().getRawEncoding();
+  for (unsigned I = 0, N = Input.size(); I != N; ++I) {
+    const Token &Tok = ArgToks[I], &Old = Input[I];
+    if (Tok.getKind() != Old.getKind() || Tok.getFlags() != Old.getFlags() ||
+        Tok.getLength() != Old.getLength() ||
+        Tok.getLocation().getRawEncoding() - FirstLoc !=
+          Old.getLocation().getRawEncoding() - InputFirstLoc)
+      return false;
+    if (Tok.isLiteral()) {
+      const char *Data = Tok.getLiteralData(), *OldData = Old.getLiteralData();
+      if (!Data || !OldData || memcmp(Data, OldData, Tok.getLength()))
+        return false;
+    } else if (Tok.getIdentifierInfo() != Old.getIdentifierInfo()) {
+      return false;
+    }
+    // The EOF may appear early if the argument is shorter.
+    if (Tok.is(tok::eof))
+      return I + 1 == N;
+  }
+  return false;
+}
+
+MacroArgExpansionCache::MacroArgExpansionCache()
+  : NumEntries(0), Stale(false), NumReplayed(0), NumRecorded(0) {
+}
+
+MacroArgExpansionCache::~MacroArgExpansionCache() {
+  clear();
+}
+
+void MacroArgExpansionCache::clear() {
+  for (llvm::DenseMap<unsigned, Entry *>::iterator I = Entries.begin(),
+         E = Entries.end(); I != E; ++I) {
+    for (Entry *Cur = I->second; Cur; ) {
+      Entry *Next = Cur->Next;
+      delete Cur;
+      Cur = Next;
+    }
+  }
+  Entries.clear();
+  NumEntries = 0;
+  Stale = false;
+}
+
+bool MacroArgExpansionCache::replay(Preprocessor &PP, const Token *ArgToks,
+                                    std::vector<Token> &Result) {
+  if (Stale)
+    clear();
+  // What a nested pre-expansion depends on is not tracked by the recordings
+  // around it, so only replay outside of them.
+  if (!ActiveRecordings.empty() || Entries.empty())
+    return false;
+
+  SourceManager &SM = PP.getSourceManager();
+  unsigned Hash;
+  if (!hashArgument(SM, ArgToks, Hash))
+    return false;
+  llvm::DenseMap<unsigned, Entry *>::iterator Pos = Entries.find(Hash);
+  if (Pos == Entries.end())
+    return false;
+
+  Entry *E = Pos->second;
+  for (; E; E = E->Next)
+    if (E->Hash == Hash && isSameArgument(ArgToks, E->Input))
+      break;
+  if (!E)
+    return false;
+
+  // The argument may only shift as a whole; its tokens must stay file or
+  // macro locations.
+  SourceLocation FirstLoc = ArgToks->getLocation();
+  SourceLocation InputFirstLoc = E->Input[0].getLocation();
+  if (FirstLoc.isMacroID() != InputFirstLoc.isMacroID())
+    return false;
+
+  for (unsigned I = 0, N = E->ExpandedMacros.size(); I != N; ++I)
+    if (!E->ExpandedMacros[I]->isEnabled())
+      return false;
+  for (unsigned I = 0, N = E->OutputMacros.size(); I != N; ++I)
+    if (E->OutputMacros[I].first->isEnabled() != E->OutputMacros[I].second)
+      return false;
+
+  int ArgumentDelta = FirstLoc.getRawEncoding() - InputFirstLoc.getRawEncoding();
+  int ExpansionDelta = SM.getNextLocalOffset() - E->StartOffset;
+  struct Mapper {
+    int ArgumentDelta, ExpansionDelta;
+    SourceLocation map(const MappedLoc &L) const {
+      switch (L.Kind) {
+      case MappedLoc::Keep:        return L.Loc;
+      case MappedLoc::InArgument:  return L.Loc.getLocWithOffset(ArgumentDelta);
+      case MappedLoc::InExpansion: return L.Loc.getLocWithOffset(ExpansionDelta);
+      }
+      return L.Loc;
+    }
+  } M = { ArgumentDelta, ExpansionDelta };
+
+  // Recreate the SLocEntries; since they are allocated contiguously, the
+  // locations within them move by ExpansionDelta.
+  for (unsigned I = 0, N = E->SLocEntries.size(); I != N; ++I) {
+    const RecordedSLocEntry &Rec = E->SLocEntries[I];
+    if (Rec.ExpansionEnd.Loc.isInvalid())
+      SM.createMacroArgExpansionLoc(M.map(Rec.Spelling),
+                                    M.map(Rec.ExpansionStart), Rec.Length);
+    else
+      SM.createExpansionLoc(M.map(Rec.Spelling), M.map(Rec.ExpansionStart),
+                            M.map(Rec.ExpansionEnd), Rec.Length);
+  }
+
+  Result = E->Output;
+  for (unsigned I = 0, N = Result.size(); I != N; ++I) {
+    MappedLoc L = { Result[I].getLocation(), E->OutputLocKinds[I] };
+    Result[I].setLocation(M.map(L));
+  }
+
+  // Do the bookkeeping of the macro expansions.
+  for (unsigned I = 0, N = E->ExpandedMacros.size(); I != N; ++I)
+    PP.markMacroAsUsed(E->ExpandedMacros[I]);
+  if (!E->ExpandedMacros.empty() && PP.CurPPLexer)
+    PP.CurPPLexer->MIOpt.ExpandedMacro();
+
+  ++NumReplayed;
+  return true;
+}
+
+MacroArgExpansionCache::Recording *
+MacroArgExpansionCache::startRecording(Preprocessor &PP, const Token *ArgToks) {
+  if (Stale)
+    clear();
+
+  SourceManager &SM = PP.getSourceManager();
+  unsigned Hash;
+  if (!hashArgument(SM, ArgToks, Hash))
+    return 0;
+
+  Recording *R = new Recording(PP.getDiagnostics());
+  R->Input = ArgToks;
+  R->Hash = Hash;
+  R->StartEntry = SM.local_sloc_entry_size();
+  R->StartOffset = SM.getNextLocalOffset();
+  R->NumWarnings = PP.getDiagnostics().getNumWarnings();
+  R->Replayable = true;
+  ActiveRecordings.push_back(R);
+  return R;
+}
+
+void MacroArgExpansionCache::noteMacroExpandedImpl(MacroInfo *MI) {
+  for (unsigned I = 0, N = ActiveRecordings.size(); I != N; ++I) {
+    Recording *R = ActiveRecordings[I];
+    // Builtin macros depend on more than the macro definitions.
+    if (MI->isBuiltinMacro())
+      R->Replayable = false;
+    else if (R->ExpandedMacros.empty() || R->ExpandedMacros.back() != MI)
+      R->ExpandedMacros.push_back(MI);
+  }
+}
+
+namespace {
+/// LocClassifier - Determines the MappedLoc::MapKind of the locations of a
+/// recorded pre-expansion.
+class LocClassifier {
+  const SourceManager &SM;
+  SourceLocation InputFirstLoc;
+  /// Extents - The offsets of the argument tokens relative to the first one,
+  /// with their lengths, sorted.
+  SmallVector<std::pair<unsigned, unsigned>, 16> Extents;
+  unsigned StartOffset, EndOffset;
+
+public:
+  LocClassifier(const SourceManager &SM, const Token *Input,
+                unsigned StartOffset, unsigned EndOffset)
+    : SM(SM), InputFirstLoc(Input->getLocation()), StartOffset(StartOffset),
+      EndOffset(EndOffset) {
+    for (const Token *Tok = Input; ; ++Tok) {
+      Extents.push_back(std::make_pair(Tok->getLocation().getRawEncoding() -
+                                         InputFirstLoc.getRawEncoding(),
+                                       Tok->getLength()));
+      if (Tok->is(tok::eof))
+        break;
+    }
+    std::sort(Extents.begin(), Extents.end());
+  }
+
+  /// classify - Compute the kind of \p Loc.  Returns false if the location
+  /// cannot be translated for a replay.
+  bool classify(SourceLocation Loc, MappedLoc::MapKind &Kind) const {
+    Kind = MappedLoc::Keep;
+    if (Loc.isInvalid())
+      return true;
+
+    if (!SM.isBeforeInSLocAddrSpace(Loc, StartOffset) &&
+        SM.isBeforeInSLocAddrSpace(Loc, EndOffset)) {
+      Kind = MappedLoc::InExpansion;
+      return true;
+    }
+
+    unsigned Rel = Loc.getRawEncoding() - InputFirstLoc.getRawEncoding();
+    SmallVectorImpl<std::pair<unsigned, unsigned> >::const_iterator I
+      = std::upper_bound(Extents.begin(), Extents.end(),
+                         std::make_pair(Rel, ~0U));
+    if (I != Extents.begin() &&
+        SM.isInSameSLocAddrSpace(InputFirstLoc, Loc, 0)) {
+      --I;
+      if (Rel - I->first <= I->second) {
+        Kind = MappedLoc::InArgument;
+        return true;
+      }
+    }
+
+    // Other macro locations come from the context of the argument.
+    return Loc.isFileID();
+  }
+};
+}
+
+void MacroArgExpansionCache::finishRecording(Preprocessor &PP, Recording *R,
+                                             const std::vector<Token> &Result) {
+  assert(!ActiveRecordings.empty() && ActiveRecordings.back() == R &&
+         "Recordings finished out of order");
+  ActiveRecordings.pop_back();
+
+  SourceManager &SM = PP.getSourceManager();
+  OwningPtr<Recording> RecordingOwner(R);
+  if (!R->Replayable || R->ErrorTrap.hasErrorOccurred() ||
+      PP.getDiagnostics().getNumWarnings() != R->NumWarnings)
+    return;
+
+  OwningPtr<Entry> E(new Entry());
+  E->Hash = R->Hash;
+  for (const Token *Tok = R->Input; ; ++Tok) {
+    E->Input.push_back(*Tok);
+    if (Tok->is(tok::eof))
+      break;
+  }
+  E->StartOffset = R->StartOffset;
+
+  unsigned EndEntry = SM.local_sloc_entry_size();
+  unsigned EndOffset = SM.getNextLocalOffset();
+  LocClassifier Classifier(SM, R->Input, R->StartOffset, EndOffset);
+  for (unsigned I = R->StartEntry; I != EndEntry; ++I) {
+    const SrcMgr::SLocEntry &SLoc = SM.getLocalSLocEntry(I);
+    // A scratch buffer chunk cannot be recreated.
+    if (!SLoc.isExpansion())
+      return;
+    const SrcMgr::ExpansionInfo &Expansion = SLoc.getExpansion();
+
+    RecordedSLocEntry Rec;
+    Rec.Spelling.Loc = Expansion.getSpellingLoc();
+    Rec.ExpansionStart.Loc = Expansion.getExpansionLocStart();
+    Rec.ExpansionEnd.Loc = Expansion.isMacroArgExpansion()
+                             ? SourceLocation()
+                             : Expansion.getExpansionLocEnd();
+    if (!Classifier.classify(Rec.Spelling.Loc, Rec.Spelling.Kind) ||
+        !Classifier.classify(Rec.ExpansionStart.Loc, Rec.ExpansionStart.Kind) ||
+        !Classifier.classify(Rec.ExpansionEnd.Loc, Rec.ExpansionEnd.Kind))
+      return;
+    unsigned NextOffset = I + 1 == EndEntry
+                            ? EndOffset
+                            : SM.getLocalSLocEntry(I + 1).getOffset();
+    Rec.Length = NextOffset - SLoc.getOffset() - 1;
+    E->SLocEntries.push_back(Rec);
+  }
+
+  E->Output = Result;
+  for (unsigned I = 0, N = Result.size(); I != N; ++I) {
+    MappedLoc::MapKind Kind;
+    if (!Classifier.classify(Result[I].getLocation(), Kind))
+      return;
+    E->OutputLocKinds.push_back(Kind);
+
+    if (Result[I].isAnnotation())
+      return;
+    if (IdentifierInfo *II = Result[I].getIdentifierInfo())
+      if (MacroInfo *MI = PP.getMacroInfo(II))
+        E->OutputMacros.push_back(std::make_pair(MI, MI->isEnabled()));
+  }
+
+  std::sort(R->ExpandedMacros.begin(), R->ExpandedMacros.end());
+  E->ExpandedMacros.append(R->ExpandedMacros.begin(),
+                           std::unique(R->ExpandedMacros.begin(),
+                                       R->ExpandedMacros.end()));
+
+  if (NumEntries == MaxEntries)
+    clear();
+  Entry *&Chain = Entries[E->Hash];
+  E->Next = Chain;
+  Chain = E.take();
+  ++NumEntries;
+  ++NumRecorded;
+}
+
+void MacroArgExpansionCache::PrintStats() const {
+  llvm::errs() << NumReplayed << " macro argument pre-expansions replayed, "
+               << NumRecorded << " recorded.\n";
+}
@@ -0,0 +1,98 @@
+//===--- MacroArgExpansionCache.h - Replay of argument pre-expansion -*- C++ -*-===//
+//
+//                     The LLVM Compiler Infrastructure
+//
+// This file is distributed under the University of Illinois Open Source
+// License. See LICENSE.TXT for details.
+//
+//===----------------------------------------------------------------------===//
+//
+// This file defines the MacroArgExpansionCache interface.
+//
+//===----------------------------------------------------------------------===//
+
+#ifndef LLVM_CLANG_MACROARGEXPANSIONCACHE_H
+#define LLVM_CLANG_MACROARGEXPANSIONCACHE_H
+
+#include "clang/Basic/LLVM.h"
+#include "llvm/ADT/DenseMap.h"
+#include "llvm/ADT/SmallVector.h"
+#include <vector>
+
+namespace clang {
+  class MacroInfo;
+  class Preprocessor;
+  class Token;
+
+/// MacroArgExpansionCache - Records the pre-expansion of macro arguments so
+/// that an argument made of the same tokens can be pre-expanded again without
+/// running the preprocessor over it.
+///
+/// A pre-expansion is only recorded if it had no effect besides producing its
+/// tokens and the expansion SLocEntries for them: it may not expand builtin
+/// macros (which includes _Pragma and __COUNTER__), emit diagnostics or
+/// allocate scratch buffer chunks.  It is only replayed if the argument tokens
+/// are identical, including the distances between their source locations, no
+/// macro was defined or undefined since it was recorded, and the macros it
+/// expanded or produced are enabled or disabled like they were.  Replay then
+/// recreates the SLocEntries with the same layout, so the result cannot be
+/// told apart from pre-expanding the argument again.
+class MacroArgExpansionCache {
+public:
+  struct Recording;
+
+private:
+  struct Entry;
+
+  /// Entries - The recorded pre-expansions, by the hash of their arguments.
+  /// Entries with the same hash are chained.
+  llvm::DenseMap<unsigned, Entry *> Entries;
+  unsigned NumEntries;
+
+  /// Stale - Whether a macro was defined or undefined since the entries were
+  /// recorded.
+  bool Stale;
+
+  /// ActiveRecordings - The pre-expansions being recorded, innermost last.
+  SmallVector<Recording *, 4> ActiveRecordings;
+
+  // Statistics.
+  unsigned NumReplayed, NumRecorded;
+
+  void clear();
+  void noteMacroExpandedImpl(MacroInfo *MI);
+
+public:
+  MacroArgExpansionCache();
+  ~MacroArgExpansionCache();
+
+  /// replay - If the pre-expansion of the argument \p ArgToks, which ends with
+  /// an EOF token, was recorded and can be replayed, recreate it into \p Result
+  /// and return true.
+  bool replay(Preprocessor &PP, const Token *ArgToks,
+              std::vector<Token> &Result);
+
+  /// startRecording - Start recording the pre-expansion of \p ArgToks.  Returns
+  /// null if it cannot be recorded.
+  Recording *startRecording(Preprocessor &PP, const Token *ArgToks);
+
+  /// finishRecording - Store the recording \p R, whose pre-expansion produced
+  /// \p Result, if it turned out to be replayable, and free it.
+  void finishRecording(Preprocessor &PP, Recording *R,
+                       const std::vector<Token> &Result);
+
+  /// noteMacroExpanded - Called for every macro the preprocessor expands.
+  void noteMacroExpanded(MacroInfo *MI) {
+    if (!ActiveRecordings.empty())
+      noteMacroExpandedImpl(MI);
+  }
+
+  /// invalidate - Called when a macro is defined or undefined.
+  void invalidate() { Stale = true; }
+
+  void PrintStats() const;
+};
+
+}  // end namespace clang
+
+#endif
@@ -12,6 +12,7 @@
 //===----------------------------------------------------------------------===//
 
 #include "MacroArgs.h"
+#include "MacroArgExpansionCache.h"
 #include "clang/Lex/MacroInfo.h"
 #include "clang/Lex/Preprocessor.h"
 #include "clang/Lex/LexDiagnostic.h"
@@ -161,6 +162,13 @@ MacroArgs::getPreExpArgument(unsigned Arg, const MacroInfo *MI,
   const Token *AT = getUnexpArgument(Arg);
   unsigned NumToks = getArgLength(AT)+1;  // Include the EOF.
 
+  // If the same argument was pre-expanded before, replay it.
+  MacroArgExpansionCache *Cache = PP.getMacroArgExpansionCache();
+  if (Cache && Cache->replay(PP, AT, Result))
+    return Result;
+  MacroArgExpansionCache::Recording *Recording
+    = Cache ? Cache->startRecording(PP, AT) : 0;
+
   // Otherwise, we have to pre-expand this argument, populating Result.  To do
   // this, we set up a fake TokenLexer to lex from the unexpanded argument
   // list.  With this installed, we lex expanded tokens until we hit the EOF
@@ -183,6 +191,9 @@ MacroArgs::getPreExpArgument(unsigned Arg, const MacroInfo *MI,
   if (PP.InCachingLexMode())
     PP.ExitCachingLexMode();
   PP.RemoveTopOfLexerStack();
+
+  if (Recording)
+    Cache->finishRecording(PP, Recording, Result);
   return Result;
 }
 
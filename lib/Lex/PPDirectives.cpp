@@ -223,6 +223,9 @@ void Preprocessor::SkipExcludedConditionalBlock(SourceLocation IfTokenLoc,
   CurPPLexer->LexingRawMode = true;
   Token Tok;
   while (1) {
+    // Skip the text up to the next line which may hold a directive without
+    // forming its tokens.
+    CurLexer->SkipExcludedLines();
     CurLexer->Lex(Tok);
 
     if (Tok.is(tok::code_completion)) {
@@ -1268,6 +1271,21 @@ bool Preprocessor::ConcatenateIncludeName(
   return true;
 }
 
+/// \brief If \p File is one of the Clang-supplied intrinsic headers, return
+/// the submodule of _Builtin_intrinsics that provides it.
+static Module *findIntrinsicsModule(HeaderSearch &HeaderInfo,
+                                    const FileEntry *File) {
+  const DirectoryEntry *Dir = HeaderInfo.getModuleMap().getBuiltinIncludeDir();
+  if (!Dir || File->getDir() != Dir ||
+      !HeaderInfo.hasModuleMap(File->getName(), Dir))
+    return 0;
+
+  Module *Mod = HeaderInfo.findModuleForHeader(File);
+  if (!Mod || Mod->getTopLevelModuleName() != "_Builtin_intrinsics")
+    return 0;
+  return Mod;
+}
+
 /// HandleIncludeDirective - The "\#include" tokens have just been read, read
 /// the file to be included from the lexer, then include it!  This is a common
 /// routine with functionality shared between \#include, \#include_next and
@@ -1414,6 +1432,12 @@ void Preprocessor::HandleIncludeDirective(SourceLocation HashLoc,
       return;
   }
 
+  // With -fintrinsics-module, the Clang-supplied intrinsic headers are
+  // imported from their module even though modules are otherwise disabled.
+  if (!SuggestedModule && !getLangOpts().Modules &&
+      getLangOpts().IntrinsicsModule)
+    SuggestedModule = findIntrinsicsModule(HeaderInfo, File);
+
   // If we are supposed to import a module rather than including the header,
   // do so now.
   if (SuggestedModule) {
@@ -1461,7 +1485,8 @@ void Preprocessor::HandleIncludeDirective(SourceLocation HashLoc,
     bool BuildingImportedModule
       = Path[0].first->getName() == getLangOpts().CurrentModule;
     
-    if (!BuildingImportedModule && getLangOpts().ObjC2) {
+    if (!BuildingImportedModule && getLangOpts().ObjC2 &&
+        getLangOpts().Modules) {
       // If we're not building the imported module, warn that we're going
       // to automatically turn this inclusion directive into a module import.
       // We only do this in Objective-C, where we have a module-import syntax.
@@ -1954,15 +1979,17 @@ void Preprocessor::HandleIfdefDirective(Token &Result, bool isIfndef,
   // Check to see if this is the last token on the #if[n]def line.
   CheckEndOfDirective(isIfndef ? "ifndef" : "ifdef");
 
+  // Whether the macro is defined is known without loading its definition
+  // from an external source.
   IdentifierInfo *MII = MacroNameTok.getIdentifierInfo();
-  MacroInfo *MI = getMacroInfo(MII);
+  bool IsDefined = MII->hasMacroDefinition();
 
   if (CurPPLexer->getConditionalStackDepth() == 0) {
     // If the start of a top-level #ifdef and if the macro is not defined,
     // inform MIOpt that this might be the start of a proper include guard.
     // Otherwise it is some other form of unknown conditional which we can't
     // handle.
-    if (!ReadAnyTokensBeforeDirective && MI == 0) {
+    if (!ReadAnyTokensBeforeDirective && !IsDefined) {
       assert(isIfndef && "#ifdef shouldn't reach here");
       CurPPLexer->MIOpt.EnterTopLevelIFNDEF(MII);
     } else
@@ -1970,8 +1997,8 @@ void Preprocessor::HandleIfdefDirective(Token &Result, bool isIfndef,
   }
 
   // If there is a macro, process it.
-  if (MI)  // Mark it used.
-    markMacroAsUsed(MI);
+  if (IsDefined)  // Mark it used.
+    markDefinedMacroAsUsed(MII);
 
   if (Callbacks) {
     if (isIfndef)
@@ -1981,7 +2008,7 @@ void Preprocessor::HandleIfdefDirective(Token &Result, bool isIfndef,
   }
 
   // Should we include the stuff contained by this directive?
-  if (!MI == isIfndef) {
+  if (!IsDefined == isIfndef) {
     // Yes, remember that we are inside a conditional, then lex the next token.
     CurPPLexer->pushConditionalLevel(DirectiveTok.getLocation(),
                                      /*wasskip*/false, /*foundnonskip*/true,
@@ -112,10 +112,8 @@ static bool EvaluateDefined(PPValue &Result, Token &PeekTok, DefinedTracker &DT,
   Result.Val.setIsUnsigned(false);  // Result is signed intmax_t.
 
   // If there is a macro, mark it used.
-  if (Result.Val != 0 && ValueLive) {
-    MacroInfo *Macro = PP.getMacroInfo(II);
-    PP.markMacroAsUsed(Macro);
-  }
+  if (Result.Val != 0 && ValueLive)
+    PP.markDefinedMacroAsUsed(II);
 
   // Invoke the 'defined' callback.
   if (PPCallbacks *Callbacks = PP.getPPCallbacks())
@@ -13,6 +13,7 @@
 //===----------------------------------------------------------------------===//
 
 #include "clang/Lex/Preprocessor.h"
+#include "clang/Lex/FileTokenCache.h"
 #include "clang/Lex/HeaderSearch.h"
 #include "clang/Lex/MacroInfo.h"
 #include "clang/Lex/LexDiagnostic.h"
@@ -101,10 +102,36 @@ void Preprocessor::EnterSourceFile(FileID FID, const DirectoryLookup *CurDir,
         CodeCompletionFileLoc.getLocWithOffset(CodeCompletionOffset);
   }
 
-  EnterSourceFileWithLexer(new Lexer(FID, InputFile, *this), CurDir);
+  Lexer *TheLexer = new Lexer(FID, InputFile, *this);
+  if (CacheRepeatedIncludes)
+    if (const FileTokenCache *Cache = getFileTokenCache(FID, InputFile))
+      TheLexer->setTokenCache(Cache);
+
+  EnterSourceFileWithLexer(TheLexer, CurDir);
   return;
 }
 
+const FileTokenCache *
+Preprocessor::getFileTokenCache(FileID FID, const llvm::MemoryBuffer *Buffer) {
+  // Only files that are entered again benefit from recorded tokens, and the
+  // code-completion point is never recorded.
+  const FileEntry *File = SourceMgr.getFileEntryForID(FID);
+  if (!File || HeaderInfo.getFileInfo(File).NumIncludes < 2 ||
+      (isCodeCompletionEnabled() && File == CodeCompletionFile))
+    return 0;
+
+  llvm::DenseMap<const FileEntry *, FileTokenCache *>::iterator Known
+    = FileTokenCaches.find(File);
+  if (Known != FileTokenCaches.end())
+    return Known->second;
+
+  FileTokenCache *Cache
+    = FileTokenCache::Create(SourceMgr.getLocForStartOfFile(FID), LangOpts,
+                             Buffer->getBufferStart(), Buffer->getBufferEnd());
+  FileTokenCaches[File] = Cache;
+  return Cache;
+}
+
 /// EnterSourceFileWithLexer - Add a source file to the top of the include stack
 ///  and start lexing tokens from it instead of the current buffer.
 void Preprocessor::EnterSourceFileWithLexer(Lexer *TheLexer,
@@ -291,10 +318,19 @@ bool Preprocessor::HandleEndOfFile(Token &Result, bool isEndOfMacro) {
     FileID ExitedFID;
     if (Callbacks && !isEndOfMacro && CurPPLexer)
       ExitedFID = CurPPLexer->getFileID();
+
+    // Remember the #included file if its buffer is to be released.
+    FileID FinishedFID;
+    if (!isEndOfMacro && CurLexer && !CurLexer->Is_PragmaLexer &&
+        SourceMgr.shouldReleaseFinishedBuffers())
+      FinishedFID = CurLexer->getFileID();
     
     // We're done with the #included file.
     RemoveTopOfLexerStack();
 
+    if (FinishedFID.isValid())
+      SourceMgr.releaseFileBuffer(FinishedFID);
+
     // Notify the client, if desired, that we are in a new source file.
     if (Callbacks && !isEndOfMacro && CurPPLexer) {
       SrcMgr::CharacteristicKind FileType =
@@ -14,6 +14,7 @@
 
 #include "clang/Lex/Preprocessor.h"
 #include "MacroArgs.h"
+#include "MacroArgExpansionCache.h"
 #include "clang/Lex/MacroInfo.h"
 #include "clang/Basic/SourceManager.h"
 #include "clang/Basic/FileManager.h"
@@ -55,6 +56,8 @@ void Preprocessor::setMacroInfo(IdentifierInfo *II, MacroInfo *MI,
   II->setHasMacroDefinition(true);
   if (II->isFromAST() && !LoadedFromAST)
     II->setChangedSinceDeserialization();
+  if (MacroArgExpansions)
+    MacroArgExpansions->invalidate();
 }
 
 /// \brief Undefine a macro for this identifier.
@@ -64,6 +67,8 @@ void Preprocessor::clearMacroInfo(IdentifierInfo *II) {
   II->setHasMacroDefinition(false);
   if (II->isFromAST())
     II->setChangedSinceDeserialization();
+  if (MacroArgExpansions)
+    MacroArgExpansions->invalidate();
 }
 
 /// RegisterBuiltinMacro - Register the specified identifier in the identifier
@@ -200,6 +205,9 @@ bool Preprocessor::HandleMacroExpandedIdentifier(Token &Identifier,
   // to disable the optimization in this case.
   if (CurPPLexer) CurPPLexer->MIOpt.ExpandedMacro();
 
+  // Recordings of argument pre-expansions depend on the macros they expand.
+  if (MacroArgExpansions) MacroArgExpansions->noteMacroExpanded(MI);
+
   // If this is a builtin macro, like __LINE__ or _Pragma, handle it specially.
   if (MI->isBuiltinMacro()) {
     if (Callbacks) Callbacks->MacroExpands(Identifier, MI,
@@ -1175,3 +1183,12 @@ void Preprocessor::markMacroAsUsed(MacroInfo *MI) {
     WarnUnusedMacroLocs.erase(MI->getDefinitionLoc());
   MI->setIsUsed(true);
 }
+
+void Preprocessor::markDefinedMacroAsUsed(IdentifierInfo *II) {
+  assert(II->hasMacroDefinition() && "Identifier is not a macro!");
+  // Only the macros of the main file are warned about when unused, and those
+  // never come from an AST file, so there is no need to load the others.
+  llvm::DenseMap<IdentifierInfo*, MacroInfo*>::iterator Pos = Macros.find(II);
+  if (Pos != Macros.end())
+    markMacroAsUsed(Pos->second);
+}
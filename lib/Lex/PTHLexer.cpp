@@ -27,9 +27,14 @@
 #include "llvm/ADT/StringMap.h"
 #include "llvm/Support/MemoryBuffer.h"
 #include "llvm/Support/system_error.h"
+#include <sys/stat.h>
 using namespace clang;
 using namespace clang::io;
 
+#if defined(_MSC_VER)
+#define S_ISDIR(s) ((_S_IFDIR & s) !=0)
+#endif
+
 #define DISK_TOKEN_SIZE (1+1+2+4+4)
 
 //===----------------------------------------------------------------------===//
@@ -437,10 +442,14 @@ static void InvalidPTH(DiagnosticsEngine &Diags, const char *Msg) {
 
 PTHManager *PTHManager::Create(const std::string &file,
                                DiagnosticsEngine &Diags) {
-  // Memory map the PTH file.
+  // Memory map the PTH file.  Nothing reads past the end of the buffer, so
+  // don't require a null terminator; that would force a copy of files whose
+  // size is a multiple of the page size.  This way, the pages are shared by
+  // all processes that use the same PTH file.
   OwningPtr<llvm::MemoryBuffer> File;
 
-  if (llvm::MemoryBuffer::getFile(file, File)) {
+  if (llvm::MemoryBuffer::getFile(file, File, /*FileSize=*/-1,
+                                  /*RequiresNullTerminator=*/false)) {
     // FIXME: Add ec.message() to this diag.
     Diags.Report(diag::err_invalid_pth_file) << file;
     return 0;
@@ -682,13 +691,13 @@ public:
   ~PTHStatCache() {}
 
   LookupResult getStat(const char *Path, struct stat &StatBuf,
-                       int *FileDescriptor) {
+                       int *FileDescriptor, VirtualFileSystem &FS) {
     // Do the lookup for the file's data in the PTH file.
     CacheTy::iterator I = Cache.find(Path);
 
     // If we don't get a hit in the PTH file just forward to 'stat'.
     if (I == Cache.end())
-      return statChained(Path, StatBuf, FileDescriptor);
+      return statChained(Path, StatBuf, FileDescriptor, FS);
 
     const PTHStatData &Data = *I;
 
@@ -708,3 +717,48 @@ public:
 FileSystemStatCache *PTHManager::createStatCache() {
   return new PTHStatCache(*((PTHFileLookup*) FileLookup));
 }
+
+namespace {
+/// PTHInputLookupTrait - Like PTHStatLookupTrait, but also returns the path of
+/// each entry when iterating over the table.
+class PTHInputLookupTrait : public PTHStatLookupTrait {
+public:
+  typedef std::pair<const char*, PTHStatData> data_type;
+
+  static data_type ReadData(const internal_key_type& k, const unsigned char* d,
+                            unsigned len) {
+    return data_type(k.second, PTHStatLookupTrait::ReadData(k, d, len));
+  }
+};
+} // end anonymous namespace
+
+bool PTHManager::isUpToDate() const {
+  PTHFileLookup &FL = *((PTHFileLookup*) FileLookup);
+  typedef OnDiskChainedHashTable<PTHInputLookupTrait> InputTableTy;
+  InputTableTy Inputs(FL.getNumBuckets(), FL.getNumEntries(), FL.getBuckets(),
+                      FL.getBase());
+
+  for (InputTableTy::data_iterator I = Inputs.data_begin(),
+         E = Inputs.data_end(); I != E; ++I) {
+    const InputTableTy::data_type &Input = *I;
+    struct stat StatBuf;
+    bool Exists = ::stat(Input.first, &StatBuf) == 0;
+
+    // A path that did not exist may now shadow a header found elsewhere.
+    if (!Input.second.hasStat) {
+      if (Exists)
+        return false;
+      continue;
+    }
+
+    if (!Exists)
+      return false;
+    if (S_ISDIR(Input.second.mode))
+      continue;
+    if (StatBuf.st_mtime != Input.second.mtime ||
+        StatBuf.st_size != Input.second.size)
+      return false;
+  }
+
+  return true;
+}
@@ -68,13 +68,9 @@ PreprocessingRecord::getPreprocessedEntitiesInRange(SourceRange Range) {
   return std::make_pair(iterator(this, Res.first), iterator(this, Res.second));
 }
 
-static bool isPreprocessedEntityIfInFileID(PreprocessedEntity *PPE, FileID FID,
-                                           SourceManager &SM) {
+static bool isPreprocessedEntityBeginInFileID(SourceLocation Loc, FileID FID,
+                                              SourceManager &SM) {
   assert(!FID.isInvalid());
-  if (!PPE)
-    return false;
-
-  SourceLocation Loc = PPE->getSourceRange().getBegin();
   if (Loc.isInvalid())
     return false;
   
@@ -84,6 +80,14 @@ static bool isPreprocessedEntityIfInFileID(PreprocessedEntity *PPE, FileID FID,
     return false;
 }
 
+static bool isPreprocessedEntityIfInFileID(PreprocessedEntity *PPE, FileID FID,
+                                           SourceManager &SM) {
+  if (!PPE)
+    return false;
+  return isPreprocessedEntityBeginInFileID(PPE->getSourceRange().getBegin(),
+                                           FID, SM);
+}
+
 /// \brief Returns true if the preprocessed entity that \arg PPEI iterator
 /// points to is coming from the file \arg FID.
 ///
@@ -120,8 +124,8 @@ bool PreprocessingRecord::isEntityInFileID(iterator PPEI, FileID FID) {
 
   assert(unsigned(PPID) < PreprocessedEntities.size() &&
          "Out-of bounds local preprocessed entity");
-  return isPreprocessedEntityIfInFileID(PreprocessedEntities[PPID],
-                                        FID, SourceMgr);
+  return isPreprocessedEntityBeginInFileID(PreprocessedEntityBegins[PPID],
+                                           FID, SourceMgr);
 }
 
 /// \brief Returns a pair of [Begin, End) iterators of preprocessed entities
@@ -170,32 +174,14 @@ PreprocessingRecord::findLocalPreprocessedEntitiesInRange(
 
 namespace {
 
-template <SourceLocation (SourceRange::*getRangeLoc)() const>
-struct PPEntityComp {
+struct LocBeforeComp {
   const SourceManager &SM;
 
-  explicit PPEntityComp(const SourceManager &SM) : SM(SM) { }
+  explicit LocBeforeComp(const SourceManager &SM) : SM(SM) { }
 
-  bool operator()(PreprocessedEntity *L, PreprocessedEntity *R) const {
-    SourceLocation LHS = getLoc(L);
-    SourceLocation RHS = getLoc(R);
+  bool operator()(SourceLocation LHS, SourceLocation RHS) const {
     return SM.isBeforeInTranslationUnit(LHS, RHS);
   }
-
-  bool operator()(PreprocessedEntity *L, SourceLocation RHS) const {
-    SourceLocation LHS = getLoc(L);
-    return SM.isBeforeInTranslationUnit(LHS, RHS);
-  }
-
-  bool operator()(SourceLocation LHS, PreprocessedEntity *R) const {
-    SourceLocation RHS = getLoc(R);
-    return SM.isBeforeInTranslationUnit(LHS, RHS);
-  }
-
-  SourceLocation getLoc(PreprocessedEntity *PPE) const {
-    SourceRange Range = PPE->getSourceRange();
-    return (Range.*getRangeLoc)();
-  }
 };
 
 }
@@ -205,11 +191,11 @@ unsigned PreprocessingRecord::findBeginLocalPreprocessedEntity(
   if (SourceMgr.isLoadedSourceLocation(Loc))
     return 0;
 
-  size_t Count = PreprocessedEntities.size();
+  size_t Count = PreprocessedEntityEnds.size();
   size_t Half;
-  std::vector<PreprocessedEntity *>::const_iterator
-    First = PreprocessedEntities.begin();
-  std::vector<PreprocessedEntity *>::const_iterator I;
+  std::vector<SourceLocation>::const_iterator
+    First = PreprocessedEntityEnds.begin();
+  std::vector<SourceLocation>::const_iterator I;
 
   // Do a binary search manually instead of using std::lower_bound because
   // The end locations of entities may be unordered (when a macro expansion
@@ -219,8 +205,7 @@ unsigned PreprocessingRecord::findBeginLocalPreprocessedEntity(
     Half = Count/2;
     I = First;
     std::advance(I, Half);
-    if (SourceMgr.isBeforeInTranslationUnit((*I)->getSourceRange().getEnd(),
-                                            Loc)){
+    if (SourceMgr.isBeforeInTranslationUnit(*I, Loc)) {
       First = I;
       ++First;
       Count = Count - Half - 1;
@@ -228,7 +213,7 @@ unsigned PreprocessingRecord::findBeginLocalPreprocessedEntity(
       Count = Half;
   }
 
-  return First - PreprocessedEntities.begin();
+  return First - PreprocessedEntityEnds.begin();
 }
 
 unsigned PreprocessingRecord::findEndLocalPreprocessedEntity(
@@ -236,66 +221,69 @@ unsigned PreprocessingRecord::findEndLocalPreprocessedEntity(
   if (SourceMgr.isLoadedSourceLocation(Loc))
     return 0;
 
-  std::vector<PreprocessedEntity *>::const_iterator
-  I = std::upper_bound(PreprocessedEntities.begin(),
-                       PreprocessedEntities.end(),
-                       Loc,
-                       PPEntityComp<&SourceRange::getBegin>(SourceMgr));
-  return I - PreprocessedEntities.begin();
+  std::vector<SourceLocation>::const_iterator
+  I = std::upper_bound(PreprocessedEntityBegins.begin(),
+                       PreprocessedEntityBegins.end(),
+                       Loc, LocBeforeComp(SourceMgr));
+  return I - PreprocessedEntityBegins.begin();
 }
 
 PreprocessingRecord::PPEntityID
 PreprocessingRecord::addPreprocessedEntity(PreprocessedEntity *Entity) {
   assert(Entity);
-  SourceLocation BeginLoc = Entity->getSourceRange().getBegin();
+  return addLocalEntity(Entity, Entity->getSourceRange(),
+                        isa<class InclusionDirective>(Entity));
+}
 
-  if (!isa<class InclusionDirective>(Entity)) {
-    assert((PreprocessedEntities.empty() ||
-            !SourceMgr.isBeforeInTranslationUnit(BeginLoc,
-                   PreprocessedEntities.back()->getSourceRange().getBegin())) &&
-           "a macro directive was encountered out-of-order");
-    PreprocessedEntities.push_back(Entity);
-    return getPPEntityID(PreprocessedEntities.size()-1, /*isLoaded=*/false);
-  }
+PreprocessingRecord::PPEntityID
+PreprocessingRecord::addLocalEntity(LocalEntity Entity, SourceRange Range,
+                                    bool MayBeOutOfOrder) {
+  SourceLocation BeginLoc = Range.getBegin();
 
   // Check normal case, this entity begin location is after the previous one.
-  if (PreprocessedEntities.empty() ||
+  if (PreprocessedEntityBegins.empty() ||
       !SourceMgr.isBeforeInTranslationUnit(BeginLoc,
-                   PreprocessedEntities.back()->getSourceRange().getBegin())) {
+                                           PreprocessedEntityBegins.back())) {
     PreprocessedEntities.push_back(Entity);
+    PreprocessedEntityBegins.push_back(BeginLoc);
+    PreprocessedEntityEnds.push_back(Range.getEnd());
     return getPPEntityID(PreprocessedEntities.size()-1, /*isLoaded=*/false);
   }
 
   // The entity's location is not after the previous one; this can happen with
   // include directives that form the filename using macros, e.g:
   // "#include MACRO(STUFF)".
+  assert(MayBeOutOfOrder && "a macro directive was encountered out-of-order");
 
-  typedef std::vector<PreprocessedEntity *>::iterator pp_iter;
+  typedef std::vector<SourceLocation>::iterator loc_iter;
 
   // Usually there are few macro expansions when defining the filename, do a
   // linear search for a few entities.
+  loc_iter InsertI = PreprocessedEntityBegins.end();
   unsigned count = 0;
-  for (pp_iter RI    = PreprocessedEntities.end(),
-               Begin = PreprocessedEntities.begin();
+  for (loc_iter RI    = PreprocessedEntityBegins.end(),
+                Begin = PreprocessedEntityBegins.begin();
        RI != Begin && count < 4; --RI, ++count) {
-    pp_iter I = RI;
+    loc_iter I = RI;
     --I;
-    if (!SourceMgr.isBeforeInTranslationUnit(BeginLoc,
-                                           (*I)->getSourceRange().getBegin())) {
-      pp_iter insertI = PreprocessedEntities.insert(RI, Entity);
-      return getPPEntityID(insertI - PreprocessedEntities.begin(),
-                           /*isLoaded=*/false);
+    if (!SourceMgr.isBeforeInTranslationUnit(BeginLoc, *I)) {
+      InsertI = RI;
+      break;
     }
   }
 
   // Linear search unsuccessful. Do a binary search.
-  pp_iter I = std::upper_bound(PreprocessedEntities.begin(),
-                               PreprocessedEntities.end(),
-                               BeginLoc,
-                               PPEntityComp<&SourceRange::getBegin>(SourceMgr));
-  pp_iter insertI = PreprocessedEntities.insert(I, Entity);
-  return getPPEntityID(insertI - PreprocessedEntities.begin(),
-                       /*isLoaded=*/false);
+  if (InsertI == PreprocessedEntityBegins.end())
+    InsertI = std::upper_bound(PreprocessedEntityBegins.begin(),
+                               PreprocessedEntityBegins.end(),
+                               BeginLoc, LocBeforeComp(SourceMgr));
+
+  unsigned Index = InsertI - PreprocessedEntityBegins.begin();
+  PreprocessedEntities.insert(PreprocessedEntities.begin() + Index, Entity);
+  PreprocessedEntityBegins.insert(InsertI, BeginLoc);
+  PreprocessedEntityEnds.insert(PreprocessedEntityEnds.begin() + Index,
+                                Range.getEnd());
+  return getPPEntityID(Index, /*isLoaded=*/false);
 }
 
 void PreprocessingRecord::SetExternalSource(
@@ -324,9 +312,29 @@ PreprocessedEntity *PreprocessingRecord::getPreprocessedEntity(PPEntityID PPID){
            "Out-of bounds loaded preprocessed entity");
     return getLoadedPreprocessedEntity(LoadedPreprocessedEntities.size()+PPID);
   }
-  assert(unsigned(PPID) < PreprocessedEntities.size() &&
+  return getLocalPreprocessedEntity(PPID);
+}
+
+/// \brief Retrieve the local preprocessed entity at the given index.
+PreprocessedEntity *
+PreprocessingRecord::getLocalPreprocessedEntity(unsigned Index) {
+  assert(Index < PreprocessedEntities.size() &&
          "Out-of bounds local preprocessed entity");
-  return PreprocessedEntities[PPID];
+  LocalEntity &Entity = PreprocessedEntities[Index];
+  if (PreprocessedEntity *PPE = Entity.dyn_cast<PreprocessedEntity *>())
+    return PPE;
+
+  // Create the macro expansion that the entry stands for.
+  SourceRange Range(PreprocessedEntityBegins[Index],
+                    PreprocessedEntityEnds[Index]);
+  MacroExpansion *Expansion;
+  if (MacroDefinition *Def = Entity.dyn_cast<MacroDefinition *>())
+    Expansion = new (*this) MacroExpansion(Def, Range);
+  else
+    Expansion = new (*this) MacroExpansion(Entity.get<IdentifierInfo *>(),
+                                           Range);
+  Entity = static_cast<PreprocessedEntity *>(Expansion);
+  return Expansion;
 }
 
 /// \brief Retrieve the loaded preprocessed entity at the given index.
@@ -363,12 +371,11 @@ void PreprocessingRecord::MacroExpands(const Token &Id, const MacroInfo* MI,
   if (Id.getLocation().isMacroID())
     return;
 
+  // The MacroExpansion is only created if a client asks for it.
   if (MI->isBuiltinMacro())
-    addPreprocessedEntity(
-                      new (*this) MacroExpansion(Id.getIdentifierInfo(),Range));
+    addLocalEntity(Id.getIdentifierInfo(), Range, /*MayBeOutOfOrder=*/false);
   else if (MacroDefinition *Def = findMacroDefinition(MI))
-    addPreprocessedEntity(
-                       new (*this) MacroExpansion(Def, Range));
+    addLocalEntity(Def, Range, /*MayBeOutOfOrder=*/false);
 }
 
 void PreprocessingRecord::MacroDefined(const Token &Id,
@@ -515,5 +522,7 @@ size_t PreprocessingRecord::getTotalMemory() const {
   return BumpAlloc.getTotalMemory()
     + llvm::capacity_in_bytes(MacroDefinitions)
     + llvm::capacity_in_bytes(PreprocessedEntities)
+    + llvm::capacity_in_bytes(PreprocessedEntityBegins)
+    + llvm::capacity_in_bytes(PreprocessedEntityEnds)
     + llvm::capacity_in_bytes(LoadedPreprocessedEntities);
 }
@@ -27,7 +27,9 @@
 
 #include "clang/Lex/Preprocessor.h"
 #include "MacroArgs.h"
+#include "MacroArgExpansionCache.h"
 #include "clang/Lex/ExternalPreprocessorSource.h"
+#include "clang/Lex/FileTokenCache.h"
 #include "clang/Lex/HeaderSearch.h"
 #include "clang/Lex/MacroInfo.h"
 #include "clang/Lex/Pragma.h"
@@ -67,7 +69,7 @@ Preprocessor::Preprocessor(DiagnosticsEngine &diags, LangOptions &opts,
 {
   OwnsHeaderSearch = OwnsHeaders;
   
-  ScratchBuf = new ScratchBuffer(SourceMgr);
+  ScratchBuf = new ScratchBuffer(SourceMgr, /*ShareSpellings=*/true);
   CounterValue = 0; // __COUNTER__ starts at 0.
   
   // Clear stats.
@@ -83,6 +85,8 @@ Preprocessor::Preprocessor(DiagnosticsEngine &diags, LangOptions &opts,
   KeepComments = false;
   KeepMacroComments = false;
   SuppressIncludeNotFoundError = false;
+  CacheRepeatedIncludes = false;
+  SkipNonDirectiveLines = false;
   
   // Macro expansion is enabled.
   DisableMacroExpansion = false;
@@ -152,6 +156,11 @@ Preprocessor::~Preprocessor() {
   for (MacroArgs *ArgList = MacroArgCache; ArgList; )
     ArgList = ArgList->deallocate();
 
+  // Free the recorded tokens of repeatedly included files.
+  for (llvm::DenseMap<const FileEntry *, FileTokenCache *>::iterator
+         I = FileTokenCaches.begin(), E = FileTokenCaches.end(); I != E; ++I)
+    delete I->second;
+
   // Release pragma information.
   delete PragmaHandlers;
 
@@ -180,6 +189,13 @@ void Preprocessor::setPTHManager(PTHManager* pm) {
   FileMgr.addStatCache(PTH->createStatCache());
 }
 
+void Preprocessor::setCacheMacroArgExpansions(bool Cache) {
+  if (!Cache)
+    MacroArgExpansions.reset();
+  else if (!MacroArgExpansions)
+    MacroArgExpansions.reset(new MacroArgExpansionCache());
+}
+
 void Preprocessor::DumpToken(const Token &Tok, bool DumpFlags) const {
   llvm::errs() << tok::getTokenName(Tok.getKind()) << " '"
                << getSpelling(Tok) << "'";
@@ -237,6 +253,9 @@ void Preprocessor::PrintStats() {
   llvm::errs() << (NumFastTokenPaste+NumTokenPaste)
              << " token paste (##) operations performed, "
              << NumFastTokenPaste << " on the fast path.\n";
+  ScratchBuf->PrintStats();
+  if (MacroArgExpansions)
+    MacroArgExpansions->PrintStats();
 
   llvm::errs() << "\nPreprocessor Memory: " << getTotalMemory() << "B total";
 
@@ -468,8 +487,8 @@ IdentifierInfo *Preprocessor::LookUpIdentifierInfo(Token &Identifier) const {
   IdentifierInfo *II;
   if (!Identifier.needsCleaning()) {
     // No cleaning needed, just use the characters from the lexed buffer.
-    II = getIdentifierInfo(StringRef(Identifier.getRawIdentifierData(),
-                                           Identifier.getLength()));
+    II = &Identifiers.getForLexer(StringRef(Identifier.getRawIdentifierData(),
+                                            Identifier.getLength()));
   } else {
     // Cleaning needed, alloca a buffer, clean into it, then use the buffer.
     SmallString<64> IdentifierBuffer;
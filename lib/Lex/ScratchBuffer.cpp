@@ -14,16 +14,26 @@
 #include "clang/Lex/ScratchBuffer.h"
 #include "clang/Basic/SourceManager.h"
 #include "llvm/Support/MemoryBuffer.h"
+#include "llvm/Support/raw_ostream.h"
 #include <cstring>
 using namespace clang;
 
-// ScratchBufSize - The size of each chunk of scratch memory.  Slightly less
-//than a page, almost certainly enough for anything. :)
+// ScratchBufSize - The size of the first chunk of scratch memory.  Slightly
+// less than a page, almost certainly enough for anything. :)
 static const unsigned ScratchBufSize = 4060;
 
-ScratchBuffer::ScratchBuffer(SourceManager &SM) : SourceMgr(SM), CurBuffer(0) {
+// MaxScratchBufSize - Each new chunk is twice the size of the previous one, up
+// to this limit.  A translation unit that pastes a lot of tokens ends up with a
+// handful of large buffers instead of many page-sized FileIDs, while one that
+// barely uses scratch space (and writes it into a PCH) stays small.
+static const unsigned MaxScratchBufSize = ScratchBufSize << 4;
+
+ScratchBuffer::ScratchBuffer(SourceManager &SM, bool ShareSpellings)
+  : SourceMgr(SM), CurBuffer(0), BufferSize(0), ShareSpellings(ShareSpellings),
+    NumTokens(0), NumSharedTokens(0), NumBuffers(0), TotalBufferBytes(0),
+    SpellingMapBytes(0) {
   // Set BytesUsed so that the first call to getToken will require an alloc.
-  BytesUsed = ScratchBufSize;
+  BytesUsed = BufferSize;
 }
 
 /// getToken - Splat the specified text into a temporary MemoryBuffer and
@@ -32,7 +42,25 @@ ScratchBuffer::ScratchBuffer(SourceManager &SM) : SourceMgr(SM), CurBuffer(0) {
 /// token.
 SourceLocation ScratchBuffer::getToken(const char *Buf, unsigned Len,
                                        const char *&DestPtr) {
-  if (BytesUsed+Len+2 > ScratchBufSize)
+  ++NumTokens;
+
+  // If this exact spelling was already formed, hand out the same copy.  Every
+  // token is on its own NUL terminated virtual line, so sharing one is
+  // indistinguishable from making a fresh copy, except that the spelling
+  // location is the same.
+  llvm::StringMapEntry<ScratchSpelling> *Entry = 0;
+  if (ShareSpellings) {
+    Entry = &Spellings.GetOrCreateValue(StringRef(Buf, Len));
+    if (Entry->getValue().Ptr) {
+      ++NumSharedTokens;
+      DestPtr = Entry->getValue().Ptr;
+      return Entry->getValue().Loc;
+    }
+    // The map keeps its own copy of the spelling next to the entry.
+    SpellingMapBytes += sizeof(*Entry) + Len + 1;
+  }
+
+  if (BytesUsed+Len+2 > BufferSize)
     AllocScratchBuffer(Len+2);
 
   // Prefix the token with a \n, so that it looks like it is the first thing on
@@ -53,21 +81,43 @@ SourceLocation ScratchBuffer::getToken(const char *Buf, unsigned Len,
   // diagnostic points to one.
   CurBuffer[BytesUsed-1] = '\0';
 
-  return BufferStartLoc.getLocWithOffset(BytesUsed-Len-1);
+  SourceLocation Loc = BufferStartLoc.getLocWithOffset(BytesUsed-Len-1);
+  if (Entry) {
+    Entry->getValue().Ptr = DestPtr;
+    Entry->getValue().Loc = Loc;
+  }
+  return Loc;
 }
 
 void ScratchBuffer::AllocScratchBuffer(unsigned RequestLen) {
   // Only pay attention to the requested length if it is larger than our default
   // page size.  If it is, we allocate an entire chunk for it.  This is to
   // support gigantic tokens, which almost certainly won't happen. :)
-  if (RequestLen < ScratchBufSize)
-    RequestLen = ScratchBufSize;
+  unsigned ChunkSize = MaxScratchBufSize;
+  if (NumBuffers < 4)
+    ChunkSize = ScratchBufSize << NumBuffers;
+  if (RequestLen < ChunkSize)
+    RequestLen = ChunkSize;
 
   llvm::MemoryBuffer *Buf =
     llvm::MemoryBuffer::getNewMemBuffer(RequestLen, "<scratch space>");
   FileID FID = SourceMgr.createFileIDForMemBuffer(Buf);
   BufferStartLoc = SourceMgr.getLocForStartOfFile(FID);
   CurBuffer = const_cast<char*>(Buf->getBufferStart());
+  BufferSize = RequestLen;
   BytesUsed = 1;
   CurBuffer[0] = '0';  // Start out with a \0 for cleanliness.
+
+  ++NumBuffers;
+  TotalBufferBytes += RequestLen;
+}
+
+void ScratchBuffer::PrintStats() const {
+  llvm::errs() << NumTokens << " tokens formed in scratch space, "
+               << NumSharedTokens << " sharing an earlier spelling.\n";
+  llvm::errs() << NumBuffers << " scratch buffers allocated, "
+               << TotalBufferBytes << " bytes.\n";
+  if (ShareSpellings)
+    llvm::errs() << Spellings.size() << " distinct spellings, "
+                 << SpellingMapBytes << " bytes in the sharing table.\n";
 }
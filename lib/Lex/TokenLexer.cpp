@@ -700,16 +700,20 @@ static void updateConsecutiveMacroArgTokens(SourceManager &SM,
   // we can perform this "merge" since the token's spelling location depends
   // on the relative offset.
 
+  // The gap is measured from the end of the previous token, so that a long
+  // token, like the format string of a logging macro, does not end the run.
   Token *NextTok = begin_tokens + 1;
+  unsigned CurLength = begin_tokens->getLength();
   for (; NextTok < end_tokens; ++NextTok) {
     int RelOffs;
     if (!SM.isInSameSLocAddrSpace(CurLoc, NextTok->getLocation(), &RelOffs))
       break; // Token from different local/loaded location.
     // Check that token is not before the previous token or more than 50
-    // "characters" away.
-    if (RelOffs < 0 || RelOffs > 50)
+    // "characters" past its end.
+    if (RelOffs < 0 || unsigned(RelOffs) > CurLength + 50)
       break;
     CurLoc = NextTok->getLocation();
+    CurLength = NextTok->getLength();
   }
 
   // For the consecutive tokens, find the length of the SLocEntry to contain
@@ -53,7 +53,8 @@ void clang::ParseAST(Preprocessor &PP, ASTConsumer *Consumer,
   ParseAST(*S.get(), PrintStats, SkipFunctionBodies);
 }
 
-void clang::ParseAST(Sema &S, bool PrintStats, bool SkipFunctionBodies) {
+void clang::ParseAST(Sema &S, bool PrintStats, bool SkipFunctionBodies,
+                     bool SkipFunctionBodiesOutsideMainFile) {
   // Collect global stats on Decls/Stmts (until we have a module streamer).
   if (PrintStats) {
     Decl::EnableStatistics();
@@ -67,7 +68,8 @@ void clang::ParseAST(Sema &S, bool PrintStats, bool SkipFunctionBodies) {
   ASTConsumer *Consumer = &S.getASTConsumer();
 
   OwningPtr<Parser> ParseOP(new Parser(S.getPreprocessor(), S,
-                                       SkipFunctionBodies));
+                                       SkipFunctionBodies,
+                                       SkipFunctionBodiesOutsideMainFile));
   Parser &P = *ParseOP.get();
 
   PrettyStackTraceParserEntry CrashInfo(P);
@@ -93,6 +95,12 @@ void clang::ParseAST(Sema &S, bool PrintStats, bool SkipFunctionBodies) {
     if (!External && !S.getLangOpts().CPlusPlus)
       P.Diag(diag::ext_empty_translation_unit);
   } else {
+    // FIXME: The consumer runs on this thread, between top-level
+    // declarations, and cannot be moved to one of its own. While the
+    // parser continues, Sema keeps changing the declarations already
+    // handed over: for example, it marks them used, adds redeclarations
+    // and instantiates templates. CodeGen in turn creates types in the
+    // shared ASTContext, whose uniquing tables take no locks.
     do {
       // If we got a null return and something *was* parsed, ignore it.  This
       // is due to a top-level semicolon, an action override, or a parse error
@@ -113,6 +121,7 @@ void clang::ParseAST(Sema &S, bool PrintStats, bool SkipFunctionBodies) {
   std::swap(OldCollectStats, S.CollectStats);
   if (PrintStats) {
     llvm::errs() << "\nSTATISTICS:\n";
+    P.PrintStats();
     P.getActions().PrintStats();
     S.getASTContext().PrintStats();
     Decl::PrintStats();
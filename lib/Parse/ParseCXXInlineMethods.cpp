@@ -15,6 +15,7 @@
 #include "clang/Parse/Parser.h"
 #include "clang/Sema/DeclSpec.h"
 #include "clang/Sema/Scope.h"
+#include "clang/AST/Attr.h"
 #include "clang/AST/DeclTemplate.h"
 #include "RAIIObjectsForParser.h"
 using namespace clang;
@@ -108,7 +109,8 @@ Decl *Parser::ParseCXXInlineMethodDef(AccessSpecifier AS,
   // In delayed template parsing mode, if we are within a class template
   // or if we are about to parse function member template then consume
   // the tokens and store them for parsing at the end of the translation unit.
-  if (getLangOpts().DelayedTemplateParsing && 
+  if ((getLangOpts().DelayedTemplateParsing ||
+       shouldDelayTemplateFunctionBody(D.getDeclSpec())) &&
       DefinitionKind == FDK_Definition && 
       ((Actions.CurContext->isDependentContext() ||
         TemplateInfo.Kind != ParsedTemplateInfo::NonTemplate) && 
@@ -375,7 +377,38 @@ void Parser::ParseLexedMethodDefs(ParsingClass &Class) {
   }
 }
 
+/// \brief With -flazy-inline-method-parsing, store the tokens of an inline
+/// member function body so that it is only parsed at the end of the
+/// translation unit, if the function turns out to be used.
+///
+/// \returns true if the body was stored rather than parsed.
+bool Parser::tryDelayingLexedMethodDef(LexedMethod &LM) {
+  if (!getLangOpts().LazyInlineMethodParsing || LM.TemplateScope ||
+      Actions.TUKind != TU_Complete || PP.isCodeCompletionEnabled())
+    return false;
+
+  // Friend functions and the members of templates and of local classes are
+  // always parsed.
+  CXXMethodDecl *MD = dyn_cast_or_null<CXXMethodDecl>(LM.D);
+  if (!MD || MD->isDependentContext() || MD->getParent()->isLocalClass())
+    return false;
+
+  // Constant expressions may call a constexpr function, and CodeGen needs the
+  // body of a function which is already used or marked 'used'.
+  if (MD->isConstexpr() || MD->isUsed(false) || MD->hasAttr<UsedAttr>())
+    return false;
+
+  LateParsedTemplatedFunction *LPT = new LateParsedTemplatedFunction(MD);
+  LPT->Toks.swap(LM.Toks);
+  LateParsedTemplateMap[MD] = LPT;
+  Actions.MarkAsLateParsedTemplate(MD);
+  return true;
+}
+
 void Parser::ParseLexedMethodDef(LexedMethod &LM) {
+  if (tryDelayingLexedMethodDef(LM))
+    return;
+
   // If this is a member template, introduce the template parameter scope.
   ParseScope TemplateScope(this, Scope::TemplateParamScope, LM.TemplateScope);
   if (LM.TemplateScope)
@@ -15,6 +15,7 @@
 #include "clang/Parse/ParseDiagnostic.h"
 #include "clang/Parse/Parser.h"
 #include "clang/Lex/Preprocessor.h"
+#include "llvm/ADT/StringSwitch.h"
 using namespace clang;
 
 /// \brief Handle the annotation token produced for #pragma unused(...)
@@ -54,6 +55,32 @@ void Parser::HandlePragmaPack() {
                           Info->LParenLoc, Info->RParenLoc);
 }
 
+struct PragmaLoopHintInfo {
+  IdentifierInfo *PragmaName;
+  IdentifierInfo *PragmaNamespace;
+  IdentifierInfo *Option;
+  SourceLocation OptionLoc;
+  Expr *Value;
+  SourceLocation RParenLoc;
+};
+
+void Parser::HandlePragmaLoopHint(ParsedAttributesWithRange &Hints) {
+  assert(Tok.is(tok::annot_pragma_loop_hint));
+  PragmaLoopHintInfo *Info =
+    static_cast<PragmaLoopHintInfo *>(Tok.getAnnotationValue());
+  SourceLocation PragmaLoc = ConsumeToken();
+
+  // The hint is located at its option, which need not be the first of the
+  // directive.
+  Expr *Value = Info->Value;
+  Hints.addNew(Info->PragmaName, SourceRange(Info->OptionLoc, Info->RParenLoc),
+               Info->PragmaNamespace, PragmaLoc, Info->Option,
+               Info->OptionLoc, &Value, 1, AttributeList::AS_Pragma);
+  if (Hints.Range.isInvalid())
+    Hints.Range.setBegin(PragmaLoc);
+  Hints.Range.setEnd(Info->RParenLoc);
+}
+
 // #pragma GCC visibility comes in two variants:
 //   'push' '(' [visibility] ')'
 //   'pop'
@@ -566,3 +593,105 @@ PragmaOpenCLExtensionHandler::HandlePragma(Preprocessor &PP,
   }
 }
 
+
+// #pragma clang loop gives one or more hints for the loop which follows:
+//   'vectorize' '(' ('enable' | 'disable') ')'
+//   'vectorize_width' '(' integer ')'
+//   'interleave_count' '(' integer ')'
+//   'unroll' '(' ('enable' | 'disable') ')'
+//   'unroll_count' '(' integer ')'
+// Sema checks that the integers make sense and that a loop follows.
+void PragmaLoopHintHandler::HandlePragma(Preprocessor &PP,
+                                         PragmaIntroducerKind Introducer,
+                                         Token &LoopTok) {
+  enum { UnknownOption, StateOption, IntegerOption };
+
+  SmallVector<PragmaLoopHintInfo, 4> Hints;
+  Token Tok;
+  PP.Lex(Tok);
+  do {
+    IdentifierInfo *Option = Tok.getIdentifierInfo();
+    if (!Option) {
+      PP.Diag(Tok.getLocation(), diag::warn_pragma_expected_identifier)
+        << "clang loop";
+      return;
+    }
+    int OptionKind = llvm::StringSwitch<int>(Option->getName())
+      .Cases("vectorize", "unroll", StateOption)
+      .Cases("vectorize_width", "interleave_count", "unroll_count",
+             IntegerOption)
+      .Default(UnknownOption);
+    if (OptionKind == UnknownOption) {
+      PP.Diag(Tok.getLocation(), diag::warn_pragma_loop_invalid_option)
+        << Option->getName();
+      return;
+    }
+    SourceLocation OptionLoc = Tok.getLocation();
+
+    PP.Lex(Tok);
+    if (Tok.isNot(tok::l_paren)) {
+      PP.Diag(Tok.getLocation(), diag::warn_pragma_expected_lparen)
+        << "clang loop";
+      return;
+    }
+
+    PP.Lex(Tok);
+    ExprResult Value;
+    if (OptionKind == StateOption) {
+      IdentifierInfo *State = Tok.getIdentifierInfo();
+      if (!State || !(State->isStr("enable") || State->isStr("disable"))) {
+        PP.Diag(Tok.getLocation(), diag::warn_pragma_expected_enable_disable);
+        return;
+      }
+      Value = Actions.ActOnIntegerConstant(Tok.getLocation(),
+                                           State->isStr("enable"));
+    } else {
+      if (Tok.isNot(tok::numeric_constant)) {
+        PP.Diag(Tok.getLocation(), diag::warn_pragma_loop_expected_integer)
+          << Option->getName();
+        return;
+      }
+      Value = Actions.ActOnNumericConstant(Tok);
+      if (Value.isInvalid())
+        return;
+    }
+
+    PP.Lex(Tok);
+    if (Tok.isNot(tok::r_paren)) {
+      PP.Diag(Tok.getLocation(), diag::warn_pragma_expected_rparen)
+        << "clang loop";
+      return;
+    }
+
+    PragmaLoopHintInfo Hint;
+    Hint.PragmaName = LoopTok.getIdentifierInfo();
+    Hint.PragmaNamespace = PP.getIdentifierInfo("clang");
+    Hint.Option = Option;
+    Hint.OptionLoc = OptionLoc;
+    Hint.Value = Value.release();
+    Hint.RParenLoc = Tok.getLocation();
+    Hints.push_back(Hint);
+
+    PP.Lex(Tok);
+  } while (Tok.isNot(tok::eod));
+
+  // Each option becomes an annotation token of its own.
+  unsigned NumHints = Hints.size();
+  PragmaLoopHintInfo *Infos =
+    (PragmaLoopHintInfo*) PP.getPreprocessorAllocator().Allocate(
+      sizeof(PragmaLoopHintInfo) * NumHints,
+      llvm::alignOf<PragmaLoopHintInfo>());
+  Token *Toks =
+    (Token*) PP.getPreprocessorAllocator().Allocate(
+      sizeof(Token) * NumHints, llvm::alignOf<Token>());
+  for (unsigned I = 0; I != NumHints; ++I) {
+    new (&Infos[I]) PragmaLoopHintInfo(Hints[I]);
+    new (&Toks[I]) Token();
+    Toks[I].startToken();
+    Toks[I].setKind(tok::annot_pragma_loop_hint);
+    Toks[I].setLocation(LoopTok.getLocation());
+    Toks[I].setAnnotationValue(static_cast<void*>(&Infos[I]));
+  }
+  PP.EnterTokenStream(Toks, NumHints, /*DisableMacroExpansion=*/true,
+                      /*OwnsTokens=*/false);
+}
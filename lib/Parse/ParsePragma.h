@@ -115,6 +115,16 @@ public:
   virtual void HandlePragma(Preprocessor &PP, PragmaIntroducerKind Introducer,
                             Token &FirstToken);
 };
+
+class PragmaLoopHintHandler : public PragmaHandler {
+  Sema &Actions;
+public:
+  explicit PragmaLoopHintHandler(Sema &A)
+    : PragmaHandler("loop"), Actions(A) {}
+
+  virtual void HandlePragma(Preprocessor &PP, PragmaIntroducerKind Introducer,
+                            Token &FirstToken);
+};
   
 
 }  // end namespace clang
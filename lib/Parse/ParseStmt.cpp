@@ -18,6 +18,7 @@
 #include "clang/Sema/PrettyDeclStackTrace.h"
 #include "clang/Sema/Scope.h"
 #include "clang/Sema/TypoCorrection.h"
+#include "clang/AST/DeclTemplate.h"
 #include "clang/Basic/Diagnostic.h"
 #include "clang/Basic/PrettyStackTrace.h"
 #include "clang/Basic/SourceManager.h"
@@ -253,6 +254,10 @@ Retry:
     ProhibitAttributes(Attrs);
     HandlePragmaPack();
     return StmtEmpty();
+
+  case tok::annot_pragma_loop_hint:
+    ProhibitAttributes(Attrs);
+    return ParsePragmaLoopHint(Stmts, OnlyStatement, TrailingElseLoc, Attrs);
   }
 
   // If we reached this code, the statement must end in a semicolon.
@@ -270,6 +275,34 @@ Retry:
   return Res;
 }
 
+/// ParsePragmaLoopHint - Parse the statement which follows one or more
+/// '#pragma clang loop' directives. Their hints are added to the attributes
+/// of the statement, which Sema checks to be a loop.
+StmtResult Parser::ParsePragmaLoopHint(StmtVector &Stmts, bool OnlyStatement,
+                                       SourceLocation *TrailingElseLoc,
+                                       ParsedAttributesWithRange &Attrs) {
+  ParsedAttributesWithRange Hints(AttrFactory);
+  while (Tok.is(tok::annot_pragma_loop_hint))
+    HandlePragmaLoopHint(Hints);
+
+  MaybeParseCXX0XAttributes(Attrs, 0, /*MightBeObjCMessageSend*/ true);
+
+  StmtResult S = ParseStatementOrDeclarationAfterAttributes(Stmts,
+                                 OnlyStatement, TrailingElseLoc, Attrs);
+  if (S.isInvalid())
+    return S;
+  if (!S.isUsable()) {
+    Diag(Hints.Range.getBegin(), diag::err_pragma_loop_precedes_nonloop);
+    return S;
+  }
+
+  SourceRange Range(Hints.Range.getBegin(), Attrs.Range.isValid() ?
+                    Attrs.Range.getEnd() : Hints.Range.getEnd());
+  Attrs.takeAllFrom(Hints);
+  Attrs.Range = Range;
+  return S;
+}
+
 /// \brief Parse an expression statement.
 StmtResult Parser::ParseExprStatement() {
   // If a case keyword is missing, this is where it should be inserted.
@@ -1917,7 +1950,7 @@ Decl *Parser::ParseFunctionStatementBody(Decl *Decl, ParseScope &BodyScope) {
   assert(Tok.is(tok::l_brace));
   SourceLocation LBraceLoc = Tok.getLocation();
 
-  if (SkipFunctionBodies && trySkippingFunctionBody()) {
+  if (shouldSkipFunctionBody(Decl) && trySkippingFunctionBody()) {
     BodyScope.Exit();
     return Actions.ActOnFinishFunctionBody(Decl, 0);
   }
@@ -1959,7 +1992,7 @@ Decl *Parser::ParseFunctionTryBlock(Decl *Decl, ParseScope &BodyScope) {
   else
     Actions.ActOnDefaultCtorInitializers(Decl);
 
-  if (SkipFunctionBodies && trySkippingFunctionBody()) {
+  if (shouldSkipFunctionBody(Decl) && trySkippingFunctionBody()) {
     BodyScope.Exit();
     return Actions.ActOnFinishFunctionBody(Decl, 0);
   }
@@ -1980,11 +2013,11 @@ Decl *Parser::ParseFunctionTryBlock(Decl *Decl, ParseScope &BodyScope) {
 
 bool Parser::trySkippingFunctionBody() {
   assert(Tok.is(tok::l_brace));
-  assert(SkipFunctionBodies &&
+  assert((SkipFunctionBodies || SkipFunctionBodiesOutsideMainFile) &&
          "Should only be called when SkipFunctionBodies is enabled");
 
-  // We're in code-completion mode. Skip parsing for all function bodies unless
-  // the body contains the code-completion point.
+  // Skip parsing for all function bodies unless the body contains the
+  // code-completion point.
   TentativeParsingAction PA(*this);
   ConsumeBrace();
   if (SkipUntil(tok::r_brace, /*StopAtSemi=*/false, /*DontConsume=*/false,
@@ -1997,6 +2030,34 @@ bool Parser::trySkippingFunctionBody() {
   return false;
 }
 
+bool Parser::shouldSkipFunctionBody(Decl *D) {
+  if (SkipFunctionBodies)
+    return true;
+  if (!SkipFunctionBodiesOutsideMainFile)
+    return false;
+
+  SourceManager &SM = PP.getSourceManager();
+  if (SM.isFromMainFile(SM.getExpansionLoc(Tok.getLocation())))
+    return false;
+
+  FunctionDecl *FD = dyn_cast_or_null<FunctionDecl>(D);
+  if (FunctionTemplateDecl *FunTmpl
+        = dyn_cast_or_null<FunctionTemplateDecl>(D))
+    FD = FunTmpl->getTemplatedDecl();
+
+  // A body which was stored to be parsed on demand is now needed. The main
+  // file may also use a constexpr function in a constant expression.
+  return !FD || (!FD->isLateTemplateParsed() && !FD->isConstexpr());
+}
+
+bool Parser::shouldDelayTemplateFunctionBody(const DeclSpec &DS) {
+  if (!SkipFunctionBodiesOutsideMainFile || DS.isConstexprSpecified())
+    return false;
+
+  SourceManager &SM = PP.getSourceManager();
+  return !SM.isFromMainFile(SM.getExpansionLoc(Tok.getLocation()));
+}
+
 /// ParseCXXTryBlock - Parse a C++ try-block.
 ///
 ///       try-block:
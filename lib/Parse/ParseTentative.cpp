@@ -119,8 +119,17 @@ bool Parser::isCXXSimpleDeclaration(bool AllowForRangeDecl) {
   if (InvalidAsDeclaration)
     return false;
 
-  // FIXME: Add statistics about the number of ambiguous statements encountered
-  // and how they were resolved (number of declarations+number of expressions).
+  // 'T(1)' and the like are function-style casts, whatever follows them.
+  if (isCXXFunctionStyleCastSimple(/*AllowEmptyParens=*/true)) {
+    ++NumSimpleDisambiguations;
+    return false;
+  }
+
+  DisambiguationKind Kind =
+    AllowForRangeDecl ? DK_ForRangeDeclaration : DK_SimpleDeclaration;
+  bool Result;
+  if (lookupDisambiguation(Kind, Result))
+    return Result;
 
   // Ok, we have a simple-type-specifier/typename-specifier followed by a '(',
   // or an identifier which doesn't resolve as anything. We need tentative
@@ -132,14 +141,16 @@ bool Parser::isCXXSimpleDeclaration(bool AllowForRangeDecl) {
 
   // In case of an error, let the declaration parsing code handle it.
   if (TPR == TPResult::Error())
-    return true;
+    TPR = TPResult::True();
 
   // Declarations take precedence over expressions.
   if (TPR == TPResult::Ambiguous())
     TPR = TPResult::True();
 
   assert(TPR == TPResult::True() || TPR == TPResult::False());
-  return TPR == TPResult::True();
+  Result = TPR == TPResult::True();
+  memoizeDisambiguation(Kind, Result);
+  return Result;
 }
 
 /// simple-declaration:
@@ -263,8 +274,14 @@ bool Parser::isCXXConditionDeclaration() {
     return TPR != TPResult::False(); // Returns true for TPResult::True() or
                                      // TPResult::Error().
 
-  // FIXME: Add statistics about the number of ambiguous statements encountered
-  // and how they were resolved (number of declarations+number of expressions).
+  if (isCXXFunctionStyleCastSimple(/*AllowEmptyParens=*/true)) {
+    ++NumSimpleDisambiguations;
+    return false;
+  }
+
+  bool Result;
+  if (lookupDisambiguation(DK_ConditionDeclaration, Result))
+    return Result;
 
   // Ok, we have a simple-type-specifier/typename-specifier followed by a '('.
   // We need tentative parsing...
@@ -304,7 +321,9 @@ bool Parser::isCXXConditionDeclaration() {
   PA.Revert();
 
   assert(TPR == TPResult::True() || TPR == TPResult::False());
-  return TPR == TPResult::True();
+  Result = TPR == TPResult::True();
+  memoizeDisambiguation(DK_ConditionDeclaration, Result);
+  return Result;
 }
 
   /// \brief Determine whether the next set of tokens contains a type-id.
@@ -340,8 +359,17 @@ bool Parser::isCXXTypeId(TentativeCXXTypeIdContext Context, bool &isAmbiguous) {
     return TPR != TPResult::False(); // Returns true for TPResult::True() or
                                      // TPResult::Error().
 
-  // FIXME: Add statistics about the number of ambiguous statements encountered
-  // and how they were resolved (number of declarations+number of expressions).
+  // 'T()' is a function type, but 'T(1)' is a function-style cast.
+  if (isCXXFunctionStyleCastSimple(/*AllowEmptyParens=*/false)) {
+    ++NumSimpleDisambiguations;
+    return false;
+  }
+
+  DisambiguationKind Kind = Context == TypeIdInParens
+    ? DK_TypeIdInParens : DK_TypeIdAsTemplateArgument;
+  bool Result;
+  if (lookupDisambiguation(Kind, Result, &isAmbiguous))
+    return Result;
 
   // Ok, we have a simple-type-specifier/typename-specifier followed by a '('.
   // We need tentative parsing...
@@ -390,7 +418,9 @@ bool Parser::isCXXTypeId(TentativeCXXTypeIdContext Context, bool &isAmbiguous) {
   PA.Revert();
 
   assert(TPR == TPResult::True() || TPR == TPResult::False());
-  return TPR == TPResult::True();
+  Result = TPR == TPResult::True();
+  memoizeDisambiguation(Kind, Result, isAmbiguous);
+  return Result;
 }
 
 /// \brief Returns true if this is a C++11 attribute-specifier. Per
@@ -845,6 +875,72 @@ Parser::isExpressionOrTypeSpecifierSimple(tok::TokenKind Kind) {
   return TPResult::Ambiguous();
 }
 
+bool Parser::isExpressionOnlyAfterParen(const Token &Next) {
+  switch (Next.getKind()) {
+  // These start ptr-operators, declarators in parentheses and attributes.
+  case tok::amp:
+  case tok::ampamp:
+  case tok::star:
+  case tok::l_paren:
+  case tok::l_square:
+    return false;
+
+  default:
+    return isExpressionOrTypeSpecifierSimple(Next.getKind()) ==
+             TPResult::True();
+  }
+}
+
+bool Parser::isCXXFunctionStyleCastSimple(bool AllowEmptyParens) {
+  if (Tok.is(tok::kw_typeof))
+    return false;
+
+  unsigned ParenIndex = Tok.is(tok::annot_cxxscope) ? 2 : 1;
+  if (GetLookAheadToken(ParenIndex).isNot(tok::l_paren))
+    return false;
+
+  const Token &Next = GetLookAheadToken(ParenIndex + 1);
+  if (Next.is(tok::r_paren))
+    return AllowEmptyParens;
+  return isExpressionOnlyAfterParen(Next);
+}
+
+bool Parser::lookupDisambiguation(DisambiguationKind Kind, bool &Result,
+                                  bool *IsAmbiguous) {
+  if (Tok.getLocation().isInvalid())
+    return false;
+
+  llvm::DenseMap<std::pair<unsigned, unsigned>,
+                 MemoizedDisambiguation>::const_iterator Known
+    = DisambiguationCache.find(
+        std::make_pair(Tok.getLocation().getRawEncoding(), unsigned(Kind)));
+  if (Known == DisambiguationCache.end() ||
+      Known->second.Generation != Actions.IdResolver.getGeneration() ||
+      Known->second.NumTentativelyDeclared !=
+        TentativelyDeclaredIdentifiers.size())
+    return false;
+
+  ++NumMemoizedDisambiguations;
+  Result = Known->second.Result;
+  if (IsAmbiguous)
+    *IsAmbiguous = Known->second.IsAmbiguous;
+  return true;
+}
+
+void Parser::memoizeDisambiguation(DisambiguationKind Kind, bool Result,
+                                   bool IsAmbiguous) {
+  ++NumTentativeDisambiguations;
+  if (Tok.getLocation().isInvalid())
+    return;
+
+  MemoizedDisambiguation &Entry = DisambiguationCache[
+      std::make_pair(Tok.getLocation().getRawEncoding(), unsigned(Kind))];
+  Entry.Generation = Actions.IdResolver.getGeneration();
+  Entry.NumTentativelyDeclared = TentativelyDeclaredIdentifiers.size();
+  Entry.Result = Result;
+  Entry.IsAmbiguous = IsAmbiguous;
+}
+
 bool Parser::isTentativelyDeclared(IdentifierInfo *II) {
   return std::find(TentativelyDeclaredIdentifiers.begin(),
                    TentativelyDeclaredIdentifiers.end(), II)
@@ -1372,39 +1468,100 @@ bool Parser::isCXXFunctionDeclarator(bool *IsAmbiguous) {
   // ambiguities mentioned in 6.8, the resolution is to consider any construct
   // that could possibly be a declaration a declaration.
 
-  TentativeParsingAction PA(*this);
+  bool Result, FoundAmbiguity = false;
+  TPResult TPR = isCXXFunctionDeclaratorSimple(FoundAmbiguity);
+  if (TPR != TPResult::Ambiguous()) {
+    ++NumSimpleDisambiguations;
+    Result = TPR == TPResult::True();
+  } else if (!lookupDisambiguation(DK_FunctionDeclarator, Result,
+                                   &FoundAmbiguity)) {
+    TentativeParsingAction PA(*this);
 
-  ConsumeParen();
-  bool InvalidAsDeclaration = false;
-  TPResult TPR = TryParseParameterDeclarationClause(&InvalidAsDeclaration);
-  if (TPR == TPResult::Ambiguous()) {
-    if (Tok.isNot(tok::r_paren))
-      TPR = TPResult::False();
-    else {
-      const Token &Next = NextToken();
-      if (Next.is(tok::amp) || Next.is(tok::ampamp) ||
-          Next.is(tok::kw_const) || Next.is(tok::kw_volatile) ||
-          Next.is(tok::kw_throw) || Next.is(tok::kw_noexcept) ||
-          Next.is(tok::l_square) || isCXX0XVirtSpecifier(Next) ||
-          Next.is(tok::l_brace) || Next.is(tok::kw_try) ||
-          Next.is(tok::equal) || Next.is(tok::arrow))
-        // The next token cannot appear after a constructor-style initializer,
-        // and can appear next in a function definition. This must be a function
-        // declarator.
+    ConsumeParen();
+    bool InvalidAsDeclaration = false;
+    TPR = TryParseParameterDeclarationClause(&InvalidAsDeclaration);
+    if (TPR == TPResult::Ambiguous()) {
+      if (Tok.isNot(tok::r_paren))
+        TPR = TPResult::False();
+      else if (isCXXFunctionDeclaratorSuffix(NextToken()))
         TPR = TPResult::True();
       else if (InvalidAsDeclaration)
         // Use the absence of 'typename' as a tie-breaker.
         TPR = TPResult::False();
     }
-  }
 
-  PA.Revert();
+    PA.Revert();
+
+    FoundAmbiguity = TPR == TPResult::Ambiguous();
 
-  if (IsAmbiguous && TPR == TPResult::Ambiguous())
+    // In case of an error, let the declaration parsing code handle it.
+    Result = TPR != TPResult::False();
+    memoizeDisambiguation(DK_FunctionDeclarator, Result, FoundAmbiguity);
+  }
+
+  if (IsAmbiguous && FoundAmbiguity)
     *IsAmbiguous = true;
 
-  // In case of an error, let the declaration parsing code handle it.
-  return TPR != TPResult::False();
+  return Result;
+}
+
+bool Parser::isCXXFunctionDeclaratorSuffix(const Token &Next) {
+  // The next token cannot appear after a constructor-style initializer,
+  // and can appear next in a function definition. This must be a function
+  // declarator.
+  return Next.is(tok::amp) || Next.is(tok::ampamp) ||
+         Next.is(tok::kw_const) || Next.is(tok::kw_volatile) ||
+         Next.is(tok::kw_throw) || Next.is(tok::kw_noexcept) ||
+         Next.is(tok::l_square) || isCXX0XVirtSpecifier(Next) ||
+         Next.is(tok::l_brace) || Next.is(tok::kw_try) ||
+         Next.is(tok::equal) || Next.is(tok::arrow);
+}
+
+Parser::TPResult Parser::isCXXFunctionDeclaratorSimple(bool &IsAmbiguous) {
+  assert(Tok.is(tok::l_paren) && "Expected '('");
+  const Token &Next = NextToken();
+  switch (Next.getKind()) {
+  case tok::r_paren:
+    // '()' is an empty parameter-declaration-clause; unless what follows can
+    // only follow a function declarator, this is the "most vexing parse".
+    if (!isCXXFunctionDeclaratorSuffix(GetLookAheadToken(2)))
+      IsAmbiguous = true;
+    return TPResult::True();
+
+  case tok::kw_const:
+  case tok::kw_volatile:
+    return TPResult::True();
+
+  case tok::kw_char:
+  case tok::kw_wchar_t:
+  case tok::kw_char16_t:
+  case tok::kw_char32_t:
+  case tok::kw_bool:
+  case tok::kw_short:
+  case tok::kw_int:
+  case tok::kw_long:
+  case tok::kw___int64:
+  case tok::kw___int128:
+  case tok::kw_signed:
+  case tok::kw_unsigned:
+  case tok::kw_half:
+  case tok::kw_float:
+  case tok::kw_double:
+  case tok::kw_void: {
+    // A simple-type-specifier which is not followed by a '(' or a '{' starts
+    // a parameter-declaration, as in isCXXDeclarationSpecifier.
+    const Token &AfterNext = GetLookAheadToken(2);
+    if (AfterNext.is(tok::l_paren) || AfterNext.is(tok::l_brace) ||
+        getLangOpts().ObjC1)
+      return TPResult::Ambiguous();
+    return TPResult::True();
+  }
+
+  default:
+    if (isExpressionOnlyAfterParen(Next))
+      return TPResult::False();
+    return TPResult::Ambiguous();
+  }
 }
 
 /// parameter-declaration-clause:
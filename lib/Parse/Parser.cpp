@@ -47,11 +47,15 @@ IdentifierInfo *Parser::getSEHExceptKeyword() {
   return Ident__except;
 }
 
-Parser::Parser(Preprocessor &pp, Sema &actions, bool SkipFunctionBodies)
+Parser::Parser(Preprocessor &pp, Sema &actions, bool SkipFunctionBodies,
+               bool SkipFunctionBodiesOutsideMainFile)
   : PP(pp), Actions(actions), Diags(PP.getDiagnostics()),
     GreaterThanIsOperator(true), ColonIsSacred(false), 
     InMessageExpression(false), TemplateParameterDepth(0),
-    ParsingInObjCContainer(false), SkipFunctionBodies(SkipFunctionBodies) {
+    ParsingInObjCContainer(false), SkipFunctionBodies(SkipFunctionBodies),
+    SkipFunctionBodiesOutsideMainFile(SkipFunctionBodiesOutsideMainFile),
+    NumTentativeDisambiguations(0), NumSimpleDisambiguations(0),
+    NumMemoizedDisambiguations(0) {
   Tok.setKind(tok::eof);
   Actions.CurScope = 0;
   NumCachedScopes = 0;
@@ -87,6 +91,9 @@ Parser::Parser(Preprocessor &pp, Sema &actions, bool SkipFunctionBodies)
   FPContractHandler.reset(new PragmaFPContractHandler(actions));
   PP.AddPragmaHandler("STDC", FPContractHandler.get());
 
+  LoopHintHandler.reset(new PragmaLoopHintHandler(actions));
+  PP.AddPragmaHandler("clang", LoopHintHandler.get());
+
   if (getLangOpts().OpenCL) {
     OpenCLExtensionHandler.reset(new PragmaOpenCLExtensionHandler(actions));
     PP.AddPragmaHandler("OPENCL", OpenCLExtensionHandler.get());
@@ -450,6 +457,8 @@ Parser::~Parser() {
 
   PP.RemovePragmaHandler("STDC", FPContractHandler.get());
   FPContractHandler.reset();
+  PP.RemovePragmaHandler("clang", LoopHintHandler.get());
+  LoopHintHandler.reset();
 
   PP.removeCommentHandler(CommentSemaHandler.get());
 
@@ -458,6 +467,17 @@ Parser::~Parser() {
   assert(TemplateIds.empty() && "Still alive TemplateIdAnnotations around?");
 }
 
+/// \brief Print out statistics about the parser.
+void Parser::PrintStats() const {
+  llvm::errs() << "\n*** Parser Stats:\n";
+  llvm::errs() << NumTentativeDisambiguations
+               << " ambiguities resolved by tentative parsing, "
+               << NumSimpleDisambiguations << " by lookahead, "
+               << NumMemoizedDisambiguations << " from memoized results.\n";
+
+  AttrFactory.PrintStats();
+}
+
 /// Initialize - Warm up the parser.
 ///
 void Parser::Initialize() {
@@ -543,11 +563,28 @@ namespace {
       Container.clear();
     }
   };
+
+  /// \brief RAIIObject to release the declaration storage of an
+  /// AttributeFactory once an external declaration has been parsed.
+  class ResetDeclStorageRAIIObj {
+    AttributeFactory &Factory;
+    bool Enabled;
+  public:
+    ResetDeclStorageRAIIObj(AttributeFactory &Factory, bool Enabled)
+      : Factory(Factory), Enabled(Enabled) {}
+
+    ~ResetDeclStorageRAIIObj() {
+      if (Enabled)
+        Factory.resetDeclStorage();
+    }
+  };
 }
 
 /// ParseTopLevelDecl - Parse one top-level declaration, return whatever the
 /// action tells us to.  This returns true if the EOF was encountered.
 bool Parser::ParseTopLevelDecl(DeclGroupPtrTy &Result) {
+  DisambiguationCache.clear();
+
   DestroyTemplateIdAnnotationsRAIIObj CleanupRAII(TemplateIds);
 
   // Skip over the EOF token, flagging end of previous input for incremental 
@@ -561,7 +598,8 @@ bool Parser::ParseTopLevelDecl(DeclGroupPtrTy &Result) {
   Result = DeclGroupPtrTy();
   if (Tok.is(tok::eof)) {
     // Late template parsing can begin.
-    if (getLangOpts().DelayedTemplateParsing)
+    if (getLangOpts().DelayedTemplateParsing ||
+        !LateParsedTemplateMap.empty())
       Actions.SetLateTemplateParser(LateTemplateParserCallback, this);
     if (!PP.isIncrementalProcessingEnabled())
       Actions.ActOnEndOfTranslationUnit();
@@ -618,6 +656,11 @@ void Parser::ParseTranslationUnit() {
 Parser::DeclGroupPtrTy
 Parser::ParseExternalDeclaration(ParsedAttributesWithRange &attrs,
                                  ParsingDeclSpec *DS) {
+  // Once the declaration is parsed, nothing refers to its declarator chunks
+  // or template-id annotations any more, so their storage is recycled, also
+  // for the declarations of namespaces and linkage specifications. The
+  // declaration spec of an enclosing linkage specification must survive.
+  ResetDeclStorageRAIIObj ResetStorageRAII(AttrFactory, DS == 0);
   DestroyTemplateIdAnnotationsRAIIObj CleanupRAII(TemplateIds);
   ParenBraceBracketBalancer BalancerRAIIObj(*this);
 
@@ -634,6 +677,10 @@ Parser::ParseExternalDeclaration(ParsedAttributesWithRange &attrs,
   case tok::annot_pragma_pack:
     HandlePragmaPack();
     return DeclGroupPtrTy();
+  case tok::annot_pragma_loop_hint:
+    Diag(Tok, diag::err_pragma_loop_precedes_nonloop);
+    ConsumeToken();
+    return DeclGroupPtrTy();
   case tok::semi:
     ConsumeExtraSemi(OutsideFunction);
     // TODO: Invoke action for top-level semicolon.
@@ -969,7 +1016,9 @@ Decl *Parser::ParseFunctionDefinition(ParsingDeclarator &D,
 
   // In delayed template parsing mode, for function template we consume the
   // tokens and store them for late parsing at the end of the translation unit.
-  if (getLangOpts().DelayedTemplateParsing &&
+  // A skipped body outside the main file is likewise only parsed on demand.
+  if ((getLangOpts().DelayedTemplateParsing ||
+       shouldDelayTemplateFunctionBody(D.getDeclSpec())) &&
       Tok.isNot(tok::equal) &&
       TemplateInfo.Kind == ParsedTemplateInfo::Template) {
     MultiTemplateParamsArg TemplateParameterLists(*TemplateInfo.TemplateParams);
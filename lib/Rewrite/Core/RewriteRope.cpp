@@ -216,6 +216,8 @@ namespace {
     /// node is returned and must be inserted into a parent.
     RopePieceBTreeNode *insert(unsigned Offset, const RopePiece &R);
 
+    /// insertPiece - Like insert, but always adds R as a piece of its own.
+    RopePieceBTreeNode *insertPiece(unsigned Offset, const RopePiece &R);
 
     /// erase - Remove NumBytes from this node at the specified offset.  We are
     /// guaranteed that there is a split at Offset.
@@ -266,7 +268,7 @@ RopePieceBTreeNode *RopePieceBTreeLeaf::split(unsigned Offset) {
   Pieces[i].EndOffs = Pieces[i].StartOffs+IntraPieceOffset;
   Size += Pieces[i].size();
 
-  return insert(Offset, Tail);
+  return insertPiece(Offset, Tail);
 }
 
 
@@ -277,6 +279,25 @@ RopePieceBTreeNode *RopePieceBTreeLeaf::split(unsigned Offset) {
 /// node is returned and must be inserted into a parent.
 RopePieceBTreeNode *RopePieceBTreeLeaf::insert(unsigned Offset,
                                                const RopePiece &R) {
+  // If R directly follows the piece ending at Offset in the same string, grow
+  // that piece instead of adding another one.  This is the common case for
+  // text inserted piecewise at an advancing offset, since RewriteRope copies
+  // consecutive insertions next to each other into its allocation buffer.
+  unsigned i = 0, SlotOffs = 0;
+  for (unsigned e = getNumPieces(); i != e && SlotOffs < Offset; ++i)
+    SlotOffs += getPiece(i).size();
+  if (i != 0 && SlotOffs == Offset && Pieces[i-1].StrData == R.StrData &&
+      Pieces[i-1].EndOffs == R.StartOffs) {
+    Pieces[i-1].EndOffs = R.EndOffs;
+    Size += R.size();
+    return 0;
+  }
+
+  return insertPiece(Offset, R);
+}
+
+RopePieceBTreeNode *RopePieceBTreeLeaf::insertPiece(unsigned Offset,
+                                                    const RopePiece &R) {
   // If this node is not full, insert the piece.
   if (!isFull()) {
     // Find the insertion point.  We are guaranteed that there is a split at the
@@ -328,9 +349,9 @@ RopePieceBTreeNode *RopePieceBTreeLeaf::insert(unsigned Offset,
 
   // These insertions can't fail.
   if (this->size() >= Offset)
-    this->insert(Offset, R);
+    this->insertPiece(Offset, R);
   else
-    NewNode->insert(Offset - this->size(), R);
+    NewNode->insertPiece(Offset - this->size(), R);
   return NewNode;
 }
 
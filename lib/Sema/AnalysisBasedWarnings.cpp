@@ -43,6 +43,7 @@
 #include "llvm/ADT/SmallVector.h"
 #include "llvm/ADT/StringRef.h"
 #include "llvm/Support/Casting.h"
+#include "llvm/Support/Timer.h"
 #include <algorithm>
 #include <iterator>
 #include <vector>
@@ -1169,6 +1170,34 @@ clang::sema::AnalysisBasedWarnings::AnalysisBasedWarnings(Sema &s)
 
 }
 
+struct clang::sema::AnalysisBasedWarnings::AnalysisTimers {
+  llvm::TimerGroup Group;
+  llvm::Timer CFGConstruction;
+  llvm::Timer UnreachableDiags;
+  llvm::Timer FallThrough;
+  llvm::Timer UnreachableCode;
+  llvm::Timer ThreadSafety;
+  llvm::Timer UninitializedValues;
+  llvm::Timer SwitchFallthrough;
+
+  AnalysisTimers()
+    : Group("Analysis-Based Warnings"),
+      CFGConstruction("CFG Construction", Group),
+      UnreachableDiags("Possibly Unreachable Diagnostics", Group),
+      FallThrough("Missing Return Analysis", Group),
+      UnreachableCode("Unreachable Code Analysis", Group),
+      ThreadSafety("Thread Safety Analysis", Group),
+      UninitializedValues("Uninitialized Values Analysis", Group),
+      SwitchFallthrough("Switch Fall-Through Analysis", Group) {}
+};
+
+clang::sema::AnalysisBasedWarnings::~AnalysisBasedWarnings() {}
+
+void clang::sema::AnalysisBasedWarnings::enableTimers() {
+  if (!Timers)
+    Timers.reset(new AnalysisTimers());
+}
+
 static void flushDiagnostics(Sema &S, sema::FunctionScopeInfo *fscope) {
   for (SmallVectorImpl<sema::PossiblyUnreachableDiag>::iterator
        i = fscope->PossiblyUnreachableDiags.begin(),
@@ -1211,7 +1240,22 @@ AnalysisBasedWarnings::IssueWarnings(sema::AnalysisBasedWarnings::Policy P,
   const Stmt *Body = D->getBody();
   assert(Body);
 
+  bool UninitDiag =
+      Diags.getDiagnosticLevel(diag::warn_uninit_var, D->getLocStart())
+      != DiagnosticsEngine::Ignored ||
+      Diags.getDiagnosticLevel(diag::warn_sometimes_uninit_var,D->getLocStart())
+      != DiagnosticsEngine::Ignored ||
+      Diags.getDiagnosticLevel(diag::warn_maybe_uninit_var, D->getLocStart())
+      != DiagnosticsEngine::Ignored;
+  bool FallThroughDiagFull =
+      Diags.getDiagnosticLevel(diag::warn_unannotated_fallthrough,
+                               D->getLocStart()) != DiagnosticsEngine::Ignored;
+  bool FallThroughDiagPerFunction =
+      Diags.getDiagnosticLevel(diag::warn_unannotated_fallthrough_per_function,
+                               D->getLocStart()) != DiagnosticsEngine::Ignored;
+
   AnalysisDeclContext AC(/* AnalysisDeclContextManager */ 0, D);
+  AnalysisTimers *T = Timers.get();
 
   // Don't generate EH edges for CallExprs as we'd like to avoid the n^2
   // explosion for destrutors that can result and the compile time hit.
@@ -1244,20 +1288,32 @@ AnalysisBasedWarnings::IssueWarnings(sema::AnalysisBasedWarnings::Policy P,
   }
 
   // Construct the analysis context with the specified CFG build options.
-  
+
+  // Register the expressions of the delayed diagnostics with the CFGBuilder.
+  for (SmallVectorImpl<sema::PossiblyUnreachableDiag>::iterator
+       i = fscope->PossiblyUnreachableDiags.begin(),
+       e = fscope->PossiblyUnreachableDiags.end();
+       i != e; ++i) {
+    if (const Stmt *stmt = i->stmt)
+      AC.registerForcedBlockExpression(stmt);
+  }
+
+  // All the analyses share the CFG of AC, which is built with the options
+  // they all need.  When timing, build it up front so that its cost is not
+  // charged to the first analysis that asks for it.
+  if (T &&
+      (!fscope->PossiblyUnreachableDiags.empty() || P.enableCheckFallThrough ||
+       P.enableCheckUnreachable || P.enableThreadSafetyAnalysis ||
+       UninitDiag || FallThroughDiagFull || FallThroughDiagPerFunction)) {
+    llvm::TimeRegion Region(&T->CFGConstruction);
+    AC.getCFG();
+  }
+
   // Emit delayed diagnostics.
   if (!fscope->PossiblyUnreachableDiags.empty()) {
+    llvm::TimeRegion Region(T ? &T->UnreachableDiags : 0);
     bool analyzed = false;
 
-    // Register the expressions with the CFGBuilder.
-    for (SmallVectorImpl<sema::PossiblyUnreachableDiag>::iterator
-         i = fscope->PossiblyUnreachableDiags.begin(),
-         e = fscope->PossiblyUnreachableDiags.end();
-         i != e; ++i) {
-      if (const Stmt *stmt = i->stmt)
-        AC.registerForcedBlockExpression(stmt);
-    }
-
     if (AC.getCFG()) {
       analyzed = true;
       for (SmallVectorImpl<sema::PossiblyUnreachableDiag>::iterator
@@ -1295,6 +1351,7 @@ AnalysisBasedWarnings::IssueWarnings(sema::AnalysisBasedWarnings::Policy P,
   
   // Warning: check missing 'return'
   if (P.enableCheckFallThrough) {
+    llvm::TimeRegion Region(T ? &T->FallThrough : 0);
     const CheckFallThroughDiagnostics &CD =
       (isa<BlockDecl>(D) ? CheckFallThroughDiagnostics::MakeForBlock()
        : (isa<CXXMethodDecl>(D) &&
@@ -1314,12 +1371,15 @@ AnalysisBasedWarnings::IssueWarnings(sema::AnalysisBasedWarnings::Policy P,
     bool isTemplateInstantiation = false;
     if (const FunctionDecl *Function = dyn_cast<FunctionDecl>(D))
       isTemplateInstantiation = Function->isTemplateInstantiation();
-    if (!isTemplateInstantiation)
+    if (!isTemplateInstantiation) {
+      llvm::TimeRegion Region(T ? &T->UnreachableCode : 0);
       CheckUnreachable(S, AC);
+    }
   }
 
   // Check for thread safety violations
   if (P.enableThreadSafetyAnalysis) {
+    llvm::TimeRegion Region(T ? &T->ThreadSafety : 0);
     SourceLocation FL = AC.getDecl()->getLocation();
     SourceLocation FEL = AC.getDecl()->getLocEnd();
     thread_safety::ThreadSafetyReporter Reporter(S, FL, FEL);
@@ -1327,12 +1387,8 @@ AnalysisBasedWarnings::IssueWarnings(sema::AnalysisBasedWarnings::Policy P,
     Reporter.emitDiagnostics();
   }
 
-  if (Diags.getDiagnosticLevel(diag::warn_uninit_var, D->getLocStart())
-      != DiagnosticsEngine::Ignored ||
-      Diags.getDiagnosticLevel(diag::warn_sometimes_uninit_var,D->getLocStart())
-      != DiagnosticsEngine::Ignored ||
-      Diags.getDiagnosticLevel(diag::warn_maybe_uninit_var, D->getLocStart())
-      != DiagnosticsEngine::Ignored) {
+  if (UninitDiag) {
+    llvm::TimeRegion Region(T ? &T->UninitializedValues : 0);
     if (CFG *cfg = AC.getCFG()) {
       UninitValsDiagReporter reporter(S);
       UninitVariablesAnalysisStats stats;
@@ -1354,13 +1410,8 @@ AnalysisBasedWarnings::IssueWarnings(sema::AnalysisBasedWarnings::Policy P,
     }
   }
 
-  bool FallThroughDiagFull =
-      Diags.getDiagnosticLevel(diag::warn_unannotated_fallthrough,
-                               D->getLocStart()) != DiagnosticsEngine::Ignored;
-  bool FallThroughDiagPerFunction =
-      Diags.getDiagnosticLevel(diag::warn_unannotated_fallthrough_per_function,
-                               D->getLocStart()) != DiagnosticsEngine::Ignored;
   if (FallThroughDiagFull || FallThroughDiagPerFunction) {
+    llvm::TimeRegion Region(T ? &T->SwitchFallthrough : 0);
     DiagnoseSwitchLabelsFallthrough(S, AC, !FallThroughDiagFull);
   }
 
@@ -63,7 +63,8 @@ clang_sema_SRC_FILES :=	\
 	SemaTemplateInstantiateDecl.cpp	\
 	SemaTemplateVariadic.cpp	\
 	SemaType.cpp	\
-	TargetAttributesSema.cpp
+	TargetAttributesSema.cpp	\
+	TemplateInstantiationProfiler.cpp
 
 LOCAL_SRC_FILES := $(clang_sema_SRC_FILES)
 
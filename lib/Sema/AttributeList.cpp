@@ -17,6 +17,7 @@
 #include "clang/Basic/IdentifierTable.h"
 #include "llvm/ADT/StringSwitch.h"
 #include "llvm/ADT/SmallString.h"
+#include "llvm/Support/raw_ostream.h"
 using namespace clang;
 
 size_t AttributeList::allocated_size() const {
@@ -26,7 +27,9 @@ size_t AttributeList::allocated_size() const {
   return (sizeof(AttributeList) + NumArgs * sizeof(Expr*));
 }
 
-AttributeFactory::AttributeFactory() {
+AttributeFactory::AttributeFactory()
+  : NumAttrsAllocated(0), NumAttrsReused(0), NumDeclAllocations(0),
+    NumDeclResets(0) {
   // Go ahead and configure all the inline capacity.  This is just a memset.
   FreeLists.resize(InlineFreeListsCapacity);
 }
@@ -44,11 +47,13 @@ void *AttributeFactory::allocate(size_t size) {
   if (index < FreeLists.size()) {
     if (AttributeList *attr = FreeLists[index]) {
       FreeLists[index] = attr->NextInPool;
+      ++NumAttrsReused;
       return attr;
     }
   }
 
   // Otherwise, allocate something new.
+  ++NumAttrsAllocated;
   return Alloc.Allocate(size, llvm::AlignOf<AttributeFactory>::Alignment);
 }
 
@@ -74,6 +79,20 @@ void AttributeFactory::reclaimPool(AttributeList *cur) {
   } while (cur);
 }
 
+void AttributeFactory::resetDeclStorage() {
+  ++NumDeclResets;
+  DeclAlloc.Reset();
+}
+
+void AttributeFactory::PrintStats() const {
+  llvm::errs() << "\n*** Parsed Declaration Storage Stats:\n";
+  llvm::errs() << NumAttrsAllocated << " attributes allocated, "
+               << NumAttrsReused << " reused from the free lists.\n";
+  llvm::errs() << NumDeclAllocations << " declaration arrays allocated, "
+               << "released in " << NumDeclResets << " resets.\n";
+  DeclAlloc.PrintStats();
+}
+
 void AttributePool::takePool(AttributeList *pool) {
   assert(pool);
 
@@ -115,6 +134,14 @@ AttributeList::Kind AttributeList::getKind(const IdentifierInfo *Name,
     AttrName = AttrName.substr(2, AttrName.size() - 4);
 
   SmallString<64> Buf;
+  if (SyntaxUsed == AS_Pragma) {
+    Buf += "#pragma ";
+    Buf += ScopeName->getName();
+    Buf += " ";
+    Buf += AttrName;
+    return ::getAttrKind(Buf);
+  }
+
   if (ScopeName)
     Buf += ScopeName->getName();
   // Ensure that in the case of C++11 attributes, we look for '::foo' if it is
@@ -23,6 +23,7 @@
 #include "llvm/ADT/Twine.h"
 #include "llvm/Support/raw_ostream.h"
 #include <algorithm>
+#include <cctype>
 #include <cstring>
 #include <functional>
 
@@ -462,6 +463,25 @@ CodeCompleteConsumer::OverloadCandidate::getFunctionType() const {
 
 CodeCompleteConsumer::~CodeCompleteConsumer() { }
 
+bool clang::matchesCodeCompletionFilter(StringRef Name, StringRef Filter,
+                                        bool Fuzzy) {
+  if (!Fuzzy)
+    return Name.size() >= Filter.size() &&
+           Name.substr(0, Filter.size()).equals_lower(Filter);
+
+  // Match the characters of the filter, in order, anywhere in the name.
+  unsigned NameIdx = 0;
+  for (unsigned I = 0, N = Filter.size(); I != N; ++I, ++NameIdx) {
+    char C = tolower((unsigned char)Filter[I]);
+    while (NameIdx != Name.size() &&
+           tolower((unsigned char)Name[NameIdx]) != C)
+      ++NameIdx;
+    if (NameIdx == Name.size())
+      return false;
+  }
+  return true;
+}
+
 void 
 PrintingCodeCompleteConsumer::ProcessCodeCompleteResults(Sema &SemaRef,
                                                  CodeCompletionContext Context,
@@ -176,7 +176,6 @@ DeclaratorChunk DeclaratorChunk::getFunction(bool hasProto, bool isVariadic,
   I.Fun.isVariadic              = isVariadic;
   I.Fun.isAmbiguous             = isAmbiguous;
   I.Fun.EllipsisLoc             = EllipsisLoc.getRawEncoding();
-  I.Fun.DeleteArgInfo           = false;
   I.Fun.TypeQuals               = TypeQuals;
   I.Fun.NumArgs                 = NumArgs;
   I.Fun.ArgInfo                 = 0;
@@ -194,20 +193,22 @@ DeclaratorChunk DeclaratorChunk::getFunction(bool hasProto, bool isVariadic,
                                   TrailingReturnType.isInvalid();
   I.Fun.TrailingReturnType      = TrailingReturnType.get();
 
-  // new[] an argument array if needed.
+  AttributeFactory &Factory = TheDeclarator.getAttributePool().getFactory();
+
+  // Allocate an argument array if needed.
   if (NumArgs) {
     // If the 'InlineParams' in Declarator is unused and big enough, put our
-    // parameter list there (in an effort to avoid new/delete traffic).  If it
-    // is already used (consider a function returning a function pointer) or too
-    // small (function taking too many arguments), go to the heap.
+    // parameter list there.  If it is already used (consider a function
+    // returning a function pointer) or too small (function taking too many
+    // arguments), allocate it from the factory, which releases it with the
+    // rest of the top-level declaration.
     if (!TheDeclarator.InlineParamsUsed &&
         NumArgs <= llvm::array_lengthof(TheDeclarator.InlineParams)) {
       I.Fun.ArgInfo = TheDeclarator.InlineParams;
-      I.Fun.DeleteArgInfo = false;
       TheDeclarator.InlineParamsUsed = true;
     } else {
-      I.Fun.ArgInfo = new DeclaratorChunk::ParamInfo[NumArgs];
-      I.Fun.DeleteArgInfo = true;
+      I.Fun.ArgInfo =
+        Factory.allocateDeclStorage<DeclaratorChunk::ParamInfo>(NumArgs);
     }
     memcpy(I.Fun.ArgInfo, ArgInfo, sizeof(ArgInfo[0])*NumArgs);
   }
@@ -216,10 +217,12 @@ DeclaratorChunk DeclaratorChunk::getFunction(bool hasProto, bool isVariadic,
   switch (ESpecType) {
   default: break; // By default, save nothing.
   case EST_Dynamic:
-    // new[] an exception array if needed
+    // Allocate an exception array if needed.
     if (NumExceptions) {
       I.Fun.NumExceptions = NumExceptions;
-      I.Fun.Exceptions = new DeclaratorChunk::TypeAndRange[NumExceptions];
+      I.Fun.Exceptions =
+        Factory.allocateDeclStorage<DeclaratorChunk::TypeAndRange>(
+          NumExceptions);
       for (unsigned i = 0; i != NumExceptions; ++i) {
         I.Fun.Exceptions[i].Ty = Exceptions[i];
         I.Fun.Exceptions[i].Range = ExceptionRanges[i];
@@ -761,9 +764,11 @@ void DeclSpec::setProtocolQualifiers(Decl * const *Protos,
                                      SourceLocation *ProtoLocs,
                                      SourceLocation LAngleLoc) {
   if (NP == 0) return;
-  ProtocolQualifiers = new Decl*[NP];
-  ProtocolLocs = new SourceLocation[NP];
-  memcpy((void*)ProtocolQualifiers, Protos, sizeof(Decl*)*NP);
+  AttributeFactory &Factory = getAttributePool().getFactory();
+  Decl **Qualifiers = Factory.allocateDeclStorage<Decl *>(NP);
+  memcpy(Qualifiers, Protos, sizeof(Decl*)*NP);
+  ProtocolQualifiers = Qualifiers;
+  ProtocolLocs = Factory.allocateDeclStorage<SourceLocation>(NP);
   memcpy(ProtocolLocs, ProtoLocs, sizeof(SourceLocation)*NP);
   NumProtocolQualifiers = NP;
   ProtocolLAngleLoc = LAngleLoc;
@@ -98,7 +98,7 @@ IdentifierResolver::IdDeclInfo::ReplaceDecl(NamedDecl *Old, NamedDecl *New) {
 
 IdentifierResolver::IdentifierResolver(Preprocessor &PP)
   : LangOpt(PP.getLangOpts()), PP(PP),
-    IdDeclInfos(new IdDeclInfoMap) {
+    IdDeclInfos(new IdDeclInfoMap), Generation(0) {
 }
 
 IdentifierResolver::~IdentifierResolver() {
@@ -399,6 +399,8 @@ void IdentifierResolver::readingIdentifier(IdentifierInfo &II) {
 }
 
 void IdentifierResolver::updatingIdentifier(IdentifierInfo &II) {
+  ++Generation;
+
   if (II.isOutOfDate())
     PP.getExternalSource()->updateOutOfDateIdentifier(II);
   
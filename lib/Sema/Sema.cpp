@@ -21,6 +21,7 @@
 #include "llvm/Support/CrashRecoveryContext.h"
 #include "clang/Sema/CXXFieldCollector.h"
 #include "clang/Sema/TemplateDeduction.h"
+#include "clang/Sema/TemplateInstantiationProfiler.h"
 #include "clang/Sema/ExternalSemaSource.h"
 #include "clang/Sema/ObjCMethodList.h"
 #include "clang/Sema/PrettyDeclStackTrace.h"
@@ -35,6 +36,7 @@
 #include "clang/AST/Expr.h"
 #include "clang/AST/ExprCXX.h"
 #include "clang/AST/StmtCXX.h"
+#include "clang/Analysis/Analyses/FormatString.h"
 #include "clang/Lex/HeaderSearch.h"
 #include "clang/Lex/Preprocessor.h"
 #include "clang/Basic/FileManager.h"
@@ -98,13 +100,21 @@ Sema::Sema(Preprocessor &pp, ASTContext &ctxt, ASTConsumer &consumer,
     NSDictionaryDecl(0), DictionaryWithObjectsMethod(0),
     GlobalNewDeleteDeclared(false), 
     TUKind(TUKind),
-    NumSFINAEErrors(0), InFunctionDeclarator(0),
+    NumSFINAEErrors(0), NumDiagnosticsEmitted(0),
+    NumSubstTypeCacheHits(0), NumConversionSequenceCacheHits(0),
+    NumAssociatedSetsCacheHits(0), NumParsedFormatStringsReused(0),
+    NumCopyInitializations(0), NumTrivialCopyInitializations(0),
+    NumIdResolverLookups(0), NumIdResolverDeclsVisited(0),
+    NumDelayedAccessChecksReused(0),
+    InFunctionDeclarator(0),
     AccessCheckingSFINAE(false), InNonInstantiationSFINAEContext(false),
     NonInstantiationEntries(0), ArgumentPackSubstitutionIndex(-1),
     CurrentInstantiationScope(0), TyposCorrected(0),
+    LoadedExternalTypoCandidates(false), ExternalTypoCandidatesGeneration(0),
     AnalysisWarnings(*this)
 {
   TUScope = 0;
+  CompileProfile = 0;
   
   LoadedExternalKnownNamespaces = false;
   for (unsigned I = 0; I != NSAPI::NumNSNumberLiteralMethods; ++I)
@@ -194,6 +204,15 @@ Sema::~Sema() {
     delete FunctionScopes[I];
   if (FunctionScopes.size() == 1)
     delete FunctionScopes[0];
+
+  for (llvm::StringMap<analyze_format_string::ParsedFormatString *>::iterator
+         I = ParsedPrintfStrings.begin(), E = ParsedPrintfStrings.end();
+       I != E; ++I)
+    delete I->getValue();
+  for (llvm::StringMap<analyze_format_string::ParsedFormatString *>::iterator
+         I = ParsedScanfStrings.begin(), E = ParsedScanfStrings.end();
+       I != E; ++I)
+    delete I->getValue();
   
   // Tell the SemaConsumer to forget about us; we're going out of scope.
   if (SemaConsumer *SC = dyn_cast<SemaConsumer>(&Consumer))
@@ -230,6 +249,12 @@ bool Sema::makeUnavailableInSystemHeader(SourceLocation loc,
   return true;
 }
 
+void Sema::enableInstantiationProfiler() {
+  if (!InstantiationProfiler)
+    InstantiationProfiler.reset(
+      new sema::TemplateInstantiationProfiler(Context));
+}
+
 ASTMutationListener *Sema::getASTMutationListener() const {
   return getASTConsumer().GetASTMutationListener();
 }
@@ -238,6 +263,25 @@ ASTMutationListener *Sema::getASTMutationListener() const {
 void Sema::PrintStats() const {
   llvm::errs() << "\n*** Semantic Analysis Stats:\n";
   llvm::errs() << NumSFINAEErrors << " SFINAE diagnostics trapped.\n";
+  llvm::errs() << NumSubstTypeCacheHits << "/" << SubstTypeCache.size()
+               << " cached type substitutions reused.\n";
+  llvm::errs() << NumConversionSequenceCacheHits << "/"
+               << ConversionSequenceCache.size()
+               << " cached conversion sequences reused.\n";
+  llvm::errs() << NumAssociatedSetsCacheHits << "/"
+               << AssociatedSetsCache.size()
+               << " cached associated namespace sets reused.\n";
+  llvm::errs() << NumParsedFormatStringsReused << "/"
+               << ParsedPrintfStrings.size() + ParsedScanfStrings.size()
+               << " parsed format strings reused.\n";
+  llvm::errs() << NumTrivialCopyInitializations << "/"
+               << NumCopyInitializations
+               << " copy-initializations without an initialization sequence.\n";
+  llvm::errs() << NumIdResolverLookups << " unqualified lookups visited "
+               << NumIdResolverDeclsVisited
+               << " declarations on identifier chains.\n";
+  llvm::errs() << NumDelayedAccessChecksReused
+               << " delayed access checks reused.\n";
 
   BumpAlloc.PrintStats();
   AnalysisWarnings.PrintStats();
@@ -500,6 +544,19 @@ static bool IsRecordFullyDefined(const CXXRecordDecl *RD,
   return Complete;
 }
 
+bool Sema::PerformPendingLateParsing() {
+  if (PendingLateParsedFunctions.empty() || !LateTemplateParser)
+    return false;
+
+  // Parsing a body may make more functions pending.
+  while (!PendingLateParsedFunctions.empty()) {
+    FunctionDecl *FD = PendingLateParsedFunctions.pop_back_val();
+    if (FD->isLateTemplateParsed())
+      LateTemplateParser(OpaqueParser, FD);
+  }
+  return true;
+}
+
 /// ActOnEndOfTranslationUnit - This is called at the very end of the
 /// translation unit when EOF is reached and all but the top-level scope is
 /// popped.
@@ -530,24 +587,34 @@ void Sema::ActOnEndOfTranslationUnit() {
         if (KeyFunction->hasBody(Definition))
           MarkVTableUsed(Definition->getLocation(), *I, true);
       }
+
+      // The owner of an AST file emits the vtables which the translation
+      // units using it leave out.
+      if (LangOpts.getPCHVTables() == LangOptions::PCHVTablesOwner &&
+          Context.isVTableOwnedByASTFile(*I))
+        MarkVTableUsed((*I)->getLocation(), *I, true);
     }
 
-    // If DefinedUsedVTables ends up marking any virtual member functions it
-    // might lead to more pending template instantiations, which we then need
-    // to instantiate.
-    DefineUsedVTables();
-
-    // C++: Perform implicit template instantiations.
-    //
-    // FIXME: When we perform these implicit instantiations, we do not
-    // carefully keep track of the point of instantiation (C++ [temp.point]).
-    // This means that name lookup that occurs within the template
-    // instantiation will always happen at the end of the translation unit,
-    // so it will find some names that should not be found. Although this is
-    // common behavior for C++ compilers, it is technically wrong. In the
-    // future, we either need to be able to filter the results of name lookup
-    // or we need to perform template instantiations earlier.
-    PerformPendingInstantiations();
+    // Parsing the delayed bodies of the used inline member functions can use
+    // more vtables, templates and delayed functions.
+    do {
+      // If DefinedUsedVTables ends up marking any virtual member functions it
+      // might lead to more pending template instantiations, which we then
+      // need to instantiate.
+      DefineUsedVTables();
+
+      // C++: Perform implicit template instantiations.
+      //
+      // FIXME: When we perform these implicit instantiations, we do not
+      // carefully keep track of the point of instantiation (C++ [temp.point]).
+      // This means that name lookup that occurs within the template
+      // instantiation will always happen at the end of the translation unit,
+      // so it will find some names that should not be found. Although this is
+      // common behavior for C++ compilers, it is technically wrong. In the
+      // future, we either need to be able to filter the results of name
+      // lookup or we need to perform template instantiations earlier.
+      PerformPendingInstantiations();
+    } while (PerformPendingLateParsing());
   }
   
   // Remove file scoped decls that turned out to be used.
@@ -795,6 +862,8 @@ void Sema::EmitCurrentDiagnostic(unsigned DiagID) {
   // eliminnated. If it truly cannot be (for example, there is some reentrancy
   // issue I am not seeing yet), then there should at least be a clarifying
   // comment somewhere.
+  ++NumDiagnosticsEmitted;
+
   if (llvm::Optional<TemplateDeductionInfo*> Info = isSFINAEContext()) {
     switch (DiagnosticIDs::getDiagnosticSFINAEResponse(
               Diags.getCurrentDiagID())) {
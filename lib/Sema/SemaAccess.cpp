@@ -1437,12 +1437,47 @@ void Sema::HandleDelayedAccessCheck(DelayedDiagnostic &DD, Decl *decl) {
     DC = fnt->getTemplatedDecl();
   }
 
+  const AccessedEntity &Entity = DD.getAccessData();
+  llvm::FoldingSetNodeID ID;
+  SucceededDelayedAccess::Profile(ID, DC, Entity.getTargetDecl(),
+                                  Entity.getNamingClass(),
+                                  Entity.getBaseObjectType(),
+                                  Entity.getAccess(), Entity.isMemberAccess());
+  void *InsertPos = 0;
+  if (SucceededDelayedAccesses.FindNodeOrInsertPos(ID, InsertPos)) {
+    ++NumDelayedAccessChecksReused;
+    return;
+  }
+
   EffectiveContext EC(DC);
 
-  AccessTarget Target(DD.getAccessData());
+  AccessTarget Target(Entity);
 
-  if (CheckEffectiveAccess(*this, EC, DD.Loc, Target) == ::AR_inaccessible)
+  switch (CheckEffectiveAccess(*this, EC, DD.Loc, Target)) {
+  case ::AR_inaccessible:
     DD.Triggered = true;
+    break;
+
+  case ::AR_accessible: {
+    // In Microsoft mode an access may be granted with a warning, which has
+    // to be issued at each use.
+    if (getLangOpts().MicrosoftMode)
+      break;
+    SucceededDelayedAccess *Entry
+      = SucceededDelayedAccessAlloc.Allocate<SucceededDelayedAccess>();
+    SucceededDelayedAccesses.InsertNode(
+      new (Entry) SucceededDelayedAccess(DC, Entity.getTargetDecl(),
+                                         Entity.getNamingClass(),
+                                         Entity.getBaseObjectType(),
+                                         Entity.getAccess(),
+                                         Entity.isMemberAccess()),
+      InsertPos);
+    break;
+  }
+
+  case ::AR_dependent:
+    break;
+  }
 }
 
 void Sema::HandleDependentAccessCheck(const DependentDiagnostic &DD,
@@ -159,6 +159,10 @@ Sema::CheckBuiltinFunctionCall(unsigned BuiltinID, CallExpr *TheCall) {
     if (SemaBuiltinPrefetch(TheCall))
       return ExprError();
     break;
+  case Builtin::BI__builtin_assume_aligned:
+    if (SemaBuiltinAssumeAligned(TheCall))
+      return ExprError();
+    break;
   case Builtin::BI__builtin_object_size:
     if (SemaBuiltinObjectSize(TheCall))
       return ExprError();
@@ -1554,6 +1558,47 @@ bool Sema::SemaBuiltinPrefetch(CallExpr *TheCall) {
   return false;
 }
 
+/// SemaBuiltinAssumeAligned - Handle __builtin_assume_aligned.
+// This is declared to take (const void*, size_t, ...); the alignment must be
+// a constant power of 2, and the optional offset is converted to size_t.
+bool Sema::SemaBuiltinAssumeAligned(CallExpr *TheCall) {
+  unsigned NumArgs = TheCall->getNumArgs();
+
+  if (NumArgs > 3)
+    return Diag(TheCall->getLocEnd(),
+             diag::err_typecheck_call_too_many_args_at_most)
+             << 0 /*function call*/ << 3 << NumArgs
+             << TheCall->getSourceRange();
+
+  Expr *AlignArg = TheCall->getArg(1);
+  if (!AlignArg->isTypeDependent() && !AlignArg->isValueDependent()) {
+    llvm::APSInt Result;
+    if (SemaBuiltinConstantArg(TheCall, 1, Result))
+      return true;
+
+    if (!Result.isPowerOf2())
+      return Diag(TheCall->getLocStart(),
+                  diag::err_attribute_aligned_not_power_of_two)
+               << AlignArg->getSourceRange();
+  }
+
+  if (NumArgs > 2) {
+    Expr *OffsetArg = TheCall->getArg(2);
+    if (OffsetArg->isTypeDependent())
+      return false;
+
+    if (!OffsetArg->getType()->isIntegerType())
+      return Diag(OffsetArg->getLocStart(),
+                  diag::err_builtin_assume_aligned_offset)
+               << OffsetArg->getSourceRange();
+
+    TheCall->setArg(2, ImpCastExprToType(OffsetArg, Context.getSizeType(),
+                                         CK_IntegralCast).take());
+  }
+
+  return false;
+}
+
 /// SemaBuiltinConstantArg - Handle a check if argument ArgNum of CallExpr
 /// TheCall is a constant expression.
 bool Sema::SemaBuiltinConstantArg(CallExpr *TheCall, int ArgNum,
@@ -2982,6 +3027,21 @@ bool CheckScanfHandler::HandleScanfSpecifier(
   return true;
 }
 
+/// \brief Parse the format string \p Str, unless a format string with the
+/// same contents was already parsed.
+const analyze_format_string::ParsedFormatString &
+Sema::getParsedFormatString(
+    llvm::StringMap<analyze_format_string::ParsedFormatString *> &Parsed,
+    StringRef Str, bool IsScanf) {
+  analyze_format_string::ParsedFormatString *&Entry = Parsed[Str];
+  if (Entry)
+    ++NumParsedFormatStringsReused;
+  else
+    Entry = new analyze_format_string::ParsedFormatString(Str, IsScanf,
+                                                          getLangOpts());
+  return *Entry;
+}
+
 void Sema::CheckFormatString(const StringLiteral *FExpr,
                              const Expr *OrigFormatExpr,
                              Expr **Args, unsigned NumArgs,
@@ -2998,9 +3058,8 @@ void Sema::CheckFormatString(const StringLiteral *FExpr,
     return;
   }
   
-  // Str - The format string.  NOTE: this is NOT null-terminated!
+  // StrRef - The format string.  NOTE: this is NOT null-terminated!
   StringRef StrRef = FExpr->getString();
-  const char *Str = StrRef.data();
   unsigned StrLen = StrRef.size();
   const unsigned numDataArgs = NumArgs - firstDataArg;
   
@@ -3013,22 +3072,27 @@ void Sema::CheckFormatString(const StringLiteral *FExpr,
     return;
   }
   
+  // The same format string is often checked many times, e.g. when it comes
+  // from a macro, so each is only parsed once; the handlers measure the
+  // positions they are given from the start of the parsed copy.
   if (Type == FST_Printf || Type == FST_NSString) {
+    const analyze_format_string::ParsedFormatString &Parsed
+      = getParsedFormatString(ParsedPrintfStrings, StrRef, /*IsScanf=*/false);
     CheckPrintfHandler H(*this, FExpr, OrigFormatExpr, firstDataArg,
                          numDataArgs, (Type == FST_NSString),
-                         Str, HasVAListArg, Args, NumArgs, format_idx,
-                         inFunctionCall, CallType);
+                         Parsed.getString().data(), HasVAListArg, Args,
+                         NumArgs, format_idx, inFunctionCall, CallType);
   
-    if (!analyze_format_string::ParsePrintfString(H, Str, Str + StrLen,
-                                                  getLangOpts()))
+    if (!Parsed.report(H))
       H.DoneProcessing();
   } else if (Type == FST_Scanf) {
+    const analyze_format_string::ParsedFormatString &Parsed
+      = getParsedFormatString(ParsedScanfStrings, StrRef, /*IsScanf=*/true);
     CheckScanfHandler H(*this, FExpr, OrigFormatExpr, firstDataArg, numDataArgs,
-                        Str, HasVAListArg, Args, NumArgs, format_idx,
-                        inFunctionCall, CallType);
+                        Parsed.getString().data(), HasVAListArg, Args, NumArgs,
+                        format_idx, inFunctionCall, CallType);
     
-    if (!analyze_format_string::ParseScanfString(H, Str, Str + StrLen,
-                                                 getLangOpts()))
+    if (!Parsed.report(H))
       H.DoneProcessing();
   } // TODO: handle other formats
 }
@@ -4630,6 +4694,10 @@ void CheckImplicitConversion(Sema &S, Expr *E, QualType T,
 
       // Builtin FP kinds are ordered by increasing FP rank.
       if (SourceBT->getKind() > TargetBT->getKind()) {
+        // Evaluating the expression is only needed to decide whether to warn.
+        if (S.Diags.isIgnored(diag::warn_impcast_float_precision, CC))
+          return;
+
         // Don't warn about float constants that are precisely
         // representable in the target type.
         Expr::EvalResult result;
@@ -164,6 +164,8 @@ namespace {
     
     void AdjustResultPriorityForDecl(Result &R);
 
+    bool isFilteredOut(const Result &R) const;
+
     void MaybeAddConstructorResults(Result R);
     
   public:
@@ -765,9 +767,52 @@ void ResultBuilder::MaybeAddConstructorResults(Result R) {
   }
 }
 
+/// \brief Determine whether the given result cannot match the text that the
+/// code-completion consumer filters on, so that it can be dropped before its
+/// completion string is built.
+bool ResultBuilder::isFilteredOut(const Result &R) const {
+  CodeCompleteConsumer *Consumer = SemaRef.CodeCompleter;
+  if (!Consumer || Consumer->getFilterPrefix().empty())
+    return false;
+
+  switch (R.Kind) {
+  case Result::RK_Declaration:
+    // The typed text of a selector or special name depends on the context.
+    if (IdentifierInfo *II = R.Declaration->getIdentifier())
+      return !Consumer->matchesFilter(II->getName());
+    return false;
+
+  case Result::RK_Keyword:
+    return !Consumer->matchesFilter(R.Keyword);
+
+  case Result::RK_Macro:
+    return !Consumer->matchesFilter(R.Macro->getName());
+
+  case Result::RK_Pattern: {
+    // Only filter on the typed text when it is all in one chunk.
+    const char *TypedText = 0;
+    for (CodeCompletionString::iterator C = R.Pattern->begin(),
+                                     CEnd = R.Pattern->end();
+         C != CEnd; ++C) {
+      if (C->Kind != CodeCompletionString::CK_TypedText)
+        continue;
+      if (TypedText)
+        return false;
+      TypedText = C->Text;
+    }
+    return TypedText && !Consumer->matchesFilter(TypedText);
+  }
+  }
+
+  llvm_unreachable("Invalid ResultKind!");
+}
+
 void ResultBuilder::MaybeAddResult(Result R, DeclContext *CurContext) {
   assert(!ShadowMaps.empty() && "Must enter into a results scope");
   
+  if (isFilteredOut(R))
+    return;
+
   if (R.Kind != Result::RK_Declaration) {
     // For non-declaration results, just add the result.
     Results.push_back(R);
@@ -880,6 +925,9 @@ void ResultBuilder::MaybeAddResult(Result R, DeclContext *CurContext) {
 
 void ResultBuilder::AddResult(Result R, DeclContext *CurContext, 
                               NamedDecl *Hiding, bool InBaseClass = false) {
+  if (isFilteredOut(R))
+    return;
+
   if (R.Kind != Result::RK_Declaration) {
     // For non-declaration results, just add the result.
     Results.push_back(R);
@@ -961,6 +1009,9 @@ void ResultBuilder::AddResult(Result R, DeclContext *CurContext,
 void ResultBuilder::AddResult(Result R) {
   assert(R.Kind != Result::RK_Declaration && 
           "Declaration results need more context");
+  if (isFilteredOut(R))
+    return;
+
   Results.push_back(R);
 }
 
@@ -1693,7 +1693,7 @@ void Sema::MergeTypedefNameDecl(TypedefNameDecl *New, LookupResult &OldDecls) {
   }
 
   // Modules always permit redefinition of typedefs, as does C11.
-  if (getLangOpts().Modules || getLangOpts().C11)
+  if (getLangOpts().allowsModuleImports() || getLangOpts().C11)
     return;
   
   // If we have a redefinition of a typedef in C, emit a warning.  This warning
@@ -6560,9 +6560,14 @@ void Sema::AddInitializerToDecl(Decl *RealDecl, Expr *Init,
       Args = CXXDirectInit->getExprs();
       NumArgs = CXXDirectInit->getNumExprs();
     }
-    InitializationSequence InitSeq(*this, Entity, Kind, Args, NumArgs);
-    ExprResult Result = InitSeq.Perform(*this, Entity, Kind,
-                                        MultiExprArg(Args, NumArgs), &DclT);
+    ExprResult Result;
+    if (!DirectInit)
+      Result = PerformTrivialCopyInitialization(Entity, Init);
+    if (!Result.isUsable() && !Result.isInvalid()) {
+      InitializationSequence InitSeq(*this, Entity, Kind, Args, NumArgs);
+      Result = InitSeq.Perform(*this, Entity, Kind,
+                               MultiExprArg(Args, NumArgs), &DclT);
+    }
     if (Result.isInvalid()) {
       VDecl->setInvalidDecl();
       return;
@@ -7600,6 +7605,21 @@ void Sema::CheckForFunctionRedefinition(FunctionDecl *FD) {
   }
 }
 
+/// \brief Determine whether the statements of the body of \p FD can be
+/// allocated so that they are released once the function has been emitted.
+///
+/// Later declarations cannot use the body of a function which is neither
+/// inline, nor constexpr, nor a template or an instantiation of one.
+/// Constructors and destructors are emitted as several variants, and are
+/// not released.
+bool Sema::canReleaseFunctionBody(const FunctionDecl *FD) const {
+  return !FD->isInlined() && !FD->isConstexpr() && !FD->isInvalidDecl() &&
+         !FD->isDependentContext() &&
+         FD->getTemplatedKind() == FunctionDecl::TK_NonTemplate &&
+         !isa<CXXConstructorDecl>(FD) && !isa<CXXDestructorDecl>(FD) &&
+         ActiveTemplateInstantiations.empty() && !Context.getExternalSource();
+}
+
 Decl *Sema::ActOnStartOfFunctionDef(Scope *FnBodyScope, Decl *D) {
   // Clear the last template instantiation error context.
   LastTemplateInstantiationErrorContext = ActiveTemplateInstantiation();
@@ -7735,6 +7755,9 @@ Decl *Sema::ActOnStartOfFunctionDef(Scope *FnBodyScope, Decl *D) {
   // We want to attach documentation to original Decl (which might be
   // a function template).
   ActOnDocumentableDecl(D);
+
+  if (Context.hasReleasableFunctionBodies() && canReleaseFunctionBody(FD))
+    Context.startFunctionBody(FD);
   return FD;
 }
 
@@ -7909,6 +7932,8 @@ Decl *Sema::ActOnFinishFunctionBody(Decl *dcl, Stmt *Body,
     DiscardCleanupsInEvaluationContext();
   }
 
+  if (FD)
+    Context.finishFunctionBody(FD);
   return dcl;
 }
 
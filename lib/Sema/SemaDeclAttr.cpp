@@ -1652,6 +1652,57 @@ static void handleMallocAttr(Sema &S, Decl *D, const AttributeList &Attr) {
   S.Diag(Attr.getLoc(), diag::warn_attribute_malloc_pointer_only);
 }
 
+/// handleAssumeAlignedAttr - Handle assume_aligned(alignment[, offset]), which
+/// promises that the pointer returned by a function, minus the offset, is a
+/// multiple of the alignment.
+static void handleAssumeAlignedAttr(Sema &S, Decl *D,
+                                    const AttributeList &Attr) {
+  if (!checkAttributeAtLeastNumArgs(S, Attr, 1))
+    return;
+  if (Attr.getNumArgs() > 2) {
+    S.Diag(Attr.getLoc(), diag::err_attribute_too_many_arguments) << 2;
+    return;
+  }
+
+  if (!isFunctionOrMethod(D)) {
+    S.Diag(Attr.getLoc(), diag::warn_attribute_wrong_decl_type)
+      << "assume_aligned" << ExpectedFunctionOrMethod;
+    return;
+  }
+
+  QualType RetTy;
+  if (const FunctionType *FnTy = getFunctionType(D))
+    RetTy = FnTy->getResultType();
+  else
+    RetTy = cast<ObjCMethodDecl>(D)->getResultType();
+  if (!RetTy->isAnyPointerType() && !RetTy->isBlockPointerType()) {
+    S.Diag(Attr.getLoc(), diag::warn_attribute_assume_aligned_pointer_only);
+    return;
+  }
+
+  uint64_t Values[2] = { 0, 0 };
+  for (unsigned I = 0, N = Attr.getNumArgs(); I != N; ++I) {
+    Expr *E = Attr.getArg(I);
+    llvm::APSInt Value;
+    if (E->isTypeDependent() || E->isValueDependent() ||
+        !E->isIntegerConstantExpr(Value, S.Context)) {
+      S.Diag(Attr.getLoc(), diag::err_attribute_argument_not_int)
+        << "assume_aligned" << E->getSourceRange();
+      return;
+    }
+    Values[I] = Value.getZExtValue();
+  }
+
+  if (!llvm::isPowerOf2_64(Values[0])) {
+    S.Diag(Attr.getLoc(), diag::err_attribute_aligned_not_power_of_two)
+      << Attr.getArg(0)->getSourceRange();
+    return;
+  }
+
+  D->addAttr(::new (S.Context) AssumeAlignedAttr(Attr.getRange(), S.Context,
+                                                 Values[0], Values[1]));
+}
+
 static void handleMayAliasAttr(Sema &S, Decl *D, const AttributeList &Attr) {
   // check the attribute arguments.
   if (!checkAttributeNumArgs(S, Attr, 0))
@@ -4271,6 +4322,8 @@ static void ProcessInheritableDeclAttr(Sema &S, Scope *scope, Decl *D,
     handleAlwaysInlineAttr  (S, D, Attr); break;
   case AttributeList::AT_AnalyzerNoReturn:
     handleAnalyzerNoReturnAttr  (S, D, Attr); break;
+  case AttributeList::AT_AssumeAligned:
+    handleAssumeAlignedAttr (S, D, Attr); break;
   case AttributeList::AT_TLSModel:    handleTLSModelAttr    (S, D, Attr); break;
   case AttributeList::AT_Annotate:    handleAnnotateAttr    (S, D, Attr); break;
   case AttributeList::AT_Availability:handleAvailabilityAttr(S, D, Attr); break;
@@ -4754,6 +4807,14 @@ void Sema::PopParsingDeclaration(ParsingDeclState state, Decl *decl) {
   DelayedDiagnosticPool &poppedPool = *DelayedDiagnostics.getCurrentPool();
   DelayedDiagnostics.popWithoutEmitting(state);
 
+  // Once no declaration is being parsed, the access checks that succeeded
+  // for the last one will not be asked for again.
+  if (!DelayedDiagnostics.getCurrentPool() &&
+      !SucceededDelayedAccesses.empty()) {
+    SucceededDelayedAccesses.clear();
+    SucceededDelayedAccessAlloc.Reset();
+  }
+
   // When delaying diagnostics to run in the context of a parsed
   // declaration, we only want to actually emit anything if parsing
   // succeeds.
@@ -1304,17 +1304,23 @@ Sema::CheckDerivedToBaseConversion(QualType Derived, QualType Base,
                                    DeclarationName Name,
                                    CXXCastPath *BasePath) {
   // First, determine whether the path from Derived to Base is
-  // ambiguous. This is slightly more expensive than checking whether
-  // the Derived to Base conversion exists, because here we need to
-  // explore multiple paths to determine if there is an ambiguity.
-  CXXBasePaths Paths(/*FindAmbiguities=*/true, /*RecordPaths=*/true,
+  // ambiguous. The bases of the derived class tell us without exploring
+  // multiple paths, so unless there is an ambiguity we only need to find
+  // the first path to the base class.
+  CXXRecordDecl *DerivedRD = GetClassForType(Derived);
+  CXXRecordDecl *BaseRD = GetClassForType(Base);
+  assert(DerivedRD && BaseRD &&
+         "Can only be used with a derived-to-base conversion");
+  bool Ambiguous = DerivedRD->isAmbiguousBase(BaseRD);
+
+  CXXBasePaths Paths(/*FindAmbiguities=*/Ambiguous, /*RecordPaths=*/true,
                      /*DetectVirtual=*/false);
   bool DerivationOkay = IsDerivedFrom(Derived, Base, Paths);
   assert(DerivationOkay &&
          "Can only be used with a derived-to-base conversion");
   (void)DerivationOkay;
   
-  if (!Paths.isAmbiguous(Context.getCanonicalType(Base).getUnqualifiedType())) {
+  if (!Ambiguous) {
     if (InaccessibleBaseID) {
       // Check that the base class can be accessed.
       switch (CheckBaseClassAccess(Loc, Base, Derived, Paths.front(),
@@ -1335,17 +1341,11 @@ Sema::CheckDerivedToBaseConversion(QualType Derived, QualType Base,
   }
   
   // We know that the derived-to-base conversion is ambiguous, and
-  // we're going to produce a diagnostic. Perform the derived-to-base
-  // search just one more time to compute all of the possible paths so
-  // that we can print them out. This is more expensive than any of
-  // the previous derived-to-base checks we've done, but at this point
-  // performance isn't as much of an issue.
-  Paths.clear();
-  Paths.setRecordingPaths(true);
-  bool StillOkay = IsDerivedFrom(Derived, Base, Paths);
-  assert(StillOkay && "Can only be used with a derived-to-base conversion");
-  (void)StillOkay;
-  
+  // we're going to produce a diagnostic. The search above recorded all
+  // of the possible paths so that we can print them out.
+  assert(Paths.isAmbiguous(Context.getCanonicalType(Base).getUnqualifiedType())
+         && "Bases of the derived class disagree with the paths");
+
   // Build up a textual representation of the ambiguous paths, e.g.,
   // D -> B -> A, that will be used to illustrate the ambiguous
   // conversions in the diagnostic. We only print one of the paths
@@ -4027,7 +4027,10 @@ void Sema::EvaluateImplicitExceptionSpec(SourceLocation Loc, CXXMethodDecl *MD)
   if (FPT->getExceptionSpecType() != EST_Unevaluated)
     return;
 
-  // Evaluate the exception specification.
+  // Evaluate the exception specification. The result replaces the
+  // unevaluated one in the type of the special member, which is what caches
+  // it: the special members of derived classes and later uses resolve it
+  // from there, without walking the bases and fields again.
   ImplicitExceptionSpecification ExceptSpec =
       computeImplicitExceptionSpec(*this, Loc, MD);
 
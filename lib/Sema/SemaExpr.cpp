@@ -1291,6 +1291,32 @@ static ExprResult BuildCookedLiteralOperatorCall(Sema &S, Scope *Scope,
   return S.BuildLiteralOperatorCall(R, OpNameInfo, Args, LitEndLoc);
 }
 
+/// \brief If the given token is a plain ordinary string literal, build it
+/// without going through the StringLiteralParser.
+static StringLiteral *BuildPlainStringLiteral(Sema &S, const Token &Tok) {
+  if (Tok.isNot(tok::string_literal) || Tok.needsCleaning())
+    return 0;
+
+  bool Invalid = false;
+  const char *TokBegin = S.getSourceManager().getCharacterData(
+                           Tok.getLocation(), &Invalid);
+  StringRef String;
+  if (Invalid ||
+      !StringLiteralParser::GetPlainString(StringRef(TokBegin, Tok.getLength()),
+                                           S.getLangOpts(), String))
+    return 0;
+
+  QualType StrTy = S.Context.CharTy;
+  if (S.getLangOpts().CPlusPlus || S.getLangOpts().ConstStrings)
+    StrTy.addConst();
+  StrTy = S.Context.getConstantArrayType(StrTy,
+                                         llvm::APInt(32, String.size() + 1),
+                                         ArrayType::Normal, 0);
+  SourceLocation Loc = Tok.getLocation();
+  return StringLiteral::Create(S.Context, String, StringLiteral::Ascii,
+                               /*Pascal=*/false, StrTy, &Loc, 1);
+}
+
 /// ActOnStringLiteral - The specified tokens were lexed as pasted string
 /// fragments (e.g. "foo" "bar" L"baz").  The result string has to handle string
 /// concatenation ([C99 5.1.1.2, translation phase #6]), so it may come from
@@ -1302,6 +1328,11 @@ Sema::ActOnStringLiteral(const Token *StringToks, unsigned NumStringToks,
                          Scope *UDLScope) {
   assert(NumStringToks && "Must have at least one string!");
 
+  // Fast path for a single string literal without escapes.
+  if (NumStringToks == 1)
+    if (StringLiteral *Lit = BuildPlainStringLiteral(*this, StringToks[0]))
+      return Owned(Lit);
+
   StringLiteralParser Literal(StringToks, NumStringToks, PP);
   if (Literal.hadError)
     return ExprError();
@@ -2622,6 +2653,46 @@ static Expr *BuildFloatingLiteral(Sema &S, NumericLiteralParser &Literal,
   return FloatingLiteral::Create(S.Context, Val, isExact, Ty, Loc);
 }
 
+/// \brief Determine whether \p Val fits in a signed integer of \p Width bits.
+static bool fitsInSignedWidth(uint64_t Val, unsigned Width) {
+  return Width >= 64 ? (Val >> 63) == 0 : (Val >> (Width - 1)) == 0;
+}
+
+/// \brief If the given token is a plain decimal integer constant whose value
+/// fits in a signed type, build it without going through the
+/// NumericLiteralParser.
+static Expr *BuildPlainDecimalLiteral(Sema &S, const Token &Tok) {
+  if (Tok.needsCleaning())
+    return 0;
+
+  bool Invalid = false;
+  const char *TokBegin = S.getSourceManager().getCharacterData(
+                           Tok.getLocation(), &Invalid);
+  uint64_t Val;
+  if (Invalid ||
+      !NumericLiteralParser::GetPlainDecimalValue(
+         StringRef(TokBegin, Tok.getLength()), Val))
+    return 0;
+
+  // A decimal constant without a suffix has the first of int, long and
+  // long long that can represent it (C99 6.4.4.1p5).
+  const TargetInfo &Target = S.Context.getTargetInfo();
+  QualType Ty = S.Context.IntTy;
+  unsigned Width = Target.getIntWidth();
+  if (!fitsInSignedWidth(Val, Width)) {
+    Ty = S.Context.LongTy;
+    Width = Target.getLongWidth();
+  }
+  if (!fitsInSignedWidth(Val, Width)) {
+    Ty = S.Context.LongLongTy;
+    Width = Target.getLongLongWidth();
+  }
+  if (!fitsInSignedWidth(Val, Width))
+    return 0;
+  return IntegerLiteral::Create(S.Context, llvm::APInt(Width, Val), Ty,
+                                Tok.getLocation());
+}
+
 ExprResult Sema::ActOnNumericConstant(const Token &Tok, Scope *UDLScope) {
   // Fast path for a single digit (which is quite common).  A single digit
   // cannot have a trigraph, escaped newline, radix prefix, or suffix.
@@ -2630,6 +2701,10 @@ ExprResult Sema::ActOnNumericConstant(const Token &Tok, Scope *UDLScope) {
     return ActOnIntegerConstant(Tok.getLocation(), Val-'0');
   }
 
+  // Fast path for the other decimal integers without a suffix.
+  if (Expr *Res = BuildPlainDecimalLiteral(*this, Tok))
+    return Owned(Res);
+
   SmallString<512> IntegerBuffer;
   // Add padding so that NumericLiteralParser can overread by one character.
   IntegerBuffer.resize(Tok.getLength()+1);
@@ -10212,6 +10287,11 @@ void Sema::MarkFunctionReferenced(SourceLocation Loc, FunctionDecl *Func) {
   if (!IsPotentiallyEvaluatedContext(*this))
     return;
 
+  // The implicit definition of a defaulted function can outlive the function
+  // body being parsed.
+  if (Func->isDefaulted() && !Func->isDeleted() && !Func->isUsed(false))
+    Context.noteFunctionBodyEscape();
+
   // Note that this declaration has been used.
   if (CXXConstructorDecl *Constructor = dyn_cast<CXXConstructorDecl>(Func)) {
     if (Constructor->isDefaulted() && !Constructor->isDeleted()) {
@@ -10319,6 +10399,11 @@ void Sema::MarkFunctionReferenced(SourceLocation Loc, FunctionDecl *Func) {
     }
   }
 
+  // Parse the body of a used inline member function whose parsing was delayed
+  // at the end of the translation unit.
+  if (Func->isLateTemplateParsed() && !Func->isDependentContext())
+    PendingLateParsedFunctions.push_back(Func);
+
   // Keep track of used but undefined functions.
   if (!Func->isPure() && !Func->hasBody() &&
       Func->getLinkage() != ExternalLinkage) {
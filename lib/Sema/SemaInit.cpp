@@ -893,6 +893,30 @@ void InitListChecker::CheckComplexType(const InitializedEntity &Entity,
 }
 
 
+/// \brief Determine whether \p Init is an integer literal whose value the
+/// integer type \p DeclType can represent.
+///
+/// Initializing an integer from such a literal is an integral conversion that
+/// does not change the value: it can neither fail nor narrow, so it does not
+/// need an initialization sequence. Huge tables of bytes that embed binary
+/// data consist of nothing else.
+static bool isRepresentableIntegerLiteralInit(Expr *Init, QualType DeclType,
+                                              ASTContext &Context) {
+  IntegerLiteral *Literal = dyn_cast<IntegerLiteral>(Init);
+  if (!Literal)
+    return false;
+
+  const BuiltinType *BT = DeclType->getAs<BuiltinType>();
+  if (!BT || !BT->isInteger() || BT->getKind() == BuiltinType::Bool)
+    return false;
+
+  // The value of an integer literal is never negative.
+  unsigned Width = Context.getIntWidth(DeclType);
+  if (BT->isSignedInteger())
+    --Width;
+  return Literal->getValue().getActiveBits() <= Width;
+}
+
 void InitListChecker::CheckScalarType(const InitializedEntity &Entity,
                                       InitListExpr *IList, QualType DeclType,
                                       unsigned &Index,
@@ -932,6 +956,19 @@ void InitListChecker::CheckScalarType(const InitializedEntity &Entity,
     return;
   }
 
+  if (isRepresentableIntegerLiteralInit(expr, DeclType, SemaRef.Context)) {
+    if (!VerifyOnly) {
+      Expr *ResultExpr =
+        SemaRef.ImpCastExprToType(expr, DeclType.getUnqualifiedType(),
+                                  CK_IntegralCast).take();
+      if (ResultExpr != expr)
+        IList->setInit(Index, ResultExpr);
+      UpdateStructuredListElement(StructuredList, StructuredIndex, ResultExpr);
+    }
+    ++Index;
+    return;
+  }
+
   if (VerifyOnly) {
     if (!SemaRef.CanPerformCopyInitialization(Entity, SemaRef.Owned(expr)))
       hadError = true;
@@ -6184,6 +6221,42 @@ Sema::CanPerformCopyInitialization(const InitializedEntity &Entity,
   return !Seq.Failed();
 }
 
+ExprResult
+Sema::PerformTrivialCopyInitialization(const InitializedEntity &Entity,
+                                       Expr *Init) {
+  ++NumCopyInitializations;
+
+  switch (Entity.getKind()) {
+  case InitializedEntity::EK_Variable:
+  case InitializedEntity::EK_Parameter:
+  case InitializedEntity::EK_Result:
+    break;
+  default:
+    return ExprEmpty();
+  }
+
+  // Only a scalar initialized from an expression of the same type, which
+  // needs nothing but an lvalue-to-rvalue conversion. Pointers are left to
+  // the initialization sequence under ARC, which may have to retain their
+  // pointees or pass them by writeback.
+  QualType DestType = Entity.getType();
+  QualType SourceType = Init->getType();
+  if (DestType->isDependentType() || isa<InitListExpr>(Init) ||
+      !Context.hasSameUnqualifiedType(DestType, SourceType))
+    return ExprEmpty();
+  if (!DestType->isArithmeticType() && !DestType->isEnumeralType() &&
+      (!DestType->isPointerType() || getLangOpts().ObjCAutoRefCount))
+    return ExprEmpty();
+  if (DestType.getQualifiers().hasNonFastQualifiers() ||
+      SourceType.getQualifiers().hasNonFastQualifiers())
+    return ExprEmpty();
+
+  ++NumTrivialCopyInitializations;
+  if (Init->isGLValue())
+    return DefaultLvalueConversion(Init);
+  return Owned(Init);
+}
+
 ExprResult
 Sema::PerformCopyInitialization(const InitializedEntity &Entity,
                                 SourceLocation EqualLoc,
@@ -6196,6 +6269,10 @@ Sema::PerformCopyInitialization(const InitializedEntity &Entity,
   Expr *InitE = Init.get();
   assert(InitE && "No initialization expression?");
 
+  ExprResult Trivial = PerformTrivialCopyInitialization(Entity, InitE);
+  if (Trivial.isUsable() || Trivial.isInvalid())
+    return Trivial;
+
   if (EqualLoc.isInvalid())
     EqualLoc = InitE->getLocStart();
 
@@ -362,6 +362,9 @@ void Sema::deduceClosureReturnType(CapturingScopeInfo &CSI) {
 void Sema::ActOnStartOfLambdaDefinition(LambdaIntroducer &Intro,
                                         Declarator &ParamInfo,
                                         Scope *CurScope) {
+  // The closure type and its members can outlive the enclosing function body.
+  Context.noteFunctionBodyEscape();
+
   // Determine if we're within a context where we know that the lambda will
   // be dependent, because there are template parameters in scope.
   bool KnownDependent = false;
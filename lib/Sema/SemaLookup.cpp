@@ -854,6 +854,7 @@ bool Sema::CppLookupName(LookupResult &R, Scope *S) {
   // fact we are in a scope where it matters.
 
   Scope *Initial = S;
+  ++NumIdResolverLookups;
   IdentifierResolver::iterator
     I = IdResolver.begin(Name),
     IEnd = IdResolver.end();
@@ -883,6 +884,7 @@ bool Sema::CppLookupName(LookupResult &R, Scope *S) {
     // Check whether the IdResolver has anything in this scope.
     bool Found = false;
     for (; I != IEnd && S->isDeclScope(*I); ++I) {
+      ++NumIdResolverDeclsVisited;
       if (NamedDecl *ND = R.getAcceptableDecl(*I)) {
         Found = true;
         R.addDecl(ND);
@@ -985,6 +987,7 @@ bool Sema::CppLookupName(LookupResult &R, Scope *S) {
     // Check whether the IdResolver has anything in this scope.
     bool Found = false;
     for (; I != IEnd && S->isDeclScope(*I); ++I) {
+      ++NumIdResolverDeclsVisited;
       if (NamedDecl *ND = R.getAcceptableDecl(*I)) {
         // We found something.  Look for anything else in our scope
         // with this same name and in an acceptable identifier
@@ -1132,9 +1135,10 @@ bool Sema::LookupName(LookupResult &R, Scope *S, bool AllowBuiltinCreation) {
     // deep shadowing is extremely uncommon.
     bool LeftStartingScope = false;
 
+    ++NumIdResolverLookups;
     for (IdentifierResolver::iterator I = IdResolver.begin(Name),
                                    IEnd = IdResolver.end();
-         I != IEnd; ++I)
+         I != IEnd; ++I, ++NumIdResolverDeclsVisited)
       if ((*I)->isInIdentifierNamespace(IDNS)) {
         if (NameKind == LookupRedeclarationWithLinkage) {
           // Determine whether this (or a previous) declaration is
@@ -1157,6 +1161,7 @@ bool Sema::LookupName(LookupResult &R, Scope *S, bool AllowBuiltinCreation) {
         if (!D)
           continue;
                 
+        ++NumIdResolverDeclsVisited;
         R.addDecl(D);
 
         // Check whether there are any other declarations with the same name
@@ -1180,6 +1185,7 @@ bool Sema::LookupName(LookupResult &R, Scope *S, bool AllowBuiltinCreation) {
             
           IdentifierResolver::iterator LastI = I;
           for (++LastI; LastI != IEnd; ++LastI) {
+            ++NumIdResolverDeclsVisited;
             if (S) {
               // Match based on scope.
               if (!S->isDeclScope(*LastI))
@@ -1729,13 +1735,17 @@ namespace {
                      Sema::AssociatedNamespaceSet &Namespaces,
                      Sema::AssociatedClassSet &Classes)
       : S(S), Namespaces(Namespaces), Classes(Classes),
-        InstantiationLoc(InstantiationLoc) {
+        InstantiationLoc(InstantiationLoc), Cacheable(true) {
     }
 
     Sema &S;
     Sema::AssociatedNamespaceSet &Namespaces;
     Sema::AssociatedClassSet &Classes;
     SourceLocation InstantiationLoc;
+
+    /// \brief Whether the sets cannot grow later, because every class they
+    /// were computed from was complete.
+    bool Cacheable;
   };
 }
 
@@ -1868,9 +1878,14 @@ addAssociatedClassesAndNamespaces(AssociatedLookup &Result,
   if (!Class->hasDefinition()) {
     QualType type = Result.S.Context.getTypeDeclType(Class);
     if (Result.S.RequireCompleteType(Result.InstantiationLoc, type,
-                                     /*no diagnostic*/ 0))
+                                     /*no diagnostic*/ 0)) {
+      // The class may be defined later, with base classes.
+      Result.Cacheable = false;
       return;
+    }
   }
+  if (Class->isBeingDefined())
+    Result.Cacheable = false;
 
   // Add direct and indirect base classes along with their associated
   // namespaces.
@@ -2080,6 +2095,32 @@ Sema::FindAssociatedClassesAndNamespaces(SourceLocation InstantiationLoc,
   AssociatedNamespaces.clear();
   AssociatedClasses.clear();
 
+  // Unless an argument names a set of overloaded functions, the sets only
+  // depend on the types of the arguments, so calls with the same argument
+  // types share them.
+  llvm::FoldingSetNodeID ID;
+  bool Cacheable = true;
+  for (unsigned ArgIdx = 0; ArgIdx != Args.size(); ++ArgIdx) {
+    QualType T = Args[ArgIdx]->getType();
+    if (T == Context.OverloadTy) {
+      Cacheable = false;
+      break;
+    }
+    ID.AddPointer(Context.getCanonicalType(T).getTypePtr());
+  }
+  if (Cacheable) {
+    void *InsertPos;
+    if (AssociatedSetsCacheEntry *Entry
+          = AssociatedSetsCache.FindNodeOrInsertPos(ID, InsertPos)) {
+      ++NumAssociatedSetsCacheHits;
+      ArrayRef<DeclContext *> Namespaces = Entry->getNamespaces();
+      AssociatedNamespaces.insert(Namespaces.begin(), Namespaces.end());
+      ArrayRef<CXXRecordDecl *> Classes = Entry->getClasses();
+      AssociatedClasses.insert(Classes.begin(), Classes.end());
+      return;
+    }
+  }
+
   AssociatedLookup Result(*this, InstantiationLoc,
                           AssociatedNamespaces, AssociatedClasses);
 
@@ -2127,6 +2168,26 @@ Sema::FindAssociatedClassesAndNamespaces(SourceLocation InstantiationLoc,
       addAssociatedClassesAndNamespaces(Result, FDecl->getType());
     }
   }
+
+  if (!Cacheable || !Result.Cacheable)
+    return;
+
+  // Computing the sets may have instantiated templates which performed
+  // lookups of their own, so the insertion position found above may be
+  // stale.
+  DeclContext **Namespaces
+    = BumpAlloc.Allocate<DeclContext *>(AssociatedNamespaces.size());
+  std::copy(AssociatedNamespaces.begin(), AssociatedNamespaces.end(),
+            Namespaces);
+  CXXRecordDecl **Classes
+    = BumpAlloc.Allocate<CXXRecordDecl *>(AssociatedClasses.size());
+  std::copy(AssociatedClasses.begin(), AssociatedClasses.end(), Classes);
+  AssociatedSetsCacheEntry *Entry
+    = BumpAlloc.Allocate<AssociatedSetsCacheEntry>();
+  AssociatedSetsCache.InsertNode(
+    new (Entry) AssociatedSetsCacheEntry(ID, Namespaces,
+                                         AssociatedNamespaces.size(),
+                                         Classes, AssociatedClasses.size()));
 }
 
 /// IsAcceptableNonMemberOperatorCandidate - Determine whether Fn is
@@ -3670,6 +3731,35 @@ static bool isCandidateViable(CorrectionCandidateCallback &CCC,
   return Candidate.getEditDistance(false) != TypoCorrection::InvalidDistance;
 }
 
+ArrayRef<StringRef> Sema::getExternalTypoCandidates(unsigned Length) {
+  IdentifierInfoLookup *External = Context.Idents.getExternalIdentifierLookup();
+  if (!External)
+    return ArrayRef<StringRef>();
+
+  unsigned Generation = External->getIdentifiersGeneration();
+  if (!LoadedExternalTypoCandidates ||
+      Generation != ExternalTypoCandidatesGeneration) {
+    LoadedExternalTypoCandidates = true;
+    ExternalTypoCandidatesGeneration = Generation;
+    ExternalTypoCandidates.clear();
+
+    OwningPtr<IdentifierIterator> Iter(External->getIdentifiers());
+    do {
+      StringRef Name = Iter->Next();
+      if (Name.empty())
+        break;
+
+      if (Name.size() >= ExternalTypoCandidates.size())
+        ExternalTypoCandidates.resize(Name.size() + 1);
+      ExternalTypoCandidates[Name.size()].push_back(Name);
+    } while (true);
+  }
+
+  if (Length >= ExternalTypoCandidates.size())
+    return ArrayRef<StringRef>();
+  return ExternalTypoCandidates[Length];
+}
+
 /// \brief Try to "correct" a typo in the source code by finding
 /// visible declarations whose names are similar to the name that was
 /// present in the source code.
@@ -3813,18 +3903,21 @@ TypoCorrection Sema::CorrectTypo(const DeclarationNameInfo &TypoName,
          I != IEnd; ++I)
       Consumer.FoundName(I->getKey());
 
-    // Walk through identifiers in external identifier sources.
-    // FIXME: Re-add the ability to skip very unlikely potential corrections.
-    if (IdentifierInfoLookup *External
-                            = Context.Idents.getExternalIdentifierLookup()) {
-      OwningPtr<IdentifierIterator> Iter(External->getIdentifiers());
-      do {
-        StringRef Name = Iter->Next();
-        if (Name.empty())
-          break;
-
-        Consumer.FoundName(Name);
-      } while (true);
+    // The identifier table only gets to know the builtins that were used.
+    SmallVector<const char *, 2048> BuiltinNames;
+    Context.BuiltinInfo.getEnabledBuiltinNames(BuiltinNames);
+    for (unsigned I = 0, N = BuiltinNames.size(); I != N; ++I)
+      Consumer.FoundName(BuiltinNames[I]);
+
+    // Walk through identifiers in external identifier sources, skipping
+    // those whose length alone makes them too far from the typo.
+    unsigned TypoLength = Typo->getName().size();
+    for (unsigned Length = TypoLength - TypoLength / 3,
+                  MaxLength = TypoLength + TypoLength / 3;
+         Length <= MaxLength; ++Length) {
+      ArrayRef<StringRef> Names = getExternalTypoCandidates(Length);
+      for (unsigned I = 0, N = Names.size(); I != N; ++I)
+        Consumer.FoundName(Names[I]);
     }
   }
 
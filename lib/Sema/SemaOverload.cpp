@@ -41,8 +41,11 @@ static ExprResult
 CreateFunctionRefExpr(Sema &S, FunctionDecl *Fn, bool HadMultipleCandidates,
                       SourceLocation Loc = SourceLocation(), 
                       const DeclarationNameLoc &LocInfo = DeclarationNameLoc()){
-  DeclRefExpr *DRE = new (S.Context) DeclRefExpr(Fn, false, Fn->getType(),
-                                                 VK_LValue, Loc, LocInfo);
+  DeclRefExpr *DRE
+    = DeclRefExpr::Create(S.Context, NestedNameSpecifierLoc(),
+                          SourceLocation(), Fn, false,
+                          DeclarationNameInfo(Fn->getDeclName(), Loc, LocInfo),
+                          Fn->getType(), VK_LValue);
   if (HadMultipleCandidates)
     DRE->setHadMultipleCandidates(true);
   ExprResult E = S.Owned(DRE);
@@ -4533,6 +4536,65 @@ TryListConversion(Sema &S, InitListExpr *From, QualType ToType,
   return Result;
 }
 
+/// \brief Determine whether the conversions to or from a type can only change
+/// when the type itself does, i.e. no class named by it can still be
+/// completed.
+static bool isCompleteForConversionCache(QualType T) {
+  while (true) {
+    T = T.getCanonicalType();
+    if (const ReferenceType *RT = T->getAs<ReferenceType>())
+      T = RT->getPointeeType();
+    else if (const PointerType *PT = T->getAs<PointerType>())
+      T = PT->getPointeeType();
+    else if (const MemberPointerType *MPT = T->getAs<MemberPointerType>()) {
+      if (!isCompleteForConversionCache(QualType(MPT->getClass(), 0)))
+        return false;
+      T = MPT->getPointeeType();
+    } else if (const ArrayType *AT = T->getAsArrayTypeUnsafe())
+      T = AT->getElementType();
+    else
+      break;
+  }
+
+  if (T->isBuiltinType())
+    return !T->isPlaceholderType();
+  if (T->isRecordType() || T->isEnumeralType())
+    return !T->isIncompleteType();
+  return false;
+}
+
+/// \brief Determine whether the implicit conversion sequence which converts
+/// \p From to \p ToType during overload resolution depends only on the type
+/// and the value category of \p From.
+static bool isConversionSequenceCacheable(Sema &S, Expr *From,
+                                          QualType ToType) {
+  // Objective-C conversions depend on the expression in many ways; so do
+  // conversions of bit-fields and vector elements.
+  if (!S.getLangOpts().CPlusPlus || S.getLangOpts().ObjC1 ||
+      From->getObjectKind() != OK_Ordinary ||
+      From->isTypeDependent() || S.isSFINAEContext())
+    return false;
+
+  // A string literal can be converted to a pointer to non-const.
+  if (isa<StringLiteral>(From->IgnoreParens()))
+    return false;
+
+  QualType FromType = From->getType();
+  if (!isCompleteForConversionCache(FromType) ||
+      !isCompleteForConversionCache(ToType))
+    return false;
+
+  // An integral expression might be a null pointer constant, which matters
+  // whenever the conversion is not to an arithmetic type.
+  if (FromType->isIntegralOrEnumerationType() ||
+      FromType->isNullPtrType()) {
+    QualType T = ToType.getNonReferenceType();
+    return T->isArithmeticType() || T->isEnumeralType();
+  }
+
+  return true;
+}
+
 /// TryCopyInitialization - Try to copy-initialize a value of type
 /// ToType from the expression From. Return the implicit conversion
 /// sequence required to pass this argument, which may be a bad
@@ -4549,18 +4611,59 @@ TryCopyInitialization(Sema &S, Expr *From, QualType ToType,
     return TryListConversion(S, FromInitList, ToType, SuppressUserConversions,
                              InOverloadResolution,AllowObjCWritebackConversion);
 
+  // Overload resolution computes the same conversions over and over, e.g.
+  // for each 'operator<<' taking a stream. Look for an earlier result.
+  llvm::FoldingSetNodeID ID;
+  bool Cacheable = InOverloadResolution &&
+                   isConversionSequenceCacheable(S, From, ToType);
+  if (Cacheable) {
+    ID.AddPointer(From->getType().getAsOpaquePtr());
+    ID.AddInteger(From->Classify(S.Context).getKind());
+    ID.AddPointer(ToType.getAsOpaquePtr());
+    ID.AddBoolean(SuppressUserConversions);
+    ID.AddBoolean(AllowExplicit);
+    void *InsertPos;
+    if (Sema::ConversionSequenceCacheEntry *Entry
+          = S.ConversionSequenceCache.FindNodeOrInsertPos(ID, InsertPos)) {
+      ++S.NumConversionSequenceCacheHits;
+      ImplicitConversionSequence ICS = Entry->getConversion();
+      if (ICS.isBad())
+        ICS.Bad.FromExpr = From;
+      return ICS;
+    }
+  }
+
+  unsigned NumDiagnostics = S.NumDiagnosticsEmitted;
+  ImplicitConversionSequence ICS;
   if (ToType->isReferenceType())
-    return TryReferenceInit(S, From, ToType,
-                            /*FIXME:*/From->getLocStart(),
-                            SuppressUserConversions,
-                            AllowExplicit);
-
-  return TryImplicitConversion(S, From, ToType,
-                               SuppressUserConversions,
-                               /*AllowExplicit=*/false,
-                               InOverloadResolution,
-                               /*CStyle=*/false,
-                               AllowObjCWritebackConversion);
+    ICS = TryReferenceInit(S, From, ToType,
+                           /*FIXME:*/From->getLocStart(),
+                           SuppressUserConversions,
+                           AllowExplicit);
+  else
+    ICS = TryImplicitConversion(S, From, ToType,
+                                SuppressUserConversions,
+                                /*AllowExplicit=*/false,
+                                InOverloadResolution,
+                                /*CStyle=*/false,
+                                AllowObjCWritebackConversion);
+
+  // Ambiguous conversion sequences own memory, and a bad conversion is only
+  // reused for the expression it describes.
+  if (Cacheable && !ICS.isAmbiguous() &&
+      (!ICS.isBad() || ICS.Bad.FromExpr == From) &&
+      NumDiagnostics == S.NumDiagnosticsEmitted) {
+    // Computing the conversion may have added entries, so the insertion
+    // position found above may be stale.
+    Sema::ConversionSequenceCacheEntry *Entry
+      = S.BumpAlloc.Allocate<Sema::ConversionSequenceCacheEntry>();
+    ImplicitConversionSequence *Conversion
+      = S.BumpAlloc.Allocate<ImplicitConversionSequence>();
+    S.ConversionSequenceCache.InsertNode(
+      new (Entry) Sema::ConversionSequenceCacheEntry(
+        ID, new (Conversion) ImplicitConversionSequence(ICS)));
+  }
+  return ICS;
 }
 
 static bool TryCopyInitialization(const CanQualType FromQTy,
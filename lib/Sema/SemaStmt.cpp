@@ -145,6 +145,22 @@ static bool DiagnoseUnusedComparison(Sema &S, const Expr *E) {
   return true;
 }
 
+/// \brief Determine whether all the warnings about unused expression results
+/// are ignored at the given location.
+static bool areUnusedResultWarningsIgnored(const DiagnosticsEngine &Diags,
+                                           SourceLocation Loc) {
+  static const unsigned DiagIDs[] = {
+    diag::warn_unused_expr, diag::warn_unused_result, diag::warn_unused_call,
+    diag::warn_unused_comparison, diag::warn_unused_voidptr,
+    diag::warn_unused_volatile, diag::warn_unused_property_expr,
+    diag::warn_unused_container_subscript_expr
+  };
+  for (unsigned I = 0; I != llvm::array_lengthof(DiagIDs); ++I)
+    if (!Diags.isIgnored(DiagIDs[I], Loc))
+      return false;
+  return true;
+}
+
 void Sema::DiagnoseUnusedExprResult(const Stmt *S) {
   if (const LabelStmt *Label = dyn_cast_or_null<LabelStmt>(S))
     return DiagnoseUnusedExprResult(Label->getSubStmt());
@@ -153,6 +169,12 @@ void Sema::DiagnoseUnusedExprResult(const Stmt *S) {
   if (!E)
     return;
 
+  // Walking the expression is only worth it if it can produce a diagnostic.
+  // Messages that are unused under ARC are errors.
+  if (!getLangOpts().ObjCAutoRefCount &&
+      areUnusedResultWarningsIgnored(Diags, E->getExprLoc()))
+    return;
+
   const Expr *WarnExpr;
   SourceLocation Loc;
   SourceRange R1, R2;
@@ -44,12 +44,100 @@ static Attr *handleFallThroughAttr(Sema &S, Stmt *St, const AttributeList &A,
   return ::new (S.Context) FallThroughAttr(A.getRange(), S.Context);
 }
 
+static Attr *handleLikelihoodAttr(Sema &S, Stmt *St, const AttributeList &A,
+                                  SourceRange Range) {
+  if (A.getKind() == AttributeList::AT_Likely)
+    return ::new (S.Context) LikelyAttr(A.getRange(), S.Context);
+  return ::new (S.Context) UnlikelyAttr(A.getRange(), S.Context);
+}
+
+/// CheckForConflictingLikelihood - Diagnose a likelihood attribute on a
+/// statement which already has the opposite one.
+static bool CheckForConflictingLikelihood(Sema &S,
+                                          ArrayRef<const Attr *> Attrs,
+                                          const Attr *A) {
+  for (unsigned I = 0, N = Attrs.size(); I != N; ++I) {
+    if ((isa<LikelyAttr>(A) && isa<UnlikelyAttr>(Attrs[I])) ||
+        (isa<UnlikelyAttr>(A) && isa<LikelyAttr>(Attrs[I]))) {
+      S.Diag(A->getLocation(), diag::err_attributes_are_not_compatible)
+        << "'likely'" << "'unlikely'";
+      return true;
+    }
+  }
+  return false;
+}
+
+static Attr *handleLoopHintAttr(Sema &S, Stmt *St, const AttributeList &A,
+                                SourceRange) {
+  if (!isa<ForStmt>(St) && !isa<CXXForRangeStmt>(St) && !isa<WhileStmt>(St) &&
+      !isa<DoStmt>(St)) {
+    S.Diag(A.getLoc(), diag::err_pragma_loop_precedes_nonloop);
+    return 0;
+  }
+
+  StringRef OptionName = A.getParameterName()->getName();
+  LoopHintAttr::OptionType Option =
+    llvm::StringSwitch<LoopHintAttr::OptionType>(OptionName)
+      .Case("vectorize", LoopHintAttr::Vectorize)
+      .Case("vectorize_width", LoopHintAttr::VectorizeWidth)
+      .Case("interleave_count", LoopHintAttr::InterleaveCount)
+      .Case("unroll", LoopHintAttr::Unroll)
+      .Case("unroll_count", LoopHintAttr::UnrollCount);
+
+  // The states of the other options were turned into 0 or 1 by the parser.
+  llvm::APSInt Value;
+  Expr *ValueExpr = A.getArg(0);
+  if (!LoopHintAttr::isStateOption(Option)) {
+    bool PowerOfTwo = Option == LoopHintAttr::VectorizeWidth;
+    if (!ValueExpr->isIntegerConstantExpr(Value, S.Context) ||
+        !Value.isStrictlyPositive() || Value.getActiveBits() > 32 ||
+        (PowerOfTwo && !Value.isPowerOf2())) {
+      S.Diag(ValueExpr->getExprLoc(), diag::err_pragma_loop_invalid_value)
+        << OptionName << PowerOfTwo << ValueExpr->getSourceRange();
+      return 0;
+    }
+  } else {
+    Value = ValueExpr->EvaluateKnownConstInt(S.Context);
+  }
+
+  return ::new (S.Context) LoopHintAttr(A.getRange(), S.Context, Option,
+                                        Value.getZExtValue());
+}
+
+/// CheckForDuplicateLoopHint - Diagnose a hint of a loop which repeats an
+/// option of the hints before it.
+static bool CheckForDuplicateLoopHint(Sema &S, ArrayRef<const Attr *> Attrs,
+                                      const LoopHintAttr *Hint) {
+  for (unsigned I = 0, N = Attrs.size(); I != N; ++I) {
+    const LoopHintAttr *Other = dyn_cast<LoopHintAttr>(Attrs[I]);
+    if (!Other || Other->getOption() != Hint->getOption())
+      continue;
+
+    // Complain about whichever comes later in the source.
+    if (S.getSourceManager().isBeforeInTranslationUnit(Hint->getLocation(),
+                                                       Other->getLocation()))
+      std::swap(Hint, Other);
+    const char *OptionName = LoopHintAttr::getOptionName(Hint->getOption());
+    S.Diag(Hint->getLocation(), diag::err_pragma_loop_duplicate)
+      << OptionName;
+    S.Diag(Other->getLocation(), diag::note_pragma_loop_previous)
+      << OptionName;
+    return true;
+  }
+  return false;
+}
+
 
 static Attr *ProcessStmtAttribute(Sema &S, Stmt *St, const AttributeList &A,
                                   SourceRange Range) {
   switch (A.getKind()) {
   case AttributeList::AT_FallThrough:
     return handleFallThroughAttr(S, St, A, Range);
+  case AttributeList::AT_LoopHint:
+    return handleLoopHintAttr(S, St, A, Range);
+  case AttributeList::AT_Likely:
+  case AttributeList::AT_Unlikely:
+    return handleLikelihoodAttr(S, St, A, Range);
   default:
     // if we're here, then we parsed an attribute, but didn't recognize it as a
     // statement attribute => it is declaration attribute
@@ -63,12 +151,41 @@ StmtResult Sema::ProcessStmtAttributes(Stmt *S, AttributeList *AttrList,
                                        SourceRange Range) {
   SmallVector<const Attr*, 8> Attrs;
   for (const AttributeList* l = AttrList; l; l = l->getNext()) {
-    if (Attr *a = ProcessStmtAttribute(*this, S, *l, Range))
-      Attrs.push_back(a);
+    Attr *a = ProcessStmtAttribute(*this, S, *l, Range);
+    if (!a)
+      continue;
+    if (LoopHintAttr *Hint = dyn_cast<LoopHintAttr>(a))
+      if (CheckForDuplicateLoopHint(*this, Attrs, Hint))
+        continue;
+    if (isa<LikelyAttr>(a) || isa<UnlikelyAttr>(a))
+      if (CheckForConflictingLikelihood(*this, Attrs, a))
+        continue;
+    Attrs.push_back(a);
   }
 
   if (Attrs.empty())
     return S;
 
+  // The likelihood of a case label is that of the statement it labels, past
+  // any further labels, which is where the code generator looks for it.
+  if (isa<SwitchCase>(S)) {
+    bool OnlyLikelihood = true;
+    for (unsigned I = 0, N = Attrs.size(); I != N; ++I)
+      if (!isa<LikelyAttr>(Attrs[I]) && !isa<UnlikelyAttr>(Attrs[I]))
+        OnlyLikelihood = false;
+    if (OnlyLikelihood) {
+      SwitchCase *Label = cast<SwitchCase>(S);
+      while (SwitchCase *Inner = dyn_cast<SwitchCase>(Label->getSubStmt()))
+        Label = Inner;
+      StmtResult Sub = ActOnAttributedStmt(Range.getBegin(), Attrs,
+                                           Label->getSubStmt());
+      if (CaseStmt *CS = dyn_cast<CaseStmt>(Label))
+        CS->setSubStmt(Sub.take());
+      else
+        cast<DefaultStmt>(Label)->setSubStmt(Sub.take());
+      return S;
+    }
+  }
+
   return ActOnAttributedStmt(Range.getBegin(), Attrs, S);
 }
@@ -2158,6 +2158,127 @@ FinishTemplateArgumentDeduction(Sema &S,
   return Sema::TDK_Success;
 }
 
+/// \brief Determine whether the type \p Param of an argument of a partial
+/// specialization cannot match the type \p Arg, judging by their outermost
+/// structure alone.
+///
+/// This repeats the first step of DeduceTemplateArgumentsByTypeMatch, and
+/// returns false whenever that step would not fail by itself.
+static bool isOuterTypeMismatch(ASTContext &Context, QualType Param,
+                                QualType Arg) {
+  Param = Context.getCanonicalType(Param);
+  Arg = Context.getCanonicalType(Arg);
+  if (isa<TemplateTypeParmType>(Param) ||
+      isa<SubstTemplateTypeParmPackType>(Param) || Arg->isDependentType())
+    return false;
+
+  if (!IsPossiblyOpaquelyQualifiedType(Param) &&
+      Param.getCVRQualifiers() != Arg.getCVRQualifiers())
+    return true;
+  if (!Param->isDependentType())
+    return Param != Arg;
+
+  switch (Param->getTypeClass()) {
+  case Type::Complex:
+    return !isa<ComplexType>(Arg);
+  case Type::Atomic:
+    return !isa<AtomicType>(Arg);
+  case Type::Pointer:
+    return !isa<PointerType>(Arg) && !isa<ObjCObjectPointerType>(Arg);
+  case Type::LValueReference:
+    return !isa<LValueReferenceType>(Arg);
+  case Type::RValueReference:
+    return !isa<RValueReferenceType>(Arg);
+  case Type::MemberPointer:
+    return !isa<MemberPointerType>(Arg);
+  case Type::IncompleteArray:
+    return !Context.getAsIncompleteArrayType(Arg);
+  case Type::ConstantArray: {
+    const ConstantArrayType *ArrayArg = Context.getAsConstantArrayType(Arg);
+    return !ArrayArg ||
+           ArrayArg->getSize() !=
+             Context.getAsConstantArrayType(Param)->getSize();
+  }
+  case Type::DependentSizedArray:
+    return !Context.getAsArrayType(Arg);
+  case Type::FunctionProto:
+    return !isa<FunctionProtoType>(Arg);
+  case Type::TemplateSpecialization: {
+    const RecordType *RecordArg = dyn_cast<RecordType>(Arg);
+    ClassTemplateSpecializationDecl *SpecArg = 0;
+    if (RecordArg)
+      SpecArg = dyn_cast<ClassTemplateSpecializationDecl>(RecordArg->getDecl());
+    if (!SpecArg)
+      return true;
+
+    // A template template parameter can be deduced as any template.
+    TemplateDecl *Template = cast<TemplateSpecializationType>(Param)
+                               ->getTemplateName().getAsTemplateDecl();
+    return Template && !isa<TemplateTemplateParmDecl>(Template) &&
+           Template->getCanonicalDecl() !=
+             SpecArg->getSpecializedTemplate()->getCanonicalDecl();
+  }
+  default:
+    return false;
+  }
+}
+
+/// \brief Determine whether the arguments of \p Partial cannot match
+/// \p Args, comparing only the kinds and the outermost structure of the
+/// arguments at each position.
+///
+/// Type traits and metaprograms try many partial specializations against
+/// each argument list, and most of them fail in this way, which is much
+/// cheaper to find than by setting up a complete deduction.
+static bool
+isObviousPartialSpecMismatch(ASTContext &Context,
+                             ClassTemplatePartialSpecializationDecl *Partial,
+                             const TemplateArgumentList &Args,
+                             TemplateDeductionInfo &Info) {
+  const TemplateArgumentList &Params = Partial->getTemplateArgs();
+  for (unsigned I = 0, N = std::min(Params.size(), Args.size()); I != N; ++I) {
+    const TemplateArgument &P = Params[I];
+    const TemplateArgument &A = Args[I];
+
+    // A pack expansion is matched against all of the remaining arguments.
+    if (P.getKind() == TemplateArgument::Pack || P.isPackExpansion() ||
+        A.getKind() == TemplateArgument::Pack || A.isPackExpansion())
+      return false;
+
+    bool Mismatch = false;
+    switch (P.getKind()) {
+    case TemplateArgument::Type:
+      Mismatch = A.getKind() != TemplateArgument::Type ||
+                 isOuterTypeMismatch(Context, P.getAsType(), A.getAsType());
+      break;
+
+    case TemplateArgument::Integral:
+      Mismatch = A.getKind() != TemplateArgument::Integral ||
+                 !hasSameExtendedValue(P.getAsIntegral(), A.getAsIntegral());
+      break;
+
+    case TemplateArgument::Declaration:
+      Mismatch = A.getKind() != TemplateArgument::Declaration ||
+                 !isSameDeclaration(P.getAsDecl(), A.getAsDecl());
+      break;
+
+    case TemplateArgument::Template:
+      Mismatch = A.getKind() != TemplateArgument::Template;
+      break;
+
+    default:
+      break;
+    }
+
+    if (Mismatch) {
+      Info.FirstArg = P;
+      Info.SecondArg = A;
+      return true;
+    }
+  }
+  return false;
+}
+
 /// \brief Perform template argument deduction to determine whether
 /// the given template arguments match the given class template
 /// partial specialization per C++ [temp.class.spec.match].
@@ -2170,6 +2291,8 @@ Sema::DeduceTemplateArguments(ClassTemplatePartialSpecializationDecl *Partial,
   //   argument list if the template arguments of the partial
   //   specialization can be deduced from the actual template argument
   //   list (14.8.2).
+  if (isObviousPartialSpecMismatch(Context, Partial, TemplateArgs, Info))
+    return TDK_NonDeducedMismatch;
 
   // Unevaluated SFINAE context.
   EnterExpressionEvaluationContext Unevaluated(*this, Sema::Unevaluated);
@@ -3164,6 +3287,12 @@ Sema::DeduceTemplateArguments(FunctionTemplateDecl *FunctionTemplate,
       SavedPacks(PackIndices.size());
     PrepareArgumentPackDeduction(*this, Deduced, PackIndices, SavedPacks,
                                  NewlyDeducedPacks);
+
+    // Adjusting the pattern for an argument only strips references and
+    // qualifiers from it, which leaves the parameters it can deduce alone, so
+    // find them once rather than for each argument.
+    bool PatternHasDeducibleParameters
+      = hasDeducibleTemplateParameters(*this, FunctionTemplate, ParamPattern);
     bool HasAnyArguments = false;
     for (; ArgIdx < Args.size(); ++ArgIdx) {
       HasAnyArguments = true;
@@ -3202,7 +3331,7 @@ Sema::DeduceTemplateArguments(FunctionTemplateDecl *FunctionTemplate,
 
         // Keep track of the argument type and corresponding argument index,
         // so we can check for compatibility between the deduced A and A.
-        if (hasDeducibleTemplateParameters(*this, FunctionTemplate, ParamType))
+        if (PatternHasDeducibleParameters)
           OriginalCallArgs.push_back(OriginalCallArg(OrigParamType, ArgIdx, 
                                                      ArgType));
 
@@ -17,10 +17,12 @@
 #include "clang/Sema/Lookup.h"
 #include "clang/Sema/Template.h"
 #include "clang/Sema/TemplateDeduction.h"
+#include "clang/Sema/TemplateInstantiationProfiler.h"
 #include "clang/AST/ASTConsumer.h"
 #include "clang/AST/ASTContext.h"
 #include "clang/AST/Expr.h"
 #include "clang/AST/DeclTemplate.h"
+#include "clang/Basic/CompilationProfile.h"
 #include "clang/Basic/LangOptions.h"
 
 using namespace clang;
@@ -188,6 +190,12 @@ InstantiatingTemplate(Sema &SemaRef, SourceLocation PointOfInstantiation,
     Inst.InstantiationRange = InstantiationRange;
     SemaRef.InNonInstantiationSFINAEContext = false;
     SemaRef.ActiveTemplateInstantiations.push_back(Inst);
+    if (sema::TemplateInstantiationProfiler *Profiler
+          = SemaRef.getInstantiationProfiler())
+      Profiler->startInstantiation(Entity, PointOfInstantiation);
+    if (SemaRef.CompileProfile)
+      SemaRef.CompileProfile->startPhase(
+          CompilationProfile::TemplateInstantiation);
   }
 }
 
@@ -397,6 +405,15 @@ void Sema::InstantiatingTemplate::Clear() {
       assert(SemaRef.NonInstantiationEntries > 0);
       --SemaRef.NonInstantiationEntries;
     }
+    if (SemaRef.ActiveTemplateInstantiations.back().Kind
+          == ActiveTemplateInstantiation::TemplateInstantiation) {
+      if (sema::TemplateInstantiationProfiler *Profiler
+            = SemaRef.getInstantiationProfiler())
+        Profiler->finishInstantiation();
+      if (SemaRef.CompileProfile)
+        SemaRef.CompileProfile->stopPhase(
+            CompilationProfile::TemplateInstantiation);
+    }
     SemaRef.InNonInstantiationSFINAEContext
       = SavedInNonInstantiationSFINAEContext;
     SemaRef.ActiveTemplateInstantiations.pop_back();
@@ -409,6 +426,10 @@ bool Sema::InstantiatingTemplate::CheckInstantiationDepth(
                                            SourceRange InstantiationRange) {
   assert(SemaRef.NonInstantiationEntries <=
                                    SemaRef.ActiveTemplateInstantiations.size());
+
+  // Whatever is instantiated can outlive the function body being parsed.
+  SemaRef.Context.noteFunctionBodyEscape();
+
   if ((SemaRef.ActiveTemplateInstantiations.size() - 
           SemaRef.NonInstantiationEntries)
         <= SemaRef.getLangOpts().InstantiationDepth)
@@ -1453,6 +1474,234 @@ TypeSourceInfo *Sema::SubstType(TypeLoc TL,
   return TLB.getTypeSourceInfo(Context, Result);
 }
 
+/// \brief Add the canonical form of \p Arg to \p ID.
+///
+/// Unlike ASTContext::getCanonicalTemplateArgument, this does not allocate a
+/// canonical copy of an argument pack.
+static void profileCanonicalArgument(llvm::FoldingSetNodeID &ID,
+                                     const TemplateArgument &Arg,
+                                     ASTContext &Context) {
+  if (Arg.getKind() != TemplateArgument::Pack) {
+    Context.getCanonicalTemplateArgument(Arg).Profile(ID, Context);
+    return;
+  }
+
+  ID.AddInteger(TemplateArgument::Pack);
+  ID.AddInteger(Arg.pack_size());
+  for (TemplateArgument::pack_iterator P = Arg.pack_begin(),
+                                       PEnd = Arg.pack_end();
+       P != PEnd; ++P)
+    profileCanonicalArgument(ID, *P, Context);
+}
+
+void MultiLevelTemplateArgumentList::Profile(llvm::FoldingSetNodeID &ID,
+                                             ASTContext &Context) const {
+  ID.AddInteger(getNumLevels());
+  for (unsigned I = 0, N = getNumLevels(); I != N; ++I) {
+    const ArgList &Args = TemplateArgumentLists[I];
+    ID.AddInteger(Args.second);
+    for (unsigned J = 0; J != Args.second; ++J)
+      profileCanonicalArgument(ID, Args.first[J], Context);
+  }
+}
+
+unsigned MultiLevelTemplateArgumentList::getNumExpandedArguments() const {
+  unsigned Count = 0;
+  for (unsigned I = 0, N = getNumLevels(); I != N; ++I) {
+    const ArgList &Args = TemplateArgumentLists[I];
+    for (unsigned J = 0; J != Args.second; ++J)
+      Count += Args.first[J].getKind() == TemplateArgument::Pack ?
+                 Args.first[J].pack_size() : 1;
+  }
+  return Count;
+}
+
+/// \brief Determine whether the declaration \p D is local to a function, in
+/// which case its instantiation is found in the current local instantiation
+/// scope.
+static bool isFunctionLocalDecl(const Decl *D) {
+  return D && (isa<ParmVarDecl>(D) || D->getParentFunctionOrMethod());
+}
+
+namespace {
+/// \brief What the result of substituting into a cacheable type depends on,
+/// besides the type itself and the context of the substitution.
+struct SubstTypeDependencies {
+  /// \brief The depth and index of each template parameter named by the type.
+  SmallVector<std::pair<unsigned, unsigned>, 4> Params;
+
+  /// \brief Whether the type names members of templates, whose instantiations
+  /// are found with all of the template arguments.
+  bool NeedsAllArgs;
+
+  SubstTypeDependencies() : NeedsAllArgs(false) {}
+
+  /// \brief Note a declaration named by the type.
+  void addDecl(const Decl *D) {
+    if (D->getDeclContext()->isDependentContext())
+      NeedsAllArgs = true;
+  }
+};
+}
+
+static bool isSubstTypeCacheable(QualType T, SubstTypeDependencies &Deps);
+
+static bool isSubstTypeCacheable(const NestedNameSpecifier *NNS,
+                                 SubstTypeDependencies &Deps) {
+  for (; NNS; NNS = NNS->getPrefix()) {
+    if (const Type *T = NNS->getAsType())
+      if (!isSubstTypeCacheable(QualType(T, 0), Deps))
+        return false;
+  }
+  return true;
+}
+
+static bool isSubstTypeCacheable(TemplateName Name,
+                                 SubstTypeDependencies &Deps) {
+  if (Name.getAsSubstTemplateTemplateParmPack())
+    return false;
+  if (DependentTemplateName *DTN = Name.getAsDependentTemplateName())
+    return isSubstTypeCacheable(DTN->getQualifier(), Deps);
+  if (QualifiedTemplateName *QTN = Name.getAsQualifiedTemplateName())
+    if (!isSubstTypeCacheable(QTN->getQualifier(), Deps))
+      return false;
+
+  TemplateDecl *Template = Name.getAsTemplateDecl();
+  if (!Template)
+    return true;
+  if (isFunctionLocalDecl(Template))
+    return false;
+  if (TemplateTemplateParmDecl *Param
+        = dyn_cast<TemplateTemplateParmDecl>(Template)) {
+    if (Param->isParameterPack())
+      return false;
+    Deps.Params.push_back(std::make_pair(Param->getDepth(),
+                                         Param->getPosition()));
+    return true;
+  }
+  Deps.addDecl(Template);
+  return true;
+}
+
+static bool isSubstTypeCacheable(const TemplateArgument *Args,
+                                 unsigned NumArgs,
+                                 SubstTypeDependencies &Deps) {
+  for (unsigned I = 0; I != NumArgs; ++I) {
+    switch (Args[I].getKind()) {
+    case TemplateArgument::Type:
+      if (!isSubstTypeCacheable(Args[I].getAsType(), Deps))
+        return false;
+      break;
+    case TemplateArgument::Integral:
+      break;
+    case TemplateArgument::Template:
+      if (!isSubstTypeCacheable(Args[I].getAsTemplate(), Deps))
+        return false;
+      break;
+    default:
+      return false;
+    }
+  }
+  return true;
+}
+
+/// \brief Determine whether the result of substituting into \p T depends only
+/// on \p T, the template arguments and the context of the substitution, and
+/// collect the template arguments it depends on into \p Deps.
+///
+/// Types which refer to function-local declarations or to parameter packs,
+/// and types which contain expressions or function types, are substituted
+/// with the help of the local instantiation scope and are never cached.
+static bool isSubstTypeCacheable(QualType T, SubstTypeDependencies &Deps) {
+  while (true) {
+    const Type *Ty = T.getTypePtr();
+    switch (Ty->getTypeClass()) {
+    case Type::Builtin:
+      return true;
+
+    case Type::TemplateTypeParm: {
+      const TemplateTypeParmType *Param = cast<TemplateTypeParmType>(Ty);
+      if (Param->isParameterPack())
+        return false;
+      Deps.Params.push_back(std::make_pair(Param->getDepth(),
+                                           Param->getIndex()));
+      return true;
+    }
+
+    case Type::Record:
+    case Type::Enum:
+      if (isFunctionLocalDecl(cast<TagType>(Ty)->getDecl()))
+        return false;
+      Deps.addDecl(cast<TagType>(Ty)->getDecl());
+      return true;
+
+    case Type::InjectedClassName:
+      if (isFunctionLocalDecl(cast<InjectedClassNameType>(Ty)->getDecl()))
+        return false;
+      Deps.NeedsAllArgs = true;
+      return true;
+
+    case Type::Typedef:
+      if (isFunctionLocalDecl(cast<TypedefType>(Ty)->getDecl()))
+        return false;
+      Deps.addDecl(cast<TypedefType>(Ty)->getDecl());
+      return true;
+
+    case Type::SubstTemplateTypeParm:
+      T = cast<SubstTemplateTypeParmType>(Ty)->getReplacementType();
+      break;
+    case Type::Paren:
+      T = cast<ParenType>(Ty)->getInnerType();
+      break;
+    case Type::Pointer:
+      T = cast<PointerType>(Ty)->getPointeeType();
+      break;
+    case Type::LValueReference:
+    case Type::RValueReference:
+      T = cast<ReferenceType>(Ty)->getPointeeTypeAsWritten();
+      break;
+    case Type::MemberPointer:
+      if (!isSubstTypeCacheable(QualType(
+              cast<MemberPointerType>(Ty)->getClass(), 0), Deps))
+        return false;
+      T = cast<MemberPointerType>(Ty)->getPointeeType();
+      break;
+    case Type::ConstantArray:
+      T = cast<ConstantArrayType>(Ty)->getElementType();
+      break;
+
+    case Type::Elaborated: {
+      const ElaboratedType *ET = cast<ElaboratedType>(Ty);
+      if (!isSubstTypeCacheable(ET->getQualifier(), Deps))
+        return false;
+      T = ET->getNamedType();
+      break;
+    }
+
+    case Type::DependentName:
+      return isSubstTypeCacheable(cast<DependentNameType>(Ty)->getQualifier(),
+                                  Deps);
+
+    case Type::DependentTemplateSpecialization: {
+      const DependentTemplateSpecializationType *DTST
+        = cast<DependentTemplateSpecializationType>(Ty);
+      return isSubstTypeCacheable(DTST->getQualifier(), Deps) &&
+             isSubstTypeCacheable(DTST->getArgs(), DTST->getNumArgs(), Deps);
+    }
+
+    case Type::TemplateSpecialization: {
+      const TemplateSpecializationType *TST
+        = cast<TemplateSpecializationType>(Ty);
+      return isSubstTypeCacheable(TST->getTemplateName(), Deps) &&
+             isSubstTypeCacheable(TST->getArgs(), TST->getNumArgs(), Deps);
+    }
+
+    default:
+      return false;
+    }
+  }
+}
+
 /// Deprecated form of the above.
 QualType Sema::SubstType(QualType T,
                          const MultiLevelTemplateArgumentList &TemplateArgs,
@@ -1466,8 +1715,62 @@ QualType Sema::SubstType(QualType T,
   if (!T->isInstantiationDependentType() && !T->isVariablyModifiedType())
     return T;
 
+  // The same type is often substituted with the same arguments many times,
+  // e.g. by template argument deduction for every call to a function template
+  // or by chains of alias templates. Look for an earlier result, unless the
+  // substitution could depend on more than its inputs or have diagnostics
+  // which would need to be produced again.
+  //
+  // The key only holds the arguments of the template parameters the type
+  // names, so that its cost does not grow with the size of argument packs
+  // the type does not use. A type naming members of templates needs all of
+  // the arguments, and is not cached when they are too many to be cheaper
+  // to hash than to substitute.
+  const unsigned MaxKeyArguments = 64;
+  llvm::FoldingSetNodeID ID;
+  SubstTypeDependencies Deps;
+  bool Cacheable = !DelayedDiagnostics.shouldDelayDiagnostics() &&
+                   isSubstTypeCacheable(T, Deps) &&
+                   (!Deps.NeedsAllArgs ||
+                    TemplateArgs.getNumExpandedArguments() <= MaxKeyArguments);
+  if (Cacheable) {
+    ID.AddPointer(T.getAsOpaquePtr());
+    ID.AddPointer(CurContext);
+    ID.AddInteger(ArgumentPackSubstitutionIndex);
+    ID.AddBoolean(Deps.NeedsAllArgs);
+    if (Deps.NeedsAllArgs) {
+      TemplateArgs.Profile(ID, Context);
+    } else {
+      // Parameters without an argument are rewritten to a lower depth, which
+      // depends on the number of levels.
+      ID.AddInteger(TemplateArgs.getNumLevels());
+      for (unsigned I = 0, N = Deps.Params.size(); I != N; ++I) {
+        unsigned Depth = Deps.Params[I].first, Index = Deps.Params[I].second;
+        bool HasArg = Depth < TemplateArgs.getNumLevels() &&
+                      TemplateArgs.hasTemplateArgument(Depth, Index);
+        ID.AddBoolean(HasArg);
+        if (HasArg)
+          profileCanonicalArgument(ID, TemplateArgs(Depth, Index), Context);
+      }
+    }
+    void *InsertPos;
+    if (SubstTypeCacheEntry *Entry
+          = SubstTypeCache.FindNodeOrInsertPos(ID, InsertPos)) {
+      ++NumSubstTypeCacheHits;
+      return Entry->getResult();
+    }
+  }
+
+  unsigned NumDiagnostics = NumDiagnosticsEmitted;
   TemplateInstantiator Instantiator(*this, TemplateArgs, Loc, Entity);
-  return Instantiator.TransformType(T);
+  QualType Result = Instantiator.TransformType(T);
+  if (Cacheable && !Result.isNull() && NumDiagnostics == NumDiagnosticsEmitted) {
+    // Substitution may have instantiated templates and added entries, so the
+    // insertion position found above may be stale.
+    SubstTypeCacheEntry *Entry = BumpAlloc.Allocate<SubstTypeCacheEntry>();
+    SubstTypeCache.InsertNode(new (Entry) SubstTypeCacheEntry(ID, Result));
+  }
+  return Result;
 }
 
 static bool NeedsInstantiationAsFunctionType(TypeSourceInfo *T) {
@@ -3558,6 +3558,14 @@ NamedDecl *Sema::FindInstantiatedDecl(SourceLocation Loc, NamedDecl *D,
 
 /// \brief Performs template instantiation for all implicit template
 /// instantiations we have seen until this point.
+///
+/// FIXME: The pending instantiations are performed one at a time. They are
+/// not independent enough to be performed concurrently: instantiating a
+/// function body allocates from the ASTContext, uniques types and
+/// specializations in its folding sets, emits diagnostics, marks other
+/// declarations used (queueing more instantiations and defining implicit
+/// members and vtables), and hands the result to the ASTConsumer, none of
+/// which is thread-safe.
 void Sema::PerformPendingInstantiations(bool LocalOnly) {
   // Load pending instantiations from the external source.
   if (!LocalOnly && ExternalSource) {
@@ -3291,6 +3291,42 @@ namespace {
   };
 }
 
+/// \brief Whether the declarator can take the type source information shared
+/// by the declarations of the same type in its system header, as with
+/// -fcompact-system-type-locs.
+///
+/// That information only has the location of the first of these
+/// declarations, so only declarations whose type locations hold nothing but
+/// locations can share it. Function declarators are excluded, as their
+/// locations hold the parameters, and so are dependent types, whose
+/// locations template instantiation reads.
+static bool canShareTypeSourceInfo(Sema &S, Declarator &D, QualType T) {
+  if (!S.getLangOpts().CompactSystemTypeLocs)
+    return false;
+
+  switch (D.getContext()) {
+  case Declarator::FileContext:
+  case Declarator::KNRTypeListContext:
+  case Declarator::PrototypeContext:
+  case Declarator::MemberContext:
+  case Declarator::BlockContext:
+    break;
+  default:
+    return false;
+  }
+
+  if (T->isInstantiationDependentType() || T->isVariablyModifiedType() ||
+      T->containsUnexpandedParameterPack() || D.hasEllipsis())
+    return false;
+
+  for (unsigned i = 0, e = D.getNumTypeObjects(); i != e; ++i)
+    if (D.getTypeObject(i).Kind == DeclaratorChunk::Function)
+      return false;
+
+  SourceLocation Loc = D.getLocStart();
+  return Loc.isValid() && S.SourceMgr.isInSystemHeader(Loc);
+}
+
 /// \brief Create and instantiate a TypeSourceInfo with type source information.
 ///
 /// \param T QualType referring to the type as written in source code.
@@ -3302,6 +3338,15 @@ namespace {
 TypeSourceInfo *
 Sema::GetTypeSourceInfoForDeclarator(Declarator &D, QualType T,
                                      TypeSourceInfo *ReturnTypeInfo) {
+  if (canShareTypeSourceInfo(*this, D, T)) {
+    SourceLocation Loc = SourceMgr.getExpansionLoc(D.getLocStart());
+    TypeSourceInfo *&Shared = SharedSystemTypeSourceInfos[
+      std::make_pair(T.getAsOpaquePtr(), SourceMgr.getFileID(Loc))];
+    if (!Shared)
+      Shared = Context.getTrivialTypeSourceInfo(T, Loc);
+    return Shared;
+  }
+
   TypeSourceInfo *TInfo = Context.CreateTypeSourceInfo(T);
   UnqualTypeLoc CurrTL = TInfo->getTypeLoc().getUnqualifiedLoc();
 
@@ -0,0 +1,202 @@
+//===--- TemplateInstantiationProfiler.cpp - Instantiation costs ----------===//
+//
+//                     The LLVM Compiler Infrastructure
+//
+// This file is distributed under the University of Illinois Open Source
+// License. See LICENSE.TXT for details.
+//
+//===----------------------------------------------------------------------===//
+//
+// This file implements TemplateInstantiationProfiler.
+//
+//===----------------------------------------------------------------------===//
+
+#include "clang/Sema/TemplateInstantiationProfiler.h"
+#include "clang/AST/ASTContext.h"
+#include "clang/AST/Decl.h"
+#include "clang/Basic/ProfilingSupport.h"
+#include "clang/Basic/SourceManager.h"
+#include "llvm/ADT/StringExtras.h"
+#include "llvm/Support/Format.h"
+#include "llvm/Support/raw_ostream.h"
+#include <algorithm>
+#include <string>
+
+using namespace clang;
+using namespace sema;
+
+TemplateInstantiationProfiler::TemplateInstantiationProfiler(
+    ASTContext &Context)
+  : Context(Context), StartTime(getCurrentTimeInNanoseconds()) {}
+
+void TemplateInstantiationProfiler::startInstantiation(
+    const Decl *Specialization, SourceLocation PointOfInstantiation) {
+  ActiveInstantiation Inst;
+  Inst.Specialization = Specialization;
+  Inst.PointOfInstantiation = PointOfInstantiation;
+  Inst.Start = getCurrentTimeInNanoseconds();
+  Inst.StartBytes = Context.getASTAllocatedMemory();
+  Inst.NestedTime = 0;
+  Inst.NestedBytes = 0;
+  Active.push_back(Inst);
+}
+
+void TemplateInstantiationProfiler::finishInstantiation() {
+  assert(!Active.empty() && "no instantiation to finish");
+  ActiveInstantiation Inst = Active.pop_back_val();
+
+  uint64_t Time = getCurrentTimeInNanoseconds() - Inst.Start;
+  uint64_t Bytes = Context.getASTAllocatedMemory() - Inst.StartBytes;
+
+  Event E;
+  E.Specialization = Inst.Specialization;
+  E.PointOfInstantiation = Inst.PointOfInstantiation;
+  E.Start = Inst.Start - StartTime;
+  E.Duration = Time;
+  E.Bytes = Bytes;
+  Events.push_back(E);
+
+  // A specialization can be instantiated within itself, e.g. a member class
+  // of a class template; count the outermost instantiation only in its total.
+  bool Nested = false;
+  for (unsigned I = 0, N = Active.size(); I != N; ++I)
+    if (Active[I].Specialization == Inst.Specialization)
+      Nested = true;
+
+  SourceLocation Loc =
+    Context.getSourceManager().getExpansionLoc(Inst.PointOfInstantiation);
+  Cost *Costs[2] = { &BySpecialization[Inst.Specialization],
+                     &ByLocation[Loc.getRawEncoding()] };
+  for (unsigned I = 0; I != 2; ++I) {
+    if (!Nested) {
+      Costs[I]->TotalTime += Time;
+      Costs[I]->TotalBytes += Bytes;
+    }
+    Costs[I]->SelfTime += Time - Inst.NestedTime;
+    Costs[I]->SelfBytes += Bytes - Inst.NestedBytes;
+    ++Costs[I]->Count;
+  }
+
+  if (!Active.empty()) {
+    Active.back().NestedTime += Time;
+    Active.back().NestedBytes += Bytes;
+  }
+}
+
+//===----------------------------------------------------------------------===//
+// Reporting.
+//===----------------------------------------------------------------------===//
+
+static std::string getSpecializationName(const Decl *D,
+                                         const PrintingPolicy &Policy) {
+  std::string Name;
+  if (const NamedDecl *ND = dyn_cast<NamedDecl>(D))
+    ND->getNameForDiagnostic(Name, Policy, /*Qualified=*/true);
+  if (Name.empty())
+    Name = "<anonymous>";
+  return Name;
+}
+
+static std::string getLocationName(SourceLocation Loc,
+                                   const SourceManager &SM) {
+  PresumedLoc PLoc = SM.getPresumedLoc(Loc);
+  if (PLoc.isInvalid())
+    return "<invalid loc>";
+  return std::string(PLoc.getFilename()) + ":" + llvm::utostr(PLoc.getLine()) +
+         ":" + llvm::utostr(PLoc.getColumn());
+}
+
+namespace {
+/// \brief A line of the report.
+struct ReportLine {
+  std::string Name;
+  uint64_t TotalTime, SelfTime;
+  uint64_t TotalBytes, SelfBytes;
+  unsigned Count;
+
+  /// \brief Order the most expensive lines first.
+  bool operator<(const ReportLine &RHS) const {
+    if (SelfTime != RHS.SelfTime)
+      return SelfTime > RHS.SelfTime;
+    if (TotalTime != RHS.TotalTime)
+      return TotalTime > RHS.TotalTime;
+    return Name < RHS.Name;
+  }
+};
+}
+
+static void printReportLines(raw_ostream &OS, StringRef Title,
+                             std::vector<ReportLine> &Lines) {
+  std::sort(Lines.begin(), Lines.end());
+
+  OS << "\n  " << Title << ":\n";
+  OS << "   Total (s)    Self (s)   Total bytes    Self bytes   Count  Name\n";
+  for (unsigned I = 0, N = Lines.size(); I != N; ++I) {
+    const ReportLine &L = Lines[I];
+    OS << llvm::format("  %10.6f  %10.6f  %12llu  %12llu  %6u  ",
+                       L.TotalTime / 1e9, L.SelfTime / 1e9,
+                       (unsigned long long)L.TotalBytes,
+                       (unsigned long long)L.SelfBytes, L.Count)
+       << L.Name << '\n';
+  }
+}
+
+void TemplateInstantiationProfiler::printReport(raw_ostream &OS) const {
+  OS << "\n*** Template Instantiation Profile:\n";
+  OS << "  " << Events.size() << " instantiations.\n";
+
+  std::vector<ReportLine> Lines;
+  const PrintingPolicy &Policy = Context.getPrintingPolicy();
+  for (llvm::DenseMap<const Decl *, Cost>::const_iterator
+         I = BySpecialization.begin(), E = BySpecialization.end();
+       I != E; ++I) {
+    ReportLine L;
+    L.Name = getSpecializationName(I->first, Policy);
+    L.TotalTime = I->second.TotalTime;
+    L.SelfTime = I->second.SelfTime;
+    L.TotalBytes = I->second.TotalBytes;
+    L.SelfBytes = I->second.SelfBytes;
+    L.Count = I->second.Count;
+    Lines.push_back(L);
+  }
+  printReportLines(OS, "By specialization", Lines);
+
+  Lines.clear();
+  const SourceManager &SM = Context.getSourceManager();
+  for (llvm::DenseMap<unsigned, Cost>::const_iterator
+         I = ByLocation.begin(), E = ByLocation.end(); I != E; ++I) {
+    ReportLine L;
+    L.Name = getLocationName(SourceLocation::getFromRawEncoding(I->first), SM);
+    L.TotalTime = I->second.TotalTime;
+    L.SelfTime = I->second.SelfTime;
+    L.TotalBytes = I->second.TotalBytes;
+    L.SelfBytes = I->second.SelfBytes;
+    L.Count = I->second.Count;
+    Lines.push_back(L);
+  }
+  printReportLines(OS, "By point of instantiation", Lines);
+}
+
+
+void TemplateInstantiationProfiler::printTraceJSON(raw_ostream &OS) const {
+  const PrintingPolicy &Policy = Context.getPrintingPolicy();
+  const SourceManager &SM = Context.getSourceManager();
+
+  // Times are in microseconds.
+  OS << "{\n  \"traceEvents\": [";
+  for (unsigned I = 0, N = Events.size(); I != N; ++I) {
+    const Event &E = Events[I];
+    OS << (I == 0 ? "\n    " : ",\n    ");
+    OS << "{ \"name\": ";
+    printJSONString(OS, getSpecializationName(E.Specialization, Policy));
+    OS << ", \"cat\": \"instantiation\", \"ph\": \"X\", \"pid\": 1, "
+       << "\"tid\": 1, "
+       << llvm::format("\"ts\": %.3f, \"dur\": %.3f", E.Start / 1e3,
+                       E.Duration / 1e3)
+       << ", \"args\": { \"location\": ";
+    printJSONString(OS, getLocationName(
+                          SM.getExpansionLoc(E.PointOfInstantiation), SM));
+    OS << ", \"bytes\": " << E.Bytes << " } }";
+  }
+  OS << "\n  ]\n}\n";
+}
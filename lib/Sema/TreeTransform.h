@@ -1530,7 +1530,7 @@ public:
       ExprValueKind VK = isArrow ? VK_LValue : Base->getValueKind();
       MemberExpr *ME =
         new (getSema().Context) MemberExpr(Base, isArrow,
-                                           Member, MemberNameInfo,
+                                           Member, MemberNameInfo.getLoc(),
                                            cast<FieldDecl>(Member)->getType(),
                                            VK, OK_Ordinary);
       return getSema().Owned(ME);
@@ -14,6 +14,7 @@
 #include "ASTCommon.h"
 #include "clang/Serialization/ASTDeserializationListener.h"
 #include "clang/Basic/IdentifierTable.h"
+#include "clang/Basic/MD5.h"
 #include "llvm/ADT/StringExtras.h"
 
 using namespace clang;
@@ -78,3 +79,8 @@ unsigned serialization::ComputeHash(Selector Sel) {
       R = llvm::HashString(II->getName(), R);
   return R;
 }
+
+void serialization::ComputeContentHash(StringRef Contents,
+                                       uint32_t (&Hash)[4]) {
+  MD5::hash(Contents, Hash);
+}
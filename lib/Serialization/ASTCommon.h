@@ -58,6 +58,28 @@ TypeID MakeTypeID(ASTContext &Context, QualType T, IdxForTypeTy IdxForType) {
 
 unsigned ComputeHash(Selector Sel);
 
+/// \brief Compute the hash of the contents of an input file that
+/// deterministic AST files store in place of its modification time.
+///
+/// This is the MD5 digest of the contents, as four 32-bit words. A hash of
+/// all zeros marks files without one.
+void ComputeContentHash(StringRef Contents, uint32_t (&Hash)[4]);
+
+/// \brief The number of bits an IDENTIFIER_FILTER has per identifier.
+const unsigned IdentifierFilterBitsPerIdentifier = 16;
+
+/// \brief The smallest base-2 logarithm of the size in bits of an
+/// IDENTIFIER_FILTER.
+const unsigned MinIdentifierFilterLog2Bits = 6;
+
+/// \brief Compute the two bits an identifier whose name hashes to \p Hash
+/// sets in an IDENTIFIER_FILTER of 2^Log2Bits bits.
+inline void getIdentifierFilterBits(unsigned Hash, unsigned Log2Bits,
+                                    unsigned &Bit1, unsigned &Bit2) {
+  Bit1 = Hash & ((1U << Log2Bits) - 1);
+  Bit2 = (Hash * 0x9E3779B1U) >> (32 - Log2Bits);
+}
+
 } // namespace serialization
 
 } // namespace clang
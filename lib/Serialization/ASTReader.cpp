@@ -25,6 +25,7 @@
 #include "clang/AST/Expr.h"
 #include "clang/AST/ExprCXX.h"
 #include "clang/AST/NestedNameSpecifier.h"
+#include "clang/AST/RecordLayout.h"
 #include "clang/AST/Type.h"
 #include "clang/AST/TypeLocVisitor.h"
 #include "clang/Lex/MacroInfo.h"
@@ -36,6 +37,7 @@
 #include "clang/Basic/SourceManagerInternals.h"
 #include "clang/Basic/FileManager.h"
 #include "clang/Basic/FileSystemStatCache.h"
+#include "clang/Basic/ProfilingSupport.h"
 #include "clang/Basic/TargetInfo.h"
 #include "clang/Basic/Version.h"
 #include "clang/Basic/VersionTuple.h"
@@ -51,6 +53,9 @@
 #include <iterator>
 #include <cstdio>
 #include <sys/stat.h>
+#ifdef CLANG_HAVE_ZLIB
+#include <zlib.h>
+#endif
 
 using namespace clang;
 using namespace clang::serialization;
@@ -915,14 +920,14 @@ public:
   ~ASTStatCache() { delete Cache; }
 
   LookupResult getStat(const char *Path, struct stat &StatBuf,
-                       int *FileDescriptor) {
+                       int *FileDescriptor, VirtualFileSystem &FS) {
     // Do the lookup for the file's data in the AST file.
     CacheTy::iterator I = Cache->find(Path);
 
     // If we don't get a hit in the AST file just forward to 'stat'.
     if (I == Cache->end()) {
       ++NumStatMisses;
-      return statChained(Path, StatBuf, FileDescriptor);
+      return statChained(Path, StatBuf, FileDescriptor, FS);
     }
 
     ++NumStatHits;
@@ -1006,6 +1011,58 @@ ASTReader::ASTReadResult ASTReader::ReadSourceManagerBlock(ModuleFile &F) {
   }
 }
 
+unsigned ASTReader::readSLocBlob(llvm::BitstreamCursor &Cursor,
+                                 StringRef &Blob,
+                                 SmallVectorImpl<char> &Decompressed) {
+  RecordData Record;
+  const char *BlobStart;
+  unsigned BlobLen;
+  unsigned Code = Cursor.ReadCode();
+  unsigned RecCode = Cursor.ReadRecord(Code, Record, &BlobStart, &BlobLen);
+  Blob = StringRef(BlobStart, BlobLen);
+  if (RecCode != SM_SLOC_COMPRESSED_BLOB)
+    return RecCode;
+
+#ifdef CLANG_HAVE_ZLIB
+  ProfileScope Profile(*this, Profile_Decompression);
+  uLongf Size = Record[1];
+  Decompressed.resize(Size);
+  if (uncompress((Bytef *)Decompressed.data(), &Size,
+                 (const Bytef *)BlobStart, BlobLen) != Z_OK ||
+      Size != Record[1]) {
+    Error("malformed compressed blob in AST file");
+    return 0;
+  }
+  ++NumSLocBlobsDecompressed;
+  NumCompressedSLocBlobBytes += BlobLen;
+  NumDecompressedSLocBlobBytes += Size;
+  Blob = StringRef(Decompressed.data(), Size);
+  return Record[0];
+#else
+  Error("AST file has compressed contents, but zlib support is not available");
+  return 0;
+#endif
+}
+
+llvm::MemoryBuffer *ASTReader::readSLocBuffer(llvm::BitstreamCursor &Cursor,
+                                              StringRef Name) {
+  StringRef Blob;
+  SmallVector<char, 0> Decompressed;
+  unsigned Code = readSLocBlob(Cursor, Blob, Decompressed);
+  if (Code != SM_SLOC_BUFFER_BLOB) {
+    if (Code)
+      Error("AST record has invalid code");
+    return 0;
+  }
+
+  // The blob includes the null terminator. Uncompressed blobs are used in
+  // place, in the mapped AST file.
+  StringRef Contents = Blob.drop_back();
+  if (Decompressed.empty())
+    return llvm::MemoryBuffer::getMemBuffer(Contents, Name);
+  return llvm::MemoryBuffer::getMemBufferCopy(Contents, Name);
+}
+
 /// \brief If a header file is not found at the path that we expect it to be
 /// and the PCH file was moved from its original location, try to resolve the
 /// file by assuming that header+PCH were moved together and the header is in
@@ -1039,6 +1096,38 @@ resolveFileRelativeToOriginalDir(const std::string &Filename,
   return currPCHPath.str();
 }
 
+/// \brief Determine whether the input file of an SM_SLOC_FILE_ENTRY record
+/// changed since the AST file was built, given its current size and
+/// modification time.
+///
+/// Deterministic AST files store a hash of the contents of the file instead
+/// of its modification time, and the contents are compared then.
+static bool isInputFileModified(FileManager &FileMgr, const FileEntry *File,
+                                const ASTReader::RecordData &Record,
+                                off_t Size, time_t ModTime) {
+  if ((off_t)Record[4] != Size)
+    return true;
+
+  if (Record.size() > 13 && Record[5] == 0 &&
+      (Record[10] | Record[11] | Record[12] | Record[13]) != 0) {
+    OwningPtr<llvm::MemoryBuffer> Buffer(FileMgr.getBufferForFile(File));
+    if (!Buffer)
+      return true;
+    uint32_t Hash[4];
+    ComputeContentHash(Buffer->getBuffer(), Hash);
+    return !std::equal(Hash, Hash + 4, Record.begin() + 10);
+  }
+
+#if !defined(LLVM_ON_WIN32)
+  // In our regression testing, the Windows file system seems to
+  // have inconsistent modification times that sometimes
+  // erroneously trigger this error-handling path.
+  if ((time_t)Record[5] != ModTime)
+    return true;
+#endif
+  return false;
+}
+
 /// \brief Read in the source location entry with the given ID.
 ASTReader::ASTReadResult ASTReader::ReadSLocEntryRecord(int ID) {
   if (ID == 0)
@@ -1054,6 +1143,7 @@ ASTReader::ASTReadResult ASTReader::ReadSLocEntryRecord(int ID) {
   llvm::BitstreamCursor &SLocEntryCursor = F->SLocEntryCursor;
   unsigned BaseOffset = F->SLocEntryBaseOffset;
 
+  ProfileScope Profile(*this, Profile_SLocEntry);
   ++NumSLocEntriesRead;
   unsigned Code = SLocEntryCursor.ReadCode();
   if (Code == llvm::bitc::END_BLOCK ||
@@ -1110,14 +1200,8 @@ ASTReader::ASTReadResult ASTReader::ReadSLocEntryRecord(int ID) {
     }
 
     if (!DisableValidation &&
-        ((off_t)Record[4] != File->getSize()
-#if !defined(LLVM_ON_WIN32)
-        // In our regression testing, the Windows file system seems to
-        // have inconsistent modification times that sometimes
-        // erroneously trigger this error-handling path.
-         || (time_t)Record[5] != File->getModificationTime()
-#endif
-        )) {
+        isInputFileModified(FileMgr, File, Record, File->getSize(),
+                            File->getModificationTime())) {
       Error(diag::err_fe_pch_file_modified, Filename);
       Result = Failure;
     }
@@ -1145,27 +1229,40 @@ ASTReader::ASTReadResult ASTReader::ReadSLocEntryRecord(int ID) {
                                                              NumFileDecls));
     }
     
+    // Read the line table of the file.
+    off_t StoredSize = (off_t)Record[4];
+    StringRef LineTable;
+    SmallVector<char, 0> DecompressedLineTable;
+    unsigned LineTableCode = readSLocBlob(SLocEntryCursor, LineTable,
+                                          DecompressedLineTable);
+    if (LineTableCode != SM_SLOC_LINE_TABLE) {
+      if (LineTableCode)
+        Error("AST record has invalid code");
+      return Failure;
+    }
+
     const SrcMgr::ContentCache *ContentCache
       = SourceMgr.getOrCreateContentCache(File,
                               /*isSystemFile=*/FileCharacter != SrcMgr::C_User);
-    if (OverriddenBuffer && !ContentCache->BufferOverridden &&
-        ContentCache->ContentsEntry == ContentCache->OrigEntry) {
-      unsigned Code = SLocEntryCursor.ReadCode();
-      Record.clear();
-      unsigned RecCode
-        = SLocEntryCursor.ReadRecord(Code, Record, &BlobStart, &BlobLen);
-      
-      if (RecCode != SM_SLOC_BUFFER_BLOB) {
-        Error("AST record has invalid code");
+    // The line table describes the contents the AST file was built from.
+    bool HasSameContents = !ContentCache->BufferOverridden &&
+        ContentCache->ContentsEntry == ContentCache->OrigEntry;
+    if (OverriddenBuffer && HasSameContents) {
+      llvm::MemoryBuffer *Buffer = readSLocBuffer(SLocEntryCursor, Filename);
+      if (!Buffer)
         return Failure;
-      }
-      
-      llvm::MemoryBuffer *Buffer
-        = llvm::MemoryBuffer::getMemBuffer(StringRef(BlobStart, BlobLen - 1),
-                                           Filename);
       SourceMgr.overrideFileContents(File, Buffer);
     }
 
+    if (Result == Success && HasSameContents &&
+        StoredSize == File->getSize()) {
+      SmallVector<unsigned, 256> LineOffsets;
+      const unsigned char *Data = (const unsigned char *)LineTable.data();
+      for (unsigned L = 0, NL = LineTable.size() / 4; L != NL; ++L)
+        LineOffsets.push_back(clang::io::ReadUnalignedLE32(Data));
+      SourceMgr.setLineTable(FID, LineOffsets);
+    }
+
     if (Result == Failure)
       return Failure;
     break;
@@ -1174,26 +1271,16 @@ ASTReader::ASTReadResult ASTReader::ReadSLocEntryRecord(int ID) {
   case SM_SLOC_BUFFER_ENTRY: {
     const char *Name = BlobStart;
     unsigned Offset = Record[0];
-    unsigned Code = SLocEntryCursor.ReadCode();
-    Record.clear();
-    unsigned RecCode
-      = SLocEntryCursor.ReadRecord(Code, Record, &BlobStart, &BlobLen);
-
-    if (RecCode != SM_SLOC_BUFFER_BLOB) {
-      Error("AST record has invalid code");
+    llvm::MemoryBuffer *Buffer = readSLocBuffer(SLocEntryCursor, Name);
+    if (!Buffer)
       return Failure;
-    }
-
-    llvm::MemoryBuffer *Buffer
-      = llvm::MemoryBuffer::getMemBuffer(StringRef(BlobStart, BlobLen - 1),
-                                         Name);
     FileID BufferID = SourceMgr.createFileIDForMemBuffer(Buffer, ID,
                                                          BaseOffset + Offset);
 
     if (strcmp(Name, "<built-in>") == 0 && F->Kind == MK_PCH) {
       PCHPredefinesBlock Block = {
         BufferID,
-        StringRef(BlobStart, BlobLen - 1)
+        Buffer->getBuffer()
       };
       PCHPredefinesBuffers.push_back(Block);
     }
@@ -1264,6 +1351,7 @@ void ASTReader::ReadMacroRecord(ModuleFile &F, uint64_t Offset) {
   // Keep track of where we are in the stream, then jump back there
   // after reading this macro.
   SavedStreamPosition SavedPosition(Stream);
+  ProfileScope Profile(*this, Profile_Macro);
 
   Stream.JumpToBit(Offset);
   RecordData Record;
@@ -1516,8 +1604,10 @@ void ASTReader::ReadDefinedMacros() {
   }
   
   // Drain the unread macro-record offsets map.
+  unsigned NumMacrosReadBefore = NumMacrosRead;
   while (!UnreadMacroRecordOffsets.empty())
     LoadMacroDefinition(UnreadMacroRecordOffsets.begin());
+  NumMacrosReadInBulk += NumMacrosRead - NumMacrosReadBefore;
 }
 
 void ASTReader::LoadMacroDefinition(
@@ -1540,11 +1630,25 @@ namespace {
   /// \brief Visitor class used to look up identifirs in an AST file.
   class IdentifierLookupVisitor {
     StringRef Name;
+    unsigned NameHash;
     unsigned PriorGeneration;
     IdentifierInfo *Found;
   public:
     IdentifierLookupVisitor(StringRef Name, unsigned PriorGeneration) 
-      : Name(Name), PriorGeneration(PriorGeneration), Found() { }
+      : Name(Name), NameHash(llvm::HashString(Name)),
+        PriorGeneration(PriorGeneration), Found() { }
+
+    /// \brief Whether the identifier filter of \p M, if any, admits the name.
+    bool mayBeIn(ModuleFile &M) const {
+      if (!M.IdentifierFilter)
+        return true;
+
+      unsigned Bit1, Bit2;
+      getIdentifierFilterBits(NameHash, M.IdentifierFilterLog2Bits,
+                              Bit1, Bit2);
+      return (M.IdentifierFilter[Bit1 / 8] & (1 << (Bit1 % 8))) &&
+             (M.IdentifierFilter[Bit2 / 8] & (1 << (Bit2 % 8)));
+    }
     
     static bool visit(ModuleFile &M, void *UserData) {
       IdentifierLookupVisitor *This
@@ -1556,7 +1660,7 @@ namespace {
       
       ASTIdentifierLookupTable *IdTable
         = (ASTIdentifierLookupTable *)M.IdentifierLookupTable;
-      if (!IdTable)
+      if (!IdTable || !This->mayBeIn(M))
         return false;
       
       ASTIdentifierLookupTrait Trait(IdTable->getInfoObj().getReader(),
@@ -1583,7 +1687,7 @@ namespace {
 
 void ASTReader::updateOutOfDateIdentifier(IdentifierInfo &II) {
   unsigned PriorGeneration = 0;
-  if (getContext().getLangOpts().Modules)
+  if (getContext().getLangOpts().allowsModuleImports())
     PriorGeneration = IdentifierGeneration[&II];
   
   IdentifierLookupVisitor Visitor(II.getName(), PriorGeneration);
@@ -1598,7 +1702,7 @@ void ASTReader::markIdentifierUpToDate(IdentifierInfo *II) {
   II->setOutOfDate(false);
 
   // Update the generation for this identifier.
-  if (getContext().getLangOpts().Modules)
+  if (getContext().getLangOpts().allowsModuleImports())
     IdentifierGeneration[II] = CurrentGeneration;
 }
 
@@ -1922,6 +2026,16 @@ ASTReader::ReadASTBlock(ModuleFile &F) {
       }
       break;
 
+    case IDENTIFIER_FILTER:
+      if (Record[0] < MinIdentifierFilterLog2Bits || Record[0] > 31 ||
+          BlobLen != (1U << Record[0]) / 8) {
+        Error("malformed IDENTIFIER_FILTER record in AST file");
+        return Failure;
+      }
+      F.IdentifierFilter = (const unsigned char *)BlobStart;
+      F.IdentifierFilterLog2Bits = Record[0];
+      break;
+
     case IDENTIFIER_OFFSET: {
       if (F.LocalNumIdentifiers != 0) {
         Error("duplicate IDENTIFIER_OFFSET record in AST file");
@@ -1946,6 +2060,7 @@ ASTReader::ReadASTBlock(ModuleFile &F) {
         
         IdentifiersLoaded.resize(IdentifiersLoaded.size() 
                                  + F.LocalNumIdentifiers);
+        PP.getIdentifierTable().reserveLexerCache(IdentifiersLoaded.size());
       }
       break;
     }
@@ -1965,6 +2080,7 @@ ASTReader::ReadASTBlock(ModuleFile &F) {
       TotalNumMacros += Record[1];
       TotalLexicalDeclContexts += Record[2];
       TotalVisibleDeclContexts += Record[3];
+      TotalNumFunctionBodies += Record[4];
       break;
 
     case UNUSED_FILESCOPED_DECLS:
@@ -2333,6 +2449,14 @@ ASTReader::ReadASTBlock(ModuleFile &F) {
     case OBJC_CATEGORIES:
       F.ObjCCategories.swap(Record);
       break;
+
+    case RECORD_LAYOUTS:
+      F.RecordLayouts.swap(Record);
+      for (unsigned I = 0, N = F.RecordLayouts.size(); I + 1 < N;
+           I += F.RecordLayouts[I + 1] + 2)
+        RecordLayoutOffsets[getGlobalDeclID(F, F.RecordLayouts[I])]
+          = std::make_pair(&F, I + 2);
+      break;
         
     case CXX_BASE_SPECIFIER_OFFSETS: {
       if (F.LocalNumCXXBaseSpecifiers != 0) {
@@ -2521,14 +2645,8 @@ ASTReader::ASTReadResult ASTReader::validateFileEntries(ModuleFile &M) {
         StatBuf.st_mtime = File->getModificationTime();
       }
 
-      if ((StoredSize != StatBuf.st_size
-#if !defined(LLVM_ON_WIN32)
-          // In our regression testing, the Windows file system seems to
-          // have inconsistent modification times that sometimes
-          // erroneously trigger this error-handling path.
-           || StoredTime != StatBuf.st_mtime
-#endif
-          )) {
+      if (isInputFileModified(FileMgr, File, Record, StatBuf.st_size,
+                              StatBuf.st_mtime)) {
         Error(diag::err_fe_pch_file_modified, Filename);
         return IgnorePCH;
       }
@@ -3006,7 +3124,8 @@ std::string ASTReader::getOriginalSourceFile(const std::string &ASTFileName,
   // Open the AST file.
   std::string ErrStr;
   OwningPtr<llvm::MemoryBuffer> Buffer;
-  Buffer.reset(FileMgr.getBufferForFile(ASTFileName, &ErrStr));
+  Buffer.reset(FileMgr.getBufferForFile(ASTFileName, &ErrStr,
+                                        /*RequiresNullTerminator=*/false));
   if (!Buffer) {
     Diags.Report(diag::err_fe_unable_to_read_pch_file) << ASTFileName << ErrStr;
     return std::string();
@@ -3078,6 +3197,94 @@ std::string ASTReader::getOriginalSourceFile(const std::string &ASTFileName,
   return std::string();
 }
 
+bool ASTReader::isASTFileUpToDate(const std::string &ASTFileName,
+                                  FileManager &FileMgr) {
+  OwningPtr<llvm::MemoryBuffer> Buffer(
+    FileMgr.getBufferForFile(ASTFileName, 0,
+                             /*RequiresNullTerminator=*/false));
+  if (!Buffer)
+    return false;
+
+  llvm::BitstreamReader StreamFile;
+  llvm::BitstreamCursor Stream;
+  StreamFile.init((const unsigned char *)Buffer->getBufferStart(),
+                  (const unsigned char *)Buffer->getBufferEnd());
+  Stream.init(StreamFile);
+
+  if (Stream.Read(8) != 'C' ||
+      Stream.Read(8) != 'P' ||
+      Stream.Read(8) != 'C' ||
+      Stream.Read(8) != 'H')
+    return false;
+
+  // Only the metadata of the AST block and the file entries of its source
+  // manager block are read; every other block is skipped.
+  bool SawMetadata = false;
+  RecordData Record;
+  while (!Stream.AtEndOfStream()) {
+    unsigned Code = Stream.ReadCode();
+
+    if (Code == llvm::bitc::ENTER_SUBBLOCK) {
+      unsigned BlockID = Stream.ReadSubBlockID();
+      if (BlockID == AST_BLOCK_ID || BlockID == SOURCE_MANAGER_BLOCK_ID) {
+        if (Stream.EnterSubBlock(BlockID))
+          return false;
+      } else if (Stream.SkipBlock())
+        return false;
+      continue;
+    }
+
+    if (Code == llvm::bitc::END_BLOCK) {
+      if (Stream.ReadBlockEnd())
+        return false;
+      continue;
+    }
+
+    if (Code == llvm::bitc::DEFINE_ABBREV) {
+      Stream.ReadAbbrevRecord();
+      continue;
+    }
+
+    Record.clear();
+    const char *BlobStart = 0;
+    unsigned BlobLen = 0;
+    switch (Stream.ReadRecord(Code, Record, &BlobStart, &BlobLen)) {
+    default:
+      break;
+
+    case METADATA:
+      // The version, whether the paths are relocatable and whether there
+      // were errors.
+      if (Record.size() < 6 || Record[0] != VERSION_MAJOR || Record[4] ||
+          Record[5])
+        return false;
+      SawMetadata = true;
+      break;
+
+    case IMPORTS:
+      if (!Record.empty())
+        return false;
+      break;
+
+    case SM_SLOC_FILE_ENTRY: {
+      if (Record.size() < 7)
+        return false;
+      // If the buffer was overridden, the file need not exist.
+      if (Record[6])
+        break;
+      const FileEntry *File =
+        FileMgr.getFile(StringRef(BlobStart, BlobLen), /*OpenFile=*/false);
+      if (!File || isInputFileModified(FileMgr, File, Record, File->getSize(),
+                                       File->getModificationTime()))
+        return false;
+      break;
+    }
+    }
+  }
+
+  return SawMetadata;
+}
+
 ASTReader::ASTReadResult ASTReader::ReadSubmoduleBlock(ModuleFile &F) {
   // Enter the submodule block.
   if (F.Stream.EnterSubBlock(SUBMODULE_BLOCK_ID)) {
@@ -3731,6 +3938,7 @@ QualType ASTReader::readTypeRecord(unsigned Index) {
   SavedStreamPosition SavedPosition(DeclsCursor);
 
   ReadingKindTracker ReadingKind(Read_Type, *this);
+  ProfileScope Profile(*this, Profile_Type);
 
   // Note that we are loading a type record.
   Deserializing AType(this);
@@ -4733,6 +4941,8 @@ Stmt *ASTReader::GetExternalDeclStmt(uint64_t Offset) {
   // Offset here is a global offset across the entire chain.
   RecordLocation Loc = getLocalBitOffset(Offset);
   Loc.F->DeclsCursor.JumpToBit(Loc.Offset);
+  ++NumFunctionBodiesRead;
+  ProfileScope Profile(*this, Profile_Stmt);
   return ReadStmtFromStream(*Loc.F);
 }
 
@@ -5100,6 +5310,12 @@ void ASTReader::PassInterestingDeclsToConsumer() {
 }
 
 void ASTReader::PassInterestingDeclToConsumer(Decl *D) {
+  // Function templates and members of class templates are never emitted, and
+  // handing them to the consumer only invites it to deserialize their bodies.
+  if (FunctionDecl *FD = dyn_cast<FunctionDecl>(D))
+    if (FD->isDependentContext())
+      return;
+
   if (ObjCImplDecl *ImplD = dyn_cast<ObjCImplDecl>(D))
     PassObjCImplDeclToConsumer(ImplD, Consumer);
   else
@@ -5122,6 +5338,150 @@ void ASTReader::StartTranslationUnit(ASTConsumer *Consumer) {
   PassInterestingDeclsToConsumer();
 }
 
+/// \brief The descriptions and JSON keys of the kinds of work measured when
+/// profiling deserialization.
+static const char *const ProfileKindNames[][2] = {
+  { "source location entries", "sloc_entries" },
+  { "types", "types" },
+  { "declarations", "decls" },
+  { "function bodies", "function_bodies" },
+  { "identifiers", "identifiers" },
+  { "identifier lookups", "identifier_lookups" },
+  { "macros", "macros" },
+  { "selector lookups", "selector_lookups" },
+  { "redeclaration merges", "decl_merges" },
+  { "decompressed blobs", "decompressions" }
+};
+
+int ASTReader::enterProfileKind(ProfileKind Kind) {
+  uint64_t Now = getCurrentTimeInNanoseconds();
+  if (CurrentProfileKind >= 0)
+    ProfileTimes[CurrentProfileKind] += Now - CurrentProfileStart;
+
+  int PrevKind = CurrentProfileKind;
+  CurrentProfileKind = Kind;
+  CurrentProfileStart = Now;
+  ++ProfileCounts[Kind];
+  return PrevKind;
+}
+
+void ASTReader::leaveProfileKind(int PrevKind) {
+  uint64_t Now = getCurrentTimeInNanoseconds();
+  ProfileTimes[CurrentProfileKind] += Now - CurrentProfileStart;
+  CurrentProfileKind = PrevKind;
+  CurrentProfileStart = Now;
+}
+
+namespace {
+  /// \brief A number of declarations read from the AST files that share a
+  /// kind or a file.  Sorts by descending count, then by name.
+  struct LoadedDeclCount {
+    StringRef Name;
+    unsigned Count;
+
+    LoadedDeclCount(StringRef Name, unsigned Count)
+      : Name(Name), Count(Count) { }
+
+    bool operator<(const LoadedDeclCount &Other) const {
+      if (Count != Other.Count)
+        return Count > Other.Count;
+      return Name < Other.Name;
+    }
+  };
+}
+
+/// \brief Count the loaded declarations in \p Decls by kind and by the file
+/// in which they are declared (or expanded, for declarations written by
+/// macros).
+///
+/// This may deserialize source location entries, so it should be done after
+/// the other statistics have been collected.
+static void countLoadedDecls(const std::vector<Decl *> &Decls,
+                             SourceManager &SM,
+                             SmallVectorImpl<LoadedDeclCount> &ByKind,
+                             SmallVectorImpl<LoadedDeclCount> &ByFile) {
+  llvm::DenseMap<const char *, unsigned> KindCounts;
+  llvm::DenseMap<const FileEntry *, unsigned> FileCounts;
+  for (unsigned I = 0, N = Decls.size(); I != N; ++I) {
+    Decl *D = Decls[I];
+    if (!D)
+      continue;
+
+    ++KindCounts[D->getDeclKindName()];
+    SourceLocation Loc = D->getLocation();
+    if (Loc.isInvalid())
+      continue;
+    if (const FileEntry *File
+          = SM.getFileEntryForID(SM.getFileID(SM.getExpansionLoc(Loc))))
+      ++FileCounts[File];
+  }
+
+  for (llvm::DenseMap<const char *, unsigned>::iterator
+         I = KindCounts.begin(), E = KindCounts.end(); I != E; ++I)
+    ByKind.push_back(LoadedDeclCount(I->first, I->second));
+  for (llvm::DenseMap<const FileEntry *, unsigned>::iterator
+         I = FileCounts.begin(), E = FileCounts.end(); I != E; ++I)
+    ByFile.push_back(LoadedDeclCount(I->first->getName(), I->second));
+  std::sort(ByKind.begin(), ByKind.end());
+  std::sort(ByFile.begin(), ByFile.end());
+}
+
+const ASTRecordLayout *ASTReader::getRecordLayout(const RecordDecl *Record) {
+  llvm::DenseMap<DeclID, std::pair<ModuleFile *, unsigned> >::iterator Known
+    = RecordLayoutOffsets.find(Record->getGlobalID());
+  if (Known == RecordLayoutOffsets.end())
+    return 0;
+
+  ModuleFile &F = *Known->second.first;
+  const SmallVectorImpl<uint64_t> &Values = F.RecordLayouts;
+  unsigned Idx = Known->second.second;
+  ++NumRecordLayoutsRead;
+
+  CharUnits Size = CharUnits::fromQuantity(Values[Idx++]);
+  CharUnits DataSize = CharUnits::fromQuantity(Values[Idx++]);
+  CharUnits Alignment = CharUnits::fromQuantity(Values[Idx++]);
+  unsigned FieldCount = Values[Idx++];
+  const uint64_t *FieldOffsets = Values.data() + Idx;
+  Idx += FieldCount;
+
+  if (!Values[Idx++])
+    return new (Context) ASTRecordLayout(Context, Size, Alignment, DataSize,
+                                         FieldOffsets, FieldCount);
+
+  bool HasOwnVFPtr = Values[Idx++];
+  CharUnits VBPtrOffset = CharUnits::fromQuantity(Values[Idx++]);
+  CharUnits NonVirtualSize = CharUnits::fromQuantity(Values[Idx++]);
+  CharUnits NonVirtualAlign = CharUnits::fromQuantity(Values[Idx++]);
+  CharUnits SizeOfLargestEmptySubobject
+    = CharUnits::fromQuantity(Values[Idx++]);
+  const CXXRecordDecl *PrimaryBase
+    = GetLocalDeclAs<CXXRecordDecl>(F, Values[Idx++]);
+  bool IsPrimaryBaseVirtual = Values[Idx++];
+
+  ASTRecordLayout::BaseOffsetsMapTy BaseOffsets;
+  for (unsigned I = 0, N = Values[Idx++]; I != N; ++I) {
+    const CXXRecordDecl *Base = GetLocalDeclAs<CXXRecordDecl>(F, Values[Idx++]);
+    BaseOffsets[Base] = CharUnits::fromQuantity(Values[Idx++]);
+  }
+  ASTRecordLayout::VBaseOffsetsMapTy VBaseOffsets;
+  for (unsigned I = 0, N = Values[Idx++]; I != N; ++I) {
+    const CXXRecordDecl *Base = GetLocalDeclAs<CXXRecordDecl>(F, Values[Idx++]);
+    CharUnits Offset = CharUnits::fromQuantity(Values[Idx++]);
+    VBaseOffsets[Base] = ASTRecordLayout::VBaseInfo(Offset, Values[Idx++]);
+  }
+
+  return new (Context) ASTRecordLayout(Context, Size, Alignment, HasOwnVFPtr,
+                                       VBPtrOffset, DataSize, FieldOffsets,
+                                       FieldCount, NonVirtualSize,
+                                       NonVirtualAlign,
+                                       SizeOfLargestEmptySubobject,
+                                       PrimaryBase, IsPrimaryBaseVirtual,
+                                       BaseOffsets, VBaseOffsets);
+}
+
+/// \brief The number of files PrintStats lists the declarations of.
+static const unsigned NumFilesWithMostDeclsPrinted = 10;
+
 void ASTReader::PrintStats() {
   std::fprintf(stderr, "*** AST File Statistics:\n");
 
@@ -5166,10 +5526,29 @@ void ASTReader::PrintStats() {
     std::fprintf(stderr, "  %u/%u statements read (%f%%)\n",
                  NumStatementsRead, TotalNumStatements,
                  ((float)NumStatementsRead/TotalNumStatements * 100));
+  if (TotalNumFunctionBodies)
+    std::fprintf(stderr, "  %u/%u function bodies read (%f%%)\n",
+                 NumFunctionBodiesRead, TotalNumFunctionBodies,
+                 ((float)NumFunctionBodiesRead/TotalNumFunctionBodies * 100));
   if (TotalNumMacros)
     std::fprintf(stderr, "  %u/%u macros read (%f%%)\n",
                  NumMacrosRead, TotalNumMacros,
                  ((float)NumMacrosRead/TotalNumMacros * 100));
+  if (NumMacrosReadInBulk)
+    std::fprintf(stderr, "  %u macros read to walk all macros\n",
+                 NumMacrosReadInBulk);
+  if (!UnreadMacroRecordOffsets.empty())
+    std::fprintf(stderr, "  %u macros of loaded identifiers left unread\n",
+                 (unsigned)UnreadMacroRecordOffsets.size());
+  if (unsigned TotalNumRecordLayouts = RecordLayoutOffsets.size())
+    std::fprintf(stderr, "  %u/%u record layouts read (%f%%)\n",
+                 NumRecordLayoutsRead, TotalNumRecordLayouts,
+                 ((float)NumRecordLayoutsRead/TotalNumRecordLayouts * 100));
+  if (NumSLocBlobsDecompressed)
+    std::fprintf(stderr, "  %u compressed blobs decompressed (%llu bytes "
+                 "expanded to %llu bytes)\n", NumSLocBlobsDecompressed,
+                 (unsigned long long)NumCompressedSLocBlobBytes,
+                 (unsigned long long)NumDecompressedSLocBlobBytes);
   if (TotalLexicalDeclContexts)
     std::fprintf(stderr, "  %u/%u lexical declcontexts read (%f%%)\n",
                  NumLexicalDeclContextsRead, TotalLexicalDeclContexts,
@@ -5185,13 +5564,148 @@ void ASTReader::PrintStats() {
                  NumMethodPoolEntriesRead, TotalNumMethodPoolEntries,
                  ((float)NumMethodPoolEntriesRead/TotalNumMethodPoolEntries
                   * 100));
+    std::fprintf(stderr, "  %u method pool lookups\n", NumMethodPoolLookups);
     std::fprintf(stderr, "  %u method pool misses\n", NumMethodPoolMisses);
   }
+  std::fprintf(stderr, "  %u identifier lookups\n", NumIdentifierLookups);
+  if (NumMergeLookups)
+    std::fprintf(stderr, "  %u/%u declarations merged with an existing "
+                 "declaration (%u found by entity)\n", NumDeclsMerged,
+                 NumMergeLookups, NumMergeCandidateHits);
+
+  if (ProfileDeserialization) {
+    std::fprintf(stderr, "\n*** AST File Deserialization Times:\n");
+    for (unsigned K = 0; K != NumProfileKinds; ++K)
+      if (ProfileCounts[K])
+        std::fprintf(stderr, "  %f seconds in %u %s\n",
+                     ProfileTimes[K] / 1e9, ProfileCounts[K],
+                     ProfileKindNames[K][0]);
+  }
+
+  if (NumDeclsLoaded) {
+    SmallVector<LoadedDeclCount, 32> ByKind, ByFile;
+    countLoadedDecls(DeclsLoaded, SourceMgr, ByKind, ByFile);
+
+    std::fprintf(stderr, "\n*** AST File Declarations Read By Kind:\n");
+    for (unsigned I = 0, N = ByKind.size(); I != N; ++I)
+      std::fprintf(stderr, "  %u %s\n", ByKind[I].Count,
+                   ByKind[I].Name.str().c_str());
+
+    unsigned NumFiles = std::min(unsigned(ByFile.size()),
+                                 NumFilesWithMostDeclsPrinted);
+    std::fprintf(stderr, "\n*** AST File Declarations Read By File "
+                 "(%u of %u files):\n", NumFiles, (unsigned)ByFile.size());
+    for (unsigned I = 0; I != NumFiles; ++I)
+      std::fprintf(stderr, "  %u %s\n", ByFile[I].Count,
+                   ByFile[I].Name.str().c_str());
+  }
   std::fprintf(stderr, "\n");
   dump();
   std::fprintf(stderr, "\n");
 }
 
+
+static void printJSONReadCount(raw_ostream &OS, StringRef Key, unsigned Read,
+                               unsigned Total) {
+  OS << "    ";
+  printJSONString(OS, Key);
+  OS << ": { \"read\": " << Read << ", \"total\": " << Total << " },\n";
+}
+
+void ASTReader::PrintStatsJSON(raw_ostream &OS) {
+  unsigned NumTypesLoaded
+    = TypesLoaded.size() - std::count(TypesLoaded.begin(), TypesLoaded.end(),
+                                      QualType());
+  unsigned NumDeclsLoaded
+    = DeclsLoaded.size() - std::count(DeclsLoaded.begin(), DeclsLoaded.end(),
+                                      (Decl *)0);
+  unsigned NumIdentifiersLoaded
+    = IdentifiersLoaded.size() - std::count(IdentifiersLoaded.begin(),
+                                            IdentifiersLoaded.end(),
+                                            (IdentifierInfo *)0);
+  unsigned NumSelectorsLoaded
+    = SelectorsLoaded.size() - std::count(SelectorsLoaded.begin(),
+                                          SelectorsLoaded.end(),
+                                          Selector());
+
+  OS << "{\n  \"ast_files\": [";
+  for (ModuleManager::ModuleConstIterator M = ModuleMgr.begin(),
+                                       MEnd = ModuleMgr.end();
+       M != MEnd; ++M) {
+    OS << (M == ModuleMgr.begin() ? "\n    " : ",\n    ");
+    printJSONString(OS, (*M)->FileName);
+  }
+  OS << "\n  ],\n";
+
+  OS << "  \"counts\": {\n";
+  printJSONReadCount(OS, "sloc_entries", NumSLocEntriesRead,
+                     getTotalNumSLocs());
+  printJSONReadCount(OS, "types", NumTypesLoaded, TypesLoaded.size());
+  printJSONReadCount(OS, "decls", NumDeclsLoaded, DeclsLoaded.size());
+  printJSONReadCount(OS, "identifiers", NumIdentifiersLoaded,
+                     IdentifiersLoaded.size());
+  printJSONReadCount(OS, "selectors", NumSelectorsLoaded,
+                     SelectorsLoaded.size());
+  printJSONReadCount(OS, "statements", NumStatementsRead, TotalNumStatements);
+  printJSONReadCount(OS, "function_bodies", NumFunctionBodiesRead,
+                     TotalNumFunctionBodies);
+  printJSONReadCount(OS, "macros", NumMacrosRead, TotalNumMacros);
+  printJSONReadCount(OS, "record_layouts", NumRecordLayoutsRead,
+                     RecordLayoutOffsets.size());
+  printJSONReadCount(OS, "lexical_decl_contexts", NumLexicalDeclContextsRead,
+                     TotalLexicalDeclContexts);
+  printJSONReadCount(OS, "visible_decl_contexts", NumVisibleDeclContextsRead,
+                     TotalVisibleDeclContexts);
+  printJSONReadCount(OS, "method_pool_entries", NumMethodPoolEntriesRead,
+                     TotalNumMethodPoolEntries);
+  OS << "    \"method_pool_lookups\": " << NumMethodPoolLookups << ",\n"
+     << "    \"method_pool_misses\": " << NumMethodPoolMisses << ",\n"
+     << "    \"identifier_lookups\": " << NumIdentifierLookups << ",\n"
+     << "    \"merge_lookups\": " << NumMergeLookups << ",\n"
+     << "    \"decls_merged\": " << NumDeclsMerged << ",\n"
+     << "    \"merge_candidate_hits\": " << NumMergeCandidateHits << ",\n"
+     << "    \"stat_cache_hits\": " << NumStatHits << ",\n"
+     << "    \"stat_cache_misses\": " << NumStatMisses << ",\n"
+     << "    \"blobs_decompressed\": " << NumSLocBlobsDecompressed << ",\n"
+     << "    \"compressed_blob_bytes\": " << NumCompressedSLocBlobBytes << ",\n"
+     << "    \"decompressed_blob_bytes\": " << NumDecompressedSLocBlobBytes
+     << ",\n"
+     << "    \"macros_read_in_bulk\": " << NumMacrosReadInBulk << ",\n"
+     << "    \"unread_macros_of_loaded_identifiers\": "
+     << UnreadMacroRecordOffsets.size() << "\n"
+     << "  },\n";
+
+  // The times are only meaningful if they were measured.
+  if (ProfileDeserialization) {
+    OS << "  \"times\": {";
+    for (unsigned K = 0; K != NumProfileKinds; ++K) {
+      OS << (K == 0 ? "\n    " : ",\n    ");
+      printJSONString(OS, ProfileKindNames[K][1]);
+      OS << ": { \"count\": " << ProfileCounts[K]
+         << ", \"nanoseconds\": " << ProfileTimes[K] << " }";
+    }
+    OS << "\n  },\n";
+  }
+
+  SmallVector<LoadedDeclCount, 32> ByKind, ByFile;
+  countLoadedDecls(DeclsLoaded, SourceMgr, ByKind, ByFile);
+  OS << "  \"decls_by_kind\": {";
+  for (unsigned I = 0, N = ByKind.size(); I != N; ++I) {
+    OS << (I == 0 ? "\n    " : ",\n    ");
+    printJSONString(OS, ByKind[I].Name);
+    OS << ": " << ByKind[I].Count;
+  }
+  OS << "\n  },\n";
+  OS << "  \"decls_by_file\": [";
+  for (unsigned I = 0, N = ByFile.size(); I != N; ++I) {
+    OS << (I == 0 ? "\n    " : ",\n    ");
+    OS << "{ \"file\": ";
+    printJSONString(OS, ByFile[I].Name);
+    OS << ", \"decls\": " << ByFile[I].Count << " }";
+  }
+  OS << "\n  ]\n}\n";
+}
+
 template<typename Key, typename ModuleFile, unsigned InitialCapacity>
 static void 
 dumpModuleIDMap(StringRef Name,
@@ -5284,6 +5798,8 @@ void ASTReader::InitializeSema(Sema &S) {
 }
 
 IdentifierInfo* ASTReader::get(const char *NameStart, const char *NameEnd) {
+  ProfileScope Profile(*this, Profile_IdentifierLookup);
+  ++NumIdentifierLookups;
   IdentifierLookupVisitor Visitor(StringRef(NameStart, NameEnd - NameStart),
                                   /*PriorGeneration=*/0);
   ModuleMgr.visit(IdentifierLookupVisitor::visit, &Visitor);
@@ -5356,13 +5872,16 @@ namespace clang { namespace serialization {
     ASTReader &Reader;
     Selector Sel;
     unsigned PriorGeneration;
+    ArrayRef<ModuleFile *> Candidates;
     llvm::SmallVector<ObjCMethodDecl *, 4> InstanceMethods;
     llvm::SmallVector<ObjCMethodDecl *, 4> FactoryMethods;
 
   public:
     ReadMethodPoolVisitor(ASTReader &Reader, Selector Sel, 
-                          unsigned PriorGeneration)
-      : Reader(Reader), Sel(Sel), PriorGeneration(PriorGeneration) { }
+                          unsigned PriorGeneration,
+                          ArrayRef<ModuleFile *> Candidates)
+      : Reader(Reader), Sel(Sel), PriorGeneration(PriorGeneration),
+        Candidates(Candidates) { }
     
     static bool visit(ModuleFile &M, void *UserData) {
       ReadMethodPoolVisitor *This
@@ -5375,6 +5894,12 @@ namespace clang { namespace serialization {
       if (M.Generation <= This->PriorGeneration)
         return true;
 
+      // Only the modules in the selector index can have an entry for this
+      // selector; don't bother hashing it for the others.
+      if (std::find(This->Candidates.begin(), This->Candidates.end(), &M)
+            == This->Candidates.end())
+        return false;
+
       ASTSelectorLookupTable *PoolTable
         = (ASTSelectorLookupTable*)M.SelectorLookupTable;
       ASTSelectorLookupTable::iterator Pos = PoolTable->find(This->Sel);
@@ -5415,15 +5940,50 @@ static void addMethodsToPool(Sema &S, ArrayRef<ObjCMethodDecl *> Methods,
     S.addMethodToGlobalList(&List, Methods[I]);
   }
 }
-                             
+
+void ASTReader::updateSelectorIndex() {
+  for (ModuleIterator I = ModuleMgr.begin() + NumModulesInSelectorIndex,
+                      E = ModuleMgr.end(); I != E; ++I) {
+    if (!(*I)->SelectorLookupTable)
+      continue;
+
+    ASTSelectorLookupTable *PoolTable
+      = (ASTSelectorLookupTable*)(*I)->SelectorLookupTable;
+    for (ASTSelectorLookupTable::hash_iterator H = PoolTable->hash_begin(),
+                                            HEnd = PoolTable->hash_end();
+         H != HEnd; ++H) {
+      SmallVectorImpl<ModuleFile *> &Modules
+        = SelectorIndex[*H & 0x7FFFFFFF];
+      // Distinct selectors of one module can share a hash.
+      if (Modules.empty() || Modules.back() != *I)
+        Modules.push_back(*I);
+    }
+  }
+  NumModulesInSelectorIndex = ModuleMgr.size();
+}
+
 void ASTReader::ReadMethodPool(Selector Sel) {
+  ProfileScope Profile(*this, Profile_SelectorLookup);
+  ++NumMethodPoolLookups;
+
   // Get the selector generation and update it to the current generation.
   unsigned &Generation = SelectorGeneration[Sel];
   unsigned PriorGeneration = Generation;
   Generation = CurrentGeneration;
-  
+
+  // Find the modules that may have methods with this selector.  Most
+  // selectors are in none of them.
+  if (NumModulesInSelectorIndex != ModuleMgr.size())
+    updateSelectorIndex();
+  llvm::DenseMap<unsigned, SmallVector<ModuleFile *, 2> >::iterator Known
+    = SelectorIndex.find(serialization::ComputeHash(Sel) & 0x7FFFFFFF);
+  if (Known == SelectorIndex.end()) {
+    ++NumMethodPoolMisses;
+    return;
+  }
+
   // Search for methods defined with this selector.
-  ReadMethodPoolVisitor Visitor(*this, Sel, PriorGeneration);
+  ReadMethodPoolVisitor Visitor(*this, Sel, PriorGeneration, Known->second);
   ModuleMgr.visit(&ReadMethodPoolVisitor::visit, &Visitor);
   
   if (Visitor.getInstanceMethods().empty() &&
@@ -5646,6 +6206,7 @@ IdentifierInfo *ASTReader::DecodeIdentifierInfo(IdentifierID ID) {
 
   ID -= 1;
   if (!IdentifiersLoaded[ID]) {
+    ProfileScope Profile(*this, Profile_Identifier);
     GlobalIdentifierMapType::iterator I = GlobalIdentifierMap.find(ID + 1);
     assert(I != GlobalIdentifierMap.end() && "Corrupted global identifier map");
     ModuleFile *M = I->second;
@@ -6454,19 +7015,29 @@ ASTReader::ASTReader(Preprocessor &PP, ASTContext &Context,
     DisableValidation(DisableValidation),
     DisableStatCache(DisableStatCache),
     AllowASTWithCompilerErrors(AllowASTWithCompilerErrors), 
-    CurrentGeneration(0), CurrSwitchCaseStmts(&SwitchCaseStmts),
+    CurrentGeneration(0), NumModulesInSelectorIndex(0),
+    CurrSwitchCaseStmts(&SwitchCaseStmts),
     NumStatHits(0), NumStatMisses(0), 
     NumSLocEntriesRead(0), TotalNumSLocEntries(0), 
-    NumStatementsRead(0), TotalNumStatements(0), NumMacrosRead(0), 
-    TotalNumMacros(0), NumSelectorsRead(0), NumMethodPoolEntriesRead(0), 
+    NumStatementsRead(0), TotalNumStatements(0), NumFunctionBodiesRead(0),
+    TotalNumFunctionBodies(0), NumMacrosRead(0), 
+    TotalNumMacros(0), NumMacrosReadInBulk(0), NumRecordLayoutsRead(0),
+    NumSLocBlobsDecompressed(0), NumCompressedSLocBlobBytes(0),
+    NumDecompressedSLocBlobBytes(0), NumSelectorsRead(0),
+    NumMethodPoolEntriesRead(0), 
     NumMethodPoolMisses(0), TotalNumMethodPoolEntries(0), 
+    NumMethodPoolLookups(0), NumIdentifierLookups(0),
+    NumMergeLookups(0), NumDeclsMerged(0), NumMergeCandidateHits(0),
     NumLexicalDeclContextsRead(0), TotalLexicalDeclContexts(0), 
     NumVisibleDeclContextsRead(0), TotalVisibleDeclContexts(0),
     TotalModulesSizeInBits(0), NumCurrentElementsDeserializing(0),
     PassingDeclsToConsumer(false),
-    NumCXXBaseSpecifiersLoaded(0)
+    NumCXXBaseSpecifiersLoaded(0), ProfileDeserialization(false),
+    CurrentProfileKind(-1), CurrentProfileStart(0)
 {
   SourceMgr.setExternalSLocEntrySource(this);
+  std::fill(ProfileTimes, ProfileTimes + NumProfileKinds, 0);
+  std::fill(ProfileCounts, ProfileCounts + NumProfileKinds, 0);
 }
 
 ASTReader::~ASTReader() {
@@ -191,6 +191,11 @@ namespace clang {
     };
     
     FindExistingResult findExisting(NamedDecl *D);
+
+    /// \brief Compute the key under which D is recorded in the reader's
+    /// MergeCandidates, or return false if D is never merged with another
+    /// declaration.
+    static bool getMergeKey(NamedDecl *D, ASTReader::MergeKey &Key);
     
   public:
     ASTDeclReader(ASTReader &Reader, ModuleFile &F,
@@ -1552,9 +1557,10 @@ template<typename T>
 void ASTDeclReader::mergeRedeclarable(Redeclarable<T> *D, 
                                       RedeclarableResult &Redecl) {
   // If modules are not available, there is no reason to perform this merge.
-  if (!Reader.getContext().getLangOpts().Modules)
+  if (!Reader.getContext().getLangOpts().allowsModuleImports())
     return;
-  
+
+  ASTReader::ProfileScope Profile(Reader, ASTReader::Profile_DeclMerging);
   if (FindExistingResult ExistingRes = findExisting(static_cast<T*>(D))) {
     if (T *Existing = ExistingRes) {
       T *ExistingCanon = Existing->getCanonicalDecl();
@@ -1758,6 +1764,42 @@ static bool isSameEntity(NamedDecl *X, NamedDecl *Y) {
   return false;
 }
 
+bool ASTDeclReader::getMergeKey(NamedDecl *D, ASTReader::MergeKey &Key) {
+  // This mirrors isSameEntity(): two declarations that it considers to be the
+  // same entity have the same key.
+  unsigned Kind = D->getKind();
+  void *Signature = 0;
+  if (TypedefNameDecl *Typedef = dyn_cast<TypedefNameDecl>(D)) {
+    // Typedefs and alias declarations of the same type are the same entity.
+    Kind = Decl::Typedef;
+    Signature = D->getASTContext().getCanonicalType(
+                  Typedef->getUnderlyingType()).getAsOpaquePtr();
+  } else if (isa<ObjCInterfaceDecl>(D) || isa<ObjCProtocolDecl>(D)) {
+    // The name is enough.
+  } else if (TagDecl *Tag = dyn_cast<TagDecl>(D)) {
+    // Structs, classes and interfaces are all compatible.
+    unsigned TagKind = Tag->getTagKind();
+    if (TagKind == TTK_Class || TagKind == TTK_Interface)
+      TagKind = TTK_Struct;
+    Signature = reinterpret_cast<void *>(static_cast<uintptr_t>(TagKind));
+  } else if (isa<FunctionDecl>(D) || isa<VarDecl>(D)) {
+    // The linkage has to match too, but isSameEntity() checks that.
+    Signature = D->getASTContext().getCanonicalType(
+                  cast<ValueDecl>(D)->getType()).getAsOpaquePtr();
+  } else if (NamespaceDecl *Namespace = dyn_cast<NamespaceDecl>(D)) {
+    Signature = reinterpret_cast<void *>(
+                  static_cast<uintptr_t>(Namespace->isInline()));
+  } else {
+    return false;
+  }
+
+  DeclContext *DC = D->getDeclContext()->getRedeclContext();
+  Key = ASTReader::MergeKey(std::make_pair(DC->getPrimaryContext(),
+                                           D->getDeclName()),
+                            std::make_pair(Kind, Signature));
+  return true;
+}
+
 ASTDeclReader::FindExistingResult::~FindExistingResult() {
   if (!AddResult || Existing)
     return;
@@ -1767,7 +1809,14 @@ ASTDeclReader::FindExistingResult::~FindExistingResult() {
     Reader.SemaObj->IdResolver.tryAddTopLevelDecl(New, New->getDeclName());
   } else if (DC->isNamespace()) {
     DC->addDecl(New);
+  } else {
+    return;
   }
+
+  // Later declarations of this entity can now find New directly.
+  ASTReader::MergeKey Key;
+  if (getMergeKey(New, Key))
+    Reader.MergeCandidates.insert(std::make_pair(Key, New));
 }
 
 ASTDeclReader::FindExistingResult ASTDeclReader::findExisting(NamedDecl *D) {
@@ -1782,26 +1831,54 @@ ASTDeclReader::FindExistingResult ASTDeclReader::findExisting(NamedDecl *D) {
   DeclContext *DC = D->getDeclContext()->getRedeclContext();
   if (!DC->isFileContext())
     return FindExistingResult(Reader);
-  
+
+  ++Reader.NumMergeLookups;
+
+  // When several modules declare the same entity, the first declaration of
+  // it that was loaded or searched for is recorded under its key; check it
+  // before searching every declaration with this name.
+  ASTReader::MergeKey Key;
+  bool HasKey = getMergeKey(D, Key);
+  if (HasKey) {
+    llvm::DenseMap<ASTReader::MergeKey, NamedDecl *>::iterator Known
+      = Reader.MergeCandidates.find(Key);
+    if (Known != Reader.MergeCandidates.end() &&
+        isSameEntity(Known->second, D)) {
+      ++Reader.NumDeclsMerged;
+      ++Reader.NumMergeCandidateHits;
+      return FindExistingResult(Reader, D, Known->second);
+    }
+  }
+
+  NamedDecl *Existing = 0;
   if (DC->isTranslationUnit() && Reader.SemaObj) {
     IdentifierResolver &IdResolver = Reader.SemaObj->IdResolver;
     for (IdentifierResolver::iterator I = IdResolver.begin(Name), 
                                    IEnd = IdResolver.end();
          I != IEnd; ++I) {
-      if (isSameEntity(*I, D))
-        return FindExistingResult(Reader, D, *I);
+      if (isSameEntity(*I, D)) {
+        Existing = *I;
+        break;
+      }
     }
   }
 
-  if (DC->isNamespace()) {
+  if (!Existing && DC->isNamespace()) {
     for (DeclContext::lookup_result R = DC->lookup(Name);
          R.first != R.second; ++R.first) {
-      if (isSameEntity(*R.first, D))
-        return FindExistingResult(Reader, D, *R.first);
+      if (isSameEntity(*R.first, D)) {
+        Existing = *R.first;
+        break;
+      }
     }
   }
-  
-  return FindExistingResult(Reader, D, /*Existing=*/0);
+
+  if (Existing) {
+    ++Reader.NumDeclsMerged;
+    if (HasKey)
+      Reader.MergeCandidates.insert(std::make_pair(Key, Existing));
+  }
+  return FindExistingResult(Reader, D, Existing);
 }
 
 void ASTDeclReader::attachPreviousDecl(Decl *D, Decl *previous) {
@@ -1900,6 +1977,7 @@ Decl *ASTReader::ReadDeclRecord(DeclID ID) {
   SavedStreamPosition SavedPosition(DeclsCursor);
 
   ReadingKindTracker ReadingKind(Read_Decl, *this);
+  ProfileScope Profile(*this, Profile_Decl);
 
   // Note that we are loading a declaration record.
   Deserializing ADecl(this);
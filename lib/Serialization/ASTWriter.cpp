@@ -11,6 +11,7 @@
 //
 //===----------------------------------------------------------------------===//
 
+#define DEBUG_TYPE "ast-writer"
 #include "clang/Serialization/ASTWriter.h"
 #include "ASTCommon.h"
 #include "clang/Sema/Sema.h"
@@ -22,6 +23,7 @@
 #include "clang/AST/DeclFriend.h"
 #include "clang/AST/Expr.h"
 #include "clang/AST/ExprCXX.h"
+#include "clang/AST/RecordLayout.h"
 #include "clang/AST/Type.h"
 #include "clang/AST/TypeLocVisitor.h"
 #include "clang/Serialization/ASTReader.h"
@@ -32,6 +34,7 @@
 #include "clang/Basic/FileManager.h"
 #include "clang/Basic/FileSystemStatCache.h"
 #include "clang/Basic/OnDiskHashTable.h"
+#include "clang/Basic/Parallel.h"
 #include "clang/Basic/SourceManager.h"
 #include "clang/Basic/SourceManagerInternals.h"
 #include "clang/Basic/TargetInfo.h"
@@ -39,6 +42,7 @@
 #include "clang/Basic/VersionTuple.h"
 #include "llvm/ADT/APFloat.h"
 #include "llvm/ADT/APInt.h"
+#include "llvm/ADT/Statistic.h"
 #include "llvm/ADT/StringExtras.h"
 #include "llvm/Bitcode/BitstreamWriter.h"
 #include "llvm/Support/FileSystem.h"
@@ -48,6 +52,9 @@
 #include <cstdio>
 #include <string.h>
 #include <utility>
+#ifdef CLANG_HAVE_ZLIB
+#include <zlib.h>
+#endif
 using namespace clang;
 using namespace clang::serialization;
 
@@ -64,6 +71,79 @@ static StringRef data(const SmallVectorImpl<T> &v) {
                          sizeof(T) * v.size());
 }
 
+namespace {
+  /// \brief Orders pairs by their first elements alone, for walking the
+  /// entries of a map by a stable key rather than in the order of the map.
+  struct LessFirst {
+    template <typename T>
+    bool operator()(const T &LHS, const T &RHS) const {
+      return LHS.first < RHS.first;
+    }
+  };
+}
+
+/// \brief A key that orders declarations the same way in every run, unlike
+/// their addresses: declarations loaded from AST files come first, in the
+/// order of their IDs, and the others follow in the order of their
+/// locations.
+static uint64_t getStableDeclOrder(const Decl *D) {
+  if (D->isFromASTFile())
+    return D->getGlobalID();
+  return (uint64_t(1) << 32) | D->getLocation().getRawEncoding();
+}
+
+namespace {
+  /// \brief The stable order of a declaration, with the ties between
+  /// declarations at the same location (such as implicit ones, or those a
+  /// macro expands to) broken by their names and then by their IDs.
+  struct StableDeclKey {
+    uint64_t Order;
+    DeclarationName Name;
+    serialization::DeclID ID;
+
+    bool operator<(const StableDeclKey &RHS) const {
+      if (Order != RHS.Order)
+        return Order < RHS.Order;
+      if (int NameOrder = DeclarationName::compare(Name, RHS.Name))
+        return NameOrder < 0;
+      return ID < RHS.ID;
+    }
+  };
+}
+
+typedef llvm::DenseMap<const Decl *, serialization::DeclID> DeclIDMap;
+
+/// \brief Compute the stable key of \p D, which has the name \p Name.
+///
+/// Declarations from AST files are identified by their global IDs, and the
+/// others by the IDs \p DeclIDs assigned them so far, if any.
+static StableDeclKey getStableDeclKey(const Decl *D, DeclarationName Name,
+                                      const DeclIDMap &DeclIDs) {
+  StableDeclKey Key;
+  Key.Order = getStableDeclOrder(D);
+  Key.Name = Name;
+  Key.ID = D->isFromASTFile() ? D->getGlobalID() : DeclIDs.lookup(D);
+  return Key;
+}
+
+/// \brief Collect the entries of a map keyed by declarations in the stable
+/// order of the declarations.
+template <typename MapTy>
+static void
+getEntriesInDeclOrder(MapTy &Map, const DeclIDMap &DeclIDs,
+                      SmallVectorImpl<std::pair<StableDeclKey,
+                                                typename MapTy::iterator> > &
+                        Entries) {
+  for (typename MapTy::iterator I = Map.begin(), E = Map.end(); I != E; ++I) {
+    const Decl *D = I->first;
+    const NamedDecl *ND = dyn_cast<NamedDecl>(D);
+    Entries.push_back(std::make_pair(
+        getStableDeclKey(D, ND ? ND->getDeclName() : DeclarationName(),
+                         DeclIDs), I));
+  }
+  std::sort(Entries.begin(), Entries.end(), LessFirst());
+}
+
 //===----------------------------------------------------------------------===//
 // Type serialization
 //===----------------------------------------------------------------------===//
@@ -818,12 +898,16 @@ void ASTWriter::WriteBlockInfoBlock() {
   RECORD(MERGED_DECLARATIONS);
   RECORD(LOCAL_REDECLARATIONS);
   RECORD(OBJC_CATEGORIES);
+  RECORD(IDENTIFIER_FILTER);
+  RECORD(RECORD_LAYOUTS);
 
   // SourceManager Block.
   BLOCK(SOURCE_MANAGER_BLOCK);
   RECORD(SM_SLOC_FILE_ENTRY);
   RECORD(SM_SLOC_BUFFER_ENTRY);
   RECORD(SM_SLOC_BUFFER_BLOB);
+  RECORD(SM_SLOC_LINE_TABLE);
+  RECORD(SM_SLOC_COMPRESSED_BLOB);
   RECORD(SM_SLOC_EXPANSION_ENTRY);
 
   // Preprocessor Block.
@@ -973,6 +1057,23 @@ adjustFilenameForRelocatablePCH(const char *Filename, StringRef isysroot) {
   return Filename + Pos;
 }
 
+/// \brief Make the absolute path \p Path relative to the working directory
+/// of \p FileMgr, if it is inside it.
+static void makeRelativeToWorkingDirectory(FileManager &FileMgr,
+                                           SmallVectorImpl<char> &Path) {
+  SmallString<128> WorkingDir(FileMgr.getFileSystemOptions().WorkingDir);
+  if (WorkingDir.empty() && llvm::sys::fs::current_path(WorkingDir))
+    return;
+  llvm::sys::fs::make_absolute(WorkingDir);
+
+  StringRef PathStr(Path.data(), Path.size());
+  if (PathStr.size() <= WorkingDir.size() ||
+      !PathStr.startswith(WorkingDir) ||
+      !llvm::sys::path::is_separator(PathStr[WorkingDir.size()]))
+    return;
+  Path.erase(Path.begin(), Path.begin() + WorkingDir.size() + 1);
+}
+
 /// \brief Write the AST metadata (e.g., i686-apple-darwin9).
 void ASTWriter::WriteMetadata(ASTContext &Context, StringRef isysroot,
                               const std::string &OutputFile) {
@@ -1034,6 +1135,8 @@ void ASTWriter::WriteMetadata(ASTContext &Context, StringRef isysroot,
     SmallString<128> MainFilePath(MainFile->getName());
 
     llvm::sys::fs::make_absolute(MainFilePath);
+    if (Deterministic && isysroot.empty())
+      makeRelativeToWorkingDirectory(SM.getFileManager(), MainFilePath);
 
     const char *MainFileNameStr = MainFilePath.c_str();
     MainFileNameStr = adjustFilenameForRelocatablePCH(MainFileNameStr,
@@ -1047,8 +1150,9 @@ void ASTWriter::WriteMetadata(ASTContext &Context, StringRef isysroot,
     Stream.EmitRecord(ORIGINAL_FILE_ID, Record);
   }
 
-  // Original PCH directory
-  if (!OutputFile.empty() && OutputFile != "-") {
+  // Original PCH directory. Deterministic AST files do not record where they
+  // were built.
+  if (!Deterministic && !OutputFile.empty() && OutputFile != "-") {
     BitCodeAbbrev *Abbrev = new BitCodeAbbrev();
     Abbrev->Add(BitCodeAbbrevOp(ORIGINAL_PCH_DIR));
     Abbrev->Add(BitCodeAbbrevOp(BitCodeAbbrevOp::Blob)); // File name
@@ -1201,6 +1305,8 @@ static unsigned CreateSLocFileAbbrev(llvm::BitstreamWriter &Stream) {
   Abbrev->Add(BitCodeAbbrevOp(BitCodeAbbrevOp::VBR, 8)); // NumCreatedFIDs
   Abbrev->Add(BitCodeAbbrevOp(BitCodeAbbrevOp::VBR, 24)); // FirstDeclIndex
   Abbrev->Add(BitCodeAbbrevOp(BitCodeAbbrevOp::VBR, 8)); // NumDecls
+  for (unsigned I = 0; I != 4; ++I)
+    Abbrev->Add(BitCodeAbbrevOp(BitCodeAbbrevOp::VBR, 6)); // Content hash
   Abbrev->Add(BitCodeAbbrevOp(BitCodeAbbrevOp::Blob)); // File name
   return Stream.EmitAbbrev(Abbrev);
 }
@@ -1229,6 +1335,27 @@ static unsigned CreateSLocBufferBlobAbbrev(llvm::BitstreamWriter &Stream) {
   return Stream.EmitAbbrev(Abbrev);
 }
 
+/// \brief Create an abbreviation for a compressed blob of the source manager
+/// block.
+static unsigned CreateSLocCompressedBlobAbbrev(llvm::BitstreamWriter &Stream) {
+  using namespace llvm;
+  BitCodeAbbrev *Abbrev = new BitCodeAbbrev();
+  Abbrev->Add(BitCodeAbbrevOp(SM_SLOC_COMPRESSED_BLOB));
+  Abbrev->Add(BitCodeAbbrevOp(BitCodeAbbrevOp::VBR, 3)); // Replaced record
+  Abbrev->Add(BitCodeAbbrevOp(BitCodeAbbrevOp::VBR, 16)); // Uncompressed size
+  Abbrev->Add(BitCodeAbbrevOp(BitCodeAbbrevOp::Blob)); // Compressed blob
+  return Stream.EmitAbbrev(Abbrev);
+}
+
+/// \brief Create an abbreviation for the line table of a file.
+static unsigned CreateSLocLineTableAbbrev(llvm::BitstreamWriter &Stream) {
+  using namespace llvm;
+  BitCodeAbbrev *Abbrev = new BitCodeAbbrev();
+  Abbrev->Add(BitCodeAbbrevOp(SM_SLOC_LINE_TABLE));
+  Abbrev->Add(BitCodeAbbrevOp(BitCodeAbbrevOp::Blob)); // Line offsets
+  return Stream.EmitAbbrev(Abbrev);
+}
+
 /// \brief Create an abbreviation for the SLocEntry that refers to a macro
 /// expansion.
 static unsigned CreateSLocExpansionAbbrev(llvm::BitstreamWriter &Stream) {
@@ -1401,6 +1528,43 @@ void ASTWriter::WriteHeaderSearch(const HeaderSearch &HS, StringRef isysroot) {
     free((void*)SavedStrings[I]);
 }
 
+STATISTIC(NumCompressedSLocBlobs,
+          "The number of source manager blobs written compressed");
+STATISTIC(NumSLocBlobBytesBeforeCompression,
+          "The size of the compressed source manager blobs before compression");
+STATISTIC(NumSLocBlobBytesAfterCompression,
+          "The size of the compressed source manager blobs after compression");
+
+/// \brief Emit a blob record of the source manager block, compressed if that
+/// was requested and makes it smaller.
+void ASTWriter::EmitSLocBlob(unsigned Code, unsigned Abbrev, StringRef Blob) {
+  RecordData Record;
+#ifdef CLANG_HAVE_ZLIB
+  // Small blobs, such as the line tables of short headers, do not get much
+  // smaller but would have to be decompressed all the same.
+  if (CompressSLocBlobs && Blob.size() >= 256) {
+    uLongf CompressedSize = compressBound(Blob.size());
+    SmallVector<char, 0> Compressed(CompressedSize);
+    if (compress2((Bytef *)Compressed.data(), &CompressedSize,
+                  (const Bytef *)Blob.data(), Blob.size(),
+                  Z_DEFAULT_COMPRESSION) == Z_OK &&
+        CompressedSize < Blob.size()) {
+      ++NumCompressedSLocBlobs;
+      NumSLocBlobBytesBeforeCompression += Blob.size();
+      NumSLocBlobBytesAfterCompression += CompressedSize;
+      Record.push_back(SM_SLOC_COMPRESSED_BLOB);
+      Record.push_back(Code);
+      Record.push_back(Blob.size());
+      Stream.EmitRecordWithBlob(SLocCompressedBlobAbbrv, Record,
+                                StringRef(Compressed.data(), CompressedSize));
+      return;
+    }
+  }
+#endif
+  Record.push_back(Code);
+  Stream.EmitRecordWithBlob(Abbrev, Record, Blob);
+}
+
 /// \brief Writes the block containing the serialized form of the
 /// source manager.
 ///
@@ -1422,6 +1586,12 @@ void ASTWriter::WriteSourceManagerBlock(SourceManager &SourceMgr,
   unsigned SLocBufferAbbrv = CreateSLocBufferAbbrev(Stream);
   unsigned SLocBufferBlobAbbrv = CreateSLocBufferBlobAbbrev(Stream);
   unsigned SLocExpansionAbbrv = CreateSLocExpansionAbbrev(Stream);
+  unsigned SLocLineTableAbbrv = CreateSLocLineTableAbbrev(Stream);
+  SLocCompressedBlobAbbrv = CreateSLocCompressedBlobAbbrev(Stream);
+
+  // Every file entry carries its line table. Compute the missing ones up
+  // front, in parallel when possible.
+  SourceMgr.startLineTablePrecomputation();
 
   // Write out the source location entry table. We skip the first
   // entry, which is always the same dummy entry.
@@ -1469,9 +1639,11 @@ void ASTWriter::WriteSourceManagerBlock(SourceManager &SourceMgr,
         // The source location entry is a file. The blob associated
         // with this entry is the file name.
 
-        // Emit size/modification time for this file.
+        // Emit size/modification time for this file. Deterministic AST
+        // files store no time, and a hash of the contents instead.
         Record.push_back(Content->OrigEntry->getSize());
-        Record.push_back(Content->OrigEntry->getModificationTime());
+        Record.push_back(Deterministic ? 0
+                           : Content->OrigEntry->getModificationTime());
         Record.push_back(Content->BufferOverridden);
         Record.push_back(File.NumCreatedFIDs);
         
@@ -1483,6 +1655,14 @@ void ASTWriter::WriteSourceManagerBlock(SourceManager &SourceMgr,
           Record.push_back(0);
           Record.push_back(0);
         }
+
+        uint32_t ContentHash[4] = { 0, 0, 0, 0 };
+        if (Deterministic && !Content->BufferOverridden) {
+          const llvm::MemoryBuffer *Buffer
+            = Content->getBuffer(PP.getDiagnostics(), PP.getSourceManager());
+          ComputeContentHash(Buffer->getBuffer(), ContentHash);
+        }
+        Record.append(ContentHash, ContentHash + 4);
         
         // Turn the file name into an absolute path, if it isn't already.
         const char *Filename = Content->OrigEntry->getName();
@@ -1495,19 +1675,32 @@ void ASTWriter::WriteSourceManagerBlock(SourceManager &SourceMgr,
         // FIXME: This call to make_absolute shouldn't be necessary, the
         // call to FixupRelativePath should always return an absolute path.
         llvm::sys::fs::make_absolute(FilePath);
+        if (Deterministic && isysroot.empty())
+          makeRelativeToWorkingDirectory(SourceMgr.getFileManager(),
+                                         FilePath);
         Filename = FilePath.c_str();
 
         Filename = adjustFilenameForRelocatablePCH(Filename, isysroot);
         Stream.EmitRecordWithBlob(SLocFileAbbrv, Record, Filename);
-        
+
+        // Emit the line table, so that clients don't need to scan the file to
+        // map locations to line numbers.
+        SmallString<256> LineTable;
+        {
+          llvm::raw_svector_ostream Out(LineTable);
+          ArrayRef<unsigned> LineOffsets
+            = SourceMgr.getLineTable(FileID::get(I));
+          for (unsigned L = 0, NL = LineOffsets.size(); L != NL; ++L)
+            clang::io::Emit32(Out, LineOffsets[L]);
+        }
+        EmitSLocBlob(SM_SLOC_LINE_TABLE, SLocLineTableAbbrv, LineTable.str());
+
         if (Content->BufferOverridden) {
-          Record.clear();
-          Record.push_back(SM_SLOC_BUFFER_BLOB);
           const llvm::MemoryBuffer *Buffer
             = Content->getBuffer(PP.getDiagnostics(), PP.getSourceManager());
-          Stream.EmitRecordWithBlob(SLocBufferBlobAbbrv, Record,
-                                    StringRef(Buffer->getBufferStart(),
-                                              Buffer->getBufferSize() + 1));          
+          EmitSLocBlob(SM_SLOC_BUFFER_BLOB, SLocBufferBlobAbbrv,
+                       StringRef(Buffer->getBufferStart(),
+                                 Buffer->getBufferSize() + 1));
         }
       } else {
         // The source location entry is a buffer. The blob associated
@@ -1521,11 +1714,9 @@ void ASTWriter::WriteSourceManagerBlock(SourceManager &SourceMgr,
         const char *Name = Buffer->getBufferIdentifier();
         Stream.EmitRecordWithBlob(SLocBufferAbbrv, Record,
                                   StringRef(Name, strlen(Name) + 1));
-        Record.clear();
-        Record.push_back(SM_SLOC_BUFFER_BLOB);
-        Stream.EmitRecordWithBlob(SLocBufferBlobAbbrv, Record,
-                                  StringRef(Buffer->getBufferStart(),
-                                                  Buffer->getBufferSize() + 1));
+        EmitSLocBlob(SM_SLOC_BUFFER_BLOB, SLocBufferBlobAbbrv,
+                     StringRef(Buffer->getBufferStart(),
+                               Buffer->getBufferSize() + 1));
 
         if (strcmp(Name, "<built-in>") == 0) {
           PreloadSLocs.push_back(SLocEntryOffsets.size());
@@ -2115,6 +2306,123 @@ void ASTWriter::WriteCXXBaseSpecifiersOffsets() {
                             data(CXXBaseSpecifiersOffsets));
 }
 
+namespace {
+/// \brief Orders the record layouts by the ID of their record, so that the
+/// AST file does not depend on the order of the layout map.
+struct RecordLayoutEntry {
+  DeclID ID;
+  const RecordDecl *Record;
+  const ASTRecordLayout *Layout;
+
+  bool operator<(const RecordLayoutEntry &RHS) const { return ID < RHS.ID; }
+};
+
+/// \brief Orders the base classes of a record by their ID.
+struct BaseOffsetEntry {
+  DeclID ID;
+  CharUnits Offset;
+  bool HasVtorDisp;
+
+  bool operator<(const BaseOffsetEntry &RHS) const { return ID < RHS.ID; }
+};
+}
+
+/// \brief Write the layouts of the records laid out while building the AST
+/// file.
+///
+/// Each layout is the record ID, the number of values which follow, and
+/// the values of the ASTRecordLayout. A layout which refers to a record
+/// that has not been written is left out.
+void ASTWriter::WriteRecordLayouts(ASTContext &Context) {
+  SmallVector<RecordLayoutEntry, 16> Layouts;
+  for (llvm::DenseMap<const RecordDecl *, const ASTRecordLayout *>::iterator
+         I = Context.ASTRecordLayouts.begin(),
+         E = Context.ASTRecordLayouts.end(); I != E; ++I) {
+    if (!I->second || (!I->first->isFromASTFile() && !DeclIDs.count(I->first)))
+      continue;
+    RecordLayoutEntry Entry = { getDeclID(I->first), I->first, I->second };
+    Layouts.push_back(Entry);
+  }
+  if (Layouts.empty())
+    return;
+  std::sort(Layouts.begin(), Layouts.end());
+
+  RecordData Record;
+  SmallVector<BaseOffsetEntry, 4> Bases, VBases;
+  for (unsigned I = 0, N = Layouts.size(); I != N; ++I) {
+    const ASTRecordLayout &Layout = *Layouts[I].Layout;
+
+    // Find the IDs of the bases first, since they may not have been written.
+    Bases.clear();
+    VBases.clear();
+    bool Written = true;
+    if (const ASTRecordLayout::CXXRecordLayoutInfo *CXXInfo = Layout.CXXInfo) {
+      for (ASTRecordLayout::BaseOffsetsMapTy::const_iterator
+             B = CXXInfo->BaseOffsets.begin(), BE = CXXInfo->BaseOffsets.end();
+           B != BE; ++B) {
+        if (!B->first->isFromASTFile() && !DeclIDs.count(B->first)) {
+          Written = false;
+          break;
+        }
+        BaseOffsetEntry Base = { getDeclID(B->first), B->second, false };
+        Bases.push_back(Base);
+      }
+      for (ASTRecordLayout::VBaseOffsetsMapTy::const_iterator
+             B = CXXInfo->VBaseOffsets.begin(),
+             BE = CXXInfo->VBaseOffsets.end(); Written && B != BE; ++B) {
+        if (!B->first->isFromASTFile() && !DeclIDs.count(B->first)) {
+          Written = false;
+          break;
+        }
+        BaseOffsetEntry Base = { getDeclID(B->first), B->second.VBaseOffset,
+                                 B->second.hasVtorDisp() };
+        VBases.push_back(Base);
+      }
+    }
+    // The primary base is one of the bases, so it has been written too.
+    if (!Written)
+      continue;
+    std::sort(Bases.begin(), Bases.end());
+    std::sort(VBases.begin(), VBases.end());
+
+    Record.push_back(Layouts[I].ID);
+    unsigned SizeIdx = Record.size();
+    Record.push_back(0);
+    Record.push_back(Layout.getSize().getQuantity());
+    Record.push_back(Layout.getDataSize().getQuantity());
+    Record.push_back(Layout.getAlignment().getQuantity());
+    Record.push_back(Layout.getFieldCount());
+    for (unsigned F = 0, FN = Layout.getFieldCount(); F != FN; ++F)
+      Record.push_back(Layout.getFieldOffset(F));
+
+    Record.push_back(Layout.CXXInfo != 0);
+    if (Layout.CXXInfo) {
+      Record.push_back(Layout.hasOwnVFPtr());
+      Record.push_back(Layout.getVBPtrOffset().getQuantity());
+      Record.push_back(Layout.getNonVirtualSize().getQuantity());
+      Record.push_back(Layout.getNonVirtualAlign().getQuantity());
+      Record.push_back(Layout.getSizeOfLargestEmptySubobject().getQuantity());
+      Record.push_back(getDeclID(Layout.getPrimaryBase()));
+      Record.push_back(Layout.isPrimaryBaseVirtual());
+      Record.push_back(Bases.size());
+      for (unsigned B = 0, BN = Bases.size(); B != BN; ++B) {
+        Record.push_back(Bases[B].ID);
+        Record.push_back(Bases[B].Offset.getQuantity());
+      }
+      Record.push_back(VBases.size());
+      for (unsigned B = 0, BN = VBases.size(); B != BN; ++B) {
+        Record.push_back(VBases[B].ID);
+        Record.push_back(VBases[B].Offset.getQuantity());
+        Record.push_back(VBases[B].HasVtorDisp);
+      }
+    }
+    Record[SizeIdx] = Record.size() - SizeIdx - 1;
+  }
+
+  if (!Record.empty())
+    Stream.EmitRecord(RECORD_LAYOUTS, Record);
+}
+
 //===----------------------------------------------------------------------===//
 // Type Serialization
 //===----------------------------------------------------------------------===//
@@ -2226,11 +2534,18 @@ void ASTWriter::WriteFileDeclIDsMap() {
   using namespace llvm;
   RecordData Record;
 
-  // Join the vectors of DeclIDs from all files.
-  SmallVector<DeclID, 256> FileSortedIDs;
+  // Join the vectors of DeclIDs from all files, in the order of the files in
+  // the source manager rather than that of the map, which depends on the
+  // addresses of the SLocEntries.
+  SmallVector<std::pair<unsigned, DeclIDInFileInfo *>, 64> SortedFiles;
   for (FileDeclIDsTy::iterator
-         FI = FileDeclIDs.begin(), FE = FileDeclIDs.end(); FI != FE; ++FI) {
-    DeclIDInFileInfo &Info = *FI->second;
+         FI = FileDeclIDs.begin(), FE = FileDeclIDs.end(); FI != FE; ++FI)
+    SortedFiles.push_back(std::make_pair(FI->first->getOffset(), FI->second));
+  std::sort(SortedFiles.begin(), SortedFiles.end());
+
+  SmallVector<DeclID, 256> FileSortedIDs;
+  for (unsigned I = 0, N = SortedFiles.size(); I != N; ++I) {
+    DeclIDInFileInfo &Info = *SortedFiles[I].second;
     Info.FirstDeclIndex = FileSortedIDs.size();
     for (LocDeclIDsTy::iterator
            DI = Info.DeclIDs.begin(), DE = Info.DeclIDs.end(); DI != DE; ++DI)
@@ -2368,15 +2683,24 @@ void ASTWriter::WriteSelectors(Sema &SemaRef) {
     ASTMethodPoolTrait Trait(*this);
 
     // Create the on-disk hash table representation. We walk through every
-    // selector we've seen and look it up in the method pool.
-    SelectorOffsets.resize(NextSelectorID - FirstSelectorID);
+    // selector we've seen, in the order of their IDs so that the layout of
+    // the table does not depend on their addresses, and look it up in the
+    // method pool.
+    SmallVector<std::pair<SelectorID, Selector>, 64> Selectors;
     for (llvm::DenseMap<Selector, SelectorID>::iterator
              I = SelectorIDs.begin(), E = SelectorIDs.end();
+         I != E; ++I)
+      Selectors.push_back(std::make_pair(I->second, I->first));
+    std::sort(Selectors.begin(), Selectors.end(), LessFirst());
+
+    SelectorOffsets.resize(NextSelectorID - FirstSelectorID);
+    for (SmallVectorImpl<std::pair<SelectorID, Selector> >::iterator
+             I = Selectors.begin(), E = Selectors.end();
          I != E; ++I) {
-      Selector S = I->first;
+      Selector S = I->second;
       Sema::GlobalMethodPool::iterator F = SemaRef.MethodPool.find(S);
       ASTMethodPoolTrait::data_type Data = {
-        I->second,
+        I->first,
         ObjCMethodList(),
         ObjCMethodList()
       };
@@ -2386,7 +2710,7 @@ void ASTWriter::WriteSelectors(Sema &SemaRef) {
       }
       // Only write this selector if it's not in an existing AST or something
       // changed.
-      if (Chain && I->second < FirstSelectorID) {
+      if (Chain && I->first < FirstSelectorID) {
         // Selector already exists. Did it change?
         bool changed = false;
         for (ObjCMethodList *M = &Data.Instance; !changed && M && M->Method;
@@ -2463,13 +2787,19 @@ void ASTWriter::WriteReferencedSelectorsPool(Sema &SemaRef) {
   // Note: this writes out all references even for a dependent AST. But it is
   // very tricky to fix, and given that @selector shouldn't really appear in
   // headers, probably not worth it. It's not a correctness issue.
+  // The references are written in the order of their locations, which
+  // unlike the order of the map does not depend on addresses.
+  SmallVector<std::pair<unsigned, Selector>, 16> Selectors;
   for (DenseMap<Selector, SourceLocation>::iterator S =
        SemaRef.ReferencedSelectors.begin(),
-       E = SemaRef.ReferencedSelectors.end(); S != E; ++S) {
-    Selector Sel = (*S).first;
-    SourceLocation Loc = (*S).second;
-    AddSelectorRef(Sel, Record);
-    AddSourceLocation(Loc, Record);
+       E = SemaRef.ReferencedSelectors.end(); S != E; ++S)
+    Selectors.push_back(std::make_pair(S->second.getRawEncoding(), S->first));
+  std::sort(Selectors.begin(), Selectors.end(), LessFirst());
+
+  for (unsigned I = 0, N = Selectors.size(); I != N; ++I) {
+    AddSelectorRef(Selectors[I].second, Record);
+    AddSourceLocation(SourceLocation::getFromRawEncoding(Selectors[I].first),
+                      Record);
   }
   Stream.EmitRecord(REFERENCED_SELECTOR_POOL, Record);
 }
@@ -2480,10 +2810,19 @@ void ASTWriter::WriteReferencedSelectorsPool(Sema &SemaRef) {
 
 namespace {
 class ASTIdentifierTableTrait {
+public:
+  typedef SmallVectorImpl<std::pair<const IdentifierInfo *, uint32_t> >
+    KeyOffsetsTy;
+
+private:
   ASTWriter &Writer;
   Preprocessor &PP;
   IdentifierResolver &IdResolver;
   bool IsModule;
+
+  /// \brief If non-null, where the key offsets are collected instead of
+  /// being passed to the writer.
+  KeyOffsetsTy *KeyOffsets;
   
   /// \brief Determines whether this is an "interesting" identifier
   /// that needs a full IdentifierInfo structure written into the hash
@@ -2517,8 +2856,10 @@ public:
   typedef data_type data_type_ref;
 
   ASTIdentifierTableTrait(ASTWriter &Writer, Preprocessor &PP, 
-                          IdentifierResolver &IdResolver, bool IsModule)
-    : Writer(Writer), PP(PP), IdResolver(IdResolver), IsModule(IsModule) { }
+                          IdentifierResolver &IdResolver, bool IsModule,
+                          KeyOffsetsTy *KeyOffsets = 0)
+    : Writer(Writer), PP(PP), IdResolver(IdResolver), IsModule(IsModule),
+      KeyOffsets(KeyOffsets) { }
 
   static unsigned ComputeHash(const IdentifierInfo* II) {
     return llvm::HashString(II->getName());
@@ -2551,7 +2892,10 @@ public:
                unsigned KeyLen) {
     // Record the location of the key data.  This is used when generating
     // the mapping from persistent IDs to strings.
-    Writer.SetIdentifierOffset(II, Out.tell());
+    if (KeyOffsets)
+      KeyOffsets->push_back(std::make_pair(II, uint32_t(Out.tell())));
+    else
+      Writer.SetIdentifierOffset(II, Out.tell());
     Out.write(II->getNameStart(), KeyLen);
   }
 
@@ -2595,8 +2939,41 @@ public:
       clang::io::Emit32(Out, Writer.getDeclID(*D));
   }
 };
+
+typedef OnDiskChainedHashTableGenerator<ASTIdentifierTableTrait>
+  ASTIdentifierTableGenerator;
+
+/// \brief The identifier hash table payload for a range of buckets, encoded
+/// by a worker thread.
+struct IdentifierTableSlice {
+  unsigned BeginBucket, EndBucket;
+  SmallString<4096> Data;
+  SmallVector<std::pair<const IdentifierInfo *, uint32_t>, 64> KeyOffsets;
+};
+
+/// \brief The state shared by the workers encoding the identifier table.
+struct IdentifierTableJob {
+  ASTIdentifierTableGenerator *Generator;
+  ASTWriter *Writer;
+  Preprocessor *PP;
+  IdentifierResolver *IdResolver;
+  std::vector<IdentifierTableSlice> Slices;
+};
 } // end anonymous namespace
 
+static void EncodeIdentifierTableSlice(void *UserData, unsigned Index) {
+  IdentifierTableJob &Job = *static_cast<IdentifierTableJob *>(UserData);
+  IdentifierTableSlice &Slice = Job.Slices[Index];
+  ASTIdentifierTableTrait Trait(*Job.Writer, *Job.PP, *Job.IdResolver,
+                                /*IsModule=*/false, &Slice.KeyOffsets);
+  llvm::raw_svector_ostream Out(Slice.Data);
+  Job.Generator->EmitBuckets(Out, Slice.BeginBucket, Slice.EndBucket, Trait);
+}
+
+/// \brief The number of identifiers above which the identifier table is
+/// encoded on several threads.
+static const unsigned MinIdentifiersForParallelEncoding = 16384;
+
 /// \brief Write the identifier table into the AST file.
 ///
 /// The identifier table consists of a blob containing string data
@@ -2610,7 +2987,7 @@ void ASTWriter::WriteIdentifierTable(Preprocessor &PP,
   // Create and write out the blob that contains the identifier
   // strings.
   {
-    OnDiskChainedHashTableGenerator<ASTIdentifierTableTrait> Generator;
+    ASTIdentifierTableGenerator Generator;
     ASTIdentifierTableTrait Trait(*this, PP, IdResolver, IsModule);
 
     // Look for any identifiers that were named while processing the
@@ -2624,26 +3001,74 @@ void ASTWriter::WriteIdentifierTable(Preprocessor &PP,
       getIdentifierRef(ID->second);
 
     // Create the on-disk hash table representation. We only store offsets
-    // for identifiers that appear here for the first time.
+    // for identifiers that appear here for the first time. The identifiers
+    // are inserted in the order of their IDs, since the layout of the table
+    // depends on the order of insertion.
     IdentifierOffsets.resize(NextIdentID - FirstIdentID);
+    SmallVector<std::pair<IdentID, const IdentifierInfo *>, 64> Identifiers;
     for (llvm::DenseMap<const IdentifierInfo *, IdentID>::iterator
            ID = IdentifierIDs.begin(), IDEnd = IdentifierIDs.end();
          ID != IDEnd; ++ID) {
       assert(ID->first && "NULL identifier in identifier table");
       if (!Chain || !ID->first->isFromAST() || 
           ID->first->hasChangedSinceDeserialization())
-        Generator.insert(const_cast<IdentifierInfo *>(ID->first), ID->second, 
-                         Trait);
+        Identifiers.push_back(std::make_pair(ID->second, ID->first));
+    }
+    std::sort(Identifiers.begin(), Identifiers.end(), LessFirst());
+
+    SmallVector<unsigned, 64> IdentifierHashes;
+    for (unsigned I = 0, N = Identifiers.size(); I != N; ++I) {
+      IdentifierInfo *II = const_cast<IdentifierInfo *>(Identifiers[I].second);
+      Generator.insert(II, Identifiers[I].first, Trait);
+      IdentifierHashes.push_back(Trait.ComputeHash(II));
     }
 
     // Create the on-disk hash table in a buffer.
     SmallString<4096> IdentifierTable;
     uint32_t BucketOffset;
-    {
+    // Make sure that no bucket is at offset 0
+    IdentifierTable.append(4, '\0');
+
+    // Encoding the entries of big tables in parallel pays off.  The trait
+    // only reads the state of the writer, the preprocessor and the resolver,
+    // except when an identifier has to be updated from an AST file or when
+    // writing a module, where the submodule lookup updates caches.
+    unsigned NumSlices = 0;
+    if (!Chain && !IsModule && isParallelExecutionSupported() &&
+        Generator.getNumEntries() >= MinIdentifiersForParallelEncoding)
+      NumSlices = std::min(getNumberOfHardwareThreads() * 4,
+                           Generator.getNumBuckets() / 1024);
+    if (NumSlices > 1) {
+      IdentifierTableJob Job;
+      Job.Generator = &Generator;
+      Job.Writer = this;
+      Job.PP = &PP;
+      Job.IdResolver = &IdResolver;
+      Job.Slices.resize(NumSlices);
+      unsigned NumBuckets = Generator.getNumBuckets();
+      for (unsigned I = 0; I != NumSlices; ++I) {
+        Job.Slices[I].BeginBucket = uint64_t(NumBuckets) * I / NumSlices;
+        Job.Slices[I].EndBucket = uint64_t(NumBuckets) * (I + 1) / NumSlices;
+      }
+      runTasksInParallel(0, NumSlices, EncodeIdentifierTableSlice, &Job);
+
+      // Stitch the slices together in bucket order, so that the result is
+      // the same as when encoding on one thread.
+      for (unsigned I = 0; I != NumSlices; ++I) {
+        IdentifierTableSlice &Slice = Job.Slices[I];
+        uint32_t Base = IdentifierTable.size();
+        Generator.RelocateBuckets(Slice.BeginBucket, Slice.EndBucket, Base);
+        for (unsigned K = 0, N = Slice.KeyOffsets.size(); K != N; ++K)
+          SetIdentifierOffset(Slice.KeyOffsets[K].first,
+                              Base + Slice.KeyOffsets[K].second);
+        IdentifierTable.append(Slice.Data.begin(), Slice.Data.end());
+      }
+
+      llvm::raw_svector_ostream Out(IdentifierTable);
+      BucketOffset = Generator.EmitTable(Out);
+    } else {
       ASTIdentifierTableTrait Trait(*this, PP, IdResolver, IsModule);
       llvm::raw_svector_ostream Out(IdentifierTable);
-      // Make sure that no bucket is at offset 0
-      clang::io::Emit32(Out, 0);
       BucketOffset = Generator.Emit(Out, Trait);
     }
 
@@ -2659,6 +3084,31 @@ void ASTWriter::WriteIdentifierTable(Preprocessor &PP,
     Record.push_back(IDENTIFIER_TABLE);
     Record.push_back(BucketOffset);
     Stream.EmitRecordWithBlob(IDTableAbbrev, Record, IdentifierTable.str());
+
+    // Write the filter of the identifiers in the table.
+    unsigned Log2Bits
+      = Log2_32_Ceil(std::max(IdentifierHashes.size() *
+                                IdentifierFilterBitsPerIdentifier,
+                              size_t(1) << MinIdentifierFilterLog2Bits));
+    SmallString<4096> Filter;
+    Filter.resize((1U << Log2Bits) / 8, 0);
+    for (unsigned I = 0, N = IdentifierHashes.size(); I != N; ++I) {
+      unsigned Bit1, Bit2;
+      getIdentifierFilterBits(IdentifierHashes[I], Log2Bits, Bit1, Bit2);
+      Filter[Bit1 / 8] |= 1 << (Bit1 % 8);
+      Filter[Bit2 / 8] |= 1 << (Bit2 % 8);
+    }
+
+    Abbrev = new BitCodeAbbrev();
+    Abbrev->Add(BitCodeAbbrevOp(IDENTIFIER_FILTER));
+    Abbrev->Add(BitCodeAbbrevOp(BitCodeAbbrevOp::Fixed, 8)); // log2 of # bits
+    Abbrev->Add(BitCodeAbbrevOp(BitCodeAbbrevOp::Blob));
+    unsigned IDFilterAbbrev = Stream.EmitAbbrev(Abbrev);
+
+    Record.clear();
+    Record.push_back(IDENTIFIER_FILTER);
+    Record.push_back(Log2Bits);
+    Stream.EmitRecordWithBlob(IDFilterAbbrev, Record, Filter.str());
   }
 
   // Write the offsets table for identifier IDs.
@@ -2795,6 +3245,27 @@ public:
 };
 } // end anonymous namespace
 
+typedef SmallVector<std::pair<StableDeclKey, StoredDeclsMap::iterator>, 32>
+  SortedLookupEntries;
+
+/// \brief Collect the names of \p Map that have visible declarations, in the
+/// order of their first declarations.
+///
+/// The layout of an on-disk lookup table depends on the order in which its
+/// names are inserted, and that of the map on the addresses of the names.
+static void getSortedLookupEntries(StoredDeclsMap &Map,
+                                   const DeclIDMap &DeclIDs,
+                                   SortedLookupEntries &Entries) {
+  for (StoredDeclsMap::iterator D = Map.begin(), DEnd = Map.end();
+       D != DEnd; ++D) {
+    DeclContext::lookup_result Result = D->second.getLookupResult();
+    if (Result.first != Result.second)
+      Entries.push_back(std::make_pair(
+          getStableDeclKey(*Result.first, D->first, DeclIDs), D));
+  }
+  std::sort(Entries.begin(), Entries.end(), LessFirst());
+}
+
 /// \brief Write the block containing all of the declaration IDs
 /// visible from the given DeclContext.
 ///
@@ -2833,25 +3304,25 @@ uint64_t ASTWriter::WriteDeclContextVisibleBlock(ASTContext &Context,
   // Create the on-disk hash table representation.
   DeclarationName ConversionName;
   llvm::SmallVector<NamedDecl *, 4> ConversionDecls;
-  for (StoredDeclsMap::iterator D = Map->begin(), DEnd = Map->end();
-       D != DEnd; ++D) {
-    DeclarationName Name = D->first;
-    DeclContext::lookup_result Result = D->second.getLookupResult();
-    if (Result.first != Result.second) {
-      if (Name.getNameKind() == DeclarationName::CXXConversionFunctionName) {
-        // Hash all conversion function names to the same name. The actual
-        // type information in conversion function name is not used in the
-        // key (since such type information is not stable across different
-        // modules), so the intended effect is to coalesce all of the conversion
-        // functions under a single key.
-        if (!ConversionName)
-          ConversionName = Name;
-        ConversionDecls.append(Result.first, Result.second);
-        continue;
-      }
-      
-      Generator.insert(Name, Result, Trait);
+  SortedLookupEntries Entries;
+  getSortedLookupEntries(*Map, DeclIDs, Entries);
+  for (unsigned I = 0, N = Entries.size(); I != N; ++I) {
+    DeclarationName Name = Entries[I].second->first;
+    DeclContext::lookup_result Result
+      = Entries[I].second->second.getLookupResult();
+    if (Name.getNameKind() == DeclarationName::CXXConversionFunctionName) {
+      // Hash all conversion function names to the same name. The actual
+      // type information in conversion function name is not used in the
+      // key (since such type information is not stable across different
+      // modules), so the intended effect is to coalesce all of the conversion
+      // functions under a single key.
+      if (!ConversionName)
+        ConversionName = Name;
+      ConversionDecls.append(Result.first, Result.second);
+      continue;
     }
+
+    Generator.insert(Name, Result, Trait);
   }
 
   // Add the conversion functions
@@ -2899,14 +3370,13 @@ void ASTWriter::WriteDeclContextVisibleUpdate(const DeclContext *DC) {
   ASTDeclContextNameLookupTrait Trait(*this);
 
   // Create the hash table.
-  for (StoredDeclsMap::iterator D = Map->begin(), DEnd = Map->end();
-       D != DEnd; ++D) {
-    DeclarationName Name = D->first;
-    DeclContext::lookup_result Result = D->second.getLookupResult();
+  SortedLookupEntries Entries;
+  getSortedLookupEntries(*Map, DeclIDs, Entries);
+  for (unsigned I = 0, N = Entries.size(); I != N; ++I) {
     // For any name that appears in this table, the results are complete, i.e.
     // they overwrite results from previous PCHs. Merging is always a mess.
-    if (Result.first != Result.second)
-      Generator.insert(Name, Result, Trait);
+    Generator.insert(Entries[I].second->first,
+                     Entries[I].second->second.getLookupResult(), Trait);
   }
 
   // Create the on-disk hash table in a buffer.
@@ -3068,10 +3538,14 @@ void ASTWriter::WriteMergedDecls() {
   if (!Chain || Chain->MergedDecls.empty())
     return;
   
+  // Write the declarations in a stable order rather than that of the map.
+  SmallVector<std::pair<StableDeclKey, ASTReader::MergedDeclsMap::iterator>,
+              16> SortedDecls;
+  getEntriesInDeclOrder(Chain->MergedDecls, DeclIDs, SortedDecls);
+
   RecordData Record;
-  for (ASTReader::MergedDeclsMap::iterator I = Chain->MergedDecls.begin(),
-                                        IEnd = Chain->MergedDecls.end();
-       I != IEnd; ++I) {
+  for (unsigned Idx = 0, N = SortedDecls.size(); Idx != N; ++Idx) {
+    ASTReader::MergedDeclsMap::iterator I = SortedDecls[Idx].second;
     DeclID CanonID = I->first->isFromASTFile()? I->first->getGlobalID()
                                               : getDeclID(I->first);
     assert(CanonID && "Merged declaration not known?");
@@ -3145,7 +3619,8 @@ void ASTWriter::SetSelectorOffset(Selector Sel, uint32_t Offset) {
 ASTWriter::ASTWriter(llvm::BitstreamWriter &Stream)
   : Stream(Stream), Context(0), PP(0), Chain(0), WritingModule(0),
     WritingAST(false), DoneWritingDeclsAndTypes(false),
-    ASTHasCompilerErrors(false),
+    ASTHasCompilerErrors(false), CompressSLocBlobs(false),
+    SLocCompressedBlobAbbrv(0), Deterministic(false),
     FirstDeclID(NUM_PREDEF_DECL_IDS), NextDeclID(FirstDeclID),
     FirstTypeID(NUM_PREDEF_TYPE_IDS), NextTypeID(FirstTypeID),
     FirstIdentID(NUM_PREDEF_IDENT_IDS), NextIdentID(FirstIdentID), 
@@ -3153,8 +3628,8 @@ ASTWriter::ASTWriter(llvm::BitstreamWriter &Stream)
     NextSubmoduleID(FirstSubmoduleID),
     FirstSelectorID(NUM_PREDEF_SELECTOR_IDS), NextSelectorID(FirstSelectorID),
     CollectedStmts(&StmtsToEmit),
-    NumStatements(0), NumMacros(0), NumLexicalDeclContexts(0),
-    NumVisibleDeclContexts(0),
+    NumStatements(0), NumFunctionBodies(0), NumMacros(0),
+    NumLexicalDeclContexts(0), NumVisibleDeclContexts(0),
     NextCXXBaseSpecifiersID(1),
     DeclParmVarAbbrev(0), DeclContextLexicalAbbrev(0),
     DeclContextVisibleLookupAbbrev(0), UpdateVisibleAbbrev(0),
@@ -3282,11 +3757,21 @@ void ASTWriter::WriteASTCore(Sema &SemaRef, MemorizeStatCalls *StatCalls,
   // Write the set of weak, undeclared identifiers. We always write the
   // entire table, since later PCH files in a PCH chain are only interested in
   // the results at the end of the chain.
+  // The identifiers are written, and get their IDs, in the order of their
+  // pragmas rather than that of the map.
   RecordData WeakUndeclaredIdentifiers;
   if (!SemaRef.WeakUndeclaredIdentifiers.empty()) {
-    for (llvm::DenseMap<IdentifierInfo*,WeakInfo>::iterator
-         I = SemaRef.WeakUndeclaredIdentifiers.begin(),
-         E = SemaRef.WeakUndeclaredIdentifiers.end(); I != E; ++I) {
+    typedef llvm::DenseMap<IdentifierInfo*,WeakInfo>::iterator WeakIterator;
+    SmallVector<std::pair<unsigned, WeakIterator>, 8> SortedWeaks;
+    for (WeakIterator I = SemaRef.WeakUndeclaredIdentifiers.begin(),
+                      E = SemaRef.WeakUndeclaredIdentifiers.end();
+         I != E; ++I)
+      SortedWeaks.push_back(
+        std::make_pair(I->second.getLocation().getRawEncoding(), I));
+    std::stable_sort(SortedWeaks.begin(), SortedWeaks.end(), LessFirst());
+
+    for (unsigned Idx = 0, N = SortedWeaks.size(); Idx != N; ++Idx) {
+      WeakIterator I = SortedWeaks[Idx].second;
       AddIdentifierRef(I->first, WeakUndeclaredIdentifiers);
       AddIdentifierRef(I->second.getAlias(), WeakUndeclaredIdentifiers);
       AddSourceLocation(I->second.getLocation(), WeakUndeclaredIdentifiers);
@@ -3296,17 +3781,22 @@ void ASTWriter::WriteASTCore(Sema &SemaRef, MemorizeStatCalls *StatCalls,
 
   // Build a record containing all of the locally-scoped external
   // declarations in this header file. Generally, this record will be
-  // empty.
+  // empty. The declarations are written in the order of their locations,
+  // since the order of the map depends on the addresses of their names.
   RecordData LocallyScopedExternalDecls;
-  // FIXME: This is filling in the AST file in densemap order which is
-  // nondeterminstic!
+  SmallVector<std::pair<uint64_t, NamedDecl *>, 4> SortedExternalDecls;
   for (llvm::DenseMap<DeclarationName, NamedDecl *>::iterator
          TD = SemaRef.LocallyScopedExternalDecls.begin(),
          TDEnd = SemaRef.LocallyScopedExternalDecls.end();
        TD != TDEnd; ++TD) {
     if (!TD->second->isFromASTFile())
-      AddDeclRef(TD->second, LocallyScopedExternalDecls);
+      SortedExternalDecls.push_back(
+        std::make_pair(getStableDeclOrder(TD->second), TD->second));
   }
+  std::sort(SortedExternalDecls.begin(), SortedExternalDecls.end(),
+            LessFirst());
+  for (unsigned I = 0, N = SortedExternalDecls.size(); I != N; ++I)
+    AddDeclRef(SortedExternalDecls[I].second, LocallyScopedExternalDecls);
   
   // Build a record containing all of the ext_vector declarations.
   RecordData ExtVectorDecls;
@@ -3349,22 +3839,28 @@ void ASTWriter::WriteASTCore(Sema &SemaRef, MemorizeStatCalls *StatCalls,
     AddDeclRef(Context.getcudaConfigureCallDecl(), CUDASpecialDeclRefs);
   }
 
-  // Build a record containing all of the known namespaces.
+  // Build a record containing all of the known namespaces, in a stable
+  // order.
   RecordData KnownNamespaces;
+  SmallVector<std::pair<uint64_t, NamespaceDecl *>, 16> SortedNamespaces;
   for (llvm::DenseMap<NamespaceDecl*, bool>::iterator 
             I = SemaRef.KnownNamespaces.begin(),
          IEnd = SemaRef.KnownNamespaces.end();
        I != IEnd; ++I) {
     if (!I->second)
-      AddDeclRef(I->first, KnownNamespaces);
+      SortedNamespaces.push_back(
+        std::make_pair(getStableDeclOrder(I->first), I->first));
   }
+  std::sort(SortedNamespaces.begin(), SortedNamespaces.end(), LessFirst());
+  for (unsigned I = 0, N = SortedNamespaces.size(); I != N; ++I)
+    AddDeclRef(SortedNamespaces[I].second, KnownNamespaces);
   
   // Write the remaining AST contents.
   RecordData Record;
   Stream.EnterSubblock(AST_BLOCK_ID, 5);
   WriteMetadata(Context, isysroot, OutputFile);
   WriteLanguageOptions(Context.getLangOpts());
-  if (StatCalls && isysroot.empty())
+  if (StatCalls && isysroot.empty() && !Deterministic)
     WriteStatCache(*StatCalls);
 
   // Create a lexical update block containing all of the declarations in the
@@ -3432,10 +3928,18 @@ void ASTWriter::WriteASTCore(Sema &SemaRef, MemorizeStatCalls *StatCalls,
   // declarations have been written.
   Stream.EnterSubblock(DECLTYPES_BLOCK_ID, NUM_ALLOWED_ABBREVS_SIZE);
   WriteDeclsBlockAbbrevs();
+  // The set is ordered by address; rewrite the declarations in a stable
+  // order instead.
+  SmallVector<std::pair<uint64_t, Decl *>, 16> SortedDeclsToRewrite;
   for (DeclsToRewriteTy::iterator I = DeclsToRewrite.begin(), 
                                   E = DeclsToRewrite.end(); 
        I != E; ++I)
-    DeclTypesToEmit.push(const_cast<Decl*>(*I));
+    SortedDeclsToRewrite.push_back(
+      std::make_pair(getStableDeclOrder(*I), const_cast<Decl*>(*I)));
+  std::sort(SortedDeclsToRewrite.begin(), SortedDeclsToRewrite.end(),
+            LessFirst());
+  for (unsigned I = 0, N = SortedDeclsToRewrite.size(); I != N; ++I)
+    DeclTypesToEmit.push(SortedDeclsToRewrite[I].second);
   while (!DeclTypesToEmit.empty()) {
     DeclOrType DOT = DeclTypesToEmit.front();
     DeclTypesToEmit.pop();
@@ -3507,6 +4011,7 @@ void ASTWriter::WriteASTCore(Sema &SemaRef, MemorizeStatCalls *StatCalls,
   WritePragmaDiagnosticMappings(Context.getDiagnostics());
 
   WriteCXXBaseSpecifiersOffsets();
+  WriteRecordLayouts(Context);
   
   // If we're emitting a module, write out the submodule information.  
   if (WritingModule)
@@ -3568,12 +4073,17 @@ void ASTWriter::WriteASTCore(Sema &SemaRef, MemorizeStatCalls *StatCalls,
   if (!KnownNamespaces.empty())
     Stream.EmitRecord(KNOWN_NAMESPACES, KnownNamespaces);
   
-  // Write the visible updates to DeclContexts.
+  // Write the visible updates to DeclContexts, in a stable order.
+  SmallVector<std::pair<uint64_t, const DeclContext *>, 16> SortedContexts;
   for (llvm::SmallPtrSet<const DeclContext *, 16>::iterator
        I = UpdatedDeclContexts.begin(),
        E = UpdatedDeclContexts.end();
        I != E; ++I)
-    WriteDeclContextVisibleUpdate(*I);
+    SortedContexts.push_back(
+      std::make_pair(getStableDeclOrder(cast<Decl>(*I)), *I));
+  std::sort(SortedContexts.begin(), SortedContexts.end(), LessFirst());
+  for (unsigned I = 0, N = SortedContexts.size(); I != N; ++I)
+    WriteDeclContextVisibleUpdate(SortedContexts[I].second);
 
   if (!WritingModule) {
     // Write the submodules that were imported, if any.
@@ -3609,6 +4119,7 @@ void ASTWriter::WriteASTCore(Sema &SemaRef, MemorizeStatCalls *StatCalls,
   Record.push_back(NumMacros);
   Record.push_back(NumLexicalDeclContexts);
   Record.push_back(NumVisibleDeclContexts);
+  Record.push_back(NumFunctionBodies);
   Stream.EmitRecord(STATISTICS, Record);
   Stream.ExitBlock();
 }
@@ -3616,8 +4127,13 @@ void ASTWriter::WriteASTCore(Sema &SemaRef, MemorizeStatCalls *StatCalls,
 /// \brief Go through the declaration update blocks and resolve declaration
 /// pointers into declaration IDs.
 void ASTWriter::ResolveDeclUpdatesBlocks() {
-  for (DeclUpdateMap::iterator
-       I = DeclUpdates.begin(), E = DeclUpdates.end(); I != E; ++I) {
+  // Resolve the pointers in a stable order, since it assigns the IDs of
+  // declarations that do not have one yet.
+  SmallVector<std::pair<StableDeclKey, DeclUpdateMap::iterator>, 16>
+    SortedUpdates;
+  getEntriesInDeclOrder(DeclUpdates, DeclIDs, SortedUpdates);
+  for (unsigned UI = 0, UE = SortedUpdates.size(); UI != UE; ++UI) {
+    DeclUpdateMap::iterator I = SortedUpdates[UI].second;
     const Decl *D = I->first;
     UpdateRecord &URec = I->second;
     
@@ -3648,8 +4164,11 @@ void ASTWriter::WriteDeclUpdatesBlocks() {
 
   RecordData OffsetsRecord;
   Stream.EnterSubblock(DECL_UPDATES_BLOCK_ID, NUM_ALLOWED_ABBREVS_SIZE);
-  for (DeclUpdateMap::iterator
-         I = DeclUpdates.begin(), E = DeclUpdates.end(); I != E; ++I) {
+  SmallVector<std::pair<StableDeclKey, DeclUpdateMap::iterator>, 16>
+    SortedUpdates;
+  getEntriesInDeclOrder(DeclUpdates, DeclIDs, SortedUpdates);
+  for (unsigned UI = 0, UE = SortedUpdates.size(); UI != UE; ++UI) {
+    DeclUpdateMap::iterator I = SortedUpdates[UI].second;
     const Decl *D = I->first;
     UpdateRecord &URec = I->second;
 
@@ -29,10 +29,14 @@ PCHGenerator::PCHGenerator(const Preprocessor &PP,
                            StringRef OutputFile,
                            clang::Module *Module,
                            StringRef isysroot,
-                           raw_ostream *OS)
+                           raw_ostream *OS,
+                           bool CompressSLocBlobs,
+                           bool Deterministic)
   : PP(PP), OutputFile(OutputFile), Module(Module), 
     isysroot(isysroot.str()), Out(OS), 
     SemaPtr(0), StatCalls(0), Stream(Buffer), Writer(Stream) {
+  Writer.setCompressSLocBlobs(CompressSLocBlobs);
+  Writer.setDeterministic(Deterministic);
   // Install a stat() listener to keep track of all of the stat()
   // calls.
   StatCalls = new MemorizeStatCalls();
@@ -42,9 +46,40 @@ PCHGenerator::PCHGenerator(const Preprocessor &PP,
 PCHGenerator::~PCHGenerator() {
 }
 
+void PCHGenerator::HandleTagDeclDefinition(TagDecl *D) {
+  if (RecordDecl *RD = dyn_cast<RecordDecl>(D))
+    RecordDefinitions.push_back(RD);
+}
+
+/// \brief Lay out the records defined in the AST file, so that the layouts
+/// are written with it and the translation units which load it need not
+/// compute them.
+void PCHGenerator::layOutRecordDefinitions(ASTContext &Ctx) {
+  // Dumping layouts is meant to show the records the program uses.
+  if (Ctx.getLangOpts().DumpRecordLayouts)
+    return;
+
+  // Nothing needed these layouts; keep their warnings, if any, for the
+  // translation units which do.
+  DiagnosticsEngine &Diags = Ctx.getDiagnostics();
+  bool SuppressAllDiagnostics = Diags.getSuppressAllDiagnostics();
+  Diags.setSuppressAllDiagnostics(true);
+  for (unsigned I = 0, N = RecordDefinitions.size(); I != N; ++I) {
+    const RecordDecl *RD = RecordDefinitions[I];
+    if (RD->isInvalidDecl() || RD->isDependentContext() ||
+        RD->getDefinition() != RD)
+      continue;
+    Ctx.getASTRecordLayout(RD);
+  }
+  Diags.setSuppressAllDiagnostics(SuppressAllDiagnostics);
+  RecordDefinitions.clear();
+}
+
 void PCHGenerator::HandleTranslationUnit(ASTContext &Ctx) {
   if (PP.getDiagnostics().hasErrorOccurred())
     return;
+
+  layOutRecordDefinitions(Ctx);
   
   // Emit the PCH file
   assert(SemaPtr && "No Sema?");
@@ -50,6 +50,7 @@ ModuleManager::addModule(StringRef FileName, ModuleKind Type,
     // Allocate a new module.
     ModuleFile *New = new ModuleFile(Type, Generation);
     New->FileName = FileName.str();
+    New->Index = Chain.size();
     Chain.push_back(New);
     NewModule = true;
     ModuleEntry = New;
@@ -66,8 +67,15 @@ ModuleManager::addModule(StringRef FileName, ModuleKind Type,
         ec = llvm::MemoryBuffer::getSTDIN(New->Buffer);
         if (ec)
           ErrorStr = ec.message();
-      } else
-        New->Buffer.reset(FileMgr.getBufferForFile(FileName, &ErrorStr));
+      } else {
+        // The bitstream reader never looks past the end of the file, so
+        // don't ask for a null terminator.  That way the file is always
+        // mapped read-only instead of being copied into memory when its size
+        // is a multiple of the page size, and concurrent compilations using
+        // the same AST file share its pages.
+        New->Buffer.reset(FileMgr.getBufferForFile(FileName, &ErrorStr,
+                                          /*RequiresNullTerminator=*/false));
+      }
       
       if (!New->Buffer)
         return std::make_pair(static_cast<ModuleFile*>(0), false);
@@ -83,6 +91,9 @@ ModuleManager::addModule(StringRef FileName, ModuleKind Type,
   } else {
     ModuleEntry->DirectlyImported = true;
   }
+
+  // The new module or import changes the visitation order.
+  VisitOrder.clear();
   
   return std::make_pair(ModuleEntry, NewModule);
 }
@@ -95,79 +106,106 @@ void ModuleManager::addInMemoryBuffer(StringRef FileName,
   InMemoryBuffers[Entry] = Buffer;
 }
 
-ModuleManager::ModuleManager(const FileSystemOptions &FSO) : FileMgr(FSO) { }
+ModuleManager::ModuleManager(const FileSystemOptions &FSO)
+  : FileMgr(FSO), FirstVisitState(0) { }
 
 ModuleManager::~ModuleManager() {
   for (unsigned i = 0, e = Chain.size(); i != e; ++i)
     delete Chain[e - i - 1];
+  delete FirstVisitState;
 }
 
-void ModuleManager::visit(bool (*Visitor)(ModuleFile &M, void *UserData), 
-                          void *UserData) {
+ModuleManager::VisitState *ModuleManager::allocateVisitState() {
+  VisitState *State = FirstVisitState;
+  if (State) {
+    FirstVisitState = State->NextState;
+    State->NextState = 0;
+    State->Skipped.reset();
+  } else {
+    State = new VisitState;
+  }
+  State->Skipped.resize(size());
+  return State;
+}
+
+void ModuleManager::returnVisitState(VisitState *State) {
+  assert(State->NextState == 0 && "Visitation state is already unused?");
+  State->NextState = FirstVisitState;
+  FirstVisitState = State;
+}
+
+void ModuleManager::computeVisitOrder() {
   unsigned N = size();
-  
+  VisitOrder.clear();
+  VisitOrder.reserve(N);
+
   // Record the number of incoming edges for each module. When we
   // encounter a module with no incoming edges, push it into the queue
   // to seed the queue.
-  SmallVector<ModuleFile *, 4> Queue;
-  Queue.reserve(N);
-  llvm::DenseMap<ModuleFile *, unsigned> UnusedIncomingEdges; 
+  SmallVector<unsigned, 4> UnusedIncomingEdges(N);
   for (ModuleIterator M = begin(), MEnd = end(); M != MEnd; ++M) {
     if (unsigned Size = (*M)->ImportedBy.size())
-      UnusedIncomingEdges[*M] = Size;
+      UnusedIncomingEdges[(*M)->Index] = Size;
     else
-      Queue.push_back(*M);
+      VisitOrder.push_back(*M);
   }
-  
-  llvm::SmallPtrSet<ModuleFile *, 4> Skipped;
-  unsigned QueueStart = 0;
-  while (QueueStart < Queue.size()) {
-    ModuleFile *CurrentModule = Queue[QueueStart++];
-    
+
+  // The order doubles as the queue of the modules whose importers have all
+  // been ordered.
+  for (unsigned QueueStart = 0; QueueStart < VisitOrder.size(); ++QueueStart) {
+    ModuleFile *CurrentModule = VisitOrder[QueueStart];
+    for (llvm::SetVector<ModuleFile *>::iterator
+           M = CurrentModule->Imports.begin(),
+           MEnd = CurrentModule->Imports.end();
+         M != MEnd; ++M) {
+      unsigned &NumUnusedEdges = UnusedIncomingEdges[(*M)->Index];
+      if (NumUnusedEdges && (--NumUnusedEdges == 0))
+        VisitOrder.push_back(*M);
+    }
+  }
+
+  assert(VisitOrder.size() == N && "Cycle in the module graph?");
+}
+
+void ModuleManager::visit(bool (*Visitor)(ModuleFile &M, void *UserData), 
+                          void *UserData) {
+  if (VisitOrder.size() != size())
+    computeVisitOrder();
+
+  VisitState *State = allocateVisitState();
+  for (unsigned I = 0, N = VisitOrder.size(); I != N; ++I) {
+    ModuleFile *CurrentModule = VisitOrder[I];
+
     // Check whether this module should be skipped.
-    if (Skipped.count(CurrentModule))
+    if (State->Skipped[CurrentModule->Index])
       continue;
-    
-    if (Visitor(*CurrentModule, UserData)) {
-      // The visitor has requested that cut off visitation of any
-      // module that the current module depends on. To indicate this
-      // behavior, we mark all of the reachable modules as having N
-      // incoming edges (which is impossible otherwise).
-      SmallVector<ModuleFile *, 4> Stack;
-      Stack.push_back(CurrentModule);
-      Skipped.insert(CurrentModule);
-      while (!Stack.empty()) {
-        ModuleFile *NextModule = Stack.back();
-        Stack.pop_back();
-        
-        // For any module that this module depends on, push it on the
-        // stack (if it hasn't already been marked as visited).
-        for (llvm::SetVector<ModuleFile *>::iterator 
-             M = NextModule->Imports.begin(),
-             MEnd = NextModule->Imports.end();
-             M != MEnd; ++M) {
-          if (Skipped.insert(*M))
-            Stack.push_back(*M);
+
+    if (!Visitor(*CurrentModule, UserData))
+      continue;
+
+    // The visitor has requested that cut off visitation of any
+    // module that the current module depends on. To indicate this
+    // behavior, we mark all of the reachable modules as skipped.
+    SmallVectorImpl<ModuleFile *> &Stack = State->Stack;
+    Stack.push_back(CurrentModule);
+    State->Skipped.set(CurrentModule->Index);
+    while (!Stack.empty()) {
+      ModuleFile *NextModule = Stack.pop_back_val();
+
+      // For any module that this module depends on, push it on the
+      // stack (if it hasn't already been marked as skipped).
+      for (llvm::SetVector<ModuleFile *>::iterator
+           M = NextModule->Imports.begin(),
+           MEnd = NextModule->Imports.end();
+           M != MEnd; ++M) {
+        if (!State->Skipped[(*M)->Index]) {
+          State->Skipped.set((*M)->Index);
+          Stack.push_back(*M);
         }
       }
-      continue;
-    }
-    
-    // For any module that this module depends on, push it on the
-    // stack (if it hasn't already been marked as visited).
-    for (llvm::SetVector<ModuleFile *>::iterator M = CurrentModule->Imports.begin(),
-         MEnd = CurrentModule->Imports.end();
-         M != MEnd; ++M) {
-      
-      // Remove our current module as an impediment to visiting the
-      // module we depend on. If we were the last unvisited module
-      // that depends on this particular module, push it into the
-      // queue to be visited.
-      unsigned &NumUnusedEdges = UnusedIncomingEdges[*M];
-      if (NumUnusedEdges && (--NumUnusedEdges == 0))
-        Queue.push_back(*M);
     }
   }
+  returnVisitState(State);
 }
 
 /// \brief Perform a depth-first visit of the current module.
@@ -28,6 +28,8 @@ using namespace ento;
 
 STATISTIC(NumBlocks,
           "The # of blocks in top level functions");
+STATISTIC(NumReclaimedNodes,
+          "The # of exploded graph nodes reclaimed in top level functions");
 STATISTIC(NumBlocksUnreachable,
           "The # of unreachable blocks in analyzing top level functions");
 
@@ -104,13 +106,16 @@ void AnalyzerStatsChecker::checkEndAnalysis(ExplodedGraph &G,
   
   NumBlocksUnreachable += unreachable;
   NumBlocks += total;
+  NumReclaimedNodes += G.getNumReclaimedNodes();
   std::string NameOfRootFunction = output.str();
 
   output << " -> Total CFGBlocks: " << total << " | Unreachable CFGBlocks: "
       << unreachable << " | Exhausted Block: "
       << (Eng.wasBlocksExhausted() ? "yes" : "no")
       << " | Empty WorkList: "
-      << (Eng.hasEmptyWorkList() ? "yes" : "no");
+      << (Eng.hasEmptyWorkList() ? "yes" : "no")
+      << " | Nodes: " << G.size()
+      << " | Reclaimed Nodes: " << G.getNumReclaimedNodes();
 
   B.EmitBasicReport(D, "Analyzer Statistics", "Internal Statistics",
                     output.str(), PathDiagnosticLocation(D, SM));
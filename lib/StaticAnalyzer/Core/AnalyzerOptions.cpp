@@ -57,6 +57,16 @@ bool AnalyzerOptions::getBooleanOption(StringRef Name, bool DefaultVal) const {
     .Default(DefaultVal);
 }
 
+unsigned AnalyzerOptions::getOptionAsInteger(StringRef Name,
+                                             unsigned DefaultVal) const {
+  // FIXME: We should emit a warning here if the value is not a number,
+  // but the AnalyzerOptions doesn't have access to a diagnostic engine.
+  unsigned Res;
+  if (StringRef(Config.lookup(Name)).getAsInteger(10, Res))
+    return DefaultVal;
+  return Res;
+}
+
 bool AnalyzerOptions::includeTemporaryDtorsInCFG() const {
   if (!IncludeTemporaryDtorsInCFG.hasValue())
     const_cast<llvm::Optional<bool> &>(IncludeTemporaryDtorsInCFG) =
@@ -80,3 +90,31 @@ bool AnalyzerOptions::mayInlineTemplateFunctions() const {
   
   return *InlineTemplateFunctions;
 }
+
+ExplorationStrategyKind AnalyzerOptions::getExplorationStrategy() const {
+  // FIXME: We should emit a warning here about an unknown strategy, but the
+  // AnalyzerOptions doesn't have access to a diagnostic engine.
+  return llvm::StringSwitch<ExplorationStrategyKind>(
+                                          Config.lookup("exploration-strategy"))
+    .Case("bfs", ESK_BFS)
+    .Case("bfs-block-dfs-contents", ESK_BFSBlockDFSContents)
+    .Case("unexplored-first", ESK_UnexploredFirst)
+    .Default(ESK_DFS);
+}
+
+unsigned AnalyzerOptions::getGraphTrimInterval() const {
+  unsigned Interval = getOptionAsInteger("graph-trim-interval", 1000);
+  return Interval ? Interval : 1;
+}
+
+unsigned AnalyzerOptions::getInliningBudget() const {
+  return getOptionAsInteger("ipa-inlining-budget", 0);
+}
+
+unsigned AnalyzerOptions::getTimeBudget() const {
+  return getOptionAsInteger("max-function-time", 0);
+}
+
+unsigned AnalyzerOptions::getMaxRetainedDeclContexts() const {
+  return getOptionAsInteger("max-retained-decl-contexts", 0);
+}
@@ -1559,7 +1559,6 @@ PathDiagnosticLocation BugReport::getLocation(const SourceManager &SM) const {
 //===----------------------------------------------------------------------===//
 
 BugReportEquivClass::~BugReportEquivClass() { }
-GRBugReporter::~GRBugReporter() { }
 BugReporterData::~BugReporterData() {}
 
 ExplodedGraph &GRBugReporter::getGraph() { return Eng.getGraph(); }
@@ -1753,6 +1752,20 @@ MakeReportGraph(const ExplodedGraph* G,
                         std::make_pair(First, NodeIndex));
 }
 
+struct GRBugReporter::ReportGraph {
+  /// The error nodes of the reports the graph was built for.
+  SmallVector<const ExplodedNode *, 10> ErrorNodes;
+
+  OwningPtr<ExplodedGraph> Graph;
+  OwningPtr<NodeBackMap> BackMap;
+
+  /// The error node in Graph, and the index of its report.
+  const ExplodedNode *ErrorNode;
+  unsigned ReportIndex;
+};
+
+GRBugReporter::~GRBugReporter() { }
+
 /// CompactPathDiagnostic - This function postprocesses a PathDiagnostic object
 ///  and collapses PathDiagosticPieces that are expanded by macros.
 static void CompactPathDiagnostic(PathPieces &path, const SourceManager& SM) {
@@ -1861,22 +1874,30 @@ void GRBugReporter::GeneratePathDiagnostic(PathDiagnostic& PD,
   }
 
   // Construct a new graph that contains only a single path from the error
-  // node to a root.
-  const std::pair<std::pair<ExplodedGraph*, NodeBackMap*>,
-  std::pair<ExplodedNode*, unsigned> >&
-    GPair = MakeReportGraph(&getGraph(), errorNodes);
+  // node to a root.  Trimming walks the whole exploded graph, so only do it
+  // for the first PathDiagnosticConsumer that flushes these reports.
+  if (!LastReportGraph || LastReportGraph->ErrorNodes != errorNodes) {
+    const std::pair<std::pair<ExplodedGraph*, NodeBackMap*>,
+    std::pair<ExplodedNode*, unsigned> >&
+      GPair = MakeReportGraph(&getGraph(), errorNodes);
+
+    LastReportGraph.reset(new ReportGraph());
+    LastReportGraph->ErrorNodes = errorNodes;
+    LastReportGraph->Graph.reset(GPair.first.first);
+    LastReportGraph->BackMap.reset(GPair.first.second);
+    LastReportGraph->ErrorNode = GPair.second.first;
+    LastReportGraph->ReportIndex = GPair.second.second;
+  }
 
   // Find the BugReport with the original location.
-  assert(GPair.second.second < bugReports.size());
-  BugReport *R = bugReports[GPair.second.second];
+  assert(LastReportGraph->ReportIndex < bugReports.size());
+  BugReport *R = bugReports[LastReportGraph->ReportIndex];
   assert(R && "No original report found for sliced graph.");
 
-  OwningPtr<ExplodedGraph> ReportGraph(GPair.first.first);
-  OwningPtr<NodeBackMap> BackMap(GPair.first.second);
-  const ExplodedNode *N = GPair.second.first;
+  const ExplodedNode *N = LastReportGraph->ErrorNode;
 
   // Start building the path diagnostic...
-  PathDiagnosticBuilder PDB(*this, R, BackMap.get(), &PC);
+  PathDiagnosticBuilder PDB(*this, R, LastReportGraph->BackMap.get(), &PC);
 
   // Register additional node visitors.
   R->addVisitor(new NilReceiverBRVisitor());
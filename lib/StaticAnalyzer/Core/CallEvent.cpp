@@ -13,15 +13,23 @@
 //
 //===----------------------------------------------------------------------===//
 
+#define DEBUG_TYPE "CallEvent"
+
 #include "clang/StaticAnalyzer/Core/PathSensitive/CallEvent.h"
 #include "clang/Analysis/ProgramPoint.h"
 #include "clang/AST/ParentMap.h"
 #include "llvm/ADT/SmallSet.h"
+#include "llvm/ADT/Statistic.h"
 #include "llvm/ADT/StringExtras.h"
 
 using namespace clang;
 using namespace ento;
 
+STATISTIC(NumCallEventsAllocated,
+  "The # of CallEvent blocks taken from the allocator");
+STATISTIC(NumCallEventsReused,
+  "The # of CallEvents created in recycled blocks");
+
 QualType CallEvent::getResultType() const {
   const Expr *E = getOriginExpr();
   assert(E && "Calls without origin expressions do not have results");
@@ -834,6 +842,15 @@ void ObjCMethodCall::getInitialStackFrameContents(
   }
 }
 
+void *CallEventManager::allocate() {
+  if (!Cache.empty()) {
+    ++NumCallEventsReused;
+    return Cache.pop_back_val();
+  }
+  ++NumCallEventsAllocated;
+  return Alloc.Allocate<FunctionCall>();
+}
+
 CallEventRef<>
 CallEventManager::getSimpleCall(const CallExpr *CE, ProgramStateRef State,
                                 const LocationContext *LCtx) {
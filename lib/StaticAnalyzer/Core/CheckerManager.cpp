@@ -17,10 +17,48 @@
 #include "clang/StaticAnalyzer/Core/PathSensitive/CallEvent.h"
 #include "clang/Analysis/ProgramPoint.h"
 #include "clang/AST/DeclBase.h"
+#include "clang/Basic/ProfilingSupport.h"
+#include "llvm/Support/Format.h"
+#include "llvm/Support/raw_ostream.h"
+#include <algorithm>
 
 using namespace clang;
 using namespace ento;
 
+namespace {
+/// \brief Accounts one checker callback to its checker when checkers are
+/// profiled.
+class CheckerProfileScope {
+  CheckerManager::CallbackProfile *Profile;
+  const ExplodedNodeSet *Dst;
+  unsigned DstSize;
+  uint64_t Start;
+
+public:
+  /// \p dst, if given, is the set that receives the nodes of the callback.
+  CheckerProfileScope(CheckerManager &Mgr, const CheckerBase *Checker,
+                      CheckerManager::CallbackKind K,
+                      const ExplodedNodeSet *dst = 0)
+    : Profile(Mgr.getCallbackProfile(Checker, K)), Dst(dst), DstSize(0),
+      Start(0) {
+    if (!Profile)
+      return;
+    if (Dst)
+      DstSize = Dst->size();
+    Start = getCurrentTimeInNanoseconds();
+  }
+
+  ~CheckerProfileScope() {
+    if (!Profile)
+      return;
+    Profile->Time += getCurrentTimeInNanoseconds() - Start;
+    ++Profile->Calls;
+    if (Dst && Dst->size() > DstSize)
+      Profile->Nodes += Dst->size() - DstSize;
+  }
+};
+}
+
 bool CheckerManager::hasPathSensitiveCheckers() const {
   return !StmtCheckers.empty()              ||
          !PreObjCMessageCheckers.empty()    ||
@@ -75,16 +113,20 @@ void CheckerManager::runCheckersOnASTDecl(const Decl *D, AnalysisManager& mgr,
 
   assert(checkers);
   for (CachedDeclCheckers::iterator
-         I = checkers->begin(), E = checkers->end(); I != E; ++I)
+         I = checkers->begin(), E = checkers->end(); I != E; ++I) {
+    CheckerProfileScope Scope(*this, I->Checker, CK_ASTDecl);
     (*I)(D, mgr, BR);
+  }
 }
 
 void CheckerManager::runCheckersOnASTBody(const Decl *D, AnalysisManager& mgr,
                                           BugReporter &BR) {
   assert(D && D->hasBody());
 
-  for (unsigned i = 0, e = BodyCheckers.size(); i != e; ++i)
+  for (unsigned i = 0, e = BodyCheckers.size(); i != e; ++i) {
+    CheckerProfileScope Scope(*this, BodyCheckers[i].Checker, CK_ASTCodeBody);
     BodyCheckers[i](D, mgr, BR);
+  }
 }
 
 //===----------------------------------------------------------------------===//
@@ -94,7 +136,8 @@ void CheckerManager::runCheckersOnASTBody(const Decl *D, AnalysisManager& mgr,
 template <typename CHECK_CTX>
 static void expandGraphWithCheckers(CHECK_CTX checkCtx,
                                     ExplodedNodeSet &Dst,
-                                    const ExplodedNodeSet &Src) {
+                                    const ExplodedNodeSet &Src,
+                                    CheckerManager::CallbackKind Kind) {
   const NodeBuilderContext &BldrCtx = checkCtx.Eng.getBuilderContext();
   if (Src.empty())
     return;
@@ -121,6 +164,8 @@ static void expandGraphWithCheckers(CHECK_CTX checkCtx,
     NodeBuilder B(*PrevSet, *CurrSet, BldrCtx);
     for (ExplodedNodeSet::iterator NI = PrevSet->begin(), NE = PrevSet->end();
          NI != NE; ++NI) {
+      CheckerProfileScope Scope(checkCtx.Eng.getCheckerManager(), I->Checker,
+                                Kind, CurrSet);
       checkCtx.runChecker(*I, B, *NI);
     }
 
@@ -172,7 +217,7 @@ void CheckerManager::runCheckersForStmt(bool isPreVisit,
                                         bool WasInlined) {
   CheckStmtContext C(isPreVisit, *getCachedStmtCheckersFor(S, isPreVisit),
                      S, Eng, WasInlined);
-  expandGraphWithCheckers(C, Dst, Src);
+  expandGraphWithCheckers(C, Dst, Src, isPreVisit ? CK_PreStmt : CK_PostStmt);
 }
 
 namespace {
@@ -213,7 +258,8 @@ void CheckerManager::runCheckersForObjCMessage(bool isPreVisit,
                             isPreVisit ? PreObjCMessageCheckers
                                        : PostObjCMessageCheckers,
                             msg, Eng, WasInlined);
-  expandGraphWithCheckers(C, Dst, Src);
+  expandGraphWithCheckers(C, Dst, Src,
+                          isPreVisit ? CK_PreObjCMessage : CK_PostObjCMessage);
 }
 
 namespace {
@@ -256,7 +302,7 @@ void CheckerManager::runCheckersForCallEvent(bool isPreVisit,
                      isPreVisit ? PreCallCheckers
                                 : PostCallCheckers,
                      Call, Eng, WasInlined);
-  expandGraphWithCheckers(C, Dst, Src);
+  expandGraphWithCheckers(C, Dst, Src, isPreVisit ? CK_PreCall : CK_PostCall);
 }
 
 namespace {
@@ -303,7 +349,7 @@ void CheckerManager::runCheckersForLocation(ExplodedNodeSet &Dst,
                                             ExprEngine &Eng) {
   CheckLocationContext C(LocationCheckers, location, isLoad, NodeEx,
                          BoundEx, Eng);
-  expandGraphWithCheckers(C, Dst, Src);
+  expandGraphWithCheckers(C, Dst, Src, CK_Location);
 }
 
 namespace {
@@ -341,14 +387,17 @@ void CheckerManager::runCheckersForBind(ExplodedNodeSet &Dst,
                                         const Stmt *S, ExprEngine &Eng,
                                         const ProgramPoint &PP) {
   CheckBindContext C(BindCheckers, location, val, S, Eng, PP);
-  expandGraphWithCheckers(C, Dst, Src);
+  expandGraphWithCheckers(C, Dst, Src, CK_Bind);
 }
 
 void CheckerManager::runCheckersForEndAnalysis(ExplodedGraph &G,
                                                BugReporter &BR,
                                                ExprEngine &Eng) {
-  for (unsigned i = 0, e = EndAnalysisCheckers.size(); i != e; ++i)
+  for (unsigned i = 0, e = EndAnalysisCheckers.size(); i != e; ++i) {
+    CheckerProfileScope Scope(*this, EndAnalysisCheckers[i].Checker,
+                              CK_EndAnalysis);
     EndAnalysisCheckers[i](G, BR, Eng);
+  }
 }
 
 /// \brief Run checkers for end of path.
@@ -369,6 +418,7 @@ void CheckerManager::runCheckersForEndPath(NodeBuilderContext &BC,
     const ProgramPoint &L = BlockEntrance(BC.Block,
                                           Pred->getLocationContext(),
                                           checkFn.Checker);
+    CheckerProfileScope Scope(*this, checkFn.Checker, CK_EndPath, &Dst);
     CheckerContext C(Bldr, Eng, Pred, L);
     checkFn(C);
   }
@@ -406,14 +456,17 @@ void CheckerManager::runCheckersForBranchCondition(const Stmt *Condition,
   ExplodedNodeSet Src;
   Src.insert(Pred);
   CheckBranchConditionContext C(BranchConditionCheckers, Condition, Eng);
-  expandGraphWithCheckers(C, Dst, Src);
+  expandGraphWithCheckers(C, Dst, Src, CK_BranchCondition);
 }
 
 /// \brief Run checkers for live symbols.
 void CheckerManager::runCheckersForLiveSymbols(ProgramStateRef state,
                                                SymbolReaper &SymReaper) {
-  for (unsigned i = 0, e = LiveSymbolsCheckers.size(); i != e; ++i)
+  for (unsigned i = 0, e = LiveSymbolsCheckers.size(); i != e; ++i) {
+    CheckerProfileScope Scope(*this, LiveSymbolsCheckers[i].Checker,
+                              CK_LiveSymbols);
     LiveSymbolsCheckers[i](state, SymReaper);
+  }
 }
 
 namespace {
@@ -455,7 +508,7 @@ void CheckerManager::runCheckersForDeadSymbols(ExplodedNodeSet &Dst,
                                                ExprEngine &Eng,
                                                ProgramPoint::Kind K) {
   CheckDeadSymbolsContext C(DeadSymbolsCheckers, SymReaper, S, Eng, K);
-  expandGraphWithCheckers(C, Dst, Src);
+  expandGraphWithCheckers(C, Dst, Src, CK_DeadSymbols);
 }
 
 /// \brief True if at least one checker wants to check region changes.
@@ -479,6 +532,8 @@ CheckerManager::runCheckersForRegionChanges(ProgramStateRef state,
     // bail out.
     if (!state)
       return NULL;
+    CheckerProfileScope Scope(*this, RegionChangesCheckers[i].CheckFn.Checker,
+                              CK_RegionChanges);
     state = RegionChangesCheckers[i].CheckFn(state, invalidated, 
                                              ExplicitRegions, Regions, Call);
   }
@@ -494,6 +549,8 @@ CheckerManager::runCheckersForEvalAssume(ProgramStateRef state,
     // bail out.
     if (!state)
       return NULL;
+    CheckerProfileScope Scope(*this, EvalAssumeCheckers[i].Checker,
+                              CK_EvalAssume);
     state = EvalAssumeCheckers[i](state, Cond, Assumption);
   }
   return state;
@@ -522,7 +579,12 @@ void CheckerManager::runCheckersForEvalCall(ExplodedNodeSet &Dst,
            EI = InlineCallCheckers.begin(), EE = InlineCallCheckers.end();
          EI != EE; ++EI) {
       ExplodedNodeSet checkDst;
-      bool evaluated = (*EI)(CE, Eng, Pred, checkDst);
+      bool evaluated;
+      {
+        CheckerProfileScope Scope(*this, EI->Checker, CK_InlineCall,
+                                  &checkDst);
+        evaluated = (*EI)(CE, Eng, Pred, checkDst);
+      }
       assert(!(evaluated && anyEvaluated)
              && "There are more than one checkers evaluating the call");
       if (evaluated) {
@@ -553,6 +615,7 @@ void CheckerManager::runCheckersForEvalCall(ExplodedNodeSet &Dst,
       { // CheckerContext generates transitions(populates checkDest) on
         // destruction, so introduce the scope to make sure it gets properly
         // populated.
+        CheckerProfileScope Scope(*this, EI->Checker, CK_EvalCall, &checkDst);
         CheckerContext C(B, Eng, Pred, L);
         evaluated = (*EI)(CE, C);
       }
@@ -580,8 +643,11 @@ void CheckerManager::runCheckersOnEndOfTranslationUnit(
                                                   const TranslationUnitDecl *TU,
                                                   AnalysisManager &mgr,
                                                   BugReporter &BR) {
-  for (unsigned i = 0, e = EndOfTranslationUnitCheckers.size(); i != e; ++i)
+  for (unsigned i = 0, e = EndOfTranslationUnitCheckers.size(); i != e; ++i) {
+    CheckerProfileScope Scope(*this, EndOfTranslationUnitCheckers[i].Checker,
+                              CK_EndOfTranslationUnit);
     EndOfTranslationUnitCheckers[i](TU, mgr, BR);
+  }
 }
 
 void CheckerManager::runCheckersForPrintState(raw_ostream &Out,
@@ -714,7 +780,116 @@ CheckerManager::getCachedStmtCheckersFor(const Stmt *S, bool isPreVisit) {
   return checkers;
 }
 
+CheckerManager::CallbackProfile *
+CheckerManager::getCallbackProfileImpl(const CheckerBase *Checker,
+                                       CallbackKind K) {
+  CheckerProfile *&Profile = CheckerProfiles[Checker];
+  if (!Profile)
+    Profile = new CheckerProfile();
+  return &Profile->Callbacks[K];
+}
+
+static const char *getCallbackKindName(CheckerManager::CallbackKind K) {
+  switch (K) {
+  case CheckerManager::CK_ASTDecl: return "ASTDecl";
+  case CheckerManager::CK_ASTCodeBody: return "ASTCodeBody";
+  case CheckerManager::CK_PreStmt: return "PreStmt";
+  case CheckerManager::CK_PostStmt: return "PostStmt";
+  case CheckerManager::CK_PreObjCMessage: return "PreObjCMessage";
+  case CheckerManager::CK_PostObjCMessage: return "PostObjCMessage";
+  case CheckerManager::CK_PreCall: return "PreCall";
+  case CheckerManager::CK_PostCall: return "PostCall";
+  case CheckerManager::CK_Location: return "Location";
+  case CheckerManager::CK_Bind: return "Bind";
+  case CheckerManager::CK_EndAnalysis: return "EndAnalysis";
+  case CheckerManager::CK_EndPath: return "EndPath";
+  case CheckerManager::CK_BranchCondition: return "BranchCondition";
+  case CheckerManager::CK_LiveSymbols: return "LiveSymbols";
+  case CheckerManager::CK_DeadSymbols: return "DeadSymbols";
+  case CheckerManager::CK_RegionChanges: return "RegionChanges";
+  case CheckerManager::CK_EvalAssume: return "EvalAssume";
+  case CheckerManager::CK_EvalCall: return "EvalCall";
+  case CheckerManager::CK_InlineCall: return "InlineCall";
+  case CheckerManager::CK_EndOfTranslationUnit: return "EndOfTranslationUnit";
+  case CheckerManager::NumCallbackKinds: break;
+  }
+  llvm_unreachable("Unknown callback kind");
+}
+
+namespace {
+struct NamedCheckerProfileLess {
+  bool operator()(const CheckerManager::NamedCheckerProfile &LHS,
+                  const CheckerManager::NamedCheckerProfile &RHS) const {
+    return LHS.first < RHS.first;
+  }
+};
+}
+
+void CheckerManager::collectCheckerProfiles(
+                             std::vector<NamedCheckerProfile> &Result) const {
+  for (llvm::DenseMap<const CheckerBase *, CheckerProfile *>::const_iterator
+         I = CheckerProfiles.begin(), E = CheckerProfiles.end(); I != E; ++I) {
+    llvm::DenseMap<const CheckerBase *, std::string>::const_iterator
+      NI = CheckerNames.find(I->first);
+    std::string Name;
+    if (NI != CheckerNames.end())
+      Name = NI->second;
+    if (Name.empty())
+      Name = "<unknown>";
+    Result.push_back(NamedCheckerProfile(Name, I->second->Callbacks));
+  }
+  std::stable_sort(Result.begin(), Result.end(), NamedCheckerProfileLess());
+}
+
+void CheckerManager::printCheckerProfile(raw_ostream &OS) const {
+  std::vector<NamedCheckerProfile> Profiles;
+  collectCheckerProfiles(Profiles);
+
+  OS << "\n*** Checker Profile:\n";
+  OS << "       Time (ms)        Calls        Nodes  Checker - Callback\n";
+  for (unsigned I = 0, E = Profiles.size(); I != E; ++I) {
+    for (unsigned K = 0; K != NumCallbackKinds; ++K) {
+      const CallbackProfile &P = Profiles[I].second[K];
+      if (!P.Calls)
+        continue;
+      OS.indent(4) << llvm::format("%12.3f %12u %12u", P.Time / 1e6, P.Calls,
+                                   P.Nodes)
+         << "  " << Profiles[I].first << " - "
+         << getCallbackKindName(CallbackKind(K)) << '\n';
+    }
+  }
+}
+
+
+void CheckerManager::printCheckerProfileJSON(raw_ostream &OS) const {
+  std::vector<NamedCheckerProfile> Profiles;
+  collectCheckerProfiles(Profiles);
+
+  OS << "{\n  \"checkers\": [";
+  for (unsigned I = 0, E = Profiles.size(); I != E; ++I) {
+    OS << (I ? ",\n" : "\n") << "    { \"name\": ";
+    printJSONString(OS, Profiles[I].first);
+    OS << ", \"callbacks\": {";
+    bool First = true;
+    for (unsigned K = 0; K != NumCallbackKinds; ++K) {
+      const CallbackProfile &P = Profiles[I].second[K];
+      if (!P.Calls)
+        continue;
+      OS << (First ? "\n" : ",\n") << "        ";
+      First = false;
+      printJSONString(OS, getCallbackKindName(CallbackKind(K)));
+      OS << ": { \"calls\": " << P.Calls << ", \"time_ns\": " << P.Time
+         << ", \"nodes\": " << P.Nodes << " }";
+    }
+    OS << (First ? "" : "\n    ") << "} }";
+  }
+  OS << "\n  ]\n}\n";
+}
+
 CheckerManager::~CheckerManager() {
   for (unsigned i = 0, e = CheckerDtors.size(); i != e; ++i)
     CheckerDtors[i]();
+  for (llvm::DenseMap<const CheckerBase *, CheckerProfile *>::iterator
+         I = CheckerProfiles.begin(), E = CheckerProfiles.end(); I != E; ++I)
+    delete I->second;
 }
@@ -8,6 +8,7 @@
 //===----------------------------------------------------------------------===//
 
 #include "clang/StaticAnalyzer/Core/CheckerRegistry.h"
+#include "clang/StaticAnalyzer/Core/CheckerManager.h"
 #include "clang/StaticAnalyzer/Core/CheckerOptInfo.h"
 #include "llvm/ADT/SetVector.h"
 
@@ -105,8 +106,10 @@ void CheckerRegistry::initializeManager(CheckerManager &checkerMgr,
   // Initialize the CheckerManager with all enabled checkers.
   for (CheckerInfoSet::iterator
          i = enabledCheckers.begin(), e = enabledCheckers.end(); i != e; ++i) {
+    checkerMgr.setCurrentCheckerName((*i)->FullName);
     (*i)->Initialize(checkerMgr);
   }
+  checkerMgr.setCurrentCheckerName(StringRef());
 }
 
 void CheckerRegistry::printHelp(llvm::raw_ostream &out,
@@ -19,9 +19,13 @@
 #include "clang/StaticAnalyzer/Core/PathSensitive/ExprEngine.h"
 #include "clang/AST/Expr.h"
 #include "clang/AST/StmtCXX.h"
+#include "clang/Basic/ProfilingSupport.h"
 #include "llvm/Support/Casting.h"
 #include "llvm/ADT/DenseMap.h"
+#include "llvm/ADT/DenseSet.h"
 #include "llvm/ADT/Statistic.h"
+#include <algorithm>
+#include <vector>
 
 using namespace clang;
 using namespace ento;
@@ -32,6 +36,12 @@ STATISTIC(NumReachedMaxSteps,
             "The # of times we reached the max number of steps.");
 STATISTIC(NumPathsExplored,
             "The # of paths explored by the analyzer.");
+STATISTIC(NumExceededTimeBudget,
+            "The # of functions whose analysis exceeded the time budget.");
+
+/// The number of steps between two checks of the time budget, which cost a
+/// system call each.
+static const unsigned TimeBudgetCheckInterval = 256;
 
 //===----------------------------------------------------------------------===//
 // Worklist classes for exploration of reachable states.
@@ -156,6 +166,89 @@ WorkList* WorkList::makeBFSBlockDFSContents() {
   return new BFSBlockDFSContents();
 }
 
+namespace {
+  class UnexploredFirst : public WorkList {
+    struct Item {
+      WorkListUnit U;
+      /// Whether the unit enters a block that no path had reached before.
+      bool Unexplored;
+      /// The number of times the path of the unit visited its block.
+      unsigned NumVisited;
+      /// The order in which the unit was enqueued.
+      unsigned Order;
+
+      Item(const WorkListUnit &U, bool Unexplored, unsigned NumVisited,
+           unsigned Order)
+        : U(U), Unexplored(Unexplored), NumVisited(NumVisited), Order(Order) {}
+    };
+
+    /// Orders the items so that the heap's top is the one to process next:
+    /// unexplored blocks first, then the fewest visits, then the most recently
+    /// enqueued one, which makes exploration depth-first among equals.
+    struct ItemLess {
+      bool operator()(const Item &LHS, const Item &RHS) const {
+        if (LHS.Unexplored != RHS.Unexplored)
+          return RHS.Unexplored;
+        if (LHS.NumVisited != RHS.NumVisited)
+          return LHS.NumVisited > RHS.NumVisited;
+        return LHS.Order < RHS.Order;
+      }
+    };
+
+    typedef std::pair<const CFGBlock *, const StackFrameContext *> BlockInFrame;
+
+    /// The blocks entered by an enqueued unit so far, per stack frame.
+    llvm::DenseSet<BlockInFrame> Reached;
+
+    std::vector<Item> Heap;
+    unsigned NextOrder;
+
+  public:
+    UnexploredFirst() : NextOrder(0) {}
+
+    virtual bool hasWork() const {
+      return !Heap.empty();
+    }
+
+    virtual void enqueue(const WorkListUnit& U) {
+      bool Unexplored = false;
+      unsigned NumVisited = 0;
+      const ExplodedNode *N = U.getNode();
+      ProgramPoint Loc = N->getLocation();
+      if (const BlockEdge *E = dyn_cast<BlockEdge>(&Loc)) {
+        const CFGBlock *B = E->getDst();
+        const StackFrameContext *SF = N->getStackFrame();
+        Unexplored = Reached.insert(BlockInFrame(B, SF)).second;
+        NumVisited = U.getBlockCounter().getNumVisited(SF, B->getBlockID());
+      }
+
+      Heap.push_back(Item(U, Unexplored, NumVisited, NextOrder++));
+      std::push_heap(Heap.begin(), Heap.end(), ItemLess());
+    }
+
+    virtual WorkListUnit dequeue() {
+      assert(!Heap.empty());
+      std::pop_heap(Heap.begin(), Heap.end(), ItemLess());
+      WorkListUnit U = Heap.back().U;
+      Heap.pop_back();
+      return U;
+    }
+
+    virtual bool visitItemsInWorkList(Visitor &V) {
+      for (std::vector<Item>::iterator I = Heap.begin(), E = Heap.end();
+           I != E; ++I) {
+        if (V.visit(I->U))
+          return true;
+      }
+      return false;
+    }
+  };
+} // end anonymous namespace
+
+WorkList *WorkList::makeUnexploredFirst() {
+  return new UnexploredFirst();
+}
+
 //===----------------------------------------------------------------------===//
 // Core analysis engine.
 //===----------------------------------------------------------------------===//
@@ -210,6 +303,14 @@ bool CoreEngine::ExecuteWorkList(const LocationContext *L, unsigned Steps,
     }
 
     NumSteps++;
+    NumStepsExecuted++;
+
+    if (Deadline && !ExceededTimeBudget &&
+        NumStepsExecuted % TimeBudgetCheckInterval == 0 &&
+        getCurrentTimeInMilliseconds() > Deadline) {
+      NumExceededTimeBudget++;
+      ExceededTimeBudget = true;
+    }
 
     const WorkListUnit& WU = WList->dequeue();
 
@@ -225,6 +326,10 @@ bool CoreEngine::ExecuteWorkList(const LocationContext *L, unsigned Steps,
   return WList->hasWork();
 }
 
+void CoreEngine::setTimeBudget(unsigned Milliseconds) {
+  Deadline = Milliseconds ? getCurrentTimeInMilliseconds() + Milliseconds : 0;
+}
+
 void CoreEngine::dispatchWorkItem(ExplodedNode* Pred, ProgramPoint Loc,
                                   const WorkListUnit& WU) {
   // Dispatch on the location type.
@@ -287,9 +392,13 @@ void CoreEngine::HandleBlockEdge(const BlockEdge &L, ExplodedNode *Pred) {
 
   // Mark this block as visited.
   const LocationContext *LC = Pred->getLocationContext();
+  bool Inlined = LC->getCurrentStackFrame()->getParent() != 0;
+  if (Inlined)
+    ++NumInlinedBlockVisits;
   FunctionSummaries->markVisitedBasicBlock(Blk->getBlockID(),
                                            LC->getDecl(),
-                                           LC->getCFG()->getNumBlockIDs());
+                                           LC->getCFG()->getNumBlockIDs(),
+                                           Inlined);
 
   // Check if we are entering the EXIT block.
   if (Blk == &(L.getLocationContext()->getCFG()->getExit())) {
@@ -12,6 +12,7 @@
 //
 //===----------------------------------------------------------------------===//
 
+#define DEBUG_TYPE "ExplodedGraph"
 #include "clang/StaticAnalyzer/Core/PathSensitive/ExplodedGraph.h"
 #include "clang/StaticAnalyzer/Core/PathSensitive/CallEvent.h"
 #include "clang/StaticAnalyzer/Core/PathSensitive/ProgramState.h"
@@ -26,6 +27,9 @@
 using namespace clang;
 using namespace ento;
 
+STATISTIC(NumNodesCreated,
+          "The # of exploded graph nodes created.");
+
 //===----------------------------------------------------------------------===//
 // Node auditing.
 //===----------------------------------------------------------------------===//
@@ -47,10 +51,9 @@ void ExplodedNode::SetAuditor(ExplodedNode::Auditor* A) {
 // Cleanup.
 //===----------------------------------------------------------------------===//
 
-static const unsigned CounterTop = 1000;
-
 ExplodedGraph::ExplodedGraph()
-  : NumNodes(0), reclaimNodes(false), reclaimCounter(CounterTop) {}
+  : NumNodes(0), NumPendingNodes(0), reclaimNodes(false), reclaimCounter(1000),
+    ReclaimInterval(1000), NumReclaimedNodes(0) {}
 
 ExplodedGraph::~ExplodedGraph() {}
 
@@ -137,6 +140,7 @@ void ExplodedGraph::collectNode(ExplodedNode *node) {
   FreeNodes.push_back(node);
   Nodes.RemoveNode(node);
   --NumNodes;
+  ++NumReclaimedNodes;
   node->~ExplodedNode();  
 }
 
@@ -150,15 +154,27 @@ void ExplodedGraph::reclaimRecentlyAllocatedNodes() {
   assert(reclaimCounter > 0);
   if (--reclaimCounter != 0)
     return;
-  reclaimCounter = CounterTop;
-
-  for (NodeVector::iterator it = ChangedNodes.begin(), et = ChangedNodes.end();
-       it != et; ++it) {
-    ExplodedNode *node = *it;
+  reclaimCounter = ReclaimInterval;
+
+  // Nodes that do not have a successor yet are still on the frontier of the
+  // exploration.  Keep them around for the next pass instead of giving up on
+  // them, so that long linear chains get collapsed even if a pass happens to
+  // run while the chain is being extended.  A node is kept for one pass only;
+  // nodes at the end of a path never get a successor, and keeping them until
+  // they do would let ChangedNodes grow with the whole graph.
+  NodeVector Pending;
+  for (unsigned i = 0, e = ChangedNodes.size(); i != e; ++i) {
+    ExplodedNode *node = ChangedNodes[i];
+    if (node->succ_empty()) {
+      if (i >= NumPendingNodes && !node->isSink())
+        Pending.push_back(node);
+      continue;
+    }
     if (shouldCollect(node))
       collectNode(node);
   }
-  ChangedNodes.clear();
+  NumPendingNodes = Pending.size();
+  ChangedNodes.swap(Pending);
 }
 
 //===----------------------------------------------------------------------===//
@@ -290,6 +306,7 @@ ExplodedNode *ExplodedGraph::getNode(const ProgramPoint &L,
     // Insert the node into the node set and return it.
     Nodes.InsertNode(V, InsertPos);
     ++NumNodes;
+    ++NumNodesCreated;
 
     if (IsNew) *IsNew = true;
   }
@@ -41,6 +41,8 @@ using llvm::APSInt;
 
 STATISTIC(NumRemoveDeadBindings,
             "The # of times RemoveDeadBindings is called");
+STATISTIC(NumRemoveDeadBindingsCached,
+            "The # of times RemoveDeadBindings reused a previous result");
 STATISTIC(NumMaxBlockCountReached,
             "The # of aborted paths due to reaching the maximum block count in "
             "a top level function");
@@ -54,12 +56,26 @@ STATISTIC(NumTimesRetriedWithoutInlining,
 // Engine construction and deletion.
 //===----------------------------------------------------------------------===//
 
+static WorkList *createWorkList(const AnalyzerOptions &Opts) {
+  switch (Opts.getExplorationStrategy()) {
+  case ESK_DFS:
+    return WorkList::makeDFS();
+  case ESK_BFS:
+    return WorkList::makeBFS();
+  case ESK_BFSBlockDFSContents:
+    return WorkList::makeBFSBlockDFSContents();
+  case ESK_UnexploredFirst:
+    return WorkList::makeUnexploredFirst();
+  }
+  llvm_unreachable("Unknown exploration strategy");
+}
+
 ExprEngine::ExprEngine(AnalysisManager &mgr, bool gcEnabled,
                        SetOfConstDecls *VisitedCalleesIn,
                        FunctionSummariesTy *FS)
   : AMgr(mgr),
     AnalysisDeclContexts(mgr.getAnalysisDeclContextManager()),
-    Engine(*this, FS),
+    Engine(*this, FS, createWorkList(mgr.options)),
     G(Engine.getGraph()),
     StateMgr(getContext(), mgr.getStoreManagerCreator(),
              mgr.getConstraintManagerCreator(), G.getAllocator(),
@@ -75,8 +91,9 @@ ExprEngine::ExprEngine(AnalysisManager &mgr, bool gcEnabled,
 {
     if (mgr.options.eagerlyTrimExplodedGraph) {
       // Enable eager node reclaimation when constructing the ExplodedGraph.
-      G.enableNodeReclamation();
+      G.enableNodeReclamation(mgr.options.getGraphTrimInterval());
     }
+    Engine.setTimeBudget(mgr.options.getTimeBudget());
 }
 
 ExprEngine::~ExprEngine() {
@@ -259,6 +276,24 @@ void ExprEngine::removeDead(ExplodedNode *Pred, ExplodedNodeSet &Out,
           ReferenceStmt == 0) && "PreStmt is not generally supported by "
                                  "the SymbolReaper yet");
   NumRemoveDeadBindings++;
+  static SimpleProgramPointTag cleanupTag("ExprEngine : Clean Node");
+
+  // Sibling nodes often reach the same statement with the same state.  If
+  // cleaning that state up did not find dead symbols before, the result only
+  // depends on the state, the statement and the location context, so reuse it.
+  CleanedStateCacheKey CacheKey(Pred->getState().getPtr(),
+                                std::make_pair(ReferenceStmt, LC));
+  llvm::DenseMap<CleanedStateCacheKey,
+                 std::pair<ProgramStateRef, ProgramStateRef> >::iterator
+    CacheI = CleanedStateCache.find(CacheKey);
+  if (CacheI != CleanedStateCache.end()) {
+    NumRemoveDeadBindingsCached++;
+    CleanedState = CacheI->second.second;
+    StmtNodeBuilder Bldr(Pred, Out, *currBldrCtx);
+    Bldr.generateNode(DiagnosticStmt, Pred, CleanedState, &cleanupTag, K);
+    return;
+  }
+
   CleanedState = Pred->getState();
   SymbolReaper SymReaper(LC, ReferenceStmt, SymMgr, getStoreManager());
 
@@ -271,9 +306,13 @@ void ExprEngine::removeDead(ExplodedNode *Pred, ExplodedNodeSet &Out,
   CleanedState = StateMgr.removeDeadBindings(CleanedState, SFC, SymReaper);
 
   // Process any special transfer function for dead symbols.
-  // A tag to track convenience transitions, which can be removed at cleanup.
-  static SimpleProgramPointTag cleanupTag("ExprEngine : Clean Node");
   if (!SymReaper.hasDeadSymbols()) {
+    // Keep the cache from growing without bounds on long paths.
+    if (CleanedStateCache.size() >= 4096)
+      CleanedStateCache.clear();
+    CleanedStateCache[CacheKey] = std::make_pair(Pred->getState(),
+                                                 CleanedState);
+
     // Generate a CleanedNode that has the environment and store cleaned
     // up. Since no symbols are dead, we can optimize and not clean out
     // the constraint manager.
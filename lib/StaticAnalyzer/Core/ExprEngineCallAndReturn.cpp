@@ -32,6 +32,9 @@ STATISTIC(NumOfDynamicDispatchPathSplits,
 STATISTIC(NumInlinedCalls,
   "The # of times we inlined a call");
 
+STATISTIC(NumCallsOverInliningBudget,
+  "The # of times we did not inline a call because of the inlining budget");
+
 void ExprEngine::processCallEnter(CallEnter CE, ExplodedNode *Pred) {
   // Get the entry block in the CFG of the callee.
   const StackFrameContext *calleeCtx = CE.getCalleeContext();
@@ -274,6 +277,11 @@ static bool IsInStdNamespace(const FunctionDecl *FD) {
 
 // Determine if we should inline the call.
 bool ExprEngine::shouldInlineDecl(const Decl *D, ExplodedNode *Pred) {
+  // Once out of time, finish the analysis without inlining, which evaluates
+  // the remaining calls conservatively.
+  if (Engine.hasExceededTimeBudget())
+    return false;
+
   AnalysisDeclContext *CalleeADC = AMgr.getAnalysisDeclContext(D);
   const CFG *CalleeCFG = CalleeADC->getCFG();
 
@@ -322,9 +330,38 @@ bool ExprEngine::shouldInlineDecl(const Decl *D, ExplodedNode *Pred) {
   if (!CalleeADC->getAnalysis<RelaxedLiveVariables>())
     return false;
 
+  if (unsigned Budget = AMgr.options.getInliningBudget()) {
+    unsigned Spent = Engine.getNumInlinedBlockVisits();
+    if (Spent >= Budget ||
+        estimateInliningCost(D, CalleeCFG) > Budget - Spent) {
+      NumCallsOverInliningBudget++;
+      return false;
+    }
+  }
+
   return true;
 }
 
+unsigned ExprEngine::estimateInliningCost(const Decl *D,
+                                          const CFG *CalleeCFG) {
+  // Once the callee has been inlined, what it cost then is the best guess.
+  FunctionSummariesTy &FS = *Engine.FunctionSummaries;
+  if (unsigned Visits = FS.getAverageInlinedBlockVisits(D))
+    return Visits;
+
+  // Otherwise assume that each block is visited once, and that every loop
+  // visits them all again each time it is unrolled.
+  unsigned NumLoops = 0;
+  for (CFG::const_iterator I = CalleeCFG->begin(), E = CalleeCFG->end();
+       I != E; ++I)
+    if ((*I)->getLoopTarget())
+      ++NumLoops;
+  unsigned Unrolls = AMgr.options.maxBlockVisitOnPath;
+  if (Unrolls)
+    --Unrolls;
+  return CalleeCFG->getNumBlockIDs() * (1 + NumLoops * Unrolls);
+}
+
 /// The GDM component containing the dynamic dispatch bifurcation info. When
 /// the exact type of the receiver is not known, we want to explore both paths -
 /// one on which we do inline it and the other one on which we don't. This is
@@ -480,6 +517,7 @@ bool ExprEngine::inlineCall(const CallEvent &Call, const Decl *D,
   Bldr.takeNodes(Pred);
 
   NumInlinedCalls++;
+  Engine.FunctionSummaries->markInlined(D);
 
   // Mark the decl as visited.
   if (VisitedCallees)
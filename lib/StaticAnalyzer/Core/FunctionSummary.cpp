@@ -12,6 +12,15 @@
 //===----------------------------------------------------------------------===//
 
 #include "clang/StaticAnalyzer/Core/PathSensitive/FunctionSummary.h"
+#include "clang/AST/ASTContext.h"
+#include "clang/AST/DeclCXX.h"
+#include "clang/AST/DeclObjC.h"
+#include "clang/AST/Mangle.h"
+#include "llvm/ADT/STLExtras.h"
+#include "llvm/ADT/SmallString.h"
+#include "llvm/Support/MemoryBuffer.h"
+#include "llvm/Support/raw_ostream.h"
+#include "llvm/Support/system_error.h"
 using namespace clang;
 using namespace ento;
 
@@ -36,3 +45,96 @@ unsigned FunctionSummariesTy::getTotalNumVisitedBasicBlocks() {
   }
   return Total;
 }
+
+bool FunctionSummariesTy::getSummaryName(const Decl *D,
+                                         SmallVectorImpl<char> &Name) {
+  llvm::raw_svector_ostream Out(Name);
+
+  if (const ObjCMethodDecl *MD = dyn_cast<ObjCMethodDecl>(D)) {
+    const ObjCInterfaceDecl *ID = MD->getClassInterface();
+    if (!ID)
+      return false;
+    Out << (MD->isInstanceMethod() ? "-[" : "+[") << *ID << ' '
+        << MD->getSelector().getAsString() << ']';
+    return true;
+  }
+
+  // Functions with internal linkage in different translation units are
+  // different functions, even if they have the same name.
+  const FunctionDecl *FD = dyn_cast<FunctionDecl>(D);
+  if (!FD || FD->getLinkage() != ExternalLinkage)
+    return false;
+
+  if (!MangleCtx)
+    MangleCtx.reset(FD->getASTContext().createMangleContext());
+  if (const CXXConstructorDecl *CD = dyn_cast<CXXConstructorDecl>(FD))
+    MangleCtx->mangleCXXCtor(CD, Ctor_Complete, Out);
+  else if (const CXXDestructorDecl *DD = dyn_cast<CXXDestructorDecl>(FD))
+    MangleCtx->mangleCXXDtor(DD, Dtor_Complete, Out);
+  else if (MangleCtx->shouldMangleDeclName(FD))
+    MangleCtx->mangleName(FD, Out);
+  else
+    Out << *FD;
+  return true;
+}
+
+bool FunctionSummariesTy::hasImportedReachedMaxBlockCount(const Decl *D) {
+  llvm::DenseMap<const Decl*, bool>::iterator I
+    = ImportedMaxBlockCountCache.find(D);
+  if (I != ImportedMaxBlockCountCache.end())
+    return I->second;
+
+  SmallString<128> Name;
+  bool Imported = getSummaryName(D, Name) &&
+                  ImportedMaxBlockCountNames.count(Name);
+  ImportedMaxBlockCountCache[D] = Imported;
+  return Imported;
+}
+
+bool FunctionSummariesTy::readSummaries(StringRef Path,
+                                        std::string &ErrorStr) {
+  OwningPtr<llvm::MemoryBuffer> Buffer;
+  if (llvm::error_code EC = llvm::MemoryBuffer::getFile(Path, Buffer)) {
+    if (EC == llvm::errc::no_such_file_or_directory)
+      return true;
+    ErrorStr = EC.message();
+    return false;
+  }
+
+  // The file holds one function name per line.
+  StringRef Rest = Buffer->getBuffer();
+  while (!Rest.empty()) {
+    StringRef Line;
+    llvm::tie(Line, Rest) = Rest.split('\n');
+    if (!Line.empty())
+      ImportedMaxBlockCountNames.insert(Line);
+  }
+  ImportedMaxBlockCountCache.clear();
+  return true;
+}
+
+bool FunctionSummariesTy::writeSummaries(StringRef Path,
+                                         std::string &ErrorStr) {
+  std::string Names;
+  for (MapTy::iterator I = Map.begin(), E = Map.end(); I != E; ++I) {
+    if (!I->second->MayReachMaxBlockCount)
+      continue;
+    SmallString<128> Name;
+    if (getSummaryName(I->first, Name) &&
+        !ImportedMaxBlockCountNames.count(Name)) {
+      Names += Name.str();
+      Names += '\n';
+    }
+  }
+  if (Names.empty())
+    return true;
+
+  // Append all of the names at once, so that translation units analyzed
+  // concurrently do not interleave their lines.
+  llvm::raw_fd_ostream Out(Path.str().c_str(), ErrorStr,
+                           llvm::raw_fd_ostream::F_Append);
+  if (!ErrorStr.empty())
+    return false;
+  Out << Names;
+  return true;
+}
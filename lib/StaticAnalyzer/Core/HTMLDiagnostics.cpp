@@ -25,6 +25,7 @@
 #include "llvm/Support/MemoryBuffer.h"
 #include "llvm/Support/raw_ostream.h"
 #include "llvm/Support/Path.h"
+#include <map>
 
 using namespace clang;
 using namespace ento;
@@ -39,6 +40,12 @@ class HTMLDiagnostics : public PathDiagnosticConsumer {
   llvm::sys::Path Directory, FilePrefix;
   bool createdDir, noDir;
   const Preprocessor &PP;
+
+  /// The syntax and macro highlighting of each file reported in, which only
+  /// depends on the file, computed the first time a report needs it.
+  std::map<FileID, html::HighlightedRanges> Highlights;
+
+  const html::HighlightedRanges &getHighlights(FileID FID);
 public:
   HTMLDiagnostics(const std::string& prefix, const Preprocessor &pp);
 
@@ -95,6 +102,17 @@ void HTMLDiagnostics::FlushDiagnosticsImpl(
   }
 }
 
+const html::HighlightedRanges &HTMLDiagnostics::getHighlights(FileID FID) {
+  std::map<FileID, html::HighlightedRanges>::iterator I = Highlights.find(FID);
+  if (I != Highlights.end())
+    return I->second;
+
+  html::HighlightedRanges &Ranges = Highlights[FID];
+  html::CollectSyntaxHighlights(FID, PP, Ranges);
+  html::CollectMacroHighlights(FID, PP, Ranges);
+  return Ranges;
+}
+
 void HTMLDiagnostics::ReportDiag(const PathDiagnostic& D,
                                  FilesMade *filesMade) {
     
@@ -149,12 +167,9 @@ void HTMLDiagnostics::ReportDiag(const PathDiagnostic& D,
   html::EscapeText(R, FID);
   html::AddLineNumbers(R, FID);
 
-  // If we have a preprocessor, relex the file and syntax highlight.
-  // We might not have a preprocessor if we come from a deserialized AST file,
-  // for example.
-
-  html::SyntaxHighlight(R, FID, PP);
-  html::HighlightMacros(R, FID, PP);
+  // Syntax highlight the file and show its macro expansions.  Relexing it
+  // is the expensive part of the report, so it is only done once per file.
+  html::ApplyHighlights(R, FID, getHighlights(FID));
 
   // Get the full directory name of the analyzed file.
 
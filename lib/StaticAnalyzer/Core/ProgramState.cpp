@@ -454,6 +454,14 @@ ProgramStateManager::FindGDMContext(void *K,
 
 ProgramStateRef ProgramStateManager::addGDM(ProgramStateRef St, void *Key, void *Data){
   ProgramState::GenericDataMap M1 = St->getGDM();
+
+  // Checkers often store the same data again; the traits return their data
+  // unchanged when an update changes nothing, so a pointer comparison avoids
+  // rebuilding the map and uniquing the state.
+  if (void *const *Old = M1.lookup(Key))
+    if (*Old == Data)
+      return St;
+
   ProgramState::GenericDataMap M2 = GDMFactory.add(M1, Key, Data);
 
   if (M1 == M2)
@@ -466,6 +474,9 @@ ProgramStateRef ProgramStateManager::addGDM(ProgramStateRef St, void *Key, void
 
 ProgramStateRef ProgramStateManager::removeGDM(ProgramStateRef state, void *Key) {
   ProgramState::GenericDataMap OldM = state->getGDM();
+  if (!OldM.lookup(Key))
+    return state;
+
   ProgramState::GenericDataMap NewM = GDMFactory.remove(OldM, Key);
 
   if (NewM == OldM)
@@ -230,6 +230,24 @@ private:
     return true;
   }
 
+  /// isContainedIn - Returns true if all the values in the set are in the
+  /// modular range [Lower, Upper], i.e. intersecting with it changes nothing.
+  bool isContainedIn(const llvm::APSInt &Lower,
+                     const llvm::APSInt &Upper) const {
+    bool Wraps = Upper < Lower;
+    for (iterator i = begin(), e = end(); i != e; ++i) {
+      if (Wraps) {
+        // The range may be [Min, Upper] or [Lower, Max], but not both, since
+        // that would include the values in between.
+        if (i->To() > Upper && i->From() < Lower)
+          return false;
+      } else if (i->From() < Lower || i->To() > Upper) {
+        return false;
+      }
+    }
+    return true;
+  }
+
 public:
   // Returns a set containing the values in the receiving set, intersected with
   // the closed range [Lower, Upper]. Unlike the Range type, this range uses
@@ -243,6 +261,11 @@ public:
     if (!pin(Lower, Upper))
       return F.getEmptySet();
 
+    // Most assumptions do not constrain the symbol any further.  Avoid
+    // rebuilding the set in that case.
+    if (isContainedIn(Lower, Upper))
+      return *this;
+
     PrimRangeSet newRanges = F.getEmptySet();
 
     PrimRangeSet::iterator i = begin(), e = end();
@@ -295,6 +318,8 @@ struct ProgramStateTrait<ConstraintRange>
 namespace {
 class RangeConstraintManager : public SimpleConstraintManager{
   RangeSet GetRange(ProgramStateRef state, SymbolRef sym);
+  ProgramStateRef SetRange(ProgramStateRef state, SymbolRef sym,
+                           const RangeSet &New);
 public:
   RangeConstraintManager(SubEngine &subengine, BasicValueFactory &BVF)
     : SimpleConstraintManager(subengine, BVF) {}
@@ -387,6 +412,22 @@ RangeConstraintManager::GetRange(ProgramStateRef state, SymbolRef sym) {
   return Result;
 }
 
+/// Returns the state with \p New as the range of \p sym, or null if \p New is
+/// empty.  If the symbol is already constrained to \p New, returns \p state
+/// itself.
+ProgramStateRef
+RangeConstraintManager::SetRange(ProgramStateRef state, SymbolRef sym,
+                                 const RangeSet &New) {
+  if (New.isEmpty())
+    return NULL;
+
+  const ConstraintRangeTy::data_type *Old = state->get<ConstraintRange>(sym);
+  if (Old && *Old == New)
+    return state;
+
+  return state->set<ConstraintRange>(sym, New);
+}
+
 //===------------------------------------------------------------------------===
 // assumeSymX methods: public interface for RangeConstraintManager.
 //===------------------------------------------------------------------------===/
@@ -416,7 +457,7 @@ RangeConstraintManager::assumeSymNE(ProgramStateRef St, SymbolRef Sym,
   // [Int-Adjustment+1, Int-Adjustment-1]
   // Notice that the lower bound is greater than the upper bound.
   RangeSet New = GetRange(St, Sym).Intersect(getBasicVals(), F, Upper, Lower);
-  return New.isEmpty() ? NULL : St->set<ConstraintRange>(Sym, New);
+  return SetRange(St, Sym, New);
 }
 
 ProgramStateRef 
@@ -431,7 +472,7 @@ RangeConstraintManager::assumeSymEQ(ProgramStateRef St, SymbolRef Sym,
   // [Int-Adjustment, Int-Adjustment]
   llvm::APSInt AdjInt = AdjustmentType.convert(Int) - Adjustment;
   RangeSet New = GetRange(St, Sym).Intersect(getBasicVals(), F, AdjInt, AdjInt);
-  return New.isEmpty() ? NULL : St->set<ConstraintRange>(Sym, New);
+  return SetRange(St, Sym, New);
 }
 
 ProgramStateRef 
@@ -460,7 +501,7 @@ RangeConstraintManager::assumeSymLT(ProgramStateRef St, SymbolRef Sym,
   --Upper;
 
   RangeSet New = GetRange(St, Sym).Intersect(getBasicVals(), F, Lower, Upper);
-  return New.isEmpty() ? NULL : St->set<ConstraintRange>(Sym, New);
+  return SetRange(St, Sym, New);
 }
 
 ProgramStateRef 
@@ -489,7 +530,7 @@ RangeConstraintManager::assumeSymGT(ProgramStateRef St, SymbolRef Sym,
   ++Lower;
 
   RangeSet New = GetRange(St, Sym).Intersect(getBasicVals(), F, Lower, Upper);
-  return New.isEmpty() ? NULL : St->set<ConstraintRange>(Sym, New);
+  return SetRange(St, Sym, New);
 }
 
 ProgramStateRef 
@@ -518,7 +559,7 @@ RangeConstraintManager::assumeSymGE(ProgramStateRef St, SymbolRef Sym,
   llvm::APSInt Upper = Max-Adjustment;
 
   RangeSet New = GetRange(St, Sym).Intersect(getBasicVals(), F, Lower, Upper);
-  return New.isEmpty() ? NULL : St->set<ConstraintRange>(Sym, New);
+  return SetRange(St, Sym, New);
 }
 
 ProgramStateRef 
@@ -547,7 +588,7 @@ RangeConstraintManager::assumeSymLE(ProgramStateRef St, SymbolRef Sym,
   llvm::APSInt Upper = ComparisonVal-Adjustment;
 
   RangeSet New = GetRange(St, Sym).Intersect(getBasicVals(), F, Lower, Upper);
-  return New.isEmpty() ? NULL : St->set<ConstraintRange>(Sym, New);
+  return SetRange(St, Sym, New);
 }
 
 //===------------------------------------------------------------------------===
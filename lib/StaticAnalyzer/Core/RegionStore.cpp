@@ -623,6 +623,10 @@ class invalidateRegionsWorker : public ClusterAnalysis<invalidateRegionsWorker>
   const LocationContext *LCtx;
   StoreManager::InvalidatedSymbols &IS;
   StoreManager::InvalidatedRegions *Regions;
+
+  /// The LazyCompoundVals whose bindings have already been visited.
+  llvm::SmallPtrSet<const LazyCompoundValData *, 16> VisitedLazyVals;
+
 public:
   invalidateRegionsWorker(RegionStoreManager &rm,
                           ProgramStateManager &stateMgr,
@@ -657,21 +661,27 @@ void invalidateRegionsWorker::VisitBinding(SVal V) {
   if (const nonloc::LazyCompoundVal *LCS =
         dyn_cast<nonloc::LazyCompoundVal>(&V)) {
 
+    // Visiting the same value again would not invalidate anything else.
+    if (!VisitedLazyVals.insert(LCS->getCVData()))
+      return;
+
     const MemRegion *LazyR = LCS->getRegion();
     RegionBindings B = RegionStoreManager::GetRegionBindings(LCS->getStore());
 
-    // FIXME: This should not have to walk all bindings in the old store.
-    for (RegionBindings::iterator RI = B.begin(), RE = B.end(); RI != RE; ++RI){
-      const ClusterBindings &Cluster = RI.getData();
-      for (ClusterBindings::iterator CI = Cluster.begin(), CE = Cluster.end();
-           CI != CE; ++CI) {
-        BindingKey K = CI.getKey();
-        if (const SubRegion *BaseR = dyn_cast<SubRegion>(K.getRegion())) {
-          if (BaseR == LazyR)
-            VisitBinding(CI.getData());
-          else if (K.hasSymbolicOffset() && BaseR->isSubRegionOf(LazyR))
-            VisitBinding(CI.getData());
-        }
+    // All the bindings of LazyR and its subregions are in the cluster of its
+    // base region, so only that cluster of the old store has to be walked.
+    const ClusterBindings *Cluster = B.lookup(LazyR->getBaseRegion());
+    if (!Cluster)
+      return;
+
+    for (ClusterBindings::iterator CI = Cluster->begin(), CE = Cluster->end();
+         CI != CE; ++CI) {
+      BindingKey K = CI.getKey();
+      if (const SubRegion *BaseR = dyn_cast<SubRegion>(K.getRegion())) {
+        if (BaseR == LazyR)
+          VisitBinding(CI.getData());
+        else if (K.hasSymbolicOffset() && BaseR->isSubRegionOf(LazyR))
+          VisitBinding(CI.getData());
       }
     }
 
@@ -1871,6 +1881,9 @@ class removeDeadBindingsWorker :
   SymbolReaper &SymReaper;
   const StackFrameContext *CurrentLCtx;
 
+  /// The LazyCompoundVals whose bindings have already been visited.
+  llvm::SmallPtrSet<const LazyCompoundValData *, 16> VisitedLazyVals;
+
 public:
   removeDeadBindingsWorker(RegionStoreManager &rm,
                            ProgramStateManager &stateMgr,
@@ -1939,21 +1952,27 @@ void removeDeadBindingsWorker::VisitBinding(SVal V) {
   if (const nonloc::LazyCompoundVal *LCS =
         dyn_cast<nonloc::LazyCompoundVal>(&V)) {
 
+    // Visiting the same value again would not mark anything else as live.
+    if (!VisitedLazyVals.insert(LCS->getCVData()))
+      return;
+
     const MemRegion *LazyR = LCS->getRegion();
     RegionBindings B = RegionStoreManager::GetRegionBindings(LCS->getStore());
 
-    // FIXME: This should not have to walk all bindings in the old store.
-    for (RegionBindings::iterator RI = B.begin(), RE = B.end(); RI != RE; ++RI){
-      const ClusterBindings &Cluster = RI.getData();
-      for (ClusterBindings::iterator CI = Cluster.begin(), CE = Cluster.end();
-           CI != CE; ++CI) {
-        BindingKey K = CI.getKey();
-        if (const SubRegion *BaseR = dyn_cast<SubRegion>(K.getRegion())) {
-          if (BaseR == LazyR)
-            VisitBinding(CI.getData());
-          else if (K.hasSymbolicOffset() && BaseR->isSubRegionOf(LazyR))
-            VisitBinding(CI.getData());
-        }
+    // All the bindings of LazyR and its subregions are in the cluster of its
+    // base region, so only that cluster of the old store has to be walked.
+    const ClusterBindings *Cluster = B.lookup(LazyR->getBaseRegion());
+    if (!Cluster)
+      return;
+
+    for (ClusterBindings::iterator CI = Cluster->begin(), CE = Cluster->end();
+         CI != CE; ++CI) {
+      BindingKey K = CI.getKey();
+      if (const SubRegion *BaseR = dyn_cast<SubRegion>(K.getRegion())) {
+        if (BaseR == LazyR)
+          VisitBinding(CI.getData());
+        else if (K.hasSymbolicOffset() && BaseR->isSubRegionOf(LazyR))
+          VisitBinding(CI.getData());
       }
     }
 
@@ -270,10 +270,24 @@ SymbolManager::getCastSymbol(const SymExpr *Op,
   return cast<SymbolCast>(data);
 }
 
+SymbolManager::BinarySymExprKey
+SymbolManager::getBinarySymExprKey(SymExpr::Kind K, const void *lhs,
+                                   BinaryOperator::Opcode op, const void *rhs,
+                                   QualType t) {
+  return std::make_pair(std::make_pair(lhs, rhs),
+                        std::make_pair(unsigned(K) << 8 | unsigned(op),
+                                       t.getAsOpaquePtr()));
+}
+
 const SymIntExpr *SymbolManager::getSymIntExpr(const SymExpr *lhs,
                                                BinaryOperator::Opcode op,
                                                const llvm::APSInt& v,
                                                QualType t) {
+  SymExpr *&Cached = BinarySymExprCache[
+    getBinarySymExprKey(SymExpr::SymIntKind, lhs, op, &v, t)];
+  if (Cached)
+    return cast<SymIntExpr>(Cached);
+
   llvm::FoldingSetNodeID ID;
   SymIntExpr::Profile(ID, lhs, op, v, t);
   void *InsertPos;
@@ -285,6 +299,7 @@ const SymIntExpr *SymbolManager::getSymIntExpr(const SymExpr *lhs,
     DataSet.InsertNode(data, InsertPos);
   }
 
+  Cached = data;
   return cast<SymIntExpr>(data);
 }
 
@@ -292,6 +307,11 @@ const IntSymExpr *SymbolManager::getIntSymExpr(const llvm::APSInt& lhs,
                                                BinaryOperator::Opcode op,
                                                const SymExpr *rhs,
                                                QualType t) {
+  SymExpr *&Cached = BinarySymExprCache[
+    getBinarySymExprKey(SymExpr::IntSymKind, &lhs, op, rhs, t)];
+  if (Cached)
+    return cast<IntSymExpr>(Cached);
+
   llvm::FoldingSetNodeID ID;
   IntSymExpr::Profile(ID, lhs, op, rhs, t);
   void *InsertPos;
@@ -303,6 +323,7 @@ const IntSymExpr *SymbolManager::getIntSymExpr(const llvm::APSInt& lhs,
     DataSet.InsertNode(data, InsertPos);
   }
 
+  Cached = data;
   return cast<IntSymExpr>(data);
 }
 
@@ -310,6 +331,11 @@ const SymSymExpr *SymbolManager::getSymSymExpr(const SymExpr *lhs,
                                                BinaryOperator::Opcode op,
                                                const SymExpr *rhs,
                                                QualType t) {
+  SymExpr *&Cached = BinarySymExprCache[
+    getBinarySymExprKey(SymExpr::SymSymKind, lhs, op, rhs, t)];
+  if (Cached)
+    return cast<SymSymExpr>(Cached);
+
   llvm::FoldingSetNodeID ID;
   SymSymExpr::Profile(ID, lhs, op, rhs, t);
   void *InsertPos;
@@ -321,6 +347,7 @@ const SymSymExpr *SymbolManager::getSymSymExpr(const SymExpr *lhs,
     DataSet.InsertNode(data, InsertPos);
   }
 
+  Cached = data;
   return cast<SymSymExpr>(data);
 }
 
@@ -14,6 +14,7 @@
 #define DEBUG_TYPE "AnalysisConsumer"
 
 #include "AnalysisConsumer.h"
+#include "AnalysisResultCache.h"
 #include "clang/AST/ASTConsumer.h"
 #include "clang/AST/Decl.h"
 #include "clang/AST/DeclCXX.h"
@@ -34,6 +35,7 @@
 
 #include "clang/Basic/FileManager.h"
 #include "clang/Basic/SourceManager.h"
+#include "clang/Frontend/FrontendDiagnostic.h"
 #include "clang/StaticAnalyzer/Core/AnalyzerOptions.h"
 #include "clang/Lex/Preprocessor.h"
 #include "llvm/Support/raw_ostream.h"
@@ -59,6 +61,16 @@ STATISTIC(NumBlocksInAnalyzedFunctions,
                      "The # of basic blocks in the analyzed functions.");
 STATISTIC(PercentReachableBlocks, "The % of reachable basic blocks.");
 STATISTIC(MaxCFGSize, "The maximum number of basic blocks in a function.");
+STATISTIC(NumStepsInAnalyzedFunctions,
+                     "The # of steps executed in the analyzed functions.");
+STATISTIC(ReachableBlocksPerThousandSteps,
+                     "The # of reachable basic blocks per 1000 steps.");
+STATISTIC(NumFunctionsNotChanged,
+                     "The # of functions not analyzed again because they did "
+                     "not change.");
+STATISTIC(NumDeclsLeftOutOfCallGraph,
+                     "The # of top level declarations from AST files left out "
+                     "of the call graph.");
 
 //===----------------------------------------------------------------------===//
 // Special PathDiagnosticConsumers.
@@ -110,6 +122,30 @@ public:
     }
   }
 };
+
+/// Records the diagnostics of this run in the AnalysisResultCache, and then
+/// reports the cached diagnostics of the functions that were not analyzed
+/// again.
+class ResultCachePathDiagConsumer : public PathDiagnosticConsumer {
+  AnalysisResultCache &Cache;
+  DiagnosticsEngine &Diag;
+  SourceManager &SM;
+public:
+  ResultCachePathDiagConsumer(AnalysisResultCache &Cache,
+                              DiagnosticsEngine &Diag, SourceManager &SM)
+    : Cache(Cache), Diag(Diag), SM(SM) {}
+  virtual ~ResultCachePathDiagConsumer() {}
+  virtual StringRef getName() const { return "ResultCache"; }
+  virtual PathGenerationScheme getGenerationScheme() const { return None; }
+
+  void FlushDiagnosticsImpl(std::vector<const PathDiagnostic *> &Diags,
+                            FilesMade *filesMade) {
+    for (std::vector<const PathDiagnostic*>::iterator I = Diags.begin(),
+         E = Diags.end(); I != E; ++I)
+      Cache.addDiagnostic(**I, SM);
+    Cache.reportCachedDiagnostics(Diag, SM);
+  }
+};
 } // end anonymous namespace
 
 //===----------------------------------------------------------------------===//
@@ -151,6 +187,10 @@ public:
   StoreManagerCreator CreateStoreMgr;
   ConstraintManagerCreator CreateConstraintMgr;
 
+  /// The results of the last run, if -analyzer-result-cache is given.  Must
+  /// outlive Mgr, whose PathDiagnosticConsumers refer to it.
+  OwningPtr<AnalysisResultCache> ResultCache;
+
   OwningPtr<CheckerManager> checkerMgr;
   OwningPtr<AnalysisManager> Mgr;
 
@@ -245,6 +285,12 @@ public:
 
   virtual void Initialize(ASTContext &Context) {
     Ctx = &Context;
+    if (!Opts->ResultCacheFile.empty()) {
+      ResultCache.reset(new AnalysisResultCache(*Opts));
+      PathConsumers.push_back(
+        new ResultCachePathDiagConsumer(*ResultCache, PP.getDiagnostics(),
+                                        Context.getSourceManager()));
+    }
     checkerMgr.reset(createCheckerManager(*Opts, PP.getLangOpts(), Plugins,
                                           PP.getDiagnostics()));
     Mgr.reset(new AnalysisManager(*Ctx,
@@ -317,6 +363,13 @@ private:
   /// \brief Check if we should skip (not analyze) the given function.
   bool skipFunction(Decl *D);
 
+  /// \brief Check if the given top level declaration has to be added to the
+  /// call graph, which reads the bodies of its functions.
+  bool shouldAddToCallGraph(Decl *D);
+
+  /// \brief Build the call graph of the first NumDecls top level declarations.
+  void buildCallGraph(CallGraph &CG, unsigned NumDecls);
+
 };
 } // end anonymous namespace
 
@@ -367,14 +420,7 @@ void AnalysisConsumer::HandleDeclsGallGraph(const unsigned LocalTUDeclsSize) {
   // Otherwise, use the Callgraph to derive the order.
   // Build the Call Graph.
   CallGraph CG;
-
-  // Add all the top level declarations to the graph.
-  // Note: CallGraph can trigger deserialization of more items from a pch
-  // (though HandleInterestingDecl); triggering additions to LocalTUDecls.
-  // We rely on random access to add the initially processed Decls to CG.
-  for (unsigned i = 0 ; i < LocalTUDeclsSize ; ++i) {
-    CG.addToCallGraph(LocalTUDecls[i]);
-  }
+  buildCallGraph(CG, LocalTUDeclsSize);
 
   // Find the top level nodes - children of root + the unreachable (parentless)
   // nodes.
@@ -404,6 +450,13 @@ void AnalysisConsumer::HandleDeclsGallGraph(const unsigned LocalTUDeclsSize) {
   // BFS over all of the functions, while skipping the ones inlined into
   // the previously processed functions. Use external Visited set, which is
   // also modified when we inline a function.
+  //
+  // FIXME: Roots are analyzed one at a time.  Analyzing them concurrently
+  // would change which functions are analyzed as top level, since the
+  // Visited set depends on what was inlined into the roots analyzed before.
+  // It would also race: every ExprEngine creates types in the shared
+  // ASTContext, caches CFGs in the AnalysisManager, and reports through the
+  // shared PathDiagnosticConsumers, and none of them is synchronized.
   SmallPtrSet<CallGraphNode*,24> Visited;
   while(!BFSQueue.empty()) {
     CallGraphNode *N = BFSQueue.front();
@@ -445,6 +498,14 @@ void AnalysisConsumer::HandleTranslationUnit(ASTContext &C) {
   if (Diags.hasErrorOccurred() || Diags.hasFatalErrorOccurred())
     return;
 
+  // Don't try to inline what was too expensive to inline elsewhere.
+  const std::string &SummariesFile = Opts->FunctionSummariesFile;
+  if (!SummariesFile.empty()) {
+    std::string ErrorStr;
+    if (!FunctionSummaries.readSummaries(SummariesFile, ErrorStr))
+      Diags.Report(diag::err_fe_error_opening) << SummariesFile << ErrorStr;
+  }
+
   {
     if (TUTotalTimer) TUTotalTimer->startTimer();
 
@@ -466,6 +527,20 @@ void AnalysisConsumer::HandleTranslationUnit(ASTContext &C) {
     // random access.  By doing so, we automatically compensate for iterators
     // possibly being invalidated, although this is a bit slower.
     const unsigned LocalTUDeclsSize = LocalTUDecls.size();
+
+    // Find the functions that did not change since the last run.
+    if (ResultCache) {
+      const std::string &CacheFile = Opts->ResultCacheFile;
+      std::string ErrorStr;
+      if (!ResultCache->read(CacheFile, ErrorStr))
+        Diags.Report(diag::err_fe_error_opening) << CacheFile << ErrorStr;
+
+      CallGraph CG;
+      buildCallGraph(CG, LocalTUDeclsSize);
+      ResultCache->computeCleanFunctions(CG, FunctionSummaries,
+                                         C.getSourceManager(), C.getLangOpts());
+    }
+
     for (unsigned i = 0 ; i < LocalTUDeclsSize ; ++i) {
       TraverseDecl(LocalTUDecls[i]);
     }
@@ -487,12 +562,44 @@ void AnalysisConsumer::HandleTranslationUnit(ASTContext &C) {
 
   if (TUTotalTimer) TUTotalTimer->stopTimer();
 
+  if (!SummariesFile.empty()) {
+    std::string ErrorStr;
+    if (!FunctionSummaries.writeSummaries(SummariesFile, ErrorStr))
+      Diags.Report(diag::err_fe_unable_to_open_output)
+        << SummariesFile << ErrorStr;
+  }
+
+  if (ResultCache) {
+    const std::string &CacheFile = Opts->ResultCacheFile;
+    std::string ErrorStr;
+    if (!ResultCache->write(CacheFile, ErrorStr))
+      Diags.Report(diag::err_fe_unable_to_open_output) << CacheFile << ErrorStr;
+  }
+
+  if (Opts->PrintStats)
+    checkerMgr->printCheckerProfile(llvm::errs());
+
+  const std::string &ProfileFile = Opts->CheckerProfileFile;
+  if (!ProfileFile.empty()) {
+    std::string ErrorStr;
+    llvm::raw_fd_ostream OS(ProfileFile.c_str(), ErrorStr);
+    if (ErrorStr.empty())
+      checkerMgr->printCheckerProfileJSON(OS);
+    else
+      Diags.Report(diag::err_fe_unable_to_open_output)
+        << ProfileFile << ErrorStr;
+  }
+
   // Count how many basic blocks we have not covered.
   NumBlocksInAnalyzedFunctions = FunctionSummaries.getTotalNumBasicBlocks();
   if (NumBlocksInAnalyzedFunctions > 0)
     PercentReachableBlocks =
       (FunctionSummaries.getTotalNumVisitedBasicBlocks() * 100) /
         NumBlocksInAnalyzedFunctions;
+  if (NumStepsInAnalyzedFunctions > 0)
+    ReachableBlocksPerThousandSteps =
+      (FunctionSummaries.getTotalNumVisitedBasicBlocks() * 1000) /
+        NumStepsInAnalyzedFunctions;
 
 }
 
@@ -518,6 +625,33 @@ static std::string getFunctionName(const Decl *D) {
   return "";
 }
 
+bool AnalysisConsumer::shouldAddToCallGraph(Decl *D) {
+  // Declarations parsed in this translation unit are cheap to walk.
+  if (!D->isFromASTFile() || Opts->AnalyzeAll)
+    return true;
+
+  // A declaration from a PCH or module only reaches LocalTUDecls because the
+  // AST reader passed it on as interesting.  Unless it is in the main file
+  // (e.g. in a precompiled preamble) it is never analyzed as top level, so
+  // don't deserialize its bodies just to find its callees.  Calls to it from
+  // the main file still add it to the graph as a callee, and the inliner
+  // reads its body if it is inlined.
+  SourceManager &SM = Ctx->getSourceManager();
+  return SM.isFromMainFile(SM.getExpansionLoc(D->getLocation()));
+}
+
+void AnalysisConsumer::buildCallGraph(CallGraph &CG, unsigned NumDecls) {
+  // Note: CallGraph can trigger deserialization of more items from a pch
+  // (though HandleInterestingDecl); triggering additions to LocalTUDecls.
+  // We rely on random access to add the initially processed Decls to CG.
+  for (unsigned i = 0 ; i < NumDecls ; ++i) {
+    if (shouldAddToCallGraph(LocalTUDecls[i]))
+      CG.addToCallGraph(LocalTUDecls[i]);
+    else
+      ++NumDeclsLeftOutOfCallGraph;
+  }
+}
+
 bool AnalysisConsumer::skipFunction(Decl *D) {
   if (!Opts->AnalyzeSpecificFunction.empty() &&
       getFunctionName(D) != Opts->AnalyzeSpecificFunction)
@@ -538,6 +672,13 @@ void AnalysisConsumer::HandleCode(Decl *D, AnalysisMode Mode,
   if (skipFunction(D))
     return;
 
+  // The cached diagnostics of the function are reported instead.
+  if (ResultCache && ResultCache->isClean(D)) {
+    if (Mode != ANALYSIS_SYNTAX)
+      NumFunctionsNotChanged++;
+    return;
+  }
+
   DisplayFunction(D, Mode);
   CFG *DeclCFG = Mgr->getCFG(D);
   if (DeclCFG) {
@@ -546,8 +687,9 @@ void AnalysisConsumer::HandleCode(Decl *D, AnalysisMode Mode,
   }
 
 
-  // Clear the AnalysisManager of old AnalysisDeclContexts.
-  Mgr->ClearContexts();
+  // Clear the AnalysisManager of old AnalysisDeclContexts, keeping the CFG of
+  // this function and of the callees likely to be inlined again.
+  Mgr->ReleaseContexts();
 
   // Dispatch on the actions.
   SmallVector<Decl*, 10> WL;
@@ -596,6 +738,19 @@ void AnalysisConsumer::ActionExprEngine(Decl *D, bool ObjCGCEnabled,
   // Execute the worklist algorithm.
   Eng.ExecuteWorkList(Mgr->getAnalysisDeclContextManager().getStackFrame(D),
                       Mgr->options.MaxNodes);
+  NumStepsInAnalyzedFunctions += Eng.getCoreEngine().getNumStepsExecuted();
+
+  if (Eng.getCoreEngine().hasExceededTimeBudget()) {
+    DiagnosticsEngine &Diags = PP.getDiagnostics();
+    DiagnosticBuilder DB =
+      Diags.Report(D->getLocation(),
+                   diag::remark_analyzer_time_budget_exceeded);
+    if (const NamedDecl *ND = dyn_cast<NamedDecl>(D))
+      DB << ND;
+    else
+      DB << "block";
+    DB << Mgr->options.getTimeBudget();
+  }
 
   // Release the auditor (if any) so that it doesn't monitor the graph
   // created BugReporter.
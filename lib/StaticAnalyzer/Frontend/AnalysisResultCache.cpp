@@ -0,0 +1,337 @@
+//===--- AnalysisResultCache.cpp - Results of previous analyzer runs ------===//
+//
+//                     The LLVM Compiler Infrastructure
+//
+// This file is distributed under the University of Illinois Open Source
+// License. See LICENSE.TXT for details.
+//
+//===----------------------------------------------------------------------===//
+//
+// This file implements AnalysisResultCache.
+//
+//===----------------------------------------------------------------------===//
+
+#include "AnalysisResultCache.h"
+#include "clang/AST/Decl.h"
+#include "clang/AST/DeclObjC.h"
+#include "clang/Analysis/CallGraph.h"
+#include "clang/Basic/Diagnostic.h"
+#include "clang/Basic/MD5.h"
+#include "clang/Basic/SourceManager.h"
+#include "clang/Basic/Version.h"
+#include "clang/Lex/Lexer.h"
+#include "clang/StaticAnalyzer/Core/AnalyzerOptions.h"
+#include "clang/StaticAnalyzer/Core/BugReporter/PathDiagnostic.h"
+#include "clang/StaticAnalyzer/Core/PathSensitive/FunctionSummary.h"
+#include "llvm/ADT/SmallString.h"
+#include "llvm/ADT/StringExtras.h"
+#include "llvm/Support/MemoryBuffer.h"
+#include "llvm/Support/raw_ostream.h"
+#include "llvm/Support/system_error.h"
+#include <algorithm>
+
+using namespace clang;
+using namespace ento;
+
+//===----------------------------------------------------------------------===//
+// Reading and writing.
+//===----------------------------------------------------------------------===//
+
+// The file starts with "V<tab>hash", the digest of the analyzer options and
+// the clang version it was written with.  Then it holds one line per function,
+// "F<tab>hash<tab>name", followed by one line per diagnostic reported in it,
+// "D<tab>line<tab>column<tab>message", with the position relative to the start
+// of the function.
+
+/// Returns \p Str with the characters that separate the fields of the file
+/// replaced.
+static std::string getField(StringRef Str) {
+  std::string Result = Str;
+  for (std::string::iterator I = Result.begin(), E = Result.end(); I != E; ++I)
+    if (*I == '\t' || *I == '\n' || *I == '\r')
+      *I = ' ';
+  return Result;
+}
+
+/// Returns the size and the MD5 digest of \p Data.
+static std::string getDigest(StringRef Data) {
+  uint32_t Digest[4];
+  MD5::hash(Data, Digest);
+  std::string Hash = llvm::utohexstr(Data.size());
+  for (unsigned I = 0; I != 4; ++I)
+    Hash += "-" + llvm::utohexstr(Digest[I]);
+  return Hash;
+}
+
+/// Returns a digest of the options that affect what the analyzer reports, and
+/// of the clang version.
+static std::string getConfigHash(const AnalyzerOptions &Opts) {
+  std::string Config;
+  llvm::raw_string_ostream OS(Config);
+  OS << getClangFullRepositoryVersion() << '\n';
+
+  for (unsigned I = 0, E = Opts.CheckersControlList.size(); I != E; ++I)
+    OS << (Opts.CheckersControlList[I].second ? '+' : '-')
+       << Opts.CheckersControlList[I].first << '\n';
+
+  // The table is not ordered.
+  std::vector<std::string> Entries;
+  for (AnalyzerOptions::ConfigTable::const_iterator I = Opts.Config.begin(),
+       E = Opts.Config.end(); I != E; ++I)
+    Entries.push_back(I->getKey().str() + "=" + I->getValue());
+  std::sort(Entries.begin(), Entries.end());
+  for (unsigned I = 0, E = Entries.size(); I != E; ++I)
+    OS << Entries[I] << '\n';
+
+  OS << Opts.AnalysisStoreOpt << ' ' << Opts.AnalysisConstraintsOpt << ' '
+     << Opts.AnalysisPurgeOpt << ' ' << Opts.IPAMode << ' '
+     << Opts.InliningMode << ' ' << Opts.MaxNodes << ' '
+     << Opts.maxBlockVisitOnPath << ' ' << Opts.InlineMaxStackDepth << ' '
+     << Opts.InlineMaxFunctionSize << ' ' << Opts.AnalyzeNestedBlocks << ' '
+     << Opts.eagerlyAssumeBinOpBifurcation << ' ' << Opts.UnoptimizedCFG
+     << ' ' << Opts.NoRetryExhausted << '\n';
+  return getDigest(OS.str());
+}
+
+AnalysisResultCache::AnalysisResultCache(const AnalyzerOptions &Opts)
+  : ConfigHash(getConfigHash(Opts)) {}
+
+bool AnalysisResultCache::read(StringRef Path, std::string &ErrorStr) {
+  OwningPtr<llvm::MemoryBuffer> Buffer;
+  if (llvm::error_code EC = llvm::MemoryBuffer::getFile(Path, Buffer)) {
+    if (EC == llvm::errc::no_such_file_or_directory)
+      return true;
+    ErrorStr = EC.message();
+    return false;
+  }
+
+  // A cache written with other options would report stale diagnostics.
+  StringRef Header, Rest;
+  llvm::tie(Header, Rest) = Buffer->getBuffer().split('\n');
+  if (Header != "V\t" + ConfigHash)
+    return true;
+
+  FunctionEntry *Entry = 0;
+  while (!Rest.empty()) {
+    StringRef Line;
+    llvm::tie(Line, Rest) = Rest.split('\n');
+
+    SmallVector<StringRef, 4> Fields;
+    Line.split(Fields, "\t");
+    if (Fields.size() == 3 && Fields[0] == "F") {
+      Entry = &Previous[Fields[2]];
+      Entry->Hash = Fields[1];
+      Entry->Diagnostics.clear();
+      continue;
+    }
+
+    CachedDiagnostic Diag;
+    if (Entry && Fields.size() == 4 && Fields[0] == "D" &&
+        !Fields[1].getAsInteger(10, Diag.Line) &&
+        !Fields[2].getAsInteger(10, Diag.Column)) {
+      Diag.Message = Fields[3];
+      Entry->Diagnostics.push_back(Diag);
+      continue;
+    }
+
+    // Ignore whatever we do not understand; the functions it belongs to are
+    // then analyzed again.
+    if (!Line.empty())
+      Entry = 0;
+  }
+  return true;
+}
+
+bool AnalysisResultCache::write(StringRef Path, std::string &ErrorStr) const {
+  llvm::raw_fd_ostream Out(Path.str().c_str(), ErrorStr);
+  if (!ErrorStr.empty())
+    return false;
+
+  Out << "V\t" << ConfigHash << '\n';
+  for (llvm::StringMap<FunctionEntry>::const_iterator I = Current.begin(),
+       E = Current.end(); I != E; ++I) {
+    Out << "F\t" << I->second.Hash << '\t' << getField(I->getKey()) << '\n';
+
+    const std::vector<CachedDiagnostic> &Diags = I->second.Diagnostics;
+    for (unsigned DI = 0, DE = Diags.size(); DI != DE; ++DI) {
+      Out << "D\t" << Diags[DI].Line << '\t' << Diags[DI].Column << '\t'
+          << Diags[DI].Message << '\n';
+    }
+  }
+  return true;
+}
+
+//===----------------------------------------------------------------------===//
+// Finding the clean functions.
+//===----------------------------------------------------------------------===//
+
+/// Returns a hash of the text of \p D, or the empty string if it cannot be
+/// computed.
+static std::string getTextHash(const Decl *D, const SourceManager &SM,
+                               const LangOptions &LangOpts) {
+  SourceLocation Begin = SM.getExpansionLoc(D->getLocStart());
+  SourceLocation End = SM.getExpansionLoc(D->getLocEnd());
+  if (Begin.isInvalid() || End.isInvalid() ||
+      SM.getFileID(Begin) != SM.getFileID(End))
+    return std::string();
+
+  bool Invalid = false;
+  const char *BeginPtr = SM.getCharacterData(Begin, &Invalid);
+  if (Invalid)
+    return std::string();
+  const char *EndPtr = SM.getCharacterData(End, &Invalid);
+  if (Invalid || EndPtr < BeginPtr)
+    return std::string();
+  EndPtr += Lexer::MeasureTokenLength(End, SM, LangOpts);
+
+  return getDigest(StringRef(BeginPtr, EndPtr - BeginPtr));
+}
+
+void AnalysisResultCache::computeCleanFunctions(const CallGraph &CG,
+                                                FunctionSummariesTy &FS,
+                                                const SourceManager &SM,
+                                                const LangOptions &LangOpts) {
+  // Name and hash all the functions, and find the ones that changed.
+  SmallVector<const CallGraphNode *, 16> Changed;
+  llvm::DenseMap<const CallGraphNode *,
+                 SmallVector<const CallGraphNode *, 4> > Callers;
+  for (CallGraph::const_iterator I = CG.begin(), E = CG.end(); I != E; ++I) {
+    const CallGraphNode *N = I->second;
+    const Decl *D = N->getDecl();
+    if (!D)
+      continue;
+
+    for (CallGraphNode::const_iterator CI = N->begin(), CE = N->end();
+         CI != CE; ++CI)
+      Callers[*CI].push_back(N);
+
+    SmallString<128> Name;
+    if (!FS.getSummaryName(D, Name)) {
+      const NamedDecl *ND = dyn_cast<NamedDecl>(D);
+      if (!ND)
+        continue;
+      Name = "static ";
+      Name += ND->getQualifiedNameAsString();
+    }
+
+    std::string Hash = getTextHash(D, SM, LangOpts);
+    Names[D] = Name.str();
+    FunctionEntry &Entry = Current[Name];
+    // If two functions share a name, analyze both again every time.
+    if (!Entry.Hash.empty())
+      Hash.clear();
+    Entry.Hash = Hash;
+
+    llvm::StringMap<FunctionEntry>::const_iterator PI = Previous.find(Name);
+    if (Hash.empty() || PI == Previous.end() || PI->second.Hash != Hash)
+      Changed.push_back(N);
+    else
+      CleanFunctions.insert(D);
+  }
+
+  // The callers of changed functions may inline them, so they are not clean
+  // either.
+  while (!Changed.empty()) {
+    const CallGraphNode *N = Changed.pop_back_val();
+    CleanFunctions.erase(N->getDecl());
+    const SmallVector<const CallGraphNode *, 4> &NCallers = Callers[N];
+    for (unsigned I = 0, E = NCallers.size(); I != E; ++I)
+      if (CleanFunctions.count(NCallers[I]->getDecl()))
+        Changed.push_back(NCallers[I]);
+  }
+}
+
+//===----------------------------------------------------------------------===//
+// Diagnostics.
+//===----------------------------------------------------------------------===//
+
+const Decl *AnalysisResultCache::getCachedFunction(const Decl *D) const {
+  // Diagnostics in blocks belong to the enclosing function.
+  while (D) {
+    if (Names.count(D))
+      return D;
+    const DeclContext *DC = D->getDeclContext();
+    D = DC ? Decl::castFromDeclContext(DC) : 0;
+  }
+  return 0;
+}
+
+void AnalysisResultCache::addDiagnostic(const PathDiagnostic &PD,
+                                        const SourceManager &SM) {
+  const Decl *D = getCachedFunction(PD.getDeclWithIssue());
+  if (!D)
+    return;
+  FunctionEntry &Entry = Current[Names.find(D)->second];
+
+  // A diagnostic outside of the text of the function, e.g. in an inlined
+  // callee, cannot be placed relative to it; analyze the function again in
+  // the next run instead.
+  SourceLocation Begin = SM.getExpansionLoc(D->getLocStart());
+  SourceLocation End = SM.getExpansionLoc(D->getLocEnd());
+  SourceLocation Loc = SM.getExpansionLoc(PD.getLocation().asLocation());
+  if (Begin.isInvalid() || End.isInvalid() || Loc.isInvalid() ||
+      SM.getFileID(Loc) != SM.getFileID(Begin) ||
+      SM.getFileID(End) != SM.getFileID(Begin) || Loc < Begin || End < Loc) {
+    Entry.Hash.clear();
+    return;
+  }
+
+  // Store the fields like they are read back, so that the diagnostic can be
+  // matched with its cached copy.
+  CachedDiagnostic Diag;
+  Diag.Line = SM.getExpansionLineNumber(Loc) -
+              SM.getExpansionLineNumber(Begin);
+  Diag.Column = SM.getExpansionColumnNumber(Loc);
+  if (Diag.Line == 0)
+    Diag.Column -= SM.getExpansionColumnNumber(Begin);
+  Diag.Message = getField(PD.getShortDescription());
+  Entry.Diagnostics.push_back(Diag);
+}
+
+void AnalysisResultCache::reportCachedDiagnostics(DiagnosticsEngine &Diags,
+                                                  SourceManager &SM) {
+  // Report in a deterministic order.
+  std::vector<std::pair<StringRef, const Decl *> > CleanNames;
+  for (llvm::DenseSet<const Decl *>::const_iterator I = CleanFunctions.begin(),
+       E = CleanFunctions.end(); I != E; ++I)
+    CleanNames.push_back(std::make_pair(StringRef(Names[*I]), *I));
+  std::sort(CleanNames.begin(), CleanNames.end());
+
+  for (unsigned I = 0, E = CleanNames.size(); I != E; ++I) {
+    StringRef Name = CleanNames[I].first;
+    std::vector<CachedDiagnostic> &Reported = Current[Name].Diagnostics;
+    const std::vector<CachedDiagnostic> &Cached = Previous[Name].Diagnostics;
+
+    // Re-base the cached positions on where the function is now.
+    SourceLocation Begin =
+      SM.getExpansionLoc(CleanNames[I].second->getLocStart());
+    if (Begin.isInvalid())
+      continue;
+    FileID FID = SM.getFileID(Begin);
+    unsigned BeginLine = SM.getExpansionLineNumber(Begin);
+    unsigned BeginColumn = SM.getExpansionColumnNumber(Begin);
+
+    for (unsigned CI = 0, CE = Cached.size(); CI != CE; ++CI) {
+      const CachedDiagnostic &Diag = Cached[CI];
+      if (std::find(Reported.begin(), Reported.end(), Diag) != Reported.end())
+        continue;
+      Reported.push_back(Diag);
+
+      unsigned Column = Diag.Line ? Diag.Column : BeginColumn + Diag.Column;
+      SourceLocation Loc = SM.translateLineCol(FID, BeginLine + Diag.Line,
+                                               Column);
+      if (Loc.isInvalid())
+        continue;
+
+      SmallString<128> Message;
+      for (std::string::const_iterator MI = Diag.Message.begin(),
+           ME = Diag.Message.end(); MI != ME; ++MI) {
+        if (*MI == '%')
+          Message += '%';
+        Message += *MI;
+      }
+      Diags.Report(Loc, Diags.getCustomDiagID(DiagnosticsEngine::Warning,
+                                              Message));
+    }
+  }
+}
@@ -0,0 +1,121 @@
+//===--- AnalysisResultCache.h - Previous analyzer results ------*- C++ -*-===//
+//
+//                     The LLVM Compiler Infrastructure
+//
+// This file is distributed under the University of Illinois Open Source
+// License. See LICENSE.TXT for details.
+//
+//===----------------------------------------------------------------------===//
+//
+// This file defines AnalysisResultCache, which lets the analyzer skip the
+// functions of a translation unit that did not change since the last run.
+//
+//===----------------------------------------------------------------------===//
+
+#ifndef LLVM_CLANG_GR_ANALYSISRESULTCACHE_H
+#define LLVM_CLANG_GR_ANALYSISRESULTCACHE_H
+
+#include "clang/Basic/LLVM.h"
+#include "llvm/ADT/DenseMap.h"
+#include "llvm/ADT/DenseSet.h"
+#include "llvm/ADT/StringMap.h"
+#include <string>
+#include <vector>
+
+namespace clang {
+
+class CallGraph;
+class Decl;
+class DiagnosticsEngine;
+class LangOptions;
+class SourceManager;
+
+namespace ento {
+class AnalyzerOptions;
+class FunctionSummariesTy;
+class PathDiagnostic;
+
+/// AnalysisResultCache - The hashes of the function bodies of a translation
+/// unit and the diagnostics reported in each function, kept between runs of
+/// the analyzer.
+///
+/// A function is clean if its text did not change and it does not call a
+/// function that did, directly or transitively.  Clean functions are not
+/// analyzed again; their cached diagnostics are reported instead.  Changes
+/// outside of function bodies, e.g. to types or macros, are not detected.
+/// The whole cache is discarded when the analyzer options or the clang
+/// version differ from those of the last run.
+class AnalysisResultCache {
+  /// CachedDiagnostic - A diagnostic reported in the text of a function.  Its
+  /// position is kept relative to the start of the function, so that it
+  /// follows the function when code above it is added or removed: Line counts
+  /// from the function's first line, and Column counts from the function's
+  /// first column on that line and from the start of the line on the others.
+  struct CachedDiagnostic {
+    unsigned Line, Column;
+    std::string Message;
+
+    bool operator==(const CachedDiagnostic &RHS) const {
+      return Line == RHS.Line && Column == RHS.Column &&
+             Message == RHS.Message;
+    }
+  };
+
+  struct FunctionEntry {
+    std::string Hash;
+    std::vector<CachedDiagnostic> Diagnostics;
+  };
+
+  /// Previous - The functions of the last run, by name.
+  llvm::StringMap<FunctionEntry> Previous;
+
+  /// Current - The functions of this run, by name.
+  llvm::StringMap<FunctionEntry> Current;
+
+  /// Names - The names of the functions of this run.
+  llvm::DenseMap<const Decl *, std::string> Names;
+
+  llvm::DenseSet<const Decl *> CleanFunctions;
+
+  /// ConfigHash - A digest of the analyzer options and the clang version of
+  /// this run.
+  std::string ConfigHash;
+
+  /// getCachedFunction - Returns the function of the call graph \p D belongs
+  /// to, or null if there is none.
+  const Decl *getCachedFunction(const Decl *D) const;
+
+public:
+  explicit AnalysisResultCache(const AnalyzerOptions &Opts);
+
+  /// read - Load the results of the last run from \p Path.  A missing file,
+  /// or one written with other analyzer options or by another version of
+  /// clang, is an empty cache.
+  bool read(StringRef Path, std::string &ErrorStr);
+
+  /// write - Save the results of this run to \p Path.
+  bool write(StringRef Path, std::string &ErrorStr) const;
+
+  /// computeCleanFunctions - Hash the functions of \p CG and find the ones
+  /// that do not have to be analyzed again.
+  void computeCleanFunctions(const CallGraph &CG, FunctionSummariesTy &FS,
+                             const SourceManager &SM,
+                             const LangOptions &LangOpts);
+
+  bool isClean(const Decl *D) const { return CleanFunctions.count(D); }
+
+  unsigned getNumCleanFunctions() const { return CleanFunctions.size(); }
+
+  /// addDiagnostic - Record a diagnostic reported in this run.
+  void addDiagnostic(const PathDiagnostic &PD, const SourceManager &SM);
+
+  /// reportCachedDiagnostics - Report the cached diagnostics of the clean
+  /// functions that were not reported again in this run.
+  void reportCachedDiagnostics(DiagnosticsEngine &Diags, SourceManager &SM);
+};
+
+} // end GR namespace
+
+} // end clang namespace
+
+#endif
@@ -14,6 +14,7 @@ clang_static_analyzer_frontend_TBLGEN_TABLES := \
 
 clang_static_analyzer_frontend_SRC_FILES := \
   AnalysisConsumer.cpp \
+  AnalysisResultCache.cpp \
   CheckerRegistration.cpp \
   FrontendActions.cpp
 
@@ -105,6 +105,8 @@ CheckerManager *ento::createCheckerManager(const AnalyzerOptions &opts,
                                            ArrayRef<std::string> plugins,
                                            DiagnosticsEngine &diags) {
   OwningPtr<CheckerManager> checkerMgr(new CheckerManager(langOpts));
+  if (opts.PrintStats || !opts.CheckerProfileFile.empty())
+    checkerMgr->enableCheckerProfiling();
 
   SmallVector<CheckerOptInfo, 8> checkerOpts;
   for (unsigned i = 0, e = opts.CheckersControlList.size(); i != e; ++i) {
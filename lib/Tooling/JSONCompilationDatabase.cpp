@@ -13,12 +13,18 @@
 
 #include "clang/Tooling/JSONCompilationDatabase.h"
 
+#include "clang/Basic/ConvertUTF.h"
+#include "clang/Basic/ProfilingSupport.h"
 #include "clang/Tooling/CompilationDatabase.h"
 #include "clang/Tooling/CompilationDatabasePluginRegistry.h"
 #include "clang/Tooling/Tooling.h"
 #include "llvm/ADT/SmallString.h"
 #include "llvm/Support/Path.h"
+#include "llvm/Support/SourceMgr.h"
+#include "llvm/Support/YAMLParser.h"
+#include "llvm/Support/raw_ostream.h"
 #include "llvm/Support/system_error.h"
+#include <algorithm>
 
 namespace clang {
 namespace tooling {
@@ -107,6 +113,133 @@ std::vector<std::string> unescapeCommandLine(
   return parser.parse();
 }
 
+/// \brief A scanner for the JSON subset compilation databases are written in.
+///
+/// Only validates the input as far as needed to find the string literals of
+/// the database; the literals themselves are not decoded.
+class JSONDatabaseScanner {
+ public:
+  JSONDatabaseScanner(StringRef Input)
+      : Position(Input.begin()), End(Input.end()) {}
+
+  /// \brief Skips whitespace and consumes C if it comes next.
+  bool consume(char C) {
+    skipWhitespace();
+    if (Position == End || *Position != C)
+      return false;
+    ++Position;
+    return true;
+  }
+
+  /// \brief Skips whitespace and consumes a string literal, quotes included.
+  ///
+  /// Fails for control characters, invalid escapes and escaped surrogates,
+  /// so that unescapeJSONString() can decode every literal this accepts.
+  bool scanString(StringRef &Literal) {
+    skipWhitespace();
+    if (Position == End || *Position != '"')
+      return false;
+    const char *Start = Position++;
+    while (Position != End) {
+      unsigned char C = *Position++;
+      if (C == '"') {
+        Literal = StringRef(Start, Position - Start);
+        return true;
+      }
+      if (C < 0x20)
+        return false;
+      if (C != '\\')
+        continue;
+      if (Position == End)
+        return false;
+      switch (*Position++) {
+      case '"': case '\\': case '/':
+      case 'b': case 'f': case 'n': case 'r': case 't':
+        break;
+      case 'u': {
+        unsigned CodePoint;
+        if (End - Position < 4 ||
+            StringRef(Position, 4).getAsInteger(16, CodePoint) ||
+            (CodePoint >= 0xD800 && CodePoint <= 0xDFFF))
+          return false;
+        Position += 4;
+        break;
+      }
+      default:
+        return false;
+      }
+    }
+    return false;
+  }
+
+  /// \brief Returns whether only whitespace is left.
+  bool atEnd() {
+    skipWhitespace();
+    return Position == End;
+  }
+
+ private:
+  void skipWhitespace() {
+    while (Position != End && (*Position == ' ' || *Position == '\t' ||
+                               *Position == '\n' || *Position == '\r'))
+      ++Position;
+  }
+
+  const char *Position;
+  const char *End;
+};
+
+/// \brief Decodes a string literal accepted by JSONDatabaseScanner.
+///
+/// Returns the value, which points either into the literal or into Storage.
+StringRef unescapeJSONString(StringRef Literal,
+                             SmallVectorImpl<char> &Storage) {
+  StringRef Value = Literal.substr(1, Literal.size() - 2);
+  if (Value.find('\\') == StringRef::npos)
+    return Value;
+  Storage.clear();
+  for (const char *I = Value.begin(), *E = Value.end(); I != E; ++I) {
+    if (*I != '\\') {
+      Storage.push_back(*I);
+      continue;
+    }
+    switch (*++I) {
+    case 'b': Storage.push_back('\b'); break;
+    case 'f': Storage.push_back('\f'); break;
+    case 'n': Storage.push_back('\n'); break;
+    case 'r': Storage.push_back('\r'); break;
+    case 't': Storage.push_back('\t'); break;
+    case 'u': {
+      unsigned CodePoint;
+      StringRef(I + 1, 4).getAsInteger(16, CodePoint);
+      char UTF8[UNI_MAX_UTF8_BYTES_PER_CODE_POINT];
+      char *UTF8End = UTF8;
+      ConvertCodePointToUTF8(CodePoint, UTF8End);
+      Storage.append(UTF8, UTF8End);
+      I += 4;
+      break;
+    }
+    default:
+      // '"', '\\' and '/' stand for themselves.
+      Storage.push_back(*I);
+      break;
+    }
+  }
+  return StringRef(Storage.begin(), Storage.size());
+}
+
+/// \brief Returns Value as a JSON string literal allocated in Allocator.
+StringRef escapeJSONString(StringRef Value,
+                           llvm::BumpPtrAllocator &Allocator) {
+  llvm::SmallString<128> Literal;
+  llvm::raw_svector_ostream OS(Literal);
+  printJSONString(OS, Value);
+  OS.flush();
+  char *Mem = Allocator.Allocate<char>(Literal.size());
+  std::copy(Literal.begin(), Literal.end(), Mem);
+  return StringRef(Mem, Literal.size());
+}
+
 } // end namespace
 
 class JSONCompilationDatabasePlugin : public CompilationDatabasePlugin {
@@ -174,9 +307,9 @@ JSONCompilationDatabase::getCompileCommands(StringRef FilePath) const {
     llvm::SmallString<8> DirectoryStorage;
     llvm::SmallString<1024> CommandStorage;
     Commands.push_back(CompileCommand(
-      // FIXME: Escape correctly:
-      CommandsRef[I].first->getValue(DirectoryStorage),
-      unescapeCommandLine(CommandsRef[I].second->getValue(CommandStorage))));
+      unescapeJSONString(CommandsRef[I].first, DirectoryStorage),
+      unescapeCommandLine(
+        unescapeJSONString(CommandsRef[I].second, CommandStorage))));
   }
   return Commands;
 }
@@ -197,6 +330,52 @@ JSONCompilationDatabase::getAllFiles() const {
 }
 
 bool JSONCompilationDatabase::parse(std::string &ErrorMessage) {
+  if (scanJSON())
+    return true;
+  IndexByFile.clear();
+  return parseYAML(ErrorMessage);
+}
+
+bool JSONCompilationDatabase::scanJSON() {
+  JSONDatabaseScanner Scanner(Database->getBuffer());
+  if (!Scanner.consume('['))
+    return false;
+  if (Scanner.consume(']'))
+    return Scanner.atEnd();
+  do {
+    if (!Scanner.consume('{'))
+      return false;
+    StringRef Directory, Command, File;
+    do {
+      StringRef Key, Value;
+      if (!Scanner.scanString(Key) || !Scanner.consume(':') ||
+          !Scanner.scanString(Value))
+        return false;
+      if (Key == "\"directory\"")
+        Directory = Value;
+      else if (Key == "\"command\"")
+        Command = Value;
+      else if (Key == "\"file\"")
+        File = Value;
+      else
+        return false;
+    } while (Scanner.consume(','));
+    if (!Scanner.consume('}') ||
+        Directory.empty() || Command.empty() || File.empty())
+      return false;
+    llvm::SmallString<8> FileStorage;
+    llvm::SmallString<128> NativeFilePath;
+    llvm::sys::path::native(unescapeJSONString(File, FileStorage),
+                            NativeFilePath);
+    IndexByFile[NativeFilePath].push_back(
+      CompileCommandRef(Directory, Command));
+  } while (Scanner.consume(','));
+  return Scanner.consume(']') && Scanner.atEnd();
+}
+
+bool JSONCompilationDatabase::parseYAML(std::string &ErrorMessage) {
+  llvm::SourceMgr SM;
+  llvm::yaml::Stream YAMLStream(Database->getBuffer(), SM);
   llvm::yaml::document_iterator I = YAMLStream.begin();
   if (I == YAMLStream.end()) {
     ErrorMessage = "Error while parsing YAML.";
@@ -246,11 +425,12 @@ bool JSONCompilationDatabase::parse(std::string &ErrorMessage) {
         return false;
       }
       llvm::SmallString<8> KeyStorage;
-      if (KeyString->getValue(KeyStorage) == "directory") {
+      StringRef Key = KeyString->getValue(KeyStorage);
+      if (Key == "directory") {
         Directory = ValueString;
-      } else if (KeyString->getValue(KeyStorage) == "command") {
+      } else if (Key == "command") {
         Command = ValueString;
-      } else if (KeyString->getValue(KeyStorage) == "file") {
+      } else if (Key == "file") {
         File = ValueString;
       } else {
         ErrorMessage = ("Unknown key: \"" +
@@ -273,8 +453,11 @@ bool JSONCompilationDatabase::parse(std::string &ErrorMessage) {
     llvm::SmallString<8> FileStorage;
     llvm::SmallString<128> NativeFilePath;
     llvm::sys::path::native(File->getValue(FileStorage), NativeFilePath);
-    IndexByFile[NativeFilePath].push_back(
-      CompileCommandRef(Directory, Command));
+    llvm::SmallString<8> DirectoryStorage;
+    llvm::SmallString<1024> CommandStorage;
+    IndexByFile[NativeFilePath].push_back(CompileCommandRef(
+      escapeJSONString(Directory->getValue(DirectoryStorage), Strings),
+      escapeJSONString(Command->getValue(CommandStorage), Strings)));
   }
   return true;
 }
@@ -0,0 +1,126 @@
+//===--- ParallelTraversal.cpp - Traversing a TU on several threads -------===//
+//
+//                     The LLVM Compiler Infrastructure
+//
+// This file is distributed under the University of Illinois Open Source
+// License. See LICENSE.TXT for details.
+//
+//===----------------------------------------------------------------------===//
+//
+//  This file implements helpers which split the traversal of a translation
+//  unit among several threads.
+//
+//===----------------------------------------------------------------------===//
+
+#include "clang/Tooling/ParallelTraversal.h"
+#include "clang/AST/ASTContext.h"
+#include "clang/AST/Decl.h"
+#include "clang/Basic/Parallel.h"
+#include "clang/Basic/SourceManager.h"
+#include <algorithm>
+#include <vector>
+
+namespace clang {
+namespace tooling {
+
+namespace {
+/// \brief The state shared by the workers of forEachTopLevelDeclInParallel.
+struct ParallelDeclRun {
+  bool (*Fn)(void *UserData, unsigned Partition, Decl *D);
+  void *UserData;
+  std::vector<Decl *> Decls;
+  /// \brief Partition I covers [PartitionBegins[I], PartitionBegins[I + 1]).
+  std::vector<unsigned> PartitionBegins;
+  std::vector<char> Succeeded;
+};
+}
+
+static void runDeclPartition(void *UserData, unsigned Partition) {
+  ParallelDeclRun &Run = *static_cast<ParallelDeclRun *>(UserData);
+  for (unsigned I = Run.PartitionBegins[Partition],
+                E = Run.PartitionBegins[Partition + 1];
+       I != E; ++I) {
+    if (!Run.Fn(Run.UserData, Partition, Run.Decls[I])) {
+      Run.Succeeded[Partition] = false;
+      return;
+    }
+  }
+}
+
+/// \brief Returns the number of characters \p D spans, or 1 if it does not
+/// span a range of a single file.
+static unsigned getSourceSize(const SourceManager &SM, const Decl *D) {
+  SourceRange Range = D->getSourceRange();
+  if (Range.isInvalid())
+    return 1;
+  SourceLocation Begin = SM.getExpansionLoc(Range.getBegin());
+  SourceLocation End = SM.getExpansionLoc(Range.getEnd());
+  if (SM.getFileID(Begin) != SM.getFileID(End))
+    return 1;
+  unsigned BeginOffset = SM.getFileOffset(Begin);
+  unsigned EndOffset = SM.getFileOffset(End);
+  return EndOffset > BeginOffset ? EndOffset - BeginOffset : 1;
+}
+
+// Ensure worker threads have the same amount of stack as libclang's safety
+// threads, since traversals are deeply recursive.
+static const unsigned ParallelTraversalStackSize = 8 << 20;
+
+bool forEachTopLevelDeclInParallel(ASTContext &Context, unsigned NumPartitions,
+                                   bool (*Fn)(void *UserData,
+                                              unsigned Partition, Decl *D),
+                                   void *UserData) {
+  assert(NumPartitions != 0 && "No partitions");
+  ParallelDeclRun Run;
+  Run.Fn = Fn;
+  Run.UserData = UserData;
+
+  // Collect the declarations and their sizes on this thread, which also
+  // loads the declarations of an external source.
+  const SourceManager &SM = Context.getSourceManager();
+  TranslationUnitDecl *TU = Context.getTranslationUnitDecl();
+  std::vector<unsigned> Sizes;
+  uint64_t TotalSize = 0;
+  for (DeclContext::decl_iterator I = TU->decls_begin(), E = TU->decls_end();
+       I != E; ++I) {
+    Run.Decls.push_back(*I);
+    Sizes.push_back(getSourceSize(SM, *I));
+    TotalSize += Sizes.back();
+  }
+
+  // Start a new partition whenever the declarations before it reach its share
+  // of the total size.
+  Run.PartitionBegins.push_back(0);
+  uint64_t Size = 0;
+  for (unsigned I = 0, E = Run.Decls.size();
+       I != E && Run.PartitionBegins.size() != NumPartitions; ++I) {
+    Size += Sizes[I];
+    while (Run.PartitionBegins.size() != NumPartitions &&
+           Size * NumPartitions >= TotalSize * Run.PartitionBegins.size())
+      Run.PartitionBegins.push_back(I + 1);
+  }
+  while (Run.PartitionBegins.size() != NumPartitions)
+    Run.PartitionBegins.push_back(Run.Decls.size());
+  Run.PartitionBegins.push_back(Run.Decls.size());
+  Run.Succeeded.assign(NumPartitions, true);
+
+  // An external source is not safe for concurrent use. Otherwise use no more
+  // threads than the hardware has; the partitions are handed out to them.
+  unsigned NumThreads = 1;
+  if (!Context.getExternalSource())
+    NumThreads = std::min(NumPartitions, getNumberOfHardwareThreads());
+  bool AllowedConcurrentReaders = Context.allowsConcurrentReaders();
+  if (NumThreads != 1)
+    Context.setConcurrentReaders(true);
+  runTasksInParallel(NumThreads, NumPartitions, runDeclPartition, &Run,
+                     ParallelTraversalStackSize);
+  Context.setConcurrentReaders(AllowedConcurrentReaders);
+
+  for (unsigned I = 0; I != NumPartitions; ++I)
+    if (!Run.Succeeded[I])
+      return false;
+  return true;
+}
+
+} // end namespace tooling
+} // end namespace clang
@@ -12,13 +12,16 @@
 //===----------------------------------------------------------------------===//
 
 #include "clang/Basic/FileManager.h"
+#include "clang/Basic/Parallel.h"
 #include "clang/Basic/SourceManager.h"
-#include "clang/Frontend/DiagnosticOptions.h"
-#include "clang/Frontend/TextDiagnosticPrinter.h"
 #include "clang/Lex/Lexer.h"
 #include "clang/Rewrite/Core/Rewriter.h"
 #include "clang/Tooling/Refactoring.h"
+#include "llvm/ADT/OwningPtr.h"
+#include "llvm/Support/MemoryBuffer.h"
+#include "llvm/Support/MutexGuard.h"
 #include "llvm/Support/raw_os_ostream.h"
+#include "llvm/Support/system_error.h"
 
 namespace clang {
 namespace tooling {
@@ -135,6 +138,144 @@ bool applyAllReplacements(Replacements &Replaces, Rewriter &Rewrite) {
   return Result;
 }
 
+unsigned applyReplacementsToCode(StringRef Code,
+                                 Replacements::const_iterator Begin,
+                                 Replacements::const_iterator End,
+                                 std::string &Result) {
+  Result.clear();
+  Result.reserve(Code.size());
+  unsigned Skipped = 0;
+  // The end of the part of Code consumed so far.
+  unsigned Position = 0;
+  for (Replacements::const_iterator I = Begin; I != End; ++I) {
+    unsigned Offset = I->getOffset();
+    unsigned Length = I->getLength();
+    if (Offset < Position || Offset > Code.size() ||
+        Length > Code.size() - Offset) {
+      ++Skipped;
+      continue;
+    }
+    Result.append(Code.data() + Position, Offset - Position);
+    Result.append(I->getReplacementText().data(),
+                  I->getReplacementText().size());
+    Position = Offset + Length;
+  }
+  Result.append(Code.data() + Position, Code.size() - Position);
+  return Skipped;
+}
+
+namespace {
+/// \brief The replacements for one file, applied by applyFileReplacements.
+struct FileReplacements {
+  Replacements::const_iterator Begin, End;
+  bool Applied, Saved;
+};
+}
+
+static void applyFileReplacements(void *UserData, unsigned Index) {
+  FileReplacements &File =
+    (*static_cast<std::vector<FileReplacements> *>(UserData))[Index];
+  std::string FilePath = File.Begin->getFilePath();
+  File.Applied = File.Saved = false;
+
+  std::string Result;
+  {
+    llvm::OwningPtr<llvm::MemoryBuffer> Code;
+    if (llvm::MemoryBuffer::getFile(FilePath, Code))
+      return;
+    // Like applyAllReplacements(), apply the replacements which do not
+    // conflict even if some do.
+    File.Applied = applyReplacementsToCode(Code->getBuffer(), File.Begin,
+                                           File.End, Result) == 0;
+  }
+
+  std::string ErrorInfo;
+  llvm::raw_fd_ostream FileStream(FilePath.c_str(), ErrorInfo,
+                                  llvm::raw_fd_ostream::F_Binary);
+  if (!ErrorInfo.empty())
+    return;
+  FileStream << Result;
+  FileStream.close();
+  File.Saved = !FileStream.has_error();
+  FileStream.clear_error();
+}
+
+bool applyAllReplacementsToFiles(const Replacements &Replaces,
+                                 unsigned NumThreads, bool *Saved) {
+  bool Result = true;
+  std::vector<FileReplacements> Files;
+  // Replacements are ordered by file first, so each file's are contiguous.
+  for (Replacements::const_iterator I = Replaces.begin(), E = Replaces.end();
+       I != E; ) {
+    Replacements::const_iterator FileEnd = I;
+    while (FileEnd != E && FileEnd->getFilePath() == I->getFilePath())
+      ++FileEnd;
+    if (I->isApplicable()) {
+      FileReplacements File;
+      File.Begin = I;
+      File.End = FileEnd;
+      File.Applied = File.Saved = false;
+      Files.push_back(File);
+    } else {
+      Result = false;
+    }
+    I = FileEnd;
+  }
+
+  runTasksInParallel(NumThreads, Files.size(), applyFileReplacements, &Files);
+
+  if (Saved)
+    *Saved = true;
+  for (unsigned I = 0, E = Files.size(); I != E; ++I) {
+    Result = Files[I].Applied && Result;
+    if (Saved && !Files[I].Saved)
+      *Saved = false;
+  }
+  return Result;
+}
+
+void writeReplacements(const Replacements &Replaces, raw_ostream &OS) {
+  for (Replacements::const_iterator I = Replaces.begin(), E = Replaces.end();
+       I != E; ++I) {
+    OS << "R " << I->getOffset() << ' ' << I->getLength() << ' '
+       << I->getFilePath().size() << ' ' << I->getReplacementText().size()
+       << '\n' << I->getFilePath() << I->getReplacementText() << '\n';
+  }
+}
+
+bool readReplacements(StringRef Data, Replacements &Replaces) {
+  while (!Data.empty()) {
+    std::pair<StringRef, StringRef> Header = Data.split('\n');
+    SmallVector<StringRef, 5> Fields;
+    Header.first.split(Fields, " ");
+    unsigned Offset, Length, PathSize, TextSize;
+    if (Fields.size() != 5 || Fields[0] != "R" ||
+        Fields[1].getAsInteger(10, Offset) ||
+        Fields[2].getAsInteger(10, Length) ||
+        Fields[3].getAsInteger(10, PathSize) ||
+        Fields[4].getAsInteger(10, TextSize))
+      return false;
+
+    // The path and the text may contain anything, including newlines, so
+    // only their sizes delimit them.
+    Data = Header.second;
+    if (PathSize > Data.size() || TextSize >= Data.size() - PathSize ||
+        Data[PathSize + TextSize] != '\n')
+      return false;
+    Replaces.insert(Replacement(Data.substr(0, PathSize), Offset, Length,
+                                Data.substr(PathSize, TextSize)));
+    Data = Data.substr(PathSize + TextSize + 1);
+  }
+  return true;
+}
+
+bool readReplacementsFile(StringRef Path, Replacements &Replaces) {
+  llvm::OwningPtr<llvm::MemoryBuffer> Contents;
+  if (llvm::MemoryBuffer::getFile(Path, Contents))
+    return false;
+  return readReplacements(Contents->getBuffer(), Replaces);
+}
+
 bool saveRewrittenFiles(Rewriter &Rewrite) {
   for (Rewriter::buffer_iterator I = Rewrite.buffer_begin(),
                                  E = Rewrite.buffer_end();
@@ -161,21 +302,33 @@ RefactoringTool::RefactoringTool(const CompilationDatabase &Compilations,
 
 Replacements &RefactoringTool::getReplacements() { return Replace; }
 
+void RefactoringTool::addReplacement(const Replacement &NewReplacement) {
+  llvm::MutexGuard Guard(ReplaceLock);
+  Replace.insert(NewReplacement);
+}
+
 int RefactoringTool::run(FrontendActionFactory *ActionFactory) {
   int Result = Tool.run(ActionFactory);
-  LangOptions DefaultLangOptions;
-  DiagnosticOptions DefaultDiagnosticOptions;
-  TextDiagnosticPrinter DiagnosticPrinter(llvm::errs(),
-                                          DefaultDiagnosticOptions);
-  DiagnosticsEngine Diagnostics(
-      llvm::IntrusiveRefCntPtr<DiagnosticIDs>(new DiagnosticIDs()),
-      &DiagnosticPrinter, false);
-  SourceManager Sources(Diagnostics, Tool.getFiles());
-  Rewriter Rewrite(Sources, DefaultLangOptions);
-  if (!applyAllReplacements(Replace, Rewrite)) {
+  if (!ReplacementsFile.empty()) {
+    std::string ErrorInfo;
+    llvm::raw_fd_ostream FileStream(ReplacementsFile.c_str(), ErrorInfo,
+                                    llvm::raw_fd_ostream::F_Binary);
+    if (ErrorInfo.empty()) {
+      writeReplacements(Replace, FileStream);
+      FileStream.close();
+      if (!FileStream.has_error())
+        return Result;
+      FileStream.clear_error();
+    }
+    llvm::errs() << "Could not write the replacements to "
+                 << ReplacementsFile << ".\n";
+    return 1;
+  }
+  bool Saved;
+  if (!applyAllReplacementsToFiles(Replace, Tool.getNumThreads(), &Saved)) {
     llvm::errs() << "Skipped some replacements.\n";
   }
-  if (!saveRewrittenFiles(Rewrite)) {
+  if (!Saved) {
     llvm::errs() << "Could not save rewritten files.\n";
     return 1;
   }
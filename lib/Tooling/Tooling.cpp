@@ -15,15 +15,22 @@
 #include "clang/Tooling/ArgumentsAdjusters.h"
 #include "clang/Tooling/Tooling.h"
 #include "clang/Tooling/CompilationDatabase.h"
+#include "clang/Basic/FileSystemStatCache.h"
+#include "clang/Basic/Parallel.h"
 #include "clang/Driver/Compilation.h"
 #include "clang/Driver/Driver.h"
 #include "clang/Driver/Tool.h"
 #include "clang/Frontend/CompilerInstance.h"
 #include "clang/Frontend/FrontendDiagnostic.h"
+#include "clang/Frontend/MultiplexConsumer.h"
 #include "clang/Frontend/TextDiagnosticPrinter.h"
+#include "clang/Serialization/ASTReader.h"
+#include "clang/Serialization/ASTWriter.h"
 #include "llvm/ADT/STLExtras.h"
+#include "llvm/ADT/StringExtras.h"
 #include "llvm/Support/FileSystem.h"
 #include "llvm/Support/Host.h"
+#include "llvm/Support/MutexGuard.h"
 #include "llvm/Support/raw_ostream.h"
 
 // For chdir, see the comment in ClangTool::run for more information.
@@ -142,10 +149,50 @@ std::string getAbsolutePath(StringRef File) {
   return PathStorage.str();
 }
 
+namespace {
+/// \brief Runs an action, and saves the AST it ran over to an AST file.
+class ASTSavingAction : public WrapperFrontendAction {
+  std::string OutputFile;
+
+protected:
+  virtual ASTConsumer *CreateASTConsumer(CompilerInstance &CI,
+                                         StringRef InFile) {
+    ASTConsumer *Consumer =
+      WrapperFrontendAction::CreateASTConsumer(CI, InFile);
+    if (!Consumer)
+      return 0;
+
+    // Failing to save the AST does not make the action fail, so the error is
+    // not reported.
+    std::string Error;
+    raw_ostream *OS = CI.createOutputFile(OutputFile, Error, /*Binary=*/true,
+                                          /*RemoveFileOnSignal=*/false, InFile,
+                                          /*Extension=*/"",
+                                          /*UseTemporary=*/true,
+                                          /*CreateMissingDirectories=*/true);
+    if (!OS)
+      return Consumer;
+
+    // The writer does not write anything if there were errors, and the
+    // output file is then erased.
+    std::vector<ASTConsumer *> Consumers;
+    Consumers.push_back(Consumer);
+    Consumers.push_back(new PCHGenerator(CI.getPreprocessor(), OutputFile,
+                                         /*Module=*/0, /*isysroot=*/"", OS));
+    return new MultiplexConsumer(Consumers);
+  }
+
+public:
+  ASTSavingAction(FrontendAction *WrappedAction, StringRef OutputFile)
+    : WrapperFrontendAction(WrappedAction), OutputFile(OutputFile) {}
+};
+}
+
 ToolInvocation::ToolInvocation(
     ArrayRef<std::string> CommandLine, FrontendAction *ToolAction,
     FileManager *Files)
-    : CommandLine(CommandLine.vec()), ToolAction(ToolAction), Files(Files) {
+    : CommandLine(CommandLine.vec()), ToolAction(ToolAction), Files(Files),
+      DiagnosticOutput(&llvm::errs()) {
 }
 
 void ToolInvocation::mapVirtualFile(StringRef FilePath, StringRef Content) {
@@ -161,7 +208,7 @@ bool ToolInvocation::run() {
   const char *const BinaryName = Argv[0];
   DiagnosticOptions DefaultDiagnosticOptions;
   TextDiagnosticPrinter DiagnosticPrinter(
-      llvm::errs(), DefaultDiagnosticOptions);
+      *DiagnosticOutput, DefaultDiagnosticOptions);
   DiagnosticsEngine Diagnostics(llvm::IntrusiveRefCntPtr<clang::DiagnosticIDs>(
       new DiagnosticIDs()), &DiagnosticPrinter, false);
 
@@ -178,6 +225,12 @@ bool ToolInvocation::run() {
   }
   llvm::OwningPtr<clang::CompilerInvocation> Invocation(
       newInvocation(&Diagnostics, *CC1Args));
+  if (!InputASTFile.empty()) {
+    std::vector<FrontendInputFile> &Inputs =
+      Invocation->getFrontendOpts().Inputs;
+    Inputs.clear();
+    Inputs.push_back(FrontendInputFile(InputASTFile, IK_AST));
+  }
   return runInvocation(BinaryName, Compilation.get(), Invocation.take(),
                        *CC1Args);
 }
@@ -197,26 +250,41 @@ bool ToolInvocation::runInvocation(
   // Create a compiler instance to handle the actual work.
   clang::CompilerInstance Compiler;
   Compiler.setInvocation(Invocation);
-  Compiler.setFileManager(Files);
+  // Loading an AST file replaces the FileManager of the compiler by the one
+  // of the AST, so ours is only handed to it when parsing.
+  const bool LoadsAST = !InputASTFile.empty();
+  if (!LoadsAST)
+    Compiler.setFileManager(Files);
   // FIXME: What about LangOpts?
 
   // ToolAction can have lifetime requirements for Compiler or its members, and
   // we need to ensure it's deleted earlier than Compiler. So we pass it to an
   // OwningPtr declared after the Compiler variable.
   llvm::OwningPtr<FrontendAction> ScopedToolAction(ToolAction.take());
+  if (!OutputASTFile.empty())
+    ScopedToolAction.reset(
+      new ASTSavingAction(ScopedToolAction.take(), OutputASTFile));
 
   // Create the compilers actual diagnostics engine.
   Compiler.createDiagnostics(CC1Args.size(),
-                             const_cast<char**>(CC1Args.data()));
+                             const_cast<char**>(CC1Args.data()),
+                             new TextDiagnosticPrinter(
+                                 *DiagnosticOutput,
+                                 Compiler.getDiagnosticOpts()),
+                             /*ShouldOwnClient=*/true,
+                             /*ShouldCloneClient=*/false);
   if (!Compiler.hasDiagnostics())
     return false;
 
-  Compiler.createSourceManager(*Files);
-  addFileMappingsTo(Compiler.getSourceManager());
+  if (!LoadsAST) {
+    Compiler.createSourceManager(*Files);
+    addFileMappingsTo(Compiler.getSourceManager());
+  }
 
   const bool Success = Compiler.ExecuteAction(*ScopedToolAction);
 
-  Compiler.resetAndLeakFileManager();
+  if (!LoadsAST)
+    Compiler.resetAndLeakFileManager();
   Files->clearStatCaches();
   return Success;
 }
@@ -238,7 +306,8 @@ void ToolInvocation::addFileMappingsTo(SourceManager &Sources) {
 ClangTool::ClangTool(const CompilationDatabase &Compilations,
                      ArrayRef<std::string> SourcePaths)
     : Files((FileSystemOptions())),
-      ArgsAdjuster(new ClangSyntaxOnlyAdjuster()) {
+      ArgsAdjuster(new ClangSyntaxOnlyAdjuster()), NumThreads(1),
+      UseSharedStatCache(false), ShardIndex(0), ShardCount(1) {
   for (unsigned I = 0, E = SourcePaths.size(); I != E; ++I) {
     llvm::SmallString<1024> File(getAbsolutePath(SourcePaths[I]));
 
@@ -268,6 +337,90 @@ void ClangTool::setArgumentsAdjuster(ArgumentsAdjuster *Adjuster) {
   ArgsAdjuster.reset(Adjuster);
 }
 
+void ClangTool::setASTCacheDirectory(StringRef Directory) {
+  // The tool changes into the directories of the compile commands.
+  ASTCacheDirectory = Directory.empty() ? "" : getAbsolutePath(Directory);
+}
+
+void ClangTool::setShard(unsigned Index, unsigned Count) {
+  assert(Count != 0 && Index < Count && "Invalid shard");
+  ShardIndex = Index;
+  ShardCount = Count;
+}
+
+bool ClangTool::isInShard(StringRef File) const {
+  // The hash must be the same on every machine, so it cannot depend on
+  // pointers or on the order of the files.
+  return ShardCount == 1 || llvm::HashString(File) % ShardCount == ShardIndex;
+}
+
+/// \brief Returns the path under which the AST of \p File, compiled with
+/// \p CommandLine in \p Directory, is saved in \p CacheDirectory, or an empty
+/// string if \p File cannot be read.
+///
+/// The name hashes the compile command and the contents of the file; the
+/// included files are checked when the AST is loaded.
+static std::string getCachedASTPath(StringRef CacheDirectory, StringRef File,
+                                    StringRef Directory,
+                                    ArrayRef<std::string> CommandLine) {
+  OwningPtr<llvm::MemoryBuffer> Contents;
+  if (llvm::MemoryBuffer::getFile(File, Contents))
+    return std::string();
+
+  // The first argument is the path of the tool, which does not matter.
+  std::string Command = File;
+  Command += '\0';
+  Command += Directory;
+  for (unsigned I = 1, E = CommandLine.size(); I != E; ++I) {
+    Command += '\0';
+    Command += CommandLine[I];
+  }
+
+  SmallString<256> Path(CacheDirectory);
+  llvm::sys::path::append(Path, llvm::sys::path::filename(File) + "-" +
+                                llvm::utohexstr(llvm::HashString(Command)) +
+                                "-" +
+                                llvm::utohexstr(llvm::HashString(
+                                    Contents->getBuffer())) +
+                                ".ast");
+  return Path.str();
+}
+
+/// \brief Returns whether the AST file \p Path exists and is up to date,
+/// which requires the files it was built from to be unchanged.
+///
+/// Only the records describing those files are read, so checking an entry
+/// costs about as much as stat'ing them.
+static bool isCachedASTUsable(const std::string &Path,
+                              const FileSystemOptions &FileSystemOpts) {
+  bool Exists;
+  if (llvm::sys::fs::exists(Path, Exists) || !Exists)
+    return false;
+
+  FileManager Files(FileSystemOpts);
+  return ASTReader::isASTFileUpToDate(Path, Files);
+}
+
+/// \brief Makes \p Invocation run over the AST of \p File saved in
+/// \p CacheDirectory if it is still usable, and save it there otherwise.
+static void useCachedAST(ToolInvocation &Invocation,
+                         const FrontendAction &Action,
+                         StringRef CacheDirectory, StringRef File,
+                         StringRef Directory,
+                         ArrayRef<std::string> CommandLine,
+                         const FileSystemOptions &FileSystemOpts) {
+  if (!Action.hasASTFileSupport() || Action.usesPreprocessorOnly())
+    return;
+  std::string Path =
+    getCachedASTPath(CacheDirectory, File, Directory, CommandLine);
+  if (Path.empty())
+    return;
+  if (isCachedASTUsable(Path, FileSystemOpts))
+    Invocation.setInputASTFile(Path);
+  else
+    Invocation.setOutputASTFile(Path);
+}
+
 int ClangTool::run(FrontendActionFactory *ActionFactory) {
   // Exists solely for the purpose of lookup of the resource path.
   // This just needs to be some symbol in the binary.
@@ -280,9 +433,14 @@ int ClangTool::run(FrontendActionFactory *ActionFactory) {
   std::string MainExecutable =
     llvm::sys::Path::GetMainExecutable("clang_tool", &StaticSymbol).str();
 
+  if (NumThreads != 1 && isParallelExecutionSupported())
+    return runInParallel(ActionFactory, MainExecutable);
+
   bool ProcessingFailed = false;
   for (unsigned I = 0; I < CompileCommands.size(); ++I) {
     std::string File = CompileCommands[I].first;
+    if (!isInShard(File))
+      continue;
     // FIXME: chdir is thread hostile; on the other hand, creating the same
     // behavior as chdir is complex: chdir resolves the path once, thus
     // guaranteeing that all subsequent relative path operations work
@@ -298,11 +456,19 @@ int ClangTool::run(FrontendActionFactory *ActionFactory) {
     assert(!CommandLine.empty());
     CommandLine[0] = MainExecutable;
     llvm::outs() << "Processing: " << File << ".\n";
-    ToolInvocation Invocation(CommandLine, ActionFactory->create(), &Files);
+    // The invocation clears the stat caches of the FileManager when done.
+    if (UseSharedStatCache)
+      Files.addStatCache(new SharedStatCache());
+    FrontendAction *Action = ActionFactory->create();
+    ToolInvocation Invocation(CommandLine, Action, &Files);
     for (int I = 0, E = MappedFileContents.size(); I != E; ++I) {
       Invocation.mapVirtualFile(MappedFileContents[I].first,
                                 MappedFileContents[I].second);
     }
+    if (!ASTCacheDirectory.empty() && MappedFileContents.empty())
+      useCachedAST(Invocation, *Action, ASTCacheDirectory, File,
+                   CompileCommands[I].second.Directory, CommandLine,
+                   Files.getFileSystemOptions());
     if (!Invocation.run()) {
       llvm::outs() << "Error while processing " << File << ".\n";
       ProcessingFailed = true;
@@ -311,5 +477,105 @@ int ClangTool::run(FrontendActionFactory *ActionFactory) {
   return ProcessingFailed ? 1 : 0;
 }
 
+namespace {
+/// \brief One translation unit processed by ClangTool::runInParallel.
+struct ParallelToolTask {
+  std::string File;
+  std::string Directory;
+  std::vector<std::string> CommandLine;
+  /// \brief The buffered diagnostics of the invocation.
+  std::string Diagnostics;
+  bool Success;
+};
+
+/// \brief The state shared by the workers of ClangTool::runInParallel.
+struct ParallelToolRun {
+  FrontendActionFactory *ActionFactory;
+  const std::vector< std::pair<StringRef, StringRef> > *MappedFileContents;
+  std::vector<ParallelToolTask> Tasks;
+  bool UseSharedStatCache;
+  StringRef ASTCacheDirectory;
+  /// \brief Serializes calls to ActionFactory->create().
+  llvm::sys::Mutex FactoryLock;
+};
+}
+
+static void runParallelToolTask(void *UserData, unsigned Index) {
+  ParallelToolRun &Run = *static_cast<ParallelToolRun *>(UserData);
+  ParallelToolTask &Task = Run.Tasks[Index];
+
+  // Every worker gets its own FileManager; the compile command's directory is
+  // applied to relative paths through the FileSystemOptions, since chdir
+  // would affect all threads.
+  FileSystemOptions FileSystemOpts;
+  FileSystemOpts.WorkingDir = Task.Directory;
+  FileManager Files(FileSystemOpts);
+  if (Run.UseSharedStatCache)
+    Files.addStatCache(new SharedStatCache());
+
+  FrontendAction *Action;
+  {
+    llvm::MutexGuard Guard(Run.FactoryLock);
+    Action = Run.ActionFactory->create();
+  }
+  ToolInvocation Invocation(Task.CommandLine, Action, &Files);
+  llvm::raw_string_ostream DiagnosticStream(Task.Diagnostics);
+  Invocation.setDiagnosticOutput(DiagnosticStream);
+  for (int I = 0, E = Run.MappedFileContents->size(); I != E; ++I) {
+    Invocation.mapVirtualFile((*Run.MappedFileContents)[I].first,
+                              (*Run.MappedFileContents)[I].second);
+  }
+  if (!Run.ASTCacheDirectory.empty() && Run.MappedFileContents->empty())
+    useCachedAST(Invocation, *Action, Run.ASTCacheDirectory, Task.File,
+                 Task.Directory, Task.CommandLine, FileSystemOpts);
+  Task.Success = Invocation.run();
+  DiagnosticStream.flush();
+}
+
+// Ensure worker threads have the same amount of stack as libclang's safety
+// threads, since parsing is deeply recursive.
+static const unsigned ParallelToolStackSize = 8 << 20;
+
+int ClangTool::runInParallel(FrontendActionFactory *ActionFactory,
+                             const std::string &MainExecutable) {
+  ParallelToolRun Run;
+  Run.ActionFactory = ActionFactory;
+  Run.MappedFileContents = &MappedFileContents;
+  Run.UseSharedStatCache = UseSharedStatCache;
+  Run.ASTCacheDirectory = ASTCacheDirectory;
+  for (unsigned I = 0, E = CompileCommands.size(); I != E; ++I) {
+    if (!isInShard(CompileCommands[I].first))
+      continue;
+    Run.Tasks.push_back(ParallelToolTask());
+    ParallelToolTask &Task = Run.Tasks.back();
+    Task.File = CompileCommands[I].first;
+    Task.Directory = CompileCommands[I].second.Directory;
+    Task.CommandLine =
+      ArgsAdjuster->Adjust(CompileCommands[I].second.CommandLine);
+    assert(!Task.CommandLine.empty());
+    Task.CommandLine[0] = MainExecutable;
+    Task.Success = false;
+  }
+
+  runTasksInParallel(NumThreads, Run.Tasks.size(), runParallelToolTask, &Run,
+                     ParallelToolStackSize);
+
+  // Report in the order of the compile commands, independent of the order in
+  // which the workers finished.
+  bool ProcessingFailed = false;
+  for (unsigned I = 0, E = Run.Tasks.size(); I != E; ++I) {
+    const ParallelToolTask &Task = Run.Tasks[I];
+    llvm::outs() << "Processing: " << Task.File << ".\n";
+    llvm::outs().flush();
+    llvm::errs() << Task.Diagnostics;
+    llvm::errs().flush();
+    if (!Task.Success) {
+      llvm::outs() << "Error while processing " << Task.File << ".\n";
+      ProcessingFailed = true;
+    }
+  }
+  return ProcessingFailed ? 1 : 0;
+}
+
 } // end namespace tooling
 } // end namespace clang
@@ -0,0 +1,21 @@
+@protocol NSObject
+- (oneway void)release;
+@end
+
+#ifdef PART1
+static inline void first1(id p) {
+  [p release];
+}
+#endif
+
+#ifdef PART2
+static inline void only2(id p) {
+  [p release];
+}
+#endif
+
+#ifdef PART1
+static inline void last1(id p) {
+  [p release];
+}
+#endif
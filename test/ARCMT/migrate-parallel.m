@@ -0,0 +1,14 @@
+// Both translation units rewrite different parts of test.h; their edits are
+// merged.
+// RUN: rm -rf %t
+// RUN: arcmt-test -migrate-directory %t -j 2 --args %S/Inputs/test1.m.in %S/Inputs/test2.m.in -x objective-c
+// RUN: c-arcmt-test -mt-migrate-directory %t | arcmt-test -verify-transformed-files %S/Inputs/test1.m.in.result %S/Inputs/test2.m.in.result %S/Inputs/test.h.result
+// RUN: rm -rf %t
+
+// The edits of the first translation unit to conflict.h surround the one of
+// the second, so they cannot be merged; both are migrated again, one after
+// the other.
+// RUN: arcmt-test -migrate-directory %t -j 2 --args %S/Inputs/conflict1.m.in %S/Inputs/conflict2.m.in -x objective-c
+// RUN: c-arcmt-test -mt-migrate-directory %t | arcmt-test -verify-transformed-files %S/Inputs/conflict1.m.in.result %S/Inputs/conflict2.m.in.result %S/Inputs/conflict.h.result
+// RUN: rm -rf %t
+// DISABLE: mingw32
@@ -0,0 +1,10 @@
+struct Point { int x, y; };
+struct Line { struct Point from, to; };
+struct Bad { int i; };
+
+struct Point p1;
+struct Line l1;
+struct Line *l2;
+struct Point *p2[2];
+struct Bad b1;
+struct Line l3;
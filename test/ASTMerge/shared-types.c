@@ -0,0 +1,17 @@
+// RUN: %clang_cc1 -emit-pch -o %t.1.ast %S/Inputs/shared-types1.c
+// RUN: %clang_cc1 -emit-pch -o %t.2.ast %S/Inputs/shared-types2.c
+// RUN: %clang_cc1 -ast-merge %t.1.ast -ast-merge %t.2.ast -fsyntax-only %s 2>&1 | FileCheck %s
+
+// Types that many declarations share are only compared once, but mismatches
+// are still diagnosed.
+
+// CHECK-NOT: 'struct Point'
+// CHECK-NOT: 'struct Line'
+// CHECK: shared-types1.c:3:8: warning: type 'struct Bad' has incompatible definitions in different translation units
+// CHECK: shared-types1.c:3:18: note: field 'i' has type 'int' here
+// CHECK: shared-types2.c:3:20: note: field 'i' has type 'float' here
+// CHECK: shared-types2.c:9:12: error: external variable 'b1' declared with incompatible types in different translation units ('struct Bad' vs. 'struct Bad')
+// CHECK: shared-types1.c:9:12: note: declared here with type 'struct Bad'
+// CHECK-NOT: 'struct Point'
+// CHECK-NOT: 'struct Line'
+// CHECK: 1 warning and 1 error generated
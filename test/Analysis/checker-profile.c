@@ -0,0 +1,16 @@
+// RUN: %clang_cc1 -analyze -analyzer-checker=core.DivideZero -analyzer-checker-profile %t %s
+// RUN: FileCheck %s < %t
+// RUN: %clang_cc1 -analyze -analyzer-checker=core.DivideZero -analyzer-stats %s 2>&1 | FileCheck -check-prefix=STATS %s
+
+int divide(int x) {
+  return 10 / x;
+}
+
+// CHECK: "checkers": [
+// CHECK-NEXT: { "name": "core.DivideZero", "callbacks": {
+// CHECK-NEXT: "PreStmt": { "calls": {{[1-9][0-9]*}}, "time_ns": {{[0-9]+}}, "nodes": {{[0-9]+}} }
+// CHECK-NEXT: } }
+// CHECK-NEXT: ]
+
+// STATS: *** Checker Profile:
+// STATS: {{[0-9.]+ +[1-9][0-9]* +[0-9]+}}  core.DivideZero - PreStmt
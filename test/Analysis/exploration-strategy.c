@@ -0,0 +1,16 @@
+// RUN: %clang_cc1 -analyze -analyzer-checker=core -analyzer-config exploration-strategy=unexplored-first -verify %s
+// RUN: %clang_cc1 -analyze -analyzer-checker=core -analyzer-config exploration-strategy=bfs -verify %s
+// RUN: %clang_cc1 -analyze -analyzer-checker=core -analyzer-config exploration-strategy=bfs-block-dfs-contents -verify %s
+// RUN: %clang_cc1 -analyze -analyzer-checker=core -analyzer-config exploration-strategy=unexplored-first -analyzer-stats %s 2>&1 | FileCheck %s
+
+int sumAndLoad(int n, int *p) {
+  int s = 0;
+  for (int i = 0; i < n; ++i)
+    s += i;
+  if (!p)
+    return *p; // expected-warning{{Dereference of null pointer}}
+  return s + *p;
+}
+
+// CHECK: AnalysisConsumer - The # of reachable basic blocks per 1000 steps.
+// CHECK: AnalysisConsumer - The # of steps executed in the analyzed functions.
@@ -0,0 +1,44 @@
+// RUN: rm -f %t
+// RUN: %clang_cc1 -analyze -analyzer-checker=core,debug.ExprInspection -analyzer-function-summaries %t -DFIRST -verify %s
+// RUN: FileCheck -check-prefix=SUMMARIES %s < %t
+// RUN: %clang_cc1 -analyze -analyzer-checker=core,debug.ExprInspection -analyzer-function-summaries %t -verify %s
+// RUN: FileCheck -check-prefix=SUMMARIES %s < %t
+// RUN: %clang_cc1 -analyze -analyzer-checker=core,debug.ExprInspection -DNO_SUMMARIES -verify %s
+
+void clang_analyzer_eval(int);
+
+int sum(int n) {
+  int s = 0;
+  for (int i = 0; i < n; ++i)
+    s += i;
+  return s;
+}
+
+static int sumStatic(int n) {
+  int s = 0;
+  for (int i = 0; i < n; ++i)
+    s += i;
+  return s;
+}
+
+#ifdef FIRST
+// Inlining both functions reaches the maximum block count, but only the one
+// with external linkage is recorded.
+void first(int n) {
+  sum(n);
+  sumStatic(n);
+}
+#else
+void second() {
+#ifdef NO_SUMMARIES
+  clang_analyzer_eval(sum(0) == 0); // expected-warning{{TRUE}}
+#else
+  // sum() is not inlined, because it was too expensive in the first run.
+  clang_analyzer_eval(sum(0) == 0); // expected-warning{{UNKNOWN}}
+#endif
+  clang_analyzer_eval(sumStatic(0) == 0); // expected-warning{{TRUE}}
+}
+#endif
+
+// SUMMARIES: {{^sum$}}
+// SUMMARIES-NOT: sum
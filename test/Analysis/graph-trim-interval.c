@@ -0,0 +1,25 @@
+// RUN: %clang_cc1 -analyze -analyzer-checker=core,debug.Stats -analyzer-config graph-trim-interval=1 -verify %s
+// RUN: %clang_cc1 -analyze -analyzer-checker=core,debug.Stats -analyzer-no-eagerly-trim-egraph -verify -DNO_TRIM %s
+
+int chain(int a) {
+#ifdef NO_TRIM
+  // expected-warning@-2 {{Reclaimed Nodes: 0}}
+#else
+  // expected-warning-re@-4 {{Reclaimed Nodes: [1-9][0-9]*$}}
+#endif
+  int b = a + 1;
+  int c = b * 2;
+  int d = c - a;
+  return d / 2;
+}
+
+void test_null(int *p) {
+#ifdef NO_TRIM
+  // expected-warning@-2 {{Reclaimed Nodes: 0}}
+#else
+  // expected-warning-re@-4 {{Reclaimed Nodes: [1-9][0-9]*$}}
+#endif
+  int x = 1 + 2;
+  if (!p)
+    *p = x; // expected-warning {{Dereference of null pointer}}
+}
@@ -0,0 +1,33 @@
+// RUN: %clang_cc1 -analyze -analyzer-checker=core,debug.ExprInspection -analyzer-ipa=inlining -verify %s
+// RUN: %clang_cc1 -analyze -analyzer-checker=core,debug.ExprInspection -analyzer-ipa=inlining -analyzer-config ipa-inlining-budget=6 -DBUDGET -verify %s
+
+void clang_analyzer_eval(int);
+
+int identity(int x) {
+  return x;
+}
+
+int classify(int x) {
+  if (x > 100)
+    return 1;
+  if (x > 10)
+    return 1;
+  if (x > 0)
+    return 1;
+  return 1;
+}
+
+// Small callees fit in the budget.
+void testSmall(int x) {
+  clang_analyzer_eval(identity(x) == x); // expected-warning{{TRUE}}
+  clang_analyzer_eval(identity(1) == 1); // expected-warning{{TRUE}}
+}
+
+// Larger ones do not.
+void testLarge(int x) {
+#ifdef BUDGET
+  clang_analyzer_eval(classify(x) == 1); // expected-warning{{UNKNOWN}}
+#else
+  clang_analyzer_eval(classify(x) == 1); // expected-warning{{TRUE}}
+#endif
+}
@@ -0,0 +1,37 @@
+// RUN: %clang_cc1 -analyze -analyzer-checker=core,debug.ExprInspection -analyzer-ipa=inlining -verify %s
+// RUN: %clang_cc1 -analyze -analyzer-checker=core,debug.ExprInspection -analyzer-ipa=inlining -analyzer-config max-retained-decl-contexts=1 -verify %s
+// RUN: %clang_cc1 -analyze -analyzer-checker=core,debug.ExprInspection -analyzer-ipa=inlining -analyzer-config max-retained-decl-contexts=100 -verify %s
+
+// Callees are inlined into several top-level functions, whether their
+// contexts were kept from the previous one or discarded and rebuilt.
+
+void clang_analyzer_eval(int);
+
+int identity(int x) {
+  return x;
+}
+
+int twice(int x) {
+  return identity(identity(x));
+}
+
+int *null(void) {
+  return 0;
+}
+
+void testIdentity(int x) {
+  clang_analyzer_eval(identity(x) == x); // expected-warning{{TRUE}}
+}
+
+void testTwice(int x) {
+  clang_analyzer_eval(twice(x) == x); // expected-warning{{TRUE}}
+}
+
+void testNull(void) {
+  *null() = 1; // expected-warning{{Dereference of null pointer}}
+}
+
+void testAgain(int x) {
+  clang_analyzer_eval(twice(identity(x)) == x); // expected-warning{{TRUE}}
+  *null() = 2; // expected-warning{{Dereference of null pointer}}
+}
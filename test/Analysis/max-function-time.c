@@ -0,0 +1,20 @@
+// RUN: %clang_cc1 -analyze -analyzer-checker=core \
+// RUN:   -analyzer-config max-function-time=1 %s 2>&1 | FileCheck %s
+
+// The budget is checked every 256 steps, which the analysis of cheap() never
+// reaches. Exploring the paths through many() takes far more than 1 ms.
+
+int cheap(int x) { return x + 1; }
+
+int many(int *p) {
+  int n = 0;
+  if (p[0]) n++; if (p[1]) n++; if (p[2]) n++; if (p[3]) n++;
+  if (p[4]) n++; if (p[5]) n++; if (p[6]) n++; if (p[7]) n++;
+  if (p[8]) n++; if (p[9]) n++; if (p[10]) n++; if (p[11]) n++;
+  if (p[12]) n++; if (p[13]) n++; if (p[14]) n++; if (p[15]) n++;
+  return cheap(n);
+}
+
+// CHECK-NOT: 'cheap'
+// CHECK: max-function-time.c:9:5: remark: analysis of 'many' exceeded its time budget of 1 ms; the calls reached afterwards were not inlined
+// CHECK-NOT: 'cheap'
@@ -0,0 +1,24 @@
+// RUN: %clang_cc1 -emit-pch -o %t %s
+// RUN: %clang_cc1 -include-pch %t -analyze -analyzer-checker=core -analyzer-ipa=inlining -verify %s
+// RUN: %clang_cc1 -include-pch %t -analyze -analyzer-checker=core -analyzer-ipa=inlining -analyzer-stats %s 2>&1 | FileCheck %s
+
+#ifndef HEADER
+#define HEADER
+// Header.
+
+// These definitions are passed to the analyzer as interesting declarations,
+// but they are not in the main file, so they are not added to the call graph.
+int zero(void) { return 0; }
+int one(void) { return zero() + 1; }
+
+#else
+// Using the header.
+
+int test(int x) {
+  // Callees from the PCH are still inlined.
+  return x / (one() - 1); // expected-warning {{Division by zero}}
+}
+
+// CHECK: 2 AnalysisConsumer - The # of top level declarations from AST files left out of the call graph.
+
+#endif
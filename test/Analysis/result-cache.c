@@ -0,0 +1,31 @@
+// RUN: rm -f %t.cache
+// RUN: sed -e 's/@VALUE@/0/' %s > %t.c
+// RUN: %clang_cc1 -analyze -analyzer-checker=core -analyzer-result-cache %t.cache -verify %t.c
+// RUN: %clang_cc1 -analyze -analyzer-checker=core -analyzer-result-cache %t.cache -analyzer-stats -verify %t.c 2>&1 | FileCheck -check-prefix=CLEAN %s
+// RUN: sed -e 's/@VALUE@/1/' %s > %t.c
+// RUN: %clang_cc1 -analyze -analyzer-checker=core -analyzer-result-cache %t.cache -analyzer-stats -verify %t.c 2>&1 | FileCheck -check-prefix=CHANGED %s
+// RUN: (echo; echo; sed -e 's/@VALUE@/1/' %s) > %t.c
+// RUN: %clang_cc1 -analyze -analyzer-checker=core -analyzer-result-cache %t.cache -analyzer-stats -verify %t.c 2>&1 | FileCheck -check-prefix=CLEAN %s
+// RUN: %clang_cc1 -analyze -analyzer-checker=core -analyzer-config cfg-temporary-dtors=false -analyzer-result-cache %t.cache -analyzer-stats -verify %t.c 2>&1 | FileCheck -check-prefix=RECONFIG %s
+
+// The warning in unrelated() is reported from the cache once it was analyzed,
+// also after the lines above it moved.  Other analyzer options discard the
+// cache.
+void unrelated() {
+  int x = 0;
+  int y = 10 / x; // expected-warning{{Division by zero}}
+}
+
+int changed() {
+  return @VALUE@;
+}
+
+// Analyzed again whenever changed() is, since it inlines it.
+int caller() {
+  return changed() + 1;
+}
+
+// CLEAN: 3 AnalysisConsumer - The # of functions not analyzed again because they did not change.
+// CHANGED: 1 AnalysisConsumer - The # of functions not analyzed again because they did not change.
+// RECONFIG: AnalysisConsumer - The # of functions analysed
+// RECONFIG-NOT: not analyzed again
@@ -0,0 +1,27 @@
+struct Point {
+  float x;
+  float xy;
+  float y;
+  float maxY;
+};
+
+#define MAX_POINTS 10
+
+void test(struct Point *p) {
+  p->x;
+  // RUN: %clang_cc1 -fsyntax-only -code-completion-prefix X -code-completion-at=%s:11:6 %s -o - | FileCheck -check-prefix=CC1 %s
+  // CHECK-CC1-NOT: maxY
+  // CHECK-CC1: x : [#float#]x
+  // CHECK-CC1-NEXT: xy : [#float#]xy
+  // CHECK-CC1-NOT: y
+  // RUN: %clang_cc1 -fsyntax-only -code-completion-prefix Y -code-completion-fuzzy -code-completion-at=%s:11:6 %s -o - | FileCheck -check-prefix=CC2 %s
+  // CHECK-CC2: maxY : [#float#]maxY
+  // CHECK-CC2-NEXT: xy : [#float#]xy
+  // CHECK-CC2-NEXT: y : [#float#]y
+  // CHECK-CC2-NOT: x :
+  MAX_POINTS;
+  // RUN: %clang_cc1 -fsyntax-only -code-completion-macros -code-completion-prefix ma -code-completion-at=%s:22:3 %s -o - | FileCheck -check-prefix=CC3 %s
+  // CHECK-CC3-NOT: COMPLETION: test
+  // CHECK-CC3: MAX_POINTS
+  // CHECK-CC3-NOT: COMPLETION: test
+}
@@ -0,0 +1,20 @@
+typedef unsigned long size_t;
+typedef int vec_t[4];
+
+struct pair {
+  const char *first;
+  const char *second;
+  size_t length;
+};
+
+extern const char *names[2];
+extern vec_t origin;
+static const vec_t unit = { 1, 1, 1, 1 };
+
+size_t count_pairs(const struct pair *pairs, size_t length);
+
+static inline size_t pair_length(const struct pair *p) {
+  const char *first = p->first;
+  size_t length = p->length;
+  return first ? length : 0;
+}
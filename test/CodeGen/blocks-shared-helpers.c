@@ -0,0 +1,38 @@
+// RUN: %clang_cc1 -triple x86_64-apple-darwin10 -emit-llvm -fblocks -o - %s | FileCheck %s
+
+// Blocks whose captures are copied and disposed of alike share their copy
+// and dispose helpers.
+
+void use(void (^)(void));
+
+// CHECK: define void @test0()
+// CHECK: define internal void @__test0_block_invoke
+// CHECK: define internal void @__copy_helper_block_(
+// CHECK: call void @_Block_object_assign(i8* {{%.*}}, i8* {{%.*}}, i32 8)
+// CHECK: define internal void @__destroy_helper_block_(
+// CHECK: call void @_Block_object_dispose(i8* {{%.*}}, i32 8)
+void test0(void) {
+  __block int x = 0;
+  use(^{ ++x; });
+}
+
+// CHECK: define void @test1()
+// CHECK: define internal void @__test1_block_invoke
+// CHECK-NOT: define internal void @__copy_helper_block_
+// CHECK-NOT: define internal void @__destroy_helper_block_
+// CHECK: define void @test2()
+void test1(void) {
+  __block long y = 0;
+  use(^{ y = 1; });
+}
+
+// A block capturing a second variable needs helpers of its own.
+// CHECK: define internal void @__test2_block_invoke
+// CHECK: define internal void @__copy_helper_block_[[N:[0-9]*]](
+// CHECK: call void @_Block_object_assign(
+// CHECK: call void @_Block_object_assign(
+// CHECK: define internal void @__destroy_helper_block_[[N]](
+void test2(void) {
+  __block int x = 0, y = 0;
+  use(^{ x = y; });
+}
@@ -0,0 +1,51 @@
+// RUN: %clang_cc1 -fbounds-checking=4 -emit-llvm -triple x86_64-apple-darwin10 < %s | FileCheck %s
+// RUN: %clang_cc1 -fbounds-checking=4 -emit-llvm -disable-llvm-optzns -triple x86_64-apple-darwin10 < %s | FileCheck -check-prefix=CHECK-MD %s
+
+void use(int *);
+
+// The frontend proves the accesses of a loop bounded by the array size.
+// CHECK: @sum
+// CHECK-MD: @sum
+int sum(void) {
+  int a[16];
+  use(a);
+  int s = 0;
+  // CHECK-NOT: trap
+  // CHECK-MD: getelementptr inbounds [16 x i32]* %a, i32 0, i64 %{{.*}}, !clang.bounds.safe
+  for (int i = 0; i < 16; ++i)
+    s += a[i];
+  // CHECK-MD: getelementptr inbounds [16 x i32]* %a, i32 0, i64 %{{.*}}, !clang.bounds.safe
+  for (unsigned j = 1; j <= 16; j++)
+    s += a[j - 1];
+  return s;
+}
+
+// CHECK: @matrix
+void matrix(void) {
+  struct { int m[4][8]; } s;
+  // CHECK-NOT: trap
+  for (int i = 0; i < 4; ++i)
+    for (int j = 0; j < 8; j += 1)
+      s.m[i][j] = i + j;
+  use(&s.m[0][0]);
+}
+
+// CHECK: @too_far
+void too_far(void) {
+  int a[16];
+  // CHECK: trap
+  for (int i = 0; i <= 16; ++i)
+    a[i] = 0;
+  use(a);
+}
+
+// CHECK: @modified
+void modified(void) {
+  int a[16];
+  // CHECK: trap
+  for (int i = 0; i < 16; ++i) {
+    use(&i);
+    a[i] = 0;
+  }
+  use(a);
+}
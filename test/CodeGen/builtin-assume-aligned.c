@@ -0,0 +1,31 @@
+// RUN: %clang_cc1 -triple x86_64-unknown-unknown -emit-llvm -o - %s | FileCheck %s
+
+// The alignment is only checked by Sema; the result is the argument.
+
+// CHECK: define double* @test1
+double *test1(double *p) {
+  // CHECK-NOT: ptrtoint
+  // CHECK-NOT: unreachable
+  // CHECK: ret double*
+  return __builtin_assume_aligned(p, 32);
+}
+
+int next(void);
+
+// CHECK: define double* @test2
+double *test2(double *p) {
+  // CHECK: call i32 @next()
+  // CHECK-NOT: ptrtoint
+  // CHECK: ret double*
+  return __builtin_assume_aligned(p, 64, next());
+}
+
+void *alloc(int) __attribute__((assume_aligned(64, 16)));
+
+// CHECK: define float* @test3
+float *test3(void) {
+  // CHECK: [[CALL:%.*]] = call i8* @alloc(i32 100)
+  // CHECK-NEXT: [[CAST:%.*]] = bitcast i8* [[CALL]] to float*
+  // CHECK-NEXT: ret float* [[CAST]]
+  return alloc(100);
+}
@@ -0,0 +1,21 @@
+// RUN: %clang_cc1 -triple x86_64-apple-darwin10 -isystem %S/Inputs -fcompact-system-type-locs -emit-llvm -o - %s | FileCheck %s
+// RUN: %clang_cc1 -triple x86_64-apple-darwin10 -isystem %S/Inputs -fcompact-system-type-locs -fsyntax-only -verify %s
+
+#include <compact-system-type-locs.h>
+
+// CHECK: @origin = external global [4 x i32]
+// CHECK: @names = external global [2 x i8*]
+
+// CHECK: define i64 @test(%struct.pair* %p)
+size_t test(struct pair *p) {
+  // CHECK: call i64 @count_pairs
+  // CHECK: call i64 @pair_length
+  int x = origin[0] + unit[1];
+  return count_pairs(p, x) + pair_length(p) + (names[0] != 0);
+}
+
+// CHECK: define internal i64 @pair_length
+
+void bad(void) {
+  struct pair p = 0; // expected-error {{initializing 'struct pair' with an expression of incompatible type 'int'}}
+}
@@ -0,0 +1,29 @@
+// RUN: %clang_cc1 -triple x86_64-unknown-unknown -emit-llvm -o - %s | FileCheck %s
+
+// Arrays of integers are emitted as packed data.
+
+// CHECK: @blob = constant [4 x i8] c"\124\FF\00"
+const unsigned char blob[] = { 0x12, 0x34, 255, 0 };
+
+// CHECK: @neg = global [3 x i8] c"\FF\02\00"
+signed char neg[3] = { -1, 2 };
+
+// CHECK: @halves = global [4 x i16] [i16 1, i16 2, i16 -1, i16 0]
+unsigned short halves[4] = { 1, 2, 0xffff };
+
+// CHECK: @words = global [2 x i32] [i32 -1, i32 7]
+unsigned int words[] = { 0xffffffffu, 1 + 6 };
+
+// CHECK: @quads = global [2 x i64] [i64 -9223372036854775808, i64 1]
+unsigned long quads[] = { 0x8000000000000000ul, 1 };
+
+enum E { A = 3 };
+// CHECK: @enums = global [2 x i32] [i32 3, i32 0]
+enum E enums[2] = { A };
+
+// CHECK: @bools = global [2 x i8] c"\01\00"
+_Bool bools[] = { 1, 0 };
+
+// Integers which are not integer constants.
+// CHECK: @mixed = global [2 x i64] [i64 1, i64 ptrtoint ([4 x i8]* @blob to i64)]
+long mixed[] = { 1, (long)&blob };
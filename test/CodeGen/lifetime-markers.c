@@ -0,0 +1,65 @@
+// RUN: %clang_cc1 -triple x86_64-unknown-unknown -O1 -disable-llvm-optzns \
+// RUN:   -emit-llvm -o - %s | FileCheck %s
+// RUN: %clang_cc1 -triple x86_64-unknown-unknown -O0 -emit-llvm -o - %s \
+// RUN:   | FileCheck -check-prefix=O0 %s
+// RUN: %clang_cc1 -triple x86_64-unknown-unknown -O1 -disable-llvm-optzns \
+// RUN:   -lifetime-markers-min-size 0 -emit-llvm -o - %s \
+// RUN:   | FileCheck -check-prefix=ALL %s
+// RUN: %clang_cc1 -triple x86_64-unknown-unknown -O1 -disable-llvm-optzns \
+// RUN:   -disable-lifetime-markers -emit-llvm -o - %s \
+// RUN:   | FileCheck -check-prefix=O0 %s
+
+// O0-NOT: @llvm.lifetime.start
+
+extern void use(char *);
+
+// CHECK: define void @scopes
+// ALL: define void @scopes
+void scopes(int x) {
+  // CHECK-NOT: call void @llvm.lifetime.start(i64 4,
+  // ALL: call void @llvm.lifetime.start(i64 4,
+  int small = x;
+  use((char *)&small);
+  if (x) {
+    // CHECK: call void @llvm.lifetime.start(i64 64,
+    char a[64];
+    use(a);
+    // CHECK: call void @llvm.lifetime.end(i64 64,
+  } else {
+    // CHECK: call void @llvm.lifetime.start(i64 128,
+    char b[128];
+    use(b);
+    // CHECK: call void @llvm.lifetime.end(i64 128,
+  }
+  // ALL: call void @llvm.lifetime.end(i64 4,
+  // CHECK: ret void
+}
+
+// A jump into the scope of a variable bypasses its declaration.
+// CHECK: define void @bypassed
+void bypassed(int x) {
+  // CHECK-NOT: @llvm.lifetime
+  if (x)
+    goto skip;
+  {
+    char c[64];
+    use(c);
+  skip:
+    use(c);
+  }
+  // CHECK: ret void
+}
+
+// CHECK: define void @switch_bypassed
+void switch_bypassed(int x) {
+  // CHECK: call void @llvm.lifetime.start(i64 64,
+  // CHECK-NOT: call void @llvm.lifetime.start(i64 256,
+  char before[64];
+  use(before);
+  switch (x) {
+    char d[256];
+  case 1:
+    use(d);
+  }
+  // CHECK: ret void
+}
@@ -0,0 +1,57 @@
+// Test that -fprofile-instr-generate counts the regions of functions.
+// RUN: %clang_cc1 -triple x86_64-unknown-unknown -emit-llvm -o - %s \
+// RUN:   -fprofile-instr-generate | FileCheck %s
+
+// CHECK: @[[IFC:__llvm_pgo_ctr[0-9]*]] = internal global [3 x i64] zeroinitializer
+// CHECK: @[[LOOPC:__llvm_pgo_ctr[0-9]*]] = internal global [7 x i64] zeroinitializer
+// CHECK: @[[SWC:__llvm_pgo_ctr[0-9]*]] = internal global [4 x i64] zeroinitializer
+// CHECK: @llvm.global_ctors = appending global {{.*}} @__llvm_pgo_init
+
+// CHECK: define i32 @ifs(
+int ifs(int x) {
+  // CHECK: load i64* getelementptr inbounds ([3 x i64]* @[[IFC]], i64 0, i64 0)
+  // CHECK: store {{.*}} @[[IFC]], i64 0, i64 0)
+  if (x)
+    return 1;
+  return 0;
+  // CHECK: store {{.*}} @[[IFC]], i64 0, i64 1)
+  // CHECK: store {{.*}} @[[IFC]], i64 0, i64 2)
+}
+
+// CHECK: define void @loops(
+void loops(int n) {
+  int i;
+  // The while loop, then the '&&'.
+  while (n-- && i++)
+    ;
+  // CHECK: store {{.*}} @[[LOOPC]], i64 0, i64 3)
+  // CHECK: store {{.*}} @[[LOOPC]], i64 0, i64 4)
+  // CHECK: store {{.*}} @[[LOOPC]], i64 0, i64 1)
+  // CHECK: store {{.*}} @[[LOOPC]], i64 0, i64 2)
+  for (i = 0; i < n; ++i)
+    ;
+  // CHECK: store {{.*}} @[[LOOPC]], i64 0, i64 5)
+  // CHECK: store {{.*}} @[[LOOPC]], i64 0, i64 6)
+}
+
+// CHECK: define i32 @switches(
+int switches(int x) {
+  switch (x) {
+  case 1:
+    return 10;
+  case 2:
+    return 20;
+  }
+  return 0;
+  // CHECK: store {{.*}} @[[SWC]], i64 0, i64 2)
+  // CHECK: store {{.*}} @[[SWC]], i64 0, i64 3)
+  // CHECK: store {{.*}} @[[SWC]], i64 0, i64 1)
+}
+
+// CHECK: define internal void @__llvm_pgo_writeout()
+// CHECK: call void @llvm_pgo_emit({{.*}}, i32 3, i64* getelementptr inbounds ([3 x i64]* @[[IFC]], i64 0, i64 0))
+// CHECK: call void @llvm_pgo_emit({{.*}}, i32 7, i64* getelementptr inbounds ([7 x i64]* @[[LOOPC]], i64 0, i64 0))
+// CHECK: call void @llvm_pgo_emit({{.*}}, i32 4, i64* getelementptr inbounds ([4 x i64]* @[[SWC]], i64 0, i64 0))
+
+// CHECK: define internal void @__llvm_pgo_init()
+// CHECK: call void @llvm_pgo_register_writeout_function(void ()* @__llvm_pgo_writeout)
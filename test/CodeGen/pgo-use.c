@@ -0,0 +1,43 @@
+// Test that -fprofile-instr-use turns counts into branch weights.
+// RUN: %clang_cc1 -triple x86_64-unknown-unknown -emit-llvm -o - %s \
+// RUN:   -fprofile-instr-use=%S/Inputs/pgo-use.profdata | FileCheck %s
+// RUN: not %clang_cc1 -triple x86_64-unknown-unknown -emit-llvm -o - %s \
+// RUN:   -fprofile-instr-use=%t.missing 2>&1 | FileCheck -check-prefix=MISSING %s
+
+// MISSING: error: unable to read profile data
+
+// CHECK: define i32 @ifs(i32 %x){{.*}} inlinehint
+int ifs(int x) {
+  // CHECK: br i1 {{.*}}, !prof ![[IFW:[0-9]+]]
+  if (x)
+    return 1;
+  return 0;
+}
+
+// CHECK: define i32 @switches(i32 %x){{.*}} inlinehint
+int switches(int x) {
+  // CHECK: switch i32 {{.*}}
+  // CHECK: ], !prof ![[SWW:[0-9]+]]
+  switch (x) {
+  case 1:
+    return 10;
+  case 2:
+    return 20;
+  }
+  return 0;
+}
+
+// Functions the profile never entered are optimized for size.
+// CHECK: define void @never(){{.*}} optsize
+void never(void) {}
+
+// The counts of functions whose regions changed are ignored.
+// CHECK: define i32 @gone(i32 %x)
+// CHECK-NOT: !prof
+// CHECK: ret i32
+int gone(int x) {
+  return x ? 1 : x && 2;
+}
+
+// CHECK: ![[IFW]] = metadata !{metadata !"branch_weights", i32 8, i32 4}
+// CHECK: ![[SWW]] = metadata !{metadata !"branch_weights", i32 6, i32 11, i32 6}
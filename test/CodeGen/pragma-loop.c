@@ -0,0 +1,60 @@
+// RUN: %clang_cc1 -triple x86_64-apple-darwin -std=c99 -emit-llvm -o - %s | FileCheck %s
+// RUN: %clang_cc1 -std=c99 -ast-print %s | FileCheck -check-prefix=PRINT %s
+
+// The hints of a loop are attached to the branch back to its header.
+
+void while_test(int *a, int n) {
+  int i = 0;
+#pragma clang loop vectorize(enable)
+#pragma clang loop interleave_count(4) vectorize_width(4)
+  while (i < n) {
+    a[i] += 1;
+    i++;
+  }
+}
+// CHECK: define void @while_test
+// CHECK: br label %{{.*}}, !llvm.loop ![[WHILE:[0-9]+]]
+// CHECK: ret void
+
+void do_test(int *a, int n) {
+  int i = 0;
+#pragma clang loop unroll(disable)
+  do {
+    a[i] = 0;
+  } while (++i < n);
+}
+// CHECK: define void @do_test
+// CHECK: br i1 %{{.*}}, label %{{.*}}, label %{{.*}}, !llvm.loop ![[DO:[0-9]+]]
+// CHECK: ret void
+
+#define WIDTH 8
+void for_test(int *a, int n) {
+#pragma clang loop vectorize_width(WIDTH) unroll_count(2)
+  for (int i = 0; i < n; ++i)
+    a[i] = i;
+}
+// CHECK: define void @for_test
+// CHECK: br label %{{.*}}, !llvm.loop ![[FOR:[0-9]+]]
+// CHECK: ret void
+
+void plain(int *a, int n) {
+  for (int i = 0; i < n; ++i)
+    a[i] = 0;
+}
+// CHECK: define void @plain
+// CHECK-NOT: !llvm.loop
+// CHECK: ret void
+
+// CHECK: ![[WHILE]] = metadata !{metadata ![[WHILE]], metadata ![[W1:[0-9]+]], metadata ![[W2:[0-9]+]], metadata ![[W3:[0-9]+]]}
+// CHECK: ![[W1]] = metadata !{metadata !"llvm.loop.vectorize.width", i32 4}
+// CHECK: ![[W2]] = metadata !{metadata !"llvm.loop.interleave.count", i32 4}
+// CHECK: ![[W3]] = metadata !{metadata !"llvm.loop.vectorize.enable", i1 true}
+// CHECK: ![[DO]] = metadata !{metadata ![[DO]], metadata ![[D1:[0-9]+]]}
+// CHECK: ![[D1]] = metadata !{metadata !"llvm.loop.unroll.disable"}
+// CHECK: ![[FOR]] = metadata !{metadata ![[FOR]], metadata ![[F1:[0-9]+]], metadata ![[F2:[0-9]+]]}
+// CHECK: ![[F1]] = metadata !{metadata !"llvm.loop.unroll.count", i32 2}
+// CHECK: ![[F2]] = metadata !{metadata !"llvm.loop.vectorize.width", i32 8}
+
+// PRINT: #pragma clang loop unroll_count(2)
+// PRINT-NEXT: #pragma clang loop vectorize_width(8)
+// PRINT-NEXT: for (int i = 0; i < n; ++i)
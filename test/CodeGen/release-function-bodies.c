@@ -0,0 +1,33 @@
+// RUN: %clang_cc1 -triple x86_64-unknown-unknown -frelease-function-bodies -emit-llvm %s -o - | FileCheck %s
+// RUN: %clang_cc1 -triple x86_64-unknown-unknown -frelease-function-bodies -emit-llvm -print-stats %s -o /dev/null 2>&1 | FileCheck -check-prefix=STATS %s
+
+// Deferred until it is used, so its body is kept.
+static int twice(int x) { return x + x; }
+
+// CHECK: define i32 @f(i32 %x)
+// CHECK: call i32 @twice(
+int f(int x) {
+  int y = x * 3;
+  return twice(y);
+}
+
+int f(int x);
+
+// CHECK: define i32 @g(
+// CHECK: call i32 @f(i32 4)
+int g(void) {
+lbl:
+  return f(4);
+}
+
+// The static local can be used after the body.
+// CHECK: define i32* @counter()
+int *counter(void) {
+  static int n = 0;
+  return &n;
+}
+
+// CHECK: define internal i32 @twice(i32 %x)
+// CHECK: add nsw i32
+
+// STATS: 2 function bodies released ({{[0-9]+}} bytes), 2 kept ({{[0-9]+}} bytes)
@@ -0,0 +1,78 @@
+// RUN: %clang_cc1 -triple x86_64-unknown-unknown -std=c++11 -emit-llvm -o - %s | FileCheck %s
+
+// [[clang::likely]] and [[clang::unlikely]] weight the branches to the
+// statements they are attached to.
+
+extern "C" void f(int);
+extern "C" int error();
+
+extern "C" void if_likely(int x) {
+// CHECK: define void @if_likely
+// CHECK: br i1 %{{.*}}, label %{{.*}}, label %{{.*}}, !prof ![[LIKELY:[0-9]+]]
+  if (x) [[clang::likely]]
+    f(1);
+}
+
+extern "C" void else_unlikely(int x) {
+// CHECK: define void @else_unlikely
+// CHECK: br i1 %{{.*}}, label %{{.*}}, label %{{.*}}, !prof ![[LIKELY]]
+  if (x)
+    f(1);
+  else [[clang::unlikely]]
+    f(2);
+}
+
+extern "C" void if_unlikely(int x) {
+// CHECK: define void @if_unlikely
+// CHECK: br i1 %{{.*}}, label %{{.*}}, label %{{.*}}, !prof ![[UNLIKELY:[0-9]+]]
+  if (x) [[clang::unlikely]] {
+    f(1);
+  }
+}
+
+// Contradicting attributes are ignored.
+extern "C" void if_both(int x) {
+// CHECK: define void @if_both
+// CHECK-NOT: !prof
+// CHECK: ret void
+  if (x) [[clang::likely]]
+    f(1);
+  else [[clang::likely]]
+    f(2);
+}
+
+// An attribute on a case label applies to what the label leads to, and so
+// to the labels that share it.
+extern "C" int switch_cases(int x) {
+// CHECK: define i32 @switch_cases
+// CHECK: switch i32 %{{.*}}, label %{{.*}} [
+// CHECK: ], !prof ![[SWITCH:[0-9]+]]
+  switch (x) {
+  case 0:
+    return 1;
+  [[clang::unlikely]] case 1:
+  case 2:
+    return error();
+  case 3: [[clang::likely]]
+    return 3;
+  default:
+    return 0;
+  }
+}
+
+// A switch without attributes is not weighted.
+extern "C" int switch_plain(int x) {
+// CHECK: define i32 @switch_plain
+// CHECK-NOT: !prof
+// CHECK: ret i32
+  switch (x) {
+  case 0:
+    return 1;
+  default:
+    return 0;
+  }
+}
+
+// CHECK: ![[LIKELY]] = metadata !{metadata !"branch_weights", i32 64, i32 4}
+// CHECK: ![[UNLIKELY]] = metadata !{metadata !"branch_weights", i32 4, i32 64}
+// CHECK: ![[SWITCH]] = metadata !{metadata !"branch_weights", i32 16, i32 16, i32 4, i32 4, i32 64}
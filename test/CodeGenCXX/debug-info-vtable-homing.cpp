@@ -0,0 +1,22 @@
+// RUN: %clang_cc1 -emit-llvm -g -fdebug-vtable-homing -triple x86_64-none-linux-gnu %s -o - | FileCheck %s
+// RUN: %clang_cc1 -emit-llvm -g -fdebug-vtable-homing -triple x86_64-none-linux-gnu %s -o - | FileCheck -check-prefix=HERE %s
+// RUN: %clang_cc1 -emit-llvm -g -fdebug-vtable-homing -triple x86_64-none-linux-gnu %s -o - | FileCheck -check-prefix=NOKEY %s
+// RUN: %clang_cc1 -emit-llvm -g -triple x86_64-none-linux-gnu %s -o - | FileCheck -check-prefix=DEFAULT %s
+
+// The vtable of Elsewhere is emitted by the translation unit which defines
+// Elsewhere::f, so only a declaration of the class is emitted here.
+struct Elsewhere { virtual void f(); int i; };
+Elsewhere e;
+
+struct Here { virtual void f(); int i; };
+void Here::f() {}
+Here h;
+
+struct NoKey { virtual void f() {} int i; };
+NoKey n;
+
+// CHECK: metadata !"Elsewhere", metadata !{{[0-9]+}}, i32 8, i64 0, i64 0, i32 0, i32 4, {{.*}} ; [ DW_TAG_class_type ]
+// CHECK-NOT: metadata !"Elsewhere", metadata !{{[0-9]+}}, i32 8, i64 128
+// HERE: metadata !"Here", metadata !{{[0-9]+}}, i32 11, i64 128, i64 64, i32 0, i32 0, {{.*}} ; [ DW_TAG_class_type ]
+// NOKEY: metadata !"NoKey", metadata !{{[0-9]+}}, i32 15, i64 128, i64 64, i32 0, i32 0, {{.*}} ; [ DW_TAG_class_type ]
+// DEFAULT: metadata !"Elsewhere", metadata !{{[0-9]+}}, i32 8, i64 128, i64 64, i32 0, i32 0, {{.*}} ; [ DW_TAG_class_type ]
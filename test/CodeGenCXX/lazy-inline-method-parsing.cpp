@@ -0,0 +1,12 @@
+// RUN: %clang_cc1 -triple x86_64-apple-darwin10 -flazy-inline-method-parsing -emit-llvm -o - %s | FileCheck %s
+
+struct S {
+  int used() { return 1; }
+  int unused() { return 2; }
+};
+
+int f() { return S().used(); }
+
+// CHECK: define i32 @_Z1fv()
+// CHECK: define linkonce_odr i32 @_ZN1S4usedEv(
+// CHECK-NOT: _ZN1S6unusedEv
@@ -0,0 +1,34 @@
+// RUN: %clang_cc1 -triple x86_64-unknown-unknown -emit-llvm -o - %s | FileCheck %s
+
+// The mangling of a class template specialization is reused by later names
+// only when the substitutions made before it do not change it.
+
+namespace std {
+  template<typename T> struct allocator { };
+  template<typename T, typename A = allocator<T> > struct vector { };
+}
+
+template<typename T, typename U> struct Pair { };
+struct A { };
+
+// CHECK: define void @_Z1f4PairI1AS0_E(
+void f(Pair<A, A>) { }
+// CHECK: define void @_Z1g4PairI1AS0_E(
+void g(Pair<A, A>) { }
+// CHECK: define void @_Z1h1A4PairIS_S_E(
+void h(A, Pair<A, A>) { }
+// CHECK: define void @_Z1iPi4PairI1AS1_E(
+void i(int *, Pair<A, A>) { }
+// CHECK: define void @_Z1j4PairI1AS0_ES1_(
+void j(Pair<A, A>, Pair<A, A>) { }
+// CHECK: define void @_Z1kPi4PairI1AS1_ES2_(
+void k(int *, Pair<A, A>, Pair<A, A>) { }
+
+// CHECK: define void @_Z1lSt6vectorI1ASaIS0_EE(
+void l(std::vector<A>) { }
+// CHECK: define void @_Z1mPiSt6vectorI1ASaIS1_EE(
+void m(int *, std::vector<A>) { }
+// CHECK: define void @_Z1nP1ASt6vectorIS_SaIS_EE(
+void n(A *, std::vector<A>) { }
+// CHECK: define void @_Z1oSt6vectorI1ASaIS0_EES2_(
+void o(std::vector<A>, std::vector<A>) { }
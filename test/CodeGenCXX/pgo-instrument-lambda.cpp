@@ -0,0 +1,31 @@
+// Test that -fprofile-instr-generate counts the regions of a lambda in the
+// lambda's call operator, and not in the function that contains it.
+// RUN: %clang_cc1 -triple x86_64-unknown-unknown -std=c++11 -emit-llvm -o - \
+// RUN:   %s -fprofile-instr-generate | FileCheck %s
+
+// CHECK: @[[OUTERC:__llvm_pgo_ctr[0-9]*]] = internal global [3 x i64] zeroinitializer
+// CHECK: @[[LAMBDAC:__llvm_pgo_ctr[0-9]*]] = internal global [5 x i64] zeroinitializer
+
+// CHECK: define i32 @_Z5outeri(
+int outer(int x) {
+  // CHECK: store {{.*}} @[[OUTERC]], i64 0, i64 0)
+  auto f = [](int y) -> int {
+    if (y)
+      return 1;
+    if (y > 1)
+      return 2;
+    return 0;
+  };
+  if (x)
+    return f(x);
+  return 0;
+  // CHECK: store {{.*}} @[[OUTERC]], i64 0, i64 1)
+  // CHECK: store {{.*}} @[[OUTERC]], i64 0, i64 2)
+}
+
+// CHECK: define {{.*}}clEi(
+// CHECK: store {{.*}} @[[LAMBDAC]], i64 0, i64 0)
+// CHECK: store {{.*}} @[[LAMBDAC]], i64 0, i64 1)
+// CHECK: store {{.*}} @[[LAMBDAC]], i64 0, i64 2)
+// CHECK: store {{.*}} @[[LAMBDAC]], i64 0, i64 3)
+// CHECK: store {{.*}} @[[LAMBDAC]], i64 0, i64 4)
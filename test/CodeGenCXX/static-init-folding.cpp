@@ -0,0 +1,68 @@
+// RUN: %clang_cc1 -triple x86_64-unknown-unknown -emit-llvm -o - %s | FileCheck %s
+// RUN: %clang_cc1 -triple x86_64-unknown-unknown -emit-llvm-only \
+// RUN:   -Wdynamic-initializers -verify %s
+
+// Initializers which call constructors and functions that are not constexpr
+// are folded when those could have been constexpr.
+
+struct Point {
+  Point(int x, int y) : x(x), y(y) {}
+  int x, y;
+};
+inline int twice(int i) { return i + i; }
+
+// CHECK: @p = global %struct.Point { i32 1, i32 2 }
+Point p(1, 2);
+// CHECK: @q = global %struct.Point { i32 6, i32 8 }
+Point q(twice(3), twice(4));
+
+struct Line {
+  Line() : from(0, 0), to(1, 1) {}
+  Point from, to;
+};
+// CHECK: @l = global %struct.Line { {{.*}}, %struct.Point { i32 1, i32 1 } }
+Line l;
+
+struct Counted {
+  Counted() : n(0) {}
+  ~Counted();
+  int n;
+};
+// CHECK: @c = global %struct.Counted zeroinitializer
+Counted c;
+
+// Initializers with side effects still run dynamically.
+int next();
+struct Logged {
+  Logged() : n(0) { next(); }
+  int n;
+};
+Logged g; // expected-warning {{'g' is initialized by a global constructor}}
+Point r(next(), 0); // expected-warning {{'r' is initialized by a global constructor}}
+
+inline int square(int i) { int s = i * i; return s; }
+int sq = square(3); // expected-warning {{'sq' is initialized by a global constructor}}
+
+// Variables whose definitions the linker may discard are initialized under a
+// guard, and are never folded: another translation unit might not fold them.
+template<typename T> struct S { static Point p; };
+template<typename T>
+Point S<T>::p(5, 6); // expected-warning {{'p' is initialized by a global constructor}}
+Point *sp = &S<int>::p;
+
+inline Point *local() { static Point lp(7, 8); return &lp; }
+Point *getLocal() { return local(); }
+
+// CHECK: @_ZN1SIiE1pE = weak_odr global %struct.Point zeroinitializer
+// CHECK: @_ZZ5localvE2lp = linkonce_odr global %struct.Point zeroinitializer
+
+// CHECK: define internal void @__cxx_global_var_init()
+// CHECK-NOT: call
+// CHECK: call i32 @__cxa_atexit({{.*}}@_ZN7CountedD1Ev{{.*}}@c
+// CHECK: define internal void @__cxx_global_var_init1()
+// CHECK: call void @_ZN6LoggedC1Ev(%struct.Logged* @g)
+// CHECK: define internal void @__cxx_global_var_init2()
+// CHECK: call i32 @_Z4nextv()
+// CHECK: call void @_ZN5PointC1Eii(%struct.Point* @r
+// CHECK: define internal void @__cxx_global_var_init3()
+// CHECK: call i32 @_Z6squarei(i32 3)
@@ -1,4 +1,5 @@
 // RUN: %clang_cc1 -triple x86_64-apple-darwin10 -emit-llvm -fblocks -fobjc-arc -fobjc-runtime-has-weak -O2 -disable-llvm-optzns -o - %s | FileCheck %s
+// RUN: %clang_cc1 -triple x86_64-apple-darwin10 -emit-llvm -fblocks -fobjc-arc -fobjc-runtime-has-weak -O2 -disable-llvm-optzns -DNO_TEST4 -o - %s | FileCheck -check-prefix=TEST6 %s
 
 // This shouldn't crash.
 void test0(id (^maker)(void)) {
@@ -82,6 +83,9 @@ void test3(void (^sink)(id*)) {
 
 }
 
+// Without test4, whose block shares its copy and dispose helpers with the
+// block of test6, test6 emits the helpers itself.
+#ifndef NO_TEST4
 void test4(void) {
   id test4_source(void);
   void test4_helper(void (^)(void));
@@ -137,6 +141,7 @@ void test4(void) {
   // CHECK:    define internal void @__destroy_helper_block_
   // CHECK:      call void @_Block_object_dispose(i8* {{%.*}}, i32 8)
 }
+#endif
 
 void test5(void) {
   extern id test5_source(void);
@@ -205,13 +210,20 @@ void test6(void) {
   // CHECK-NEXT: call i8* @objc_storeWeak(i8** [[SLOT]], i8* null)
   // CHECK-NEXT: ret void
 
-  // CHECK:    define internal void @__copy_helper_block_
+  // The block copies its capture with FIELD_IS_BYREF, and no FIELD_IS_WEAK
+  // because clang is in control, like the block of test4 does, so it shares
+  // the copy and dispose helpers of that block.
+  // CHECK-NOT:  define internal void @__copy_helper_block_
+  // CHECK-NOT:  define internal void @__destroy_helper_block_
+
+  // TEST6:    define internal void @__test6_block_invoke
+  // TEST6:    define internal void @__copy_helper_block_
   // 0x8 - FIELD_IS_BYREF (no FIELD_IS_WEAK because clang in control)
-  // CHECK:      call void @_Block_object_assign(i8* {{%.*}}, i8* {{%.*}}, i32 8)
+  // TEST6:      call void @_Block_object_assign(i8* {{%.*}}, i8* {{%.*}}, i32 8)
 
-  // CHECK:    define internal void @__destroy_helper_block_
+  // TEST6:    define internal void @__destroy_helper_block_
   // 0x8 - FIELD_IS_BYREF (no FIELD_IS_WEAK because clang in control)
-  // CHECK:      call void @_Block_object_dispose(i8* {{%.*}}, i32 8)
+  // TEST6:      call void @_Block_object_dispose(i8* {{%.*}}, i32 8)
 }
 
 void test7(void) {
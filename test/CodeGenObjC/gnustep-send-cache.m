@@ -0,0 +1,54 @@
+// RUN: %clang_cc1 -triple x86_64-unknown-freebsd -fobjc-runtime=gnustep-1.7 -fobjc-send-cache -emit-llvm -o - %s | FileCheck %s
+// RUN: %clang_cc1 -triple x86_64-unknown-freebsd -fobjc-runtime=gnustep-1.7 -emit-llvm -o - %s | FileCheck -check-prefix=NOCACHE %s
+
+// CHECK: @.objc_send_cache = internal thread_local global { i8*, {{.*}}, i32 } zeroinitializer
+// CHECK: @objc_method_cache_version = external global i32
+
+// NOCACHE-NOT: objc_send_cache
+// NOCACHE-NOT: objc_method_cache_version
+
+@interface A
+- (int) value;
+@end
+
+// CHECK: define i32 @get(
+int get(A *a) {
+  // Receivers which are nil or small objects skip the cache.
+  // CHECK:      [[INT:%.*]] = ptrtoint i8* {{%.*}} to i64
+  // CHECK:      and i64 [[INT]], 7
+  // CHECK:      br i1 {{%.*}}, label %[[CHECK:send.cache.check[0-9]*]], label %[[MISS:send.cache.miss[0-9]*]]
+
+  // CHECK:    [[CHECK]]:
+  // CHECK:      [[ISA:%.*]] = load i8** {{%.*}}
+  // CHECK:      [[CACHED:%.*]] = load i8** getelementptr inbounds ({{.*}} @.objc_send_cache, i32 0, i32 0)
+  // CHECK:      load i32* getelementptr inbounds ({{.*}} @.objc_send_cache, i32 0, i32 2)
+  // CHECK:      load i32* @objc_method_cache_version
+  // CHECK:      icmp eq i8* [[ISA]], [[CACHED]]
+  // CHECK:      br i1 {{%.*}}, label %[[HIT:send.cache.hit[0-9]*]], label %[[MISS]]
+
+  // CHECK:    [[HIT]]:
+  // CHECK:      load {{.*}} getelementptr inbounds ({{.*}} @.objc_send_cache, i32 0, i32 1)
+
+  // CHECK:    [[MISS]]:
+  // CHECK:      load i32* @objc_method_cache_version
+  // CHECK:      call {{.*}} @objc_msg_lookup_sender(
+  // CHECK:      br i1 {{%.*}}, label %[[FILL:send.cache.fill[0-9]*]], label %[[CONT:send.cache.cont[0-9]*]]
+
+  // CHECK:    [[FILL]]:
+  // CHECK:      store {{.*}} @.objc_send_cache, i32 0, i32 0)
+  // CHECK:      store {{.*}} @.objc_send_cache, i32 0, i32 1)
+  // CHECK:      store {{.*}} @.objc_send_cache, i32 0, i32 2)
+
+  // CHECK:    [[CONT]]:
+  // CHECK:      [[RESULT:%.*]] = phi
+  // CHECK:      getelementptr inbounds {{.*}} [[RESULT]], i32 0, i32 4
+  return [a value];
+}
+
+// Each call site has a cache of its own.
+// CHECK: define i32 @get2(
+// CHECK: @.objc_send_cache1
+// CHECK: @.objc_send_cache2
+int get2(A *a) {
+  return [a value] + [a value];
+}
@@ -0,0 +1 @@
+#warning first input
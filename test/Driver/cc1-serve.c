@@ -0,0 +1,16 @@
+// RUN: printf '%%s\n' -fsyntax-only %s '' -fsyntax-only -DBROKEN %s '' \
+// RUN:   '#invalidate' '' -fsyntax-only -mllvm -debug-pass=Structure %s '' \
+// RUN:   | %clang -cc1serve 2>&1 | FileCheck %s
+
+// CHECK: warning: compiled by the server
+// CHECK: exit 0
+// CHECK: error: broken
+// CHECK: exit 1
+// CHECK: exit 0
+// CHECK: error: -mllvm options are not supported by the compile server
+// CHECK: exit 1
+
+#warning compiled by the server
+#ifdef BROKEN
+#error broken
+#endif
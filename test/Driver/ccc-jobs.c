@@ -0,0 +1,14 @@
+// Check that independent commands can run in parallel, with their diagnostics
+// printed in command order.
+//
+// RUN: %clang -ccc-jobs 2 -fsyntax-only %S/Inputs/ccc-jobs/first.c \
+// RUN:   %S/Inputs/ccc-jobs/second.c 2>&1 | FileCheck %s
+// CHECK: first.c:1:2: warning: first input
+// CHECK: second.c:1:2: warning: second input
+
+// RUN: %clang -ccc-jobs 0 -fsyntax-only %S/Inputs/ccc-jobs/first.c \
+// RUN:   %S/Inputs/ccc-jobs/second.c 2>&1 | FileCheck %s
+
+// RUN: %clang -ccc-jobs foo -fsyntax-only %s 2>&1 \
+// RUN:   | FileCheck -check-prefix=INVALID %s
+// INVALID: invalid integral value 'foo' in '-ccc-jobs foo'
@@ -0,0 +1,26 @@
+// Check that the object files and diagnostics of compilations are cached, and
+// that changing a header they include invalidates the cache.
+//
+// RUN: rm -rf %t && mkdir -p %t
+// RUN: echo '#warning first header' > %t/header.h
+// RUN: %clang -ccc-cache-dir %t/cache -I%t -c %s -o %t/out.o 2>&1 \
+// RUN:   | FileCheck -check-prefix=FIRST %s
+// RUN: ls %t/cache | count 2
+//
+// A hit restores the object file and replays the diagnostics.
+// RUN: rm %t/out.o
+// RUN: %clang -ccc-cache-dir %t/cache -I%t -c %s -o %t/out.o 2>&1 \
+// RUN:   | FileCheck -check-prefix=FIRST %s
+// RUN: test -f %t/out.o
+// RUN: ls %t/cache | count 2
+// RUN: grep "^dep .*header.h$" %t/cache/* | count 1
+//
+// RUN: echo '#warning second header' > %t/header.h
+// RUN: %clang -ccc-cache-dir %t/cache -I%t -c %s -o %t/out.o 2>&1 \
+// RUN:   | FileCheck -check-prefix=SECOND %s
+// RUN: ls %t/cache | count 3
+//
+// FIRST: header.h:1:2: warning: first header
+// SECOND: header.h:1:2: warning: second header
+
+#include "header.h"
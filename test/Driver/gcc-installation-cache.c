@@ -0,0 +1,36 @@
+// Test that the detected GCC installation is cached, and detected again once
+// the directories it was found in change.
+//
+// RUN: rm -rf %t && mkdir -p %t
+// RUN: cp -R %S/Inputs/basic_linux_tree %t/tree
+// RUN: touch -t 200001010000 %t/tree/usr/lib/gcc/x86_64-unknown-linux
+// RUN: env CLANG_GCC_INSTALLATION_CACHE=%t/cache \
+// RUN:   %clang -no-canonical-prefixes %s -### -o %t.o 2>&1 \
+// RUN:     -target x86_64-unknown-linux --sysroot=%t/tree \
+// RUN:   | FileCheck --check-prefix=CHECK-460 %s
+// RUN: FileCheck --check-prefix=CHECK-CACHE %s < %t/cache
+//
+// The cached installation is used as is.
+// RUN: sed -e '/^install-path/s/4\.6\.0$/4.6.1/' %t/cache > %t/cache.edited
+// RUN: mv %t/cache.edited %t/cache
+// RUN: env CLANG_GCC_INSTALLATION_CACHE=%t/cache \
+// RUN:   %clang -no-canonical-prefixes %s -### -o %t.o 2>&1 \
+// RUN:     -target x86_64-unknown-linux --sysroot=%t/tree \
+// RUN:   | FileCheck --check-prefix=CHECK-461 %s
+//
+// RUN: mkdir %t/tree/usr/lib/gcc/x86_64-unknown-linux/4.7.0
+// RUN: touch %t/tree/usr/lib/gcc/x86_64-unknown-linux/4.7.0/crtbegin.o
+// RUN: env CLANG_GCC_INSTALLATION_CACHE=%t/cache \
+// RUN:   %clang -no-canonical-prefixes %s -### -o %t.o 2>&1 \
+// RUN:     -target x86_64-unknown-linux --sysroot=%t/tree \
+// RUN:   | FileCheck --check-prefix=CHECK-470 %s
+//
+// CHECK-460: "{{.*}}/usr/lib/gcc/x86_64-unknown-linux/4.6.0/crtbegin.o"
+// CHECK-CACHE: clang-gcc-installation-cache 1
+// CHECK-CACHE: entry {{.*}} x86_64-unknown-linux
+// CHECK-CACHE: valid 1
+// CHECK-CACHE: install-path {{.*}}/usr/lib/gcc/x86_64-unknown-linux/4.6.0
+// CHECK-CACHE: dir {{[0-9]+}} {{.*}}/usr/lib/gcc/x86_64-unknown-linux
+// CHECK-CACHE: end
+// CHECK-461: "{{.*}}/usr/lib/gcc/x86_64-unknown-linux/4.6.1/crtbegin.o"
+// CHECK-470: "{{.*}}/usr/lib/gcc/x86_64-unknown-linux/4.7.0/crtbegin.o"
@@ -0,0 +1,16 @@
+// RUN: %clang -integrated-cc1 -fsyntax-only %s 2>&1 | FileCheck %s
+// RUN: %clang -integrated-cc1 -no-integrated-cc1 -fsyntax-only %s 2>&1 \
+// RUN:   | FileCheck %s
+// RUN: %clang -integrated-cc1 -c %s -o %t.o 2>&1 | FileCheck %s
+// RUN: test -f %t.o
+// -mllvm options are global to the process, so those commands run out of
+// process and each parses its options once.
+// RUN: %clang -integrated-cc1 -fsyntax-only -mllvm -inline-threshold=100 \
+// RUN:   %s %s 2>&1 | FileCheck %s -check-prefix=MLLVM
+// CHECK-NOT: argument unused
+// CHECK: warning: compiled in process
+// MLLVM-NOT: may only occur
+// MLLVM: warning: compiled in process
+// MLLVM-NOT: may only occur
+// MLLVM: warning: compiled in process
+#warning compiled in process
@@ -0,0 +1,4 @@
+#include "header-cost-b.h"
+#define A_TYPE int
+A_TYPE a1;
+A_TYPE a2;
@@ -0,0 +1 @@
+struct B { int x; };
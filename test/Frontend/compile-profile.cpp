@@ -0,0 +1,25 @@
+// RUN: %clang_cc1 -O1 -emit-llvm -o %t.ll -compile-profile-file %t.json %s
+// RUN: FileCheck %s < %t.json
+// RUN: %clang_cc1 -E -o %t.i -compile-profile-file %t-pp.json %s
+// RUN: FileCheck -check-prefix=PP %s < %t-pp.json
+
+template<typename T> T twice(T t) { return t + t; }
+int f(int i) { return twice(i); }
+
+// CHECK: "file": "{{.*}}compile-profile.cpp",
+// CHECK: "phases": [
+// CHECK-NOT: "preprocessing"
+// CHECK: { "name": "frontend", "total": {{[0-9.]+}}, "self": {{[0-9.]+}}, "count": 1 },
+// CHECK: { "name": "template_instantiation", {{.*}}, "count": 1 },
+// CHECK: { "name": "ir_generation",
+// CHECK: { "name": "function_passes",
+// CHECK: { "name": "module_passes", {{.*}}, "count": 1 }
+// CHECK: ],
+// CHECK: "ir": {
+// CHECK: "before_optimization": { "functions": 2, "basic_blocks": {{[1-9][0-9]*}}, "instructions": {{[1-9][0-9]*}} },
+// CHECK: "after_optimization": { "functions": 2,
+
+// PP: "phases": [
+// PP: { "name": "preprocessing", {{.*}}, "count": 1 }
+// PP-NEXT: ]
+// PP-NOT: "ir"
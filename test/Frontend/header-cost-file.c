@@ -0,0 +1,22 @@
+// RUN: rm -f %t
+// RUN: %clang_cc1 -fsyntax-only -I %S/Inputs -header-cost-file %t %s
+// RUN: %clang_cc1 -E -I %S/Inputs -header-cost-file %t %s -o /dev/null
+// RUN: FileCheck %s < %t
+
+#include "header-cost-a.h"
+int main_decl;
+
+// CHECK: {"file": "{{.*}}header-cost-file.c", "headers": [
+// CHECK: {"name": "{{.*}}header-cost-file.c", "includes": 1,
+// CHECK: "inclusive": { "tokens": {{[0-9]+}}, "macro_expansions": 2, "decls": 5,
+// CHECK: {"name": "<built-in>", "includes": 1,
+// CHECK: {"name": "{{.*}}header-cost-a.h", "includes": 1,
+// CHECK: "exclusive": { "tokens": {{[0-9]+}}, "macro_expansions": 2, "decls": 2, "deserialized_decls": 0,
+// CHECK: "inclusive": { "tokens": {{[0-9]+}}, "macro_expansions": 2, "decls": 4,
+// CHECK: {"name": "{{.*}}header-cost-b.h", "includes": 1,
+// CHECK: "exclusive": { "tokens": 8, "macro_expansions": 0, "decls": 2,
+
+// Preprocessing alone counts no declarations.
+// CHECK: {"file": "{{.*}}header-cost-file.c", "headers": [
+// CHECK: {"name": "{{.*}}header-cost-b.h", "includes": 1,
+// CHECK: "exclusive": { "tokens": 8, "macro_expansions": 0, "decls": 0,
@@ -0,0 +1,33 @@
+// RUN: %clang_cc1 %s -O2 -gline-tables-only -Rpass=inline -emit-obj \
+// RUN:   -o /dev/null 2>&1 | FileCheck %s
+// RUN: %clang_cc1 %s -O2 -Rpass=inline -emit-obj -o /dev/null 2>&1 \
+// RUN:   | FileCheck -check-prefix=NODEBUG %s
+// RUN: %clang_cc1 %s -O0 -gline-tables-only -Rpass=inline -emit-obj \
+// RUN:   -o /dev/null 2>&1 | FileCheck -check-prefix=O0 %s
+// RUN: %clang_cc1 %s -O2 -gline-tables-only -Rpass=loop -emit-obj \
+// RUN:   -o /dev/null 2>&1 | FileCheck -check-prefix=OTHER %s
+// RUN: not %clang_cc1 %s -Rpass='(' -fsyntax-only 2>&1 \
+// RUN:   | FileCheck -check-prefix=BADREGEX %s
+
+static int small(int x) { return x + 1; }
+
+__attribute__((noinline)) int never(int x) { return x * 3; }
+
+int caller(int x) {
+  return small(x) + never(x);
+}
+
+// CHECK: optimization-remark.c:17:10: remark: small inlined into caller
+// CHECK: optimization-remark.c:17:21: remark: never not inlined into caller because it is marked noinline
+
+// NODEBUG: remark: inlined calls are only reported with -gline-tables-only or -g
+// NODEBUG: remark: never not inlined into caller because it is marked noinline
+
+// Without the inliner, no call was found too costly.
+// O0-NOT: too costly
+// O0: optimization-remark.c:17:21: remark: never not inlined into caller because it is marked noinline
+// O0-NOT: too costly
+
+// OTHER-NOT: remark:
+
+// BADREGEX: error: {{.*}} in '-Rpass=('
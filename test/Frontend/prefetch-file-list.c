@@ -0,0 +1,11 @@
+// RUN: echo "%S/Inputs/test.h" > %t.list
+// RUN: echo "%S/Inputs/does-not-exist.h" >> %t.list
+// RUN: %clang_cc1 -fsyntax-only -verify -prefetch-file-list %t.list %s
+// RUN: not %clang_cc1 -fsyntax-only -prefetch-file-list %t.missing %s 2>&1 \
+// RUN:   | FileCheck %s
+
+// Prefetched files, and files in the list that do not exist, do not change
+// the result of the compilation.
+#include "Inputs/test.h"
+
+// CHECK: error reading '{{.*}}.missing'
@@ -0,0 +1,11 @@
+// RUN: %clang_cc1 -rewrite-test %s -o - | FileCheck %s
+
+// Every tag the rewriter inserts gets a fresh scratch location, even when the
+// same tag was inserted before; the tags around these two comments are
+// identical.
+
+/* first */ int a;
+/* second */ int b;
+
+// CHECK: <i>/* first */</i> int a;
+// CHECK: <i>/* second */</i> int b;
@@ -0,0 +1,44 @@
+// RUN: rm -rf %t.dir
+// RUN: mkdir -p %t.dir
+// RUN: echo '#define FROM_A 1' > %t.dir/a.h
+// RUN: echo 'int b;' > %t.dir/b.h
+// RUN: echo 'int c;' > %t.dir/c.h
+// RUN: echo 'int d;' > %t.dir/d.h
+// RUN: %clang_cc1 -std=c++11 -scan-dependencies -I %t.dir -MT scan.o \
+// RUN:   -dependency-file - %s | FileCheck %s
+// RUN: %clang_cc1 -std=c++11 -scan-dependencies -I %t.dir -MT scan.o \
+// RUN:   -dependency-file %t.scan.d %s
+// RUN: %clang_cc1 -std=c++11 -Eonly -I %t.dir -MT scan.o \
+// RUN:   -dependency-file %t.eonly.d %s
+// RUN: diff %t.eonly.d %t.scan.d
+
+#include "a.h"
+const char *s = "/* not a comment";
+#include "b.h"
+/*
+#include "not-included.h"
+*/
+int x = 1 + \
+#include "not-included.h"
+  2;
+const char *r = R"delim(
+#include "not-included.h"
+)delim";
+  #if FROM_A
+    # include "c.h"
+  #else
+#include "not-included.h"
+#endif
+#define HEADER "d.h"
+#include HEADER
+
+// CHECK: scan.o:
+// CHECK-NOT: not-included.h
+// CHECK: a.h
+// CHECK-NOT: not-included.h
+// CHECK: b.h
+// CHECK-NOT: not-included.h
+// CHECK: c.h
+// CHECK-NOT: not-included.h
+// CHECK: d.h
+// CHECK-NOT: not-included.h
@@ -0,0 +1,3 @@
+#include "a.h"
+
+A second_tu;
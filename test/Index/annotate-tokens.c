@@ -34,6 +34,7 @@ enum Color g(int i, ...) {
 }
 
 // RUN: c-index-test -test-annotate-tokens=%s:4:1:34:1 %s | FileCheck %s
+// RUN: env CINDEXTEST_TOKENIZE_AND_ANNOTATE=1 c-index-test -test-annotate-tokens=%s:4:1:34:1 %s | FileCheck %s
 // CHECK: Identifier: "T" [4:3 - 4:4] TypeRef=T:1:13
 // CHECK: Punctuation: "*" [4:4 - 4:5] VarDecl=t_ptr:4:6 (Definition)
 // CHECK: Identifier: "t_ptr" [4:6 - 4:11] VarDecl=t_ptr:4:6 (Definition)
@@ -0,0 +1,11 @@
+struct Point { int x, y; };
+
+int length(struct Point p) {
+  return p.x + p.y;
+}
+
+// RUN: c-index-test -code-completion-benchmark=%s %s | FileCheck -check-prefix=CHECK-ALL %s
+// CHECK-ALL: Completed at 10 positions: {{[0-9]+}} results in
+
+// RUN: env CINDEXTEST_COMPLETION_PREFIX_LENGTH=1 CINDEXTEST_COMPLETION_STRIDE=3 c-index-test -code-completion-benchmark=%s %s | FileCheck -check-prefix=CHECK-STRIDE %s
+// CHECK-STRIDE: Completed at 4 positions: {{[0-9]+}} results in
@@ -0,0 +1,17 @@
+// RUN: rm -rf %t.cache
+// RUN: env LIBCLANG_PREAMBLE_CACHE=%t.cache CINDEXTEST_EDITING=1 CINDEXTEST_COMPLETION_CACHING=1 c-index-test -code-completion-at=%s:10:1 -I%S/Inputs %s | FileCheck %s
+// RUN: ls %t.cache | FileCheck -check-prefix CHECK-ENTRY %s
+// RUN: env LIBCLANG_PREAMBLE_CACHE=%t.cache CINDEXTEST_EDITING=1 CINDEXTEST_COMPLETION_CACHING=1 c-index-test -code-completion-at=%s:10:1 -I%S/Inputs %s | FileCheck %s
+#include "a.h"
+#include "b.h"
+
+void local_function(A a, B b);
+void f() {
+
+}
+
+// CHECK: TypedefDecl:{TypedText A}
+// CHECK: macro definition:{TypedText A_H}
+// CHECK: TypedefDecl:{TypedText B}
+// CHECK: FunctionDecl:{ResultType void}{TypedText local_function}{LeftParen (}{Placeholder A a}{Comma , }{Placeholder B b}{RightParen )}
+// CHECK-ENTRY: .completions
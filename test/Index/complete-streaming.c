@@ -0,0 +1,30 @@
+// Note: the run lines follow their respective tests, since line/column
+// matter in this test.
+
+struct Point { int x, y, xx; };
+
+void f(struct Point p) {
+  p.x;
+}
+
+// RUN: env CINDEXTEST_COMPLETION_PREFIX=X c-index-test -code-completion-at=%s:7:5 %s | FileCheck -check-prefix=CHECK-PREFIX %s
+// CHECK-PREFIX-NOT: {TypedText y}
+// CHECK-PREFIX: FieldDecl:{ResultType int}{TypedText x}
+// CHECK-PREFIX-NOT: {TypedText y}
+// CHECK-PREFIX: FieldDecl:{ResultType int}{TypedText xx}
+// CHECK-PREFIX-NOT: {TypedText y}
+
+// RUN: env CINDEXTEST_COMPLETION_BATCH_SIZE=2 c-index-test -code-completion-at=%s:7:5 %s | FileCheck -check-prefix=CHECK-BATCH %s
+// CHECK-BATCH: Completion batch: 2 results
+// CHECK-BATCH-NEXT: Completion batch: 1 results
+// CHECK-BATCH: FieldDecl:{ResultType int}{TypedText x}
+// CHECK-BATCH: FieldDecl:{ResultType int}{TypedText xx}
+// CHECK-BATCH: FieldDecl:{ResultType int}{TypedText y}
+
+// RUN: env CINDEXTEST_COMPLETION_BATCH_SIZE=2 CINDEXTEST_COMPLETION_CANCEL_AFTER=1 c-index-test -code-completion-at=%s:7:5 %s | FileCheck -check-prefix=CHECK-CANCEL %s
+// CHECK-CANCEL: Completion batch: 2 results
+// CHECK-CANCEL-NEXT: Cancelled code completion
+// CHECK-CANCEL-NOT: Completion batch
+// CHECK-CANCEL: FieldDecl:{ResultType int}
+// CHECK-CANCEL: FieldDecl:{ResultType int}
+// CHECK-CANCEL-NOT: FieldDecl
@@ -102,3 +102,22 @@ void f() {
 // CHECK-NEXT: TypeRef=Cake:39:11 =[44:14 - 44:18]
 
 // RUN:   %s | FileCheck %s
+
+struct Base {
+  virtual void vm();
+};
+struct Derived : Base {
+  void vm();
+};
+void test_vm(Base *b, Derived *d) {
+  b->vm();
+  d->vm();
+}
+
+// References to a method include those to the methods it overrides.
+// RUN: c-index-test -file-refs-at=%s:110:8 %s | FileCheck -check-prefix=VIRT %s
+// VIRT:      CXXMethod=vm:110:8
+// VIRT-NEXT: CXXMethod=vm:107:16 (virtual) =[107:16 - 107:18]
+// VIRT-NEXT: CXXMethod=vm:110:8 {{.*}}=[110:8 - 110:10]
+// VIRT-NEXT: MemberRefExpr=vm:107:16 =[113:6 - 113:8]
+// VIRT-NEXT: MemberRefExpr=vm:110:8 =[114:6 - 114:8]
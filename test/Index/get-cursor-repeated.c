@@ -0,0 +1,34 @@
+struct Point {
+  int x, y;
+};
+
+int length(struct Point *p) {
+  return p->x + p->y;
+}
+
+// Looking up the same tokens again, possibly from another column within the
+// token, finds the same cursors.
+// RUN: c-index-test -cursor-at=%s:6:13 \
+// RUN:              -cursor-at=%s:5:5 \
+// RUN:              -cursor-at=%s:1:10 \
+// RUN:              -cursor-at=%s:5:9 \
+// RUN:              -cursor-at=%s:1:8 \
+// RUN:              -cursor-at=%s:6:20 \
+// RUN:              -cursor-at=%s:2:7 \
+// RUN:       %s | FileCheck %s
+// RUN: env CINDEXTEST_EDITING=1 c-index-test -cursor-at=%s:6:13 \
+// RUN:              -cursor-at=%s:5:5 \
+// RUN:              -cursor-at=%s:1:10 \
+// RUN:              -cursor-at=%s:5:9 \
+// RUN:              -cursor-at=%s:1:8 \
+// RUN:              -cursor-at=%s:6:20 \
+// RUN:              -cursor-at=%s:2:7 \
+// RUN:       %s | FileCheck %s
+
+// CHECK: MemberRefExpr=x:2:7
+// CHECK: FunctionDecl=length:5:5 (Definition)
+// CHECK: StructDecl=Point:1:8 (Definition)
+// CHECK: FunctionDecl=length:5:5 (Definition)
+// CHECK: StructDecl=Point:1:8 (Definition)
+// CHECK: MemberRefExpr=y:2:10
+// CHECK: FieldDecl=x:2:7 (Definition)
@@ -0,0 +1,19 @@
+// RUN: rm -rf %t
+// RUN: mkdir %t
+// RUN: echo '[{"directory": "%t", "command": "clang -c -I%S/Inputs %s", "file": "%s"}, {"directory": "%t", "command": "clang -c -I%S/Inputs %S/Inputs/index-compile-db.c", "file": "%S/Inputs/index-compile-db.c"}]' > %t/compile_commands.json
+// RUN: c-index-test -index-compile-db %t > %t/out
+// RUN: FileCheck %s -input-file=%t/out
+// RUN: FileCheck %s -check-prefix=CHECK-FIRST -input-file=%t/out
+// RUN: FileCheck %s -check-prefix=CHECK-SECOND -input-file=%t/out
+
+// The header is indexed once per batch, whichever translation unit comes
+// first.
+// CHECK: [indexDeclaration]: kind: typedef | name: A |
+// CHECK-NOT: [indexDeclaration]: kind: typedef | name: A |
+
+// CHECK-FIRST: [indexDeclaration]: kind: variable | name: first_tu |
+// CHECK-SECOND: [indexDeclaration]: kind: variable | name: second_tu |
+
+#include "a.h"
+
+A first_tu;
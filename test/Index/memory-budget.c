@@ -0,0 +1,13 @@
+// The index unloads the least recently used translation unit to stay within
+// its memory budget, but never one whose cursors are still being visited.
+
+// RUN: c-index-test -test-memory-budget %s %s | FileCheck %s
+
+int first;
+int second(void);
+
+// CHECK: after parsing: main unloaded, other loaded
+// CHECK: in visitor: main loaded, other loaded
+// CHECK: visiting first
+// CHECK: visiting second
+// CHECK: after visiting: main loaded, other loaded
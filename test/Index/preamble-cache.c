@@ -0,0 +1,13 @@
+// RUN: rm -rf %t.cache
+// RUN: env LIBCLANG_PREAMBLE_CACHE=%t.cache CINDEXTEST_EDITING=1 c-index-test -test-load-source-reparse 1 local -I%S/Inputs %s | FileCheck %s
+// RUN: ls %t.cache | FileCheck -check-prefix CHECK-ENTRY %s
+// RUN: env LIBCLANG_PREAMBLE_CACHE=%t.cache CINDEXTEST_EDITING=1 c-index-test -test-load-source-reparse 1 local -I%S/Inputs %s | FileCheck %s
+#include "a.h"
+#include "b.h"
+
+A a;
+B b;
+
+// CHECK: preamble-cache.c:8:3: VarDecl=a:8:3 Extent=[8:1 - 8:4]
+// CHECK: preamble-cache.c:9:3: VarDecl=b:9:3 Extent=[9:1 - 9:4]
+// CHECK-ENTRY: .preamble
@@ -0,0 +1,12 @@
+// RUN: env CINDEXTEST_EDITING=1 CINDEXTEST_BACKGROUND_PREAMBLE=1 c-index-test -test-load-source-reparse 5 local -I%S/Inputs %s | FileCheck %s
+// RUN: env CINDEXTEST_EDITING=1 CINDEXTEST_BACKGROUND_PREAMBLE=1 c-index-test -test-load-source-reparse 5 all -I%S/Inputs %s | FileCheck -check-prefix CHECK-ALL %s
+#include "a.h"
+#include "b.h"
+
+A a;
+B b;
+
+// CHECK: preamble-reparse-background.c:6:3: VarDecl=a:6:3 Extent=[6:1 - 6:4]
+// CHECK: preamble-reparse-background.c:7:3: VarDecl=b:7:3 Extent=[7:1 - 7:4]
+// CHECK-ALL: a.h:3:13: TypedefDecl=A:3:13 (Definition) Extent=[3:1 - 3:14]
+// CHECK-ALL: b.h:1:15: TypedefDecl=B:1:15 (Definition) Extent=[1:1 - 1:16]
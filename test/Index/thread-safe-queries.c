@@ -0,0 +1,27 @@
+#include "a.h"
+
+struct Point {
+  A x, y;
+};
+
+A length(struct Point *p) {
+  return p->x + p->y;
+}
+
+// The queries serialized by CXTranslationUnit_ThreadSafeQueries find the same
+// cursors, also after reparsing with a precompiled preamble.
+// RUN: env CINDEXTEST_THREAD_SAFE_QUERIES=1 c-index-test \
+// RUN:     -cursor-at=%s:8:13 -cursor-at=%s:7:3 -cursor-at=%s:3:8 \
+// RUN:     -I%S/Inputs %s | FileCheck %s
+// RUN: env CINDEXTEST_EDITING=1 CINDEXTEST_THREAD_SAFE_QUERIES=1 \
+// RUN:     c-index-test -cursor-at=%s:8:13 -cursor-at=%s:7:3 \
+// RUN:     -cursor-at=%s:3:8 -I%S/Inputs %s | FileCheck %s
+// RUN: env CINDEXTEST_EDITING=1 CINDEXTEST_THREAD_SAFE_QUERIES=1 \
+// RUN:     c-index-test -test-load-source-reparse 3 local -I%S/Inputs %s \
+// RUN:   | FileCheck -check-prefix=RELOAD %s
+
+// CHECK: MemberRefExpr=x:4:5
+// CHECK: FunctionDecl=length:7:3 (Definition)
+// CHECK: StructDecl=Point:3:8 (Definition)
+
+// RELOAD: thread-safe-queries.c:7:3: FunctionDecl=length:7:3 (Definition)
@@ -0,0 +1,26 @@
+namespace outer {
+namespace inner {
+struct S {
+  void f(int);
+  static int v;
+};
+}
+}
+
+void use(outer::inner::S &s) {
+  s.f(outer::inner::S::v);
+  s.f(outer::inner::S::v);
+}
+
+// The USRs of declarations and their contexts are cached; asking for them
+// again gives the same USRs.
+// RUN: c-index-test -index-file %s | FileCheck %s
+// CHECK: [indexDeclaration]: kind: {{.*}} | name: f | USR: c:@N@outer@N@inner@S@S@F@f#I# |
+// CHECK: [indexDeclaration]: kind: {{.*}} | name: v | USR: c:@N@outer@N@inner@S@S@v |
+// CHECK: [indexEntityReference]: kind: {{.*}} | name: f | USR: c:@N@outer@N@inner@S@S@F@f#I# | {{.*}} | loc: 11:5
+// CHECK: [indexEntityReference]: kind: {{.*}} | name: v | USR: c:@N@outer@N@inner@S@S@v | {{.*}} | loc: 11:24
+// CHECK: [indexEntityReference]: kind: {{.*}} | name: f | USR: c:@N@outer@N@inner@S@S@F@f#I# | {{.*}} | loc: 12:5
+// CHECK: [indexEntityReference]: kind: {{.*}} | name: v | USR: c:@N@outer@N@inner@S@S@v | {{.*}} | loc: 12:24
+
+// RUN: c-index-test -usr-benchmark=3 %s | FileCheck -check-prefix=BENCH %s
+// BENCH: Computed {{[1-9][0-9]*}} USRs in 3 rounds in
@@ -0,0 +1,29 @@
+// RUN: %clang_cc1 -dump-tokens %s 2>&1 | FileCheck %s
+
+// The lexer skips identifiers, numbers, whitespace and line comments in blocks
+// of 16 characters.  Check runs that span several blocks and end on each kind
+// of character that needs the slow path.
+
+int identifier_that_is_longer_than_several_blocks_0123456789_abcdefghijklmnop;
+// CHECK: identifier 'identifier_that_is_longer_than_several_blocks_0123456789_abcdefghijklmnop'
+// CHECK-NEXT: semi ';'
+
+int identifier_that_contains_a_dollar_$_after_the_first_block;
+// CHECK: identifier 'identifier_that_contains_a_dollar_$_after_the_first_block'
+
+int identifier_split_by_an_escaped_newline_\
+after_the_first_block;
+// CHECK: identifier 'identifier_split_by_an_escaped_newline_after_the_first_block'
+
+double d = 1234567890123456789012345678901234567890.0123456789e+12345;
+// CHECK: numeric_constant '1234567890123456789012345678901234567890.0123456789e+12345'
+// CHECK-NEXT: semi ';'
+
+int                     		                          spaced;
+// CHECK: identifier 'spaced'{{.*}}[LeadingSpace]
+
+// A comment that is longer than several blocks, and that continues \
+int not_a_declaration;
+int after_comment;
+// CHECK-NOT: not_a_declaration
+// CHECK: identifier 'after_comment'{{.*}}[StartOfLine]
@@ -0,0 +1,6 @@
+struct Point {
+  int x, y;
+  int sum() const { return x + y; }
+};
+
+template<typename T> T twice(T t) { return t + t; }
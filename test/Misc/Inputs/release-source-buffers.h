@@ -0,0 +1 @@
+#define BAD_INIT "released"
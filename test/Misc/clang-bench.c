@@ -0,0 +1,18 @@
+// REQUIRES: x86-registered-target
+// RUN: clang-bench -iterations=1 -benchmark=c -benchmark=macros -mode=syntax \
+// RUN:   %S/../../tools/clang-bench/Corpus | FileCheck %s
+
+// CHECK: "version": "
+// CHECK: "iterations": 1,
+// CHECK: "name": "c",
+// CHECK-NEXT: "file": "c.c",
+// CHECK-NEXT: "mode": "syntax",
+// CHECK-NEXT: "wall": { "min": {{[0-9.]+}}, "median": {{[0-9.]+}} },
+// CHECK-NEXT: "phases": [
+// CHECK-NEXT: { "name": "frontend", "total": {{.*}}, "count": 1 }
+// CHECK: "allocations": {{[0-9]+}},
+// CHECK-NEXT: "allocated_bytes": {{[0-9]+}},
+// CHECK-NEXT: "peak_allocated_bytes": {{[0-9]+}},
+// CHECK-NEXT: "ast_bytes": {{[0-9]+}}
+// CHECK: "name": "macros",
+// CHECK-NOT: "name": "objc"
@@ -0,0 +1,17 @@
+// RUN: clang-microbench -repetitions=1 -min-time=0 -search-dirs=4 \
+// RUN:   %S/../../lib/Headers/stddef.h %S/../../lib/Headers/float.h \
+// RUN:   | FileCheck %s
+
+// CHECK: "inputs": 2,
+// CHECK: "name": "lexer-raw", "operations": {{[0-9]+}}, "ns_per_op": {
+// CHECK: "name": "source-manager-getFileID"
+// CHECK: "name": "source-manager-getLineNumber"
+// CHECK: "name": "source-manager-isBeforeInTranslationUnit"
+// CHECK: "name": "identifier-table-get-warm"
+// CHECK: "name": "identifier-table-get-cold"
+// CHECK: "name": "identifier-table-getForLexer"
+// CHECK: "name": "file-manager-getFile-warm"
+// CHECK: "name": "file-manager-getFile-cold"
+// CHECK: "name": "header-search-LookupFile"
+// CHECK: "name": "header-search-LookupFile-missing"
+// CHECK: "name": "opt-table-ParseArgs"
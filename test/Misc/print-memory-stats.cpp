@@ -0,0 +1,22 @@
+// RUN: %clang_cc1 -fsyntax-only -print-memory-stats -I %S/Inputs %s 2>&1 | FileCheck %s
+
+#include "print-memory-stats.h"
+
+int f(Point p) {
+  return twice(p.sum());
+}
+
+// CHECK: *** AST Memory Stats:
+// CHECK: {{[1-9][0-9]*}} bytes allocated for the AST
+// CHECK: Declarations by class: {{[1-9][0-9]*}} bytes
+// CHECK: CXXRecord
+// CHECK: Statements by class: {{[1-9][0-9]*}} bytes
+// CHECK: ReturnStmt
+// CHECK: Types by class: {{[1-9][0-9]*}} bytes
+// CHECK: TypeLoc data: {{[1-9][0-9]*}} bytes
+// CHECK: DeclContext lookup tables:
+// CHECK: Uniquing tables:
+// CHECK: FunctionProtoTypes
+// CHECK: By source file:
+// CHECK-DAG: print-memory-stats.cpp
+// CHECK-DAG: Inputs{{/|\\}}print-memory-stats.h
@@ -0,0 +1,11 @@
+// RUN: %clang_cc1 -release-source-buffers -print-stats -fsyntax-only \
+// RUN:   -I %S/Inputs %s 2>&1 | FileCheck %s
+
+// Diagnostics still show the source of headers after they were released.
+#include "release-source-buffers.h"
+int bad = BAD_INIT;
+
+// CHECK: warning: incompatible pointer to integer conversion
+// CHECK: note: expanded from macro 'BAD_INIT'
+// CHECK-NEXT: #define BAD_INIT "released"
+// CHECK: {{[0-9]+}} file buffers released ({{[0-9]+}} bytes).
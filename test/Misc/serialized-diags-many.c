@@ -0,0 +1,18 @@
+// RUN: %clang_cc1 -fsyntax-only -Wunused-value %s -serialize-diagnostic-file %t
+// RUN: c-index-test -read-diagnostics %t 2>&1 | FileCheck %s
+// RUN: rm -f %t
+
+// Test that the serialized diagnostics stay readable when they are written out
+// in several pieces.
+
+#define X4(x) x x x x
+#define X16(x) X4(X4(x))
+#define X4096(x) X16(X16(X16(x)))
+
+void f(void) {
+  X4096(0;)
+}
+
+// CHECK: {{.*}}serialized-diags-many.c:13:9: warning: expression result unused [-Wunused-value]
+// CHECK: +-{{.*}}serialized-diags-many.c:10:{{[0-9]+}}: note: expanded from macro 'X4096' []
+// CHECK: Number of diagnostics: 4096
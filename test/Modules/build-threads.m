@@ -0,0 +1,26 @@
+// RUN: rm -rf %t
+// RUN: %clang_cc1 -fmodules -fmodules-build-threads=4 -fmodule-cache-path %t -I %S/Inputs -verify %s
+// RUN: ls %t/*/diamond_top.pcm %t/*/diamond_left.pcm %t/*/diamond_right.pcm %t/*/lookup_right_objc.pcm
+// RUN: %clang_cc1 -fmodules -fmodule-cache-path %t -I %S/Inputs -verify %s
+// RUN: rm -rf %t
+// RUN: %clang_cc1 -fmodules -fmodules-build-threads=0 -fmodule-cache-path %t -I %S/Inputs -verify %s
+
+// diamond_right and lookup_right_objc are built in the background while
+// diamond_left is built; diamond_top, which both diamonds import, is built
+// once and shared through the module cache.
+@__experimental_modules_import diamond_left;
+@__experimental_modules_import diamond_right;
+// @__experimental_modules_import no_such_module;
+@__experimental_modules_import lookup_right_objc;
+
+void test(int i, float f, double d) {
+  top(&i);
+  left(&f);
+  right(&d);
+  struct left_and_right lr;
+  lr.left = 17;
+}
+
+double test_method(B *b) {
+  return [b method];
+}
@@ -0,0 +1,27 @@
+// RUN: rm -rf %t
+// RUN: %clang_cc1 -triple x86_64-unknown-unknown -target-feature +sse2 \
+// RUN:   -fintrinsics-module -fmodule-cache-path %t -fsyntax-only -verify %s
+// RUN: ls %t/*/_Builtin_intrinsics.pcm
+// RUN: %clang_cc1 -triple x86_64-unknown-unknown -target-feature +sse2 \
+// RUN:   -fintrinsics-module -fmodule-cache-path %t -emit-llvm -o - %s \
+// RUN:   | FileCheck %s
+// RUN: %clang -target x86_64-unknown-unknown -fintrinsics-module -### \
+// RUN:   -fsyntax-only %s 2>&1 | FileCheck -check-prefix=DRIVER %s
+// expected-no-diagnostics
+
+// The intrinsic headers are imported from the module; other builtin headers
+// are still included textually.
+#include <emmintrin.h>
+#include <emmintrin.h>
+#include <stddef.h>
+
+__m128i add(__m128i a, __m128i b) {
+  return _mm_add_epi32(a, b);
+}
+
+size_t size = sizeof(__m128d);
+
+// CHECK: define <2 x i64> @add
+// CHECK: add <4 x i32>
+
+// DRIVER: "-fintrinsics-module"
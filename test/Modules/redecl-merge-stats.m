@@ -0,0 +1,11 @@
+// RUN: rm -rf %t
+// RUN: %clang_cc1 -fmodules -fmodule-cache-path %t -I %S/Inputs %s -fsyntax-only -Wno-objc-root-class -print-stats 2>&1 | FileCheck %s
+
+// Both modules declare the classes of redecl_merge_top (and some of their
+// own) again; their declarations are merged when they are loaded.
+@__experimental_modules_import redecl_merge_left;
+@__experimental_modules_import redecl_merge_right;
+
+void f(A *a, B *b, C *c) { }
+
+// CHECK: {{[1-9][0-9]*}}/{{[1-9][0-9]*}} declarations merged with an existing declaration ({{[0-9]+}} found by entity)
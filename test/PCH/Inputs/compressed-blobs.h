@@ -0,0 +1,85 @@
+// Header for compressed-blobs.c. It is long enough for its line table, and
+// the buffer of the predefines, to be compressed.
+
+int compressed_0(int x);
+int compressed_1(int x);
+int compressed_2(int x);
+int compressed_3(int x);
+int compressed_4(int x);
+int compressed_5(int x);
+int compressed_6(int x);
+int compressed_7(int x);
+int compressed_8(int x);
+int compressed_9(int x);
+int compressed_10(int x);
+int compressed_11(int x);
+int compressed_12(int x);
+int compressed_13(int x);
+int compressed_14(int x);
+int compressed_15(int x);
+int compressed_16(int x);
+int compressed_17(int x);
+int compressed_18(int x);
+int compressed_19(int x);
+int compressed_20(int x);
+int compressed_21(int x);
+int compressed_22(int x);
+int compressed_23(int x);
+int compressed_24(int x);
+int compressed_25(int x);
+int compressed_26(int x);
+int compressed_27(int x);
+int compressed_28(int x);
+int compressed_29(int x);
+int compressed_30(int x);
+int compressed_31(int x);
+int compressed_32(int x);
+int compressed_33(int x);
+int compressed_34(int x);
+int compressed_35(int x);
+int compressed_36(int x);
+int compressed_37(int x);
+int compressed_38(int x);
+int compressed_39(int x);
+int compressed_40(int x);
+int compressed_41(int x);
+int compressed_42(int x);
+int compressed_43(int x);
+int compressed_44(int x);
+int compressed_45(int x);
+int compressed_46(int x);
+int compressed_47(int x);
+int compressed_48(int x);
+int compressed_49(int x);
+int compressed_50(int x);
+int compressed_51(int x);
+int compressed_52(int x);
+int compressed_53(int x);
+int compressed_54(int x);
+int compressed_55(int x);
+int compressed_56(int x);
+int compressed_57(int x);
+int compressed_58(int x);
+int compressed_59(int x);
+int compressed_60(int x);
+int compressed_61(int x);
+int compressed_62(int x);
+int compressed_63(int x);
+int compressed_64(int x);
+int compressed_65(int x);
+int compressed_66(int x);
+int compressed_67(int x);
+int compressed_68(int x);
+int compressed_69(int x);
+int compressed_70(int x);
+int compressed_71(int x);
+int compressed_72(int x);
+int compressed_73(int x);
+int compressed_74(int x);
+int compressed_75(int x);
+int compressed_76(int x);
+int compressed_77(int x);
+int compressed_78(int x);
+int compressed_79(int x);
+
+static int last_line_of_header(void) { return 0; }
@@ -0,0 +1,4 @@
+struct Point { int x, y; };
+typedef struct Point PointT;
+int distance(PointT A, PointT B);
+int unused(int);
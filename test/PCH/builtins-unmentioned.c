@@ -0,0 +1,22 @@
+// Test that the builtins a PCH does not mention are still found.
+// RUN: %clang_cc1 -triple i686-apple-darwin9 -emit-pch -o %t %s
+// RUN: %clang_cc1 -triple i686-apple-darwin9 -include-pch %t \
+// RUN:   -fsyntax-only -verify %s
+
+#ifndef HEADER
+#define HEADER
+
+int mentioned(int x) { return __builtin_popcount(x); }
+
+#else
+
+int unmentioned(int x) {
+  return __builtin_expect(x, 0) + __builtin_ctz(x) + mentioned(x);
+}
+
+void unknown(int a, int b) {
+  __builtin_isles(a, b); // expected-error{{use of unknown builtin}} \
+                         // expected-note{{did you mean '__builtin_isless'?}}
+}
+
+#endif
@@ -0,0 +1,37 @@
+// REQUIRES: shell
+// RUN: rm -rf %t
+// RUN: mkdir -p %t
+// RUN: echo 'int a;' > %t/a.h
+// RUN: echo 'int b;' > %t/b.h
+// RUN: %clang_cc1 -fsyntax-only -verify -DFIRST %s -chain-include %t/a.h -chain-include %t/b.h -chain-include-cache %t/cache
+// RUN: ls %t/cache | FileCheck %s
+
+// Backdate the cached layers, so that the rebuilt ones are newer than %t/stamp.
+// RUN: touch -t 200001010000 %t/cache/*
+// RUN: touch -t 200101010000 %t/stamp
+
+// Reuse both layers.
+// RUN: %clang_cc1 -fsyntax-only -verify -DFIRST %s -chain-include %t/a.h -chain-include %t/b.h -chain-include-cache %t/cache
+// RUN: find %t/cache -name '*.pch' -newer %t/stamp | count 0
+
+// Rebuild the layer of the header that changed.
+// RUN: echo 'int b; int c;' > %t/b.h
+// RUN: %clang_cc1 -fsyntax-only -verify %s -chain-include %t/a.h -chain-include %t/b.h -chain-include-cache %t/cache
+// RUN: find %t/cache -name '*.pch' -newer %t/stamp | FileCheck -check-prefix=REBUILT %s
+
+// CHECK: a.h-{{[0-9A-F]+}}.pch
+// CHECK-NEXT: a.h-{{[0-9A-F]+}}.pch.deps
+// CHECK-NEXT: b.h-{{[0-9A-F]+}}.pch
+// CHECK-NEXT: b.h-{{[0-9A-F]+}}.pch.deps
+
+// REBUILT-NOT: a.h-
+// REBUILT: b.h-{{[0-9A-F]+}}.pch
+// REBUILT-NOT: a.h-
+
+int *p = &a;
+int *q = &b;
+#ifdef FIRST
+int *r = &c; // expected-error {{use of undeclared identifier 'c'}}
+#else
+int *r = &c;
+#endif
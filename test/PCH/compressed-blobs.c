@@ -0,0 +1,15 @@
+// Test that AST files whose source manager blobs are compressed can be used.
+// REQUIRES: zlib
+// RUN: %clang_cc1 -emit-pch -compress-pch -o %t %S/Inputs/compressed-blobs.h
+// RUN: not %clang_cc1 -include-pch %t -fsyntax-only %s 2>&1 | FileCheck %s
+// RUN: not %clang_cc1 -include-pch %t -fsyntax-only -print-stats %s 2>&1 \
+// RUN:   | FileCheck -check-prefix=STATS %s
+
+int use(int x) { return compressed_79(x); }
+
+static int last_line_of_header(void) { return 1; }
+
+// CHECK: compressed-blobs.c:10:12: error: redefinition of 'last_line_of_header'
+// CHECK: compressed-blobs.h:85:12: note: previous definition is here
+
+// STATS: {{[1-9][0-9]*}} compressed blobs decompressed
@@ -0,0 +1,60 @@
+// Test this without pch.
+// RUN: %clang_cc1 -include %s -emit-llvm -o - %s | FileCheck %s
+
+// Test with pch.
+// RUN: %clang_cc1 -emit-pch -o %t %s
+// RUN: %clang_cc1 -include-pch %t -emit-llvm -o - %s | FileCheck %s
+// RUN: %clang_cc1 -include-pch %t -emit-llvm -o - %s \
+// RUN:   | FileCheck -check-prefix=MINUS %s
+// RUN: %clang_cc1 -include-pch %t -emit-llvm -o - %s \
+// RUN:   | FileCheck -check-prefix=TIMES %s
+
+// The name locations are read back from the pch.
+// RUN: c-index-test -test-load-tu %t all | FileCheck -check-prefix=LOCS %s
+
+// References to operator and conversion function names keep their
+// DeclarationNameLoc next to any qualifier or template arguments.
+
+#ifndef HEADER
+#define HEADER
+
+struct S {
+  operator int() const;
+};
+
+S &operator+(S &, S &);
+
+template<typename T> T &operator-(T &, T &);
+
+namespace N {
+  S &operator*(S &, S &);
+}
+
+inline int (S::*conv())() const { return &S::operator int; }
+
+inline int convert(const S &s) { return s.operator int(); }
+
+inline S &plus(S &a, S &b) { return operator+(a, b); }
+
+inline S &minus(S &a, S &b) { return operator-<S>(a, b); }
+
+inline S &times(S &a, S &b) { return N::operator*(a, b); }
+
+#else
+
+int test(S &a, S &b) {
+  int (S::*pm)() const = conv();
+  return (times(minus(plus(a, b), a), b).*pm)() + convert(a);
+}
+
+// CHECK: call {{.*}} @_ZplR1SS0_
+// MINUS: call {{.*}} @_ZmiI1SE
+// TIMES: call {{.*}} @_ZN1NmlER1SS1_
+
+// LOCS: cxx-operator-names.cpp:33:46: DeclRefExpr=operator int:{{[0-9:]+}} Extent=[33:43 - 33:58]
+// LOCS: cxx-operator-names.cpp:35:43: MemberRefExpr=operator int:{{[0-9:]+}} Extent=[35:41 - 35:55]
+// LOCS: cxx-operator-names.cpp:37:37: DeclRefExpr=operator+:{{[0-9:]+}} Extent=[37:37 - 37:46]
+// LOCS: cxx-operator-names.cpp:39:38: DeclRefExpr=operator-:{{[0-9:]+}} Extent=[39:38 - 39:50]
+// LOCS: cxx-operator-names.cpp:41:41: DeclRefExpr=operator*:{{[0-9:]+}} Extent=[41:38 - 41:50]
+
+#endif
@@ -0,0 +1,28 @@
+// Test the statistics of reading a PCH file.
+// RUN: %clang_cc1 -emit-pch -o %t %S/Inputs/deserialization-stats.h
+// RUN: %clang_cc1 -include-pch %t -fsyntax-only -print-stats %s 2>&1 \
+// RUN:   | FileCheck -check-prefix=STATS %s
+// RUN: %clang_cc1 -include-pch %t -fsyntax-only \
+// RUN:   -deserialization-stats-file %t.json %s
+// RUN: FileCheck -check-prefix=JSON %s < %t.json
+
+int d(struct Point *P) { return distance(*P, *P); }
+
+// STATS: *** AST File Deserialization Times:
+// STATS: seconds in {{[0-9]+}} declarations
+// STATS: *** AST File Declarations Read By Kind:
+// STATS: Function
+// STATS: *** AST File Declarations Read By File (1 of 1 files):
+// STATS: deserialization-stats.h
+
+// JSON: "ast_files": [
+// JSON: "counts": {
+// JSON: "decls": { "read": {{[0-9]+}}, "total": {{[0-9]+}} },
+// JSON: "identifier_lookups":
+// JSON: "times": {
+// JSON: "decls": { "count": {{[0-9]+}}, "nanoseconds": {{[0-9]+}} },
+// JSON: "decls_by_kind": {
+// JSON: "Function": 1
+// JSON: "decls_by_file": [
+// JSON-NEXT: { "file": "{{.*}}deserialization-stats.h", "decls": {{[0-9]+}} }
+// JSON-NEXT: ]
@@ -0,0 +1,36 @@
+// Test that deterministic AST files do not depend on where and when they
+// were built, and that they validate their input files by their contents.
+// REQUIRES: shell
+
+// RUN: rm -rf %t && mkdir -p %t/a %t/b
+// RUN: cp %s %t/a/t.h && cp %s %t/b/t.h && touch -t 200001010000 %t/b/t.h
+// RUN: cd %t/a && %clang_cc1 -x c-header t.h -emit-pch -deterministic-pch \
+// RUN:   -o %t/a.pch
+// RUN: cd %t/b && %clang_cc1 -x c-header t.h -emit-pch -deterministic-pch \
+// RUN:   -o %t/b.pch
+// RUN: cmp %t/a.pch %t/b.pch
+
+// A new modification time does not invalidate the AST file.
+// RUN: touch %t/a/t.h
+// RUN: cd %t/a && %clang_cc1 -include-pch %t/a.pch -fsyntax-only -verify %s
+
+// New contents of the same size do.
+// RUN: sed -e 's/value = 1;/value = 2;/' %t/a/t.h > %t/t.h && mv %t/t.h %t/a
+// RUN: cd %t/a && not %clang_cc1 -include-pch %t/a.pch -fsyntax-only %s \
+// RUN:   2>&1 | FileCheck %s
+
+#ifndef HEADER
+#define HEADER
+
+struct S { int member; };
+enum { First, Second };
+static const int value = 1;
+int get(struct S *s);
+
+#else
+
+int use(struct S *s) { return get(s) + value + Second; }
+
+// CHECK: fatal error: file {{.*}}t.h' has been modified since the precompiled header was built
+
+#endif
@@ -0,0 +1,30 @@
+// Test that deterministic AST files of C++ headers are identical from one
+// run to the next, even when declarations share a location and the lookup
+// tables have to be ordered by name.
+// REQUIRES: shell
+
+// RUN: rm -rf %t && mkdir -p %t
+// RUN: %clang_cc1 -x c++-header %s -emit-pch -deterministic-pch -o %t/1.pch
+// RUN: %clang_cc1 -x c++-header %s -emit-pch -deterministic-pch -o %t/2.pch
+// RUN: %clang_cc1 -x c++-header %s -emit-pch -deterministic-pch -o %t/3.pch
+// RUN: cmp %t/1.pch %t/2.pch
+// RUN: cmp %t/1.pch %t/3.pch
+
+// Every member declared by one expansion of this macro has the same location.
+#define MEMBERS(T) T alpha; T beta; T gamma; T delta(T); static T epsilon;
+
+namespace N {
+  struct S { MEMBERS(int) };
+  struct Implicit { int i; };
+  inline void copy(Implicit &A, const Implicit &B) { A = B; }
+}
+
+extern "C" {
+  int first; int second; int third;
+}
+
+namespace N {
+  template<typename T> struct Box { MEMBERS(T) };
+  template struct Box<int>;
+  template struct Box<char>;
+}
@@ -0,0 +1,26 @@
+// Test that function bodies are only deserialized when they are needed.
+// RUN: %clang_cc1 -emit-pch -o %t %s
+// RUN: %clang_cc1 -include-pch %t -fsyntax-only -print-stats %s 2>&1 \
+// RUN:   | FileCheck -check-prefix=SYNTAX %s
+// RUN: %clang_cc1 -include-pch %t -emit-llvm -o - -print-stats %s 2>&1 \
+// RUN:   | FileCheck -check-prefix=CODEGEN %s
+
+#ifndef HEADER
+#define HEADER
+
+inline int used() { return 1; }
+inline int unused1() { return 2; }
+inline int unused2() { return 3; }
+
+template<typename T> struct S {
+  int get() { return unused1(); }
+};
+
+#else
+
+int x = used();
+
+// SYNTAX: 0/4 function bodies read
+// CODEGEN: 1/4 function bodies read
+
+#endif
@@ -0,0 +1,35 @@
+// Test that macros which are only tested by #ifdef and 'defined' are not
+// read from the AST file.
+// RUN: %clang_cc1 -emit-pch -o %t %s
+// RUN: %clang_cc1 -include-pch %t -fsyntax-only -verify %s
+// RUN: %clang_cc1 -include-pch %t -fsyntax-only -print-stats %s 2>&1 \
+// RUN:   | FileCheck %s
+
+#ifndef HEADER
+#define HEADER
+
+#define TESTED_BY_IFDEF 1
+#define TESTED_BY_DEFINED 2
+#define EXPANDED 3
+#define UNUSED 4
+
+#else
+
+#ifndef TESTED_BY_IFDEF
+#error TESTED_BY_IFDEF should be defined
+#endif
+
+#if !defined(TESTED_BY_DEFINED)
+#error TESTED_BY_DEFINED should be defined
+#endif
+
+#ifdef NOT_DEFINED
+#error NOT_DEFINED should not be defined
+#endif
+
+int x[EXPANDED == 3 ? 1 : -1];
+
+// CHECK: {{[1-9][0-9]*}}/{{[1-9][0-9]*}} macros read
+// CHECK: {{[1-9][0-9]*}} macros of loaded identifiers left unread
+
+#endif
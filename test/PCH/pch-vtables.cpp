@@ -0,0 +1,58 @@
+// Test that -fpch-vtables leaves the vtables and RTTI of the classes of a PCH
+// to the translation unit which owns it.
+// RUN: %clang_cc1 -triple x86_64-unknown-unknown -emit-pch -o %t %s
+// RUN: %clang_cc1 -triple x86_64-unknown-unknown -include-pch %t \
+// RUN:   -emit-llvm -o - %s | FileCheck -check-prefix=EVERYWHERE %s
+// RUN: %clang_cc1 -triple x86_64-unknown-unknown -include-pch %t \
+// RUN:   -fpch-vtables=owner -emit-llvm -o - %s | FileCheck -check-prefix=OWNER %s
+// RUN: %clang_cc1 -triple x86_64-unknown-unknown -include-pch %t \
+// RUN:   -fpch-vtables=external -emit-llvm -o - %s \
+// RUN:   | FileCheck -check-prefix=EXTERNAL %s
+// RUN: %clang_cc1 -triple x86_64-unknown-unknown -include-pch %t \
+// RUN:   -fpch-vtables=external -O1 -disable-llvm-optzns -emit-llvm -o - %s \
+// RUN:   | FileCheck -check-prefix=EXTERNAL-OPT %s
+
+#ifndef HEADER
+#define HEADER
+
+struct NoKey { virtual void f() {} };
+struct Key { virtual void g(); };
+template<typename T> struct Tmpl { virtual void h() {} };
+inline void instantiateInHeader() { Tmpl<int> t; }
+
+#else
+
+// EVERYWHERE-DAG: @_ZTV5NoKey = linkonce_odr unnamed_addr constant
+// EVERYWHERE-DAG: @_ZTV4TmplIiE = linkonce_odr unnamed_addr constant
+
+// The owner defines them, whether or not it uses them.
+// OWNER-DAG: @_ZTV5NoKey = weak_odr unnamed_addr constant
+// OWNER-DAG: @_ZTS5NoKey = weak_odr {{.*}}constant
+// OWNER-DAG: @_ZTI5NoKey = weak_odr {{.*}}constant
+// OWNER-DAG: @_ZTV4TmplIiE = weak_odr unnamed_addr constant
+// OWNER-DAG: @_ZTV5Local = linkonce_odr unnamed_addr constant
+// OWNER-DAG: @_ZTV4TmplIcE = linkonce_odr unnamed_addr constant
+// OWNER-DAG: @_ZTV3Key = external unnamed_addr constant
+
+// EXTERNAL-DAG: @_ZTV5NoKey = external unnamed_addr constant
+// EXTERNAL-DAG: @_ZTV4TmplIiE = external unnamed_addr constant
+// EXTERNAL-DAG: @_ZTV5Local = linkonce_odr unnamed_addr constant
+// EXTERNAL-DAG: @_ZTV4TmplIcE = linkonce_odr unnamed_addr constant
+
+// EXTERNAL-OPT-DAG: @_ZTV5NoKey = available_externally unnamed_addr constant
+// EXTERNAL-OPT-DAG: @_ZTV4TmplIiE = available_externally unnamed_addr constant
+// EXTERNAL-OPT-DAG: @_ZTV4TmplIcE = linkonce_odr unnamed_addr constant
+
+// Classes of this translation unit, and instantiations made here, are not
+// covered.
+struct Local { virtual void l() {} };
+
+void use() {
+  NoKey n;
+  Key k;
+  Tmpl<int> i;
+  Tmpl<char> c;
+  Local l;
+}
+
+#endif
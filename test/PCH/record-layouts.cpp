@@ -0,0 +1,47 @@
+// Test that the layouts of records are stored in the AST file and read back.
+// RUN: %clang_cc1 -triple x86_64-unknown-unknown -std=c++11 -emit-pch -o %t %s
+// RUN: %clang_cc1 -triple x86_64-unknown-unknown -std=c++11 -include-pch %t \
+// RUN:   -fsyntax-only -verify %s
+// RUN: %clang_cc1 -triple x86_64-unknown-unknown -std=c++11 -include-pch %t \
+// RUN:   -fsyntax-only -print-stats %s 2>&1 | FileCheck %s
+// RUN: %clang_cc1 -triple x86_64-unknown-unknown -std=c++11 -include-pch %t \
+// RUN:   -emit-llvm -o - %s | FileCheck -check-prefix=IR %s
+
+// Records are laid out again when their layout warnings are enabled.
+// RUN: %clang_cc1 -triple x86_64-unknown-unknown -std=c++11 -include-pch %t \
+// RUN:   -fsyntax-only -Wpadded %s 2>&1 | FileCheck -check-prefix=PADDED %s
+
+#ifndef HEADER
+#define HEADER
+
+struct Plain { char c; int i; short s; };
+struct Bits { unsigned a : 3; unsigned b : 7; char c; };
+struct Empty {};
+struct Base { virtual ~Base(); int b; };
+struct Derived : Empty, Base { char d; };
+struct VBase { int v; };
+struct Virtual : virtual VBase, Base { long l; };
+template<typename T> struct Box { T value; char tag; };
+typedef Box<double> DoubleBox;
+inline double get(DoubleBox b) { return b.value; }
+
+#else
+
+static_assert(sizeof(Plain) == 12 && alignof(Plain) == 4, "");
+static_assert(__builtin_offsetof(Plain, s) == 8, "");
+static_assert(sizeof(Bits) == 4, "");
+static_assert(sizeof(Derived) == 16, "");
+static_assert(sizeof(Virtual) == 32, "");
+static_assert(sizeof(DoubleBox) == 16, "");
+static_assert(sizeof(Box<char>) == 2, "");
+
+Plain p;
+Derived d;
+void use(Virtual *v) { v->v = v->l; }
+
+// CHECK: {{[1-9][0-9]*}}/{{[1-9][0-9]*}} record layouts read
+// IR: %struct.Plain = type { i8, i32, i16 }
+
+// PADDED: warning: padding struct 'Plain' with 3 bytes to align
+
+#endif
@@ -0,0 +1,11 @@
+inline int skipped() { return undeclared_in_skipped; }
+
+constexpr int parsed() { return 42; }
+
+template<typename T> T delayed(T t) { return t.undeclared_member; }
+
+template<typename T> T unused(T t) { return t.unused_member; }
+
+struct S {
+  int member() { return undeclared_in_member; }
+};
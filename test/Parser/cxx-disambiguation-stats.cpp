@@ -0,0 +1,28 @@
+// RUN: %clang_cc1 -fsyntax-only -verify %s
+// RUN: %clang_cc1 -fsyntax-only -print-stats %s 2>&1 | FileCheck %s
+
+struct T {
+  T();
+  T(int);
+  T(const char *);
+  int get() const;
+};
+
+void functions(int x);
+void functions(const T &t);
+
+int f(int b) {
+  // Resolved by looking at the token after the '('.
+  T(1).get();
+  T("one").get();
+  T().get();
+  T two(2);
+
+  // Resolved by a tentative parse, whose result for the '(b)' is reused when
+  // the declaration is parsed.
+  T(a)(b);
+  return a.get();
+}
+
+// CHECK: *** Parser Stats:
+// CHECK: {{[1-9][0-9]*}} ambiguities resolved by tentative parsing, {{[1-9][0-9]*}} by lookahead, {{[1-9][0-9]*}} from memoized results.
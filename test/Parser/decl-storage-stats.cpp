@@ -0,0 +1,26 @@
+// RUN: %clang_cc1 -fsyntax-only -verify %s
+// RUN: %clang_cc1 -fsyntax-only -print-stats %s 2>&1 | FileCheck %s
+
+template<typename T, typename U> struct Pair { T first; U second; };
+
+void many(int, int, int, int, int, int, int, int, int,
+          int, int, int, int, int, int, int, int, int);
+void (*returns_function(int, int))(int, int);
+void throws() throw(int, float);
+
+__attribute__((unused)) static Pair<int, float> p1;
+__attribute__((unused)) static Pair<Pair<int, int>, float> p2;
+
+namespace ns {
+  void in_namespace(int, int) throw(int);
+  Pair<int, Pair<float, int> > in_namespace_pair;
+  extern "C" {
+    void in_linkage(int, int, int);
+  }
+  extern "C" void (*in_linkage_spec(int))(int, int);
+  void after_linkage(Pair<int, int>, Pair<float, float>);
+}
+
+// CHECK: *** Parsed Declaration Storage Stats:
+// CHECK: {{[1-9][0-9]*}} attributes allocated, {{[1-9][0-9]*}} reused from the free lists.
+// CHECK: {{[1-9][0-9]*}} declaration arrays allocated, released in {{[1-9][0-9]*}} resets.
@@ -0,0 +1,30 @@
+// RUN: %clang_cc1 -fsyntax-only -std=c++11 -verify -flazy-inline-method-parsing %s
+
+// The body of an inline member function which is never used is not parsed.
+struct Unused {
+  void f() { undeclared_in_unused(); }
+};
+
+// The bodies of the used ones are parsed at the end of the translation unit,
+// including those used only by other delayed bodies or by a vtable.
+struct Used {
+  Used() {}
+  int f() { return g(); }
+  int g() { return undeclared_in_used; } // expected-error {{use of undeclared identifier 'undeclared_in_used'}}
+  virtual void h() { undeclared_in_virtual(); } // expected-error {{use of undeclared identifier 'undeclared_in_virtual'}}
+  void unused() { undeclared_in_unused_member(); }
+};
+
+int use() { return Used().f(); }
+
+// Constant expressions need the body of a constexpr function right away.
+struct Literal {
+  constexpr int k() const { return 42; }
+};
+static_assert(Literal().k() == 42, "");
+
+// Member function templates and members of class templates are unaffected.
+template<typename T> struct Template {
+  void f() { T::undeclared_member(); } // expected-error {{type 'int' cannot be used prior to '::' because it has no members}}
+};
+template struct Template<int>; // expected-note {{in instantiation of member function 'Template<int>::f' requested here}}
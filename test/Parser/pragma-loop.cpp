@@ -0,0 +1,80 @@
+// RUN: %clang_cc1 -std=c++11 -fsyntax-only -verify %s
+
+#define WIDTH 4
+
+void loops(int *a, int n) {
+#pragma clang loop vectorize(enable) vectorize_width(WIDTH)
+#pragma clang loop interleave_count(2)
+#pragma clang loop unroll(disable) unroll_count(8)
+  for (int i = 0; i < n; ++i)
+    a[i] = 0;
+
+#pragma clang loop vectorize(disable)
+  while (n--)
+    a[n] = 1;
+
+#pragma clang loop unroll(enable)
+  do
+    --n;
+  while (n);
+
+  int b[8];
+#pragma clang loop vectorize_width(8)
+  for (int x : b)
+    a[x] = x;
+}
+
+void invalid_values(int *a, int n) {
+  // expected-error@+1 {{invalid argument of 'vectorize_width' in '#pragma clang loop'; expected a power of two}}
+#pragma clang loop vectorize_width(3)
+  for (int i = 0; i < n; ++i)
+    a[i] = 0;
+
+  // expected-error@+1 {{invalid argument of 'unroll_count' in '#pragma clang loop'; expected a positive integer}}
+#pragma clang loop unroll_count(0)
+  while (n--)
+    a[n] = 1;
+
+  // expected-error@+1 {{invalid argument of 'interleave_count' in '#pragma clang loop'; expected a positive integer}}
+#pragma clang loop interleave_count(1.5)
+  while (n--)
+    a[n] = 1;
+
+  // expected-error@+2 {{duplicate 'vectorize_width' option in '#pragma clang loop'}}
+  // expected-note@+1 {{previous 'vectorize_width' option is here}}
+#pragma clang loop vectorize_width(4) unroll(enable) vectorize_width(8)
+  while (n--)
+    a[n] = 1;
+}
+
+void malformed(int *a, int n) {
+  // expected-warning@+1 {{expected 'enable' or 'disable' - ignoring}}
+#pragma clang loop vectorize(maybe)
+  // expected-warning@+1 {{unknown option 'fuse' in '#pragma clang loop'; expected vectorize, vectorize_width, interleave_count, unroll or unroll_count - ignored}}
+#pragma clang loop fuse(2)
+  // expected-warning@+1 {{expected an integer after 'unroll_count' in '#pragma clang loop' - ignored}}
+#pragma clang loop unroll_count(n)
+  // expected-warning@+1 {{missing '(' after '#pragma clang loop' - ignoring}}
+#pragma clang loop unroll_count 4
+  // expected-warning@+1 {{missing ')' after '#pragma clang loop' - ignoring}}
+#pragma clang loop unroll_count(4
+  // expected-warning@+1 {{expected identifier in '#pragma clang loop' - ignored}}
+#pragma clang loop
+  while (n--)
+    a[n] = 1;
+}
+
+void not_a_loop(int *a, int n) {
+  // expected-error@+1 {{'#pragma clang loop' must precede a for, while or do loop}}
+#pragma clang loop unroll(enable)
+  a[0] = n;
+
+  // expected-error@+1 {{'#pragma clang loop' must precede a for, while or do loop}}
+#pragma clang loop vectorize(enable)
+  if (n)
+    a[0] = 0;
+}
+
+// expected-error@+1 {{'#pragma clang loop' must precede a for, while or do loop}}
+#pragma clang loop unroll(enable)
+int global;
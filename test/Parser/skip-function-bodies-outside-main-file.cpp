@@ -0,0 +1,17 @@
+// RUN: not %clang_cc1 -fsyntax-only -std=c++11 -skip-function-bodies-outside-main-file -include %S/Inputs/skip-function-bodies.h %s 2>&1 | FileCheck %s
+
+// Constexpr functions are always parsed.
+static_assert(parsed() == 42, "");
+
+// Bodies in the main file are still parsed.
+int main_body() { return undeclared_in_main; }
+
+// The body of a template is parsed when it is instantiated.
+int use = delayed(1);
+
+// CHECK-NOT: undeclared_in_skipped
+// CHECK-NOT: undeclared_in_member
+// CHECK: error: use of undeclared identifier 'undeclared_in_main'
+// CHECK: skip-function-bodies.h:5:{{[0-9]+}}: error: member reference base type 'int' is not a structure or union
+// CHECK-NOT: unused_member
+// CHECK-NOT: undeclared_in_member
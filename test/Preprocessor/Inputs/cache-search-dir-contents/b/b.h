@@ -0,0 +1 @@
+int from_b;
@@ -0,0 +1,8 @@
+#pragma clang diagnostic push
+#pragma clang diagnostic ignored "-Wundef"
+#if FOO_IN_HEADER
+#endif
+#pragma clang diagnostic pop
+#pragma clang diagnostic warning "-Wundef"
+#if BAR_IN_HEADER // expected-warning {{'BAR_IN_HEADER' is not defined}}
+#endif
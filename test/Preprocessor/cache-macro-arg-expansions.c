@@ -0,0 +1,33 @@
+// RUN: %clang_cc1 -E %s > %t.uncached
+// RUN: %clang_cc1 -E -cache-macro-arg-expansions %s > %t.cached
+// RUN: diff %t.uncached %t.cached
+// RUN: FileCheck %s < %t.cached
+// RUN: %clang_cc1 -E -cache-macro-arg-expansions -print-stats %s 2>&1 \
+// RUN:   | FileCheck -check-prefix=STATS %s
+// RUN: %clang_cc1 -fsyntax-only -verify -cache-macro-arg-expansions %s
+
+#define ZERO 0
+#define INNER(x) x
+#define OUTER(x) INNER(x)
+
+int a = 1 / OUTER(ZERO); // expected-warning {{division by zero}}
+int b = 1 / OUTER(ZERO); // expected-warning {{division by zero}}
+// CHECK: int a = 1 / 0;
+// CHECK: int b = 1 / 0;
+
+#define TWICE(x) x x
+int c = OUTER(TWICE(ZERO)) + OUTER(TWICE(ZERO));
+// CHECK: int c = 0 0 + 0 0;
+
+#undef ZERO
+#define ZERO 1
+int d = OUTER(ZERO);
+// CHECK: int d = 1;
+
+#define LINE OUTER(__LINE__)
+int e = LINE;
+int f = LINE;
+// CHECK: int e = 28;
+// CHECK: int f = 29;
+
+// STATS: {{[1-9][0-9]*}} macro argument pre-expansions replayed
@@ -0,0 +1,33 @@
+// RUN: %clang_cc1 -E -I %S/Inputs %s > %t.uncached
+// RUN: %clang_cc1 -E -I %S/Inputs -cache-repeated-includes %s > %t.cached
+// RUN: diff %t.uncached %t.cached
+// RUN: FileCheck %s < %t.cached
+// RUN: %clang_cc1 -fsyntax-only -verify -I %S/Inputs -cache-repeated-includes %s
+
+#define ITEM(Name, Value) int Name = sizeof(Value);
+#include "cache-repeated-includes.def"
+// CHECK: int first = sizeof(1);
+// CHECK: int second = sizeof("two");
+// CHECK: int with_$_dollar = sizeof(0x1p4);
+
+struct S {
+#define ITEM(Name, Value) char Name;
+#include "cache-repeated-includes.def"
+};
+// CHECK: struct S {
+// CHECK: char first;
+// CHECK: char second;
+// CHECK: char with_$_dollar;
+
+#define USE_THIRD 1
+enum E {
+#define ITEM(Name, Value) E_##Name,
+#include "cache-repeated-includes.def"
+};
+// CHECK: enum E {
+// CHECK: E_first,
+// CHECK: E_second,
+// CHECK: E_third,
+// CHECK: E_with_$_dollar,
+
+int y = third; // expected-error {{use of undeclared identifier 'third'}}
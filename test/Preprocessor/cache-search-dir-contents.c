@@ -0,0 +1,30 @@
+// RUN: %clang_cc1 -E -cache-search-dir-contents \
+// RUN:   -I %S/Inputs/cache-search-dir-contents/a \
+// RUN:   -I %S/Inputs/cache-search-dir-contents/b %s | FileCheck %s
+// RUN: %clang_cc1 -E -cache-search-dir-contents -print-stats \
+// RUN:   -I %S/Inputs/cache-search-dir-contents/a \
+// RUN:   -I %S/Inputs/cache-search-dir-contents/b %s 2>&1 \
+// RUN:   | FileCheck -check-prefix=STATS %s
+// RUN: %clang_cc1 -fsyntax-only -verify -cache-search-dir-contents \
+// RUN:   -I %S/Inputs/cache-search-dir-contents/a \
+// RUN:   -I %S/Inputs/cache-search-dir-contents/b %s
+
+#include "b.h"
+#include <sub/sub.h>
+#include <a.h>
+#include <./b.h>
+// CHECK: int from_b;
+// CHECK: int from_sub;
+// CHECK: int from_a;
+// CHECK: int from_b;
+
+#ifndef __has_include
+#error __has_include is required
+#endif
+#if __has_include(<missing.h>) || __has_include(<sub/missing.h>)
+#error found a missing header
+#endif
+
+#include <missing.h> // expected-error {{'missing.h' file not found}}
+
+// STATS: {{[0-9]+}} search directory lookups, {{[1-9][0-9]*}} answered from the directory contents cache.
@@ -0,0 +1,8 @@
+// RUN: %clang_cc1 -E -print-stats %s -o /dev/null 2>&1 | FileCheck %s
+
+// A long token inside a macro argument does not split the argument into
+// several macro arg expansion entries.
+#define ID(x) x
+ID(a + "a string literal that is quite a bit longer than fifty characters" + b)
+
+// CHECK: {{^}}1 macro expansion SLocEntry's ({{[0-9]+}} bytes, {{[0-9]+}}B of Sloc address space), 1 macro arg expansion SLocEntry's ({{[0-9]+}} bytes, {{[0-9]+}}B of Sloc address space).
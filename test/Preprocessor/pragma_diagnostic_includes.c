@@ -0,0 +1,25 @@
+// RUN: %clang_cc1 -fsyntax-only -verify -I %S/Inputs %s
+// Diagnostic pragmas in included files take effect in the including file
+// after the #include, and not before it.
+
+#if BEFORE // no warning, -Wundef is off
+#endif
+
+#pragma clang diagnostic error "-Wundef"
+#if ERROR // expected-error {{'ERROR' is not defined}}
+#endif
+
+#pragma clang diagnostic push
+#pragma clang diagnostic warning "-Wundef"
+#include "pragma-diagnostic-header.h"
+#if AFTER_HEADER // expected-warning {{'AFTER_HEADER' is not defined}}
+#endif
+#pragma clang diagnostic pop
+
+#if AFTER_POP // expected-error {{'AFTER_POP' is not defined}}
+#endif
+
+#pragma clang diagnostic ignored "-Wundef"
+#include "pragma-diagnostic-header.h"
+#if AFTER_SECOND_HEADER // expected-warning {{'AFTER_SECOND_HEADER' is not defined}}
+#endif
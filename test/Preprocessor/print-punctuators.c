@@ -0,0 +1,11 @@
+// RUN: %clang_cc1 -E -trigraphs %s | FileCheck -strict-whitespace %s
+
+// Digraphs are printed as they are spelled, trigraphs are replaced.
+#define CAT(a, b) a ## b
+int a<:2:> = <% 1, 2 %>;
+int b[2] = { CAT(3, 4), - -5 };
+int c ??( 1 ??) ;
+
+// CHECK: int a<:2:> = <% 1, 2 %>;
+// CHECK: int b[2] = { 34, - -5 };
+// CHECK: int c [ 1 ] ;
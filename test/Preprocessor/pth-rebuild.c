@@ -0,0 +1,13 @@
+// RUN: rm -rf %t && mkdir -p %t
+// RUN: echo 'int old_decl;' > %t/header.h
+// RUN: %clang_cc1 -emit-pth %t/header.h -o %t/header.pth
+// RUN: echo 'int new_decl_with_a_longer_name;' > %t/header.h
+// RUN: %clang_cc1 -include-pth %t/header.pth -rebuild-stale-token-cache -E %s \
+// RUN:   | FileCheck %s
+// The cache was regenerated in place.
+// RUN: %clang_cc1 -include-pth %t/header.pth -E %s | FileCheck %s
+
+// CHECK-NOT: old_decl
+// CHECK: int new_decl_with_a_longer_name;
+// CHECK-NOT: old_decl
+int main_decl;
@@ -0,0 +1,16 @@
+// RUN: %clang_cc1 -E -print-stats %s 2>&1 | FileCheck %s
+
+// Every expansion of CAT(x, y) pastes the same token, and every expansion of
+// STR(x) stringizes the same one; each spelling is placed in scratch space
+// only once.
+#define CAT(a, b) a ## b
+#define STR(a) #a
+
+int CAT(x, y), CAT(x, y), CAT(x, y);
+const char *s = STR(x), *t = STR(x);
+
+// CHECK: int xy, xy, xy;
+// CHECK: const char *s = "x", *t = "x";
+// CHECK: {{^}}5 tokens formed in scratch space, 3 sharing an earlier spelling.
+// CHECK: {{^}}1 scratch buffers allocated, 4060 bytes.
+// CHECK: {{^}}2 distinct spellings, {{[0-9]+}} bytes in the sharing table.
@@ -0,0 +1,50 @@
+// RUN: %clang_cc1 -E %s | FileCheck -strict-whitespace %s
+// RUN: %clang_cc1 -E -std=c89 %s | FileCheck -strict-whitespace %s
+// RUN: %clang_cc1 -E -trigraphs %s | FileCheck -strict-whitespace %s
+// RUN: %clang_cc1 -E -x c++ -std=c++11 %s | FileCheck -strict-whitespace %s
+
+// Excluded blocks are skipped without forming tokens; the directives which
+// end them must still be found, and only those.
+
+#if 0
+int skipped1; /* #else
+#endif */ "#else" '#endif
+// #else \
+#endif
+a \
+#else
+  /* comment */ #elif 1
+ok1
+#endif
+// CHECK: ok1
+// CHECK-NOT: skipped1
+
+#ifdef UNDEFINED
+#if nested
+#else
+#endif
+x "\
+#else" y '\
+#else
+%:else
+#endif
+// CHECK-NOT: else
+
+#if 0
+skipped2
+#\
+else
+ok2
+#endif
+// CHECK: ok2
+// CHECK-NOT: skipped2
+
+#if 0
+#define M 'unterminated
+/*
+ * #endif
+ */
+	#	else
+ok3
+#endif
+// CHECK: ok3
@@ -0,0 +1,3 @@
+/// \brief Documented in the header.
+/// \param a The parameter.
+void in_header(int a);
@@ -0,0 +1,21 @@
+// RUN: %clang_cc1 -fsyntax-only -verify %s
+
+void *foo(double *p, int n) {
+  void *a = __builtin_assume_aligned(p, 32);
+  a = __builtin_assume_aligned(p, 64, 8);
+  a = __builtin_assume_aligned(p, 16, n);
+  a = __builtin_assume_aligned(p); // expected-error{{too few arguments to function call}}
+  a = __builtin_assume_aligned(p, 16, 0, 1); // expected-error{{too many arguments to function}}
+  a = __builtin_assume_aligned(p, n); // expected-error{{argument to '__builtin_assume_aligned' must be a constant integer}}
+  a = __builtin_assume_aligned(p, 24); // expected-error{{requested alignment is not a power of 2}}
+  a = __builtin_assume_aligned(p, 16, p); // expected-error{{offset argument to __builtin_assume_aligned must have integer type}}
+  return a;
+}
+
+void *alloc(int) __attribute__((assume_aligned(32)));
+void *alloc_offset(int) __attribute__((assume_aligned(64, 16)));
+int not_a_function __attribute__((assume_aligned(16))); // expected-warning{{attribute only applies to functions}}
+int returns_int(void) __attribute__((assume_aligned(16))); // expected-warning{{'assume_aligned' attribute only applies to functions returning a pointer type}}
+void *bad_align(void) __attribute__((assume_aligned(12))); // expected-error{{requested alignment is not a power of 2}}
+void *no_args(void) __attribute__((assume_aligned)); // expected-error{{attribute takes at least 1 argument}}
+void *too_many(void) __attribute__((assume_aligned(16, 0, 1))); // expected-error{{attribute takes no more than 2 arguments}}
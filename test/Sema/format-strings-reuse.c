@@ -0,0 +1,29 @@
+// RUN: %clang_cc1 -fsyntax-only -verify %s
+// RUN: %clang_cc1 -fsyntax-only -fdiagnostics-parseable-fixits %s 2>&1 \
+// RUN:   | FileCheck -check-prefix=FIXIT %s
+// RUN: %clang_cc1 -fsyntax-only -print-stats %s 2>&1 | FileCheck %s
+
+// A format string which is checked again is not parsed again, but every
+// check still reports its own arguments, at its own locations.
+
+int printf(const char *, ...);
+int scanf(const char *, ...);
+
+#define LOG(...) printf("[%s:%d] %s\n", __VA_ARGS__)
+
+void log_values(const char *s, int i, double d) {
+  LOG(s, i, s);
+  LOG(s, d, s); // expected-warning {{format specifies type 'int' but the argument has type 'double'}}
+  LOG(s, i); // expected-warning {{more '%' conversions than data arguments}}
+  printf("%d %%y %y\n", i, i); // expected-warning {{invalid conversion specifier 'y'}}
+  int n = printf("%d %%y %y\n", d, i); // expected-warning {{format specifies type 'int' but the argument has type 'double'}} expected-warning {{invalid conversion specifier 'y'}}
+}
+
+void read_values(int *i, float *f) {
+  scanf("%d %f", i, f);
+  scanf("%d %f", f, i); // expected-warning {{format specifies type 'int *' but the argument has type 'float *'}} expected-warning {{format specifies type 'float *' but the argument has type 'int *'}}
+}
+
+// FIXIT: fix-it:"{{.*}}":{19:19-19:21}:"%f"
+
+// CHECK: {{[1-9][0-9]*}}/{{[1-9][0-9]*}} parsed format strings reused.
@@ -0,0 +1,20 @@
+// RUN: %clang_cc1 -fsyntax-only -verify %s
+// RUN: %clang_cc1 -x c++ -std=c++11 -fsyntax-only -verify -DCXX11 %s
+
+// Integer literals that the element type can represent take a shortcut
+// through the initialization of arrays; the others must still be diagnosed.
+
+unsigned char bytes[] = { 0, 0x7f, 255 };
+signed char chars[] = { 0, 127 };
+const unsigned short halves[] = { 65535 };
+typedef int check_bytes[sizeof(bytes) == 3 ? 1 : -1];
+
+#ifndef CXX11
+unsigned char too_big[] = { 256 }; // expected-warning {{implicit conversion from 'int' to 'unsigned char' changes value from 256 to 0}}
+signed char too_big_signed[] = { 128 }; // expected-warning {{implicit conversion from 'int' to 'signed char' changes value from 128 to -128}}
+#else
+unsigned char too_big[] = { 256 }; // expected-error {{constant expression evaluates to 256 which cannot be narrowed to type 'unsigned char'}} expected-note {{inserting an explicit cast}} expected-warning {{changes value from 256 to 0}}
+constexpr unsigned char table[] = { 1, 255 };
+static_assert(table[0] == 1 && table[1] == 255, "");
+bool flags[] = { 0, 1 };
+#endif
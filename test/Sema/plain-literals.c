@@ -0,0 +1,45 @@
+// RUN: %clang_cc1 -triple x86_64-unknown-unknown -fsyntax-only -verify %s
+// RUN: %clang_cc1 -triple i386-unknown-unknown -fsyntax-only -verify %s
+// RUN: %clang_cc1 -triple i386-unknown-unknown -std=gnu89 -fsyntax-only -verify %s
+
+// Plain decimal integers and plain string literals are built without the
+// literal parsers; they must get the same values and types as the others.
+
+#define SAME_TYPE(x, T) __builtin_types_compatible_p(__typeof__(x), T)
+#define CHECK2(e, l) typedef int check_##l[(e) ? 1 : -1]
+#define CHECK1(e, l) CHECK2(e, l)
+#define STATIC_ASSERT(e) CHECK1(e, __LINE__)
+
+STATIC_ASSERT(SAME_TYPE(10, int) && 10 == 0xa);
+STATIC_ASSERT(SAME_TYPE(2147483647, int));
+STATIC_ASSERT(2147483647 == 0x7fffffff);
+#ifdef __LP64__
+STATIC_ASSERT(SAME_TYPE(2147483648, long));
+STATIC_ASSERT(SAME_TYPE(9223372036854775807, long));
+#else
+STATIC_ASSERT(SAME_TYPE(2147483648, long long));
+STATIC_ASSERT(SAME_TYPE(9223372036854775807, long long));
+#endif
+STATIC_ASSERT(2147483648 == 0x80000000);
+STATIC_ASSERT(9223372036854775807 == 0x7fffffffffffffff);
+STATIC_ASSERT(1234567890123456789 / 1000000000 == 1234567890);
+
+// Numbers which are not plain decimal integers.
+STATIC_ASSERT(SAME_TYPE(010, int) && 010 == 8);
+STATIC_ASSERT(SAME_TYPE(10u, unsigned) && SAME_TYPE(10l, long));
+STATIC_ASSERT(sizeof(1e1) == sizeof(double));
+STATIC_ASSERT(1\
+0 == 10);
+unsigned long long big = 9223372036854775808; // expected-warning {{integer constant is so large that it is unsigned}}
+
+STATIC_ASSERT(sizeof("") == 1);
+STATIC_ASSERT(sizeof("plain") == 6);
+STATIC_ASSERT(SAME_TYPE("plain", char[6]));
+
+// Strings which are not plain.
+STATIC_ASSERT(sizeof("a\tb") == 4);
+STATIC_ASSERT(sizeof("a" "b") == 3);
+STATIC_ASSERT(sizeof("a\
+b") == 3);
+STATIC_ASSERT(sizeof(L"ab") == 3 * sizeof(__WCHAR_TYPE__));
+STATIC_ASSERT(sizeof("\xc3\xa9") == 3);
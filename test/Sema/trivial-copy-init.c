@@ -0,0 +1,18 @@
+// RUN: %clang_cc1 -fsyntax-only -print-stats %s 2>&1 | FileCheck %s
+// RUN: %clang_cc1 -x c++ -fsyntax-only -print-stats %s 2>&1 | FileCheck %s
+// RUN: %clang_cc1 -triple x86_64-apple-darwin10 -emit-llvm -o - %s | FileCheck %s -check-prefix=IR
+
+int f(int a, long b);
+
+long g(int x) {
+  int y = x;
+  long z = y;
+  return f(y, z) + z;
+}
+
+// CHECK: 4/5 copy-initializations without an initialization sequence.
+
+// IR: define i64 @g(i32 %x)
+// IR: [[Y:%.*]] = load i32* %x.addr
+// IR: store i32 [[Y]], i32* %y
+// IR: call i32 @f(i32 {{%.*}}, i64 {{%.*}})
@@ -0,0 +1,13 @@
+// RUN: %clang_cc1 -fsyntax-only -Wuninitialized -Wunreachable-code -ftime-report %s 2>&1 | FileCheck %s
+
+int f(int x) {
+  int y;
+  if (x)
+    return y;
+  return 0;
+}
+
+// CHECK: Analysis-Based Warnings
+// CHECK-DAG: CFG Construction
+// CHECK-DAG: Uninitialized Values Analysis
+// CHECK-DAG: Unreachable Code Analysis
@@ -0,0 +1,17 @@
+// RUN: %clang_cc1 -fsyntax-only -Wdocumentation -I %S/Inputs -verify %s
+
+// Comments are only attached to declarations of the same file.
+
+/// \param z Not attached to anything: an inclusion follows.
+#include "warn-documentation-files.h"
+void after_include(int y);
+
+/// \param z Misnamed.
+// expected-warning@-1 {{parameter 'z' not found in the function declaration}}
+// expected-note@-2 {{did you mean 'a'?}}
+void documented(int a);
+
+struct S {
+  int field; ///< \param w Misnamed.
+  // expected-warning@-1 {{'\param' command used in a comment that is not attached to a function declaration}}
+};
@@ -0,0 +1,27 @@
+// RUN: %clang_cc1 -fsyntax-only -verify -Wno-unused-value %s
+// Unused results are still diagnosed where a pragma enables the warnings
+// that are disabled on the command line.
+
+int i;
+int f(void) __attribute__((warn_unused_result));
+
+void disabled(void) {
+  i;
+  i == 1;
+  f();
+}
+
+#pragma clang diagnostic push
+#pragma clang diagnostic warning "-Wunused-value"
+void enabled_value(void) {
+  i; // expected-warning {{expression result unused}}
+  f(); // expected-warning {{ignoring return value of function declared with warn_unused_result attribute}}
+}
+#pragma clang diagnostic pop
+
+#pragma clang diagnostic warning "-Wunused-comparison"
+void enabled_comparison(void) {
+  i;
+  i == 1; // expected-warning {{equality comparison result unused}} \
+          // expected-note {{use '=' to turn this equality comparison into an assignment}}
+}
@@ -0,0 +1,34 @@
+// RUN: %clang_cc1 -fsyntax-only -verify %s
+// RUN: %clang_cc1 -fsyntax-only -DSTATS -print-stats %s 2>&1 | FileCheck %s
+
+namespace N {
+  struct Base {};
+  void g(Base *);
+}
+
+// A class is only associated with the namespaces of its bases once it is
+// complete.
+struct Incomplete;
+#ifndef STATS
+void before(Incomplete *p) {
+  g(p); // expected-error {{use of undeclared identifier 'g'}}
+}
+#endif
+struct Incomplete : N::Base {};
+void after(Incomplete *p) {
+  g(p);
+}
+
+namespace M {
+  template<typename L, typename R> struct Sum {};
+  template<typename T> struct Leaf {};
+  template<typename L, typename R>
+  Sum<L, R> operator+(const L &, const R &);
+  template<typename T> int eval(const T &);
+}
+
+int sums(M::Leaf<int> a, M::Leaf<double> b) {
+  return eval(a + b) + eval(a + b) + eval(b + a) + eval(a + b + a);
+}
+
+// CHECK: {{[1-9][0-9]*}}/{{[1-9][0-9]*}} cached associated namespace sets reused.
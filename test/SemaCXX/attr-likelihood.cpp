@@ -0,0 +1,20 @@
+// RUN: %clang_cc1 -fsyntax-only -verify -std=c++11 %s
+
+void f(int x) {
+  if (x) [[clang::likely]]
+    ;
+  else [[clang::unlikely]]
+    ;
+
+  if (x) [[clang::likely]] [[clang::unlikely]] // expected-error {{'likely' and 'unlikely' attributes are not compatible}}
+    ;
+
+  switch (x) {
+  [[clang::unlikely]] case 0:
+    break;
+  case 1: [[clang::likely]]
+    break;
+  [[clang::likely]] default:
+    break;
+  }
+}
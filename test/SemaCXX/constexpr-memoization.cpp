@@ -0,0 +1,30 @@
+// RUN: %clang_cc1 -std=c++11 -fsyntax-only -verify -fconstexpr-depth 32 %s
+// RUN: %clang_cc1 -std=c++11 -fsyntax-only -fconstexpr-depth 32 -DSTATS -print-stats %s 2>&1 | FileCheck %s
+
+constexpr int fib(int n) { return n < 2 ? n : fib(n - 1) + fib(n - 2); }
+static_assert(fib(24) == 46368, "");
+static_assert(fib(24) + fib(23) == fib(25), "");
+
+// A memoized call must still respect the call depth limit when it is made
+// from deeper in the call stack.
+constexpr int depth(int n) { return n > 1 ? depth(n - 1) : 0; } // expected-note {{exceeded maximum depth}} expected-note +{{in call to 'depth(}}
+static_assert(depth(32) == 0, "");
+constexpr int nest(int k, int n) { return k ? nest(k - 1, n) : depth(n); } // expected-note +{{in call to}}
+#ifndef STATS
+constexpr int kBad = nest(1, 32); // expected-error {{must be initialized by a constant expression}} expected-note {{in call to 'nest(1, 32)'}}
+#endif
+
+// Calls on an object are not memoized.
+struct S {
+  int n;
+  constexpr int get() const { return n; }
+};
+constexpr S s1 = { 1 }, s2 = { 2 };
+static_assert(s1.get() == 1 && s2.get() == 2, "");
+
+// Neither are calls whose results refer to an object.
+constexpr const int *addr(const int *p) { return p; }
+constexpr int x = 0, y = 0;
+static_assert(addr(&x) == &x && addr(&y) == &y, "");
+
+// CHECK: {{[1-9][0-9]*}}/{{[1-9][0-9]*}} memoized constexpr function calls reused
@@ -0,0 +1,47 @@
+// RUN: %clang_cc1 -fsyntax-only -verify %s
+// RUN: %clang_cc1 -fsyntax-only -DSTATS -print-stats %s 2>&1 | FileCheck %s
+
+struct Stream {};
+Stream &operator<<(Stream &, int);
+Stream &operator<<(Stream &, double);
+Stream &operator<<(Stream &, const char *);
+Stream &operator<<(Stream &, const void *);
+
+void log(Stream &s, int i, double d) {
+  s << i << d << "text" << &i;
+  s << d << i << &d << "text";
+}
+
+// Whether an integral argument is a null pointer constant depends on the
+// expression, not only its type.
+char *pick(void *);
+int pick(...);
+void nulls(int n) {
+  int a = pick(n);
+  char *b = pick(0);
+  int c = pick(n);
+}
+
+// So does whether a string literal converts to a pointer to non-const.
+char *lit(char *);
+int lit(...);
+void literals(const char *p) {
+  char *a = lit("text"); // expected-warning {{conversion from string literal to 'char *' is deprecated}}
+  int b = lit(p);
+}
+
+#ifndef STATS
+struct A {};
+struct B {};
+void take(int); // expected-note 2{{candidate function not viable: no known conversion from 'A' to 'int' for 1st argument}} \
+                // expected-note {{candidate function not viable: no known conversion from 'B' to 'int' for 1st argument}}
+void take(long); // expected-note 2{{candidate function not viable: no known conversion from 'A' to 'long' for 1st argument}} \
+                 // expected-note {{candidate function not viable: no known conversion from 'B' to 'long' for 1st argument}}
+void bad(A a, B b) {
+  take(a); // expected-error {{no matching function for call to 'take'}}
+  take(b); // expected-error {{no matching function for call to 'take'}}
+  take(a); // expected-error {{no matching function for call to 'take'}}
+}
+#endif
+
+// CHECK: {{[1-9][0-9]*}}/{{[1-9][0-9]*}} cached conversion sequences reused.
@@ -0,0 +1,16 @@
+// RUN: %clang_cc1 -fsyntax-only -verify %s
+// RUN: %clang_cc1 -fsyntax-only -print-stats %s 2>&1 | FileCheck %s
+
+class C {
+  typedef int T; // expected-note 2 {{implicitly declared private here}}
+  friend T get(T, T);
+};
+
+// The access to C::T succeeds once in the context of the friend and is
+// reused for its other uses in the declaration.
+C::T get(C::T a, C::T b) { return a + b; }
+
+// A failed access is diagnosed at each use.
+C::T bad(C::T); // expected-error 2 {{'T' is a private member of 'C'}}
+
+// CHECK: {{^[1-9][0-9]*}} delayed access checks reused.
@@ -31,3 +31,34 @@ void overload_okay(E2*);
 void overload_call(F2* f2) {
   overload_okay(f2);
 }
+
+// The subobjects within a virtual base are shared, however many paths lead
+// to it; those of non-virtual bases are not.
+class Object3 { };
+class V3 : public Object3 { };
+class L3 : public virtual V3 { };
+class R3 : public virtual V3 { };
+class M3 : public L3, public R3 { };
+class N3 : public M3, public virtual V3 { };
+class P3 : public L3, public Object3 { };
+class Q3 : public N3, public virtual Object3 { };
+class S3 : public virtual Object3, public virtual L3 { };
+
+void h(M3* m3, N3* n3, P3* p3, Q3* q3, S3* s3) {
+  Object3* o3;
+  o3 = m3;
+  o3 = n3;
+  o3 = p3; // expected-error{{ambiguous conversion from derived class 'P3' to base class 'Object3':}} expected-error{{assigning to 'Object3 *' from incompatible type 'P3 *'}}
+  o3 = q3; // expected-error{{ambiguous conversion from derived class 'Q3' to base class 'Object3':}} expected-error{{assigning to 'Object3 *' from incompatible type 'Q3 *'}}
+  o3 = s3; // expected-error{{ambiguous conversion from derived class 'S3' to base class 'Object3':}} expected-error{{assigning to 'Object3 *' from incompatible type 'S3 *'}}
+  V3* v3 = q3;
+}
+
+// Bases introduced by instantiation are seen by the conversion.
+template<typename T> class W4 : public T, public R3 { };
+W4<L3> w4l;
+W4<Object3> w4o;
+void i() {
+  Object3* o4 = &w4l;
+  o4 = &w4o; // expected-error{{ambiguous conversion from derived class 'W4<Object3>' to base class 'Object3':}} expected-error{{assigning to 'Object3 *' from incompatible type 'W4<Object3> *'}}
+}
@@ -0,0 +1,25 @@
+// RUN: %clang_cc1 -std=c++11 -fsyntax-only -verify %s
+// RUN: %clang_cc1 -std=c++11 -fsyntax-only -print-stats %s 2>&1 | FileCheck %s
+
+int f(int, char);
+int f(int, char);
+int g(int, char) throw(int);
+int g(int, char) throw(int);
+int g(int, char) throw(char); // expected-error {{exception specification in declaration does not match previous declaration}} expected-note@7 {{previous declaration is here}}
+
+struct S {
+  void m() const;
+  void m() volatile;
+  void n() &;
+  void n() &&;
+};
+
+// Function types which differ in any component are distinct.
+static_assert(__is_same(void(int), void(int)), "");
+static_assert(!__is_same(void(int), void(int, ...)), "");
+static_assert(!__is_same(void(int), int(int)), "");
+static_assert(!__is_same(void(int), void(long)), "");
+static_assert(!__is_same(void (S::*)() const, void (S::*)() volatile), "");
+static_assert(!__is_same(void (S::*)() &, void (S::*)() &&), "");
+
+// CHECK: {{[1-9][0-9]*}}/{{[1-9][0-9]*}} function type lookups found in the type cache
@@ -0,0 +1,13 @@
+// RUN: %clang_cc1 -fsyntax-only -print-stats %s 2>&1 | FileCheck %s
+// RUN: %clang_cc1 -x c -fsyntax-only -print-stats %s 2>&1 | FileCheck %s
+
+int f(int x) {
+  int y = x;
+  {
+    int x = y;
+    y = x;
+  }
+  return x + y;
+}
+
+// CHECK: {{^[1-9][0-9]*}} unqualified lookups visited {{[1-9][0-9]*}} declarations on identifier chains.
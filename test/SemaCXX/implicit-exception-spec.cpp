@@ -96,3 +96,25 @@ namespace ImplicitDtorExceptionSpec {
     } e;
   };
 }
+
+// The exception specification of each implicit member is evaluated once and
+// kept in its type; those of derived classes build on it.
+namespace DeepHierarchy {
+  struct Throws { Throws() noexcept(false); ~Throws() noexcept(false); };
+  struct Nothrow {};
+
+  template<typename T, int N> struct Chain : Chain<T, N - 1> { T t; };
+  template<typename T> struct Chain<T, 0> { T t; };
+  template<typename T> T &ref();
+
+  static_assert(!noexcept(Chain<Throws, 32>()), "");
+  static_assert(noexcept(Chain<Nothrow, 32>()), "");
+  static_assert(!noexcept(ref<Chain<Throws, 16>>().~Chain()), "");
+  static_assert(noexcept(ref<Chain<Nothrow, 16>>().~Chain()), "");
+
+  // Asking again, or about a class in the middle of the chain, reuses the
+  // specifications already evaluated.
+  static_assert(!noexcept(Chain<Throws, 32>()), "");
+  static_assert(!noexcept(Chain<Throws, 8>()), "");
+  static_assert(noexcept(Chain<Nothrow, 8>(Chain<Nothrow, 8>())), "");
+}
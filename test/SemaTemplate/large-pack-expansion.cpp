@@ -0,0 +1,57 @@
+// RUN: %clang_cc1 -fsyntax-only -std=c++11 -verify %s
+// expected-no-diagnostics
+
+// Tuple-like types with large argument packs, built without recursion over
+// the pack.
+
+template<unsigned... Is> struct indices {};
+
+template<typename A, typename B> struct concat;
+template<unsigned... As, unsigned... Bs>
+struct concat<indices<As...>, indices<Bs...> > {
+  typedef indices<As..., (sizeof...(As) + Bs)...> type;
+};
+
+template<unsigned N> struct make_indices {
+  typedef typename concat<typename make_indices<N / 2>::type,
+                          typename make_indices<N - N / 2>::type>::type type;
+};
+template<> struct make_indices<0> { typedef indices<> type; };
+template<> struct make_indices<1> { typedef indices<0> type; };
+
+template<unsigned I, typename T> struct leaf { T value; };
+
+template<typename Is, typename... Ts> struct tuple_impl;
+template<unsigned... Is, typename... Ts>
+struct tuple_impl<indices<Is...>, Ts...> : leaf<Is, Ts>... {
+  typedef tuple_impl type;
+};
+
+template<typename... Ts>
+struct tuple
+  : tuple_impl<typename make_indices<sizeof...(Ts)>::type, Ts...> {
+  static const unsigned size = sizeof...(Ts);
+};
+
+template<unsigned I, typename T> T &get(leaf<I, T> &L) { return L.value; }
+
+template<unsigned I> struct tag { char c; };
+
+template<typename Is> struct tag_tuple;
+template<unsigned... Is> struct tag_tuple<indices<Is...> > {
+  typedef tuple<tag<Is>...> type;
+};
+
+typedef tag_tuple<make_indices<16>::type>::type Tuple16;
+typedef tag_tuple<make_indices<256>::type>::type Tuple256;
+typedef tag_tuple<make_indices<1024>::type>::type Tuple1024;
+
+static_assert(Tuple16::size == 16, "");
+static_assert(Tuple256::size == 256, "");
+static_assert(Tuple1024::size == 1024, "");
+static_assert(sizeof(Tuple1024) == 1024, "");
+
+Tuple1024 t;
+tag<0> &first = get<0>(t);
+tag<517> &middle = get<517>(t);
+tag<1023> &last = get<1023>(t);
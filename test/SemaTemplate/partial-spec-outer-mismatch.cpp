@@ -0,0 +1,64 @@
+// RUN: %clang_cc1 -fsyntax-only -std=c++11 -verify %s
+
+// Partial specializations are ruled out by the outermost form of their
+// arguments before deduction; check that this picks the same ones.
+
+template<typename T> struct W {};
+template<typename T> struct V {};
+struct S { int m; };
+
+template<typename T, int N = 0> struct Shape { static const int value = 0; };
+template<typename T> struct Shape<T*> { static const int value = 1; };
+template<typename T> struct Shape<T&> { static const int value = 2; };
+template<typename T> struct Shape<T&&> { static const int value = 3; };
+template<typename T> struct Shape<const T> { static const int value = 4; };
+template<typename T> struct Shape<T[]> { static const int value = 5; };
+template<typename T> struct Shape<T[3]> { static const int value = 6; };
+template<typename T> struct Shape<W<T> > { static const int value = 7; };
+template<typename T, typename C> struct Shape<T C::*> {
+  static const int value = 8;
+};
+template<typename R, typename A> struct Shape<R(A)> {
+  static const int value = 9;
+};
+template<typename T> struct Shape<T, 1> { static const int value = 10; };
+template<> struct Shape<long> { static const int value = 11; };
+template<template<typename> class TT, typename T> struct Shape<TT<T>, 2> {
+  static const int value = 12;
+};
+
+static_assert(Shape<int>::value == 0, "");
+static_assert(Shape<int*>::value == 1, "");
+static_assert(Shape<const int*>::value == 1, "");
+static_assert(Shape<int&>::value == 2, "");
+static_assert(Shape<int&&>::value == 3, "");
+static_assert(Shape<const int>::value == 4, "");
+static_assert(Shape<int* const>::value == 4, "");
+static_assert(Shape<int[]>::value == 5, "");
+static_assert(Shape<int[3]>::value == 6, "");
+static_assert(Shape<int[4]>::value == 0, "");
+static_assert(Shape<W<int> >::value == 7, "");
+static_assert(Shape<V<int> >::value == 0, "");
+static_assert(Shape<int S::*>::value == 8, "");
+static_assert(Shape<void(int)>::value == 9, "");
+static_assert(Shape<void(int, int)>::value == 0, "");
+static_assert(Shape<int, 1>::value == 10, "");
+static_assert(Shape<int, 3>::value == 0, "");
+static_assert(Shape<long>::value == 11, "");
+static_assert(Shape<V<int>, 2>::value == 12, "");
+static_assert(Shape<int, 2>::value == 0, "");
+
+// An argument matching several partial specializations is still ambiguous.
+template<typename T, typename U> struct Pair;
+template<typename T, typename U> struct Pair<T*, U> {}; // expected-note{{matches}}
+template<typename T, typename U> struct Pair<T, U*> {}; // expected-note{{matches}}
+Pair<int*, int*> p; // expected-error{{ambiguous partial specializations}}
+
+// Variadic arguments are left to deduction.
+template<typename... Ts> struct Pack { static const int value = 0; };
+template<typename T, typename... Ts> struct Pack<T*, Ts...> {
+  static const int value = 1;
+};
+static_assert(Pack<>::value == 0, "");
+static_assert(Pack<int*, int>::value == 1, "");
+static_assert(Pack<int, int*>::value == 0, "");
@@ -0,0 +1,23 @@
+// RUN: %clang_cc1 -std=c++11 -fsyntax-only -verify %s
+// RUN: %clang_cc1 -std=c++11 -fsyntax-only -DSTATS -print-stats %s 2>&1 | FileCheck %s
+
+template<typename T> using Ptr = T*;
+template<typename T> struct Traits { typedef T value_type; };
+template<typename T> using Value = typename Traits<T>::value_type;
+
+Ptr<int> p1;
+Ptr<int> p2 = p1;
+Ptr<float> p3;
+Value<int> v1 = 0;
+Value<int> v2 = v1;
+Value<Ptr<int> > v3 = p1;
+static_assert(!__is_same(Value<Ptr<int> >, Ptr<float>), "");
+
+#ifndef STATS
+// Substitutions which fail are not cached.
+template<typename T> using Type = typename T::type; // expected-error 2{{type 'int' cannot be used prior to '::' because it has no members}}
+Type<int> t1; // expected-note {{in instantiation of template type alias 'Type' requested here}}
+Type<int> t2; // expected-note {{in instantiation of template type alias 'Type' requested here}}
+#endif
+
+// CHECK: {{[1-9][0-9]*}}/{{[1-9][0-9]*}} cached type substitutions reused.
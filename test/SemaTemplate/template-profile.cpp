@@ -0,0 +1,27 @@
+// RUN: %clang_cc1 -fsyntax-only -ftemplate-profile %s 2>&1 | FileCheck %s
+// RUN: %clang_cc1 -fsyntax-only -ftemplate-profile-trace %t.json %s
+// RUN: FileCheck -check-prefix=TRACE %s < %t.json
+
+namespace N {
+  template<typename T> struct Box { T value; };
+  template<typename T> T twice(T t) { return t + t; }
+}
+
+N::Box<int> b1;
+N::Box<float> b2;
+int i = N::twice(1);
+
+// CHECK: *** Template Instantiation Profile:
+// CHECK: 3 instantiations.
+// CHECK: By specialization:
+// CHECK-DAG: N::Box<int>
+// CHECK-DAG: N::Box<float>
+// CHECK-DAG: N::twice<int>
+// CHECK: By point of instantiation:
+// CHECK-DAG: template-profile.cpp:10:
+// CHECK-DAG: template-profile.cpp:11:
+// CHECK-DAG: template-profile.cpp:12:
+
+// TRACE: "traceEvents": [
+// TRACE-DAG: { "name": "N::Box<int>", "cat": "instantiation", "ph": "X", {{.*}}"location": "{{.*}}template-profile.cpp:10:
+// TRACE-DAG: { "name": "N::twice<int>", "cat": "instantiation", "ph": "X"
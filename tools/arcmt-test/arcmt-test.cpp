@@ -50,6 +50,16 @@ RemappingsFile("remappings-file",
                llvm::cl::desc("Pairs of file mappings (typically the output of "
                "c-arcmt-test)"));
 
+static llvm::cl::opt<std::string>
+MigrateDirectory("migrate-directory",
+                 llvm::cl::desc("Migrate all the inputs, producing temporary "
+                                "files and metadata into this directory"));
+
+static llvm::cl::opt<unsigned>
+NumThreads("j", llvm::cl::init(1),
+           llvm::cl::desc("Number of inputs to migrate concurrently "
+                          "(0 = number of hardware threads)"));
+
 static llvm::cl::list<std::string>
 ResultFiles(llvm::cl::Positional, llvm::cl::desc("<filename>..."));
 
@@ -202,6 +212,30 @@ static bool performTransformations(StringRef resourcesPath,
   return false;
 }
 
+static bool migrateToDirectory(ArrayRef<const char *> Args) {
+  DiagnosticOptions DiagOpts;
+  DiagnosticConsumer *DiagClient =
+    new TextDiagnosticPrinter(llvm::errs(), DiagOpts);
+  IntrusiveRefCntPtr<DiagnosticIDs> DiagID(new DiagnosticIDs());
+  IntrusiveRefCntPtr<DiagnosticsEngine> TopDiags(
+      new DiagnosticsEngine(DiagID, DiagClient));
+
+  CompilerInvocation origCI;
+  if (!CompilerInvocation::CreateFromArgs(origCI, Args.begin(), Args.end(),
+                                          *TopDiags))
+    return true;
+
+  if (origCI.getFrontendOpts().Inputs.empty()) {
+    llvm::errs() << "error: no input files\n";
+    return true;
+  }
+
+  CompilerInvocation *Invocations[] = { &origCI };
+  return arcmt::migrateWithTemporaryFilesInParallel(Invocations, llvm::errs(),
+                                                    MigrateDirectory,
+                                                    false, NumThreads);
+}
+
 static bool filesCompareEqual(StringRef fname1, StringRef fname2) {
   using namespace llvm;
 
@@ -372,5 +406,8 @@ int main(int argc, const char **argv) {
   if (CheckOnly)
     return checkForMigration(resourcesPath, Args);
 
+  if (!MigrateDirectory.empty())
+    return migrateToDirectory(Args);
+
   return performTransformations(resourcesPath, Args);
 }
@@ -7,6 +7,7 @@
 #include <stdlib.h>
 #include <stdio.h>
 #include <string.h>
+#include <time.h>
 #include <assert.h>
 
 #ifdef CLANG_HAVE_LIBXML
@@ -66,8 +67,14 @@ static unsigned getDefaultParsingOptions() {
     options &= ~CXTranslationUnit_CacheCompletionResults;
   if (getenv("CINDEXTEST_SKIP_FUNCTION_BODIES"))
     options |= CXTranslationUnit_SkipFunctionBodies;
+  if (getenv("CINDEXTEST_SKIP_FUNCTION_BODIES_OUTSIDE_MAIN_FILE"))
+    options |= CXTranslationUnit_SkipFunctionBodiesOutsideMainFile;
   if (getenv("CINDEXTEST_COMPLETION_BRIEF_COMMENTS"))
     options |= CXTranslationUnit_IncludeBriefCommentsInCodeCompletion;
+  if (getenv("CINDEXTEST_BACKGROUND_PREAMBLE"))
+    options |= CXTranslationUnit_BackgroundPreamble;
+  if (getenv("CINDEXTEST_THREAD_SAFE_QUERIES"))
+    options |= CXTranslationUnit_ThreadSafeQueries;
   
   return options;
 }
@@ -1718,6 +1725,21 @@ int my_stricmp(const char *s1, const char *s2) {
   return 0;
 }
 
+/* Prints the size of every batch of code-completion results and cancels code
+ * completion after the number of batches *client_data points to, if any. */
+static unsigned print_completion_batch(CXCompletionResult *Results,
+                                       unsigned NumResults,
+                                       CXClientData client_data) {
+  int *RemainingBatches = (int *)client_data;
+  (void)Results;
+  printf("Completion batch: %u results\n", NumResults);
+  if (*RemainingBatches > 0 && --*RemainingBatches == 0) {
+    printf("Cancelled code completion\n");
+    return 1;
+  }
+  return 0;
+}
+
 int perform_code_completion(int argc, const char **argv, int timing_only) {
   const char *input = argv[1];
   char *filename = 0;
@@ -1731,11 +1753,20 @@ int perform_code_completion(int argc, const char **argv, int timing_only) {
   CXTranslationUnit TU = 0;
   unsigned I, Repeats = 1;
   unsigned completionOptions = clang_defaultCodeCompleteOptions();
+  const char *completionPrefix = getenv("CINDEXTEST_COMPLETION_PREFIX");
+  unsigned batchSize = 0;
+  int remainingBatches = 0;
   
+  if (getenv("CINDEXTEST_COMPLETION_BATCH_SIZE"))
+    batchSize = atoi(getenv("CINDEXTEST_COMPLETION_BATCH_SIZE"));
+  if (getenv("CINDEXTEST_COMPLETION_CANCEL_AFTER"))
+    remainingBatches = atoi(getenv("CINDEXTEST_COMPLETION_CANCEL_AFTER"));
   if (getenv("CINDEXTEST_CODE_COMPLETE_PATTERNS"))
     completionOptions |= CXCodeComplete_IncludeCodePatterns;
   if (getenv("CINDEXTEST_COMPLETION_BRIEF_COMMENTS"))
     completionOptions |= CXCodeComplete_IncludeBriefComments;
+  if (getenv("CINDEXTEST_COMPLETION_FUZZY"))
+    completionOptions |= CXCodeComplete_FuzzyPrefix;
   
   if (timing_only)
     input += strlen("-code-completion-timing=");
@@ -1769,9 +1800,18 @@ int perform_code_completion(int argc, const char **argv, int timing_only) {
   }
   
   for (I = 0; I != Repeats; ++I) {
-    results = clang_codeCompleteAt(TU, filename, line, column,
-                                   unsaved_files, num_unsaved_files,
-                                   completionOptions);
+    if (completionPrefix || batchSize)
+      results = clang_codeCompleteAtWithCallback(TU, filename, line, column,
+                                                 unsaved_files,
+                                                 num_unsaved_files,
+                                                 completionOptions,
+                                                 completionPrefix, batchSize,
+                                        batchSize ? print_completion_batch : 0,
+                                                 &remainingBatches);
+    else
+      results = clang_codeCompleteAt(TU, filename, line, column,
+                                     unsaved_files, num_unsaved_files,
+                                     completionOptions);
     if (!results) {
       fprintf(stderr, "Unable to perform code completion!\n");
       return 1;
@@ -1843,6 +1883,269 @@ int perform_code_completion(int argc, const char **argv, int timing_only) {
   return 0;
 }
 
+/* Performs code completion at every CINDEXTEST_COMPLETION_STRIDE'th
+ * identifier in a file, as though its first CINDEXTEST_COMPLETION_PREFIX_LENGTH
+ * characters had been typed, and reports how long that took. */
+static int perform_code_completion_benchmark(int argc, const char **argv) {
+  const char *filename = argv[1] + strlen("-code-completion-benchmark=");
+  CXIndex CIdx;
+  CXTranslationUnit TU;
+  CXFile file;
+  CXSourceRange range;
+  CXToken *tokens = 0;
+  unsigned num_tokens;
+  struct CXUnsavedFile *unsaved_files = 0;
+  int num_unsaved_files = 0;
+  unsigned completionOptions = clang_defaultCodeCompleteOptions();
+  unsigned prefixLength = 0, stride = 1;
+  unsigned num_sites = 0, num_identifiers = 0, num_results = 0, i;
+  unsigned *lines, *columns;
+  char **prefixes;
+  FILE *fp;
+  long size;
+  clock_t start;
+  double seconds;
+
+  if (getenv("CINDEXTEST_COMPLETION_PREFIX_LENGTH"))
+    prefixLength = atoi(getenv("CINDEXTEST_COMPLETION_PREFIX_LENGTH"));
+  if (getenv("CINDEXTEST_COMPLETION_STRIDE"))
+    stride = atoi(getenv("CINDEXTEST_COMPLETION_STRIDE"));
+  if (stride == 0)
+    stride = 1;
+  if (getenv("CINDEXTEST_CODE_COMPLETE_PATTERNS"))
+    completionOptions |= CXCodeComplete_IncludeCodePatterns;
+  if (getenv("CINDEXTEST_COMPLETION_FUZZY"))
+    completionOptions |= CXCodeComplete_FuzzyPrefix;
+
+  if (!(fp = fopen(filename, "r"))) {
+    fprintf(stderr, "Unable to open '%s'\n", filename);
+    return 1;
+  }
+  fseek(fp, 0, SEEK_END);
+  size = ftell(fp);
+  fclose(fp);
+
+  if (parse_remapped_files(argc, argv, 2, &unsaved_files, &num_unsaved_files))
+    return -1;
+
+  CIdx = clang_createIndex(0, 0);
+  TU = clang_parseTranslationUnit(CIdx, 0,
+                                  argv + num_unsaved_files + 2,
+                                  argc - num_unsaved_files - 2,
+                                  unsaved_files, num_unsaved_files,
+                                  getDefaultParsingOptions());
+  if (!TU) {
+    fprintf(stderr, "Unable to load translation unit!\n");
+    return 1;
+  }
+
+  if (clang_reparseTranslationUnit(TU, num_unsaved_files, unsaved_files,
+                                   clang_defaultReparseOptions(TU))) {
+    fprintf(stderr, "Unable to reparse translation unit!\n");
+    return 1;
+  }
+
+  /* Collect the completion sites before completing at any of them. */
+  file = clang_getFile(TU, filename);
+  range = clang_getRange(clang_getLocationForOffset(TU, file, 0),
+                         clang_getLocationForOffset(TU, file, size));
+  clang_tokenize(TU, range, &tokens, &num_tokens);
+  lines = (unsigned *)malloc(sizeof(unsigned) * (num_tokens + 1));
+  columns = (unsigned *)malloc(sizeof(unsigned) * (num_tokens + 1));
+  prefixes = (char **)malloc(sizeof(char *) * (num_tokens + 1));
+  for (i = 0; i != num_tokens; ++i) {
+    CXString spelling;
+    size_t length;
+
+    if (clang_getTokenKind(tokens[i]) != CXToken_Identifier)
+      continue;
+    if (num_identifiers++ % stride != 0)
+      continue;
+
+    clang_getSpellingLocation(clang_getTokenLocation(TU, tokens[i]), 0,
+                              &lines[num_sites], &columns[num_sites], 0);
+    spelling = clang_getTokenSpelling(TU, tokens[i]);
+    length = strlen(clang_getCString(spelling));
+    if (length > prefixLength)
+      length = prefixLength;
+    prefixes[num_sites] = (char *)malloc(length + 1);
+    memcpy(prefixes[num_sites], clang_getCString(spelling), length);
+    prefixes[num_sites][length] = 0;
+    clang_disposeString(spelling);
+    ++num_sites;
+  }
+  clang_disposeTokens(TU, tokens, num_tokens);
+
+  start = clock();
+  for (i = 0; i != num_sites; ++i) {
+    CXCodeCompleteResults *results
+      = clang_codeCompleteAtWithCallback(TU, filename, lines[i], columns[i],
+                                         unsaved_files, num_unsaved_files,
+                                         completionOptions, prefixes[i],
+                                         0, 0, 0);
+    if (!results) {
+      fprintf(stderr, "Unable to perform code completion at %u:%u!\n",
+              lines[i], columns[i]);
+      return 1;
+    }
+    num_results += results->NumResults;
+    clang_disposeCodeCompleteResults(results);
+  }
+  seconds = (double)(clock() - start) / CLOCKS_PER_SEC;
+
+  printf("Completed at %u positions: %u results in %.3f seconds\n",
+         num_sites, num_results, seconds);
+
+  for (i = 0; i != num_sites; ++i)
+    free(prefixes[i]);
+  free(prefixes);
+  free(columns);
+  free(lines);
+  clang_disposeTranslationUnit(TU);
+  clang_disposeIndex(CIdx);
+  free_remapped_files(unsaved_files, num_unsaved_files);
+  return 0;
+}
+
+static enum CXChildVisitResult USRBenchmarkVisitor(CXCursor C, CXCursor parent,
+                                                   CXClientData data) {
+  unsigned *num_usrs = (unsigned *)data;
+  CXString USR;
+
+  /* Like an indexer, also ask for the USRs of referenced declarations. */
+  if (clang_isReference(C.kind) || clang_isExpression(C.kind))
+    C = clang_getCursorReferenced(C);
+  if (clang_Cursor_isNull(C))
+    return CXChildVisit_Recurse;
+
+  USR = clang_getCursorUSR(C);
+  if (clang_getCString(USR)[0])
+    ++*num_usrs;
+  clang_disposeString(USR);
+  return CXChildVisit_Recurse;
+}
+
+/* Computes the USRs of the declarations of a translation unit, and of those
+ * referenced within it, as many times as requested, and reports how long
+ * that took. */
+static int perform_usr_benchmark(int argc, const char **argv) {
+  unsigned rounds = atoi(argv[1] + strlen("-usr-benchmark="));
+  CXIndex CIdx;
+  CXTranslationUnit TU;
+  struct CXUnsavedFile *unsaved_files = 0;
+  int num_unsaved_files = 0;
+  unsigned num_usrs = 0, i;
+  clock_t start;
+  double seconds;
+
+  if (parse_remapped_files(argc, argv, 2, &unsaved_files, &num_unsaved_files))
+    return -1;
+
+  CIdx = clang_createIndex(0, 0);
+  TU = clang_parseTranslationUnit(CIdx, 0,
+                                  argv + num_unsaved_files + 2,
+                                  argc - num_unsaved_files - 2,
+                                  unsaved_files, num_unsaved_files,
+                                  getDefaultParsingOptions());
+  if (!TU) {
+    fprintf(stderr, "Unable to load translation unit!\n");
+    return 1;
+  }
+
+  start = clock();
+  for (i = 0; i != rounds; ++i)
+    clang_visitChildren(clang_getTranslationUnitCursor(TU),
+                        USRBenchmarkVisitor, &num_usrs);
+  seconds = (double)(clock() - start) / CLOCKS_PER_SEC;
+
+  printf("Computed %u USRs in %u rounds in %.3f seconds\n", num_usrs, rounds,
+         seconds);
+
+  clang_disposeTranslationUnit(TU);
+  clang_disposeIndex(CIdx);
+  free_remapped_files(unsaved_files, num_unsaved_files);
+  return 0;
+}
+
+/* Whether the index kept the AST of a translation unit loaded. */
+static const char *getASTState(CXTranslationUnit TU) {
+  CXTUResourceUsage Usage = clang_getCXTUResourceUsage(TU);
+  const char *State = "unloaded";
+  unsigned I;
+  for (I = 0; I != Usage.numEntries; ++I)
+    if (Usage.entries[I].kind == CXTUResourceUsage_AST)
+      State = "loaded";
+  clang_disposeCXTUResourceUsage(Usage);
+  return State;
+}
+
+typedef struct {
+  CXTranslationUnit Main, Other;
+  unsigned Visited;
+} MemoryBudgetData;
+
+static enum CXChildVisitResult MemoryBudgetVisitor(CXCursor C, CXCursor Parent,
+                                                   CXClientData ClientData) {
+  MemoryBudgetData *Data = (MemoryBudgetData *)ClientData;
+  CXString Spelling;
+
+  /* Use the other translation unit while the main one is being visited; the
+     index must not unload the main one to make room for it. */
+  if (Data->Visited++ == 0) {
+    clang_getTranslationUnitCursor(Data->Other);
+    printf("in visitor: main %s, other %s\n", getASTState(Data->Main),
+           getASTState(Data->Other));
+  }
+
+  Spelling = clang_getCursorSpelling(C);
+  printf("visiting %s\n", clang_getCString(Spelling));
+  clang_disposeString(Spelling);
+  return CXChildVisit_Continue;
+}
+
+static int perform_test_memory_budget(int argc, const char **argv) {
+  const char *other_file = argv[2];
+  CXIndex CIdx;
+  MemoryBudgetData Data;
+  struct CXUnsavedFile *unsaved_files = 0;
+  int num_unsaved_files = 0;
+  int result = 0;
+
+  if (parse_remapped_files(argc, argv, 3, &unsaved_files, &num_unsaved_files))
+    return -1;
+
+  CIdx = clang_createIndex(0, 0);
+  /* Every translation unit is over this budget. */
+  clang_CXIndex_setMemoryBudget(CIdx, 1);
+  Data.Main = clang_parseTranslationUnit(CIdx, 0,
+                                         argv + num_unsaved_files + 3,
+                                         argc - num_unsaved_files - 3,
+                                         unsaved_files, num_unsaved_files,
+                                         getDefaultParsingOptions());
+  Data.Other = clang_parseTranslationUnit(CIdx, other_file, 0, 0, 0, 0,
+                                          getDefaultParsingOptions());
+  Data.Visited = 0;
+  if (!Data.Main || !Data.Other) {
+    fprintf(stderr, "Unable to load translation unit!\n");
+    result = 1;
+  } else {
+    printf("after parsing: main %s, other %s\n", getASTState(Data.Main),
+           getASTState(Data.Other));
+    clang_visitChildren(clang_getTranslationUnitCursor(Data.Main),
+                        MemoryBudgetVisitor, &Data);
+    printf("after visiting: main %s, other %s\n", getASTState(Data.Main),
+           getASTState(Data.Other));
+  }
+
+  if (Data.Main)
+    clang_disposeTranslationUnit(Data.Main);
+  if (Data.Other)
+    clang_disposeTranslationUnit(Data.Other);
+  clang_disposeIndex(CIdx);
+  free_remapped_files(unsaved_files, num_unsaved_files);
+  return result;
+}
+
 typedef struct {
   char *filename;
   unsigned line;
@@ -2543,6 +2846,64 @@ static int index_file(int argc, const char **argv) {
   return result;
 }
 
+static int index_compile_db(int argc, const char **argv) {
+  const char *check_prefix;
+  CXIndex Idx;
+  CXIndexAction idxAction;
+  CXCompilationDatabase db;
+  CXCompilationDatabase_Error ec;
+  IndexData index_data;
+  unsigned index_opts;
+  int result;
+
+  check_prefix = 0;
+  if (argc > 0) {
+    if (strstr(argv[0], "-check-prefix=") == argv[0]) {
+      check_prefix = argv[0] + strlen("-check-prefix=");
+      ++argv;
+      --argc;
+    }
+  }
+
+  if (argc == 0) {
+    fprintf(stderr, "no compilation database directory\n");
+    return -1;
+  }
+
+  db = clang_CompilationDatabase_fromDirectory(argv[0], &ec);
+  if (!db) {
+    fprintf(stderr, "unable to load compilation database\n");
+    return -1;
+  }
+
+  if (!(Idx = clang_createIndex(/* excludeDeclsFromPCH */ 1,
+                                /* displayDiagnosics=*/1))) {
+    fprintf(stderr, "Could not create Index\n");
+    clang_CompilationDatabase_dispose(db);
+    return 1;
+  }
+
+  index_data.check_prefix = check_prefix;
+  index_data.first_check_printed = 0;
+  index_data.fail_for_error = 0;
+  index_data.abort = 0;
+
+  index_opts = getIndexOptions();
+  idxAction = clang_IndexAction_create(Idx);
+  /* The callbacks print as they go, so use a single thread to keep the
+     output deterministic. */
+  result = clang_indexCompilationDatabase(idxAction, &index_data,
+                                          &IndexCB, sizeof(IndexCB),
+                                          index_opts, db, /*num_threads=*/1);
+  if (index_data.fail_for_error)
+    result = -1;
+
+  clang_IndexAction_dispose(idxAction);
+  clang_disposeIndex(Idx);
+  clang_CompilationDatabase_dispose(db);
+  return result;
+}
+
 static int index_tu(int argc, const char **argv) {
   CXIndex Idx;
   CXIndexAction idxAction;
@@ -2686,15 +3047,29 @@ int perform_token_annotation(int argc, const char **argv) {
   }
 
   range = clang_getRange(startLoc, endLoc);
-  clang_tokenize(TU, range, &tokens, &num_tokens);
+  if (getenv("CINDEXTEST_TOKENIZE_AND_ANNOTATE")) {
+    num_tokens = clang_tokenizeAndAnnotate(TU, range, 0, 0, 0);
+    tokens = (CXToken *)malloc(num_tokens * sizeof(CXToken));
+    cursors = (CXCursor *)malloc(num_tokens * sizeof(CXCursor));
+    if (clang_tokenizeAndAnnotate(TU, range, tokens, cursors,
+                                  num_tokens) != num_tokens) {
+      fprintf(stderr, "number of tokens changed between calls\n");
+      free(tokens);
+      free(cursors);
+      errorCode = -1;
+      goto teardown;
+    }
+  } else {
+    clang_tokenize(TU, range, &tokens, &num_tokens);
 
-  if (checkForErrors(TU) != 0) {
-    errorCode = -1;
-    goto teardown;
-  }
+    if (checkForErrors(TU) != 0) {
+      errorCode = -1;
+      goto teardown;
+    }
 
-  cursors = (CXCursor *)malloc(num_tokens * sizeof(CXCursor));
-  clang_annotateTokens(TU, tokens, num_tokens, cursors);
+    cursors = (CXCursor *)malloc(num_tokens * sizeof(CXCursor));
+    clang_annotateTokens(TU, tokens, num_tokens, cursors);
+  }
 
   if (checkForErrors(TU) != 0) {
     errorCode = -1;
@@ -2728,7 +3103,10 @@ int perform_token_annotation(int argc, const char **argv) {
     printf("\n");
   }
   free(cursors);
-  clang_disposeTokens(TU, tokens, num_tokens);
+  if (getenv("CINDEXTEST_TOKENIZE_AND_ANNOTATE"))
+    free(tokens);
+  else
+    clang_disposeTokens(TU, tokens, num_tokens);
 
  teardown:
   PrintDiagnostics(TU);
@@ -3232,10 +3610,17 @@ static void print_usage(void) {
   fprintf(stderr,
     "usage: c-index-test -code-completion-at=<site> <compiler arguments>\n"
     "       c-index-test -code-completion-timing=<site> <compiler arguments>\n"
+    "       c-index-test -code-completion-benchmark=<file> "
+          "<compiler arguments>\n"
+    "       c-index-test -usr-benchmark=<rounds> <compiler arguments>\n"
+    "       c-index-test -test-memory-budget <other source file> "
+          "<compiler arguments>\n"
     "       c-index-test -cursor-at=<site> <compiler arguments>\n"
     "       c-index-test -file-refs-at=<site> <compiler arguments>\n"
     "       c-index-test -index-file [-check-prefix=<FileCheck prefix>] <compiler arguments>\n"
     "       c-index-test -index-tu [-check-prefix=<FileCheck prefix>] <AST file>\n"
+    "       c-index-test -index-compile-db [-check-prefix=<FileCheck prefix>] "
+          "<build directory>\n"
     "       c-index-test -test-file-scan <AST file> <source file> "
           "[FileCheck prefix]\n");
   fprintf(stderr,
@@ -3287,6 +3672,12 @@ int cindextest_main(int argc, const char **argv) {
     return perform_code_completion(argc, argv, 0);
   if (argc > 2 && strstr(argv[1], "-code-completion-timing=") == argv[1])
     return perform_code_completion(argc, argv, 1);
+  if (argc > 2 && strstr(argv[1], "-code-completion-benchmark=") == argv[1])
+    return perform_code_completion_benchmark(argc, argv);
+  if (argc > 2 && strstr(argv[1], "-usr-benchmark=") == argv[1])
+    return perform_usr_benchmark(argc, argv);
+  if (argc > 3 && strcmp(argv[1], "-test-memory-budget") == 0)
+    return perform_test_memory_budget(argc, argv);
   if (argc > 2 && strstr(argv[1], "-cursor-at=") == argv[1])
     return inspect_cursor_at(argc, argv);
   if (argc > 2 && strstr(argv[1], "-file-refs-at=") == argv[1])
@@ -3295,6 +3686,8 @@ int cindextest_main(int argc, const char **argv) {
     return index_file(argc - 2, argv + 2);
   if (argc > 2 && strcmp(argv[1], "-index-tu") == 0)
     return index_tu(argc - 2, argv + 2);
+  if (argc > 2 && strcmp(argv[1], "-index-compile-db") == 0)
+    return index_compile_db(argc - 2, argv + 2);
   else if (argc >= 4 && strncmp(argv[1], "-test-load-tu", 13) == 0) {
     CXCursorVisitor I = GetVisitor(argv[1] + 13);
     if (I)
@@ -0,0 +1,474 @@
+//===--- ClangBench.cpp - Compile-time benchmarks -------------------------===//
+//
+//                     The LLVM Compiler Infrastructure
+//
+// This file is distributed under the University of Illinois Open Source
+// License. See LICENSE.TXT for details.
+//
+//===----------------------------------------------------------------------===//
+//
+//  This file implements clang-bench, which compiles a fixed corpus of source
+//  files in-process several times, and reports as JSON the time each
+//  compilation spent in each phase and the memory it allocated, so that the
+//  throughput of the compiler can be tracked from commit to commit.
+//
+//===----------------------------------------------------------------------===//
+
+#include "clang/AST/ASTContext.h"
+#include "clang/Basic/CompilationProfile.h"
+#include "clang/Basic/Diagnostic.h"
+#include "clang/Basic/ProfilingSupport.h"
+#include "clang/Basic/Version.h"
+#include "clang/CodeGen/CodeGenAction.h"
+#include "clang/Frontend/CompilerInstance.h"
+#include "clang/Frontend/CompilerInvocation.h"
+#include "clang/Frontend/DiagnosticOptions.h"
+#include "clang/Frontend/FrontendActions.h"
+#include "clang/Frontend/TextDiagnosticPrinter.h"
+#include "llvm/ADT/OwningPtr.h"
+#include "llvm/ADT/STLExtras.h"
+#include "llvm/Support/CommandLine.h"
+#include "llvm/Support/ErrorHandling.h"
+#include "llvm/Support/Format.h"
+#include "llvm/Support/ManagedStatic.h"
+#include "llvm/Support/Path.h"
+#include "llvm/Support/PrettyStackTrace.h"
+#include "llvm/Support/Signals.h"
+#include "llvm/Support/TargetSelect.h"
+#include "llvm/Support/raw_ostream.h"
+#include <algorithm>
+#include <cstdlib>
+#include <cstring>
+#include <new>
+#include <string>
+#include <vector>
+
+using namespace clang;
+using namespace llvm;
+
+static cl::opt<std::string> CorpusDir(cl::Positional, cl::Required,
+  cl::desc("<corpus directory>"));
+
+static cl::opt<unsigned> Iterations("iterations",
+  cl::desc("Number of measured runs of each benchmark"), cl::init(5));
+
+static cl::opt<std::string> OutputFile("o",
+  cl::desc("Write the report to <file>"), cl::value_desc("file"),
+  cl::init("-"));
+
+static cl::list<std::string> OnlyBenchmarks("benchmark",
+  cl::desc("Run only the named benchmark"), cl::value_desc("name"));
+
+static cl::list<std::string> OnlyModes("mode",
+  cl::desc("Run only the named mode: preprocess, syntax or compile"),
+  cl::value_desc("mode"));
+
+//===----------------------------------------------------------------------===//
+// Allocation counting
+//===----------------------------------------------------------------------===//
+
+// Every operator new of the process goes through the ones below, which keep
+// the size of each block in front of it. Memory the compiler gets from malloc
+// directly, such as the slabs of its bump pointer allocators, is not counted;
+// the memory of the AST is reported on its own instead. Modules are built on
+// the thread which imports them, so nothing allocates concurrently.
+
+namespace {
+struct AllocationCounts {
+  uint64_t Count, Bytes, Live, PeakLive;
+};
+}
+
+static AllocationCounts Allocations;
+
+/// \brief The size of the header in front of each block, which keeps the
+/// blocks as aligned as malloc() does.
+static const size_t HeaderSize = 16;
+
+static void *allocate(size_t Size) {
+  char *Block = static_cast<char *>(malloc(HeaderSize + Size));
+  if (!Block)
+    abort();
+  *reinterpret_cast<size_t *>(Block) = Size;
+  ++Allocations.Count;
+  Allocations.Bytes += Size;
+  Allocations.Live += Size;
+  if (Allocations.Live > Allocations.PeakLive)
+    Allocations.PeakLive = Allocations.Live;
+  return Block + HeaderSize;
+}
+
+static void deallocate(void *Ptr) {
+  if (!Ptr)
+    return;
+  char *Block = static_cast<char *>(Ptr) - HeaderSize;
+  Allocations.Live -= *reinterpret_cast<size_t *>(Block);
+  free(Block);
+}
+
+void *operator new(size_t Size) throw(std::bad_alloc) {
+  return allocate(Size);
+}
+void *operator new[](size_t Size) throw(std::bad_alloc) {
+  return allocate(Size);
+}
+void *operator new(size_t Size, const std::nothrow_t &) throw() {
+  return allocate(Size);
+}
+void *operator new[](size_t Size, const std::nothrow_t &) throw() {
+  return allocate(Size);
+}
+void operator delete(void *Ptr) throw() { deallocate(Ptr); }
+void operator delete[](void *Ptr) throw() { deallocate(Ptr); }
+void operator delete(void *Ptr, const std::nothrow_t &) throw() {
+  deallocate(Ptr);
+}
+void operator delete[](void *Ptr, const std::nothrow_t &) throw() {
+  deallocate(Ptr);
+}
+
+//===----------------------------------------------------------------------===//
+// The corpus
+//===----------------------------------------------------------------------===//
+
+namespace {
+/// \brief A file of the corpus, and how to compile it.
+struct Benchmark {
+  const char *Name;
+  const char *File;
+  const char *Language;
+  /// \brief The -cc1 arguments besides the language, input and output.
+  const char *Args;
+  /// \brief A header of the corpus to precompile and include, if any.
+  const char *PCH;
+  /// \brief Whether the file imports the modules of Modules/module.map.
+  bool UsesModules;
+};
+
+enum Mode {
+  Preprocess,
+  SyntaxOnly,
+  Compile,
+  NumModes
+};
+}
+
+#define LINUX_ARGS "-triple x86_64-unknown-linux-gnu"
+#define DARWIN_ARGS "-triple x86_64-apple-macosx10.7.0 " \
+                    "-fobjc-runtime=macosx-10.7.0 -fblocks"
+
+static const Benchmark Benchmarks[] = {
+  { "c", "c.c", "c", LINUX_ARGS " -std=gnu99", 0, false },
+  { "cxx-templates", "templates.cpp", "c++", LINUX_ARGS " -std=c++11", 0,
+    false },
+  { "objc", "objc.m", "objective-c", DARWIN_ARGS, 0, false },
+  { "macros", "macros.c", "c", LINUX_ARGS " -std=gnu99", 0, false },
+  { "pch", "pch.c", "c", LINUX_ARGS " -std=gnu99", "pch.h", false },
+  { "modules", "modules.m", "objective-c", DARWIN_ARGS " -fmodules", 0,
+    true }
+};
+
+static const char *const ModeNames[NumModes] = {
+  "preprocess", "syntax", "compile"
+};
+
+//===----------------------------------------------------------------------===//
+// Running the compiler
+//===----------------------------------------------------------------------===//
+
+namespace {
+/// \brief The measurements of one compilation.
+struct RunResult {
+  double WallTime;
+  double TotalTime[CompilationProfile::NumPhases];
+  double SelfTime[CompilationProfile::NumPhases];
+  unsigned Count[CompilationProfile::NumPhases];
+  uint64_t Allocations, AllocatedBytes, PeakAllocatedBytes, ASTBytes;
+};
+
+/// MeasuringAction - Records the memory of the AST just before the compiler
+/// frees it.
+class MeasuringAction : public WrapperFrontendAction {
+  RunResult &Result;
+
+public:
+  MeasuringAction(FrontendAction *WrappedAction, RunResult &Result)
+    : WrapperFrontendAction(WrappedAction), Result(Result) {}
+
+protected:
+  virtual void EndSourceFileAction() {
+    CompilerInstance &CI = getCompilerInstance();
+    if (CI.hasASTContext())
+      Result.ASTBytes = CI.getASTContext().getASTAllocatedMemory() +
+                        CI.getASTContext().getSideTableAllocatedMemory();
+    WrapperFrontendAction::EndSourceFileAction();
+  }
+};
+}
+
+static std::string getCorpusPath(StringRef File) {
+  sys::Path Path(CorpusDir);
+  Path.appendComponent(File);
+  return Path.str();
+}
+
+/// \brief Run \p Act, which is freed, over the given -cc1 arguments,
+/// measuring the run into \p Result.
+///
+/// \returns false if the compilation failed.
+static bool runCompiler(const std::vector<std::string> &ArgStrings,
+                        FrontendAction *Act, RunResult &Result) {
+  OwningPtr<FrontendAction> Action(Act);
+  std::vector<const char *> Args;
+  for (unsigned I = 0, N = ArgStrings.size(); I != N; ++I)
+    Args.push_back(ArgStrings[I].c_str());
+
+  OwningPtr<CompilerInstance> Clang(new CompilerInstance());
+  DiagnosticOptions DiagOpts;
+  IntrusiveRefCntPtr<DiagnosticIDs> DiagID(new DiagnosticIDs());
+  DiagnosticsEngine Diags(DiagID, new TextDiagnosticPrinter(errs(), DiagOpts));
+  if (!CompilerInvocation::CreateFromArgs(Clang->getInvocation(),
+                                          &Args[0], &Args[0] + Args.size(),
+                                          Diags))
+    return false;
+  Clang->createDiagnostics(Args.size(), &Args[0]);
+  if (!Clang->hasDiagnostics())
+    return false;
+  Clang->createCompilationProfile();
+
+  memset(&Result, 0, sizeof(Result));
+  MeasuringAction Measuring(Action.take(), Result);
+  AllocationCounts Start = Allocations;
+  Allocations.PeakLive = Allocations.Live;
+  double StartTime = getCurrentTimeInSeconds();
+  bool Success = Clang->ExecuteAction(Measuring);
+  Result.WallTime = getCurrentTimeInSeconds() - StartTime;
+  Result.Allocations = Allocations.Count - Start.Count;
+  Result.AllocatedBytes = Allocations.Bytes - Start.Bytes;
+  Result.PeakAllocatedBytes = Allocations.PeakLive - Start.Live;
+  Allocations.PeakLive = std::max(Allocations.PeakLive, Start.PeakLive);
+
+  const CompilationProfile &Profile = Clang->getCompilationProfile();
+  for (unsigned I = 0; I != CompilationProfile::NumPhases; ++I) {
+    CompilationProfile::Phase P = CompilationProfile::Phase(I);
+    Result.TotalTime[I] = Profile.getTotalTime(P) / 1e9;
+    Result.SelfTime[I] = Profile.getSelfTime(P) / 1e9;
+    Result.Count[I] = Profile.getCount(P);
+  }
+  return Success;
+}
+
+/// \brief The -cc1 arguments shared by the compilations of \p B.
+static void getCommonArgs(const Benchmark &B, StringRef TempDir,
+                          std::vector<std::string> &Args) {
+  SmallVector<StringRef, 8> Split;
+  StringRef(B.Args).split(Split, " ", -1, /*KeepEmpty=*/false);
+  Args.insert(Args.end(), Split.begin(), Split.end());
+
+  // Leave the host's headers out so that every machine compiles the same
+  // code.
+  Args.push_back("-nostdsysteminc");
+  Args.push_back("-nobuiltininc");
+
+  if (B.UsesModules) {
+    sys::Path Cache(TempDir);
+    Cache.appendComponent("module-cache");
+    Args.push_back("-fmodule-cache-path");
+    Args.push_back(Cache.str());
+    Args.push_back("-I");
+    Args.push_back(getCorpusPath("Modules"));
+  }
+}
+
+static std::string getPCHPath(const Benchmark &B, StringRef TempDir) {
+  sys::Path Path(TempDir);
+  Path.appendComponent(std::string(B.Name) + ".pch");
+  return Path.str();
+}
+
+/// \brief Precompile the header of \p B, if it has one.
+static bool buildPCH(const Benchmark &B, StringRef TempDir) {
+  if (!B.PCH)
+    return true;
+
+  std::vector<std::string> Args;
+  getCommonArgs(B, TempDir, Args);
+  Args.push_back("-x");
+  Args.push_back(std::string(B.Language) + "-header");
+  Args.push_back("-o");
+  Args.push_back(getPCHPath(B, TempDir));
+  Args.push_back(getCorpusPath(B.PCH));
+  RunResult Ignored;
+  return runCompiler(Args, new GeneratePCHAction(), Ignored);
+}
+
+static bool runBenchmark(const Benchmark &B, Mode M, StringRef TempDir,
+                         RunResult &Result) {
+  std::vector<std::string> Args;
+  getCommonArgs(B, TempDir, Args);
+  if (M == Compile)
+    Args.push_back("-O2");
+  if (B.PCH) {
+    Args.push_back("-include-pch");
+    Args.push_back(getPCHPath(B, TempDir));
+  }
+  sys::Path Output(TempDir);
+  Output.appendComponent("output.o");
+  Args.push_back("-o");
+  Args.push_back(Output.str());
+  Args.push_back("-x");
+  Args.push_back(B.Language);
+  Args.push_back(getCorpusPath(B.File));
+
+  FrontendAction *Act = 0;
+  switch (M) {
+  case Preprocess: Act = new PreprocessOnlyAction(); break;
+  case SyntaxOnly: Act = new SyntaxOnlyAction();     break;
+  case Compile:    Act = new EmitObjAction();        break;
+  case NumModes:   llvm_unreachable("invalid mode");
+  }
+  return runCompiler(Args, Act, Result);
+}
+
+//===----------------------------------------------------------------------===//
+// The report
+//===----------------------------------------------------------------------===//
+
+static double getMedian(std::vector<double> Values) {
+  std::sort(Values.begin(), Values.end());
+  unsigned N = Values.size();
+  return N % 2 ? Values[N / 2] : (Values[N / 2 - 1] + Values[N / 2]) / 2;
+}
+
+
+/// \brief Print the medians of the runs of \p B in mode \p M; the peak
+/// memory is the largest of any run.
+static void printResults(raw_ostream &OS, const Benchmark &B, Mode M,
+                         const std::vector<RunResult> &Runs) {
+  std::vector<double> Values;
+  OS << "    {\n      \"name\": ";
+  printJSONString(OS, B.Name);
+  OS << ",\n      \"file\": ";
+  printJSONString(OS, B.File);
+  OS << ",\n      \"mode\": \"" << ModeNames[M] << "\",\n";
+
+  double MinWall = Runs[0].WallTime;
+  for (unsigned R = 0, N = Runs.size(); R != N; ++R) {
+    Values.push_back(Runs[R].WallTime);
+    MinWall = std::min(MinWall, Runs[R].WallTime);
+  }
+  OS << format("      \"wall\": { \"min\": %.6f, \"median\": %.6f },\n",
+               MinWall, getMedian(Values));
+
+  // Times are in seconds.
+  OS << "      \"phases\": [";
+  bool First = true;
+  for (unsigned I = 0; I != CompilationProfile::NumPhases; ++I) {
+    if (!Runs[0].Count[I])
+      continue;
+    std::vector<double> Total, Self;
+    for (unsigned R = 0, N = Runs.size(); R != N; ++R) {
+      Total.push_back(Runs[R].TotalTime[I]);
+      Self.push_back(Runs[R].SelfTime[I]);
+    }
+    OS << (First ? "\n        " : ",\n        ");
+    First = false;
+    OS << "{ \"name\": \""
+       << CompilationProfile::getPhaseName(CompilationProfile::Phase(I))
+       << "\", "
+       << format("\"total\": %.6f, \"self\": %.6f", getMedian(Total),
+                 getMedian(Self))
+       << ", \"count\": " << Runs[0].Count[I] << " }";
+  }
+  OS << "\n      ],\n";
+
+  std::vector<double> Count, Bytes;
+  uint64_t Peak = 0, AST = 0;
+  for (unsigned R = 0, N = Runs.size(); R != N; ++R) {
+    Count.push_back(Runs[R].Allocations);
+    Bytes.push_back(Runs[R].AllocatedBytes);
+    Peak = std::max(Peak, Runs[R].PeakAllocatedBytes);
+    AST = std::max(AST, Runs[R].ASTBytes);
+  }
+  OS << "      \"allocations\": " << uint64_t(getMedian(Count))
+     << ",\n      \"allocated_bytes\": " << uint64_t(getMedian(Bytes))
+     << ",\n      \"peak_allocated_bytes\": " << Peak
+     << ",\n      \"ast_bytes\": " << AST << "\n    }";
+}
+
+static bool isSelected(const cl::list<std::string> &Only, StringRef Name) {
+  return Only.empty() ||
+         std::find(Only.begin(), Only.end(), Name) != Only.end();
+}
+
+int main(int argc, char **argv) {
+  sys::PrintStackTraceOnErrorSignal();
+  PrettyStackTraceProgram X(argc, argv);
+  llvm_shutdown_obj Y;
+  cl::ParseCommandLineOptions(argc, argv, "clang compile-time benchmarks\n");
+  if (Iterations == 0)
+    Iterations = 1;
+
+  InitializeAllTargets();
+  InitializeAllTargetMCs();
+  InitializeAllAsmPrinters();
+  InitializeAllAsmParsers();
+
+  std::string Error;
+  sys::Path TempDir = sys::Path::GetTemporaryDirectory(&Error);
+  if (TempDir.isEmpty()) {
+    errs() << "error: cannot create a temporary directory: " << Error << "\n";
+    return 1;
+  }
+
+  std::string OutputError;
+  raw_fd_ostream OS(OutputFile.c_str(), OutputError);
+  if (!OutputError.empty()) {
+    errs() << "error: cannot open '" << OutputFile << "': " << OutputError
+           << "\n";
+    TempDir.eraseFromDisk(/*destroy_contents=*/true);
+    return 1;
+  }
+
+  OS << "{\n  \"version\": ";
+  printJSONString(OS, getClangFullVersion());
+  OS << ",\n  \"iterations\": " << Iterations << ",\n  \"benchmarks\": [";
+
+  bool Failed = false, First = true;
+  for (unsigned I = 0; I != array_lengthof(Benchmarks) && !Failed; ++I) {
+    const Benchmark &B = Benchmarks[I];
+    if (!isSelected(OnlyBenchmarks, B.Name))
+      continue;
+    if (!buildPCH(B, TempDir.str())) {
+      errs() << "error: cannot precompile the header of '" << B.Name
+             << "'\n";
+      Failed = true;
+      break;
+    }
+
+    for (unsigned M = 0; M != NumModes; ++M) {
+      if (!isSelected(OnlyModes, ModeNames[M]))
+        continue;
+
+      // The first run fills the caches of the file system and builds the
+      // modules, and is not measured.
+      std::vector<RunResult> Runs(Iterations + 1);
+      for (unsigned R = 0; R != Runs.size() && !Failed; ++R)
+        Failed = !runBenchmark(B, Mode(M), TempDir.str(), Runs[R]);
+      if (Failed) {
+        errs() << "error: benchmark '" << B.Name << "' failed in mode '"
+               << ModeNames[M] << "'\n";
+        break;
+      }
+      Runs.erase(Runs.begin());
+
+      OS << (First ? "\n" : ",\n");
+      First = false;
+      printResults(OS, B, Mode(M), Runs);
+    }
+  }
+  OS << "\n  ]\n}\n";
+
+  TempDir.eraseFromDisk(/*destroy_contents=*/true);
+  return Failed;
+}
@@ -0,0 +1,21 @@
+typedef __SIZE_TYPE__ size_t;
+typedef unsigned int uint32_t;
+
+void *malloc(size_t);
+void free(void *);
+int printf(const char *, ...);
+
+static inline uint32_t bench_hash(uint32_t h) {
+  h ^= h >> 16;
+  h *= 0x85ebca6b;
+  h ^= h >> 13;
+  return h;
+}
+
+struct bench_array {
+  void **items;
+  size_t count, capacity;
+};
+
+void bench_array_push(struct bench_array *a, void *item);
+void bench_array_free(struct bench_array *a);
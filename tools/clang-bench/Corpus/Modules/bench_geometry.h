@@ -0,0 +1,25 @@
+@__experimental_modules_import bench_base;
+
+struct bench_point { double x, y; };
+struct bench_rect { struct bench_point origin, size; };
+
+static inline double bench_rect_area(struct bench_rect r) {
+  return r.size.x * r.size.y;
+}
+
+static inline int bench_rect_contains(struct bench_rect r,
+                                      struct bench_point p) {
+  return p.x >= r.origin.x && p.y >= r.origin.y &&
+         p.x < r.origin.x + r.size.x && p.y < r.origin.y + r.size.y;
+}
+
+__attribute__((objc_root_class))
+@interface BenchShape {
+  struct bench_rect bounds;
+}
++ (id)alloc;
+- (id)initWithBounds:(struct bench_rect)bounds;
+- (struct bench_rect)bounds;
+- (double)area;
+- (int)containsPoint:(struct bench_point)point;
+@end
@@ -0,0 +1,280 @@
+/* Plain C: data structures, string handling and arithmetic. */
+
+typedef __SIZE_TYPE__ size_t;
+typedef unsigned int uint32_t;
+typedef unsigned long long uint64_t;
+
+void *malloc(size_t);
+void free(void *);
+void *memset(void *, int, size_t);
+void *memcpy(void *, const void *, size_t);
+int printf(const char *, ...);
+
+/* A chained hash table from strings to integers. */
+
+struct entry {
+  struct entry *next;
+  uint32_t hash;
+  int value;
+  char key[1];
+};
+
+struct table {
+  struct entry **buckets;
+  size_t num_buckets;
+  size_t num_entries;
+};
+
+static size_t string_length(const char *s) {
+  const char *p = s;
+  while (*p)
+    ++p;
+  return p - s;
+}
+
+static int string_compare(const char *a, const char *b) {
+  while (*a && *a == *b) {
+    ++a;
+    ++b;
+  }
+  return (unsigned char)*a - (unsigned char)*b;
+}
+
+static uint32_t hash_string(const char *s) {
+  uint32_t h = 2166136261u;
+  while (*s) {
+    h ^= (unsigned char)*s++;
+    h *= 16777619u;
+  }
+  return h;
+}
+
+static void table_init(struct table *t, size_t num_buckets) {
+  t->buckets = malloc(num_buckets * sizeof(*t->buckets));
+  memset(t->buckets, 0, num_buckets * sizeof(*t->buckets));
+  t->num_buckets = num_buckets;
+  t->num_entries = 0;
+}
+
+static void table_grow(struct table *t) {
+  size_t old_size = t->num_buckets, i;
+  struct entry **old = t->buckets;
+  table_init(t, old_size * 2);
+  for (i = 0; i != old_size; ++i) {
+    struct entry *e = old[i];
+    while (e) {
+      struct entry *next = e->next;
+      size_t b = e->hash & (t->num_buckets - 1);
+      e->next = t->buckets[b];
+      t->buckets[b] = e;
+      ++t->num_entries;
+      e = next;
+    }
+  }
+  free(old);
+}
+
+static int *table_lookup(struct table *t, const char *key, int insert) {
+  uint32_t h = hash_string(key);
+  size_t b = h & (t->num_buckets - 1), len;
+  struct entry *e;
+  for (e = t->buckets[b]; e; e = e->next)
+    if (e->hash == h && !string_compare(e->key, key))
+      return &e->value;
+  if (!insert)
+    return 0;
+  if (t->num_entries * 4 > t->num_buckets * 3) {
+    table_grow(t);
+    b = h & (t->num_buckets - 1);
+  }
+  len = string_length(key);
+  e = malloc(sizeof(*e) + len);
+  memcpy(e->key, key, len + 1);
+  e->hash = h;
+  e->value = 0;
+  e->next = t->buckets[b];
+  t->buckets[b] = e;
+  ++t->num_entries;
+  return &e->value;
+}
+
+/* Sorting. */
+
+static void swap_ints(int *a, int *b) {
+  int t = *a;
+  *a = *b;
+  *b = t;
+}
+
+static void quicksort(int *v, long lo, long hi) {
+  while (lo < hi) {
+    int pivot = v[lo + (hi - lo) / 2];
+    long i = lo, j = hi;
+    while (i <= j) {
+      while (v[i] < pivot)
+        ++i;
+      while (v[j] > pivot)
+        --j;
+      if (i <= j)
+        swap_ints(&v[i++], &v[j--]);
+    }
+    if (j - lo < hi - i) {
+      quicksort(v, lo, j);
+      lo = i;
+    } else {
+      quicksort(v, i, hi);
+      hi = j;
+    }
+  }
+}
+
+/* A small expression evaluator, as a state machine over characters. */
+
+enum token_kind { TOK_NUM, TOK_PLUS, TOK_MINUS, TOK_MUL, TOK_DIV, TOK_LPAREN,
+                  TOK_RPAREN, TOK_END, TOK_ERROR };
+
+struct lexer {
+  const char *p;
+  enum token_kind kind;
+  double value;
+};
+
+static void next_token(struct lexer *l) {
+  while (*l->p == ' ' || *l->p == '\t')
+    ++l->p;
+  switch (*l->p) {
+  case '\0': l->kind = TOK_END; return;
+  case '+': l->kind = TOK_PLUS; break;
+  case '-': l->kind = TOK_MINUS; break;
+  case '*': l->kind = TOK_MUL; break;
+  case '/': l->kind = TOK_DIV; break;
+  case '(': l->kind = TOK_LPAREN; break;
+  case ')': l->kind = TOK_RPAREN; break;
+  default:
+    if (*l->p >= '0' && *l->p <= '9') {
+      l->value = 0;
+      while (*l->p >= '0' && *l->p <= '9')
+        l->value = l->value * 10 + (*l->p++ - '0');
+      if (*l->p == '.') {
+        double scale = 0.1;
+        for (++l->p; *l->p >= '0' && *l->p <= '9'; ++l->p, scale /= 10)
+          l->value += (*l->p - '0') * scale;
+      }
+      l->kind = TOK_NUM;
+      return;
+    }
+    l->kind = TOK_ERROR;
+    return;
+  }
+  ++l->p;
+}
+
+static double parse_sum(struct lexer *l);
+
+static double parse_primary(struct lexer *l) {
+  double v;
+  switch (l->kind) {
+  case TOK_NUM:
+    v = l->value;
+    next_token(l);
+    return v;
+  case TOK_MINUS:
+    next_token(l);
+    return -parse_primary(l);
+  case TOK_LPAREN:
+    next_token(l);
+    v = parse_sum(l);
+    if (l->kind == TOK_RPAREN)
+      next_token(l);
+    return v;
+  default:
+    return 0;
+  }
+}
+
+static double parse_product(struct lexer *l) {
+  double v = parse_primary(l);
+  while (l->kind == TOK_MUL || l->kind == TOK_DIV) {
+    enum token_kind op = l->kind;
+    next_token(l);
+    if (op == TOK_MUL)
+      v *= parse_primary(l);
+    else
+      v /= parse_primary(l);
+  }
+  return v;
+}
+
+static double parse_sum(struct lexer *l) {
+  double v = parse_product(l);
+  while (l->kind == TOK_PLUS || l->kind == TOK_MINUS) {
+    enum token_kind op = l->kind;
+    next_token(l);
+    if (op == TOK_PLUS)
+      v += parse_product(l);
+    else
+      v -= parse_product(l);
+  }
+  return v;
+}
+
+double evaluate(const char *text) {
+  struct lexer l;
+  l.p = text;
+  next_token(&l);
+  return parse_sum(&l);
+}
+
+/* Matrices. */
+
+#define N 16
+
+static void matrix_multiply(double a[N][N], double b[N][N], double c[N][N]) {
+  int i, j, k;
+  for (i = 0; i != N; ++i)
+    for (j = 0; j != N; ++j) {
+      double sum = 0;
+      for (k = 0; k != N; ++k)
+        sum += a[i][k] * b[k][j];
+      c[i][j] = sum;
+    }
+}
+
+uint64_t checksum(const unsigned char *data, size_t size) {
+  uint64_t a = 1, b = 0;
+  size_t i;
+  for (i = 0; i != size; ++i) {
+    a = (a + data[i]) % 65521;
+    b = (b + a) % 65521;
+  }
+  return (b << 16) | a;
+}
+
+int main(void) {
+  static const char *words[] = { "alpha", "beta", "gamma", "delta", "alpha",
+                                 "beta", "epsilon", "alpha" };
+  struct table t;
+  int values[64];
+  double a[N][N], b[N][N], c[N][N];
+  unsigned i, j;
+
+  table_init(&t, 8);
+  for (i = 0; i != sizeof(words) / sizeof(*words); ++i)
+    ++*table_lookup(&t, words[i], 1);
+  printf("alpha: %d\n", *table_lookup(&t, "alpha", 0));
+
+  for (i = 0; i != 64; ++i)
+    values[i] = (int)((i * 2654435761u) >> 7);
+  quicksort(values, 0, 63);
+
+  for (i = 0; i != N; ++i)
+    for (j = 0; j != N; ++j) {
+      a[i][j] = i + j;
+      b[i][j] = i == j;
+    }
+  matrix_multiply(a, b, c);
+
+  printf("%f %llu\n", evaluate("(1 + 2.5) * 4 - 6 / 3") + c[3][4],
+         checksum((const unsigned char *)values, sizeof(values)));
+  return 0;
+}
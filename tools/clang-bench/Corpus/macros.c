@@ -0,0 +1,119 @@
+/* Macro-heavy C: X-macros, token pasting, stringizing and nested repetition
+   which expands to thousands of tokens. */
+
+typedef __SIZE_TYPE__ size_t;
+int printf(const char *, ...);
+
+#define CAT_(a, b) a##b
+#define CAT(a, b) CAT_(a, b)
+#define STR_(x) #x
+#define STR(x) STR_(x)
+
+#define REPEAT2(m, x) m(CAT(x, 0)) m(CAT(x, 1))
+#define REPEAT4(m, x) REPEAT2(m, CAT(x, 0)) REPEAT2(m, CAT(x, 1))
+#define REPEAT8(m, x) REPEAT4(m, CAT(x, 0)) REPEAT4(m, CAT(x, 1))
+#define REPEAT16(m, x) REPEAT8(m, CAT(x, 0)) REPEAT8(m, CAT(x, 1))
+#define REPEAT32(m, x) REPEAT16(m, CAT(x, 0)) REPEAT16(m, CAT(x, 1))
+#define REPEAT64(m, x) REPEAT32(m, CAT(x, 0)) REPEAT32(m, CAT(x, 1))
+#define REPEAT128(m, x) REPEAT64(m, CAT(x, 0)) REPEAT64(m, CAT(x, 1))
+#define REPEAT256(m, x) REPEAT128(m, CAT(x, 0)) REPEAT128(m, CAT(x, 1))
+
+#define MAX(a, b) ((a) > (b) ? (a) : (b))
+#define MIN(a, b) ((a) < (b) ? (a) : (b))
+#define CLAMP(x, lo, hi) MIN(MAX(x, lo), hi)
+#define ABS(x) ((x) < 0 ? -(x) : (x))
+#define SQUARE(x) ((x) * (x))
+#define LERP(a, b, t) ((a) + ((b) - (a)) * (t))
+#define SMOOTH(x) LERP(0, 1, SQUARE(CLAMP(x, 0, 1)) * (3 - 2 * CLAMP(x, 0, 1)))
+
+#define ARRAY_SIZE(a) (sizeof(a) / sizeof((a)[0]))
+#define LOG(fmt, ...) printf("%s:%d: " fmt "\n", __FILE__, __LINE__, __VA_ARGS__)
+
+/* An X-macro list of opcodes, expanded into an enum, a name table, operand
+   counts and an interpreter switch. */
+#define OPCODES(X)                        \
+  X(nop, 0, (void)0)                      \
+  X(push, 1, stack[sp++] = operand)       \
+  X(pop, 0, --sp)                         \
+  X(dup, 0, (stack[sp] = stack[sp - 1], ++sp)) \
+  X(add, 0, (stack[sp - 2] += stack[sp - 1], --sp)) \
+  X(sub, 0, (stack[sp - 2] -= stack[sp - 1], --sp)) \
+  X(mul, 0, (stack[sp - 2] *= stack[sp - 1], --sp)) \
+  X(neg, 0, stack[sp - 1] = -stack[sp - 1]) \
+  X(abs, 0, stack[sp - 1] = ABS(stack[sp - 1])) \
+  X(min, 0, (stack[sp - 2] = MIN(stack[sp - 2], stack[sp - 1]), --sp)) \
+  X(max, 0, (stack[sp - 2] = MAX(stack[sp - 2], stack[sp - 1]), --sp)) \
+  X(clamp, 2, stack[sp - 1] = CLAMP(stack[sp - 1], operand, operand2)) \
+  X(square, 0, stack[sp - 1] = SQUARE(stack[sp - 1])) \
+  X(swap, 0, (tmp = stack[sp - 1], stack[sp - 1] = stack[sp - 2], \
+              stack[sp - 2] = tmp))
+
+#define ENUM_ENTRY(name, operands, action) CAT(op_, name),
+enum opcode { OPCODES(ENUM_ENTRY) num_opcodes };
+
+#define NAME_ENTRY(name, operands, action) STR(name),
+static const char *const opcode_names[] = { OPCODES(NAME_ENTRY) };
+
+#define OPERANDS_ENTRY(name, operands, action) operands,
+static const unsigned char opcode_operands[] = { OPCODES(OPERANDS_ENTRY) };
+
+struct instruction {
+  enum opcode op;
+  long operand, operand2;
+};
+
+long run(const struct instruction *code, size_t size) {
+  long stack[64], tmp;
+  size_t pc, sp = 0;
+  (void)tmp;
+  for (pc = 0; pc != size; ++pc) {
+    long operand = code[pc].operand, operand2 = code[pc].operand2;
+    (void)operand;
+    (void)operand2;
+    switch (code[pc].op) {
+#define CASE_ENTRY(name, operands, action) \
+    case CAT(op_, name): action; break;
+      OPCODES(CASE_ENTRY)
+    case num_opcodes:
+      break;
+    }
+  }
+  return sp ? stack[sp - 1] : 0;
+}
+
+/* 256 functions and the table pointing to them, each built from the nested
+   macros above. */
+#define DEFINE_FUNCTION(id) \
+  static double CAT(f_, id)(double x) { \
+    return SMOOTH(x * (STR(id)[1] - '0' + 1)) + \
+           CLAMP(LERP(x, ABS(x - 2), 0.5), -1, 1); \
+  }
+REPEAT256(DEFINE_FUNCTION, b)
+
+#define FUNCTION_ENTRY(id) CAT(f_, id),
+static double (*const functions[])(double) = { REPEAT256(FUNCTION_ENTRY, b) };
+
+#define NAME_OF(id) STR(CAT(f_, id)),
+static const char *const function_names[] = { REPEAT256(NAME_OF, b) };
+
+#define SUM_TERM(id) + CAT(f_, id)(0.25)
+double sum_all(void) {
+  return 0 REPEAT256(SUM_TERM, b);
+}
+
+int main(void) {
+  static const struct instruction program[] = {
+    { op_push, 3, 0 }, { op_push, 4, 0 }, { op_mul, 0, 0 },
+    { op_dup, 0, 0 }, { op_square, 0, 0 }, { op_swap, 0, 0 },
+    { op_neg, 0, 0 }, { op_abs, 0, 0 }, { op_add, 0, 0 },
+    { op_clamp, 0, 100, }, { op_push, 7, 0 }, { op_max, 0, 0 },
+  };
+  size_t i;
+  double total = 0;
+  for (i = 0; i != ARRAY_SIZE(functions); ++i)
+    total += functions[i](i / 256.0);
+  LOG("%ld %s %u", run(program, ARRAY_SIZE(program)),
+      opcode_names[op_clamp], (unsigned)opcode_operands[op_clamp]);
+  LOG("%f %f %s", total, sum_all(), function_names[ARRAY_SIZE(functions) - 1]);
+  return 0;
+}
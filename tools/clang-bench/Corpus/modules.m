@@ -0,0 +1,38 @@
+// Uses modules built from Modules/module.map into the module cache.
+
+@__experimental_modules_import bench_geometry;
+
+@interface BenchCircle : BenchShape
+- (double)radius;
+@end
+
+@implementation BenchCircle
+- (double)radius {
+  struct bench_rect r = [self bounds];
+  return r.size.x / 2;
+}
+
+- (double)area {
+  double radius = [self radius];
+  return 3.14159265358979 * radius * radius;
+}
+@end
+
+int main(void) {
+  struct bench_array shapes = { 0, 0, 0 };
+  unsigned i;
+  double total = 0;
+  for (i = 0; i != 16; ++i) {
+    struct bench_rect r = { { i, i }, { i + 1, i + 1 } };
+    bench_array_push(&shapes, [[BenchCircle alloc] initWithBounds:r]);
+  }
+  for (i = 0; i != shapes.count; ++i) {
+    BenchShape *s = shapes.items[i];
+    struct bench_point p = { i + 0.5, i + 0.5 };
+    if ([s containsPoint:p])
+      total += [s area] + bench_rect_area([s bounds]);
+  }
+  printf("%f %u\n", total, bench_hash((uint32_t)total));
+  bench_array_free(&shapes);
+  return 0;
+}
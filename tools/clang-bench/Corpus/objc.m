@@ -0,0 +1,204 @@
+// Objective-C: classes, protocols, categories, properties and blocks.
+
+typedef __SIZE_TYPE__ size_t;
+typedef signed char BOOL;
+#define YES ((BOOL)1)
+#define NO ((BOOL)0)
+
+void *calloc(size_t, size_t);
+void *realloc(void *, size_t);
+void free(void *);
+int printf(const char *, ...);
+
+__attribute__((objc_root_class))
+@interface Object {
+  Class isa;
+  unsigned retainCount;
+}
++ (id)alloc;
++ (id)new;
+- (id)init;
+- (id)retain;
+- (void)release;
+- (id)autorelease;
+- (void)dealloc;
+- (BOOL)isEqual:(id)other;
+- (unsigned)hash;
+- (BOOL)isKindOfNumber;
+@end
+
+@protocol Visitor
+- (void)visitNumber:(id)number;
+- (void)visitSum:(id)sum;
+@optional
+- (void)finish;
+@end
+
+@protocol Node
+- (double)evaluate;
+- (void)accept:(id<Visitor>)visitor;
+@end
+
+@interface Number : Object <Node> {
+  double value;
+}
+@property (nonatomic, assign) double value;
++ (Number *)numberWithValue:(double)value;
+@end
+
+@interface Sum : Object <Node> {
+  Object<Node> **operands;
+  unsigned count, capacity;
+}
+@property (nonatomic, readonly) unsigned count;
+- (void)addOperand:(Object<Node> *)operand;
+- (Object<Node> *)operandAtIndex:(unsigned)index;
+- (void)enumerateOperands:(void (^)(Object<Node> *operand, unsigned index,
+                                    BOOL *stop))block;
+@end
+
+@interface Printer : Object <Visitor> {
+  unsigned depth;
+}
+@end
+
+@interface Sum (Folding)
+- (Number *)fold;
+- (double)sumMatching:(BOOL (^)(double))predicate;
+@end
+
+@implementation Number
+@synthesize value;
+
++ (Number *)numberWithValue:(double)aValue {
+  Number *result = [[[self alloc] init] autorelease];
+  result.value = aValue;
+  return result;
+}
+
+- (double)evaluate {
+  return self.value;
+}
+
+- (void)accept:(id<Visitor>)visitor {
+  [visitor visitNumber:self];
+}
+
+- (BOOL)isEqual:(id)other {
+  return other == self ||
+         ([other isKindOfNumber] && [(Number *)other value] == value);
+}
+
+- (BOOL)isKindOfNumber {
+  return YES;
+}
+
+- (unsigned)hash {
+  return (unsigned)value;
+}
+@end
+
+@implementation Sum
+@synthesize count;
+
+- (void)dealloc {
+  for (unsigned i = 0; i != count; ++i)
+    [operands[i] release];
+  free(operands);
+  [super dealloc];
+}
+
+- (void)addOperand:(Object<Node> *)operand {
+  if (count == capacity) {
+    capacity = capacity ? capacity * 2 : 4;
+    operands = realloc(operands, capacity * sizeof(*operands));
+  }
+  operands[count++] = [operand retain];
+}
+
+- (Object<Node> *)operandAtIndex:(unsigned)index {
+  return index < count ? operands[index] : nil;
+}
+
+- (void)enumerateOperands:(void (^)(Object<Node> *operand, unsigned index,
+                                    BOOL *stop))block {
+  BOOL stop = NO;
+  for (unsigned i = 0; i != count && !stop; ++i)
+    block(operands[i], i, &stop);
+}
+
+- (double)evaluate {
+  __block double total = 0;
+  [self enumerateOperands:^(Object<Node> *operand, unsigned index,
+                            BOOL *stop) {
+    total += [operand evaluate];
+  }];
+  return total;
+}
+
+- (void)accept:(id<Visitor>)visitor {
+  [visitor visitSum:self];
+}
+@end
+
+@implementation Sum (Folding)
+- (Number *)fold {
+  return [Number numberWithValue:[self evaluate]];
+}
+
+- (double)sumMatching:(BOOL (^)(double))predicate {
+  __block double total = 0;
+  [self enumerateOperands:^(Object<Node> *operand, unsigned index,
+                            BOOL *stop) {
+    double v = [operand evaluate];
+    if (predicate(v))
+      total += v;
+    *stop = total > 1000;
+  }];
+  return total;
+}
+@end
+
+@implementation Printer
+- (void)visitNumber:(id)number {
+  printf("%*s%f\n", (int)depth * 2, "", [(Number *)number value]);
+}
+
+- (void)visitSum:(id)sum {
+  Sum *s = sum;
+  printf("%*s+\n", (int)depth * 2, "");
+  ++depth;
+  for (unsigned i = 0; i != s.count; ++i)
+    [[s operandAtIndex:i] accept:self];
+  --depth;
+}
+
+- (void)finish {
+  printf("done\n");
+}
+@end
+
+static Sum *buildTree(unsigned levels, double *next) {
+  Sum *sum = [[Sum new] autorelease];
+  for (unsigned i = 0; i != 3; ++i) {
+    if (levels)
+      [sum addOperand:buildTree(levels - 1, next)];
+    else
+      [sum addOperand:[Number numberWithValue:(*next)++]];
+  }
+  return sum;
+}
+
+int main(void) {
+  double next = 1;
+  Sum *tree = buildTree(4, &next);
+  Printer *printer = [Printer new];
+  [tree accept:printer];
+  [printer finish];
+  [printer release];
+
+  double threshold = 40;
+  double large = [tree sumMatching:^BOOL(double v) { return v > threshold; }];
+  printf("%f %f %f\n", [tree evaluate], [[tree fold] value], large);
+  return 0;
+}
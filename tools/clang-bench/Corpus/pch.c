@@ -0,0 +1,39 @@
+/* Uses the precompiled pch.h. */
+
+static struct shape *new_rect(double w, double h) {
+  struct shape *s = calloc(1, sizeof(*s));
+  s->kind = SHAPE_RECT;
+  s->u.rect.max.x = w;
+  s->u.rect.max.y = h;
+  list_init(&s->link);
+  return s;
+}
+
+int handle_rect(struct buffer *out, const struct shape *s) {
+  buffer_append_u32(out, SHAPE_RECT);
+  buffer_append_u32(out, murmur_mix((uint32_t)shape_area(s)));
+  return 0;
+}
+
+int main(void) {
+  struct list_node shapes;
+  struct buffer out = { 0, 0, 0 };
+  struct list_node *n;
+  unsigned i;
+
+  list_init(&shapes);
+  for (i = 1; i != 10; ++i)
+    list_insert_after(&shapes, &new_rect(i, i + 1)->link);
+
+  for (n = shapes.next; n != &shapes; n = n->next)
+    handle_rect(&out, CONTAINER_OF(n, struct shape, link));
+
+  printf("%u %u\n", (unsigned)out.size, popcount32(rotl32(out.size, 3)));
+  while (!list_empty(&shapes)) {
+    struct shape *s = CONTAINER_OF(shapes.next, struct shape, link);
+    list_remove(&s->link);
+    free(s);
+  }
+  buffer_free(&out);
+  return 0;
+}
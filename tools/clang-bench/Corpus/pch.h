@@ -0,0 +1,165 @@
+/* A header of the kind projects precompile: many declarations, macros and
+   inline functions, of which each file uses a few. */
+
+typedef __SIZE_TYPE__ size_t;
+typedef unsigned char uint8_t;
+typedef unsigned short uint16_t;
+typedef unsigned int uint32_t;
+typedef unsigned long long uint64_t;
+
+void *malloc(size_t);
+void *calloc(size_t, size_t);
+void *realloc(void *, size_t);
+void free(void *);
+void *memcpy(void *, const void *, size_t);
+void *memmove(void *, const void *, size_t);
+void *memset(void *, int, size_t);
+int memcmp(const void *, const void *, size_t);
+size_t strlen(const char *);
+int printf(const char *, ...);
+int snprintf(char *, size_t, const char *, ...);
+
+#define LIKELY(x) __builtin_expect(!!(x), 1)
+#define UNLIKELY(x) __builtin_expect(!!(x), 0)
+#define CONTAINER_OF(ptr, type, member) \
+  ((type *)((char *)(ptr) - __builtin_offsetof(type, member)))
+
+/* Intrusive doubly linked lists. */
+struct list_node {
+  struct list_node *prev, *next;
+};
+
+static inline void list_init(struct list_node *head) {
+  head->prev = head->next = head;
+}
+
+static inline int list_empty(const struct list_node *head) {
+  return head->next == head;
+}
+
+static inline void list_insert_after(struct list_node *pos,
+                                     struct list_node *node) {
+  node->prev = pos;
+  node->next = pos->next;
+  pos->next->prev = node;
+  pos->next = node;
+}
+
+static inline void list_remove(struct list_node *node) {
+  node->prev->next = node->next;
+  node->next->prev = node->prev;
+  node->prev = node->next = node;
+}
+
+/* Growable byte buffers. */
+struct buffer {
+  uint8_t *data;
+  size_t size, capacity;
+};
+
+static inline void buffer_reserve(struct buffer *b, size_t capacity) {
+  if (capacity <= b->capacity)
+    return;
+  if (capacity < b->capacity * 2)
+    capacity = b->capacity * 2;
+  b->data = realloc(b->data, capacity);
+  b->capacity = capacity;
+}
+
+static inline void buffer_append(struct buffer *b, const void *data,
+                                 size_t size) {
+  buffer_reserve(b, b->size + size);
+  memcpy(b->data + b->size, data, size);
+  b->size += size;
+}
+
+static inline void buffer_append_u32(struct buffer *b, uint32_t v) {
+  uint8_t bytes[4];
+  bytes[0] = v;
+  bytes[1] = v >> 8;
+  bytes[2] = v >> 16;
+  bytes[3] = v >> 24;
+  buffer_append(b, bytes, 4);
+}
+
+static inline void buffer_free(struct buffer *b) {
+  free(b->data);
+  b->data = 0;
+  b->size = b->capacity = 0;
+}
+
+/* Bit manipulation. */
+static inline unsigned popcount32(uint32_t v) {
+  v = v - ((v >> 1) & 0x55555555);
+  v = (v & 0x33333333) + ((v >> 2) & 0x33333333);
+  return (((v + (v >> 4)) & 0x0F0F0F0F) * 0x01010101) >> 24;
+}
+
+static inline uint32_t rotl32(uint32_t v, unsigned n) {
+  return (v << n) | (v >> (32 - n));
+}
+
+static inline uint32_t murmur_mix(uint32_t h) {
+  h ^= h >> 16;
+  h *= 0x85ebca6b;
+  h ^= h >> 13;
+  h *= 0xc2b2ae35;
+  h ^= h >> 16;
+  return h;
+}
+
+/* A vocabulary of record types. */
+enum shape_kind { SHAPE_CIRCLE, SHAPE_RECT, SHAPE_TRIANGLE, SHAPE_POLYGON };
+
+struct point { double x, y; };
+
+struct shape {
+  enum shape_kind kind;
+  struct list_node link;
+  union {
+    struct { struct point center; double radius; } circle;
+    struct { struct point min, max; } rect;
+    struct { struct point a, b, c; } triangle;
+    struct { struct point *points; unsigned count; } polygon;
+  } u;
+};
+
+static inline double shape_area(const struct shape *s) {
+  switch (s->kind) {
+  case SHAPE_CIRCLE:
+    return 3.14159265358979 * s->u.circle.radius * s->u.circle.radius;
+  case SHAPE_RECT:
+    return (s->u.rect.max.x - s->u.rect.min.x) *
+           (s->u.rect.max.y - s->u.rect.min.y);
+  case SHAPE_TRIANGLE: {
+    double a = (s->u.triangle.b.x - s->u.triangle.a.x) *
+               (s->u.triangle.c.y - s->u.triangle.a.y);
+    double b = (s->u.triangle.c.x - s->u.triangle.a.x) *
+               (s->u.triangle.b.y - s->u.triangle.a.y);
+    return (a > b ? a - b : b - a) / 2;
+  }
+  case SHAPE_POLYGON: {
+    double area = 0;
+    unsigned i;
+    for (i = 0; i != s->u.polygon.count; ++i) {
+      const struct point *p = &s->u.polygon.points[i];
+      const struct point *q =
+        &s->u.polygon.points[(i + 1) % s->u.polygon.count];
+      area += p->x * q->y - q->x * p->y;
+    }
+    return (area < 0 ? -area : area) / 2;
+  }
+  }
+  return 0;
+}
+
+#define DECLARE_HANDLER(name) \
+  int handle_##name(struct buffer *out, const struct shape *s);
+DECLARE_HANDLER(circle)
+DECLARE_HANDLER(rect)
+DECLARE_HANDLER(triangle)
+DECLARE_HANDLER(polygon)
+DECLARE_HANDLER(group)
+DECLARE_HANDLER(transform)
+DECLARE_HANDLER(clip)
+DECLARE_HANDLER(mask)
@@ -0,0 +1,305 @@
+// Template-heavy C++11: type lists, variadic tuples, expression templates
+// and generic algorithms, instantiated over many types.
+
+typedef __SIZE_TYPE__ size_t;
+
+namespace bench {
+
+template<typename T, T V> struct constant {
+  static constexpr T value = V;
+  typedef constant type;
+};
+typedef constant<bool, true> true_type;
+typedef constant<bool, false> false_type;
+
+template<bool B, typename T = void> struct enable_if {};
+template<typename T> struct enable_if<true, T> { typedef T type; };
+
+template<bool B, typename T, typename F> struct conditional { typedef T type; };
+template<typename T, typename F> struct conditional<false, T, F> {
+  typedef F type;
+};
+
+template<typename T, typename U> struct is_same : false_type {};
+template<typename T> struct is_same<T, T> : true_type {};
+
+template<typename T> struct remove_reference { typedef T type; };
+template<typename T> struct remove_reference<T &> { typedef T type; };
+template<typename T> struct remove_reference<T &&> { typedef T type; };
+
+template<typename T>
+constexpr T &&forward(typename remove_reference<T>::type &t) {
+  return static_cast<T &&>(t);
+}
+
+template<typename T>
+constexpr typename remove_reference<T>::type &&move(T &&t) {
+  return static_cast<typename remove_reference<T>::type &&>(t);
+}
+
+template<typename T> T &&declval();
+
+// Type lists.
+
+template<typename... Ts> struct list {};
+
+template<typename L> struct size;
+template<typename... Ts> struct size<list<Ts...> >
+  : constant<size_t, sizeof...(Ts)> {};
+
+template<typename L, typename T> struct push_front;
+template<typename... Ts, typename T> struct push_front<list<Ts...>, T> {
+  typedef list<T, Ts...> type;
+};
+
+template<typename L, template<typename> class F> struct transform;
+template<typename... Ts, template<typename> class F>
+struct transform<list<Ts...>, F> {
+  typedef list<typename F<Ts>::type...> type;
+};
+
+template<typename L, template<typename> class P> struct filter;
+template<template<typename> class P> struct filter<list<>, P> {
+  typedef list<> type;
+};
+template<typename T, typename... Ts, template<typename> class P>
+struct filter<list<T, Ts...>, P> {
+  typedef typename filter<list<Ts...>, P>::type rest;
+  typedef typename conditional<P<T>::value,
+                               typename push_front<rest, T>::type,
+                               rest>::type type;
+};
+
+template<typename L, size_t I> struct at;
+template<typename T, typename... Ts> struct at<list<T, Ts...>, 0> {
+  typedef T type;
+};
+template<typename T, typename... Ts, size_t I> struct at<list<T, Ts...>, I> {
+  typedef typename at<list<Ts...>, I - 1>::type type;
+};
+
+template<size_t... Is> struct indices {};
+template<size_t N, size_t... Is> struct make_indices
+  : make_indices<N - 1, N - 1, Is...> {};
+template<size_t... Is> struct make_indices<0, Is...> {
+  typedef indices<Is...> type;
+};
+
+// Tuples.
+
+template<size_t I, typename T> struct tuple_leaf {
+  T value;
+  tuple_leaf() : value() {}
+  template<typename U> explicit tuple_leaf(U &&u) : value(forward<U>(u)) {}
+};
+
+template<typename Is, typename... Ts> struct tuple_impl;
+template<size_t... Is, typename... Ts>
+struct tuple_impl<indices<Is...>, Ts...> : tuple_leaf<Is, Ts>... {
+  tuple_impl() {}
+  template<typename... Us>
+  explicit tuple_impl(Us &&...us) : tuple_leaf<Is, Ts>(forward<Us>(us))... {}
+};
+
+template<typename... Ts>
+struct tuple
+  : tuple_impl<typename make_indices<sizeof...(Ts)>::type, Ts...> {
+  typedef tuple_impl<typename make_indices<sizeof...(Ts)>::type, Ts...> base;
+  tuple() {}
+  template<typename... Us> explicit tuple(Us &&...us)
+    : base(forward<Us>(us)...) {}
+};
+
+template<size_t I, typename T> T &get(tuple_leaf<I, T> &leaf) {
+  return leaf.value;
+}
+
+template<typename... Ts> tuple<Ts...> make_tuple(Ts... ts) {
+  return tuple<Ts...>(ts...);
+}
+
+template<typename F, typename... Ts, size_t... Is>
+auto apply_impl(F f, tuple<Ts...> &t, indices<Is...>)
+    -> decltype(f(get<Is>(t)...)) {
+  return f(get<Is>(t)...);
+}
+
+template<typename F, typename... Ts>
+auto apply(F f, tuple<Ts...> &t)
+    -> decltype(apply_impl(f, t, typename make_indices<sizeof...(Ts)>::type())) {
+  return apply_impl(f, t, typename make_indices<sizeof...(Ts)>::type());
+}
+
+// Containers and algorithms.
+
+template<typename T, size_t N> struct array {
+  T elems[N];
+  typedef T *iterator;
+  typedef const T *const_iterator;
+  iterator begin() { return elems; }
+  iterator end() { return elems + N; }
+  const_iterator begin() const { return elems; }
+  const_iterator end() const { return elems + N; }
+  T &operator[](size_t i) { return elems[i]; }
+  const T &operator[](size_t i) const { return elems[i]; }
+  static constexpr size_t size() { return N; }
+};
+
+template<typename It, typename T>
+T accumulate(It first, It last, T init) {
+  for (; first != last; ++first)
+    init = init + *first;
+  return init;
+}
+
+template<typename It, typename F> void for_each(It first, It last, F f) {
+  for (; first != last; ++first)
+    f(*first);
+}
+
+template<typename T> void swap(T &a, T &b) {
+  T t = move(a);
+  a = move(b);
+  b = move(t);
+}
+
+template<typename It, typename Less>
+void insertion_sort(It first, It last, Less less) {
+  if (first == last)
+    return;
+  for (It i = first + 1; i != last; ++i)
+    for (It j = i; j != first && less(*j, *(j - 1)); --j)
+      swap(*j, *(j - 1));
+}
+
+template<typename It> void insertion_sort(It first, It last) {
+  insertion_sort(first, last, [](decltype(*first) a, decltype(*first) b) {
+    return a < b;
+  });
+}
+
+// Expression templates.
+
+template<typename E> struct expr {
+  const E &self() const { return static_cast<const E &>(*this); }
+};
+
+template<typename T, size_t N> struct vec : expr<vec<T, N> > {
+  array<T, N> data;
+  vec() { for (size_t i = 0; i != N; ++i) data[i] = T(); }
+  template<typename E> vec(const expr<E> &e) {
+    for (size_t i = 0; i != N; ++i)
+      data[i] = e.self()[i];
+  }
+  T operator[](size_t i) const { return data[i]; }
+  T &operator[](size_t i) { return data[i]; }
+};
+
+template<typename L, typename R, typename Op>
+struct binary : expr<binary<L, R, Op> > {
+  const L &l;
+  const R &r;
+  binary(const L &l, const R &r) : l(l), r(r) {}
+  auto operator[](size_t i) const -> decltype(Op::apply(l[i], r[i])) {
+    return Op::apply(l[i], r[i]);
+  }
+};
+
+struct add_op {
+  template<typename T> static T apply(T a, T b) { return a + b; }
+};
+struct mul_op {
+  template<typename T> static T apply(T a, T b) { return a * b; }
+};
+
+template<typename L, typename R>
+binary<L, R, add_op> operator+(const expr<L> &l, const expr<R> &r) {
+  return binary<L, R, add_op>(l.self(), r.self());
+}
+template<typename L, typename R>
+binary<L, R, mul_op> operator*(const expr<L> &l, const expr<R> &r) {
+  return binary<L, R, mul_op>(l.self(), r.self());
+}
+
+// CRTP and SFINAE.
+
+template<typename Derived> struct counter {
+  static int count;
+  counter() { ++count; }
+  counter(const counter &) { ++count; }
+  ~counter() { --count; }
+};
+template<typename Derived> int counter<Derived>::count = 0;
+
+template<typename T> struct has_size {
+  template<typename U> static char test(decltype(U::size()) *);
+  template<typename U> static long test(...);
+  static constexpr bool value = sizeof(test<T>(0)) == 1;
+};
+
+template<typename T>
+typename enable_if<has_size<T>::value, size_t>::type count_of(const T &) {
+  return T::size();
+}
+template<typename T>
+typename enable_if<!has_size<T>::value, size_t>::type count_of(const T &) {
+  return 1;
+}
+
+template<typename T> struct add_pointer { typedef T *type; };
+template<typename T> struct is_small : constant<bool, sizeof(T) <= 4> {};
+
+} // end namespace bench
+
+using namespace bench;
+
+template<typename T> struct widget : counter<widget<T> > {
+  T value;
+  explicit widget(T v = T()) : value(v) {}
+};
+
+typedef list<char, short, int, long, long long, float, double, long double,
+             unsigned char, unsigned short, unsigned, unsigned long> scalars;
+typedef transform<scalars, add_pointer>::type pointers;
+typedef filter<scalars, is_small>::type small_scalars;
+
+static_assert(size<pointers>::value == 12, "");
+static_assert(is_same<at<pointers, 3>::type, long *>::value, "");
+static_assert(size<small_scalars>::value == 7, "");
+
+template<typename T, size_t N> T sum_of_sorted(array<T, N> a) {
+  insertion_sort(a.begin(), a.end());
+  return accumulate(a.begin(), a.end(), T());
+}
+
+template<typename T> T exercise() {
+  array<T, 8> a;
+  for (size_t i = 0; i != a.size(); ++i)
+    a[i] = T((i * 7) % 8);
+  vec<T, 8> x, y;
+  for (size_t i = 0; i != 8; ++i) {
+    x[i] = T(i);
+    y[i] = T(8 - i);
+  }
+  vec<T, 8> z = x * y + x + y * y;
+  tuple<T, widget<T>, array<T, 8> > t(T(1), widget<T>(T(2)), a);
+  T total = sum_of_sorted(a) + z[3] + get<0>(t) + get<1>(t).value;
+  for_each(a.begin(), a.end(), [&total](T v) { total = total + v; });
+  total = total + T(count_of(a) + count_of(total));
+  return total + apply([](T p, widget<T> &w, array<T, 8> &q) {
+    return p + w.value + q[0];
+  }, t);
+}
+
+template<typename L> struct exercise_all;
+template<typename... Ts> struct exercise_all<list<Ts...> > {
+  static long double run() {
+    long double results[] = { (long double)exercise<Ts>()... };
+    return accumulate(results, results + sizeof...(Ts), 0.0L);
+  }
+};
+
+long double run_all() {
+  return exercise_all<scalars>::run() +
+         counter<widget<int> >::count + counter<widget<double> >::count;
+}
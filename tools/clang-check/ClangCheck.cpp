@@ -57,6 +57,11 @@ static cl::opt<bool> ASTPrint(
 static cl::opt<std::string> ASTDumpFilter(
     "ast-dump-filter",
     cl::desc(Options->getOptionHelpText(options::OPT_ast_dump_filter)));
+static cl::opt<unsigned> NumThreads(
+    "j",
+    cl::desc("Number of translation units to process in parallel "
+             "(0 = number of hardware threads)"),
+    cl::init(1));
 
 // Anonymous namespace here causes problems with gcc <= 4.4 on MacOS 10.6.
 // "Non-global symbol: ... can't be a weak_definition"
@@ -80,5 +85,6 @@ int main(int argc, const char **argv) {
   CommonOptionsParser OptionsParser(argc, argv);
   ClangTool Tool(OptionsParser.GetCompilations(),
                  OptionsParser.GetSourcePathList());
+  Tool.setNumThreads(NumThreads);
   return Tool.run(newFrontendActionFactory(&Factory));
 }
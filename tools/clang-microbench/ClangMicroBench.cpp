@@ -0,0 +1,594 @@
+//===--- ClangMicroBench.cpp - Benchmarks of Lex and Basic ----------------===//
+//
+//                     The LLVM Compiler Infrastructure
+//
+// This file is distributed under the University of Illinois Open Source
+// License. See LICENSE.TXT for details.
+//
+//===----------------------------------------------------------------------===//
+//
+//  This file implements clang-microbench, which times the hot paths of the
+//  lexer, the source manager, the identifier table, the file manager and
+//  header search over a set of real headers, and reports the time of one
+//  operation of each as JSON.
+//
+//===----------------------------------------------------------------------===//
+
+#include "clang/Basic/Diagnostic.h"
+#include "clang/Basic/FileManager.h"
+#include "clang/Basic/FileSystemOptions.h"
+#include "clang/Basic/IdentifierTable.h"
+#include "clang/Basic/LangOptions.h"
+#include "clang/Basic/ProfilingSupport.h"
+#include "clang/Basic/SourceManager.h"
+#include "clang/Basic/TargetInfo.h"
+#include "clang/Basic/TargetOptions.h"
+#include "clang/Driver/ArgList.h"
+#include "clang/Driver/OptTable.h"
+#include "clang/Driver/Options.h"
+#include "clang/Lex/DirectoryLookup.h"
+#include "clang/Lex/HeaderSearch.h"
+#include "clang/Lex/Lexer.h"
+#include "llvm/ADT/OwningPtr.h"
+#include "llvm/ADT/STLExtras.h"
+#include "llvm/ADT/StringExtras.h"
+#include "llvm/Support/CommandLine.h"
+#include "llvm/Support/ErrorHandling.h"
+#include "llvm/Support/Format.h"
+#include "llvm/Support/ManagedStatic.h"
+#include "llvm/Support/Path.h"
+#include "llvm/Support/PrettyStackTrace.h"
+#include "llvm/Support/Signals.h"
+#include "llvm/Support/raw_ostream.h"
+#include <algorithm>
+#include <string>
+#include <vector>
+
+using namespace clang;
+using namespace llvm;
+
+static cl::list<std::string> InputFiles(cl::Positional, cl::OneOrMore,
+  cl::desc("<header files>"));
+
+static cl::opt<unsigned> Repetitions("repetitions",
+  cl::desc("Number of measurements of each benchmark"), cl::init(5));
+
+static cl::opt<double> MinTime("min-time",
+  cl::desc("Minimum time of each measurement, in seconds"), cl::init(0.1));
+
+static cl::opt<unsigned> SearchDirs("search-dirs",
+  cl::desc("Number of empty header search directories in front of the "
+           "directories of the inputs"), cl::init(64));
+
+static cl::opt<std::string> OutputFile("o",
+  cl::desc("Write the report to <file>"), cl::value_desc("file"),
+  cl::init("-"));
+
+static cl::list<std::string> OnlyBenchmarks("benchmark",
+  cl::desc("Run only the named benchmark"), cl::value_desc("name"));
+
+/// \brief Results of the benchmarks are added here so that the compiler
+/// cannot drop the work producing them.
+static volatile uintptr_t Sink;
+
+namespace {
+/// \brief A deterministic generator of pseudo-random numbers, so that every
+/// run queries the same locations.
+class Random {
+  uint64_t State;
+
+public:
+  Random() : State(0x2545F4914F6CDD1DULL) {}
+
+  /// \brief A number in [0, N).
+  unsigned next(unsigned N) {
+    State = State * 6364136223846793005ULL + 1442695040888963407ULL;
+    return unsigned(State >> 33) % N;
+  }
+};
+
+/// \brief The objects the benchmarks share: the inputs, and a source
+/// manager where each of them is entered several times, forming a tree of
+/// inclusions.
+class Environment {
+public:
+  FileSystemOptions FileSystemOpts;
+  FileManager FileMgr;
+  IntrusiveRefCntPtr<DiagnosticIDs> DiagID;
+  DiagnosticsEngine Diags;
+  SourceManager SourceMgr;
+  LangOptions LangOpts;
+  IntrusiveRefCntPtr<TargetInfo> Target;
+
+  std::vector<const FileEntry *> Inputs;
+  std::vector<FileID> FileIDs;
+
+  /// \brief The input with the most bytes, and its size.
+  FileID LargestFile;
+  unsigned LargestSize;
+
+  /// \brief Locations spread over all of \c FileIDs.
+  std::vector<SourceLocation> Locations;
+
+  Environment()
+    : FileMgr(FileSystemOpts), DiagID(new DiagnosticIDs()),
+      Diags(DiagID, new IgnoringDiagConsumer()), SourceMgr(Diags, FileMgr),
+      LargestSize(0) {
+    LangOpts.C99 = LangOpts.CPlusPlus = LangOpts.CPlusPlus0x = true;
+    LangOpts.BCPLComment = LangOpts.Bool = true;
+    TargetOptions TargetOpts;
+    TargetOpts.Triple = "x86_64-unknown-linux-gnu";
+    Target = TargetInfo::CreateTargetInfo(Diags, TargetOpts);
+  }
+
+  /// \brief Read the inputs and enter them into the source manager.
+  bool initialize();
+};
+}
+
+bool Environment::initialize() {
+  for (unsigned I = 0, N = InputFiles.size(); I != N; ++I) {
+    const FileEntry *Entry = FileMgr.getFile(InputFiles[I]);
+    if (!Entry || !Entry->getSize()) {
+      errs() << "error: cannot read '" << InputFiles[I] << "'\n";
+      return false;
+    }
+    Inputs.push_back(Entry);
+  }
+
+  // Every file is included at its parent's start, the parent of the I'th
+  // file being the (I - 1) / 2'th, which gives a tree as deep as the include
+  // stacks of real translation units.
+  unsigned NumFileIDs = std::max(1024U, unsigned(Inputs.size()));
+  for (unsigned I = 0; I != NumFileIDs; ++I) {
+    SourceLocation IncludeLoc;
+    if (I)
+      IncludeLoc = SourceMgr.getLocForStartOfFile(FileIDs[(I - 1) / 2]);
+    const FileEntry *Entry = Inputs[I % Inputs.size()];
+    FileIDs.push_back(SourceMgr.createFileID(Entry, IncludeLoc,
+                                             SrcMgr::C_User));
+    if (Entry->getSize() > LargestSize) {
+      LargestFile = FileIDs.back();
+      LargestSize = Entry->getSize();
+    }
+  }
+  SourceMgr.setMainFileID(FileIDs[0]);
+
+  Random R;
+  for (unsigned I = 0; I != 4096; ++I) {
+    unsigned Index = R.next(FileIDs.size());
+    unsigned Size = Inputs[Index % Inputs.size()]->getSize();
+    Locations.push_back(SourceMgr.getLocForStartOfFile(FileIDs[Index])
+                          .getLocWithOffset(R.next(Size)));
+  }
+  return true;
+}
+
+//===----------------------------------------------------------------------===//
+// The benchmarks
+//===----------------------------------------------------------------------===//
+
+namespace {
+/// MicroBenchmark - Some operation to time.
+class MicroBenchmark {
+public:
+  virtual ~MicroBenchmark() {}
+
+  virtual const char *getName() const = 0;
+
+  /// \brief Prepare to run, outside of the measurements.
+  virtual bool setUp(Environment &Env) { return true; }
+
+  /// \brief Perform the operation a number of times.
+  ///
+  /// \returns the number of operations performed.
+  virtual uint64_t run(Environment &Env) = 0;
+};
+
+/// Raw-lex each input, which runs Lexer::LexTokenInternal once per token.
+class LexBenchmark : public MicroBenchmark {
+public:
+  virtual const char *getName() const { return "lexer-raw"; }
+
+  virtual uint64_t run(Environment &Env) {
+    uint64_t Tokens = 0;
+    for (unsigned I = 0, N = Env.Inputs.size(); I != N; ++I) {
+      FileID FID = Env.FileIDs[I];
+      Lexer L(FID, Env.SourceMgr.getBuffer(FID), Env.SourceMgr,
+              Env.LangOpts);
+      Token Tok;
+      do {
+        L.LexFromRawLexer(Tok);
+        Sink += Tok.getKind();
+        ++Tokens;
+      } while (Tok.isNot(tok::eof));
+    }
+    return Tokens;
+  }
+};
+
+/// Map locations scattered over the tree of files back to their files.
+class GetFileIDBenchmark : public MicroBenchmark {
+public:
+  virtual const char *getName() const { return "source-manager-getFileID"; }
+
+  virtual uint64_t run(Environment &Env) {
+    const std::vector<SourceLocation> &Locs = Env.Locations;
+    for (unsigned I = 0, N = Locs.size(); I != N; ++I)
+      Sink += Env.SourceMgr.getFileID(Locs[I]).getHashValue();
+    return Locs.size();
+  }
+};
+
+/// Compute the line numbers of random offsets in the largest input.
+class GetLineNumberBenchmark : public MicroBenchmark {
+  std::vector<unsigned> Offsets;
+
+public:
+  virtual const char *getName() const {
+    return "source-manager-getLineNumber";
+  }
+
+  virtual bool setUp(Environment &Env) {
+    Random R;
+    for (unsigned I = 0; I != 4096; ++I)
+      Offsets.push_back(R.next(Env.LargestSize));
+    return true;
+  }
+
+  virtual uint64_t run(Environment &Env) {
+    for (unsigned I = 0, N = Offsets.size(); I != N; ++I)
+      Sink += Env.SourceMgr.getLineNumber(Env.LargestFile, Offsets[I]);
+    return Offsets.size();
+  }
+};
+
+/// Order pairs of locations in different files of the tree.
+class IsBeforeBenchmark : public MicroBenchmark {
+public:
+  virtual const char *getName() const {
+    return "source-manager-isBeforeInTranslationUnit";
+  }
+
+  virtual uint64_t run(Environment &Env) {
+    const std::vector<SourceLocation> &Locs = Env.Locations;
+    for (unsigned I = 1, N = Locs.size(); I != N; ++I)
+      Sink += Env.SourceMgr.isBeforeInTranslationUnit(Locs[I - 1], Locs[I]);
+    return Locs.size() - 1;
+  }
+};
+
+/// Look up the identifiers of the inputs, in order, in a table which either
+/// holds them already or starts out with the keywords only, or through the
+/// cache the lexer uses.
+class IdentifierTableBenchmark : public MicroBenchmark {
+public:
+  enum Kind { Warm, Cold, ForLexer };
+
+private:
+  Kind K;
+  std::vector<std::string> Identifiers;
+  OwningPtr<IdentifierTable> Table;
+
+public:
+  explicit IdentifierTableBenchmark(Kind K) : K(K) {}
+
+  virtual const char *getName() const {
+    switch (K) {
+    case Warm:     return "identifier-table-get-warm";
+    case Cold:     return "identifier-table-get-cold";
+    case ForLexer: return "identifier-table-getForLexer";
+    }
+    llvm_unreachable("invalid kind");
+  }
+
+  virtual bool setUp(Environment &Env) {
+    for (unsigned I = 0, N = Env.Inputs.size(); I != N; ++I) {
+      FileID FID = Env.FileIDs[I];
+      Lexer L(FID, Env.SourceMgr.getBuffer(FID), Env.SourceMgr,
+              Env.LangOpts);
+      Token Tok;
+      do {
+        L.LexFromRawLexer(Tok);
+        if (Tok.is(tok::raw_identifier))
+          Identifiers.push_back(std::string(Tok.getRawIdentifierData(),
+                                            Tok.getLength()));
+      } while (Tok.isNot(tok::eof));
+    }
+    Table.reset(new IdentifierTable(Env.LangOpts));
+    return !Identifiers.empty();
+  }
+
+  virtual uint64_t run(Environment &Env) {
+    // A cold run pays for adding the keywords to the new table as well.
+    if (K == Cold)
+      Table.reset(new IdentifierTable(Env.LangOpts));
+    if (K == ForLexer) {
+      for (unsigned I = 0, N = Identifiers.size(); I != N; ++I)
+        Sink += uintptr_t(&Table->getForLexer(Identifiers[I]));
+    } else {
+      for (unsigned I = 0, N = Identifiers.size(); I != N; ++I)
+        Sink += uintptr_t(&Table->get(Identifiers[I]));
+    }
+    return Identifiers.size();
+  }
+};
+
+/// Look up the inputs in a file manager which either has seen them already or
+/// has to stat them.
+class GetFileBenchmark : public MicroBenchmark {
+  bool Cold;
+  OwningPtr<FileManager> FileMgr;
+
+public:
+  explicit GetFileBenchmark(bool Cold) : Cold(Cold) {}
+
+  virtual const char *getName() const {
+    return Cold ? "file-manager-getFile-cold" : "file-manager-getFile-warm";
+  }
+
+  virtual bool setUp(Environment &Env) {
+    FileMgr.reset(new FileManager(Env.FileSystemOpts));
+    return true;
+  }
+
+  virtual uint64_t run(Environment &Env) {
+    if (Cold)
+      FileMgr.reset(new FileManager(Env.FileSystemOpts));
+    for (unsigned I = 0, N = InputFiles.size(); I != N; ++I)
+      Sink += uintptr_t(FileMgr->getFile(InputFiles[I]));
+    return InputFiles.size();
+  }
+};
+
+/// Find each input by its name, or a name no directory has, behind
+/// -search-dirs empty directories.
+class LookupFileBenchmark : public MicroBenchmark {
+  bool Missing;
+  sys::Path TempDir;
+  OwningPtr<FileManager> FileMgr;
+  OwningPtr<HeaderSearch> HeaderInfo;
+  std::vector<std::string> Names;
+
+public:
+  explicit LookupFileBenchmark(bool Missing) : Missing(Missing) {}
+
+  ~LookupFileBenchmark() {
+    if (!TempDir.isEmpty())
+      TempDir.eraseFromDisk(/*destroy_contents=*/true);
+  }
+
+  virtual const char *getName() const {
+    return Missing ? "header-search-LookupFile-missing"
+                   : "header-search-LookupFile";
+  }
+
+  virtual bool setUp(Environment &Env);
+
+  virtual uint64_t run(Environment &Env) {
+    for (unsigned I = 0, N = Names.size(); I != N; ++I) {
+      const DirectoryLookup *CurDir;
+      Sink += uintptr_t(HeaderInfo->LookupFile(Names[I], /*isAngled=*/true,
+                                               /*FromDir=*/0, CurDir,
+                                               /*CurFileEnt=*/0,
+                                               /*SearchPath=*/0,
+                                               /*RelativePath=*/0,
+                                               /*SuggestedModule=*/0,
+                                               /*SkipCache=*/true));
+    }
+    return Names.size();
+  }
+};
+}
+
+bool LookupFileBenchmark::setUp(Environment &Env) {
+  std::string Error;
+  TempDir = sys::Path::GetTemporaryDirectory(&Error);
+  if (TempDir.isEmpty()) {
+    errs() << "error: cannot create a temporary directory: " << Error << "\n";
+    return false;
+  }
+
+  FileMgr.reset(new FileManager(Env.FileSystemOpts));
+  HeaderInfo.reset(new HeaderSearch(*FileMgr, Env.Diags, Env.LangOpts,
+                                    Env.Target.getPtr()));
+  std::vector<DirectoryLookup> Dirs;
+  for (unsigned I = 0; I != SearchDirs; ++I) {
+    sys::Path Dir(TempDir);
+    Dir.appendComponent("dir" + utostr(I));
+    if (Dir.createDirectoryOnDisk(/*create_parents=*/false, &Error)) {
+      errs() << "error: " << Error << "\n";
+      return false;
+    }
+    Dirs.push_back(DirectoryLookup(FileMgr->getDirectory(Dir.str()),
+                                   SrcMgr::C_User, /*isUser=*/true,
+                                   /*isFramework=*/false));
+  }
+
+  // Behind the empty directories come those of the inputs.
+  for (unsigned I = 0, N = InputFiles.size(); I != N; ++I) {
+    StringRef Parent = sys::path::parent_path(InputFiles[I]);
+    const DirectoryEntry *Dir =
+      FileMgr->getDirectory(Parent.empty() ? StringRef(".") : Parent);
+    if (!Dir)
+      continue;
+    bool Seen = false;
+    for (unsigned J = 0, M = Dirs.size(); J != M && !Seen; ++J)
+      Seen = Dirs[J].getDir() == Dir;
+    if (!Seen)
+      Dirs.push_back(DirectoryLookup(Dir, SrcMgr::C_User, /*isUser=*/true,
+                                     /*isFramework=*/false));
+    Names.push_back(sys::path::filename(InputFiles[I]).str());
+    if (Missing)
+      Names.back() += ".missing";
+  }
+  HeaderInfo->SetSearchPaths(Dirs, /*angledDirIdx=*/0,
+                             /*systemDirIdx=*/Dirs.size(),
+                             /*noCurDirSearch=*/true);
+  return !Names.empty();
+}
+
+namespace {
+/// Parse a cc1 command line of a size and mix of options found in large
+/// builds: many -I, -isystem and -D, warnings, and a few dozen flags.
+class ParseArgsBenchmark : public MicroBenchmark {
+  OwningPtr<driver::OptTable> Opts;
+  std::vector<std::string> Strings;
+  std::vector<const char *> Args;
+
+public:
+  virtual const char *getName() const { return "opt-table-ParseArgs"; }
+
+  virtual bool setUp(Environment &Env);
+
+  virtual uint64_t run(Environment &Env) {
+    unsigned MissingArgIndex, MissingArgCount;
+    OwningPtr<driver::InputArgList> Parsed(
+      Opts->ParseArgs(&Args[0], &Args[0] + Args.size(),
+                      MissingArgIndex, MissingArgCount));
+    Sink += Parsed->size();
+    return Args.size();
+  }
+};
+}
+
+bool ParseArgsBenchmark::setUp(Environment &Env) {
+  static const char *const Flags[] = {
+    "-triple", "x86_64-unknown-linux-gnu", "-emit-obj", "-disable-free",
+    "-main-file-name", "file.cpp", "-mrelocation-model", "pic",
+    "-pic-level", "2", "-mdisable-fp-elim", "-fmath-errno", "-masm-verbose",
+    "-mconstructor-aliases", "-munwind-tables", "-target-cpu", "x86-64",
+    "-target-linker-version", "2.22", "-g", "-coverage-file", "file.o",
+    "-resource-dir", "/usr/lib/clang/3.2", "-O2", "-std=c++11",
+    "-fdeprecated-macro", "-fdebug-compilation-dir", "/src/build",
+    "-ferror-limit", "19", "-fmessage-length", "0", "-fvisibility", "hidden",
+    "-fcxx-exceptions", "-fexceptions", "-fdiagnostics-show-option",
+    "-fcolor-diagnostics", "-ffunction-sections", "-fdata-sections",
+    "-fno-strict-aliasing", "-stack-protector", "1"
+  };
+  static const char *const Warnings[] = {
+    "-Wall", "-Wextra", "-Werror", "-Wno-unused-parameter",
+    "-Wno-missing-field-initializers", "-Wno-sign-compare", "-Wshadow",
+    "-Wno-deprecated-declarations", "-Wnon-virtual-dtor", "-Wformat=2",
+    "-Wno-error=deprecated", "-Wstrict-overflow"
+  };
+
+  Opts.reset(driver::createDriverOptTable());
+  Strings.assign(Flags, Flags + array_lengthof(Flags));
+  Strings.insert(Strings.end(), Warnings, Warnings + array_lengthof(Warnings));
+  for (unsigned I = 0; I != 120; ++I) {
+    Strings.push_back("-I");
+    Strings.push_back("/src/project/module" + utostr(I) + "/include");
+  }
+  for (unsigned I = 0; I != 20; ++I) {
+    Strings.push_back("-isystem");
+    Strings.push_back("/src/third_party/lib" + utostr(I) + "/include");
+  }
+  for (unsigned I = 0; I != 80; ++I)
+    Strings.push_back("-DPROJECT_FEATURE_" + utostr(I) + "=1");
+  Strings.push_back("-o");
+  Strings.push_back("file.o");
+  Strings.push_back("-x");
+  Strings.push_back("c++");
+  Strings.push_back("file.cpp");
+
+  for (unsigned I = 0, N = Strings.size(); I != N; ++I)
+    Args.push_back(Strings[I].c_str());
+  return true;
+}
+
+//===----------------------------------------------------------------------===//
+// Running the benchmarks
+//===----------------------------------------------------------------------===//
+
+static double getMedian(std::vector<double> Values) {
+  std::sort(Values.begin(), Values.end());
+  unsigned N = Values.size();
+  return N % 2 ? Values[N / 2] : (Values[N / 2 - 1] + Values[N / 2]) / 2;
+}
+
+/// \brief Time \p B, printing its results to \p OS.
+static void runBenchmark(MicroBenchmark &B, Environment &Env,
+                         raw_ostream &OS) {
+  // One unmeasured run fills the caches.
+  B.run(Env);
+
+  std::vector<double> NanosPerOp;
+  uint64_t Operations = 0;
+  for (unsigned R = 0; R != Repetitions; ++R) {
+    uint64_t Ops = 0;
+    double Start = getCurrentTimeInSeconds(), Elapsed;
+    do {
+      Ops += B.run(Env);
+      Elapsed = getCurrentTimeInSeconds() - Start;
+    } while (Elapsed < MinTime);
+    NanosPerOp.push_back(Elapsed * 1e9 / Ops);
+    Operations += Ops;
+  }
+
+  OS << "    { \"name\": \"" << B.getName() << "\", \"operations\": "
+     << Operations
+     << format(", \"ns_per_op\": { \"min\": %.3f, \"median\": %.3f } }",
+               *std::min_element(NanosPerOp.begin(), NanosPerOp.end()),
+               getMedian(NanosPerOp));
+}
+
+int main(int argc, char **argv) {
+  sys::PrintStackTraceOnErrorSignal();
+  PrettyStackTraceProgram X(argc, argv);
+  llvm_shutdown_obj Y;
+  cl::ParseCommandLineOptions(argc, argv,
+                              "benchmarks of the lexer and source manager\n");
+  if (Repetitions == 0)
+    Repetitions = 1;
+
+  Environment Env;
+  if (!Env.initialize())
+    return 1;
+
+  std::string OutputError;
+  raw_fd_ostream OS(OutputFile.c_str(), OutputError);
+  if (!OutputError.empty()) {
+    errs() << "error: cannot open '" << OutputFile << "': " << OutputError
+           << "\n";
+    return 1;
+  }
+
+  LexBenchmark Lex;
+  GetFileIDBenchmark GetFileID;
+  GetLineNumberBenchmark GetLineNumber;
+  IsBeforeBenchmark IsBefore;
+  IdentifierTableBenchmark IdentifiersWarm(IdentifierTableBenchmark::Warm);
+  IdentifierTableBenchmark IdentifiersCold(IdentifierTableBenchmark::Cold);
+  IdentifierTableBenchmark IdentifiersForLexer(
+    IdentifierTableBenchmark::ForLexer);
+  GetFileBenchmark GetFileWarm(false), GetFileCold(true);
+  LookupFileBenchmark LookupFile(false), LookupMissing(true);
+  ParseArgsBenchmark ParseArgs;
+  MicroBenchmark *Benchmarks[] = {
+    &Lex, &GetFileID, &GetLineNumber, &IsBefore, &IdentifiersWarm,
+    &IdentifiersCold, &IdentifiersForLexer, &GetFileWarm, &GetFileCold,
+    &LookupFile, &LookupMissing, &ParseArgs
+  };
+
+  OS << "{\n  \"inputs\": " << InputFiles.size()
+     << ",\n  \"repetitions\": " << Repetitions << ",\n  \"benchmarks\": [";
+  bool First = true, Failed = false;
+  for (unsigned I = 0; I != array_lengthof(Benchmarks); ++I) {
+    MicroBenchmark &B = *Benchmarks[I];
+    if (!OnlyBenchmarks.empty() &&
+        std::find(OnlyBenchmarks.begin(), OnlyBenchmarks.end(),
+                  B.getName()) == OnlyBenchmarks.end())
+      continue;
+    if (!B.setUp(Env)) {
+      errs() << "error: cannot set up benchmark '" << B.getName() << "'\n";
+      Failed = true;
+      continue;
+    }
+    OS << (First ? "\n" : ",\n");
+    First = false;
+    runBenchmark(B, Env, OS);
+  }
+  OS << "\n  ]\n}\n";
+  return Failed;
+}
@@ -13,6 +13,7 @@
 //
 //===----------------------------------------------------------------------===//
 
+#include "clang/Basic/FileSystemStatCache.h"
 #include "clang/Driver/Arg.h"
 #include "clang/Driver/ArgList.h"
 #include "clang/Driver/Options.h"
@@ -32,6 +33,7 @@
 #include "llvm/Support/raw_ostream.h"
 #include "llvm/LinkAllPasses.h"
 #include <cstdio>
+#include <vector>
 using namespace clang;
 
 //===----------------------------------------------------------------------===//
@@ -115,8 +117,26 @@ static int cc1_test(DiagnosticsEngine &Diags,
   return 0;
 }
 
-int cc1_main(const char **ArgBegin, const char **ArgEnd,
-             const char *Argv0, void *MainAddr) {
+namespace {
+/// \brief How a clang -cc1 command is run.
+enum CC1Mode {
+  /// \brief As the only command of the process.
+  CC1_Process,
+  /// \brief Inside the driver process, for one of possibly many commands.
+  CC1_Integrated,
+  /// \brief As one of the requests of a compile server, see cc1serve_main.
+  CC1_Server
+};
+}
+
+/// \brief Run clang -cc1.
+///
+/// Unless \p Mode is CC1_Process, more commands follow in the same process:
+/// the compiler always frees its memory and the process-wide LLVM state is
+/// left alone.
+static int ExecuteCC1(const char **ArgBegin, const char **ArgEnd,
+                      const char *Argv0, void *MainAddr, CC1Mode Mode) {
+  bool Integrated = Mode != CC1_Process;
   OwningPtr<CompilerInstance> Clang(new CompilerInstance());
   IntrusiveRefCntPtr<DiagnosticIDs> DiagID(new DiagnosticIDs());
 
@@ -158,8 +178,27 @@ int cc1_main(const char **ArgBegin, const char **ArgEnd,
                                   static_cast<void*>(&Clang->getDiagnostics()));
 
   DiagsBuffer->FlushDiagnostics(Clang->getDiagnostics());
-  if (!Success)
+  if (!Success) {
+    llvm::remove_fatal_error_handler();
     return 1;
+  }
+
+  // The driver runs further commands after this one, so -disable-free would
+  // only accumulate leaked memory.
+  if (Integrated)
+    Clang->getFrontendOpts().DisableFree = false;
+
+  if (Mode == CC1_Server) {
+    // The file system lookups of one request are reused by the next.
+    Clang->getFileSystemOpts().UseSharedStatCache = true;
+
+    // LLVM options are process-wide and can only be parsed once.
+    if (!Clang->getFrontendOpts().LLVMArgs.empty()) {
+      Clang->getDiagnostics().Report(diag::err_fe_server_llvm_args);
+      llvm::remove_fatal_error_handler();
+      return 1;
+    }
+  }
 
   // Execute the frontend actions.
   Success = ExecuteCompilerInvocation(Clang.get());
@@ -181,9 +220,91 @@ int cc1_main(const char **ArgBegin, const char **ArgEnd,
     return !Success;
   }
 
+  // Leave the managed statics to the driver, which may still need them.
+  if (Integrated) {
+    if (llvm::AreStatisticsEnabled() || Clang->getFrontendOpts().ShowStats)
+      llvm::PrintStatistics();
+    return !Success;
+  }
+
   // Managed static deconstruction. Useful for making things like
   // -time-passes usable.
   llvm::llvm_shutdown();
 
   return !Success;
 }
+
+int cc1_main(const char **ArgBegin, const char **ArgEnd,
+             const char *Argv0, void *MainAddr) {
+  return ExecuteCC1(ArgBegin, ArgEnd, Argv0, MainAddr, CC1_Process);
+}
+
+int cc1_main_integrated(const char **ArgBegin, const char **ArgEnd,
+                        const char *Argv0, void *MainAddr) {
+  return ExecuteCC1(ArgBegin, ArgEnd, Argv0, MainAddr, CC1_Integrated);
+}
+
+/// \brief Read a line from \p In, without its newline.
+///
+/// \returns false at the end of the input, if nothing was read.
+static bool readLine(FILE *In, std::string &Line) {
+  Line.clear();
+  int C;
+  while ((C = getc(In)) != EOF && C != '\n')
+    Line += char(C);
+  return C != EOF || !Line.empty();
+}
+
+/// \brief Run clang -cc1 commands in this process, as requested on the
+/// standard input, until it ends.
+///
+/// A request is a block of lines ended by an empty line. Usually the lines
+/// are the arguments of a clang -cc1 command, one per line. The command
+/// runs as it would in a process of its own, with its diagnostics on the
+/// standard error, except that the targets are only initialized once and the
+/// file system lookups are shared with the later requests. A request whose
+/// first line is "#invalidate" instead forgets the lookups of the absolute
+/// paths on its other lines, or of all paths if there are none; it must be
+/// sent for files that were created since an earlier request looked for
+/// them. Files that changed are noticed without it.
+///
+/// Each request is answered with a line "exit <status>" on the standard
+/// output, which the commands must therefore not write to. A fatal error in
+/// the backend ends the server.
+int cc1serve_main(const char **ArgBegin, const char **ArgEnd,
+                  const char *Argv0, void *MainAddr) {
+  if (ArgBegin != ArgEnd) {
+    llvm::errs() << "error: clang -cc1serve takes no arguments\n";
+    return 1;
+  }
+
+  std::string Line;
+  while (readLine(stdin, Line)) {
+    std::vector<std::string> Request;
+    for (; !Line.empty(); readLine(stdin, Line))
+      Request.push_back(Line);
+    if (Request.empty())
+      continue;
+
+    int Status = 0;
+    if (Request[0] == "#invalidate") {
+      if (Request.size() == 1)
+        SharedStatCache::invalidateAll();
+      for (unsigned I = 1, N = Request.size(); I != N; ++I)
+        SharedStatCache::invalidate(Request[I]);
+    } else {
+      SmallVector<const char *, 64> Args;
+      for (unsigned I = 0, N = Request.size(); I != N; ++I)
+        Args.push_back(Request[I].c_str());
+      Status = ExecuteCC1(Args.begin(), Args.end(), Argv0, MainAddr,
+                          CC1_Server);
+    }
+
+    llvm::errs().flush();
+    llvm::outs() << "exit " << Status << "\n";
+    llvm::outs().flush();
+  }
+
+  llvm::llvm_shutdown();
+  return 0;
+}
@@ -184,9 +184,21 @@ static void ApplyQAOverride(SmallVectorImpl<const char*> &Args,
 
 extern int cc1_main(const char **ArgBegin, const char **ArgEnd,
                     const char *Argv0, void *MainAddr);
+extern int cc1_main_integrated(const char **ArgBegin, const char **ArgEnd,
+                               const char *Argv0, void *MainAddr);
+extern int cc1serve_main(const char **ArgBegin, const char **ArgEnd,
+                         const char *Argv0, void *MainAddr);
 extern int cc1as_main(const char **ArgBegin, const char **ArgEnd,
                       const char *Argv0, void *MainAddr);
 
+/// \brief Runs "clang -cc1" commands of the compilation in the driver process,
+/// see -integrated-cc1.
+static int ExecuteIntegratedCC1(const char **ArgBegin, const char **ArgEnd,
+                                const char *Argv0) {
+  return cc1_main_integrated(ArgBegin, ArgEnd, Argv0,
+                             (void*) (intptr_t) GetExecutablePath);
+}
+
 static void ExpandArgsFromBuf(const char *Arg,
                               SmallVectorImpl<const char*> &ArgVector,
                               std::set<std::string> &SavedStrings) {
@@ -359,6 +371,9 @@ int main(int argc_, const char **argv_) {
     if (Tool == "as")
       return cc1as_main(argv.data()+2, argv.data()+argv.size(), argv[0],
                       (void*) (intptr_t) GetExecutablePath);
+    if (Tool == "serve")
+      return cc1serve_main(argv.data()+2, argv.data()+argv.size(), argv[0],
+                           (void*) (intptr_t) GetExecutablePath);
 
     // Reject unknown tools.
     llvm::errs() << "error: unknown integrated tool '" << Tool << "'\n";
@@ -469,6 +484,8 @@ int main(int argc_, const char **argv_) {
     argv.insert(&argv[1], ExtraArgs.begin(), ExtraArgs.end());
   }
 
+  TheDriver.CC1Main = ExecuteIntegratedCC1;
+
   OwningPtr<Compilation> C(TheDriver.BuildCompilation(argv));
   int Res = 0;
   const Command *FailingCommand = 0;
@@ -29,10 +29,12 @@
 #include "clang/Frontend/ASTUnit.h"
 #include "clang/Frontend/CompilerInstance.h"
 #include "clang/Frontend/FrontendDiagnostic.h"
+#include "clang/Frontend/PreambleCache.h"
 #include "clang/Lex/Lexer.h"
 #include "clang/Lex/HeaderSearch.h"
 #include "clang/Lex/PreprocessingRecord.h"
 #include "clang/Lex/Preprocessor.h"
+#include "llvm/ADT/DenseMap.h"
 #include "llvm/ADT/STLExtras.h"
 #include "llvm/ADT/Optional.h"
 #include "llvm/ADT/StringSwitch.h"
@@ -63,14 +65,129 @@ CXTranslationUnit cxtu::MakeCXTranslationUnit(CIndexer *CIdx, ASTUnit *TU) {
   D->StringPool = createCXStringPool();
   D->Diagnostics = 0;
   D->OverridenCursorsPool = createOverridenCXCursorsPool();
+  D->CursorCache = 0;
+  D->USRCache = 0;
+  D->FileRefIndex = 0;
+  D->LastUse = 0;
+  D->QueryMutex = 0;
+  D->ActiveQueries = 0;
+  if (CIdx) {
+    D->LastUse = CIdx->nextUse();
+    CIdx->addTranslationUnit(D);
+  }
   return D;
 }
 
+namespace {
+/// \brief The cursors found by cxcursor::getCursor() in a translation unit,
+/// keyed by the raw encoding of the beginning of the token they were asked for.
+///
+/// Clients such as IDEs ask for the cursor under the mouse pointer over and
+/// over again, mostly for the same few tokens, and every lookup otherwise
+/// walks the region around the token again.
+typedef llvm::DenseMap<unsigned, CXCursor> CursorCacheTy;
+
+/// \brief The number of cursors after which the cursor cache is cleared.
+enum { MaxCursorCacheSize = 4096 };
+}
+
+/// \brief Drop the cursors, USRs and references cached for the translation
+/// unit, when its AST goes away.
+static void disposeCursorCache(CXTranslationUnit TU) {
+  delete static_cast<CursorCacheTy *>(TU->CursorCache);
+  TU->CursorCache = 0;
+  disposeUSRCache(TU);
+  disposeFileRefIndex(TU);
+}
+
 cxtu::CXTUOwner::~CXTUOwner() {
   if (TU)
     clang_disposeTranslationUnit(TU);
 }
 
+cxtu::CXTUQueryLock::CXTUQueryLock(CXTranslationUnit TU)
+  : TU(TU), Mutex(TU ? TU->QueryMutex : 0) {
+  if (Mutex)
+    static_cast<llvm::sys::Mutex *>(Mutex)->acquire();
+  if (TU)
+    llvm::sys::AtomicIncrement(&TU->ActiveQueries);
+}
+
+cxtu::CXTUQueryLock::~CXTUQueryLock() {
+  if (TU)
+    llvm::sys::AtomicDecrement(&TU->ActiveQueries);
+  if (Mutex)
+    static_cast<llvm::sys::Mutex *>(Mutex)->release();
+}
+
+ASTUnit *cxtu::getASTUnit(CXTranslationUnit TU) {
+  ASTUnit *Unit = static_cast<ASTUnit *>(TU->TUData);
+  if (CIndexer *CXXIdx = static_cast<CIndexer *>(TU->CIdx))
+    TU->LastUse = CXXIdx->nextUse();
+  if (Unit->isASTUnloaded()) {
+    Unit->reloadAST();
+    enforceMemoryBudget(TU);
+  }
+  return Unit;
+}
+
+namespace {
+struct TUMemoryUsage {
+  unsigned long long LastUse;
+  unsigned long long Bytes;
+  CXTranslationUnit TU;
+
+  bool operator<(const TUMemoryUsage &Other) const {
+    return LastUse < Other.LastUse;
+  }
+};
+}
+
+/// \brief The memory used by \p TU, as reported by
+/// clang_getCXTUResourceUsage().
+static unsigned long long getTUMemoryUsage(CXTranslationUnit TU) {
+  CXTUResourceUsage Usage = clang_getCXTUResourceUsage(TU);
+  unsigned long long Bytes = 0;
+  for (unsigned I = 0; I != Usage.numEntries; ++I)
+    Bytes += Usage.entries[I].amount;
+  clang_disposeCXTUResourceUsage(Usage);
+  return Bytes;
+}
+
+void cxtu::enforceMemoryBudget(CXTranslationUnit TU) {
+  CIndexer *CXXIdx = static_cast<CIndexer *>(TU->CIdx);
+  if (!CXXIdx || !CXXIdx->getMemoryBudget())
+    return;
+
+  const std::vector<CXTranslationUnit> &TUs = CXXIdx->getTranslationUnits();
+  SmallVector<TUMemoryUsage, 16> Usages;
+  unsigned long long Total = 0;
+  for (unsigned I = 0, N = TUs.size(); I != N; ++I) {
+    TUMemoryUsage Usage = { TUs[I]->LastUse, getTUMemoryUsage(TUs[I]),
+                            TUs[I] };
+    Total += Usage.Bytes;
+    Usages.push_back(Usage);
+  }
+  std::sort(Usages.begin(), Usages.end());
+
+  for (unsigned I = 0, N = Usages.size();
+       I != N && Total > CXXIdx->getMemoryBudget(); ++I) {
+    CXTranslationUnit Victim = Usages[I].TU;
+    ASTUnit *Unit = static_cast<ASTUnit *>(Victim->TUData);
+    // The caller is about to use TU, and the ASTs of the units with queries
+    // in progress are in use further up the stack or on other threads.
+    if (Victim == TU || Victim->ActiveQueries != 0 ||
+        Unit->isASTUnloaded() || Unit->unloadAST())
+      continue;
+
+    // These refer to the AST that was freed.
+    delete static_cast<CXDiagnosticSetImpl *>(Victim->Diagnostics);
+    Victim->Diagnostics = 0;
+    disposeCursorCache(Victim);
+    Total -= Usages[I].Bytes - getTUMemoryUsage(Victim);
+  }
+}
+
 /// \brief Compare two source ranges to determine their relative position in
 /// the translation unit.
 static RangeComparisonResult RangeCompare(SourceManager &SM,
@@ -218,7 +335,7 @@ void CursorVisitor::visitFileRegion() {
   if (RegionOfInterest.isInvalid())
     return;
 
-  ASTUnit *Unit = static_cast<ASTUnit *>(TU->TUData);
+  ASTUnit *Unit = cxtu::getASTUnit(TU);
   SourceManager &SM = Unit->getSourceManager();
   
   std::pair<FileID, unsigned>
@@ -264,7 +381,7 @@ static bool isInLexicalContext(Decl *D, DeclContext *DC) {
 
 void CursorVisitor::visitDeclsFromFileRegion(FileID File,
                                              unsigned Offset, unsigned Length) {
-  ASTUnit *Unit = static_cast<ASTUnit *>(TU->TUData);
+  ASTUnit *Unit = cxtu::getASTUnit(TU);
   SourceManager &SM = Unit->getSourceManager();
   SourceRange Range = RegionOfInterest;
 
@@ -476,7 +593,7 @@ bool CursorVisitor::VisitChildren(CXCursor Cursor) {
 
   if (clang_isTranslationUnit(Cursor.kind)) {
     CXTranslationUnit tu = getCursorTU(Cursor);
-    ASTUnit *CXXUnit = static_cast<ASTUnit*>(tu->TUData);
+    ASTUnit *CXXUnit = cxtu::getASTUnit(tu);
     
     int VisitOrder[2] = { VisitPreprocessorLast, !VisitPreprocessorLast };
     for (unsigned I = 0; I != 2; ++I) {
@@ -2432,6 +2549,15 @@ CXIndex clang_createIndex(int excludeDeclarationsFromPCH,
       llvm::install_fatal_error_handler(fatal_error_handler, 0);
       llvm::llvm_start_multithreaded();
       EnabledMultithreading = true;
+
+      // Let precompiled preambles outlive this process if requested.
+      if (const char *CacheDir = getenv("LIBCLANG_PREAMBLE_CACHE")) {
+        uint64_t MaxSizeInMB = 1024;
+        if (const char *Size = getenv("LIBCLANG_PREAMBLE_CACHE_SIZE"))
+          StringRef(Size).getAsInteger(10, MaxSizeInMB);
+        PreambleCache::setShared(new PreambleCache(CacheDir,
+                                                   MaxSizeInMB << 20));
+      }
     }
   }
 
@@ -2467,6 +2593,13 @@ unsigned clang_CXIndex_getGlobalOptions(CXIndex CIdx) {
   return 0;
 }
 
+void clang_CXIndex_setMemoryBudget(CXIndex CIdx, unsigned long long Bytes) {
+  if (!CIdx)
+    return;
+  CIndexer *CXXIdx = static_cast<CIndexer *>(CIdx);
+  CXXIdx->setMemoryBudget(Bytes);
+}
+
 void clang_toggleCrashRecovery(unsigned isEnabled) {
   if (isEnabled)
     llvm::CrashRecoveryContext::Enable();
@@ -2617,6 +2750,11 @@ static void clang_parseTranslationUnit_Impl(void *UserData) {
     Args->push_back("-Xclang");
     Args->push_back("-detailed-preprocessing-record");
   }
+
+  if (options & CXTranslationUnit_SkipFunctionBodiesOutsideMainFile) {
+    Args->push_back("-Xclang");
+    Args->push_back("-skip-function-bodies-outside-main-file");
+  }
   
   unsigned NumErrors = Diags->getClient()->getNumErrors();
   OwningPtr<ASTUnit> ErrUnit;
@@ -2640,6 +2778,9 @@ static void clang_parseTranslationUnit_Impl(void *UserData) {
                                  /*UserFilesAreVolatile=*/true,
                                  &ErrUnit));
 
+  if (Unit && (options & CXTranslationUnit_BackgroundPreamble))
+    Unit->setBackgroundPreambleRebuild(true);
+
   if (NumErrors != Diags->getClient()->getNumErrors()) {
     // Make sure to check that 'Unit' is non-NULL.
     if (CXXIdx->getDisplayDiagnostics())
@@ -2647,6 +2788,10 @@ static void clang_parseTranslationUnit_Impl(void *UserData) {
   }
 
   PTUI->result = MakeCXTranslationUnit(CXXIdx, Unit.take());
+  if (PTUI->result && (options & CXTranslationUnit_ThreadSafeQueries))
+    PTUI->result->QueryMutex = new llvm::sys::Mutex;
+  if (PTUI->result)
+    enforceMemoryBudget(PTUI->result);
 }
 CXTranslationUnit clang_parseTranslationUnit(CXIndex CIdx,
                                              const char *source_filename,
@@ -2720,7 +2865,8 @@ int clang_saveTranslationUnit(CXTranslationUnit TU, const char *FileName,
   if (!TU)
     return CXSaveError_InvalidTU;
 
-  ASTUnit *CXXUnit = static_cast<ASTUnit *>(TU->TUData);
+  CXTUQueryLock Lock(TU);
+  ASTUnit *CXXUnit = cxtu::getASTUnit(TU);
   ASTUnit::ConcurrencyCheck Check(*CXXUnit);
   if (!CXXUnit->hasSema())
     return CXSaveError_InvalidTU;
@@ -2759,6 +2905,9 @@ int clang_saveTranslationUnit(CXTranslationUnit TU, const char *FileName,
 
 void clang_disposeTranslationUnit(CXTranslationUnit CTUnit) {
   if (CTUnit) {
+    if (CIndexer *CXXIdx = static_cast<CIndexer *>(CTUnit->CIdx))
+      CXXIdx->removeTranslationUnit(CTUnit);
+
     // If the translation unit has been marked as unsafe to free, just discard
     // it.
     if (static_cast<ASTUnit *>(CTUnit->TUData)->isUnsafeToFree())
@@ -2768,6 +2917,8 @@ void clang_disposeTranslationUnit(CXTranslationUnit CTUnit) {
     disposeCXStringPool(CTUnit->StringPool);
     delete static_cast<CXDiagnosticSetImpl *>(CTUnit->Diagnostics);
     disposeOverridenCXCursorsPool(CTUnit->OverridenCursorsPool);
+    disposeCursorCache(CTUnit);
+    delete static_cast<llvm::sys::Mutex *>(CTUnit->QueryMutex);
     delete CTUnit;
   }
 }
@@ -2806,8 +2957,14 @@ static void clang_reparseTranslationUnit_Impl(void *UserData) {
   if (CXXIdx->isOptEnabled(CXGlobalOpt_ThreadBackgroundPriorityForEditing))
     setThreadBackgroundPriority();
 
+  CXTUQueryLock Lock(TU);
+  // Reparsing reloads an unloaded AST anyway.
   ASTUnit *CXXUnit = static_cast<ASTUnit *>(TU->TUData);
   ASTUnit::ConcurrencyCheck Check(*CXXUnit);
+  TU->LastUse = CXXIdx->nextUse();
+
+  // The cached cursors point into the AST about to be replaced.
+  disposeCursorCache(TU);
   
   OwningPtr<std::vector<ASTUnit::RemappedFile> >
     RemappedFiles(new std::vector<ASTUnit::RemappedFile>());
@@ -2827,6 +2984,7 @@ static void clang_reparseTranslationUnit_Impl(void *UserData) {
   if (!CXXUnit->Reparse(RemappedFiles->size() ? &(*RemappedFiles)[0] : 0,
                         RemappedFiles->size()))
     RTUI->result = 0;
+  enforceMemoryBudget(TU);
 }
 
 int clang_reparseTranslationUnit(CXTranslationUnit TU,
@@ -2863,7 +3021,7 @@ CXString clang_getTranslationUnitSpelling(CXTranslationUnit CTUnit) {
 }
 
 CXCursor clang_getTranslationUnitCursor(CXTranslationUnit TU) {
-  ASTUnit *CXXUnit = static_cast<ASTUnit*>(TU->TUData);
+  ASTUnit *CXXUnit = cxtu::getASTUnit(TU);
   return MakeCXCursor(CXXUnit->getASTContext().getTranslationUnitDecl(), TU);
 }
 
@@ -2894,7 +3052,7 @@ CXFile clang_getFile(CXTranslationUnit tu, const char *file_name) {
   if (!tu)
     return 0;
 
-  ASTUnit *CXXUnit = static_cast<ASTUnit *>(tu->TUData);
+  ASTUnit *CXXUnit = cxtu::getASTUnit(tu);
 
   FileManager &FMgr = CXXUnit->getFileManager();
   return const_cast<FileEntry *>(FMgr.getFile(file_name));
@@ -2904,7 +3062,7 @@ unsigned clang_isFileMultipleIncludeGuarded(CXTranslationUnit tu, CXFile file) {
   if (!tu || !file)
     return 0;
 
-  ASTUnit *CXXUnit = static_cast<ASTUnit *>(tu->TUData);
+  ASTUnit *CXXUnit = cxtu::getASTUnit(tu);
   FileEntry *FEnt = static_cast<FileEntry *>(file);
   return CXXUnit->getPreprocessor().getHeaderSearchInfo()
                                           .isFileMultipleIncludeGuarded(FEnt);
@@ -2984,11 +3142,76 @@ static SourceLocation getLocationFromExpr(Expr *E) {
   return E->getLocStart();
 }
 
+/// \brief Append the contents of \p S, which is disposed of, to the
+/// NUL-separated \p Spellings, recording where they start in \p Offsets.
+static void appendSpelling(CXString S, std::string &Spellings,
+                           SmallVectorImpl<unsigned> &Offsets) {
+  Offsets.push_back(Spellings.size());
+  if (const char *Str = clang_getCString(S))
+    Spellings += Str;
+  Spellings += '\0';
+  clang_disposeString(S);
+}
+
+/// \brief Copy \p Items, followed by their \p Spellings, into one block of
+/// memory to be released with free(), and point the \c Spelling of each
+/// item at its own.
+template<typename T>
+static T *copyWithSpellings(const SmallVectorImpl<T> &Items,
+                            const SmallVectorImpl<unsigned> &Offsets,
+                            StringRef Spellings) {
+  size_t Size = sizeof(T) * Items.size();
+  char *Memory = static_cast<char *>(malloc(Size + Spellings.size()));
+  T *Result = reinterpret_cast<T *>(Memory);
+  std::copy(Items.begin(), Items.end(), Result);
+  memcpy(Memory + Size, Spellings.data(), Spellings.size());
+  for (unsigned I = 0, N = Items.size(); I != N; ++I)
+    Result[I].Spelling = Memory + Size + Offsets[I];
+  return Result;
+}
+
+namespace {
+/// \brief The cursors found so far by clang_getCursorSubtree().
+struct CursorSubtreeData {
+  SmallVector<CXFlatCursor, 64> Cursors;
+  SmallVector<unsigned, 64> SpellingOffsets;
+  std::string Spellings;
+  /// \brief The positions in \c Cursors of the ancestors of the cursor
+  /// visited last.
+  SmallVector<unsigned, 16> Ancestors;
+};
+}
+
+static enum CXChildVisitResult getCursorSubtreeVisit(CXCursor C,
+                                                     CXCursor Parent,
+                                                     CXClientData Data) {
+  CursorSubtreeData &Subtree = *static_cast<CursorSubtreeData *>(Data);
+
+  // The walk is depth-first, so the parent is the innermost ancestor of the
+  // previous cursor which is equal to it, if any; otherwise it is the root.
+  while (!Subtree.Ancestors.empty() &&
+         !clang_equalCursors(Subtree.Cursors[Subtree.Ancestors.back()].Cursor,
+                             Parent))
+    Subtree.Ancestors.pop_back();
+
+  CXFlatCursor Flat;
+  Flat.Cursor = C;
+  Flat.Extent = clang_getCursorExtent(C);
+  Flat.Spelling = 0;
+  Flat.Parent = Subtree.Ancestors.empty() ? -1 : Subtree.Ancestors.back();
+  appendSpelling(clang_getCursorSpelling(C), Subtree.Spellings,
+                 Subtree.SpellingOffsets);
+  Subtree.Ancestors.push_back(Subtree.Cursors.size());
+  Subtree.Cursors.push_back(Flat);
+  return CXChildVisit_Recurse;
+}
+
 extern "C" {
 
 unsigned clang_visitChildren(CXCursor parent,
                              CXCursorVisitor visitor,
                              CXClientData client_data) {
+  CXTUQueryLock Lock(getCursorTU(parent));
   CursorVisitor CursorVis(getCursorTU(parent), visitor, client_data,
                           /*VisitPreprocessorLast=*/false);
   return CursorVis.VisitChildren(parent);
@@ -3031,6 +3254,29 @@ unsigned clang_visitChildrenWithBlock(CXCursor parent,
   return clang_visitChildren(parent, visitWithBlock, block);
 }
 
+void clang_getCursorSubtree(CXCursor Root, CXFlatCursor **Cursors,
+                            unsigned *NumCursors) {
+  if (Cursors)
+    *Cursors = 0;
+  if (NumCursors)
+    *NumCursors = 0;
+  if (!Cursors || !NumCursors)
+    return;
+
+  CursorSubtreeData Subtree;
+  clang_visitChildren(Root, getCursorSubtreeVisit, &Subtree);
+  if (Subtree.Cursors.empty())
+    return;
+
+  *Cursors = copyWithSpellings(Subtree.Cursors, Subtree.SpellingOffsets,
+                               Subtree.Spellings);
+  *NumCursors = Subtree.Cursors.size();
+}
+
+void clang_disposeCursorSubtree(CXFlatCursor *Cursors, unsigned NumCursors) {
+  free(Cursors);
+}
+
 static CXString getDeclSpelling(Decl *D) {
   if (!D)
     return createCXString("");
@@ -3756,7 +4002,8 @@ CXCursor clang_getCursor(CXTranslationUnit TU, CXSourceLocation Loc) {
   if (!TU)
     return clang_getNullCursor();
 
-  ASTUnit *CXXUnit = static_cast<ASTUnit *>(TU->TUData);
+  CXTUQueryLock Lock(TU);
+  ASTUnit *CXXUnit = cxtu::getASTUnit(TU);
   ASTUnit::ConcurrencyCheck Check(*CXXUnit);
 
   SourceLocation SLoc = cxloc::translateSourceLocation(Loc);
@@ -4015,7 +4262,7 @@ CXCursor cxcursor::getCursor(CXTranslationUnit TU, SourceLocation SLoc) {
   if (SLoc.isInvalid())
     return clang_getNullCursor();
 
-  ASTUnit *CXXUnit = static_cast<ASTUnit *>(TU->TUData);
+  ASTUnit *CXXUnit = cxtu::getASTUnit(TU);
 
   // Translate the given source location to make it point at the beginning of
   // the token under the cursor.
@@ -4024,12 +4271,23 @@ CXCursor cxcursor::getCursor(CXTranslationUnit TU, SourceLocation SLoc) {
   
   CXCursor Result = MakeCXCursorInvalid(CXCursor_NoDeclFound);
   if (SLoc.isValid()) {
+    if (!TU->CursorCache)
+      TU->CursorCache = new CursorCacheTy();
+    CursorCacheTy &Cache = *static_cast<CursorCacheTy *>(TU->CursorCache);
+    CursorCacheTy::iterator Known = Cache.find(SLoc.getRawEncoding());
+    if (Known != Cache.end())
+      return Known->second;
+
     GetCursorData ResultData(CXXUnit->getSourceManager(), SLoc, Result);
     CursorVisitor CursorVis(TU, GetCursorVisitor, &ResultData,
                             /*VisitPreprocessorLast=*/true, 
                             /*VisitIncludedEntities=*/false,
                             SourceLocation(SLoc));
     CursorVis.visitFileRegion();
+
+    if (Cache.size() >= MaxCursorCacheSize)
+      Cache.clear();
+    Cache[SLoc.getRawEncoding()] = Result;
   }
 
   return Result;
@@ -4191,6 +4449,7 @@ CXCursor clang_getCursorReferenced(CXCursor C) {
     return clang_getNullCursor();
 
   CXTranslationUnit tu = getCursorTU(C);
+  CXTUQueryLock Lock(tu);
   if (clang_isDeclaration(C.kind)) {
     Decl *D = getCursorDecl(C);
     if (!D)
@@ -4280,7 +4539,7 @@ CXCursor clang_getCursorReferenced(CXCursor C) {
       // FIXME: We end up faking the "parent" declaration here because we
       // don't want to make CXCursor larger.
       return MakeCXCursor(getCursorLabelRef(C).first, 
-               static_cast<ASTUnit*>(tu->TUData)->getASTContext()
+               cxtu::getASTUnit(tu)->getASTContext()
                           .getTranslationUnitDecl(),
                           tu);
 
@@ -4301,6 +4560,7 @@ CXCursor clang_getCursorDefinition(CXCursor C) {
     return clang_getNullCursor();
 
   CXTranslationUnit TU = getCursorTU(C);
+  CXTUQueryLock Lock(TU);
 
   bool WasReference = false;
   if (clang_isReference(C.kind) || clang_isExpression(C.kind)) {
@@ -4683,7 +4943,7 @@ CXString clang_getTokenSpelling(CXTranslationUnit TU, CXToken CXTok) {
 
   // We have to find the starting buffer pointer the hard way, by
   // deconstructing the source location.
-  ASTUnit *CXXUnit = static_cast<ASTUnit *>(TU->TUData);
+  ASTUnit *CXXUnit = cxtu::getASTUnit(TU);
   if (!CXXUnit)
     return createCXString("");
 
@@ -4700,7 +4960,7 @@ CXString clang_getTokenSpelling(CXTranslationUnit TU, CXToken CXTok) {
 }
 
 CXSourceLocation clang_getTokenLocation(CXTranslationUnit TU, CXToken CXTok) {
-  ASTUnit *CXXUnit = static_cast<ASTUnit *>(TU->TUData);
+  ASTUnit *CXXUnit = cxtu::getASTUnit(TU);
   if (!CXXUnit)
     return clang_getNullLocation();
 
@@ -4709,7 +4969,7 @@ CXSourceLocation clang_getTokenLocation(CXTranslationUnit TU, CXToken CXTok) {
 }
 
 CXSourceRange clang_getTokenExtent(CXTranslationUnit TU, CXToken CXTok) {
-  ASTUnit *CXXUnit = static_cast<ASTUnit *>(TU->TUData);
+  ASTUnit *CXXUnit = cxtu::getASTUnit(TU);
   if (!CXXUnit)
     return clang_getNullRange();
 
@@ -4796,7 +5056,8 @@ void clang_tokenize(CXTranslationUnit TU, CXSourceRange Range,
   if (NumTokens)
     *NumTokens = 0;
 
-  ASTUnit *CXXUnit = static_cast<ASTUnit *>(TU->TUData);
+  CXTUQueryLock Lock(TU);
+  ASTUnit *CXXUnit = cxtu::getASTUnit(TU);
   if (!CXXUnit || !Tokens || !NumTokens)
     return;
 
@@ -4822,6 +5083,53 @@ void clang_disposeTokens(CXTranslationUnit TU,
   free(Tokens);
 }
 
+void clang_tokenizeFlat(CXTranslationUnit TU, CXSourceRange Range,
+                        CXFlatToken **Tokens, unsigned *NumTokens) {
+  if (Tokens)
+    *Tokens = 0;
+  if (NumTokens)
+    *NumTokens = 0;
+
+  CXTUQueryLock Lock(TU);
+  ASTUnit *CXXUnit = cxtu::getASTUnit(TU);
+  if (!CXXUnit || !Tokens || !NumTokens)
+    return;
+
+  ASTUnit::ConcurrencyCheck Check(*CXXUnit);
+
+  SourceRange R = cxloc::translateCXSourceRange(Range);
+  if (R.isInvalid())
+    return;
+
+  SmallVector<CXToken, 256> CXTokens;
+  getTokens(CXXUnit, R, CXTokens);
+  if (CXTokens.empty())
+    return;
+
+  SmallVector<CXFlatToken, 256> FlatTokens;
+  SmallVector<unsigned, 256> SpellingOffsets;
+  std::string Spellings;
+  FlatTokens.reserve(CXTokens.size());
+  SpellingOffsets.reserve(CXTokens.size());
+  for (unsigned I = 0, N = CXTokens.size(); I != N; ++I) {
+    CXFlatToken Flat;
+    Flat.Token = CXTokens[I];
+    Flat.Kind = clang_getTokenKind(CXTokens[I]);
+    Flat.Extent = clang_getTokenExtent(TU, CXTokens[I]);
+    Flat.Spelling = 0;
+    appendSpelling(clang_getTokenSpelling(TU, CXTokens[I]), Spellings,
+                   SpellingOffsets);
+    FlatTokens.push_back(Flat);
+  }
+
+  *Tokens = copyWithSpellings(FlatTokens, SpellingOffsets, Spellings);
+  *NumTokens = FlatTokens.size();
+}
+
+void clang_disposeFlatTokens(CXFlatToken *Tokens, unsigned NumTokens) {
+  free(Tokens);
+}
+
 } // end: extern "C"
 
 //===----------------------------------------------------------------------===//
@@ -4884,7 +5192,7 @@ public:
                   RegionOfInterest,
                   /*VisitDeclsOnly=*/false,
                   AnnotateTokensPostChildrenVisitor),
-      SrcMgr(static_cast<ASTUnit*>(tu->TUData)->getSourceManager()),
+      SrcMgr(cxtu::getASTUnit(tu)->getSourceManager()),
       HasContextSensitiveKeywords(false) { }
 
   void VisitChildren(CXCursor C) { AnnotateVis.VisitChildren(C); }
@@ -5297,7 +5605,7 @@ namespace {
 static void annotatePreprocessorTokens(CXTranslationUnit TU,
                                        SourceRange RegionOfInterest,
                                        AnnotateTokensData &Annotated) {
-  ASTUnit *CXXUnit = static_cast<ASTUnit *>(TU->TUData);
+  ASTUnit *CXXUnit = cxtu::getASTUnit(TU);
 
   SourceManager &SourceMgr = CXXUnit->getSourceManager();
   std::pair<FileID, unsigned> BeginLocInfo
@@ -5468,6 +5776,24 @@ static void clang_annotateTokensImpl(void *UserData) {
   }
 }
 
+/// \brief Annotate the given tokens of \p CXXUnit, which the caller has
+/// checked for concurrent access.
+static void annotateTokens(CXTranslationUnit TU, ASTUnit *CXXUnit,
+                           CXToken *Tokens, unsigned NumTokens,
+                           CXCursor *Cursors) {
+  // Any token we don't specifically annotate will have a NULL cursor.
+  CXCursor C = clang_getNullCursor();
+  for (unsigned I = 0; I != NumTokens; ++I)
+    Cursors[I] = C;
+
+  clang_annotateTokens_Data data = { TU, CXXUnit, Tokens, NumTokens, Cursors };
+  llvm::CrashRecoveryContext CRC;
+  if (!RunSafely(CRC, clang_annotateTokensImpl, &data,
+                 GetSafetyThreadStackSize() * 2)) {
+    fprintf(stderr, "libclang: crash detected while annotating tokens\n");
+  }
+}
+
 extern "C" {
 
 void clang_annotateTokens(CXTranslationUnit TU,
@@ -5477,23 +5803,47 @@ void clang_annotateTokens(CXTranslationUnit TU,
   if (NumTokens == 0 || !Tokens || !Cursors)
     return;
 
-  // Any token we don't specifically annotate will have a NULL cursor.
-  CXCursor C = clang_getNullCursor();
-  for (unsigned I = 0; I != NumTokens; ++I)
-    Cursors[I] = C;
+  CXTUQueryLock Lock(TU);
+  ASTUnit *CXXUnit = cxtu::getASTUnit(TU);
+  if (!CXXUnit) {
+    CXCursor C = clang_getNullCursor();
+    for (unsigned I = 0; I != NumTokens; ++I)
+      Cursors[I] = C;
+    return;
+  }
 
-  ASTUnit *CXXUnit = static_cast<ASTUnit *>(TU->TUData);
+  ASTUnit::ConcurrencyCheck Check(*CXXUnit);
+  annotateTokens(TU, CXXUnit, Tokens, NumTokens, Cursors);
+}
+
+unsigned clang_tokenizeAndAnnotate(CXTranslationUnit TU, CXSourceRange Range,
+                                   CXToken *Tokens, CXCursor *Cursors,
+                                   unsigned MaxTokens) {
+  if (!TU)
+    return 0;
+
+  ASTUnit *CXXUnit = cxtu::getASTUnit(TU);
   if (!CXXUnit)
-    return;
+    return 0;
 
   ASTUnit::ConcurrencyCheck Check(*CXXUnit);
-  
-  clang_annotateTokens_Data data = { TU, CXXUnit, Tokens, NumTokens, Cursors };
-  llvm::CrashRecoveryContext CRC;
-  if (!RunSafely(CRC, clang_annotateTokensImpl, &data,
-                 GetSafetyThreadStackSize() * 2)) {
-    fprintf(stderr, "libclang: crash detected while annotating tokens\n");
-  }
+
+  SourceRange R = cxloc::translateCXSourceRange(Range);
+  if (R.isInvalid())
+    return 0;
+
+  SmallVector<CXToken, 256> CXTokens;
+  getTokens(CXXUnit, R, CXTokens);
+
+  // If the caller's buffers are too small, just tell it how large they have
+  // to be.
+  unsigned NumTokens = CXTokens.size();
+  if (NumTokens == 0 || NumTokens > MaxTokens || !Tokens || !Cursors)
+    return NumTokens;
+
+  memcpy(Tokens, CXTokens.data(), sizeof(CXToken) * NumTokens);
+  annotateTokens(TU, CXXUnit, Tokens, NumTokens, Cursors);
+  return NumTokens;
 }
 
 } // end: extern "C"
@@ -5768,6 +6118,7 @@ CXString clang_Cursor_getRawCommentText(CXCursor C) {
   if (!clang_isDeclaration(C.kind))
     return createCXString((const char *) NULL);
 
+  CXTUQueryLock Lock(getCursorTU(C));
   const Decl *D = getCursorDecl(C);
   ASTContext &Context = getCursorContext(C);
   const RawComment *RC = Context.getRawCommentForAnyRedecl(D);
@@ -5802,6 +6153,7 @@ CXComment clang_Cursor_getParsedComment(CXCursor C) {
   if (!clang_isDeclaration(C.kind))
     return cxcomment::createCXComment(NULL, NULL);
 
+  CXTUQueryLock Lock(getCursorTU(C));
   const Decl *D = getCursorDecl(C);
   const ASTContext &Context = getCursorContext(C);
   const comments::FullComment *FC = Context.getCommentForDecl(D);
@@ -5872,6 +6224,27 @@ static inline void createCXTUResourceUsageEntry(MemUsageEntries &entries,
   entries.push_back(entry);
 }
 
+static void createSourceManagerUsageEntries(MemUsageEntries &entries,
+                                            const SourceManager &SM) {
+  // How much memory is being used by SourceManager's content cache?
+  createCXTUResourceUsageEntry(entries,
+          CXTUResourceUsage_SourceManagerContentCache,
+          (unsigned long) SM.getContentCacheSize());
+  
+  // How much memory is being used by the MemoryBuffer's in SourceManager?
+  const SourceManager::MemoryBufferSizes &srcBufs = SM.getMemoryBufferSizes();
+  
+  createCXTUResourceUsageEntry(entries,
+                               CXTUResourceUsage_SourceManager_Membuffer_Malloc,
+                               (unsigned long) srcBufs.malloc_bytes);
+  createCXTUResourceUsageEntry(entries,
+                               CXTUResourceUsage_SourceManager_Membuffer_MMap,
+                               (unsigned long) srcBufs.mmap_bytes);
+  createCXTUResourceUsageEntry(entries,
+                               CXTUResourceUsage_SourceManager_DataStructures,
+                               (unsigned long) SM.getDataStructureSizes());
+}
+
 extern "C" {
 
 const char *clang_getTUResourceUsageName(CXTUResourceUsageKind kind) {
@@ -5931,6 +6304,17 @@ CXTUResourceUsage clang_getCXTUResourceUsage(CXTranslationUnit TU) {
   
   ASTUnit *astUnit = static_cast<ASTUnit*>(TU->TUData);
   OwningPtr<MemUsageEntries> entries(new MemUsageEntries());
+
+  // Only the source manager remains of an unloaded AST.
+  if (astUnit->isASTUnloaded()) {
+    createSourceManagerUsageEntries(*entries, astUnit->getSourceManager());
+    CXTUResourceUsage usage = { (void*) entries.get(),
+                                (unsigned) entries->size(),
+                                entries->size() ? &(*entries)[0] : 0 };
+    entries.take();
+    return usage;
+  }
+
   ASTContext &astContext = astUnit->getASTContext();
   
   // How much memory is used by AST nodes and types?
@@ -5959,25 +6343,7 @@ CXTUResourceUsage clang_getCXTUResourceUsage(CXTranslationUnit TU) {
                                CXTUResourceUsage_GlobalCompletionResults,
                                completionBytes);
   
-  // How much memory is being used by SourceManager's content cache?
-  createCXTUResourceUsageEntry(*entries,
-          CXTUResourceUsage_SourceManagerContentCache,
-          (unsigned long) astContext.getSourceManager().getContentCacheSize());
-  
-  // How much memory is being used by the MemoryBuffer's in SourceManager?
-  const SourceManager::MemoryBufferSizes &srcBufs =
-    astUnit->getSourceManager().getMemoryBufferSizes();
-  
-  createCXTUResourceUsageEntry(*entries,
-                               CXTUResourceUsage_SourceManager_Membuffer_Malloc,
-                               (unsigned long) srcBufs.malloc_bytes);
-  createCXTUResourceUsageEntry(*entries,
-                               CXTUResourceUsage_SourceManager_Membuffer_MMap,
-                               (unsigned long) srcBufs.mmap_bytes);
-  createCXTUResourceUsageEntry(*entries,
-                               CXTUResourceUsage_SourceManager_DataStructures,
-                               (unsigned long) astContext.getSourceManager()
-                                .getDataStructureSizes());
+  createSourceManagerUsageEntries(*entries, astContext.getSourceManager());
   
   // How much memory is being used by the ExternalASTSource?
   if (ExternalASTSource *esrc = astContext.getExternalSource()) {
@@ -273,6 +273,10 @@ struct AllocatedCXCodeCompleteResults : public CXCodeCompleteResults {
   /// \brief Allocator used to store globally cached code-completion results.
   IntrusiveRefCntPtr<clang::GlobalCodeCompletionAllocator>
     CachedCompletionAllocator;
+
+  /// \brief The globally cached code-completion results shared between
+  /// translation units with the same preamble, which also store strings.
+  IntrusiveRefCntPtr<ASTUnit::PreambleCompletions> PreambleCompletions;
   
   /// \brief Allocator used to store code completion results.
   IntrusiveRefCntPtr<clang::GlobalCodeCompletionAllocator>
@@ -519,13 +523,33 @@ namespace {
     CodeCompletionTUInfo CCTUInfo;
     SmallVector<CXCompletionResult, 16> StoredResults;
     CXTranslationUnit *TU;
+
+    /// \brief The number of results to deliver to \c Callback at a time, or
+    /// zero to deliver all of them at once.
+    unsigned BatchSize;
+
+    CXCodeCompleteResultsCallback Callback;
+    CXClientData ClientData;
+
+    /// \brief The number of results in \c StoredResults that were passed to
+    /// \c Callback.
+    unsigned NumDelivered;
+
+    /// \brief Whether \c Callback cancelled code completion.
+    bool Cancelled;
+
   public:
     CaptureCompletionResults(const CodeCompleteOptions &Opts,
                              AllocatedCXCodeCompleteResults &Results,
-                             CXTranslationUnit *TranslationUnit)
+                             CXTranslationUnit *TranslationUnit,
+                             unsigned BatchSize = 0,
+                             CXCodeCompleteResultsCallback Callback = 0,
+                             CXClientData ClientData = 0)
       : CodeCompleteConsumer(Opts, false), 
         AllocatedResults(Results), CCTUInfo(Results.CodeCompletionAllocator),
-        TU(TranslationUnit) { }
+        TU(TranslationUnit), BatchSize(BatchSize),
+        Callback(Callback), ClientData(ClientData), NumDelivered(0),
+        Cancelled(false) { }
     ~CaptureCompletionResults() { Finish(); }
     
     virtual void ProcessCodeCompleteResults(Sema &S, 
@@ -533,17 +557,28 @@ namespace {
                                             CodeCompletionResult *Results,
                                             unsigned NumResults) {
       StoredResults.reserve(StoredResults.size() + NumResults);
-      for (unsigned I = 0; I != NumResults; ++I) {
+      for (unsigned I = 0; I != NumResults && !Cancelled; ++I) {
         CodeCompletionString *StoredCompletion        
           = Results[I].CreateCodeCompletionString(S, getAllocator(),
                                                   getCodeCompletionTUInfo(),
                                                   includeBriefComments());
+        // Sema could not filter the results whose typed text depends on the
+        // context, such as selectors.
+        if (!getFilterPrefix().empty()) {
+          const char *TypedText = StoredCompletion->getTypedText();
+          if (!TypedText || !matchesFilter(TypedText))
+            continue;
+        }
         
         CXCompletionResult R;
         R.CursorKind = Results[I].CursorKind;
         R.CompletionString = StoredCompletion;
         StoredResults.push_back(R);
+
+        if (BatchSize && StoredResults.size() - NumDelivered >= BatchSize)
+          Deliver();
       }
+      Deliver();
       
       enum CodeCompletionContext::Kind contextKind = Context.getKind();
       
@@ -621,6 +656,9 @@ namespace {
     virtual void ProcessOverloadCandidates(Sema &S, unsigned CurrentArg,
                                            OverloadCandidate *Candidates,
                                            unsigned NumCandidates) {
+      if (Cancelled)
+        return;
+
       StoredResults.reserve(StoredResults.size() + NumCandidates);
       for (unsigned I = 0; I != NumCandidates; ++I) {
         CodeCompletionString *StoredCompletion
@@ -641,7 +679,20 @@ namespace {
     virtual CodeCompletionTUInfo &getCodeCompletionTUInfo() { return CCTUInfo; }
     
   private:
+    /// \brief Pass the results that were not delivered yet to \c Callback.
+    void Deliver() {
+      if (!Callback || Cancelled || NumDelivered == StoredResults.size())
+        return;
+
+      unsigned Begin = NumDelivered;
+      NumDelivered = StoredResults.size();
+      if (Callback(StoredResults.data() + Begin, NumDelivered - Begin,
+                   ClientData))
+        Cancelled = true;
+    }
+
     void Finish() {
+      Deliver();
       AllocatedResults.Results = new CXCompletionResult [StoredResults.size()];
       AllocatedResults.NumResults = StoredResults.size();
       std::memcpy(AllocatedResults.Results, StoredResults.data(), 
@@ -660,6 +711,10 @@ struct CodeCompleteAtInfo {
   struct CXUnsavedFile *unsaved_files;
   unsigned num_unsaved_files;
   unsigned options;
+  const char *prefix;
+  unsigned batch_size;
+  CXCodeCompleteResultsCallback callback;
+  CXClientData client_data;
   CXCodeCompleteResults *result;
 };
 void clang_codeCompleteAt_Impl(void *UserData) {
@@ -682,7 +737,7 @@ void clang_codeCompleteAt_Impl(void *UserData) {
 
   bool EnableLogging = getenv("LIBCLANG_CODE_COMPLETION_LOGGING") != 0;
   
-  ASTUnit *AST = static_cast<ASTUnit *>(TU->TUData);
+  ASTUnit *AST = cxtu::getASTUnit(TU);
   if (!AST)
     return;
 
@@ -715,7 +770,11 @@ void clang_codeCompleteAt_Impl(void *UserData) {
   // Create a code-completion consumer to capture the results.
   CodeCompleteOptions Opts;
   Opts.IncludeBriefComments = IncludeBriefComments;
-  CaptureCompletionResults Capture(Opts, *Results, &TU);
+  if (CCAI->prefix)
+    Opts.FilterPrefix = CCAI->prefix;
+  Opts.FuzzyFilter = (options & CXCodeComplete_FuzzyPrefix) != 0;
+  CaptureCompletionResults Capture(Opts, *Results, &TU, CCAI->batch_size,
+                                   CCAI->callback, CCAI->client_data);
 
   // Perform completion.
   AST->CodeComplete(complete_filename, complete_line, complete_column,
@@ -733,6 +792,7 @@ void clang_codeCompleteAt_Impl(void *UserData) {
   // doesn't get freed due to subsequent reparses (while the code completion
   // results are still active).
   Results->CachedCompletionAllocator = AST->getCachedCompletionAllocator();
+  Results->PreambleCompletions = AST->getPreambleCompletions();
 
   
 
@@ -817,9 +877,30 @@ CXCodeCompleteResults *clang_codeCompleteAt(CXTranslationUnit TU,
                                             struct CXUnsavedFile *unsaved_files,
                                             unsigned num_unsaved_files,
                                             unsigned options) {
+  return clang_codeCompleteAtWithCallback(TU, complete_filename, complete_line,
+                                          complete_column, unsaved_files,
+                                          num_unsaved_files, options,
+                                          /*prefix=*/0, /*batch_size=*/0,
+                                          /*callback=*/0, /*client_data=*/0);
+}
+
+CXCodeCompleteResults *
+clang_codeCompleteAtWithCallback(CXTranslationUnit TU,
+                                 const char *complete_filename,
+                                 unsigned complete_line,
+                                 unsigned complete_column,
+                                 struct CXUnsavedFile *unsaved_files,
+                                 unsigned num_unsaved_files,
+                                 unsigned options,
+                                 const char *prefix,
+                                 unsigned batch_size,
+                                 CXCodeCompleteResultsCallback callback,
+                                 CXClientData client_data) {
   CodeCompleteAtInfo CCAI = { TU, complete_filename, complete_line,
                               complete_column, unsaved_files, num_unsaved_files,
-                              options, 0 };
+                              options, prefix, batch_size, callback,
+                              client_data, 0 };
+  cxtu::CXTUQueryLock Lock(TU);
   llvm::CrashRecoveryContext CRC;
 
   if (!RunSafely(CRC, clang_codeCompleteAt_Impl, &CCAI)) {
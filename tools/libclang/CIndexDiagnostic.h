@@ -32,11 +32,11 @@ public:
 
   virtual ~CXDiagnosticSetImpl();
   
-  size_t getNumDiagnostics() const {
+  virtual size_t getNumDiagnostics() const {
     return Diagnostics.size();
   }
   
-  CXDiagnosticImpl *getDiagnostic(unsigned i) const {
+  virtual CXDiagnosticImpl *getDiagnostic(unsigned i) const {
     assert(i < getNumDiagnostics());
     return Diagnostics[i];
   }
@@ -46,7 +46,7 @@ public:
   }
   
   bool empty() const {
-    return Diagnostics.empty();
+    return getNumDiagnostics() == 0;
   }
   
   bool isExternallyManaged() const { return IsExternallyManaged; }
@@ -14,6 +14,9 @@
 
 #include "clang/Frontend/ASTUnit.h"
 #include "clang/AST/DeclObjC.h"
+#include "llvm/ADT/DenseMap.h"
+#include <algorithm>
+#include <vector>
 
 using namespace clang;
 using namespace cxcursor;
@@ -60,7 +63,7 @@ struct FindFileIdRefVisitData {
   }
 
   ASTContext &getASTContext() const {
-    return static_cast<ASTUnit *>(TU->TUData)->getASTContext();
+    return cxtu::getASTUnit(TU)->getASTContext();
   }
 
   /// \brief We are looking to find all semantically relevant identifiers,
@@ -74,7 +77,7 @@ struct FindFileIdRefVisitData {
   ///
   /// we consider the canonical decl of the constructor decl to be the class
   /// itself, so both 'C' can be highlighted.
-  Decl *getCanonical(Decl *D) const {
+  static Decl *getCanonical(Decl *D) {
     if (!D)
       return 0;
 
@@ -141,6 +144,61 @@ static SourceLocation getFileSpellingLoc(SourceManager &SM,
   return SpellLoc;
 }
 
+/// \brief Report \arg cursor, which references a declaration \arg data is
+/// looking for, if it names it in the file searched.
+static void reportFileIdRef(FindFileIdRefVisitData *data, CXCursor cursor) {
+  cursor = cxcursor::getSelectorIdentifierCursor(data->SelectorIdIdx, cursor);
+
+  // We are looking for identifiers to highlight so for objc methods (and
+  // not a parameter) we can only highlight the selector identifiers.
+  if ((cursor.kind == CXCursor_ObjCClassMethodDecl ||
+       cursor.kind == CXCursor_ObjCInstanceMethodDecl) &&
+       cxcursor::getSelectorIdentifierIndex(cursor) == -1)
+    return;
+
+  if (clang_isExpression(cursor.kind)) {
+    if (cursor.kind == CXCursor_DeclRefExpr ||
+        cursor.kind == CXCursor_MemberRefExpr) {
+      // continue..
+
+    } else if (cursor.kind == CXCursor_ObjCMessageExpr &&
+               cxcursor::getSelectorIdentifierIndex(cursor) != -1) {
+      // continue..
+
+    } else
+      return;
+  }
+
+  SourceLocation
+    Loc = cxloc::translateSourceLocation(clang_getCursorLocation(cursor));
+  SourceLocation SelIdLoc = cxcursor::getSelectorIdentifierLoc(cursor);
+  if (SelIdLoc.isValid())
+    Loc = SelIdLoc;
+
+  ASTContext &Ctx = data->getASTContext();
+  SourceManager &SM = Ctx.getSourceManager();
+  bool isInMacroDef = false;
+  if (Loc.isMacroID()) {
+    bool isMacroArg;
+    Loc = getFileSpellingLoc(SM, Loc, isMacroArg);
+    isInMacroDef = !isMacroArg;
+  }
+
+  // We are looking for identifiers in a specific file.
+  std::pair<FileID, unsigned> LocInfo = SM.getDecomposedLoc(Loc);
+  if (LocInfo.first != data->FID)
+    return;
+
+  if (isInMacroDef) {
+    // FIXME: For a macro definition make sure that all expansions
+    // of it expand to the same reference before allowing to point to it.
+    return;
+  }
+
+  data->visitor.visit(data->visitor.context, cursor,
+                      cxloc::translateSourceRange(Ctx, Loc));
+}
+
 static enum CXChildVisitResult findFileIdRefVisit(CXCursor cursor,
                                                   CXCursor parent,
                                                   CXClientData client_data) {
@@ -153,66 +211,95 @@ static enum CXChildVisitResult findFileIdRefVisit(CXCursor cursor,
     return CXChildVisit_Continue;
 
   FindFileIdRefVisitData *data = (FindFileIdRefVisitData *)client_data;
-  if (data->isHit(D)) {
-    cursor = cxcursor::getSelectorIdentifierCursor(data->SelectorIdIdx, cursor);
-
-    // We are looking for identifiers to highlight so for objc methods (and
-    // not a parameter) we can only highlight the selector identifiers.
-    if ((cursor.kind == CXCursor_ObjCClassMethodDecl ||
-         cursor.kind == CXCursor_ObjCInstanceMethodDecl) &&
-         cxcursor::getSelectorIdentifierIndex(cursor) == -1)
-      return CXChildVisit_Recurse;
-
-    if (clang_isExpression(cursor.kind)) {
-      if (cursor.kind == CXCursor_DeclRefExpr ||
-          cursor.kind == CXCursor_MemberRefExpr) {
-        // continue..
-
-      } else if (cursor.kind == CXCursor_ObjCMessageExpr &&
-                 cxcursor::getSelectorIdentifierIndex(cursor) != -1) {
-        // continue..
-                
-      } else
-        return CXChildVisit_Recurse;
-    }
+  if (data->isHit(D))
+    reportFileIdRef(data, cursor);
+  return CXChildVisit_Recurse;
+}
 
-    SourceLocation
-      Loc = cxloc::translateSourceLocation(clang_getCursorLocation(cursor));
-    SourceLocation SelIdLoc = cxcursor::getSelectorIdentifierLoc(cursor);
-    if (SelIdLoc.isValid())
-      Loc = SelIdLoc;
-
-    ASTContext &Ctx = data->getASTContext();
-    SourceManager &SM = Ctx.getSourceManager();
-    bool isInMacroDef = false;
-    if (Loc.isMacroID()) {
-      bool isMacroArg;
-      Loc = getFileSpellingLoc(SM, Loc, isMacroArg);
-      isInMacroDef = !isMacroArg;
-    }
+namespace {
 
-    // We are looking for identifiers in a specific file.
-    std::pair<FileID, unsigned> LocInfo = SM.getDecomposedLoc(Loc);
-    if (LocInfo.first != data->FID)
-      return CXChildVisit_Recurse;
+/// \brief The cursors of a file which reference declarations, in the order
+/// in which a walk of the file visits them, by the declaration referenced.
+///
+/// Built once per file and AST, so that highlighting the references to a
+/// declaration does not walk the whole file again for every query.
+struct FileIdRefIndex {
+  struct Ref {
+    /// \brief The referenced declaration, made canonical as by
+    /// FindFileIdRefVisitData::getCanonical().
+    Decl *D;
+    CXCursor Cursor;
+  };
+
+  std::vector<Ref> Refs;
+
+  /// \brief The positions in \c Refs of the references to each declaration.
+  llvm::DenseMap<Decl *, SmallVector<unsigned, 4> > RefsByDecl;
+};
 
-    if (isInMacroDef) {
-      // FIXME: For a macro definition make sure that all expansions
-      // of it expand to the same reference before allowing to point to it.
-      return CXChildVisit_Recurse;
-    }
+typedef llvm::DenseMap<const FileEntry *, FileIdRefIndex *> FileIdRefIndexMap;
 
-    data->visitor.visit(data->visitor.context, cursor,
-                        cxloc::translateSourceRange(Ctx, Loc));
-  }
+} // end anonymous namespace.
+
+static enum CXChildVisitResult indexFileIdRefVisit(CXCursor cursor,
+                                                   CXCursor parent,
+                                                   CXClientData client_data) {
+  CXCursor declCursor = clang_getCursorReferenced(cursor);
+  if (!clang_isDeclaration(declCursor.kind))
+    return CXChildVisit_Recurse;
+
+  Decl *D = cxcursor::getCursorDecl(declCursor);
+  if (!D)
+    return CXChildVisit_Continue;
+
+  FileIdRefIndex *Index = (FileIdRefIndex *)client_data;
+  FileIdRefIndex::Ref R = { FindFileIdRefVisitData::getCanonical(D), cursor };
+  Index->RefsByDecl[R.D].push_back(Index->Refs.size());
+  Index->Refs.push_back(R);
   return CXChildVisit_Recurse;
 }
 
+/// \brief Return the index of the references in \arg File of \arg TU,
+/// building it the first time it is needed.
+static FileIdRefIndex &getFileIdRefIndex(CXTranslationUnit TU,
+                                         const FileEntry *File, FileID FID) {
+  if (!TU->FileRefIndex)
+    TU->FileRefIndex = new FileIdRefIndexMap();
+  FileIdRefIndexMap &Indices =
+    *static_cast<FileIdRefIndexMap *>(TU->FileRefIndex);
+  FileIdRefIndex *&Index = Indices[File];
+  if (Index)
+    return *Index;
+
+  Index = new FileIdRefIndex();
+  SourceManager &SM = cxtu::getASTUnit(TU)->getSourceManager();
+  SourceRange Range(SM.getLocForStartOfFile(FID), SM.getLocForEndOfFile(FID));
+  CursorVisitor IndexVisitor(TU,
+                             indexFileIdRefVisit, Index,
+                             /*VisitPreprocessorLast=*/true,
+                             /*VisitIncludedEntities=*/false,
+                             Range,
+                             /*VisitDeclsOnly=*/true);
+  IndexVisitor.visitFileRegion();
+  return *Index;
+}
+
+void cxcursor::disposeFileRefIndex(CXTranslationUnit TU) {
+  if (FileIdRefIndexMap *Indices =
+        static_cast<FileIdRefIndexMap *>(TU->FileRefIndex)) {
+    for (FileIdRefIndexMap::iterator I = Indices->begin(), E = Indices->end();
+         I != E; ++I)
+      delete I->second;
+    delete Indices;
+  }
+  TU->FileRefIndex = 0;
+}
+
 static void findIdRefsInFile(CXTranslationUnit TU, CXCursor declCursor,
                            const FileEntry *File,
                            CXCursorAndRangeVisitor Visitor) {
   assert(clang_isDeclaration(declCursor.kind));
-  ASTUnit *Unit = static_cast<ASTUnit*>(TU->TUData);
+  ASTUnit *Unit = cxtu::getASTUnit(TU);
   SourceManager &SM = Unit->getSourceManager();
 
   FileID FID = SM.translateFile(File);
@@ -230,14 +317,25 @@ static void findIdRefsInFile(CXTranslationUnit TU, CXCursor declCursor,
     return;
   }
 
-  SourceRange Range(SM.getLocForStartOfFile(FID), SM.getLocForEndOfFile(FID));
-  CursorVisitor FindIdRefsVisitor(TU,
-                                  findFileIdRefVisit, &data,
-                                  /*VisitPreprocessorLast=*/true,
-                                  /*VisitIncludedEntities=*/false,
-                                  Range,
-                                  /*VisitDeclsOnly=*/true);
-  FindIdRefsVisitor.visitFileRegion();
+  FileIdRefIndex &Index = getFileIdRefIndex(TU, File, FID);
+  SmallVector<unsigned, 16> Hits;
+  if (data.TopMethods.empty()) {
+    // Only a method can be referenced through the methods it overrides.
+    llvm::DenseMap<Decl *, SmallVector<unsigned, 4> >::iterator
+      Known = Index.RefsByDecl.find(data.Dcl);
+    if (Known != Index.RefsByDecl.end())
+      Hits.append(Known->second.begin(), Known->second.end());
+  } else {
+    for (llvm::DenseMap<Decl *, SmallVector<unsigned, 4> >::iterator
+           I = Index.RefsByDecl.begin(), E = Index.RefsByDecl.end();
+         I != E; ++I)
+      if (data.isHit(I->first))
+        Hits.append(I->second.begin(), I->second.end());
+    std::sort(Hits.begin(), Hits.end());
+  }
+
+  for (unsigned I = 0, N = Hits.size(); I != N; ++I)
+    reportFileIdRef(&data, Index.Refs[Hits[I]].Cursor);
 }
 
 namespace {
@@ -310,7 +408,7 @@ static void findMacroRefsInFile(CXTranslationUnit TU, CXCursor Cursor,
       Cursor.kind != CXCursor_MacroExpansion)
     return;
 
-  ASTUnit *Unit = static_cast<ASTUnit*>(TU->TUData);
+  ASTUnit *Unit = cxtu::getASTUnit(TU);
   SourceManager &SM = Unit->getSourceManager();
 
   FileID FID = SM.translateFile(File);
@@ -370,6 +468,7 @@ void clang_findReferencesInFile(CXCursor cursor, CXFile file,
     return;
 
   ASTUnit::ConcurrencyCheck Check(*CXXUnit);
+  cxtu::CXTUQueryLock Lock(cxcursor::getCursorTU(cursor));
 
   if (cursor.kind == CXCursor_MacroDefinition ||
       cursor.kind == CXCursor_MacroExpansion) {
@@ -14,12 +14,16 @@
 #include "CIndexer.h"
 #include "CXCursor.h"
 #include "CXString.h"
+#include "CXTranslationUnit.h"
 #include "clang/AST/DeclTemplate.h"
 #include "clang/AST/DeclVisitor.h"
 #include "clang/Frontend/ASTUnit.h"
 #include "clang/Lex/PreprocessingRecord.h"
+#include "llvm/ADT/DenseMap.h"
 #include "llvm/ADT/SmallString.h"
+#include "llvm/Support/Allocator.h"
 #include "llvm/Support/raw_ostream.h"
+#include <algorithm>
 
 using namespace clang;
 using namespace clang::cxstring;
@@ -29,6 +33,44 @@ using namespace clang::cxstring;
 //===----------------------------------------------------------------------===//
 
 namespace {
+/// \brief The USRs generated for the declarations of a translation unit, kept
+/// until its AST goes away.
+///
+/// The USR of a declaration starts with the USR of its context, so besides
+/// answering repeated requests for the same declaration, the cached USR of a
+/// context is reused for the declarations within it.
+class USRCache {
+public:
+  struct Entry {
+    /// \brief The USR, without the "c:" prefix.
+    StringRef USR;
+    bool IgnoreResults;
+    bool GeneratedLoc;
+    /// \brief Whether generating the USR recorded type substitutions, to
+    /// which the rest of the USR of a nested declaration may refer.
+    bool UsedSubstitutions;
+  };
+
+private:
+  llvm::DenseMap<const Decl *, Entry> Entries;
+  llvm::BumpPtrAllocator Alloc;
+
+public:
+  const Entry *lookup(const Decl *D) const {
+    llvm::DenseMap<const Decl *, Entry>::const_iterator I = Entries.find(D);
+    return I == Entries.end() ? 0 : &I->second;
+  }
+
+  void insert(const Decl *D, StringRef USR, bool IgnoreResults,
+              bool GeneratedLoc, bool UsedSubstitutions) {
+    char *Data = static_cast<char *>(Alloc.Allocate(USR.size(), 1));
+    std::copy(USR.begin(), USR.end(), Data);
+    Entry E = { StringRef(Data, USR.size()), IgnoreResults, GeneratedLoc,
+                UsedSubstitutions };
+    Entries[D] = E;
+  }
+};
+
 class USRGenerator : public DeclVisitor<USRGenerator> {
   OwningPtr<SmallString<128> > OwnedBuf;
   SmallVectorImpl<char> &Buf;
@@ -36,17 +78,20 @@ class USRGenerator : public DeclVisitor<USRGenerator> {
   bool IgnoreResults;
   ASTContext *Context;
   bool generatedLoc;
+  USRCache *Cache;
   
   llvm::DenseMap<const Type *, unsigned> TypeSubstitutions;
   
 public:
-  explicit USRGenerator(ASTContext *Ctx = 0, SmallVectorImpl<char> *extBuf = 0)
+  explicit USRGenerator(ASTContext *Ctx = 0, SmallVectorImpl<char> *extBuf = 0,
+                        USRCache *Cache = 0)
   : OwnedBuf(extBuf ? 0 : new SmallString<128>()),
     Buf(extBuf ? *extBuf : *OwnedBuf.get()),
     Out(Buf),
     IgnoreResults(false),
     Context(Ctx),
-    generatedLoc(false)
+    generatedLoc(false),
+    Cache(Cache)
   {
     // Add the USR space prefix.
     Out << "c:";
@@ -66,6 +111,13 @@ public:
 
   bool ignoreResults() const { return IgnoreResults; }
 
+  /// \brief Generate the USR of \p D, or reuse the cached one, if it does not
+  /// depend on what was generated before.
+  ///
+  /// \param IsPrefix Whether more of the USR is generated after that of
+  /// \p D, which may then refer to its type substitutions.
+  void VisitCached(Decl *D, bool IsPrefix);
+
   // Visitation methods from generating USRs from AST elements.
   void VisitDeclContext(DeclContext *D);
   void VisitFieldDecl(FieldDecl *D);
@@ -161,9 +213,32 @@ static inline bool ShouldGenerateLocation(const NamedDecl *D) {
   return D->getLinkage() != ExternalLinkage && !InAnonymousNamespace(D);
 }
 
+void USRGenerator::VisitCached(Decl *D, bool IsPrefix) {
+  if (!Cache || generatedLoc || IgnoreResults || !TypeSubstitutions.empty()) {
+    Visit(D);
+    return;
+  }
+
+  const USRCache::Entry *E = Cache->lookup(D);
+  if (E && (!IsPrefix || !E->UsedSubstitutions)) {
+    Out << E->USR;
+    IgnoreResults = E->IgnoreResults;
+    generatedLoc = E->GeneratedLoc;
+    return;
+  }
+
+  Out.flush();
+  const unsigned Start = Buf.size();
+  Visit(D);
+  Out.flush();
+  if (!E)
+    Cache->insert(D, StringRef(Buf.data() + Start, Buf.size() - Start),
+                  IgnoreResults, generatedLoc, !TypeSubstitutions.empty());
+}
+
 void USRGenerator::VisitDeclContext(DeclContext *DC) {
   if (NamedDecl *D = dyn_cast<NamedDecl>(DC))
-    Visit(D);
+    VisitCached(D, /*IsPrefix=*/true);
 }
 
 void USRGenerator::VisitFieldDecl(FieldDecl *D) {
@@ -798,7 +873,13 @@ static inline StringRef extractUSRSuffix(StringRef s) {
   return s.startswith("c:") ? s.substr(2) : "";
 }
 
-bool cxcursor::getDeclCursorUSR(const Decl *D, SmallVectorImpl<char> &Buf) {
+void cxcursor::disposeUSRCache(CXTranslationUnit TU) {
+  delete static_cast<USRCache *>(TU->USRCache);
+  TU->USRCache = 0;
+}
+
+bool cxcursor::getDeclCursorUSR(const Decl *D, SmallVectorImpl<char> &Buf,
+                                CXTranslationUnit TU) {
   // Don't generate USRs for things with invalid locations.
   if (!D || D->getLocStart().isInvalid())
     return true;
@@ -826,9 +907,16 @@ bool cxcursor::getDeclCursorUSR(const Decl *D, SmallVectorImpl<char> &Buf) {
           break;
     }
 
+  USRCache *Cache = 0;
+  if (TU) {
+    if (!TU->USRCache)
+      TU->USRCache = new USRCache();
+    Cache = static_cast<USRCache *>(TU->USRCache);
+  }
+
   {
-    USRGenerator UG(&D->getASTContext(), &Buf);
-    UG->Visit(const_cast<Decl*>(D));
+    USRGenerator UG(&D->getASTContext(), &Buf, Cache);
+    UG->VisitCached(const_cast<Decl*>(D), /*IsPrefix=*/false);
 
     if (UG->ignoreResults())
       return true;
@@ -841,6 +929,7 @@ extern "C" {
 
 CXString clang_getCursorUSR(CXCursor C) {
   const CXCursorKind &K = clang_getCursorKind(C);
+  cxtu::CXTUQueryLock Lock(cxcursor::getCursorTU(C));
 
   if (clang_isDeclaration(K)) {
     Decl *D = cxcursor::getCursorDecl(C);
@@ -855,7 +944,7 @@ CXString clang_getCursorUSR(CXCursor C) {
     if (!buf)
       return createCXString("");
 
-    bool Ignore = cxcursor::getDeclCursorUSR(D, buf->Data);
+    bool Ignore = cxcursor::getDeclCursorUSR(D, buf->Data, TU);
     if (Ignore) {
       disposeCXStringBuf(buf);
       return createCXString("");
@@ -27,6 +27,7 @@
 #include "llvm/Support/raw_ostream.h"
 #include "llvm/Support/Program.h"
 
+#include <algorithm>
 #include <cstdio>
 #include <vector>
 #include <sstream>
@@ -90,6 +91,13 @@ std::string CIndexer::getClangResourcesPath() {
   return LibClangPath.str();
 }
 
+void CIndexer::removeTranslationUnit(CXTranslationUnit TU) {
+  std::vector<CXTranslationUnit>::iterator I
+    = std::find(TranslationUnits.begin(), TranslationUnits.end(), TU);
+  if (I != TranslationUnits.end())
+    TranslationUnits.erase(I);
+}
+
 static llvm::sys::Path GetTemporaryPath() {
   // FIXME: This is lame; sys::Path should provide this function (in particular,
   // it should know how to find the temporary files dir).
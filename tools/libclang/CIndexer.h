@@ -35,9 +35,19 @@ class CIndexer {
   llvm::sys::Path ResourcesPath;
   std::string WorkingDir;
 
+  /// \brief The memory the translation units may use before the least
+  /// recently used ones are unloaded, or 0 for no limit.
+  unsigned long long MemoryBudget;
+
+  /// \brief Counts the uses of the translation units, to order them.
+  unsigned long long UseCount;
+
+  /// \brief The translation units created from this index.
+  std::vector<CXTranslationUnit> TranslationUnits;
+
 public:
  CIndexer() : OnlyLocalDecls(false), DisplayDiagnostics(false),
-              Options(CXGlobalOpt_None) { }
+              Options(CXGlobalOpt_None), MemoryBudget(0), UseCount(0) { }
   
   /// \brief Whether we only want to see "local" declarations (that did not
   /// come from a previous precompiled header). If false, we want to see all
@@ -62,6 +72,19 @@ public:
 
   const std::string &getWorkingDirectory() const { return WorkingDir; }
   void setWorkingDirectory(const std::string &Dir) { WorkingDir = Dir; }
+
+  unsigned long long getMemoryBudget() const { return MemoryBudget; }
+  void setMemoryBudget(unsigned long long Bytes) { MemoryBudget = Bytes; }
+
+  unsigned long long nextUse() { return ++UseCount; }
+
+  const std::vector<CXTranslationUnit> &getTranslationUnits() const {
+    return TranslationUnits;
+  }
+  void addTranslationUnit(CXTranslationUnit TU) {
+    TranslationUnits.push_back(TU);
+  }
+  void removeTranslationUnit(CXTranslationUnit TU);
 };
 
   /**
@@ -1226,7 +1226,7 @@ CXString clang_FullComment_getAsXML(CXComment CXC) {
     return createCXString((const char *) 0);
 
   CXTranslationUnit TU = CXC.TranslationUnit;
-  SourceManager &SM = static_cast<ASTUnit *>(TU->TUData)->getSourceManager();
+  SourceManager &SM = cxtu::getASTUnit(TU)->getSourceManager();
 
   SmallString<1024> XML;
   CommentASTToXMLConverter Converter(XML, getCommandTraits(CXC), SM);
@@ -787,7 +787,7 @@ ASTUnit *cxcursor::getCursorASTUnit(CXCursor Cursor) {
   CXTranslationUnit TU = static_cast<CXTranslationUnit>(Cursor.data[2]);
   if (!TU)
     return 0;
-  return static_cast<ASTUnit *>(TU->TUData);
+  return cxtu::getASTUnit(TU);
 }
 
 CXTranslationUnit cxcursor::getCursorTU(CXCursor Cursor) {
@@ -916,7 +916,7 @@ static void collectOnCategoriesAfterLocation(SourceLocation Loc,
   if (!Class)
     return;
 
-  SourceManager &SM = static_cast<ASTUnit *>(TU->TUData)->getSourceManager();
+  SourceManager &SM = cxtu::getASTUnit(TU)->getSourceManager();
   for (ObjCCategoryDecl *Category = Class->getCategoryList();
        Category; Category = Category->getNextClassCategory())
     if (SM.isBeforeInTranslationUnit(Loc, Category->getLocation()))
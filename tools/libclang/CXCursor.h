@@ -237,9 +237,21 @@ static inline CXCursor getTypeRefedCallExprCursor(CXCursor cursor) {
 CXCursor getTypeRefCursor(CXCursor cursor);
 
 /// \brief Generate a USR for \arg D and put it in \arg Buf.
+///
+/// If \arg TU is given, the USRs generated for its declarations are cached
+/// until disposeUSRCache() is called.
+///
 /// \returns true if no USR was computed or the result should be ignored,
 /// false otherwise.
-bool getDeclCursorUSR(const Decl *D, SmallVectorImpl<char> &Buf);
+bool getDeclCursorUSR(const Decl *D, SmallVectorImpl<char> &Buf,
+                      CXTranslationUnit TU = 0);
+
+/// \brief Drop the USRs cached for \arg TU, when its AST goes away.
+void disposeUSRCache(CXTranslationUnit TU);
+
+/// \brief Drop the references clang_findReferencesInFile() indexed for
+/// \arg TU, when its AST goes away.
+void disposeFileRefIndex(CXTranslationUnit TU);
 
 bool operator==(CXCursor X, CXCursor Y);
   
@@ -35,12 +35,24 @@ using namespace clang::cxstring;
 typedef llvm::DenseMap<unsigned, llvm::StringRef> Strings;
 
 namespace {
+/// \brief The diagnostics of a serialized diagnostics file.
+///
+/// The file stays mapped while the set is alive. Loading it only checks it
+/// and reads the strings it defines; a top-level diagnostic, along with its
+/// notes, is only read when a client asks for it, so that files with a huge
+/// number of diagnostics can be enumerated cheaply.
 class CXLoadedDiagnosticSetImpl : public CXDiagnosticSetImpl {
 public:
   CXLoadedDiagnosticSetImpl() : CXDiagnosticSetImpl(true), FakeFiles(FO) {}
-  virtual ~CXLoadedDiagnosticSetImpl() {}  
+  virtual ~CXLoadedDiagnosticSetImpl();
 
   llvm::StringRef makeString(const char *blob, unsigned blobLen);
+
+  virtual size_t getNumDiagnostics() const {
+    return DiagOffsets.size();
+  }
+
+  virtual CXDiagnosticImpl *getDiagnostic(unsigned i) const;
   
   llvm::BumpPtrAllocator Alloc;
   Strings Categories;
@@ -50,9 +62,25 @@ public:
   FileSystemOptions FO;
   FileManager FakeFiles;
   llvm::DenseMap<unsigned, const FileEntry *> Files;
+
+  OwningPtr<llvm::MemoryBuffer> Buffer;
+  llvm::BitstreamReader StreamFile;
+
+  /// \brief The bit offset of each top-level DIAG block, just past its
+  /// block ID.
+  std::vector<uint64_t> DiagOffsets;
+
+  /// \brief The top-level diagnostics read so far, indexed like
+  /// \c DiagOffsets.
+  mutable std::vector<CXLoadedDiagnostic *> LoadedDiags;
 };
 }
 
+CXLoadedDiagnosticSetImpl::~CXLoadedDiagnosticSetImpl() {
+  for (unsigned I = 0, N = LoadedDiags.size(); I != N; ++I)
+    delete LoadedDiags[I];
+}
+
 llvm::StringRef CXLoadedDiagnosticSetImpl::makeString(const char *blob,
                                                       unsigned bloblen) {
   char *mem = Alloc.Allocate<char>(bloblen + 1);
@@ -76,11 +104,13 @@ CXLoadedDiagnostic::~CXLoadedDiagnostic() {}
 CXDiagnosticSeverity CXLoadedDiagnostic::getSeverity() const {
   // FIXME: possibly refactor with logic in CXStoredDiagnostic.
   switch (severity) {
-    case DiagnosticsEngine::Ignored: return CXDiagnostic_Ignored;
-    case DiagnosticsEngine::Note:    return CXDiagnostic_Note;
-    case DiagnosticsEngine::Warning: return CXDiagnostic_Warning;
-    case DiagnosticsEngine::Error:   return CXDiagnostic_Error;
-    case DiagnosticsEngine::Fatal:   return CXDiagnostic_Fatal;
+    case serialized_diags::Ignored: return CXDiagnostic_Ignored;
+    case serialized_diags::Note:    return CXDiagnostic_Note;
+    // FIXME: Add a severity for remarks to libclang.
+    case serialized_diags::Remark:  return CXDiagnostic_Note;
+    case serialized_diags::Warning: return CXDiagnostic_Warning;
+    case serialized_diags::Error:   return CXDiagnostic_Error;
+    case serialized_diags::Fatal:   return CXDiagnostic_Fatal;
   }
   
   llvm_unreachable("Invalid diagnostic level");
@@ -209,16 +239,11 @@ class DiagLoader {
 
   LoadResult readMetaBlock(llvm::BitstreamCursor &Stream);
   
-  LoadResult readDiagnosticBlock(llvm::BitstreamCursor &Stream,
-                                 CXDiagnosticSetImpl &Diags,
-                                 CXLoadedDiagnosticSetImpl &TopDiags);
-
   StreamResult readToNextRecordOrBlock(llvm::BitstreamCursor &Stream,
                                        llvm::StringRef errorContext,
                                        unsigned &BlockOrRecordID,
                                        const bool atTopLevel = false);
-  
-  
+
   LoadResult readString(CXLoadedDiagnosticSetImpl &TopDiags,
                         Strings &strings, llvm::StringRef errorContext,
                         RecordData &Record,
@@ -236,7 +261,7 @@ class DiagLoader {
 
   LoadResult readRange(CXLoadedDiagnosticSetImpl &TopDiags,
                        RecordData &Record, unsigned RecStartIdx,
-                       CXSourceRange &SR);
+                       CXSourceRange *SR);
   
   LoadResult readLocation(CXLoadedDiagnosticSetImpl &TopDiags,
                           RecordData &Record, unsigned &offset,
@@ -252,29 +277,58 @@ public:
     }
 
   CXDiagnosticSet load(const char *file);
+
+  /// \brief Read the DIAG block the cursor is in into \p D, or, if \p D is
+  /// null, only check it and read the strings it defines.
+  LoadResult readDiagnosticBlock(llvm::BitstreamCursor &Stream,
+                                 CXLoadedDiagnostic *D,
+                                 CXLoadedDiagnosticSetImpl &TopDiags);
 };
 }
 
+CXDiagnosticImpl *CXLoadedDiagnosticSetImpl::getDiagnostic(unsigned i) const {
+  assert(i < getNumDiagnostics());
+  if (LoadedDiags.empty())
+    LoadedDiags.resize(DiagOffsets.size());
+  if (LoadedDiags[i])
+    return LoadedDiags[i];
+
+  // Reading the diagnostic only adds strings and locations to the set, which
+  // the clients do not see.
+  CXLoadedDiagnosticSetImpl &Self =
+    const_cast<CXLoadedDiagnosticSetImpl &>(*this);
+  llvm::BitstreamCursor Stream(Self.StreamFile);
+  Stream.JumpToBit(DiagOffsets[i]);
+  OwningPtr<CXLoadedDiagnostic> D(new CXLoadedDiagnostic());
+  DiagLoader Loader(0, 0);
+  // The block was checked when the file was loaded.
+  if (Loader.readDiagnosticBlock(Stream, D.get(), Self))
+    llvm_unreachable("Diagnostics file changed after it was checked");
+  LoadedDiags[i] = D.take();
+  return LoadedDiags[i];
+}
+
 CXDiagnosticSet DiagLoader::load(const char *file) {
   // Open the diagnostics file.
   std::string ErrStr;
   FileSystemOptions FO;
   FileManager FileMgr(FO);
 
-  OwningPtr<llvm::MemoryBuffer> Buffer;
-  Buffer.reset(FileMgr.getBufferForFile(file));
+  OwningPtr<CXLoadedDiagnosticSetImpl>
+    Diags(new CXLoadedDiagnosticSetImpl());
+  Diags->Buffer.reset(FileMgr.getBufferForFile(file));
 
-  if (!Buffer) {
+  if (!Diags->Buffer) {
     reportBad(CXLoadDiag_CannotLoad, ErrStr);
     return 0;
   }
 
-  llvm::BitstreamReader StreamFile;
-  StreamFile.init((const unsigned char *)Buffer->getBufferStart(),
-                  (const unsigned char *)Buffer->getBufferEnd());
+  llvm::MemoryBuffer &Buffer = *Diags->Buffer;
+  Diags->StreamFile.init((const unsigned char *)Buffer.getBufferStart(),
+                         (const unsigned char *)Buffer.getBufferEnd());
 
   llvm::BitstreamCursor Stream;
-  Stream.init(StreamFile);
+  Stream.init(Diags->StreamFile);
 
   // Sniff for the signature.
   if (Stream.Read(8) != 'D' ||
@@ -286,9 +340,6 @@ CXDiagnosticSet DiagLoader::load(const char *file) {
     return 0;
   }
 
-  OwningPtr<CXLoadedDiagnosticSetImpl>
-    Diags(new CXLoadedDiagnosticSetImpl());
-
   while (true) {
     unsigned BlockID = 0;
     StreamResult Res = readToNextRecordOrBlock(Stream, "Top-level", 
@@ -312,7 +363,8 @@ CXDiagnosticSet DiagLoader::load(const char *file) {
           return 0;
         break;
       case serialized_diags::BLOCK_DIAG:
-        if (readDiagnosticBlock(Stream, *Diags.get(), *Diags.get()))
+        Diags->DiagOffsets.push_back(Stream.GetCurrentBitNo());
+        if (readDiagnosticBlock(Stream, 0, *Diags.get()))
           return 0;
         break;
       default:
@@ -470,7 +522,7 @@ LoadResult DiagLoader::readString(CXLoadedDiagnosticSetImpl &TopDiags,
     return Failure;
   }
   
-  RetStr = TopDiags.makeString(BlobStart, BlobLen);
+  RetStr = llvm::StringRef(BlobStart, BlobLen);
   return Success;
 }
 
@@ -485,7 +537,7 @@ LoadResult DiagLoader::readString(CXLoadedDiagnosticSetImpl &TopDiags,
   if (readString(TopDiags, RetStr, errorContext, Record, BlobStart, BlobLen,
                  allowEmptyString))
     return Failure;
-  strings[Record[0]] = RetStr;
+  strings[Record[0]] = TopDiags.makeString(RetStr.data(), RetStr.size());
   return Success;
 }
 
@@ -522,7 +574,15 @@ LoadResult DiagLoader::readLocation(CXLoadedDiagnosticSetImpl &TopDiags,
 LoadResult DiagLoader::readRange(CXLoadedDiagnosticSetImpl &TopDiags,
                                  RecordData &Record,
                                  unsigned int RecStartIdx,
-                                 CXSourceRange &SR) {
+                                 CXSourceRange *SR) {
+  if (!SR) {
+    // Only check the range.
+    CXLoadedDiagnostic::Location Start, End;
+    if (readLocation(TopDiags, Record, RecStartIdx, Start))
+      return Failure;
+    return readLocation(TopDiags, Record, RecStartIdx, End);
+  }
+
   CXLoadedDiagnostic::Location *Start, *End;
   Start = TopDiags.Alloc.Allocate<CXLoadedDiagnostic::Location>();
   End = TopDiags.Alloc.Allocate<CXLoadedDiagnostic::Location>();
@@ -534,12 +594,12 @@ LoadResult DiagLoader::readRange(CXLoadedDiagnosticSetImpl &TopDiags,
   
   CXSourceLocation startLoc = makeLocation(Start);
   CXSourceLocation endLoc = makeLocation(End);
-  SR = clang_getRange(startLoc, endLoc);
+  *SR = clang_getRange(startLoc, endLoc);
   return Success;  
 }
 
 LoadResult DiagLoader::readDiagnosticBlock(llvm::BitstreamCursor &Stream,
-                                           CXDiagnosticSetImpl &Diags,
+                                           CXLoadedDiagnostic *D,
                                            CXLoadedDiagnosticSetImpl &TopDiags){
 
   if (Stream.EnterSubBlock(clang::serialized_diags::BLOCK_DIAG)) {
@@ -547,7 +607,6 @@ LoadResult DiagLoader::readDiagnosticBlock(llvm::BitstreamCursor &Stream,
     return Failure;
   }
   
-  OwningPtr<CXLoadedDiagnostic> D(new CXLoadedDiagnostic());
   RecordData Record;
   
   while (true) {
@@ -566,15 +625,19 @@ LoadResult DiagLoader::readDiagnosticBlock(llvm::BitstreamCursor &Stream,
             reportInvalidFile("Invalid subblock in Diagnostics block");
             return Failure;
           }
-        } else if (readDiagnosticBlock(Stream, D->getChildDiagnostics(),
-                                       TopDiags)) {
-          return Failure;
+        } else {
+          OwningPtr<CXLoadedDiagnostic> Child;
+          if (D)
+            Child.reset(new CXLoadedDiagnostic());
+          if (readDiagnosticBlock(Stream, Child.get(), TopDiags))
+            return Failure;
+          if (D)
+            D->getChildDiagnostics().appendDiagnostic(Child.take());
         }
 
         continue;
       }
       case Read_BlockEnd:
-        Diags.appendDiagnostic(D.take());        
         return Success;
       case Read_Record:
         break;
@@ -591,6 +654,12 @@ LoadResult DiagLoader::readDiagnosticBlock(llvm::BitstreamCursor &Stream,
         recID > serialized_diags::RECORD_LAST)
       continue;
     
+    // The strings were all read when the file was loaded.
+    if (D && (recID == serialized_diags::RECORD_CATEGORY ||
+              recID == serialized_diags::RECORD_DIAG_FLAG ||
+              recID == serialized_diags::RECORD_FILENAME))
+      continue;
+
     switch ((serialized_diags::RecordIDs)recID) {  
       case serialized_diags::RECORD_VERSION:
         continue;
@@ -628,29 +697,38 @@ LoadResult DiagLoader::readDiagnosticBlock(llvm::BitstreamCursor &Stream,
 
       case serialized_diags::RECORD_SOURCE_RANGE: {
         CXSourceRange SR;
-        if (readRange(TopDiags, Record, 0, SR))
+        if (readRange(TopDiags, Record, 0, D ? &SR : 0))
           return Failure;
-        D->Ranges.push_back(SR);
+        if (D)
+          D->Ranges.push_back(SR);
         continue;
       }
       
       case serialized_diags::RECORD_FIXIT: {
         CXSourceRange SR;
-        if (readRange(TopDiags, Record, 0, SR))
+        if (readRange(TopDiags, Record, 0, D ? &SR : 0))
           return Failure;
         llvm::StringRef RetStr;
         if (readString(TopDiags, RetStr, "FIXIT", Record, BlobStart, BlobLen,
                        /* allowEmptyString */ true))
           return Failure;
-        D->FixIts.push_back(std::make_pair(SR, createCXString(RetStr, false)));
+        if (D) {
+          RetStr = TopDiags.makeString(RetStr.data(), RetStr.size());
+          D->FixIts.push_back(std::make_pair(SR,
+                                             createCXString(RetStr, false)));
+        }
         continue;
       }
         
       case serialized_diags::RECORD_DIAG: {
-        D->severity = Record[0];
+        CXLoadedDiagnostic::Location DiagLoc;
         unsigned offset = 1;
-        if (readLocation(TopDiags, Record, offset, D->DiagLoc))
+        if (readLocation(TopDiags, Record, offset, DiagLoc))
           return Failure;
+        if (!D)
+          continue;
+        D->severity = Record[0];
+        D->DiagLoc = DiagLoc;
         D->category = Record[offset++];
         unsigned diagFlag = Record[offset++];
         D->DiagOption = diagFlag ? TopDiags.WarningFlags[diagFlag] : "";
@@ -14,6 +14,8 @@
 #ifndef LLVM_CLANG_CXTRANSLATIONUNIT_H
 #define LLVM_CLANG_CXTRANSLATIONUNIT_H
 
+#include "llvm/Support/Atomic.h"
+
 extern "C" {
 struct CXTranslationUnitImpl {
   void *CIdx;
@@ -21,6 +23,14 @@ struct CXTranslationUnitImpl {
   void *StringPool;
   void *Diagnostics;
   void *OverridenCursorsPool;
+  void *CursorCache;
+  void *USRCache;
+  void *FileRefIndex;
+  unsigned long long LastUse;
+  void *QueryMutex;
+  /// The number of CXTUQueryLocks held on the translation unit, which keep
+  /// the index from unloading its AST.
+  llvm::sys::cas_flag ActiveQueries;
 };
 }
 
@@ -31,6 +41,36 @@ namespace clang {
 namespace cxtu {
 
 CXTranslationUnitImpl *MakeCXTranslationUnit(CIndexer *CIdx, ASTUnit *TU);
+
+/// \brief Return the ASTUnit of \p TU, noting that it was used.
+///
+/// If the index unloaded the AST to stay within its memory budget, it is
+/// parsed again first.
+ASTUnit *getASTUnit(CXTranslationUnitImpl *TU);
+
+/// \brief Unload the ASTs of the least recently used translation units of
+/// the index of \p TU until they fit its memory budget.
+///
+/// Neither \p TU nor a translation unit with a query in progress, such as
+/// one whose cursors are being visited while the visitor calls into \p TU,
+/// is unloaded.
+void enforceMemoryBudget(CXTranslationUnitImpl *TU);
+
+/// \brief Marks a query on a translation unit as in progress, so that its AST
+/// is not unloaded, and holds the lock that serializes the queries on a
+/// translation unit parsed with \c CXTranslationUnit_ThreadSafeQueries.
+class CXTUQueryLock {
+  CXTranslationUnitImpl *TU;
+  void *Mutex;
+
+  // DO NOT IMPLEMENT
+  CXTUQueryLock(const CXTUQueryLock &);
+  void operator=(const CXTUQueryLock &);
+
+public:
+  explicit CXTUQueryLock(CXTranslationUnitImpl *TU);
+  ~CXTUQueryLock();
+};
   
 class CXTUOwner {
   CXTranslationUnitImpl *TU;
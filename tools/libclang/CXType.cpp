@@ -97,7 +97,7 @@ CXType cxtype::MakeCXType(QualType T, CXTranslationUnit TU) {
   CXTypeKind TK = CXType_Invalid;
 
   if (TU && !T.isNull()) {
-    ASTContext &Ctx = static_cast<ASTUnit *>(TU->TUData)->getASTContext();
+    ASTContext &Ctx = cxtu::getASTUnit(TU)->getASTContext();
     if (Ctx.getLangOpts().ObjC1) {
       QualType UnqualT = T.getUnqualifiedType();
       if (Ctx.isObjCIdType(UnqualT))
@@ -131,7 +131,8 @@ CXType clang_getCursorType(CXCursor C) {
   using namespace cxcursor;
   
   CXTranslationUnit TU = cxcursor::getCursorTU(C);
-  ASTContext &Context = static_cast<ASTUnit *>(TU->TUData)->getASTContext();
+  cxtu::CXTUQueryLock Lock(TU);
+  ASTContext &Context = cxtu::getASTUnit(TU)->getASTContext();
   if (clang_isExpression(C.kind)) {
     QualType T = cxcursor::getCursorExpr(C)->getType();
     return MakeCXType(T, TU);
@@ -275,7 +276,7 @@ CXType clang_getCanonicalType(CXType CT) {
   if (T.isNull())
     return MakeCXType(QualType(), GetTU(CT));
 
-  ASTUnit *AU = static_cast<ASTUnit*>(TU->TUData);
+  ASTUnit *AU = cxtu::getASTUnit(TU);
   return MakeCXType(AU->getASTContext().getCanonicalType(T), TU);
 }
 
@@ -326,6 +327,7 @@ CXCursor clang_getTypeDeclaration(CXType CT) {
   if (CT.kind == CXType_Invalid)
     return cxcursor::MakeCXCursorInvalid(CXCursor_NoDeclFound);
 
+  cxtu::CXTUQueryLock Lock(GetTU(CT));
   QualType T = GetQualType(CT);
   const Type *TP = T.getTypePtrOrNull();
 
@@ -532,7 +534,7 @@ unsigned clang_isPODType(CXType X) {
     return 0;
   
   CXTranslationUnit TU = GetTU(X);
-  ASTUnit *AU = static_cast<ASTUnit*>(TU->TUData);
+  ASTUnit *AU = cxtu::getASTUnit(TU);
 
   return T.isPODType(AU->getASTContext()) ? 1 : 0;
 }
@@ -620,7 +622,7 @@ CXString clang_getDeclObjCTypeEncoding(CXCursor C) {
 
   Decl *D = static_cast<Decl*>(C.data[0]);
   CXTranslationUnit TU = static_cast<CXTranslationUnit>(C.data[2]);
-  ASTUnit *AU = static_cast<ASTUnit*>(TU->TUData);
+  ASTUnit *AU = cxtu::getASTUnit(TU);
   ASTContext &Ctx = AU->getASTContext();
   std::string encoding;
 
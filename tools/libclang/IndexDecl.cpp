@@ -328,6 +328,8 @@ void IndexingContext::indexDeclContext(const DeclContext *DC) {
 void IndexingContext::indexTopLevelDecl(Decl *D) {
   if (isNotFromSourceFile(D->getLocation()))
     return;
+  if (isInSkippedFile(D->getLocation()))
+    return;
 
   if (isa<ObjCMethodDecl>(D))
     return; // Wait for the objc container.
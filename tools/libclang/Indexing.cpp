@@ -15,6 +15,7 @@
 #include "CIndexDiagnostic.h"
 #include "CIndexer.h"
 
+#include "clang/Basic/Parallel.h"
 #include "clang/Frontend/ASTUnit.h"
 #include "clang/Frontend/CompilerInvocation.h"
 #include "clang/Frontend/CompilerInstance.h"
@@ -25,8 +26,11 @@
 #include "clang/AST/DeclVisitor.h"
 #include "clang/Lex/Preprocessor.h"
 #include "clang/Lex/PPCallbacks.h"
+#include "clang/Tooling/CompilationDatabase.h"
+#include "llvm/Support/Atomic.h"
 #include "llvm/Support/MemoryBuffer.h"
 #include "llvm/Support/CrashRecoveryContext.h"
+#include "llvm/Support/Mutex.h"
 
 using namespace clang;
 using namespace cxstring;
@@ -52,15 +56,22 @@ public:
 
   virtual void FileChanged(SourceLocation Loc, FileChangeReason Reason,
                           SrcMgr::CharacteristicKind FileType, FileID PrevFID) {
-    if (IsMainFileEntered)
+    if (Reason != PPCallbacks::EnterFile)
       return;
 
     SourceManager &SM = PP.getSourceManager();
+    if (IsMainFileEntered) {
+      IndexCtx.enteredFile(SM.getFileEntryForID(SM.getFileID(Loc)));
+      return;
+    }
+
     SourceLocation MainFileLoc = SM.getLocForStartOfFile(SM.getMainFileID());
 
-    if (Loc == MainFileLoc && Reason == PPCallbacks::EnterFile) {
+    if (Loc == MainFileLoc) {
       IsMainFileEntered = true;
-      IndexCtx.enteredMainFile(SM.getFileEntryForID(SM.getMainFileID()));
+      const FileEntry *MainFile = SM.getFileEntryForID(SM.getMainFileID());
+      IndexCtx.enteredMainFile(MainFile);
+      IndexCtx.enteredFile(MainFile);
     }
   }
 
@@ -183,9 +194,12 @@ public:
   IndexingFrontendAction(CXClientData clientData,
                          IndexerCallbacks &indexCallbacks,
                          unsigned indexOptions,
-                         CXTranslationUnit cxTU)
+                         CXTranslationUnit cxTU,
+                         IndexSessionData *session)
     : IndexCtx(clientData, indexCallbacks, indexOptions, cxTU),
-      CXTU(cxTU) { }
+      CXTU(cxTU) {
+    IndexCtx.setSession(session);
+  }
 
   virtual ASTConsumer *CreateASTConsumer(CompilerInstance &CI,
                                          StringRef InFile) {
@@ -226,6 +240,8 @@ struct IndexSourceFileInfo {
   unsigned num_unsaved_files;
   CXTranslationUnit *out_TU;
   unsigned TU_options;
+  const char *working_directory;
+  IndexSessionData *session;
   int result;
 };
 
@@ -256,6 +272,8 @@ static void clang_indexSourceFile_Impl(void *UserData) {
   unsigned num_unsaved_files = ITUI->num_unsaved_files;
   CXTranslationUnit *out_TU  = ITUI->out_TU;
   unsigned TU_options = ITUI->TU_options;
+  const char *working_directory = ITUI->working_directory;
+  IndexSessionData *session = ITUI->session;
   ITUI->result = 1; // init as error.
   
   if (out_TU)
@@ -326,6 +344,9 @@ static void clang_indexSourceFile_Impl(void *UserData) {
   if (CInvok->getFrontendOpts().Inputs.empty())
     return;
 
+  if (working_directory)
+    CInvok->getFileSystemOpts().WorkingDir = working_directory;
+
   OwningPtr<MemBufferOwner> BufOwner(new MemBufferOwner());
 
   // Recover resources if we crash before exiting this method.
@@ -356,6 +377,8 @@ static void clang_indexSourceFile_Impl(void *UserData) {
                                   /*CaptureDiagnostics=*/true,
                                   /*UserFilesAreVolatile=*/true);
   OwningPtr<CXTUOwner> CXTU(new CXTUOwner(MakeCXTranslationUnit(CXXIdx, Unit)));
+  // Keep the memory budget from unloading the AST while it is being built.
+  CXXIdx->removeTranslationUnit(CXTU->getTU());
 
   // Recover resources if we crash before exiting this method.
   llvm::CrashRecoveryContextCleanupRegistrar<CXTUOwner>
@@ -363,7 +386,8 @@ static void clang_indexSourceFile_Impl(void *UserData) {
 
   OwningPtr<IndexingFrontendAction> IndexAction;
   IndexAction.reset(new IndexingFrontendAction(client_data, CB,
-                                               index_options, CXTU->getTU()));
+                                               index_options, CXTU->getTU(),
+                                               session));
 
   // Recover resources if we crash before exiting this method.
   llvm::CrashRecoveryContextCleanupRegistrar<IndexingFrontendAction>
@@ -406,12 +430,80 @@ static void clang_indexSourceFile_Impl(void *UserData) {
   if (!Success)
     return;
 
-  if (out_TU)
+  if (out_TU) {
     *out_TU = CXTU->takeTU();
+    if (TU_options & CXTranslationUnit_ThreadSafeQueries)
+      (*out_TU)->QueryMutex = new llvm::sys::Mutex;
+    CXXIdx->addTranslationUnit(*out_TU);
+    enforceMemoryBudget(*out_TU);
+  }
 
   ITUI->result = 0; // success.
 }
 
+//===----------------------------------------------------------------------===//
+// clang_indexCompilationDatabase Implementation
+//===----------------------------------------------------------------------===//
+
+namespace {
+
+struct IndexCompilationDatabaseInfo {
+  CXIndexAction idxAction;
+  CXClientData client_data;
+  IndexerCallbacks *index_callbacks;
+  unsigned index_callbacks_size;
+  unsigned index_options;
+  std::vector<tooling::CompileCommand> Commands;
+  IndexSessionData Session;
+  bool UseCrashRecovery;
+  volatile llvm::sys::cas_flag NumFailures;
+};
+
+} // anonymous namespace
+
+static void indexCompileCommand(void *UserData, unsigned Index) {
+  IndexCompilationDatabaseInfo &Info
+    = *static_cast<IndexCompilationDatabaseInfo *>(UserData);
+  const tooling::CompileCommand &Command = Info.Commands[Index];
+
+  // The first argument is the compiler itself, and the source file is part
+  // of the remaining ones.
+  std::vector<const char *> Args;
+  for (unsigned I = 1, N = Command.CommandLine.size(); I < N; ++I)
+    Args.push_back(Command.CommandLine[I].c_str());
+
+  IndexSourceFileInfo ITUI = { Info.idxAction, Info.client_data,
+                               Info.index_callbacks, Info.index_callbacks_size,
+                               Info.index_options, /*source_filename=*/0,
+                               Args.empty() ? 0 : &Args[0],
+                               static_cast<int>(Args.size()),
+                               /*unsaved_files=*/0, /*num_unsaved_files=*/0,
+                               /*out_TU=*/0, /*TU_options=*/0,
+                               Command.Directory.c_str(), &Info.Session, 0 };
+
+  if (!Info.UseCrashRecovery) {
+    clang_indexSourceFile_Impl(&ITUI);
+  } else {
+    llvm::CrashRecoveryContext CRC;
+    if (!CRC.RunSafely(clang_indexSourceFile_Impl, &ITUI)) {
+      fprintf(stderr, "libclang: crash detected during batch indexing: {\n");
+      fprintf(stderr, "  'directory' : '%s'\n", Command.Directory.c_str());
+      fprintf(stderr, "  'command_line_args' : [");
+      for (unsigned i = 0, e = Args.size(); i != e; ++i) {
+        if (i)
+          fprintf(stderr, ", ");
+        fprintf(stderr, "'%s'", Args[i]);
+      }
+      fprintf(stderr, "],\n");
+      fprintf(stderr, "}\n");
+      ITUI.result = 1;
+    }
+  }
+
+  if (ITUI.result)
+    llvm::sys::AtomicIncrement(&Info.NumFailures);
+}
+
 //===----------------------------------------------------------------------===//
 // clang_indexTranslationUnit Implementation
 //===----------------------------------------------------------------------===//
@@ -535,7 +627,7 @@ static void clang_indexTranslationUnit_Impl(void *UserData) {
   llvm::CrashRecoveryContextCleanupRegistrar<IndexingConsumer>
     IndexConsumerCleanup(IndexConsumer.get());
 
-  ASTUnit *Unit = static_cast<ASTUnit *>(TU->TUData);
+  ASTUnit *Unit = cxtu::getASTUnit(TU);
   if (!Unit)
     return;
 
@@ -719,7 +811,8 @@ int clang_indexSourceFile(CXIndexAction idxAction,
                                index_callbacks_size, index_options,
                                source_filename, command_line_args,
                                num_command_line_args, unsaved_files,
-                               num_unsaved_files, out_TU, TU_options, 0 };
+                               num_unsaved_files, out_TU, TU_options,
+                               /*working_directory=*/0, /*session=*/0, 0 };
 
   if (getenv("LIBCLANG_NOTHREADS")) {
     clang_indexSourceFile_Impl(&ITUI);
@@ -785,6 +878,44 @@ int clang_indexTranslationUnit(CXIndexAction idxAction,
   return ITUI.result;
 }
 
+int clang_indexCompilationDatabase(CXIndexAction idxAction,
+                                   CXClientData client_data,
+                                   IndexerCallbacks *index_callbacks,
+                                   unsigned index_callbacks_size,
+                                   unsigned index_options,
+                                   CXCompilationDatabase CDb,
+                                   unsigned num_threads) {
+  tooling::CompilationDatabase *DB
+    = static_cast<tooling::CompilationDatabase *>(CDb);
+  if (!DB)
+    return 1;
+
+  IndexCompilationDatabaseInfo Info;
+  Info.idxAction = idxAction;
+  Info.client_data = client_data;
+  Info.index_callbacks = index_callbacks;
+  Info.index_callbacks_size = index_callbacks_size;
+  Info.index_options = index_options;
+  Info.UseCrashRecovery = !getenv("LIBCLANG_NOTHREADS");
+  Info.NumFailures = 0;
+
+  std::vector<std::string> Files = DB->getAllFiles();
+  for (unsigned I = 0, N = Files.size(); I != N; ++I) {
+    std::vector<tooling::CompileCommand> Commands
+      = DB->getCompileCommands(Files[I]);
+    Info.Commands.insert(Info.Commands.end(), Commands.begin(), Commands.end());
+  }
+
+  if (!Info.UseCrashRecovery)
+    num_threads = 1;
+
+  // Parsing deeply nested code needs more than the default stack size of
+  // worker threads.
+  runTasksInParallel(num_threads, Info.Commands.size(), indexCompileCommand,
+                     &Info, /*StackSize=*/8 << 20);
+  return Info.NumFailures;
+}
+
 void clang_indexLoc_getFileLocation(CXIdxLoc location,
                                     CXIdxClientFile *indexFile,
                                     CXFile *file,
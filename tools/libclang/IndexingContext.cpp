@@ -14,6 +14,7 @@
 #include "clang/Frontend/ASTUnit.h"
 #include "clang/AST/DeclCXX.h"
 #include "clang/AST/DeclTemplate.h"
+#include "llvm/Support/MutexGuard.h"
 
 using namespace clang;
 using namespace cxindex;
@@ -217,6 +218,24 @@ void IndexingContext::enteredMainFile(const FileEntry *File) {
   }
 }
 
+bool IndexSessionData::claimFile(const FileEntry *File) {
+  llvm::MutexGuard Guard(Lock);
+  return ClaimedFiles.insert(std::make_pair(File->getDevice(),
+                                            File->getInode())).second;
+}
+
+void IndexingContext::enteredFile(const FileEntry *File) {
+  if (!Session || !File)
+    return;
+  if (ClaimedFiles.count(File) || SkippedFiles.count(File))
+    return;
+
+  if (Session->claimFile(File))
+    ClaimedFiles.insert(File);
+  else
+    SkippedFiles.insert(File);
+}
+
 void IndexingContext::ppIncludedFile(SourceLocation hashLoc,
                                      StringRef filename,
                                      const FileEntry *File,
@@ -255,6 +274,8 @@ bool IndexingContext::handleDecl(const NamedDecl *D,
     return false;
   if (D->isImplicit() && shouldIgnoreIfImplicit(D))
     return false;
+  if (isInSkippedFile(Loc))
+    return false;
 
   ScratchAlloc SA(*this);
   getEntityInfo(D, DInfo.EntInfo, SA);
@@ -596,6 +617,8 @@ bool IndexingContext::handleReference(const NamedDecl *D, SourceLocation Loc,
     return false;
   if (D->isImplicit() && shouldIgnoreIfImplicit(D))
     return false;
+  if (isInSkippedFile(Loc))
+    return false;
 
   if (shouldSuppressRefs()) {
     if (markEntityOccurrenceInFile(D, Loc))
@@ -632,6 +655,15 @@ bool IndexingContext::isNotFromSourceFile(SourceLocation Loc) const {
   return SM.getFileEntryForID(FID) == 0;
 }
 
+bool IndexingContext::isInSkippedFile(SourceLocation Loc) const {
+  if (SkippedFiles.empty() || Loc.isInvalid())
+    return false;
+  SourceManager &SM = Ctx->getSourceManager();
+  SourceLocation FileLoc = SM.getFileLoc(Loc);
+  FileID FID = SM.getFileID(FileLoc);
+  return SkippedFiles.count(SM.getFileEntryForID(FID));
+}
+
 void IndexingContext::addContainerInMap(const DeclContext *DC,
                                         CXIdxClientContainer container) {
   if (!DC)
@@ -1023,7 +1055,7 @@ void IndexingContext::getEntityInfo(const NamedDecl *D,
 
   {
     SmallString<512> StrBuf;
-    bool Ignore = getDeclCursorUSR(D, StrBuf);
+    bool Ignore = getDeclCursorUSR(D, StrBuf, CXTU);
     if (Ignore) {
       EntityInfo.USR = 0;
     } else {
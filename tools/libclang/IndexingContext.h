@@ -13,7 +13,9 @@
 #include "clang/AST/DeclObjC.h"
 #include "clang/AST/DeclGroup.h"
 #include "llvm/ADT/DenseSet.h"
+#include "llvm/Support/Mutex.h"
 #include <deque>
+#include <set>
 
 namespace clang {
   class FileEntry;
@@ -287,6 +289,20 @@ struct RefFileOccurence {
     : File(File), Dcl(Dcl) { }
 };
 
+/// \brief State shared between the translation units indexed by one call to
+/// clang_indexCompilationDatabase, which may be indexed concurrently.
+class IndexSessionData {
+  llvm::sys::Mutex Lock;
+  std::set<std::pair<dev_t, ino_t> > ClaimedFiles;
+
+public:
+  /// \brief Claim \p File for the calling translation unit.
+  ///
+  /// \returns false if another translation unit of the session already
+  /// claimed it, in which case it should not be indexed again.
+  bool claimFile(const FileEntry *File);
+};
+
 class IndexingContext {
   ASTContext *Ctx;
   CXClientData ClientData;
@@ -305,6 +321,13 @@ class IndexingContext {
 
   llvm::DenseSet<RefFileOccurence> RefFileOccurences;
 
+  IndexSessionData *Session;
+
+  /// \brief The files whose declarations and references are indexed by
+  /// another translation unit of the session.
+  llvm::DenseSet<const FileEntry *> SkippedFiles;
+  llvm::DenseSet<const FileEntry *> ClaimedFiles;
+
   std::deque<DeclGroupRef> TUDeclsInObjCContainer;
   
   llvm::BumpPtrAllocator StrScratch;
@@ -350,13 +373,14 @@ public:
   IndexingContext(CXClientData clientData, IndexerCallbacks &indexCallbacks,
                   unsigned indexOptions, CXTranslationUnit cxTU)
     : Ctx(0), ClientData(clientData), CB(indexCallbacks),
-      IndexOptions(indexOptions), CXTU(cxTU),
+      IndexOptions(indexOptions), CXTU(cxTU), Session(0),
       StrScratch(/*size=*/1024), StrAdapterCount(0) { }
 
   ASTContext &getASTContext() const { return *Ctx; }
 
   void setASTContext(ASTContext &ctx);
   void setPreprocessor(Preprocessor &PP);
+  void setSession(IndexSessionData *session) { Session = session; }
 
   bool shouldSuppressRefs() const {
     return IndexOptions & CXIndexOpt_SuppressRedundantRefs;
@@ -376,6 +400,10 @@ public:
 
   void enteredMainFile(const FileEntry *File);
 
+  /// \brief Called when the preprocessor enters \p File, including the main
+  /// file.
+  void enteredFile(const FileEntry *File);
+
   void ppIncludedFile(SourceLocation hashLoc,
                       StringRef filename, const FileEntry *File,
                       bool isImport, bool isAngled);
@@ -451,6 +479,10 @@ public:
 
   bool isNotFromSourceFile(SourceLocation Loc) const;
 
+  /// \brief Whether \p Loc is in a file that another translation unit of the
+  /// session indexes.
+  bool isInSkippedFile(SourceLocation Loc) const;
+
   void indexTopLevelDecl(Decl *D);
   void indexTUDeclsInObjCContainer();
   void indexDeclGroupRef(DeclGroupRef DG);
@@ -10,6 +10,8 @@
 #include "clang/Basic/FileSystemOptions.h"
 #include "clang/Basic/FileSystemStatCache.h"
 #include "clang/Basic/FileManager.h"
+#include "clang/Basic/VirtualFileSystem.h"
+#include "llvm/Support/MemoryBuffer.h"
 
 #include "gtest/gtest.h"
 
@@ -52,7 +54,7 @@ public:
 
   // Implement FileSystemStatCache::getStat().
   virtual LookupResult getStat(const char *Path, struct stat &StatBuf,
-                               int *FileDescriptor) {
+                               int *FileDescriptor, VirtualFileSystem &FS) {
     if (StatCalls.count(Path) != 0) {
       StatBuf = StatCalls[Path];
       return CacheExists;
@@ -186,6 +188,90 @@ TEST_F(FileManagerTest, getFileReturnsNULLForNonexistentFile) {
   EXPECT_EQ(NULL, file);
 }
 
+// Results cached by one SharedStatCache are visible to the SharedStatCaches
+// of other FileManagers.
+TEST_F(FileManagerTest, sharedStatCacheIsSharedBetweenFileManagers) {
+  SharedStatCache::invalidateAll();
+
+  FakeStatCache *statCache = new FakeStatCache;
+  statCache->InjectDirectory("/shared", 41);
+  statCache->InjectFile("/shared/foo.h", 42);
+  SharedStatCache *sharedCache = new SharedStatCache;
+  sharedCache->setNextStatCache(statCache);
+  manager.addStatCache(sharedCache);
+  ASSERT_TRUE(manager.getFile("/shared/foo.h") != NULL);
+  EXPECT_EQ(NULL, manager.getFile("/shared/bar.h"));
+
+  // The second file manager sees an empty file system below its shared cache.
+  FileManager otherManager(options);
+  sharedCache = new SharedStatCache;
+  sharedCache->setNextStatCache(new FakeStatCache);
+  otherManager.addStatCache(sharedCache);
+  const FileEntry *file = otherManager.getFile("/shared/foo.h");
+  ASSERT_TRUE(file != NULL);
+  EXPECT_STREQ("/shared", file->getDir()->getName());
+  EXPECT_EQ(NULL, otherManager.getFile("/shared/bar.h"));
+
+  SharedStatCache::invalidate("/shared/foo.h");
+  FileManager thirdManager(options);
+  sharedCache = new SharedStatCache;
+  sharedCache->setNextStatCache(new FakeStatCache);
+  thirdManager.addStatCache(sharedCache);
+  EXPECT_EQ(NULL, thirdManager.getFile("/shared/foo.h"));
+
+  SharedStatCache::invalidateAll();
+}
+
+// Files and directories are looked up in the file system of the FileManager.
+TEST_F(FileManagerTest, getFileFindsFilesOfInMemoryFileSystem) {
+  IntrusiveRefCntPtr<InMemoryFileSystem> FS(new InMemoryFileSystem);
+  FS->addFile("/src/foo.h", MemoryBuffer::getMemBuffer("int foo;"), 42);
+  FS->addFile("inc/./sub/../bar.h", MemoryBuffer::getMemBuffer("int bar;"));
+  FileManager fileManager(options, FS.getPtr());
+
+  const FileEntry *file = fileManager.getFile("/src/foo.h");
+  ASSERT_TRUE(file != NULL);
+  EXPECT_EQ(8, file->getSize());
+  EXPECT_EQ(42, file->getModificationTime());
+  EXPECT_STREQ("/src", file->getDir()->getName());
+  OwningPtr<MemoryBuffer> buffer(fileManager.getBufferForFile(file));
+  ASSERT_TRUE(buffer != NULL);
+  EXPECT_EQ("int foo;", buffer->getBuffer());
+
+  file = fileManager.getFile("inc/bar.h");
+  ASSERT_TRUE(file != NULL);
+  EXPECT_NE(file, fileManager.getFile("/src/foo.h"));
+  EXPECT_TRUE(fileManager.getDirectory("inc/sub") == NULL);
+  EXPECT_TRUE(fileManager.getDirectory("inc") != NULL);
+  EXPECT_EQ(NULL, fileManager.getFile("/src/bar.h"));
+  EXPECT_EQ(NULL, fileManager.getFile("/src"));
+}
+
+// The most recently pushed file system of an overlay provides the files it
+// has; the others provide the rest.
+TEST_F(FileManagerTest, overlayFileSystemPrefersUpperFileSystems) {
+  IntrusiveRefCntPtr<InMemoryFileSystem> lower(new InMemoryFileSystem);
+  lower->addFile("/src/foo.h", MemoryBuffer::getMemBuffer("lower"));
+  lower->addFile("/src/bar.h", MemoryBuffer::getMemBuffer("bar"));
+  IntrusiveRefCntPtr<InMemoryFileSystem> upper(new InMemoryFileSystem);
+  upper->addFile("/src/foo.h", MemoryBuffer::getMemBuffer("upper"));
+  IntrusiveRefCntPtr<OverlayFileSystem> FS(
+      new OverlayFileSystem(lower.getPtr()));
+  FS->pushOverlay(upper.getPtr());
+  FileManager fileManager(options, FS.getPtr());
+
+  OwningPtr<MemoryBuffer> buffer(fileManager.getBufferForFile("/src/foo.h"));
+  ASSERT_TRUE(buffer != NULL);
+  EXPECT_EQ("upper", buffer->getBuffer());
+
+  const FileEntry *file = fileManager.getFile("/src/bar.h");
+  ASSERT_TRUE(file != NULL);
+  buffer.reset(fileManager.getBufferForFile(file));
+  ASSERT_TRUE(buffer != NULL);
+  EXPECT_EQ("bar", buffer->getBuffer());
+  EXPECT_NE(file, fileManager.getFile("/src/foo.h"));
+}
+
 // The following tests apply to Unix-like system only.
 
 #ifndef _WIN32
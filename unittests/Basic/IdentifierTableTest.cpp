@@ -0,0 +1,58 @@
+//===- unittests/Basic/IdentifierTableTest.cpp - IdentifierTable tests ----===//
+//
+//                     The LLVM Compiler Infrastructure
+//
+// This file is distributed under the University of Illinois Open Source
+// License. See LICENSE.TXT for details.
+//
+//===----------------------------------------------------------------------===//
+
+#include "clang/Basic/IdentifierTable.h"
+#include "clang/Basic/LangOptions.h"
+#include "llvm/ADT/StringExtras.h"
+
+#include "gtest/gtest.h"
+
+using namespace llvm;
+using namespace clang;
+
+namespace {
+
+TEST(IdentifierTableTest, getForLexerFindsKeywords) {
+  LangOptions LangOpts;
+  IdentifierTable Table(LangOpts);
+
+  EXPECT_EQ(tok::kw_int, Table.getForLexer("int").getTokenID());
+  EXPECT_EQ(tok::kw_while, Table.getForLexer("while").getTokenID());
+  EXPECT_EQ(&Table.get("return"), &Table.getForLexer("return"));
+}
+
+TEST(IdentifierTableTest, getForLexerMatchesGet) {
+  LangOptions LangOpts;
+  IdentifierTable Table(LangOpts);
+
+  // These names share their length and the bytes getQuickHash() reads.
+  const char *Names[] = {
+    "prefix_for_all_0_suffix_for_all", "prefix_for_all_1_suffix_for_all",
+    "prefix_for_all_2_suffix_for_all", "a", "ab", "abc", "abcd", "abcde",
+    "abcdefgh", "abcdefghi", "%%%", ""
+  };
+  for (unsigned Round = 0; Round != 2; ++Round) {
+    for (unsigned I = 0; I != array_lengthof(Names); ++I) {
+      IdentifierInfo &II = Table.getForLexer(Names[I]);
+      EXPECT_EQ(StringRef(Names[I]), II.getName());
+      EXPECT_EQ(&Table.get(Names[I]), &II);
+    }
+  }
+
+  // Growing the cache keeps the answers.
+  Table.reserveLexerCache(100000);
+  for (unsigned I = 0; I != 5000; ++I) {
+    std::string Name = "id" + utostr(I);
+    EXPECT_EQ(&Table.get(Name), &Table.getForLexer(Name));
+  }
+  for (unsigned I = 0; I != array_lengthof(Names); ++I)
+    EXPECT_EQ(StringRef(Names[I]), Table.getForLexer(Names[I]).getName());
+}
+
+} // anonymous namespace
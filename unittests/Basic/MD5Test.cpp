@@ -0,0 +1,67 @@
+//===- unittests/Basic/MD5Test.cpp - MD5 tests ----------------------------===//
+//
+//                     The LLVM Compiler Infrastructure
+//
+// This file is distributed under the University of Illinois Open Source
+// License. See LICENSE.TXT for details.
+//
+//===----------------------------------------------------------------------===//
+
+#include "clang/Basic/MD5.h"
+#include "llvm/ADT/SmallString.h"
+#include "llvm/Support/Format.h"
+#include "llvm/Support/raw_ostream.h"
+
+#include "gtest/gtest.h"
+
+using namespace llvm;
+using namespace clang;
+
+namespace {
+
+std::string digestOf(StringRef Data, unsigned ChunkSize = 0) {
+  MD5 Hasher;
+  if (!ChunkSize)
+    ChunkSize = Data.size();
+  for (size_t I = 0; I < Data.size(); I += ChunkSize)
+    Hasher.update(Data.substr(I, ChunkSize));
+  MD5::Digest Result;
+  Hasher.final(Result);
+
+  SmallString<32> Hex;
+  raw_svector_ostream OS(Hex);
+  for (unsigned I = 0; I != 16; ++I)
+    OS << format("%02x", Result[I]);
+  return OS.str();
+}
+
+// The test suite of RFC 1321.
+TEST(MD5Test, ComputesKnownDigests) {
+  EXPECT_EQ("d41d8cd98f00b204e9800998ecf8427e", digestOf(""));
+  EXPECT_EQ("900150983cd24fb0d6963f7d28e17f72", digestOf("abc"));
+  EXPECT_EQ("f96b697d7cb7938d525a2f31aaf161d0", digestOf("message digest"));
+  EXPECT_EQ("57edf4a22be3c955ac49da2e2107b67a",
+            digestOf("1234567890123456789012345678901234567890"
+                     "1234567890123456789012345678901234567890"));
+}
+
+TEST(MD5Test, DoesNotDependOnHowTheDataIsSplit) {
+  std::string Data;
+  for (unsigned I = 0; I != 300; ++I)
+    Data += char(I);
+  std::string Whole = digestOf(Data);
+  EXPECT_EQ(Whole, digestOf(Data, 1));
+  EXPECT_EQ(Whole, digestOf(Data, 7));
+  EXPECT_EQ(Whole, digestOf(Data, 64));
+}
+
+TEST(MD5Test, HashesIntoLittleEndianWords) {
+  uint32_t Words[4];
+  MD5::hash("abc", Words);
+  EXPECT_EQ(0x98500190u, Words[0]);
+  EXPECT_EQ(0xb04fd23cu, Words[1]);
+  EXPECT_EQ(0x7d3f96d6u, Words[2]);
+  EXPECT_EQ(0x727fe128u, Words[3]);
+}
+
+} // anonymous namespace
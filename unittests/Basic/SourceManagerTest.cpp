@@ -18,6 +18,8 @@
 #include "clang/Lex/Preprocessor.h"
 #include "llvm/ADT/SmallString.h"
 #include "llvm/Config/config.h"
+#include "llvm/Support/Path.h"
+#include "llvm/Support/raw_ostream.h"
 
 #include "gtest/gtest.h"
 
@@ -155,6 +157,50 @@ TEST_F(SourceManagerTest, getColumnNumber) {
   EXPECT_EQ(1U, SourceMgr.getColumnNumber(MainFileID, 0, NULL));
 }
 
+TEST_F(SourceManagerTest, precomputedLineTables) {
+  const char *Source =
+    "int x;\n"
+    "int y;\r\n"
+    "int z;";
+
+  MemoryBuffer *Buf = MemoryBuffer::getMemBuffer(Source);
+  FileID MainFileID = SourceMgr.createMainFileIDForMemBuffer(Buf);
+
+  SourceMgr.startLineTablePrecomputation();
+  EXPECT_EQ(2U, SourceMgr.getLineNumber(MainFileID, 7));
+  EXPECT_EQ(3U, SourceMgr.getLineNumber(MainFileID, 15));
+
+  ArrayRef<unsigned> LineOffsets = SourceMgr.getLineTable(MainFileID);
+  ASSERT_EQ(3U, LineOffsets.size());
+  EXPECT_EQ(0U, LineOffsets[0]);
+  EXPECT_EQ(7U, LineOffsets[1]);
+  EXPECT_EQ(15U, LineOffsets[2]);
+
+  bool Invalid = false;
+  EXPECT_TRUE(SourceMgr.getLineTable(FileID(), &Invalid).empty());
+  EXPECT_TRUE(Invalid);
+}
+
+TEST_F(SourceManagerTest, setLineTable) {
+  const char *Source =
+    "int x;\n"
+    "int y;";
+
+  MemoryBuffer *Buf = MemoryBuffer::getMemBuffer(Source);
+  FileID MainFileID = SourceMgr.createMainFileIDForMemBuffer(Buf);
+
+  // A provided table is used instead of scanning the buffer.
+  const unsigned Offsets[] = { 0, 3 };
+  SourceMgr.setLineTable(MainFileID, Offsets);
+  EXPECT_EQ(2U, SourceMgr.getLineNumber(MainFileID, 4));
+
+  // Once known, the table is not replaced.
+  const unsigned OtherOffsets[] = { 0, 7 };
+  SourceMgr.setLineTable(MainFileID, OtherOffsets);
+  EXPECT_EQ(2U, SourceMgr.getLineTable(MainFileID).size());
+  EXPECT_EQ(3U, SourceMgr.getLineTable(MainFileID)[1]);
+}
+
 #if defined(LLVM_ON_UNIX)
 
 TEST_F(SourceManagerTest, getMacroArgExpandedLocation) {
@@ -339,6 +385,95 @@ TEST_F(SourceManagerTest, isBeforeInTranslationUnitWithMacroInInclude) {
   EXPECT_TRUE(SourceMgr.isBeforeInTranslationUnit(Macros[7].Loc, Macros[8].Loc));
 }
 
+TEST_F(SourceManagerTest, isBeforeInTranslationUnitManyFiles) {
+  // The main file includes the header once at each of its offsets, and the
+  // first inclusion of the header includes it again.
+  const unsigned NumIncludes = 300;
+  std::string Main(NumIncludes + 1, ' ');
+  MemoryBuffer *MainBuf = MemoryBuffer::getMemBufferCopy(Main);
+  FileID MainFileID = SourceMgr.createMainFileIDForMemBuffer(MainBuf);
+  SourceLocation MainLoc = SourceMgr.getLocForStartOfFile(MainFileID);
+
+  const char *Header = "int x;\n";
+  MemoryBuffer *HeaderBuf = MemoryBuffer::getMemBuffer(Header);
+  const FileEntry *HeaderFile = FileMgr.getVirtualFile("/test-header.h",
+                                                 HeaderBuf->getBufferSize(), 0);
+  SourceMgr.overrideFileContents(HeaderFile, HeaderBuf);
+
+  std::vector<SourceLocation> Headers;
+  for (unsigned I = 0; I != NumIncludes; ++I) {
+    FileID FID = SourceMgr.createFileID(HeaderFile,
+                                        MainLoc.getLocWithOffset(I + 1),
+                                        SrcMgr::C_User);
+    Headers.push_back(SourceMgr.getLocForStartOfFile(FID).getLocWithOffset(4));
+  }
+  FileID NestedFID = SourceMgr.createFileID(HeaderFile,
+                                            Headers[0].getLocWithOffset(1),
+                                            SrcMgr::C_User);
+  SourceLocation Nested = SourceMgr.getLocForStartOfFile(NestedFID);
+
+  // Compare more pairs of files than are cached, in both orders and twice.
+  for (unsigned Round = 0; Round != 2; ++Round) {
+    for (unsigned I = 0; I != NumIncludes; ++I) {
+      for (unsigned J = I + 1; J != NumIncludes; ++J) {
+        EXPECT_TRUE(SourceMgr.isBeforeInTranslationUnit(Headers[I],
+                                                        Headers[J]));
+        EXPECT_FALSE(SourceMgr.isBeforeInTranslationUnit(Headers[J],
+                                                         Headers[I]));
+      }
+    }
+  }
+
+  // The nested header comes after what precedes its #include, and before
+  // the later inclusions of the main file.
+  EXPECT_TRUE(SourceMgr.isBeforeInTranslationUnit(Headers[0], Nested));
+  EXPECT_TRUE(SourceMgr.isBeforeInTranslationUnit(Nested, Headers[1]));
+  EXPECT_FALSE(SourceMgr.isBeforeInTranslationUnit(Headers[1], Nested));
+  EXPECT_TRUE(SourceMgr.isBeforeInTranslationUnit(MainLoc, Nested));
+  EXPECT_FALSE(SourceMgr.isBeforeInTranslationUnit(
+                 MainLoc.getLocWithOffset(2), Nested));
+
+  // A location at the #include comes before the included file.
+  EXPECT_TRUE(SourceMgr.isBeforeInTranslationUnit(MainLoc.getLocWithOffset(1),
+                                                  Nested));
+}
+
+
+TEST_F(SourceManagerTest, releaseFileBuffer) {
+  // A file large enough to be mapped rather than read, whose size is not a
+  // multiple of the page size.
+  std::string ErrorInfo;
+  llvm::sys::Path Dir = llvm::sys::Path::GetTemporaryDirectory(&ErrorInfo);
+  ASSERT_TRUE(ErrorInfo.empty());
+  SmallString<128> Path(Dir.str());
+  llvm::sys::path::append(Path, "large.h");
+  std::string Contents;
+  for (unsigned I = 0; I != 2000; ++I)
+    Contents += "int filler;\n";
+  Contents += "int last;\n";
+  {
+    llvm::raw_fd_ostream OS(Path.c_str(), ErrorInfo,
+                            llvm::raw_fd_ostream::F_Binary);
+    ASSERT_TRUE(ErrorInfo.empty());
+    OS << Contents;
+  }
+
+  const FileEntry *File = FileMgr.getFile(Path);
+  ASSERT_TRUE(File != 0);
+  FileID FID = SourceMgr.createMainFileID(File);
+  const char *Start = SourceMgr.getBuffer(FID)->getBufferStart();
+  EXPECT_EQ(Contents, SourceMgr.getBufferData(FID).str());
+
+  // Released buffers stay where they were and read back the same contents.
+  SourceMgr.releaseFileBuffer(FID);
+  EXPECT_EQ(Start, SourceMgr.getBuffer(FID)->getBufferStart());
+  EXPECT_EQ(Contents, SourceMgr.getBufferData(FID).str());
+  SourceLocation Last = SourceMgr.getLocForEndOfFile(FID).getLocWithOffset(-10);
+  EXPECT_EQ(0, strcmp(SourceMgr.getCharacterData(Last), "int last;\n"));
+
+  Dir.eraseFromDisk(true);
+}
+
 #endif
 
 } // anonymous namespace
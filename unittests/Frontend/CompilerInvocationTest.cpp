@@ -0,0 +1,105 @@
+//===- unittests/Frontend/CompilerInvocationTest.cpp - Invocation tests ---===//
+//
+//                     The LLVM Compiler Infrastructure
+//
+// This file is distributed under the University of Illinois Open Source
+// License. See LICENSE.TXT for details.
+//
+//===----------------------------------------------------------------------===//
+
+#include "clang/Basic/Diagnostic.h"
+#include "clang/Basic/DiagnosticIDs.h"
+#include "clang/Frontend/CompilerInvocation.h"
+
+#include "llvm/ADT/OwningPtr.h"
+#include "llvm/ADT/SmallString.h"
+#include "llvm/Support/MemoryBuffer.h"
+
+#include "gtest/gtest.h"
+
+using namespace llvm;
+using namespace clang;
+
+namespace {
+
+class CompilerInvocationTest : public ::testing::Test {
+protected:
+  CompilerInvocationTest()
+    : DiagID(new DiagnosticIDs()),
+      Diags(DiagID, new IgnoringDiagConsumer()) {}
+
+  bool createFromArgs(CompilerInvocation &Invocation,
+                      const char *const *Args, unsigned NumArgs) {
+    return CompilerInvocation::CreateFromArgs(Invocation, Args,
+                                              Args + NumArgs, Diags);
+  }
+
+  IntrusiveRefCntPtr<DiagnosticIDs> DiagID;
+  DiagnosticsEngine Diags;
+};
+
+TEST_F(CompilerInvocationTest, RoundTrip) {
+  const char *Args[] = {
+    "-triple", "x86_64-unknown-linux-gnu", "-emit-obj", "-O2",
+    "-std=c++11", "-fexceptions", "-DFOO=1", "-UBAR", "-I", "include",
+    "-isystem", "sys", "-Wall", "-ferror-limit", "7",
+    "-analyzer-config", "ipa=dynamic", "-fno-dwarf2-cfi-asm",
+    "-o", "out.o", "in.cpp"
+  };
+  CompilerInvocation Original;
+  ASSERT_TRUE(createFromArgs(Original, Args, sizeof(Args) / sizeof(*Args)));
+
+  SmallString<256> Data;
+  ASSERT_TRUE(Original.serialize(Data));
+
+  CompilerInvocation Loaded;
+  ASSERT_TRUE(CompilerInvocation::deserialize(Loaded, Data));
+
+  std::vector<std::string> OriginalArgs, LoadedArgs;
+  Original.toArgs(OriginalArgs);
+  Loaded.toArgs(LoadedArgs);
+  EXPECT_EQ(OriginalArgs, LoadedArgs);
+
+  EXPECT_EQ("x86_64-unknown-linux-gnu", Loaded.getTargetOpts().Triple);
+  EXPECT_EQ(2U, Loaded.getCodeGenOpts().OptimizationLevel);
+  EXPECT_TRUE(Loaded.getCodeGenOpts().NoDwarf2CFIAsm);
+  EXPECT_TRUE(Loaded.getLangOpts()->CPlusPlus0x);
+  EXPECT_EQ(7U, Loaded.getDiagnosticOpts().ErrorLimit);
+  ASSERT_EQ(1U, Loaded.getFrontendOpts().Inputs.size());
+  EXPECT_EQ("in.cpp", Loaded.getFrontendOpts().Inputs[0].File);
+  EXPECT_EQ("dynamic", Loaded.getAnalyzerOpts()->Config["ipa"]);
+  EXPECT_NE(Original.getLangOpts(), Loaded.getLangOpts());
+
+  // Serializing the loaded invocation gives back the same bytes.
+  SmallString<256> Again;
+  ASSERT_TRUE(Loaded.serialize(Again));
+  EXPECT_EQ(Data.str(), Again.str());
+}
+
+TEST_F(CompilerInvocationTest, RejectsCorruptData) {
+  CompilerInvocation Original;
+  Original.getFrontendOpts().OutputFile = "out.o";
+  SmallString<256> Data;
+  ASSERT_TRUE(Original.serialize(Data));
+
+  CompilerInvocation Loaded;
+  EXPECT_FALSE(CompilerInvocation::deserialize(Loaded, ""));
+  EXPECT_FALSE(CompilerInvocation::deserialize(Loaded,
+                                               Data.str().drop_back()));
+  std::string Longer = Data.str().str() + "x";
+  EXPECT_FALSE(CompilerInvocation::deserialize(Loaded, Longer));
+  std::string BadMagic = Data.str().str();
+  BadMagic[0] = 'X';
+  EXPECT_FALSE(CompilerInvocation::deserialize(Loaded, BadMagic));
+}
+
+TEST_F(CompilerInvocationTest, RefusesRemappedBuffers) {
+  CompilerInvocation Invocation;
+  OwningPtr<MemoryBuffer> Buffer(MemoryBuffer::getMemBuffer("int x;"));
+  Invocation.getPreprocessorOpts().addRemappedFile("test.c", Buffer.get());
+  SmallString<256> Data;
+  EXPECT_FALSE(Invocation.serialize(Data));
+  Invocation.getPreprocessorOpts().clearRemappedFiles();
+}
+
+} // anonymous namespace
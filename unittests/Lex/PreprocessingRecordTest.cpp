@@ -136,4 +136,63 @@ TEST_F(PreprocessingRecordTest, PPRecAPI) {
                     toks[5].getLocation(), toks[1].getLocation()));
 }
 
+TEST_F(PreprocessingRecordTest, MacroExpansions) {
+  const char *source =
+      "#define M(x) x\n"
+      "int a = M(1);\n"
+      "int b = __LINE__;\n"
+      "int c = M(M(2));\n";
+
+  MemoryBuffer *buf = MemoryBuffer::getMemBuffer(source);
+  FileID mainFileID = SourceMgr.createMainFileIDForMemBuffer(buf);
+
+  VoidModuleLoader ModLoader;
+  HeaderSearch HeaderInfo(FileMgr, Diags, LangOpts, Target.getPtr());
+  Preprocessor PP(Diags, LangOpts,
+                  Target.getPtr(),
+                  SourceMgr, HeaderInfo, ModLoader,
+                  /*IILookup =*/ 0,
+                  /*OwnsHeaderSearch =*/false,
+                  /*DelayInitialization =*/ false);
+  PP.createPreprocessingRecord(false);
+  PP.EnterMainSourceFile();
+
+  std::vector<Token> toks;
+  while (1) {
+    Token tok;
+    PP.Lex(tok);
+    if (tok.is(tok::eof))
+      break;
+    toks.push_back(tok);
+  }
+  ASSERT_EQ(15U, toks.size());
+
+  // The definition of M and its three outermost expansions; the expansion
+  // of M within the argument of M is not recorded.
+  PreprocessingRecord &PPRec = *PP.getPreprocessingRecord();
+  ASSERT_EQ(4, PPRec.local_end() - PPRec.local_begin());
+  MacroDefinition *Def = dyn_cast<MacroDefinition>(*PPRec.local_begin());
+  ASSERT_TRUE(Def != 0);
+
+  SourceLocation Start = SourceMgr.getLocForStartOfFile(mainFileID);
+  std::pair<PreprocessingRecord::iterator, PreprocessingRecord::iterator>
+    Range = PPRec.getPreprocessedEntitiesInRange(
+              SourceRange(Start.getLocWithOffset(16),
+                          Start.getLocWithOffset(47)));
+  ASSERT_EQ(2, Range.second - Range.first);
+
+  MacroExpansion *First = dyn_cast<MacroExpansion>(*Range.first);
+  ASSERT_TRUE(First != 0);
+  EXPECT_EQ(Def, First->getDefinition());
+  EXPECT_EQ(Start.getLocWithOffset(23), First->getSourceRange().getBegin());
+  EXPECT_EQ(Start.getLocWithOffset(26), First->getSourceRange().getEnd());
+  EXPECT_EQ(First, *Range.first);
+
+  MacroExpansion *Second = dyn_cast<MacroExpansion>(*(Range.first + 1));
+  ASSERT_TRUE(Second != 0);
+  EXPECT_TRUE(Second->isBuiltinMacro());
+  EXPECT_TRUE(Second->getName()->isStr("__LINE__"));
+  EXPECT_TRUE(PPRec.isEntityInFileID(Range.first + 1, mainFileID));
+}
+
 } // anonymous namespace
@@ -147,6 +147,33 @@ TEST(findCompileArgsInJsonDatabase, ReadsDirectoryWithSpaces) {
   EXPECT_EQ(Directory, FoundCommand.Directory) << ErrorMessage;
 }
 
+TEST(findCompileArgsInJsonDatabase, UnescapesDirectory) {
+  StringRef FileName("/path/to/a-file.cpp");
+  std::string ErrorMessage;
+  CompileCommand FoundCommand = findCompileArgsInJsonDatabase(
+    FileName,
+    "[{\"directory\":\"/a\\\\b\\/c\\u0020d\\td\","
+      "\"command\":\"a command\","
+      "\"file\":\"/path\\/to/a-file.cpp\"}]",
+    ErrorMessage);
+  EXPECT_EQ("/a\\b/c d\td", FoundCommand.Directory) << ErrorMessage;
+}
+
+TEST(findCompileArgsInJsonDatabase, ReadsNonJSONYAML) {
+  StringRef FileName("/path/to/a-file.cpp");
+  std::string ErrorMessage;
+  CompileCommand FoundCommand = findCompileArgsInJsonDatabase(
+    FileName,
+    "- directory: /some/directory\n"
+    "  command: a \"quoted \\\\ command\"\n"
+    "  file: /path/to/a-file.cpp\n",
+    ErrorMessage);
+  EXPECT_EQ("/some/directory", FoundCommand.Directory) << ErrorMessage;
+  ASSERT_EQ(2u, FoundCommand.CommandLine.size()) << ErrorMessage;
+  EXPECT_EQ("a", FoundCommand.CommandLine[0]);
+  EXPECT_EQ("quoted \\ command", FoundCommand.CommandLine[1]);
+}
+
 TEST(findCompileArgsInJsonDatabase, FindsEntry) {
   StringRef Directory("directory");
   StringRef FileName("file");
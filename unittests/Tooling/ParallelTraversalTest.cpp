@@ -0,0 +1,112 @@
+//===- unittest/Tooling/ParallelTraversalTest.cpp -------------------------===//
+//
+//                     The LLVM Compiler Infrastructure
+//
+// This file is distributed under the University of Illinois Open Source
+// License. See LICENSE.TXT for details.
+//
+//===----------------------------------------------------------------------===//
+
+#include "clang/AST/ASTConsumer.h"
+#include "clang/AST/ASTContext.h"
+#include "clang/AST/RecursiveASTVisitor.h"
+#include "clang/Frontend/FrontendAction.h"
+#include "clang/Tooling/ParallelTraversal.h"
+#include "clang/Tooling/Tooling.h"
+#include "gtest/gtest.h"
+#include <string>
+#include <vector>
+
+namespace clang {
+namespace tooling {
+
+namespace {
+/// Counts the variables it visits and adds up the sizes of their types.
+class VarSizeVisitor : public RecursiveASTVisitor<VarSizeVisitor> {
+public:
+  VarSizeVisitor() : Context(0), NumVars(0), TotalSize(0) {}
+  bool VisitVarDecl(VarDecl *D) {
+    ++NumVars;
+    if (!D->getType()->isIncompleteType())
+      TotalSize += Context->getTypeSize(D->getType());
+    return true;
+  }
+  ASTContext *Context;
+  unsigned NumVars;
+  uint64_t TotalSize;
+};
+
+/// Traverses the translation unit serially and in parallel.
+class CompareTraversalsConsumer : public ASTConsumer {
+public:
+  CompareTraversalsConsumer(unsigned NumPartitions, bool *Same)
+    : NumPartitions(NumPartitions), Same(Same) {}
+
+  virtual void HandleTranslationUnit(ASTContext &Context) {
+    VarSizeVisitor Serial;
+    Serial.Context = &Context;
+    Serial.TraverseDecl(Context.getTranslationUnitDecl());
+
+    std::vector<VarSizeVisitor> Visitors(NumPartitions);
+    for (unsigned I = 0; I != NumPartitions; ++I)
+      Visitors[I].Context = &Context;
+    bool Success = traverseTranslationUnitInParallel(Context, &Visitors[0],
+                                                     NumPartitions);
+    unsigned NumVars = 0;
+    uint64_t TotalSize = 0;
+    for (unsigned I = 0; I != NumPartitions; ++I) {
+      NumVars += Visitors[I].NumVars;
+      TotalSize += Visitors[I].TotalSize;
+    }
+    *Same = Success && Serial.NumVars != 0 && NumVars == Serial.NumVars &&
+            TotalSize == Serial.TotalSize && !Context.allowsConcurrentReaders();
+  }
+
+private:
+  unsigned NumPartitions;
+  bool *Same;
+};
+
+class CompareTraversalsAction : public ASTFrontendAction {
+public:
+  CompareTraversalsAction(unsigned NumPartitions, bool *Same)
+    : NumPartitions(NumPartitions), Same(Same) {}
+
+protected:
+  virtual ASTConsumer *CreateASTConsumer(CompilerInstance &, StringRef) {
+    return new CompareTraversalsConsumer(NumPartitions, Same);
+  }
+
+private:
+  unsigned NumPartitions;
+  bool *Same;
+};
+} // end namespace
+
+static std::string getManyRecords() {
+  std::string Code;
+  for (char Name = 'a'; Name <= 'z'; ++Name) {
+    std::string Record = std::string("R") + Name;
+    Code += "struct " + Record + " { int i; double d[" +
+            std::string(1, Name) + "_n]; };\n";
+    Code.insert(0, std::string("enum { ") + Name + "_n = 3 };\n");
+    Code += Record + " v_" + Name + ";\n";
+    Code += "void f_" + std::string(1, Name) + "(" + Record + " *r) {\n"
+            "  " + Record + " local = *r; (void)local;\n}\n";
+  }
+  return Code;
+}
+
+TEST(ParallelTraversal, VisitsTheSameDeclsAsASerialTraversal) {
+  std::string Code = getManyRecords();
+  unsigned Partitions[] = { 1, 2, 3, 7, 200 };
+  for (unsigned I = 0; I != sizeof(Partitions) / sizeof(Partitions[0]); ++I) {
+    bool Same = false;
+    EXPECT_TRUE(runToolOnCode(
+      new CompareTraversalsAction(Partitions[I], &Same), Code));
+    EXPECT_TRUE(Same) << Partitions[I] << " partitions";
+  }
+}
+
+} // end namespace tooling
+} // end namespace clang
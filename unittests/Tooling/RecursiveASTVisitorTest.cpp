@@ -78,6 +78,27 @@ public:
   }
 };
 
+class StmtCountingVisitor : public TestVisitor<StmtCountingVisitor> {
+public:
+  StmtCountingVisitor() : NumVisited(0) {}
+  bool VisitStmt(Stmt *S) {
+    ++NumVisited;
+    return true;
+  }
+  unsigned NumVisited;
+};
+
+class StmtCountingTraverser : public TestVisitor<StmtCountingTraverser> {
+public:
+  StmtCountingTraverser() : NumTraversed(0) {}
+  bool TraverseStmt(Stmt *S) {
+    if (S)
+      ++NumTraversed;
+    return TestVisitor<StmtCountingTraverser>::TraverseStmt(S);
+  }
+  unsigned NumTraversed;
+};
+
 class TemplateArgumentLocTraverser
   : public ExpectedLocationVisitor<TemplateArgumentLocTraverser> {
 public:
@@ -331,6 +352,30 @@ TEST(RecursiveASTVisitor, VisitsParensDuringDataRecursion) {
   EXPECT_TRUE(Visitor.runOver("int k = (4) + 9;\n"));
 }
 
+TEST(RecursiveASTVisitor, VisitsNestedStatementsDuringDataRecursion) {
+  ParenExprVisitor Visitor;
+  Visitor.ExpectMatch("", 2, 36);
+  EXPECT_TRUE(Visitor.runOver(
+    "int f(int *p, int i) {\n"
+    "  if (i) { return i ? p[(i)] : -(p[(i + 1)]); } else if (!i) {}\n"
+    "  return 0;\n"
+    "}\n"));
+}
+
+TEST(RecursiveASTVisitor, TraversesAllStatementsThroughTraverseStmt) {
+  const char *Code =
+    "int f(int *p, int i) {\n"
+    "  if (i) { return i ? p[(i)] : -(p[(i + 1)]); } else if (!i) {}\n"
+    "  return 0;\n"
+    "}\n";
+  StmtCountingVisitor Visitor;
+  EXPECT_TRUE(Visitor.runOver(Code));
+  StmtCountingTraverser Traverser;
+  EXPECT_TRUE(Traverser.runOver(Code));
+  EXPECT_NE(0u, Visitor.NumVisited);
+  EXPECT_EQ(Visitor.NumVisited, Traverser.NumTraversed);
+}
+
 TEST(RecursiveASTVisitor, VisitsClassTemplateNonTypeParmDefaultArgument) {
   CXXBoolLiteralExprVisitor Visitor;
   Visitor.ExpectMatch("true", 2, 19);
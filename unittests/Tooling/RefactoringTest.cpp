@@ -151,6 +151,78 @@ TEST_F(ReplacementTest, ApplyAllFailsIfOneApplyFails) {
   EXPECT_EQ("z", Context.getRewrittenText(IDz));
 }
 
+TEST(ApplyReplacementsToCode, AppliesInOrder) {
+  Replacements Replaces;
+  Replaces.insert(Replacement("input.cpp", 6, 5, "replaced"));
+  Replaces.insert(Replacement("input.cpp", 0, 0, "first\n"));
+  Replaces.insert(Replacement("input.cpp", 18, 5, ""));
+  std::string Result;
+  EXPECT_EQ(0u, applyReplacementsToCode("line1\nline2\nline3\nline4",
+                                        Replaces.begin(), Replaces.end(),
+                                        Result));
+  EXPECT_EQ("first\nline1\nreplaced\nline3\n", Result);
+}
+
+TEST(ApplyReplacementsToCode, InsertsAtSameOffset) {
+  Replacements Replaces;
+  Replaces.insert(Replacement("input.cpp", 2, 0, "a"));
+  Replaces.insert(Replacement("input.cpp", 2, 0, "b"));
+  Replaces.insert(Replacement("input.cpp", 2, 1, "c"));
+  std::string Result;
+  EXPECT_EQ(0u, applyReplacementsToCode("xxyy", Replaces.begin(),
+                                        Replaces.end(), Result));
+  EXPECT_EQ("xxabcy", Result);
+}
+
+TEST(ApplyReplacementsToCode, SkipsConflictingReplacements) {
+  Replacements Replaces;
+  Replaces.insert(Replacement("input.cpp", 0, 3, "a"));
+  Replaces.insert(Replacement("input.cpp", 2, 2, "b"));
+  Replaces.insert(Replacement("input.cpp", 4, 1, "c"));
+  Replaces.insert(Replacement("input.cpp", 6, 1, "d"));
+  std::string Result;
+  EXPECT_EQ(2u, applyReplacementsToCode("012345", Replaces.begin(),
+                                        Replaces.end(), Result));
+  EXPECT_EQ("a3c5", Result);
+}
+
+TEST(WriteReplacements, ReadsBackAndMerges) {
+  Replacements Shard1;
+  Shard1.insert(Replacement("/a.cc", 3, 1, "x\ny"));
+  Shard1.insert(Replacement("/h.h", 0, 2, ""));
+  Replacements Shard2;
+  Shard2.insert(Replacement("/b.cc", 7, 0, "R 1 2 3 4\n"));
+  Shard2.insert(Replacement("/h.h", 0, 2, ""));
+
+  std::string Data;
+  llvm::raw_string_ostream OS(Data);
+  writeReplacements(Shard1, OS);
+  writeReplacements(Shard2, OS);
+  OS.flush();
+
+  Replacements Merged;
+  EXPECT_TRUE(readReplacements(Data, Merged));
+  ASSERT_EQ(4u, Merged.size());
+  Replacements::const_iterator I = Merged.begin();
+  EXPECT_EQ("/a.cc", I->getFilePath());
+  EXPECT_EQ(3u, I->getOffset());
+  EXPECT_EQ(1u, I->getLength());
+  EXPECT_EQ("x\ny", I->getReplacementText());
+  ++I;
+  EXPECT_EQ("R 1 2 3 4\n", I->getReplacementText());
+  ++I;
+  EXPECT_EQ("/h.h", I->getFilePath());
+}
+
+TEST(WriteReplacements, RejectsMalformedData) {
+  Replacements Replaces;
+  EXPECT_FALSE(readReplacements("R 0 0 5 0\nabc\n", Replaces));
+  EXPECT_FALSE(readReplacements("R 0 0\n", Replaces));
+  EXPECT_FALSE(readReplacements("R 0 0 1 1\nabc", Replaces));
+  EXPECT_TRUE(Replaces.empty());
+  EXPECT_TRUE(readReplacements("", Replaces));
+}
+
 class FlushRewrittenFilesTest : public ::testing::Test {
  public:
   FlushRewrittenFilesTest() {
@@ -205,6 +277,47 @@ TEST_F(FlushRewrittenFilesTest, StoresChangesOnDisk) {
             getFileContentFromDisk("input.cpp"));
 }
 
+TEST_F(FlushRewrittenFilesTest, AppliesReplacementsToFilesOnDisk) {
+  FileID ID1 = createFile("input1.cpp", "line1\nline2\nline3\nline4");
+  FileID ID2 = createFile("input2.cpp", "text");
+  Replacements Replaces;
+  Replaces.insert(Replacement(Context.Sources, Context.getLocation(ID1, 2, 1),
+                              5, "replaced"));
+  Replaces.insert(Replacement(Context.Sources, Context.getLocation(ID1, 3, 1),
+                              5, "other"));
+  Replaces.insert(Replacement(Context.Sources, Context.getLocation(ID2, 1, 1),
+                              4, "changed"));
+  EXPECT_TRUE(applyAllReplacementsToFiles(Replaces, 2));
+  EXPECT_EQ("line1\nreplaced\nother\nline4",
+            getFileContentFromDisk("input1.cpp"));
+  EXPECT_EQ("changed", getFileContentFromDisk("input2.cpp"));
+}
+
+TEST_F(FlushRewrittenFilesTest, AppliesOtherFilesIfOneFails) {
+  FileID ID = createFile("input.cpp", "text");
+  Replacements Replaces;
+  Replaces.insert(Replacement(Context.Sources, SourceLocation(), 5, "2"));
+  Replaces.insert(Replacement(Context.Sources, Context.getLocation(ID, 1, 1),
+                              4, "changed"));
+  EXPECT_FALSE(applyAllReplacementsToFiles(Replaces));
+  EXPECT_EQ("changed", getFileContentFromDisk("input.cpp"));
+}
+
+TEST_F(FlushRewrittenFilesTest, AppliesNonConflictingReplacements) {
+  FileID ID = createFile("input.cpp", "line1\nline2\nline3\nline4");
+  Replacements Replaces;
+  Replaces.insert(Replacement(Context.Sources, Context.getLocation(ID, 1, 1),
+                              11, "both"));
+  Replaces.insert(Replacement(Context.Sources, Context.getLocation(ID, 2, 1),
+                              5, "conflict"));
+  Replaces.insert(Replacement(Context.Sources, Context.getLocation(ID, 4, 1),
+                              5, "last"));
+  bool Saved = false;
+  EXPECT_FALSE(applyAllReplacementsToFiles(Replaces, 1, &Saved));
+  EXPECT_TRUE(Saved);
+  EXPECT_EQ("both\nline3\nlast", getFileContentFromDisk("input.cpp"));
+}
+
 namespace {
 template <typename T>
 class TestVisitor : public clang::RecursiveASTVisitor<T> {
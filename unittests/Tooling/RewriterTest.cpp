@@ -8,6 +8,7 @@
 //===----------------------------------------------------------------------===//
 
 #include "RewriterTestContext.h"
+#include "llvm/ADT/StringExtras.h"
 #include "gtest/gtest.h"
 
 namespace clang {
@@ -34,4 +35,27 @@ TEST(Rewriter, ContinuesOverwritingFilesOnError) {
             Context.getFileContentFromDisk("working.cpp")); 
 }
 
+TEST(Rewriter, InsertsTextAtAdvancingOffsets) {
+  RewriterTestContext Context;
+  FileID ID = Context.createInMemoryFile("input.cpp", "begin\nend");
+  SourceLocation End = Context.getLocation(ID, 2, 1);
+  std::string Expected = "begin\n";
+  for (unsigned I = 0; I != 100; ++I) {
+    std::string Line = "line" + llvm::utostr(I) + "\n";
+    Context.Rewrite.InsertTextAfter(End, Line);
+    Expected += Line;
+  }
+  Expected += "end";
+  EXPECT_EQ(Expected, Context.getRewrittenText(ID));
+
+  // Splitting and erasing text inserted that way keeps the rest intact.
+  Context.Rewrite.InsertTextBefore(End, "first\n");
+  Context.Rewrite.ReplaceText(Context.getLocation(ID, 1, 1), 5, "BEGIN");
+  Context.Rewrite.RemoveText(End, 3);
+  Expected.replace(0, 5, "BEGIN");
+  Expected.insert(6, "first\n");
+  Expected.erase(Expected.size() - 3);
+  EXPECT_EQ(Expected, Context.getRewrittenText(ID));
+}
+
 } // end namespace clang
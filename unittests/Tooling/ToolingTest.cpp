@@ -14,6 +14,9 @@
 #include "clang/Frontend/FrontendActions.h"
 #include "clang/Tooling/CompilationDatabase.h"
 #include "clang/Tooling/Tooling.h"
+#include "llvm/Support/FileSystem.h"
+#include "llvm/Support/Path.h"
+#include "llvm/Support/raw_ostream.h"
 #include "gtest/gtest.h"
 #include <string>
 
@@ -130,5 +133,166 @@ TEST(ToolInvocation, TestMapVirtualFile) {
   EXPECT_TRUE(Invocation.run());
 }
 
+static int runClangToolOnMappedFiles(unsigned NumThreads) {
+  FixedCompilationDatabase Compilations("/", std::vector<std::string>());
+  std::vector<std::string> Sources;
+  Sources.push_back("/a.cc");
+  Sources.push_back("/b.cc");
+  Sources.push_back("/c.cc");
+  ClangTool Tool(Compilations, Sources);
+  Tool.setNumThreads(NumThreads);
+  Tool.mapVirtualFile("/a.cc", "int a;\n");
+  Tool.mapVirtualFile("/b.cc", "#include \"b.h\"\nint b = B;\n");
+  Tool.mapVirtualFile("/b.h", "#define B 1\n");
+  Tool.mapVirtualFile("/c.cc", "int c;\n");
+  llvm::OwningPtr<FrontendActionFactory> Factory(
+    newFrontendActionFactory<SyntaxOnlyAction>());
+  return Tool.run(Factory.get());
+}
+
+TEST(ClangTool, RunsSeriallyAndInParallel) {
+  EXPECT_EQ(0, runClangToolOnMappedFiles(1));
+  EXPECT_EQ(0, runClangToolOnMappedFiles(2));
+  EXPECT_EQ(0, runClangToolOnMappedFiles(0));
+}
+
+TEST(ClangTool, ReportsFailureInParallel) {
+  FixedCompilationDatabase Compilations("/", std::vector<std::string>());
+  std::vector<std::string> Sources;
+  Sources.push_back("/ok.cc");
+  Sources.push_back("/broken.cc");
+  ClangTool Tool(Compilations, Sources);
+  Tool.setNumThreads(2);
+  Tool.mapVirtualFile("/ok.cc", "int a;\n");
+  Tool.mapVirtualFile("/broken.cc", "int b = ;\n");
+  llvm::OwningPtr<FrontendActionFactory> Factory(
+    newFrontendActionFactory<SyntaxOnlyAction>());
+  EXPECT_EQ(1, Tool.run(Factory.get()));
+}
+
+namespace {
+/// Counts the translation units processed.
+struct TranslationUnitCounter {
+  unsigned Count;
+  ASTConsumer *newASTConsumer() {
+    ++Count;
+    return new ASTConsumer;
+  }
+};
+} // end namespace
+
+static unsigned countTranslationUnitsInShard(unsigned Index, unsigned Count) {
+  FixedCompilationDatabase Compilations("/", std::vector<std::string>());
+  std::vector<std::string> Sources;
+  for (char Name = 'a'; Name != 'k'; ++Name) {
+    std::string Source = std::string("/") + Name + ".cc";
+    Sources.push_back(Source);
+  }
+  ClangTool Tool(Compilations, Sources);
+  Tool.setShard(Index, Count);
+  for (unsigned I = 0, E = Sources.size(); I != E; ++I)
+    Tool.mapVirtualFile(Sources[I], "int i;\n");
+  TranslationUnitCounter Counter;
+  Counter.Count = 0;
+  llvm::OwningPtr<FrontendActionFactory> Factory(
+    newFrontendActionFactory(&Counter));
+  EXPECT_EQ(0, Tool.run(Factory.get()));
+  return Counter.Count;
+}
+
+TEST(ClangTool, ProcessesEveryFileInExactlyOneShard) {
+  EXPECT_EQ(10u, countTranslationUnitsInShard(0, 1));
+  unsigned Total = 0;
+  for (unsigned Index = 0; Index != 3; ++Index)
+    Total += countTranslationUnitsInShard(Index, 3);
+  EXPECT_EQ(10u, Total);
+}
+
+namespace {
+/// Records where the class X was seen.
+struct ClassXFinder {
+  bool InTopLevelDecl;
+  bool InTranslationUnit;
+
+  class Consumer : public clang::ASTConsumer {
+   public:
+    explicit Consumer(ClassXFinder *Finder) : Finder(Finder) {}
+    virtual bool HandleTopLevelDecl(clang::DeclGroupRef GroupRef) {
+      for (DeclGroupRef::iterator I = GroupRef.begin(), E = GroupRef.end();
+           I != E; ++I)
+        if (isClassX(*I))
+          Finder->InTopLevelDecl = true;
+      return true;
+    }
+    virtual void HandleTranslationUnit(clang::ASTContext &Context) {
+      TranslationUnitDecl *TU = Context.getTranslationUnitDecl();
+      for (DeclContext::decl_iterator I = TU->decls_begin(),
+                                      E = TU->decls_end();
+           I != E; ++I)
+        if (isClassX(*I))
+          Finder->InTranslationUnit = true;
+    }
+   private:
+    static bool isClassX(Decl *D) {
+      CXXRecordDecl *Record = dyn_cast<CXXRecordDecl>(D);
+      return Record && Record->getName() == "X";
+    }
+    ClassXFinder *Finder;
+  };
+
+  ASTConsumer *newASTConsumer() { return new Consumer(this); }
+};
+} // end namespace
+
+static unsigned countFilesIn(StringRef Directory) {
+  unsigned Count = 0;
+  llvm::error_code EC;
+  for (llvm::sys::fs::directory_iterator I(Directory, EC), E; !EC && I != E;
+       I.increment(EC))
+    ++Count;
+  return Count;
+}
+
+TEST(ClangTool, ReusesSavedASTs) {
+  std::string ErrorInfo;
+  llvm::sys::Path TemporaryDirectory =
+    llvm::sys::Path::GetTemporaryDirectory(&ErrorInfo);
+  ASSERT_TRUE(ErrorInfo.empty());
+  llvm::SmallString<1024> Source(TemporaryDirectory.str());
+  llvm::sys::path::append(Source, "x.cc");
+  {
+    llvm::raw_fd_ostream OutStream(Source.c_str(), ErrorInfo);
+    ASSERT_TRUE(ErrorInfo.empty());
+    OutStream << "struct X {};\n";
+  }
+  llvm::SmallString<1024> Cache(TemporaryDirectory.str());
+  llvm::sys::path::append(Cache, "cache");
+
+  FixedCompilationDatabase Compilations(TemporaryDirectory.str(),
+                                        std::vector<std::string>());
+  ClangTool Tool(Compilations, std::vector<std::string>(1, Source.str()));
+  Tool.setASTCacheDirectory(Cache);
+  ClassXFinder Finder;
+  llvm::OwningPtr<FrontendActionFactory> Factory(
+    newFrontendActionFactory(&Finder));
+
+  // The first run parses the file and saves its AST.
+  Finder.InTopLevelDecl = Finder.InTranslationUnit = false;
+  EXPECT_EQ(0, Tool.run(Factory.get()));
+  EXPECT_TRUE(Finder.InTopLevelDecl);
+  EXPECT_TRUE(Finder.InTranslationUnit);
+  EXPECT_EQ(1u, countFilesIn(Cache));
+
+  // The second run loads the AST, whose records are only deserialized when
+  // the consumer asks for them.
+  Finder.InTopLevelDecl = Finder.InTranslationUnit = false;
+  EXPECT_EQ(0, Tool.run(Factory.get()));
+  EXPECT_FALSE(Finder.InTopLevelDecl);
+  EXPECT_TRUE(Finder.InTranslationUnit);
+  EXPECT_EQ(1u, countFilesIn(Cache));
+
+  TemporaryDirectory.eraseFromDisk(true, &ErrorInfo);
+}
+
 } // end namespace tooling
 } // end namespace clang
@@ -790,7 +790,11 @@ void EmitClangAttrImpl(RecordKeeper &Records, raw_ostream &OS) {
 
     OS << "void " << R.getName() << "Attr::printPretty("
        << "llvm::raw_ostream &OS, const PrintingPolicy &Policy) const {\n";
-    if (Spellings.begin() != Spellings.end()) {
+    if (Spellings.begin() != Spellings.end() &&
+        (*Spellings.begin())->getValueAsString("Variety") == "Pragma") {
+      // Pragmas print their options themselves.
+      OS << "  printPrettyPragma(OS, Policy);\n";
+    } else if (Spellings.begin() != Spellings.end()) {
       std::string Spelling = (*Spellings.begin())->getValueAsString("Name");
       OS << "  OS << \" __attribute__((" << Spelling;
       if (Args.size()) OS << "(";
@@ -968,6 +972,9 @@ void EmitClangAttrSpellingList(RecordKeeper &Records, raw_ostream &OS) {
     std::vector<Record*> Spellings = Attr.getValueAsListOfDefs("Spellings");
 
     for (std::vector<Record*>::const_iterator I = Spellings.begin(), E = Spellings.end(); I != E; ++I) {
+      // Pragmas are not attributes that __has_attribute can find.
+      if ((*I)->getValueAsString("Variety") == "Pragma")
+        continue;
       OS << ".Case(\"" << (*I)->getValueAsString("Name") << "\", true)\n";
     }
   }
@@ -1142,6 +1149,11 @@ void EmitClangAttrParsedAttrKinds(RecordKeeper &Records, raw_ostream &OS) {
         if ((*I)->getValueAsString("Variety") == "CXX11") {
           Spelling += (*I)->getValueAsString("Namespace");
           Spelling += "::";
+        } else if ((*I)->getValueAsString("Variety") == "Pragma") {
+          // Keyed as the directive, which no other spelling can collide with.
+          Spelling += "#pragma ";
+          Spelling += (*I)->getValueAsString("Namespace");
+          Spelling += " ";
         }
         Spelling += NormalizeAttrSpelling(RawSpelling);
 
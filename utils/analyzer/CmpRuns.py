@@ -26,10 +26,15 @@ Usage:
     # Generate a relation from diagnostics in run A to diagnostics in run B 
     # to obtain a list of triples (a, b, confidence). 
     diff = compareResults(resultsA, resultsB)
+
+    # Compare the per-TU benchmark records of two runs made in benchmark mode
+    # (see SATestBuild.py) and print the performance regressions.
+    numRegressions = dumpBenchmarkDiff(fileA, fileB)
            
 """
 
 import os
+import csv
 import plistlib
 
 #
@@ -262,6 +267,100 @@ def dumpScanBuildResultsDiff(dirA, dirB, opts, deleteEmpty=True):
         
     return foundDiffs    
 
+#
+# Benchmark comparison.
+#
+
+# The metrics recorded per TU in benchmark mode: (name, unit, whether a
+# larger value is worse). Time and memory are noisy, so they are only
+# flagged when they move by more than the threshold and above a floor; the
+# node rate uses the floor of the wall time.
+BenchmarkMetrics = [("WallTime", "s", True),
+                    ("PeakRSS", "KB", True),
+                    ("Nodes", "", True),
+                    ("NodesPerSecond", "", False)]
+BenchmarkFloors = {"WallTime" : 0.1, "PeakRSS" : 1024}
+
+# The statistics that are only summed up and printed, never flagged.
+BenchmarkTotals = ["Steps", "InlinedCalls", "CallsOverInliningBudget",
+                   "FunctionsAnalyzed", "ReachedMaxSteps", "ReclaimedNodes"]
+
+def loadBenchmark(path):
+    results = {}
+    f = open(path, "rb")
+    try:
+        for row in csv.DictReader(f):
+            record = {}
+            for key, value in row.items():
+                if key != "File":
+                    record[key] = float(value)
+            results[row["File"]] = record
+    finally:
+        f.close()
+    return results
+
+def isBenchmarkRegression(name, worseIfLarger, a, b, threshold):
+    floorName = name
+    if name == "NodesPerSecond":
+        floorName = "WallTime"
+    if floorName in BenchmarkFloors and \
+       max(a[floorName], b[floorName]) < BenchmarkFloors[floorName]:
+        return False
+    valueA = a[name]
+    valueB = b[name]
+    if not worseIfLarger:
+        valueA, valueB = valueB, valueA
+    if valueA == 0:
+        return valueB > 0 and floorName not in BenchmarkFloors
+    return (valueB - valueA) / valueA > threshold
+
+def dumpBenchmarkDiff(fileA, fileB, threshold=0.1, log=None):
+    benchA = loadBenchmark(fileA)
+    benchB = loadBenchmark(fileB)
+
+    numRegressions = 0
+    totalsA = {}
+    totalsB = {}
+    for tu in sorted(benchB.keys()):
+        if tu not in benchA:
+            print "NEW TU: %r" % tu
+            continue
+        a = benchA[tu]
+        b = benchB[tu]
+        for name in BenchmarkTotals + [m[0] for m in BenchmarkMetrics]:
+            totalsA[name] = totalsA.get(name, 0) + a.get(name, 0)
+            totalsB[name] = totalsB.get(name, 0) + b.get(name, 0)
+        for name, unit, worseIfLarger in BenchmarkMetrics:
+            if not isBenchmarkRegression(name, worseIfLarger, a, b, threshold):
+                continue
+            numRegressions += 1
+            message = "REGRESSED: %r %s %g%s -> %g%s" % \
+                      (tu, name, a[name], unit, b[name], unit)
+            print message
+            if log:
+                print >>log, message
+    for tu in sorted(benchA.keys()):
+        if tu not in benchB:
+            print "MISSING TU: %r" % tu
+
+    for name, unit, worseIfLarger in BenchmarkMetrics:
+        if name == "NodesPerSecond":
+            continue
+        print "TOTAL %s: %g%s -> %g%s" % \
+              (name, totalsA.get(name, 0), unit, totalsB.get(name, 0), unit)
+    if totalsA.get("WallTime") and totalsB.get("WallTime"):
+        print "TOTAL NodesPerSecond: %.1f -> %.1f" % \
+              (totalsA["Nodes"] / totalsA["WallTime"],
+               totalsB["Nodes"] / totalsB["WallTime"])
+    for name in BenchmarkTotals:
+        print "TOTAL %s: %d -> %d" % \
+              (name, totalsA.get(name, 0), totalsB.get(name, 0))
+    print "TOTAL PERFORMANCE REGRESSIONS: %r" % numRegressions
+    if log:
+        print >>log, "('TOTAL PERFORMANCE REGRESSIONS', %r)" % numRegressions
+
+    return numRegressions
+
 def main():
     from optparse import OptionParser
     parser = OptionParser("usage: %prog [options] [dir A] [dir B]")
@@ -275,6 +374,14 @@ def main():
                       help="Write additional information to LOG [default=None]",
                       action="store", type=str, default=None,
                       metavar="LOG")
+    parser.add_option("", "--benchmark", dest="benchmark",
+                      help="Compare two benchmark files instead of two "
+                           "result directories",
+                      action="store_true", default=False)
+    parser.add_option("", "--threshold", dest="threshold",
+                      help="Relative change flagged as a performance "
+                           "regression [default=0.1]",
+                      action="store", type=float, default=0.1)
     (opts, args) = parser.parse_args()
 
     if len(args) != 2:
@@ -282,6 +389,10 @@ def main():
 
     dirA,dirB = args
 
+    if opts.benchmark:
+        dumpBenchmarkDiff(dirA, dirB, opts.threshold)
+        return
+
     dumpScanBuildResultsDiff(dirA, dirB, opts)    
 
 if __name__ == '__main__':
@@ -32,6 +32,12 @@ Assumptions (TODO: shouldn't need to assume these.):
    The compiler for scan-build and scan-build are in the PATH.
    export PATH=/Users/zaks/workspace/c2llvm/build/Release+Asserts/bin:$PATH
 
+Benchmark mode (-b, or -rb to regenerate its reference) analyzes the single
+file projects with fixed budgets and records the wall time, peak RSS and
+analyzer statistics of every TU in Logs/benchmark.csv. It uses its own result
+directories and flags performance regressions against the reference run
+next to the diagnostic differences.
+
 For more logging, set the  env variables:
    zaks:TI zaks$ export CCC_ANALYZER_LOG=1
    zaks:TI zaks$ export CCC_ANALYZER_VERBOSE=1
@@ -39,14 +45,16 @@ For more logging, set the  env variables:
 import CmpRuns
 
 import os
+import re
 import csv
 import sys
 import glob
 import math
+import shlex
 import shutil
 import time
 import plistlib
-from subprocess import check_call, CalledProcessError
+from subprocess import check_call, CalledProcessError, Popen
 
 #------------------------------------------------------------------------------
 # Helper functions.
@@ -126,10 +134,13 @@ def getProjectDir(ID):
     return os.path.join(os.path.abspath(os.curdir), ID)        
 
 def getSBOutputDirName(IsReferenceBuild) :
+    OutputDirName = SBOutputDirName
+    if Benchmark == True :
+        OutputDirName = BenchmarkOutputDirName
     if IsReferenceBuild == True :
-        return SBOutputDirReferencePrefix + SBOutputDirName
+        return SBOutputDirReferencePrefix + OutputDirName
     else :
-        return SBOutputDirName
+        return OutputDirName
 
 #------------------------------------------------------------------------------
 # Configuration setup.
@@ -171,6 +182,34 @@ SBOutputDirReferencePrefix = "Ref"
 # Currently, consists of all the non experimental checkers.
 Checkers="alpha.security.taint,core,deadcode,security,unix,osx"
 
+# Benchmark mode.
+Benchmark = False
+BenchmarkOutputDirName = "BenchmarkResults"
+BenchmarkFileName = "benchmark.csv"
+PerfDiffsSummaryFileName = "perf_diffs.txt"
+# The budgets are spelled out so that both runs explore the same amount of
+# paths even if the defaults change between them.
+BenchmarkOptions = "-analyzer-stats -analyzer-checker=debug.Stats " \
+                   "-analyzer-max-nodes 150000 -analyzer-max-loop 4 "
+# The relative change flagged as a performance regression.
+BenchmarkThreshold = 0.1
+# Maps the descriptions of the statistics printed by -analyzer-stats to the
+# columns of the benchmark file.
+BenchmarkStats = {
+    "The # of exploded graph nodes created." : "Nodes",
+    "The # of steps executed." : "Steps",
+    "The # of times we inlined a call" : "InlinedCalls",
+    "The # of times we did not inline a call because of the inlining budget" :
+        "CallsOverInliningBudget",
+    "The # of functions analysed (as top level)." : "FunctionsAnalyzed",
+    "The # of times we reached the max number of steps." : "ReachedMaxSteps",
+    "The # of exploded graph nodes reclaimed in top level functions" :
+        "ReclaimedNodes" }
+BenchmarkColumns = ["File", "WallTime", "PeakRSS", "NodesPerSecond"] + \
+                   sorted(BenchmarkStats.values())
+# A line printed by llvm::PrintStatistics: value, component, description.
+StatisticLine = re.compile(r"^\s*(\d+) \S+\s+- (.*)$")
+
 Verbose = 1
 
 #------------------------------------------------------------------------------
@@ -226,6 +265,46 @@ def runScanBuild(Dir, SBOutputDir, PBuildLogFile):
               " for details."
         raise
 
+# Run a single analyzer command, measuring its wall time and peak RSS, and
+# return its benchmark record.
+def runBenchmarkCommand(Command, FileName, Dir, LogFile):
+    TBegin = time.time()
+    Process = Popen(shlex.split(Command), cwd = Dir, stderr=LogFile,
+                                                     stdout=LogFile)
+    (Pid, Status, Usage) = os.wait4(Process.pid, 0)
+    WallTime = time.time() - TBegin
+    if not os.WIFEXITED(Status) or os.WEXITSTATUS(Status) != 0:
+        raise CalledProcessError(Status, Command)
+
+    # ru_maxrss is in kilobytes, except on Darwin.
+    PeakRSS = Usage.ru_maxrss
+    if sys.platform == "darwin":
+        PeakRSS = PeakRSS / 1024
+
+    Record = {"File" : FileName, "WallTime" : "%.3f" % WallTime,
+              "PeakRSS" : PeakRSS}
+    for Name in BenchmarkStats.values():
+        Record[Name] = 0
+    LogFile.seek(0)
+    for Line in LogFile:
+        Match = StatisticLine.match(Line)
+        if Match and Match.group(2).strip() in BenchmarkStats:
+            Record[BenchmarkStats[Match.group(2).strip()]] = \
+                int(Match.group(1))
+    Record["NodesPerSecond"] = "%.1f" % (Record["Nodes"] / max(WallTime, 1e-3))
+    return Record
+
+def writeBenchmark(SBOutputDir, Records):
+    BenchmarkPath = os.path.join(SBOutputDir, LogFolderName, BenchmarkFileName)
+    BenchmarkFile = open(BenchmarkPath, "wb")
+    try:
+        Writer = csv.DictWriter(BenchmarkFile, BenchmarkColumns)
+        Writer.writerow(dict(zip(BenchmarkColumns, BenchmarkColumns)))
+        Writer.writerows(Records)
+    finally:
+        BenchmarkFile.close()
+    print "Benchmark results: %s" % (BenchmarkPath,)
+
 def hasNoExtension(FileName):
     (Root, Ext) = os.path.splitext(FileName)
     if ((Ext == "")) :
@@ -252,6 +331,10 @@ def runAnalyzePreprocessed(Dir, SBOutputDir, Mode):
     
     if (Mode == 2) :
         CmdPrefix += "-std=c++11 " 
+
+    if Benchmark == True :
+        CmdPrefix += BenchmarkOptions
+    BenchmarkRecords = []
     
     PlistPath = os.path.join(Dir, SBOutputDir, "date")
     FailPath = os.path.join(PlistPath, "failures");
@@ -275,9 +358,13 @@ def runAnalyzePreprocessed(Dir, SBOutputDir, Mode):
         try:
             if Verbose == 1:        
                 print "  Executing: %s" % (Command,)
-            check_call(Command, cwd = Dir, stderr=LogFile,
-                                           stdout=LogFile, 
-                                           shell=True)
+            if Benchmark == True :
+                BenchmarkRecords.append(runBenchmarkCommand(Command, FileName,
+                                                            Dir, LogFile))
+            else :
+                check_call(Command, cwd = Dir, stderr=LogFile,
+                                               stdout=LogFile, 
+                                               shell=True)
         except CalledProcessError, e:
             print "Error: Analyzes of %s failed. See %s for details." \
                   "Error code %d." % \
@@ -290,6 +377,9 @@ def runAnalyzePreprocessed(Dir, SBOutputDir, Mode):
         if Failed == False:
             os.remove(LogFile.name);
 
+    if Benchmark == True :
+        writeBenchmark(SBOutputDir, BenchmarkRecords)
+
 def buildProject(Dir, SBOutputDir, ProjectBuildMode, IsReferenceBuild):
     TBegin = time.time() 
 
@@ -321,6 +411,9 @@ def buildProject(Dir, SBOutputDir, ProjectBuildMode, IsReferenceBuild):
         runCleanupScript(Dir, PBuildLogFile)
         
         if (ProjectBuildMode == 1):
+            if Benchmark == True :
+                print "Warning: benchmark mode only measures single file " \
+                      "projects; %s is built without measurements." % (Dir,)
             runScanBuild(Dir, SBOutputDir, PBuildLogFile)
         else:
             runAnalyzePreprocessed(Dir, SBOutputDir, ProjectBuildMode)
@@ -400,8 +493,8 @@ class Discarder(object):
 def runCmpResults(Dir):   
     TBegin = time.time() 
 
-    RefDir = os.path.join(Dir, SBOutputDirReferencePrefix + SBOutputDirName)
-    NewDir = os.path.join(Dir, SBOutputDirName)
+    RefDir = os.path.join(Dir, getSBOutputDirName(True))
+    NewDir = os.path.join(Dir, getSBOutputDirName(False))
     
     # We have to go one level down the directory tree.
     RefList = glob.glob(RefDir + "/*") 
@@ -446,7 +539,35 @@ def runCmpResults(Dir):
                   (NumDiffs, DiffsPath,)
                     
     print "Diagnostic comparison complete (time: %.2f)." % (time.time()-TBegin) 
+
+    if Benchmark == True :
+        runCmpBenchmark(Dir)
     return (NumDiffs > 0)
+
+# Compare the benchmark records of the reference and the new run.
+def runCmpBenchmark(Dir):
+    RefPath = os.path.join(Dir, getSBOutputDirName(True), LogFolderName,
+                           BenchmarkFileName)
+    NewPath = os.path.join(Dir, getSBOutputDirName(False), LogFolderName,
+                           BenchmarkFileName)
+    if not os.path.exists(RefPath) or not os.path.exists(NewPath):
+        return False
+
+    DiffsPath = os.path.join(Dir, getSBOutputDirName(False), LogFolderName,
+                             PerfDiffsSummaryFileName)
+    DiffsLog = open(DiffsPath, "w")
+    OLD_STDOUT = sys.stdout
+    sys.stdout = DiffsLog
+    try:
+        NumRegressions = CmpRuns.dumpBenchmarkDiff(RefPath, NewPath,
+                                                   BenchmarkThreshold)
+    finally:
+        sys.stdout = OLD_STDOUT
+        DiffsLog.close()
+    if (NumRegressions > 0) :
+        print "Warning: %r performance regressions. See %s" % \
+              (NumRegressions, DiffsPath,)
+    return (NumRegressions > 0)
     
 def updateSVN(Mode, ProjectsMap):
     try:
@@ -544,10 +665,17 @@ if __name__ == '__main__':
         elif sys.argv[1] == "-rs":
             IsReference = True
             UpdateSVN = True
+        elif sys.argv[1] == "-b":
+            Benchmark = True
+        elif sys.argv[1] == "-rb":
+            IsReference = True
+            Benchmark = True
         else:     
           print >> sys.stderr, 'Usage: ', sys.argv[0],\
-                             '[-r|-rs]' \
+                             '[-r|-rs|-b|-rb]' \
                              'Use -r to regenerate reference output' \
-                             'Use -rs to regenerate reference output and update svn'
+                             'Use -rs to regenerate reference output and update svn' \
+                             'Use -b to benchmark against the reference' \
+                             'Use -rb to regenerate the benchmark reference'
 
     testAll(IsReference, UpdateSVN)
@@ -6,8 +6,13 @@ Script to Summarize statistics in the scan-build output.
 Statistics are enabled by passing '-internal-stats' option to scan-build 
 (or '-analyzer-stats' to the analyzer).
 
+Any further arguments are checker profiles written by the analyzer with
+'-analyzer-checker-profile'; the time spent in each checker is summed over
+them.
+
 """
 
+import json
 import string
 from operator import itemgetter
 import sys
@@ -15,7 +20,7 @@ import sys
 if __name__ == '__main__':
     if len(sys.argv) < 2:
         print >> sys.stderr, 'Usage: ', sys.argv[0],\
-                             'scan_build_output_file'
+                             'scan_build_output_file [checker_profile ...]'
         sys.exit(-1)
 
     f = open(sys.argv[1], 'r')
@@ -81,4 +86,18 @@ if __name__ == '__main__':
     print "MaxTime %f" % (MaxTime)
     print "TotalTime %f" % (TotalTime)
     print "Max CFG Size %d" % (MaxCFGSize)
-    
\ No newline at end of file
+    
+
+    CheckerTimes = {}
+    for ProfileFile in sys.argv[2:]:
+        Profile = json.load(open(ProfileFile, 'r'))
+        for Checker in Profile['checkers']:
+            Entry = CheckerTimes.setdefault(Checker['name'], [0, 0, 0])
+            for Callback in Checker['callbacks'].values():
+                Entry[0] = Entry[0] + Callback['time_ns']
+                Entry[1] = Entry[1] + Callback['calls']
+                Entry[2] = Entry[2] + Callback['nodes']
+    for Name, Entry in sorted(CheckerTimes.items(), key=itemgetter(1),
+                              reverse=True):
+        print "Checker %s %f (calls %d, nodes %d)" % \
+              (Name, Entry[0] / 1e9, Entry[1], Entry[2])
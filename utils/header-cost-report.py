@@ -0,0 +1,81 @@
+#!/usr/bin/env python
+
+"""
+Sum the costs that "clang -cc1 -header-cost-file <file>" appends for each
+translation unit, and print the headers that cost the build the most.
+"""
+
+import json
+import sys
+
+COUNTERS = ['tokens', 'macro_expansions', 'decls', 'deserialized_decls',
+            'time']
+
+class HeaderCosts(object):
+    def __init__(self, name):
+        self.name = name
+        self.translationUnits = 0
+        self.includes = 0
+        self.exclusive = dict((c, 0) for c in COUNTERS)
+        self.inclusive = dict((c, 0) for c in COUNTERS)
+
+    def add(self, header):
+        self.translationUnits += 1
+        self.includes += header['includes']
+        for c in COUNTERS:
+            self.exclusive[c] += header['exclusive'][c]
+            self.inclusive[c] += header['inclusive'][c]
+
+def readCosts(paths):
+    headers = {}
+    for path in paths:
+        f = open(path)
+        for line in f:
+            line = line.strip()
+            if not line:
+                continue
+            for header in json.loads(line)['headers']:
+                name = header['name']
+                if name not in headers:
+                    headers[name] = HeaderCosts(name)
+                headers[name].add(header)
+        f.close()
+    return headers.values()
+
+def main():
+    from optparse import OptionParser
+    parser = OptionParser("%prog [options] {cost files+}")
+    parser.add_option("", "--sort", dest="sort",
+                      help="counter to sort by [default %default]",
+                      action="store", choices=COUNTERS, default="time")
+    parser.add_option("", "--exclusive", dest="exclusive",
+                      help="sort by the exclusive costs of the headers",
+                      action="store_true", default=False)
+    parser.add_option("-n", "", dest="count",
+                      help="number of headers to print [default %default]",
+                      action="store", type=int, default=50)
+    (opts, args) = parser.parse_args()
+
+    if not args:
+        parser.error('Invalid number of arguments.')
+
+    headers = readCosts(args)
+    if opts.exclusive:
+        key = lambda h: h.exclusive[opts.sort]
+    else:
+        key = lambda h: h.inclusive[opts.sort]
+    headers.sort(key=key, reverse=True)
+
+    # Times are reported in nanoseconds, and printed in milliseconds.
+    print '%8s %8s %12s %12s %10s %10s %10s %10s  %s' % (
+        'TUs', 'includes', 'tokens', 'incl tokens', 'decls', 'incl decls',
+        'ms', 'incl ms', 'header')
+    for h in headers[:opts.count]:
+        print '%8d %8d %12d %12d %10d %10d %10.1f %10.1f  %s' % (
+            h.translationUnits, h.includes, h.exclusive['tokens'],
+            h.inclusive['tokens'], h.exclusive['decls'],
+            h.inclusive['decls'], h.exclusive['time'] / 1e6,
+            h.inclusive['time'] / 1e6, h.name)
+
+if __name__ == '__main__':
+    main()